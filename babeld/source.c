@@ -36,27 +36,48 @@ THE SOFTWARE.
 #include "babel_interface.h"
 #include "route.h"
 #include "babel_errors.h"
+#include "jhash.h"
 
-struct source *srcs = NULL;
+static int
+source_cmp(const struct source *a, const struct source *b)
+{
+    int rc;
+
+    rc = memcmp(a->id, b->id, 8);
+    if(rc != 0)
+        return rc;
+    if(a->plen != b->plen)
+        return a->plen < b->plen ? -1 : 1;
+    return memcmp(a->prefix, b->prefix, 16);
+}
+
+static uint32_t
+source_hash_key(const struct source *src)
+{
+    uint32_t key;
+
+    key = jhash(src->id, 8, src->plen);
+    return jhash(src->prefix, 16, key);
+}
+
+DECLARE_HASH(source_hash, struct source, hash_item, source_cmp,
+             source_hash_key);
+
+static struct source_hash_head sources = INIT_HASH(sources);
 
 struct source*
 find_source(const unsigned char *id, const unsigned char *p, unsigned char plen,
             int create, unsigned short seqno)
 {
     struct source *src;
+    struct source key;
 
-    for(src = srcs; src; src = src->next) {
-        /* This should really be a hash table.  For now, check the
-           last byte first. */
-        if(src->id[7] != id[7])
-            continue;
-        if(memcmp(src->id, id, 8) != 0)
-            continue;
-        if(src->plen != plen)
-            continue;
-        if(memcmp(src->prefix, p, 16) == 0)
-            return src;
-    }
+    memcpy(key.id, id, 8);
+    memcpy(key.prefix, p, 16);
+    key.plen = plen;
+    src = source_hash_find(&sources, &key);
+    if(src)
+        return src;
 
     if(!create)
         return NULL;
@@ -74,8 +95,7 @@ find_source(const unsigned char *id, const unsigned char *p, unsigned char plen,
     src->metric = INFINITY;
     src->time = babel_now.tv_sec;
     src->route_count = 0;
-    src->next = srcs;
-    srcs = src;
+    source_hash_add(&sources, src);
     return src;
 }
 
@@ -101,15 +121,7 @@ flush_source(struct source *src)
         /* The source is in use by a route. */
         return 0;
 
-    if(srcs == src) {
-        srcs = src->next;
-    } else {
-        struct source *previous = srcs;
-        while(previous->next != src)
-            previous = previous->next;
-        previous->next = src->next;
-    }
-
+    source_hash_del(&sources, src);
     free(src);
     return 1;
 }
@@ -139,18 +151,12 @@ expire_sources(void)
 {
     struct source *src;
 
-    src = srcs;
-    while(src) {
+    frr_each_safe(source_hash, &sources, src) {
         if(src->time > babel_now.tv_sec)
             /* clock stepped */
             src->time = babel_now.tv_sec;
-        if(src->time < babel_now.tv_sec - SOURCE_GC_TIME) {
-            struct source *old = src;
-            src = src->next;
-            flush_source(old);
-            continue;
-        }
-        src = src->next;
+        if(src->time < babel_now.tv_sec - SOURCE_GC_TIME)
+            flush_source(src);
     }
 }
 
@@ -159,7 +165,7 @@ check_sources_released(void)
 {
     struct source *src;
 
-    for(src = srcs; src; src = src->next) {
+    frr_each(source_hash, &sources, src) {
         if(src->route_count != 0)
             fprintf(stderr, "Warning: source %s %s has refcount %d.\n",
                     format_eui64(src->id),
@@ -226,6 +226,9 @@ void bfd_session_apply(struct bfd_session *bs)
 
 	/* Send updated information to data plane. */
 	bfd_dplane_update_session(bs);
+
+	/* Or to the fast path. */
+	bfd_fastpath_update(bs, NULL);
 }
 
 void bfd_profile_remove(struct bfd_session *bs)
@@ -415,6 +418,9 @@ void bfd_session_disable(struct bfd_session *bs)
 	if (bs->bdc)
 		return;
 
+	/* The fast path uses the socket too. */
+	bfd_fastpath_release(bs, false);
+
 	/* Free up socket resources. */
 	if (bs->sock != -1) {
 		close(bs->sock);
@@ -665,6 +671,10 @@ int bfd_recvtimer_cb(struct thread *t)
 {
 	struct bfd_session *bs = THREAD_ARG(t);
 
+	/* Heard from the peer since the timer started. */
+	if (bfd_recvtimer_rearm(bs))
+		return 0;
+
 	switch (bs->ses_state) {
 	case PTM_BFD_INIT:
 	case PTM_BFD_UP:
@@ -688,6 +698,10 @@ int bfd_echo_recvtimer_cb(struct thread *t)
 {
 	struct bfd_session *bs = THREAD_ARG(t);
 
+	/* Echo packets came back since the timer started. */
+	if (bfd_echo_recvtimer_rearm(bs))
+		return 0;
+
 	switch (bs->ses_state) {
 	case PTM_BFD_INIT:
 	case PTM_BFD_UP:
@@ -999,6 +1013,9 @@ void bfd_set_polling(struct bfd_session *bs)
 	 * RFC 5880, Section 6.8.3.
 	 */
 	bs->polling = 1;
+
+	/* Polling is done from the main pthread. */
+	bfd_fastpath_update(bs, NULL);
 }
 
 /*
@@ -2058,18 +2075,23 @@ static int bfd_vrf_enable(struct vrf *vrf)
 		if (!bvrf->bg_echov6)
 			bvrf->bg_echov6 = bp_echov6_socket(vrf);
 
-		if (!bvrf->bg_ev[0] && bvrf->bg_shop != -1)
-			thread_add_read(master, bfd_recv_cb, bvrf,
-					bvrf->bg_shop, &bvrf->bg_ev[0]);
-		if (!bvrf->bg_ev[1] && bvrf->bg_mhop != -1)
-			thread_add_read(master, bfd_recv_cb, bvrf,
-					bvrf->bg_mhop, &bvrf->bg_ev[1]);
-		if (!bvrf->bg_ev[2] && bvrf->bg_shop6 != -1)
-			thread_add_read(master, bfd_recv_cb, bvrf,
-					bvrf->bg_shop6, &bvrf->bg_ev[2]);
-		if (!bvrf->bg_ev[3] && bvrf->bg_mhop6 != -1)
-			thread_add_read(master, bfd_recv_cb, bvrf,
-					bvrf->bg_mhop6, &bvrf->bg_ev[3]);
+		/* Control packets, echo packets stay on the main pthread. */
+		if (bglobal.bg_use_fastpath)
+			bfd_fastpath_reads_on(bvrf);
+		else {
+			if (!bvrf->bg_ev[0] && bvrf->bg_shop != -1)
+				thread_add_read(master, bfd_recv_cb, bvrf,
+						bvrf->bg_shop, &bvrf->bg_ev[0]);
+			if (!bvrf->bg_ev[1] && bvrf->bg_mhop != -1)
+				thread_add_read(master, bfd_recv_cb, bvrf,
+						bvrf->bg_mhop, &bvrf->bg_ev[1]);
+			if (!bvrf->bg_ev[2] && bvrf->bg_shop6 != -1)
+				thread_add_read(master, bfd_recv_cb, bvrf,
+						bvrf->bg_shop6, &bvrf->bg_ev[2]);
+			if (!bvrf->bg_ev[3] && bvrf->bg_mhop6 != -1)
+				thread_add_read(master, bfd_recv_cb, bvrf,
+						bvrf->bg_mhop6, &bvrf->bg_ev[3]);
+		}
 		if (!bvrf->bg_ev[4] && bvrf->bg_echo != -1)
 			thread_add_read(master, bfd_recv_cb, bvrf,
 					bvrf->bg_echo, &bvrf->bg_ev[4]);
@@ -2101,10 +2123,14 @@ static int bfd_vrf_disable(struct vrf *vrf)
 		zlog_debug("VRF disable %s id %d", vrf->name, vrf->vrf_id);
 
 	/* Disable read/write poll triggering. */
-	THREAD_OFF(bvrf->bg_ev[0]);
-	THREAD_OFF(bvrf->bg_ev[1]);
-	THREAD_OFF(bvrf->bg_ev[2]);
-	THREAD_OFF(bvrf->bg_ev[3]);
+	if (bglobal.bg_use_fastpath)
+		bfd_fastpath_reads_off(bvrf);
+	else {
+		THREAD_OFF(bvrf->bg_ev[0]);
+		THREAD_OFF(bvrf->bg_ev[1]);
+		THREAD_OFF(bvrf->bg_ev[2]);
+		THREAD_OFF(bvrf->bg_ev[3]);
+	}
 	THREAD_OFF(bvrf->bg_ev[4]);
 	THREAD_OFF(bvrf->bg_ev[5]);
 
@@ -276,6 +276,9 @@ struct bfd_session {
 	uint64_t detect_TO;
 	struct thread *echo_recvtimer_ev;
 	struct thread *recvtimer_ev;
+	/* Detection deadlines, the timers above may fire earlier. */
+	struct timeval echo_recv_deadline;
+	struct timeval recv_deadline;
 	uint64_t xmt_TO;
 	uint64_t echo_xmt_TO;
 	struct thread *xmttimer_ev;
@@ -290,6 +293,8 @@ struct bfd_session {
 	struct peer_label *pl;
 
 	struct bfd_dplane_ctx *bdc;
+	/* Set while the fast path pthread runs the session. */
+	struct bfd_fp_session *fp;
 	struct sockaddr_any local_address;
 	struct interface *ifp;
 	struct vrf *vrf;
@@ -473,6 +478,9 @@ struct bfd_global {
 	struct thread *bg_dplane_sockev;
 	struct dplane_queue bg_dplaneq;
 
+	/* Steady state sessions on the fast path pthread. */
+	bool bg_use_fastpath;
+
 	/* Debug options. */
 	/* Show distributed BFD debug messages. */
 	bool debug_dplane;
@@ -553,10 +561,22 @@ int bp_peer_socketv6(const struct bfd_session *bs);
 int bp_echo_socket(const struct vrf *vrf);
 int bp_echov6_socket(const struct vrf *vrf);
 
+socklen_t bp_peer_sockaddr(const struct bfd_session *bs, uint16_t *port,
+			   struct sockaddr_any *sa);
+void ptm_bfd_pkt_build(const struct bfd_session *bfd, int fbit,
+		       struct bfd_pkt *cp);
 void ptm_bfd_snd(struct bfd_session *bfd, int fbit);
 void ptm_bfd_echo_snd(struct bfd_session *bfd);
 
 int bfd_recv_cb(struct thread *t);
+ssize_t bfd_recv_control(struct bfd_vrf_global *bvrf, int sd,
+			 uint8_t *msgbuf, size_t msgbuflen, bool *is_mhop,
+			 uint8_t *ttl, ifindex_t *ifindex,
+			 struct sockaddr_any *local, struct sockaddr_any *peer);
+void bfd_recv_process(struct bfd_vrf_global *bvrf, bool is_mhop,
+		      uint8_t *msgbuf, ssize_t mlen, uint8_t ttl,
+		      ifindex_t ifindex, struct sockaddr_any *local,
+		      struct sockaddr_any *peer);
 
 
 /*
@@ -576,6 +596,14 @@ void bfd_echo_xmttimer_delete(struct bfd_session *bs);
 void bfd_recvtimer_delete(struct bfd_session *bs);
 void bfd_echo_recvtimer_delete(struct bfd_session *bs);
 
+/*
+ * Called from the detection timer callbacks: returns `true` if packets
+ * arrived since the timer was armed, in which case it runs again until
+ * the new deadline.
+ */
+bool bfd_recvtimer_rearm(struct bfd_session *bs);
+bool bfd_echo_recvtimer_rearm(struct bfd_session *bs);
+
 void bfd_recvtimer_assign(struct bfd_session *bs, bfd_ev_cb cb, int sd);
 void bfd_echo_recvtimer_assign(struct bfd_session *bs, bfd_ev_cb cb, int sd);
 void bfd_xmttimer_assign(struct bfd_session *bs, bfd_ev_cb cb);
@@ -827,6 +855,55 @@ int bfd_dplane_delete_session(struct bfd_session *bs);
  */
 int bfd_dplane_update_session_counters(struct bfd_session *bs);
 
+/**
+ * Asks the data planes for the counters of all their sessions at once,
+ * rather than one session at a time.
+ */
+void bfd_dplane_update_all_counters(void);
+
 void bfd_dplane_show_counters(struct vty *vty);
 
+/*
+ * fastpath.c
+ */
+
+/**
+ * Sets up the fast path pthread, which reads the control packet sockets
+ * and runs the sessions in the steady state once bfd_fastpath_run() is
+ * called after daemonizing.
+ */
+void bfd_fastpath_init(void);
+void bfd_fastpath_run(void);
+
+/** Stops the fast path pthread, once the VRFs are gone. */
+void bfd_fastpath_finish(void);
+
+/**
+ * Hands the session over to the fast path, or back from it, depending on
+ * whether it's in the steady state: up, not polling and not offloaded to a
+ * data plane.  Called whenever something the session sends may have
+ * changed.
+ *
+ * \param bs the BFD session.
+ * \param cp the control packet just processed for it, if any.
+ */
+void bfd_fastpath_update(struct bfd_session *bs, const struct bfd_pkt *cp);
+
+/**
+ * Takes the session back from the fast path, before its socket goes away.
+ *
+ * \param bs the BFD session.
+ * \param restart `true` to restart the session timers on the main pthread.
+ */
+void bfd_fastpath_release(struct bfd_session *bs, bool restart);
+
+/**
+ * Adds the packets the fast path sent and received for the session to its
+ * counters.
+ */
+void bfd_fastpath_update_session_counters(struct bfd_session *bs);
+
+void bfd_fastpath_reads_on(struct bfd_vrf_global *bvrf);
+void bfd_fastpath_reads_off(struct bfd_vrf_global *bvrf);
+
 #endif /* _BFD_H_ */
@@ -66,51 +66,55 @@ static void bp_bind_ipv6(int sd, uint16_t port);
 /*
  * Functions
  */
-int _ptm_bfd_send(struct bfd_session *bs, uint16_t *port, const void *data,
-		  size_t datalen)
+socklen_t bp_peer_sockaddr(const struct bfd_session *bs, uint16_t *port,
+			   struct sockaddr_any *sa)
 {
-	struct sockaddr *sa;
-	struct sockaddr_in sin;
-	struct sockaddr_in6 sin6;
+	struct sockaddr_in *sin = &sa->sa_sin;
+	struct sockaddr_in6 *sin6 = &sa->sa_sin6;
 	socklen_t slen;
-	ssize_t rv;
-	int sd = -1;
 
+	memset(sa, 0, sizeof(*sa));
 	if (CHECK_FLAG(bs->flags, BFD_SESS_FLAG_IPV6)) {
-		memset(&sin6, 0, sizeof(sin6));
-		sin6.sin6_family = AF_INET6;
-		memcpy(&sin6.sin6_addr, &bs->key.peer, sizeof(sin6.sin6_addr));
-		if (bs->ifp && IN6_IS_ADDR_LINKLOCAL(&sin6.sin6_addr))
-			sin6.sin6_scope_id = bs->ifp->ifindex;
+		sin6->sin6_family = AF_INET6;
+		memcpy(&sin6->sin6_addr, &bs->key.peer,
+		       sizeof(sin6->sin6_addr));
+		if (bs->ifp && IN6_IS_ADDR_LINKLOCAL(&sin6->sin6_addr))
+			sin6->sin6_scope_id = bs->ifp->ifindex;
 
-		sin6.sin6_port =
+		sin6->sin6_port =
 			(port) ? *port
 			       : (CHECK_FLAG(bs->flags, BFD_SESS_FLAG_MH))
 					 ? htons(BFD_DEF_MHOP_DEST_PORT)
 					 : htons(BFD_DEFDESTPORT);
 
-		sd = bs->sock;
-		sa = (struct sockaddr *)&sin6;
-		slen = sizeof(sin6);
+		slen = sizeof(*sin6);
 	} else {
-		memset(&sin, 0, sizeof(sin));
-		sin.sin_family = AF_INET;
-		memcpy(&sin.sin_addr, &bs->key.peer, sizeof(sin.sin_addr));
-		sin.sin_port =
+		sin->sin_family = AF_INET;
+		memcpy(&sin->sin_addr, &bs->key.peer, sizeof(sin->sin_addr));
+		sin->sin_port =
 			(port) ? *port
 			       : (CHECK_FLAG(bs->flags, BFD_SESS_FLAG_MH))
 					 ? htons(BFD_DEF_MHOP_DEST_PORT)
 					 : htons(BFD_DEFDESTPORT);
 
-		sd = bs->sock;
-		sa = (struct sockaddr *)&sin;
-		slen = sizeof(sin);
+		slen = sizeof(*sin);
 	}
 
 #ifdef HAVE_STRUCT_SOCKADDR_SA_LEN
-	sa->sa_len = slen;
+	((struct sockaddr *)sa)->sa_len = slen;
 #endif /* HAVE_STRUCT_SOCKADDR_SA_LEN */
-	rv = sendto(sd, data, datalen, 0, sa, slen);
+	return slen;
+}
+
+int _ptm_bfd_send(struct bfd_session *bs, uint16_t *port, const void *data,
+		  size_t datalen)
+{
+	struct sockaddr_any sa;
+	socklen_t slen;
+	ssize_t rv;
+
+	slen = bp_peer_sockaddr(bs, port, &sa);
+	rv = sendto(bs->sock, data, datalen, 0, (struct sockaddr *)&sa, slen);
 	if (rv <= 0) {
 		if (bglobal.debug_network)
 			zlog_debug("packet-send: send failure: %s",
@@ -222,38 +226,39 @@ static int ptm_bfd_process_echo_pkt(struct bfd_vrf_global *bvrf, int s)
 	return 0;
 }
 
-void ptm_bfd_snd(struct bfd_session *bfd, int fbit)
+void ptm_bfd_pkt_build(const struct bfd_session *bfd, int fbit,
+		       struct bfd_pkt *cp)
 {
-	struct bfd_pkt cp = {};
+	memset(cp, 0, sizeof(*cp));
 
 	/* Set fields according to section 6.5.7 */
-	cp.diag = bfd->local_diag;
-	BFD_SETVER(cp.diag, BFD_VERSION);
-	cp.flags = 0;
-	BFD_SETSTATE(cp.flags, bfd->ses_state);
+	cp->diag = bfd->local_diag;
+	BFD_SETVER(cp->diag, BFD_VERSION);
+	cp->flags = 0;
+	BFD_SETSTATE(cp->flags, bfd->ses_state);
 
 	if (CHECK_FLAG(bfd->flags, BFD_SESS_FLAG_CBIT))
-		BFD_SETCBIT(cp.flags, BFD_CBIT);
+		BFD_SETCBIT(cp->flags, BFD_CBIT);
 
-	BFD_SETDEMANDBIT(cp.flags, BFD_DEF_DEMAND);
+	BFD_SETDEMANDBIT(cp->flags, BFD_DEF_DEMAND);
 
 	/*
 	 * Polling and Final can't be set at the same time.
 	 *
 	 * RFC 5880, Section 6.5.
 	 */
-	BFD_SETFBIT(cp.flags, fbit);
+	BFD_SETFBIT(cp->flags, fbit);
 	if (fbit == 0)
-		BFD_SETPBIT(cp.flags, bfd->polling);
+		BFD_SETPBIT(cp->flags, bfd->polling);
 
-	cp.detect_mult = bfd->detect_mult;
-	cp.len = BFD_PKT_LEN;
-	cp.discrs.my_discr = htonl(bfd->discrs.my_discr);
-	cp.discrs.remote_discr = htonl(bfd->discrs.remote_discr);
+	cp->detect_mult = bfd->detect_mult;
+	cp->len = BFD_PKT_LEN;
+	cp->discrs.my_discr = htonl(bfd->discrs.my_discr);
+	cp->discrs.remote_discr = htonl(bfd->discrs.remote_discr);
 	if (bfd->polling) {
-		cp.timers.desired_min_tx =
+		cp->timers.desired_min_tx =
 			htonl(bfd->timers.desired_min_tx);
-		cp.timers.required_min_rx =
+		cp->timers.required_min_rx =
 			htonl(bfd->timers.required_min_rx);
 	} else {
 		/*
@@ -262,13 +267,22 @@ void ptm_bfd_snd(struct bfd_session *bfd, int fbit)
 		 * the oportunity to learn. See `bs_final_handler` for
 		 * more information.
 		 */
-		cp.timers.desired_min_tx =
+		cp->timers.desired_min_tx =
 			htonl(bfd->cur_timers.desired_min_tx);
-		cp.timers.required_min_rx =
+		cp->timers.required_min_rx =
 			htonl(bfd->cur_timers.required_min_rx);
 	}
-	cp.timers.required_min_echo = htonl(bfd->timers.required_min_echo_rx);
+	cp->timers.required_min_echo = htonl(bfd->timers.required_min_echo_rx);
+}
+
+void ptm_bfd_snd(struct bfd_session *bfd, int fbit)
+{
+	struct bfd_pkt cp;
+
+	/* the fast path only sends what's current in the steady state */
+	bfd_fastpath_update(bfd, NULL);
 
+	ptm_bfd_pkt_build(bfd, fbit, &cp);
 	if (_ptm_bfd_send(bfd, NULL, &cp, BFD_PKT_LEN) != 0)
 		return;
 
@@ -531,23 +545,44 @@ static void cp_debug(bool mhop, struct sockaddr_any *peer,
 		   mhop ? "yes" : "no", peerstr, localstr, portstr, vrfstr);
 }
 
+ssize_t bfd_recv_control(struct bfd_vrf_global *bvrf, int sd,
+			 uint8_t *msgbuf, size_t msgbuflen, bool *is_mhop,
+			 uint8_t *ttl, ifindex_t *ifindex,
+			 struct sockaddr_any *local, struct sockaddr_any *peer)
+{
+	ssize_t mlen = 0;
+
+	/* Sanitize input/output. */
+	memset(local, 0, sizeof(*local));
+	memset(peer, 0, sizeof(*peer));
+	*ttl = 0;
+	*ifindex = IFINDEX_INTERNAL;
+
+	*is_mhop = false;
+	if (sd == bvrf->bg_shop || sd == bvrf->bg_mhop) {
+		*is_mhop = sd == bvrf->bg_mhop;
+		mlen = bfd_recv_ipv4(sd, msgbuf, msgbuflen, ttl, ifindex, local,
+				     peer);
+	} else if (sd == bvrf->bg_shop6 || sd == bvrf->bg_mhop6) {
+		*is_mhop = sd == bvrf->bg_mhop6;
+		mlen = bfd_recv_ipv6(sd, msgbuf, msgbuflen, ttl, ifindex, local,
+				     peer);
+	}
+
+	return mlen;
+}
+
 int bfd_recv_cb(struct thread *t)
 {
 	int sd = THREAD_FD(t);
-	struct bfd_session *bfd;
-	struct bfd_pkt *cp;
 	bool is_mhop;
-	ssize_t mlen = 0;
-	uint8_t ttl = 0;
-	vrf_id_t vrfid;
-	ifindex_t ifindex = IFINDEX_INTERNAL;
+	ssize_t mlen;
+	uint8_t ttl;
+	ifindex_t ifindex;
 	struct sockaddr_any local, peer;
 	uint8_t msgbuf[1516];
-	struct interface *ifp = NULL;
 	struct bfd_vrf_global *bvrf = THREAD_ARG(t);
 
-	vrfid = bvrf->vrf->vrf_id;
-
 	/* Schedule next read. */
 	bfd_sd_reschedule(bvrf, sd);
 
@@ -557,21 +592,26 @@ int bfd_recv_cb(struct thread *t)
 		return 0;
 	}
 
-	/* Sanitize input/output. */
-	memset(&local, 0, sizeof(local));
-	memset(&peer, 0, sizeof(peer));
-
 	/* Handle control packets. */
-	is_mhop = false;
-	if (sd == bvrf->bg_shop || sd == bvrf->bg_mhop) {
-		is_mhop = sd == bvrf->bg_mhop;
-		mlen = bfd_recv_ipv4(sd, msgbuf, sizeof(msgbuf), &ttl, &ifindex,
-				     &local, &peer);
-	} else if (sd == bvrf->bg_shop6 || sd == bvrf->bg_mhop6) {
-		is_mhop = sd == bvrf->bg_mhop6;
-		mlen = bfd_recv_ipv6(sd, msgbuf, sizeof(msgbuf), &ttl, &ifindex,
-				     &local, &peer);
-	}
+	mlen = bfd_recv_control(bvrf, sd, msgbuf, sizeof(msgbuf), &is_mhop,
+				&ttl, &ifindex, &local, &peer);
+	bfd_recv_process(bvrf, is_mhop, msgbuf, mlen, ttl, ifindex, &local,
+			 &peer);
+
+	return 0;
+}
+
+void bfd_recv_process(struct bfd_vrf_global *bvrf, bool is_mhop,
+		      uint8_t *msgbuf, ssize_t mlen, uint8_t ttl,
+		      ifindex_t ifindex, struct sockaddr_any *local,
+		      struct sockaddr_any *peer)
+{
+	struct bfd_session *bfd;
+	struct bfd_pkt *cp;
+	vrf_id_t vrfid;
+	struct interface *ifp = NULL;
+
+	vrfid = bvrf->vrf->vrf_id;
 
 	/* update vrf-id because when in vrf-lite mode,
 	 * the socket is on default namespace
@@ -584,16 +624,16 @@ int bfd_recv_cb(struct thread *t)
 
 	/* Implement RFC 5880 6.8.6 */
 	if (mlen < BFD_PKT_LEN) {
-		cp_debug(is_mhop, &peer, &local, ifindex, vrfid,
+		cp_debug(is_mhop, peer, local, ifindex, vrfid,
 			 "too small (%ld bytes)", mlen);
-		return 0;
+		return;
 	}
 
 	/* Validate single hop packet TTL. */
 	if ((!is_mhop) && (ttl != BFD_TTL_VAL)) {
-		cp_debug(is_mhop, &peer, &local, ifindex, vrfid,
+		cp_debug(is_mhop, peer, local, ifindex, vrfid,
 			 "invalid TTL: %d expected %d", ttl, BFD_TTL_VAL);
-		return 0;
+		return;
 	}
 
 	/*
@@ -605,34 +645,34 @@ int bfd_recv_cb(struct thread *t)
 	 */
 	cp = (struct bfd_pkt *)(msgbuf);
 	if (BFD_GETVER(cp->diag) != BFD_VERSION) {
-		cp_debug(is_mhop, &peer, &local, ifindex, vrfid,
+		cp_debug(is_mhop, peer, local, ifindex, vrfid,
 			 "bad version %d", BFD_GETVER(cp->diag));
-		return 0;
+		return;
 	}
 
 	if (cp->detect_mult == 0) {
-		cp_debug(is_mhop, &peer, &local, ifindex, vrfid,
+		cp_debug(is_mhop, peer, local, ifindex, vrfid,
 			 "detect multiplier set to zero");
-		return 0;
+		return;
 	}
 
 	if ((cp->len < BFD_PKT_LEN) || (cp->len > mlen)) {
-		cp_debug(is_mhop, &peer, &local, ifindex, vrfid, "too small");
-		return 0;
+		cp_debug(is_mhop, peer, local, ifindex, vrfid, "too small");
+		return;
 	}
 
 	if (cp->discrs.my_discr == 0) {
-		cp_debug(is_mhop, &peer, &local, ifindex, vrfid,
+		cp_debug(is_mhop, peer, local, ifindex, vrfid,
 			 "'my discriminator' is zero");
-		return 0;
+		return;
 	}
 
 	/* Find the session that this packet belongs. */
-	bfd = ptm_bfd_sess_find(cp, &peer, &local, ifindex, vrfid, is_mhop);
+	bfd = ptm_bfd_sess_find(cp, peer, local, ifindex, vrfid, is_mhop);
 	if (bfd == NULL) {
-		cp_debug(is_mhop, &peer, &local, ifindex, vrfid,
+		cp_debug(is_mhop, peer, local, ifindex, vrfid,
 			 "no session found");
-		return 0;
+		return;
 	}
 
 	bfd->stats.rx_ctrl_pkt++;
@@ -643,13 +683,13 @@ int bfd_recv_cb(struct thread *t)
 	 */
 	if (is_mhop) {
 		if (ttl < bfd->mh_ttl) {
-			cp_debug(is_mhop, &peer, &local, ifindex, vrfid,
+			cp_debug(is_mhop, peer, local, ifindex, vrfid,
 				 "exceeded max hop count (expected %d, got %d)",
 				 bfd->mh_ttl, ttl);
-			return 0;
+			return;
 		}
 	} else if (bfd->local_address.sa_sin.sin_family == AF_UNSPEC) {
-		bfd->local_address = local;
+		bfd->local_address = *local;
 	}
 
 	/*
@@ -662,7 +702,7 @@ int bfd_recv_cb(struct thread *t)
 	/* Log remote discriminator changes. */
 	if ((bfd->discrs.remote_discr != 0)
 	    && (bfd->discrs.remote_discr != ntohl(cp->discrs.my_discr)))
-		cp_debug(is_mhop, &peer, &local, ifindex, vrfid,
+		cp_debug(is_mhop, peer, local, ifindex, vrfid,
 			 "remote discriminator mismatch (expected %u, got %u)",
 			 bfd->discrs.remote_discr, ntohl(cp->discrs.my_discr));
 
@@ -715,7 +755,8 @@ int bfd_recv_cb(struct thread *t)
 		ptm_bfd_snd(bfd, 1);
 	}
 
-	return 0;
+	/* Hand steady sessions over to the fast path. */
+	bfd_fastpath_update(bfd, cp);
 }
 
 /*
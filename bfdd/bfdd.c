@@ -89,6 +89,8 @@ static void sigterm_handler(void)
 
 	bfd_vrf_terminate();
 
+	bfd_fastpath_finish();
+
 	/* Terminate and free() FRR related memory. */
 	frr_fini();
 
@@ -139,9 +141,11 @@ FRR_DAEMON_INFO(bfdd, BFD, .vty_port = 2617,
 
 #define OPTION_CTLSOCK 1001
 #define OPTION_DPLANEADDR 2000
+#define OPTION_FASTPATH 2001
 static const struct option longopts[] = {
 	{"bfdctl", required_argument, NULL, OPTION_CTLSOCK},
 	{"dplaneaddr", required_argument, NULL, OPTION_DPLANEADDR},
+	{"fastpath", no_argument, NULL, OPTION_FASTPATH},
 	{0}
 };
 
@@ -343,7 +347,8 @@ int main(int argc, char *argv[])
 	frr_preinit(&bfdd_di, argc, argv);
 	frr_opt_add("", longopts,
 		    "      --bfdctl       Specify bfdd control socket\n"
-		    "      --dplaneaddr   Specify BFD data plane address\n");
+		    "      --dplaneaddr   Specify BFD data plane address\n"
+		    "      --fastpath     Run steady state sessions on a separate pthread\n");
 
 	snprintf(ctl_path, sizeof(ctl_path), BFDD_CONTROL_SOCKET,
 		 "", "");
@@ -361,6 +366,9 @@ int main(int argc, char *argv[])
 			strlcpy(dplane_addr, optarg, sizeof(dplane_addr));
 			bglobal.bg_use_dplane = true;
 			break;
+		case OPTION_FASTPATH:
+			bglobal.bg_use_fastpath = true;
+			break;
 
 		default:
 			frr_help_exit(1);
@@ -381,6 +389,10 @@ int main(int argc, char *argv[])
 	/* Initialize BFD data structures. */
 	bfd_initialize();
 
+	/* Before the VRFs, which schedule the socket reads. */
+	if (bglobal.bg_use_fastpath)
+		bfd_fastpath_init();
+
 	bfd_vrf_init();
 
 	access_list_init();
@@ -397,6 +409,8 @@ int main(int argc, char *argv[])
 	/* read configuration file and daemonize  */
 	frr_config_fork();
 
+	bfd_fastpath_run();
+
 	/* Initialize BFD data plane listening socket. */
 	if (bglobal.bg_use_dplane)
 		distributed_bfd_init(dplane_addr);
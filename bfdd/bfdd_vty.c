@@ -357,14 +357,19 @@ static void _display_all_peers(struct vty *vty, char *vrfname, bool use_json)
 	json_object_free(jo);
 }
 
-static void _display_peer_counter(struct vty *vty, struct bfd_session *bs)
+static void _refresh_peer_counters(struct bfd_session *bs)
 {
-	_display_peer_header(vty, bs);
-
 	/* Ask data plane for updated counters. */
 	if (bfd_dplane_update_session_counters(bs) == -1)
 		zlog_debug("%s: failed to update BFD session counters (%s)",
 			   __func__, bs_to_string(bs));
+	bfd_fastpath_update_session_counters(bs);
+}
+
+/* Callers refresh the counters first. */
+static void _display_peer_counter(struct vty *vty, struct bfd_session *bs)
+{
+	_display_peer_header(vty, bs);
 
 	vty_out(vty, "\t\tControl packet input: %" PRIu64 " packets\n",
 		bs->stats.rx_ctrl_pkt);
@@ -387,11 +392,6 @@ static struct json_object *__display_peer_counters_json(struct bfd_session *bs)
 {
 	struct json_object *jo = _peer_json_header(bs);
 
-	/* Ask data plane for updated counters. */
-	if (bfd_dplane_update_session_counters(bs) == -1)
-		zlog_debug("%s: failed to update BFD session counters (%s)",
-			   __func__, bs_to_string(bs));
-
 	json_object_int_add(jo, "control-packet-input", bs->stats.rx_ctrl_pkt);
 	json_object_int_add(jo, "control-packet-output", bs->stats.tx_ctrl_pkt);
 	json_object_int_add(jo, "echo-packet-input", bs->stats.rx_echo_pkt);
@@ -427,6 +427,7 @@ static void _display_peer_counter_iter(struct hash_bucket *hb, void *arg)
 			return;
 	}
 
+	bfd_fastpath_update_session_counters(bs);
 	_display_peer_counter(vty, bs);
 }
 
@@ -446,6 +447,7 @@ static void _display_peer_counter_json_iter(struct hash_bucket *hb, void *arg)
 			return;
 	}
 
+	bfd_fastpath_update_session_counters(bs);
 	jon = __display_peer_counters_json(bs);
 	if (jon == NULL) {
 		zlog_warn("%s: not enough memory", __func__);
@@ -460,6 +462,9 @@ static void _display_peers_counter(struct vty *vty, char *vrfname, bool use_json
 	struct json_object *jo;
 	struct bfd_vrf_tuple bvt = {0};
 
+	/* One batch of data plane requests rather than one per peer. */
+	bfd_dplane_update_all_counters();
+
 	bvt.vrfname = vrfname;
 	if (!use_json) {
 		bvt.vty = vty;
@@ -480,6 +485,7 @@ static void _clear_peer_counter(struct bfd_session *bs)
 {
 	/* Clear only pkt stats, intention is not to loose system
 	   events counters */
+	bfd_fastpath_update_session_counters(bs);
 	bs->stats.rx_ctrl_pkt = 0;
 	bs->stats.tx_ctrl_pkt = 0;
 	bs->stats.rx_echo_pkt = 0;
@@ -693,6 +699,8 @@ DEFPY(bfd_show_peer_counters, bfd_show_peer_counters_cmd,
 	if (bs == NULL)
 		return CMD_WARNING_CONFIG_FAILED;
 
+	_refresh_peer_counters(bs);
+
 	if (use_json(argc, argv))
 		_display_peer_counters_json(vty, bs);
 	else
@@ -51,6 +51,11 @@ DEFINE_MTYPE_STATIC(BFDD, BFDD_DPLANE_CTX,
 
 /** Data plane client socket buffer size. */
 #define BFD_DPLANE_CLIENT_BUF_SIZE 8192
+/**
+ * The output buffer grows up to this size, so all sessions can be queued
+ * at once when a data plane connects.
+ */
+#define BFD_DPLANE_CLIENT_OUTBUF_MAX (1024 * 1024)
 
 struct bfd_dplane_ctx {
 	/** Client file descriptor. */
@@ -112,6 +117,8 @@ static bool bfd_dplane_client_connecting(struct bfd_dplane_ctx *bdc);
 static void bfd_dplane_ctx_free(struct bfd_dplane_ctx *bdc);
 static int _bfd_dplane_add_session(struct bfd_dplane_ctx *bdc,
 				   struct bfd_session *bs);
+static void bfd_dplane_session_counters(struct bfd_dplane_ctx *bdc,
+					const struct bfddp_session_counters *bsc);
 
 /*
  * BFD data plane helper functions.
@@ -420,13 +427,23 @@ bfd_dplane_session_state_change(struct bfd_dplane_ctx *bdc,
 static int bfd_dplane_enqueue(struct bfd_dplane_ctx *bdc, const void *buf,
 			      size_t buflen)
 {
-	size_t rlen;
+	size_t rlen, size;
 
 	/* Handle not connected yet client. */
 	if (bdc->client && bdc->sock == -1)
 		return -1;
 
-	/* Not enough space. */
+	/* Not enough space: make room for a batch of sessions. */
+	if (buflen > STREAM_WRITEABLE(bdc->outbuf)) {
+		stream_pulldown(bdc->outbuf);
+
+		size = STREAM_SIZE(bdc->outbuf);
+		while (buflen > size - STREAM_READABLE(bdc->outbuf)
+		       && size < BFD_DPLANE_CLIENT_OUTBUF_MAX)
+			size *= 2;
+		if (size != STREAM_SIZE(bdc->outbuf))
+			stream_resize_inplace(&bdc->outbuf, size);
+	}
 	if (buflen > STREAM_WRITEABLE(bdc->outbuf)) {
 		bdc->out_fullev++;
 		return -1;
@@ -500,9 +517,10 @@ static void bfd_dplane_handle_message(struct bfddp_message *msg, void *arg)
 		break;
 	case BFD_SESSION_COUNTERS:
 		/*
-		 * NOTHING: caller of DP_REQUEST_SESSION_COUNTERS should
-		 * handle this with `bfd_dplane_expect`.
+		 * Answers to `bfd_dplane_update_all_counters`, single
+		 * requests are handled with `bfd_dplane_expect`.
 		 */
+		bfd_dplane_session_counters(bdc, &msg->data.session_counters);
 		break;
 
 	default:
@@ -789,29 +807,49 @@ static int _bfd_dplane_add_session(struct bfd_dplane_ctx *bdc,
 	return rv;
 }
 
+static void _bfd_dplane_session_counters_fill(
+	struct bfd_session *bs, const struct bfddp_session_counters *bsc)
+{
+	bs->stats.rx_ctrl_pkt = be64toh(bsc->control_input_packets);
+	bs->stats.tx_ctrl_pkt = be64toh(bsc->control_output_packets);
+	bs->stats.rx_echo_pkt = be64toh(bsc->echo_input_packets);
+	bs->stats.tx_echo_pkt = be64toh(bsc->echo_output_bytes);
+}
+
 static void _bfd_dplane_update_session_counters(struct bfddp_message *msg,
 						void *arg)
 {
 	struct bfd_session *bs = arg;
 
-	bs->stats.rx_ctrl_pkt =
-		be64toh(msg->data.session_counters.control_input_packets);
-	bs->stats.tx_ctrl_pkt =
-		be64toh(msg->data.session_counters.control_output_packets);
-	bs->stats.rx_echo_pkt =
-		be64toh(msg->data.session_counters.echo_input_packets);
-	bs->stats.tx_echo_pkt =
-		be64toh(msg->data.session_counters.echo_output_bytes);
+	_bfd_dplane_session_counters_fill(bs, &msg->data.session_counters);
+}
+
+static void bfd_dplane_session_counters(struct bfd_dplane_ctx *bdc,
+					const struct bfddp_session_counters *bsc)
+{
+	struct bfd_session *bs;
+
+	bs = bfd_id_lookup(ntohl(bsc->lid));
+	if (bs == NULL || bs->bdc != bdc)
+		return;
+
+	_bfd_dplane_session_counters_fill(bs, bsc);
+}
+
+static void _bfd_dplane_all_counters_last(struct bfddp_message *msg,
+					  void *arg)
+{
+	bfd_dplane_session_counters(arg, &msg->data.session_counters);
 }
 
 /**
- * Send message to data plane requesting the session counters.
+ * Enqueue message to data plane requesting the session counters.
  *
  * \param bs the BFD session.
  *
  * \returns `0` on failure or the request id.
  */
-static uint16_t bfd_dplane_request_counters(const struct bfd_session *bs)
+static uint16_t _bfd_dplane_request_counters(const struct bfd_session *bs)
 {
 	struct bfddp_message msg = {};
 	size_t msglen = sizeof(msg.header) + sizeof(msg.data.counters_req);
@@ -829,10 +867,28 @@ static uint16_t bfd_dplane_request_counters(const struct bfd_session *bs)
 	if (bfd_dplane_enqueue(bs->bdc, &msg, msglen) == -1)
 		return 0;
 
+	return ntohs(msg.header.id);
+}
+
+/**
+ * Send message to data plane requesting the session counters.
+ *
+ * \param bs the BFD session.
+ *
+ * \returns `0` on failure or the request id.
+ */
+static uint16_t bfd_dplane_request_counters(const struct bfd_session *bs)
+{
+	uint16_t id;
+
+	id = _bfd_dplane_request_counters(bs);
+	if (id == 0)
+		return 0;
+
 	/* Flush socket. */
 	bfd_dplane_flush(bs->bdc);
 
-	return ntohs(msg.header.id);
+	return id;
 }
 
 /*
@@ -1197,3 +1253,52 @@ int bfd_dplane_update_session_counters(struct bfd_session *bs)
 
 	return rv;
 }
+
+struct bfd_dplane_counters_batch {
+	struct bfd_dplane_ctx *bdc;
+	uint16_t last_id;
+};
+
+static void _bfd_dplane_request_all_counters(struct hash_bucket *hb,
+					     void *arg)
+{
+	struct bfd_dplane_counters_batch *batch = arg;
+	struct bfd_session *bs = hb->data;
+	uint16_t id;
+
+	if (bs->bdc != batch->bdc)
+		return;
+
+	id = _bfd_dplane_request_counters(bs);
+	if (id != 0)
+		batch->last_id = id;
+}
+
+void bfd_dplane_update_all_counters(void)
+{
+	struct bfd_dplane_counters_batch batch;
+	struct bfd_dplane_ctx *bdc, *bdcn;
+	int rv;
+
+	TAILQ_FOREACH_SAFE (bdc, &bglobal.bg_dplaneq, entry, bdcn) {
+		batch.bdc = bdc;
+		batch.last_id = 0;
+		bfd_id_iterate(_bfd_dplane_request_all_counters, &batch);
+		if (batch.last_id == 0)
+			continue;
+
+		/* Nothing written means the connection went away. */
+		if (bfd_dplane_flush(bdc) == 0)
+			continue;
+
+		/*
+		 * Answers come in order: the other ones are handled by
+		 * `bfd_dplane_handle_message` while waiting for the last.
+		 */
+		do {
+			rv = bfd_dplane_expect(bdc, batch.last_id,
+					       _bfd_dplane_all_counters_last,
+					       bdc);
+		} while (rv == -2);
+	}
+}
@@ -35,40 +35,94 @@ void tv_normalize(struct timeval *tv)
 	tv->tv_usec = tv->tv_usec % 1000000;
 }
 
-void bfd_recvtimer_update(struct bfd_session *bs)
+/*
+ * Every packet received pushes the detection deadline forward.  Instead of
+ * cancelling and adding a timer each time, only the deadline moves: a
+ * running timer that fires no later than the new deadline is left alone,
+ * and the callback arms it again for what's left when it fires early.
+ */
+static void bfd_detect_timer_update(struct bfd_session *bs, uint64_t usec,
+				    int (*func)(struct thread *),
+				    struct thread **ev,
+				    struct timeval *deadline)
 {
-	struct timeval tv = {.tv_sec = 0, .tv_usec = bs->detect_TO};
+	struct timeval tv = {.tv_sec = 0, .tv_usec = usec};
+	struct timeval now, remain;
 
-	/* Remove previous schedule if any. */
-	bfd_recvtimer_delete(bs);
+	tv_normalize(&tv);
+	monotime(&now);
+	timeradd(&now, &tv, deadline);
 
+	if (*ev) {
+		remain = thread_timer_remain(*ev);
+		if (timercmp(&remain, &tv, <=))
+			return;
+		THREAD_OFF(*ev);
+	}
+
+	thread_add_timer_tv(master, func, bs, &tv, ev);
+}
+
+static bool bfd_detect_timer_rearm(struct bfd_session *bs,
+				   int (*func)(struct thread *),
+				   struct thread **ev,
+				   const struct timeval *deadline)
+{
+	struct timeval now, tv;
+
+	monotime(&now);
+	if (!timercmp(&now, deadline, <))
+		return false;
+
+	timersub(deadline, &now, &tv);
+	thread_add_timer_tv(master, func, bs, &tv, ev);
+	return true;
+}
+
+void bfd_recvtimer_update(struct bfd_session *bs)
+{
 	/* Don't add event if peer is deactivated. */
 	if (CHECK_FLAG(bs->flags, BFD_SESS_FLAG_SHUTDOWN) ||
-	    bs->sock == -1)
+	    bs->sock == -1) {
+		bfd_recvtimer_delete(bs);
 		return;
+	}
 
-	tv_normalize(&tv);
+	/* The fast path is watching the session. */
+	if (bs->fp) {
+		bfd_recvtimer_delete(bs);
+		return;
+	}
 
-	thread_add_timer_tv(master, bfd_recvtimer_cb, bs, &tv,
-			    &bs->recvtimer_ev);
+	bfd_detect_timer_update(bs, bs->detect_TO, bfd_recvtimer_cb,
+				&bs->recvtimer_ev, &bs->recv_deadline);
 }
 
 void bfd_echo_recvtimer_update(struct bfd_session *bs)
 {
-	struct timeval tv = {.tv_sec = 0, .tv_usec = bs->echo_detect_TO};
-
-	/* Remove previous schedule if any. */
-	bfd_echo_recvtimer_delete(bs);
-
 	/* Don't add event if peer is deactivated. */
 	if (CHECK_FLAG(bs->flags, BFD_SESS_FLAG_SHUTDOWN) ||
-	    bs->sock == -1)
+	    bs->sock == -1) {
+		bfd_echo_recvtimer_delete(bs);
 		return;
+	}
 
-	tv_normalize(&tv);
+	bfd_detect_timer_update(bs, bs->echo_detect_TO, bfd_echo_recvtimer_cb,
+				&bs->echo_recvtimer_ev,
+				&bs->echo_recv_deadline);
+}
 
-	thread_add_timer_tv(master, bfd_echo_recvtimer_cb, bs, &tv,
-			    &bs->echo_recvtimer_ev);
+bool bfd_recvtimer_rearm(struct bfd_session *bs)
+{
+	return bfd_detect_timer_rearm(bs, bfd_recvtimer_cb, &bs->recvtimer_ev,
+				      &bs->recv_deadline);
+}
+
+bool bfd_echo_recvtimer_rearm(struct bfd_session *bs)
+{
+	return bfd_detect_timer_rearm(bs, bfd_echo_recvtimer_cb,
+				      &bs->echo_recvtimer_ev,
+				      &bs->echo_recv_deadline);
 }
 
 void bfd_xmttimer_update(struct bfd_session *bs, uint64_t jitter)
@@ -83,6 +137,10 @@ void bfd_xmttimer_update(struct bfd_session *bs, uint64_t jitter)
 	    bs->sock == -1)
 		return;
 
+	/* The fast path is sending the control packets. */
+	if (bs->fp)
+		return;
+
 	tv_normalize(&tv);
 
 	thread_add_timer_tv(master, bfd_xmt_cb, bs, &tv, &bs->xmttimer_ev);
@@ -0,0 +1,677 @@
+/*
+ * BFD steady state sessions on a separate pthread.
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Once a session is up and its packets stop changing, all there is left to
+ * do is sending the same control packet every transmission interval and
+ * restarting the detection timer whenever the same packet from the peer
+ * comes in.  The fast path pthread does just that for the sessions the main
+ * pthread hands over, so a busy main pthread can't bring them down.  It
+ * reads the control packet sockets, consumes the packets it expects and
+ * queues every other one for the main pthread, which keeps running the
+ * state machine: as soon as something the session sends or receives
+ * changes, the session goes back to the main pthread's timers.
+ */
+
+#include <zebra.h>
+
+#include "lib/frr_pthread.h"
+#include "lib/frratomic.h"
+#include "lib/jhash.h"
+#include "lib/memory.h"
+#include "lib/network.h"
+#include "lib/typesafe.h"
+
+#include "bfd.h"
+
+DEFINE_MTYPE_STATIC(BFDD, BFDD_FP_SESSION, "BFD fast path session");
+DEFINE_MTYPE_STATIC(BFDD, BFDD_FP_RX, "BFD fast path queued packet");
+
+/* control packets read per socket wakeup */
+#define BFD_FP_RX_BATCH 32
+/* queued items processed per run of bfd_fp_rx_process() */
+#define BFD_FP_PROCESS_MAX 64
+
+PREDECL_HASH(bfd_fp_sessions);
+PREDECL_LIST(bfd_fp_sync);
+PREDECL_LIST(bfd_fp_rxq);
+
+struct bfd_fp_session {
+	struct bfd_fp_sessions_item hitem;
+	struct bfd_fp_sync_item sitem;
+
+	/* set by the main pthread before the session is added */
+	uint32_t lid;
+	uint64_t gen;
+	/* our own copy, closed by the fast path pthread */
+	int sock;
+	struct sockaddr_any dst;
+	socklen_t dstlen;
+	bool mhop;
+
+	/* the rest is under fp_mtx */
+	struct bfd_pkt tx;
+	/* the packet the peer keeps sending */
+	struct bfd_pkt rx;
+	uint64_t xmt_TO;
+	uint64_t detect_TO;
+	uint8_t detect_mult;
+	uint8_t mh_ttl;
+	/* the main pthread processed a packet from the peer */
+	bool heard;
+	/* the timers changed */
+	bool resched;
+	/* handed back to the main pthread, to be freed */
+	bool dead;
+	/* on the fp_sync list */
+	bool syncing;
+	/* the detection timer ran out */
+	bool expired;
+
+	/* fast path pthread only */
+	struct thread *t_xmt;
+	struct thread *t_detect;
+
+	_Atomic uint64_t rx_cnt;
+	_Atomic uint64_t tx_cnt;
+};
+
+struct bfd_fp_rx {
+	struct bfd_fp_rxq_item item;
+
+	/* a detection timeout rather than a packet */
+	bool expired;
+	uint32_t lid;
+	uint64_t gen;
+
+	struct bfd_vrf_global *bvrf;
+	bool is_mhop;
+	uint8_t ttl;
+	ifindex_t ifindex;
+	struct sockaddr_any local;
+	struct sockaddr_any peer;
+	ssize_t mlen;
+	uint8_t buf[];
+};
+
+static int bfd_fp_sessions_cmp(const struct bfd_fp_session *a,
+			       const struct bfd_fp_session *b)
+{
+	return numcmp(a->lid, b->lid);
+}
+
+static uint32_t bfd_fp_sessions_hash(const struct bfd_fp_session *fs)
+{
+	return jhash_1word(fs->lid, 0);
+}
+
+DECLARE_HASH(bfd_fp_sessions, struct bfd_fp_session, hitem,
+	     bfd_fp_sessions_cmp, bfd_fp_sessions_hash);
+DECLARE_LIST(bfd_fp_sync, struct bfd_fp_session, sitem);
+DECLARE_LIST(bfd_fp_rxq, struct bfd_fp_rx, item);
+
+static struct frr_pthread *fp_pth;
+
+/* the sessions by local discriminator, and those with news for the pthread */
+static pthread_mutex_t fp_mtx = PTHREAD_MUTEX_INITIALIZER;
+static struct bfd_fp_sessions_head fp_sessions;
+static struct bfd_fp_sync_head fp_sync;
+static struct thread *t_fp_sync;
+
+/* main pthread only */
+static uint64_t fp_gen;
+
+/* filled by the fast path pthread, drained by the main pthread */
+static pthread_mutex_t rx_mtx = PTHREAD_MUTEX_INITIALIZER;
+static struct bfd_fp_rxq_head rx_queue;
+static struct thread *t_rx_process;
+
+static int bfd_fp_xmt(struct thread *t);
+static int bfd_fp_detect(struct thread *t);
+static int bfd_fp_read(struct thread *t);
+static int bfd_fp_rx_process(struct thread *t);
+
+static void bfd_fp_tv(uint64_t usec, struct timeval *tv)
+{
+	tv->tv_sec = usec / 1000000;
+	tv->tv_usec = usec % 1000000;
+}
+
+/* The fast path pthread functions, they all need fp_mtx. */
+static void bfd_fp_xmt_schedule(struct bfd_fp_session *fs)
+{
+	struct timeval tv;
+	uint64_t jitter;
+	int maxpercent;
+
+	/* Same jitter as ptm_bfd_start_xmt_timer(). */
+	maxpercent = (fs->detect_mult == 1) ? 16 : 26;
+	jitter = (fs->xmt_TO * (75 + (frr_weak_random() % maxpercent))) / 100;
+	bfd_fp_tv(jitter, &tv);
+
+	THREAD_OFF(fs->t_xmt);
+	thread_add_timer_tv(fp_pth->master, bfd_fp_xmt, fs, &tv, &fs->t_xmt);
+}
+
+static void bfd_fp_detect_schedule(struct bfd_fp_session *fs)
+{
+	struct timeval tv;
+
+	bfd_fp_tv(fs->detect_TO, &tv);
+
+	THREAD_OFF(fs->t_detect);
+	thread_add_timer_tv(fp_pth->master, bfd_fp_detect, fs, &tv,
+			    &fs->t_detect);
+}
+
+static void bfd_fp_session_free(struct bfd_fp_session *fs)
+{
+	THREAD_OFF(fs->t_xmt);
+	THREAD_OFF(fs->t_detect);
+	close(fs->sock);
+	XFREE(MTYPE_BFDD_FP_SESSION, fs);
+}
+
+/* fast path pthread */
+static void bfd_fp_rx_post(struct bfd_fp_rxq_head *q)
+{
+	struct bfd_fp_rx *rx;
+
+	if (!bfd_fp_rxq_count(q))
+		return;
+
+	frr_with_mutex(&rx_mtx) {
+		while ((rx = bfd_fp_rxq_pop(q)))
+			bfd_fp_rxq_add_tail(&rx_queue, rx);
+	}
+	thread_add_event(master, bfd_fp_rx_process, NULL, 0, &t_rx_process);
+}
+
+/* fast path pthread */
+static int bfd_fp_xmt(struct thread *t)
+{
+	struct bfd_fp_session *fs = THREAD_ARG(t);
+	struct bfd_pkt cp;
+
+	frr_with_mutex(&fp_mtx) {
+		if (fs->dead || fs->expired)
+			return 0;
+
+		cp = fs->tx;
+		bfd_fp_xmt_schedule(fs);
+	}
+
+	/* Send errors show up as the peer's detection timeout. */
+	if (sendto(fs->sock, &cp, BFD_PKT_LEN, 0, (struct sockaddr *)&fs->dst,
+		   fs->dstlen)
+	    == BFD_PKT_LEN)
+		atomic_fetch_add_explicit(&fs->tx_cnt, 1, memory_order_relaxed);
+
+	return 0;
+}
+
+/* fast path pthread */
+static int bfd_fp_detect(struct thread *t)
+{
+	struct bfd_fp_session *fs = THREAD_ARG(t);
+	struct bfd_fp_rxq_head q;
+	struct bfd_fp_rx *rx;
+
+	frr_with_mutex(&fp_mtx) {
+		if (fs->dead)
+			return 0;
+
+		/* Stop telling the peer we're up, the main pthread takes it. */
+		fs->expired = true;
+		THREAD_OFF(fs->t_xmt);
+	}
+
+	rx = XCALLOC(MTYPE_BFDD_FP_RX, sizeof(*rx));
+	rx->expired = true;
+	rx->lid = fs->lid;
+	rx->gen = fs->gen;
+
+	bfd_fp_rxq_init(&q);
+	bfd_fp_rxq_add_tail(&q, rx);
+	bfd_fp_rx_post(&q);
+	bfd_fp_rxq_fini(&q);
+
+	return 0;
+}
+
+/* fast path pthread */
+static int bfd_fp_sync(struct thread *t)
+{
+	struct bfd_fp_session *fs;
+
+	frr_with_mutex(&fp_mtx) {
+		while ((fs = bfd_fp_sync_pop(&fp_sync))) {
+			fs->syncing = false;
+
+			if (fs->dead) {
+				bfd_fp_session_free(fs);
+				continue;
+			}
+			if (fs->expired)
+				continue;
+
+			if (fs->resched || !fs->t_xmt)
+				bfd_fp_xmt_schedule(fs);
+			if (fs->resched || fs->heard || !fs->t_detect)
+				bfd_fp_detect_schedule(fs);
+			fs->resched = false;
+			fs->heard = false;
+		}
+	}
+
+	return 0;
+}
+
+static bool bfd_fp_same_peer(const struct bfd_fp_session *fs,
+			     const struct sockaddr_any *peer)
+{
+	if (fs->dst.sa_sin.sin_family != peer->sa_sin.sin_family)
+		return false;
+	if (peer->sa_sin.sin_family == AF_INET)
+		return fs->dst.sa_sin.sin_addr.s_addr
+		       == peer->sa_sin.sin_addr.s_addr;
+
+	return IN6_ARE_ADDR_EQUAL(&fs->dst.sa_sin6.sin6_addr,
+				  &peer->sa_sin6.sin6_addr);
+}
+
+/*
+ * Fast path pthread: consumes the packet if it's the very one its session
+ * expects, after the same checks bfd_recv_process() would do.
+ */
+static bool bfd_fp_rx_steady(const uint8_t *msgbuf, ssize_t mlen,
+			     bool is_mhop, uint8_t ttl,
+			     const struct sockaddr_any *peer)
+{
+	const struct bfd_pkt *cp = (const struct bfd_pkt *)msgbuf;
+	struct bfd_fp_session *fs, ref;
+
+	if (mlen != BFD_PKT_LEN || cp->discrs.remote_discr == 0)
+		return false;
+	if (!is_mhop && ttl != BFD_TTL_VAL)
+		return false;
+
+	ref.lid = ntohl(cp->discrs.remote_discr);
+
+	frr_with_mutex(&fp_mtx) {
+		fs = bfd_fp_sessions_find(&fp_sessions, &ref);
+		if (fs == NULL || fs->expired || fs->mhop != is_mhop)
+			return false;
+		if (is_mhop && ttl < fs->mh_ttl)
+			return false;
+		if (!bfd_fp_same_peer(fs, peer)
+		    || memcmp(cp, &fs->rx, BFD_PKT_LEN))
+			return false;
+
+		bfd_fp_detect_schedule(fs);
+		atomic_fetch_add_explicit(&fs->rx_cnt, 1, memory_order_relaxed);
+	}
+
+	return true;
+}
+
+static void bfd_fp_read_reschedule(struct bfd_vrf_global *bvrf, int sd)
+{
+	struct thread **ev;
+
+	if (sd == bvrf->bg_shop)
+		ev = &bvrf->bg_ev[0];
+	else if (sd == bvrf->bg_mhop)
+		ev = &bvrf->bg_ev[1];
+	else if (sd == bvrf->bg_shop6)
+		ev = &bvrf->bg_ev[2];
+	else if (sd == bvrf->bg_mhop6)
+		ev = &bvrf->bg_ev[3];
+	else
+		return;
+
+	thread_add_read(fp_pth->master, bfd_fp_read, bvrf, sd, ev);
+}
+
+/* fast path pthread */
+static int bfd_fp_read(struct thread *t)
+{
+	struct bfd_vrf_global *bvrf = THREAD_ARG(t);
+	int sd = THREAD_FD(t);
+	struct sockaddr_any local, peer;
+	struct bfd_fp_rxq_head q;
+	struct bfd_fp_rx *rx;
+	uint8_t msgbuf[1516];
+	ifindex_t ifindex;
+	bool is_mhop;
+	ssize_t mlen;
+	uint8_t ttl;
+	int i;
+
+	bfd_fp_read_reschedule(bvrf, sd);
+
+	bfd_fp_rxq_init(&q);
+
+	for (i = 0; i < BFD_FP_RX_BATCH; i++) {
+		mlen = bfd_recv_control(bvrf, sd, msgbuf, sizeof(msgbuf),
+					&is_mhop, &ttl, &ifindex, &local,
+					&peer);
+		if (mlen < 0)
+			break;
+
+		if (bfd_fp_rx_steady(msgbuf, mlen, is_mhop, ttl, &peer))
+			continue;
+
+		rx = XCALLOC(MTYPE_BFDD_FP_RX, sizeof(*rx) + mlen);
+		rx->bvrf = bvrf;
+		rx->is_mhop = is_mhop;
+		rx->ttl = ttl;
+		rx->ifindex = ifindex;
+		rx->local = local;
+		rx->peer = peer;
+		rx->mlen = mlen;
+		memcpy(rx->buf, msgbuf, mlen);
+		bfd_fp_rxq_add_tail(&q, rx);
+	}
+
+	bfd_fp_rx_post(&q);
+	bfd_fp_rxq_fini(&q);
+
+	return 0;
+}
+
+/* The main pthread functions. */
+static void bfd_fp_sync_add(struct bfd_fp_session *fs)
+{
+	/* Needs fp_mtx. */
+	if (!fs->syncing) {
+		fs->syncing = true;
+		bfd_fp_sync_add_tail(&fp_sync, fs);
+	}
+	thread_add_event(fp_pth->master, bfd_fp_sync, NULL, 0, &t_fp_sync);
+}
+
+static void bfd_fp_expired(uint32_t lid, uint64_t gen)
+{
+	struct bfd_session *bs = bfd_id_lookup(lid);
+
+	/* Handed back, or over again, since. */
+	if (bs == NULL || bs->fp == NULL || bs->fp->gen != gen)
+		return;
+
+	bfd_fastpath_release(bs, true);
+
+	/* Same as bfd_recvtimer_cb(), the session was up. */
+	ptm_bfd_sess_dn(bs, BD_CONTROL_EXPIRED);
+	bfd_recvtimer_update(bs);
+}
+
+static int bfd_fp_rx_process(struct thread *t)
+{
+	struct bfd_fp_rxq_head q;
+	struct bfd_fp_rx *rx;
+	unsigned int n;
+	bool more;
+
+	bfd_fp_rxq_init(&q);
+
+	frr_with_mutex(&rx_mtx) {
+		for (n = 0; n < BFD_FP_PROCESS_MAX
+			    && (rx = bfd_fp_rxq_pop(&rx_queue));
+		     n++)
+			bfd_fp_rxq_add_tail(&q, rx);
+		more = bfd_fp_rxq_count(&rx_queue) > 0;
+	}
+
+	while ((rx = bfd_fp_rxq_pop(&q))) {
+		if (rx->expired)
+			bfd_fp_expired(rx->lid, rx->gen);
+		else
+			bfd_recv_process(rx->bvrf, rx->is_mhop, rx->buf,
+					 rx->mlen, rx->ttl, rx->ifindex,
+					 &rx->local, &rx->peer);
+		XFREE(MTYPE_BFDD_FP_RX, rx);
+	}
+
+	bfd_fp_rxq_fini(&q);
+
+	if (more)
+		thread_add_event(master, bfd_fp_rx_process, NULL, 0,
+				 &t_rx_process);
+	return 0;
+}
+
+static bool bfd_fp_steady(const struct bfd_session *bs)
+{
+	return fp_pth && bs->bdc == NULL && bs->sock != -1
+	       && bs->ses_state == PTM_BFD_UP && !bs->polling
+	       && !bs->demand_mode
+	       && !CHECK_FLAG(bs->flags, BFD_SESS_FLAG_SHUTDOWN)
+	       && bs->xmt_TO && bs->detect_TO;
+}
+
+/* A packet the peer will repeat until something changes. */
+static bool bfd_fp_plain(const struct bfd_pkt *cp)
+{
+	return cp->len == BFD_PKT_LEN && !BFD_GETPBIT(cp->flags)
+	       && !BFD_GETFBIT(cp->flags);
+}
+
+static void bfd_fp_take(struct bfd_session *bs, const struct bfd_pkt *cp)
+{
+	struct bfd_fp_session *fs;
+	int sock;
+
+	sock = dup(bs->sock);
+	if (sock == -1)
+		return;
+
+	fs = XCALLOC(MTYPE_BFDD_FP_SESSION, sizeof(*fs));
+	fs->lid = bs->discrs.my_discr;
+	fs->gen = ++fp_gen;
+	fs->sock = sock;
+	fs->dstlen = bp_peer_sockaddr(bs, NULL, &fs->dst);
+	fs->mhop = CHECK_FLAG(bs->flags, BFD_SESS_FLAG_MH);
+	fs->mh_ttl = bs->mh_ttl;
+	ptm_bfd_pkt_build(bs, 0, &fs->tx);
+	fs->rx = *cp;
+	fs->xmt_TO = bs->xmt_TO;
+	fs->detect_TO = bs->detect_TO;
+	fs->detect_mult = bs->detect_mult;
+
+	/* The fast path runs both from now on. */
+	bfd_xmttimer_delete(bs);
+	bfd_recvtimer_delete(bs);
+	bs->fp = fs;
+
+	frr_with_mutex(&fp_mtx) {
+		bfd_fp_sessions_add(&fp_sessions, fs);
+		bfd_fp_sync_add(fs);
+	}
+}
+
+void bfd_fastpath_update(struct bfd_session *bs, const struct bfd_pkt *cp)
+{
+	struct bfd_fp_session *fs = bs->fp;
+
+	if (!bfd_fp_steady(bs)) {
+		bfd_fastpath_release(bs, true);
+		return;
+	}
+
+	if (fs == NULL) {
+		/* Only take over from a packet we know the peer repeats. */
+		if (cp && bfd_fp_plain(cp))
+			bfd_fp_take(bs, cp);
+		return;
+	}
+
+	frr_with_mutex(&fp_mtx) {
+		ptm_bfd_pkt_build(bs, 0, &fs->tx);
+		fs->mh_ttl = bs->mh_ttl;
+
+		if (cp) {
+			if (bfd_fp_plain(cp))
+				fs->rx = *cp;
+			fs->heard = true;
+		}
+
+		if (fs->xmt_TO != bs->xmt_TO || fs->detect_TO != bs->detect_TO
+		    || fs->detect_mult != bs->detect_mult) {
+			fs->xmt_TO = bs->xmt_TO;
+			fs->detect_TO = bs->detect_TO;
+			fs->detect_mult = bs->detect_mult;
+			fs->resched = true;
+		}
+
+		if (fs->heard || fs->resched)
+			bfd_fp_sync_add(fs);
+	}
+}
+
+void bfd_fastpath_release(struct bfd_session *bs, bool restart)
+{
+	struct bfd_fp_session *fs = bs->fp;
+
+	if (fs == NULL)
+		return;
+
+	/* The pthread frees the session once it's dead. */
+	bfd_fastpath_update_session_counters(bs);
+	bs->fp = NULL;
+
+	frr_with_mutex(&fp_mtx) {
+		bfd_fp_sessions_del(&fp_sessions, fs);
+		fs->dead = true;
+		bfd_fp_sync_add(fs);
+	}
+
+	if (restart) {
+		bfd_recvtimer_update(bs);
+		ptm_bfd_start_xmt_timer(bs, false);
+	}
+}
+
+void bfd_fastpath_update_session_counters(struct bfd_session *bs)
+{
+	struct bfd_fp_session *fs = bs->fp;
+
+	if (fs == NULL)
+		return;
+
+	bs->stats.rx_ctrl_pkt += atomic_exchange_explicit(
+		&fs->rx_cnt, 0, memory_order_relaxed);
+	bs->stats.tx_ctrl_pkt += atomic_exchange_explicit(
+		&fs->tx_cnt, 0, memory_order_relaxed);
+}
+
+void bfd_fastpath_reads_on(struct bfd_vrf_global *bvrf)
+{
+	if (bvrf->bg_shop != -1)
+		thread_add_read(fp_pth->master, bfd_fp_read, bvrf,
+				bvrf->bg_shop, &bvrf->bg_ev[0]);
+	if (bvrf->bg_mhop != -1)
+		thread_add_read(fp_pth->master, bfd_fp_read, bvrf,
+				bvrf->bg_mhop, &bvrf->bg_ev[1]);
+	if (bvrf->bg_shop6 != -1)
+		thread_add_read(fp_pth->master, bfd_fp_read, bvrf,
+				bvrf->bg_shop6, &bvrf->bg_ev[2]);
+	if (bvrf->bg_mhop6 != -1)
+		thread_add_read(fp_pth->master, bfd_fp_read, bvrf,
+				bvrf->bg_mhop6, &bvrf->bg_ev[3]);
+}
+
+void bfd_fastpath_reads_off(struct bfd_vrf_global *bvrf)
+{
+	struct bfd_fp_rx *rx;
+	int i;
+
+	if (fp_pth == NULL)
+		return;
+
+	for (i = 0; i < 4; i++)
+		thread_cancel_async(fp_pth->master, &bvrf->bg_ev[i], NULL);
+
+	frr_with_mutex(&rx_mtx) {
+		frr_each_safe (bfd_fp_rxq, &rx_queue, rx) {
+			if (rx->expired || rx->bvrf != bvrf)
+				continue;
+			bfd_fp_rxq_del(&rx_queue, rx);
+			XFREE(MTYPE_BFDD_FP_RX, rx);
+		}
+	}
+}
+
+void bfd_fastpath_init(void)
+{
+	struct frr_pthread_attr attr = {
+		.start = frr_pthread_attr_default.start,
+		.stop = frr_pthread_attr_default.stop,
+	};
+
+	assert(fp_pth == NULL);
+
+	bfd_fp_sessions_init(&fp_sessions);
+	bfd_fp_sync_init(&fp_sync);
+	bfd_fp_rxq_init(&rx_queue);
+
+	fp_pth = frr_pthread_new(&attr, "BFD fast path", "bfdd_fp");
+}
+
+void bfd_fastpath_run(void)
+{
+	if (fp_pth == NULL)
+		return;
+
+	frr_pthread_run(fp_pth, NULL);
+	frr_pthread_wait_running(fp_pth);
+}
+
+void bfd_fastpath_finish(void)
+{
+	struct bfd_fp_session *fs;
+	struct bfd_fp_rx *rx;
+
+	if (fp_pth == NULL)
+		return;
+
+	frr_pthread_stop(fp_pth, NULL);
+	frr_pthread_destroy(fp_pth);
+	fp_pth = NULL;
+
+	/* The timers went with the pthread, dead sessions are only queued. */
+	while ((fs = bfd_fp_sync_pop(&fp_sync))) {
+		if (!fs->dead)
+			continue;
+		close(fs->sock);
+		XFREE(MTYPE_BFDD_FP_SESSION, fs);
+	}
+	while ((fs = bfd_fp_sessions_pop(&fp_sessions))) {
+		close(fs->sock);
+		XFREE(MTYPE_BFDD_FP_SESSION, fs);
+	}
+
+	THREAD_OFF(t_rx_process);
+	while ((rx = bfd_fp_rxq_pop(&rx_queue)))
+		XFREE(MTYPE_BFDD_FP_RX, rx);
+
+	bfd_fp_sessions_fini(&fp_sessions);
+	bfd_fp_sync_fini(&fp_sync);
+	bfd_fp_rxq_fini(&rx_queue);
+}
@@ -38,6 +38,13 @@ static const struct bgp_addpath_strategy_names strat_names[BGP_ADDPATH_MAX] = {
 		.human_description = "Advertise bestpath per AS via addpath",
 		.type_json_name = "addpathTxBestpathPerAS",
 		.id_json_name = "addpathTxIdBestPerAS"
+	},
+	{
+		.config_name = "addpath-tx-best-selected",
+		.human_name = "Best-Selected",
+		.human_description = "Advertise best N selected paths via addpath",
+		.type_json_name = "addpathTxBestSelectedPaths",
+		.id_json_name = "addpathTxIdBestSelected"
 	}
 };
 
@@ -171,11 +178,31 @@ bool bgp_addpath_tx_path(enum bgp_addpath_strat strat, struct bgp_path_info *pi)
 			return true;
 		else
 			return false;
+	case BGP_ADDPATH_BEST_SELECTED:
+		return pi->tx_addpath.best_selected_rank != 0;
 	default:
 		return false;
 	}
 }
 
+/*
+ * Return true if this is a path the peer should be sent due to its addpath-tx
+ * knob.  Unlike the other strategies, how many of the ranked paths
+ * addpath-tx-best-selected sends depends on the peer.
+ */
+bool bgp_addpath_capable(struct bgp_path_info *pi, struct peer *peer,
+			 afi_t afi, safi_t safi)
+{
+	enum bgp_addpath_strat strat = peer->addpath_type[afi][safi];
+
+	if (strat == BGP_ADDPATH_BEST_SELECTED)
+		return pi->tx_addpath.best_selected_rank != 0
+		       && pi->tx_addpath.best_selected_rank
+				  <= peer->addpath_best_selected[afi][safi];
+
+	return bgp_addpath_tx_path(strat, pi);
+}
+
 static void bgp_addpath_flush_type_rn(struct bgp *bgp, afi_t afi, safi_t safi,
 				      enum bgp_addpath_strat addpath_type,
 				      struct bgp_dest *dest)
@@ -312,6 +339,8 @@ void bgp_addpath_type_changed(struct bgp *bgp)
 	struct listnode *node, *nnode;
 	struct peer *peer;
 	int peer_count[AFI_MAX][SAFI_MAX][BGP_ADDPATH_MAX];
+	uint8_t best_selected_max[AFI_MAX][SAFI_MAX];
+	bool rerank = false;
 	enum bgp_addpath_strat type;
 
 	FOREACH_AFI_SAFI(afi, safi) {
@@ -319,6 +348,7 @@ void bgp_addpath_type_changed(struct bgp *bgp)
 			peer_count[afi][safi][type] = 0;
 		}
 		bgp->tx_addpath.total_peercount[afi][safi] = 0;
+		best_selected_max[afi][safi] = 0;
 	}
 
 	for (ALL_LIST_ELEMENTS(bgp->peer, node, nnode, peer)) {
@@ -328,9 +358,28 @@ void bgp_addpath_type_changed(struct bgp *bgp)
 				peer_count[afi][safi][type] += 1;
 				bgp->tx_addpath.total_peercount[afi][safi] += 1;
 			}
+			if (type == BGP_ADDPATH_BEST_SELECTED
+			    && peer->addpath_best_selected[afi][safi]
+				       > best_selected_max[afi][safi])
+				best_selected_max[afi][safi] =
+					peer->addpath_best_selected[afi][safi];
 		}
 	}
 
+	/* The paths are only ranked as far as needed, see
+	 * bgp_addpath_rank_paths()
+	 */
+	FOREACH_AFI_SAFI(afi, safi) {
+		if (best_selected_max[afi][safi]
+		    == bgp->tx_addpath.best_selected_max[afi][safi])
+			continue;
+
+		bgp->tx_addpath.best_selected_max[afi][safi] =
+			best_selected_max[afi][safi];
+		if (best_selected_max[afi][safi])
+			rerank = true;
+	}
+
 	FOREACH_AFI_SAFI(afi, safi) {
 		for (type=0; type<BGP_ADDPATH_MAX; type++) {
 			int old = bgp->tx_addpath.peercount[afi][safi][type];
@@ -346,6 +395,9 @@ void bgp_addpath_type_changed(struct bgp *bgp)
 			}
 		}
 	}
+
+	if (rerank)
+		bgp_recalculate_all_bestpaths(bgp);
 }
 
 /*
@@ -354,24 +406,31 @@ void bgp_addpath_type_changed(struct bgp *bgp)
  * change take effect.
  */
 void bgp_addpath_set_peer_type(struct peer *peer, afi_t afi, safi_t safi,
-			      enum bgp_addpath_strat addpath_type)
+			      enum bgp_addpath_strat addpath_type,
+			      uint8_t paths)
 {
 	struct bgp *bgp = peer->bgp;
 	enum bgp_addpath_strat old_type = peer->addpath_type[afi][safi];
+	uint8_t old_paths = peer->addpath_best_selected[afi][safi];
 	struct listnode *node, *nnode;
 	struct peer *tmp_peer;
 	struct peer_group *group;
 
-	if (addpath_type == old_type)
+	if (addpath_type != BGP_ADDPATH_BEST_SELECTED)
+		paths = 0;
+
+	if (addpath_type == old_type && paths == old_paths)
 		return;
 
 	if (addpath_type == BGP_ADDPATH_NONE && peer->group &&
 	    !CHECK_FLAG(peer->sflags, PEER_STATUS_GROUP)) {
 		/* A "no" config on a group member inherits group */
 		addpath_type = peer->group->conf->addpath_type[afi][safi];
+		paths = peer->group->conf->addpath_best_selected[afi][safi];
 	}
 
 	peer->addpath_type[afi][safi] = addpath_type;
+	peer->addpath_best_selected[afi][safi] = paths;
 
 	bgp_addpath_type_changed(bgp);
 
@@ -404,11 +463,14 @@ void bgp_addpath_set_peer_type(struct peer *peer, afi_t afi, safi_t safi,
 			for (ALL_LIST_ELEMENTS(group->peer, node, nnode,
 			     tmp_peer)) {
 				if (tmp_peer->addpath_type[afi][safi] ==
-				    old_type) {
+				    old_type
+				    && tmp_peer->addpath_best_selected[afi][safi]
+					       == old_paths) {
 					bgp_addpath_set_peer_type(tmp_peer,
 								 afi,
 								 safi,
-								 addpath_type);
+								 addpath_type,
+								 paths);
 				}
 			}
 		}
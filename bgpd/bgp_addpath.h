@@ -59,11 +59,21 @@ bool bgp_addpath_dmed_required(int strategy);
  */
 bool bgp_addpath_tx_path(enum bgp_addpath_strat strat,
 			 struct bgp_path_info *pi);
+
+/*
+ * Return true if this is a path we should advertise to the peer due to its
+ * addpath-tx knob
+ */
+bool bgp_addpath_capable(struct bgp_path_info *pi, struct peer *peer,
+			 afi_t afi, safi_t safi);
+
 /*
- * Change the type of addpath used for a peer.
+ * Change the type of addpath used for a peer, paths is the number of paths
+ * for addpath-tx-best-selected.
  */
 void bgp_addpath_set_peer_type(struct peer *peer, afi_t afi, safi_t safi,
-			      enum bgp_addpath_strat addpath_type);
+			      enum bgp_addpath_strat addpath_type,
+			      uint8_t paths);
 
 void bgp_addpath_update_ids(struct bgp *bgp, struct bgp_dest *dest, afi_t afi,
 			    safi_t safi);
@@ -25,15 +25,22 @@
 enum bgp_addpath_strat {
 	BGP_ADDPATH_ALL = 0,
 	BGP_ADDPATH_BEST_PER_AS,
+	BGP_ADDPATH_BEST_SELECTED,
 	BGP_ADDPATH_MAX,
 	BGP_ADDPATH_NONE,
 };
 
+/* Most paths addpath-tx-best-selected can be configured to send */
+#define BGP_ADDPATH_BEST_SELECTED_MAX 6
+
 /* TX Addpath structures */
 struct bgp_addpath_bgp_data {
 	unsigned int peercount[AFI_MAX][SAFI_MAX][BGP_ADDPATH_MAX];
 	unsigned int total_peercount[AFI_MAX][SAFI_MAX];
 	struct id_alloc *id_allocators[AFI_MAX][SAFI_MAX][BGP_ADDPATH_MAX];
+
+	/* Most paths any peer sends with addpath-tx-best-selected */
+	uint8_t best_selected_max[AFI_MAX][SAFI_MAX];
 };
 
 struct bgp_addpath_node_data {
@@ -42,6 +49,12 @@ struct bgp_addpath_node_data {
 
 struct bgp_addpath_info_data {
 	uint32_t addpath_tx_id[BGP_ADDPATH_MAX];
+
+	/* Position of the path among the best ones, 1 for the bestpath, 0
+	 * past best_selected_max; only kept up to date while a peer is using
+	 * addpath-tx-best-selected.
+	 */
+	uint8_t best_selected_rank;
 };
 
 struct bgp_addpath_strategy_names {
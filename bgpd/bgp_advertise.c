@@ -144,39 +144,49 @@ void bgp_advertise_unintern(struct hash *hash, struct bgp_advertise_attr *baa)
 	}
 }
 
-bool bgp_adj_out_lookup(struct peer *peer, struct bgp_dest *dest,
-			uint32_t addpath_tx_id)
+static bool bgp_adj_out_lookup_safi(struct peer *peer, struct bgp_dest *dest,
+				    afi_t afi, safi_t safi,
+				    uint32_t addpath_tx_id)
 {
 	struct bgp_adj_out *adj;
-	struct peer_af *paf;
-	afi_t afi;
-	safi_t safi;
+	struct update_subgroup *subgrp;
 	int addpath_capable;
 
-	RB_FOREACH (adj, bgp_adj_out_rb, &dest->adj_out)
-		SUBGRP_FOREACH_PEER (adj->subgroup, paf)
-			if (paf->peer == peer) {
-				afi = SUBGRP_AFI(adj->subgroup);
-				safi = SUBGRP_SAFI(adj->subgroup);
-				addpath_capable =
-					bgp_addpath_encode_tx(peer, afi, safi);
-
-				/* Match on a specific addpath_tx_id if we are
-				 * using addpath for
-				 * this
-				 * peer and if an addpath_tx_id was specified */
-				if (addpath_capable && addpath_tx_id
-				    && adj->addpath_tx_id != addpath_tx_id)
-					continue;
-
-				return (adj->adv
-						? (adj->adv->baa ? true : false)
-						: (adj->attr ? true : false));
-			}
+	subgrp = peer_subgroup(peer, afi, safi);
+	if (!subgrp)
+		return false;
+
+	addpath_capable = bgp_addpath_encode_tx(peer, afi, safi);
+
+	SUBGRP_FOREACH_DEST_ADJ (subgrp, dest, adj) {
+		/* Match on a specific addpath_tx_id if we are using addpath
+		 * for this peer and if an addpath_tx_id was specified */
+		if (addpath_capable && addpath_tx_id
+		    && adj->addpath_tx_id != addpath_tx_id)
+			continue;
+
+		return (adj->adv ? (adj->adv->baa ? true : false)
+				 : (adj->attr ? true : false));
+	}
 
 	return false;
 }
 
+bool bgp_adj_out_lookup(struct peer *peer, struct bgp_dest *dest,
+			uint32_t addpath_tx_id)
+{
+	struct bgp_table *table = bgp_dest_table(dest);
+
+	/* Labeled unicast subgroups advertise out of the unicast table */
+	if (table->safi == SAFI_UNICAST
+	    && bgp_adj_out_lookup_safi(peer, dest, table->afi,
+				       SAFI_LABELED_UNICAST, addpath_tx_id))
+		return true;
+
+	return bgp_adj_out_lookup_safi(peer, dest, table->afi, table->safi,
+				       addpath_tx_id);
+}
+
 
 void bgp_adj_in_set(struct bgp_dest *dest, struct peer *peer, struct attr *attr,
 		    uint32_t addpath_id)
@@ -195,16 +205,21 @@ void bgp_adj_in_set(struct bgp_dest *dest, struct peer *peer, struct attr *attr,
 	adj = XCALLOC(MTYPE_BGP_ADJ_IN, sizeof(struct bgp_adj_in));
 	adj->peer = peer_lock(peer); /* adj_in peer reference */
 	adj->attr = bgp_attr_intern(attr);
-	adj->uptime = bgp_clock();
 	adj->addpath_rx_id = addpath_id;
-	BGP_ADJ_IN_ADD(dest, adj);
+	adj->next = dest->adj_in;
+	dest->adj_in = adj;
 	bgp_dest_lock_node(dest);
 }
 
 void bgp_adj_in_remove(struct bgp_dest *dest, struct bgp_adj_in *bai)
 {
+	struct bgp_adj_in **adjp;
+
+	for (adjp = &dest->adj_in; *adjp != bai; adjp = &(*adjp)->next)
+		;
+	*adjp = bai->next;
+
 	bgp_attr_unintern(&bai->attr);
-	BGP_ADJ_IN_DEL(dest, bai);
 	bgp_dest_unlock_node(dest);
 	peer_unlock(bai->peer); /* adj_in peer reference */
 	XFREE(MTYPE_BGP_ADJ_IN, bai);
@@ -64,8 +64,8 @@ DECLARE_DLIST(bgp_adv_fifo, struct bgp_advertise, fifo);
 
 /* BGP adjacency out.  */
 struct bgp_adj_out {
-	/* RB Tree of adjacency entries */
-	RB_ENTRY(bgp_adj_out) adj_entry;
+	/* Next entry of the same subgroup and prefix, i.e. other addpath ids */
+	struct bgp_adj_out *next;
 
 	/* Advertised subgroup.  */
 	struct update_subgroup *subgroup;
@@ -88,15 +88,16 @@ struct bgp_adj_out {
 	uint32_t attr_hash;
 };
 
-RB_HEAD(bgp_adj_out_rb, bgp_adj_out);
-RB_PROTOTYPE(bgp_adj_out_rb, bgp_adj_out, adj_entry,
-	     bgp_adj_out_compare);
-
-/* BGP adjacency in. */
+/* BGP adjacency in.
+ *
+ * There is one of these per peer and path with soft-reconfiguration inbound,
+ * so keep it small: the list is singly linked (it only holds a handful of
+ * entries per dest) and the attribute is the interned one, shared with the
+ * path itself whenever the inbound policy didn't modify it.
+ */
 struct bgp_adj_in {
 	/* Linked list pointer.  */
 	struct bgp_adj_in *next;
-	struct bgp_adj_in *prev;
 
 	/* Received peer.  */
 	struct peer *peer;
@@ -104,9 +105,6 @@ struct bgp_adj_in {
 	/* Received attribute.  */
 	struct attr *attr;
 
-	/* timestamp (monotime) */
-	time_t uptime;
-
 	/* Addpath identifier */
 	uint32_t addpath_rx_id;
 };
@@ -118,29 +116,6 @@ struct bgp_synchronize {
 	struct bgp_adv_fifo_head withdraw_low;
 };
 
-/* BGP adjacency linked list.  */
-#define BGP_PATH_INFO_ADD(N, A, TYPE)                                          \
-	do {                                                                   \
-		(A)->prev = NULL;                                              \
-		(A)->next = (N)->TYPE;                                         \
-		if ((N)->TYPE)                                                 \
-			(N)->TYPE->prev = (A);                                 \
-		(N)->TYPE = (A);                                               \
-	} while (0)
-
-#define BGP_PATH_INFO_DEL(N, A, TYPE)                                          \
-	do {                                                                   \
-		if ((A)->next)                                                 \
-			(A)->next->prev = (A)->prev;                           \
-		if ((A)->prev)                                                 \
-			(A)->prev->next = (A)->next;                           \
-		else                                                           \
-			(N)->TYPE = (A)->next;                                 \
-	} while (0)
-
-#define BGP_ADJ_IN_ADD(N, A) BGP_PATH_INFO_ADD(N, A, adj_in)
-#define BGP_ADJ_IN_DEL(N, A) BGP_PATH_INFO_DEL(N, A, adj_in)
-
 /* Prototypes.  */
 extern bool bgp_adj_out_lookup(struct peer *, struct bgp_dest *, uint32_t);
 extern void bgp_adj_in_set(struct bgp_dest *, struct peer *, struct attr *,
@@ -30,6 +30,7 @@
 #include "jhash.h"
 #include "queue.h"
 #include "filter.h"
+#include "frr_pthread.h"
 
 #include "bgpd/bgpd.h"
 #include "bgpd/bgp_aspath.h"
@@ -314,16 +315,26 @@ void aspath_free(struct aspath *aspath)
 		return;
 	if (aspath->segments)
 		assegment_free_all(aspath->segments);
-	XFREE(MTYPE_AS_STR, aspath->str);
-
-	if (aspath->json) {
-		json_object_free(aspath->json);
-		aspath->json = NULL;
+	frr_with_mutex(&bgp_text_mtx) {
+		bgp_text_forget(&aspath->text);
 	}
+	aspath_text_drop(aspath);
 
 	XFREE(MTYPE_AS_PATH, aspath);
 }
 
+/* Called by the text cache, see bgp_text_trim() */
+void aspath_text_drop(struct aspath *as)
+{
+	XFREE(MTYPE_AS_STR, as->str);
+	as->str_len = 0;
+
+	if (as->json) {
+		json_object_free(as->json);
+		as->json = NULL;
+	}
+}
+
 /* Unintern aspath from AS path bucket. */
 void aspath_unintern(struct aspath **aspath)
 {
@@ -534,6 +545,7 @@ static void aspath_make_str_count(struct aspath *as, bool make_json)
 		as->str = XMALLOC(MTYPE_AS_STR, 1);
 		as->str[0] = '\0';
 		as->str_len = 0;
+		bgp_text_touch(&as->text, BGP_TEXT_ASPATH, 0, make_json);
 		return;
 	}
 
@@ -647,20 +659,34 @@ static void aspath_make_str_count(struct aspath *as, bool make_json)
 		json_object_object_add(as->json, "segments", jaspath_segments);
 		json_object_int_add(as->json, "length", aspath_count_hops(as));
 	}
+	bgp_text_touch(&as->text, BGP_TEXT_ASPATH, len, make_json);
 
 	return;
 }
 
+/* Drops the string and json representations after the path changed.  The
+ * string is rebuilt on demand by aspath_print(), the json only if asked for.
+ */
 void aspath_str_update(struct aspath *as, bool make_json)
 {
-	XFREE(MTYPE_AS_STR, as->str);
+	frr_with_mutex(&bgp_text_mtx) {
+		bgp_text_forget(&as->text);
+		aspath_text_drop(as);
 
-	if (as->json) {
-		json_object_free(as->json);
-		as->json = NULL;
+		if (make_json)
+			aspath_make_str_count(as, make_json);
 	}
+}
 
-	aspath_make_str_count(as, make_json);
+/*
+ * Interned AS paths are never modified, so their hash key only needs to be
+ * computed once. This matters to attrhash_key_make(), which would otherwise
+ * hash the whole AS path string again for every attribute interned.
+ */
+static void aspath_key_cache(struct aspath *aspath)
+{
+	aspath->key = aspath_key_make(aspath);
+	aspath->key_cached = true;
 }
 
 /* Intern allocated AS path. */
@@ -668,15 +694,15 @@ struct aspath *aspath_intern(struct aspath *aspath)
 {
 	struct aspath *find;
 
-	/* Assert this AS path structure is not interned and has the string
-	   representation built. */
+	/* Assert this AS path structure is not interned. */
 	assert(aspath->refcnt == 0);
-	assert(aspath->str);
 
 	/* Check AS path hash. */
 	find = hash_get(ashash, aspath, hash_alloc_intern);
 	if (find != aspath)
 		aspath_free(aspath);
+	else
+		aspath_key_cache(find);
 
 	find->refcnt++;
 
@@ -687,7 +713,6 @@ struct aspath *aspath_intern(struct aspath *aspath)
    reference count and AS path string is cleared. */
 struct aspath *aspath_dup(struct aspath *aspath)
 {
-	unsigned short buflen = aspath->str_len + 1;
 	struct aspath *new;
 
 	new = XCALLOC(MTYPE_AS_PATH, sizeof(struct aspath));
@@ -696,18 +721,6 @@ struct aspath *aspath_dup(struct aspath *aspath)
 	if (aspath->segments)
 		new->segments = assegment_dup_all(aspath->segments);
 
-	if (!aspath->str)
-		return new;
-
-	new->str = XMALLOC(MTYPE_AS_STR, buflen);
-	new->str_len = aspath->str_len;
-
-	/* copy the string data */
-	if (aspath->str_len > 0)
-		memcpy(new->str, aspath->str, buflen);
-	else
-		new->str[0] = '\0';
-
 	return new;
 }
 
@@ -716,18 +729,11 @@ static void *aspath_hash_alloc(void *arg)
 	const struct aspath *aspath = arg;
 	struct aspath *new;
 
-	/* Malformed AS path value. */
-	assert(aspath->str);
-
 	/* New aspath structure is needed. */
-	new = XMALLOC(MTYPE_AS_PATH, sizeof(struct aspath));
+	new = XCALLOC(MTYPE_AS_PATH, sizeof(struct aspath));
 
-	/* Reuse segments and string representation */
-	new->refcnt = 0;
+	/* Reuse segments, the string representation is built on demand */
 	new->segments = aspath->segments;
-	new->str = aspath->str;
-	new->str_len = aspath->str_len;
-	new->json = aspath->json;
 
 	return new;
 }
@@ -862,13 +868,8 @@ struct aspath *aspath_parse(struct stream *s, size_t length, int use32bit)
 	/* if the aspath was already hashed free temporary memory. */
 	if (find->refcnt) {
 		assegment_free_all(as.segments);
-		/* aspath_key_make() always updates the string */
-		XFREE(MTYPE_AS_STR, as.str);
-		if (as.json) {
-			json_object_free(as.json);
-			as.json = NULL;
-		}
-	}
+	} else
+		aspath_key_cache(find);
 
 	find->refcnt++;
 
@@ -1694,7 +1695,7 @@ struct aspath *aspath_reconcile_as4(struct aspath *aspath,
 	if (BGP_DEBUG(as4, AS4))
 		zlog_debug(
 			"[AS4] got AS_PATH %s and AS4_PATH %s synthesizing now",
-			aspath->str, as4path->str);
+			aspath_print(aspath), aspath_print(as4path));
 
 	while (seg && hops > 0) {
 		switch (seg->type) {
@@ -1752,7 +1753,7 @@ struct aspath *aspath_reconcile_as4(struct aspath *aspath,
 
 	if (BGP_DEBUG(as4, AS4))
 		zlog_debug("[AS4] result of synthesizing is %s",
-			   mergedpath->str);
+			   aspath_print(mergedpath));
 
 	return mergedpath;
 }
@@ -1871,7 +1872,6 @@ struct aspath *aspath_empty_get(void)
 	struct aspath *aspath;
 
 	aspath = aspath_new();
-	aspath_make_str_count(aspath, false);
 	return aspath;
 }
 
@@ -2022,8 +2022,6 @@ struct aspath *aspath_str2aspath(const char *str)
 		}
 	}
 
-	aspath_make_str_count(aspath, false);
-
 	return aspath;
 }
 
@@ -2031,12 +2029,17 @@ struct aspath *aspath_str2aspath(const char *str)
 unsigned int aspath_key_make(const void *p)
 {
 	const struct aspath *aspath = p;
-	unsigned int key = 0;
+	const struct assegment *seg;
+	unsigned int key = 2334325;
 
-	if (!aspath->str)
-		aspath_str_update((struct aspath *)aspath, false);
+	if (aspath->key_cached)
+		return aspath->key;
 
-	key = jhash(aspath->str, aspath->str_len, 2334325);
+	/* same input as aspath_cmp(), the string need not exist */
+	for (seg = aspath->segments; seg; seg = seg->next) {
+		key = jhash_2words(seg->type, seg->length, key);
+		key = jhash(seg->as, seg->length * sizeof(as_t), key);
+	}
 
 	return key;
 }
@@ -2048,16 +2051,14 @@ bool aspath_cmp(const void *arg1, const void *arg2)
 	const struct assegment *seg2 = ((const struct aspath *)arg2)->segments;
 
 	while (seg1 || seg2) {
-		int i;
 		if ((!seg1 && seg2) || (seg1 && !seg2))
 			return false;
 		if (seg1->type != seg2->type)
 			return false;
 		if (seg1->length != seg2->length)
 			return false;
-		for (i = 0; i < seg1->length; i++)
-			if (seg1->as[i] != seg2->as[i])
-				return false;
+		if (memcmp(seg1->as, seg2->as, seg1->length * sizeof(as_t)))
+			return false;
 		seg1 = seg1->next;
 		seg2 = seg2->next;
 	}
@@ -2084,7 +2085,17 @@ void aspath_finish(void)
 /* return and as path value */
 const char *aspath_print(struct aspath *as)
 {
-	return (as ? as->str : NULL);
+	if (!as)
+		return NULL;
+
+	frr_with_mutex(&bgp_text_mtx) {
+		if (!as->str)
+			aspath_make_str_count(as, false);
+		else
+			bgp_text_touch(&as->text, BGP_TEXT_ASPATH, as->str_len,
+				       !!as->json);
+	}
+	return as->str;
 }
 
 /* Printing functions */
@@ -2095,7 +2106,7 @@ void aspath_print_vty(struct vty *vty, const char *format, struct aspath *as,
 		      const char *suffix)
 {
 	assert(format);
-	vty_out(vty, format, as->str);
+	vty_out(vty, format, aspath_print(as));
 	if (as->str_len && strlen(suffix))
 		vty_out(vty, "%s", suffix);
 }
@@ -2108,7 +2119,7 @@ static void aspath_show_all_iterator(struct hash_bucket *bucket,
 	as = (struct aspath *)bucket->data;
 
 	vty_out(vty, "[%p:%u] (%ld) ", (void *)bucket, bucket->key, as->refcnt);
-	vty_out(vty, "%s\n", as->str);
+	vty_out(vty, "%s\n", aspath_print(as));
 }
 
 /* Print all aspath and hash information.  This function is used from
@@ -2139,10 +2150,12 @@ static void bgp_aggr_aspath_prepare(struct hash_bucket *hb, void *arg)
 {
 	struct aspath *hb_aspath = hb->data;
 	struct aspath **aggr_aspath = arg;
+	struct aspath *old = *aggr_aspath;
 
-	if (*aggr_aspath)
-		*aggr_aspath = aspath_aggregate(*aggr_aspath, hb_aspath);
-	else
+	if (old) {
+		*aggr_aspath = aspath_aggregate(old, hb_aspath);
+		aspath_free(old);
+	} else
 		*aggr_aspath = aspath_dup(hb_aspath);
 }
 
@@ -2156,10 +2169,27 @@ void bgp_aggr_aspath_remove(void *arg)
 void bgp_compute_aggregate_aspath(struct bgp_aggregate *aggregate,
 				  struct aspath *aspath)
 {
+	struct aspath *aggr_aspath;
+	struct aspath *old;
+
+	if ((aggregate == NULL) || (aspath == NULL))
+		return;
+
 	bgp_compute_aggregate_aspath_hash(aggregate, aspath);
 
-	bgp_compute_aggregate_aspath_val(aggregate);
+	/* Only an as-path none of the routes had yet changes the aggregate's
+	 * as-path, and aggregating is done one as-path at a time anyway.
+	 */
+	aggr_aspath = bgp_aggr_aspath_lookup(aggregate, aspath);
+	if (aggr_aspath->refcnt > 1)
+		return;
 
+	old = aggregate->aspath;
+	if (old) {
+		aggregate->aspath = aspath_aggregate(old, aggr_aspath);
+		aspath_free(old);
+	} else
+		aggregate->aspath = aspath_dup(aggr_aspath);
 }
 
 void bgp_compute_aggregate_aspath_hash(struct bgp_aggregate *aggregate,
@@ -23,6 +23,7 @@
 
 #include "lib/json.h"
 #include "bgpd/bgp_route.h"
+#include "bgpd/bgp_textcache.h"
 
 /* AS path segment type.  */
 #define AS_SET                       1
@@ -58,6 +59,8 @@ struct assegment {
 };
 
 /* AS path may be include some AsSegments.  */
+#define ASPATH_FILTER_CACHE 4
+
 struct aspath {
 	/* Reference count to this aspath.  */
 	unsigned long refcnt;
@@ -69,9 +72,22 @@ struct aspath {
 	json_object *json;
 
 	/* String expression of AS path.  This string is used by vty output
-	   and AS path regular expression match.  */
+	   and AS path regular expression match.  Built on demand by
+	   aspath_print(), accessing it directly is not a good idea.  It may
+	   be dropped again by the text cache.  */
 	char *str;
 	unsigned short str_len;
+	struct bgp_text text;
+
+	/* Hash key, computed once when interned, see aspath_key_cache() */
+	bool key_cached;
+	unsigned int key;
+
+	/* Recent as-path access-list results for interned paths, indexed by
+	 * list id modulo ASPATH_FILTER_CACHE, see as_list_apply()
+	 */
+	uint32_t filter_id[ASPATH_FILTER_CACHE];
+	uint8_t filter_result[ASPATH_FILTER_CACHE];
 };
 
 #define ASPATH_STR_DEFAULT_LEN 32
@@ -96,6 +112,7 @@ extern struct aspath *aspath_empty(void);
 extern struct aspath *aspath_empty_get(void);
 extern struct aspath *aspath_str2aspath(const char *);
 extern void aspath_str_update(struct aspath *as, bool make_json);
+extern void aspath_text_drop(struct aspath *as);
 extern void aspath_free(struct aspath *);
 extern struct aspath *aspath_intern(struct aspath *);
 extern void aspath_unintern(struct aspath **);
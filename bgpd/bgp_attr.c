@@ -118,7 +118,7 @@ static void *cluster_hash_alloc(void *p)
 }
 
 /* Cluster list related functions. */
-static struct cluster_list *cluster_parse(struct in_addr *pnt, int length)
+struct cluster_list *cluster_parse(struct in_addr *pnt, int length)
 {
 	struct cluster_list tmp = {};
 	struct cluster_list *cluster;
@@ -756,8 +756,8 @@ bool attrhash_cmp(const void *p1, const void *p2)
 
 static void attrhash_init(void)
 {
-	attrhash =
-		hash_create(attrhash_key_make, attrhash_cmp, "BGP Attributes");
+	attrhash = hash_create_open(HASH_INITIAL_SIZE, attrhash_key_make,
+				    attrhash_cmp, "BGP Attributes");
 }
 
 /*
@@ -932,6 +932,36 @@ struct attr *bgp_attr_intern(struct attr *attr)
 	return find;
 }
 
+/* Whether bgp_attr_intern() would only take references on the parts of attr,
+ * rather than intern (and possibly free) some of them.
+ */
+bool bgp_attr_parts_interned(const struct attr *attr)
+{
+	struct ecommunity *ecomm = bgp_attr_get_ipv6_ecommunity(attr);
+	struct cluster_list *cluster = bgp_attr_get_cluster(attr);
+	struct transit *transit = bgp_attr_get_transit(attr);
+
+	if ((attr->aspath && !attr->aspath->refcnt)
+	    || (attr->community && !attr->community->refcnt)
+	    || (attr->ecommunity && !attr->ecommunity->refcnt)
+	    || (ecomm && !ecomm->refcnt)
+	    || (attr->lcommunity && !attr->lcommunity->refcnt)
+	    || (cluster && !cluster->refcnt) || (transit && !transit->refcnt)
+	    || (attr->encap_subtlvs && !attr->encap_subtlvs->refcnt)
+	    || (attr->srv6_l3vpn && !attr->srv6_l3vpn->refcnt)
+	    || (attr->srv6_vpn && !attr->srv6_vpn->refcnt))
+		return false;
+
+#ifdef ENABLE_BGP_VNC
+	struct bgp_attr_encap_subtlv *vnc_subtlvs =
+		bgp_attr_get_vnc_subtlvs(attr);
+
+	if (vnc_subtlvs && !vnc_subtlvs->refcnt)
+		return false;
+#endif
+	return true;
+}
+
 /* Make network statement's attribute. */
 struct attr *bgp_attr_default_set(struct attr *attr, uint8_t origin)
 {
@@ -1062,6 +1092,46 @@ struct attr *bgp_attr_aggregate_intern(
 }
 
 /* Unintern just the sub-components of the attr, but not the attr */
+/* Take another reference on the interned parts of an attribute, which
+ * bgp_attr_unintern_sub() then drops.
+ */
+void bgp_attr_ref_sub(struct attr *attr)
+{
+	struct ecommunity *ecomm = bgp_attr_get_ipv6_ecommunity(attr);
+	struct cluster_list *cluster = bgp_attr_get_cluster(attr);
+	struct transit *transit = bgp_attr_get_transit(attr);
+
+	if (attr->aspath)
+		attr->aspath->refcnt++;
+	if (attr->community)
+		attr->community->refcnt++;
+	if (attr->ecommunity)
+		attr->ecommunity->refcnt++;
+	if (ecomm)
+		ecomm->refcnt++;
+	if (attr->lcommunity)
+		attr->lcommunity->refcnt++;
+	if (cluster)
+		cluster->refcnt++;
+	if (transit)
+		transit->refcnt++;
+	if (attr->encap_subtlvs)
+		attr->encap_subtlvs->refcnt++;
+
+#ifdef ENABLE_BGP_VNC
+	struct bgp_attr_encap_subtlv *vnc_subtlvs =
+		bgp_attr_get_vnc_subtlvs(attr);
+
+	if (vnc_subtlvs)
+		vnc_subtlvs->refcnt++;
+#endif
+
+	if (attr->srv6_l3vpn)
+		attr->srv6_l3vpn->refcnt++;
+	if (attr->srv6_vpn)
+		attr->srv6_vpn->refcnt++;
+}
+
 void bgp_attr_unintern_sub(struct attr *attr)
 {
 	struct ecommunity *ecomm;
@@ -138,7 +138,15 @@ struct bgp_attr_srv6_l3vpn {
 	struct in6_addr sid;
 };
 
-/* BGP core attribute structure. */
+/*
+ * BGP core attribute structure.
+ *
+ * One is interned for every distinct set of path attributes, and the
+ * fields used by attrhash_key_make(), best path selection and update
+ * generation come first so that they share the first cache lines.  Plain
+ * IPv4/IPv6 unicast routes don't use anything past srte_color.  Small
+ * fields are grouped to avoid padding, please keep it that way.
+ */
 struct attr {
 	/* AS Path structure */
 	struct aspath *aspath;
@@ -146,28 +154,44 @@ struct attr {
 	/* Community structure */
 	struct community *community;
 
-	/* Reference count of this attribute. */
-	unsigned long refcnt;
+	/* Extended Communities attribute. */
+	struct ecommunity *ecommunity;
+
+	/* Large Communities attribute. */
+	struct lcommunity *lcommunity;
 
 	/* Flag of attribute is set or not. */
 	uint64_t flag;
 
+	/* Reference count of this attribute. */
+	unsigned long refcnt;
+
 	/* Apart from in6_addr, the remaining static attributes */
 	struct in_addr nexthop;
 	uint32_t med;
 	uint32_t local_pref;
-	ifindex_t nh_ifindex;
-
-	/* Path origin attribute */
-	uint8_t origin;
 
-	/* PMSI tunnel type (RFC 6514). */
-	enum pta_type pmsi_tnl_type;
+	/* Local weight, not actually an attribute */
+	uint32_t weight;
 
 	/* has the route-map changed any attribute?
 	   Used on the peer outbound side. */
 	uint32_t rmap_change_flags;
 
+	/* Path origin attribute */
+	uint8_t origin;
+
+	/* MP Nexthop length */
+	uint8_t mp_nexthop_len;
+
+	/* MP Nexthop preference */
+	uint8_t mp_nexthop_prefer_global;
+
+	/* Distance as applied by Route map */
+	uint8_t distance;
+
+	ifindex_t nh_ifindex;
+
 	/* Multi-Protocol Nexthop, AFI IPv6 */
 	struct in6_addr mp_nexthop_global;
 	struct in6_addr mp_nexthop_local;
@@ -175,14 +199,25 @@ struct attr {
 	/* ifIndex corresponding to mp_nexthop_local. */
 	ifindex_t nh_lla_ifindex;
 
-	/* Extended Communities attribute. */
-	struct ecommunity *ecommunity;
+	struct in_addr mp_nexthop_global_in;
 
-	/* Extended Communities attribute. */
-	struct ecommunity *ipv6_ecommunity;
+	/* route tag */
+	route_tag_t tag;
 
-	/* Large Communities attribute. */
-	struct lcommunity *lcommunity;
+	/* MPLS label */
+	mpls_label_t label;
+
+	/* Label index */
+	uint32_t label_index;
+
+	/* Aggregator ASN */
+	as_t aggregator_as;
+
+	/* Aggregator Router ID attribute */
+	struct in_addr aggregator_addr;
+
+	/* Route Reflector Originator attribute */
+	struct in_addr originator_id;
 
 	/* Route-Reflector Cluster attribute */
 	struct cluster_list *cluster1;
@@ -190,29 +225,62 @@ struct attr {
 	/* Unknown transitive attribute. */
 	struct transit *transit;
 
-	struct in_addr mp_nexthop_global_in;
+	/* Extended Communities attribute. */
+	struct ecommunity *ipv6_ecommunity;
 
-	/* Aggregator Router ID attribute */
-	struct in_addr aggregator_addr;
+	/* rmap set table */
+	uint32_t rmap_table_id;
 
-	/* Route Reflector Originator attribute */
-	struct in_addr originator_id;
+	/* Link bandwidth value, if any. */
+	uint32_t link_bw;
 
-	/* Local weight, not actually an attribute */
-	uint32_t weight;
+	/* SR-TE Color */
+	uint32_t srte_color;
 
-	/* Aggregator ASN */
-	as_t aggregator_as;
+	/* Rarely used from here on. */
 
-	/* MP Nexthop length */
-	uint8_t mp_nexthop_len;
+	uint16_t encap_tunneltype;		     /* grr */
 
-	/* MP Nexthop preference */
-	uint8_t mp_nexthop_prefer_global;
+	/* PMSI tunnel type (RFC 6514), enum pta_type. */
+	uint8_t pmsi_tnl_type;
 
 	/* Static MAC for EVPN */
 	uint8_t sticky;
 
+	/* SRv6 VPN SID */
+	struct bgp_attr_srv6_vpn *srv6_vpn;
+
+	/* SRv6 L3VPN SID */
+	struct bgp_attr_srv6_l3vpn *srv6_l3vpn;
+
+	struct bgp_attr_encap_subtlv *encap_subtlvs; /* rfc5512 */
+
+#ifdef ENABLE_BGP_VNC
+	struct bgp_attr_encap_subtlv *vnc_subtlvs; /* VNC-specific */
+#endif
+	/* EVPN */
+	struct bgp_route_evpn evpn_overlay;
+
+	/* EVPN MAC Mobility sequence number, if any. */
+	uint32_t mm_seqnum;
+	/* highest MM sequence number rxed in a MAC-IP route from an
+	 * ES peer (this includes both proxy and non-proxy MAC-IP
+	 * advertisements from ES peers).
+	 * This is only applicable to local paths in the VNI routing
+	 * table and derived from other imported/non-best paths.
+	 */
+	uint32_t mm_sync_seqnum;
+
+	/* EVPN ES */
+	esi_t esi;
+
+	/* EVPN local router-mac */
+	struct ethaddr rmac;
+
+	/* EVPN DF preference and algorithm for DF election on local ESs */
+	uint16_t df_pref;
+	uint8_t df_alg;
+
 	/* Flag for default gateway extended community in EVPN */
 	uint8_t default_gw;
 
@@ -251,62 +319,6 @@ struct attr {
 #define ATTR_ES_L3_NHG_USE (1 << 5)
 #define ATTR_ES_L3_NHG_ACTIVE (1 << 6)
 #define ATTR_ES_L3_NHG (ATTR_ES_L3_NHG_USE | ATTR_ES_L3_NHG_ACTIVE)
-
-	/* route tag */
-	route_tag_t tag;
-
-	/* Label index */
-	uint32_t label_index;
-
-	/* MPLS label */
-	mpls_label_t label;
-
-	/* SRv6 VPN SID */
-	struct bgp_attr_srv6_vpn *srv6_vpn;
-
-	/* SRv6 L3VPN SID */
-	struct bgp_attr_srv6_l3vpn *srv6_l3vpn;
-
-	uint16_t encap_tunneltype;		     /* grr */
-	struct bgp_attr_encap_subtlv *encap_subtlvs; /* rfc5512 */
-
-#ifdef ENABLE_BGP_VNC
-	struct bgp_attr_encap_subtlv *vnc_subtlvs; /* VNC-specific */
-#endif
-	/* EVPN */
-	struct bgp_route_evpn evpn_overlay;
-
-	/* EVPN MAC Mobility sequence number, if any. */
-	uint32_t mm_seqnum;
-	/* highest MM sequence number rxed in a MAC-IP route from an
-	 * ES peer (this includes both proxy and non-proxy MAC-IP
-	 * advertisements from ES peers).
-	 * This is only applicable to local paths in the VNI routing
-	 * table and derived from other imported/non-best paths.
-	 */
-	uint32_t mm_sync_seqnum;
-
-	/* EVPN local router-mac */
-	struct ethaddr rmac;
-
-	/* Distance as applied by Route map */
-	uint8_t distance;
-
-	/* rmap set table */
-	uint32_t rmap_table_id;
-
-	/* Link bandwidth value, if any. */
-	uint32_t link_bw;
-
-	/* EVPN ES */
-	esi_t esi;
-
-	/* SR-TE Color */
-	uint32_t srte_color;
-
-	/* EVPN DF preference and algorithm for DF election on local ESs */
-	uint16_t df_pref;
-	uint8_t df_alg;
 };
 
 /* rmap_change_flags definition */
@@ -364,6 +376,8 @@ extern bgp_attr_parse_ret_t bgp_attr_parse(struct peer *, struct attr *,
 					   struct bgp_nlri *);
 extern void bgp_attr_undup(struct attr *new, struct attr *old);
 extern struct attr *bgp_attr_intern(struct attr *attr);
+extern bool bgp_attr_parts_interned(const struct attr *attr);
+extern void bgp_attr_ref_sub(struct attr *attr);
 extern void bgp_attr_unintern_sub(struct attr *);
 extern void bgp_attr_unintern(struct attr **);
 extern void bgp_attr_flush(struct attr *);
@@ -388,6 +402,7 @@ extern unsigned long int attr_count(void);
 extern unsigned long int attr_unknown_count(void);
 
 /* Cluster list prototypes. */
+extern struct cluster_list *cluster_parse(struct in_addr *pnt, int length);
 extern bool cluster_loop_check(struct cluster_list *, struct in_addr);
 
 /* Below exported for unit-test purposes only */
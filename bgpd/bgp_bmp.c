@@ -43,6 +43,7 @@
 #include "bgpd/bgp_route.h"
 #include "bgpd/bgp_attr.h"
 #include "bgpd/bgp_dump.h"
+#include "bgpd/bgp_aspath.h"
 #include "bgpd/bgp_errors.h"
 #include "bgpd/bgp_packet.h"
 #include "bgpd/bgp_bmp.h"
@@ -250,6 +251,7 @@ static void bmp_per_peer_hdr(struct stream *s, struct peer *peer,
 #define BMP_PEER_TYPE_GLOBAL_INSTANCE 0
 #define BMP_PEER_TYPE_RD_INSTANCE     1
 #define BMP_PEER_TYPE_LOCAL_INSTANCE  2
+#define BMP_PEER_TYPE_LOC_RIB_INSTANCE 3
 
 #define BMP_PEER_FLAG_V (1 << 7)
 #define BMP_PEER_FLAG_L (1 << 6)
@@ -300,6 +302,32 @@ static void bmp_per_peer_hdr(struct stream *s, struct peer *peer,
 	}
 }
 
+/* RFC 9069 4.1: the Loc-RIB is reported as a peer of its own */
+static void bmp_locrib_hdr(struct stream *s, struct bgp *bgp,
+			   const struct timeval *tv)
+{
+	/* Peer Type, Peer Flags */
+	stream_putc(s, BMP_PEER_TYPE_LOC_RIB_INSTANCE);
+	stream_putc(s, 0);
+
+	/* Peer Distinguisher, Peer Address */
+	stream_put(s, NULL, 8);
+	stream_put(s, NULL, 16);
+
+	/* Peer AS, Peer BGP ID */
+	stream_putl(s, bgp->as);
+	stream_put_in_addr(s, &bgp->router_id);
+
+	/* Timestamp */
+	if (tv) {
+		stream_putl(s, tv->tv_sec);
+		stream_putl(s, tv->tv_usec);
+	} else {
+		stream_putl(s, 0);
+		stream_putl(s, 0);
+	}
+}
+
 static void bmp_put_info_tlv(struct stream *s, uint16_t type,
 		const char *string)
 {
@@ -460,6 +488,55 @@ static struct stream *bmp_peerstate(struct peer *peer, bool down)
 }
 
 
+static bool bmp_locrib_monitored(struct bmp_targets *bt)
+{
+	afi_t afi;
+	safi_t safi;
+
+	FOREACH_AFI_SAFI (afi, safi)
+		if (bt->afimon[afi][safi] & BMP_MON_LOC_RIB)
+			return true;
+	return false;
+}
+
+/* RFC 9069 5.3: Loc-RIB peer up, with a made up OPEN standing in for both
+ * the sent and the received one
+ */
+static void bmp_send_locrib_peerup(struct bmp *bmp)
+{
+	struct bgp *bgp = bmp->targets->bgp;
+	struct stream *s, *open;
+
+	open = stream_new(BGP_MAX_PACKET_SIZE);
+	bgp_packet_set_marker(open, BGP_MSG_OPEN);
+	stream_putc(open, BGP_VERSION_4);
+	stream_putw(open, bgp->as <= BGP_AS_MAX ? bgp->as : BGP_AS_TRANS);
+	stream_putw(open, bgp->default_holdtime);
+	stream_put_in_addr(open, &bgp->router_id);
+	stream_putc(open, 0);
+	bgp_packet_set_size(open);
+
+	s = stream_new(BGP_MAX_PACKET_SIZE);
+	bmp_common_hdr(s, BMP_VERSION_3, BMP_TYPE_PEER_UP_NOTIFICATION);
+	bmp_locrib_hdr(s, bgp, NULL);
+
+	/* Local Address, Local Port, Remote Port */
+	stream_put(s, NULL, 16);
+	stream_putw(s, 0);
+	stream_putw(s, 0);
+
+	stream_put(s, STREAM_DATA(open), stream_get_endp(open));
+	stream_put(s, STREAM_DATA(open), stream_get_endp(open));
+
+	/* VRF/Table Name TLV */
+	bmp_put_info_tlv(s, 3, bgp->name ? bgp->name : VRF_DEFAULT_NAME);
+
+	stream_putl_at(s, BMP_LENGTH_POS, stream_get_endp(s));
+	pullwr_write_stream(bmp->pullwr, s);
+	stream_free(s);
+	stream_free(open);
+}
+
 static int bmp_send_peerup(struct bmp *bmp)
 {
 	struct peer *peer;
@@ -473,6 +550,9 @@ static int bmp_send_peerup(struct bmp *bmp)
 		stream_free(s);
 	}
 
+	if (bmp_locrib_monitored(bmp->targets))
+		bmp_send_locrib_peerup(bmp);
+
 	return 0;
 }
 
@@ -746,16 +826,12 @@ static int bmp_peer_backward(struct peer *peer)
 	return 0;
 }
 
-static void bmp_eor(struct bmp *bmp, afi_t afi, safi_t safi, uint8_t flags)
+static struct stream *bmp_eor_msg(afi_t afi, safi_t safi)
 {
-	struct peer *peer;
-	struct listnode *node;
-	struct stream *s, *s2;
+	struct stream *s;
 	iana_afi_t pkt_afi;
 	iana_safi_t pkt_safi;
 
-	frrtrace(3, frr_bgp, bmp_eor, afi, safi, flags);
-
 	s = stream_new(BGP_MAX_PACKET_SIZE);
 
 	/* Make BGP update packet. */
@@ -781,6 +857,18 @@ static void bmp_eor(struct bmp *bmp, afi_t afi, safi_t safi, uint8_t flags)
 	}
 
 	bgp_packet_set_size(s);
+	return s;
+}
+
+static void bmp_eor(struct bmp *bmp, afi_t afi, safi_t safi, uint8_t flags)
+{
+	struct peer *peer;
+	struct listnode *node;
+	struct stream *s, *s2;
+
+	frrtrace(3, frr_bgp, bmp_eor, afi, safi, flags);
+
+	s = bmp_eor_msg(afi, safi);
 
 	for (ALL_LIST_ELEMENTS_RO(bmp->targets->bgp->peer, node, peer)) {
 		if (!peer->afc_nego[afi][safi])
@@ -803,6 +891,25 @@ static void bmp_eor(struct bmp *bmp, afi_t afi, safi_t safi, uint8_t flags)
 	stream_free(s);
 }
 
+static void bmp_eor_locrib(struct bmp *bmp, afi_t afi, safi_t safi)
+{
+	struct stream *s, *hdr;
+
+	s = bmp_eor_msg(afi, safi);
+
+	hdr = stream_new(BGP_MAX_PACKET_SIZE);
+	bmp_common_hdr(hdr, BMP_VERSION_3, BMP_TYPE_ROUTE_MONITORING);
+	bmp_locrib_hdr(hdr, bmp->targets->bgp, NULL);
+	stream_putl_at(hdr, BMP_LENGTH_POS,
+		       stream_get_endp(hdr) + stream_get_endp(s));
+
+	bmp->cnt_update++;
+	pullwr_write_stream(bmp->pullwr, hdr);
+	pullwr_write_stream(bmp->pullwr, s);
+	stream_free(hdr);
+	stream_free(s);
+}
+
 static struct stream *bmp_update(const struct prefix *p, struct prefix_rd *prd,
 				 struct peer *peer, struct attr *attr,
 				 afi_t afi, safi_t safi)
@@ -922,6 +1029,47 @@ static void bmp_monitor(struct bmp *bmp, struct peer *peer, uint8_t flags,
 	stream_free(msg);
 }
 
+/* Loc-RIB routes are encoded as if sent to ourselves */
+static void bmp_monitor_locrib(struct bmp *bmp, const struct prefix *p,
+			       struct prefix_rd *prd, struct attr *attr,
+			       afi_t afi, safi_t safi, time_t uptime)
+{
+	struct bgp *bgp = bmp->targets->bgp;
+	struct stream *hdr, *msg;
+	struct timeval tv = { .tv_sec = uptime, .tv_usec = 0 };
+	struct timeval uptime_real;
+
+	monotime_to_realtime(&tv, &uptime_real);
+	if (attr)
+		msg = bmp_update(p, prd, bgp->peer_self, attr, afi, safi);
+	else
+		msg = bmp_withdraw(p, prd, afi, safi);
+
+	hdr = stream_new(BGP_MAX_PACKET_SIZE);
+	bmp_common_hdr(hdr, BMP_VERSION_3, BMP_TYPE_ROUTE_MONITORING);
+	bmp_locrib_hdr(hdr, bgp, &uptime_real);
+
+	stream_putl_at(hdr, BMP_LENGTH_POS,
+		       stream_get_endp(hdr) + stream_get_endp(msg));
+
+	bmp->cnt_update++;
+	pullwr_write_stream(bmp->pullwr, hdr);
+	pullwr_write_stream(bmp->pullwr, msg);
+	stream_free(hdr);
+	stream_free(msg);
+}
+
+static struct bgp_path_info *bmp_selected(struct bgp_dest *bn)
+{
+	struct bgp_path_info *bpi;
+
+	for (bpi = bn ? bgp_dest_get_bgp_path_info(bn) : NULL; bpi;
+	     bpi = bpi->next)
+		if (CHECK_FLAG(bpi->flags, BGP_PATH_SELECTED))
+			return bpi;
+	return NULL;
+}
+
 static bool bmp_wrsync(struct bmp *bmp, struct pullwr *pullwr)
 {
 	afi_t afi;
@@ -937,6 +1085,7 @@ static bool bmp_wrsync(struct bmp *bmp, struct pullwr *pullwr)
 			bmp->syncafi = afi;
 			bmp->syncsafi = safi;
 			bmp->syncpeerid = 0;
+			bmp->synclocrib = false;
 			memset(&bmp->syncpos, 0, sizeof(bmp->syncpos));
 			bmp->syncpos.family = afi2family(afi);
 			bmp->syncrdpos = NULL;
@@ -965,7 +1114,7 @@ afibreak:
 
 	struct bgp_table *table = bmp->targets->bgp->rib[afi][safi];
 	struct bgp_dest *bn;
-	struct bgp_path_info *bpi = NULL, *bpiter;
+	struct bgp_path_info *bpi = NULL, *bpiter, *locrib = NULL;
 	struct bgp_adj_in *adjin = NULL, *adjiter;
 
 	if (afi == AFI_L2VPN && safi == SAFI_EVPN) {
@@ -1021,6 +1170,9 @@ afibreak:
 						safi2str(safi));
 				bmp_eor(bmp, afi, safi, BMP_PEER_FLAG_L);
 				bmp_eor(bmp, afi, safi, 0);
+				if (bmp->targets->afimon[afi][safi]
+				    & BMP_MON_LOC_RIB)
+					bmp_eor_locrib(bmp, afi, safi);
 
 				bmp->afistate[afi][safi] = BMP_AFI_LIVE;
 				bmp->syncafi = AFI_MAX;
@@ -1028,9 +1180,19 @@ afibreak:
 				return true;
 			}
 			bmp->syncpeerid = 0;
+			bmp->synclocrib = false;
 			prefix_copy(&bmp->syncpos, bgp_dest_get_prefix(bn));
 		}
 
+		/* the Loc-RIB entry goes first, then the peers' */
+		if ((bmp->targets->afimon[afi][safi] & BMP_MON_LOC_RIB)
+		    && !bmp->synclocrib) {
+			bmp->synclocrib = true;
+			locrib = bmp_selected(bn);
+			if (locrib)
+				break;
+		}
+
 		if (bmp->targets->afimon[afi][safi] & BMP_MON_POSTPOLICY) {
 			for (bpiter = bgp_dest_get_bgp_path_info(bn); bpiter;
 			     bpiter = bpiter->next) {
@@ -1082,6 +1244,12 @@ afibreak:
 	if (afi == AFI_L2VPN && safi == SAFI_EVPN)
 		prd = (struct prefix_rd *)bgp_dest_get_prefix(bmp->syncrdpos);
 
+	if (locrib) {
+		bmp_monitor_locrib(bmp, bn_p, prd, locrib->attr, afi, safi,
+				   locrib->uptime);
+		return true;
+	}
+
 	if (bpi)
 		bmp_monitor(bmp, bpi->peer, BMP_PEER_FLAG_L, bn_p, prd,
 			    bpi->attr, afi, safi, bpi->uptime);
@@ -1141,6 +1309,25 @@ static bool bmp_wrqueue(struct bmp *bmp, struct pullwr *pullwr)
 		break;
 	}
 
+	if (bqe->locrib) {
+		struct prefix_rd *prd = NULL;
+		struct bgp_path_info *bpi;
+
+		if (afi == AFI_L2VPN && safi == SAFI_EVPN)
+			prd = &bqe->rd;
+
+		bn = bgp_afi_node_lookup(bmp->targets->bgp->rib[afi][safi],
+					 afi, safi, &bqe->p, prd);
+		bpi = bmp_selected(bn);
+
+		bmp_monitor_locrib(bmp, &bqe->p, prd, bpi ? bpi->attr : NULL,
+				   afi, safi, bpi ? bpi->uptime : monotime(NULL));
+		if (bn)
+			bgp_dest_unlock_node(bn);
+		written = true;
+		goto out;
+	}
+
 	peer = QOBJ_GET_TYPESAFE(bqe->peerid, peer);
 	if (!peer) {
 		zlog_info("bmp: skipping queued item for deleted peer");
@@ -1223,7 +1410,8 @@ static void bmp_wrerr(struct bmp *bmp, struct pullwr *pullwr, bool eof)
 }
 
 static void bmp_process_one(struct bmp_targets *bt, struct bgp *bgp, afi_t afi,
-			    safi_t safi, struct bgp_dest *bn, struct peer *peer)
+			    safi_t safi, struct bgp_dest *bn, uint64_t peerid,
+			    bool locrib)
 {
 	struct bmp *bmp;
 	struct bmp_queue_entry *bqe, bqeref;
@@ -1235,9 +1423,10 @@ static void bmp_process_one(struct bmp_targets *bt, struct bgp *bgp, afi_t afi,
 
 	memset(&bqeref, 0, sizeof(bqeref));
 	prefix_copy(&bqeref.p, bgp_dest_get_prefix(bn));
-	bqeref.peerid = peer->qobj_node.nid;
+	bqeref.peerid = peerid;
 	bqeref.afi = afi;
 	bqeref.safi = safi;
+	bqeref.locrib = locrib;
 
 	if (afi == AFI_L2VPN && safi == SAFI_EVPN && bn->pdest)
 		prefix_copy(&bqeref.rd,
@@ -1284,10 +1473,37 @@ static int bmp_process(struct bgp *bgp, afi_t afi, safi_t safi,
 		return 0;
 
 	frr_each(bmp_targets, &bmpbgp->targets, bt) {
-		if (!bt->afimon[afi][safi])
+		if (!(bt->afimon[afi][safi]
+		      & (BMP_MON_PREPOLICY | BMP_MON_POSTPOLICY)))
+			continue;
+
+		bmp_process_one(bt, bgp, afi, safi, bn, peer->qobj_node.nid,
+				false);
+
+		frr_each(bmp_session, &bt->sessions, bmp) {
+			pullwr_bump(bmp->pullwr);
+		}
+	}
+	return 0;
+}
+
+static int bmp_route_update(struct bgp *bgp, afi_t afi, safi_t safi,
+			    struct bgp_dest *bn,
+			    struct bgp_path_info *old_route,
+			    struct bgp_path_info *new_route)
+{
+	struct bmp_bgp *bmpbgp = bmp_bgp_find(bgp);
+	struct bmp_targets *bt;
+	struct bmp *bmp;
+
+	if (!bmpbgp)
+		return 0;
+
+	frr_each(bmp_targets, &bmpbgp->targets, bt) {
+		if (!(bt->afimon[afi][safi] & BMP_MON_LOC_RIB))
 			continue;
 
-		bmp_process_one(bt, bgp, afi, safi, bn, peer);
+		bmp_process_one(bt, bgp, afi, safi, bn, 0, true);
 
 		frr_each(bmp_session, &bt->sessions, bmp) {
 			pullwr_bump(bmp->pullwr);
@@ -2095,14 +2311,15 @@ DEFPY(bmp_stats_cfg,
 
 DEFPY(bmp_monitor_cfg,
       bmp_monitor_cmd,
-      "[no] bmp monitor <ipv4|ipv6|l2vpn> <unicast|multicast|evpn> <pre-policy|post-policy>$policy",
+      "[no] bmp monitor <ipv4|ipv6|l2vpn> <unicast|multicast|evpn> <pre-policy|post-policy|loc-rib>$policy",
       NO_STR
       BMP_STR
       "Send BMP route monitoring messages\n"
       "Address Family\nAddress Family\nAddress Family\n"
       "Address Family\nAddress Family\nAddress Family\n"
       "Send state before policy and filter processing\n"
-      "Send state with policy and filters applied\n")
+      "Send state with policy and filters applied\n"
+      "Send the selected paths (RFC 9069)\n")
 {
 	int index = 0;
 	uint8_t flag, prev;
@@ -2115,7 +2332,9 @@ DEFPY(bmp_monitor_cfg,
 	argv_find_and_parse_afi(argv, argc, &index, &afi);
 	argv_find_and_parse_safi(argv, argc, &index, &safi);
 
-	if (policy[1] == 'r')
+	if (policy[0] == 'l')
+		flag = BMP_MON_LOC_RIB;
+	else if (policy[1] == 'r')
 		flag = BMP_MON_PREPOLICY;
 	else
 		flag = BMP_MON_POSTPOLICY;
@@ -2247,23 +2466,27 @@ DEFPY(show_bmp,
 			safi_t safi;
 
 			FOREACH_AFI_SAFI (afi, safi) {
-				const char *str = NULL;
-
-				switch (bt->afimon[afi][safi]) {
-				case BMP_MON_PREPOLICY:
-					str = "pre-policy";
-					break;
-				case BMP_MON_POSTPOLICY:
-					str = "post-policy";
-					break;
-				case BMP_MON_PREPOLICY | BMP_MON_POSTPOLICY:
-					str = "pre-policy and post-policy";
-					break;
-				}
-				if (!str)
+				uint8_t mon = bt->afimon[afi][safi];
+
+				if (!mon)
 					continue;
-				vty_out(vty, "    Route Monitoring %s %s %s\n",
-					afi2str(afi), safi2str(safi), str);
+				vty_out(vty, "    Route Monitoring %s %s %s%s%s%s%s\n",
+					afi2str(afi), safi2str(safi),
+					(mon & BMP_MON_PREPOLICY) ? "pre-policy"
+								  : "",
+					(mon & BMP_MON_PREPOLICY)
+							&& (mon & ~BMP_MON_PREPOLICY)
+						? " and "
+						: "",
+					(mon & BMP_MON_POSTPOLICY)
+						? "post-policy"
+						: "",
+					(mon & BMP_MON_POSTPOLICY)
+							&& (mon & BMP_MON_LOC_RIB)
+						? " and "
+						: "",
+					(mon & BMP_MON_LOC_RIB) ? "loc-rib"
+								: "");
 			}
 
 			vty_out(vty, "    Listeners:\n");
@@ -2391,6 +2614,9 @@ static int bmp_config_write(struct bgp *bgp, struct vty *vty)
 			if (bt->afimon[afi][safi] & BMP_MON_POSTPOLICY)
 				vty_out(vty, "  bmp monitor %s %s post-policy\n",
 					afi_str, safi2str(safi));
+			if (bt->afimon[afi][safi] & BMP_MON_LOC_RIB)
+				vty_out(vty, "  bmp monitor %s %s loc-rib\n",
+					afi_str, safi2str(safi));
 		}
 		frr_each (bmp_listeners, &bt->listeners, bl)
 			vty_out(vty, " \n  bmp listener %s port %d\n",
@@ -2436,6 +2662,7 @@ static int bgp_bmp_module_init(void)
 	hook_register(peer_status_changed, bmp_peer_established);
 	hook_register(peer_backward_transition, bmp_peer_backward);
 	hook_register(bgp_process, bmp_process);
+	hook_register(bgp_route_update, bmp_route_update);
 	hook_register(bgp_inst_config_write, bmp_config_write);
 	hook_register(bgp_inst_delete, bmp_bgp_del);
 	hook_register(frr_late_init, bgp_bmp_init);
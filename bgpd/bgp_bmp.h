@@ -77,6 +77,8 @@ struct bmp_queue_entry {
 	uint64_t peerid;
 	afi_t afi;
 	safi_t safi;
+	/* selected path rather than peerid's, RFC 9069 */
+	bool locrib;
 
 	size_t refcount;
 
@@ -158,6 +160,7 @@ struct bmp {
 	struct prefix syncpos;
 	struct bgp_dest *syncrdpos;
 	uint64_t syncpeerid;
+	bool synclocrib;
 	afi_t syncafi;
 	safi_t syncsafi;
 };
@@ -232,6 +235,7 @@ struct bmp_targets {
 	 */
 #define BMP_MON_PREPOLICY	(1 << 0)
 #define BMP_MON_POSTPOLICY	(1 << 1)
+#define BMP_MON_LOC_RIB		(1 << 2)
 	uint8_t afimon[AFI_MAX][SAFI_MAX];
 	bool mirror;
 
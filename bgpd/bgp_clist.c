@@ -158,6 +158,7 @@ static struct community_list *community_list_new(void)
 static void community_list_free(struct community_list *list)
 {
 	XFREE(MTYPE_COMMUNITY_LIST_NAME, list->name);
+	XFREE(MTYPE_COMMUNITY_LIST, list->index);
 	XFREE(MTYPE_COMMUNITY_LIST, list);
 }
 
@@ -316,6 +317,81 @@ static bool community_list_empty_p(struct community_list *list)
 	return list->head == NULL && list->tail == NULL;
 }
 
+/* Standard entry matching exactly one community value, which is the only
+ * thing community_list_match() needs to know about it.
+ */
+static bool community_entry_single(const struct community_entry *entry)
+{
+	return entry->style == COMMUNITY_LIST_STANDARD && !entry->any
+	       && entry->u.com && entry->u.com->size == 1
+	       && community_val_get(entry->u.com, 0) != COMMUNITY_INTERNET;
+}
+
+static int community_list_index_cmp(const void *a, const void *b)
+{
+	const struct community_list_index *ia = a, *ib = b;
+
+	if (ia->val != ib->val)
+		return ia->val < ib->val ? -1 : 1;
+	if (ia->pos != ib->pos)
+		return ia->pos < ib->pos ? -1 : 1;
+	return 0;
+}
+
+/* Rebuild the index of the single value entries of a community-list.  Of
+ * several entries for one value only the first can ever match, so only that
+ * one is kept.
+ */
+static void community_list_compile(struct community_list *list)
+{
+	struct community_entry *entry;
+	uint32_t pos = 0, count = 0, i, j;
+
+	XFREE(MTYPE_COMMUNITY_LIST, list->index);
+	list->index_count = 0;
+
+	for (entry = list->head; entry; entry = entry->next)
+		if (community_entry_single(entry))
+			count++;
+	if (!count)
+		return;
+
+	list->index = XMALLOC(MTYPE_COMMUNITY_LIST,
+			      count * sizeof(struct community_list_index));
+	for (entry = list->head, i = 0; entry; entry = entry->next, pos++) {
+		if (!community_entry_single(entry))
+			continue;
+		list->index[i].val = community_val_get(entry->u.com, 0);
+		list->index[i].pos = pos;
+		i++;
+	}
+	qsort(list->index, count, sizeof(struct community_list_index),
+	      community_list_index_cmp);
+
+	for (i = 1, j = 0; i < count; i++)
+		if (list->index[i].val != list->index[j].val)
+			list->index[++j] = list->index[i];
+	list->index_count = j + 1;
+}
+
+/* Position of the first single value entry for val, UINT32_MAX if none. */
+static uint32_t community_list_index_find(const struct community_list *list,
+					  uint32_t val)
+{
+	uint32_t lo = 0, hi = list->index_count, mid;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (list->index[mid].val == val)
+			return list->index[mid].pos;
+		if (list->index[mid].val < val)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return UINT32_MAX;
+}
+
 /* Delete community-list entry from the list.  */
 static void community_list_entry_delete(struct community_list_master *cm,
 					struct community_list *list,
@@ -335,6 +411,8 @@ static void community_list_entry_delete(struct community_list_master *cm,
 
 	if (community_list_empty_p(list))
 		community_list_delete(cm, list);
+	else
+		community_list_compile(list);
 }
 
 /*
@@ -383,6 +461,7 @@ static void community_list_entry_add(struct community_list *list,
 		replace = bgp_clist_seq_check(list, entry->seq);
 		if (replace) {
 			community_list_entry_replace(list, replace, entry);
+			community_list_compile(list);
 			return;
 		}
 
@@ -412,6 +491,8 @@ static void community_list_entry_add(struct community_list *list,
 		entry->prev = list->tail;
 		list->tail = entry;
 	}
+
+	community_list_compile(list);
 }
 
 /* Lookup community-list entry from the list.  */
@@ -659,8 +740,27 @@ static bool ecommunity_regexp_match(struct ecommunity *ecom, regex_t *reg)
 bool community_list_match(struct community *com, struct community_list *list)
 {
 	struct community_entry *entry;
+	uint32_t best = UINT32_MAX, pos = 0, found;
+	int i;
+
+	/* The first single value entry hit by any of the values, found by
+	 * lookups rather than by trying every such entry in turn.  Only the
+	 * other entries ahead of it still need evaluating.
+	 */
+	if (com && list->index_count)
+		for (i = 0; i < com->size; i++) {
+			found = community_list_index_find(
+				list, community_val_get(com, i));
+			if (found < best)
+				best = found;
+		}
+
+	for (entry = list->head; entry; entry = entry->next, pos++) {
+		if (pos == best)
+			return entry->direct == COMMUNITY_PERMIT;
+		if (community_entry_single(entry))
+			continue;
 
-	for (entry = list->head; entry; entry = entry->next) {
 		if (entry->any)
 			return entry->direct == COMMUNITY_PERMIT;
 
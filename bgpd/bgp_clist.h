@@ -46,6 +46,14 @@
 #define LARGE_COMMUNITY_LIST_STANDARD  4 /* Standard Large community-list.  */
 #define LARGE_COMMUNITY_LIST_EXPANDED  5 /* Expanded Large community-list.  */
 
+/* Standard entry permitting or denying a single community value, by
+ * position in the list.
+ */
+struct community_list_index {
+	uint32_t val;
+	uint32_t pos;
+};
+
 /* Community-list.  */
 struct community_list {
 	/* Name of the community-list.  */
@@ -67,6 +75,12 @@ struct community_list {
 	/* Community-list entry in this community-list.  */
 	struct community_entry *head;
 	struct community_entry *tail;
+
+	/* Single value standard entries, sorted by value, first one per value
+	 * only.  Rebuilt on every change to the entries.
+	 */
+	struct community_list_index *index;
+	uint32_t index_count;
 };
 
 /* Each entry in community-list.  */
@@ -25,10 +25,12 @@
 #include "memory.h"
 #include "jhash.h"
 #include "frrstr.h"
+#include "frr_pthread.h"
 
 #include "bgpd/bgp_memory.h"
 #include "bgpd/bgp_community.h"
 #include "bgpd/bgp_community_alias.h"
+#include "bgpd/bgp_textcache.h"
 
 /* Hash of community attribute. */
 static struct hash *comhash;
@@ -46,19 +48,31 @@ void community_free(struct community **com)
 		return;
 
 	XFREE(MTYPE_COMMUNITY_VAL, (*com)->val);
-	XFREE(MTYPE_COMMUNITY_STR, (*com)->str);
-
-	if ((*com)->json) {
-		json_object_free((*com)->json);
-		(*com)->json = NULL;
+	frr_with_mutex(&bgp_text_mtx) {
+		bgp_text_forget(&(*com)->text);
 	}
+	community_text_drop(*com);
 
 	XFREE(MTYPE_COMMUNITY, (*com));
 }
 
+/* Called by the text cache, see bgp_text_trim() */
+void community_text_drop(struct community *com)
+{
+	XFREE(MTYPE_COMMUNITY_STR, com->str);
+
+	if (com->json) {
+		json_object_free(com->json);
+		com->json = NULL;
+	}
+}
+
 /* Add one community value to the community. */
 void community_add_val(struct community *com, uint32_t val)
 {
+	com->sorted = !com->size
+		      || (com->sorted
+			  && val > community_val_get(com, com->size - 1));
 	com->size++;
 	com->val = XREALLOC(MTYPE_COMMUNITY_VAL, com->val, com_length(com));
 
@@ -131,7 +145,24 @@ static int community_compare(const void *a1, const void *a2)
 
 bool community_include(struct community *com, uint32_t val)
 {
-	int i;
+	int i, lo, hi;
+	uint32_t cur;
+
+	if (com->sorted) {
+		lo = 0;
+		hi = com->size - 1;
+		while (lo <= hi) {
+			i = lo + (hi - lo) / 2;
+			cur = community_val_get(com, i);
+			if (cur == val)
+				return true;
+			if (cur < val)
+				lo = i + 1;
+			else
+				hi = i - 1;
+		}
+		return false;
+	}
 
 	val = htonl(val);
 
@@ -157,24 +188,26 @@ uint32_t community_val_get(struct community *com, int i)
 /* Sort and uniq given community. */
 struct community *community_uniq_sort(struct community *com)
 {
-	int i;
+	int i, j;
 	struct community *new;
-	uint32_t val;
 
 	if (!com)
 		return NULL;
 
 	new = community_new();
 	new->json = NULL;
+	new->sorted = true;
+	if (!com->size)
+		return new;
 
-	for (i = 0; i < com->size; i++) {
-		val = community_val_get(com, i);
-
-		if (!community_include(new, val))
-			community_add_val(new, val);
-	}
+	new->val = XMALLOC(MTYPE_COMMUNITY_VAL, com->size * COMMUNITY_SIZE);
+	memcpy(new->val, com->val, com->size * COMMUNITY_SIZE);
+	qsort(new->val, com->size, sizeof(uint32_t), community_compare);
 
-	qsort(new->val, new->size, sizeof(uint32_t), community_compare);
+	for (i = j = 0; i < com->size; i++)
+		if (!j || new->val[i] != new->val[j - 1])
+			new->val[j++] = new->val[i];
+	new->size = j;
 
 	return new;
 }
@@ -231,6 +264,7 @@ static void set_community_string(struct community *com, bool make_json)
 					       json_community_list);
 		}
 		com->str = str;
+		bgp_text_touch(&com->text, BGP_TEXT_COMMUNITY, 0, make_json);
 		return;
 	}
 
@@ -464,6 +498,7 @@ static void set_community_string(struct community *com, bool make_json)
 		json_object_object_add(com->json, "list", json_community_list);
 	}
 	com->str = str;
+	bgp_text_touch(&com->text, BGP_TEXT_COMMUNITY, strlen(str), make_json);
 }
 
 /* Intern communities attribute.  */
@@ -481,14 +516,15 @@ struct community *community_intern(struct community *com)
 	   hash, it should be freed.  */
 	if (find != com)
 		community_free(&com);
+	else {
+		/* Interned communities are never modified. */
+		find->key = community_hash_make(find);
+		find->key_cached = true;
+	}
 
 	/* Increment refrence counter.  */
 	find->refcnt++;
 
-	/* Make string.  */
-	if (!find->str)
-		set_community_string(find, false);
-
 	return find;
 }
 
@@ -513,7 +549,7 @@ void community_unintern(struct community **com)
 /* Create new community attribute. */
 struct community *community_parse(uint32_t *pnt, unsigned short length)
 {
-	struct community tmp;
+	struct community tmp = {};
 	struct community *new;
 
 	/* If length is malformed return NULL. */
@@ -535,6 +571,7 @@ struct community *community_dup(struct community *com)
 
 	new = XCALLOC(MTYPE_COMMUNITY, sizeof(struct community));
 	new->size = com->size;
+	new->sorted = com->sorted;
 	if (new->size) {
 		new->val = XMALLOC(MTYPE_COMMUNITY_VAL,
 				   com->size * COMMUNITY_SIZE);
@@ -550,11 +587,18 @@ char *community_str(struct community *com, bool make_json)
 	if (!com)
 		return NULL;
 
-	if (make_json && !com->json && com->str)
-		XFREE(MTYPE_COMMUNITY_STR, com->str);
+	frr_with_mutex(&bgp_text_mtx) {
+		if (make_json && !com->json && com->str) {
+			bgp_text_forget(&com->text);
+			XFREE(MTYPE_COMMUNITY_STR, com->str);
+		}
 
-	if (!com->str)
-		set_community_string(com, make_json);
+		if (!com->str)
+			set_community_string(com, make_json);
+		else
+			bgp_text_touch(&com->text, BGP_TEXT_COMMUNITY,
+				       strlen(com->str), !!com->json);
+	}
 	return com->str;
 }
 
@@ -564,6 +608,9 @@ unsigned int community_hash_make(const struct community *com)
 {
 	uint32_t *pnt = com->val;
 
+	if (com->key_cached)
+		return com->key;
+
 	return jhash2(pnt, com->size, 0x43ea96c1);
 }
 
@@ -614,6 +661,13 @@ bool community_cmp(const struct community *com1, const struct community *com2)
 struct community *community_merge(struct community *com1,
 				  struct community *com2)
 {
+	if (com2->size)
+		com1->sorted = com2->sorted
+			       && (!com1->size
+				   || (com1->sorted
+				       && community_val_get(com1, com1->size - 1)
+						  < community_val_get(com2, 0)));
+
 	com1->val = XREALLOC(MTYPE_COMMUNITY_VAL, com1->val,
 			     (com1->size + com2->size) * COMMUNITY_SIZE);
 
@@ -951,18 +1005,16 @@ void bgp_aggr_community_remove(void *arg)
 	community_free(&community);
 }
 
-void bgp_compute_aggregate_community(struct bgp_aggregate *aggregate,
-				     struct community *community)
-{
-	bgp_compute_aggregate_community_hash(aggregate, community);
-	bgp_compute_aggregate_community_val(aggregate);
-}
-
-
-void bgp_compute_aggregate_community_hash(struct bgp_aggregate *aggregate,
-					  struct community *community)
+/* Takes a reference on community for the aggregate.  If update is set and
+ * the aggregate has not seen some of its values yet, they are added to the
+ * aggregate's community in place.
+ */
+static void bgp_aggr_community_ref(struct bgp_aggregate *aggregate,
+				   struct community *community, bool update)
 {
 	struct community *aggr_community = NULL;
+	bool added = false;
+	int i;
 
 	if ((aggregate == NULL) || (community == NULL))
 		return;
@@ -985,7 +1037,78 @@ void bgp_compute_aggregate_community_hash(struct bgp_aggregate *aggregate,
 
 	/* Increment reference counter.
 	 */
-	aggr_community->refcnt++;
+	if (aggr_community->refcnt++ > 0)
+		return;
+
+	for (i = 0; i < community->size; i++) {
+		if (!bgp_aggr_val_ref(&aggregate->community_val_hash,
+				      community->val + i, COMMUNITY_SIZE)
+		    || !update)
+			continue;
+
+		if (aggregate->community == NULL)
+			aggregate->community = community_new();
+		community_add_val(aggregate->community,
+				  community_val_get(community, i));
+		added = true;
+	}
+
+	if (added)
+		qsort(aggregate->community->val, aggregate->community->size,
+		      sizeof(uint32_t), community_compare);
+}
+
+/* Drops a reference on community.  If update is set, the values no other
+ * route under the aggregate carries are removed from its community.
+ */
+static void bgp_aggr_community_unref(struct bgp_aggregate *aggregate,
+				     struct community *community, bool update)
+{
+	struct community *aggr_community = NULL;
+	struct community *ret_comm = NULL;
+	int i;
+
+	if ((!aggregate)
+	    || (!aggregate->community_hash)
+	    || (!community))
+		return;
+
+	/* Look-up the community in the hash.
+	 */
+	aggr_community = bgp_aggr_community_lookup(aggregate, community);
+	if (!aggr_community)
+		return;
+
+	aggr_community->refcnt--;
+	if (aggr_community->refcnt > 0)
+		return;
+
+	ret_comm = hash_release(aggregate->community_hash, aggr_community);
+	community_free(&ret_comm);
+
+	for (i = 0; i < community->size; i++) {
+		if (bgp_aggr_val_unref(aggregate->community_val_hash,
+				       community->val + i, COMMUNITY_SIZE)
+		    && update && aggregate->community)
+			community_del_val(aggregate->community,
+					  community->val + i);
+	}
+
+	if (update && aggregate->community && !aggregate->community->size)
+		community_free(&aggregate->community);
+}
+
+void bgp_compute_aggregate_community(struct bgp_aggregate *aggregate,
+				     struct community *community)
+{
+	bgp_aggr_community_ref(aggregate, community, true);
+}
+
+
+void bgp_compute_aggregate_community_hash(struct bgp_aggregate *aggregate,
+					  struct community *community)
+{
+	bgp_aggr_community_ref(aggregate, community, false);
 }
 
 void bgp_compute_aggregate_community_val(struct bgp_aggregate *aggregate)
@@ -1016,52 +1139,11 @@ void bgp_compute_aggregate_community_val(struct bgp_aggregate *aggregate)
 void bgp_remove_community_from_aggregate(struct bgp_aggregate *aggregate,
 					 struct community *community)
 {
-	struct community *aggr_community = NULL;
-	struct community *ret_comm = NULL;
-
-	if ((!aggregate)
-	    || (!aggregate->community_hash)
-	    || (!community))
-		return;
-
-	/* Look-up the community in the hash.
-	 */
-	aggr_community = bgp_aggr_community_lookup(aggregate, community);
-	if (aggr_community) {
-		aggr_community->refcnt--;
-
-		if (aggr_community->refcnt == 0) {
-			ret_comm = hash_release(aggregate->community_hash,
-						aggr_community);
-			community_free(&ret_comm);
-
-			bgp_compute_aggregate_community_val(aggregate);
-		}
-	}
+	bgp_aggr_community_unref(aggregate, community, true);
 }
 
 void bgp_remove_comm_from_aggregate_hash(struct bgp_aggregate *aggregate,
 		struct community *community)
 {
-
-	struct community *aggr_community = NULL;
-	struct community *ret_comm = NULL;
-
-	if ((!aggregate)
-	    || (!aggregate->community_hash)
-	    || (!community))
-		return;
-
-	/* Look-up the community in the hash.
-	 */
-	aggr_community = bgp_aggr_community_lookup(aggregate, community);
-	if (aggr_community) {
-		aggr_community->refcnt--;
-
-		if (aggr_community->refcnt == 0) {
-			ret_comm = hash_release(aggregate->community_hash,
-						aggr_community);
-			community_free(&ret_comm);
-		}
-	}
+	bgp_aggr_community_unref(aggregate, community, false);
 }
@@ -23,6 +23,7 @@
 
 #include "lib/json.h"
 #include "bgpd/bgp_route.h"
+#include "bgpd/bgp_textcache.h"
 
 /* Communities attribute.  */
 struct community {
@@ -39,8 +40,17 @@ struct community {
 	json_object *json;
 
 	/* String of community attribute.  This sring is used by vty output
-	   and expanded community-list for regular expression match.  */
+	   and expanded community-list for regular expression match.  Built on
+	   demand by community_str(), may be dropped again by the text cache. */
 	char *str;
+	struct bgp_text text;
+
+	/* Hash key, computed once when interned.  */
+	bool key_cached;
+	unsigned int key;
+
+	/* Values are ascending and unique, as after community_uniq_sort() */
+	bool sorted;
 };
 
 /* Well-known communities value.  */
@@ -77,6 +87,7 @@ extern struct community *community_parse(uint32_t *, unsigned short);
 extern struct community *community_intern(struct community *);
 extern void community_unintern(struct community **);
 extern char *community_str(struct community *, bool make_json);
+extern void community_text_drop(struct community *com);
 extern unsigned int community_hash_make(const struct community *);
 extern struct community *community_str2com(const char *);
 extern bool community_match(const struct community *, const struct community *);
@@ -122,9 +122,7 @@ static void bgp_conditional_adv_routes(struct peer *peer, afi_t afi,
 
 			if (CHECK_FLAG(pi->flags, BGP_PATH_SELECTED)
 			    || (addpath_capable
-				&& bgp_addpath_tx_path(
-					   peer->addpath_type[afi][safi],
-					   pi))) {
+				&& bgp_addpath_capable(pi, peer, afi, safi))) {
 
 				/* Skip route-map checks in
 				 * subgroup_announce_check while executing from
@@ -163,7 +161,8 @@ static void bgp_conditional_adv_routes(struct peer *peer, afi_t afi,
 	}
 }
 
-/* Handler of conditional advertisement timer event.
+/* Handler of conditional advertisement timer event, scheduled by
+ * bgp_conditional_adv_schedule() once something it depends on changed.
  * Each route in the condition-map is evaluated.
  */
 static int bgp_conditional_adv_timer(struct thread *t)
@@ -183,8 +182,7 @@ static int bgp_conditional_adv_timer(struct thread *t)
 	bgp = THREAD_ARG(t);
 	assert(bgp);
 
-	thread_add_timer(bm->master, bgp_conditional_adv_timer, bgp,
-			 bgp->condition_check_period, &bgp->t_condition_check);
+	bgp->condition_check_last = bgp_clock();
 
 	/* loop through each peer and advertise or withdraw routes if
 	 * advertise-map is configured and prefix(es) in condition-map
@@ -290,32 +288,99 @@ static int bgp_conditional_adv_timer(struct thread *t)
 	return 0;
 }
 
+/* Run the scanner as soon as possible, but at most once every
+ * condition_check_period.
+ */
+static void bgp_conditional_adv_schedule(struct bgp *bgp)
+{
+	time_t now, next;
+
+	if (!bgp->condition_filter_count || bgp->t_condition_check)
+		return;
+
+	now = bgp_clock();
+	next = bgp->condition_check_last + bgp->condition_check_period;
+	if (next <= now)
+		thread_add_event(bm->master, bgp_conditional_adv_timer, bgp, 0,
+				 &bgp->t_condition_check);
+	else
+		thread_add_timer(bm->master, bgp_conditional_adv_timer, bgp,
+				 next - now, &bgp->t_condition_check);
+}
+
+void bgp_conditional_adv_config_change(struct peer *peer, afi_t afi,
+				       safi_t safi)
+{
+	peer->advmap_config_change[afi][safi] = true;
+
+	if (ADVERTISE_MAP_NAME(&peer->filter[afi][safi]))
+		bgp_conditional_adv_schedule(peer->bgp);
+}
+
+void bgp_conditional_adv_table_change(struct peer *peer)
+{
+	peer->advmap_table_change = true;
+	bgp_conditional_adv_schedule(peer->bgp);
+}
+
+static bool bgp_conditional_adv_watches(struct peer *peer, afi_t afi,
+					safi_t safi, const struct prefix *p)
+{
+	struct route_map *cmap = peer->filter[afi][safi].advmap.cmap;
+
+	if (cmap && route_map_may_permit(cmap, p))
+		return true;
+
+	/* labeled-unicast looks at the unicast table too */
+	if (safi == SAFI_UNICAST)
+		return bgp_conditional_adv_watches(peer, afi,
+						   SAFI_LABELED_UNICAST, p);
+	return false;
+}
+
+/* The paths of dest changed.  Only peers whose condition-map can permit
+ * the prefix need to look at the table again.
+ */
+void bgp_conditional_adv_process(struct bgp *bgp, afi_t afi, safi_t safi,
+				 struct bgp_dest *dest)
+{
+	const struct prefix *p;
+	struct listnode *node;
+	struct peer *peer;
+
+	if (!bgp->condition_filter_count)
+		return;
+
+	p = bgp_dest_get_prefix(dest);
+
+	for (ALL_LIST_ELEMENTS_RO(bgp->peer, node, peer)) {
+		if (!CHECK_FLAG(peer->flags, PEER_FLAG_CONFIG_NODE))
+			continue;
+
+		if (peer->advmap_table_change)
+			continue;
+
+		if (bgp_conditional_adv_watches(peer, afi, safi, p))
+			bgp_conditional_adv_table_change(peer);
+	}
+}
+
 void bgp_conditional_adv_enable(struct peer *peer, afi_t afi, safi_t safi)
 {
 	struct bgp *bgp = peer->bgp;
 
 	assert(bgp);
 
+	bgp->condition_filter_count++;
+	if (BGP_DEBUG(update, UPDATE_OUT))
+		zlog_debug("%s: condition_filter_count %d", __func__,
+			   bgp->condition_filter_count);
+
 	/* This flag is used to monitor conditional routes status in BGP table,
 	 * and advertise/withdraw routes only when there is a change in BGP
 	 * table w.r.t conditional routes
 	 */
-	peer->advmap_config_change[afi][safi] = true;
-
-	/* advertise-map is already configured on atleast one of its
-	 * neighbors (AFI/SAFI). So just increment the counter.
-	 */
-	if (++bgp->condition_filter_count > 1) {
-		if (BGP_DEBUG(update, UPDATE_OUT))
-			zlog_debug("%s: condition_filter_count %d", __func__,
-				   bgp->condition_filter_count);
-
-		return;
-	}
-
-	/* Register for conditional routes polling timer */
-	thread_add_timer(bm->master, bgp_conditional_adv_timer, bgp,
-			 bgp->condition_check_period, &bgp->t_condition_check);
+	bgp_conditional_adv_config_change(peer, afi, safi);
 }
 
 void bgp_conditional_adv_disable(struct peer *peer, afi_t afi, safi_t safi)
@@ -336,6 +401,6 @@ void bgp_conditional_adv_disable(struct peer *peer, afi_t afi, safi_t safi)
 		return;
 	}
 
-	/* Last filter removed. So cancel conditional routes polling thread. */
+	/* Last filter removed. So cancel conditional routes scanner thread. */
 	THREAD_OFF(bgp->t_condition_check);
 }
@@ -33,13 +33,24 @@
 extern "C" {
 #endif
 
-/* Polling time for monitoring condition-map routes in route table */
+/* Minimum time between two evaluations of the condition-map routes */
 #define DEFAULT_CONDITIONAL_ROUTES_POLL_TIME 60
 
 extern void bgp_conditional_adv_enable(struct peer *peer, afi_t afi,
 				       safi_t safi);
 extern void bgp_conditional_adv_disable(struct peer *peer, afi_t afi,
 					safi_t safi);
+
+/* Something the conditional advertisement of peer depends on changed,
+ * have the scanner look at it.
+ */
+extern void bgp_conditional_adv_config_change(struct peer *peer, afi_t afi,
+					      safi_t safi);
+extern void bgp_conditional_adv_table_change(struct peer *peer);
+
+/* Called for every dest whose paths changed */
+extern void bgp_conditional_adv_process(struct bgp *bgp, afi_t afi,
+					safi_t safi, struct bgp_dest *dest);
 #ifdef __cplusplus
 }
 #endif
@@ -37,90 +37,38 @@
 #include "bgpd/bgp_advertise.h"
 #include "bgpd/bgp_vty.h"
 
-static void bgp_reuselist_add(struct reuselist *list,
-			      struct bgp_damp_info *info)
+static struct reuselist_head *bgp_damp_info_list(struct bgp_damp_info *bdi)
 {
-	struct reuselist_node *new_node;
+	struct bgp_damp_config *bdc = bdi->config;
 
-	assert(info);
-	new_node = XCALLOC(MTYPE_BGP_DAMP_REUSELIST, sizeof(*new_node));
-	new_node->info = info;
-	SLIST_INSERT_HEAD(list, new_node, entry);
-}
-
-static void bgp_reuselist_del(struct reuselist *list,
-			      struct reuselist_node **node)
-{
-	if ((*node) == NULL)
-		return;
-	assert(list && node && *node);
-	SLIST_REMOVE(list, (*node), reuselist_node, entry);
-	XFREE(MTYPE_BGP_DAMP_REUSELIST, (*node));
-	*node = NULL;
-}
-
-static void bgp_reuselist_switch(struct reuselist *source,
-				 struct reuselist_node *node,
-				 struct reuselist *target)
-{
-	assert(source && target && node);
-	SLIST_REMOVE(source, node, reuselist_node, entry);
-	SLIST_INSERT_HEAD(target, node, entry);
-}
-
-static void bgp_reuselist_free(struct reuselist *list)
-{
-	struct reuselist_node *rn;
-
-	assert(list);
-	while ((rn = SLIST_FIRST(list)) != NULL)
-		bgp_reuselist_del(list, &rn);
-}
-
-static struct reuselist_node *bgp_reuselist_find(struct reuselist *list,
-						 struct bgp_damp_info *info)
-{
-	struct reuselist_node *rn;
-
-	assert(list && info);
-	SLIST_FOREACH (rn, list, entry) {
-		if (rn->info == info)
-			return rn;
-	}
-	return NULL;
+	if (bdi->index == BGP_DAMP_NO_REUSE_LIST_INDEX)
+		return &bdc->no_reuse_list;
+	if (bdi->index == BGP_DAMP_REUSE_PENDING_INDEX)
+		return &bdc->reuse_pending;
+	return &bdc->reuse_list[bdi->index];
 }
 
+/* Take dampening information off whichever list it is on.  */
 static void bgp_damp_info_unclaim(struct bgp_damp_info *bdi)
 {
-	struct reuselist_node *node;
-
-	assert(bdi && bdi->config);
-	if (bdi->index == BGP_DAMP_NO_REUSE_LIST_INDEX) {
-		node = bgp_reuselist_find(&bdi->config->no_reuse_list, bdi);
-		if (node)
-			bgp_reuselist_del(&bdi->config->no_reuse_list, &node);
-	} else {
-		node = bgp_reuselist_find(&bdi->config->reuse_list[bdi->index],
-					  bdi);
-		if (node)
-			bgp_reuselist_del(&bdi->config->reuse_list[bdi->index],
-					  &node);
-	}
+	assert(bdi);
+	if (bdi->config == NULL)
+		return;
+	reuselist_del(bgp_damp_info_list(bdi), bdi);
 	bdi->config = NULL;
 }
 
+/* Put dampening information on list index of bdc.  */
 static void bgp_damp_info_claim(struct bgp_damp_info *bdi,
-				struct bgp_damp_config *bdc)
+				struct bgp_damp_config *bdc, int index)
 {
 	assert(bdc && bdi);
-	if (bdi->config == NULL) {
-		bdi->config = bdc;
-		return;
-	}
 	bgp_damp_info_unclaim(bdi);
 	bdi->config = bdc;
 	bdi->afi = bdc->afi;
 	bdi->safi = bdc->safi;
+	bdi->index = index;
+	reuselist_add_head(bgp_damp_info_list(bdi), bdi);
 }
 
 struct bgp_damp_config *get_active_bdc_from_pi(struct bgp_path_info *pi,
@@ -141,25 +89,39 @@ struct bgp_damp_config *get_active_bdc_from_pi(struct bgp_path_info *pi,
 	return NULL;
 }
 
-/* Calculate reuse list index by penalty value.  */
-static int bgp_reuse_index(int penalty, struct bgp_damp_config *bdc)
+/* Seconds until penalty has decayed below the reuse limit.  */
+static time_t bgp_reuse_delay(unsigned int penalty,
+			      struct bgp_damp_config *bdc)
 {
-	unsigned int i;
-	unsigned int index;
+	double ticks;
 
-	/*
-	 * reuse_limit can't be zero, this is for Coverity
-	 * to bypass division by zero test.
-	 */
-	assert(bdc->reuse_limit);
+	if (penalty < bdc->reuse_limit)
+		return 0;
 
-	i = (int)(((double)penalty / bdc->reuse_limit - 1.0)
-		  * bdc->scale_factor);
+	/* the first decay_array step that takes it below reuse_limit */
+	ticks = log((double)bdc->reuse_limit / penalty)
+		/ log(bdc->decay_array[1]);
+	if (ticks >= bdc->decay_array_size)
+		return bdc->max_suppress_time;
 
-	if (i >= bdc->reuse_index_size)
-		i = bdc->reuse_index_size - 1;
+	return DELTA_T * ((time_t)ticks + 1);
+}
 
-	index = bdc->reuse_index[i] - bdc->reuse_index[0];
+/* Calculate reuse list index by reuse time.  */
+static int bgp_reuse_index(struct bgp_damp_info *bdi,
+			   struct bgp_damp_config *bdc, time_t t_now)
+{
+	time_t remain;
+	unsigned int index;
+
+	/*
+	 * The slot at reuse_offset is the one the next reuse timer tick,
+	 * at most DELTA_REUSE seconds away, looks at.
+	 */
+	remain = bdi->t_reuse - t_now;
+	index = remain > DELTA_REUSE ? (remain - 1) / DELTA_REUSE : 0;
+	if (index >= bdc->reuse_list_size)
+		index = bdc->reuse_list_size - 1;
 
 	return (bdc->reuse_offset + index) % bdc->reuse_list_size;
 }
@@ -168,45 +130,15 @@ static int bgp_reuse_index(int penalty, struct bgp_damp_config *bdc)
 static void bgp_reuse_list_add(struct bgp_damp_info *bdi,
 			       struct bgp_damp_config *bdc)
 {
-	bgp_damp_info_claim(bdi, bdc);
-	bdi->index = bgp_reuse_index(bdi->penalty, bdc);
-	bgp_reuselist_add(&bdc->reuse_list[bdi->index], bdi);
-}
-
-/* Delete BGP dampening information from reuse list.  */
-static void bgp_reuse_list_delete(struct bgp_damp_info *bdi,
-				  struct bgp_damp_config *bdc)
-{
-	struct reuselist *list;
-	struct reuselist_node *rn;
-
-	list = &bdc->reuse_list[bdi->index];
-	rn = bgp_reuselist_find(list, bdi);
-	bgp_damp_info_unclaim(bdi);
-	bgp_reuselist_del(list, &rn);
+	bdi->t_reuse = bdi->t_updated + bgp_reuse_delay(bdi->penalty, bdc);
+	bgp_damp_info_claim(bdi, bdc,
+			    bgp_reuse_index(bdi, bdc, bgp_clock()));
 }
 
 static void bgp_no_reuse_list_add(struct bgp_damp_info *bdi,
 				  struct bgp_damp_config *bdc)
 {
-	bgp_damp_info_claim(bdi, bdc);
-	bdi->index = BGP_DAMP_NO_REUSE_LIST_INDEX;
-	bgp_reuselist_add(&bdc->no_reuse_list, bdi);
-}
-
-static void bgp_no_reuse_list_delete(struct bgp_damp_info *bdi,
-				     struct bgp_damp_config *bdc)
-{
-	struct reuselist_node *rn;
-
-	assert(bdc && bdi);
-	if (bdi->config == NULL) {
-		bgp_damp_info_unclaim(bdi);
-		return;
-	}
-	bdi->config = NULL;
-	rn = bgp_reuselist_find(&bdc->no_reuse_list, bdi);
-	bgp_reuselist_del(&bdc->no_reuse_list, &rn);
+	bgp_damp_info_claim(bdi, bdc, BGP_DAMP_NO_REUSE_LIST_INDEX);
 }
 
 /* Return decayed penalty value.  */
@@ -225,85 +157,107 @@ int bgp_damp_decay(time_t tdiff, int penalty, struct bgp_damp_config *bdc)
 	return (int)(penalty * bdc->decay_array[i]);
 }
 
-/* Handler of reuse timer event.  Each route in the current reuse-list
-   is evaluated.  RFC2439 Section 4.8.7.  */
-static int bgp_reuse_timer(struct thread *t)
+/* Re-evaluate up to REUSE_BATCH_SIZE routes the reuse timer found due.
+ * RFC2439 Section 4.8.7.
+ */
+static int bgp_reuse_batch(struct thread *t)
 {
 	struct bgp_damp_config *bdc = THREAD_ARG(t);
 	struct bgp_damp_info *bdi;
-	struct reuselist plist;
-	struct reuselist_node *node;
 	struct bgp *bgp;
-	time_t t_now, t_diff;
-
-	thread_add_timer(bm->master, bgp_reuse_timer, bdc, DELTA_REUSE,
-			 &bdc->t_reuse);
+	unsigned int count = 0;
+	time_t t_now;
 
 	t_now = bgp_clock();
 
-	/* 1.  save a pointer to the current queue head and zero the list head
-	 * list head entry. */
-	assert(bdc->reuse_offset < bdc->reuse_list_size);
-	plist = bdc->reuse_list[bdc->reuse_offset];
-	SLIST_INIT(&bdc->reuse_list[bdc->reuse_offset]);
+	while ((bdi = reuselist_pop(&bdc->reuse_pending)) != NULL) {
+		bdi->config = NULL;
 
-	/* 2.  set offset = modulo reuse-list-size ( offset + 1 ), thereby
-	   rotating the circular queue of list-heads.  */
-	bdc->reuse_offset = (bdc->reuse_offset + 1) % bdc->reuse_list_size;
-	assert(bdc->reuse_offset < bdc->reuse_list_size);
+		if (++count > REUSE_BATCH_SIZE) {
+			bgp_damp_info_claim(bdi, bdc,
+					    BGP_DAMP_REUSE_PENDING_INDEX);
+			thread_add_event(bm->master, bgp_reuse_batch, bdc, 0,
+					 &bdc->t_reuse_batch);
+			break;
+		}
 
-	/* 3. if ( the saved list head pointer is non-empty ) */
-	while ((node = SLIST_FIRST(&plist)) != NULL) {
-		bdi = node->info;
-		bgp = bdi->path->peer->bgp;
+		/* Beyond what the reuse list spans, just wait some more */
+		if (bdi->t_reuse > t_now) {
+			bgp_damp_info_claim(bdi, bdc,
+					    bgp_reuse_index(bdi, bdc, t_now));
+			continue;
+		}
 
-		/* Set t-diff = t-now - t-updated.  */
-		t_diff = t_now - bdi->t_updated;
+		bgp = bdi->path->peer->bgp;
 
 		/* Set figure-of-merit = figure-of-merit * decay-array-ok
-		 * [t-diff] */
-		bdi->penalty = bgp_damp_decay(t_diff, bdi->penalty, bdc);
-
-		/* Set t-updated = t-now.  */
+		 * [t-now - t-updated] and t-updated = t-now.
+		 */
+		bdi->penalty = bgp_damp_decay(t_now - bdi->t_updated,
+					      bdi->penalty, bdc);
 		bdi->t_updated = t_now;
 
 		/* if (figure-of-merit < reuse).  */
-		if (bdi->penalty < bdc->reuse_limit) {
-			/* Reuse the route.  */
-			bgp_path_info_unset_flag(bdi->dest, bdi->path,
-						 BGP_PATH_DAMPED);
-			bdi->suppress_time = 0;
-
-			if (bdi->lastrecord == BGP_RECORD_UPDATE) {
-				bgp_path_info_unset_flag(bdi->dest, bdi->path,
-							 BGP_PATH_HISTORY);
-				bgp_aggregate_increment(
-					bgp, bgp_dest_get_prefix(bdi->dest),
-					bdi->path, bdi->afi, bdi->safi);
-				bgp_process(bgp, bdi->dest, bdi->afi,
-					    bdi->safi);
-			}
-
-			if (bdi->penalty <= bdc->reuse_limit / 2.0) {
-				bgp_damp_info_free(&bdi, bdc, 1, bdi->afi,
-						   bdi->safi);
-				bgp_reuselist_del(&plist, &node);
-			} else {
-				node->info->index =
-					BGP_DAMP_NO_REUSE_LIST_INDEX;
-				bgp_reuselist_switch(&plist, node,
-						     &bdc->no_reuse_list);
-			}
-		} else {
+		if (bdi->penalty >= bdc->reuse_limit) {
 			/* Re-insert into another list (See RFC2439 Section
 			 * 4.8.6).  */
-			bdi->index = bgp_reuse_index(bdi->penalty, bdc);
-			bgp_reuselist_switch(&plist, node,
-					     &bdc->reuse_list[bdi->index]);
+			bgp_reuse_list_add(bdi, bdc);
+			continue;
+		}
+
+		/* Reuse the route.  */
+		bgp_path_info_unset_flag(bdi->dest, bdi->path,
+					 BGP_PATH_DAMPED);
+		bdi->suppress_time = 0;
+
+		if (bdi->lastrecord == BGP_RECORD_UPDATE) {
+			bgp_path_info_unset_flag(bdi->dest, bdi->path,
+						 BGP_PATH_HISTORY);
+			bgp_aggregate_increment(bgp,
+						bgp_dest_get_prefix(bdi->dest),
+						bdi->path, bdi->afi, bdi->safi);
+			bgp_process(bgp, bdi->dest, bdi->afi, bdi->safi);
 		}
+
+		if (bdi->penalty <= bdc->reuse_limit / 2.0)
+			bgp_damp_info_free(&bdi, bdc, 1, bdi->afi, bdi->safi);
+		else
+			bgp_no_reuse_list_add(bdi, bdc);
+	}
+
+	return 0;
+}
+
+/* Handler of reuse timer event.  The routes in the current reuse-list
+ * are due, hand them to bgp_reuse_batch().
+ */
+static int bgp_reuse_timer(struct thread *t)
+{
+	struct bgp_damp_config *bdc = THREAD_ARG(t);
+	struct reuselist_head *list;
+	struct bgp_damp_info *bdi;
+
+	thread_add_timer(bm->master, bgp_reuse_timer, bdc, DELTA_REUSE,
+			 &bdc->t_reuse);
+
+	assert(bdc->reuse_offset < bdc->reuse_list_size);
+	list = &bdc->reuse_list[bdc->reuse_offset];
+
+	/* Set offset = modulo reuse-list-size ( offset + 1 ), thereby
+	 * rotating the circular queue of list-heads.
+	 */
+	bdc->reuse_offset = (bdc->reuse_offset + 1) % bdc->reuse_list_size;
+
+	if (reuselist_count(list) == 0)
+		return 0;
+
+	while ((bdi = reuselist_pop(list)) != NULL) {
+		bdi->index = BGP_DAMP_REUSE_PENDING_INDEX;
+		reuselist_add_tail(&bdc->reuse_pending, bdi);
 	}
 
-	assert(SLIST_EMPTY(&plist));
+	thread_add_event(bm->master, bgp_reuse_batch, bdc, 0,
+			 &bdc->t_reuse_batch);
 
 	return 0;
 }
@@ -349,7 +303,6 @@ int bgp_damp_withdraw(struct bgp_path_info *path, struct bgp_dest *dest,
 		(bgp_path_info_extra_get(path))->damp_info = bdi;
 		bgp_no_reuse_list_add(bdi, bdc);
 	} else {
-		bgp_damp_info_claim(bdi, bdc);
 		last_penalty = bdi->penalty;
 
 		/* 1. Set t-diff = t-now - t-updated.  */
@@ -375,10 +328,8 @@ int bgp_damp_withdraw(struct bgp_path_info *path, struct bgp_dest *dest,
 	/* Remove the route from a reuse list if it is on one.  */
 	if (CHECK_FLAG(bdi->path->flags, BGP_PATH_DAMPED)) {
 		/* If decay rate isn't equal to 0, reinsert brn. */
-		if (bdi->penalty != last_penalty) {
-			bgp_reuse_list_delete(bdi, bdc);
+		if (bdi->penalty != last_penalty || bdi->config != bdc)
 			bgp_reuse_list_add(bdi, bdc);
-		}
 		return BGP_DAMP_SUPPRESSED;
 	}
 
@@ -387,9 +338,9 @@ int bgp_damp_withdraw(struct bgp_path_info *path, struct bgp_dest *dest,
 	if (bdi->penalty >= bdc->suppress_value) {
 		bgp_path_info_set_flag(dest, path, BGP_PATH_DAMPED);
 		bdi->suppress_time = t_now;
-		bgp_no_reuse_list_delete(bdi, bdc);
 		bgp_reuse_list_add(bdi, bdc);
-	}
+	} else if (bdi->config != bdc)
+		bgp_no_reuse_list_add(bdi, bdc);
 	return BGP_DAMP_USED;
 }
 
@@ -420,7 +371,6 @@ int bgp_damp_update(struct bgp_path_info *path, struct bgp_dest *dest,
 	else if (CHECK_FLAG(bdi->path->flags, BGP_PATH_DAMPED)
 		 && (bdi->penalty < bdc->reuse_limit)) {
 		bgp_path_info_unset_flag(dest, path, BGP_PATH_DAMPED);
-		bgp_reuse_list_delete(bdi, bdc);
 		bgp_no_reuse_list_add(bdi, bdc);
 		bdi->suppress_time = 0;
 		status = BGP_DAMP_USED;
@@ -429,10 +379,8 @@ int bgp_damp_update(struct bgp_path_info *path, struct bgp_dest *dest,
 
 	if (bdi->penalty > bdc->reuse_limit / 2.0)
 		bdi->t_updated = t_now;
-	else {
-		bgp_damp_info_unclaim(bdi);
+	else
 		bgp_damp_info_free(&bdi, bdc, 0, afi, safi);
-	}
 
 	return status;
 }
@@ -442,33 +390,29 @@ void bgp_damp_info_free(struct bgp_damp_info **bdi, struct bgp_damp_config *bdc,
 {
 	assert(bdc && bdi && *bdi);
 
-	if ((*bdi)->path == NULL) {
-		XFREE(MTYPE_BGP_DAMP_INFO, (*bdi));
-		return;
+	bgp_damp_info_unclaim(*bdi);
+
+	if ((*bdi)->path) {
+		(*bdi)->path->extra->damp_info = NULL;
+		bgp_path_info_unset_flag((*bdi)->dest, (*bdi)->path,
+					 BGP_PATH_HISTORY | BGP_PATH_DAMPED);
+		if ((*bdi)->lastrecord == BGP_RECORD_WITHDRAW && withdraw)
+			bgp_path_info_delete((*bdi)->dest, (*bdi)->path);
 	}
 
-	(*bdi)->path->extra->damp_info = NULL;
-	bgp_path_info_unset_flag((*bdi)->dest, (*bdi)->path,
-				 BGP_PATH_HISTORY | BGP_PATH_DAMPED);
-	if ((*bdi)->lastrecord == BGP_RECORD_WITHDRAW && withdraw)
-		bgp_path_info_delete((*bdi)->dest, (*bdi)->path);
+	XFREE(MTYPE_BGP_DAMP_INFO, (*bdi));
 }
 
 static void bgp_damp_parameter_set(int hlife, int reuse, int sup, int maxsup,
 				   struct bgp_damp_config *bdc)
 {
-	double reuse_max_ratio;
 	unsigned int i;
-	double j;
 
 	bdc->suppress_value = sup;
 	bdc->half_life = hlife;
 	bdc->reuse_limit = reuse;
 	bdc->max_suppress_time = maxsup;
 
-	/* Initialize params per bgp_damp_config. */
-	bdc->reuse_index_size = REUSE_ARRAY_SIZE;
-
 	bdc->ceiling = (int)(bdc->reuse_limit
 			     * (pow(2, (double)bdc->max_suppress_time
 					       / bdc->half_life)));
@@ -494,28 +438,11 @@ static void bgp_damp_parameter_set(int hlife, int reuse, int sup, int maxsup,
 
 	bdc->reuse_list =
 		XCALLOC(MTYPE_BGP_DAMP_ARRAY,
-			bdc->reuse_list_size * sizeof(struct reuselist));
-	/* Reuse-array computations */
-	bdc->reuse_index = XCALLOC(MTYPE_BGP_DAMP_ARRAY,
-				   sizeof(int) * bdc->reuse_index_size);
-
-	reuse_max_ratio = (double)bdc->ceiling / bdc->reuse_limit;
-	j = (exp((double)bdc->max_suppress_time / bdc->half_life) * log10(2.0));
-	if (reuse_max_ratio > j && j != 0)
-		reuse_max_ratio = j;
-
-	bdc->scale_factor =
-		(double)bdc->reuse_index_size / (reuse_max_ratio - 1);
-
-	for (i = 0; i < bdc->reuse_index_size; i++) {
-		bdc->reuse_index[i] =
-			(int)(((double)bdc->half_life / DELTA_REUSE)
-			      * log10(1.0
-				      / (bdc->reuse_limit
-					 * (1.0
-					    + ((double)i / bdc->scale_factor))))
-			      / log10(0.5));
-	}
+			bdc->reuse_list_size * sizeof(struct reuselist_head));
+	for (i = 0; i < bdc->reuse_list_size; i++)
+		reuselist_init(&bdc->reuse_list[i]);
+	reuselist_init(&bdc->reuse_pending);
+	reuselist_init(&bdc->no_reuse_list);
 }
 
 int bgp_damp_enable(struct bgp *bgp, afi_t afi, safi_t safi, time_t half,
@@ -548,15 +475,14 @@ void bgp_damp_info_clean(struct bgp *bgp, struct bgp_damp_config *bdc,
 			 afi_t afi, safi_t safi)
 {
 	struct bgp_damp_info *bdi;
-	struct reuselist_node *rn;
-	struct reuselist *list;
+	struct reuselist_head *list;
 	unsigned int i;
 
 	bdc->reuse_offset = 0;
-	for (i = 0; i < bdc->reuse_list_size; ++i) {
-		list = &bdc->reuse_list[i];
-		while ((rn = SLIST_FIRST(list)) != NULL) {
-			bdi = rn->info;
+	for (i = 0; i <= bdc->reuse_list_size; ++i) {
+		list = i < bdc->reuse_list_size ? &bdc->reuse_list[i]
+						: &bdc->reuse_pending;
+		while ((bdi = reuselist_first(list)) != NULL) {
 			if (bdi->lastrecord == BGP_RECORD_UPDATE) {
 				bgp_aggregate_increment(bgp, &bdi->dest->p,
 							bdi->path, bdi->afi,
@@ -564,33 +490,25 @@ void bgp_damp_info_clean(struct bgp *bgp, struct bgp_damp_config *bdc,
 				bgp_process(bgp, bdi->dest, bdi->afi,
 					    bdi->safi);
 			}
-			bgp_reuselist_del(list, &rn);
 			bgp_damp_info_free(&bdi, bdc, 1, afi, safi);
 		}
+		reuselist_fini(list);
 	}
 
-	while ((rn = SLIST_FIRST(&bdc->no_reuse_list)) != NULL) {
-		bdi = rn->info;
-		bgp_reuselist_del(&bdc->no_reuse_list, &rn);
+	while ((bdi = reuselist_first(&bdc->no_reuse_list)) != NULL)
 		bgp_damp_info_free(&bdi, bdc, 1, afi, safi);
-	}
+	reuselist_fini(&bdc->no_reuse_list);
 
 	/* Free decay array */
 	XFREE(MTYPE_BGP_DAMP_ARRAY, bdc->decay_array);
 	bdc->decay_array_size = 0;
 
-	/* Free reuse index array */
-	XFREE(MTYPE_BGP_DAMP_ARRAY, bdc->reuse_index);
-	bdc->reuse_index_size = 0;
-
 	/* Free reuse list array. */
-	for (i = 0; i < bdc->reuse_list_size; ++i)
-		bgp_reuselist_free(&bdc->reuse_list[i]);
-
 	XFREE(MTYPE_BGP_DAMP_ARRAY, bdc->reuse_list);
 	bdc->reuse_list_size = 0;
 
 	THREAD_OFF(bdc->t_reuse);
+	THREAD_OFF(bdc->t_reuse_batch);
 }
 
 /* Disable route flap dampening for a bgp instance.
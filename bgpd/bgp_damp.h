@@ -21,10 +21,16 @@
 #ifndef _QUAGGA_BGP_DAMP_H
 #define _QUAGGA_BGP_DAMP_H
 
+#include "typesafe.h"
 #include "bgpd/bgp_table.h"
 
+PREDECL_DLIST(reuselist);
+
 /* Structure maintained on a per-route basis. */
 struct bgp_damp_info {
+	/* Entry on the reuse list or no-reuse list it is on */
+	struct reuselist_item reuse_entry;
+
 	/* Figure-of-merit.  */
 	unsigned int penalty;
 
@@ -40,7 +46,14 @@ struct bgp_damp_info {
 	/* Time of route start to be suppressed.  */
 	time_t suppress_time;
 
-	/* Back reference to associated dampening configuration. */
+	/* When the penalty will have decayed below the reuse limit, as of
+	 * when it was put on a reuse list.
+	 */
+	time_t t_reuse;
+
+	/* Back reference to the dampening configuration whose list it is
+	 * on, NULL while on none.
+	 */
 	struct bgp_damp_config *config;
 
 	/* Back reference to bgp_path_info. */
@@ -53,6 +66,8 @@ struct bgp_damp_info {
 	int index;
 #define BGP_DAMP_NO_REUSE_LIST_INDEX                                           \
 	(-1) /* index for elements on no_reuse_list */
+#define BGP_DAMP_REUSE_PENDING_INDEX                                           \
+	(-2) /* index for elements on reuse_pending */
 
 	/* Last time message type. */
 	uint8_t lastrecord;
@@ -63,12 +78,7 @@ struct bgp_damp_info {
 	safi_t safi;
 };
 
-struct reuselist_node {
-	SLIST_ENTRY(reuselist_node) entry;
-	struct bgp_damp_info *info;
-};
-
-SLIST_HEAD(reuselist, reuselist_node);
+DECLARE_DLIST(reuselist, struct bgp_damp_info, reuse_entry);
 
 /* Specified parameter set configuration. */
 struct bgp_damp_config {
@@ -89,7 +99,6 @@ struct bgp_damp_config {
 	 */
 	time_t tmax; /* Max time previous instability retained */
 	unsigned int reuse_list_size;  /* Number of reuse lists */
-	unsigned int reuse_index_size; /* Size of reuse index array */
 
 	/* Non-configurable parameters.  Most of these are calculated from
 	 * the configurable parameters above.
@@ -97,24 +106,25 @@ struct bgp_damp_config {
 	unsigned int ceiling;		  /* Max value a penalty can attain */
 	unsigned int decay_rate_per_tick; /* Calculated from half-life */
 	unsigned int decay_array_size; /* Calculated using config parameters */
-	double scale_factor;
-	unsigned int reuse_scale_factor;
 
 	/* Decay array per-set based. */
 	double *decay_array;
 
-	/* Reuse index array per-set based. */
-	int *reuse_index;
-
-	/* Reuse list array per-set based. */
-	struct reuselist *reuse_list;
+	/* Reuse list array per-set based, a wheel of DELTA_REUSE slots by
+	 * reuse time.
+	 */
+	struct reuselist_head *reuse_list;
 	unsigned int reuse_offset;
 
 	/* All dampening information which is not on reuse list.  */
-	struct reuselist no_reuse_list;
+	struct reuselist_head no_reuse_list;
+
+	/* Taken off the reuse list, waiting for bgp_reuse_batch() */
+	struct reuselist_head reuse_pending;
 
 	/* Reuse timer thread per-set base. */
 	struct thread *t_reuse;
+	struct thread *t_reuse_batch;
 
 	afi_t afi;
 	safi_t safi;
@@ -137,7 +147,9 @@ struct bgp_damp_config {
 #define DEFAULT_SUPPRESS 	2000
 
 #define REUSE_LIST_SIZE          256
-#define REUSE_ARRAY_SIZE        1024
+
+/* Damped paths re-evaluated per run of bgp_reuse_batch() */
+#define REUSE_BATCH_SIZE        1000
 
 extern struct bgp_damp_config *get_active_bdc_from_pi(struct bgp_path_info *pi,
 						      afi_t afi, safi_t safi);
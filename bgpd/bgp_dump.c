@@ -30,6 +30,8 @@
 #include "queue.h"
 #include "memory.h"
 #include "filter.h"
+#include "frr_pthread.h"
+#include "frratomic.h"
 
 #include "bgpd/bgp_table.h"
 #include "bgpd/bgpd.h"
@@ -39,6 +41,8 @@
 #include "bgpd/bgp_errors.h"
 #include "bgpd/bgp_packet.h"
 
+DEFINE_MTYPE_STATIC(BGPD, BGP_DUMP, "BGP routes-mrt dump");
+
 enum bgp_dump_type {
 	BGP_DUMP_ALL,
 	BGP_DUMP_ALL_ET,
@@ -217,111 +221,92 @@ static void bgp_dump_set_size(struct stream *s, int type)
 	stream_putl_at(s, 8, stream_get_endp(s) - BGP_DUMP_HEADER_SIZE);
 }
 
-static void bgp_dump_routes_index_table(struct bgp *bgp)
+static int bgp_addpath_encode_rx(struct peer *peer, afi_t afi, safi_t safi)
 {
-	struct peer *peer;
-	struct listnode *node;
-	uint16_t peerno = 1;
-	struct stream *obuf;
-
-	obuf = bgp_dump_obuf;
-	stream_reset(obuf);
-
-	/* MRT header */
-	bgp_dump_header(obuf, MSG_TABLE_DUMP_V2, TABLE_DUMP_V2_PEER_INDEX_TABLE,
-			BGP_DUMP_ROUTES);
 
-	/* Collector BGP ID */
-	stream_put_in_addr(obuf, &bgp->router_id);
+	return (CHECK_FLAG(peer->af_cap[afi][safi], PEER_CAP_ADDPATH_AF_RX_ADV)
+		&& CHECK_FLAG(peer->af_cap[afi][safi],
+			      PEER_CAP_ADDPATH_AF_TX_RCV));
+}
 
-	/* View name */
-	if (bgp->name_pretty) {
-		stream_putw(obuf, strlen(bgp->name_pretty));
-		stream_put(obuf, bgp->name_pretty, strlen(bgp->name_pretty));
-	} else {
-		stream_putw(obuf, 0);
-	}
+/* Snapshot of the routes of one destination */
+struct bgp_dump_snap_dest {
+	struct prefix p;
+	uint32_t first;
+	uint32_t count;
+};
 
-	/* Peer count ( plus one extra internal peer ) */
-	stream_putw(obuf, listcount(bgp->peer) + 1);
+struct bgp_dump_snap_path {
+	/* holds a reference */
+	struct attr *attr;
+	uint32_t originated;
+	uint32_t addpath_rx_id;
+	uint16_t peer_index;
+	bool addpath;
+};
 
-	/* Populate fake peer at index 0, for locally originated routes */
-	/* Peer type (IPv4) */
-	stream_putc(obuf,
-		    TABLE_DUMP_V2_PEER_INDEX_TABLE_AS4
-			    + TABLE_DUMP_V2_PEER_INDEX_TABLE_IP);
-	/* Peer BGP ID (0.0.0.0) */
-	stream_putl(obuf, 0);
-	/* Peer IP address (0.0.0.0) */
-	stream_putl(obuf, 0);
-	/* Peer ASN (0) */
-	stream_putl(obuf, 0);
+/*
+ * A routes-mrt dump.  The main pthread takes a snapshot of the table in one
+ * go, which is consistent and cheap since it only references the interned
+ * attributes.  The dump pthread then encodes and writes it, and hands it
+ * back to the main pthread to drop the references.
+ */
+struct bgp_dump_job {
+	int fd;
 
-	/* Walk down all peers */
-	for (ALL_LIST_ELEMENTS_RO(bgp->peer, node, peer)) {
+	/* peer index table, already encoded */
+	struct stream *index;
 
-		/* Peer's type */
-		if (sockunion_family(&peer->su) == AF_INET) {
-			stream_putc(
-				obuf,
-				TABLE_DUMP_V2_PEER_INDEX_TABLE_AS4
-					+ TABLE_DUMP_V2_PEER_INDEX_TABLE_IP);
-		} else if (sockunion_family(&peer->su) == AF_INET6) {
-			stream_putc(
-				obuf,
-				TABLE_DUMP_V2_PEER_INDEX_TABLE_AS4
-					+ TABLE_DUMP_V2_PEER_INDEX_TABLE_IP6);
-		}
+	struct bgp_dump_snap_dest *dests;
+	uint32_t ndests, dests_alloc;
+	struct bgp_dump_snap_path *paths;
+	uint32_t npaths, paths_alloc;
 
-		/* Peer's BGP ID */
-		stream_put_in_addr(obuf, &peer->remote_id);
+	/* progress, updated by the dump pthread */
+	_Atomic uint32_t dests_done;
+	_Atomic uint64_t bytes;
+	_Atomic bool abort;
+	int error;
 
-		/* Peer's IP address */
-		if (sockunion_family(&peer->su) == AF_INET) {
-			stream_put_in_addr(obuf, &peer->su.sin.sin_addr);
-		} else if (sockunion_family(&peer->su) == AF_INET6) {
-			stream_write(obuf, (uint8_t *)&peer->su.sin6.sin6_addr,
-				     IPV6_MAX_BYTELEN);
-		}
-
-		/* Peer's AS number. */
-		/* Note that, as this is an AS4 compliant quagga, the RIB is
-		 * always AS4 */
-		stream_putl(obuf, peer->as);
-
-		/* Store the peer number for this peer */
-		peer->table_dump_index = peerno;
-		peerno++;
-	}
-
-	bgp_dump_set_size(obuf, MSG_TABLE_DUMP_V2);
+	struct timeval started;
+	struct thread *t_done;
+};
 
-	fwrite(STREAM_DATA(obuf), stream_get_endp(obuf), 1, bgp_dump_routes.fp);
-	fflush(bgp_dump_routes.fp);
-}
+struct bgp_dump_stats {
+	uint64_t runs;
+	uint64_t failures;
+	uint64_t skipped;
+
+	/* last completed dump */
+	uint32_t prefixes;
+	uint32_t paths;
+	uint64_t bytes;
+	int64_t usec;
+	time_t finished;
+};
 
-static int bgp_addpath_encode_rx(struct peer *peer, afi_t afi, safi_t safi)
-{
+#define BGP_DUMP_WBUF_SIZE (1 << 20)
 
-	return (CHECK_FLAG(peer->af_cap[afi][safi], PEER_CAP_ADDPATH_AF_RX_ADV)
-		&& CHECK_FLAG(peer->af_cap[afi][safi],
-			      PEER_CAP_ADDPATH_AF_TX_RCV));
-}
+static struct frr_pthread *bgp_dump_pth;
+static struct bgp_dump_job *bgp_dump_job;
+static struct bgp_dump_stats bgp_dump_stats;
 
-static struct bgp_path_info *
-bgp_dump_route_node_record(int afi, struct bgp_dest *dest,
-			   struct bgp_path_info *path, unsigned int seq)
+/* Encodes one TABLE_DUMP_V2 RIB record, returns the number of paths used */
+static uint32_t bgp_dump_route_node_record(struct stream *obuf,
+					   const struct bgp_dump_snap_dest *sd,
+					   const struct bgp_dump_snap_path *sp,
+					   uint32_t count, uint32_t seq)
 {
-	struct stream *obuf;
 	size_t sizep;
 	size_t endp;
 	int addpath_encoded;
-	const struct prefix *p = bgp_dest_get_prefix(dest);
+	const struct prefix *p = &sd->p;
+	afi_t afi = family2afi(p->family);
+	uint32_t i;
 
-	obuf = bgp_dump_obuf;
 	stream_reset(obuf);
 
-	addpath_encoded = bgp_addpath_encode_rx(path->peer, afi, SAFI_UNICAST);
+	addpath_encoded = sp->addpath;
 
 	/* MRT header */
 	if (afi == AFI_IP && addpath_encoded)
@@ -370,23 +355,23 @@ bgp_dump_route_node_record(int afi, struct bgp_dest *dest,
 	stream_putw(obuf, 0);
 
 	endp = stream_get_endp(obuf);
-	for (; path; path = path->next) {
+	for (i = 0; i < count; i++) {
 		size_t cur_endp;
 
 		/* Peer index */
-		stream_putw(obuf, path->peer->table_dump_index);
+		stream_putw(obuf, sp[i].peer_index);
 
 		/* Originated */
-		stream_putl(obuf, time(NULL) - (bgp_clock() - path->uptime));
+		stream_putl(obuf, sp[i].originated);
 
 		/*Path Identifier*/
 		if (addpath_encoded) {
-			stream_putl(obuf, path->addpath_rx_id);
+			stream_putl(obuf, sp[i].addpath_rx_id);
 		}
 
 		/* Dump attribute. */
 		/* Skip prefix & AFI/SAFI for MP_NLRI */
-		bgp_dump_routes_attr(obuf, path->attr, p);
+		bgp_dump_routes_attr(obuf, sp[i].attr, p);
 
 		cur_endp = stream_get_endp(obuf);
 		if (cur_endp > BGP_STANDARD_MESSAGE_MAX_PACKET_SIZE
@@ -404,49 +389,297 @@ bgp_dump_route_node_record(int afi, struct bgp_dest *dest,
 	stream_putw_at(obuf, sizep, entry_count);
 
 	bgp_dump_set_size(obuf, MSG_TABLE_DUMP_V2);
-	fwrite(STREAM_DATA(obuf), stream_get_endp(obuf), 1, bgp_dump_routes.fp);
 
-	return path;
+	/* a single path too big for a record is skipped */
+	return MAX(i, 1);
+}
+
+static bool bgp_dump_job_flush(struct bgp_dump_job *job, struct stream *s)
+{
+	size_t off = 0, len = stream_get_endp(s);
+	ssize_t nwrite;
+
+	while (off < len) {
+		nwrite = write(job->fd, STREAM_DATA(s) + off, len - off);
+		if (nwrite < 0) {
+			if (errno == EINTR)
+				continue;
+			job->error = errno;
+			return false;
+		}
+		off += nwrite;
+	}
+
+	atomic_fetch_add_explicit(&job->bytes, len, memory_order_relaxed);
+	stream_reset(s);
+	return true;
 }
 
+static int bgp_dump_job_done(struct thread *t);
 
-/* Runs under child process. */
-static unsigned int bgp_dump_routes_func(int afi, int first_run,
-					 unsigned int seq)
+/* Runs on the dump pthread. */
+static int bgp_dump_job_run(struct thread *t)
 {
-	struct bgp_path_info *path;
-	struct bgp_dest *dest;
-	struct bgp *bgp;
-	struct bgp_table *table;
+	struct bgp_dump_job *job = THREAD_ARG(t);
+	const struct bgp_dump_snap_dest *sd;
+	struct stream *obuf, *wbuf;
+	uint32_t seq = 0, i, done, n;
 
-	bgp = bgp_get_default();
-	if (!bgp)
-		return seq;
+	obuf = stream_new((BGP_STANDARD_MESSAGE_MAX_PACKET_SIZE * 2)
+			  + BGP_DUMP_MSG_HEADER + BGP_DUMP_HEADER_SIZE);
+	wbuf = stream_new(BGP_DUMP_WBUF_SIZE);
 
-	if (bgp_dump_routes.fp == NULL)
-		return seq;
+	stream_put(wbuf, STREAM_DATA(job->index), stream_get_endp(job->index));
 
-	/* Note that bgp_dump_routes_index_table will do ipv4 and ipv6 peers,
-	   so this should only be done on the first call to
-	   bgp_dump_routes_func.
-	   ( this function will be called once for ipv4 and once for ipv6 ) */
-	if (first_run)
-		bgp_dump_routes_index_table(bgp);
+	for (i = 0; i < job->ndests && !job->error; i++) {
+		if (atomic_load_explicit(&job->abort, memory_order_relaxed))
+			break;
+
+		sd = &job->dests[i];
+		for (done = 0; done < sd->count && !job->error; done += n) {
+			n = bgp_dump_route_node_record(obuf, sd,
+						       &job->paths[sd->first
+								   + done],
+						       sd->count - done, seq++);
+
+			if (STREAM_WRITEABLE(wbuf) < stream_get_endp(obuf)
+			    && !bgp_dump_job_flush(job, wbuf))
+				break;
+			stream_put(wbuf, STREAM_DATA(obuf),
+				   stream_get_endp(obuf));
+		}
+		atomic_store_explicit(&job->dests_done, i + 1,
+				      memory_order_relaxed);
+	}
+
+	if (!job->error)
+		bgp_dump_job_flush(job, wbuf);
+	if (close(job->fd) < 0 && !job->error)
+		job->error = errno;
+	job->fd = -1;
+
+	stream_free(obuf);
+	stream_free(wbuf);
+
+	thread_add_event(bm->master, bgp_dump_job_done, job, 0, &job->t_done);
+	return 0;
+}
+
+static void bgp_dump_job_free(struct bgp_dump_job *job)
+{
+	uint32_t i;
+
+	THREAD_OFF(job->t_done);
+
+	for (i = 0; i < job->npaths; i++)
+		bgp_attr_unintern(&job->paths[i].attr);
+
+	if (job->fd >= 0)
+		close(job->fd);
+	stream_free(job->index);
+	XFREE(MTYPE_BGP_DUMP, job->dests);
+	XFREE(MTYPE_BGP_DUMP, job->paths);
+	XFREE(MTYPE_BGP_DUMP, job);
+}
+
+static int bgp_dump_job_done(struct thread *t)
+{
+	struct bgp_dump_job *job = THREAD_ARG(t);
+
+	assert(job == bgp_dump_job);
+	bgp_dump_job = NULL;
+
+	if (job->error) {
+		bgp_dump_stats.failures++;
+		flog_warn(EC_BGP_DUMP, "%s: routes-mrt dump failed: %s",
+			  __func__, safe_strerror(job->error));
+	} else {
+		bgp_dump_stats.prefixes = job->ndests;
+		bgp_dump_stats.paths = job->npaths;
+		bgp_dump_stats.bytes = atomic_load_explicit(
+			&job->bytes, memory_order_relaxed);
+		bgp_dump_stats.usec = monotime_since(&job->started, NULL);
+		bgp_dump_stats.finished = time(NULL);
+	}
+
+	bgp_dump_job_free(job);
+	return 0;
+}
+
+static void bgp_dump_routes_index_table(struct bgp *bgp)
+{
+	struct peer *peer;
+	struct listnode *node;
+	uint16_t peerno = 1;
+	struct stream *obuf;
+
+	obuf = bgp_dump_obuf;
+	stream_reset(obuf);
+
+	/* MRT header */
+	bgp_dump_header(obuf, MSG_TABLE_DUMP_V2, TABLE_DUMP_V2_PEER_INDEX_TABLE,
+			BGP_DUMP_ROUTES);
+
+	/* Collector BGP ID */
+	stream_put_in_addr(obuf, &bgp->router_id);
+
+	/* View name */
+	if (bgp->name_pretty) {
+		stream_putw(obuf, strlen(bgp->name_pretty));
+		stream_put(obuf, bgp->name_pretty, strlen(bgp->name_pretty));
+	} else {
+		stream_putw(obuf, 0);
+	}
+
+	/* Peer count ( plus one extra internal peer ) */
+	stream_putw(obuf, listcount(bgp->peer) + 1);
+
+	/* Populate fake peer at index 0, for locally originated routes */
+	/* Peer type (IPv4) */
+	stream_putc(obuf,
+		    TABLE_DUMP_V2_PEER_INDEX_TABLE_AS4
+			    + TABLE_DUMP_V2_PEER_INDEX_TABLE_IP);
+	/* Peer BGP ID (0.0.0.0) */
+	stream_putl(obuf, 0);
+	/* Peer IP address (0.0.0.0) */
+	stream_putl(obuf, 0);
+	/* Peer ASN (0) */
+	stream_putl(obuf, 0);
+
+	/* Walk down all peers */
+	for (ALL_LIST_ELEMENTS_RO(bgp->peer, node, peer)) {
+
+		/* Peer's type */
+		if (sockunion_family(&peer->su) == AF_INET) {
+			stream_putc(
+				obuf,
+				TABLE_DUMP_V2_PEER_INDEX_TABLE_AS4
+					+ TABLE_DUMP_V2_PEER_INDEX_TABLE_IP);
+		} else if (sockunion_family(&peer->su) == AF_INET6) {
+			stream_putc(
+				obuf,
+				TABLE_DUMP_V2_PEER_INDEX_TABLE_AS4
+					+ TABLE_DUMP_V2_PEER_INDEX_TABLE_IP6);
+		}
+
+		/* Peer's BGP ID */
+		stream_put_in_addr(obuf, &peer->remote_id);
+
+		/* Peer's IP address */
+		if (sockunion_family(&peer->su) == AF_INET) {
+			stream_put_in_addr(obuf, &peer->su.sin.sin_addr);
+		} else if (sockunion_family(&peer->su) == AF_INET6) {
+			stream_write(obuf, (uint8_t *)&peer->su.sin6.sin6_addr,
+				     IPV6_MAX_BYTELEN);
+		}
+
+		/* Peer's AS number. */
+		/* Note that, as this is an AS4 compliant quagga, the RIB is
+		 * always AS4 */
+		stream_putl(obuf, peer->as);
+
+		/* Store the peer number for this peer */
+		peer->table_dump_index = peerno;
+		peerno++;
+	}
+
+	bgp_dump_set_size(obuf, MSG_TABLE_DUMP_V2);
+}
+
+
+static void bgp_dump_routes_snap(struct bgp_dump_job *job, struct bgp *bgp,
+				 afi_t afi)
+{
+	struct bgp_path_info *path;
+	struct bgp_dest *dest;
+	struct bgp_table *table;
+	struct bgp_dump_snap_dest *sd;
+	struct bgp_dump_snap_path *sp;
+	time_t offset = time(NULL) - bgp_clock();
 
 	/* Walk down each BGP route. */
 	table = bgp->rib[afi][SAFI_UNICAST];
 
 	for (dest = bgp_table_top(table); dest; dest = bgp_route_next(dest)) {
 		path = bgp_dest_get_bgp_path_info(dest);
-		while (path) {
-			path = bgp_dump_route_node_record(afi, dest, path, seq);
-			seq++;
+		if (!path)
+			continue;
+
+		if (job->ndests == job->dests_alloc) {
+			job->dests_alloc = MAX(job->dests_alloc * 2, 1024);
+			job->dests = XREALLOC(MTYPE_BGP_DUMP, job->dests,
+					      job->dests_alloc
+						      * sizeof(*job->dests));
 		}
+		sd = &job->dests[job->ndests++];
+		prefix_copy(&sd->p, bgp_dest_get_prefix(dest));
+		sd->first = job->npaths;
+		sd->count = 0;
+
+		for (; path; path = path->next) {
+			if (job->npaths == job->paths_alloc) {
+				job->paths_alloc =
+					MAX(job->paths_alloc * 2, 4096);
+				job->paths = XREALLOC(
+					MTYPE_BGP_DUMP, job->paths,
+					job->paths_alloc * sizeof(*job->paths));
+			}
+			sp = &job->paths[job->npaths++];
+			sp->attr = bgp_attr_intern(path->attr);
+			sp->originated = offset + path->uptime;
+			sp->addpath_rx_id = path->addpath_rx_id;
+			sp->peer_index = path->peer->table_dump_index;
+			sp->addpath = bgp_addpath_encode_rx(path->peer, afi,
+							    SAFI_UNICAST);
+			sd->count++;
+		}
+	}
+}
+
+static void bgp_dump_routes_start(struct bgp_dump *bgp_dump)
+{
+	struct frr_pthread_attr attr = {
+		.start = frr_pthread_attr_default.start,
+		.stop = frr_pthread_attr_default.stop,
+	};
+	struct bgp_dump_job *job;
+	struct bgp *bgp;
+	int fd;
+
+	bgp = bgp_get_default();
+	if (!bgp)
+		return;
+
+	fd = dup(fileno(bgp_dump->fp));
+	if (fd < 0) {
+		flog_warn(EC_BGP_DUMP, "%s: dup: %s", __func__,
+			  safe_strerror(errno));
+		return;
 	}
 
-	fflush(bgp_dump_routes.fp);
+	job = XCALLOC(MTYPE_BGP_DUMP, sizeof(*job));
+	job->fd = fd;
+	monotime(&job->started);
+
+	/* Note that bgp_dump_routes_index_table will do ipv4 and ipv6 peers,
+	 * and assigns the indexes that the snapshot refers to.
+	 */
+	bgp_dump_routes_index_table(bgp);
+	job->index = stream_dup(bgp_dump_obuf);
+
+	bgp_dump_routes_snap(job, bgp, AFI_IP);
+	bgp_dump_routes_snap(job, bgp, AFI_IP6);
+
+	if (!bgp_dump_pth) {
+		bgp_dump_pth = frr_pthread_new(&attr, "BGP MRT dump thread",
+					       "bgpd_dump");
+		frr_pthread_run(bgp_dump_pth, NULL);
+		frr_pthread_wait_running(bgp_dump_pth);
+	}
 
-	return seq;
+	bgp_dump_job = job;
+	bgp_dump_stats.runs++;
+	thread_add_event(bgp_dump_pth->master, bgp_dump_job_run, job, 0, NULL);
 }
 
 static int bgp_dump_interval_func(struct thread *t)
@@ -456,12 +689,17 @@ static int bgp_dump_interval_func(struct thread *t)
 	bgp_dump->t_interval = NULL;
 
 	/* Reschedule dump even if file couldn't be opened this time... */
-	if (bgp_dump_open_file(bgp_dump) != NULL) {
+	if (bgp_dump->type == BGP_DUMP_ROUTES && bgp_dump_job) {
+		/* rather than truncating the file of the next interval */
+		bgp_dump_stats.skipped++;
+		flog_warn(EC_BGP_DUMP,
+			  "%s: previous routes-mrt dump still running, skipping",
+			  __func__);
+	} else if (bgp_dump_open_file(bgp_dump) != NULL) {
 		/* In case of bgp_dump_routes, we need special route dump
 		 * function. */
 		if (bgp_dump->type == BGP_DUMP_ROUTES) {
-			unsigned int seq = bgp_dump_routes_func(AFI_IP, 1, 0);
-			bgp_dump_routes_func(AFI_IP6, 0, seq);
+			bgp_dump_routes_start(bgp_dump);
 			/* Close the file now. For a RIB dump there's no point
 			 * in leaving
 			 * it open until the next scheduled dump starts. */
@@ -812,6 +1050,72 @@ DEFUN (no_dump_bgp_all,
 	return bgp_dump_unset(bgp_dump_struct);
 }
 
+static const char *bgp_dump_type_str(enum bgp_dump_type type)
+{
+	const struct bgp_dump_type_map *map;
+
+	for (map = bgp_dump_type_map; map->str; map++)
+		if (map->type == type)
+			return map->str;
+	return "unknown";
+}
+
+static void bgp_dump_show_one(struct vty *vty, struct bgp_dump *bgp_dump)
+{
+	if (!bgp_dump->filename)
+		return;
+
+	vty_out(vty, "dump bgp %s %s", bgp_dump_type_str(bgp_dump->type),
+		bgp_dump->filename);
+	if (bgp_dump->interval_str)
+		vty_out(vty, ", every %s", bgp_dump->interval_str);
+	vty_out(vty, "\n");
+}
+
+DEFUN (show_dump,
+       show_dump_cmd,
+       "show dump",
+       SHOW_STR
+       "BGP packet and routing table dumps\n")
+{
+	struct bgp_dump_job *job = bgp_dump_job;
+	int64_t usec;
+
+	bgp_dump_show_one(vty, &bgp_dump_all);
+	bgp_dump_show_one(vty, &bgp_dump_updates);
+	bgp_dump_show_one(vty, &bgp_dump_routes);
+
+	vty_out(vty, "routes-mrt dumps: %" PRIu64 " started, %" PRIu64
+		" failed, %" PRIu64 " skipped while busy\n",
+		bgp_dump_stats.runs, bgp_dump_stats.failures,
+		bgp_dump_stats.skipped);
+
+	if (job) {
+		usec = monotime_since(&job->started, NULL);
+		vty_out(vty,
+			"  Running for %" PRId64 ".%03" PRId64
+			"s: %u of %u prefixes, %" PRIu64 " bytes written\n",
+			usec / 1000000, (usec / 1000) % 1000,
+			atomic_load_explicit(&job->dests_done,
+					     memory_order_relaxed),
+			job->ndests,
+			atomic_load_explicit(&job->bytes,
+					     memory_order_relaxed));
+	}
+
+	if (bgp_dump_stats.finished) {
+		usec = bgp_dump_stats.usec;
+		vty_out(vty,
+			"  Last completed %lld seconds ago: %u prefixes, %u paths, %" PRIu64
+			" bytes in %" PRId64 ".%03" PRId64 "s\n",
+			(long long)(time(NULL) - bgp_dump_stats.finished),
+			bgp_dump_stats.prefixes, bgp_dump_stats.paths,
+			bgp_dump_stats.bytes, usec / 1000000,
+			(usec / 1000) % 1000);
+	}
+	return CMD_SUCCESS;
+}
+
 static int config_write_bgp_dump(struct vty *vty);
 /* BGP node structure. */
 static struct cmd_node bgp_dump_node = {
@@ -876,6 +1180,7 @@ void bgp_dump_init(void)
 
 	install_element(CONFIG_NODE, &dump_bgp_all_cmd);
 	install_element(CONFIG_NODE, &no_dump_bgp_all_cmd);
+	install_element(VIEW_NODE, &show_dump_cmd);
 
 	hook_register(bgp_packet_dump, bgp_dump_packet);
 	hook_register(peer_status_changed, bgp_dump_state);
@@ -887,6 +1192,19 @@ void bgp_dump_finish(void)
 	bgp_dump_unset(&bgp_dump_updates);
 	bgp_dump_unset(&bgp_dump_routes);
 
+	if (bgp_dump_job)
+		atomic_store_explicit(&bgp_dump_job->abort, true,
+				      memory_order_relaxed);
+	if (bgp_dump_pth) {
+		frr_pthread_stop(bgp_dump_pth, NULL);
+		frr_pthread_destroy(bgp_dump_pth);
+		bgp_dump_pth = NULL;
+	}
+	if (bgp_dump_job) {
+		bgp_dump_job_free(bgp_dump_job);
+		bgp_dump_job = NULL;
+	}
+
 	stream_free(bgp_dump_obuf);
 	bgp_dump_obuf = NULL;
 	hook_unregister(bgp_packet_dump, bgp_dump_packet);
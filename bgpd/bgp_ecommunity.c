@@ -70,6 +70,7 @@ void ecommunity_free(struct ecommunity **ecom)
 		return;
 
 	XFREE(MTYPE_ECOMMUNITY_VAL, (*ecom)->val);
+	XFREE(MTYPE_ECOMMUNITY_VAL, (*ecom)->keys);
 	XFREE(MTYPE_ECOMMUNITY_STR, (*ecom)->str);
 	XFREE(MTYPE_ECOMMUNITY, *ecom);
 }
@@ -223,7 +224,7 @@ static struct ecommunity *ecommunity_parse_internal(uint8_t *pnt,
 					unsigned short length,
 					unsigned short size_ecom)
 {
-	struct ecommunity tmp;
+	struct ecommunity tmp = {};
 	struct ecommunity *new;
 
 	/* Length check.  */
@@ -297,6 +298,118 @@ struct ecommunity *ecommunity_merge(struct ecommunity *ecom1,
 	return ecom1;
 }
 
+static uint64_t ecommunity_val_key(const uint8_t *p)
+{
+	uint64_t key = 0;
+	int i;
+
+	/* big endian, so keys sort like the values do with memcmp() */
+	for (i = 0; i < ECOMMUNITY_SIZE; i++)
+		key = (key << 8) | p[i];
+	return key;
+}
+
+/* Two bits of a one word filter per key */
+static uint64_t ecommunity_key_bloom(uint64_t key)
+{
+	key *= 0x9e3779b97f4a7c15ULL;
+	return (1ULL << (key >> 58)) | (1ULL << ((key >> 52) & 63));
+}
+
+static int ecommunity_key_cmp(const void *a, const void *b)
+{
+	uint64_t ka = *(const uint64_t *)a, kb = *(const uint64_t *)b;
+
+	return ka < kb ? -1 : ka > kb;
+}
+
+static void ecommunity_summarize(struct ecommunity *ecom)
+{
+	uint32_t i;
+
+	if (ecom->unit_size != ECOMMUNITY_SIZE || !ecom->size)
+		return;
+
+	ecom->keys = XMALLOC(MTYPE_ECOMMUNITY_VAL,
+			     ecom->size * sizeof(*ecom->keys));
+	for (i = 0; i < ecom->size; i++) {
+		ecom->keys[i] =
+			ecommunity_val_key(ecom->val + i * ECOMMUNITY_SIZE);
+		ecom->bloom |= ecommunity_key_bloom(ecom->keys[i]);
+	}
+	/* merged values needn't be in order */
+	qsort(ecom->keys, ecom->size, sizeof(*ecom->keys), ecommunity_key_cmp);
+}
+
+static bool ecommunity_has_key(const struct ecommunity *ecom, uint64_t key)
+{
+	uint64_t bloom = ecommunity_key_bloom(key);
+	uint32_t lo = 0, hi = ecom->size, mid;
+
+	if ((ecom->bloom & bloom) != bloom)
+		return false;
+
+	while (lo < hi) {
+		mid = lo + (hi - lo) / 2;
+		if (ecom->keys[mid] == key)
+			return true;
+		if (ecom->keys[mid] < key)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return false;
+}
+
+bool ecommunity_intersect(const struct ecommunity *ecom1,
+			  const struct ecommunity *ecom2)
+{
+	const struct ecommunity *look, *in;
+	uint32_t i, j;
+
+	if (!ecom1 || !ecom2)
+		return false;
+
+	if (ecom1->keys && ecom2->keys) {
+		if (!(ecom1->bloom & ecom2->bloom))
+			return false;
+
+		/* both sorted */
+		i = j = 0;
+		while (i < ecom1->size && j < ecom2->size) {
+			if (ecom1->keys[i] == ecom2->keys[j])
+				return true;
+			if (ecom1->keys[i] < ecom2->keys[j])
+				i++;
+			else
+				j++;
+		}
+		return false;
+	}
+
+	/* look the values of the other one up in the summarized one */
+	in = ecom1->keys ? ecom1 : ecom2;
+	look = ecom1->keys ? ecom2 : ecom1;
+	if (in->keys && look->unit_size == ECOMMUNITY_SIZE) {
+		for (i = 0; i < look->size; i++)
+			if (ecommunity_has_key(
+				    in, ecommunity_val_key(
+						look->val + i * ECOMMUNITY_SIZE)))
+				return true;
+		return false;
+	}
+
+	for (i = 0; i < ecom1->size; ++i) {
+		for (j = 0; j < ecom2->size; ++j) {
+			if (!memcmp(ecom1->val + (i * ecom1->unit_size),
+				    ecom2->val + (j * ecom2->unit_size),
+				    ecom1->unit_size))
+				return true;
+		}
+	}
+	return false;
+}
+
 /* Intern Extended Communities Attribute.  */
 struct ecommunity *ecommunity_intern(struct ecommunity *ecom)
 {
@@ -306,6 +419,12 @@ struct ecommunity *ecommunity_intern(struct ecommunity *ecom)
 	find = (struct ecommunity *)hash_get(ecomhash, ecom, hash_alloc_intern);
 	if (find != ecom)
 		ecommunity_free(&ecom);
+	else {
+		/* Interned communities are never modified. */
+		find->key = ecommunity_hash_make(find);
+		find->key_cached = true;
+		ecommunity_summarize(find);
+	}
 
 	find->refcnt++;
 
@@ -343,6 +462,9 @@ unsigned int ecommunity_hash_make(const void *arg)
 	const struct ecommunity *ecom = arg;
 	int size = ecom->size * ecom->unit_size;
 
+	if (ecom->key_cached)
+		return ecom->key;
+
 	return jhash(ecom->val, size, 0x564321ab);
 }
 
@@ -1390,18 +1512,16 @@ void bgp_aggr_ecommunity_remove(void *arg)
 	ecommunity_free(&ecommunity);
 }
 
-void bgp_compute_aggregate_ecommunity(struct bgp_aggregate *aggregate,
-				      struct ecommunity *ecommunity)
-{
-	bgp_compute_aggregate_ecommunity_hash(aggregate, ecommunity);
-	bgp_compute_aggregate_ecommunity_val(aggregate);
-}
-
-
-void bgp_compute_aggregate_ecommunity_hash(struct bgp_aggregate *aggregate,
-					   struct ecommunity *ecommunity)
+/* Takes a reference on ecommunity for the aggregate.  If update is set and
+ * the aggregate has not seen some of its values yet, they are added to the
+ * aggregate's extended community in place.
+ */
+static void bgp_aggr_ecommunity_ref(struct bgp_aggregate *aggregate,
+				    struct ecommunity *ecommunity, bool update)
 {
 	struct ecommunity *aggr_ecommunity = NULL;
+	uint8_t *p;
+	uint32_t c;
 
 	if ((aggregate == NULL) || (ecommunity == NULL))
 		return;
@@ -1424,7 +1544,80 @@ void bgp_compute_aggregate_ecommunity_hash(struct bgp_aggregate *aggregate,
 
 	/* Increment reference counter.
 	 */
-	aggr_ecommunity->refcnt++;
+	if (aggr_ecommunity->refcnt++ > 0)
+		return;
+
+	for (p = ecommunity->val, c = 0; c < ecommunity->size;
+	     p += ecommunity->unit_size, c++) {
+		if (!bgp_aggr_val_ref(&aggregate->ecommunity_val_hash, p,
+				      ecommunity->unit_size)
+		    || !update)
+			continue;
+
+		if (aggregate->ecommunity == NULL) {
+			aggregate->ecommunity = ecommunity_new();
+			aggregate->ecommunity->unit_size =
+				ecommunity->unit_size;
+		}
+		ecommunity_add_val_internal(aggregate->ecommunity, p, false,
+					    false, ecommunity->unit_size);
+	}
+}
+
+/* Drops a reference on ecommunity.  If update is set, the values no other
+ * route under the aggregate carries are removed from its extended community.
+ */
+static void bgp_aggr_ecommunity_unref(struct bgp_aggregate *aggregate,
+				      struct ecommunity *ecommunity,
+				      bool update)
+{
+	struct ecommunity *aggr_ecommunity = NULL;
+	struct ecommunity *ret_ecomm = NULL;
+	uint8_t *p;
+	uint32_t c;
+
+	if ((!aggregate)
+	    || (!aggregate->ecommunity_hash)
+	    || (!ecommunity))
+		return;
+
+	/* Look-up the ecommunity in the hash.
+	 */
+	aggr_ecommunity = bgp_aggr_ecommunity_lookup(aggregate, ecommunity);
+	if (!aggr_ecommunity)
+		return;
+
+	aggr_ecommunity->refcnt--;
+	if (aggr_ecommunity->refcnt > 0)
+		return;
+
+	ret_ecomm = hash_release(aggregate->ecommunity_hash, aggr_ecommunity);
+	ecommunity_free(&ret_ecomm);
+
+	for (p = ecommunity->val, c = 0; c < ecommunity->size;
+	     p += ecommunity->unit_size, c++) {
+		if (bgp_aggr_val_unref(aggregate->ecommunity_val_hash, p,
+				       ecommunity->unit_size)
+		    && update)
+			ecommunity_del_val(aggregate->ecommunity,
+					   (struct ecommunity_val *)p);
+	}
+
+	if (update && aggregate->ecommunity && !aggregate->ecommunity->size)
+		ecommunity_free(&aggregate->ecommunity);
+}
+
+void bgp_compute_aggregate_ecommunity(struct bgp_aggregate *aggregate,
+				      struct ecommunity *ecommunity)
+{
+	bgp_aggr_ecommunity_ref(aggregate, ecommunity, true);
+}
+
+
+void bgp_compute_aggregate_ecommunity_hash(struct bgp_aggregate *aggregate,
+					   struct ecommunity *ecommunity)
+{
+	bgp_aggr_ecommunity_ref(aggregate, ecommunity, false);
 }
 
 void bgp_compute_aggregate_ecommunity_val(struct bgp_aggregate *aggregate)
@@ -1453,53 +1646,13 @@ void bgp_compute_aggregate_ecommunity_val(struct bgp_aggregate *aggregate)
 void bgp_remove_ecommunity_from_aggregate(struct bgp_aggregate *aggregate,
 					  struct ecommunity *ecommunity)
 {
-	struct ecommunity *aggr_ecommunity = NULL;
-	struct ecommunity *ret_ecomm = NULL;
-
-	if ((!aggregate)
-	    || (!aggregate->ecommunity_hash)
-	    || (!ecommunity))
-		return;
-
-	/* Look-up the ecommunity in the hash.
-	 */
-	aggr_ecommunity = bgp_aggr_ecommunity_lookup(aggregate, ecommunity);
-	if (aggr_ecommunity) {
-		aggr_ecommunity->refcnt--;
-
-		if (aggr_ecommunity->refcnt == 0) {
-			ret_ecomm = hash_release(aggregate->ecommunity_hash,
-						 aggr_ecommunity);
-			ecommunity_free(&ret_ecomm);
-			bgp_compute_aggregate_ecommunity_val(aggregate);
-		}
-	}
+	bgp_aggr_ecommunity_unref(aggregate, ecommunity, true);
 }
 
 void bgp_remove_ecomm_from_aggregate_hash(struct bgp_aggregate *aggregate,
 					  struct ecommunity *ecommunity)
 {
-
-	struct ecommunity *aggr_ecommunity = NULL;
-	struct ecommunity *ret_ecomm = NULL;
-
-	if ((!aggregate)
-	    || (!aggregate->ecommunity_hash)
-	    || (!ecommunity))
-		return;
-
-	/* Look-up the ecommunity in the hash.
-	 */
-	aggr_ecommunity = bgp_aggr_ecommunity_lookup(aggregate, ecommunity);
-	if (aggr_ecommunity) {
-		aggr_ecommunity->refcnt--;
-
-		if (aggr_ecommunity->refcnt == 0) {
-			ret_ecomm = hash_release(aggregate->ecommunity_hash,
-						 aggr_ecommunity);
-			ecommunity_free(&ret_ecomm);
-		}
-	}
+	bgp_aggr_ecommunity_unref(aggregate, ecommunity, false);
 }
 
 /*
@@ -124,6 +124,17 @@ struct ecommunity {
 
 	/* Human readable format string.  */
 	char *str;
+
+	/* Hash key, computed once when interned.  */
+	bool key_cached;
+	unsigned int key;
+
+	/* Summary for ecommunity_intersect(), computed once when interned
+	 * with ECOMMUNITY_SIZE values: the values as sorted 64-bit keys and a
+	 * one word bloom filter of them.
+	 */
+	uint64_t *keys;
+	uint64_t bloom;
 };
 
 struct ecommunity_as {
@@ -239,6 +250,9 @@ extern char *ecommunity_ecom2str(struct ecommunity *, int, int);
 extern void ecommunity_strfree(char **s);
 extern bool ecommunity_match(const struct ecommunity *,
 			     const struct ecommunity *);
+/* Whether the two have any value in common */
+extern bool ecommunity_intersect(const struct ecommunity *ecom1,
+				 const struct ecommunity *ecom2);
 extern char *ecommunity_str(struct ecommunity *);
 extern struct ecommunity_val *ecommunity_lookup(const struct ecommunity *,
 						uint8_t, uint8_t);
@@ -3054,6 +3054,7 @@ static int install_uninstall_routes_for_vrf(struct bgp *bgp_vrf, int install)
 	bgp_evpn = bgp_get_evpn();
 	if (!bgp_evpn)
 		return -1;
+	bgp_evpn->evpn_info->import_walks++;
 
 	/* Walk entire global routing table and evaluate routes which could be
 	 * imported into this VRF. Note that we need to loop through all global
@@ -3113,6 +3114,7 @@ static int install_uninstall_routes_for_vni(struct bgp *bgp,
 
 	afi = AFI_L2VPN;
 	safi = SAFI_EVPN;
+	bgp->evpn_info->import_walks++;
 
 	/* Walk entire global routing table and evaluate routes which could be
 	 * imported into this VPN. Note that we cannot just look at the routes
@@ -3177,6 +3179,152 @@ static int install_uninstall_routes_for_vni(struct bgp *bgp,
 	return 0;
 }
 
+static void install_route_in_pending_vnis(struct bgp *bgp,
+					  const struct prefix_evpn *evp,
+					  struct bgp_path_info *pi,
+					  struct irt_node *irt, uint64_t mark)
+{
+	struct bgpevpn *vpn;
+	struct listnode *node;
+
+	if (!irt)
+		return;
+
+	for (ALL_LIST_ELEMENTS_RO(irt->vnis, node, vpn)) {
+		/* more than one RT of the route can point here */
+		if (!CHECK_FLAG(vpn->flags, VNI_FLAG_IMPORT_PENDING)
+		    || !is_vni_live(vpn) || vpn->import_mark == mark)
+			continue;
+		vpn->import_mark = mark;
+
+		if (install_evpn_route_entry(bgp, vpn, evp, pi))
+			flog_err(EC_BGP_EVPN_FAIL,
+				 "%u: Failed to install EVPN %s route in VNI %u",
+				 bgp->vrf_id,
+				 evp->prefix.route_type == BGP_EVPN_MAC_IP_ROUTE
+					 ? "MACIP"
+					 : "IMET",
+				 vpn->vni);
+		else
+			bgp->evpn_info->import_vnis++;
+	}
+}
+
+/*
+ * Same as install_uninstall_routes_for_vni(), for all the VNIs waiting to
+ * have their remote routes installed.  Instead of checking each route
+ * against each VNI, the RTs of the route are looked up in the import RT
+ * hash, so the cost goes with the number of VNIs importing the route and
+ * not with the number of VNIs that came up.
+ */
+static void install_routes_for_pending_vnis(struct bgp *bgp,
+					    bgp_evpn_route_type rtype)
+{
+	struct bgp_dest *rd_dest, *dest;
+	struct bgp_table *table;
+	struct bgp_path_info *pi;
+	struct ecommunity *ecom;
+	uint32_t i;
+
+	bgp->evpn_info->import_walks++;
+
+	for (rd_dest = bgp_table_top(bgp->rib[AFI_L2VPN][SAFI_EVPN]); rd_dest;
+	     rd_dest = bgp_route_next(rd_dest)) {
+		table = bgp_dest_get_bgp_table_info(rd_dest);
+		if (!table)
+			continue;
+
+		for (dest = bgp_table_top(table); dest;
+		     dest = bgp_route_next(dest)) {
+			const struct prefix_evpn *evp =
+				(const struct prefix_evpn *)bgp_dest_get_prefix(
+					dest);
+
+			if (evp->prefix.route_type != rtype)
+				continue;
+
+			for (pi = bgp_dest_get_bgp_path_info(dest); pi;
+			     pi = pi->next) {
+				uint64_t mark;
+
+				if (!(CHECK_FLAG(pi->flags, BGP_PATH_VALID)
+				      && pi->type == ZEBRA_ROUTE_BGP
+				      && pi->sub_type == BGP_ROUTE_NORMAL))
+					continue;
+
+				if (!(pi->attr->flag & ATTR_FLAG_BIT(
+					      BGP_ATTR_EXT_COMMUNITIES)))
+					continue;
+				ecom = pi->attr->ecommunity;
+				if (!ecom)
+					continue;
+
+				mark = ++bgp->evpn_info->import_mark;
+
+				for (i = 0; i < ecom->size; i++) {
+					struct ecommunity_val *eval;
+					struct ecommunity_val eval_tmp;
+					uint8_t type;
+
+					eval = (struct ecommunity_val
+							*)(ecom->val
+							   + (i * ecom->unit_size));
+					type = eval->val[0];
+					if (eval->val[1] != ECOMMUNITY_ROUTE_TARGET)
+						continue;
+
+					install_route_in_pending_vnis(
+						bgp, evp, pi,
+						lookup_import_rt(bgp, eval),
+						mark);
+
+					/* same non-exact match as
+					 * is_route_matching_for_vni()
+					 */
+					if (type != ECOMMUNITY_ENCODE_AS
+					    && type != ECOMMUNITY_ENCODE_AS4
+					    && type != ECOMMUNITY_ENCODE_IP)
+						continue;
+
+					memcpy(&eval_tmp, eval,
+					       ecom->unit_size);
+					mask_ecom_global_admin(&eval_tmp, eval);
+					install_route_in_pending_vnis(
+						bgp, evp, pi,
+						lookup_import_rt(bgp,
+								 &eval_tmp),
+						mark);
+				}
+			}
+		}
+	}
+}
+
+static void clear_vni_import_pending(struct hash_bucket *bucket, void *arg)
+{
+	struct bgpevpn *vpn = bucket->data;
+
+	UNSET_FLAG(vpn->flags, VNI_FLAG_IMPORT_PENDING);
+}
+
+/*
+ * VNIs come up in bursts when zebra (re)connects; their remote routes are
+ * installed together once the burst is over, type-3 routes first as in
+ * install_routes_for_vni().
+ */
+static int bgp_evpn_vni_import(struct thread *thread)
+{
+	struct bgp *bgp = THREAD_ARG(thread);
+
+	install_routes_for_pending_vnis(bgp, BGP_EVPN_IMET_ROUTE);
+	install_routes_for_pending_vnis(bgp, BGP_EVPN_AD_ROUTE);
+	install_routes_for_pending_vnis(bgp, BGP_EVPN_MAC_IP_ROUTE);
+
+	hash_iterate(bgp->vnihash, clear_vni_import_pending, NULL);
+
+	return 0;
+}
+
 /* Install any existing remote routes applicable for this VRF into VRF RIB. This
  * is invoked upon l3vni-add or l3vni import rt change
  */
@@ -3274,9 +3422,10 @@ static int install_uninstall_route_in_vrfs(struct bgp *bgp_def, afi_t afi,
 		/* don't import hosts that are locally attached */
 		if (install
 		    && !bgp_evpn_skip_vrf_import_of_local_es(bgp_vrf, evp, pi,
-							     install))
+							     install)) {
 			ret = install_evpn_route_entry_in_vrf(bgp_vrf, evp, pi);
-		else
+			bgp_def->evpn_info->import_vrfs++;
+		} else
 			ret = uninstall_evpn_route_entry_in_vrf(bgp_vrf, evp,
 								pi);
 
@@ -3310,9 +3459,10 @@ static int install_uninstall_route_in_vnis(struct bgp *bgp, afi_t afi,
 		if (!is_vni_live(vpn))
 			continue;
 
-		if (install)
+		if (install) {
 			ret = install_evpn_route_entry(bgp, vpn, evp, pi);
-		else
+			bgp->evpn_info->import_vnis++;
+		} else
 			ret = uninstall_evpn_route_entry(bgp, vpn, evp, pi);
 
 		if (ret) {
@@ -3369,6 +3519,9 @@ static int bgp_evpn_install_uninstall_table(struct bgp *bgp, afi_t afi,
 	if (!ecom || !ecom->size)
 		return -1;
 
+	if (import)
+		bgp->evpn_info->import_routes++;
+
 	/* An EVPN route belongs to a VNI or a VRF or an ESI based on the RTs
 	 * attached to the route */
 	for (i = 0; i < ecom->size; i++) {
@@ -5881,7 +6034,9 @@ int bgp_evpn_local_vni_add(struct bgp *bgp, vni_t vni,
 	 * VNI,
 	 * install them.
 	 */
-	install_routes_for_vni(bgp, vpn);
+	SET_FLAG(vpn->flags, VNI_FLAG_IMPORT_PENDING);
+	thread_add_event(bm->master, bgp_evpn_vni_import, bgp, 0,
+			 &bgp->evpn_info->t_vni_import);
 
 	/* If we are advertising gateway mac-ip
 	   It needs to be conveyed again to zebra */
@@ -5930,6 +6085,9 @@ void bgp_evpn_cleanup_on_disable(struct bgp *bgp)
  */
 void bgp_evpn_cleanup(struct bgp *bgp)
 {
+	if (bgp->evpn_info)
+		THREAD_OFF(bgp->evpn_info->t_vni_import);
+
 	hash_iterate(bgp->vnihash,
 		     (void (*)(struct hash_bucket *, void *))free_vni_entry,
 		     bgp);
@@ -71,6 +71,7 @@ struct bgpevpn {
 #define VNI_FLAG_EXPRT_CFGD        0x10 /* Export RT is user configured */
 #define VNI_FLAG_USE_TWO_LABELS    0x20 /* Attach both L2-VNI and L3-VNI if
 					   needed for this VPN */
+#define VNI_FLAG_IMPORT_PENDING    0x40 /* Remote routes yet to be installed */
 
 	struct bgp *bgp_vrf; /* back pointer to the vrf instance */
 
@@ -90,6 +91,9 @@ struct bgpevpn {
 	 * automatically for this VNI */
 	uint16_t rd_id;
 
+	/* Last route installed here by install_routes_for_pending_vnis() */
+	uint64_t import_mark;
+
 	/* RD for this VNI. */
 	struct prefix_rd prd;
 
@@ -186,6 +190,18 @@ struct bgp_evpn_info {
 	struct ethaddr pip_rmac_static;
 	struct ethaddr pip_rmac_zebra;
 	bool is_anycast_mac;
+
+	/* Installs remote routes into VNIs that came up, all at once */
+	struct thread *t_vni_import;
+	uint64_t import_mark;
+
+	/* Remote routes imported, how many VNI and VRF tables they went
+	 * into and how often the whole table had to be walked for it
+	 */
+	uint64_t import_routes;
+	uint64_t import_vnis;
+	uint64_t import_vrfs;
+	uint64_t import_walks;
 };
 
 /* This structure defines an entry in remote_ip_hash */
@@ -4383,6 +4383,14 @@ DEFUN(show_bgp_l2vpn_evpn_vni,
 			json_object_int_add(json, "numVnis", num_vnis);
 			json_object_int_add(json, "numL2Vnis", num_l2vnis);
 			json_object_int_add(json, "numL3Vnis", num_l3vnis);
+			json_object_int_add(json, "importRoutes",
+					    bgp_evpn->evpn_info->import_routes);
+			json_object_int_add(json, "importVnis",
+					    bgp_evpn->evpn_info->import_vnis);
+			json_object_int_add(json, "importVrfs",
+					    bgp_evpn->evpn_info->import_vrfs);
+			json_object_int_add(json, "importTableWalks",
+					    bgp_evpn->evpn_info->import_walks);
 		} else {
 			vty_out(vty, "Advertise Gateway Macip: %s\n",
 				bgp_evpn->advertise_gw_macip ? "Enabled"
@@ -4399,6 +4407,14 @@ DEFUN(show_bgp_l2vpn_evpn_vni,
 					: "Disabled");
 			vty_out(vty, "Number of L2 VNIs: %u\n", num_l2vnis);
 			vty_out(vty, "Number of L3 VNIs: %u\n", num_l3vnis);
+			vty_out(vty,
+				"Remote routes imported: %" PRIu64
+				" (into %" PRIu64 " VNI, %" PRIu64
+				" VRF tables, %" PRIu64 " table walks)\n",
+				bgp_evpn->evpn_info->import_routes,
+				bgp_evpn->evpn_info->import_vnis,
+				bgp_evpn->evpn_info->import_vrfs,
+				bgp_evpn->evpn_info->import_walks);
 		}
 		evpn_show_all_vnis(vty, bgp_evpn, json);
 	} else {
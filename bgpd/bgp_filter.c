@@ -31,6 +31,7 @@
 #include "bgpd/bgp_aspath.h"
 #include "bgpd/bgp_regex.h"
 #include "bgpd/bgp_filter.h"
+#include "bgpd/bgp_worker_pool.h"
 
 /* List of AS filter list. */
 struct as_list_list {
@@ -73,8 +74,21 @@ struct as_list {
 
 	struct as_filter *head;
 	struct as_filter *tail;
+
+	/* Changes with every modification, see as_list_apply() */
+	uint32_t id;
 };
 
+/* Source of as_list ids, 0 is never handed out */
+static uint32_t as_list_next_id;
+
+static void as_list_new_id(struct as_list *aslist)
+{
+	if (++as_list_next_id == 0)
+		as_list_next_id++;
+	aslist->id = as_list_next_id;
+}
+
 
 /* Calculate new sequential number. */
 static int64_t bgp_alist_new_seq_get(struct as_list *list)
@@ -189,6 +203,7 @@ static void as_list_filter_add(struct as_list *aslist,
 		replace = bgp_aslist_seq_check(aslist, asfilter->seq);
 		if (replace) {
 			as_filter_entry_replace(aslist, replace, asfilter);
+			as_list_new_id(aslist);
 			return;
 		}
 
@@ -218,6 +233,8 @@ static void as_list_filter_add(struct as_list *aslist,
 		aslist->tail = asfilter;
 	}
 
+	as_list_new_id(aslist);
+
 	/* Run hook function. */
 	if (as_list_master.add_hook)
 		(*as_list_master.add_hook)(aslist->name);
@@ -261,6 +278,7 @@ static struct as_list *as_list_insert(const char *name)
 	aslist = as_list_new();
 	aslist->name = XSTRDUP(MTYPE_AS_STR, name);
 	assert(aslist->name);
+	as_list_new_id(aslist);
 
 	/* Set access_list to string list. */
 	list = &as_list_master.str;
@@ -372,6 +390,7 @@ static void as_list_filter_delete(struct as_list *aslist,
 		aslist->head = asfilter->next;
 
 	as_filter_free(asfilter);
+	as_list_new_id(aslist);
 
 	/* If access_list becomes empty delete it from access_master. */
 	if (as_list_empty(aslist))
@@ -388,22 +407,39 @@ static bool as_filter_match(struct as_filter *asfilter, struct aspath *aspath)
 	return bgp_regexec(asfilter->reg, aspath) != REG_NOMATCH;
 }
 
-/* Apply AS path filter to AS. */
+/* Apply AS path filter to AS.  Interned paths never change, so they keep a
+ * few recent results; a list gets a new id when it is modified, which makes
+ * its old results go stale.
+ */
 enum as_filter_type as_list_apply(struct as_list *aslist, void *object)
 {
 	struct as_filter *asfilter;
 	struct aspath *aspath;
+	enum as_filter_type type = AS_FILTER_DENY;
+	unsigned int slot;
 
 	aspath = (struct aspath *)object;
 
 	if (aslist == NULL)
 		return AS_FILTER_DENY;
 
+	slot = aslist->id % ASPATH_FILTER_CACHE;
+	if (aspath->refcnt && aspath->filter_id[slot] == aslist->id)
+		return aspath->filter_result[slot];
+
 	for (asfilter = aslist->head; asfilter; asfilter = asfilter->next) {
-		if (as_filter_match(asfilter, aspath))
-			return asfilter->type;
+		if (as_filter_match(asfilter, aspath)) {
+			type = asfilter->type;
+			break;
+		}
+	}
+
+	/* other pthreads may be looking at the same slot */
+	if (aspath->refcnt && !bgp_worker_pool_busy()) {
+		aspath->filter_id[slot] = aslist->id;
+		aspath->filter_result[slot] = type;
 	}
-	return AS_FILTER_DENY;
+	return type;
 }
 
 /* Add hook function. */
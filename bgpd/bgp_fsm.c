@@ -27,7 +27,6 @@
 #include "thread.h"
 #include "log.h"
 #include "stream.h"
-#include "ringbuf.h"
 #include "memory.h"
 #include "plist.h"
 #include "workqueue.h"
@@ -230,9 +229,9 @@ static struct peer *peer_xfer_conn(struct peer *from_peer)
 			stream_fifo_push(peer->ibuf,
 					 stream_fifo_pop(from_peer->ibuf));
 
-		ringbuf_wipe(peer->ibuf_work);
-		ringbuf_copy(peer->ibuf_work, from_peer->ibuf_work,
-			     ringbuf_remain(from_peer->ibuf_work));
+		bgp_ibuf_work_wipe(peer);
+		stream_put(peer->ibuf_work, stream_pnt(from_peer->ibuf_work),
+			   STREAM_READABLE(from_peer->ibuf_work));
 	}
 
 	peer->as = from_peer->as;
@@ -416,8 +415,9 @@ void bgp_timer_set(struct peer *peer)
 		BGP_TIMER_OFF(peer->t_start);
 		BGP_TIMER_OFF(peer->t_connect);
 		if (peer->v_holdtime != 0) {
-			BGP_TIMER_ON(peer->t_holdtime, bgp_holdtime_timer,
-				     peer->v_holdtime);
+			BGP_TIMER_ON_URGENT(peer->t_holdtime,
+					    bgp_holdtime_timer,
+					    peer->v_holdtime);
 		} else {
 			BGP_TIMER_OFF(peer->t_holdtime);
 		}
@@ -437,8 +437,9 @@ void bgp_timer_set(struct peer *peer)
 			BGP_TIMER_OFF(peer->t_holdtime);
 			bgp_keepalives_off(peer);
 		} else {
-			BGP_TIMER_ON(peer->t_holdtime, bgp_holdtime_timer,
-				     peer->v_holdtime);
+			BGP_TIMER_ON_URGENT(peer->t_holdtime,
+					    bgp_holdtime_timer,
+					    peer->v_holdtime);
 			bgp_keepalives_on(peer);
 		}
 		BGP_TIMER_OFF(peer->t_routeadv);
@@ -458,8 +459,9 @@ void bgp_timer_set(struct peer *peer)
 			BGP_TIMER_OFF(peer->t_holdtime);
 			bgp_keepalives_off(peer);
 		} else {
-			BGP_TIMER_ON(peer->t_holdtime, bgp_holdtime_timer,
-				     peer->v_holdtime);
+			BGP_TIMER_ON_URGENT(peer->t_holdtime,
+					    bgp_holdtime_timer,
+					    peer->v_holdtime);
 			bgp_keepalives_on(peer);
 		}
 		break;
@@ -556,8 +558,8 @@ static int bgp_holdtime_timer(struct thread *thread)
 	inq_count = atomic_load_explicit(&peer->ibuf->count,
 					 memory_order_relaxed);
 	if (inq_count) {
-		BGP_TIMER_ON(peer->t_holdtime, bgp_holdtime_timer,
-			     peer->v_holdtime);
+		BGP_TIMER_ON_URGENT(peer->t_holdtime, bgp_holdtime_timer,
+				    peer->v_holdtime);
 
 		return 0;
 	}
@@ -1362,7 +1364,7 @@ int bgp_stop(struct peer *peer)
 			stream_fifo_clean(peer->obuf);
 
 		if (peer->ibuf_work)
-			ringbuf_wipe(peer->ibuf_work);
+			bgp_ibuf_work_wipe(peer);
 		if (peer->obuf_work)
 			stream_reset(peer->obuf_work);
 
@@ -29,6 +29,16 @@
 			thread_add_timer(bm->master, (F), peer, (V), &(T));    \
 	} while (0)
 
+/* Same, for timers that must not be held up by route processing */
+#define BGP_TIMER_ON_URGENT(T, F, V)                                           \
+	do {                                                                   \
+		if ((peer->status != Deleted)) {                               \
+			thread_add_timer(bm->master, (F), peer, (V), &(T));    \
+			if ((T))                                               \
+				thread_set_priority((T), THREAD_PRIO_URGENT);  \
+		}                                                              \
+	} while (0)
+
 #define BGP_TIMER_OFF(T)                                                       \
 	do {                                                                   \
 		THREAD_OFF((T));					       \
@@ -24,13 +24,13 @@
 #include <pthread.h>		// for pthread_mutex_unlock, pthread_mutex_lock
 #include <sys/uio.h>		// for writev
 
+#include "convergence.h"		// for conv_get_rate, conv_now
 #include "frr_pthread.h"
 #include "linklist.h"		// for list_delete, list_delete_all_node, lis...
 #include "log.h"		// for zlog_debug, safe_strerror, zlog_err
 #include "memory.h"		// for MTYPE_TMP, XCALLOC, XFREE
 #include "network.h"		// for ERRNO_IO_RETRY
 #include "stream.h"		// for stream_get_endp, stream_getw_from, str...
-#include "ringbuf.h"		// for ringbuf_remain, ringbuf_peek, ringbuf_...
 #include "thread.h"		// for THREAD_OFF, THREAD_ARG, thread...
 
 #include "bgpd/bgp_io.h"
@@ -180,6 +180,7 @@ static int bgp_process_reads(struct thread *thread)
 	bool fatal = false;		// whether fatal error occurred
 	bool added_pkt = false;		// whether we pushed onto ->ibuf
 	int code = 0;			// FSM code if error occurred
+	int64_t rx_time = 0;		// for convergence sampling
 	/* clang-format on */
 
 	peer = THREAD_ARG(thread);
@@ -193,6 +194,9 @@ static int bgp_process_reads(struct thread *thread)
 		status = bgp_read(peer, &code);
 	}
 
+	if (conv_get_rate(bm->conv))
+		rx_time = conv_now();
+
 	/* error checking phase */
 	if (CHECK_FLAG(status, BGP_IO_TRANS_ERR)) {
 		/* no problem; just don't process packets */
@@ -212,14 +216,13 @@ static int bgp_process_reads(struct thread *thread)
 	}
 
 	while (more) {
-		/* static buffer for transferring packets */
 		/* shorter alias to peer's input buffer */
-		struct ringbuf *ibw = peer->ibuf_work;
+		struct stream *ibw = peer->ibuf_work;
 		/* packet size as given by header */
 		uint16_t pktsize = 0;
 
 		/* check that we have enough data for a header */
-		if (ringbuf_remain(ibw) < BGP_HEADER_SIZE)
+		if (STREAM_READABLE(ibw) < BGP_HEADER_SIZE)
 			break;
 
 		/* check that header is valid */
@@ -229,23 +232,22 @@ static int bgp_process_reads(struct thread *thread)
 		}
 
 		/* header is valid; retrieve packet size */
-		ringbuf_peek(ibw, BGP_MARKER_SIZE, &pktsize, sizeof(pktsize));
-
-		pktsize = ntohs(pktsize);
+		pktsize = stream_getw_from(ibw, stream_get_getp(ibw)
+							+ BGP_MARKER_SIZE);
 
 		/* if this fails we are seriously screwed */
 		assert(pktsize <= peer->max_packet_size);
 
 		/*
-		 * If we have that much data, chuck it into its own
-		 * stream and append to input queue for processing.
+		 * If we have that much data, hand out a slice of the read
+		 * buffer and append it to the input queue for processing.
 		 */
-		if (ringbuf_remain(ibw) >= pktsize) {
-			struct stream *pkt = stream_new(pktsize);
+		if (STREAM_READABLE(ibw) >= pktsize) {
+			struct stream *pkt = stream_slice(
+				ibw, stream_get_getp(ibw), pktsize);
 
-			assert(STREAM_WRITEABLE(pkt) == pktsize);
-			assert(ringbuf_get(ibw, pkt->data, pktsize) == pktsize);
-			stream_set_endp(pkt, pktsize);
+			stream_forward_getp(ibw, pktsize);
+			pkt->rx_time = rx_time;
 
 			frrtrace(2, frr_bgp, packet_read, peer, pkt);
 			frr_with_mutex(&peer->io_mtx) {
@@ -260,9 +262,13 @@ static int bgp_process_reads(struct thread *thread)
 	/* handle invalid header */
 	if (fatal) {
 		/* wipe buffer just in case someone screwed up */
-		ringbuf_wipe(peer->ibuf_work);
+		frr_with_mutex(&peer->io_mtx) {
+			bgp_ibuf_work_wipe(peer);
+		}
 	} else {
-		assert(ringbuf_space(peer->ibuf_work) >= peer->max_packet_size);
+		frr_with_mutex(&peer->io_mtx) {
+			bgp_ibuf_work_reserve(peer);
+		}
 
 		thread_add_read(fpt->master, bgp_process_reads, peer, peer->fd,
 				&peer->t_read);
@@ -451,6 +457,43 @@ done : {
 	return status;
 }
 
+/*
+ * Make sure there's room for at least one more full packet at the end of
+ * peer->ibuf_work.  The buffer is only reused if none of the packets
+ * sliced out of it are still around; otherwise the partial packet at its
+ * end is moved to a fresh one and the old one goes away with its last
+ * slice.
+ *
+ * Must be called with peer->io_mtx held.
+ */
+void bgp_ibuf_work_reserve(struct peer *peer)
+{
+	struct stream *ibw = peer->ibuf_work;
+	struct stream *snew;
+
+	if (STREAM_WRITEABLE(ibw) >= peer->max_packet_size)
+		return;
+
+	if (!stream_is_shared(ibw)) {
+		stream_pulldown(ibw);
+		return;
+	}
+
+	snew = stream_new(BGP_READ_CHUNK_SIZE);
+	stream_put(snew, stream_pnt(ibw), STREAM_READABLE(ibw));
+	stream_free(ibw);
+	peer->ibuf_work = snew;
+}
+
+void bgp_ibuf_work_wipe(struct peer *peer)
+{
+	if (stream_is_shared(peer->ibuf_work)) {
+		stream_free(peer->ibuf_work);
+		peer->ibuf_work = stream_new(BGP_READ_CHUNK_SIZE);
+	} else
+		stream_reset(peer->ibuf_work);
+}
+
 /*
  * Reads a chunk of data from peer->fd into peer->ibuf_work.
  *
@@ -465,9 +508,12 @@ static uint16_t bgp_read(struct peer *peer, int *code_p)
 	ssize_t nbytes;  // how many bytes we actually read
 	uint16_t status = 0;
 
-	readsize =
-		MIN(ringbuf_space(peer->ibuf_work), sizeof(peer->ibuf_scratch));
-	nbytes = read(peer->fd, peer->ibuf_scratch, readsize);
+	/* straight into the buffer packets are sliced out of */
+	readsize = STREAM_WRITEABLE(peer->ibuf_work);
+	nbytes = read(peer->fd,
+		      STREAM_DATA(peer->ibuf_work)
+			      + stream_get_endp(peer->ibuf_work),
+		      readsize);
 
 	/* EAGAIN or EWOULDBLOCK; come back later */
 	if (nbytes < 0 && ERRNO_IO_RETRY(errno)) {
@@ -496,8 +542,7 @@ static uint16_t bgp_read(struct peer *peer, int *code_p)
 
 		SET_FLAG(status, BGP_IO_FATAL_ERR);
 	} else {
-		assert(ringbuf_put(peer->ibuf_work, peer->ibuf_scratch, nbytes)
-		       == (size_t)nbytes);
+		stream_forward_endp(peer->ibuf_work, nbytes);
 	}
 
 	return status;
@@ -514,27 +559,25 @@ static bool validate_header(struct peer *peer)
 {
 	uint16_t size;
 	uint8_t type;
-	struct ringbuf *pkt = peer->ibuf_work;
+	struct stream *pkt = peer->ibuf_work;
+	size_t getp = stream_get_getp(pkt);
 
 	static const uint8_t m_correct[BGP_MARKER_SIZE] = {
 		0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff,
 		0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff};
-	uint8_t m_rx[BGP_MARKER_SIZE] = {0x00};
 
-	if (ringbuf_peek(pkt, 0, m_rx, BGP_MARKER_SIZE) != BGP_MARKER_SIZE)
+	if (STREAM_READABLE(pkt) < BGP_HEADER_SIZE)
 		return false;
 
-	if (memcmp(m_correct, m_rx, BGP_MARKER_SIZE) != 0) {
+	if (memcmp(m_correct, stream_pnt(pkt), BGP_MARKER_SIZE) != 0) {
 		bgp_notify_send(peer, BGP_NOTIFY_HEADER_ERR,
 				BGP_NOTIFY_HEADER_NOT_SYNC);
 		return false;
 	}
 
-	/* Get size and type in network byte order. */
-	ringbuf_peek(pkt, BGP_MARKER_SIZE, &size, sizeof(size));
-	ringbuf_peek(pkt, BGP_MARKER_SIZE + 2, &type, sizeof(type));
-
-	size = ntohs(size);
+	/* Get size and type. */
+	size = stream_getw_from(pkt, getp + BGP_MARKER_SIZE);
+	type = stream_getc_from(pkt, getp + BGP_MARKER_SIZE + 2);
 
 	/* BGP type check. */
 	if (type != BGP_MSG_OPEN && type != BGP_MSG_UPDATE
@@ -25,6 +25,9 @@
 #define BGP_WRITE_PACKET_MAX 64U
 #define BGP_READ_PACKET_MAX  10U
 
+/* size of the buffer received packets are sliced out of */
+#define BGP_READ_CHUNK_SIZE (BGP_MAX_PACKET_SIZE * BGP_READ_PACKET_MAX)
+
 #include "bgpd/bgpd.h"
 #include "frr_pthread.h"
 
@@ -100,4 +103,26 @@ extern void bgp_reads_on(struct peer *peer);
  */
 extern void bgp_reads_off(struct peer *peer);
 
+/**
+ * Makes sure peer->ibuf_work has room for another full packet.
+ *
+ * Packets handed to peer->ibuf are slices of peer->ibuf_work, so it is only
+ * compacted in place if none of them are still waiting to be processed.
+ * Otherwise the unparsed tail is moved to a new buffer.
+ *
+ * Must be called with peer->io_mtx held.
+ *
+ * @param peer - peer whose read buffer to check
+ */
+extern void bgp_ibuf_work_reserve(struct peer *peer);
+
+/**
+ * Discards whatever is in peer->ibuf_work.
+ *
+ * Must be called with peer->io_mtx held.
+ *
+ * @param peer - peer whose read buffer to wipe
+ */
+extern void bgp_ibuf_work_wipe(struct peer *peer);
+
 #endif /* _FRR_BGP_IO_H */
@@ -29,6 +29,7 @@
 #include "log.h"		// for zlog_debug
 #include "memory.h"		// for MTYPE_TMP, XFREE, XCALLOC, XMALLOC
 #include "monotime.h"		// for monotime, monotime_since
+#include "typesafe.h"		// for PREDECL_HEAP, DECLARE_HEAP
 
 #include "bgpd/bgpd.h"          // for peer, PEER_THREAD_KEEPALIVES_ON, peer...
 #include "bgpd/bgp_debug.h"	// for bgp_debug_neighbor_events
@@ -36,98 +37,129 @@
 #include "bgpd/bgp_keepalives.h"
 /* clang-format on */
 
+PREDECL_HEAP(pkat_due);
+
 /*
  * Peer KeepAlive Timer.
- * Associates a peer with the time of its last keepalive.
+ * Associates a peer with the time its next keepalive is due.
  */
 struct pkat {
 	/* the peer to send keepalives to */
 	struct peer *peer;
-	/* absolute time of last keepalive sent */
-	struct timeval last;
+	/* absolute time the next keepalive is due */
+	struct timeval due;
+
+	struct pkat_due_item due_item;
 };
 
-/* List of peers we are sending keepalives for, and associated mutex. */
+static int pkat_due_cmp(const struct pkat *a, const struct pkat *b)
+{
+	if (timercmp(&a->due, &b->due, <))
+		return -1;
+	if (timercmp(&a->due, &b->due, >))
+		return 1;
+	return 0;
+}
+
+DECLARE_HEAP(pkat_due, struct pkat, due_item, pkat_due_cmp);
+
+/*
+ * List of peers we are sending keepalives for, and associated mutex.  The
+ * hash is for finding a peer's entry, the heap has the same entries ordered
+ * by when their next keepalive is due.
+ */
 static pthread_mutex_t *peerhash_mtx;
 static pthread_cond_t *peerhash_cond;
 static struct hash *peerhash;
+static struct pkat_due_head pkat_due_heap;
 
 static struct pkat *pkat_new(struct peer *peer)
 {
-	struct pkat *pkat = XMALLOC(MTYPE_TMP, sizeof(struct pkat));
+	struct pkat *pkat = XCALLOC(MTYPE_TMP, sizeof(struct pkat));
+	uint32_t v_ka = atomic_load_explicit(&peer->v_keepalive,
+					     memory_order_relaxed);
+
 	pkat->peer = peer;
-	monotime(&pkat->last);
+	monotime(&pkat->due);
+	pkat->due.tv_sec += v_ka;
+	pkat_due_add(&pkat_due_heap, pkat);
 	return pkat;
 }
 
-static void pkat_del(void *pkat)
+static void pkat_del(void *arg)
 {
+	struct pkat *pkat = arg;
+
+	pkat_due_del(&pkat_due_heap, pkat);
 	XFREE(MTYPE_TMP, pkat);
 }
 
 
 /*
- * Callback for hash_iterate. Determines if a peer needs a keepalive and if so,
- * generates and sends it.
- *
- * For any given peer, if the elapsed time since its last keepalive exceeds its
- * configured keepalive timer, a keepalive is sent to the peer and its
- * last-sent time is reset. Additionally, If the elapsed time does not exceed
- * the configured keepalive timer, but the time until the next keepalive is due
- * is within a hardcoded tolerance, a keepalive is sent as if the configured
- * timer was exceeded. Doing this helps alleviate nanosecond sleeps between
- * ticks by grouping together peers who are due for keepalives at roughly the
- * same time. This tolerance value is arbitrarily chosen to be 100ms.
+ * Sends a keepalive to a peer that is due for one, and works out when the
+ * next one is due.
  *
- * In addition, this function calculates the maximum amount of time that the
- * keepalive thread can sleep before another tick needs to take place. This is
- * equivalent to shortest time until a keepalive is due for any one peer.
- *
- * @return maximum time to wait until next update (0 if infinity)
+ * The deadline is computed from the keepalive timer when the previous
+ * keepalive is sent, so a changed timer takes effect from the next keepalive
+ * on.  A peer with a 0 keepalive timer gets no keepalives, but is looked at
+ * again after a second in case that changes.
  */
-static void peer_process(struct hash_bucket *hb, void *arg)
+static void peer_process(struct pkat *pkat, const struct timeval *now)
 {
-	struct pkat *pkat = hb->data;
-
-	struct timeval *next_update = arg;
-
-	static struct timeval elapsed;  // elapsed time since keepalive
-	static struct timeval ka = {0}; // peer->v_keepalive as a timeval
-	static struct timeval diff;     // ka - elapsed
-
-	static const struct timeval tolerance = {0, 100000};
+	struct timeval ka = {0}; // peer->v_keepalive as a timeval
 
 	uint32_t v_ka = atomic_load_explicit(&pkat->peer->v_keepalive,
 					     memory_order_relaxed);
 
 	/* 0 keepalive timer means no keepalives */
-	if (v_ka == 0)
+	if (v_ka == 0) {
+		ka.tv_sec = 1;
+		timeradd(now, &ka, &pkat->due);
 		return;
+	}
+
+	if (bgp_debug_neighbor_events(pkat->peer))
+		zlog_debug("%s [FSM] Timer (keepalive timer expire)",
+			   pkat->peer->host);
 
-	/* calculate elapsed time since last keepalive */
-	monotime_since(&pkat->last, &elapsed);
+	bgp_keepalive_send(pkat->peer);
 
-	/* calculate difference between elapsed time and configured time */
 	ka.tv_sec = v_ka;
-	timersub(&ka, &elapsed, &diff);
+	timeradd(now, &ka, &pkat->due);
+}
+
+/*
+ * Sends keepalives to all peers that are due, taking them off the front of the
+ * heap, so only the peers that are due are looked at.
+ *
+ * If the time until the next keepalive is due is within a hardcoded tolerance,
+ * a keepalive is sent as if the configured timer was exceeded. Doing this
+ * helps alleviate nanosecond sleeps between ticks by grouping together peers
+ * who are due for keepalives at roughly the same time. This tolerance value is
+ * arbitrarily chosen to be 100ms.
+ *
+ * In addition, this function calculates the absolute time until which the
+ * keepalive thread can sleep before another tick needs to take place. This is
+ * when the keepalive is due for the peer now at the front of the heap.
+ */
+static void peers_process(const struct timeval *now,
+			  struct timeval *next_update)
+{
+	static const struct timeval tolerance = {0, 100000};
 
-	int send_keepalive =
-		elapsed.tv_sec >= ka.tv_sec || timercmp(&diff, &tolerance, <);
+	struct timeval limit;
+	struct pkat *pkat;
 
-	if (send_keepalive) {
-		if (bgp_debug_neighbor_events(pkat->peer))
-			zlog_debug("%s [FSM] Timer (keepalive timer expire)",
-				   pkat->peer->host);
+	timeradd(now, &tolerance, &limit);
 
-		bgp_keepalive_send(pkat->peer);
-		monotime(&pkat->last);
-		memset(&elapsed, 0x00, sizeof(struct timeval));
-		diff = ka;
+	while ((pkat = pkat_due_first(&pkat_due_heap))
+	       && timercmp(&pkat->due, &limit, <)) {
+		pkat_due_pop(&pkat_due_heap);
+		peer_process(pkat, now);
+		pkat_due_add(&pkat_due_heap, pkat);
 	}
 
-	/* if calculated next update for this peer < current delay, use it */
-	if (next_update->tv_sec < 0 || timercmp(&diff, next_update, <))
-		*next_update = diff;
+	*next_update = pkat ? pkat->due : *now;
 }
 
 static bool peer_hash_cmp(const void *f, const void *s)
@@ -153,6 +185,7 @@ static void bgp_keepalives_finish(void *arg)
 	}
 
 	peerhash = NULL;
+	pkat_due_fini(&pkat_due_heap);
 
 	pthread_mutex_unlock(peerhash_mtx);
 	pthread_mutex_destroy(peerhash_mtx);
@@ -171,7 +204,6 @@ void *bgp_keepalives_start(void *arg)
 	fpt->master->owner = pthread_self();
 
 	struct timeval currtime = {0, 0};
-	struct timeval aftertime = {0, 0};
 	struct timeval next_update = {0, 0};
 	struct timespec next_update_ts = {0, 0};
 
@@ -196,6 +228,7 @@ void *bgp_keepalives_start(void *arg)
 
 	/* initialize peer hashtable */
 	peerhash = hash_create_size(2048, peer_hash_key, peer_hash_cmp, NULL);
+	pkat_due_init(&pkat_due_heap);
 	pthread_mutex_lock(peerhash_mtx);
 
 	/* register cleanup handler */
@@ -216,15 +249,7 @@ void *bgp_keepalives_start(void *arg)
 
 		monotime(&currtime);
 
-		next_update.tv_sec = -1;
-
-		hash_iterate(peerhash, peer_process, &next_update);
-		if (next_update.tv_sec == -1)
-			memset(&next_update, 0x00, sizeof(next_update));
-
-		monotime_since(&currtime, &aftertime);
-
-		timeradd(&currtime, &next_update, &next_update);
+		peers_process(&currtime, &next_update);
 		TIMEVAL_TO_TIMESPEC(&next_update, &next_update_ts);
 	}
 
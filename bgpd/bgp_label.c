@@ -42,9 +42,78 @@
 
 extern struct zclient *zclient;
 
-int bgp_parse_fec_update(void)
+/*
+ * FEC (un)registrations queued for zebra; zebra takes any number of FECs in
+ * one ZEBRA_FEC_REGISTER or ZEBRA_FEC_UNREGISTER message.
+ */
+static struct {
+	struct stream *s;
+	int command;
+	struct thread *t_flush;
+} fec_batch;
+
+/* the largest FEC entry: flags, family, prefix length, prefix and label */
+#define FEC_ENTRY_MAX (2 + 2 + 1 + IPV6_MAX_BYTELEN + 4)
+
+static void bgp_fec_batch_flush(void)
+{
+	struct stream *s = fec_batch.s;
+
+	if (!s || stream_get_endp(s) <= ZEBRA_HEADER_SIZE)
+		return;
+
+	if (zclient && zclient->sock >= 0) {
+		stream_putw_at(s, 0, stream_get_endp(s));
+		stream_reset(zclient->obuf);
+		stream_put(zclient->obuf, STREAM_DATA(s), stream_get_endp(s));
+		zclient_send_message(zclient);
+	}
+	stream_reset(s);
+}
+
+static int bgp_fec_batch_flush_event(struct thread *thread)
+{
+	bgp_fec_batch_flush();
+	return 0;
+}
+
+/* Start a FEC entry in the batch, for the given command */
+static struct stream *bgp_fec_batch_get(int command)
 {
 	struct stream *s;
+
+	if (!fec_batch.s)
+		fec_batch.s = stream_new(ZEBRA_MAX_PACKET_SIZ);
+	s = fec_batch.s;
+
+	if (stream_get_endp(s) > ZEBRA_HEADER_SIZE
+	    && (fec_batch.command != command
+		|| STREAM_WRITEABLE(s) < FEC_ENTRY_MAX))
+		bgp_fec_batch_flush();
+
+	if (stream_get_endp(s) == 0) {
+		zclient_create_header(s, command, VRF_DEFAULT);
+		fec_batch.command = command;
+	}
+
+	thread_add_event(bm->master, bgp_fec_batch_flush_event, NULL, 0,
+			 &fec_batch.t_flush);
+	return s;
+}
+
+void bgp_label_finish(void)
+{
+	THREAD_OFF(fec_batch.t_flush);
+	if (fec_batch.s)
+		stream_free(fec_batch.s);
+	fec_batch.s = NULL;
+}
+
+/* zebra sends the label bindings of a registration in bulk, see
+ * zebra_mpls_fec_batch_begin()
+ */
+static int bgp_parse_fec_entry(struct stream *s)
+{
 	struct bgp_dest *dest;
 	struct bgp *bgp;
 	struct bgp_table *table;
@@ -53,13 +122,13 @@ int bgp_parse_fec_update(void)
 	afi_t afi;
 	safi_t safi;
 
-	s = zclient->ibuf;
-
 	memset(&p, 0, sizeof(struct prefix));
-	p.family = stream_getw(s);
-	p.prefixlen = stream_getc(s);
-	stream_get(p.u.val, s, PSIZE(p.prefixlen));
-	label = stream_getl(s);
+	STREAM_GETW(s, p.family);
+	STREAM_GETC(s, p.prefixlen);
+	if (p.prefixlen > sizeof(p.u.val) * 8)
+		return -1;
+	STREAM_GET(p.u.val, s, PSIZE(p.prefixlen));
+	STREAM_GETL(s, label);
 
 	/* hack for the bgp instance & SAFI = have to send/receive it */
 	afi = family2afi(p.family);
@@ -92,6 +161,23 @@ int bgp_parse_fec_update(void)
 	bgp_process(bgp, dest, afi, safi);
 	bgp_dest_unlock_node(dest);
 	return 1;
+
+stream_failure:
+	return -2;
+}
+
+int bgp_parse_fec_update(void)
+{
+	struct stream *s = zclient->ibuf;
+	int ret = 0;
+
+	while (STREAM_READABLE(s)) {
+		ret = bgp_parse_fec_entry(s);
+		/* can't find the next entry after a malformed one */
+		if (ret == -2)
+			return -1;
+	}
+	return ret;
 }
 
 mpls_label_t bgp_adv_label(struct bgp_dest *dest, struct bgp_path_info *pi,
@@ -146,10 +232,8 @@ static void bgp_send_fec_register_label_msg(struct bgp_dest *dest, bool reg,
 	/* If the route node has a local_label assigned or the
 	 * path node has an MPLS SR label index allowing zebra to
 	 * derive the label, proceed with registration. */
-	s = zclient->obuf;
-	stream_reset(s);
 	command = (reg) ? ZEBRA_FEC_REGISTER : ZEBRA_FEC_UNREGISTER;
-	zclient_create_header(s, command, VRF_DEFAULT);
+	s = bgp_fec_batch_get(command);
 	flags_pos = stream_get_endp(s); /* save position of 'flags' */
 	stream_putw(s, flags);		/* initial flags */
 	stream_putw(s, PREFIX_FAMILY(p));
@@ -167,16 +251,11 @@ static void bgp_send_fec_register_label_msg(struct bgp_dest *dest, bool reg,
 	} else
 		UNSET_FLAG(dest->flags, BGP_NODE_REGISTERED_FOR_LABEL);
 
-	/* Set length and flags */
-	stream_putw_at(s, 0, stream_get_endp(s));
-
 	/*
 	 * We only need to write new flags if this is a register
 	 */
 	if (reg)
 		stream_putw_at(s, flags_pos, flags);
-
-	zclient_send_message(zclient);
 }
 
 /**
@@ -35,6 +35,7 @@ extern int bgp_reg_for_label_callback(mpls_label_t new_label, void *labelid,
 extern void bgp_reg_dereg_for_label(struct bgp_dest *dest,
 				    struct bgp_path_info *pi, bool reg);
 extern int bgp_parse_fec_update(void);
+extern void bgp_label_finish(void);
 extern mpls_label_t bgp_adv_label(struct bgp_dest *dest,
 				  struct bgp_path_info *pi, struct peer *to,
 				  afi_t afi, safi_t safi);
@@ -47,8 +47,15 @@ extern struct zclient *zclient;
  */
 static struct labelpool *lp;
 
-/* request this many labels at a time from zebra */
-#define LP_CHUNK_SIZE	50
+/*
+ * request at least this many labels at a time from zebra, and then as many
+ * as we already have, up to LP_CHUNK_SIZE_MAX, so that a large number of
+ * allocations is served from a few chunks
+ */
+#define LP_CHUNK_SIZE		50
+#define LP_CHUNK_SIZE_MAX	16384
+
+#define LP_WORD_BITS		32
 
 DEFINE_MTYPE_STATIC(BGPD, BGP_LABEL_CHUNK, "BGP Label Chunk");
 DEFINE_MTYPE_STATIC(BGPD, BGP_LABEL_FIFO, "BGP Label FIFO item");
@@ -58,6 +65,9 @@ DEFINE_MTYPE_STATIC(BGPD, BGP_LABEL_CBQ, "BGP Dynamic Label Callback");
 struct lp_chunk {
 	uint32_t	first;
 	uint32_t	last;
+	uint32_t	nfree;
+	uint32_t	hint;		/* first word that may have a free label */
+	uint32_t	*inuse;		/* bitmap, 1 = allocated */
 };
 
 /*
@@ -90,6 +100,37 @@ struct lp_cbq_item {
 	bool		allocated;	/* false = lost */
 };
 
+static struct lp_chunk *lp_chunk_find(mpls_label_t label)
+{
+	struct listnode *node;
+	struct lp_chunk *chunk;
+
+	for (ALL_LIST_ELEMENTS_RO(lp->chunks, node, chunk))
+		if (label >= chunk->first && label <= chunk->last)
+			return chunk;
+	return NULL;
+}
+
+/* mark a label allocated from get_label_from_pool() as free again */
+static void lp_chunk_release(mpls_label_t label)
+{
+	struct lp_chunk *chunk = lp_chunk_find(label);
+	uint32_t idx, w;
+
+	if (!chunk)
+		return;
+
+	idx = label - chunk->first;
+	w = idx / LP_WORD_BITS;
+	if (!(chunk->inuse[w] & (1U << (idx % LP_WORD_BITS))))
+		return;
+
+	chunk->inuse[w] &= ~(1U << (idx % LP_WORD_BITS));
+	chunk->nfree++;
+	if (w < chunk->hint)
+		chunk->hint = w;
+}
+
 static wq_item_status lp_cbq_docallback(struct work_queue *wq, void *data)
 {
 	struct lp_cbq_item *lcbq = data;
@@ -141,6 +182,7 @@ static wq_item_status lp_cbq_docallback(struct work_queue *wq, void *data)
 							labelid, NULL);
 				}
 				skiplist_delete(lp->inuse, (void *)lbl, NULL);
+				lp_chunk_release(lbl);
 			}
 		}
 	}
@@ -160,7 +202,10 @@ static void lp_lcb_free(void *goner)
 
 static void lp_chunk_free(void *goner)
 {
-	XFREE(MTYPE_BGP_LABEL_CHUNK, goner);
+	struct lp_chunk *chunk = goner;
+
+	XFREE(MTYPE_BGP_LABEL_CHUNK, chunk->inuse);
+	XFREE(MTYPE_BGP_LABEL_CHUNK, chunk);
 }
 
 void bgp_lp_init(struct thread_master *master, struct labelpool *pool)
@@ -239,17 +284,31 @@ static mpls_label_t get_label_from_pool(void *labelid)
 	int debug = BGP_DEBUG(labelpool, LABELPOOL);
 
 	/*
-	 * Find a free label
-	 * Linear search is not efficient but should be executed infrequently.
+	 * Find a free label: the chunks are few, as they grow with the pool,
+	 * and each one keeps a bitmap of its allocated labels.
 	 */
 	for (ALL_LIST_ELEMENTS_RO(lp->chunks, node, chunk)) {
 		uintptr_t lbl;
+		uint32_t w;
 
 		if (debug)
-			zlog_debug("%s: chunk first=%u last=%u",
-				__func__, chunk->first, chunk->last);
+			zlog_debug("%s: chunk first=%u last=%u free=%u",
+				__func__, chunk->first, chunk->last,
+				chunk->nfree);
+
+		while (chunk->nfree) {
+			/* the bits past the last label are always set */
+			for (w = chunk->hint; chunk->inuse[w] == UINT32_MAX;
+			     w++)
+				;
+			chunk->hint = w;
+
+			lbl = chunk->first + w * LP_WORD_BITS
+			      + ffs(~chunk->inuse[w]) - 1;
+			chunk->inuse[w] |= 1U << ((lbl - chunk->first)
+						  % LP_WORD_BITS);
+			chunk->nfree--;
 
-		for (lbl = chunk->first; lbl <= chunk->last; ++lbl) {
 			/* labelid is key to all-request "ledger" list */
 			if (!skiplist_insert(lp->inuse, (void *)lbl, labelid)) {
 				/*
@@ -390,12 +449,25 @@ void bgp_lp_get(
 	lp_fifo_add_tail(&lp->requests, lf);
 
 	if (lp_fifo_count(&lp->requests) > lp->pending_count) {
+		uint32_t size;
+
 		if (!zclient || zclient->sock < 0)
 			return;
-		if (zclient_send_get_label_chunk(zclient, 0, LP_CHUNK_SIZE,
+
+		/*
+		 * Double the pool each time it runs out, which only depends
+		 * on how many labels were asked for so far.
+		 */
+		size = lp->label_count + lp->pending_count;
+		if (size < LP_CHUNK_SIZE)
+			size = LP_CHUNK_SIZE;
+		else if (size > LP_CHUNK_SIZE_MAX)
+			size = LP_CHUNK_SIZE_MAX;
+
+		if (zclient_send_get_label_chunk(zclient, 0, size,
 						 MPLS_LABEL_BASE_ANY)
 		    != ZCLIENT_SEND_FAILURE)
-			lp->pending_count += LP_CHUNK_SIZE;
+			lp->pending_count += size;
 	}
 }
 
@@ -412,6 +484,7 @@ void bgp_lp_release(
 
 			/* no longer in use */
 			skiplist_delete(lp->inuse, (void *)lbl, NULL);
+			lp_chunk_release(lbl);
 
 			/* no longer requested */
 			skiplist_delete(lp->ledger, labelid, NULL);
@@ -427,6 +500,7 @@ void bgp_lp_event_chunk(uint8_t keep, uint32_t first, uint32_t last)
 	struct lp_chunk *chunk;
 	int debug = BGP_DEBUG(labelpool, LABELPOOL);
 	struct lp_fifo *lf;
+	uint32_t size, words;
 
 	if (last < first) {
 		flog_err(EC_BGP_LABEL,
@@ -437,12 +511,24 @@ void bgp_lp_event_chunk(uint8_t keep, uint32_t first, uint32_t last)
 
 	chunk = XCALLOC(MTYPE_BGP_LABEL_CHUNK, sizeof(struct lp_chunk));
 
+	size = last - first + 1;
+	words = (size + LP_WORD_BITS - 1) / LP_WORD_BITS;
+
 	chunk->first = first;
 	chunk->last = last;
+	chunk->nfree = size;
+	chunk->inuse = XCALLOC(MTYPE_BGP_LABEL_CHUNK,
+			       words * sizeof(*chunk->inuse));
+	if (size % LP_WORD_BITS)
+		chunk->inuse[words - 1] = UINT32_MAX << (size % LP_WORD_BITS);
 
 	listnode_add(lp->chunks, chunk);
 
-	lp->pending_count -= (last - first + 1);
+	lp->label_count += size;
+	if (lp->pending_count > size)
+		lp->pending_count -= size;
+	else
+		lp->pending_count = 0;
 
 	if (debug) {
 		zlog_debug("%s: %zu pending requests", __func__,
@@ -567,6 +653,7 @@ void bgp_lp_event_zebra_up(void)
 	 * Invalidate current list of chunks
 	 */
 	list_delete_all_node(lp->chunks);
+	lp->label_count = 0;
 
 	/*
 	 * Invalidate any existing labels and requeue them as requests
@@ -40,6 +40,7 @@ struct labelpool {
 	struct lp_fifo_head	requests;	/* blocked on zebra */
 	struct work_queue	*callback_q;
 	uint32_t		pending_count;	/* requested from zebra */
+	uint32_t		label_count;	/* in chunks */
 	uint32_t reconnect_count;		/* zebra reconnections */
 };
 
@@ -27,11 +27,13 @@
 #include "filter.h"
 #include "jhash.h"
 #include "stream.h"
+#include "frr_pthread.h"
 
 #include "bgpd/bgpd.h"
 #include "bgpd/bgp_lcommunity.h"
 #include "bgpd/bgp_community_alias.h"
 #include "bgpd/bgp_aspath.h"
+#include "bgpd/bgp_textcache.h"
 
 /* Hash of community attribute. */
 static struct hash *lcomhash;
@@ -49,12 +51,23 @@ void lcommunity_free(struct lcommunity **lcom)
 		return;
 
 	XFREE(MTYPE_LCOMMUNITY_VAL, (*lcom)->val);
-	XFREE(MTYPE_LCOMMUNITY_STR, (*lcom)->str);
-	if ((*lcom)->json)
-		json_object_free((*lcom)->json);
+	frr_with_mutex(&bgp_text_mtx) {
+		bgp_text_forget(&(*lcom)->text);
+	}
+	lcommunity_text_drop(*lcom);
 	XFREE(MTYPE_LCOMMUNITY, *lcom);
 }
 
+/* Called by the text cache, see bgp_text_trim() */
+void lcommunity_text_drop(struct lcommunity *lcom)
+{
+	XFREE(MTYPE_LCOMMUNITY_STR, lcom->str);
+	if (lcom->json) {
+		json_object_free(lcom->json);
+		lcom->json = NULL;
+	}
+}
+
 static void lcommunity_hash_free(struct lcommunity *lcom)
 {
 	lcommunity_free(&lcom);
@@ -106,29 +119,46 @@ static bool lcommunity_add_val(struct lcommunity *lcom,
 /* This function takes pointer to Large Communites strucutre then
    create a new Large Communities structure by uniq and sort each
    Large Communities value.  */
+static int lcommunity_val_cmp(const void *a, const void *b)
+{
+	return memcmp(a, b, LCOMMUNITY_SIZE);
+}
+
 struct lcommunity *lcommunity_uniq_sort(struct lcommunity *lcom)
 {
-	int i;
+	int i, j;
 	struct lcommunity *new;
-	struct lcommunity_val *lval;
 
 	if (!lcom)
 		return NULL;
 
 	new = lcommunity_new();
+	if (!lcom->size)
+		return new;
 
-	for (i = 0; i < lcom->size; i++) {
-		lval = (struct lcommunity_val *)(lcom->val
-						 + (i * LCOMMUNITY_SIZE));
-		lcommunity_add_val(new, lval);
+	/* Sorting once keeps this O(n log n), where inserting one value at a
+	 * time with lcommunity_add_val() is quadratic in the size.
+	 */
+	new->val = XMALLOC(MTYPE_LCOMMUNITY_VAL, lcom_length(lcom));
+	memcpy(new->val, lcom->val, lcom_length(lcom));
+	qsort(new->val, lcom->size, LCOMMUNITY_SIZE, lcommunity_val_cmp);
+
+	for (i = 1, j = 0; i < lcom->size; i++) {
+		if (!memcmp(new->val + i * LCOMMUNITY_SIZE,
+			    new->val + j * LCOMMUNITY_SIZE, LCOMMUNITY_SIZE))
+			continue;
+		j++;
+		memcpy(new->val + j * LCOMMUNITY_SIZE,
+		       new->val + i * LCOMMUNITY_SIZE, LCOMMUNITY_SIZE);
 	}
+	new->size = j + 1;
 	return new;
 }
 
 /* Parse Large Communites Attribute in BGP packet.  */
 struct lcommunity *lcommunity_parse(uint8_t *pnt, unsigned short length)
 {
-	struct lcommunity tmp;
+	struct lcommunity tmp = {};
 	struct lcommunity *new;
 
 	/* Length check.  */
@@ -206,6 +236,7 @@ static void set_lcommunity_string(struct lcommunity *lcom, bool make_json)
 		}
 
 		lcom->str = str_buf;
+		bgp_text_touch(&lcom->text, BGP_TEXT_LCOMMUNITY, 0, make_json);
 		return;
 	}
 
@@ -246,7 +277,10 @@ static void set_lcommunity_string(struct lcommunity *lcom, bool make_json)
 				       json_lcommunity_list);
 	}
 
-	lcom->str = str_buf;
+	/* the scratch buffer is way too big to be cached */
+	len = strlen(str_buf);
+	lcom->str = XREALLOC(MTYPE_LCOMMUNITY_STR, str_buf, len + 1);
+	bgp_text_touch(&lcom->text, BGP_TEXT_LCOMMUNITY, len, make_json);
 }
 
 /* Intern Large Communities Attribute.  */
@@ -260,12 +294,14 @@ struct lcommunity *lcommunity_intern(struct lcommunity *lcom)
 
 	if (find != lcom)
 		lcommunity_free(&lcom);
+	else {
+		/* Interned communities are never modified. */
+		find->key = lcommunity_hash_make(find);
+		find->key_cached = true;
+	}
 
 	find->refcnt++;
 
-	if (!find->str)
-		set_lcommunity_string(find, false);
-
 	return find;
 }
 
@@ -293,11 +329,18 @@ char *lcommunity_str(struct lcommunity *lcom, bool make_json)
 	if (!lcom)
 		return NULL;
 
-	if (make_json && !lcom->json && lcom->str)
-		XFREE(MTYPE_LCOMMUNITY_STR, lcom->str);
+	frr_with_mutex(&bgp_text_mtx) {
+		if (make_json && !lcom->json && lcom->str) {
+			bgp_text_forget(&lcom->text);
+			XFREE(MTYPE_LCOMMUNITY_STR, lcom->str);
+		}
 
-	if (!lcom->str)
-		set_lcommunity_string(lcom, make_json);
+		if (!lcom->str)
+			set_lcommunity_string(lcom, make_json);
+		else
+			bgp_text_touch(&lcom->text, BGP_TEXT_LCOMMUNITY,
+				       strlen(lcom->str), !!lcom->json);
+	}
 
 	return lcom->str;
 }
@@ -308,6 +351,9 @@ unsigned int lcommunity_hash_make(const void *arg)
 	const struct lcommunity *lcom = arg;
 	int size = lcom_length(lcom);
 
+	if (lcom->key_cached)
+		return lcom->key;
+
 	return jhash(lcom->val, size, 0xab125423);
 }
 
@@ -557,19 +603,16 @@ void bgp_aggr_lcommunity_remove(void *arg)
 	lcommunity_free(&lcommunity);
 }
 
-void bgp_compute_aggregate_lcommunity(struct bgp_aggregate *aggregate,
-				      struct lcommunity *lcommunity)
-{
-
-	bgp_compute_aggregate_lcommunity_hash(aggregate, lcommunity);
-	bgp_compute_aggregate_lcommunity_val(aggregate);
-}
-
-void bgp_compute_aggregate_lcommunity_hash(struct bgp_aggregate *aggregate,
-					   struct lcommunity *lcommunity)
+/* Takes a reference on lcommunity for the aggregate.  If update is set and
+ * the aggregate has not seen some of its values yet, they are added to the
+ * aggregate's large community in place.
+ */
+static void bgp_aggr_lcommunity_ref(struct bgp_aggregate *aggregate,
+				    struct lcommunity *lcommunity, bool update)
 {
-
 	struct lcommunity *aggr_lcommunity = NULL;
+	uint8_t *p;
+	int c;
 
 	if ((aggregate == NULL) || (lcommunity == NULL))
 		return;
@@ -592,7 +635,75 @@ void bgp_compute_aggregate_lcommunity_hash(struct bgp_aggregate *aggregate,
 
 	/* Increment reference counter.
 	 */
-	aggr_lcommunity->refcnt++;
+	if (aggr_lcommunity->refcnt++ > 0)
+		return;
+
+	for (p = lcommunity->val, c = 0; c < lcommunity->size;
+	     p += LCOMMUNITY_SIZE, c++) {
+		if (!bgp_aggr_val_ref(&aggregate->lcommunity_val_hash, p,
+				      LCOMMUNITY_SIZE)
+		    || !update)
+			continue;
+
+		if (aggregate->lcommunity == NULL)
+			aggregate->lcommunity = lcommunity_new();
+		lcommunity_add_val(aggregate->lcommunity,
+				   (struct lcommunity_val *)p);
+	}
+}
+
+/* Drops a reference on lcommunity.  If update is set, the values no other
+ * route under the aggregate carries are removed from its large community.
+ */
+static void bgp_aggr_lcommunity_unref(struct bgp_aggregate *aggregate,
+				      struct lcommunity *lcommunity,
+				      bool update)
+{
+	struct lcommunity *aggr_lcommunity = NULL;
+	struct lcommunity *ret_lcomm = NULL;
+	uint8_t *p;
+	int c;
+
+	if ((!aggregate)
+	    || (!aggregate->lcommunity_hash)
+	    || (!lcommunity))
+		return;
+
+	/* Look-up the lcommunity in the hash.
+	 */
+	aggr_lcommunity = bgp_aggr_lcommunity_lookup(aggregate, lcommunity);
+	if (!aggr_lcommunity)
+		return;
+
+	aggr_lcommunity->refcnt--;
+	if (aggr_lcommunity->refcnt > 0)
+		return;
+
+	ret_lcomm = hash_release(aggregate->lcommunity_hash, aggr_lcommunity);
+	lcommunity_free(&ret_lcomm);
+
+	for (p = lcommunity->val, c = 0; c < lcommunity->size;
+	     p += LCOMMUNITY_SIZE, c++) {
+		if (bgp_aggr_val_unref(aggregate->lcommunity_val_hash, p,
+				       LCOMMUNITY_SIZE)
+		    && update && aggregate->lcommunity)
+			lcommunity_del_val(aggregate->lcommunity, p);
+	}
+
+	if (update && aggregate->lcommunity && !aggregate->lcommunity->size)
+		lcommunity_free(&aggregate->lcommunity);
+}
+
+void bgp_compute_aggregate_lcommunity(struct bgp_aggregate *aggregate,
+				      struct lcommunity *lcommunity)
+{
+	bgp_aggr_lcommunity_ref(aggregate, lcommunity, true);
+}
+
+void bgp_compute_aggregate_lcommunity_hash(struct bgp_aggregate *aggregate,
+					   struct lcommunity *lcommunity)
+{
+	bgp_aggr_lcommunity_ref(aggregate, lcommunity, false);
 }
 
 void bgp_compute_aggregate_lcommunity_val(struct bgp_aggregate *aggregate)
@@ -621,52 +732,11 @@ void bgp_compute_aggregate_lcommunity_val(struct bgp_aggregate *aggregate)
 void bgp_remove_lcommunity_from_aggregate(struct bgp_aggregate *aggregate,
 					  struct lcommunity *lcommunity)
 {
-	struct lcommunity *aggr_lcommunity = NULL;
-	struct lcommunity *ret_lcomm = NULL;
-
-	if ((!aggregate)
-	    || (!aggregate->lcommunity_hash)
-	    || (!lcommunity))
-		return;
-
-	/* Look-up the lcommunity in the hash.
-	 */
-	aggr_lcommunity = bgp_aggr_lcommunity_lookup(aggregate, lcommunity);
-	if (aggr_lcommunity) {
-		aggr_lcommunity->refcnt--;
-
-		if (aggr_lcommunity->refcnt == 0) {
-			ret_lcomm = hash_release(aggregate->lcommunity_hash,
-						 aggr_lcommunity);
-			lcommunity_free(&ret_lcomm);
-
-			bgp_compute_aggregate_lcommunity_val(aggregate);
-
-		}
-	}
+	bgp_aggr_lcommunity_unref(aggregate, lcommunity, true);
 }
 
 void bgp_remove_lcomm_from_aggregate_hash(struct bgp_aggregate *aggregate,
 					  struct lcommunity *lcommunity)
 {
-	struct lcommunity *aggr_lcommunity = NULL;
-	struct lcommunity *ret_lcomm = NULL;
-
-	if ((!aggregate)
-	    || (!aggregate->lcommunity_hash)
-	    || (!lcommunity))
-		return;
-
-	/* Look-up the lcommunity in the hash.
-	 */
-	aggr_lcommunity = bgp_aggr_lcommunity_lookup(aggregate, lcommunity);
-	if (aggr_lcommunity) {
-		aggr_lcommunity->refcnt--;
-
-		if (aggr_lcommunity->refcnt == 0) {
-			ret_lcomm = hash_release(aggregate->lcommunity_hash,
-						 aggr_lcommunity);
-			lcommunity_free(&ret_lcomm);
-		}
-	}
+	bgp_aggr_lcommunity_unref(aggregate, lcommunity, false);
 }
@@ -24,6 +24,7 @@
 #include "lib/json.h"
 #include "bgpd/bgp_route.h"
 #include "bgpd/bgp_clist.h"
+#include "bgpd/bgp_textcache.h"
 
 /* Large Communities value is twelve octets long.  */
 #define LCOMMUNITY_SIZE                        12
@@ -42,8 +43,15 @@ struct lcommunity {
 	/* Large Communities as a json object */
 	json_object *json;
 
-	/* Human readable format string.  */
+	/* Human readable format string, built on demand by lcommunity_str().
+	 * May be dropped again by the text cache.
+	 */
 	char *str;
+	struct bgp_text text;
+
+	/* Hash key, computed once when interned.  */
+	bool key_cached;
+	unsigned int key;
 };
 
 /* Large community value is 12 octets.  */
@@ -70,6 +78,7 @@ extern struct lcommunity *lcommunity_str2com(const char *);
 extern bool lcommunity_match(const struct lcommunity *,
 			     const struct lcommunity *);
 extern char *lcommunity_str(struct lcommunity *, bool make_json);
+extern void lcommunity_text_drop(struct lcommunity *lcom);
 extern bool lcommunity_include(struct lcommunity *lcom, uint8_t *ptr);
 extern void lcommunity_del_val(struct lcommunity *lcom, uint8_t *ptr);
 
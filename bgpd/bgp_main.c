@@ -67,11 +67,16 @@
 #include "bgpd/bgp_nht.h"
 #include "bgpd/bgp_routemap_nb.h"
 #include "bgpd/bgp_community_alias.h"
+#include "bgpd/bgp_textcache.h"
+#include "bgpd/bgp_rib_snapshot.h"
+#include "bgpd/bgp_label.h"
 
 #ifdef ENABLE_BGP_VNC
 #include "bgpd/rfapi/rfapi_backend.h"
 #endif
 
+#define OPTION_RIB_SNAPSHOT 2000
+
 /* bgpd options, we use GNU getopt library. */
 static const struct option longopts[] = {
 	{"bgp_port", required_argument, NULL, 'p'},
@@ -82,6 +87,7 @@ static const struct option longopts[] = {
 	{"int_num", required_argument, NULL, 'I'},
 	{"no_zebra", no_argument, NULL, 'Z'},
 	{"socket_size", required_argument, NULL, 's'},
+	{"rib-snapshot", required_argument, NULL, OPTION_RIB_SNAPSHOT},
 	{0}};
 
 /* signal definitions */
@@ -167,6 +173,9 @@ __attribute__((__noreturn__)) void sigint(void)
 	/* Disable BFD events to avoid wasting processing. */
 	bfd_protocol_integration_set_shutdown(true);
 
+	/* while the peers still have their paths */
+	bgp_rib_snapshot_write();
+
 	bgp_terminate();
 
 	bgp_exit(0);
@@ -230,6 +239,8 @@ static __attribute__((__noreturn__)) void bgp_exit(int status)
 
 	/* reverse bgp_attr_init */
 	bgp_attr_finish();
+	bgp_text_finish();
+	bgp_rib_snapshot_finish();
 
 	/* stop pthreads */
 	bgp_pthreads_finish();
@@ -259,10 +270,12 @@ static __attribute__((__noreturn__)) void bgp_exit(int status)
 	bgp_zebra_destroy();
 
 	bf_free(bm->rd_idspace);
+	conv_sampler_free(&bm->conv);
 	list_delete(&bm->bgp);
 	list_delete(&bm->addresses);
 
 	bgp_lp_finish();
+	bgp_label_finish();
 
 	memset(bm, 0, sizeof(*bm));
 
@@ -414,6 +427,7 @@ int main(int argc, char **argv)
 	int skip_runas = 0;
 	int instance = 0;
 	int buffer_size = BGP_SOCKET_SNDBUF_SIZE;
+	unsigned long rib_snapshot = 0;
 	char *address;
 	struct listnode *node;
 
@@ -429,7 +443,8 @@ int main(int argc, char **argv)
 		"  -S, --skip_runas   Skip capabilities checks, and changing user and group IDs.\n"
 		"  -e, --ecmp         Specify ECMP to use.\n"
 		"  -I, --int_num      Set instance number (label-manager)\n"
-		"  -s, --socket_size  Set BGP peer socket send buffer size\n");
+		"  -s, --socket_size  Set BGP peer socket send buffer size\n"
+		"      --rib-snapshot Interval in seconds for saving received paths for restarts\n");
 
 	/* Command line argument treatment. */
 	while (1) {
@@ -492,6 +507,14 @@ int main(int argc, char **argv)
 		case 's':
 			buffer_size = atoi(optarg);
 			break;
+		case OPTION_RIB_SNAPSHOT:
+			rib_snapshot = strtoul(optarg, NULL, 10);
+			if (rib_snapshot == 0) {
+				fprintf(stderr,
+					"RIB snapshot interval must be at least 1 second\n");
+				exit(1);
+			}
+			break;
 		default:
 			frr_help_exit(1);
 			break;
@@ -523,6 +546,7 @@ int main(int argc, char **argv)
 
 	/* BGP related initialization.  */
 	bgp_init((unsigned short)instance);
+	bgp_rib_snapshot_init(MIN(rib_snapshot, UINT_MAX));
 
 	if (list_isempty(bm->addresses)) {
 		snprintf(bgpd_di.startinfo, sizeof(bgpd_di.startinfo),
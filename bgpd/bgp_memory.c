@@ -59,6 +59,7 @@ DEFINE_MTYPE(BGPD, BGP_ADVERTISE, "BGP adv");
 DEFINE_MTYPE(BGPD, BGP_SYNCHRONISE, "BGP synchronise");
 DEFINE_MTYPE(BGPD, BGP_ADJ_IN, "BGP adj in");
 DEFINE_MTYPE(BGPD, BGP_ADJ_OUT, "BGP adj out");
+DEFINE_MTYPE(BGPD, BGP_ADJ_OUT_INDEX, "BGP adj out index");
 DEFINE_MTYPE(BGPD, BGP_MPATH_INFO, "BGP multipath info");
 
 DEFINE_MTYPE(BGPD, AS_LIST, "BGP AS list");
@@ -100,14 +101,18 @@ DEFINE_MTYPE(BGPD, PEER_UPDATE_SOURCE, "BGP peer update interface");
 DEFINE_MTYPE(BGPD, PEER_CONF_IF, "BGP peer config interface");
 DEFINE_MTYPE(BGPD, BGP_DAMP_INFO, "Dampening info");
 DEFINE_MTYPE(BGPD, BGP_DAMP_ARRAY, "BGP Dampening array");
-DEFINE_MTYPE(BGPD, BGP_DAMP_REUSELIST, "BGP Dampening reuse list");
 DEFINE_MTYPE(BGPD, BGP_REGEXP, "BGP regexp");
 DEFINE_MTYPE(BGPD, BGP_AGGREGATE, "BGP aggregate");
+DEFINE_MTYPE(BGPD, BGP_AGGREGATE_VAL, "BGP aggregate community value");
 DEFINE_MTYPE(BGPD, BGP_ADDR, "BGP own address");
 DEFINE_MTYPE(BGPD, TIP_ADDR, "BGP own tunnel-ip address");
 
 DEFINE_MTYPE(BGPD, BGP_REDIST, "BGP redistribution");
 DEFINE_MTYPE(BGPD, BGP_FILTER_NAME, "BGP Filter Information");
+DEFINE_MTYPE(BGPD, BGP_RMAP_MEMO, "BGP route-map memo");
+DEFINE_MTYPE(BGPD, BGP_SOFT_RECONFIG, "BGP soft reconfiguration batch");
+DEFINE_MTYPE(BGPD, BGP_SHOW_WALK, "BGP show walk");
+DEFINE_MTYPE(BGPD, BGP_VPN_IMPORT_RT, "BGP VPN import route-target");
 DEFINE_MTYPE(BGPD, BGP_DUMP_STR, "BGP Dump String Information");
 DEFINE_MTYPE(BGPD, ENCAP_TLV, "ENCAP TLV");
 
@@ -144,4 +149,5 @@ DEFINE_MTYPE(BGPD, BGP_SRV6_L3VPN, "BGP prefix-sid srv6 l3vpn servcie");
 DEFINE_MTYPE(BGPD, BGP_SRV6_VPN, "BGP prefix-sid srv6 vpn service");
 DEFINE_MTYPE(BGPD, BGP_SRV6_SID, "BGP srv6 segment-id");
 DEFINE_MTYPE(BGPD, BGP_SRV6_FUNCTION, "BGP srv6 function");
+DEFINE_MTYPE(BGPD, BGP_SRV6_LOCATOR_CHUNK, "BGP srv6 locator chunk");
 DEFINE_MTYPE(BGPD, EVPN_REMOTE_IP, "BGP EVPN Remote IP hash entry");
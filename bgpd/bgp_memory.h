@@ -55,6 +55,7 @@ DECLARE_MTYPE(BGP_ADVERTISE);
 DECLARE_MTYPE(BGP_SYNCHRONISE);
 DECLARE_MTYPE(BGP_ADJ_IN);
 DECLARE_MTYPE(BGP_ADJ_OUT);
+DECLARE_MTYPE(BGP_ADJ_OUT_INDEX);
 DECLARE_MTYPE(BGP_MPATH_INFO);
 
 DECLARE_MTYPE(AS_LIST);
@@ -96,14 +97,18 @@ DECLARE_MTYPE(PEER_UPDATE_SOURCE);
 DECLARE_MTYPE(PEER_CONF_IF);
 DECLARE_MTYPE(BGP_DAMP_INFO);
 DECLARE_MTYPE(BGP_DAMP_ARRAY);
-DECLARE_MTYPE(BGP_DAMP_REUSELIST);
 DECLARE_MTYPE(BGP_REGEXP);
 DECLARE_MTYPE(BGP_AGGREGATE);
+DECLARE_MTYPE(BGP_AGGREGATE_VAL);
 DECLARE_MTYPE(BGP_ADDR);
 DECLARE_MTYPE(TIP_ADDR);
 
 DECLARE_MTYPE(BGP_REDIST);
 DECLARE_MTYPE(BGP_FILTER_NAME);
+DECLARE_MTYPE(BGP_RMAP_MEMO);
+DECLARE_MTYPE(BGP_SOFT_RECONFIG);
+DECLARE_MTYPE(BGP_SHOW_WALK);
+DECLARE_MTYPE(BGP_VPN_IMPORT_RT);
 DECLARE_MTYPE(BGP_DUMP_STR);
 DECLARE_MTYPE(ENCAP_TLV);
 
@@ -141,6 +146,7 @@ DECLARE_MTYPE(BGP_SRV6_L3VPN);
 DECLARE_MTYPE(BGP_SRV6_VPN);
 DECLARE_MTYPE(BGP_SRV6_SID);
 DECLARE_MTYPE(BGP_SRV6_FUNCTION);
+DECLARE_MTYPE(BGP_SRV6_LOCATOR_CHUNK);
 
 DECLARE_MTYPE(EVPN_REMOTE_IP);
 
@@ -30,6 +30,8 @@
 #include "mpls.h"
 #include "json.h"
 #include "zclient.h"
+#include "jhash.h"
+#include "typesafe.h"
 
 #include "bgpd/bgpd.h"
 #include "bgpd/bgp_debug.h"
@@ -507,15 +509,35 @@ static void sid_register(struct bgp *bgp, const struct in6_addr *sid,
 	listnode_add(bgp->srv6_functions, func);
 }
 
-static bool sid_exist(struct bgp *bgp, const struct in6_addr *sid)
+/* The bits of a SID which alloc_new_sid() sets on top of its chunk */
+static uint16_t sid_function(const struct in6_addr *sid)
 {
-	struct listnode *node;
-	struct bgp_srv6_function *func;
+	return (sid->s6_addr[14] << 8) | sid->s6_addr[15];
+}
 
-	for (ALL_LIST_ELEMENTS_RO(bgp->srv6_functions, node, func))
-		if (sid_same(&func->sid, sid))
-			return true;
-	return false;
+static bool sid_exist(struct bgp_srv6_locator_chunk *chunk,
+		      const struct in6_addr *sid)
+{
+	return bf_test_index(chunk->functions, sid_function(sid));
+}
+
+struct bgp_srv6_locator_chunk *
+bgp_srv6_locator_chunk_new(const struct prefix_ipv6 *prefix)
+{
+	struct bgp_srv6_locator_chunk *chunk;
+
+	chunk = XCALLOC(MTYPE_BGP_SRV6_LOCATOR_CHUNK, sizeof(*chunk));
+	chunk->prefix = *prefix;
+	bf_init(chunk->functions, BGP_SRV6_CHUNK_FUNCTIONS);
+	/* The chunk prefix itself is never handed out */
+	bf_assign_zero_index(chunk->functions);
+	return chunk;
+}
+
+void bgp_srv6_locator_chunk_free(struct bgp_srv6_locator_chunk *chunk)
+{
+	bf_free(chunk->functions);
+	XFREE(MTYPE_BGP_SRV6_LOCATOR_CHUNK, chunk);
 }
 
 /*
@@ -526,7 +548,7 @@ static bool alloc_new_sid(struct bgp *bgp, uint32_t index,
 			  struct in6_addr *sid)
 {
 	struct listnode *node;
-	struct prefix_ipv6 *chunk;
+	struct bgp_srv6_locator_chunk *chunk;
 	struct in6_addr sid_buf;
 	bool alloced = false;
 
@@ -534,10 +556,10 @@ static bool alloc_new_sid(struct bgp *bgp, uint32_t index,
 		return false;
 
 	for (ALL_LIST_ELEMENTS_RO(bgp->srv6_locator_chunks, node, chunk)) {
-		sid_buf = chunk->prefix;
+		sid_buf = chunk->prefix.prefix;
 		if (index != 0) {
 			sid_buf.s6_addr[15] = index;
-			if (sid_exist(bgp, &sid_buf))
+			if (sid_exist(chunk, &sid_buf))
 				return false;
 			alloced = true;
 			break;
@@ -547,16 +569,19 @@ static bool alloc_new_sid(struct bgp *bgp, uint32_t index,
 			sid_buf.s6_addr[15] = (i & 0xff00) >> 8;
 			sid_buf.s6_addr[14] = (i & 0x00ff);
 
-			if (sid_exist(bgp, &sid_buf))
+			if (sid_exist(chunk, &sid_buf))
 				continue;
 			alloced = true;
 			break;
 		}
+		if (alloced)
+			break;
 	}
 
 	if (!alloced)
 		return false;
 
+	bf_set_bit(chunk->functions, sid_function(&sid_buf));
 	sid_register(bgp, &sid_buf, bgp->srv6_locator_name);
 	*sid = sid_buf;
 	return true;
@@ -618,25 +643,6 @@ void ensure_vrf_tovpn_sid(struct bgp *bgp_vpn, struct bgp *bgp_vrf, afi_t afi)
 	bgp_vrf->vpn_policy[afi].tovpn_sid = sid;
 }
 
-static bool ecom_intersect(struct ecommunity *e1, struct ecommunity *e2)
-{
-	uint32_t i, j;
-
-	if (!e1 || !e2)
-		return false;
-	for (i = 0; i < e1->size; ++i) {
-		for (j = 0; j < e2->size; ++j) {
-			if (!memcmp(e1->val + (i * e1->unit_size),
-				    e2->val + (j * e2->unit_size),
-				    e1->unit_size)) {
-
-				return true;
-			}
-		}
-	}
-	return false;
-}
-
 static bool labels_same(struct bgp_path_info *bpi, mpls_label_t *label,
 			uint32_t n)
 {
@@ -782,7 +788,8 @@ leak_update(struct bgp *bgp, /* destination bgp instance */
 			return NULL;
 		}
 
-		if (attrhash_cmp(bpi->attr, new_attr) && labelssame
+		if ((bpi->attr == new_attr || attrhash_cmp(bpi->attr, new_attr))
+		    && labelssame
 		    && !CHECK_FLAG(bpi->flags, BGP_PATH_REMOVED)) {
 
 			bgp_attr_unintern(&new_attr);
@@ -1355,69 +1362,137 @@ void vpn_leak_from_vrf_update_all(struct bgp *bgp_vpn, /* to */
 	}
 }
 
-static void
-vpn_leak_to_vrf_update_onevrf(struct bgp *bgp_vrf,	    /* to */
-			      struct bgp *bgp_vpn,	    /* from */
-			      struct bgp_path_info *path_vpn) /* route */
-{
-	const struct prefix *p = bgp_dest_get_prefix(path_vpn->net);
-	afi_t afi = family2afi(p->family);
-
-	struct attr static_attr = {0};
-	struct attr *new_attr = NULL;
-	struct bgp_dest *bn;
-	safi_t safi = SAFI_UNICAST;
-	const char *debugmsg;
+/*
+ * What leaking path_vpn has in common for all of the vrfs importing it,
+ * worked out once by vpn_leak_to_vrf_src_init() rather than for each vrf.
+ */
+struct vpn_leak_to_vrf_src {
+	struct bgp_path_info *path_vpn;
+	struct bgp *src_vrf;
 	struct prefix nexthop_orig;
-	mpls_label_t *pLabels = NULL;
-	uint32_t num_labels = 0;
-	int nexthop_self_flag = 1;
-	struct bgp_path_info *bpi_ultimate = NULL;
+
+	/* Labels to copy, unless the vrf is doing VRF-to-VRF leaking */
+	mpls_label_t *labels;
+	uint32_t num_labels;
+
+	/*
+	 * Interned attr for the vrfs without a FROMVPN route-map, by whether
+	 * they are doing VRF-to-VRF leaking.  The leaked paths all reference
+	 * the same one, NULL until the first needs it.
+	 */
+	struct attr *attr[2];
+};
+
+static void vpn_leak_to_vrf_src_init(struct vpn_leak_to_vrf_src *src,
+				     struct bgp *bgp_vpn,
+				     struct bgp_path_info *path_vpn)
+{
+	struct bgp_path_info *bpi_ultimate;
 	int origin_local = 0;
-	struct bgp *src_vrf;
 
-	int debug = BGP_DEBUG(vpn, VPN_LEAK_TO_VRF);
+	memset(src, 0, sizeof(*src));
+	src->path_vpn = path_vpn;
 
-	if (!vpn_leak_from_vpn_active(bgp_vrf, afi, &debugmsg)) {
-		if (debug)
-			zlog_debug("%s: skipping: %s", __func__, debugmsg);
-		return;
+	/*
+	 * Nexthop: stash
+	 *
+	 * Nexthop is valid in context of VPN core, but not in destination vrf.
+	 * Stash it for later label resolution by vrf ingress path.
+	 */
+	src->nexthop_orig.family =
+		NEXTHOP_FAMILY(path_vpn->attr->mp_nexthop_len);
+
+	switch (src->nexthop_orig.family) {
+	case AF_INET:
+		src->nexthop_orig.u.prefix4 =
+			path_vpn->attr->mp_nexthop_global_in;
+		src->nexthop_orig.prefixlen = IPV4_MAX_BITLEN;
+		break;
+	case AF_INET6:
+		src->nexthop_orig.u.prefix6 = path_vpn->attr->mp_nexthop_global;
+		src->nexthop_orig.prefixlen = IPV6_MAX_BITLEN;
+		break;
 	}
 
-	/* Check for intersection of route targets */
-	if (!ecom_intersect(
-		    bgp_vrf->vpn_policy[afi].rtlist[BGP_VPN_POLICY_DIR_FROMVPN],
-		    path_vpn->attr->ecommunity)) {
-		if (debug)
-			zlog_debug(
-				"from vpn to vrf %s, skipping after no intersection of route targets",
-				bgp_vrf->name_pretty);
-		return;
+	/*
+	 * Labels: if the route originated in another local VRF (as opposed
+	 * to arriving via VPN), then the nexthop is reached by hairpinning
+	 * through this router (me) using IP forwarding only (no LSP).
+	 * Therefore, the route imported to the VRF should not have labels
+	 * attached. Note that nexthop tracking is also involved: eliminating
+	 * the labels for these routes enables the non-labeled nexthops from
+	 * the originating VRF to be considered valid for this route.
+	 */
+
+	/* work back to original route */
+	for (bpi_ultimate = path_vpn;
+	     bpi_ultimate->extra && bpi_ultimate->extra->parent;
+	     bpi_ultimate = bpi_ultimate->extra->parent)
+		;
+
+	/*
+	 * if original route was unicast,
+	 * then it did not arrive over vpn
+	 */
+	if (bpi_ultimate->net) {
+		struct bgp_table *table;
+
+		table = bgp_dest_table(bpi_ultimate->net);
+		if (table && (table->safi == SAFI_UNICAST))
+			origin_local = 1;
 	}
 
-	if (debug)
-		zlog_debug("%s: updating %pFX to vrf %s", __func__, p,
-			   bgp_vrf->name_pretty);
+	/* copy labels */
+	if (!origin_local && path_vpn->extra && path_vpn->extra->num_labels) {
+		src->num_labels = path_vpn->extra->num_labels;
+		if (src->num_labels > BGP_MAX_LABELS)
+			src->num_labels = BGP_MAX_LABELS;
+		src->labels = path_vpn->extra->label;
+	}
 
-	/* shallow copy */
-	static_attr = *path_vpn->attr;
+	/*
+	 * For VRF-2-VRF route-leaking,
+	 * the source will be the originating VRF.
+	 */
+	if (path_vpn->extra && path_vpn->extra->bgp_orig)
+		src->src_vrf = path_vpn->extra->bgp_orig;
+	else
+		src->src_vrf = bgp_vpn;
+}
+
+static void vpn_leak_to_vrf_src_fini(struct vpn_leak_to_vrf_src *src)
+{
+	unsigned int i;
 
+	for (i = 0; i < array_size(src->attr); i++)
+		if (src->attr[i])
+			bgp_attr_unintern(&src->attr[i]);
+}
+
+/* The attr of the path leaked from src, before any route-map */
+static void vpn_leak_to_vrf_attr(struct attr *static_attr,
+				 struct vpn_leak_to_vrf_src *src,
+				 bool vrf_to_vrf)
+{
+	struct bgp_path_info *path_vpn = src->path_vpn;
 	struct ecommunity *old_ecom;
 	struct ecommunity *new_ecom;
 
+	/* shallow copy */
+	*static_attr = *path_vpn->attr;
+
 	/* If doing VRF-to-VRF leaking, strip RTs. */
-	old_ecom = static_attr.ecommunity;
-	if (old_ecom && CHECK_FLAG(bgp_vrf->af_flags[afi][safi],
-				BGP_CONFIG_VRF_TO_VRF_IMPORT)) {
+	old_ecom = static_attr->ecommunity;
+	if (old_ecom && vrf_to_vrf) {
 		new_ecom = ecommunity_dup(old_ecom);
 		ecommunity_strip_rts(new_ecom);
-		static_attr.ecommunity = new_ecom;
+		static_attr->ecommunity = new_ecom;
 
 		if (new_ecom->size == 0) {
-			UNSET_FLAG(static_attr.flag,
+			UNSET_FLAG(static_attr->flag,
 				   ATTR_FLAG_BIT(BGP_ATTR_EXT_COMMUNITIES));
 			ecommunity_free(&new_ecom);
-			static_attr.ecommunity = NULL;
+			static_attr->ecommunity = NULL;
 		}
 
 		if (!old_ecom->refcnt)
@@ -1425,46 +1500,75 @@ vpn_leak_to_vrf_update_onevrf(struct bgp *bgp_vrf,	    /* to */
 	}
 
 	/*
-	 * Nexthop: stash and clear
+	 * Nexthop: clear
 	 *
-	 * Nexthop is valid in context of VPN core, but not in destination vrf.
-	 * Stash it for later label resolution by vrf ingress path and then
-	 * overwrite with 0, i.e., "me", for the sake of vrf advertisement.
+	 * Overwrite it with 0, i.e., "me", for the sake of vrf advertisement.
 	 */
-	uint8_t nhfamily = NEXTHOP_FAMILY(path_vpn->attr->mp_nexthop_len);
-
-	memset(&nexthop_orig, 0, sizeof(nexthop_orig));
-	nexthop_orig.family = nhfamily;
-
-	switch (nhfamily) {
+	switch (src->nexthop_orig.family) {
 	case AF_INET:
-		/* save */
-		nexthop_orig.u.prefix4 = path_vpn->attr->mp_nexthop_global_in;
-		nexthop_orig.prefixlen = IPV4_MAX_BITLEN;
-
-		if (CHECK_FLAG(bgp_vrf->af_flags[afi][safi],
-			       BGP_CONFIG_VRF_TO_VRF_IMPORT)) {
-			static_attr.nexthop.s_addr =
-				nexthop_orig.u.prefix4.s_addr;
+		if (vrf_to_vrf) {
+			static_attr->nexthop.s_addr =
+				src->nexthop_orig.u.prefix4.s_addr;
 
-			static_attr.mp_nexthop_global_in =
+			static_attr->mp_nexthop_global_in =
 				path_vpn->attr->mp_nexthop_global_in;
-			static_attr.mp_nexthop_len =
+			static_attr->mp_nexthop_len =
 				path_vpn->attr->mp_nexthop_len;
 		}
-		static_attr.flag |= ATTR_FLAG_BIT(BGP_ATTR_NEXT_HOP);
+		static_attr->flag |= ATTR_FLAG_BIT(BGP_ATTR_NEXT_HOP);
 		break;
 	case AF_INET6:
-		/* save */
-		nexthop_orig.u.prefix6 = path_vpn->attr->mp_nexthop_global;
-		nexthop_orig.prefixlen = IPV6_MAX_BITLEN;
-
-		if (CHECK_FLAG(bgp_vrf->af_flags[afi][safi],
-			       BGP_CONFIG_VRF_TO_VRF_IMPORT)) {
-			static_attr.mp_nexthop_global = nexthop_orig.u.prefix6;
-		}
+		if (vrf_to_vrf)
+			static_attr->mp_nexthop_global =
+				src->nexthop_orig.u.prefix6;
 		break;
 	}
+}
+
+static void
+vpn_leak_to_vrf_update_onevrf(struct bgp *bgp_vrf,	    /* to */
+			      struct bgp *bgp_vpn,	    /* from */
+			      struct vpn_leak_to_vrf_src *src) /* route */
+{
+	struct bgp_path_info *path_vpn = src->path_vpn;
+	const struct prefix *p = bgp_dest_get_prefix(path_vpn->net);
+	afi_t afi = family2afi(p->family);
+
+	struct attr static_attr = {0};
+	struct attr *new_attr = NULL;
+	struct bgp_dest *bn;
+	safi_t safi = SAFI_UNICAST;
+	const char *debugmsg;
+	mpls_label_t *pLabels = NULL;
+	uint32_t num_labels = 0;
+	int nexthop_self_flag = 1;
+	bool vrf_to_vrf;
+
+	int debug = BGP_DEBUG(vpn, VPN_LEAK_TO_VRF);
+
+	if (!vpn_leak_from_vpn_active(bgp_vrf, afi, &debugmsg)) {
+		if (debug)
+			zlog_debug("%s: skipping: %s", __func__, debugmsg);
+		return;
+	}
+
+	/* Check for intersection of route targets */
+	if (!ecommunity_intersect(
+		    bgp_vrf->vpn_policy[afi].rtlist[BGP_VPN_POLICY_DIR_FROMVPN],
+		    path_vpn->attr->ecommunity)) {
+		if (debug)
+			zlog_debug(
+				"from vpn to vrf %s, skipping after no intersection of route targets",
+				bgp_vrf->name_pretty);
+		return;
+	}
+
+	if (debug)
+		zlog_debug("%s: updating %pFX to vrf %s", __func__, p,
+			   bgp_vrf->name_pretty);
+
+	vrf_to_vrf = CHECK_FLAG(bgp_vrf->af_flags[afi][safi],
+				BGP_CONFIG_VRF_TO_VRF_IMPORT);
 
 	/*
 	 * route map handling
@@ -1473,6 +1577,8 @@ vpn_leak_to_vrf_update_onevrf(struct bgp *bgp_vrf,	    /* to */
 		struct bgp_path_info info;
 		route_map_result_t ret;
 
+		vpn_leak_to_vrf_attr(&static_attr, src, vrf_to_vrf);
+
 		memset(&info, 0, sizeof(info));
 		info.peer = bgp_vrf->peer_self;
 		info.attr = &static_attr;
@@ -1497,92 +1603,223 @@ vpn_leak_to_vrf_update_onevrf(struct bgp *bgp_vrf,	    /* to */
 		if (!CHECK_FLAG(static_attr.rmap_change_flags,
 						BATTR_RMAP_NEXTHOP_UNCHANGED))
 			nexthop_self_flag = 0;
-	}
 
-	new_attr = bgp_attr_intern(&static_attr);
-	bgp_attr_flush(&static_attr);
+		new_attr = bgp_attr_intern(&static_attr);
+		bgp_attr_flush(&static_attr);
+	} else {
+		if (!src->attr[vrf_to_vrf]) {
+			vpn_leak_to_vrf_attr(&static_attr, src, vrf_to_vrf);
+			src->attr[vrf_to_vrf] = bgp_attr_intern(&static_attr);
+			bgp_attr_flush(&static_attr);
+		}
+
+		/* the leaked path holds a reference of its own */
+		new_attr = bgp_attr_intern(src->attr[vrf_to_vrf]);
+	}
 
 	bn = bgp_afi_node_get(bgp_vrf->rib[afi][safi], afi, safi, p, NULL);
 
-	/*
-	 * ensure labels are copied
-	 *
-	 * However, there is a special case: if the route originated in
-	 * another local VRF (as opposed to arriving via VPN), then the
-	 * nexthop is reached by hairpinning through this router (me)
-	 * using IP forwarding only (no LSP). Therefore, the route
-	 * imported to the VRF should not have labels attached. Note
-	 * that nexthop tracking is also involved: eliminating the
-	 * labels for these routes enables the non-labeled nexthops
-	 * from the originating VRF to be considered valid for this route.
-	 */
-	if (!CHECK_FLAG(bgp_vrf->af_flags[afi][safi],
-			BGP_CONFIG_VRF_TO_VRF_IMPORT)) {
-		/* work back to original route */
-		for (bpi_ultimate = path_vpn;
-		     bpi_ultimate->extra && bpi_ultimate->extra->parent;
-		     bpi_ultimate = bpi_ultimate->extra->parent)
-			;
+	/* ensure labels are copied, see vpn_leak_to_vrf_src_init() */
+	if (!vrf_to_vrf) {
+		num_labels = src->num_labels;
+		pLabels = src->labels;
+	}
 
-		/*
-		 * if original route was unicast,
-		 * then it did not arrive over vpn
-		 */
-		if (bpi_ultimate->net) {
-			struct bgp_table *table;
+	if (debug)
+		zlog_debug("%s: pfx %pBD: num_labels %d", __func__,
+			   path_vpn->net, num_labels);
+
+	leak_update(bgp_vrf, bn, new_attr, afi, safi, path_vpn, pLabels,
+		    num_labels, path_vpn, /* parent */
+		    src->src_vrf, &src->nexthop_orig, nexthop_self_flag, debug);
+}
+
+/*
+ * Index of the vrfs importing from vpn, by the route-targets in their
+ * FROMVPN rtlist, so that a vpn route only has to be looked at by the vrfs
+ * that may import it rather than by all of them.  It's rebuilt on first
+ * use after vpn_leak_import_changed(), which vpn_leak_prechange() and
+ * vpn_leak_postchange() call around every change to the lists.
+ */
+PREDECL_HASH(vpn_import_rts);
+
+struct vpn_import_rt {
+	struct vpn_import_rts_item item;
+
+	uint8_t val[ECOMMUNITY_SIZE];
+	struct list *vrfs;
+};
 
-			table = bgp_dest_table(bpi_ultimate->net);
-			if (table && (table->safi == SAFI_UNICAST))
-				origin_local = 1;
+static int vpn_import_rt_cmp(const struct vpn_import_rt *a,
+			     const struct vpn_import_rt *b)
+{
+	return memcmp(a->val, b->val, ECOMMUNITY_SIZE);
+}
+
+static uint32_t vpn_import_rt_hash(const struct vpn_import_rt *rt)
+{
+	return jhash(rt->val, ECOMMUNITY_SIZE, 0x6b3d5a91);
+}
+
+DECLARE_HASH(vpn_import_rts, struct vpn_import_rt, item, vpn_import_rt_cmp,
+	     vpn_import_rt_hash);
+
+static struct {
+	bool valid;
+	struct vpn_import_rts_head rts[AFI_MAX];
+
+	/* vrfs whose route-targets aren't ECOMMUNITY_SIZE, always tried */
+	struct list *others[AFI_MAX];
+
+	uint32_t mark;
+} vpn_import;
+
+void vpn_leak_import_changed(void)
+{
+	struct vpn_import_rt *rt;
+	afi_t afi;
+
+	if (!vpn_import.valid)
+		return;
+
+	for (afi = AFI_IP; afi < AFI_MAX; afi++) {
+		while ((rt = vpn_import_rts_pop(&vpn_import.rts[afi]))) {
+			list_delete(&rt->vrfs);
+			XFREE(MTYPE_BGP_VPN_IMPORT_RT, rt);
 		}
+		vpn_import_rts_fini(&vpn_import.rts[afi]);
+		list_delete(&vpn_import.others[afi]);
+	}
+	vpn_import.valid = false;
+}
+
+static void vpn_import_build(void)
+{
+	struct vpn_import_rt key, *rt;
+	struct ecommunity *ecom;
+	struct listnode *node;
+	struct bgp *bgp;
+	uint32_t i;
+	afi_t afi;
+
+	for (afi = AFI_IP; afi < AFI_MAX; afi++) {
+		vpn_import_rts_init(&vpn_import.rts[afi]);
+		vpn_import.others[afi] = list_new();
+	}
 
-		/* copy labels */
-		if (!origin_local && path_vpn->extra
-		    && path_vpn->extra->num_labels) {
-			num_labels = path_vpn->extra->num_labels;
-			if (num_labels > BGP_MAX_LABELS)
-				num_labels = BGP_MAX_LABELS;
-			pLabels = path_vpn->extra->label;
+	for (ALL_LIST_ELEMENTS_RO(bm->bgp, node, bgp)) {
+		for (afi = AFI_IP; afi < AFI_MAX; afi++) {
+			ecom = bgp->vpn_policy[afi]
+				       .rtlist[BGP_VPN_POLICY_DIR_FROMVPN];
+			if (!ecom || !ecom->size)
+				continue;
+
+			if (ecom->unit_size != ECOMMUNITY_SIZE) {
+				listnode_add(vpn_import.others[afi], bgp);
+				continue;
+			}
+
+			for (i = 0; i < ecom->size; i++) {
+				memcpy(key.val, ecom->val + i * ECOMMUNITY_SIZE,
+				       ECOMMUNITY_SIZE);
+				rt = vpn_import_rts_find(&vpn_import.rts[afi],
+							 &key);
+				if (!rt) {
+					rt = XCALLOC(MTYPE_BGP_VPN_IMPORT_RT,
+						     sizeof(*rt));
+					memcpy(rt->val, key.val,
+					       ECOMMUNITY_SIZE);
+					rt->vrfs = list_new();
+					vpn_import_rts_add(&vpn_import.rts[afi],
+							   rt);
+				}
+				listnode_add(rt->vrfs, bgp);
+			}
 		}
 	}
+	vpn_import.valid = true;
+}
 
-	if (debug)
-		zlog_debug("%s: pfx %pBD: num_labels %d", __func__,
-			   path_vpn->net, num_labels);
+static void vpn_import_push(struct bgp *bgp, struct bgp **head)
+{
+	if (bgp->vpn_import_mark == vpn_import.mark)
+		return;
 
-	/*
-	 * For VRF-2-VRF route-leaking,
-	 * the source will be the originating VRF.
+	bgp->vpn_import_mark = vpn_import.mark;
+	bgp->vpn_import_next = *head;
+	*head = bgp;
+}
+
+/*
+ * The vrfs that may import a vpn route with route-targets ecom, linked
+ * through vpn_import_next; a superset of those for which
+ * ecommunity_intersect() with their FROMVPN rtlist is true.
+ */
+static struct bgp *vpn_import_vrfs(afi_t afi, struct ecommunity *ecom)
+{
+	struct vpn_import_rt key, *rt;
+	struct bgp *head = NULL;
+	struct listnode *node;
+	struct bgp *bgp;
+	uint32_t i;
+
+	if (!ecom)
+		return NULL;
+
+	if (!vpn_import.valid)
+		vpn_import_build();
+
+	if (++vpn_import.mark == 0) {
+		for (ALL_LIST_ELEMENTS_RO(bm->bgp, node, bgp))
+			bgp->vpn_import_mark = 0;
+		vpn_import.mark = 1;
+	}
+
+	for (ALL_LIST_ELEMENTS_RO(vpn_import.others[afi], node, bgp))
+		vpn_import_push(bgp, &head);
+
+	/* ecommunity_intersect() compares the first ECOMMUNITY_SIZE bytes of
+	 * each of the route's values with the vrf's
 	 */
-	if (path_vpn->extra && path_vpn->extra->bgp_orig)
-		src_vrf = path_vpn->extra->bgp_orig;
-	else
-		src_vrf = bgp_vpn;
+	for (i = 0; i < ecom->size; i++) {
+		memcpy(key.val, ecom->val + i * ecom->unit_size,
+		       ECOMMUNITY_SIZE);
+		rt = vpn_import_rts_find(&vpn_import.rts[afi], &key);
+		if (!rt)
+			continue;
 
-	leak_update(bgp_vrf, bn, new_attr, afi, safi, path_vpn, pLabels,
-		    num_labels, path_vpn, /* parent */
-		    src_vrf, &nexthop_orig, nexthop_self_flag, debug);
+		for (ALL_LIST_ELEMENTS_RO(rt->vrfs, node, bgp))
+			vpn_import_push(bgp, &head);
+	}
+	return head;
 }
 
 void vpn_leak_to_vrf_update(struct bgp *bgp_vpn,	    /* from */
 			    struct bgp_path_info *path_vpn) /* route */
 {
-	struct listnode *mnode, *mnnode;
+	const struct prefix *p = bgp_dest_get_prefix(path_vpn->net);
 	struct bgp *bgp;
+	struct vpn_leak_to_vrf_src src;
 
 	int debug = BGP_DEBUG(vpn, VPN_LEAK_TO_VRF);
 
 	if (debug)
 		zlog_debug("%s: start (path_vpn=%p)", __func__, path_vpn);
 
-	/* Loop over VRFs */
-	for (ALL_LIST_ELEMENTS(bm->bgp, mnode, mnnode, bgp)) {
+	vpn_leak_to_vrf_src_init(&src, bgp_vpn, path_vpn);
+
+	/* Loop over VRFs importing any of its route-targets */
+	for (bgp = vpn_import_vrfs(family2afi(p->family),
+				   path_vpn->attr->ecommunity);
+	     bgp; bgp = bgp->vpn_import_next) {
 
 		if (!path_vpn->extra
 		    || path_vpn->extra->bgp_orig != bgp) { /* no loop */
-			vpn_leak_to_vrf_update_onevrf(bgp, bgp_vpn, path_vpn);
+			vpn_leak_to_vrf_update_onevrf(bgp, bgp_vpn, &src);
 		}
 	}
+
+	vpn_leak_to_vrf_src_fini(&src);
 }
 
 void vpn_leak_to_vrf_withdraw(struct bgp *bgp_vpn,	    /* from */
@@ -1592,7 +1829,6 @@ void vpn_leak_to_vrf_withdraw(struct bgp *bgp_vpn,	    /* from */
 	afi_t afi;
 	safi_t safi = SAFI_UNICAST;
 	struct bgp *bgp;
-	struct listnode *mnode, *mnnode;
 	struct bgp_dest *bn;
 	struct bgp_path_info *bpi;
 	const char *debugmsg;
@@ -1625,8 +1861,9 @@ void vpn_leak_to_vrf_withdraw(struct bgp *bgp_vpn,	    /* from */
 	p = bgp_dest_get_prefix(path_vpn->net);
 	afi = family2afi(p->family);
 
-	/* Loop over VRFs */
-	for (ALL_LIST_ELEMENTS(bm->bgp, mnode, mnnode, bgp)) {
+	/* Loop over VRFs importing any of its route-targets */
+	for (bgp = vpn_import_vrfs(afi, path_vpn->attr->ecommunity); bgp;
+	     bgp = bgp->vpn_import_next) {
 		if (!vpn_leak_from_vpn_active(bgp, afi, &debugmsg)) {
 			if (debug)
 				zlog_debug("%s: skipping: %s", __func__,
@@ -1635,9 +1872,10 @@ void vpn_leak_to_vrf_withdraw(struct bgp *bgp_vpn,	    /* from */
 		}
 
 		/* Check for intersection of route targets */
-		if (!ecom_intersect(bgp->vpn_policy[afi]
-					    .rtlist[BGP_VPN_POLICY_DIR_FROMVPN],
-				    path_vpn->attr->ecommunity)) {
+		if (!ecommunity_intersect(
+			    bgp->vpn_policy[afi]
+				    .rtlist[BGP_VPN_POLICY_DIR_FROMVPN],
+			    path_vpn->attr->ecommunity)) {
 
 			continue;
 		}
@@ -1732,12 +1970,16 @@ void vpn_leak_to_vrf_update_all(struct bgp *bgp_vrf, /* to */
 			for (bpi = bgp_dest_get_bgp_path_info(bn); bpi;
 			     bpi = bpi->next) {
 
+				struct vpn_leak_to_vrf_src src;
+
 				if (bpi->extra
 				    && bpi->extra->bgp_orig == bgp_vrf)
 					continue;
 
+				vpn_leak_to_vrf_src_init(&src, bgp_vpn, bpi);
 				vpn_leak_to_vrf_update_onevrf(bgp_vrf, bgp_vpn,
-							      bpi);
+							      &src);
+				vpn_leak_to_vrf_src_fini(&src);
 			}
 		}
 	}
@@ -2819,7 +3061,7 @@ vrf_id_t get_first_vrf_for_redirect_with_rt(struct ecommunity *eckey)
 		if (ec && eckey->unit_size != ec->unit_size)
 			continue;
 
-		if (ecom_intersect(ec, eckey))
+		if (ecommunity_intersect(ec, eckey))
 			return bgp->vrf_id;
 	}
 	return VRF_UNKNOWN;
@@ -81,6 +81,9 @@ extern void vpn_leak_zebra_vrf_sid_update(struct bgp *bgp, afi_t afi);
 extern void vpn_leak_zebra_vrf_sid_withdraw(struct bgp *bgp, afi_t afi);
 extern int vpn_leak_label_callback(mpls_label_t label, void *lblid, bool alloc);
 extern void ensure_vrf_tovpn_sid(struct bgp *vpn, struct bgp *vrf, afi_t afi);
+extern struct bgp_srv6_locator_chunk *
+bgp_srv6_locator_chunk_new(const struct prefix_ipv6 *prefix);
+extern void bgp_srv6_locator_chunk_free(struct bgp_srv6_locator_chunk *chunk);
 extern void vrf_import_from_vrf(struct bgp *to_bgp, struct bgp *from_bgp,
 				afi_t afi, safi_t safi);
 void vrf_unimport_from_vrf(struct bgp *to_bgp, struct bgp *from_bgp,
@@ -202,10 +205,15 @@ static inline int vpn_leak_from_vpn_active(struct bgp *bgp_vrf, afi_t afi,
 	return 1;
 }
 
+/* Called whenever the FROMVPN route-targets of any vrf may change */
+extern void vpn_leak_import_changed(void);
+
 static inline void vpn_leak_prechange(vpn_policy_direction_t direction,
 				      afi_t afi, struct bgp *bgp_vpn,
 				      struct bgp *bgp_vrf)
 {
+	vpn_leak_import_changed();
+
 	/* Detect when default bgp instance is not (yet) defined by config */
 	if (!bgp_vpn)
 		return;
@@ -226,6 +234,8 @@ static inline void vpn_leak_postchange(vpn_policy_direction_t direction,
 				       afi_t afi, struct bgp *bgp_vpn,
 				       struct bgp *bgp_vrf)
 {
+	vpn_leak_import_changed();
+
 	/* Detect when default bgp instance is not (yet) defined by config */
 	if (!bgp_vpn)
 		return;
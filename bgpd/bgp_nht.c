@@ -937,6 +937,42 @@ static void unregister_zebra_rnh(struct bgp_nexthop_cache *bnc,
  * RETURNS:
  *   void.
  */
+/*
+ * With "bgp lazy-nexthop-update", a nexthop change that leaves the path's
+ * reachability alone and cannot change the outcome of best path selection
+ * is only recorded in the path.  The route is installed in zebra against
+ * the BGP nexthop and zebra re-resolves it by itself, so there is no need
+ * to run every prefix using the nexthop through bgp_process().  A metric
+ * change is only lazy if the path has nothing to be compared against.
+ */
+static bool bgp_nht_path_update_is_lazy(struct bgp *bgp,
+					struct bgp_nexthop_cache *bnc,
+					struct bgp_dest *dest,
+					struct bgp_path_info *path, safi_t safi)
+{
+	if (!CHECK_FLAG(bgp->flags, BGP_FLAG_LAZY_NHT))
+		return false;
+
+	if (safi != SAFI_UNICAST && safi != SAFI_MULTICAST)
+		return false;
+
+	if (path->sub_type != BGP_ROUTE_NORMAL || path->attr->srte_color
+	    || bnc->is_evpn_gwip_nexthop
+	    || path->attr->evpn_overlay.type == OVERLAY_INDEX_GATEWAY_IP)
+		return false;
+
+	if (!bnc->change_flags
+	    || CHECK_FLAG(bnc->change_flags, ~(BGP_NEXTHOP_CHANGED
+					       | BGP_NEXTHOP_METRIC_CHANGED)))
+		return false;
+
+	if (CHECK_FLAG(bnc->change_flags, BGP_NEXTHOP_METRIC_CHANGED)
+	    && (bgp_dest_get_bgp_path_info(dest) != path || path->next))
+		return false;
+
+	return true;
+}
+
 void evaluate_paths(struct bgp_nexthop_cache *bnc)
 {
 	struct bgp_dest *dest;
@@ -1048,12 +1084,17 @@ void evaluate_paths(struct bgp_nexthop_cache *bnc)
 		else if (path->extra)
 			path->extra->igpmetric = 0;
 
+		path_valid = CHECK_FLAG(path->flags, BGP_PATH_VALID);
+		if (path_valid == bnc_is_valid_nexthop
+		    && bgp_nht_path_update_is_lazy(bgp_path, bnc, dest, path,
+						   safi))
+			continue;
+
 		if (CHECK_FLAG(bnc->change_flags, BGP_NEXTHOP_METRIC_CHANGED)
 		    || CHECK_FLAG(bnc->change_flags, BGP_NEXTHOP_CHANGED)
 		    || path->attr->srte_color != 0)
 			SET_FLAG(path->flags, BGP_PATH_IGP_CHANGED);
 
-		path_valid = CHECK_FLAG(path->flags, BGP_PATH_VALID);
 		if (path_valid != bnc_is_valid_nexthop) {
 			if (path_valid) {
 				/* No longer valid, clear flag; also for EVPN
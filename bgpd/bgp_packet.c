@@ -359,6 +359,7 @@ static void bgp_write_proceed_actions(struct peer *peer)
 		if (bpacket_queue_is_full(SUBGRP_INST(subgrp),
 					  SUBGRP_PKTQ(subgrp))
 		    || subgroup_packets_to_build(subgrp)) {
+			subgroup_update_packets_schedule(SUBGRP_INST(subgrp));
 			BGP_TIMER_ON(peer->t_generate_updgrp_packets,
 				     bgp_generate_updgrp_packets, 0);
 			return;
@@ -545,7 +546,8 @@ void bgp_keepalive_send(struct peer *peer)
 {
 	struct stream *s;
 
-	s = stream_new(BGP_STANDARD_MESSAGE_MAX_PACKET_SIZE);
+	/* sent from the keepalives pthread, freed on the I/O one */
+	s = stream_new_pooled(BGP_STANDARD_MESSAGE_MAX_PACKET_SIZE);
 
 	/* Make keepalive packet. */
 	bgp_packet_set_marker(s, BGP_MSG_KEEPALIVE);
@@ -586,7 +588,7 @@ void bgp_open_send(struct peer *peer)
 	else
 		local_as = peer->local_as;
 
-	s = stream_new(BGP_STANDARD_MESSAGE_MAX_PACKET_SIZE);
+	s = stream_new_pooled(BGP_STANDARD_MESSAGE_MAX_PACKET_SIZE);
 
 	/* Make open packet. */
 	bgp_packet_set_marker(s, BGP_MSG_OPEN);
@@ -1512,6 +1514,72 @@ static int bgp_refresh_stalepath_timer_expire(struct thread *thread)
 	return 0;
 }
 
+/* bumped by every bgp_process_packet() run */
+static uint64_t bgp_rx_batch;
+
+void bgp_update_attr_cache_free(struct peer *peer)
+{
+	if (peer->rx_attr) {
+		bgp_attr_unintern_sub(peer->rx_attr);
+		XFREE(MTYPE_TMP, peer->rx_attr);
+	}
+	XFREE(MTYPE_TMP, peer->rx_attr_raw);
+	peer->rx_attr_size = 0;
+	peer->rx_attr_len = 0;
+}
+
+/*
+ * Big tables come in as runs of UPDATEs with one and the same attribute
+ * block, only the NLRI differ.  The parse result of the last block is kept
+ * and handed out again for an identical one, instead of decoding and
+ * interning all of it again.
+ *
+ * The outcome of bgp_attr_parse() also depends on configuration and
+ * connected addresses (e.g. enforce-first-as, nexthop checks), which can't
+ * change while bgp_process_packet() runs, so only a block seen in the same
+ * run is reused.  Blocks with MP_REACH/MP_UNREACH_NLRI reference their NLRI
+ * in the packet and are never kept.
+ */
+static bool bgp_update_attr_replay(struct peer *peer, struct attr *attr,
+				   bgp_size_t attribute_len)
+{
+	if (!peer->rx_attr || peer->rx_attr_batch != bgp_rx_batch
+	    || peer->rx_attr_len != attribute_len
+	    || memcmp(peer->rx_attr_raw, stream_pnt(BGP_INPUT(peer)),
+		      attribute_len))
+		return false;
+
+	*attr = *peer->rx_attr;
+	bgp_attr_ref_sub(attr);
+	stream_forward_getp(BGP_INPUT(peer), attribute_len);
+	return true;
+}
+
+static void bgp_update_attr_keep(struct peer *peer, struct attr *attr,
+				 const uint8_t *raw, bgp_size_t attribute_len)
+{
+	if (CHECK_FLAG(attr->flag, ATTR_FLAG_BIT(BGP_ATTR_MP_REACH_NLRI)
+					   | ATTR_FLAG_BIT(BGP_ATTR_MP_UNREACH_NLRI))
+	    || !bgp_attr_parts_interned(attr))
+		return;
+
+	if (peer->rx_attr)
+		bgp_attr_unintern_sub(peer->rx_attr);
+	else
+		peer->rx_attr = XMALLOC(MTYPE_TMP, sizeof(*peer->rx_attr));
+	if (peer->rx_attr_size < attribute_len) {
+		peer->rx_attr_size = attribute_len;
+		peer->rx_attr_raw = XREALLOC(MTYPE_TMP, peer->rx_attr_raw,
+					     peer->rx_attr_size);
+	}
+	memcpy(peer->rx_attr_raw, raw, attribute_len);
+	peer->rx_attr_len = attribute_len;
+	peer->rx_attr_batch = bgp_rx_batch;
+	/* a copy with references of its own on the parts */
+	*peer->rx_attr = *attr;
+	bgp_attr_ref_sub(peer->rx_attr);
+}
+
 /**
  * Process BGP UPDATE message for peer.
  *
@@ -1637,7 +1705,9 @@ static int bgp_update_receive(struct peer *peer, bgp_size_t size)
 #define NLRI_ATTR_ARG (attr_parse_ret != BGP_ATTR_PARSE_WITHDRAW ? &attr : NULL)
 
 	/* Parse attribute when it exists. */
-	if (attribute_len) {
+	if (attribute_len && !bgp_update_attr_replay(peer, &attr, attribute_len)) {
+		uint8_t *raw = stream_pnt(s);
+
 		attr_parse_ret = bgp_attr_parse(peer, &attr, attribute_len,
 						&nlris[NLRI_MP_UPDATE],
 						&nlris[NLRI_MP_WITHDRAW]);
@@ -1645,6 +1715,8 @@ static int bgp_update_receive(struct peer *peer, bgp_size_t size)
 			bgp_attr_unintern_sub(&attr);
 			return BGP_Stop;
 		}
+		if (attr_parse_ret == BGP_ATTR_PARSE_PROCEED)
+			bgp_update_attr_keep(peer, &attr, raw, attribute_len);
 	}
 
 	/* Logging the attribute. */
@@ -1817,6 +1889,13 @@ static int bgp_update_receive(struct peer *peer, bgp_size_t size)
 			if (peer->nsf[afi][safi])
 				bgp_clear_stale_route(peer, afi, safi);
 
+			/* and what's left from the RIB snapshot */
+			if (peer->rib_restored[afi][safi]) {
+				peer->rib_restored[afi][safi] = 0;
+				if (!peer->nsf[afi][safi])
+					bgp_clear_stale_route(peer, afi, safi);
+			}
+
                         zlog_info(
                             "%s: rcvd End-of-RIB for %s from %s in vrf %s",
                             __func__, get_afi_safi_str(afi, safi, false),
@@ -1830,9 +1909,6 @@ static int bgp_update_receive(struct peer *peer, bgp_size_t size)
 
 	peer->update_time = bgp_clock();
 
-	/* Notify BGP Conditional advertisement scanner process */
-	peer->advmap_table_change = true;
-
 	return Receive_UPDATE_message;
 }
 
@@ -2524,12 +2600,20 @@ int bgp_process_packet(struct thread *thread)
 	/* Yes first of all get peer pointer. */
 	struct peer *peer;	// peer
 	uint32_t rpkt_quanta_old; // how many packets to read
+	bool adaptive;		  // keep going while we have time left
 	int fsm_update_result;    // return code of bgp_event_update()
 	int mprc;		  // message processing return code
 
 	peer = THREAD_ARG(thread);
 	rpkt_quanta_old = atomic_load_explicit(&peer->bgp->rpkt_quanta,
 					       memory_order_relaxed);
+	bgp_rx_batch++;
+	/*
+	 * With the default quanta, the batch grows to whatever fits into
+	 * this event's time slice; an explicitly configured read-quanta is
+	 * taken as a hard limit.
+	 */
+	adaptive = (rpkt_quanta_old == BGP_READ_PACKET_MAX);
 	fsm_update_result = 0;
 
 	/* Guard against scheduled events that occur after peer deletion. */
@@ -2538,7 +2622,8 @@ int bgp_process_packet(struct thread *thread)
 
 	unsigned int processed = 0;
 
-	while (processed < rpkt_quanta_old) {
+	while (processed < rpkt_quanta_old
+	       || (adaptive && !thread_should_yield(thread))) {
 		uint8_t type = 0;
 		bgp_size_t size;
 		char notify_data_length[2];
@@ -81,6 +81,7 @@ extern int bgp_packet_set_size(struct stream *s);
 
 extern int bgp_generate_updgrp_packets(struct thread *);
 extern int bgp_process_packet(struct thread *);
+extern void bgp_update_attr_cache_free(struct peer *peer);
 
 extern void bgp_send_delayed_eor(struct bgp *bgp);
 
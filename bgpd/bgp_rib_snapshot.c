@@ -0,0 +1,759 @@
+/*
+ * BGP Adj-RIB-In snapshot for fast restarts.
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+#include <sys/mman.h>
+
+#include "command.h"
+#include "jhash.h"
+#include "lib_errors.h"
+#include "libfrr.h"
+#include "memory.h"
+#include "sockunion.h"
+#include "stream.h"
+#include "thread.h"
+#include "typesafe.h"
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_aspath.h"
+#include "bgpd/bgp_attr.h"
+#include "bgpd/bgp_community.h"
+#include "bgpd/bgp_ecommunity.h"
+#include "bgpd/bgp_lcommunity.h"
+#include "bgpd/bgp_route.h"
+#include "bgpd/bgp_table.h"
+#include "bgpd/bgp_debug.h"
+#include "bgpd/bgp_rib_snapshot.h"
+
+DEFINE_MTYPE_STATIC(BGPD, BGP_RIB_SNAPSHOT, "BGP RIB snapshot");
+
+/*
+ * File layout: a header, the path records, then the peer records which the
+ * paths refer to by index.  Each path record is followed by its attributes:
+ * the fixed part, then the AS path in 4-byte AS wire format, the cluster
+ * list and the standard, large and extended community values, each padded
+ * to 4 bytes.  The file is only read back by bgpd on the same machine, so
+ * everything that isn't wire format is in host byte order.
+ */
+#define BGP_SNAP_MAGIC 0x42524942 /* "BRIB" */
+#define BGP_SNAP_VERSION 1
+
+struct bgp_snap_hdr {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t hdr_size;
+	uint16_t peer_size;
+	uint16_t path_size;
+	uint16_t attr_size;
+	uint16_t pad;
+	uint32_t peer_count;
+	uint32_t path_count;
+	uint64_t paths_len;
+};
+
+struct bgp_snap_peer {
+	char bgp_name[VRF_NAMSIZ + 1];
+	char conf_if[INTERFACE_NAMSIZ];
+	uint8_t family;
+	uint8_t pad[2];
+	uint8_t addr[16];
+};
+
+struct bgp_snap_path {
+	uint32_t peer;
+	uint32_t addpath_rx_id;
+	uint8_t afi;
+	uint8_t safi;
+	uint8_t family;
+	uint8_t prefixlen;
+	uint8_t prefix[16];
+	uint32_t attr_len;
+};
+
+struct bgp_snap_attr {
+	uint64_t flag;
+	struct in6_addr mp_nexthop_global;
+	struct in6_addr mp_nexthop_local;
+	struct in_addr nexthop;
+	struct in_addr mp_nexthop_global_in;
+	struct in_addr aggregator_addr;
+	struct in_addr originator_id;
+	uint32_t med;
+	uint32_t local_pref;
+	uint32_t weight;
+	uint32_t tag;
+	uint32_t aggregator_as;
+	uint32_t label;
+	uint32_t label_index;
+	int32_t nh_ifindex;
+	int32_t nh_lla_ifindex;
+	uint8_t origin;
+	uint8_t mp_nexthop_len;
+	uint8_t mp_nexthop_prefer_global;
+	uint8_t pad;
+	uint16_t aspath_len;
+	uint16_t cluster_len;
+	uint16_t community_len;
+	uint16_t lcommunity_len;
+	uint16_t ecommunity_len;
+	uint16_t pad2;
+};
+
+/* Attributes that can be restored; paths carrying others are not saved */
+#define BGP_SNAP_ATTR_FLAGS                                                    \
+	(ATTR_FLAG_BIT(BGP_ATTR_ORIGIN) | ATTR_FLAG_BIT(BGP_ATTR_AS_PATH)      \
+	 | ATTR_FLAG_BIT(BGP_ATTR_NEXT_HOP)                                    \
+	 | ATTR_FLAG_BIT(BGP_ATTR_MULTI_EXIT_DISC)                             \
+	 | ATTR_FLAG_BIT(BGP_ATTR_LOCAL_PREF)                                  \
+	 | ATTR_FLAG_BIT(BGP_ATTR_ATOMIC_AGGREGATE)                            \
+	 | ATTR_FLAG_BIT(BGP_ATTR_AGGREGATOR)                                  \
+	 | ATTR_FLAG_BIT(BGP_ATTR_COMMUNITIES)                                 \
+	 | ATTR_FLAG_BIT(BGP_ATTR_ORIGINATOR_ID)                               \
+	 | ATTR_FLAG_BIT(BGP_ATTR_CLUSTER_LIST)                                \
+	 | ATTR_FLAG_BIT(BGP_ATTR_MP_REACH_NLRI)                               \
+	 | ATTR_FLAG_BIT(BGP_ATTR_EXT_COMMUNITIES)                             \
+	 | ATTR_FLAG_BIT(BGP_ATTR_LARGE_COMMUNITIES))
+
+#define BGP_SNAP_PAD(len) (((len) + 3) & ~(size_t)3)
+
+static unsigned int bgp_snap_interval;
+static struct thread *t_bgp_snap_write;
+static struct thread *t_bgp_snap_release;
+
+static void bgp_snap_path_name(char *buf, size_t len, const char *suffix)
+{
+	snprintf(buf, len, "%s/bgpd-rib.snapshot%s", frr_vtydir, suffix);
+}
+
+/*
+ * Writing
+ */
+PREDECL_HASH(bgp_snap_peer_idx);
+
+struct bgp_snap_peer_ref {
+	struct bgp_snap_peer_idx_item item;
+	struct peer *peer;
+	uint32_t idx;
+};
+
+static int bgp_snap_peer_ref_cmp(const struct bgp_snap_peer_ref *a,
+				 const struct bgp_snap_peer_ref *b)
+{
+	return numcmp((uintptr_t)a->peer, (uintptr_t)b->peer);
+}
+
+static uint32_t bgp_snap_peer_ref_hash(const struct bgp_snap_peer_ref *ref)
+{
+	return jhash(&ref->peer, sizeof(ref->peer), 0x4b1d05e3);
+}
+
+DECLARE_HASH(bgp_snap_peer_idx, struct bgp_snap_peer_ref, item,
+	     bgp_snap_peer_ref_cmp, bgp_snap_peer_ref_hash);
+
+struct bgp_snap_writer {
+	FILE *fp;
+	struct stream *s;
+	struct bgp_snap_peer_idx_head peers;
+	uint32_t path_count;
+	uint64_t paths_len;
+	bool error;
+};
+
+static void bgp_snap_put(struct bgp_snap_writer *w, const void *data,
+			 size_t len)
+{
+	static const uint8_t zero[4];
+
+	if (w->error || !len)
+		return;
+	if (fwrite(data, 1, len, w->fp) != len
+	    || fwrite(zero, 1, BGP_SNAP_PAD(len) - len, w->fp)
+		       != BGP_SNAP_PAD(len) - len)
+		w->error = true;
+}
+
+static uint32_t bgp_snap_peer_get(struct bgp_snap_writer *w, struct peer *peer)
+{
+	struct bgp_snap_peer_ref lookup = { .peer = peer }, *ref;
+
+	ref = bgp_snap_peer_idx_find(&w->peers, &lookup);
+	if (!ref) {
+		ref = XCALLOC(MTYPE_BGP_RIB_SNAPSHOT, sizeof(*ref));
+		ref->peer = peer;
+		ref->idx = bgp_snap_peer_idx_count(&w->peers);
+		bgp_snap_peer_idx_add(&w->peers, ref);
+	}
+	return ref->idx;
+}
+
+/* can this path be put back as it is? */
+static bool bgp_snap_path_ok(struct bgp_path_info *pi)
+{
+	struct peer *peer = pi->peer;
+
+	if (pi->type != ZEBRA_ROUTE_BGP || pi->sub_type != BGP_ROUTE_NORMAL
+	    || !pi->attr || !peer || peer == peer->bgp->peer_self
+	    || CHECK_FLAG(peer->sflags, PEER_STATUS_GROUP)
+	    || peer_dynamic_neighbor(peer)
+	    || CHECK_FLAG(pi->flags, BGP_PATH_REMOVED | BGP_PATH_HISTORY
+					     | BGP_PATH_DAMPED)
+	    || (pi->extra && pi->extra->num_labels))
+		return false;
+
+	if (pi->attr->ecommunity
+	    && pi->attr->ecommunity->unit_size != ECOMMUNITY_SIZE)
+		return false;
+
+	return !(pi->attr->flag & ~BGP_SNAP_ATTR_FLAGS);
+}
+
+static void bgp_snap_write_path(struct bgp_snap_writer *w, afi_t afi,
+				safi_t safi, const struct prefix *p,
+				struct bgp_path_info *pi)
+{
+	struct attr *attr = pi->attr;
+	struct cluster_list *cluster = bgp_attr_get_cluster(attr);
+	struct bgp_snap_path sp = {};
+	struct bgp_snap_attr sa = {};
+
+	stream_reset(w->s);
+	if (attr->aspath && aspath_size(attr->aspath) < STREAM_SIZE(w->s))
+		sa.aspath_len = aspath_put(w->s, attr->aspath, 1);
+	else if (attr->aspath)
+		return;
+
+	sa.flag = attr->flag;
+	sa.mp_nexthop_global = attr->mp_nexthop_global;
+	sa.mp_nexthop_local = attr->mp_nexthop_local;
+	sa.nexthop = attr->nexthop;
+	sa.mp_nexthop_global_in = attr->mp_nexthop_global_in;
+	sa.aggregator_addr = attr->aggregator_addr;
+	sa.originator_id = attr->originator_id;
+	sa.med = attr->med;
+	sa.local_pref = attr->local_pref;
+	sa.weight = attr->weight;
+	sa.tag = attr->tag;
+	sa.aggregator_as = attr->aggregator_as;
+	sa.label = attr->label;
+	sa.label_index = attr->label_index;
+	sa.nh_ifindex = attr->nh_ifindex;
+	sa.nh_lla_ifindex = attr->nh_lla_ifindex;
+	sa.origin = attr->origin;
+	sa.mp_nexthop_len = attr->mp_nexthop_len;
+	sa.mp_nexthop_prefer_global = attr->mp_nexthop_prefer_global;
+	if (cluster)
+		sa.cluster_len = cluster->length;
+	if (attr->community)
+		sa.community_len = attr->community->size * COMMUNITY_SIZE;
+	if (attr->lcommunity)
+		sa.lcommunity_len = lcom_length(attr->lcommunity);
+	if (attr->ecommunity)
+		sa.ecommunity_len =
+			attr->ecommunity->size * attr->ecommunity->unit_size;
+
+	sp.peer = bgp_snap_peer_get(w, pi->peer);
+	sp.addpath_rx_id = pi->addpath_rx_id;
+	sp.afi = afi;
+	sp.safi = safi;
+	sp.family = p->family;
+	sp.prefixlen = p->prefixlen;
+	memcpy(sp.prefix, &p->u.prefix, prefix_blen(p));
+	sp.attr_len = sizeof(sa) + BGP_SNAP_PAD(sa.aspath_len)
+		      + BGP_SNAP_PAD(sa.cluster_len)
+		      + BGP_SNAP_PAD(sa.community_len)
+		      + BGP_SNAP_PAD(sa.lcommunity_len)
+		      + BGP_SNAP_PAD(sa.ecommunity_len);
+
+	bgp_snap_put(w, &sp, sizeof(sp));
+	bgp_snap_put(w, &sa, sizeof(sa));
+	bgp_snap_put(w, STREAM_DATA(w->s), sa.aspath_len);
+	if (cluster)
+		bgp_snap_put(w, cluster->list, sa.cluster_len);
+	if (attr->community)
+		bgp_snap_put(w, attr->community->val, sa.community_len);
+	if (attr->lcommunity)
+		bgp_snap_put(w, attr->lcommunity->val, sa.lcommunity_len);
+	if (attr->ecommunity)
+		bgp_snap_put(w, attr->ecommunity->val, sa.ecommunity_len);
+
+	w->path_count++;
+	w->paths_len += sizeof(sp) + sp.attr_len;
+}
+
+static void bgp_snap_write_peer(struct bgp_snap_writer *w, struct peer *peer)
+{
+	struct bgp_snap_peer sr = {};
+
+	if (peer->bgp->name)
+		strlcpy(sr.bgp_name, peer->bgp->name, sizeof(sr.bgp_name));
+	if (peer->conf_if)
+		strlcpy(sr.conf_if, peer->conf_if, sizeof(sr.conf_if));
+	sr.family = sockunion_family(&peer->su);
+	if (sr.family == AF_INET)
+		memcpy(sr.addr, &peer->su.sin.sin_addr, IPV4_MAX_BYTELEN);
+	else if (sr.family == AF_INET6)
+		memcpy(sr.addr, &peer->su.sin6.sin6_addr, IPV6_MAX_BYTELEN);
+	bgp_snap_put(w, &sr, sizeof(sr));
+}
+
+void bgp_rib_snapshot_write(void)
+{
+	struct bgp_snap_writer w = {};
+	struct bgp_snap_hdr hdr = {};
+	struct bgp_snap_peer_ref *ref, **order;
+	struct bgp_path_info *pi;
+	struct bgp_dest *dest;
+	struct listnode *node;
+	struct bgp *bgp;
+	char path[512], tmppath[512];
+	uint32_t i, npeers;
+	afi_t afi;
+	safi_t safi;
+
+	if (!bgp_snap_interval)
+		return;
+
+	bgp_snap_path_name(path, sizeof(path), "");
+	bgp_snap_path_name(tmppath, sizeof(tmppath), ".tmp");
+
+	w.fp = fopen(tmppath, "w");
+	if (!w.fp) {
+		flog_err_sys(EC_LIB_SYSTEM_CALL, "%s: cannot create %s: %s",
+			     __func__, tmppath, safe_strerror(errno));
+		return;
+	}
+	w.s = stream_new(BGP_MAX_PACKET_SIZE);
+	bgp_snap_peer_idx_init(&w.peers);
+
+	/* header goes in last, once the counts are known */
+	bgp_snap_put(&w, &hdr, sizeof(hdr));
+
+	for (ALL_LIST_ELEMENTS_RO(bm->bgp, node, bgp)) {
+		for (afi = AFI_IP; afi <= AFI_IP6; afi++) {
+			for (safi = SAFI_UNICAST; safi <= SAFI_MULTICAST;
+			     safi++) {
+				for (dest = bgp_table_top(bgp->rib[afi][safi]);
+				     dest; dest = bgp_route_next(dest)) {
+					for (pi = bgp_dest_get_bgp_path_info(
+						     dest);
+					     pi; pi = pi->next)
+						if (bgp_snap_path_ok(pi))
+							bgp_snap_write_path(
+								&w, afi, safi,
+								bgp_dest_get_prefix(
+									dest),
+								pi);
+				}
+			}
+		}
+	}
+
+	npeers = bgp_snap_peer_idx_count(&w.peers);
+	order = XCALLOC(MTYPE_BGP_RIB_SNAPSHOT, (npeers + 1) * sizeof(*order));
+	while ((ref = bgp_snap_peer_idx_pop(&w.peers)))
+		order[ref->idx] = ref;
+	for (i = 0; i < npeers; i++) {
+		bgp_snap_write_peer(&w, order[i]->peer);
+		XFREE(MTYPE_BGP_RIB_SNAPSHOT, order[i]);
+	}
+	XFREE(MTYPE_BGP_RIB_SNAPSHOT, order);
+	bgp_snap_peer_idx_fini(&w.peers);
+	stream_free(w.s);
+
+	hdr.magic = BGP_SNAP_MAGIC;
+	hdr.version = BGP_SNAP_VERSION;
+	hdr.hdr_size = sizeof(hdr);
+	hdr.peer_size = sizeof(struct bgp_snap_peer);
+	hdr.path_size = sizeof(struct bgp_snap_path);
+	hdr.attr_size = sizeof(struct bgp_snap_attr);
+	hdr.peer_count = npeers;
+	hdr.path_count = w.path_count;
+	hdr.paths_len = w.paths_len;
+	if (fseek(w.fp, 0, SEEK_SET) < 0)
+		w.error = true;
+	bgp_snap_put(&w, &hdr, sizeof(hdr));
+
+	if (fflush(w.fp) || fsync(fileno(w.fp)))
+		w.error = true;
+	if (fclose(w.fp))
+		w.error = true;
+
+	if (w.error || rename(tmppath, path) < 0) {
+		flog_err_sys(EC_LIB_SYSTEM_CALL, "%s: cannot write %s: %s",
+			     __func__, path, safe_strerror(errno));
+		unlink(tmppath);
+		return;
+	}
+
+	if (bgp_debug_neighbor_events(NULL))
+		zlog_debug("%s: %u paths of %u peers written to %s", __func__,
+			   hdr.path_count, hdr.peer_count, path);
+}
+
+static int bgp_snap_write_timer(struct thread *thread)
+{
+	bgp_rib_snapshot_write();
+
+	thread_add_timer(bm->master, bgp_snap_write_timer, NULL,
+			 bgp_snap_interval, &t_bgp_snap_write);
+	return 0;
+}
+
+/*
+ * Restoring
+ *
+ * The snapshot stays mapped until the stale path time has passed, peers
+ * appearing in the configuration before then get their paths back.
+ */
+static struct {
+	uint8_t *data;
+	size_t len;
+	const struct bgp_snap_hdr *hdr;
+	const struct bgp_snap_peer *peers;
+	/* locked references on the peers that got their paths back */
+	struct peer **restored;
+} bgp_snap;
+
+static struct peer *bgp_snap_peer_lookup(const struct bgp_snap_peer *sr)
+{
+	char name[VRF_NAMSIZ + 1], conf_if[INTERFACE_NAMSIZ];
+	union sockunion su = {};
+	struct bgp *bgp;
+
+	strlcpy(name, sr->bgp_name, sizeof(name));
+	strlcpy(conf_if, sr->conf_if, sizeof(conf_if));
+
+	bgp = name[0] ? bgp_lookup_by_name(name) : bgp_get_default();
+	if (!bgp)
+		return NULL;
+
+	if (conf_if[0])
+		return peer_lookup_by_conf_if(bgp, conf_if);
+
+	if (sr->family == AF_INET) {
+		su.sin.sin_family = AF_INET;
+		memcpy(&su.sin.sin_addr, sr->addr, IPV4_MAX_BYTELEN);
+	} else if (sr->family == AF_INET6) {
+		su.sin6.sin6_family = AF_INET6;
+		memcpy(&su.sin6.sin6_addr, sr->addr, IPV6_MAX_BYTELEN);
+	} else
+		return NULL;
+
+	return peer_lookup(bgp, &su);
+}
+
+/* The values come from the file, each parser takes a reference. */
+static bool bgp_snap_attr_get(const struct bgp_snap_path *sp, struct attr *attr)
+{
+	const struct bgp_snap_attr *sa = (const void *)(sp + 1);
+	uint8_t *pnt = (uint8_t *)(sa + 1), *end;
+	struct stream *s;
+
+	if (sp->attr_len < sizeof(*sa))
+		return false;
+	end = (uint8_t *)sa + sp->attr_len;
+	if (BGP_SNAP_PAD(sa->aspath_len) + BGP_SNAP_PAD(sa->cluster_len)
+		    + BGP_SNAP_PAD(sa->community_len)
+		    + BGP_SNAP_PAD(sa->lcommunity_len)
+		    + BGP_SNAP_PAD(sa->ecommunity_len)
+	    != (size_t)(end - pnt))
+		return false;
+	if (sa->flag & ~BGP_SNAP_ATTR_FLAGS)
+		return false;
+
+	memset(attr, 0, sizeof(*attr));
+	attr->flag = sa->flag;
+	attr->mp_nexthop_global = sa->mp_nexthop_global;
+	attr->mp_nexthop_local = sa->mp_nexthop_local;
+	attr->nexthop = sa->nexthop;
+	attr->mp_nexthop_global_in = sa->mp_nexthop_global_in;
+	attr->aggregator_addr = sa->aggregator_addr;
+	attr->originator_id = sa->originator_id;
+	attr->med = sa->med;
+	attr->local_pref = sa->local_pref;
+	attr->weight = sa->weight;
+	attr->tag = sa->tag;
+	attr->aggregator_as = sa->aggregator_as;
+	attr->label = sa->label;
+	attr->label_index = sa->label_index;
+	attr->nh_ifindex = sa->nh_ifindex;
+	attr->nh_lla_ifindex = sa->nh_lla_ifindex;
+	attr->origin = sa->origin;
+	attr->mp_nexthop_len = sa->mp_nexthop_len;
+	attr->mp_nexthop_prefer_global = sa->mp_nexthop_prefer_global;
+
+	if (sa->aspath_len) {
+		s = stream_new(sa->aspath_len);
+		stream_put(s, pnt, sa->aspath_len);
+		attr->aspath = aspath_parse(s, sa->aspath_len, 1);
+		stream_free(s);
+	} else
+		attr->aspath = aspath_empty();
+	pnt += BGP_SNAP_PAD(sa->aspath_len);
+	if (!attr->aspath)
+		return false;
+
+	if (sa->cluster_len)
+		bgp_attr_set_cluster(attr, cluster_parse((struct in_addr *)pnt,
+							 sa->cluster_len));
+	pnt += BGP_SNAP_PAD(sa->cluster_len);
+	if (sa->community_len)
+		attr->community =
+			community_parse((uint32_t *)pnt, sa->community_len);
+	pnt += BGP_SNAP_PAD(sa->community_len);
+	if (sa->lcommunity_len)
+		attr->lcommunity = lcommunity_parse(pnt, sa->lcommunity_len);
+	pnt += BGP_SNAP_PAD(sa->lcommunity_len);
+	if (sa->ecommunity_len)
+		attr->ecommunity = ecommunity_parse(pnt, sa->ecommunity_len);
+
+	if ((sa->community_len && !attr->community)
+	    || (sa->lcommunity_len && !attr->lcommunity)
+	    || (sa->ecommunity_len && !attr->ecommunity)) {
+		bgp_attr_unintern_sub(attr);
+		return false;
+	}
+	return true;
+}
+
+static int bgp_snap_release_timer(struct thread *thread);
+
+static void bgp_snap_restore(void)
+{
+	const struct bgp_snap_hdr *hdr = bgp_snap.hdr;
+	const struct bgp_snap_path *sp;
+	struct peer **peers;
+	struct peer *peer;
+	struct attr attr;
+	struct prefix p;
+	uint8_t *pnt, *end;
+	uint32_t i, restored = 0, paths = 0, stalepath_time = 0;
+
+	if (!hdr)
+		return;
+
+	/* peers configured since the last pass, and not up yet */
+	peers = XCALLOC(MTYPE_BGP_RIB_SNAPSHOT,
+			(hdr->peer_count + 1) * sizeof(*peers));
+	for (i = 0; i < hdr->peer_count; i++) {
+		if (bgp_snap.restored[i])
+			continue;
+		peer = bgp_snap_peer_lookup(&bgp_snap.peers[i]);
+		if (!peer || peer_established(peer)
+		    || CHECK_FLAG(peer->sflags, PEER_STATUS_GROUP))
+			continue;
+		peers[i] = peer;
+		restored++;
+		stalepath_time = MAX(stalepath_time, peer->bgp->stalepath_time);
+	}
+
+	if (!restored) {
+		XFREE(MTYPE_BGP_RIB_SNAPSHOT, peers);
+		return;
+	}
+
+	pnt = bgp_snap.data + hdr->hdr_size;
+	end = pnt + hdr->paths_len;
+	while (pnt + sizeof(*sp) <= end) {
+		sp = (const struct bgp_snap_path *)pnt;
+		if (sp->attr_len > (size_t)(end - pnt) - sizeof(*sp))
+			break;
+		pnt += sizeof(*sp) + sp->attr_len;
+
+		if (sp->peer >= hdr->peer_count || !peers[sp->peer])
+			continue;
+		peer = peers[sp->peer];
+
+		if ((sp->afi != AFI_IP && sp->afi != AFI_IP6)
+		    || (sp->safi != SAFI_UNICAST && sp->safi != SAFI_MULTICAST)
+		    || !peer->afc[sp->afi][sp->safi]
+		    || sp->family != afi2family(sp->afi))
+			continue;
+
+		memset(&p, 0, sizeof(p));
+		p.family = sp->family;
+		p.prefixlen = sp->prefixlen;
+		if (p.prefixlen > prefix_blen(&p) * 8)
+			continue;
+		memcpy(&p.u.prefix, sp->prefix, prefix_blen(&p));
+		apply_mask(&p);
+
+		if (!bgp_snap_attr_get(sp, &attr))
+			continue;
+
+		bgp_path_restore(peer, &p, sp->addpath_rx_id, &attr, sp->afi,
+				 sp->safi);
+		peer->rib_restored[sp->afi][sp->safi] = 1;
+		paths++;
+	}
+
+	for (i = 0; i < hdr->peer_count; i++)
+		if (peers[i])
+			bgp_snap.restored[i] = peer_lock(peers[i]);
+	XFREE(MTYPE_BGP_RIB_SNAPSHOT, peers);
+
+	/* the stale path time is only known now that config has been read */
+	if (t_bgp_snap_release
+	    && stalepath_time > thread_timer_remain_second(t_bgp_snap_release)) {
+		THREAD_OFF(t_bgp_snap_release);
+		thread_add_timer(bm->master, bgp_snap_release_timer, NULL,
+				 stalepath_time, &t_bgp_snap_release);
+	}
+
+	zlog_info("Restored %u paths of %u peers from the RIB snapshot", paths,
+		  restored);
+}
+
+static void bgp_snap_unmap(void)
+{
+	if (!bgp_snap.data)
+		return;
+
+	munmap(bgp_snap.data, bgp_snap.len);
+	memset(&bgp_snap, 0, sizeof(bgp_snap));
+}
+
+/* Peers that never sent End-of-RIB don't get to keep their stale paths */
+static int bgp_snap_release_timer(struct thread *thread)
+{
+	struct peer *peer;
+	uint32_t i;
+	afi_t afi;
+	safi_t safi;
+
+	for (i = 0; bgp_snap.hdr && i < bgp_snap.hdr->peer_count; i++) {
+		peer = bgp_snap.restored[i];
+		if (!peer)
+			continue;
+
+		for (afi = AFI_IP; afi <= AFI_IP6; afi++)
+			for (safi = SAFI_UNICAST; safi <= SAFI_MULTICAST;
+			     safi++) {
+				if (!peer->rib_restored[afi][safi])
+					continue;
+				peer->rib_restored[afi][safi] = 0;
+				if (!peer->nsf[afi][safi]
+				    && !peer->t_refresh_stalepath)
+					bgp_clear_stale_route(peer, afi, safi);
+			}
+		peer_unlock(peer);
+	}
+
+	XFREE(MTYPE_BGP_RIB_SNAPSHOT, bgp_snap.restored);
+	bgp_snap_unmap();
+	return 0;
+}
+
+static void bgp_snap_load(void)
+{
+	const struct bgp_snap_hdr *hdr;
+	char path[512];
+	struct stat st;
+	uint64_t need;
+	void *data;
+	int fd;
+
+	bgp_snap_path_name(path, sizeof(path), "");
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		if (errno != ENOENT)
+			flog_err_sys(EC_LIB_SYSTEM_CALL,
+				     "%s: cannot open %s: %s", __func__, path,
+				     safe_strerror(errno));
+		return;
+	}
+
+	if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(*hdr)) {
+		close(fd);
+		return;
+	}
+
+	data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		flog_err_sys(EC_LIB_SYSTEM_CALL, "%s: cannot map %s: %s",
+			     __func__, path, safe_strerror(errno));
+		return;
+	}
+
+	hdr = data;
+	need = sizeof(*hdr) + hdr->paths_len
+	       + (uint64_t)hdr->peer_count * sizeof(struct bgp_snap_peer);
+	if (hdr->magic != BGP_SNAP_MAGIC || hdr->version != BGP_SNAP_VERSION
+	    || hdr->hdr_size != sizeof(*hdr)
+	    || hdr->peer_size != sizeof(struct bgp_snap_peer)
+	    || hdr->path_size != sizeof(struct bgp_snap_path)
+	    || hdr->attr_size != sizeof(struct bgp_snap_attr)
+	    || need != (uint64_t)st.st_size) {
+		zlog_warn("%s: %s is not a usable RIB snapshot, ignoring",
+			  __func__, path);
+		munmap(data, st.st_size);
+		return;
+	}
+
+	bgp_snap.data = data;
+	bgp_snap.len = st.st_size;
+	bgp_snap.hdr = hdr;
+	bgp_snap.peers = (const struct bgp_snap_peer *)(bgp_snap.data
+							+ sizeof(*hdr)
+							+ hdr->paths_len);
+	bgp_snap.restored = XCALLOC(MTYPE_BGP_RIB_SNAPSHOT,
+				    (hdr->peer_count + 1) * sizeof(struct peer *));
+
+	thread_add_timer(bm->master, bgp_snap_release_timer, NULL,
+			 BGP_DEFAULT_STALEPATH_TIME, &t_bgp_snap_release);
+}
+
+/* the configuration file is read here... */
+static int bgp_snap_config_post(struct thread_master *master)
+{
+	bgp_snap_restore();
+	return 0;
+}
+
+/* ...while integrated configuration comes in from vtysh */
+static void bgp_snap_config_end(void)
+{
+	bgp_snap_restore();
+}
+
+void bgp_rib_snapshot_init(unsigned int interval)
+{
+	bgp_snap_interval = interval;
+	if (!interval)
+		return;
+
+	bgp_snap_load();
+	hook_register(frr_config_post, bgp_snap_config_post);
+	cmd_init_config_callbacks(NULL, bgp_snap_config_end);
+
+	thread_add_timer(bm->master, bgp_snap_write_timer, NULL, interval,
+			 &t_bgp_snap_write);
+}
+
+void bgp_rib_snapshot_finish(void)
+{
+	struct thread t = {};
+
+	THREAD_OFF(t_bgp_snap_write);
+	if (t_bgp_snap_release) {
+		THREAD_OFF(t_bgp_snap_release);
+		bgp_snap_release_timer(&t);
+	}
+}
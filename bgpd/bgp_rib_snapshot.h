@@ -0,0 +1,47 @@
+/*
+ * BGP Adj-RIB-In snapshot for fast restarts.
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _FRR_BGP_RIB_SNAPSHOT_H
+#define _FRR_BGP_RIB_SNAPSHOT_H
+
+/*
+ * With --rib-snapshot, the unicast and multicast paths received from each
+ * configured peer are written to a file in the runtime directory
+ * periodically and at shutdown.  When bgpd starts again, the paths of each
+ * peer showing up in the configuration are put back as stale paths, so best
+ * path selection and the FIB have a full table right away.  The peer's
+ * updates refresh them, and whatever is still stale at its End-of-RIB (or
+ * after the stale path time) is removed.
+ */
+
+/*
+ * Write a snapshot every 'interval' seconds; 0 disables snapshots.  Also
+ * loads the previous snapshot, which is applied once the configuration has
+ * been read.
+ */
+extern void bgp_rib_snapshot_init(unsigned int interval);
+
+/*
+ * Write a snapshot now; at shutdown, before the peers are torn down.
+ */
+extern void bgp_rib_snapshot_write(void);
+
+extern void bgp_rib_snapshot_finish(void);
+
+#endif /* _FRR_BGP_RIB_SNAPSHOT_H */
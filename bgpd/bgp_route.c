@@ -37,6 +37,8 @@
 #include "plist.h"
 #include "thread.h"
 #include "workqueue.h"
+#include "hash.h"
+#include "jhash.h"
 #include "queue.h"
 #include "memory.h"
 #include "srv6.h"
@@ -74,6 +76,7 @@
 #include "bgpd/bgp_network.h"
 #include "bgpd/bgp_trace.h"
 #include "bgpd/bgp_rpki.h"
+#include "bgpd/bgp_worker_pool.h"
 
 #ifdef ENABLE_BGP_VNC
 #include "bgpd/rfapi/rfapi_backend.h"
@@ -88,6 +91,7 @@
 #include "bgpd/bgp_flowspec.h"
 #include "bgpd/bgp_flowspec_util.h"
 #include "bgpd/bgp_pbr.h"
+#include "bgpd/bgp_conditional_adv.h"
 #include "northbound.h"
 #include "northbound_cli.h"
 #include "bgpd/bgp_nb.h"
@@ -127,6 +131,11 @@ static const struct message bgp_pmsi_tnltype_str[] = {
 #define VRFID_NONE_STR "-"
 #define SOFT_RECONFIG_TASK_MAX_PREFIX 25000
 
+DEFINE_HOOK(bgp_route_update,
+	    (struct bgp * bgp, afi_t afi, safi_t safi, struct bgp_dest *bn,
+	     struct bgp_path_info *old_route, struct bgp_path_info *new_route),
+	    (bgp, afi, safi, bn, old_route, new_route));
+
 DEFINE_HOOK(bgp_process,
 	    (struct bgp * bgp, afi_t afi, safi_t safi, struct bgp_dest *bn,
 	     struct peer *peer, bool withdraw),
@@ -399,8 +408,32 @@ static int bgp_dest_set_defer_flag(struct bgp_dest *dest, bool delete)
 	return -1;
 }
 
+/* The index of the peer's paths that 'dest' is in, if it is in the peer's
+ * own bgp->rib (or one of its per-RD tables); paths in other tables, e.g.
+ * the EVPN per-VNI ones, aren't cleared together with the peer.
+ */
+static struct bgp_peer_paths_head *bgp_peer_paths_head(struct bgp_dest *dest,
+							struct peer *peer)
+{
+	struct bgp_table *table = bgp_dest_table(dest);
+	struct bgp_table *rib;
+
+	if (!table || !peer->bgp)
+		return NULL;
+
+	rib = peer->bgp->rib[table->afi][table->safi];
+	if (dest->pdest) {
+		if (bgp_dest_table(dest->pdest) != rib)
+			return NULL;
+	} else if (table != rib)
+		return NULL;
+
+	return &peer->paths[table->afi][table->safi];
+}
+
 void bgp_path_info_add(struct bgp_dest *dest, struct bgp_path_info *pi)
 {
+	struct bgp_peer_paths_head *peer_paths;
 	struct bgp_path_info *top;
 
 	top = bgp_dest_get_bgp_path_info(dest);
@@ -411,6 +444,10 @@ void bgp_path_info_add(struct bgp_dest *dest, struct bgp_path_info *pi)
 		top->prev = pi;
 	bgp_dest_set_bgp_path_info(dest, pi);
 
+	peer_paths = bgp_peer_paths_head(dest, pi->peer);
+	if (peer_paths)
+		bgp_peer_paths_add_tail(peer_paths, pi);
+
 	bgp_path_info_lock(pi);
 	bgp_dest_lock_node(dest);
 	peer_lock(pi->peer); /* bgp_path_info peer reference */
@@ -422,6 +459,15 @@ void bgp_path_info_add(struct bgp_dest *dest, struct bgp_path_info *pi)
    completion callback *only* */
 void bgp_path_info_reap(struct bgp_dest *dest, struct bgp_path_info *pi)
 {
+	struct bgp_peer_paths_head *peer_paths;
+
+	/* a bestpath worker may have picked this one */
+	UNSET_FLAG(dest->flags, BGP_NODE_BESTPATH_PRESEL);
+
+	peer_paths = bgp_peer_paths_head(dest, pi->peer);
+	if (peer_paths)
+		bgp_peer_paths_del(peer_paths, pi);
+
 	if (pi->next)
 		pi->next->prev = pi->prev;
 	if (pi->prev)
@@ -1353,11 +1399,46 @@ int bgp_path_info_cmp_compatible(struct bgp *bgp, struct bgp_path_info *new,
 	return ret;
 }
 
+/*
+ * The loop checks of bgp_update() only look at the attribute, so for all the
+ * prefixes of an UPDATE they can be done just once, see bgp_nlri_parse_ip().
+ */
+enum bgp_update_loop {
+	BGP_UPDATE_LOOP_NONE = 0,
+	BGP_UPDATE_LOOP_ASPATH,
+	BGP_UPDATE_LOOP_ORIGINATOR,
+	BGP_UPDATE_LOOP_CLUSTER,
+};
+
+/*
+ * Inbound policy outcomes that don't depend on the prefix, shared by the
+ * prefixes of an UPDATE since they all come with the same attribute.
+ */
+struct bgp_update_cache {
+	enum bgp_update_loop loop;
+	/* outcome of the filter-list, -1 until it was applied */
+	int aslist;
+	/* last outcome of the route-map, see bgp_rmap_memo_apply() */
+	struct route_map *rmap;
+	struct route_map_memo_key key;
+	struct attr *out; /* NULL if denied */
+};
+
+static void bgp_update_cache_init(struct bgp_update_cache *cache)
+{
+	memset(cache, 0, sizeof(*cache));
+	cache->aslist = -1;
+}
+
+static void bgp_update_cache_fini(struct bgp_update_cache *cache);
+
 static enum filter_type bgp_input_filter(struct peer *peer,
 					 const struct prefix *p,
 					 struct attr *attr, afi_t afi,
-					 safi_t safi)
+					 safi_t safi,
+					 struct bgp_update_cache *cache)
 {
+	enum as_filter_type aslist;
 	struct bgp_filter *filter;
 	enum filter_type ret = FILTER_PERMIT;
 
@@ -1391,8 +1472,15 @@ static enum filter_type bgp_input_filter(struct peer *peer,
 	if (FILTER_LIST_IN_NAME(filter)) {
 		FILTER_EXIST_WARN(FILTER_LIST, as, filter);
 
-		if (as_list_apply(FILTER_LIST_IN(filter), attr->aspath)
-		    == AS_FILTER_DENY) {
+		if (cache && cache->aslist >= 0)
+			aslist = cache->aslist;
+		else
+			aslist = as_list_apply(FILTER_LIST_IN(filter),
+					       attr->aspath);
+		if (cache)
+			cache->aslist = aslist;
+
+		if (aslist == AS_FILTER_DENY) {
 			ret = FILTER_DENY;
 			goto done;
 		}
@@ -1510,10 +1598,202 @@ static bool bgp_cluster_filter(struct peer *peer, struct attr *attr)
 	return false;
 }
 
+/*
+ * Memoized outcome of the inbound route-map, see route_map_memo_key().  The
+ * object a BGP route-map looks at is the path's attribute and peer; the peer
+ * is implied by the table the entry lives in.
+ */
+struct bgp_rmap_memo {
+	struct route_map *map;
+	struct route_map_memo_key key;
+	struct attr *in;
+	struct attr *out; /* NULL if denied */
+};
+
+/* The table only has to catch the prefixes of an UPDATE or of a table dump
+ * sharing an attribute, it is flushed when it gets this large.
+ */
+#define BGP_RMAP_MEMO_MAX 4096
+
+/* The tables are per peer, but interning touches the global attribute hashes
+ * and the soft reconfiguration workers may get here for different peers at
+ * the same time.
+ */
+static pthread_mutex_t bgp_rmap_memo_mtx = PTHREAD_MUTEX_INITIALIZER;
+
+static unsigned int bgp_rmap_memo_hash_key(const void *arg)
+{
+	const struct bgp_rmap_memo *memo = arg;
+
+	return jhash_3words(attrhash_key_make(memo->in),
+			    (uint32_t)(memo->key.plist ^ (memo->key.plist >> 32)),
+			    (uint32_t)(uintptr_t)memo->map, memo->key.family);
+}
+
+static bool bgp_rmap_memo_cmp(const void *arg1, const void *arg2)
+{
+	const struct bgp_rmap_memo *memo1 = arg1;
+	const struct bgp_rmap_memo *memo2 = arg2;
+
+	return memo1->map == memo2->map && memo1->key.gen == memo2->key.gen
+	       && memo1->key.plist == memo2->key.plist
+	       && memo1->key.family == memo2->key.family
+	       && attrhash_cmp(memo1->in, memo2->in);
+}
+
+static void bgp_rmap_memo_free(void *arg)
+{
+	struct bgp_rmap_memo *memo = arg;
+
+	bgp_attr_unintern(&memo->in);
+	if (memo->out)
+		bgp_attr_unintern(&memo->out);
+	XFREE(MTYPE_BGP_RMAP_MEMO, memo);
+}
+
+static void bgp_update_cache_fini(struct bgp_update_cache *cache)
+{
+	if (cache->out)
+		frr_with_mutex(&bgp_rmap_memo_mtx) {
+			bgp_attr_unintern(&cache->out);
+		}
+}
+
+void bgp_rmap_memo_clean(struct hash **memosp)
+{
+	if (!*memosp)
+		return;
+
+	frr_with_mutex(&bgp_rmap_memo_mtx) {
+		hash_clean(*memosp, bgp_rmap_memo_free);
+	}
+	hash_free(*memosp);
+	*memosp = NULL;
+}
+
+void bgp_rmap_memo_finish(struct peer *peer)
+{
+	bgp_rmap_memo_clean(&peer->rmap_memo);
+}
+
+/*
+ * route_map_apply() for the route-map of a peer or update subgroup.  Paths
+ * with equal attributes mostly get the same treatment, so the outcome is
+ * memoized in *memosp and replayed.  Only attributes made of interned parts
+ * are looked up: on a hit the result replaces the attribute wholesale and the
+ * caller does not get to free parts it may own.  *hit is set to whether the
+ * outcome came from the table, it is left alone if the map or the attribute
+ * can't be memoized.
+ *
+ * The prefixes of an UPDATE share their attribute, the last outcome is kept
+ * in the UPDATE's cache to save the table lookup for the prefixes after the
+ * first one.
+ */
+static route_map_result_t bgp_rmap_memo_apply(struct hash **memosp,
+					      uint64_t *memo_gen,
+					      struct route_map *rmap,
+					      const struct prefix *p,
+					      struct bgp_path_info *path,
+					      struct bgp_update_cache *cache,
+					      int *hit)
+{
+	struct bgp_rmap_memo lookup, *memo;
+	struct attr *attr = path->attr;
+	struct attr in;
+	route_map_result_t ret;
+
+	if (!rmap || !route_map_memo_key(rmap, p, &lookup.key)
+	    || !bgp_attr_parts_interned(attr))
+		return route_map_apply(rmap, p, path);
+
+	if (hit)
+		*hit = 1;
+
+	if (cache && cache->rmap == rmap && cache->key.gen == lookup.key.gen
+	    && cache->key.plist == lookup.key.plist
+	    && cache->key.family == lookup.key.family) {
+		route_map_memo_count(rmap, true);
+		if (!cache->out)
+			return RMAP_DENYMATCH;
+
+		*attr = *cache->out;
+		attr->refcnt = 0;
+		return RMAP_PERMITMATCH;
+	}
+
+	if (*memosp && *memo_gen != lookup.key.gen)
+		frr_with_mutex(&bgp_rmap_memo_mtx) {
+			hash_clean(*memosp, bgp_rmap_memo_free);
+		}
+	*memo_gen = lookup.key.gen;
+
+	if (!*memosp)
+		*memosp = hash_create(bgp_rmap_memo_hash_key, bgp_rmap_memo_cmp,
+				      "BGP route-map memo");
+
+	lookup.map = rmap;
+	lookup.in = attr;
+	memo = hash_lookup(*memosp, &lookup);
+	if (memo) {
+		route_map_memo_count(rmap, true);
+		ret = memo->out ? RMAP_PERMITMATCH : RMAP_DENYMATCH;
+		if (memo->out) {
+			/* the parts stay owned by memo->out, just like the
+			 * parts of a newly received attribute are owned by the
+			 * parser
+			 */
+			*attr = *memo->out;
+			attr->refcnt = 0;
+		}
+	} else {
+		route_map_memo_count(rmap, false);
+		if (hit)
+			*hit = 0;
+
+		in = *attr;
+		memo = XCALLOC(MTYPE_BGP_RMAP_MEMO, sizeof(*memo));
+		memo->map = rmap;
+		memo->key = lookup.key;
+		frr_with_mutex(&bgp_rmap_memo_mtx) {
+			memo->in = bgp_attr_intern(&in);
+		}
+
+		ret = route_map_apply(rmap, p, path);
+
+		frr_with_mutex(&bgp_rmap_memo_mtx) {
+			/* interning converts whatever the set clauses
+			 * allocated in place
+			 */
+			if (ret != RMAP_DENYMATCH)
+				memo->out = bgp_attr_intern(attr);
+
+			if (hashcount(*memosp) >= BGP_RMAP_MEMO_MAX)
+				hash_clean(*memosp, bgp_rmap_memo_free);
+		}
+		(void)hash_get(*memosp, memo, hash_alloc_intern);
+	}
+
+	/* the table may be flushed before the next prefix comes along, so
+	 * the cache holds its own reference
+	 */
+	if (cache) {
+		bgp_update_cache_fini(cache);
+		cache->rmap = rmap;
+		cache->key = lookup.key;
+		if (memo->out)
+			frr_with_mutex(&bgp_rmap_memo_mtx) {
+				cache->out = bgp_attr_intern(memo->out);
+			}
+	}
+
+	return ret;
+}
+
 static int bgp_input_modifier(struct peer *peer, const struct prefix *p,
 			      struct attr *attr, afi_t afi, safi_t safi,
 			      const char *rmap_name, mpls_label_t *label,
-			      uint32_t num_labels, struct bgp_dest *dest)
+			      uint32_t num_labels, struct bgp_dest *dest,
+			      struct bgp_update_cache *cache)
 {
 	struct bgp_filter *filter;
 	struct bgp_path_info rmap_path = { 0 };
@@ -1557,8 +1837,15 @@ static int bgp_input_modifier(struct peer *peer, const struct prefix *p,
 
 		SET_FLAG(peer->rmap_type, PEER_RMAP_TYPE_IN);
 
-		/* Apply BGP route map to the attribute. */
-		ret = route_map_apply(rmap, p, &rmap_path);
+		/* Apply BGP route map to the attribute.  Lookups of a named
+		 * map come from show commands, only memoize the real thing.
+		 */
+		if (rmap_name)
+			ret = route_map_apply(rmap, p, &rmap_path);
+		else
+			ret = bgp_rmap_memo_apply(&peer->rmap_memo,
+						  &peer->rmap_memo_gen, rmap, p,
+						  &rmap_path, cache, NULL);
 
 		peer->rmap_type = 0;
 
@@ -1720,8 +2007,12 @@ void bgp_attr_add_gshut_community(struct attr *attr)
 }
 
 
-/* Notify BGP Conditional advertisement scanner process. */
-void bgp_notify_conditional_adv_scanner(struct update_subgroup *subgrp)
+/* Notify BGP Conditional advertisement scanner process that dest was
+ * announced to subgrp, the state of the advertise-map routes might have to
+ * be restored.
+ */
+void bgp_notify_conditional_adv_scanner(struct update_subgroup *subgrp,
+					struct bgp_dest *dest)
 {
 	struct peer *temp_peer;
 	struct peer *peer = SUBGRP_PEER(subgrp);
@@ -1734,6 +2025,11 @@ void bgp_notify_conditional_adv_scanner(struct update_subgroup *subgrp)
 	if (!ADVERTISE_MAP_NAME(filter))
 		return;
 
+	if (ADVERTISE_MAP(filter)
+	    && !route_map_may_permit(ADVERTISE_MAP(filter),
+				     bgp_dest_get_prefix(dest)))
+		return;
+
 	for (ALL_LIST_ELEMENTS(bgp->peer, temp_node, temp_nnode, temp_peer)) {
 		if (!CHECK_FLAG(peer->flags, PEER_FLAG_CONFIG_NODE))
 			continue;
@@ -1741,7 +2037,7 @@ void bgp_notify_conditional_adv_scanner(struct update_subgroup *subgrp)
 		if (peer != temp_peer)
 			continue;
 
-		temp_peer->advmap_table_change = true;
+		bgp_conditional_adv_table_change(temp_peer);
 		break;
 	}
 }
@@ -1833,7 +2129,7 @@ bool subgroup_announce_check(struct bgp_dest *dest, struct bgp_path_info *pi,
 	 * addpath
 	 * feature that requires us to advertise it */
 	if (!CHECK_FLAG(pi->flags, BGP_PATH_SELECTED)) {
-		if (!bgp_addpath_tx_path(peer->addpath_type[afi][safi], pi)) {
+		if (!bgp_addpath_capable(pi, peer, afi, safi)) {
 			return false;
 		}
 	}
@@ -2082,6 +2378,7 @@ bool subgroup_announce_check(struct bgp_dest *dest, struct bgp_path_info *pi,
 		struct bgp_path_info rmap_path = {0};
 		struct bgp_path_info_extra dummy_rmap_path_extra = {0};
 		struct attr dummy_attr = {0};
+		int hit;
 
 		/* Fill temp path_info */
 		prep_for_rmap_apply(&rmap_path, &dummy_rmap_path_extra, dest,
@@ -2103,15 +2400,21 @@ bool subgroup_announce_check(struct bgp_dest *dest, struct bgp_path_info *pi,
 
 		SET_FLAG(peer->rmap_type, PEER_RMAP_TYPE_OUT);
 
-		if (bgp_path_suppressed(pi))
-			ret = route_map_apply(UNSUPPRESS_MAP(filter), p,
-					      &rmap_path);
-		else
-			ret = route_map_apply(ROUTE_MAP_OUT(filter), p,
-					      &rmap_path);
+		hit = -1;
+		ret = bgp_rmap_memo_apply(&subgrp->rmap_memo,
+					  &subgrp->rmap_memo_gen,
+					  bgp_path_suppressed(pi)
+						  ? UNSUPPRESS_MAP(filter)
+						  : ROUTE_MAP_OUT(filter),
+					  p, &rmap_path, NULL, &hit);
 
 		peer->rmap_type = 0;
 
+		if (hit > 0)
+			subgrp->rmap_memo_hits++;
+		else if (hit == 0)
+			subgrp->rmap_memo_misses++;
+
 		if (ret == RMAP_DENYMATCH) {
 			if (bgp_debug_update(NULL, p, subgrp->update_group, 0))
 				zlog_debug(
@@ -2305,10 +2608,18 @@ static int bgp_route_select_timer_expire(struct thread *thread)
 	return bgp_best_path_select_defer(bgp, afi, safi);
 }
 
-void bgp_best_selection(struct bgp *bgp, struct bgp_dest *dest,
-			struct bgp_maxpaths_cfg *mpath_cfg,
-			struct bgp_path_info_pair *result, afi_t afi,
-			safi_t safi)
+/*
+ * Pick the best path of dest, leaving the multipath and addpath state alone.
+ *
+ * With old_selectp == NULL this doesn't free anything and only writes to
+ * dest and the paths hanging off it, so bestpath worker pthreads can run it
+ * on disjoint sets of dests while the main pthread waits for them.
+ */
+static struct bgp_path_info *
+bgp_best_selection_scan(struct bgp *bgp, struct bgp_dest *dest,
+			struct bgp_maxpaths_cfg *mpath_cfg, int debug,
+			char *pfx_buf, afi_t afi, safi_t safi,
+			struct bgp_path_info **old_selectp)
 {
 	struct bgp_path_info *new_select;
 	struct bgp_path_info *old_select;
@@ -2316,20 +2627,9 @@ void bgp_best_selection(struct bgp *bgp, struct bgp_dest *dest,
 	struct bgp_path_info *pi1;
 	struct bgp_path_info *pi2;
 	struct bgp_path_info *nextpi = NULL;
-	int paths_eq, do_mpath, debug;
-	struct list mp_list;
-	char pfx_buf[PREFIX2STR_BUFFER];
+	int paths_eq;
 	char path_buf[PATH_ADDPATH_STR_BUFFER];
 
-	bgp_mp_list_init(&mp_list);
-	do_mpath =
-		(mpath_cfg->maxpaths_ebgp > 1 || mpath_cfg->maxpaths_ibgp > 1);
-
-	debug = bgp_debug_bestpath(dest);
-
-	if (debug)
-		prefix2str(bgp_dest_get_prefix(dest), pfx_buf, sizeof(pfx_buf));
-
 	dest->reason = bgp_path_selection_none;
 	/* bgp deterministic-med */
 	new_select = NULL;
@@ -2420,7 +2720,7 @@ void bgp_best_selection(struct bgp *bgp, struct bgp_dest *dest,
 			/* reap REMOVED routes, if needs be
 			 * selected route must stay for a while longer though
 			 */
-			if (CHECK_FLAG(pi->flags, BGP_PATH_REMOVED)
+			if (old_selectp && CHECK_FLAG(pi->flags, BGP_PATH_REMOVED)
 			    && (pi != old_select))
 				bgp_path_info_reap(dest, pi);
 
@@ -2464,6 +2764,110 @@ void bgp_best_selection(struct bgp *bgp, struct bgp_dest *dest,
 		}
 	}
 
+	if (old_selectp)
+		*old_selectp = old_select;
+	return new_select;
+}
+
+/*
+ * Rank the paths of dest for addpath-tx-best-selected: the bestpath is
+ * first, each next one the best of the paths left.  Ranking stops at the
+ * most paths any peer is sent, the ranks are shared by all of the update
+ * groups sending them.
+ */
+static void bgp_addpath_rank_paths(struct bgp *bgp, struct bgp_dest *dest,
+				   struct bgp_path_info *new_select, afi_t afi,
+				   safi_t safi)
+{
+	uint8_t max = bgp->tx_addpath.best_selected_max[afi][safi];
+	enum bgp_path_selection_reason reason;
+	char pfx_buf[PREFIX2STR_BUFFER] = "";
+	struct bgp_path_info *pi, *best;
+	int paths_eq;
+	uint8_t rank;
+
+	for (pi = bgp_dest_get_bgp_path_info(dest); pi; pi = pi->next)
+		pi->tx_addpath.best_selected_rank = 0;
+
+	if (!new_select)
+		return;
+
+	new_select->tx_addpath.best_selected_rank = 1;
+
+	for (rank = 2; rank <= max; rank++) {
+		best = NULL;
+		for (pi = bgp_dest_get_bgp_path_info(dest); pi; pi = pi->next) {
+			if (pi->tx_addpath.best_selected_rank)
+				continue;
+
+			if (BGP_PATH_HOLDDOWN(pi))
+				continue;
+
+			if (bgp_path_info_cmp(bgp, pi, best, &paths_eq, NULL, 0,
+					      pfx_buf, afi, safi, &reason))
+				best = pi;
+		}
+		if (!best)
+			break;
+
+		best->tx_addpath.best_selected_rank = rank;
+	}
+}
+
+/* presel: if non-NULL, the best path was already picked by a bestpath worker
+ * and only needs to be checked for still being eligible.
+ */
+static void bgp_best_selection_presel(struct bgp *bgp, struct bgp_dest *dest,
+				      struct bgp_maxpaths_cfg *mpath_cfg,
+				      struct bgp_path_info_pair *result,
+				      afi_t afi, safi_t safi,
+				      struct bgp_path_info **presel)
+{
+	struct bgp_path_info *new_select;
+	struct bgp_path_info *old_select;
+	struct bgp_path_info *pi;
+	struct bgp_path_info *nextpi = NULL;
+	int paths_eq, do_mpath, debug;
+	struct list mp_list;
+	char pfx_buf[PREFIX2STR_BUFFER];
+	char path_buf[PATH_ADDPATH_STR_BUFFER];
+
+	bgp_mp_list_init(&mp_list);
+	do_mpath =
+		(mpath_cfg->maxpaths_ebgp > 1 || mpath_cfg->maxpaths_ibgp > 1);
+
+	debug = bgp_debug_bestpath(dest);
+
+	if (debug)
+		prefix2str(bgp_dest_get_prefix(dest), pfx_buf, sizeof(pfx_buf));
+
+	new_select = presel ? *presel : NULL;
+	if (new_select
+	    && (BGP_PATH_HOLDDOWN(new_select)
+		|| (new_select->peer && new_select->peer != bgp->peer_self
+		    && !CHECK_FLAG(new_select->peer->sflags,
+				   PEER_STATUS_NSF_WAIT)
+		    && !peer_established(new_select->peer))))
+		presel = NULL;
+
+	if (presel) {
+		/* same reaping as in bgp_best_selection_scan() */
+		old_select = NULL;
+		for (pi = bgp_dest_get_bgp_path_info(dest);
+		     (pi != NULL) && (nextpi = pi->next, 1); pi = nextpi) {
+			if (CHECK_FLAG(pi->flags, BGP_PATH_SELECTED))
+				old_select = pi;
+
+			if (BGP_PATH_HOLDDOWN(pi)
+			    && CHECK_FLAG(pi->flags, BGP_PATH_REMOVED)
+			    && (pi != old_select))
+				bgp_path_info_reap(dest, pi);
+		}
+	} else
+		new_select = bgp_best_selection_scan(bgp, dest, mpath_cfg,
+						     debug, pfx_buf, afi, safi,
+						     &old_select);
+
 	/* Now that we know which path is the bestpath see if any of the other
 	 * paths
 	 * qualify as multipaths
@@ -2533,6 +2937,9 @@ void bgp_best_selection(struct bgp *bgp, struct bgp_dest *dest,
 	bgp_path_info_mpath_aggregate_update(new_select, old_select);
 	bgp_mp_list_clear(&mp_list);
 
+	if (bgp->tx_addpath.peercount[afi][safi][BGP_ADDPATH_BEST_SELECTED])
+		bgp_addpath_rank_paths(bgp, dest, new_select, afi, safi);
+
 	bgp_addpath_update_ids(bgp, dest, afi, safi);
 
 	result->old = old_select;
@@ -2541,6 +2948,15 @@ void bgp_best_selection(struct bgp *bgp, struct bgp_dest *dest,
 	return;
 }
 
+void bgp_best_selection(struct bgp *bgp, struct bgp_dest *dest,
+			struct bgp_maxpaths_cfg *mpath_cfg,
+			struct bgp_path_info_pair *result, afi_t afi,
+			safi_t safi)
+{
+	bgp_best_selection_presel(bgp, dest, mpath_cfg, result, afi, safi,
+				  NULL);
+}
+
 /*
  * A new route/change in bestpath of an existing route. Evaluate the path
  * for advertisement to the subgroup.
@@ -2729,7 +3145,8 @@ static void bgp_process_evpn_route_injection(struct bgp *bgp, afi_t afi,
  *     is being removed.
  */
 static void bgp_process_main_one(struct bgp *bgp, struct bgp_dest *dest,
-				 afi_t afi, safi_t safi)
+				 afi_t afi, safi_t safi,
+				 struct bgp_path_info **presel)
 {
 	struct bgp_path_info *new_select;
 	struct bgp_path_info *old_select;
@@ -2778,11 +3195,16 @@ static void bgp_process_main_one(struct bgp *bgp, struct bgp_dest *dest,
 	}
 
 	/* Best path selection. */
-	bgp_best_selection(bgp, dest, &bgp->maxpaths[afi][safi], &old_and_new,
-			   afi, safi);
+	bgp_best_selection_presel(bgp, dest, &bgp->maxpaths[afi][safi],
+				  &old_and_new, afi, safi, presel);
 	old_select = old_and_new.old;
 	new_select = old_and_new.new;
 
+	if (safi == SAFI_UNICAST)
+		conv_stage(bm->conv, bgp->vrf_id, p, BGP_CONV_BESTPATH);
+
+	bgp_conditional_adv_process(bgp, afi, safi, dest);
+
 	/* Do we need to allocate or free labels?
 	 * Right now, since we only deal with per-prefix labels, it is not
 	 * necessary to do this upon changes to best path. Exceptions:
@@ -2866,6 +3288,8 @@ static void bgp_process_main_one(struct bgp *bgp, struct bgp_dest *dest,
 		if (CHECK_FLAG(old_select->flags, BGP_PATH_ATTR_CHANGED)
 		    || CHECK_FLAG(old_select->flags, BGP_PATH_LINK_BW_CHG)
 		    || CHECK_FLAG(dest->flags, BGP_NODE_LABEL_CHANGED)) {
+			hook_call(bgp_route_update, bgp, afi, safi, dest,
+				  old_select, new_select);
 			group_announce_route(bgp, afi, safi, dest, new_select);
 
 			/* unicast routes must also be annouced to
@@ -2939,6 +3363,9 @@ static void bgp_process_main_one(struct bgp *bgp, struct bgp_dest *dest,
 	}
 #endif
 
+	hook_call(bgp_route_update, bgp, afi, safi, dest, old_select,
+		  new_select);
+
 	group_announce_route(bgp, afi, safi, dest, new_select);
 
 	/* unicast routes must also be annouced to labeled-unicast update-groups
@@ -3019,7 +3446,7 @@ int bgp_best_path_select_defer(struct bgp *bgp, afi_t afi, safi_t safi)
 
 		UNSET_FLAG(dest->flags, BGP_NODE_SELECT_DEFER);
 		bgp->gr_info[afi][safi].gr_deferred--;
-		bgp_process_main_one(bgp, dest, afi, safi);
+		bgp_process_main_one(bgp, dest, afi, safi, NULL);
 		cnt++;
 		if (cnt >= BGP_MAX_BEST_ROUTE_SELECT) {
 			bgp_dest_unlock_node(dest);
@@ -3051,6 +3478,109 @@ int bgp_best_path_select_defer(struct bgp *bgp, afi_t afi, safi_t safi)
 	return 0;
 }
 
+/* Smaller batches aren't worth waking up the bestpath workers for */
+#define BGP_BESTPATH_PARALLEL_MIN 256
+
+struct bgp_process_batch {
+	struct bgp *bgp;
+	size_t count;
+	struct bgp_process_batch_item {
+		struct bgp_dest *dest;
+		struct bgp_path_info *best;
+		/* UINT_MAX if done on the main pthread only */
+		unsigned int shard;
+	} *items;
+};
+
+static void bgp_process_parallel_shard(void *arg, unsigned int shard)
+{
+	struct bgp_process_batch *batch = arg;
+	struct bgp_process_batch_item *item;
+	struct bgp_table *table;
+	size_t i;
+
+	for (i = 0; i < batch->count; i++) {
+		item = &batch->items[i];
+		if (item->shard != shard)
+			continue;
+
+		table = bgp_dest_table(item->dest);
+		item->best = bgp_best_selection_scan(
+			batch->bgp, item->dest,
+			&batch->bgp->maxpaths[table->afi][table->safi], 0, NULL,
+			table->afi, table->safi, NULL);
+	}
+}
+
+/*
+ * Run best path selection for everything currently on pqnode in two steps:
+ * the bestpath workers pick the best path of each dest, sharded by prefix
+ * hash, and then the main pthread goes through the dests in order to do
+ * everything else (multipath, zebra, update-groups, ...) as usual.
+ *
+ * A dest whose paths change between the two steps (it gets bgp_process()ed
+ * again, or a path is reaped) loses BGP_NODE_BESTPATH_PRESEL and is done
+ * from scratch in the second step.
+ */
+static void bgp_process_parallel(struct bgp *bgp,
+				 struct bgp_process_queue *pqnode)
+{
+	struct bgp_process_batch batch = {.bgp = bgp};
+	struct bgp_process_batch_item *item;
+	struct bgp_table *table;
+	struct bgp_dest *dest;
+	unsigned int nshards = bgp_worker_pool_size(bgp_bestpath_pool) + 1;
+	size_t i, count = 0;
+
+	STAILQ_FOREACH (dest, &pqnode->pqueue, pq)
+		count++;
+
+	batch.items = XCALLOC(MTYPE_TMP, count * sizeof(*batch.items));
+
+	while (!STAILQ_EMPTY(&pqnode->pqueue)) {
+		dest = STAILQ_FIRST(&pqnode->pqueue);
+		STAILQ_REMOVE_HEAD(&pqnode->pqueue, pq);
+		STAILQ_NEXT(dest, pq) = NULL; /* complete unlink */
+		table = bgp_dest_table(dest);
+
+		item = &batch.items[batch.count++];
+		item->dest = dest;
+		item->shard = UINT_MAX;
+
+		/* EVPN best path selection has side effects on other dests */
+		if (table->safi == SAFI_EVPN
+		    || CHECK_FLAG(dest->flags, BGP_NODE_SELECT_DEFER)
+		    || bgp_debug_bestpath(dest))
+			continue;
+
+		item->shard = prefix_hash_key(bgp_dest_get_prefix(dest))
+			      % nshards;
+		SET_FLAG(dest->flags, BGP_NODE_BESTPATH_PRESEL);
+	}
+
+	bgp_worker_pool_run(bgp_bestpath_pool, bgp_process_parallel_shard,
+			    &batch);
+
+	for (i = 0; i < batch.count; i++) {
+		item = &batch.items[i];
+		dest = item->dest;
+		table = bgp_dest_table(dest);
+
+		/* note, new DESTs may be added as part of processing */
+		bgp_process_main_one(
+			bgp, dest, table->afi, table->safi,
+			CHECK_FLAG(dest->flags, BGP_NODE_BESTPATH_PRESEL)
+				? &item->best
+				: NULL);
+		UNSET_FLAG(dest->flags, BGP_NODE_BESTPATH_PRESEL);
+
+		bgp_dest_unlock_node(dest);
+		bgp_table_unlock(table);
+	}
+
+	XFREE(MTYPE_TMP, batch.items);
+}
+
 static wq_item_status bgp_process_wq(struct work_queue *wq, void *data)
 {
 	struct bgp_process_queue *pqnode = data;
@@ -3060,19 +3590,24 @@ static wq_item_status bgp_process_wq(struct work_queue *wq, void *data)
 
 	/* eoiu marker */
 	if (CHECK_FLAG(pqnode->flags, BGP_PROCESS_QUEUE_EOIU_MARKER)) {
-		bgp_process_main_one(bgp, NULL, 0, 0);
+		bgp_process_main_one(bgp, NULL, 0, 0, NULL);
 		/* should always have dedicated wq call */
 		assert(STAILQ_FIRST(&pqnode->pqueue) == NULL);
 		return WQ_SUCCESS;
 	}
 
+	if (bgp_worker_pool_size(bgp_bestpath_pool)
+	    && pqnode->queued >= BGP_BESTPATH_PARALLEL_MIN
+	    && !CHECK_FLAG(bgp->flags, BGP_FLAG_DELETE_IN_PROGRESS))
+		bgp_process_parallel(bgp, pqnode);
+
 	while (!STAILQ_EMPTY(&pqnode->pqueue)) {
 		dest = STAILQ_FIRST(&pqnode->pqueue);
 		STAILQ_REMOVE_HEAD(&pqnode->pqueue, pq);
 		STAILQ_NEXT(dest, pq) = NULL; /* complete unlink */
 		table = bgp_dest_table(dest);
 		/* note, new DESTs may be added as part of processing */
-		bgp_process_main_one(bgp, dest, table->afi, table->safi);
+		bgp_process_main_one(bgp, dest, table->afi, table->safi, NULL);
 
 		bgp_dest_unlock_node(dest);
 		bgp_table_unlock(table);
@@ -3129,8 +3664,11 @@ void bgp_process(struct bgp *bgp, struct bgp_dest *dest, afi_t afi, safi_t safi)
 	int pqnode_reuse = 0;
 
 	/* already scheduled for processing? */
-	if (CHECK_FLAG(dest->flags, BGP_NODE_PROCESS_SCHEDULED))
+	if (CHECK_FLAG(dest->flags, BGP_NODE_PROCESS_SCHEDULED)) {
+		/* paths changed after a bestpath worker looked at them */
+		UNSET_FLAG(dest->flags, BGP_NODE_BESTPATH_PRESEL);
 		return;
+	}
 
 	/* If the flag BGP_NODE_SELECT_DEFER is set, do not add route to
 	 * the workqueue
@@ -3232,14 +3770,15 @@ static uint32_t bgp_filtered_routes_count(struct peer *peer, afi_t afi,
 
 			attr = *ain->attr;
 
-			if (bgp_input_filter(peer, rn_p, &attr, afi, safi)
+			if (bgp_input_filter(peer, rn_p, &attr, afi, safi,
+					     NULL)
 			    == FILTER_DENY)
 				filtered = true;
 
 			if (bgp_input_modifier(
 				    peer, rn_p, &attr, afi, safi,
 				    ROUTE_MAP_IN_NAME(&peer->filter[afi][safi]),
-				    NULL, 0, NULL)
+				    NULL, 0, NULL, NULL)
 			    == RMAP_DENY)
 				filtered = true;
 
@@ -3581,25 +4120,108 @@ static void bgp_attr_add_no_export_community(struct attr *attr)
 	attr->flag |= ATTR_FLAG_BIT(BGP_ATTR_COMMUNITIES);
 }
 
-int bgp_update(struct peer *peer, const struct prefix *p, uint32_t addpath_id,
-	       struct attr *attr, afi_t afi, safi_t safi, int type,
-	       int sub_type, struct prefix_rd *prd, mpls_label_t *label,
-	       uint32_t num_labels, int soft_reconfig,
-	       struct bgp_route_evpn *evpn)
+/*
+ * Outcome of the inbound filters and route-map for a path, worked out ahead
+ * of bgp_update(), see bgp_soft_reconfig_batch().  The attribute is what
+ * bgp_input_modifier() made of a copy of the received one, it is owned by
+ * this until bgp_update() takes it over.
+ */
+struct bgp_update_policy {
+	enum filter_type filter;
+	int rmap;
+	bool pending;
+	struct attr attr;
+};
+
+static void bgp_update_policy_apply(struct peer *peer, const struct prefix *p,
+				    struct attr *attr, afi_t afi, safi_t safi,
+				    mpls_label_t *label, uint32_t num_labels,
+				    struct bgp_dest *dest,
+				    struct bgp_update_policy *policy)
 {
-	int ret;
+	policy->pending = false;
+	policy->filter = bgp_input_filter(peer, p, attr, afi, safi, NULL);
+	if (policy->filter == FILTER_DENY)
+		return;
+
+	policy->attr = *attr;
+	policy->rmap = bgp_input_modifier(peer, p, &policy->attr, afi, safi,
+					  NULL, label, num_labels, dest, NULL);
+	policy->pending = true;
+}
+
+static enum bgp_update_loop bgp_update_loop_check(struct peer *peer,
+						  struct attr *attr, afi_t afi,
+						  safi_t safi)
+{
+	struct bgp *bgp = peer->bgp;
 	int aspath_loop_count = 0;
-	struct bgp_dest *dest;
-	struct bgp *bgp;
-	struct attr new_attr;
-	struct attr *attr_new;
-	struct bgp_path_info *pi;
-	struct bgp_path_info *new;
+	int do_loop_check = 1;
+
+	/* AS path local-as loop check. */
+	if (peer->change_local_as) {
+		if (peer->allowas_in[afi][safi])
+			aspath_loop_count = peer->allowas_in[afi][safi];
+		else if (!CHECK_FLAG(peer->flags,
+				     PEER_FLAG_LOCAL_AS_NO_PREPEND))
+			aspath_loop_count = 1;
+
+		if (aspath_loop_check(attr->aspath, peer->change_local_as)
+		    > aspath_loop_count)
+			return BGP_UPDATE_LOOP_ASPATH;
+	}
+
+	/* If the peer is configured for "allowas-in origin" and the last ASN in
+	 * the
+	 * as-path is our ASN then we do not need to call aspath_loop_check
+	 */
+	if (CHECK_FLAG(peer->af_flags[afi][safi], PEER_FLAG_ALLOWAS_IN_ORIGIN))
+		if (aspath_get_last_as(attr->aspath) == bgp->as)
+			do_loop_check = 0;
+
+	/* AS path loop check. */
+	if (do_loop_check) {
+		if (aspath_loop_check(attr->aspath, bgp->as)
+			    > peer->allowas_in[afi][safi]
+		    || (CHECK_FLAG(bgp->config, BGP_CONFIG_CONFEDERATION)
+			&& aspath_loop_check(attr->aspath, bgp->confed_id)
+				   > peer->allowas_in[afi][safi]))
+			return BGP_UPDATE_LOOP_ASPATH;
+	}
+
+	/* Route reflector originator ID check.  */
+	if (attr->flag & ATTR_FLAG_BIT(BGP_ATTR_ORIGINATOR_ID)
+	    && IPV4_ADDR_SAME(&bgp->router_id, &attr->originator_id))
+		return BGP_UPDATE_LOOP_ORIGINATOR;
+
+	/* Route reflector cluster ID check.  */
+	if (bgp_cluster_filter(peer, attr))
+		return BGP_UPDATE_LOOP_CLUSTER;
+
+	return BGP_UPDATE_LOOP_NONE;
+}
+
+static int bgp_update_with_policy(struct peer *peer, const struct prefix *p,
+				  uint32_t addpath_id, struct attr *attr,
+				  afi_t afi, safi_t safi, int type,
+				  int sub_type, struct prefix_rd *prd,
+				  mpls_label_t *label, uint32_t num_labels,
+				  int soft_reconfig,
+				  struct bgp_route_evpn *evpn,
+				  struct bgp_update_policy *policy,
+				  struct bgp_update_cache *cache)
+{
+	int ret;
+	struct bgp_dest *dest;
+	struct bgp *bgp;
+	struct attr new_attr;
+	struct attr *attr_new;
+	struct bgp_path_info *pi;
+	struct bgp_path_info *new;
 	struct bgp_path_info_extra *extra;
 	const char *reason;
 	char pfx_buf[BGP_PRD_PATH_STRLEN];
 	int connected = 0;
-	int do_loop_check = 1;
 	int has_valid_label = 0;
 	afi_t nh_afi;
 	uint8_t pi_type = 0;
@@ -3613,6 +4235,11 @@ int bgp_update(struct peer *peer, const struct prefix *p, uint32_t addpath_id,
 			 afi, safi, attr);
 	}
 
+	if (!soft_reconfig && peer->curr && safi == SAFI_UNICAST) {
+		conv_start(bm->conv, peer->bgp->vrf_id, p, peer->curr->rx_time);
+		conv_stage(bm->conv, peer->bgp->vrf_id, p, BGP_CONV_UPDATE);
+	}
+
 #ifdef ENABLE_BGP_VNC
 	int vnc_implicit_withdraw = 0;
 #endif
@@ -3652,60 +4279,28 @@ int bgp_update(struct peer *peer, const struct prefix *p, uint32_t addpath_id,
 		    && pi->addpath_rx_id == addpath_id)
 			break;
 
-	/* AS path local-as loop check. */
-	if (peer->change_local_as) {
-		if (peer->allowas_in[afi][safi])
-			aspath_loop_count = peer->allowas_in[afi][safi];
-		else if (!CHECK_FLAG(peer->flags,
-				     PEER_FLAG_LOCAL_AS_NO_PREPEND))
-			aspath_loop_count = 1;
-
-		if (aspath_loop_check(attr->aspath, peer->change_local_as)
-		    > aspath_loop_count) {
-			peer->stat_pfx_aspath_loop++;
-			reason = "as-path contains our own AS;";
-			goto filtered;
-		}
-	}
-
-	/* If the peer is configured for "allowas-in origin" and the last ASN in
-	 * the
-	 * as-path is our ASN then we do not need to call aspath_loop_check
-	 */
-	if (CHECK_FLAG(peer->af_flags[afi][safi], PEER_FLAG_ALLOWAS_IN_ORIGIN))
-		if (aspath_get_last_as(attr->aspath) == bgp->as)
-			do_loop_check = 0;
-
-	/* AS path loop check. */
-	if (do_loop_check) {
-		if (aspath_loop_check(attr->aspath, bgp->as)
-			    > peer->allowas_in[afi][safi]
-		    || (CHECK_FLAG(bgp->config, BGP_CONFIG_CONFEDERATION)
-			&& aspath_loop_check(attr->aspath, bgp->confed_id)
-				   > peer->allowas_in[afi][safi])) {
-			peer->stat_pfx_aspath_loop++;
-			reason = "as-path contains our own AS;";
-			goto filtered;
-		}
-	}
-
-	/* Route reflector originator ID check.  */
-	if (attr->flag & ATTR_FLAG_BIT(BGP_ATTR_ORIGINATOR_ID)
-	    && IPV4_ADDR_SAME(&bgp->router_id, &attr->originator_id)) {
+	switch (cache ? cache->loop
+		      : bgp_update_loop_check(peer, attr, afi, safi)) {
+	case BGP_UPDATE_LOOP_NONE:
+		break;
+	case BGP_UPDATE_LOOP_ASPATH:
+		peer->stat_pfx_aspath_loop++;
+		reason = "as-path contains our own AS;";
+		goto filtered;
+	case BGP_UPDATE_LOOP_ORIGINATOR:
 		peer->stat_pfx_originator_loop++;
 		reason = "originator is us;";
 		goto filtered;
-	}
-
-	/* Route reflector cluster ID check.  */
-	if (bgp_cluster_filter(peer, attr)) {
+	case BGP_UPDATE_LOOP_CLUSTER:
 		peer->stat_pfx_cluster_loop++;
 		reason = "reflected from the same cluster;";
 		goto filtered;
 	}
 
 	/* Apply incoming filter.  */
-	if (bgp_input_filter(peer, p, attr, afi, safi) == FILTER_DENY) {
+	if ((policy ? policy->filter
+		    : bgp_input_filter(peer, p, attr, afi, safi, cache))
+	    == FILTER_DENY) {
 		peer->stat_pfx_filter++;
 		reason = "filter;";
 		goto filtered;
@@ -3740,17 +4335,22 @@ int bgp_update(struct peer *peer, const struct prefix *p, uint32_t addpath_id,
 			goto filtered;
 		}
 
-	new_attr = *attr;
-
 	/* Apply incoming route-map.
 	 * NB: new_attr may now contain newly allocated values from route-map
 	 * "set"
 	 * commands, so we need bgp_attr_flush in the error paths, until we
 	 * intern
 	 * the attr (which takes over the memory references) */
-	if (bgp_input_modifier(peer, p, &new_attr, afi, safi, NULL, label,
-			       num_labels, dest)
-	    == RMAP_DENY) {
+	if (policy) {
+		new_attr = policy->attr;
+		policy->pending = false;
+		ret = policy->rmap;
+	} else {
+		new_attr = *attr;
+		ret = bgp_input_modifier(peer, p, &new_attr, afi, safi, NULL,
+					 label, num_labels, dest, cache);
+	}
+	if (ret == RMAP_DENY) {
 		peer->stat_pfx_filter++;
 		reason = "route-map;";
 		bgp_attr_flush(&new_attr);
@@ -4380,6 +4980,17 @@ filtered:
 	return 0;
 }
 
+int bgp_update(struct peer *peer, const struct prefix *p, uint32_t addpath_id,
+	       struct attr *attr, afi_t afi, safi_t safi, int type,
+	       int sub_type, struct prefix_rd *prd, mpls_label_t *label,
+	       uint32_t num_labels, int soft_reconfig,
+	       struct bgp_route_evpn *evpn)
+{
+	return bgp_update_with_policy(peer, p, addpath_id, attr, afi, safi,
+				      type, sub_type, prd, label, num_labels,
+				      soft_reconfig, evpn, NULL, NULL);
+}
+
 int bgp_withdraw(struct peer *peer, const struct prefix *p, uint32_t addpath_id,
 		 struct attr *attr, afi_t afi, safi_t safi, int type,
 		 int sub_type, struct prefix_rd *prd, mpls_label_t *label,
@@ -4399,6 +5010,11 @@ int bgp_withdraw(struct peer *peer, const struct prefix *p, uint32_t addpath_id,
 
 	bgp = peer->bgp;
 
+	if (peer->curr && safi == SAFI_UNICAST) {
+		conv_start(bm->conv, bgp->vrf_id, p, peer->curr->rx_time);
+		conv_stage(bm->conv, bgp->vrf_id, p, BGP_CONV_UPDATE);
+	}
+
 	/* Lookup node. */
 	dest = bgp_afi_node_get(bgp->rib[afi][safi], afi, safi, p, prd);
 
@@ -4516,7 +5132,7 @@ static int bgp_announce_route_timer_expired(struct thread *t)
 	peer_af_announce_route(paf, 1);
 
 	/* Notify BGP conditional advertisement scanner percess */
-	peer->advmap_config_change[paf->afi][paf->safi] = true;
+	bgp_conditional_adv_config_change(peer, paf->afi, paf->safi);
 
 	return 0;
 }
@@ -4598,34 +5214,52 @@ static void bgp_soft_reconfig_table_flag(struct bgp_table *table, bool flag)
 	}
 }
 
-static int bgp_soft_reconfig_table_update(struct peer *peer,
-					  struct bgp_dest *dest,
-					  struct bgp_adj_in *ain, afi_t afi,
-					  safi_t safi, struct prefix_rd *prd)
+/* Labels (and EVPN overlay, if evpn is given) of peer's path on dest */
+static mpls_label_t *bgp_soft_reconfig_labels(struct peer *peer,
+					      struct bgp_dest *dest,
+					      uint32_t *num_labels,
+					      struct bgp_route_evpn *evpn)
 {
 	struct bgp_path_info *pi;
-	uint32_t num_labels = 0;
 	mpls_label_t *label_pnt = NULL;
-	struct bgp_route_evpn evpn;
 
 	for (pi = bgp_dest_get_bgp_path_info(dest); pi; pi = pi->next)
 		if (pi->peer == peer)
 			break;
 
+	*num_labels = 0;
 	if (pi && pi->extra)
-		num_labels = pi->extra->num_labels;
-	if (num_labels)
+		*num_labels = pi->extra->num_labels;
+	if (*num_labels)
 		label_pnt = &pi->extra->label[0];
+	if (!evpn)
+		return label_pnt;
 	if (pi)
-		memcpy(&evpn, bgp_attr_get_evpn_overlay(pi->attr),
-		       sizeof(evpn));
+		memcpy(evpn, bgp_attr_get_evpn_overlay(pi->attr),
+		       sizeof(*evpn));
 	else
-		memset(&evpn, 0, sizeof(evpn));
+		memset(evpn, 0, sizeof(*evpn));
+
+	return label_pnt;
+}
 
-	return bgp_update(peer, bgp_dest_get_prefix(dest), ain->addpath_rx_id,
-			  ain->attr, afi, safi, ZEBRA_ROUTE_BGP,
-			  BGP_ROUTE_NORMAL, prd, label_pnt, num_labels, 1,
-			  &evpn);
+static int bgp_soft_reconfig_table_update(struct peer *peer,
+					  struct bgp_dest *dest,
+					  struct bgp_adj_in *ain, afi_t afi,
+					  safi_t safi, struct prefix_rd *prd,
+					  struct bgp_update_policy *policy)
+{
+	uint32_t num_labels;
+	mpls_label_t *label_pnt;
+	struct bgp_route_evpn evpn;
+
+	label_pnt = bgp_soft_reconfig_labels(peer, dest, &num_labels, &evpn);
+
+	return bgp_update_with_policy(peer, bgp_dest_get_prefix(dest),
+				      ain->addpath_rx_id, ain->attr, afi, safi,
+				      ZEBRA_ROUTE_BGP, BGP_ROUTE_NORMAL, prd,
+				      label_pnt, num_labels, 1, &evpn, policy,
+				      NULL);
 }
 
 static void bgp_soft_reconfig_table(struct peer *peer, afi_t afi, safi_t safi,
@@ -4645,7 +5279,8 @@ static void bgp_soft_reconfig_table(struct peer *peer, afi_t afi, safi_t safi,
 				continue;
 
 			ret = bgp_soft_reconfig_table_update(peer, dest, ain,
-							     afi, safi, prd);
+							     afi, safi, prd,
+							     NULL);
 
 			if (ret < 0) {
 				bgp_dest_unlock_node(dest);
@@ -4654,6 +5289,162 @@ static void bgp_soft_reconfig_table(struct peer *peer, afi_t afi, safi_t safi,
 		}
 }
 
+static int bgp_soft_reconfig_table_task(struct thread *thread);
+
+static void bgp_soft_reconfig_table_done(struct bgp_table *table)
+{
+	struct listnode *node, *nnode;
+	struct peer *peer;
+
+	for (ALL_LIST_ELEMENTS(table->soft_reconfig_peers, node, nnode, peer)) {
+		listnode_delete(table->soft_reconfig_peers, peer);
+		bgp_announce_route(peer, table->afi, table->safi);
+	}
+
+	list_delete(&table->soft_reconfig_peers);
+}
+
+/* A path of the Adj-RIB-In to replay, see bgp_soft_reconfig_batch() */
+struct bgp_soft_reconfig_job {
+	struct peer *peer;
+	struct bgp_dest *dest;
+	struct bgp_adj_in *ain;
+	unsigned int shard;
+	struct bgp_update_policy policy;
+};
+
+struct bgp_soft_reconfig_jobs {
+	struct bgp_table *table;
+	struct bgp_soft_reconfig_job *job;
+	unsigned int count;
+	unsigned int size;
+};
+
+static void bgp_soft_reconfig_shard(void *arg, unsigned int shard)
+{
+	struct bgp_soft_reconfig_jobs *jobs = arg;
+	struct bgp_soft_reconfig_job *job;
+	mpls_label_t *label_pnt;
+	uint32_t num_labels;
+	unsigned int i;
+
+	for (i = 0; i < jobs->count; i++) {
+		job = &jobs->job[i];
+		if (job->shard != shard)
+			continue;
+
+		label_pnt = bgp_soft_reconfig_labels(job->peer, job->dest,
+						     &num_labels, NULL);
+		bgp_update_policy_apply(job->peer, bgp_dest_get_prefix(job->dest),
+					job->ain->attr, jobs->table->afi,
+					jobs->table->safi, label_pnt,
+					num_labels, job->dest, &job->policy);
+	}
+}
+
+/*
+ * One chunk of bgp_soft_reconfig_table_task() with the inbound filters and
+ * route-maps run on the soft reconfiguration pthreads.  The paths are
+ * sharded by peer, so all of a peer's state is only ever touched by the one
+ * pthread; what the policy made of them is then handed to bgp_update() on
+ * the main pthread, in table order, as the serial walk would.
+ *
+ * Takes care of scheduling the next chunk, or of finishing up, as
+ * bgp_soft_reconfig_table_task() does.
+ */
+static int bgp_soft_reconfig_batch(struct bgp_table *table)
+{
+	struct bgp_soft_reconfig_jobs jobs = {.table = table};
+	struct bgp_soft_reconfig_job *job;
+	struct bgp_dest *dest;
+	struct bgp_adj_in *ain;
+	struct listnode *node;
+	struct peer *peer;
+	unsigned int i, n, shards;
+	bool more;
+	int ret;
+
+	shards = bgp_worker_pool_size(bgp_soft_reconfig_pool) + 1;
+
+	for (dest = bgp_table_top(table);
+	     dest && jobs.count < SOFT_RECONFIG_TASK_MAX_PREFIX;
+	     dest = bgp_route_next(dest)) {
+		if (!CHECK_FLAG(dest->flags, BGP_NODE_SOFT_RECONFIG))
+			continue;
+
+		UNSET_FLAG(dest->flags, BGP_NODE_SOFT_RECONFIG);
+
+		for (ain = dest->adj_in; ain; ain = ain->next) {
+			n = 0;
+			for (ALL_LIST_ELEMENTS_RO(table->soft_reconfig_peers,
+						  node, peer)) {
+				if (ain->peer == peer)
+					break;
+				n++;
+			}
+			if (!node)
+				continue;
+
+			if (jobs.count == jobs.size) {
+				jobs.size = jobs.size ? jobs.size * 2 : 1024;
+				jobs.job = XREALLOC(MTYPE_BGP_SOFT_RECONFIG,
+						    jobs.job,
+						    jobs.size * sizeof(*job));
+			}
+			job = &jobs.job[jobs.count++];
+			job->peer = peer;
+			job->dest = bgp_dest_lock_node(dest);
+			job->ain = ain;
+			job->shard = n % shards;
+			job->policy.pending = false;
+		}
+	}
+
+	more = dest != NULL;
+	if (dest)
+		bgp_dest_unlock_node(dest);
+
+	bgp_worker_pool_run(bgp_soft_reconfig_pool, bgp_soft_reconfig_shard,
+			    &jobs);
+
+	for (i = 0; i < jobs.count; i++) {
+		job = &jobs.job[i];
+		peer = job->peer;
+
+		if (listnode_lookup(table->soft_reconfig_peers, peer)) {
+			ret = bgp_soft_reconfig_table_update(
+				peer, job->dest, job->ain, table->afi,
+				table->safi, NULL, &job->policy);
+			if (ret < 0) {
+				listnode_delete(table->soft_reconfig_peers,
+						peer);
+				bgp_announce_route(peer, table->afi,
+						   table->safi);
+			}
+		}
+
+		if (job->policy.pending)
+			bgp_attr_flush(&job->policy.attr);
+		bgp_dest_unlock_node(job->dest);
+	}
+
+	XFREE(MTYPE_BGP_SOFT_RECONFIG, jobs.job);
+
+	if (list_isempty(table->soft_reconfig_peers)) {
+		list_delete(&table->soft_reconfig_peers);
+		bgp_soft_reconfig_table_flag(table, false);
+		return 0;
+	}
+
+	if (more)
+		thread_add_event(bm->master, bgp_soft_reconfig_table_task,
+				 table, 0, &table->soft_reconfig_thread);
+	else
+		bgp_soft_reconfig_table_done(table);
+
+	return 0;
+}
+
 /* Do soft reconfig table per bgp table.
  * Walk on SOFT_RECONFIG_TASK_MAX_PREFIX bgp_dest,
  * when BGP_NODE_SOFT_RECONFIG is set,
@@ -4685,6 +5476,10 @@ static int bgp_soft_reconfig_table_task(struct thread *thread)
 		max_iter = 0;
 	}
 
+	if (!table->soft_reconfig_init
+	    && bgp_worker_pool_size(bgp_soft_reconfig_pool))
+		return bgp_soft_reconfig_batch(table);
+
 	for (iter = 0, dest = bgp_table_top(table); (dest && iter < max_iter);
 	     dest = bgp_route_next(dest)) {
 		if (!CHECK_FLAG(dest->flags, BGP_NODE_SOFT_RECONFIG))
@@ -4700,7 +5495,7 @@ static int bgp_soft_reconfig_table_task(struct thread *thread)
 
 				ret = bgp_soft_reconfig_table_update(
 					peer, dest, ain, table->afi,
-					table->safi, prd);
+					table->safi, prd, NULL);
 				iter++;
 
 				if (ret < 0) {
@@ -4735,12 +5530,7 @@ static int bgp_soft_reconfig_table_task(struct thread *thread)
 	/* we're done, clean up the background iteration context info and
 	schedule route annoucement
 	*/
-	for (ALL_LIST_ELEMENTS(table->soft_reconfig_peers, node, nnode, peer)) {
-		listnode_delete(table->soft_reconfig_peers, peer);
-		bgp_announce_route(peer, table->afi, table->safi);
-	}
-
-	list_delete(&table->soft_reconfig_peers);
+	bgp_soft_reconfig_table_done(table);
 
 	return 0;
 }
@@ -4870,57 +5660,90 @@ void bgp_soft_reconfig_in(struct peer *peer, afi_t afi, safi_t safi)
 
 struct bgp_clear_node_queue {
 	struct bgp_dest *dest;
+	struct bgp_path_info *pi;
 };
 
+/* Whether 'pi' can be taken out of the RIB without running best path
+ * selection on 'dest' again: it isn't (part of) the best path, and nothing
+ * else is using the other paths.
+ */
+static bool bgp_clear_path_quiet(struct bgp *bgp, struct bgp_dest *dest,
+				 struct bgp_path_info *pi, afi_t afi,
+				 safi_t safi)
+{
+	if (CHECK_FLAG(pi->flags, BGP_PATH_SELECTED | BGP_PATH_MULTIPATH
+					  | BGP_PATH_DMED_SELECTED
+					  | BGP_PATH_HISTORY | BGP_PATH_DAMPED
+					  | BGP_PATH_REMOVED))
+		return false;
+
+	/* route selection deferral keeps count of these */
+	if (CHECK_FLAG(dest->flags, BGP_NODE_SELECT_DEFER)
+	    || bgp->gr_info[afi][safi].t_select_deferral)
+		return false;
+
+	/* addpath may be sending non-best paths */
+	return !bgp_addpath_is_addpath_used(&bgp->tx_addpath, afi, safi);
+}
+
 static wq_item_status bgp_clear_route_node(struct work_queue *wq, void *data)
 {
 	struct bgp_clear_node_queue *cnq = data;
 	struct bgp_dest *dest = cnq->dest;
+	struct bgp_path_info *pi = cnq->pi;
+	struct bgp_path_info *cur;
 	struct peer *peer = wq->spec.data;
-	struct bgp_path_info *pi;
 	struct bgp *bgp;
 	afi_t afi = bgp_dest_table(dest)->afi;
 	safi_t safi = bgp_dest_table(dest)->safi;
 
-	assert(dest && peer);
+	assert(dest && pi && peer);
 	bgp = peer->bgp;
 
-	/* It is possible that we have multiple paths for a prefix from a peer
-	 * if that peer is using AddPath.
+	/* already gone, e.g. reaped by best path selection for an earlier
+	 * withdraw
 	 */
-	for (pi = bgp_dest_get_bgp_path_info(dest); pi; pi = pi->next) {
-		if (pi->peer != peer)
-			continue;
+	for (cur = bgp_dest_get_bgp_path_info(dest); cur; cur = cur->next)
+		if (cur == pi)
+			break;
+	if (!cur)
+		return WQ_SUCCESS;
 
-		/* graceful restart STALE flag set. */
-		if (((CHECK_FLAG(peer->sflags, PEER_STATUS_NSF_WAIT)
-		      && peer->nsf[afi][safi])
-		     || CHECK_FLAG(peer->af_sflags[afi][safi],
-				   PEER_STATUS_ENHANCED_REFRESH))
-		    && !CHECK_FLAG(pi->flags, BGP_PATH_STALE)
-		    && !CHECK_FLAG(pi->flags, BGP_PATH_UNUSEABLE))
-			bgp_path_info_set_flag(dest, pi, BGP_PATH_STALE);
-		else {
-			/* If this is an EVPN route, process for
-			 * un-import. */
-			if (safi == SAFI_EVPN)
-				bgp_evpn_unimport_route(
-					bgp, afi, safi,
-					bgp_dest_get_prefix(dest), pi);
-			/* Handle withdraw for VRF route-leaking and L3VPN */
-			if (SAFI_UNICAST == safi
-			    && (bgp->inst_type == BGP_INSTANCE_TYPE_VRF ||
-				bgp->inst_type == BGP_INSTANCE_TYPE_DEFAULT)) {
-				vpn_leak_from_vrf_withdraw(bgp_get_default(),
-							   bgp, pi);
-			}
-			if (SAFI_MPLS_VPN == safi &&
-			    bgp->inst_type == BGP_INSTANCE_TYPE_DEFAULT) {
-				vpn_leak_to_vrf_withdraw(bgp, pi);
-			}
+	/* graceful restart STALE flag set. */
+	if (((CHECK_FLAG(peer->sflags, PEER_STATUS_NSF_WAIT)
+	      && peer->nsf[afi][safi])
+	     || CHECK_FLAG(peer->af_sflags[afi][safi],
+			   PEER_STATUS_ENHANCED_REFRESH))
+	    && !CHECK_FLAG(pi->flags, BGP_PATH_STALE)
+	    && !CHECK_FLAG(pi->flags, BGP_PATH_UNUSEABLE))
+		bgp_path_info_set_flag(dest, pi, BGP_PATH_STALE);
+	else {
+		/* If this is an EVPN route, process for
+		 * un-import. */
+		if (safi == SAFI_EVPN)
+			bgp_evpn_unimport_route(bgp, afi, safi,
+						bgp_dest_get_prefix(dest), pi);
+		/* Handle withdraw for VRF route-leaking and L3VPN */
+		if (SAFI_UNICAST == safi
+		    && (bgp->inst_type == BGP_INSTANCE_TYPE_VRF ||
+			bgp->inst_type == BGP_INSTANCE_TYPE_DEFAULT)) {
+			vpn_leak_from_vrf_withdraw(bgp_get_default(),
+						   bgp, pi);
+		}
+		if (SAFI_MPLS_VPN == safi &&
+		    bgp->inst_type == BGP_INSTANCE_TYPE_DEFAULT) {
+			vpn_leak_to_vrf_withdraw(bgp, pi);
+		}
 
+		if (bgp_clear_path_quiet(bgp, dest, pi, afi, safi)) {
+			bgp_aggregate_decrement(bgp, bgp_dest_get_prefix(dest),
+						pi, afi, safi);
+			bgp_path_info_delete(dest, pi);
+			hook_call(bgp_process, bgp, afi, safi, dest, peer,
+				  true);
+			bgp_path_info_reap(dest, pi);
+		} else
 			bgp_rib_remove(dest, pi, peer, afi, safi);
-		}
 	}
 	return WQ_SUCCESS;
 }
@@ -4931,6 +5754,7 @@ static void bgp_clear_node_queue_del(struct work_queue *wq, void *data)
 	struct bgp_dest *dest = cnq->dest;
 	struct bgp_table *table = bgp_dest_table(dest);
 
+	bgp_path_info_unlock(cnq->pi);
 	bgp_dest_unlock_node(dest);
 	bgp_table_unlock(table);
 	XFREE(MTYPE_BGP_CLEAR_NODE_QUEUE, cnq);
@@ -4965,59 +5789,13 @@ static void bgp_clear_node_queue_init(struct peer *peer)
 	peer->clear_node_queue->spec.data = peer;
 }
 
-static void bgp_clear_route_table(struct peer *peer, afi_t afi, safi_t safi,
-				  struct bgp_table *table)
+static void bgp_clear_adj_in_table(struct peer *peer, struct bgp_table *table)
 {
 	struct bgp_dest *dest;
-	int force = peer->bgp->process_queue ? 0 : 1;
-
-	if (!table)
-		table = peer->bgp->rib[afi][safi];
-
-	/* If still no table => afi/safi isn't configured at all or smth. */
-	if (!table)
-		return;
+	struct bgp_adj_in *ain;
+	struct bgp_adj_in *ain_next;
 
 	for (dest = bgp_table_top(table); dest; dest = bgp_route_next(dest)) {
-		struct bgp_path_info *pi, *next;
-		struct bgp_adj_in *ain;
-		struct bgp_adj_in *ain_next;
-
-		/* XXX:TODO: This is suboptimal, every non-empty route_node is
-		 * queued for every clearing peer, regardless of whether it is
-		 * relevant to the peer at hand.
-		 *
-		 * Overview: There are 3 different indices which need to be
-		 * scrubbed, potentially, when a peer is removed:
-		 *
-		 * 1 peer's routes visible via the RIB (ie accepted routes)
-		 * 2 peer's routes visible by the (optional) peer's adj-in index
-		 * 3 other routes visible by the peer's adj-out index
-		 *
-		 * 3 there is no hurry in scrubbing, once the struct peer is
-		 * removed from bgp->peer, we could just GC such deleted peer's
-		 * adj-outs at our leisure.
-		 *
-		 * 1 and 2 must be 'scrubbed' in some way, at least made
-		 * invisible via RIB index before peer session is allowed to be
-		 * brought back up. So one needs to know when such a 'search' is
-		 * complete.
-		 *
-		 * Ideally:
-		 *
-		 * - there'd be a single global queue or a single RIB walker
-		 * - rather than tracking which route_nodes still need to be
-		 *   examined on a peer basis, we'd track which peers still
-		 *   aren't cleared
-		 *
-		 * Given that our per-peer prefix-counts now should be reliable,
-		 * this may actually be achievable. It doesn't seem to be a huge
-		 * problem at this time,
-		 *
-		 * It is possible that we have multiple paths for a prefix from
-		 * a peer
-		 * if that peer is using AddPath.
-		 */
 		ain = dest->adj_in;
 		while (ain) {
 			ain_next = ain->next;
@@ -5027,30 +5805,52 @@ static void bgp_clear_route_table(struct peer *peer, afi_t afi, safi_t safi,
 
 			ain = ain_next;
 		}
+	}
+}
 
-		for (pi = bgp_dest_get_bgp_path_info(dest); pi; pi = next) {
-			next = pi->next;
-			if (pi->peer != peer)
-				continue;
+/*
+ * There are 3 different indices which need to be scrubbed, potentially, when
+ * a peer is removed:
+ *
+ * 1 peer's routes visible via the RIB (ie accepted routes)
+ * 2 peer's routes visible by the (optional) peer's adj-in index
+ * 3 other routes visible by the peer's adj-out index
+ *
+ * 3 there is no hurry in scrubbing, once the struct peer is removed from
+ * bgp->peer, we could just GC such deleted peer's adj-outs at our leisure.
+ *
+ * 1 and 2 must be 'scrubbed' in some way, at least made invisible via RIB
+ * index before peer session is allowed to be brought back up.  1 goes by
+ * peer->paths, so it only visits the peer's own paths (it is possible that
+ * we have multiple paths for a prefix from a peer if that peer is using
+ * AddPath); 2 still needs a table walk, but only with soft-reconfiguration
+ * inbound.
+ */
+static void bgp_clear_route_paths(struct peer *peer, afi_t afi, safi_t safi)
+{
+	struct bgp_peer_paths_head *paths = &peer->paths[afi][safi];
+	struct bgp_clear_node_queue *cnq;
+	struct bgp_path_info *pi;
+	struct bgp_dest *dest;
 
-			if (force)
-				bgp_path_info_reap(dest, pi);
-			else {
-				struct bgp_clear_node_queue *cnq;
-
-				/* both unlocked in bgp_clear_node_queue_del */
-				bgp_table_lock(bgp_dest_table(dest));
-				bgp_dest_lock_node(dest);
-				cnq = XCALLOC(
-					MTYPE_BGP_CLEAR_NODE_QUEUE,
-					sizeof(struct bgp_clear_node_queue));
-				cnq->dest = dest;
-				work_queue_add(peer->clear_node_queue, cnq);
-				break;
-			}
-		}
+	if (!peer->bgp->process_queue) {
+		frr_each_safe (bgp_peer_paths, paths, pi)
+			bgp_path_info_reap(pi->net, pi);
+		return;
+	}
+
+	frr_each (bgp_peer_paths, paths, pi) {
+		dest = pi->net;
+
+		/* all unlocked in bgp_clear_node_queue_del */
+		bgp_table_lock(bgp_dest_table(dest));
+		bgp_dest_lock_node(dest);
+		cnq = XCALLOC(MTYPE_BGP_CLEAR_NODE_QUEUE,
+			      sizeof(struct bgp_clear_node_queue));
+		cnq->dest = dest;
+		cnq->pi = bgp_path_info_lock(pi);
+		work_queue_add(peer->clear_node_queue, cnq);
 	}
-	return;
 }
 
 void bgp_clear_route(struct peer *peer, afi_t afi, safi_t safi)
@@ -5081,17 +5881,27 @@ void bgp_clear_route(struct peer *peer, afi_t afi, safi_t safi)
 	if (!peer->clear_node_queue->thread)
 		peer_lock(peer);
 
-	if (safi != SAFI_MPLS_VPN && safi != SAFI_ENCAP && safi != SAFI_EVPN)
-		bgp_clear_route_table(peer, afi, safi, NULL);
-	else
-		for (dest = bgp_table_top(peer->bgp->rib[afi][safi]); dest;
-		     dest = bgp_route_next(dest)) {
-			table = bgp_dest_get_bgp_table_info(dest);
-			if (!table)
-				continue;
+	/* adj-in is only kept with soft-reconfiguration inbound; if no table
+	 * => afi/safi isn't configured at all or smth.
+	 */
+	table = peer->bgp->rib[afi][safi];
+	if (table
+	    && CHECK_FLAG(peer->af_flags[afi][safi], PEER_FLAG_SOFT_RECONFIG)) {
+		if (safi != SAFI_MPLS_VPN && safi != SAFI_ENCAP
+		    && safi != SAFI_EVPN)
+			bgp_clear_adj_in_table(peer, table);
+		else
+			for (dest = bgp_table_top(peer->bgp->rib[afi][safi]);
+			     dest; dest = bgp_route_next(dest)) {
+				table = bgp_dest_get_bgp_table_info(dest);
+				if (!table)
+					continue;
 
-			bgp_clear_route_table(peer, afi, safi, table);
-		}
+				bgp_clear_adj_in_table(peer, table);
+			}
+	}
+
+	bgp_clear_route_paths(peer, afi, safi);
 
 	/* unlock if no nodes got added to the clear-node-queue. */
 	if (!peer->clear_node_queue->thread)
@@ -5182,6 +5992,69 @@ void bgp_clear_stale_route(struct peer *peer, afi_t afi, safi_t safi)
 	}
 }
 
+/*
+ * Put back a path from a RIB snapshot taken by a previous bgpd.  It is
+ * stale until the peer announces it again; updates from the peer win.
+ * 'attr' is consumed.
+ */
+void bgp_path_restore(struct peer *peer, const struct prefix *p,
+		      uint32_t addpath_id, struct attr *attr, afi_t afi,
+		      safi_t safi)
+{
+	struct bgp *bgp = peer->bgp;
+	struct bgp_dest *dest;
+	struct bgp_path_info *pi, *new;
+	struct attr *attr_new;
+	afi_t nh_afi;
+	int connected;
+
+	dest = bgp_afi_node_get(bgp->rib[afi][safi], afi, safi, p, NULL);
+
+	for (pi = bgp_dest_get_bgp_path_info(dest); pi; pi = pi->next)
+		if (pi->peer == peer && pi->type == ZEBRA_ROUTE_BGP
+		    && pi->sub_type == BGP_ROUTE_NORMAL
+		    && pi->addpath_rx_id == addpath_id)
+			break;
+
+	if (pi || bgp_update_martian_nexthop(bgp, afi, safi, ZEBRA_ROUTE_BGP,
+					     BGP_ROUTE_NORMAL, attr, dest)) {
+		bgp_attr_unintern_sub(attr);
+		bgp_dest_unlock_node(dest);
+		return;
+	}
+
+	attr_new = bgp_attr_intern(attr);
+	bgp_attr_unintern_sub(attr);
+
+	new = info_make(ZEBRA_ROUTE_BGP, BGP_ROUTE_NORMAL, 0, peer, attr_new,
+			dest);
+	new->addpath_rx_id = addpath_id;
+	SET_FLAG(new->flags, BGP_PATH_STALE);
+
+	if (peer->sort == BGP_PEER_EBGP && peer->ttl == BGP_DEFAULT_TTL
+	    && !CHECK_FLAG(peer->flags, PEER_FLAG_DISABLE_CONNECTED_CHECK)
+	    && !CHECK_FLAG(bgp->flags, BGP_FLAG_DISABLE_NH_CONNECTED_CHK))
+		connected = 1;
+	else
+		connected = 0;
+
+	nh_afi = BGP_ATTR_NH_AFI(afi, new->attr);
+	if (bgp_find_or_add_nexthop(bgp, bgp, nh_afi, safi, new, NULL,
+				    connected))
+		bgp_path_info_set_flag(dest, new, BGP_PATH_VALID);
+
+	bgp_aggregate_increment(bgp, p, new, afi, safi);
+	bgp_path_info_add(dest, new);
+	bgp_dest_unlock_node(dest);
+
+	bgp_process(bgp, dest, afi, safi);
+
+	if (safi == SAFI_UNICAST
+	    && (bgp->inst_type == BGP_INSTANCE_TYPE_VRF
+		|| bgp->inst_type == BGP_INSTANCE_TYPE_DEFAULT))
+		vpn_leak_from_vrf_update(bgp_get_default(), bgp, new);
+}
+
 void bgp_set_stale_route(struct peer *peer, afi_t afi, safi_t safi)
 {
 	struct bgp_dest *dest, *ndest;
@@ -5385,33 +6258,43 @@ static int bgp_addpath_encode_rx(struct peer *peer, afi_t afi, safi_t safi)
 
 /* Parse NLRI stream.  Withdraw NLRI is recognized by NULL attr
    value. */
-int bgp_nlri_parse_ip(struct peer *peer, struct attr *attr,
-		      struct bgp_nlri *packet)
+/* A prefix of an UPDATE, as found by bgp_nlri_parse_ip_validate(). */
+struct bgp_nlri_ip {
+	uint32_t addpath_id;
+	/* where the prefix itself starts in the NLRI */
+	uint16_t offset;
+	uint8_t prefixlen;
+};
+
+/*
+ * Check the whole NLRI field and note where the prefixes are, so that no
+ * prefix is applied if the field turns out to be malformed later on.
+ */
+static int bgp_nlri_parse_ip_validate(struct peer *peer,
+				      struct bgp_nlri *packet,
+				      struct bgp_nlri_ip *nlris, size_t *count)
 {
 	uint8_t *pnt;
 	uint8_t *lim;
-	struct prefix p;
-	int psize;
-	int ret;
-	afi_t afi;
-	safi_t safi;
-	int addpath_encoded;
+	uint8_t prefixlen;
 	uint32_t addpath_id;
+	size_t maxlen;
+	int addpath_encoded;
+	int psize;
 
 	pnt = packet->nlri;
 	lim = pnt + packet->length;
-	afi = packet->afi;
-	safi = packet->safi;
+	maxlen = afi2family(packet->afi) == AF_INET ? IPV4_MAX_BITLEN
+						    : IPV6_MAX_BITLEN;
 	addpath_id = 0;
-	addpath_encoded = bgp_addpath_encode_rx(peer, afi, safi);
+	addpath_encoded =
+		bgp_addpath_encode_rx(peer, packet->afi, packet->safi);
+	*count = 0;
 
 	/* RFC4771 6.3 The NLRI field in the UPDATE message is checked for
 	   syntactic validity.  If the field is syntactically incorrect,
 	   then the Error Subcode is set to Invalid Network Field. */
 	for (; pnt < lim; pnt += psize) {
-		/* Clear prefix structure. */
-		memset(&p, 0, sizeof(struct prefix));
-
 		if (addpath_encoded) {
 
 			/* When packet overflow occurs return immediately. */
@@ -5424,44 +6307,89 @@ int bgp_nlri_parse_ip(struct peer *peer, struct attr *attr,
 		}
 
 		/* Fetch prefix length. */
-		p.prefixlen = *pnt++;
-		/* afi/safi validity already verified by caller,
-		 * bgp_update_receive */
-		p.family = afi2family(afi);
+		prefixlen = *pnt++;
 
 		/* Prefix length check. */
-		if (p.prefixlen > prefix_blen(&p) * 8) {
+		if (prefixlen > maxlen) {
 			flog_err(
 				EC_BGP_UPDATE_RCV,
 				"%s [Error] Update packet error (wrong prefix length %d for afi %u)",
-				peer->host, p.prefixlen, packet->afi);
+				peer->host, prefixlen, packet->afi);
 			return BGP_NLRI_PARSE_ERROR_PREFIX_LENGTH;
 		}
 
 		/* Packet size overflow check. */
-		psize = PSIZE(p.prefixlen);
+		psize = PSIZE(prefixlen);
 
 		/* When packet overflow occur return immediately. */
 		if (pnt + psize > lim) {
 			flog_err(
 				EC_BGP_UPDATE_RCV,
 				"%s [Error] Update packet error (prefix length %d overflows packet)",
-				peer->host, p.prefixlen);
+				peer->host, prefixlen);
 			return BGP_NLRI_PARSE_ERROR_PACKET_OVERFLOW;
 		}
 
-		/* Defensive coding, double-check the psize fits in a struct
-		 * prefix */
-		if (psize > (ssize_t)sizeof(p.u)) {
-			flog_err(
-				EC_BGP_UPDATE_RCV,
-				"%s [Error] Update packet error (prefix length %d too large for prefix storage %zu)",
-				peer->host, p.prefixlen, sizeof(p.u));
-			return BGP_NLRI_PARSE_ERROR_PACKET_LENGTH;
-		}
+		nlris[*count].addpath_id = addpath_id;
+		nlris[*count].offset = pnt - packet->nlri;
+		nlris[*count].prefixlen = prefixlen;
+		(*count)++;
+	}
+
+	/* Packet length consistency check. */
+	if (pnt != lim) {
+		flog_err(
+			EC_BGP_UPDATE_RCV,
+			"%s [Error] Update packet error (prefix length mismatch with total length)",
+			peer->host);
+		return BGP_NLRI_PARSE_ERROR_PACKET_LENGTH;
+	}
+
+	return BGP_NLRI_PARSE_OK;
+}
+
+#define BGP_NLRI_IP_STACK 256
+
+int bgp_nlri_parse_ip(struct peer *peer, struct attr *attr,
+		      struct bgp_nlri *packet)
+{
+	struct bgp_nlri_ip stack_nlris[BGP_NLRI_IP_STACK];
+	struct bgp_nlri_ip *nlris = stack_nlris;
+	struct bgp_update_cache cache;
+	struct prefix p;
+	size_t i, count;
+	int ret;
+	afi_t afi;
+	safi_t safi;
+
+	afi = packet->afi;
+	safi = packet->safi;
+	bgp_update_cache_init(&cache);
+
+	/* every prefix takes at least a byte */
+	if (packet->length > BGP_NLRI_IP_STACK)
+		nlris = XMALLOC(MTYPE_TMP, packet->length * sizeof(*nlris));
+
+	ret = bgp_nlri_parse_ip_validate(peer, packet, nlris, &count);
+	if (ret != BGP_NLRI_PARSE_OK)
+		goto out;
+
+	/* the same for all prefixes, see bgp_update_loop_check() */
+	if (attr)
+		cache.loop = bgp_update_loop_check(peer, attr, afi, safi);
+
+	for (i = 0; i < count; i++) {
+		/* Clear prefix structure. */
+		memset(&p, 0, sizeof(struct prefix));
+
+		/* afi/safi validity already verified by caller,
+		 * bgp_update_receive */
+		p.family = afi2family(afi);
+		p.prefixlen = nlris[i].prefixlen;
 
 		/* Fetch prefix from NLRI packet. */
-		memcpy(p.u.val, pnt, psize);
+		memcpy(p.u.val, packet->nlri + nlris[i].offset,
+		       PSIZE(p.prefixlen));
 
 		/* Check address. */
 		if (afi == AFI_IP && safi == SAFI_UNICAST) {
@@ -5505,35 +6433,36 @@ int bgp_nlri_parse_ip(struct peer *peer, struct attr *attr,
 
 		/* Normal process. */
 		if (attr)
-			ret = bgp_update(peer, &p, addpath_id, attr, afi, safi,
-					 ZEBRA_ROUTE_BGP, BGP_ROUTE_NORMAL,
-					 NULL, NULL, 0, 0, NULL);
+			ret = bgp_update_with_policy(
+				peer, &p, nlris[i].addpath_id, attr, afi, safi,
+				ZEBRA_ROUTE_BGP, BGP_ROUTE_NORMAL, NULL, NULL,
+				0, 0, NULL, NULL, &cache);
 		else
-			ret = bgp_withdraw(peer, &p, addpath_id, attr, afi,
-					   safi, ZEBRA_ROUTE_BGP,
+			ret = bgp_withdraw(peer, &p, nlris[i].addpath_id, attr,
+					   afi, safi, ZEBRA_ROUTE_BGP,
 					   BGP_ROUTE_NORMAL, NULL, NULL, 0,
 					   NULL);
 
 		/* Do not send BGP notification twice when maximum-prefix count
 		 * overflow. */
-		if (CHECK_FLAG(peer->sflags, PEER_STATUS_PREFIX_OVERFLOW))
-			return BGP_NLRI_PARSE_ERROR_PREFIX_OVERFLOW;
+		if (CHECK_FLAG(peer->sflags, PEER_STATUS_PREFIX_OVERFLOW)) {
+			ret = BGP_NLRI_PARSE_ERROR_PREFIX_OVERFLOW;
+			goto out;
+		}
 
 		/* Address family configuration mismatch. */
-		if (ret < 0)
-			return BGP_NLRI_PARSE_ERROR_ADDRESS_FAMILY;
-	}
-
-	/* Packet length consistency check. */
-	if (pnt != lim) {
-		flog_err(
-			EC_BGP_UPDATE_RCV,
-			"%s [Error] Update packet error (prefix length mismatch with total length)",
-			peer->host);
-		return BGP_NLRI_PARSE_ERROR_PACKET_LENGTH;
+		if (ret < 0) {
+			ret = BGP_NLRI_PARSE_ERROR_ADDRESS_FAMILY;
+			goto out;
+		}
 	}
+	ret = BGP_NLRI_PARSE_OK;
 
-	return BGP_NLRI_PARSE_OK;
+out:
+	bgp_update_cache_fini(&cache);
+	if (nlris != stack_nlris)
+		XFREE(MTYPE_TMP, nlris);
+	return ret;
 }
 
 static struct bgp_static *bgp_static_new(void)
@@ -6744,6 +7673,90 @@ static void bgp_aggregate_free(struct bgp_aggregate *aggregate)
 	XFREE(MTYPE_BGP_AGGREGATE, aggregate);
 }
 
+/* One community value and the count of aggregated sets carrying it. */
+struct bgp_aggr_val {
+	unsigned long refcnt;
+	uint8_t len;
+	uint8_t val[IPV6_ECOMMUNITY_SIZE];
+};
+
+static unsigned int bgp_aggr_val_key(const void *p)
+{
+	const struct bgp_aggr_val *v = p;
+
+	return jhash(v->val, v->len, v->len);
+}
+
+static bool bgp_aggr_val_cmp(const void *p1, const void *p2)
+{
+	const struct bgp_aggr_val *v1 = p1;
+	const struct bgp_aggr_val *v2 = p2;
+
+	return v1->len == v2->len && !memcmp(v1->val, v2->val, v1->len);
+}
+
+static void *bgp_aggr_val_alloc(void *p)
+{
+	struct bgp_aggr_val *v;
+
+	v = XMALLOC(MTYPE_BGP_AGGREGATE_VAL, sizeof(*v));
+	memcpy(v, p, sizeof(*v));
+	return v;
+}
+
+static void bgp_aggr_val_release(void *p)
+{
+	XFREE(MTYPE_BGP_AGGREGATE_VAL, p);
+}
+
+/* Returns true if val was not in the hash before. */
+bool bgp_aggr_val_ref(struct hash **hash, const void *val, uint8_t len)
+{
+	struct bgp_aggr_val key = {.len = len};
+	struct bgp_aggr_val *v;
+
+	assert(len <= sizeof(key.val));
+	memcpy(key.val, val, len);
+
+	if (*hash == NULL)
+		*hash = hash_create(bgp_aggr_val_key, bgp_aggr_val_cmp,
+				    "BGP Aggregator value hash");
+
+	v = hash_get(*hash, &key, bgp_aggr_val_alloc);
+	return v->refcnt++ == 0;
+}
+
+/* Returns true if that was the last reference to val. */
+bool bgp_aggr_val_unref(struct hash *hash, const void *val, uint8_t len)
+{
+	struct bgp_aggr_val key = {.len = len};
+	struct bgp_aggr_val *v;
+
+	if (hash == NULL)
+		return false;
+
+	assert(len <= sizeof(key.val));
+	memcpy(key.val, val, len);
+
+	v = hash_lookup(hash, &key);
+	if (v == NULL || --v->refcnt > 0)
+		return false;
+
+	hash_release(hash, v);
+	bgp_aggr_val_release(v);
+	return true;
+}
+
+void bgp_aggr_val_free(struct hash **hash)
+{
+	if (*hash == NULL)
+		return;
+
+	hash_clean(*hash, bgp_aggr_val_release);
+	hash_free(*hash);
+	*hash = NULL;
+}
+
 /**
  * Helper function to avoid repeated code: prepare variables for a
  * `route_map_apply` call.
@@ -7885,6 +8898,10 @@ int bgp_aggregate_unset(struct bgp *bgp, struct prefix *prefix, afi_t afi,
 		hash_free(aggregate->aspath_hash);
 	}
 
+	bgp_aggr_val_free(&aggregate->community_val_hash);
+	bgp_aggr_val_free(&aggregate->ecommunity_val_hash);
+	bgp_aggr_val_free(&aggregate->lcommunity_val_hash);
+
 	bgp_aggregate_free(aggregate);
 	bgp_dest_unlock_node(dest);
 	bgp_dest_unlock_node(dest);
@@ -9043,7 +10060,7 @@ void route_vty_out(struct vty *vty, const struct prefix *p,
 	if (attr->aspath) {
 		if (json_paths)
 			json_object_string_add(json_path, "path",
-					       attr->aspath->str);
+					       aspath_print(attr->aspath));
 		else
 			aspath_print_vty(vty, "%s", attr->aspath, " ");
 	}
@@ -9233,7 +10250,7 @@ void route_vty_out_tmp(struct vty *vty, struct bgp_dest *dest,
 			/* Print aspath */
 			if (attr->aspath)
 				json_object_string_add(json_net, "path",
-						       attr->aspath->str);
+						       aspath_print(attr->aspath));
 
 			/* Print origin */
 			json_object_string_add(json_net, "bgpOriginCode",
@@ -9564,7 +10581,7 @@ static void damp_route_vty_out(struct vty *vty, const struct prefix *p,
 
 		if (attr->aspath)
 			json_object_string_add(json_path, "asPath",
-					       attr->aspath->str);
+					       aspath_print(attr->aspath));
 
 		json_object_string_add(json_path, "origin",
 				       bgp_origin_str[attr->origin]);
@@ -9650,7 +10667,7 @@ static void flap_route_vty_out(struct vty *vty, const struct prefix *p,
 
 		if (attr->aspath)
 			json_object_string_add(json_path, "asPath",
-					       attr->aspath->str);
+					       aspath_print(attr->aspath));
 
 		json_object_string_add(json_path, "origin",
 				       bgp_origin_str[attr->origin]);
@@ -10475,7 +11492,7 @@ void route_vty_out_detail(struct vty *vty, struct bgp *bgp, struct bgp_dest *bn,
 					       attr->community->json);
 		} else {
 			vty_out(vty, "      Community: %s\n",
-				attr->community->str);
+				community_str(attr->community, false));
 		}
 	}
 
@@ -10503,7 +11520,7 @@ void route_vty_out_detail(struct vty *vty, struct bgp *bgp, struct bgp_dest *bn,
 					       attr->lcommunity->json);
 		} else {
 			vty_out(vty, "      Large Community: %s\n",
-				attr->lcommunity->str);
+				lcommunity_str(attr->lcommunity, false));
 		}
 	}
 
@@ -10771,28 +11788,43 @@ static int bgp_show_community(struct vty *vty, struct bgp *bgp,
 			      const char *comstr, int exact, afi_t afi,
 			      safi_t safi, uint16_t show_flags);
 
-static int bgp_show_table(struct vty *vty, struct bgp *bgp, safi_t safi,
-			  struct bgp_table *table, enum bgp_show_type type,
-			  void *output_arg, char *rd, int is_last,
-			  unsigned long *output_cum, unsigned long *total_cum,
-			  unsigned long *json_header_depth, uint16_t show_flags,
-			  enum rpki_states rpki_target_state)
-{
-	struct bgp_path_info *pi;
+/* A walk over a table for show commands, see bgp_show_table() */
+struct bgp_show_ctx {
+	struct vty *vty;
+	struct bgp *bgp;
+	safi_t safi;
+	struct bgp_table *table;
+	enum bgp_show_type type;
+	void *output_arg;
+	char *rd;
+	int is_last;
+	unsigned long *json_header_depth;
+	uint16_t show_flags;
+	enum rpki_states rpki_target_state;
+
+	int header;
+	unsigned long output_count;
+	unsigned long total_count;
+	struct json_stream js;
+
+	/* next prefix of a yielding walk, see bgp_show_yield() */
 	struct bgp_dest *dest;
-	int header = 1;
-	int display;
-	unsigned long output_count = 0;
-	unsigned long total_count = 0;
-	struct prefix *p;
-	json_object *json_paths = NULL;
-	int first = 1;
-	bool use_json = CHECK_FLAG(show_flags, BGP_SHOW_OPT_JSON);
-	bool wide = CHECK_FLAG(show_flags, BGP_SHOW_OPT_WIDE);
-	bool all = CHECK_FLAG(show_flags, BGP_SHOW_OPT_AFI_ALL);
+	unsigned long yield_json_header_depth;
+};
 
+static void bgp_show_table_start(struct bgp_show_ctx *ctx,
+				 unsigned long *output_cum)
+{
+	struct vty *vty = ctx->vty;
+	struct bgp *bgp = ctx->bgp;
+	char *rd = ctx->rd;
+	unsigned long *json_header_depth = ctx->json_header_depth;
+	bool use_json = CHECK_FLAG(ctx->show_flags, BGP_SHOW_OPT_JSON);
+	bool all = CHECK_FLAG(ctx->show_flags, BGP_SHOW_OPT_AFI_ALL);
+
+	ctx->header = 1;
 	if (output_cum && *output_cum != 0)
-		header = 0;
+		ctx->header = 0;
 
 	if (use_json && !*json_header_depth) {
 		if (all)
@@ -10810,7 +11842,7 @@ static int bgp_show_table(struct vty *vty, struct bgp *bgp, safi_t safi,
 			bgp->inst_type == BGP_INSTANCE_TYPE_DEFAULT
 				? VRF_DEFAULT_NAME
 				: bgp->name,
-			table->version, &bgp->router_id,
+			ctx->table->version, &bgp->router_id,
 			bgp->default_local_pref, bgp->as);
 		if (rd) {
 			vty_out(vty, " \"routeDistinguishers\" : {");
@@ -10822,330 +11854,353 @@ static int bgp_show_table(struct vty *vty, struct bgp *bgp, safi_t safi,
 		vty_out(vty, " \"%s\" : { ", rd);
 	}
 
-	/* Start processing of routes. */
-	for (dest = bgp_table_top(table); dest; dest = bgp_route_next(dest)) {
-		const struct prefix *dest_p = bgp_dest_get_prefix(dest);
-		enum rpki_states rpki_curr_state = RPKI_NOT_BEING_USED;
+	/* the prefixes go into the object opened above */
+	json_stream_init(&ctx->js, vty, JSON_C_TO_STRING_PRETTY);
+	json_stream_enter(&ctx->js);
+}
 
-		pi = bgp_dest_get_bgp_path_info(dest);
-		if (pi == NULL)
-			continue;
+static void bgp_show_table_dest(struct bgp_show_ctx *ctx,
+				struct bgp_dest *dest)
+{
+	struct vty *vty = ctx->vty;
+	struct bgp *bgp = ctx->bgp;
+	safi_t safi = ctx->safi;
+	enum bgp_show_type type = ctx->type;
+	void *output_arg = ctx->output_arg;
+	char *rd = ctx->rd;
+	uint16_t show_flags = ctx->show_flags;
+	enum rpki_states rpki_target_state = ctx->rpki_target_state;
+	struct bgp_path_info *pi;
+	int display;
+	struct prefix *p;
+	json_object *json_paths = NULL;
+	char key[BGP_FLOWSPEC_STRING_DISPLAY_MAX + 8];
+	bool use_json = CHECK_FLAG(show_flags, BGP_SHOW_OPT_JSON);
+	bool wide = CHECK_FLAG(show_flags, BGP_SHOW_OPT_WIDE);
+	const struct prefix *dest_p = bgp_dest_get_prefix(dest);
+	enum rpki_states rpki_curr_state = RPKI_NOT_BEING_USED;
 
-		display = 0;
-		if (use_json)
-			json_paths = json_object_new_array();
-		else
-			json_paths = NULL;
+	pi = bgp_dest_get_bgp_path_info(dest);
+	if (pi == NULL)
+		return;
 
-		for (; pi; pi = pi->next) {
-			total_count++;
+	display = 0;
+	if (use_json)
+		json_paths = json_object_new_array();
+	else
+		json_paths = NULL;
 
-			if (type == bgp_show_type_prefix_version) {
-				uint32_t version =
-					strtoul(output_arg, NULL, 10);
-				if (dest->version < version)
-					continue;
-			}
+	for (; pi; pi = pi->next) {
+		ctx->total_count++;
 
-			if (type == bgp_show_type_community_alias) {
-				char *alias = output_arg;
-				char **communities;
-				int num;
-				bool found = false;
-
-				if (pi->attr->community) {
-					frrstr_split(pi->attr->community->str,
-						     " ", &communities, &num);
-					for (int i = 0; i < num; i++) {
-						const char *com2alias =
-							bgp_community2alias(
-								communities[i]);
-						if (strncmp(alias, com2alias,
-							    strlen(com2alias))
-						    == 0) {
-							found = true;
-							break;
-						}
+		if (type == bgp_show_type_prefix_version) {
+			uint32_t version =
+				strtoul(output_arg, NULL, 10);
+			if (dest->version < version)
+				continue;
+		}
+
+		if (type == bgp_show_type_community_alias) {
+			char *alias = output_arg;
+			char **communities;
+			int num;
+			bool found = false;
+
+			if (pi->attr->community) {
+				frrstr_split(
+					community_str(pi->attr->community,
+						      false),
+					" ", &communities, &num);
+				for (int i = 0; i < num; i++) {
+					const char *com2alias =
+						bgp_community2alias(
+							communities[i]);
+					if (strncmp(alias, com2alias,
+						    strlen(com2alias))
+					    == 0) {
+						found = true;
+						break;
 					}
 				}
+			}
 
-				if (!found && pi->attr->lcommunity) {
-					frrstr_split(pi->attr->lcommunity->str,
-						     " ", &communities, &num);
-					for (int i = 0; i < num; i++) {
-						const char *com2alias =
-							bgp_community2alias(
-								communities[i]);
-						if (strncmp(alias, com2alias,
-							    strlen(com2alias))
-						    == 0) {
-							found = true;
-							break;
-						}
+			if (!found && pi->attr->lcommunity) {
+				frrstr_split(
+					lcommunity_str(
+						pi->attr->lcommunity,
+						false),
+					" ", &communities, &num);
+				for (int i = 0; i < num; i++) {
+					const char *com2alias =
+						bgp_community2alias(
+							communities[i]);
+					if (strncmp(alias, com2alias,
+						    strlen(com2alias))
+					    == 0) {
+						found = true;
+						break;
 					}
 				}
-
-				if (!found)
-					continue;
 			}
 
-			if (type == bgp_show_type_rpki) {
-				if (dest_p->family == AF_INET
-				    || dest_p->family == AF_INET6)
-					rpki_curr_state = hook_call(
-						bgp_rpki_prefix_status,
-						pi->peer, pi->attr, dest_p);
-				if (rpki_target_state != RPKI_NOT_BEING_USED
-				    && rpki_curr_state != rpki_target_state)
-					continue;
-			}
+			if (!found)
+				continue;
+		}
 
-			if (type == bgp_show_type_flap_statistics
-			    || type == bgp_show_type_flap_neighbor
-			    || type == bgp_show_type_dampend_paths
-			    || type == bgp_show_type_damp_neighbor) {
-				if (!(pi->extra && pi->extra->damp_info))
-					continue;
-			}
-			if (type == bgp_show_type_regexp) {
-				regex_t *regex = output_arg;
+		if (type == bgp_show_type_rpki) {
+			if (dest_p->family == AF_INET
+			    || dest_p->family == AF_INET6)
+				rpki_curr_state = hook_call(
+					bgp_rpki_prefix_status,
+					pi->peer, pi->attr, dest_p);
+			if (rpki_target_state != RPKI_NOT_BEING_USED
+			    && rpki_curr_state != rpki_target_state)
+				continue;
+		}
 
-				if (bgp_regexec(regex, pi->attr->aspath)
-				    == REG_NOMATCH)
-					continue;
-			}
-			if (type == bgp_show_type_prefix_list) {
-				struct prefix_list *plist = output_arg;
+		if (type == bgp_show_type_flap_statistics
+		    || type == bgp_show_type_flap_neighbor
+		    || type == bgp_show_type_dampend_paths
+		    || type == bgp_show_type_damp_neighbor) {
+			if (!(pi->extra && pi->extra->damp_info))
+				continue;
+		}
+		if (type == bgp_show_type_regexp) {
+			regex_t *regex = output_arg;
 
-				if (prefix_list_apply(plist, dest_p)
-				    != PREFIX_PERMIT)
-					continue;
-			}
-			if (type == bgp_show_type_filter_list) {
-				struct as_list *as_list = output_arg;
+			if (bgp_regexec(regex, pi->attr->aspath)
+			    == REG_NOMATCH)
+				continue;
+		}
+		if (type == bgp_show_type_prefix_list) {
+			struct prefix_list *plist = output_arg;
 
-				if (as_list_apply(as_list, pi->attr->aspath)
-				    != AS_FILTER_PERMIT)
-					continue;
-			}
-			if (type == bgp_show_type_route_map) {
-				struct route_map *rmap = output_arg;
-				struct bgp_path_info path;
-				struct attr dummy_attr;
-				route_map_result_t ret;
+			if (prefix_list_apply(plist, dest_p)
+			    != PREFIX_PERMIT)
+				continue;
+		}
+		if (type == bgp_show_type_filter_list) {
+			struct as_list *as_list = output_arg;
 
-				dummy_attr = *pi->attr;
+			if (as_list_apply(as_list, pi->attr->aspath)
+			    != AS_FILTER_PERMIT)
+				continue;
+		}
+		if (type == bgp_show_type_route_map) {
+			struct route_map *rmap = output_arg;
+			struct bgp_path_info path;
+			struct attr dummy_attr;
+			route_map_result_t ret;
 
-				path.peer = pi->peer;
-				path.attr = &dummy_attr;
+			dummy_attr = *pi->attr;
 
-				ret = route_map_apply(rmap, dest_p, &path);
-				if (ret == RMAP_DENYMATCH)
-					continue;
-			}
-			if (type == bgp_show_type_neighbor
-			    || type == bgp_show_type_flap_neighbor
-			    || type == bgp_show_type_damp_neighbor) {
-				union sockunion *su = output_arg;
+			path.peer = pi->peer;
+			path.attr = &dummy_attr;
 
-				if (pi->peer == NULL
-				    || pi->peer->su_remote == NULL
-				    || !sockunion_same(pi->peer->su_remote, su))
-					continue;
-			}
-			if (type == bgp_show_type_cidr_only) {
-				uint32_t destination;
+			ret = route_map_apply(rmap, dest_p, &path);
+			if (ret == RMAP_DENYMATCH)
+				continue;
+		}
+		if (type == bgp_show_type_neighbor
+		    || type == bgp_show_type_flap_neighbor
+		    || type == bgp_show_type_damp_neighbor) {
+			union sockunion *su = output_arg;
 
-				destination = ntohl(dest_p->u.prefix4.s_addr);
-				if (IN_CLASSC(destination)
-				    && dest_p->prefixlen == 24)
-					continue;
-				if (IN_CLASSB(destination)
-				    && dest_p->prefixlen == 16)
-					continue;
-				if (IN_CLASSA(destination)
-				    && dest_p->prefixlen == 8)
-					continue;
-			}
-			if (type == bgp_show_type_prefix_longer) {
-				p = output_arg;
-				if (!prefix_match(p, dest_p))
-					continue;
-			}
-			if (type == bgp_show_type_community_all) {
-				if (!pi->attr->community)
-					continue;
-			}
-			if (type == bgp_show_type_community) {
-				struct community *com = output_arg;
+			if (pi->peer == NULL
+			    || pi->peer->su_remote == NULL
+			    || !sockunion_same(pi->peer->su_remote, su))
+				continue;
+		}
+		if (type == bgp_show_type_cidr_only) {
+			uint32_t destination;
 
-				if (!pi->attr->community
-				    || !community_match(pi->attr->community,
-							com))
-					continue;
-			}
-			if (type == bgp_show_type_community_exact) {
-				struct community *com = output_arg;
+			destination = ntohl(dest_p->u.prefix4.s_addr);
+			if (IN_CLASSC(destination)
+			    && dest_p->prefixlen == 24)
+				continue;
+			if (IN_CLASSB(destination)
+			    && dest_p->prefixlen == 16)
+				continue;
+			if (IN_CLASSA(destination)
+			    && dest_p->prefixlen == 8)
+				continue;
+		}
+		if (type == bgp_show_type_prefix_longer) {
+			p = output_arg;
+			if (!prefix_match(p, dest_p))
+				continue;
+		}
+		if (type == bgp_show_type_community_all) {
+			if (!pi->attr->community)
+				continue;
+		}
+		if (type == bgp_show_type_community) {
+			struct community *com = output_arg;
 
-				if (!pi->attr->community
-				    || !community_cmp(pi->attr->community, com))
-					continue;
-			}
-			if (type == bgp_show_type_community_list) {
-				struct community_list *list = output_arg;
+			if (!pi->attr->community
+			    || !community_match(pi->attr->community,
+						com))
+				continue;
+		}
+		if (type == bgp_show_type_community_exact) {
+			struct community *com = output_arg;
 
-				if (!community_list_match(pi->attr->community,
-							  list))
-					continue;
-			}
-			if (type == bgp_show_type_community_list_exact) {
-				struct community_list *list = output_arg;
+			if (!pi->attr->community
+			    || !community_cmp(pi->attr->community, com))
+				continue;
+		}
+		if (type == bgp_show_type_community_list) {
+			struct community_list *list = output_arg;
 
-				if (!community_list_exact_match(
-					    pi->attr->community, list))
-					continue;
-			}
-			if (type == bgp_show_type_lcommunity) {
-				struct lcommunity *lcom = output_arg;
+			if (!community_list_match(pi->attr->community,
+						  list))
+				continue;
+		}
+		if (type == bgp_show_type_community_list_exact) {
+			struct community_list *list = output_arg;
 
-				if (!pi->attr->lcommunity
-				    || !lcommunity_match(pi->attr->lcommunity,
-							 lcom))
-					continue;
-			}
+			if (!community_list_exact_match(
+				    pi->attr->community, list))
+				continue;
+		}
+		if (type == bgp_show_type_lcommunity) {
+			struct lcommunity *lcom = output_arg;
 
-			if (type == bgp_show_type_lcommunity_exact) {
-				struct lcommunity *lcom = output_arg;
+			if (!pi->attr->lcommunity
+			    || !lcommunity_match(pi->attr->lcommunity,
+						 lcom))
+				continue;
+		}
 
-				if (!pi->attr->lcommunity
-				    || !lcommunity_cmp(pi->attr->lcommunity,
-						      lcom))
-					continue;
-			}
-			if (type == bgp_show_type_lcommunity_list) {
-				struct community_list *list = output_arg;
+		if (type == bgp_show_type_lcommunity_exact) {
+			struct lcommunity *lcom = output_arg;
 
-				if (!lcommunity_list_match(pi->attr->lcommunity,
-							   list))
-					continue;
-			}
-			if (type
-			    == bgp_show_type_lcommunity_list_exact) {
-				struct community_list *list = output_arg;
+			if (!pi->attr->lcommunity
+			    || !lcommunity_cmp(pi->attr->lcommunity,
+					      lcom))
+				continue;
+		}
+		if (type == bgp_show_type_lcommunity_list) {
+			struct community_list *list = output_arg;
 
-				if (!lcommunity_list_exact_match(
-					    pi->attr->lcommunity, list))
-					continue;
-			}
-			if (type == bgp_show_type_lcommunity_all) {
-				if (!pi->attr->lcommunity)
-					continue;
-			}
-			if (type == bgp_show_type_dampend_paths
-			    || type == bgp_show_type_damp_neighbor) {
-				if (!CHECK_FLAG(pi->flags, BGP_PATH_DAMPED)
-				    || CHECK_FLAG(pi->flags, BGP_PATH_HISTORY))
-					continue;
-			}
+			if (!lcommunity_list_match(pi->attr->lcommunity,
+						   list))
+				continue;
+		}
+		if (type
+		    == bgp_show_type_lcommunity_list_exact) {
+			struct community_list *list = output_arg;
 
-			if (!use_json && header) {
-				vty_out(vty,
-					"BGP table version is %" PRIu64
-					", local router ID is %pI4, vrf id ",
-					table->version, &bgp->router_id);
-				if (bgp->vrf_id == VRF_UNKNOWN)
-					vty_out(vty, "%s", VRFID_NONE_STR);
-				else
-					vty_out(vty, "%u", bgp->vrf_id);
-				vty_out(vty, "\n");
-				vty_out(vty, "Default local pref %u, ",
-					bgp->default_local_pref);
-				vty_out(vty, "local AS %u\n", bgp->as);
-				vty_out(vty, BGP_SHOW_SCODE_HEADER);
-				vty_out(vty, BGP_SHOW_NCODE_HEADER);
-				vty_out(vty, BGP_SHOW_OCODE_HEADER);
-				vty_out(vty, BGP_SHOW_RPKI_HEADER);
-				if (type == bgp_show_type_dampend_paths
-				    || type == bgp_show_type_damp_neighbor)
-					vty_out(vty, BGP_SHOW_DAMP_HEADER);
-				else if (type == bgp_show_type_flap_statistics
-					 || type == bgp_show_type_flap_neighbor)
-					vty_out(vty, BGP_SHOW_FLAP_HEADER);
-				else
-					vty_out(vty, (wide ? BGP_SHOW_HEADER_WIDE
-							   : BGP_SHOW_HEADER));
-				header = 0;
-			}
-			if (rd != NULL && !display && !output_count) {
-				if (!use_json)
-					vty_out(vty,
-						"Route Distinguisher: %s\n",
-						rd);
-			}
+			if (!lcommunity_list_exact_match(
+				    pi->attr->lcommunity, list))
+				continue;
+		}
+		if (type == bgp_show_type_lcommunity_all) {
+			if (!pi->attr->lcommunity)
+				continue;
+		}
+		if (type == bgp_show_type_dampend_paths
+		    || type == bgp_show_type_damp_neighbor) {
+			if (!CHECK_FLAG(pi->flags, BGP_PATH_DAMPED)
+			    || CHECK_FLAG(pi->flags, BGP_PATH_HISTORY))
+				continue;
+		}
+
+		if (!use_json && ctx->header) {
+			vty_out(vty,
+				"BGP table version is %" PRIu64
+				", local router ID is %pI4, vrf id ",
+				ctx->table->version, &bgp->router_id);
+			if (bgp->vrf_id == VRF_UNKNOWN)
+				vty_out(vty, "%s", VRFID_NONE_STR);
+			else
+				vty_out(vty, "%u", bgp->vrf_id);
+			vty_out(vty, "\n");
+			vty_out(vty, "Default local pref %u, ",
+				bgp->default_local_pref);
+			vty_out(vty, "local AS %u\n", bgp->as);
+			vty_out(vty, BGP_SHOW_SCODE_HEADER);
+			vty_out(vty, BGP_SHOW_NCODE_HEADER);
+			vty_out(vty, BGP_SHOW_OCODE_HEADER);
+			vty_out(vty, BGP_SHOW_RPKI_HEADER);
 			if (type == bgp_show_type_dampend_paths
 			    || type == bgp_show_type_damp_neighbor)
-				damp_route_vty_out(vty, dest_p, pi, display,
-						   AFI_IP, safi, use_json,
-						   json_paths);
+				vty_out(vty, BGP_SHOW_DAMP_HEADER);
 			else if (type == bgp_show_type_flap_statistics
 				 || type == bgp_show_type_flap_neighbor)
-				flap_route_vty_out(vty, dest_p, pi, display,
-						   AFI_IP, safi, use_json,
-						   json_paths);
-			else {
-				if (CHECK_FLAG(show_flags, BGP_SHOW_OPT_DETAIL))
-					route_vty_out_detail(
-						vty, bgp, dest, pi,
-						family2afi(dest_p->family),
-						safi, RPKI_NOT_BEING_USED,
-						json_paths);
-				else
-					route_vty_out(vty, dest_p, pi, display,
-						      safi, json_paths, wide);
-			}
-			display++;
+				vty_out(vty, BGP_SHOW_FLAP_HEADER);
+			else
+				vty_out(vty, (wide ? BGP_SHOW_HEADER_WIDE
+						   : BGP_SHOW_HEADER));
+			ctx->header = 0;
 		}
-
-		if (display) {
-			output_count++;
+		if (rd != NULL && !display && !ctx->output_count) {
 			if (!use_json)
-				continue;
+				vty_out(vty,
+					"Route Distinguisher: %s\n",
+					rd);
+		}
+		if (type == bgp_show_type_dampend_paths
+		    || type == bgp_show_type_damp_neighbor)
+			damp_route_vty_out(vty, dest_p, pi, display,
+					   AFI_IP, safi, use_json,
+					   json_paths);
+		else if (type == bgp_show_type_flap_statistics
+			 || type == bgp_show_type_flap_neighbor)
+			flap_route_vty_out(vty, dest_p, pi, display,
+					   AFI_IP, safi, use_json,
+					   json_paths);
+		else {
+			if (CHECK_FLAG(show_flags, BGP_SHOW_OPT_DETAIL))
+				route_vty_out_detail(
+					vty, bgp, dest, pi,
+					family2afi(dest_p->family),
+					safi, RPKI_NOT_BEING_USED,
+					json_paths);
+			else
+				route_vty_out(vty, dest_p, pi, display,
+					      safi, json_paths, wide);
+		}
+		display++;
+	}
 
-			/* encode prefix */
-			if (dest_p->family == AF_FLOWSPEC) {
-				char retstr[BGP_FLOWSPEC_STRING_DISPLAY_MAX];
+	if (display) {
+		ctx->output_count++;
+		if (!use_json)
+			return;
 
+		/* encode prefix */
+		if (dest_p->family == AF_FLOWSPEC) {
+			char retstr[BGP_FLOWSPEC_STRING_DISPLAY_MAX];
 
-				bgp_fs_nlri_get_string(
-					(unsigned char *)
-						dest_p->u.prefix_flowspec.ptr,
-					dest_p->u.prefix_flowspec.prefixlen,
-					retstr, NLRI_STRING_FORMAT_MIN, NULL,
-					family2afi(dest_p->u
-						   .prefix_flowspec.family));
-				if (first)
-					vty_out(vty, "\"%s/%d\": ", retstr,
-						dest_p->u.prefix_flowspec
-							.prefixlen);
-				else
-					vty_out(vty, ",\"%s/%d\": ", retstr,
-						dest_p->u.prefix_flowspec
-							.prefixlen);
-			} else {
-				if (first)
-					vty_out(vty, "\"%pFX\": ", dest_p);
-				else
-					vty_out(vty, ",\"%pFX\": ", dest_p);
-			}
-			vty_out(vty, "%s",
-				json_object_to_json_string_ext(
-					json_paths, JSON_C_TO_STRING_PRETTY));
-			json_object_free(json_paths);
-			json_paths = NULL;
-			first = 0;
+
+			bgp_fs_nlri_get_string(
+				(unsigned char *)
+					dest_p->u.prefix_flowspec.ptr,
+				dest_p->u.prefix_flowspec.prefixlen,
+				retstr, NLRI_STRING_FORMAT_MIN, NULL,
+				family2afi(dest_p->u
+					   .prefix_flowspec.family));
+			snprintf(key, sizeof(key), "%s/%d", retstr,
+				 dest_p->u.prefix_flowspec.prefixlen);
 		} else
-			json_object_free(json_paths);
-	}
+			snprintfrr(key, sizeof(key), "%pFX", dest_p);
+		json_stream_add(&ctx->js, key, json_paths);
+	} else
+		json_object_free(json_paths);
+}
+
+static void bgp_show_table_end(struct bgp_show_ctx *ctx,
+			       unsigned long *output_cum,
+			       unsigned long *total_cum)
+{
+	struct vty *vty = ctx->vty;
+	unsigned long output_count = ctx->output_count;
+	unsigned long total_count = ctx->total_count;
+	bool use_json = CHECK_FLAG(ctx->show_flags, BGP_SHOW_OPT_JSON);
+	bool all = CHECK_FLAG(ctx->show_flags, BGP_SHOW_OPT_AFI_ALL);
+
+	json_stream_leave(&ctx->js);
 
 	if (output_cum) {
 		output_count += *output_cum;
@@ -11156,21 +12211,21 @@ static int bgp_show_table(struct vty *vty, struct bgp *bgp, safi_t safi,
 		*total_cum = total_count;
 	}
 	if (use_json) {
-		if (rd) {
-			vty_out(vty, " }%s ", (is_last ? "" : ","));
+		if (ctx->rd) {
+			vty_out(vty, " }%s ", (ctx->is_last ? "" : ","));
 		}
-		if (is_last) {
+		if (ctx->is_last) {
 			unsigned long i;
-			for (i = 0; i < *json_header_depth; ++i)
+			for (i = 0; i < *ctx->json_header_depth; ++i)
 				vty_out(vty, " } ");
 			if (!all)
 				vty_out(vty, "\n");
 		}
 	} else {
-		if (is_last) {
+		if (ctx->is_last) {
 			/* No route is displayed */
 			if (output_count == 0) {
-				if (type == bgp_show_type_normal)
+				if (ctx->type == bgp_show_type_normal)
 					vty_out(vty,
 						"No BGP prefixes displayed, %ld exist\n",
 						total_count);
@@ -11180,10 +12235,104 @@ static int bgp_show_table(struct vty *vty, struct bgp *bgp, safi_t safi,
 					output_count, total_count);
 		}
 	}
+}
+
+static int bgp_show_table(struct vty *vty, struct bgp *bgp, safi_t safi,
+			  struct bgp_table *table, enum bgp_show_type type,
+			  void *output_arg, char *rd, int is_last,
+			  unsigned long *output_cum, unsigned long *total_cum,
+			  unsigned long *json_header_depth, uint16_t show_flags,
+			  enum rpki_states rpki_target_state)
+{
+	struct bgp_show_ctx ctx = {
+		.vty = vty,
+		.bgp = bgp,
+		.safi = safi,
+		.table = table,
+		.type = type,
+		.output_arg = output_arg,
+		.rd = rd,
+		.is_last = is_last,
+		.json_header_depth = json_header_depth,
+		.show_flags = show_flags,
+		.rpki_target_state = rpki_target_state,
+	};
+	struct bgp_dest *dest;
+
+	bgp_show_table_start(&ctx, output_cum);
+
+	/* Start processing of routes. */
+	for (dest = bgp_table_top(table); dest; dest = bgp_route_next(dest))
+		bgp_show_table_dest(&ctx, dest);
+
+	bgp_show_table_end(&ctx, output_cum, total_cum);
+
+	return CMD_SUCCESS;
+}
+
+static bool bgp_show_yield_step(struct vty *vty, void *arg)
+{
+	struct bgp_show_ctx *ctx = arg;
+
+	if (!ctx->dest)
+		return false;
+
+	bgp_show_table_dest(ctx, ctx->dest);
+	ctx->dest = bgp_route_next(ctx->dest);
+	return true;
+}
 
+static int bgp_show_yield_finish(struct vty *vty, void *arg)
+{
+	struct bgp_show_ctx *ctx = arg;
+
+	if (vty)
+		bgp_show_table_end(ctx, NULL, NULL);
+
+	if (ctx->dest)
+		bgp_dest_unlock_node(ctx->dest);
+	bgp_table_unlock(ctx->table);
+	bgp_unlock(ctx->bgp);
+	XFREE(MTYPE_BGP_SHOW_WALK, ctx);
 	return CMD_SUCCESS;
 }
 
+static const struct vty_walk_ops bgp_show_yield_ops = {
+	.step = bgp_show_yield_step,
+	.finish = bgp_show_yield_finish,
+};
+
+/*
+ * Same as bgp_show_table() for a whole table, but run through vty_walk() so
+ * that full table JSON dumps to vtysh neither block bgpd nor pile up in the
+ * vty output buffer.  The table and the next prefix stay locked in between.
+ * output_arg must not be needed after the command returns.
+ */
+static int bgp_show_yield(struct vty *vty, struct bgp *bgp, safi_t safi,
+			  struct bgp_table *table, enum bgp_show_type type,
+			  uint16_t show_flags,
+			  enum rpki_states rpki_target_state)
+{
+	struct bgp_show_ctx *ctx;
+
+	ctx = XCALLOC(MTYPE_BGP_SHOW_WALK, sizeof(*ctx));
+	ctx->vty = vty;
+	ctx->bgp = bgp_lock(bgp);
+	ctx->safi = safi;
+	ctx->table = table;
+	bgp_table_lock(table);
+	ctx->type = type;
+	ctx->is_last = 1;
+	ctx->json_header_depth = &ctx->yield_json_header_depth;
+	ctx->show_flags = show_flags;
+	ctx->rpki_target_state = rpki_target_state;
+
+	bgp_show_table_start(ctx, NULL);
+	ctx->dest = bgp_table_top(table);
+
+	return vty_walk(vty, &bgp_show_yield_ops, ctx);
+}
+
 int bgp_show_table_rd(struct vty *vty, struct bgp *bgp, safi_t safi,
 		      struct bgp_table *table, struct prefix_rd *prd_match,
 		      enum bgp_show_type type, void *output_arg, bool use_json)
@@ -11270,6 +12419,10 @@ static int bgp_show(struct vty *vty, struct bgp *bgp, afi_t afi, safi_t safi,
 	else if (safi == SAFI_LABELED_UNICAST)
 		safi = SAFI_UNICAST;
 
+	if (CHECK_FLAG(show_flags, BGP_SHOW_OPT_YIELD) && !output_arg)
+		return bgp_show_yield(vty, bgp, safi, table, type, show_flags,
+				      rpki_target_state);
+
 	return bgp_show_table(vty, bgp, safi, table, type, output_arg, NULL, 1,
 			      NULL, NULL, &json_header_depth, show_flags,
 			      rpki_target_state);
@@ -12319,9 +13472,13 @@ DEFPY(show_ip_bgp_json, show_ip_bgp_json_cmd,
 			return bgp_show(vty, bgp, afi, safi, sh_type,
 					bgp_community_alias, show_flags,
 					rpki_target_state);
-		else
+		else {
+			/* full table dumps may be huge, don't block bgpd */
+			if (uj)
+				SET_FLAG(show_flags, BGP_SHOW_OPT_YIELD);
 			return bgp_show(vty, bgp, afi, safi, sh_type, NULL,
 					show_flags, rpki_target_state);
+		}
 	} else {
 		/* show <ip> bgp ipv4 all: AFI_IP, show <ip> bgp ipv6 all:
 		 * AFI_IP6 */
@@ -13496,7 +14653,6 @@ show_adj_route(struct vty *vty, struct peer *peer, struct bgp_table *table,
 	struct attr attr;
 	int ret;
 	struct update_subgroup *subgrp;
-	struct peer_af *paf;
 	bool route_filtered;
 	bool use_json = CHECK_FLAG(show_flags, BGP_SHOW_OPT_JSON);
 	bool wide = CHECK_FLAG(show_flags, BGP_SHOW_OPT_WIDE);
@@ -13598,14 +14754,14 @@ show_adj_route(struct vty *vty, struct peer *peer, struct bgp_table *table,
 				const struct prefix *rn_p =
 					bgp_dest_get_prefix(dest);
 				if ((bgp_input_filter(peer, rn_p, &attr, afi,
-						      safi))
+						      safi, NULL))
 				    == FILTER_DENY)
 					route_filtered = true;
 
 				/* Filter prefix using route-map */
 				ret = bgp_input_modifier(peer, rn_p, &attr, afi,
 							 safi, rmap_name, NULL,
-							 0, NULL);
+							 0, NULL, NULL);
 
 				if (type == bgp_show_adj_route_filtered &&
 					!route_filtered && ret != RMAP_DENY) {
@@ -13623,52 +14779,54 @@ show_adj_route(struct vty *vty, struct peer *peer, struct bgp_table *table,
 				(*output_count)++;
 			}
 		} else if (type == bgp_show_adj_route_advertised) {
-			RB_FOREACH (adj, bgp_adj_out_rb, &dest->adj_out)
-				SUBGRP_FOREACH_PEER (adj->subgroup, paf) {
-					if (paf->peer != peer || !adj->attr)
-						continue;
+			if (!subgrp)
+				continue;
+
+			SUBGRP_FOREACH_DEST_ADJ (subgrp, dest, adj) {
+				if (!adj->attr)
+					continue;
+
+				show_adj_route_header(vty, bgp, table,
+						      header1, header2,
+						      json, json_scode,
+						      json_ocode, wide);
 
-					show_adj_route_header(vty, bgp, table,
-							      header1, header2,
-							      json, json_scode,
-							      json_ocode, wide);
-
-					const struct prefix *rn_p =
-						bgp_dest_get_prefix(dest);
-
-					attr = *adj->attr;
-					ret = bgp_output_modifier(
-						peer, rn_p, &attr, afi, safi,
-						rmap_name);
-
-					if (ret != RMAP_DENY) {
-						if ((safi == SAFI_MPLS_VPN)
-						    || (safi == SAFI_ENCAP)
-						    || (safi == SAFI_EVPN)) {
-							if (use_json)
-								json_object_string_add(
-									json_ar,
-									"rd",
-									rd_str);
-							else if (show_rd
-								 && rd_str) {
-								vty_out(vty,
-									"Route Distinguisher: %s\n",
-									rd_str);
-								show_rd = false;
-							}
+				const struct prefix *rn_p =
+					bgp_dest_get_prefix(dest);
+
+				attr = *adj->attr;
+				ret = bgp_output_modifier(
+					peer, rn_p, &attr, afi, safi,
+					rmap_name);
+
+				if (ret != RMAP_DENY) {
+					if ((safi == SAFI_MPLS_VPN)
+					    || (safi == SAFI_ENCAP)
+					    || (safi == SAFI_EVPN)) {
+						if (use_json)
+							json_object_string_add(
+								json_ar,
+								"rd",
+								rd_str);
+						else if (show_rd
+							 && rd_str) {
+							vty_out(vty,
+								"Route Distinguisher: %s\n",
+								rd_str);
+							show_rd = false;
 						}
-						route_vty_out_tmp(
-							vty, dest, rn_p, &attr,
-							safi, use_json, json_ar,
-							wide);
-						(*output_count)++;
-					} else {
-						(*filtered_count)++;
 					}
-
-					bgp_attr_undup(&attr, adj->attr);
+					route_vty_out_tmp(
+						vty, dest, rn_p, &attr,
+						safi, use_json, json_ar,
+						wide);
+					(*output_count)++;
+				} else {
+					(*filtered_count)++;
 				}
+
+				bgp_attr_undup(&attr, adj->attr);
+			}
 		} else if (type == bgp_show_adj_route_bestpath) {
 			struct bgp_path_info *pi;
 
@@ -307,8 +307,13 @@ struct bgp_path_info {
 	/* Addpath identifiers */
 	uint32_t addpath_rx_id;
 	struct bgp_addpath_info_data tx_addpath;
+
+	/* peer->paths[afi][safi] */
+	struct bgp_peer_paths_item peer_paths;
 };
 
+DECLARE_DLIST(bgp_peer_paths, struct bgp_path_info, peer_paths);
+
 /* Structure used in BGP path selection */
 struct bgp_path_info_pair {
 	struct bgp_path_info *old;
@@ -410,6 +415,14 @@ struct bgp_aggregate {
 	 */
 	struct hash *aspath_hash;
 
+	/* Count, for each community, extended community and large community
+	 * value, of the distinct sets in the hashes above carrying it, so
+	 * the aggregate's own sets are edited rather than rebuilt.
+	 */
+	struct hash *community_val_hash;
+	struct hash *ecommunity_val_hash;
+	struct hash *lcommunity_val_hash;
+
 	/* Aggregate route's community. */
 	struct community *community;
 
@@ -582,6 +595,15 @@ DECLARE_HOOK(bgp_process,
 	      struct peer *peer, bool withdraw),
 	     (bgp, afi, safi, bn, peer, withdraw));
 
+/* called when the selected path of a destination, or its attributes, changed;
+ * either path may be NULL
+ */
+DECLARE_HOOK(bgp_route_update,
+	     (struct bgp * bgp, afi_t afi, safi_t safi, struct bgp_dest *bn,
+	      struct bgp_path_info *old_route,
+	      struct bgp_path_info *new_route),
+	     (bgp, afi, safi, bn, old_route, new_route));
+
 /* BGP show options */
 #define BGP_SHOW_OPT_JSON (1 << 0)
 #define BGP_SHOW_OPT_WIDE (1 << 1)
@@ -592,6 +614,8 @@ DECLARE_HOOK(bgp_process,
 #define BGP_SHOW_OPT_FAILED (1 << 6)
 #define BGP_SHOW_OPT_DETAIL (1 << 7)
 #define BGP_SHOW_OPT_TERSE (1 << 8)
+/* may return CMD_SUSPEND and finish from events, see bgp_show_yield() */
+#define BGP_SHOW_OPT_YIELD (1 << 9)
 
 /* Prototypes. */
 extern void bgp_rib_remove(struct bgp_dest *dest, struct bgp_path_info *pi,
@@ -610,9 +634,14 @@ extern void bgp_soft_reconfig_table_task_cancel(const struct bgp *bgp,
 extern void bgp_soft_reconfig_in(struct peer *, afi_t, safi_t);
 extern void bgp_clear_route(struct peer *, afi_t, safi_t);
 extern void bgp_clear_route_all(struct peer *);
+extern void bgp_rmap_memo_clean(struct hash **memosp);
+extern void bgp_rmap_memo_finish(struct peer *peer);
 extern void bgp_clear_adj_in(struct peer *, afi_t, safi_t);
 extern void bgp_clear_stale_route(struct peer *, afi_t, safi_t);
 extern void bgp_set_stale_route(struct peer *peer, afi_t afi, safi_t safi);
+extern void bgp_path_restore(struct peer *peer, const struct prefix *p,
+			     uint32_t addpath_id, struct attr *attr, afi_t afi,
+			     safi_t safi);
 extern bool bgp_outbound_policy_exists(struct peer *, struct bgp_filter *);
 extern bool bgp_inbound_policy_exists(struct peer *, struct bgp_filter *);
 
@@ -699,6 +728,11 @@ extern void bgp_aggregate_delete(struct bgp *bgp, const struct prefix *p,
 extern void bgp_aggregate_route(struct bgp *bgp, const struct prefix *p,
 				afi_t afi, safi_t safi,
 				struct bgp_aggregate *aggregate);
+extern bool bgp_aggr_val_ref(struct hash **hash, const void *val,
+			     uint8_t len);
+extern bool bgp_aggr_val_unref(struct hash *hash, const void *val,
+			       uint8_t len);
+extern void bgp_aggr_val_free(struct hash **hash);
 extern void bgp_aggregate_increment(struct bgp *bgp, const struct prefix *p,
 				    struct bgp_path_info *path, afi_t afi,
 				    safi_t safi);
@@ -732,7 +766,8 @@ extern void route_vty_out_overlay(struct vty *vty, const struct prefix *p,
 				  struct bgp_path_info *path, int display,
 				  json_object *json);
 
-extern void bgp_notify_conditional_adv_scanner(struct update_subgroup *subgrp);
+extern void bgp_notify_conditional_adv_scanner(struct update_subgroup *subgrp,
+					       struct bgp_dest *dest);
 
 extern void subgroup_process_announce_selected(struct update_subgroup *subgrp,
 					       struct bgp_path_info *selected,
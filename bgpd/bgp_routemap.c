@@ -68,6 +68,7 @@
 #include "bgpd/bgp_encap_types.h"
 #include "bgpd/bgp_mpath.h"
 #include "bgpd/bgp_script.h"
+#include "bgpd/bgp_conditional_adv.h"
 
 #ifdef ENABLE_BGP_VNC
 #include "bgpd/rfapi/bgp_rfapi_cfg.h"
@@ -142,6 +143,14 @@ struct rmap_value {
 	uint32_t value;
 };
 
+/* rtt changes under the route-map's feet */
+static bool route_value_memoizable(void *rule)
+{
+	struct rmap_value *rv = rule;
+
+	return rv->variable == 0;
+}
+
 static int route_value_match(struct rmap_value *rv, uint32_t value)
 {
 	if (rv->variable == 0 && value == rv->value)
@@ -361,19 +370,63 @@ enum frrlua_rm_status {
 	LUA_RM_MATCH_AND_CHANGE,
 };
 
+/*
+ * The script is loaded and compiled once, then run for every route; it's
+ * loaded again when its file changes, which is checked at most once a
+ * second.  Route-maps can be applied on several pthreads at once, so the
+ * Lua state is only used under the mutex.
+ */
+struct route_match_script {
+	char *name;
+
+	pthread_mutex_t mtx;
+	struct frrscript *fs;
+	time_t checked;
+};
+
+static enum route_map_cmd_result_t
+route_match_script_run(struct route_match_script *rms,
+		       const struct prefix *prefix, struct bgp_path_info *path);
+
 static enum route_map_cmd_result_t
 route_match_script(void *rule, const struct prefix *prefix, void *object)
 {
-	const char *scriptname = rule;
+	struct route_match_script *rms = rule;
 	struct bgp_path_info *path = (struct bgp_path_info *)object;
+	enum route_map_cmd_result_t status;
+	time_t now = monotime(NULL);
+
+	frr_with_mutex(&rms->mtx) {
+		if (rms->fs && rms->checked != now) {
+			rms->checked = now;
+			if (frrscript_is_stale(rms->fs)) {
+				frrscript_unload(rms->fs);
+				rms->fs = NULL;
+			}
+		}
+		if (!rms->fs) {
+			rms->fs = frrscript_load(rms->name, NULL);
+			rms->checked = now;
+		}
 
-	struct frrscript *fs = frrscript_load(scriptname, NULL);
-
-	if (!fs) {
-		zlog_err("Issue loading script rule; defaulting to no match");
-		return RMAP_NOMATCH;
+		if (!rms->fs) {
+			zlog_err(
+				"Issue loading script rule; defaulting to no match");
+			status = RMAP_NOMATCH;
+		} else
+			status = route_match_script_run(rms, prefix, path);
 	}
 
+	return status;
+}
+
+static enum route_map_cmd_result_t
+route_match_script_run(struct route_match_script *rms,
+		       const struct prefix *prefix, struct bgp_path_info *path)
+{
+	const char *scriptname = rms->name;
+	struct frrscript *fs = rms->fs;
+
 	enum frrlua_rm_status lrm_status = LUA_RM_FAILURE,
 			      status_nomatch = LUA_RM_NOMATCH,
 			      status_match = LUA_RM_MATCH,
@@ -427,23 +480,29 @@ route_match_script(void *rule, const struct prefix *prefix, void *object)
 		break;
 	}
 
-	frrscript_unload(fs);
-
 	return status;
 }
 
 static void *route_match_script_compile(const char *arg)
 {
-	char *scriptname;
+	struct route_match_script *rms;
 
-	scriptname = XSTRDUP(MTYPE_ROUTE_MAP_COMPILED, arg);
+	rms = XCALLOC(MTYPE_ROUTE_MAP_COMPILED, sizeof(*rms));
+	rms->name = XSTRDUP(MTYPE_ROUTE_MAP_COMPILED, arg);
+	pthread_mutex_init(&rms->mtx, NULL);
 
-	return scriptname;
+	return rms;
 }
 
 static void route_match_script_free(void *rule)
 {
-	XFREE(MTYPE_ROUTE_MAP_COMPILED, rule);
+	struct route_match_script *rms = rule;
+
+	if (rms->fs)
+		frrscript_unload(rms->fs);
+	pthread_mutex_destroy(&rms->mtx);
+	XFREE(MTYPE_ROUTE_MAP_COMPILED, rms->name);
+	XFREE(MTYPE_ROUTE_MAP_COMPILED, rms);
 }
 
 static const struct route_map_rule_cmd route_match_script_cmd = {
@@ -1233,7 +1292,9 @@ static const struct route_map_rule_cmd route_match_local_pref_cmd = {
 	"local-preference",
 	route_match_local_pref,
 	route_match_local_pref_compile,
-	route_match_local_pref_free
+	route_match_local_pref_free,
+	NULL,
+	route_map_rule_memoizable
 };
 
 /* `match metric METRIC' */
@@ -1256,6 +1317,8 @@ static const struct route_map_rule_cmd route_match_metric_cmd = {
 	route_match_metric,
 	route_value_compile,
 	route_value_free,
+	NULL,
+	route_map_rule_memoizable
 };
 
 /* `match as-path ASPATH' */
@@ -1297,7 +1360,9 @@ static const struct route_map_rule_cmd route_match_aspath_cmd = {
 	"as-path",
 	route_match_aspath,
 	route_match_aspath_compile,
-	route_match_aspath_free
+	route_match_aspath_free,
+	NULL,
+	route_map_rule_memoizable
 };
 
 /* `match community COMMUNIY' */
@@ -1389,7 +1454,8 @@ static const struct route_map_rule_cmd route_match_community_cmd = {
 	route_match_community,
 	route_match_community_compile,
 	route_match_community_free,
-	route_match_get_community_key
+	route_match_get_community_key,
+	route_map_rule_memoizable
 };
 
 /* Match function for lcommunity match. */
@@ -1457,7 +1523,8 @@ static const struct route_map_rule_cmd route_match_lcommunity_cmd = {
 	route_match_lcommunity,
 	route_match_lcommunity_compile,
 	route_match_lcommunity_free,
-	route_match_get_community_key
+	route_match_get_community_key,
+	route_map_rule_memoizable
 };
 
 
@@ -1508,7 +1575,9 @@ static const struct route_map_rule_cmd route_match_ecommunity_cmd = {
 	"extcommunity",
 	route_match_ecommunity,
 	route_match_ecommunity_compile,
-	route_match_ecommunity_free
+	route_match_ecommunity_free,
+	NULL,
+	route_map_rule_memoizable
 };
 
 /* `match nlri` and `set nlri` are replaced by `address-family ipv4`
@@ -1557,7 +1626,9 @@ static const struct route_map_rule_cmd route_match_origin_cmd = {
 	"origin",
 	route_match_origin,
 	route_match_origin_compile,
-	route_match_origin_free
+	route_match_origin_free,
+	NULL,
+	route_map_rule_memoizable
 };
 
 /* match probability  { */
@@ -1858,6 +1929,8 @@ static const struct route_map_rule_cmd route_set_local_pref_cmd = {
 	route_set_local_pref,
 	route_value_compile,
 	route_value_free,
+	NULL,
+	route_value_memoizable
 };
 
 /* `set weight WEIGHT' */
@@ -1885,6 +1958,8 @@ static const struct route_map_rule_cmd route_set_weight_cmd = {
 	route_set_weight,
 	route_value_compile,
 	route_value_free,
+	NULL,
+	route_value_memoizable
 };
 
 /* `set distance DISTANCE */
@@ -1936,6 +2011,8 @@ static const struct route_map_rule_cmd route_set_metric_cmd = {
 	route_set_metric,
 	route_value_compile,
 	route_value_free,
+	NULL,
+	route_value_memoizable
 };
 
 /* `set table (1-4294967295)' */
@@ -2020,6 +2097,8 @@ static const struct route_map_rule_cmd route_set_aspath_prepend_cmd = {
 	route_set_aspath_prepend,
 	route_set_aspath_prepend_compile,
 	route_set_aspath_prepend_free,
+	NULL,
+	route_map_rule_memoizable
 };
 
 /* `set as-path exclude ASn' */
@@ -2165,6 +2244,8 @@ static const struct route_map_rule_cmd route_set_community_cmd = {
 	route_set_community,
 	route_set_community_compile,
 	route_set_community_free,
+	NULL,
+	route_map_rule_memoizable
 };
 
 /* `set community COMMUNITY' */
@@ -2280,6 +2361,8 @@ static const struct route_map_rule_cmd route_set_lcommunity_cmd = {
 	route_set_lcommunity,
 	route_set_lcommunity_compile,
 	route_set_lcommunity_free,
+	NULL,
+	route_map_rule_memoizable
 };
 
 /* `set large-comm-list (<1-99>|<100-500>|WORD) delete' */
@@ -2366,6 +2449,8 @@ static const struct route_map_rule_cmd route_set_lcommunity_delete_cmd = {
 	route_set_lcommunity_delete,
 	route_set_lcommunity_delete_compile,
 	route_set_lcommunity_delete_free,
+	NULL,
+	route_map_rule_memoizable
 };
 
 
@@ -2453,6 +2538,8 @@ static const struct route_map_rule_cmd route_set_community_delete_cmd = {
 	route_set_community_delete,
 	route_set_community_delete_compile,
 	route_set_community_delete_free,
+	NULL,
+	route_map_rule_memoizable
 };
 
 /* `set extcommunity rt COMMUNITY' */
@@ -2726,6 +2813,8 @@ static const struct route_map_rule_cmd route_set_origin_cmd = {
 	route_set_origin,
 	route_set_origin_compile,
 	route_set_origin_free,
+	NULL,
+	route_map_rule_memoizable
 };
 
 /* `set atomic-aggregate' */
@@ -3553,7 +3642,7 @@ static void bgp_route_map_process_peer(const char *rmap_name,
 		peer->default_rmap[afi][safi].map = map;
 
 	/* Notify BGP conditional advertisement scanner percess */
-	peer->advmap_config_change[afi][safi] = true;
+	bgp_conditional_adv_config_change(peer, afi, safi);
 }
 
 static void bgp_route_map_update_peer_group(const char *rmap_name,
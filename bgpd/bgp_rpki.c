@@ -40,6 +40,7 @@
 #include "memory.h"
 #include "thread.h"
 #include "filter.h"
+#include "table.h"
 #include "bgpd/bgpd.h"
 #include "bgpd/bgp_table.h"
 #include "bgp_advertise.h"
@@ -65,11 +66,18 @@
 
 DEFINE_MTYPE_STATIC(BGPD, BGP_RPKI_CACHE, "BGP RPKI Cache server");
 DEFINE_MTYPE_STATIC(BGPD, BGP_RPKI_CACHE_GROUP, "BGP RPKI Cache server group");
+DEFINE_MTYPE_STATIC(BGPD, BGP_RPKI_VCACHE, "BGP RPKI validation result");
 
 #define POLLING_PERIOD_DEFAULT 3600
 #define EXPIRE_INTERVAL_DEFAULT 7200
 #define RETRY_INTERVAL_DEFAULT 600
 
+/* ROA records read from the rtrlib thread per event */
+#define RPKI_SYNC_READ_MAX 10000
+/* routes revalidated before going back to the event loop */
+#define RPKI_REVALIDATE_BATCH 1000
+#define RPKI_VCACHE_MAX (1024 * 1024)
+
 #define RPKI_DEBUG(...)                                                        \
 	if (rpki_debug) {                                                      \
 		zlog_debug("RPKI: " __VA_ARGS__);                              \
@@ -90,6 +98,28 @@ struct cache {
 
 enum return_values { SUCCESS = 0, ERROR = -1 };
 
+/*
+ * Validation results by (prefix, origin AS).  The same prefix usually
+ * comes with the same origin from many peers, so there is no point in
+ * asking rtrlib again for each of them, and hits don't contend with the
+ * rtrlib thread for its table lock while a cache is being reloaded.  They
+ * are kept in a prefix tree so that a changed ROA only drops the results
+ * for the range it covers.
+ */
+struct rpki_vcache_entry {
+	struct rpki_vcache_entry *next;
+	as_t as;
+	enum pfxv_state state;
+};
+
+static struct route_table *rpki_vcache[AFI_MAX];
+static unsigned long rpki_vcache_count;
+/* taken around lookups and inserts, which may come from route-maps applied
+ * on the soft reconfiguration workers; everything else runs on the main
+ * pthread while those are not running
+ */
+static pthread_mutex_t rpki_vcache_mtx = PTHREAD_MUTEX_INITIALIZER;
+
 struct rpki_for_each_record_arg {
 	struct vty *vty;
 	unsigned int *prefix_amount;
@@ -128,6 +158,8 @@ static enum route_map_cmd_result_t route_match(void *rule,
 static void *route_match_compile(const char *arg);
 static void revalidate_bgp_node(struct bgp_dest *dest, afi_t afi, safi_t safi);
 static void revalidate_all_routes(void);
+static void rpki_vcache_flush(void);
+static void rpki_revalidate_flush(void);
 
 static struct rtr_mgr_config *rtr_config;
 static struct list *cache_list;
@@ -141,6 +173,14 @@ static unsigned int retry_interval;
 static int rpki_sync_socket_rtr;
 static int rpki_sync_socket_bgpd;
 
+/*
+ * ROA ranges whose routes still have to be revalidated.  A range covers
+ * everything below it, so none of the pending ones overlap.
+ */
+static struct route_table *rpki_pending[AFI_MAX];
+static struct thread *t_rpki_revalidate;
+static int rpki_pending_mark;
+
 static struct cmd_node rpki_node = {
 	.name = "rpki",
 	.node = RPKI_NODE,
@@ -337,10 +377,10 @@ inline int is_running(void)
 	return rtr_is_running;
 }
 
-static struct prefix *pfx_record_to_prefix(struct pfx_record *record)
+static void pfx_record_to_prefix(struct pfx_record *record,
+				 struct prefix *prefix)
 {
-	struct prefix *prefix = prefix_new();
-
+	memset(prefix, 0, sizeof(*prefix));
 	prefix->prefixlen = record->min_len;
 
 	if (record->prefix.ver == LRTR_IPV4) {
@@ -351,16 +391,220 @@ static struct prefix *pfx_record_to_prefix(struct pfx_record *record)
 		ipv6_addr_to_network_byte_order(record->prefix.u.addr6.addr,
 						prefix->u.prefix6.s6_addr32);
 	}
-
-	return prefix;
+	apply_mask(prefix);
 }
 
-static int bgpd_sync_callback(struct thread *thread)
+/* Revalidates the routes covered by a ROA, returns how many there were. */
+static unsigned int revalidate_prefix(const struct prefix *prefix, afi_t afi)
 {
 	struct bgp *bgp;
 	struct listnode *node;
-	struct prefix *prefix;
+	unsigned int count = 0;
+
+	for (ALL_LIST_ELEMENTS_RO(bm->bgp, node, bgp)) {
+		safi_t safi;
+
+		for (safi = SAFI_UNICAST; safi < SAFI_MAX; safi++) {
+			struct bgp_dest *match;
+			struct bgp_dest *dest;
+
+			if (!bgp->rib[afi][safi])
+				continue;
+
+			match = bgp_table_subtree_lookup(bgp->rib[afi][safi],
+							 prefix);
+			dest = match;
+
+			while (dest) {
+				if (bgp_dest_has_bgp_path_info_data(dest)) {
+					revalidate_bgp_node(dest, afi, safi);
+					count++;
+				}
+
+				dest = bgp_route_next_until(dest, match);
+			}
+		}
+	}
+
+	return count;
+}
+
+static int rpki_revalidate_pending(struct thread *thread)
+{
+	unsigned int count = 0;
+	struct route_node *rn;
+	afi_t afi;
+
+	for (afi = AFI_IP; afi <= AFI_IP6; afi++) {
+		for (rn = route_top(rpki_pending[afi]); rn;
+		     rn = route_next(rn)) {
+			if (!rn->info)
+				continue;
+
+			rn->info = NULL;
+			count += revalidate_prefix(&rn->p, afi);
+			route_unlock_node(rn);
+
+			if (count >= RPKI_REVALIDATE_BATCH) {
+				route_unlock_node(rn);
+				thread_add_event(bm->master,
+						 rpki_revalidate_pending, NULL,
+						 0, &t_rpki_revalidate);
+				return 0;
+			}
+		}
+	}
+
+	return 0;
+}
+
+/* Queues the routes covered by a changed ROA for revalidation. */
+static void rpki_revalidate_add(const struct prefix *prefix, afi_t afi)
+{
+	struct route_table *table = rpki_pending[afi];
+	struct route_node *rn, *top;
+
+	rn = route_node_match(table, prefix);
+	if (rn) {
+		/* a pending range covers it already */
+		route_unlock_node(rn);
+		return;
+	}
+
+	top = route_node_get(table, prefix);
+
+	/* and this one covers the pending ranges below it */
+	rn = route_lock_node(top);
+	while ((rn = route_next_until(rn, top))) {
+		if (rn->info) {
+			rn->info = NULL;
+			route_unlock_node(rn);
+		}
+	}
+
+	top->info = &rpki_pending_mark;
+	thread_add_event(bm->master, rpki_revalidate_pending, NULL, 0,
+			 &t_rpki_revalidate);
+}
+
+static void rpki_revalidate_flush(void)
+{
+	struct route_node *rn;
+	afi_t afi;
+
+	THREAD_OFF(t_rpki_revalidate);
+
+	for (afi = AFI_IP; afi <= AFI_IP6; afi++) {
+		if (!rpki_pending[afi])
+			continue;
+
+		for (rn = route_top(rpki_pending[afi]); rn;
+		     rn = route_next(rn)) {
+			if (rn->info) {
+				rn->info = NULL;
+				route_unlock_node(rn);
+			}
+		}
+	}
+}
+
+static bool rpki_vcache_get(const struct prefix *prefix, as_t as,
+			    enum pfxv_state *state)
+{
+	struct route_table *table = rpki_vcache[family2afi(prefix->family)];
+	struct rpki_vcache_entry *e;
+	struct route_node *rn;
+
+	rn = route_node_lookup(table, prefix);
+	if (!rn)
+		return false;
+
+	for (e = rn->info; e; e = e->next)
+		if (e->as == as)
+			break;
+	route_unlock_node(rn);
+
+	if (!e)
+		return false;
+	*state = e->state;
+	return true;
+}
+
+static void rpki_vcache_set(const struct prefix *prefix, as_t as,
+			    enum pfxv_state state)
+{
+	struct route_table *table = rpki_vcache[family2afi(prefix->family)];
+	struct rpki_vcache_entry *e;
+	struct route_node *rn;
+
+	if (rpki_vcache_count >= RPKI_VCACHE_MAX)
+		rpki_vcache_flush();
+
+	rn = route_node_get(table, prefix);
+	if (rn->info)
+		/* the node is locked once for as long as it has entries */
+		route_unlock_node(rn);
+
+	e = XMALLOC(MTYPE_BGP_RPKI_VCACHE, sizeof(*e));
+	e->as = as;
+	e->state = state;
+	e->next = rn->info;
+	rn->info = e;
+	rpki_vcache_count++;
+}
+
+static void rpki_vcache_drop(struct route_node *rn)
+{
+	struct rpki_vcache_entry *e, *next;
+
+	if (!rn->info)
+		return;
+
+	for (e = rn->info; e; e = next) {
+		next = e->next;
+		XFREE(MTYPE_BGP_RPKI_VCACHE, e);
+		rpki_vcache_count--;
+	}
+	rn->info = NULL;
+	route_unlock_node(rn);
+}
+
+/* A ROA changed, the results for everything it covers may be stale. */
+static void rpki_vcache_invalidate(const struct prefix *prefix, afi_t afi)
+{
+	struct route_node *rn, *top;
+
+	top = route_node_get(rpki_vcache[afi], prefix);
+
+	rn = route_lock_node(top);
+	do {
+		rpki_vcache_drop(rn);
+	} while ((rn = route_next_until(rn, top)));
+
+	route_unlock_node(top);
+}
+
+static void rpki_vcache_flush(void)
+{
+	struct route_node *rn;
+	afi_t afi;
+
+	for (afi = AFI_IP; afi <= AFI_IP6; afi++) {
+		if (!rpki_vcache[afi])
+			continue;
+
+		for (rn = route_top(rpki_vcache[afi]); rn; rn = route_next(rn))
+			rpki_vcache_drop(rn);
+	}
+}
+
+static int bgpd_sync_callback(struct thread *thread)
+{
+	struct prefix prefix;
 	struct pfx_record rec;
+	unsigned int count = 0;
+	afi_t afi;
+	int retval;
 
 	thread_add_read(bm->master, bgpd_sync_callback, NULL,
 			rpki_sync_socket_bgpd, NULL);
@@ -373,53 +617,34 @@ static int bgpd_sync_callback(struct thread *thread)
 
 		atomic_store_explicit(&rtr_update_overflow, 0,
 				      memory_order_seq_cst);
+		rpki_vcache_flush();
+		rpki_revalidate_flush();
 		revalidate_all_routes();
 		return 0;
 	}
 
-	int retval =
-		read(rpki_sync_socket_bgpd, &rec, sizeof(struct pfx_record));
-	if (retval != sizeof(struct pfx_record)) {
-		RPKI_DEBUG("Could not read from rpki_sync_socket_bgpd");
-		return retval;
-	}
-	prefix = pfx_record_to_prefix(&rec);
-
-	afi_t afi = (rec.prefix.ver == LRTR_IPV4) ? AFI_IP : AFI_IP6;
-
-	for (ALL_LIST_ELEMENTS_RO(bm->bgp, node, bgp)) {
-		struct peer *peer;
-		struct listnode *peer_listnode;
-
-		for (ALL_LIST_ELEMENTS_RO(bgp->peer, peer_listnode, peer)) {
-			safi_t safi;
-
-			for (safi = SAFI_UNICAST; safi < SAFI_MAX; safi++) {
-				if (!peer->bgp->rib[afi][safi])
-					continue;
-
-				struct bgp_dest *match;
-				struct bgp_dest *node;
-
-				match = bgp_table_subtree_lookup(
-					peer->bgp->rib[afi][safi], prefix);
-				node = match;
+	/*
+	 * Take everything rtrlib has queued up, a cache reload brings a lot
+	 * of records at once and many of them share a range.
+	 */
+	while (count < RPKI_SYNC_READ_MAX) {
+		retval = read(rpki_sync_socket_bgpd, &rec,
+			      sizeof(struct pfx_record));
+		if (retval != sizeof(struct pfx_record))
+			break;
 
-				while (node) {
-					if (bgp_dest_has_bgp_path_info_data(
-						    node)) {
-						revalidate_bgp_node(node, afi,
-								    safi);
-					}
+		count++;
+		afi = (rec.prefix.ver == LRTR_IPV4) ? AFI_IP : AFI_IP6;
+		pfx_record_to_prefix(&rec, &prefix);
+		rpki_vcache_invalidate(&prefix, afi);
+		rpki_revalidate_add(&prefix, afi);
+	}
 
-					node = bgp_route_next_until(node,
-								    match);
-				}
-			}
-		}
+	if (!count) {
+		RPKI_DEBUG("Could not read from rpki_sync_socket_bgpd");
+		return -1;
 	}
 
-	prefix_free(&prefix);
 	return 0;
 }
 
@@ -541,6 +766,10 @@ static int bgp_rpki_init(struct thread_master *master)
 	polling_period = POLLING_PERIOD_DEFAULT;
 	expire_interval = EXPIRE_INTERVAL_DEFAULT;
 	retry_interval = RETRY_INTERVAL_DEFAULT;
+	rpki_vcache[AFI_IP] = route_table_init();
+	rpki_vcache[AFI_IP6] = route_table_init();
+	rpki_pending[AFI_IP] = route_table_init();
+	rpki_pending[AFI_IP6] = route_table_init();
 	install_cli_commands();
 	rpki_init_sync_socket();
 	return 0;
@@ -551,6 +780,12 @@ static int bgp_rpki_fini(void)
 	stop();
 	list_delete(&cache_list);
 
+	rpki_revalidate_flush();
+	route_table_finish(rpki_pending[AFI_IP]);
+	route_table_finish(rpki_pending[AFI_IP6]);
+	route_table_finish(rpki_vcache[AFI_IP]);
+	route_table_finish(rpki_vcache[AFI_IP6]);
+
 	close(rpki_sync_socket_rtr);
 	close(rpki_sync_socket_bgpd);
 
@@ -615,6 +850,7 @@ static void stop(void)
 		rtr_mgr_free(rtr_config);
 		rtr_is_running = 0;
 	}
+	rpki_vcache_flush();
 }
 
 static int reset(bool force)
@@ -700,6 +936,7 @@ static int rpki_validate_prefix(struct peer *peer, struct attr *attr,
 	as_t as_number = 0;
 	struct lrtr_ip_addr ip_addr_prefix;
 	enum pfxv_state result;
+	bool cached;
 
 	if (!is_synchronized())
 		return 0;
@@ -745,9 +982,17 @@ static int rpki_validate_prefix(struct peer *peer, struct attr *attr,
 		return 0;
 	}
 
-	// Do the actual validation
-	rtr_mgr_validate(rtr_config, as_number, &ip_addr_prefix,
-			 prefix->prefixlen, &result);
+	frr_with_mutex(&rpki_vcache_mtx) {
+		cached = rpki_vcache_get(prefix, as_number, &result);
+	}
+	if (!cached) {
+		// Do the actual validation
+		rtr_mgr_validate(rtr_config, as_number, &ip_addr_prefix,
+				 prefix->prefixlen, &result);
+		frr_with_mutex(&rpki_vcache_mtx) {
+			rpki_vcache_set(prefix, as_number, result);
+		}
+	}
 
 	// Print Debug output
 	switch (result) {
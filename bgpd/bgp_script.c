@@ -148,7 +148,7 @@ void lua_pushattr(lua_State *L, const struct attr *attr)
 	lua_setfield(L, -2, "metric");
 	lua_pushinteger(L, attr->nh_ifindex);
 	lua_setfield(L, -2, "ifindex");
-	lua_pushstring(L, attr->aspath->str);
+	lua_pushstring(L, aspath_print(attr->aspath));
 	lua_setfield(L, -2, "aspath");
 	lua_pushinteger(L, attr->local_pref);
 	lua_setfield(L, -2, "localpref");
@@ -650,6 +650,37 @@ static uint8_t *bgpRcvdPathAttrTable(struct variable *v, oid name[],
 	return NULL;
 }
 
+/*
+ * Where the last GETNEXT on bgp4PathAttrTable ended.  Walks ask for the row
+ * after the one they got last, so resume from its (locked) node rather than
+ * looking the prefix up again.
+ */
+static struct {
+	struct bgp *bgp;
+	struct bgp_dest *dest;
+	struct prefix_ipv4 p;
+} pathattr_cursor;
+
+static void bgp4PathAttrCursorSet(struct bgp *bgp, struct bgp_dest *dest)
+{
+	if (pathattr_cursor.dest == dest)
+		return;
+
+	if (pathattr_cursor.dest)
+		bgp_dest_unlock_node(pathattr_cursor.dest);
+	pathattr_cursor.bgp = bgp;
+	pathattr_cursor.dest = dest ? bgp_dest_lock_node(dest) : NULL;
+	if (dest)
+		prefix_copy(&pathattr_cursor.p, bgp_dest_get_prefix(dest));
+}
+
+static int bgp4PathAttrCursorDrop(struct bgp *bgp)
+{
+	if (pathattr_cursor.bgp == bgp)
+		bgp4PathAttrCursorSet(NULL, NULL);
+	return 0;
+}
+
 static struct bgp_path_info *bgp4PathAttrLookup(struct variable *v, oid name[],
 						size_t *length, struct bgp *bgp,
 						struct prefix_ipv4 *addr,
@@ -692,9 +723,11 @@ static struct bgp_path_info *bgp4PathAttrLookup(struct variable *v, oid name[],
 			for (path = bgp_dest_get_bgp_path_info(dest); path;
 			     path = path->next)
 				if (sockunion_same(&path->peer->su, &su))
-					return path;
+					break;
 
 			bgp_dest_unlock_node(dest);
+			if (path)
+				return path;
 		}
 	} else {
 		offset = name + v->namelen;
@@ -717,8 +750,13 @@ static struct bgp_path_info *bgp4PathAttrLookup(struct variable *v, oid name[],
 			else
 				addr->prefixlen = len * 8;
 
-			dest = bgp_node_get(bgp->rib[AFI_IP][SAFI_UNICAST],
-					    (struct prefix *)addr);
+			if (pathattr_cursor.dest && pathattr_cursor.bgp == bgp
+			    && prefix_same(&pathattr_cursor.p, addr))
+				dest = bgp_dest_lock_node(pathattr_cursor.dest);
+			else
+				dest = bgp_node_get(
+					bgp->rib[AFI_IP][SAFI_UNICAST],
+					(struct prefix *)addr);
 
 			offset++;
 			offsetlen--;
@@ -776,6 +814,7 @@ static struct bgp_path_info *bgp4PathAttrLookup(struct variable *v, oid name[],
 				addr->prefix = rn_p->u.prefix4;
 				addr->prefixlen = rn_p->prefixlen;
 
+				bgp4PathAttrCursorSet(bgp, dest);
 				bgp_dest_unlock_node(dest);
 
 				return min;
@@ -907,6 +946,7 @@ static int bgp_snmp_module_init(void)
 	hook_register(peer_status_changed, bgpTrapEstablished);
 	hook_register(peer_backward_transition, bgpTrapBackwardTransition);
 	hook_register(frr_late_init, bgp_snmp_init);
+	hook_register(bgp_inst_delete, bgp4PathAttrCursorDrop);
 	return 0;
 }
 
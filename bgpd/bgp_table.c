@@ -27,11 +27,15 @@
 #include "filter.h"
 #include "command.h"
 #include "printfrr.h"
+#include "id_alloc.h"
 
 #include "bgpd/bgpd.h"
 #include "bgpd/bgp_table.h"
 #include "bgp_addpath.h"
 
+/* Dense ids for the dests that have been advertised, see bgp_updgrp_adv.c */
+static struct id_alloc *bgp_adj_out_ids;
+
 void bgp_table_lock(struct bgp_table *rt)
 {
 	rt->lock++;
@@ -69,10 +73,55 @@ static struct route_node *bgp_node_create(route_table_delegate_t *delegate,
 	struct bgp_node *node;
 	node = XCALLOC(MTYPE_BGP_NODE, sizeof(struct bgp_node));
 
-	RB_INIT(bgp_adj_out_rb, &node->adj_out);
 	return bgp_dest_to_rnode(node);
 }
 
+static bool bgp_table_is_rd_table(const struct bgp_table *rt)
+{
+	if (rt->safi != SAFI_MPLS_VPN && rt->safi != SAFI_ENCAP
+	    && rt->safi != SAFI_EVPN)
+		return false;
+
+	return rt->bgp && rt != rt->bgp->rib[rt->afi][rt->safi];
+}
+
+/*
+ * Empty route distinguisher tables are freed from an event rather than as
+ * soon as their last node goes, the code deleting it may still be holding
+ * on to the table.  Tables someone else has locked are left to a later run.
+ */
+static int bgp_table_rd_sweep(struct thread *thread)
+{
+	struct bgp *bgp = THREAD_ARG(thread);
+	struct bgp_table *table;
+	struct bgp_dest *pdest;
+	afi_t afi;
+	safi_t safi;
+
+	if (CHECK_FLAG(bgp->flags, BGP_FLAG_DELETE_IN_PROGRESS))
+		return 0;
+
+	FOREACH_AFI_SAFI (afi, safi) {
+		if (safi != SAFI_MPLS_VPN && safi != SAFI_ENCAP
+		    && safi != SAFI_EVPN)
+			continue;
+
+		for (pdest = bgp_table_top(bgp->rib[afi][safi]); pdest;
+		     pdest = bgp_route_next(pdest)) {
+			table = bgp_dest_get_bgp_table_info(pdest);
+			if (!table || table->route_table->count
+			    || table->lock > 1 || table->soft_reconfig_init)
+				continue;
+
+			bgp_dest_set_bgp_table_info(pdest, NULL);
+			bgp_table_finish(&table);
+			/* the lock bgp_afi_node_get() kept for the table */
+			bgp_dest_unlock_node(pdest);
+		}
+	}
+	return 0;
+}
+
 /*
  * bgp_node_destroy
  */
@@ -90,7 +139,33 @@ static void bgp_node_destroy(route_table_delegate_t *delegate,
 					 rt->afi, rt->safi);
 	}
 
+	if (bgp_node->adj_out_id)
+		idalloc_free(bgp_adj_out_ids, bgp_node->adj_out_id);
+
 	XFREE(MTYPE_BGP_NODE, bgp_node);
+
+	/* not while the table itself is being freed */
+	if (!table->count && rt->lock && bgp_table_is_rd_table(rt))
+		thread_add_event(bm->master, bgp_table_rd_sweep, rt->bgp, 0,
+				 &rt->bgp->t_rd_table_sweep);
+}
+
+/*
+ * bgp_dest_adj_out_id
+ *
+ * Returns the id by which the update subgroups index their adj-outs for
+ * this dest, assigning one on first use. Ids are reused once the dest is
+ * freed, so that the indexes stay dense.
+ */
+uint32_t bgp_dest_adj_out_id(struct bgp_dest *dest)
+{
+	if (!dest->adj_out_id) {
+		if (!bgp_adj_out_ids)
+			bgp_adj_out_ids = idalloc_new("BGP adj-out index");
+		dest->adj_out_id = idalloc_allocate(bgp_adj_out_ids);
+	}
+
+	return dest->adj_out_id;
 }
 
 /*
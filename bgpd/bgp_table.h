@@ -92,8 +92,6 @@ struct bgp_node {
 	 */
 	ROUTE_NODE_FIELDS
 
-	struct bgp_adj_out_rb adj_out;
-
 	struct bgp_adj_in *adj_in;
 
 	struct bgp_dest *pdest;
@@ -104,6 +102,9 @@ struct bgp_node {
 
 	mpls_label_t local_label;
 
+	/* Slot in the subgroup adj-out indexes, 0 until first advertised */
+	uint32_t adj_out_id;
+
 	uint16_t flags;
 #define BGP_NODE_PROCESS_SCHEDULED	(1 << 0)
 #define BGP_NODE_USER_CLEAR             (1 << 1)
@@ -114,6 +115,7 @@ struct bgp_node {
 #define BGP_NODE_FIB_INSTALLED          (1 << 6)
 #define BGP_NODE_LABEL_REQUESTED        (1 << 7)
 #define BGP_NODE_SOFT_RECONFIG (1 << 8)
+#define BGP_NODE_BESTPATH_PRESEL (1 << 9)
 
 	struct bgp_addpath_node_data tx_addpath;
 
@@ -135,6 +137,7 @@ extern struct bgp_table *bgp_table_init(struct bgp *bgp, afi_t, safi_t);
 extern void bgp_table_lock(struct bgp_table *);
 extern void bgp_table_unlock(struct bgp_table *);
 extern void bgp_table_finish(struct bgp_table **);
+extern uint32_t bgp_dest_adj_out_id(struct bgp_dest *dest);
 
 
 /*
@@ -0,0 +1,156 @@
+/*
+ * BGP cache of attribute string representations.
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+
+#include "frr_pthread.h"
+#include "memory.h"
+#include "thread.h"
+#include "vty.h"
+#include "lib_vty.h"
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_aspath.h"
+#include "bgpd/bgp_community.h"
+#include "bgpd/bgp_lcommunity.h"
+#include "bgpd/bgp_textcache.h"
+
+DECLARE_DLIST(bgp_text_lru, struct bgp_text, lru);
+
+pthread_mutex_t bgp_text_mtx = PTHREAD_MUTEX_INITIALIZER;
+
+/* least recently used first */
+static struct bgp_text_lru_head bgp_text_lru = INIT_DLIST(bgp_text_lru);
+static size_t bgp_text_used;
+static size_t bgp_text_limit = (size_t)BGP_TEXT_LIMIT_DEF << 20;
+static uint64_t bgp_text_evictions;
+static struct thread *t_bgp_text_trim;
+
+/* json-c objects are a lot bigger than the string they were made from; this
+ * is a rough estimate of what the "string" and "list" members cost.
+ */
+static uint32_t bgp_text_size(size_t len, bool json)
+{
+	size_t size = len + 1;
+
+	if (json)
+		size += 8 * (len + 1) + 256;
+	return MIN(size, UINT32_MAX);
+}
+
+static void bgp_text_drop(struct bgp_text *text)
+{
+	switch (text->type) {
+	case BGP_TEXT_ASPATH:
+		aspath_text_drop(container_of(text, struct aspath, text));
+		break;
+	case BGP_TEXT_COMMUNITY:
+		community_text_drop(container_of(text, struct community, text));
+		break;
+	case BGP_TEXT_LCOMMUNITY:
+		lcommunity_text_drop(
+			container_of(text, struct lcommunity, text));
+		break;
+	}
+}
+
+static int bgp_text_trim(struct thread *thread)
+{
+	struct bgp_text *text;
+	size_t target = bgp_text_limit - bgp_text_limit / 8;
+
+	frr_with_mutex(&bgp_text_mtx) {
+		while (bgp_text_used > target
+		       && (text = bgp_text_lru_pop(&bgp_text_lru))) {
+			bgp_text_used -= text->size;
+			text->size = 0;
+			bgp_text_drop(text);
+			bgp_text_evictions++;
+		}
+	}
+	return 0;
+}
+
+void bgp_text_touch(struct bgp_text *text, enum bgp_text_type type,
+		    size_t len, bool json)
+{
+	uint32_t size = bgp_text_size(len, json);
+
+	if (text->size)
+		bgp_text_lru_del(&bgp_text_lru, text);
+
+	bgp_text_used += size;
+	bgp_text_used -= text->size;
+	text->size = size;
+	text->type = type;
+	bgp_text_lru_add_tail(&bgp_text_lru, text);
+
+	if (bgp_text_used > bgp_text_limit && bm && bm->master)
+		thread_add_event(bm->master, bgp_text_trim, NULL, 0,
+				 &t_bgp_text_trim);
+}
+
+void bgp_text_forget(struct bgp_text *text)
+{
+	if (!text->size)
+		return;
+
+	bgp_text_lru_del(&bgp_text_lru, text);
+	bgp_text_used -= text->size;
+	text->size = 0;
+}
+
+void bgp_text_set_limit(uint32_t limit)
+{
+	frr_with_mutex(&bgp_text_mtx) {
+		bgp_text_limit = (size_t)limit << 20;
+		if (bgp_text_used > bgp_text_limit && bm && bm->master)
+			thread_add_event(bm->master, bgp_text_trim, NULL, 0,
+					 &t_bgp_text_trim);
+	}
+}
+
+uint32_t bgp_text_get_limit(void)
+{
+	return bgp_text_limit >> 20;
+}
+
+void bgp_text_show_memory(struct vty *vty)
+{
+	char usedbuf[MTYPE_MEMSTR_LEN], limitbuf[MTYPE_MEMSTR_LEN];
+	size_t count, used, limit = bgp_text_limit;
+	uint64_t evictions;
+
+	frr_with_mutex(&bgp_text_mtx) {
+		count = bgp_text_lru_count(&bgp_text_lru);
+		used = bgp_text_used;
+		evictions = bgp_text_evictions;
+	}
+
+	vty_out(vty,
+		"%zu cached attribute strings, using %s of %s (%" PRIu64
+		" evicted)\n",
+		count, mtype_memstr(usedbuf, sizeof(usedbuf), used),
+		mtype_memstr(limitbuf, sizeof(limitbuf), limit), evictions);
+}
+
+void bgp_text_finish(void)
+{
+	THREAD_OFF(t_bgp_text_trim);
+}
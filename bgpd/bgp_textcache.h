@@ -0,0 +1,87 @@
+/*
+ * BGP cache of attribute string representations.
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _FRR_BGP_TEXTCACHE_H
+#define _FRR_BGP_TEXTCACHE_H
+
+#include <pthread.h>
+
+#include "lib/typesafe.h"
+
+/*
+ * The string and json forms of AS paths, communities and large communities
+ * are only needed by show commands, debugs and regular expression matches.
+ * They are built on first use and kept on a LRU list; once the list goes
+ * over its memory budget the least recently used ones are dropped again,
+ * from an event so that a pointer handed out by aspath_print() and friends
+ * stays valid until the caller returns to the event loop.
+ */
+PREDECL_DLIST(bgp_text_lru);
+
+enum bgp_text_type {
+	BGP_TEXT_ASPATH,
+	BGP_TEXT_COMMUNITY,
+	BGP_TEXT_LCOMMUNITY,
+};
+
+/* Embedded in the objects owning the strings */
+struct bgp_text {
+	struct bgp_text_lru_item lru;
+	/* estimated bytes used, 0 if nothing is cached */
+	uint32_t size;
+	uint8_t type;
+};
+
+#define BGP_TEXT_LIMIT_DEF 64 /* MiB */
+
+/*
+ * Serializes building, using and dropping cached strings; debugs may print
+ * attributes from the worker pthreads.
+ */
+extern pthread_mutex_t bgp_text_mtx;
+
+/**
+ * Accounts for a string that was just built or used.  Must hold bgp_text_mtx.
+ *
+ * @param text - LRU entry of the owning object
+ * @param type - enum bgp_text_type of the owning object
+ * @param len - string length
+ * @param json - whether a json object is cached too
+ */
+extern void bgp_text_touch(struct bgp_text *text, enum bgp_text_type type,
+			   size_t len, bool json);
+
+/**
+ * Called by the owner after freeing its cached strings.  Must hold
+ * bgp_text_mtx.
+ */
+extern void bgp_text_forget(struct bgp_text *text);
+
+/**
+ * Sets the memory budget, in MiB.
+ */
+extern void bgp_text_set_limit(uint32_t limit);
+extern uint32_t bgp_text_get_limit(void);
+
+struct vty;
+extern void bgp_text_show_memory(struct vty *vty);
+
+extern void bgp_text_finish(void);
+
+#endif /* _FRR_BGP_TEXTCACHE_H */
@@ -56,6 +56,8 @@
 #include "bgpd/bgp_filter.h"
 #include "bgpd/bgp_io.h"
 
+DEFINE_MTYPE_STATIC(BGPD, BGP_UPDGRP_NAME, "BGP update-group policy name");
+
 /********************
  * PRIVATE FUNCTIONS
  ********************/
@@ -155,6 +157,8 @@ static void conf_copy(struct peer *dst, struct peer *src, afi_t afi,
 	dst->afc_nego[afi][safi] = src->afc_nego[afi][safi];
 	dst->orf_plist[afi][safi] = src->orf_plist[afi][safi];
 	dst->addpath_type[afi][safi] = src->addpath_type[afi][safi];
+	dst->addpath_best_selected[afi][safi] =
+		src->addpath_best_selected[afi][safi];
 	dst->local_as = src->local_as;
 	dst->change_local_as = src->change_local_as;
 	dst->shared_network = src->shared_network;
@@ -263,26 +267,92 @@ static void peer2_updgrp_copy(struct update_group *updgrp, struct peer_af *paf)
 	conf_copy(dst, src, paf->afi, paf->safi);
 }
 
-/**
- * auxiliary functions to maintain the hash table.
- * - updgrp_hash_alloc - to create a new entry, passed to hash_get
- * - updgrp_hash_key_make - makes the key for update group search
- * - updgrp_hash_cmp - compare two update groups.
+/*
+ * Policy names in update group signatures are interned, so that signatures
+ * compare and hash as plain memory.
  */
-static void *updgrp_hash_alloc(void *p)
+struct updgrp_name {
+	char *name;
+	unsigned int refcnt;
+};
+
+static struct hash *updgrp_names;
+
+static unsigned int updgrp_name_hash_key(const void *arg)
 {
-	struct update_group *updgrp;
-	const struct update_group *in;
+	const struct updgrp_name *un = arg;
 
-	in = (const struct update_group *)p;
-	updgrp = XCALLOC(MTYPE_BGP_UPDGRP, sizeof(struct update_group));
-	memcpy(updgrp, in, sizeof(struct update_group));
-	updgrp->conf = XCALLOC(MTYPE_BGP_PEER, sizeof(struct peer));
-	conf_copy(updgrp->conf, in->conf, in->afi, in->safi);
-	return updgrp;
+	return string_hash_make(un->name);
 }
 
-/**
+static bool updgrp_name_hash_cmp(const void *arg1, const void *arg2)
+{
+	const struct updgrp_name *un1 = arg1;
+	const struct updgrp_name *un2 = arg2;
+
+	return strcmp(un1->name, un2->name) == 0;
+}
+
+static void *updgrp_name_hash_alloc(void *arg)
+{
+	const struct updgrp_name *in = arg;
+	struct updgrp_name *un;
+
+	un = XCALLOC(MTYPE_BGP_UPDGRP_NAME, sizeof(*un));
+	un->name = XSTRDUP(MTYPE_BGP_UPDGRP_NAME, in->name);
+	return un;
+}
+
+static const char *updgrp_name_get(const char *name)
+{
+	struct updgrp_name lookup, *un;
+
+	if (!name)
+		return NULL;
+
+	if (!updgrp_names)
+		updgrp_names = hash_create(updgrp_name_hash_key,
+					   updgrp_name_hash_cmp,
+					   "BGP update-group policy names");
+
+	lookup.name = (char *)name;
+	un = hash_get(updgrp_names, &lookup, updgrp_name_hash_alloc);
+	un->refcnt++;
+	return un->name;
+}
+
+static void updgrp_name_put(const char *name)
+{
+	struct updgrp_name lookup, *un;
+
+	if (!name)
+		return;
+
+	lookup.name = (char *)name;
+	un = hash_lookup(updgrp_names, &lookup);
+	assert(un && un->refcnt);
+	if (--un->refcnt)
+		return;
+
+	hash_release(updgrp_names, un);
+	XFREE(MTYPE_BGP_UPDGRP_NAME, un->name);
+	XFREE(MTYPE_BGP_UPDGRP_NAME, un);
+
+	if (!hashcount(updgrp_names)) {
+		hash_free(updgrp_names);
+		updgrp_names = NULL;
+	}
+}
+
+/* every interned name in a signature, for taking and dropping references */
+#define UPDGRP_SIG_NAMES(sig)                                                  \
+	{                                                                      \
+		&(sig)->rmap_out, &(sig)->dlist_out, &(sig)->plist_out,        \
+			&(sig)->aslist_out, &(sig)->usmap, &(sig)->advmap,     \
+			&(sig)->default_rmap, &(sig)->host,                    \
+	}
+
+/*
  * The hash value for a peer is computed from the following variables:
  * v = f(
  *       1. IBGP (1) or EBGP (2)
@@ -307,94 +377,47 @@ static void *updgrp_hash_alloc(void *p)
  *       15. If peer is configured to be a lonesoul, peer ip address
  *       16. Local-as should match, if configured.
  *      )
+ *
+ * These are gathered into the signature once, when the peer is (re)placed
+ * into an update group; the hash and compare functions only look at it.
+ * The signature holds references on its interned names, see
+ * updgrp_sig_release().
  */
-static unsigned int updgrp_hash_key_make(const void *p)
+static void updgrp_sig_make(struct updgrp_sig *sig, struct peer *peer,
+			    afi_t afi, safi_t safi)
 {
-	const struct update_group *updgrp;
-	const struct peer *peer;
-	const struct bgp_filter *filter;
-	uint32_t flags;
-	uint32_t key;
-	afi_t afi;
-	safi_t safi;
-
-#define SEED1 999331
-#define SEED2 2147483647
-
-	updgrp = p;
-	peer = updgrp->conf;
-	afi = updgrp->afi;
-	safi = updgrp->safi;
-	flags = peer->af_flags[afi][safi];
-	filter = &peer->filter[afi][safi];
-
-	key = 0;
-
-	key = jhash_1word(peer->sort, key); /* EBGP or IBGP */
-	key = jhash_1word((peer->flags & PEER_UPDGRP_FLAGS), key);
-	key = jhash_1word((flags & PEER_UPDGRP_AF_FLAGS), key);
-	key = jhash_1word((uint32_t)peer->addpath_type[afi][safi], key);
-	key = jhash_1word((peer->cap & PEER_UPDGRP_CAP_FLAGS), key);
-	key = jhash_1word((peer->af_cap[afi][safi] & PEER_UPDGRP_AF_CAP_FLAGS),
-			  key);
-	key = jhash_1word(peer->v_routeadv, key);
-	key = jhash_1word(peer->change_local_as, key);
-	key = jhash_1word(peer->max_packet_size, key);
-
-	if (peer->group)
-		key = jhash_1word(jhash(peer->group->name,
-					strlen(peer->group->name), SEED1),
-				  key);
-
-	if (filter->map[RMAP_OUT].name)
-		key = jhash_1word(jhash(filter->map[RMAP_OUT].name,
-					strlen(filter->map[RMAP_OUT].name),
-					SEED1),
-				  key);
-
-	if (filter->dlist[FILTER_OUT].name)
-		key = jhash_1word(jhash(filter->dlist[FILTER_OUT].name,
-					strlen(filter->dlist[FILTER_OUT].name),
-					SEED1),
-				  key);
-
-	if (filter->plist[FILTER_OUT].name)
-		key = jhash_1word(jhash(filter->plist[FILTER_OUT].name,
-					strlen(filter->plist[FILTER_OUT].name),
-					SEED1),
-				  key);
-
-	if (filter->aslist[FILTER_OUT].name)
-		key = jhash_1word(jhash(filter->aslist[FILTER_OUT].name,
-					strlen(filter->aslist[FILTER_OUT].name),
-					SEED1),
-				  key);
-
-	if (filter->usmap.name)
-		key = jhash_1word(jhash(filter->usmap.name,
-					strlen(filter->usmap.name), SEED1),
-				  key);
-
-	if (filter->advmap.aname)
-		key = jhash_1word(jhash(filter->advmap.aname,
-					strlen(filter->advmap.aname), SEED1),
-				  key);
-
-	if (peer->default_rmap[afi][safi].name)
-		key = jhash_1word(
-			jhash(peer->default_rmap[afi][safi].name,
-			      strlen(peer->default_rmap[afi][safi].name),
-			      SEED1),
-			key);
+	const struct bgp_filter *filter = &peer->filter[afi][safi];
+
+	/* all of it is hashed and compared, padding included */
+	memset(sig, 0, sizeof(*sig));
+
+	sig->sort = peer->sort; /* EBGP or IBGP */
+	sig->flags = peer->flags & PEER_UPDGRP_FLAGS;
+	sig->af_flags = peer->af_flags[afi][safi] & PEER_UPDGRP_AF_FLAGS;
+	sig->addpath_type = peer->addpath_type[afi][safi];
+	sig->addpath_best_selected = peer->addpath_best_selected[afi][safi];
+	sig->cap = peer->cap & PEER_UPDGRP_CAP_FLAGS;
+	sig->af_cap = peer->af_cap[afi][safi] & PEER_UPDGRP_AF_CAP_FLAGS;
+	sig->v_routeadv = peer->v_routeadv;
+	sig->change_local_as = peer->change_local_as;
+	sig->max_packet_size = peer->max_packet_size;
 
 	/* If peer is on a shared network and is exchanging IPv6 prefixes,
 	 * it needs to include link-local address. That's different from
 	 * non-shared-network peers (nexthop encoded with 32 bytes vs 16
 	 * bytes). We create different update groups to take care of that.
 	 */
-	key = jhash_1word(
-		(peer->shared_network && peer_afi_active_nego(peer, AFI_IP6)),
-		key);
+	sig->shared_network = afi == AFI_IP6 && peer->shared_network;
+
+	sig->group = peer->group;
+	sig->rmap_out = updgrp_name_get(filter->map[RMAP_OUT].name);
+	sig->dlist_out = updgrp_name_get(filter->dlist[FILTER_OUT].name);
+	sig->plist_out = updgrp_name_get(filter->plist[FILTER_OUT].name);
+	sig->aslist_out = updgrp_name_get(filter->aslist[FILTER_OUT].name);
+	sig->usmap = updgrp_name_get(filter->usmap.name);
+	sig->advmap = updgrp_name_get(filter->advmap.aname);
+	sig->default_rmap =
+		updgrp_name_get(peer->default_rmap[afi][safi].name);
 
 	/*
 	 * There are certain peers that must get their own update-group:
@@ -407,134 +430,70 @@ static unsigned int updgrp_hash_key_make(const void *p)
 	    || CHECK_FLAG(peer->af_cap[afi][safi],
 			  PEER_CAP_ORF_PREFIX_SM_OLD_RCV)
 	    || CHECK_FLAG(peer->af_flags[afi][safi], PEER_FLAG_MAX_PREFIX_OUT))
-		key = jhash_1word(jhash(peer->host, strlen(peer->host), SEED2),
-				  key);
+		sig->host = updgrp_name_get(peer->host);
 
-	return key;
+	sig->key = jhash((uint8_t *)sig + sizeof(sig->key),
+			 sizeof(*sig) - sizeof(sig->key), 0);
 }
 
-static bool updgrp_hash_cmp(const void *p1, const void *p2)
+/* take references on the names of a copied signature */
+static void updgrp_sig_ref(struct updgrp_sig *sig)
 {
-	const struct update_group *grp1;
-	const struct update_group *grp2;
-	const struct peer *pe1;
-	const struct peer *pe2;
-	uint32_t flags1;
-	uint32_t flags2;
-	const struct bgp_filter *fl1;
-	const struct bgp_filter *fl2;
-	afi_t afi;
-	safi_t safi;
-
-	if (!p1 || !p2)
-		return false;
+	const char **names[] = UPDGRP_SIG_NAMES(sig);
+	size_t i;
 
-	grp1 = p1;
-	grp2 = p2;
-	pe1 = grp1->conf;
-	pe2 = grp2->conf;
-	afi = grp1->afi;
-	safi = grp1->safi;
-	flags1 = pe1->af_flags[afi][safi];
-	flags2 = pe2->af_flags[afi][safi];
-	fl1 = &pe1->filter[afi][safi];
-	fl2 = &pe2->filter[afi][safi];
-
-	/* put EBGP and IBGP peers in different update groups */
-	if (pe1->sort != pe2->sort)
-		return false;
-
-	/* check peer flags */
-	if ((pe1->flags & PEER_UPDGRP_FLAGS)
-	    != (pe2->flags & PEER_UPDGRP_FLAGS))
-		return false;
-
-	/* If there is 'local-as' configured, it should match. */
-	if (pe1->change_local_as != pe2->change_local_as)
-		return false;
-
-	/* flags like route reflector client */
-	if ((flags1 & PEER_UPDGRP_AF_FLAGS) != (flags2 & PEER_UPDGRP_AF_FLAGS))
-		return false;
-
-	if (pe1->addpath_type[afi][safi] != pe2->addpath_type[afi][safi])
-		return false;
-
-	if ((pe1->cap & PEER_UPDGRP_CAP_FLAGS)
-	    != (pe2->cap & PEER_UPDGRP_CAP_FLAGS))
-		return false;
-
-	if ((pe1->af_cap[afi][safi] & PEER_UPDGRP_AF_CAP_FLAGS)
-	    != (pe2->af_cap[afi][safi] & PEER_UPDGRP_AF_CAP_FLAGS))
-		return false;
-
-	if (pe1->v_routeadv != pe2->v_routeadv)
-		return false;
-
-	if (pe1->group != pe2->group)
-		return false;
-
-	/* route-map names should be the same */
-	if ((fl1->map[RMAP_OUT].name && !fl2->map[RMAP_OUT].name)
-	    || (!fl1->map[RMAP_OUT].name && fl2->map[RMAP_OUT].name)
-	    || (fl1->map[RMAP_OUT].name && fl2->map[RMAP_OUT].name
-		&& strcmp(fl1->map[RMAP_OUT].name, fl2->map[RMAP_OUT].name)))
-		return false;
+	for (i = 0; i < array_size(names); i++)
+		if (*names[i])
+			updgrp_name_get(*names[i]);
+}
 
-	if ((fl1->dlist[FILTER_OUT].name && !fl2->dlist[FILTER_OUT].name)
-	    || (!fl1->dlist[FILTER_OUT].name && fl2->dlist[FILTER_OUT].name)
-	    || (fl1->dlist[FILTER_OUT].name && fl2->dlist[FILTER_OUT].name
-		&& strcmp(fl1->dlist[FILTER_OUT].name,
-			  fl2->dlist[FILTER_OUT].name)))
-		return false;
+static void updgrp_sig_release(struct updgrp_sig *sig)
+{
+	const char **names[] = UPDGRP_SIG_NAMES(sig);
+	size_t i;
 
-	if ((fl1->plist[FILTER_OUT].name && !fl2->plist[FILTER_OUT].name)
-	    || (!fl1->plist[FILTER_OUT].name && fl2->plist[FILTER_OUT].name)
-	    || (fl1->plist[FILTER_OUT].name && fl2->plist[FILTER_OUT].name
-		&& strcmp(fl1->plist[FILTER_OUT].name,
-			  fl2->plist[FILTER_OUT].name)))
-		return false;
+	for (i = 0; i < array_size(names); i++) {
+		updgrp_name_put(*names[i]);
+		*names[i] = NULL;
+	}
+}
 
-	if ((fl1->aslist[FILTER_OUT].name && !fl2->aslist[FILTER_OUT].name)
-	    || (!fl1->aslist[FILTER_OUT].name && fl2->aslist[FILTER_OUT].name)
-	    || (fl1->aslist[FILTER_OUT].name && fl2->aslist[FILTER_OUT].name
-		&& strcmp(fl1->aslist[FILTER_OUT].name,
-			  fl2->aslist[FILTER_OUT].name)))
-		return false;
+/**
+ * auxiliary functions to maintain the hash table.
+ * - updgrp_hash_alloc - to create a new entry, passed to hash_get
+ * - updgrp_hash_key_make - makes the key for update group search
+ * - updgrp_hash_cmp - compare two update groups.
+ */
+static void *updgrp_hash_alloc(void *p)
+{
+	struct update_group *updgrp;
+	const struct update_group *in;
 
-	if ((fl1->usmap.name && !fl2->usmap.name)
-	    || (!fl1->usmap.name && fl2->usmap.name)
-	    || (fl1->usmap.name && fl2->usmap.name
-		&& strcmp(fl1->usmap.name, fl2->usmap.name)))
-		return false;
+	in = (const struct update_group *)p;
+	updgrp = XCALLOC(MTYPE_BGP_UPDGRP, sizeof(struct update_group));
+	memcpy(updgrp, in, sizeof(struct update_group));
+	updgrp->conf = XCALLOC(MTYPE_BGP_PEER, sizeof(struct peer));
+	conf_copy(updgrp->conf, in->conf, in->afi, in->safi);
+	updgrp_sig_ref(&updgrp->sig);
+	return updgrp;
+}
 
-	if ((fl1->advmap.aname && !fl2->advmap.aname)
-	    || (!fl1->advmap.aname && fl2->advmap.aname)
-	    || (fl1->advmap.aname && fl2->advmap.aname
-		&& strcmp(fl1->advmap.aname, fl2->advmap.aname)))
-		return false;
+static unsigned int updgrp_hash_key_make(const void *p)
+{
+	const struct update_group *updgrp = p;
 
-	if ((pe1->default_rmap[afi][safi].name
-	     && !pe2->default_rmap[afi][safi].name)
-	    || (!pe1->default_rmap[afi][safi].name
-		&& pe2->default_rmap[afi][safi].name)
-	    || (pe1->default_rmap[afi][safi].name
-		&& pe2->default_rmap[afi][safi].name
-		&& strcmp(pe1->default_rmap[afi][safi].name,
-			  pe2->default_rmap[afi][safi].name)))
-		return false;
+	return updgrp->sig.key;
+}
 
-	if ((afi == AFI_IP6) && (pe1->shared_network != pe2->shared_network))
-		return false;
+static bool updgrp_hash_cmp(const void *p1, const void *p2)
+{
+	const struct update_group *grp1 = p1;
+	const struct update_group *grp2 = p2;
 
-	if ((CHECK_FLAG(pe1->flags, PEER_FLAG_LONESOUL)
-	     || CHECK_FLAG(pe1->af_cap[afi][safi], PEER_CAP_ORF_PREFIX_SM_RCV)
-	     || CHECK_FLAG(pe1->af_cap[afi][safi],
-			   PEER_CAP_ORF_PREFIX_SM_OLD_RCV))
-	    && !sockunion_same(&pe1->su, &pe2->su))
+	if (!p1 || !p2)
 		return false;
 
-	return true;
+	return memcmp(&grp1->sig, &grp2->sig, sizeof(grp1->sig)) == 0;
 }
 
 static void peer_lonesoul_or_not(struct peer *peer, int set)
@@ -647,6 +606,17 @@ static int update_group_show_walkcb(struct update_group *updgrp, void *arg)
 			subgrp->peer_refreshes_combined);
 		vty_out(vty, "    Merge checks triggered: %u\n",
 			subgrp->merge_checks_triggered);
+		vty_out(vty, "    Announcements inherited: %u\n",
+			subgrp->announce_inherits);
+		if (subgrp->rmap_memo_hits || subgrp->rmap_memo_misses)
+			vty_out(vty,
+				"    Route-map memo: hits %" PRIu64
+				" misses %" PRIu64 " (%" PRIu64 "%%)\n",
+				subgrp->rmap_memo_hits,
+				subgrp->rmap_memo_misses,
+				subgrp->rmap_memo_hits * 100
+					/ (subgrp->rmap_memo_hits
+					   + subgrp->rmap_memo_misses));
 		vty_out(vty, "    Coalesce Time: %u%s\n",
 			(UPDGRP_INST(subgrp->update_group))->coalesce_time,
 			subgrp->t_coalesce ? "(Running)" : "");
@@ -720,18 +690,15 @@ static struct update_group *update_group_find(struct peer_af *paf)
 {
 	struct update_group *updgrp;
 	struct update_group tmp;
-	struct peer tmp_conf;
 
 	if (!peer_established(PAF_PEER(paf)))
 		return NULL;
 
-	memset(&tmp, 0, sizeof(tmp));
-	memset(&tmp_conf, 0, sizeof(tmp_conf));
-	tmp.conf = &tmp_conf;
-	peer2_updgrp_copy(&tmp, paf);
+	/* only the signature is looked at */
+	updgrp_sig_make(&tmp.sig, paf->peer, paf->afi, paf->safi);
 
 	updgrp = hash_lookup(paf->peer->bgp->update_groups[paf->afid], &tmp);
-	conf_release(&tmp_conf, paf->afi, paf->safi);
+	updgrp_sig_release(&tmp.sig);
 	return updgrp;
 }
 
@@ -745,11 +712,15 @@ static struct update_group *update_group_create(struct peer_af *paf)
 	memset(&tmp_conf, 0, sizeof(tmp_conf));
 	tmp.conf = &tmp_conf;
 	peer2_updgrp_copy(&tmp, paf);
+	updgrp_sig_make(&tmp.sig, paf->peer, paf->afi, paf->safi);
 
 	updgrp = hash_get(paf->peer->bgp->update_groups[paf->afid], &tmp,
 			  updgrp_hash_alloc);
-	if (!updgrp)
+	updgrp_sig_release(&tmp.sig);
+	if (!updgrp) {
+		conf_release(&tmp_conf, paf->afi, paf->safi);
 		return NULL;
+	}
 	update_group_checkin(updgrp);
 
 	if (BGP_DEBUG(update_groups, UPDATE_GROUPS))
@@ -769,6 +740,7 @@ static void update_group_delete(struct update_group *updgrp)
 	UPDGRP_GLOBAL_STAT(updgrp, updgrps_deleted) += 1;
 
 	hash_release(updgrp->bgp->update_groups[updgrp->afid], updgrp);
+	updgrp_sig_release(&updgrp->sig);
 	conf_release(updgrp->conf, updgrp->afi, updgrp->safi);
 
 	XFREE(MTYPE_BGP_PEER_HOST, updgrp->conf->host);
@@ -839,6 +811,7 @@ static void update_subgroup_delete(struct update_subgroup *subgrp)
 	subgroup_clear_table(subgrp);
 
 	sync_delete(subgrp);
+	bgp_rmap_memo_clean(&subgrp->rmap_memo);
 
 	if (BGP_DEBUG(update_groups, UPDATE_GROUPS) && subgrp->update_group)
 		zlog_debug("delete subgroup u%" PRIu64 ":s%" PRIu64,
@@ -1404,7 +1377,11 @@ static int updgrp_policy_update_walkcb(struct update_group *updgrp, void *arg)
 					"u%" PRIu64 ":s%" PRIu64" announcing routes upon policy %s (type %d) change",
 					updgrp->id, subgrp->id,
 					ctx->policy_name, ctx->policy_type);
-			subgroup_announce_route(subgrp);
+			if (ctx->policy_type == BGP_POLICY_ROUTE_MAP)
+				subgroup_announce_route_changed(
+					subgrp, ctx->policy_name);
+			else
+				subgroup_announce_route(subgrp);
 		}
 		if (def_changed) {
 			if (bgp_debug_update(NULL, NULL, updgrp, 0))
@@ -1630,6 +1607,8 @@ void update_group_show_stats(struct bgp *bgp, struct vty *vty)
 		bgp->update_group_stats.peer_refreshes_combined);
 	vty_out(vty, "Merge checks triggered: %u\n",
 		bgp->update_group_stats.merge_checks_triggered);
+	vty_out(vty, "Announcements inherited: %u\n",
+		bgp->update_group_stats.announce_inherits);
 }
 
 /*
@@ -1900,6 +1879,9 @@ void subgroup_trigger_write(struct update_subgroup *subgrp)
 {
 	struct peer_af *paf;
 
+	/* Get the packets built on the worker pthreads, if there are any. */
+	subgroup_update_packets_schedule(SUBGRP_INST(subgrp));
+
 	/*
 	 * For each peer in the subgroup, schedule a job to pull packets from
 	 * the subgroup output queue into their own output queue. This action
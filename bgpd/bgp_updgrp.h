@@ -115,6 +115,37 @@ struct bpacket_queue {
 	unsigned int max_count_reached_count;
 };
 
+/*
+ * What puts peers into the same update group, see updgrp_sig_make().  Names
+ * are interned, so equal signatures are equal in memory.
+ */
+struct updgrp_sig {
+	uint32_t key;
+
+	uint32_t sort;
+	uint32_t flags;
+	uint32_t af_flags;
+	uint32_t addpath_type;
+	uint32_t addpath_best_selected;
+	uint32_t cap;
+	uint32_t af_cap;
+	uint32_t v_routeadv;
+	uint32_t change_local_as;
+	uint32_t max_packet_size;
+	uint32_t shared_network;
+
+	const struct peer_group *group;
+	const char *rmap_out;
+	const char *dlist_out;
+	const char *plist_out;
+	const char *aslist_out;
+	const char *usmap;
+	const char *advmap;
+	const char *default_rmap;
+	/* peers that get a group of their own */
+	const char *host;
+};
+
 struct update_group {
 	/* back pointer to the BGP instance */
 	struct bgp *bgp;
@@ -122,9 +153,10 @@ struct update_group {
 	/* list of subgroups that belong to the update group */
 	LIST_HEAD(subgrp_list, update_subgroup) subgrps;
 
-	/* lazy way to store configuration common to all peers
-	   hash function will compute from this data */
+	/* lazy way to store configuration common to all peers */
 	struct peer *conf;
+	/* what the update group hash is computed from */
+	struct updgrp_sig sig;
 
 	afi_t afi;
 	safi_t safi;
@@ -141,6 +173,7 @@ struct update_group {
 	uint32_t adj_count;
 	uint32_t split_events;
 	uint32_t merge_checks_triggered;
+	uint32_t announce_inherits;
 
 	uint32_t subgrps_created;
 	uint32_t subgrps_deleted;
@@ -189,6 +222,14 @@ struct update_subgroup {
 	 */
 	TAILQ_HEAD(adjout_queue, bgp_adj_out) adjq;
 
+	/*
+	 * The same adj-outs indexed by dest->adj_out_id, in pages of
+	 * SUBGRP_ADJ_PAGE_SIZE slots allocated as needed. Each slot holds the
+	 * adj-outs of one dest, chained through adj->next for addpath.
+	 */
+	struct bgp_adj_out_page **adj_pages;
+	uint32_t adj_npages;
+
 	/* packet buffer for update generation */
 	struct stream *work;
 
@@ -201,12 +242,22 @@ struct update_subgroup {
 	/* synchronization list and time */
 	struct bgp_synchronize *sync;
 
+	/* update FIFO head passed over, see subgroup_update_first_adv() */
+	struct bgp_advertise *pack_head;
+	unsigned int pack_skips;
+
 	/* send prefix count */
 	uint32_t scount;
 
 	/* announcement attribute hash */
 	struct hash *hash;
 
+	/* Memoized outbound route-map results, see bgp_rmap_memo_apply() */
+	struct hash *rmap_memo;
+	uint64_t rmap_memo_gen;
+	uint64_t rmap_memo_hits;
+	uint64_t rmap_memo_misses;
+
 	struct thread *t_coalesce;
 	uint32_t v_coalesce;
 
@@ -243,6 +294,11 @@ struct update_subgroup {
 	uint32_t split_events;
 	uint32_t merge_checks_triggered;
 
+	/* started off from another subgroup's adj-out, see
+	 * subgroup_announce_inherit()
+	 */
+	uint32_t announce_inherits;
+
 	uint64_t id;
 
 	uint16_t sflags;
@@ -346,6 +402,16 @@ struct updwalk_context {
 #define SUBGRP_FOREACH_ADJ_SAFE(subgrp, adj, adj_temp)                         \
 	TAILQ_FOREACH_SAFE (adj, &(subgrp->adjq), subgrp_adj_train, adj_temp)
 
+/* The adj-outs of a subgroup for one dest, one per addpath id */
+#define SUBGRP_FOREACH_DEST_ADJ(subgrp, dest, adj)                             \
+	for ((adj) = subgroup_adj_first(subgrp, dest); (adj);                  \
+	     (adj) = subgroup_adj_next(adj))
+
+#define SUBGRP_FOREACH_DEST_ADJ_SAFE(subgrp, dest, adj, adj_temp)              \
+	for ((adj) = subgroup_adj_first(subgrp, dest);                         \
+	     (adj) && ((adj_temp) = subgroup_adj_next(adj), 1);                \
+	     (adj) = (adj_temp))
+
 /* Prototypes.  */
 /* bgp_updgrp.c */
 extern void update_bgp_group_init(struct bgp *);
@@ -401,6 +467,7 @@ extern void bpacket_queue_show_vty(struct bpacket_queue *q, struct vty *vty);
 bool subgroup_packets_to_build(struct update_subgroup *subgrp);
 extern struct bpacket *subgroup_update_packet(struct update_subgroup *s);
 extern struct bpacket *subgroup_withdraw_packet(struct update_subgroup *s);
+extern void subgroup_update_packets_schedule(struct bgp *bgp);
 extern struct stream *bpacket_reformat_for_peer(struct bpacket *pkt,
 						struct peer_af *paf);
 extern void bpacket_attr_vec_arr_reset(struct bpacket_attr_vec_arr *vecarr);
@@ -425,6 +492,8 @@ extern void update_group_show_packet_queue(struct bgp *bgp, afi_t afi,
 					   safi_t safi, struct vty *vty,
 					   uint64_t id);
 extern void subgroup_announce_route(struct update_subgroup *subgrp);
+extern void subgroup_announce_route_changed(struct update_subgroup *subgrp,
+					    const char *rmap_name);
 extern void subgroup_announce_all(struct update_subgroup *subgrp);
 
 extern void subgroup_default_originate(struct update_subgroup *subgrp,
@@ -436,6 +505,9 @@ extern void subgroup_clear_table(struct update_subgroup *subgrp);
 extern void update_group_announce(struct bgp *bgp);
 extern void update_group_announce_rrclients(struct bgp *bgp);
 extern void peer_af_announce_route(struct peer_af *paf, int combine);
+extern struct bgp_adj_out *subgroup_adj_first(struct update_subgroup *subgrp,
+					      struct bgp_dest *dest);
+extern struct bgp_adj_out *subgroup_adj_next(struct bgp_adj_out *adj);
 extern struct bgp_adj_out *bgp_adj_out_alloc(struct update_subgroup *subgrp,
 					     struct bgp_dest *dest,
 					     uint32_t addpath_tx_id);
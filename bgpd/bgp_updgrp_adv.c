@@ -55,40 +55,97 @@
 /********************
  * PRIVATE FUNCTIONS
  ********************/
-static int bgp_adj_out_compare(const struct bgp_adj_out *o1,
-			       const struct bgp_adj_out *o2)
+#define SUBGRP_ADJ_PAGE_BITS 8
+#define SUBGRP_ADJ_PAGE_SIZE (1 << SUBGRP_ADJ_PAGE_BITS)
+
+struct bgp_adj_out_page {
+	unsigned int count;
+	struct bgp_adj_out *slots[SUBGRP_ADJ_PAGE_SIZE];
+};
+
+/*
+ * Returns the index slot of the subgroup for the given dest id, or NULL if
+ * its page does not exist and create is false.
+ */
+static struct bgp_adj_out **adj_index_slot(struct update_subgroup *subgrp,
+					   uint32_t id, bool create)
 {
-	if (o1->subgroup < o2->subgroup)
-		return -1;
+	uint32_t pageno = id >> SUBGRP_ADJ_PAGE_BITS;
+	struct bgp_adj_out_page *page;
+
+	if (pageno >= subgrp->adj_npages) {
+		uint32_t npages = MAX(subgrp->adj_npages, 16);
+
+		if (!create)
+			return NULL;
+
+		while (npages <= pageno)
+			npages *= 2;
+		subgrp->adj_pages =
+			XREALLOC(MTYPE_BGP_ADJ_OUT_INDEX, subgrp->adj_pages,
+				 npages * sizeof(subgrp->adj_pages[0]));
+		memset(subgrp->adj_pages + subgrp->adj_npages, 0,
+		       (npages - subgrp->adj_npages)
+			       * sizeof(subgrp->adj_pages[0]));
+		subgrp->adj_npages = npages;
+	}
+
+	page = subgrp->adj_pages[pageno];
+	if (!page) {
+		if (!create)
+			return NULL;
+
+		page = XCALLOC(MTYPE_BGP_ADJ_OUT_INDEX, sizeof(*page));
+		subgrp->adj_pages[pageno] = page;
+	}
 
-	if (o1->subgroup > o2->subgroup)
-		return 1;
+	return &page->slots[id & (SUBGRP_ADJ_PAGE_SIZE - 1)];
+}
 
-	if (o1->addpath_tx_id < o2->addpath_tx_id)
-		return -1;
+static void adj_index_add(struct update_subgroup *subgrp,
+			  struct bgp_adj_out *adj)
+{
+	uint32_t id = bgp_dest_adj_out_id(adj->dest);
+	struct bgp_adj_out **slot = adj_index_slot(subgrp, id, true);
 
-	if (o1->addpath_tx_id > o2->addpath_tx_id)
-		return 1;
+	adj->next = *slot;
+	*slot = adj;
+	subgrp->adj_pages[id >> SUBGRP_ADJ_PAGE_BITS]->count++;
+}
 
-	return 0;
+static void adj_index_del(struct update_subgroup *subgrp,
+			  struct bgp_adj_out *adj)
+{
+	uint32_t id = adj->dest->adj_out_id;
+	uint32_t pageno = id >> SUBGRP_ADJ_PAGE_BITS;
+	struct bgp_adj_out **slot = adj_index_slot(subgrp, id, false);
+
+	assert(slot);
+	while (*slot != adj)
+		slot = &(*slot)->next;
+	*slot = adj->next;
+	adj->next = NULL;
+
+	if (--subgrp->adj_pages[pageno]->count == 0)
+		XFREE(MTYPE_BGP_ADJ_OUT_INDEX, subgrp->adj_pages[pageno]);
 }
-RB_GENERATE(bgp_adj_out_rb, bgp_adj_out, adj_entry, bgp_adj_out_compare);
 
 static inline struct bgp_adj_out *adj_lookup(struct bgp_dest *dest,
 					     struct update_subgroup *subgrp,
 					     uint32_t addpath_tx_id)
 {
-	struct bgp_adj_out lookup;
+	struct bgp_adj_out *adj;
 
 	if (!dest || !subgrp)
 		return NULL;
 
 	/* update-groups that do not support addpath will pass 0 for
 	 * addpath_tx_id. */
-	lookup.subgroup = subgrp;
-	lookup.addpath_tx_id = addpath_tx_id;
+	SUBGRP_FOREACH_DEST_ADJ (subgrp, dest, adj)
+		if (adj->addpath_tx_id == addpath_tx_id)
+			return adj;
 
-	return RB_FIND(bgp_adj_out_rb, &dest->adj_out, &lookup);
+	return NULL;
 }
 
 static void adj_free(struct bgp_adj_out *adj)
@@ -96,7 +153,7 @@ static void adj_free(struct bgp_adj_out *adj)
 	TAILQ_REMOVE(&(adj->subgroup->adjq), adj, subgrp_adj_train);
 	SUBGRP_DECR_STAT(adj->subgroup, adj_count);
 
-	RB_REMOVE(bgp_adj_out_rb, &adj->dest->adj_out, adj);
+	adj_index_del(adj->subgroup, adj);
 	bgp_dest_unlock_node(adj->dest);
 
 	XFREE(MTYPE_BGP_ADJ_OUT, adj);
@@ -114,24 +171,20 @@ static void subgrp_withdraw_stale_addpath(struct updwalk_context *ctx,
 
 	/* Look through all of the paths we have advertised for this rn and send
 	 * a withdraw for the ones that are no longer present */
-	RB_FOREACH_SAFE (adj, bgp_adj_out_rb, &ctx->dest->adj_out, adj_next) {
+	SUBGRP_FOREACH_DEST_ADJ_SAFE (subgrp, ctx->dest, adj, adj_next) {
+		for (pi = bgp_dest_get_bgp_path_info(ctx->dest); pi;
+		     pi = pi->next) {
+			id = bgp_addpath_id_for_peer(peer, afi, safi,
+				&pi->tx_addpath);
 
-		if (adj->subgroup == subgrp) {
-			for (pi = bgp_dest_get_bgp_path_info(ctx->dest); pi;
-			     pi = pi->next) {
-				id = bgp_addpath_id_for_peer(peer, afi, safi,
-					&pi->tx_addpath);
-
-				if (id == adj->addpath_tx_id) {
-					break;
-				}
+			if (id == adj->addpath_tx_id) {
+				break;
 			}
+		}
 
-			if (!pi) {
-				subgroup_process_announce_selected(
-					subgrp, NULL, ctx->dest,
-					adj->addpath_tx_id);
-			}
+		if (!pi) {
+			subgroup_process_announce_selected(
+				subgrp, NULL, ctx->dest, adj->addpath_tx_id);
 		}
 	}
 }
@@ -206,22 +259,18 @@ static int group_announce_route_walkcb(struct update_group *updgrp, void *arg)
 					/* Find the addpath_tx_id of the path we
 					 * had advertised and
 					 * send a withdraw */
-					RB_FOREACH_SAFE (adj, bgp_adj_out_rb,
-							 &ctx->dest->adj_out,
-							 adj_next) {
-						if (adj->subgroup == subgrp) {
-							subgroup_process_announce_selected(
-								subgrp, NULL,
-								ctx->dest,
-								adj->addpath_tx_id);
-						}
-					}
+					SUBGRP_FOREACH_DEST_ADJ_SAFE (
+						subgrp, ctx->dest, adj,
+						adj_next)
+						subgroup_process_announce_selected(
+							subgrp, NULL, ctx->dest,
+							adj->addpath_tx_id);
 				}
 			}
 		}
 
 		/* Notify BGP Conditional advertisement */
-		bgp_notify_conditional_adv_scanner(subgrp);
+		bgp_notify_conditional_adv_scanner(subgrp, ctx->dest);
 	}
 
 	return UPDWALK_CONTINUE;
@@ -249,39 +298,38 @@ static void subgrp_show_adjq_vty(struct update_subgroup *subgrp,
 	for (dest = bgp_table_top(table); dest; dest = bgp_route_next(dest)) {
 		const struct prefix *dest_p = bgp_dest_get_prefix(dest);
 
-		RB_FOREACH (adj, bgp_adj_out_rb, &dest->adj_out)
-			if (adj->subgroup == subgrp) {
-				if (header1) {
-					vty_out(vty,
-						"BGP table version is %" PRIu64
-						", local router ID is %pI4\n",
-						table->version,
-						&bgp->router_id);
-					vty_out(vty, BGP_SHOW_SCODE_HEADER);
-					vty_out(vty, BGP_SHOW_OCODE_HEADER);
-					header1 = 0;
-				}
-				if (header2) {
-					vty_out(vty, BGP_SHOW_HEADER);
-					header2 = 0;
-				}
-				if ((flags & UPDWALK_FLAGS_ADVQUEUE) && adj->adv
-				    && adj->adv->baa) {
-					route_vty_out_tmp(vty, dest, dest_p,
-							  adj->adv->baa->attr,
-							  SUBGRP_SAFI(subgrp),
-							  0, NULL, false);
-					output_count++;
-				}
-				if ((flags & UPDWALK_FLAGS_ADVERTISED)
-				    && adj->attr) {
-					route_vty_out_tmp(vty, dest, dest_p,
-							  adj->attr,
-							  SUBGRP_SAFI(subgrp),
-							  0, NULL, false);
-					output_count++;
-				}
+		SUBGRP_FOREACH_DEST_ADJ (subgrp, dest, adj) {
+			if (header1) {
+				vty_out(vty,
+					"BGP table version is %" PRIu64
+					", local router ID is %pI4\n",
+					table->version,
+					&bgp->router_id);
+				vty_out(vty, BGP_SHOW_SCODE_HEADER);
+				vty_out(vty, BGP_SHOW_OCODE_HEADER);
+				header1 = 0;
+			}
+			if (header2) {
+				vty_out(vty, BGP_SHOW_HEADER);
+				header2 = 0;
+			}
+			if ((flags & UPDWALK_FLAGS_ADVQUEUE) && adj->adv
+			    && adj->adv->baa) {
+				route_vty_out_tmp(vty, dest, dest_p,
+						  adj->adv->baa->attr,
+						  SUBGRP_SAFI(subgrp),
+						  0, NULL, false);
+				output_count++;
+			}
+			if ((flags & UPDWALK_FLAGS_ADVERTISED)
+			    && adj->attr) {
+				route_vty_out_tmp(vty, dest, dest_p,
+						  adj->attr,
+						  SUBGRP_SAFI(subgrp),
+						  0, NULL, false);
+				output_count++;
 			}
+		}
 	}
 	if (output_count != 0)
 		vty_out(vty, "\nTotal number of prefixes %ld\n", output_count);
@@ -392,6 +440,27 @@ static int update_group_announce_rrc_walkcb(struct update_group *updgrp,
  * PUBLIC FUNCTIONS
  ********************/
 
+/**
+ * Return the first adj-out of the subgroup for the dest, if any. The
+ * others, with different addpath ids, follow through subgroup_adj_next().
+ */
+struct bgp_adj_out *subgroup_adj_first(struct update_subgroup *subgrp,
+				       struct bgp_dest *dest)
+{
+	struct bgp_adj_out **slot;
+
+	if (!dest->adj_out_id)
+		return NULL;
+
+	slot = adj_index_slot(subgrp, dest->adj_out_id, false);
+	return slot ? *slot : NULL;
+}
+
+struct bgp_adj_out *subgroup_adj_next(struct bgp_adj_out *adj)
+{
+	return adj->next;
+}
+
 /**
  * Allocate an adj-out object. Do proper initialization of its fields,
  * primarily its association with the subgroup and the prefix.
@@ -406,9 +475,9 @@ struct bgp_adj_out *bgp_adj_out_alloc(struct update_subgroup *subgrp,
 	adj->subgroup = subgrp;
 	adj->addpath_tx_id = addpath_tx_id;
 
-	RB_INSERT(bgp_adj_out_rb, &dest->adj_out, adj);
 	bgp_dest_lock_node(dest);
 	adj->dest = dest;
+	adj_index_add(subgrp, adj);
 
 	TAILQ_INSERT_TAIL(&(subgrp->adjq), adj, subgrp_adj_train);
 	SUBGRP_INCR_STAT(subgrp, adj_count);
@@ -634,13 +703,24 @@ void subgroup_clear_table(struct update_subgroup *subgrp)
 
 	SUBGRP_FOREACH_ADJ_SAFE (subgrp, aout, taout)
 		bgp_adj_out_remove_subgroup(aout->dest, aout, subgrp);
+
+	/* the pages went away with their last adj-out */
+	XFREE(MTYPE_BGP_ADJ_OUT_INDEX, subgrp->adj_pages);
+	subgrp->adj_npages = 0;
 }
 
 /*
  * subgroup_announce_table
  */
-void subgroup_announce_table(struct update_subgroup *subgrp,
-			     struct bgp_table *table)
+/*
+ * subgroup_announce_table_rmap
+ *
+ * Refresh the routes of table out to a subgroup; with rmap set, only those
+ * that the changes to it may affect, see route_map_changed_prefix().
+ */
+static void subgroup_announce_table_rmap(struct update_subgroup *subgrp,
+					 struct bgp_table *table,
+					 struct route_map *rmap)
 {
 	struct bgp_dest *dest;
 	struct bgp_path_info *ri;
@@ -672,6 +752,9 @@ void subgroup_announce_table(struct update_subgroup *subgrp,
 	for (dest = bgp_table_top(table); dest; dest = bgp_route_next(dest)) {
 		const struct prefix *dest_p = bgp_dest_get_prefix(dest);
 
+		if (rmap && !route_map_changed_prefix(rmap, dest_p))
+			continue;
+
 		/* Check if the route can be advertised */
 		advertise = bgp_check_advertise(bgp, dest);
 
@@ -679,9 +762,8 @@ void subgroup_announce_table(struct update_subgroup *subgrp,
 
 			if (CHECK_FLAG(ri->flags, BGP_PATH_SELECTED)
 			    || (addpath_capable
-				&& bgp_addpath_tx_path(
-					   peer->addpath_type[afi][safi],
-					   ri))) {
+				&& bgp_addpath_capable(ri, peer, afi,
+						       safi))) {
 				if (subgroup_announce_check(dest, ri, subgrp,
 							    dest_p, &attr,
 							    false)) {
@@ -729,12 +811,100 @@ void subgroup_announce_table(struct update_subgroup *subgrp,
 	update_subgroup_trigger_merge_check(subgrp, 0);
 }
 
+void subgroup_announce_table(struct update_subgroup *subgrp,
+			     struct bgp_table *table)
+{
+	subgroup_announce_table_rmap(subgrp, table, NULL);
+}
+
 /*
- * subgroup_announce_route
+ * Start off a subgroup that hasn't announced anything yet from the adj-out of
+ * another subgroup of the same update group, instead of running the outbound
+ * policy over the whole table.  The peers of an update group share that
+ * policy, so the result would be the same.  This is what makes peers that
+ * come up after their update group has settled cheap to bring up.
  *
- * Refresh all routes out to a subgroup.
+ * The source must have caught up with the table (nothing left on its
+ * advertise list) and have more than one peer, so that none of the checks
+ * subgroup_announce_check() only does for a single peer were applied to it.
+ *
+ * Returns false if no subgroup qualifies, in which case the table must be
+ * walked.
  */
-void subgroup_announce_route(struct update_subgroup *subgrp)
+static bool subgroup_announce_inherit(struct update_subgroup *subgrp)
+{
+	struct update_subgroup *source = NULL, *sibling;
+	struct bgp_adj_out *aout;
+	struct bgp_path_info *ri;
+	struct peer *peer;
+	afi_t afi;
+	safi_t safi;
+	int addpath_capable;
+
+	peer = SUBGRP_PEER(subgrp);
+	afi = SUBGRP_AFI(subgrp);
+	safi = SUBGRP_SAFI(subgrp);
+	addpath_capable = bgp_addpath_encode_tx(peer, afi, safi);
+
+	if (subgrp->version || subgrp->adj_count)
+		return false;
+	if (CHECK_FLAG(peer->af_flags[afi][safi], PEER_FLAG_DEFAULT_ORIGINATE))
+		return false;
+
+	UPDGRP_FOREACH_SUBGRP (SUBGRP_UPDGRP(subgrp), sibling) {
+		if (sibling == subgrp || SUBGRP_PCOUNT(sibling) < 2
+		    || !sibling->version)
+			continue;
+		if (CHECK_FLAG(sibling->sflags, SUBGRP_STATUS_DEFAULT_ORIGINATE)
+		    || update_subgroup_needs_refresh(sibling)
+		    || !advertise_list_is_empty(sibling))
+			continue;
+
+		source = sibling;
+		break;
+	}
+	if (!source)
+		return false;
+
+	SUBGRP_FOREACH_ADJ (source, aout) {
+		if (!aout->attr)
+			continue;
+
+		/* the path the adj-out was made from */
+		for (ri = bgp_dest_get_bgp_path_info(aout->dest); ri;
+		     ri = ri->next) {
+			if (!CHECK_FLAG(ri->flags, BGP_PATH_SELECTED)
+			    && !(addpath_capable
+				 && bgp_addpath_capable(ri, peer, afi, safi)))
+				continue;
+			if (bgp_addpath_id_for_peer(peer, afi, safi,
+						    &ri->tx_addpath)
+			    == aout->addpath_tx_id)
+				break;
+		}
+
+		/* out of sync after all; whatever was set up so far is
+		 * corrected by the table walk
+		 */
+		if (!ri)
+			return false;
+
+		bgp_adj_out_set_subgroup(aout->dest, subgrp, aout->attr, ri);
+	}
+
+	if (bgp_debug_update(NULL, NULL, subgrp->update_group, 0))
+		zlog_debug("u%" PRIu64 ":s%" PRIu64 " announcing routes inherited from s%" PRIu64,
+			   subgrp->update_group->id, subgrp->id, source->id);
+
+	subgrp->version = source->version;
+	SUBGRP_INCR_STAT(subgrp, announce_inherits);
+
+	update_subgroup_trigger_merge_check(subgrp, 0);
+	return true;
+}
+
+static void subgroup_announce_route_rmap(struct update_subgroup *subgrp,
+					 struct route_map *rmap)
 {
 	struct bgp_dest *dest;
 	struct bgp_table *table;
@@ -756,9 +926,11 @@ void subgroup_announce_route(struct update_subgroup *subgrp)
 
 	if (SUBGRP_SAFI(subgrp) != SAFI_MPLS_VPN
 	    && SUBGRP_SAFI(subgrp) != SAFI_ENCAP
-	    && SUBGRP_SAFI(subgrp) != SAFI_EVPN)
-		subgroup_announce_table(subgrp, NULL);
-	else
+	    && SUBGRP_SAFI(subgrp) != SAFI_EVPN) {
+		if (!rmap && subgroup_announce_inherit(subgrp))
+			return;
+		subgroup_announce_table_rmap(subgrp, NULL, rmap);
+	} else
 		for (dest = bgp_table_top(update_subgroup_rib(subgrp)); dest;
 		     dest = bgp_route_next(dest)) {
 			table = bgp_dest_get_bgp_table_info(dest);
@@ -768,6 +940,35 @@ void subgroup_announce_route(struct update_subgroup *subgrp)
 		}
 }
 
+/*
+ * subgroup_announce_route
+ *
+ * Refresh all routes out to a subgroup.
+ */
+void subgroup_announce_route(struct update_subgroup *subgrp)
+{
+	subgroup_announce_route_rmap(subgrp, NULL);
+}
+
+/*
+ * subgroup_announce_route_changed
+ *
+ * Refresh the routes out to a subgroup after the route-map rmap_name it
+ * uses was modified.  Where the library can tell which prefixes the
+ * modification may affect, only those are looked at again.
+ */
+void subgroup_announce_route_changed(struct update_subgroup *subgrp,
+				     const char *rmap_name)
+{
+	struct route_map *rmap;
+
+	rmap = route_map_lookup_by_name(rmap_name);
+	if (route_map_changed_all(rmap))
+		rmap = NULL;
+
+	subgroup_announce_route_rmap(subgrp, rmap);
+}
+
 void subgroup_default_originate(struct update_subgroup *subgrp, int withdraw)
 {
 	struct bgp *bgp;
@@ -57,6 +57,7 @@
 #include "bgpd/bgp_mplsvpn.h"
 #include "bgpd/bgp_label.h"
 #include "bgpd/bgp_addpath.h"
+#include "bgpd/bgp_worker_pool.h"
 
 /********************
  * PRIVATE FUNCTIONS
@@ -352,7 +353,10 @@ struct stream *bpacket_reformat_for_peer(struct bpacket *pkt,
 	struct peer *peer;
 	struct bgp_filter *filter;
 
-	s = stream_dup(pkt->buffer);
+	/* the packet is only copied if the nexthop needs rewriting, otherwise
+	 * all peers in the subgroup send from the same buffer
+	 */
+	s = stream_share(pkt->buffer);
 	peer = PAF_PEER(paf);
 
 	vec = &pkt->arr.entries[BGP_ATTR_VEC_NH];
@@ -445,8 +449,10 @@ struct stream *bpacket_reformat_for_peer(struct bpacket *pkt,
 			nh_modified = 1;
 		}
 
-		if (nh_modified) /* allow for VPN RD */
+		if (nh_modified) { /* allow for VPN RD */
+			stream_unshare(&s);
 			stream_put_in_addr_at(s, offset_nh, mod_v4nh);
+		}
 
 		if (bgp_debug_update(peer, NULL, NULL, 0))
 			zlog_debug("u%" PRIu64 ":s%" PRIu64
@@ -557,6 +563,8 @@ struct stream *bpacket_reformat_for_peer(struct bpacket *pkt,
 			}
 		}
 
+		if (gnh_modified || lnh_modified)
+			stream_unshare(&s);
 		if (gnh_modified)
 			stream_put_in6_addr_at(s, offset_nhglobal, mod_v6nhg);
 		if (lnh_modified)
@@ -598,8 +606,10 @@ struct stream *bpacket_reformat_for_peer(struct bpacket *pkt,
 			nh_modified = 1;
 		}
 
-		if (nh_modified)
+		if (nh_modified) {
+			stream_unshare(&s);
 			stream_put_in_addr_at(s, vec->offset + 1, mod_v4nh);
+		}
 
 		if (bgp_debug_update(peer, NULL, NULL, 0))
 			zlog_debug("u%" PRIu64 ":s%" PRIu64
@@ -648,17 +658,108 @@ bool subgroup_packets_to_build(struct update_subgroup *subgrp)
 	return false;
 }
 
-/* Make BGP update packet.  */
-struct bpacket *subgroup_update_packet(struct update_subgroup *subgrp)
-{
+/*
+ * One UPDATE for a subgroup, formatted by subgroup_update_packet_format()
+ * and queued by subgroup_update_packet_finish().
+ */
+struct subgroup_update_job {
+	struct update_subgroup *subgrp;
+
+	/* the advertisement to start with, see subgroup_update_first_adv() */
+	struct bgp_advertise *first;
+
+	/* the message, NULL if there was nothing to send */
+	struct stream *packet;
 	struct bpacket_attr_vec_arr vecarr;
-	struct bpacket *pkt;
+
+	/*
+	 * Number of advertisements taken from the update FIFO, including the
+	 * ones held back by maximum-prefix-out.
+	 */
+	unsigned int count;
+
+	/* the attributes alone leave no room for NLRI */
+	bool too_long;
+};
+
+/*
+ * How far into the update FIFO to look for a better filled UPDATE than the
+ * one the head would start, and how many times in a row the head may be
+ * passed over.
+ */
+#define UPDATE_PACK_WINDOW 32
+#define UPDATE_PACK_MAX_SKIPS 8
+
+/*
+ * Pick the advertisement to start the next UPDATE with.
+ *
+ * All the prefixes sharing its attributes go into the same UPDATE, so out of
+ * the first UPDATE_PACK_WINDOW ones prefer the attributes with the most
+ * prefixes pending.  The others get the chance to collect more prefixes in
+ * the meantime, instead of going out in small messages during table dumps.
+ */
+static struct bgp_advertise *
+subgroup_update_first_adv(struct update_subgroup *subgrp)
+{
+	struct bgp_advertise *head, *adv, *best;
+	unsigned int i;
+
+	head = bgp_adv_fifo_first(&subgrp->sync->update);
+	if (!head)
+		return NULL;
+
+	if (head != subgrp->pack_head) {
+		subgrp->pack_head = head;
+		subgrp->pack_skips = 0;
+	}
+	if (subgrp->pack_skips >= UPDATE_PACK_MAX_SKIPS)
+		return head;
+
+	best = head;
+	for (adv = bgp_adv_fifo_next(&subgrp->sync->update, head), i = 1;
+	     adv && i < UPDATE_PACK_WINDOW;
+	     adv = bgp_adv_fifo_next(&subgrp->sync->update, adv), i++)
+		if (adv->baa->refcnt > best->baa->refcnt)
+			best = adv;
+
+	if (best != head)
+		subgrp->pack_skips++;
+	return best;
+}
+
+/*
+ * The advertisement that follows adv in an UPDATE started with first.
+ * This is the order in which bgp_advertise_clean_subgroup() hands them out:
+ * the others with the same attributes, head first.
+ */
+static struct bgp_advertise *
+subgroup_update_next_adv(struct bgp_advertise *first, struct bgp_advertise *adv)
+{
+	adv = (adv == first) ? adv->baa->adv : adv->next;
+	if (adv == first)
+		adv = adv->next;
+	return adv;
+}
+
+/*
+ * Encode an UPDATE out of the subgroup's update FIFO, starting with
+ * job->first.
+ *
+ * This only reads the advertisements, the adj-outs and the rest of the
+ * daemon state and writes to the subgroup's work streams, so the jobs of
+ * different subgroups can run on separate pthreads.  The FIFO and the adj-outs
+ * are brought up to date afterwards, on the main pthread.
+ */
+static void subgroup_update_packet_format(struct subgroup_update_job *job)
+{
+	struct update_subgroup *subgrp = job->subgrp;
+	struct bpacket_attr_vec_arr *vecarr = &job->vecarr;
 	struct peer *peer;
 	struct stream *s;
 	struct stream *snlri;
 	struct stream *packet;
 	struct bgp_adj_out *adj;
-	struct bgp_advertise *adv;
+	struct bgp_advertise *adv, *first;
 	struct bgp_dest *dest = NULL;
 	struct bgp_path_info *path = NULL;
 	bgp_size_t total_attr_len = 0;
@@ -675,16 +776,11 @@ struct bpacket *subgroup_update_packet(struct update_subgroup *subgrp)
 	int addpath_encode = 0;
 	int addpath_overhead = 0;
 	uint32_t addpath_tx_id = 0;
+	uint32_t scount = subgrp->scount;
 	struct prefix_rd *prd = NULL;
 	mpls_label_t label = MPLS_INVALID_LABEL, *label_pnt = NULL;
 	uint32_t num_labels = 0;
 
-	if (!subgrp)
-		return NULL;
-
-	if (bpacket_queue_is_full(SUBGRP_INST(subgrp), SUBGRP_PKTQ(subgrp)))
-		return NULL;
-
 	peer = SUBGRP_PEER(subgrp);
 	afi = SUBGRP_AFI(subgrp);
 	safi = SUBGRP_SAFI(subgrp);
@@ -693,12 +789,12 @@ struct bpacket *subgroup_update_packet(struct update_subgroup *subgrp)
 	snlri = subgrp->scratch;
 	stream_reset(snlri);
 
-	bpacket_attr_vec_arr_reset(&vecarr);
+	bpacket_attr_vec_arr_reset(vecarr);
 
 	addpath_encode = bgp_addpath_encode_tx(peer, afi, safi);
 	addpath_overhead = addpath_encode ? BGP_ADDPATH_ID_LEN : 0;
 
-	adv = bgp_adv_fifo_first(&subgrp->sync->update);
+	first = adv = job->first;
 	while (adv) {
 		const struct prefix *dest_p;
 
@@ -714,7 +810,7 @@ struct bpacket *subgroup_update_packet(struct update_subgroup *subgrp)
 		 */
 		if (CHECK_FLAG(peer->af_flags[afi][safi],
 			       PEER_FLAG_MAX_PREFIX_OUT)
-		    && subgrp->scount >= peer->pmax_out[afi][safi]) {
+		    && scount >= peer->pmax_out[afi][safi]) {
 			if (BGP_DEBUG(update, UPDATE_OUT)
 			    || BGP_DEBUG(update, UPDATE_PREFIX)) {
 				zlog_debug(
@@ -766,7 +862,7 @@ struct bpacket *subgroup_update_packet(struct update_subgroup *subgrp)
 			/* 5: Encode all the attributes, except MP_REACH_NLRI
 			 * attr. */
 			total_attr_len = bgp_packet_attribute(
-				NULL, peer, s, adv->baa->attr, &vecarr, NULL,
+				NULL, peer, s, adv->baa->attr, vecarr, NULL,
 				afi, safi, from, NULL, NULL, 0, 0, 0);
 
 			space_remaining =
@@ -780,16 +876,8 @@ struct bpacket *subgroup_update_packet(struct update_subgroup *subgrp)
 			 * NLRI then
 			 * return */
 			if (space_remaining < space_needed) {
-				flog_err(
-					EC_BGP_UPDGRP_ATTR_LEN,
-					"u%" PRIu64 ":s%" PRIu64" attributes too long, cannot send UPDATE",
-					subgrp->update_group->id, subgrp->id);
-
-				/* Flush the FIFO update queue */
-				while (adv)
-					adv = bgp_advertise_clean_subgroup(
-						subgrp, adj);
-				return NULL;
+				job->too_long = true;
+				return;
 			}
 
 			if (BGP_DEBUG(update, UPDATE_OUT)
@@ -823,7 +911,7 @@ struct bpacket *subgroup_update_packet(struct update_subgroup *subgrp)
 
 			if (stream_empty(snlri))
 				mpattrlen_pos = bgp_packet_mpattr_start(
-					snlri, peer, afi, safi, &vecarr,
+					snlri, peer, afi, safi, vecarr,
 					adv->baa->attr);
 
 			bgp_packet_mpattr_prefix(snlri, afi, safi, dest_p, prd,
@@ -869,15 +957,12 @@ struct bpacket *subgroup_update_packet(struct update_subgroup *subgrp)
 				   pfx_buf);
 		}
 
-		/* Synchnorize attribute.  */
-		if (adj->attr)
-			bgp_attr_unintern(&adj->attr);
-		else
-			subgrp->scount++;
-
-		adj->attr = bgp_attr_intern(adv->baa->attr);
+		/* A new prefix counts against maximum-prefix-out. */
+		if (!adj->attr)
+			scount++;
 next:
-		adv = bgp_advertise_clean_subgroup(subgrp, adj);
+		job->count++;
+		adv = subgroup_update_next_adv(first, adv);
 	}
 
 	if (!stream_empty(s)) {
@@ -891,7 +976,7 @@ next:
 
 		if (!stream_empty(snlri)) {
 			packet = stream_dupcat(s, snlri, mpattr_pos);
-			bpacket_attr_vec_arr_update(&vecarr, mpattr_pos);
+			bpacket_attr_vec_arr_update(vecarr, mpattr_pos);
 		} else
 			packet = stream_dup(s);
 		bgp_packet_set_size(packet);
@@ -903,12 +988,194 @@ next:
 				(stream_get_endp(packet)
 				 - stream_get_getp(packet)),
 				peer->max_packet_size, num_pfx);
-		pkt = bpacket_queue_add(SUBGRP_PKTQ(subgrp), packet, &vecarr);
+		job->packet = packet;
 		stream_reset(s);
 		stream_reset(snlri);
-		return pkt;
 	}
-	return NULL;
+}
+
+/*
+ * Synchronize the adj-outs with the UPDATE formatted by job, take its
+ * advertisements off the FIFO and queue the message for the peers.
+ */
+static struct bpacket *
+subgroup_update_packet_finish(struct subgroup_update_job *job)
+{
+	struct update_subgroup *subgrp = job->subgrp;
+	struct peer *peer = SUBGRP_PEER(subgrp);
+	afi_t afi = SUBGRP_AFI(subgrp);
+	safi_t safi = SUBGRP_SAFI(subgrp);
+	struct bgp_advertise *adv;
+	struct bgp_adj_out *adj;
+	unsigned int i;
+
+	adv = job->first;
+
+	if (job->too_long) {
+		flog_err(EC_BGP_UPDGRP_ATTR_LEN,
+			 "u%" PRIu64 ":s%" PRIu64
+			 " attributes too long, cannot send UPDATE",
+			 subgrp->update_group->id, subgrp->id);
+
+		/* Flush the prefixes sharing these attributes */
+		while (adv)
+			adv = bgp_advertise_clean_subgroup(subgrp, adv->adj);
+		return NULL;
+	}
+
+	for (i = 0; i < job->count; i++) {
+		adj = adv->adj;
+
+		/* Same test as in subgroup_update_packet_format() */
+		if (!CHECK_FLAG(peer->af_flags[afi][safi],
+				PEER_FLAG_MAX_PREFIX_OUT)
+		    || subgrp->scount < peer->pmax_out[afi][safi]) {
+			/* Synchnorize attribute.  */
+			if (adj->attr)
+				bgp_attr_unintern(&adj->attr);
+			else
+				subgrp->scount++;
+
+			adj->attr = bgp_attr_intern(adv->baa->attr);
+		}
+
+		adv = bgp_advertise_clean_subgroup(subgrp, adj);
+	}
+
+	if (!job->packet)
+		return NULL;
+
+	return bpacket_queue_add(SUBGRP_PKTQ(subgrp), job->packet,
+				 &job->vecarr);
+}
+
+/* Make BGP update packet.  */
+struct bpacket *subgroup_update_packet(struct update_subgroup *subgrp)
+{
+	struct subgroup_update_job job = {.subgrp = subgrp};
+
+	if (!subgrp)
+		return NULL;
+
+	if (bpacket_queue_is_full(SUBGRP_INST(subgrp), SUBGRP_PKTQ(subgrp)))
+		return NULL;
+
+	job.first = subgroup_update_first_adv(subgrp);
+	subgroup_update_packet_format(&job);
+	return subgroup_update_packet_finish(&job);
+}
+
+/* One round of UPDATEs, at most one per subgroup */
+struct subgroup_update_batch {
+	struct subgroup_update_job *jobs;
+	unsigned int count;
+	unsigned int size;
+	unsigned int nshards;
+};
+
+/*
+ * Whether one of the peers of the subgroup would pull packets out of it
+ * right away, see bgp_generate_updgrp_packets().  Others are left alone so
+ * that their advertisements keep accumulating, e.g. until the MRAI expires.
+ */
+static bool subgroup_update_packets_wanted(struct update_subgroup *subgrp)
+{
+	struct peer_af *paf;
+
+	SUBGRP_FOREACH_PEER (subgrp, paf)
+		if (peer_established(paf->peer) && !paf->peer->t_routeadv)
+			return true;
+
+	return false;
+}
+
+static int subgroup_update_packets_collect(struct update_group *updgrp,
+					   void *arg)
+{
+	struct subgroup_update_batch *batch = arg;
+	struct update_subgroup *subgrp;
+
+	UPDGRP_FOREACH_SUBGRP (updgrp, subgrp) {
+		if (!subgroup_update_packets_wanted(subgrp))
+			continue;
+
+		/* withdraws go out first and are cheap to build */
+		while (bgp_adv_fifo_first(&subgrp->sync->withdraw)
+		       && subgroup_withdraw_packet(subgrp))
+			;
+
+		if (bgp_adv_fifo_first(&subgrp->sync->withdraw)
+		    || !bgp_adv_fifo_first(&subgrp->sync->update)
+		    || bpacket_queue_is_full(SUBGRP_INST(subgrp),
+					     SUBGRP_PKTQ(subgrp)))
+			continue;
+
+		if (batch->count == batch->size) {
+			batch->size = MAX(batch->size * 2, 16);
+			batch->jobs = XREALLOC(MTYPE_TMP, batch->jobs,
+					       batch->size
+						       * sizeof(*batch->jobs));
+		}
+		batch->jobs[batch->count++] = (struct subgroup_update_job){
+			.subgrp = subgrp,
+			.first = subgroup_update_first_adv(subgrp),
+		};
+	}
+
+	return UPDWALK_CONTINUE;
+}
+
+static void subgroup_update_packets_shard(void *arg, unsigned int shard)
+{
+	struct subgroup_update_batch *batch = arg;
+	unsigned int i;
+
+	for (i = shard; i < batch->count; i += batch->nshards)
+		subgroup_update_packet_format(&batch->jobs[i]);
+}
+
+/*
+ * Build the pending UPDATEs of all the subgroups of the instance, formatting
+ * one message per subgroup at a time on the worker pthreads.  The peers
+ * then find them ready in bgp_generate_updgrp_packets().
+ */
+static int subgroup_update_packets_build(struct thread *thread)
+{
+	struct bgp *bgp = THREAD_ARG(thread);
+	struct subgroup_update_batch batch = {};
+	unsigned int i;
+
+	if (bgp->main_peers_update_hold || bgp_update_delay_active(bgp))
+		return 0;
+
+	batch.nshards = bgp_worker_pool_size(bgp_update_pool) + 1;
+
+	do {
+		batch.count = 0;
+		update_group_walk(bgp, subgroup_update_packets_collect, &batch);
+
+		if (batch.count > 1)
+			bgp_worker_pool_run(bgp_update_pool,
+					    subgroup_update_packets_shard,
+					    &batch);
+		else if (batch.count)
+			subgroup_update_packet_format(&batch.jobs[0]);
+
+		for (i = 0; i < batch.count; i++)
+			subgroup_update_packet_finish(&batch.jobs[i]);
+	} while (batch.count);
+
+	XFREE(MTYPE_TMP, batch.jobs);
+	return 0;
+}
+
+void subgroup_update_packets_schedule(struct bgp *bgp)
+{
+	if (!bgp_worker_pool_size(bgp_update_pool))
+		return;
+
+	thread_add_event(bm->master, subgroup_update_packets_build, bgp, 0,
+			 &bgp->t_update_build);
 }
 
 /* Make BGP withdraw packet.  */
@@ -40,6 +40,7 @@ int show_adj_route_vpn(struct vty *vty, struct peer *peer,
 	struct bgp_table *table;
 	struct bgp_dest *dest;
 	struct bgp_dest *rm;
+	struct update_subgroup *subgrp;
 	int rd_header;
 	int header = 1;
 	json_object *json = NULL;
@@ -77,6 +78,8 @@ int show_adj_route_vpn(struct vty *vty, struct peer *peer,
 		json_object_string_add(json_ocode, "incomplete", "?");
 	}
 
+	subgrp = peer_subgroup(peer, afi, safi);
+
 	for (dest = bgp_table_top(bgp->rib[afi][safi]); dest;
 	     dest = bgp_route_next(dest)) {
 		const struct prefix *dest_p = bgp_dest_get_prefix(dest);
@@ -99,16 +102,13 @@ int show_adj_route_vpn(struct vty *vty, struct peer *peer,
 		for (rm = bgp_table_top(table); rm; rm = bgp_route_next(rm)) {
 			struct bgp_adj_out *adj = NULL;
 			struct attr *attr = NULL;
-			struct peer_af *paf = NULL;
-
-			RB_FOREACH (adj, bgp_adj_out_rb, &rm->adj_out)
-				SUBGRP_FOREACH_PEER (adj->subgroup, paf) {
-					if (paf->peer != peer || !adj->attr)
-						continue;
 
-					attr = adj->attr;
-					break;
-			}
+			if (subgrp)
+				SUBGRP_FOREACH_DEST_ADJ (subgrp, rm, adj)
+					if (adj->attr) {
+						attr = adj->attr;
+						break;
+					}
 
 			if (bgp_dest_get_bgp_path_info(rm) == NULL)
 				continue;
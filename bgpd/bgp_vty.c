@@ -73,6 +73,8 @@
 #include "bgpd/bgp_mac.h"
 #include "bgpd/bgp_flowspec.h"
 #include "bgpd/bgp_conditional_adv.h"
+#include "bgpd/bgp_worker_pool.h"
+#include "bgpd/bgp_textcache.h"
 #ifdef ENABLE_BGP_VNC
 #include "bgpd/rfapi/bgp_rfapi_cfg.h"
 #endif
@@ -3653,6 +3655,31 @@ DEFUN(no_bgp_bestpath_peer_type_multipath_relax,
 	return CMD_SUCCESS;
 }
 
+/* "bgp lazy-nexthop-update" configuration. */
+DEFUN(bgp_lazy_nexthop_update,
+      bgp_lazy_nexthop_update_cmd,
+      "bgp lazy-nexthop-update",
+      BGP_STR
+      "Skip route processing for nexthop changes that cannot change the best path\n")
+{
+	VTY_DECLVAR_CONTEXT(bgp, bgp);
+	SET_FLAG(bgp->flags, BGP_FLAG_LAZY_NHT);
+
+	return CMD_SUCCESS;
+}
+
+DEFUN(no_bgp_lazy_nexthop_update,
+      no_bgp_lazy_nexthop_update_cmd,
+      "no bgp lazy-nexthop-update",
+      NO_STR BGP_STR
+      "Skip route processing for nexthop changes that cannot change the best path\n")
+{
+	VTY_DECLVAR_CONTEXT(bgp, bgp);
+	UNSET_FLAG(bgp->flags, BGP_FLAG_LAZY_NHT);
+
+	return CMD_SUCCESS;
+}
+
 /* "bgp log-neighbor-changes" configuration.  */
 DEFUN_YANG(bgp_log_neighbor_changes,
 	   bgp_log_neighbor_changes_cmd,
@@ -7815,6 +7842,121 @@ DEFUN (no_bgp_set_route_map_delay_timer,
 	return CMD_SUCCESS;
 }
 
+DEFPY (bgp_bestpath_threads,
+       bgp_bestpath_threads_cmd,
+       "bgp bestpath-threads (1-64)$threads",
+       BGP_STR
+       "Run best path selection for large batches of routes in worker pthreads\n"
+       "Number of worker pthreads\n")
+{
+	bgp_worker_pool_set(bgp_bestpath_pool, threads);
+	return CMD_SUCCESS;
+}
+
+DEFPY (no_bgp_bestpath_threads,
+       no_bgp_bestpath_threads_cmd,
+       "no bgp bestpath-threads [(1-64)]",
+       NO_STR
+       BGP_STR
+       "Run best path selection for large batches of routes in worker pthreads\n"
+       "Number of worker pthreads\n")
+{
+	bgp_worker_pool_set(bgp_bestpath_pool, 0);
+	return CMD_SUCCESS;
+}
+
+DEFPY (bgp_update_threads,
+       bgp_update_threads_cmd,
+       "bgp update-threads (1-64)$threads",
+       BGP_STR
+       "Build the UPDATE messages of the update-groups in worker pthreads\n"
+       "Number of worker pthreads\n")
+{
+	bgp_worker_pool_set(bgp_update_pool, threads);
+	return CMD_SUCCESS;
+}
+
+DEFPY (no_bgp_update_threads,
+       no_bgp_update_threads_cmd,
+       "no bgp update-threads [(1-64)]",
+       NO_STR
+       BGP_STR
+       "Build the UPDATE messages of the update-groups in worker pthreads\n"
+       "Number of worker pthreads\n")
+{
+	bgp_worker_pool_set(bgp_update_pool, 0);
+	return CMD_SUCCESS;
+}
+
+DEFPY (bgp_soft_reconfig_threads,
+       bgp_soft_reconfig_threads_cmd,
+       "bgp soft-reconfiguration-threads (1-64)$threads",
+       BGP_STR
+       "Apply inbound policy for soft reconfiguration in worker pthreads\n"
+       "Number of worker pthreads\n")
+{
+	bgp_worker_pool_set(bgp_soft_reconfig_pool, threads);
+	return CMD_SUCCESS;
+}
+
+DEFPY (no_bgp_soft_reconfig_threads,
+       no_bgp_soft_reconfig_threads_cmd,
+       "no bgp soft-reconfiguration-threads [(1-64)]",
+       NO_STR
+       BGP_STR
+       "Apply inbound policy for soft reconfiguration in worker pthreads\n"
+       "Number of worker pthreads\n")
+{
+	bgp_worker_pool_set(bgp_soft_reconfig_pool, 0);
+	return CMD_SUCCESS;
+}
+
+DEFPY (bgp_text_cache_limit,
+       bgp_text_cache_limit_cmd,
+       "bgp text-cache-limit (1-65535)$limit",
+       BGP_STR
+       "Memory budget for cached AS path and community strings\n"
+       "Budget in MiB\n")
+{
+	bgp_text_set_limit(limit);
+	return CMD_SUCCESS;
+}
+
+DEFPY (no_bgp_text_cache_limit,
+       no_bgp_text_cache_limit_cmd,
+       "no bgp text-cache-limit [(1-65535)]",
+       NO_STR
+       BGP_STR
+       "Memory budget for cached AS path and community strings\n"
+       "Budget in MiB\n")
+{
+	bgp_text_set_limit(BGP_TEXT_LIMIT_DEF);
+	return CMD_SUCCESS;
+}
+
+DEFPY (bgp_convergence_sampling,
+       bgp_convergence_sampling_cmd,
+       "bgp convergence-sampling (1-65535)$rate",
+       BGP_STR
+       "Time a sample of the unicast prefix updates from receipt to zebra\n"
+       "Sample 1 in this many prefixes\n")
+{
+	conv_set_rate(bm->conv, rate);
+	return CMD_SUCCESS;
+}
+
+DEFPY (no_bgp_convergence_sampling,
+       no_bgp_convergence_sampling_cmd,
+       "no bgp convergence-sampling [(1-65535)]",
+       NO_STR
+       BGP_STR
+       "Time a sample of the unicast prefix updates from receipt to zebra\n"
+       "Sample 1 in this many prefixes\n")
+{
+	conv_set_rate(bm->conv, 0);
+	return CMD_SUCCESS;
+}
+
 DEFUN_YANG (neighbor_interface,
 	    neighbor_interface_cmd,
 	    "neighbor <A.B.C.D|X:X::X:X> interface WORD",
@@ -8877,7 +9019,7 @@ DEFUN (neighbor_addpath_tx_all_paths,
 		return CMD_WARNING_CONFIG_FAILED;
 
 	bgp_addpath_set_peer_type(peer, bgp_node_afi(vty), bgp_node_safi(vty),
-				 BGP_ADDPATH_ALL);
+				 BGP_ADDPATH_ALL, 0);
 	return CMD_SUCCESS;
 }
 
@@ -8910,7 +9052,7 @@ DEFUN (no_neighbor_addpath_tx_all_paths,
 	}
 
 	bgp_addpath_set_peer_type(peer, bgp_node_afi(vty), bgp_node_safi(vty),
-				 BGP_ADDPATH_NONE);
+				 BGP_ADDPATH_NONE, 0);
 
 	return CMD_SUCCESS;
 }
@@ -8936,7 +9078,7 @@ DEFUN (neighbor_addpath_tx_bestpath_per_as,
 		return CMD_WARNING_CONFIG_FAILED;
 
 	bgp_addpath_set_peer_type(peer, bgp_node_afi(vty), bgp_node_safi(vty),
-				 BGP_ADDPATH_BEST_PER_AS);
+				 BGP_ADDPATH_BEST_PER_AS, 0);
 
 	return CMD_SUCCESS;
 }
@@ -8970,7 +9112,7 @@ DEFUN (no_neighbor_addpath_tx_bestpath_per_as,
 	}
 
 	bgp_addpath_set_peer_type(peer, bgp_node_afi(vty), bgp_node_safi(vty),
-				 BGP_ADDPATH_NONE);
+				 BGP_ADDPATH_NONE, 0);
 
 	return CMD_SUCCESS;
 }
@@ -8981,6 +9123,54 @@ ALIAS_HIDDEN(no_neighbor_addpath_tx_bestpath_per_as,
 	     NO_STR NEIGHBOR_STR NEIGHBOR_ADDR_STR2
 	     "Use addpath to advertise the bestpath per each neighboring AS\n")
 
+DEFPY (neighbor_addpath_tx_best_selected_paths,
+       neighbor_addpath_tx_best_selected_paths_cmd,
+       "neighbor <A.B.C.D|X:X::X:X|WORD>$neighbor addpath-tx-best-selected (1-6)$paths",
+       NEIGHBOR_STR
+       NEIGHBOR_ADDR_STR2
+       "Use addpath to advertise best N selected paths\n"
+       "The number of best paths\n")
+{
+	struct peer *peer;
+
+	peer = peer_and_group_lookup_vty(vty, neighbor);
+	if (!peer)
+		return CMD_WARNING_CONFIG_FAILED;
+
+	bgp_addpath_set_peer_type(peer, bgp_node_afi(vty), bgp_node_safi(vty),
+				 BGP_ADDPATH_BEST_SELECTED, paths);
+
+	return CMD_SUCCESS;
+}
+
+DEFPY (no_neighbor_addpath_tx_best_selected_paths,
+       no_neighbor_addpath_tx_best_selected_paths_cmd,
+       "no neighbor <A.B.C.D|X:X::X:X|WORD>$neighbor addpath-tx-best-selected [(1-6)]",
+       NO_STR
+       NEIGHBOR_STR
+       NEIGHBOR_ADDR_STR2
+       "Use addpath to advertise best N selected paths\n"
+       "The number of best paths\n")
+{
+	struct peer *peer;
+
+	peer = peer_and_group_lookup_vty(vty, neighbor);
+	if (!peer)
+		return CMD_WARNING_CONFIG_FAILED;
+
+	if (peer->addpath_type[bgp_node_afi(vty)][bgp_node_safi(vty)]
+	    != BGP_ADDPATH_BEST_SELECTED) {
+		vty_out(vty,
+			"%% Peer not currently configured to transmit best selected paths.");
+		return CMD_WARNING_CONFIG_FAILED;
+	}
+
+	bgp_addpath_set_peer_type(peer, bgp_node_afi(vty), bgp_node_safi(vty),
+				 BGP_ADDPATH_NONE, 0);
+
+	return CMD_SUCCESS;
+}
+
 DEFPY(
 	neighbor_aspath_loop_detection, neighbor_aspath_loop_detection_cmd,
 	"neighbor <A.B.C.D|X:X::X:X|WORD>$neighbor sender-as-path-loop-detection",
@@ -10090,7 +10280,7 @@ DEFPY (show_bgp_srv6,
 {
 	struct bgp *bgp;
 	struct listnode *node;
-	struct prefix_ipv6 *chunk;
+	struct bgp_srv6_locator_chunk *chunk;
 	struct bgp_srv6_function *func;
 	struct in6_addr *tovpn4_sid;
 	struct in6_addr *tovpn6_sid;
@@ -10105,7 +10295,7 @@ DEFPY (show_bgp_srv6,
 	vty_out(vty, "locator_name: %s\n", bgp->srv6_locator_name);
 	vty_out(vty, "locator_chunks:\n");
 	for (ALL_LIST_ELEMENTS_RO(bgp->srv6_locator_chunks, node, chunk)) {
-		prefix2str(chunk, buf, sizeof(buf));
+		prefix2str(&chunk->prefix, buf, sizeof(buf));
 		vty_out(vty, "- %s\n", buf);
 	}
 
@@ -10654,6 +10844,18 @@ DEFUN(show_bgp_martian_nexthop_db, show_bgp_martian_nexthop_db_cmd,
 	return CMD_SUCCESS;
 }
 
+DEFUN (show_bgp_convergence,
+       show_bgp_convergence_cmd,
+       "show bgp convergence [json]",
+       SHOW_STR
+       BGP_STR
+       "Per-stage timing of the sampled prefix updates\n"
+       JSON_STR)
+{
+	conv_show(vty, bm->conv, use_json(argc, argv));
+	return CMD_SUCCESS;
+}
+
 DEFUN (show_bgp_memory,
        show_bgp_memory_cmd,
        "show [ip] bgp memory",
@@ -10754,6 +10956,8 @@ DEFUN (show_bgp_memory,
 			mtype_memstr(memstrbuf, sizeof(memstrbuf),
 				     count * sizeof(struct cluster_list)));
 
+	bgp_text_show_memory(vty);
+
 	/* Peer related usage */
 	count = mtype_stats_alloc(MTYPE_BGP_PEER);
 	vty_out(vty, "%ld peers, using %s of memory\n", count,
@@ -17016,6 +17220,10 @@ static bool peergroup_af_addpath_check(struct peer *peer, afi_t afi,
 
 			if (type != g_type)
 				return true;
+			else if (peer->addpath_best_selected[afi][safi]
+				 != peer->group->conf
+					    ->addpath_best_selected[afi][safi])
+				return true;
 			else
 				return false;
 		}
@@ -17554,6 +17762,11 @@ static void bgp_config_write_peer_af(struct vty *vty, struct bgp *bgp,
 				"  neighbor %s addpath-tx-bestpath-per-AS\n",
 				addr);
 			break;
+		case BGP_ADDPATH_BEST_SELECTED:
+			vty_out(vty,
+				"  neighbor %s addpath-tx-best-selected %u\n",
+				addr, peer->addpath_best_selected[afi][safi]);
+			break;
 		case BGP_ADDPATH_MAX:
 		case BGP_ADDPATH_NONE:
 			break;
@@ -17871,6 +18084,25 @@ int bgp_config_write(struct vty *vty)
 		vty_out(vty, "bgp route-map delay-timer %u\n",
 			bm->rmap_update_timer);
 
+	if (bgp_worker_pool_size(bgp_bestpath_pool))
+		vty_out(vty, "bgp bestpath-threads %u\n",
+			bgp_worker_pool_size(bgp_bestpath_pool));
+
+	if (bgp_worker_pool_size(bgp_update_pool))
+		vty_out(vty, "bgp update-threads %u\n",
+			bgp_worker_pool_size(bgp_update_pool));
+
+	if (bgp_worker_pool_size(bgp_soft_reconfig_pool))
+		vty_out(vty, "bgp soft-reconfiguration-threads %u\n",
+			bgp_worker_pool_size(bgp_soft_reconfig_pool));
+
+	if (bgp_text_get_limit() != BGP_TEXT_LIMIT_DEF)
+		vty_out(vty, "bgp text-cache-limit %u\n", bgp_text_get_limit());
+
+	if (conv_get_rate(bm->conv))
+		vty_out(vty, "bgp convergence-sampling %u\n",
+			conv_get_rate(bm->conv));
+
 	if (bm->v_update_delay != BGP_UPDATE_DELAY_DEF) {
 		vty_out(vty, "bgp update-delay %d", bm->v_update_delay);
 		if (bm->v_update_delay != bm->v_establish_wait)
@@ -18142,6 +18374,9 @@ int bgp_config_write(struct vty *vty)
 			vty_out(vty,
 				" bgp bestpath peer-type multipath-relax\n");
 
+		if (CHECK_FLAG(bgp->flags, BGP_FLAG_LAZY_NHT))
+			vty_out(vty, " bgp lazy-nexthop-update\n");
+
 		/* Link bandwidth handling. */
 		if (bgp->lb_handling == BGP_LINK_BW_IGNORE_BW)
 			vty_out(vty, " bgp bestpath bandwidth ignore\n");
@@ -18462,6 +18697,22 @@ void bgp_vty_init(void)
 	install_element(CONFIG_NODE, &bgp_set_route_map_delay_timer_cmd);
 	install_element(CONFIG_NODE, &no_bgp_set_route_map_delay_timer_cmd);
 
+	/* bgp bestpath-threads commands. */
+	install_element(CONFIG_NODE, &bgp_bestpath_threads_cmd);
+	install_element(CONFIG_NODE, &no_bgp_bestpath_threads_cmd);
+	install_element(CONFIG_NODE, &bgp_update_threads_cmd);
+	install_element(CONFIG_NODE, &no_bgp_update_threads_cmd);
+	install_element(CONFIG_NODE, &bgp_soft_reconfig_threads_cmd);
+	install_element(CONFIG_NODE, &no_bgp_soft_reconfig_threads_cmd);
+
+	/* bgp text-cache-limit commands. */
+	install_element(CONFIG_NODE, &bgp_text_cache_limit_cmd);
+	install_element(CONFIG_NODE, &no_bgp_text_cache_limit_cmd);
+
+	/* bgp convergence-sampling commands. */
+	install_element(CONFIG_NODE, &bgp_convergence_sampling_cmd);
+	install_element(CONFIG_NODE, &no_bgp_convergence_sampling_cmd);
+
 	/* global bgp update-delay command */
 	install_element(CONFIG_NODE, &bgp_global_update_delay_cmd);
 	install_element(CONFIG_NODE, &no_bgp_global_update_delay_cmd);
@@ -18655,6 +18906,10 @@ void bgp_vty_init(void)
 	install_element(BGP_NODE,
 			&no_bgp_bestpath_peer_type_multipath_relax_cmd);
 
+	/* "bgp lazy-nexthop-update" commands */
+	install_element(BGP_NODE, &bgp_lazy_nexthop_update_cmd);
+	install_element(BGP_NODE, &no_bgp_lazy_nexthop_update_cmd);
+
 	/* "bgp log-neighbor-changes" commands */
 	install_element(BGP_NODE, &bgp_log_neighbor_changes_cmd);
 	install_element(BGP_NODE, &no_bgp_log_neighbor_changes_cmd);
@@ -19224,6 +19479,40 @@ void bgp_vty_init(void)
 	install_element(BGP_VPNV6_NODE,
 			&no_neighbor_addpath_tx_bestpath_per_as_cmd);
 
+	/* "neighbor addpath-tx-best-selected" commands.*/
+	install_element(BGP_IPV4_NODE,
+			&neighbor_addpath_tx_best_selected_paths_cmd);
+	install_element(BGP_IPV4_NODE,
+			&no_neighbor_addpath_tx_best_selected_paths_cmd);
+	install_element(BGP_IPV4M_NODE,
+			&neighbor_addpath_tx_best_selected_paths_cmd);
+	install_element(BGP_IPV4M_NODE,
+			&no_neighbor_addpath_tx_best_selected_paths_cmd);
+	install_element(BGP_IPV4L_NODE,
+			&neighbor_addpath_tx_best_selected_paths_cmd);
+	install_element(BGP_IPV4L_NODE,
+			&no_neighbor_addpath_tx_best_selected_paths_cmd);
+	install_element(BGP_IPV6_NODE,
+			&neighbor_addpath_tx_best_selected_paths_cmd);
+	install_element(BGP_IPV6_NODE,
+			&no_neighbor_addpath_tx_best_selected_paths_cmd);
+	install_element(BGP_IPV6M_NODE,
+			&neighbor_addpath_tx_best_selected_paths_cmd);
+	install_element(BGP_IPV6M_NODE,
+			&no_neighbor_addpath_tx_best_selected_paths_cmd);
+	install_element(BGP_IPV6L_NODE,
+			&neighbor_addpath_tx_best_selected_paths_cmd);
+	install_element(BGP_IPV6L_NODE,
+			&no_neighbor_addpath_tx_best_selected_paths_cmd);
+	install_element(BGP_VPNV4_NODE,
+			&neighbor_addpath_tx_best_selected_paths_cmd);
+	install_element(BGP_VPNV4_NODE,
+			&no_neighbor_addpath_tx_best_selected_paths_cmd);
+	install_element(BGP_VPNV6_NODE,
+			&neighbor_addpath_tx_best_selected_paths_cmd);
+	install_element(BGP_VPNV6_NODE,
+			&no_neighbor_addpath_tx_best_selected_paths_cmd);
+
 	/* "neighbor sender-as-path-loop-detection" commands. */
 	install_element(BGP_NODE, &neighbor_aspath_loop_detection_cmd);
 	install_element(BGP_NODE, &no_neighbor_aspath_loop_detection_cmd);
@@ -19727,6 +20016,9 @@ void bgp_vty_init(void)
 	/* "show [ip] bgp memory" commands. */
 	install_element(VIEW_NODE, &show_bgp_memory_cmd);
 
+	/* "show bgp convergence" */
+	install_element(VIEW_NODE, &show_bgp_convergence_cmd);
+
 	/* "show bgp martian next-hop" */
 	install_element(VIEW_NODE, &show_bgp_martian_nexthop_db_cmd);
 
@@ -0,0 +1,185 @@
+/*
+ * BGP worker pthread pools.
+ * Copyright (C) 2021  FRRouting
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+#include <pthread.h>
+
+#include "frr_pthread.h"
+#include "memory.h"
+#include "thread.h"
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_worker_pool.h"
+
+DEFINE_MTYPE_STATIC(BGPD, BGP_WORKER_POOL, "BGP worker pool");
+
+struct bgp_worker_shard {
+	struct bgp_worker_pool *pool;
+	void (*fn)(void *arg, unsigned int shard);
+	void *arg;
+	unsigned int shard;
+};
+
+struct bgp_worker_pool {
+	/* thread names, suffixed with the thread number */
+	const char *name;
+	const char *os_name;
+
+	/* only touched by the main pthread */
+	struct frr_pthread **threads;
+	struct bgp_worker_shard *shards;
+	unsigned int size;
+
+	/* number of shards still running on the workers */
+	pthread_mutex_t mtx;
+	pthread_cond_t cond;
+	unsigned int pending;
+};
+
+static struct bgp_worker_pool bestpath_pool = {
+	.name = "BGP bestpath thread",
+	.os_name = "bgpd_bp",
+	.mtx = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER,
+};
+
+static struct bgp_worker_pool update_pool = {
+	.name = "BGP update thread",
+	.os_name = "bgpd_upd",
+	.mtx = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER,
+};
+
+static struct bgp_worker_pool soft_reconfig_pool = {
+	.name = "BGP soft-reconfig thread",
+	.os_name = "bgpd_src",
+	.mtx = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER,
+};
+
+struct bgp_worker_pool *bgp_bestpath_pool = &bestpath_pool;
+struct bgp_worker_pool *bgp_update_pool = &update_pool;
+struct bgp_worker_pool *bgp_soft_reconfig_pool = &soft_reconfig_pool;
+
+/* Only written by the main pthread while no worker is running; the workers
+ * see it through the event and mutex handoff in bgp_worker_pool_run().
+ */
+static bool worker_pool_busy;
+
+static int bgp_worker_pool_work(struct thread *thread)
+{
+	struct bgp_worker_shard *shard = THREAD_ARG(thread);
+	struct bgp_worker_pool *pool = shard->pool;
+
+	shard->fn(shard->arg, shard->shard);
+
+	frr_with_mutex(&pool->mtx) {
+		if (--pool->pending == 0)
+			pthread_cond_signal(&pool->cond);
+	}
+	return 0;
+}
+
+void bgp_worker_pool_run(struct bgp_worker_pool *pool,
+			 void (*fn)(void *arg, unsigned int shard), void *arg)
+{
+	unsigned int i;
+
+	if (!pool->size) {
+		fn(arg, 0);
+		return;
+	}
+
+	worker_pool_busy = true;
+
+	frr_with_mutex(&pool->mtx) {
+		pool->pending = pool->size;
+	}
+
+	for (i = 0; i < pool->size; i++) {
+		pool->shards[i].pool = pool;
+		pool->shards[i].fn = fn;
+		pool->shards[i].arg = arg;
+		pool->shards[i].shard = i;
+		thread_add_event(pool->threads[i]->master, bgp_worker_pool_work,
+				 &pool->shards[i], 0, NULL);
+	}
+
+	fn(arg, pool->size);
+
+	frr_with_mutex(&pool->mtx) {
+		while (pool->pending)
+			pthread_cond_wait(&pool->cond, &pool->mtx);
+	}
+
+	worker_pool_busy = false;
+}
+
+bool bgp_worker_pool_busy(void)
+{
+	return worker_pool_busy;
+}
+
+unsigned int bgp_worker_pool_size(const struct bgp_worker_pool *pool)
+{
+	return pool->size;
+}
+
+void bgp_worker_pool_set(struct bgp_worker_pool *pool, unsigned int nthreads)
+{
+	struct frr_pthread_attr attr = {
+		.start = frr_pthread_attr_default.start,
+		.stop = frr_pthread_attr_default.stop,
+	};
+	char name[32], os_name[OS_THREAD_NAMELEN];
+	unsigned int i;
+
+	if (nthreads > BGP_WORKER_THREADS_MAX)
+		nthreads = BGP_WORKER_THREADS_MAX;
+	if (nthreads == pool->size)
+		return;
+
+	/* the workers carry no state, so resizing is just rebuilding */
+	for (i = 0; i < pool->size; i++) {
+		frr_pthread_stop(pool->threads[i], NULL);
+		frr_pthread_destroy(pool->threads[i]);
+	}
+	XFREE(MTYPE_BGP_WORKER_POOL, pool->threads);
+	XFREE(MTYPE_BGP_WORKER_POOL, pool->shards);
+	pool->size = 0;
+
+	if (!nthreads)
+		return;
+
+	pool->threads = XCALLOC(MTYPE_BGP_WORKER_POOL,
+				nthreads * sizeof(*pool->threads));
+	pool->shards = XCALLOC(MTYPE_BGP_WORKER_POOL,
+			       nthreads * sizeof(*pool->shards));
+
+	for (i = 0; i < nthreads; i++) {
+		snprintf(name, sizeof(name), "%s %u", pool->name, i);
+		snprintf(os_name, sizeof(os_name), "%s%u", pool->os_name, i);
+		pool->threads[i] = frr_pthread_new(&attr, name, os_name);
+		frr_pthread_run(pool->threads[i], NULL);
+	}
+	for (i = 0; i < nthreads; i++)
+		frr_pthread_wait_running(pool->threads[i]);
+
+	pool->size = nthreads;
+}
@@ -0,0 +1,75 @@
+/*
+ * BGP worker pthread pools.
+ * Copyright (C) 2021  FRRouting
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _FRR_BGP_WORKER_POOL_H
+#define _FRR_BGP_WORKER_POOL_H
+
+#define BGP_WORKER_THREADS_MAX 64
+
+struct bgp_worker_pool;
+
+/* best path selection, see bgp_process_parallel() */
+extern struct bgp_worker_pool *bgp_bestpath_pool;
+/* UPDATE formatting, see subgroup_update_packets_build() */
+extern struct bgp_worker_pool *bgp_update_pool;
+/* inbound policy for soft reconfiguration, see bgp_soft_reconfig_batch() */
+extern struct bgp_worker_pool *bgp_soft_reconfig_pool;
+
+/**
+ * Resizes the pool to the given number of worker pthreads.
+ *
+ * Must be called from the main pthread.  0 stops all workers, in which case
+ * the work runs on the main pthread only.
+ *
+ * @param pool - the pool to resize
+ * @param nthreads - number of worker pthreads
+ */
+extern void bgp_worker_pool_set(struct bgp_worker_pool *pool,
+				unsigned int nthreads);
+
+/**
+ * Number of worker pthreads currently running.
+ */
+extern unsigned int bgp_worker_pool_size(const struct bgp_worker_pool *pool);
+
+/**
+ * Runs fn once for each shard in [0, bgp_worker_pool_size()].
+ *
+ * The last shard is run on the calling pthread, all others on the workers.
+ * Returns once every shard has completed.  The caller must not touch
+ * anything fn may be reading until then, which is trivially satisfied by
+ * the main pthread since it is busy in here.
+ *
+ * @param pool - the pool to run on
+ * @param fn - work function, called with arg and the shard number
+ * @param arg - passed to fn
+ */
+extern void bgp_worker_pool_run(struct bgp_worker_pool *pool,
+				void (*fn)(void *arg, unsigned int shard),
+				void *arg);
+
+/**
+ * Whether a bgp_worker_pool_run() is in progress, i.e. whether other
+ * pthreads may be running the same code right now.  Caches shared between
+ * paths, which are normally only written by the main pthread, are left
+ * alone while this is true.
+ */
+extern bool bgp_worker_pool_busy(void);
+
+#endif /* _FRR_BGP_WORKER_POOL_H */
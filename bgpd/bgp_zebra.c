@@ -1453,16 +1453,18 @@ void bgp_zebra_announce(struct bgp_dest *dest, const struct prefix *p,
 	if (is_add && CHECK_FLAG(bm->flags, BM_FLAG_SEND_EXTRA_DATA_TO_ZEBRA)) {
 		struct bgp_zebra_opaque bzo = {};
 
-		strlcpy(bzo.aspath, info->attr->aspath->str,
+		strlcpy(bzo.aspath, aspath_print(info->attr->aspath),
 			sizeof(bzo.aspath));
 
 		if (info->attr->flag & ATTR_FLAG_BIT(BGP_ATTR_COMMUNITIES))
-			strlcpy(bzo.community, info->attr->community->str,
+			strlcpy(bzo.community,
+				community_str(info->attr->community, false),
 				sizeof(bzo.community));
 
 		if (info->attr->flag
 		    & ATTR_FLAG_BIT(BGP_ATTR_LARGE_COMMUNITIES))
-			strlcpy(bzo.lcommunity, info->attr->lcommunity->str,
+			strlcpy(bzo.lcommunity,
+				lcommunity_str(info->attr->lcommunity, false),
 				sizeof(bzo.lcommunity));
 
 		SET_FLAG(api.message, ZAPI_MESSAGE_OPAQUE);
@@ -1573,6 +1575,7 @@ void bgp_zebra_announce(struct bgp_dest *dest, const struct prefix *p,
 		zlog_debug("%s: %pFX: announcing to zebra (recursion %sset)",
 			   __func__, p, (recursion_flag ? "" : "NOT "));
 	}
+	conv_stage(bm->conv, bgp->vrf_id, &api.prefix, BGP_CONV_ZEBRA);
 	zclient_route_send(is_add ? ZEBRA_ROUTE_ADD : ZEBRA_ROUTE_DELETE,
 			   zclient, &api);
 }
@@ -1668,6 +1671,7 @@ void bgp_zebra_withdraw(const struct prefix *p, struct bgp_path_info *info,
 		zlog_debug("Tx route delete VRF %u %pFX", bgp->vrf_id,
 			   &api.prefix);
 
+	conv_stage(bm->conv, bgp->vrf_id, &api.prefix, BGP_CONV_ZEBRA);
 	zclient_route_send(ZEBRA_ROUTE_DELETE, zclient, &api);
 }
 
@@ -3045,9 +3049,8 @@ static void bgp_zebra_process_srv6_locator_chunk(ZAPI_CALLBACK_ARGS)
 	struct stream *s = NULL;
 	struct bgp *bgp = bgp_get_default();
 	struct listnode *node;
-	struct prefix_ipv6 *c;
+	struct bgp_srv6_locator_chunk *c;
 	struct srv6_locator_chunk s6c = {};
-	struct prefix_ipv6 *chunk = NULL;
 
 	s = zclient->ibuf;
 	zapi_srv6_locator_chunk_decode(s, &s6c);
@@ -3059,25 +3062,27 @@ static void bgp_zebra_process_srv6_locator_chunk(ZAPI_CALLBACK_ARGS)
 	}
 
 	for (ALL_LIST_ELEMENTS_RO(bgp->srv6_locator_chunks, node, c)) {
-		if (!prefix_cmp(c, &s6c.prefix))
+		if (!prefix_cmp(&c->prefix, &s6c.prefix))
 			return;
 	}
 
-	chunk = prefix_ipv6_new();
-	*chunk = s6c.prefix;
-	listnode_add(bgp->srv6_locator_chunks, chunk);
+	c = bgp_srv6_locator_chunk_new(&s6c.prefix);
+	listnode_add(bgp->srv6_locator_chunks, c);
 	vpn_leak_postchange_all();
 }
 
 void bgp_zebra_init(struct thread_master *master, unsigned short instance)
 {
+	struct zclient_options options = zclient_options_default;
+
 	zclient_num_connects = 0;
+	options.shm_ring = true;
 
 	if_zapi_callbacks(bgp_ifp_create, bgp_ifp_up,
 			  bgp_ifp_down, bgp_ifp_destroy);
 
 	/* Set default values. */
-	zclient = zclient_new(master, &zclient_options_default);
+	zclient = zclient_new(master, &options);
 	zclient_init(zclient, ZEBRA_ROUTE_BGP, 0, &bgpd_privs);
 	zclient->zebra_connected = bgp_zebra_connected;
 	zclient->router_id_update = bgp_router_id_update;
@@ -3115,10 +3120,64 @@ void bgp_zebra_init(struct thread_master *master, unsigned short instance)
 		bgp_zebra_process_srv6_locator_chunk;
 }
 
+/*
+ * Flowspec rules mostly differ by their ipset entries, which zebra takes
+ * many of in one message: the entries are collected here and sent together,
+ * once the current event is done or before any other PBR message so that
+ * zebra still sees them in order.
+ */
+#define BGP_PBR_ENTRY_ENCODED_MAX                                              \
+	(4 + ZEBRA_IPSET_NAME_SIZE + 2 * (2 + IPV6_MAX_BYTELEN) + 4 * 2 + 1)
+
+static struct {
+	struct stream *s;
+	uint16_t cmd;
+	uint32_t count;
+	struct thread *t_flush;
+} bgp_pbr_entry_batch;
+
+static void bgp_pbr_entry_batch_flush(void)
+{
+	struct stream *s;
+
+	THREAD_OFF(bgp_pbr_entry_batch.t_flush);
+
+	if (!bgp_pbr_entry_batch.count)
+		return;
+
+	s = zclient->obuf;
+	stream_reset(s);
+
+	zclient_create_header(s, bgp_pbr_entry_batch.cmd, VRF_DEFAULT);
+	stream_putl(s, bgp_pbr_entry_batch.count);
+	stream_put(s, STREAM_DATA(bgp_pbr_entry_batch.s),
+		   stream_get_endp(bgp_pbr_entry_batch.s));
+	stream_putw_at(s, 0, stream_get_endp(s));
+
+	if (BGP_DEBUG(zebra, ZEBRA))
+		zlog_debug("%s: %s %u entries", __func__,
+			   zserv_command_string(bgp_pbr_entry_batch.cmd),
+			   bgp_pbr_entry_batch.count);
+
+	zclient_send_message(zclient);
+
+	stream_reset(bgp_pbr_entry_batch.s);
+	bgp_pbr_entry_batch.count = 0;
+}
+
+static int bgp_pbr_entry_batch_timer(struct thread *t)
+{
+	bgp_pbr_entry_batch_flush();
+	return 0;
+}
+
 void bgp_zebra_destroy(void)
 {
 	if (zclient == NULL)
 		return;
+	bgp_pbr_entry_batch_flush();
+	stream_free(bgp_pbr_entry_batch.s);
+	bgp_pbr_entry_batch.s = NULL;
 	zclient_stop(zclient);
 	zclient_free(zclient);
 	zclient = NULL;
@@ -3139,6 +3198,7 @@ void bgp_send_pbr_rule_action(struct bgp_pbr_action *pbra,
 		return;
 	if (pbr && pbr->install_in_progress)
 		return;
+	bgp_pbr_entry_batch_flush();
 	if (BGP_DEBUG(zebra, ZEBRA)) {
 		if (pbr)
 			zlog_debug("%s: table %d (ip rule) %d", __func__,
@@ -3173,6 +3233,7 @@ void bgp_send_pbr_ipset_match(struct bgp_pbr_match *pbrim, bool install)
 
 	if (pbrim->install_in_progress)
 		return;
+	bgp_pbr_entry_batch_flush();
 	if (BGP_DEBUG(zebra, ZEBRA))
 		zlog_debug("%s: name %s type %d %d, ID %u", __func__,
 			   pbrim->ipset_name, pbrim->type, install,
@@ -3197,7 +3258,8 @@ void bgp_send_pbr_ipset_match(struct bgp_pbr_match *pbrim, bool install)
 void bgp_send_pbr_ipset_entry_match(struct bgp_pbr_match_entry *pbrime,
 				    bool install)
 {
-	struct stream *s;
+	uint16_t cmd = install ? ZEBRA_IPSET_ENTRY_ADD
+			       : ZEBRA_IPSET_ENTRY_DELETE;
 
 	if (pbrime->install_in_progress)
 		return;
@@ -3205,20 +3267,28 @@ void bgp_send_pbr_ipset_entry_match(struct bgp_pbr_match_entry *pbrime,
 		zlog_debug("%s: name %s %d %d, ID %u", __func__,
 			   pbrime->backpointer->ipset_name, pbrime->unique,
 			   install, pbrime->unique);
-	s = zclient->obuf;
-	stream_reset(s);
 
-	zclient_create_header(s,
-			      install ? ZEBRA_IPSET_ENTRY_ADD :
-			      ZEBRA_IPSET_ENTRY_DELETE,
-			      VRF_DEFAULT);
+	if (!bgp_pbr_entry_batch.s)
+		bgp_pbr_entry_batch.s = stream_new(ZEBRA_MAX_PACKET_SIZ);
 
-	stream_putl(s, 1); /* send one pbr action */
+	if (bgp_pbr_entry_batch.count
+	    && (bgp_pbr_entry_batch.cmd != cmd
+		|| STREAM_WRITEABLE(bgp_pbr_entry_batch.s)
+			   < ZEBRA_HEADER_SIZE + 4
+				     + BGP_PBR_ENTRY_ENCODED_MAX))
+		bgp_pbr_entry_batch_flush();
 
-	bgp_encode_pbr_ipset_entry_match(s, pbrime);
+	bgp_pbr_entry_batch.cmd = cmd;
+	bgp_encode_pbr_ipset_entry_match(bgp_pbr_entry_batch.s, pbrime);
+	bgp_pbr_entry_batch.count++;
 
-	stream_putw_at(s, 0, stream_get_endp(s));
-	if ((zclient_send_message(zclient) != ZCLIENT_SEND_FAILURE) && install)
+	thread_add_event(bm->master, bgp_pbr_entry_batch_timer, NULL, 0,
+			 &bgp_pbr_entry_batch.t_flush);
+
+	/* zebra reports the result through ipset_entry_notify_owner(), as if
+	 * it had been sent on its own
+	 */
+	if (install)
 		pbrime->install_in_progress = true;
 }
 
@@ -3273,6 +3343,7 @@ void bgp_send_pbr_iptable(struct bgp_pbr_action *pba,
 
 	if (pbm->install_iptable_in_progress)
 		return;
+	bgp_pbr_entry_batch_flush();
 	if (BGP_DEBUG(zebra, ZEBRA))
 		zlog_debug("%s: name %s type %d mark %d %d, ID %u", __func__,
 			   pbm->ipset_name, pbm->type, pba->fwmark, install,
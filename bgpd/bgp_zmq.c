@@ -0,0 +1,130 @@
+/*
+ * BGP best path change export over ZeroMQ
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+
+#include "command.h"
+#include "frr_zmq_pub.h"
+#include "libfrr.h"
+#include "lib/version.h"
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_attr.h"
+#include "bgpd/bgp_route.h"
+#include "bgpd/bgp_table.h"
+
+#define BGP_ZMQ_DEFAULT_ENDPOINT "tcp://127.0.0.1:5561"
+
+static struct frrzmq_pub *bgp_zmq_pub;
+
+static int bgp_zmq_route_update(struct bgp *bgp, afi_t afi, safi_t safi,
+				struct bgp_dest *bn,
+				struct bgp_path_info *old_route,
+				struct bgp_path_info *new_route)
+{
+	struct frrzmq_route_event ev = {};
+	const struct prefix *p = bgp_dest_get_prefix(bn);
+	struct attr *attr;
+
+	if (!bgp_zmq_pub)
+		return 0;
+
+	/* VPN, EVPN and flowspec prefixes don't fit the event */
+	if (safi != SAFI_UNICAST && safi != SAFI_MULTICAST
+	    && safi != SAFI_LABELED_UNICAST)
+		return 0;
+	if (p->family != AF_INET && p->family != AF_INET6)
+		return 0;
+
+	frrzmq_route_event_prefix(&ev, p);
+	ev.safi = safi;
+	ev.vrf_id = htonl(bgp->vrf_id);
+
+	if (!new_route) {
+		ev.op = FRRZMQ_ROUTE_DEL;
+		frrzmq_pub_add(bgp_zmq_pub, &ev, sizeof(ev));
+		return 0;
+	}
+
+	attr = new_route->attr;
+
+	ev.op = FRRZMQ_ROUTE_ADD;
+	ev.type = ZEBRA_ROUTE_BGP;
+	if (attr->flag & ATTR_FLAG_BIT(BGP_ATTR_MULTI_EXIT_DISC))
+		ev.metric = htonl(attr->med);
+
+	if (attr->mp_nexthop_len >= BGP_ATTR_NHLEN_IPV6_GLOBAL) {
+		ev.nh_afi = AFI_IP6;
+		memcpy(ev.nexthop, &attr->mp_nexthop_global,
+		       sizeof(attr->mp_nexthop_global));
+	} else if (afi == AFI_IP) {
+		ev.nh_afi = AFI_IP;
+		memcpy(ev.nexthop, &attr->nexthop, sizeof(attr->nexthop));
+	}
+
+	frrzmq_pub_add(bgp_zmq_pub, &ev, sizeof(ev));
+	return 0;
+}
+
+DEFUN (show_bgp_zmq_publisher,
+       show_bgp_zmq_publisher_cmd,
+       "show bgp zmq-publisher",
+       SHOW_STR
+       BGP_STR
+       "ZeroMQ best path change export\n")
+{
+	if (!bgp_zmq_pub) {
+		vty_out(vty, "ZeroMQ publisher is not running\n");
+		return CMD_SUCCESS;
+	}
+
+	frrzmq_pub_show(vty, bgp_zmq_pub);
+	return CMD_SUCCESS;
+}
+
+static int bgp_zmq_init(struct thread_master *master)
+{
+	const char *endpoint = THIS_MODULE->load_args;
+
+	if (!endpoint || !*endpoint)
+		endpoint = BGP_ZMQ_DEFAULT_ENDPOINT;
+
+	bgp_zmq_pub = frrzmq_pub_new(master, endpoint, FRRZMQ_SRC_BGP_BESTPATH);
+	install_element(VIEW_NODE, &show_bgp_zmq_publisher_cmd);
+	return 0;
+}
+
+static int bgp_zmq_fini(void)
+{
+	frrzmq_pub_free(&bgp_zmq_pub);
+	return 0;
+}
+
+static int bgp_zmq_module_init(void)
+{
+	hook_register(bgp_route_update, bgp_zmq_route_update);
+	hook_register(frr_late_init, bgp_zmq_init);
+	hook_register(frr_early_fini, bgp_zmq_fini);
+	return 0;
+}
+
+FRR_MODULE_SETUP(.name = "bgpd_zmq", .version = FRR_VERSION,
+		 .description = "bgpd best path change export over ZeroMQ",
+		 .init = bgp_zmq_module_init,
+);
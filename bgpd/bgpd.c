@@ -24,7 +24,6 @@
 #include "thread.h"
 #include "buffer.h"
 #include "stream.h"
-#include "ringbuf.h"
 #include "command.h"
 #include "sockunion.h"
 #include "sockopt.h"
@@ -84,6 +83,7 @@
 #include "bgpd/bgp_evpn_vty.h"
 #include "bgpd/bgp_keepalives.h"
 #include "bgpd/bgp_io.h"
+#include "bgpd/bgp_worker_pool.h"
 #include "bgpd/bgp_ecommunity.h"
 #include "bgpd/bgp_flowspec.h"
 #include "bgpd/bgp_labelpool.h"
@@ -1129,6 +1129,7 @@ static void peer_free(struct peer *peer)
 					     peer);
 
 	FOREACH_AFI_SAFI (afi, safi) {
+		bgp_peer_paths_fini(&peer->paths[afi][safi]);
 		if (peer->filter[afi][safi].advmap.aname)
 			XFREE(MTYPE_BGP_FILTER_NAME,
 			      peer->filter[afi][safi].advmap.aname);
@@ -1159,6 +1160,8 @@ static void peer_free(struct peer *peer)
 		work_queue_free_and_null(&peer->clear_node_queue);
 
 	bgp_sync_delete(peer);
+	bgp_rmap_memo_finish(peer);
+	bgp_update_attr_cache_free(peer);
 
 	XFREE(MTYPE_PEER_CONF_IF, peer->conf_if);
 
@@ -1167,7 +1170,8 @@ static void peer_free(struct peer *peer)
 		bgp_peer_remove_bfd_config(peer);
 
 	FOREACH_AFI_SAFI (afi, safi)
-		bgp_addpath_set_peer_type(peer, afi, safi, BGP_ADDPATH_NONE);
+		bgp_addpath_set_peer_type(peer, afi, safi, BGP_ADDPATH_NONE,
+					  0);
 
 	bgp_unlock(peer->bgp);
 
@@ -1329,6 +1333,8 @@ static void bgp_srv6_init(struct bgp *bgp)
 	bgp->srv6_enabled = false;
 	memset(bgp->srv6_locator_name, 0, sizeof(bgp->srv6_locator_name));
 	bgp->srv6_locator_chunks = list_new();
+	bgp->srv6_locator_chunks->del =
+		(void (*)(void *))bgp_srv6_locator_chunk_free;
 	bgp->srv6_functions = list_new();
 }
 
@@ -1368,6 +1374,7 @@ struct peer *peer_new(struct bgp *bgp)
 
 	/* Set default flags. */
 	FOREACH_AFI_SAFI (afi, safi) {
+		bgp_peer_paths_init(&peer->paths[afi][safi]);
 		SET_FLAG(peer->af_flags[afi][safi], PEER_FLAG_SEND_COMMUNITY);
 		SET_FLAG(peer->af_flags[afi][safi],
 			 PEER_FLAG_SEND_EXT_COMMUNITY);
@@ -1411,8 +1418,7 @@ struct peer *peer_new(struct bgp *bgp)
 	 */
 	peer->obuf_work =
 		stream_new(BGP_MAX_PACKET_SIZE + BGP_MAX_PACKET_SIZE_OVERFLOW);
-	peer->ibuf_work =
-		ringbuf_new(BGP_MAX_PACKET_SIZE * BGP_READ_PACKET_MAX);
+	peer->ibuf_work = stream_new(BGP_READ_CHUNK_SIZE);
 
 	peer->scratch = stream_new(BGP_MAX_PACKET_SIZE);
 
@@ -1487,6 +1493,8 @@ void peer_xfer_config(struct peer *peer_dst, struct peer *peer_src)
 		peer_dst->weight[afi][safi] = peer_src->weight[afi][safi];
 		peer_dst->addpath_type[afi][safi] =
 			peer_src->addpath_type[afi][safi];
+		peer_dst->addpath_best_selected[afi][safi] =
+			peer_src->addpath_best_selected[afi][safi];
 	}
 
 	for (afidx = BGP_AF_START; afidx < BGP_AF_MAX; afidx++) {
@@ -2108,6 +2116,8 @@ static void peer_group2peer_config_copy_af(struct peer_group *group,
 
 	if (peer->addpath_type[afi][safi] == BGP_ADDPATH_NONE) {
 		peer->addpath_type[afi][safi] = conf->addpath_type[afi][safi];
+		peer->addpath_best_selected[afi][safi] =
+			conf->addpath_best_selected[afi][safi];
 		bgp_addpath_type_changed(conf->bgp);
 	}
 }
@@ -2482,7 +2492,7 @@ int peer_delete(struct peer *peer)
 	}
 
 	if (peer->ibuf_work) {
-		ringbuf_del(peer->ibuf_work);
+		stream_free(peer->ibuf_work);
 		peer->ibuf_work = NULL;
 	}
 
@@ -3629,6 +3639,7 @@ int bgp_delete(struct bgp *bgp)
 		bgp_unlock(bgp); /* TODO - This timer is started with a lock -
 				    why? */
 	}
+	THREAD_OFF(bgp->t_update_build);
 
 	/* Inform peers we're going down. */
 	for (ALL_LIST_ELEMENTS(bgp->peer, node, next, peer)) {
@@ -3689,6 +3700,7 @@ int bgp_delete(struct bgp *bgp)
 	 * routes to be processed still referencing the struct bgp.
 	 */
 	listnode_delete(bm->bgp, bgp);
+	vpn_leak_import_changed();
 
 	/* Free interfaces in this instance. */
 	bgp_if_finish(bgp);
@@ -3725,6 +3737,8 @@ void bgp_free(struct bgp *bgp)
 
 	QOBJ_UNREG(bgp);
 
+	THREAD_OFF(bgp->t_rd_table_sweep);
+
 	list_delete(&bgp->group);
 	list_delete(&bgp->peer);
 
@@ -6965,7 +6979,7 @@ static void peer_advertise_map_filter_update(struct peer *peer, afi_t afi,
 	filter->advmap.cmap = cmap;
 	filter->advmap.condition = condition;
 	route_map_counter_increment(filter->advmap.amap);
-	peer->advmap_config_change[afi][safi] = true;
+	bgp_conditional_adv_config_change(peer, afi, safi);
 
 	/* Increment condition_filter_count and/or create timer. */
 	if (!filter_exists) {
@@ -7589,11 +7603,34 @@ char *peer_uptime(time_t uptime2, char *buf, size_t len, bool use_json,
 	return buf;
 }
 
+/* enum bgp_conv_stage */
+static const char *const bgp_conv_stages[] = {
+	"receive",
+	"update",
+	"best-path",
+	"zebra",
+};
+
 void bgp_master_init(struct thread_master *master, const int buffer_size,
 		     struct list *addresses)
 {
 	qobj_init();
 
+	/* one or more of each of these per prefix and peer, keep them out of
+	 * the general purpose allocator; the ones best-path walks over go on
+	 * huge pages with --hugepages
+	 */
+	mtype_slab_enable(MTYPE_BGP_NODE, sizeof(struct bgp_node));
+	mtype_slab_enable(MTYPE_BGP_ROUTE, sizeof(struct bgp_path_info));
+	mtype_slab_enable(MTYPE_BGP_ROUTE_EXTRA,
+			  sizeof(struct bgp_path_info_extra));
+	mtype_slab_enable(MTYPE_BGP_ADJ_IN, sizeof(struct bgp_adj_in));
+	mtype_slab_enable(MTYPE_ATTR, sizeof(struct attr));
+	mtype_slab_hugepages(MTYPE_BGP_NODE);
+	mtype_slab_hugepages(MTYPE_BGP_ROUTE);
+	mtype_slab_hugepages(MTYPE_BGP_ROUTE_EXTRA);
+	mtype_slab_hugepages(MTYPE_ATTR);
+
 	memset(&bgp_master, 0, sizeof(struct bgp_master));
 
 	bm = &bgp_master;
@@ -7624,6 +7661,9 @@ void bgp_master_init(struct thread_master *master, const int buffer_size,
 	/* mpls label dynamic allocation pool */
 	bgp_lp_init(bm->master, &bm->labelpool);
 
+	bm->conv = conv_sampler_new("bgp", bgp_conv_stages,
+				    array_size(bgp_conv_stages));
+
 	bgp_l3nhg_init();
 	bgp_evpn_mh_init();
 	QOBJ_REG(bm, bgp_master);
@@ -7729,6 +7769,9 @@ void bgp_pthreads_run(void)
 
 void bgp_pthreads_finish(void)
 {
+	bgp_worker_pool_set(bgp_bestpath_pool, 0);
+	bgp_worker_pool_set(bgp_update_pool, 0);
+	bgp_worker_pool_set(bgp_soft_reconfig_pool, 0);
 	frr_pthread_stop_all();
 }
 
@@ -48,6 +48,7 @@
 #include "bgp_io.h"
 
 #include "lib/bfd.h"
+#include "lib/convergence.h"
 
 #define BGP_MAX_HOSTNAME 64	/* Linux max, is larger than most other sys */
 #define BGP_PEER_MAX_HASH_SIZE 16384
@@ -174,6 +175,9 @@ struct bgp_master {
 	uint16_t v_update_delay;
 	uint16_t v_establish_wait;
 
+	/* "bgp convergence-sampling", stages are enum bgp_conv_stage */
+	struct conv_sampler *conv;
+
 	uint32_t flags;
 #define BM_FLAG_GRACEFUL_SHUTDOWN        (1 << 0)
 #define BM_FLAG_SEND_EXTRA_DATA_TO_ZEBRA (1 << 1)
@@ -183,6 +187,14 @@ struct bgp_master {
 };
 DECLARE_QOBJ_TYPE(bgp_master);
 
+/* Convergence sampling stages, see lib/convergence.h */
+enum bgp_conv_stage {
+	BGP_CONV_RECEIVE = 0,
+	BGP_CONV_UPDATE,
+	BGP_CONV_BESTPATH,
+	BGP_CONV_ZEBRA,
+};
+
 /* BGP route-map structure.  */
 struct bgp_rmap {
 	char *name;
@@ -336,6 +348,16 @@ struct bgp_srv6_function {
 	char locator_name[SRV6_LOCNAME_SIZE];
 };
 
+/* Number of SIDs, hence function bits, a locator chunk can hand out */
+#define BGP_SRV6_CHUNK_FUNCTIONS 0x10000
+
+struct bgp_srv6_locator_chunk {
+	struct prefix_ipv6 prefix;
+
+	/* SIDs in use out of this chunk, indexed by their function bits */
+	bitfield_t functions;
+};
+
 /* BGP instance structure.  */
 struct bgp {
 	/* AS number of this BGP instance.  */
@@ -382,6 +404,7 @@ struct bgp {
 		uint32_t peer_refreshes_combined;
 		uint32_t adj_count;
 		uint32_t merge_checks_triggered;
+		uint32_t announce_inherits;
 
 		uint32_t updgrps_created;
 		uint32_t updgrps_deleted;
@@ -493,6 +516,7 @@ struct bgp {
 #define BGP_FLAG_SHUTDOWN (1 << 25)
 #define BGP_FLAG_SUPPRESS_FIB_PENDING (1 << 26)
 #define BGP_FLAG_SUPPRESS_DUPLICATES (1 << 27)
+#define BGP_FLAG_LAZY_NHT (1 << 28)
 #define BGP_FLAG_PEERTYPE_MULTIPATH_RELAX (1 << 29)
 
 	/* BGP default address-families.
@@ -586,6 +610,12 @@ struct bgp {
 	struct thread *t_rmap_def_originate_eval;
 #define RMAP_DEFAULT_ORIGINATE_EVAL_TIMER 5
 
+	/* event to build UPDATEs for all subgroups on the worker pthreads */
+	struct thread *t_update_build;
+
+	/* event to free the emptied route distinguisher tables of the rib */
+	struct thread *t_rd_table_sweep;
+
 	/* BGP distance configuration.  */
 	uint8_t distance_ebgp[AFI_MAX][SAFI_MAX];
 	uint8_t distance_ibgp[AFI_MAX][SAFI_MAX];
@@ -736,6 +766,10 @@ struct bgp {
 
 	struct vpn_policy vpn_policy[AFI_MAX];
 
+	/* Scratch for vpn_import_vrfs() */
+	uint32_t vpn_import_mark;
+	struct bgp *vpn_import_next;
+
 	struct bgp_pbr_config *bgp_pbr_cfg;
 
 	/* Count of peers in established state */
@@ -751,6 +785,7 @@ struct bgp {
 	uint32_t condition_check_period;
 	uint32_t condition_filter_count;
 	struct thread *t_condition_check;
+	time_t condition_check_last;
 
 	/* BGP route flap dampening configuration */
 	struct bgp_damp_config damp[AFI_MAX][SAFI_MAX];
@@ -1050,6 +1085,9 @@ enum bgp_fsm_status {
 
 #define PEER_HOSTNAME(peer) ((peer)->host ? (peer)->host : "(unknown peer)")
 
+/* struct bgp_path_info's in the peer's RIB, see bgp_peer_paths_head() */
+PREDECL_DLIST(bgp_peer_paths);
+
 /* BGP neighbor structure. */
 struct peer {
 	/* BGP structure.  */
@@ -1092,10 +1130,7 @@ struct peer {
 	struct stream_fifo *ibuf; // packets waiting to be processed
 	struct stream_fifo *obuf; // packets waiting to be written
 
-	/* used as a block to deposit raw wire data to */
-	uint8_t ibuf_scratch[BGP_EXTENDED_MESSAGE_MAX_PACKET_SIZE
-			     * BGP_READ_PACKET_MAX];
-	struct ringbuf *ibuf_work; // WiP buffer used by bgp_read() only
+	struct stream *ibuf_work; // WiP buffer used by bgp_read() only
 	struct stream *obuf_work;  // WiP buffer used to construct packets
 
 	struct stream *curr; // the current packet being parsed
@@ -1309,6 +1344,8 @@ struct peer {
 
 	/* NSF mode (graceful restart) */
 	uint8_t nsf[AFI_MAX][SAFI_MAX];
+	/* Stale paths restored from a RIB snapshot, until End-of-RIB */
+	uint8_t rib_restored[AFI_MAX][SAFI_MAX];
 	/* EOR Send time */
 	time_t eor_stime[AFI_MAX][SAFI_MAX];
 	/* Last update packet sent time */
@@ -1358,6 +1395,8 @@ struct peer {
 
 
 	enum bgp_addpath_strat addpath_type[AFI_MAX][SAFI_MAX];
+	/* Paths sent with addpath-tx-best-selected */
+	uint8_t addpath_best_selected[AFI_MAX][SAFI_MAX];
 
 	/* MD5 password */
 	char *password;
@@ -1539,9 +1578,23 @@ struct peer {
 	/* Track if we printed the attribute in debugs */
 	int rcvd_attr_printed;
 
+	/* Last attribute block received and what it was parsed into, see
+	 * bgp_update_attr_replay()
+	 */
+	uint8_t *rx_attr_raw;
+	size_t rx_attr_size;
+	bgp_size_t rx_attr_len;
+	struct attr *rx_attr;
+	uint64_t rx_attr_batch;
+
 	/* Accepted prefix count */
 	uint32_t pcount[AFI_MAX][SAFI_MAX];
 
+	/* All paths from this peer in bgp->rib, so clearing the peer doesn't
+	 * need to walk the whole table.
+	 */
+	struct bgp_peer_paths_head paths[AFI_MAX][SAFI_MAX];
+
 	/* Max prefix count. */
 	uint32_t pmax[AFI_MAX][SAFI_MAX];
 	uint8_t pmax_threshold[AFI_MAX][SAFI_MAX];
@@ -1612,6 +1665,10 @@ struct peer {
 #define PEER_RMAP_TYPE_EXPORT         (1U << 7) /* neighbor route-map export */
 #define PEER_RMAP_TYPE_AGGREGATE      (1U << 8) /* aggregate-address route-map */
 
+	/* Memoized inbound route-map results, see bgp_rmap_memo_apply() */
+	struct hash *rmap_memo;
+	uint64_t rmap_memo_gen;
+
 	/** Peer overwrite configuration. */
 	struct bfd_session_config {
 		/**
@@ -28,7 +28,6 @@
 #include "lib/linklist.h"
 #include "lib/command.h"
 #include "lib/stream.h"
-#include "lib/ringbuf.h"
 #include "lib/lib_errors.h"
 
 #include "bgpd/bgpd.h"
@@ -1267,7 +1266,7 @@ static int rfapi_open_inner(struct rfapi_descriptor *rfd, struct bgp *bgp,
 			stream_fifo_free(rfd->peer->obuf);
 
 		if (rfd->peer->ibuf_work)
-			ringbuf_del(rfd->peer->ibuf_work);
+			stream_free(rfd->peer->ibuf_work);
 		if (rfd->peer->obuf_work)
 			stream_free(rfd->peer->obuf_work);
 
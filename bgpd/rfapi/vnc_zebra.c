@@ -30,7 +30,6 @@
 #include "lib/command.h"
 #include "lib/zclient.h"
 #include "lib/stream.h"
-#include "lib/ringbuf.h"
 #include "lib/memory.h"
 #include "lib/lib_errors.h"
 
@@ -201,7 +200,7 @@ static void vnc_redistribute_add(struct prefix *p, uint32_t metric,
 					stream_fifo_free(vncHD1VR.peer->obuf);
 
 				if (vncHD1VR.peer->ibuf_work)
-					ringbuf_del(vncHD1VR.peer->ibuf_work);
+					stream_free(vncHD1VR.peer->ibuf_work);
 				if (vncHD1VR.peer->obuf_work)
 					stream_free(vncHD1VR.peer->obuf_work);
 
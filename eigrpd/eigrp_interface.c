@@ -450,6 +450,9 @@ void eigrp_if_free(struct eigrp_interface *ei, int source)
 
 	eigrp_if_down(ei);
 
+	if (eigrp->changes_exception == ei)
+		eigrp->changes_exception = NULL;
+
 	listnode_delete(ei->eigrp->eiflist, ei);
 }
 
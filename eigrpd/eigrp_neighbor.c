@@ -66,6 +66,8 @@ struct eigrp_neighbor *eigrp_nbr_new(struct eigrp_interface *ei)
 	/* Relate neighbor to the interface. */
 	nbr->ei = ei;
 
+	eigrp_nbr_routes_init(&nbr->routes);
+
 	/* Set default values. */
 	eigrp_nbr_state_set(nbr, EIGRP_NEIGHBOR_DOWN);
 
@@ -186,6 +188,9 @@ void eigrp_nbr_delete(struct eigrp_neighbor *nbr)
 
 	if (nbr->ei)
 		listnode_delete(nbr->ei->nbrs, nbr);
+
+	eigrp_topology_neighbor_unlink(nbr);
+	eigrp_nbr_routes_fini(&nbr->routes);
 	XFREE(MTYPE_EIGRP_NEIGHBOR, nbr);
 }
 
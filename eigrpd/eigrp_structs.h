@@ -33,6 +33,7 @@
 #define _ZEBRA_EIGRP_STRUCTS_H_
 
 #include "filter.h"
+#include "typesafe.h"
 
 #include "eigrpd/eigrp_const.h"
 #include "eigrpd/eigrp_macros.h"
@@ -89,6 +90,10 @@ struct eigrp {
 	struct thread *t_write;
 	struct thread *t_read;
 	struct thread *t_distribute; /* timer for distribute list */
+	struct thread *t_changes; /* deferred queries and updates */
+
+	/* Interface not to send the deferred updates to */
+	struct eigrp_interface *changes_exception;
 
 	struct route_table *networks; /* EIGRP config networks. */
 
@@ -222,6 +227,8 @@ enum Packet_part_type {
 };
 
 /* Neighbor Data Structure */
+PREDECL_DLIST(eigrp_nbr_routes);
+
 struct eigrp_neighbor {
 	/* This neighbor's parent eigrp interface. */
 	struct eigrp_interface *ei;
@@ -270,6 +277,9 @@ struct eigrp_neighbor {
 	struct list *nbr_gr_prefixes_send;
 	/* if packet is first or last during Graceful restart */
 	enum Packet_part_type nbr_gr_packet_type;
+
+	/* route descriptors advertised by this neighbor */
+	struct eigrp_nbr_routes_head routes;
 };
 
 //---------------------------------------------------------------------------------------------------------------------------------------------
@@ -484,8 +494,13 @@ struct eigrp_route_descriptor {
 	uint8_t flags;			   // used for marking successor and FS
 
 	struct eigrp_interface *ei; // pointer for case of connected entry
+
+	/* item in the adv_router's list of routes */
+	struct eigrp_nbr_routes_item nbr_item;
 };
 
+DECLARE_DLIST(eigrp_nbr_routes, struct eigrp_route_descriptor, nbr_item);
+
 //---------------------------------------------------------------------------------------------------------------------------------------------
 typedef enum {
 	EIGRP_CONNECTED,
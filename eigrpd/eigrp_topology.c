@@ -102,6 +102,43 @@ static int eigrp_route_descriptor_cmp(struct eigrp_route_descriptor *entry1,
 	return 0;
 }
 
+/*
+ * Keep the entry in its advertising neighbor's list of routes, so that the
+ * neighbor's prefixes can be found without walking the topology table
+ */
+static void
+eigrp_route_descriptor_nbr_link(struct eigrp_route_descriptor *entry)
+{
+	if (!entry->adv_router
+	    || CHECK_FLAG(entry->flags, EIGRP_ROUTE_DESCRIPTOR_NBR_LINKED_FLAG))
+		return;
+
+	eigrp_nbr_routes_add_tail(&entry->adv_router->routes, entry);
+	SET_FLAG(entry->flags, EIGRP_ROUTE_DESCRIPTOR_NBR_LINKED_FLAG);
+}
+
+static void
+eigrp_route_descriptor_nbr_unlink(struct eigrp_route_descriptor *entry)
+{
+	if (!CHECK_FLAG(entry->flags, EIGRP_ROUTE_DESCRIPTOR_NBR_LINKED_FLAG))
+		return;
+
+	eigrp_nbr_routes_del(&entry->adv_router->routes, entry);
+	UNSET_FLAG(entry->flags, EIGRP_ROUTE_DESCRIPTOR_NBR_LINKED_FLAG);
+}
+
+/*
+ * Detach the route descriptors still pointing to a neighbor being freed
+ */
+void eigrp_topology_neighbor_unlink(struct eigrp_neighbor *nbr)
+{
+	struct eigrp_route_descriptor *entry;
+
+	while ((entry = eigrp_nbr_routes_pop(&nbr->routes)))
+		UNSET_FLAG(entry->flags,
+			   EIGRP_ROUTE_DESCRIPTOR_NBR_LINKED_FLAG);
+}
+
 /*
  * Returns new topology entry
  */
@@ -161,6 +198,7 @@ void eigrp_route_descriptor_add(struct eigrp *eigrp,
 	if (listnode_lookup(node->entries, entry) == NULL) {
 		listnode_add_sort(node->entries, entry);
 		entry->prefix = node;
+		eigrp_route_descriptor_nbr_link(entry);
 
 		eigrp_zebra_route_add(eigrp, node->destination,
 				      l, node->fdistance);
@@ -215,6 +253,7 @@ void eigrp_route_descriptor_delete(struct eigrp *eigrp,
 {
 	if (listnode_lookup(node->entries, entry) != NULL) {
 		listnode_delete(node->entries, entry);
+		eigrp_route_descriptor_nbr_unlink(entry);
 		eigrp_zebra_route_delete(eigrp, node->destination);
 		XFREE(MTYPE_EIGRP_ROUTE_DESCRIPTOR, entry);
 	}
@@ -324,27 +363,14 @@ eigrp_route_descriptor_lookup(struct list *entries, struct eigrp_neighbor *nbr)
 struct list *eigrp_neighbor_prefixes_lookup(struct eigrp *eigrp,
 					    struct eigrp_neighbor *nbr)
 {
-	struct listnode *node2, *node22;
 	struct eigrp_route_descriptor *entry;
-	struct eigrp_prefix_descriptor *pe;
-	struct route_node *rn;
 
 	/* create new empty list for prefixes storage */
 	struct list *prefixes = list_new();
 
-	/* iterate over all prefixes in topology table */
-	for (rn = route_top(eigrp->topology_table); rn; rn = route_next(rn)) {
-		if (!rn->info)
-			continue;
-		pe = rn->info;
-		/* iterate over all neighbor entry in prefix */
-		for (ALL_LIST_ELEMENTS(pe->entries, node2, node22, entry)) {
-			/* if entry is from specified neighbor, add to list */
-			if (entry->adv_router == nbr) {
-				listnode_add(prefixes, pe);
-			}
-		}
-	}
+	/* iterate over the entries advertised by the neighbor */
+	frr_each (eigrp_nbr_routes, &nbr->routes, entry)
+		listnode_add(prefixes, entry->prefix);
 
 	/* return list of prefixes from specified neighbor */
 	return prefixes;
@@ -413,6 +439,7 @@ distance_done:
 	 */
 	listnode_delete(prefix->entries, entry);
 	listnode_add_sort(prefix->entries, entry);
+	eigrp_route_descriptor_nbr_link(entry);
 
 	return change;
 }
@@ -493,37 +520,51 @@ void eigrp_update_routing_table(struct eigrp *eigrp,
 void eigrp_topology_neighbor_down(struct eigrp *eigrp,
 				  struct eigrp_neighbor *nbr)
 {
-	struct listnode *node2, *node22;
-	struct eigrp_prefix_descriptor *pe;
 	struct eigrp_route_descriptor *entry;
-	struct route_node *rn;
 
-	for (rn = route_top(eigrp->topology_table); rn; rn = route_next(rn)) {
-		pe = rn->info;
+	frr_each_safe (eigrp_nbr_routes, &nbr->routes, entry) {
+		struct eigrp_fsm_action_message msg;
+
+		memset(&msg, 0, sizeof(msg));
+		msg.metrics.delay = EIGRP_MAX_METRIC;
+		msg.packet_type = EIGRP_OPC_UPDATE;
+		msg.eigrp = eigrp;
+		msg.data_type = EIGRP_INT;
+		msg.adv_router = nbr;
+		msg.entry = entry;
+		msg.prefix = entry->prefix;
+		eigrp_fsm_event(&msg);
+	}
 
-		if (!pe)
-			continue;
+	eigrp_topology_changes_send(eigrp, nbr->ei);
+}
 
-		for (ALL_LIST_ELEMENTS(pe->entries, node2, node22, entry)) {
-			struct eigrp_fsm_action_message msg;
-
-			if (entry->adv_router != nbr)
-				continue;
-
-			memset(&msg, 0, sizeof(msg));
-			msg.metrics.delay = EIGRP_MAX_METRIC;
-			msg.packet_type = EIGRP_OPC_UPDATE;
-			msg.eigrp = eigrp;
-			msg.data_type = EIGRP_INT;
-			msg.adv_router = nbr;
-			msg.entry = entry;
-			msg.prefix = pe;
-			eigrp_fsm_event(&msg);
-		}
-	}
+static int eigrp_topology_changes_flush(struct thread *t)
+{
+	struct eigrp *eigrp = THREAD_ARG(t);
 
 	eigrp_query_send_all(eigrp);
-	eigrp_update_send_all(eigrp, nbr->ei);
+	eigrp_update_send_all(eigrp, eigrp->changes_exception);
+	eigrp->changes_exception = NULL;
+
+	return 0;
+}
+
+/*
+ * Send the queries and updates for the topology changes once the current
+ * event is done, so that all the prefixes lost with several neighbors (an
+ * interface going down, say) are packed into the same packets.
+ */
+void eigrp_topology_changes_send(struct eigrp *eigrp,
+				 struct eigrp_interface *exception)
+{
+	if (!eigrp->t_changes)
+		eigrp->changes_exception = exception;
+	else if (eigrp->changes_exception != exception)
+		eigrp->changes_exception = NULL;
+
+	thread_add_event(master, eigrp_topology_changes_flush, eigrp, 0,
+			 &eigrp->t_changes);
 }
 
 void eigrp_update_topology_table_prefix(struct eigrp *eigrp,
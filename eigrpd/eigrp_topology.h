@@ -77,6 +77,9 @@ extern void eigrp_update_routing_table(struct eigrp *eigrp,
 				       struct eigrp_prefix_descriptor *pe);
 extern void eigrp_topology_neighbor_down(struct eigrp *eigrp,
 					 struct eigrp_neighbor *neigh);
+extern void eigrp_topology_neighbor_unlink(struct eigrp_neighbor *neigh);
+extern void eigrp_topology_changes_send(struct eigrp *eigrp,
+					struct eigrp_interface *exception);
 extern void
 eigrp_update_topology_table_prefix(struct eigrp *eigrp,
 				   struct route_table *table,
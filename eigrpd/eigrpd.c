@@ -275,6 +275,7 @@ void eigrp_finish_final(struct eigrp *eigrp)
 		eigrp_if_free(ei, INTERFACE_DOWN_BY_FINAL);
 	}
 
+	THREAD_OFF(eigrp->t_changes);
 	THREAD_OFF(eigrp->t_write);
 	THREAD_OFF(eigrp->t_read);
 	close(eigrp->fd);
@@ -1033,6 +1033,23 @@ void isis_circuit_print_vty(struct isis_circuit *circuit, struct vty *vty,
 				vty_out(vty, "\n");
 			}
 		}
+		if (circuit->tx_queue) {
+			const struct isis_tx_queue_stats *stats;
+
+			stats = isis_tx_queue_stats(circuit->tx_queue);
+			vty_out(vty,
+				"    LSPs queued: %lu, sent: %" PRIu64
+				", retransmitted: %" PRIu64 "\n",
+				isis_tx_queue_len(circuit->tx_queue),
+				stats->lsps_sent, stats->lsps_rxmt);
+			vty_out(vty,
+				"    LSP queueing delay: avg %" PRIu64
+				" usec, max %" PRIu64 " usec\n",
+				stats->delay_count
+					? stats->delay_total / stats->delay_count
+					: 0,
+				stats->delay_max);
+		}
 		if (circuit->ip_addrs && listcount(circuit->ip_addrs) > 0) {
 			vty_out(vty, "    IP Prefix(es):\n");
 			for (ALL_LIST_ELEMENTS_RO(circuit->ip_addrs, node,
@@ -115,6 +115,8 @@ struct isis_circuit {
 	int pad_hellos;     /* add padding to Hello PDUs ? */
 	char ext_domain;    /* externalDomain   (boolean) */
 	int lsp_regenerate_pending[ISIS_LEVELS];
+	/* SSN flags may be set for this circuit, see lsp_set_ssn() */
+	bool psnp_pending[ISIS_LEVELS];
 	uint64_t lsp_error_counter;
 
 	/*
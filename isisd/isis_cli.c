@@ -984,6 +984,52 @@ void cli_show_isis_lsp_mtu(struct vty *vty, struct lyd_node *dnode,
 	vty_out(vty, " lsp-mtu %s\n", yang_dnode_get_string(dnode, NULL));
 }
 
+/*
+ * XPath: /frr-isisd:isis/instance/lsp/flooding
+ */
+DEFPY_YANG(area_lsp_flood_rate, area_lsp_flood_rate_cmd,
+      "lsp-flood-rate (1-65535)$rate [burst (1-65535)$burst]",
+      "Pace the LSPs sent on each circuit\n"
+      "LSPs per second\n"
+      "LSPs sent back to back after an idle period\n"
+      "Number of LSPs\n")
+{
+	nb_cli_enqueue_change(vty, "./lsp/flooding/rate", NB_OP_MODIFY,
+			      rate_str);
+	nb_cli_enqueue_change(vty, "./lsp/flooding/burst", NB_OP_MODIFY,
+			      burst_str);
+
+	return nb_cli_apply_changes(vty, NULL);
+}
+
+DEFPY_YANG(no_area_lsp_flood_rate, no_area_lsp_flood_rate_cmd,
+      "no lsp-flood-rate [(1-65535) [burst (1-65535)]]",
+      NO_STR
+      "Pace the LSPs sent on each circuit\n"
+      "LSPs per second\n"
+      "LSPs sent back to back after an idle period\n"
+      "Number of LSPs\n")
+{
+	nb_cli_enqueue_change(vty, "./lsp/flooding/rate", NB_OP_MODIFY, NULL);
+	nb_cli_enqueue_change(vty, "./lsp/flooding/burst", NB_OP_MODIFY, NULL);
+
+	return nb_cli_apply_changes(vty, NULL);
+}
+
+void cli_show_isis_lsp_flooding(struct vty *vty, struct lyd_node *dnode,
+				bool show_defaults)
+{
+	if (!yang_dnode_get_uint16(dnode, "./rate"))
+		return;
+
+	vty_out(vty, " lsp-flood-rate %s",
+		yang_dnode_get_string(dnode, "./rate"));
+	if (!yang_dnode_is_default(dnode, "./burst"))
+		vty_out(vty, " burst %s",
+			yang_dnode_get_string(dnode, "./burst"));
+	vty_out(vty, "\n");
+}
+
 /*
  * XPath: /frr-isisd:isis/instance/spf/minimum-interval
  */
@@ -1150,6 +1196,36 @@ void cli_show_isis_spf_prefix_priority(struct vty *vty, struct lyd_node *dnode,
 		yang_dnode_get_string(dnode, NULL));
 }
 
+/*
+ * XPath: /frr-isisd:isis/instance/spf/threads
+ */
+DEFPY_YANG(spf_threads, spf_threads_cmd, "spf threads (1-64)$threads",
+      "SPF configuration\n"
+      "Run the Fast Re-Route SPFs on worker threads\n"
+      "Number of worker threads\n")
+{
+	nb_cli_enqueue_change(vty, "./spf/threads", NB_OP_MODIFY, threads_str);
+
+	return nb_cli_apply_changes(vty, NULL);
+}
+
+DEFPY_YANG(no_spf_threads, no_spf_threads_cmd, "no spf threads [(1-64)]",
+      NO_STR
+      "SPF configuration\n"
+      "Run the Fast Re-Route SPFs on worker threads\n"
+      "Number of worker threads\n")
+{
+	nb_cli_enqueue_change(vty, "./spf/threads", NB_OP_MODIFY, NULL);
+
+	return nb_cli_apply_changes(vty, NULL);
+}
+
+void cli_show_isis_spf_threads(struct vty *vty, struct lyd_node *dnode,
+			       bool show_defaults)
+{
+	vty_out(vty, " spf threads %s\n", yang_dnode_get_string(dnode, NULL));
+}
+
 /*
  * XPath: /frr-isisd:isis/instance/purge-originator
  */
@@ -1170,6 +1246,27 @@ void cli_show_isis_purge_origin(struct vty *vty, struct lyd_node *dnode,
 	vty_out(vty, " purge-originator\n");
 }
 
+/*
+ * XPath: /frr-isisd:isis/instance/dynamic-flooding
+ */
+DEFPY_YANG(area_dynamic_flooding, area_dynamic_flooding_cmd,
+      "[no] dynamic-flooding",
+      NO_STR "Flood along a flooding topology computed from the LSPDB\n")
+{
+	nb_cli_enqueue_change(vty, "./dynamic-flooding", NB_OP_MODIFY,
+			      no ? "false" : "true");
+
+	return nb_cli_apply_changes(vty, NULL);
+}
+
+void cli_show_isis_dynamic_flooding(struct vty *vty, struct lyd_node *dnode,
+				    bool show_defaults)
+{
+	if (!yang_dnode_get_bool(dnode, NULL))
+		vty_out(vty, " no");
+	vty_out(vty, " dynamic-flooding\n");
+}
+
 /*
  * XPath: /frr-isisd:isis/instance/mpls-te
  */
@@ -3207,15 +3304,20 @@ void isis_cli_init(void)
 	install_element(ISIS_NODE, &no_lsp_timers_cmd);
 	install_element(ISIS_NODE, &area_lsp_mtu_cmd);
 	install_element(ISIS_NODE, &no_area_lsp_mtu_cmd);
+	install_element(ISIS_NODE, &area_lsp_flood_rate_cmd);
+	install_element(ISIS_NODE, &no_area_lsp_flood_rate_cmd);
 
 	install_element(ISIS_NODE, &spf_interval_cmd);
 	install_element(ISIS_NODE, &no_spf_interval_cmd);
 	install_element(ISIS_NODE, &spf_prefix_priority_cmd);
 	install_element(ISIS_NODE, &no_spf_prefix_priority_cmd);
+	install_element(ISIS_NODE, &spf_threads_cmd);
+	install_element(ISIS_NODE, &no_spf_threads_cmd);
 	install_element(ISIS_NODE, &spf_delay_ietf_cmd);
 	install_element(ISIS_NODE, &no_spf_delay_ietf_cmd);
 
 	install_element(ISIS_NODE, &area_purge_originator_cmd);
+	install_element(ISIS_NODE, &area_dynamic_flooding_cmd);
 
 	install_element(ISIS_NODE, &isis_mpls_te_on_cmd);
 	install_element(ISIS_NODE, &no_isis_mpls_te_on_cmd);
@@ -0,0 +1,405 @@
+/*
+ * IS-IS dynamic flooding topology.
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+
+#include "linklist.h"
+#include "memory.h"
+#include "vty.h"
+
+#include "isisd/isisd.h"
+#include "isisd/isis_adjacency.h"
+#include "isisd/isis_circuit.h"
+#include "isisd/isis_lsp.h"
+#include "isisd/isis_misc.h"
+#include "isisd/isis_mt.h"
+#include "isisd/isis_tx_queue.h"
+#include "isisd/isis_flood_topo.h"
+
+DEFINE_MTYPE_STATIC(ISISD, ISIS_FLOOD_TOPO, "ISIS flooding topology");
+DEFINE_MTYPE_STATIC(ISISD, ISIS_FLOOD_GRAPH, "ISIS flooding graph");
+
+/* what a level's computation leaves behind, system IDs sorted */
+struct isis_flood_topo {
+	/* our neighbors on the flooding topology */
+	uint8_t (*ft_nbrs)[ISIS_SYS_ID_LEN];
+	size_t ft_count;
+	/* all neighbors with a two-way adjacency in the LSPDB */
+	uint8_t (*nbrs)[ISIS_SYS_ID_LEN];
+	size_t nbr_count;
+};
+
+struct flood_edge {
+	uint32_t from, to;
+};
+
+/* the LSPDB as a graph of routers and pseudonodes */
+struct flood_graph {
+	uint8_t (*ids)[ISIS_SYS_ID_LEN + 1];
+	uint32_t count;
+
+	/* collected while going through the LSPs */
+	struct flood_edge *edges;
+	size_t edge_count, edge_size;
+	uint32_t cur;
+
+	/* two-way links, as adjacency arrays: the links of node n are
+	 * link[first[n]] up to link[first[n + 1]]
+	 */
+	uint32_t *first;
+	uint32_t *link_to;
+	uint32_t *link_id;
+	bool *on_ft;
+	uint32_t *ft_degree;
+};
+
+static int flood_id_cmp(const void *a, const void *b)
+{
+	return memcmp(a, b, ISIS_SYS_ID_LEN + 1);
+}
+
+static int flood_edge_cmp(const void *a, const void *b)
+{
+	const struct flood_edge *ea = a, *eb = b;
+
+	if (ea->from != eb->from)
+		return ea->from < eb->from ? -1 : 1;
+	if (ea->to != eb->to)
+		return ea->to < eb->to ? -1 : 1;
+	return 0;
+}
+
+static int flood_edge_add(const uint8_t *id, uint32_t metric, bool oldmetric,
+			  struct isis_ext_subtlvs *subtlvs, void *arg)
+{
+	struct flood_graph *g = arg;
+	uint8_t (*found)[ISIS_SYS_ID_LEN + 1];
+
+	found = bsearch(id, g->ids, g->count, sizeof(*g->ids), flood_id_cmp);
+	if (!found || (uint32_t)(found - g->ids) == g->cur)
+		return LSP_ITER_CONTINUE;
+
+	if (g->edge_count == g->edge_size) {
+		g->edge_size = MAX(64, g->edge_size * 2);
+		g->edges = XREALLOC(MTYPE_ISIS_FLOOD_GRAPH, g->edges,
+				    g->edge_size * sizeof(*g->edges));
+	}
+	g->edges[g->edge_count].from = g->cur;
+	g->edges[g->edge_count].to = found - g->ids;
+	g->edge_count++;
+
+	return LSP_ITER_CONTINUE;
+}
+
+static void flood_graph_build(struct flood_graph *g, struct lspdb_head *lspdb)
+{
+	struct isis_lsp *lsp;
+	struct flood_edge rev;
+	size_t i, links = 0;
+
+	frr_each (lspdb, lspdb, lsp) {
+		if (LSP_FRAGMENT(lsp->hdr.lsp_id) == 0
+		    && lsp->hdr.rem_lifetime && lsp->hdr.seqno)
+			g->count++;
+	}
+	g->ids = XCALLOC(MTYPE_ISIS_FLOOD_GRAPH,
+			 MAX(g->count, 1) * sizeof(*g->ids));
+
+	/* the LSPDB is sorted by LSP ID, so are the nodes */
+	g->count = 0;
+	frr_each (lspdb, lspdb, lsp) {
+		if (LSP_FRAGMENT(lsp->hdr.lsp_id) == 0
+		    && lsp->hdr.rem_lifetime && lsp->hdr.seqno)
+			memcpy(g->ids[g->count++], lsp->hdr.lsp_id,
+			       ISIS_SYS_ID_LEN + 1);
+	}
+
+	g->cur = 0;
+	frr_each (lspdb, lspdb, lsp) {
+		if (LSP_FRAGMENT(lsp->hdr.lsp_id) != 0
+		    || !lsp->hdr.rem_lifetime || !lsp->hdr.seqno)
+			continue;
+		isis_lsp_iterate_is_reach(lsp, ISIS_MT_IPV4_UNICAST,
+					  flood_edge_add, g);
+		g->cur++;
+	}
+
+	qsort(g->edges, g->edge_count, sizeof(*g->edges), flood_edge_cmp);
+
+	/* keep the links both ends report, once in each direction */
+	g->first = XCALLOC(MTYPE_ISIS_FLOOD_GRAPH,
+			   (g->count + 1) * sizeof(*g->first));
+	g->link_to = XCALLOC(MTYPE_ISIS_FLOOD_GRAPH,
+			     MAX(g->edge_count, 1) * sizeof(*g->link_to));
+	g->link_id = XCALLOC(MTYPE_ISIS_FLOOD_GRAPH,
+			     MAX(g->edge_count, 1) * sizeof(*g->link_id));
+
+	for (i = 0; i < g->edge_count; i++) {
+		struct flood_edge *e = &g->edges[i];
+
+		if (i && !flood_edge_cmp(e, &g->edges[i - 1]))
+			continue;
+		rev.from = e->to;
+		rev.to = e->from;
+		if (!bsearch(&rev, g->edges, g->edge_count, sizeof(*g->edges),
+			     flood_edge_cmp))
+			continue;
+
+		g->link_to[links] = e->to;
+		/* both directions of a link share the lower one's index */
+		g->link_id[links] = links;
+		g->first[e->from + 1]++;
+		links++;
+	}
+	for (i = 0; i < g->count; i++)
+		g->first[i + 1] += g->first[i];
+
+	/* the two halves of a link point at the same link id */
+	for (i = 0; i < g->count; i++) {
+		for (uint32_t l = g->first[i]; l < g->first[i + 1]; l++) {
+			uint32_t to = g->link_to[l];
+
+			if (to > i)
+				continue;
+			for (uint32_t r = g->first[to]; r < g->first[to + 1];
+			     r++) {
+				if (g->link_to[r] == i) {
+					g->link_id[l] = g->link_id[r];
+					break;
+				}
+			}
+		}
+	}
+
+	g->on_ft = XCALLOC(MTYPE_ISIS_FLOOD_GRAPH, MAX(links, 1));
+	g->ft_degree = XCALLOC(MTYPE_ISIS_FLOOD_GRAPH,
+			       MAX(g->count, 1) * sizeof(*g->ft_degree));
+}
+
+static void flood_graph_free(struct flood_graph *g)
+{
+	XFREE(MTYPE_ISIS_FLOOD_GRAPH, g->ids);
+	XFREE(MTYPE_ISIS_FLOOD_GRAPH, g->edges);
+	XFREE(MTYPE_ISIS_FLOOD_GRAPH, g->first);
+	XFREE(MTYPE_ISIS_FLOOD_GRAPH, g->link_to);
+	XFREE(MTYPE_ISIS_FLOOD_GRAPH, g->link_id);
+	XFREE(MTYPE_ISIS_FLOOD_GRAPH, g->on_ft);
+	XFREE(MTYPE_ISIS_FLOOD_GRAPH, g->ft_degree);
+}
+
+static void flood_graph_use(struct flood_graph *g, uint32_t n, uint32_t l)
+{
+	g->on_ft[g->link_id[l]] = true;
+	g->ft_degree[n]++;
+	g->ft_degree[g->link_to[l]]++;
+}
+
+/*
+ * Everything in here only depends on the LSPDB and goes through nodes and
+ * links in ID order, so all routers with the same LSPDB get the same
+ * flooding topology.
+ */
+static void flood_graph_compute(struct flood_graph *g)
+{
+	uint32_t *queue, head, tail;
+	bool *seen;
+	uint32_t n, l;
+
+	queue = XCALLOC(MTYPE_ISIS_FLOOD_GRAPH,
+			MAX(g->count, 1) * sizeof(*queue));
+	seen = XCALLOC(MTYPE_ISIS_FLOOD_GRAPH, MAX(g->count, 1));
+
+	/* breadth-first spanning tree of each connected part */
+	for (n = 0; n < g->count; n++) {
+		if (seen[n])
+			continue;
+
+		seen[n] = true;
+		head = tail = 0;
+		queue[tail++] = n;
+		while (head < tail) {
+			uint32_t u = queue[head++];
+
+			for (l = g->first[u]; l < g->first[u + 1]; l++) {
+				uint32_t v = g->link_to[l];
+
+				if (seen[v])
+					continue;
+				seen[v] = true;
+				queue[tail++] = v;
+				flood_graph_use(g, u, l);
+			}
+		}
+	}
+
+	/* no router with a choice hangs off a single link */
+	for (n = 0; n < g->count; n++) {
+		while (g->ft_degree[n] < 2) {
+			uint32_t best = UINT32_MAX;
+
+			for (l = g->first[n]; l < g->first[n + 1]; l++) {
+				if (g->on_ft[g->link_id[l]])
+					continue;
+				if (best == UINT32_MAX
+				    || g->ft_degree[g->link_to[l]]
+					       < g->ft_degree[g->link_to[best]])
+					best = l;
+			}
+			if (best == UINT32_MAX)
+				break;
+			flood_graph_use(g, n, best);
+		}
+	}
+
+	XFREE(MTYPE_ISIS_FLOOD_GRAPH, queue);
+	XFREE(MTYPE_ISIS_FLOOD_GRAPH, seen);
+}
+
+static void flood_topo_del(struct isis_flood_topo **ftp)
+{
+	struct isis_flood_topo *ft = *ftp;
+
+	if (!ft)
+		return;
+
+	XFREE(MTYPE_ISIS_FLOOD_TOPO, ft->ft_nbrs);
+	XFREE(MTYPE_ISIS_FLOOD_TOPO, ft->nbrs);
+	XFREE(MTYPE_ISIS_FLOOD_TOPO, ft);
+	*ftp = NULL;
+}
+
+void isis_flood_topo_compute(struct isis_area *area, int level)
+{
+	struct isis_flood_topo *ft;
+	struct flood_graph g = {};
+	uint8_t self[ISIS_SYS_ID_LEN + 1] = {};
+	uint8_t (*found)[ISIS_SYS_ID_LEN + 1];
+	uint32_t n, l, links;
+
+	flood_topo_del(&area->flood_topo[level - 1]);
+	if (!area->dynamic_flooding || fabricd)
+		return;
+
+	memcpy(self, area->isis->sysid, ISIS_SYS_ID_LEN);
+	flood_graph_build(&g, &area->lspdb[level - 1]);
+
+	found = bsearch(self, g.ids, g.count, sizeof(*g.ids), flood_id_cmp);
+	if (!found) {
+		/* nothing to go by, flood as usual */
+		flood_graph_free(&g);
+		return;
+	}
+
+	flood_graph_compute(&g);
+
+	n = found - g.ids;
+	links = g.first[n + 1] - g.first[n];
+	ft = XCALLOC(MTYPE_ISIS_FLOOD_TOPO, sizeof(*ft));
+	ft->ft_nbrs = XCALLOC(MTYPE_ISIS_FLOOD_TOPO,
+			      MAX(links, 1) * sizeof(*ft->ft_nbrs));
+	ft->nbrs = XCALLOC(MTYPE_ISIS_FLOOD_TOPO,
+			   MAX(links, 1) * sizeof(*ft->nbrs));
+
+	/* pseudonodes don't matter, LANs are flooded anyway */
+	for (l = g.first[n]; l < g.first[n + 1]; l++) {
+		uint8_t *id = g.ids[g.link_to[l]];
+
+		if (LSP_PSEUDO_ID(id))
+			continue;
+		memcpy(ft->nbrs[ft->nbr_count++], id, ISIS_SYS_ID_LEN);
+		if (g.on_ft[g.link_id[l]])
+			memcpy(ft->ft_nbrs[ft->ft_count++], id,
+			       ISIS_SYS_ID_LEN);
+	}
+
+	if (IS_DEBUG_FLOODING)
+		zlog_debug(
+			"ISIS-Flood (%s) L%d flooding topology: %zu of %zu neighbors",
+			area->area_tag, level, ft->ft_count, ft->nbr_count);
+
+	area->flood_topo[level - 1] = ft;
+	flood_graph_free(&g);
+}
+
+void isis_flood_topo_free(struct isis_area *area)
+{
+	for (int level = ISIS_LEVEL1; level <= ISIS_LEVEL2; level++)
+		flood_topo_del(&area->flood_topo[level - 1]);
+}
+
+bool isis_flood_topo_active(struct isis_lsp *lsp)
+{
+	struct isis_area *area = lsp->area;
+
+	if (!area || !area->flood_topo[lsp->level - 1])
+		return false;
+
+	/* our own LSPs report our adjacency changes, which the flooding
+	 * topology may not reflect yet
+	 */
+	return memcmp(lsp->hdr.lsp_id, area->isis->sysid, ISIS_SYS_ID_LEN);
+}
+
+static int flood_sysid_cmp(const void *a, const void *b)
+{
+	return memcmp(a, b, ISIS_SYS_ID_LEN);
+}
+
+static bool flood_topo_uses(struct isis_flood_topo *ft, const uint8_t *sysid)
+{
+	if (bsearch(sysid, ft->ft_nbrs, ft->ft_count, sizeof(*ft->ft_nbrs),
+		    flood_sysid_cmp))
+		return true;
+
+	/* an adjacency that isn't in the LSPDB yet isn't on anybody's
+	 * flooding topology, so it's flooded on until it is
+	 */
+	return !bsearch(sysid, ft->nbrs, ft->nbr_count, sizeof(*ft->nbrs),
+			flood_sysid_cmp);
+}
+
+void isis_flood_topo_flood(struct isis_lsp *lsp)
+{
+	struct isis_flood_topo *ft = lsp->area->flood_topo[lsp->level - 1];
+	struct isis_circuit *circuit;
+	struct isis_adjacency *adj;
+	struct listnode *node;
+
+	for (ALL_LIST_ELEMENTS_RO(lsp->area->circuit_list, node, circuit)) {
+		if (circuit->circ_type == CIRCUIT_T_P2P) {
+			adj = circuit->u.p2p.neighbor;
+			if (adj && adj->adj_state == ISIS_ADJ_UP
+			    && !flood_topo_uses(ft, adj->sysid))
+				continue;
+		}
+
+		isis_tx_queue_add(circuit->tx_queue, lsp, TX_LSP_NORMAL);
+	}
+}
+
+void isis_flood_topo_show(struct vty *vty, struct isis_area *area, int level)
+{
+	struct isis_flood_topo *ft = area->flood_topo[level - 1];
+
+	if (!ft)
+		return;
+
+	vty_out(vty, "    Flooding topology: %zu of %zu neighbors\n",
+		ft->ft_count, ft->nbr_count);
+}
@@ -0,0 +1,50 @@
+/*
+ * IS-IS dynamic flooding topology.
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _FRR_ISIS_FLOOD_TOPO_H
+#define _FRR_ISIS_FLOOD_TOPO_H
+
+struct isis_area;
+struct isis_lsp;
+struct vty;
+
+/*
+ * With "dynamic-flooding", each router derives the same sparse flooding
+ * topology from the LSPDB, in the spirit of the distributed mode of
+ * RFC 9667: a spanning tree of every connected part of the network built
+ * from the lowest system ID, plus links that bring every router with more
+ * than one neighbor to at least two.  LSPs of other routers are then only
+ * flooded over the point-to-point adjacencies on that topology, and over
+ * those the LSPDB doesn't know about yet.  LANs, as well as our own LSPs,
+ * are still flooded everywhere, and the periodic CSNPs keep the LSPDBs in
+ * sync over the other adjacencies.
+ */
+
+/* Recompute the flooding topology of a level, after an SPF run. */
+extern void isis_flood_topo_compute(struct isis_area *area, int level);
+extern void isis_flood_topo_free(struct isis_area *area);
+
+/* Whether lsp is to be flooded with isis_flood_topo_flood(). */
+extern bool isis_flood_topo_active(struct isis_lsp *lsp);
+extern void isis_flood_topo_flood(struct isis_lsp *lsp);
+
+extern void isis_flood_topo_show(struct vty *vty, struct isis_area *area,
+				 int level);
+
+#endif /* _FRR_ISIS_FLOOD_TOPO_H */
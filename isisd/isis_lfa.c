@@ -22,6 +22,7 @@
 #include "linklist.h"
 #include "log.h"
 #include "memory.h"
+#include "frratomic.h"
 #include "vrf.h"
 #include "table.h"
 #include "srcdest_table.h"
@@ -35,6 +36,7 @@
 #include "isis_circuit.h"
 #include "isis_lsp.h"
 #include "isis_spf.h"
+#include "isis_spf_pool.h"
 #include "isis_route.h"
 #include "isis_mt.h"
 #include "isis_tlvs.h"
@@ -884,6 +886,41 @@ static bool lfa_check_needs_protection(const struct isis_spftree *spftree_pc,
 		&spftree_pc->lfa.protected_resource);
 }
 
+/*
+ * Check if the route/adjacency of a post-convergence SPF vertex was already
+ * covered by node protection.
+ */
+static bool tilfa_check_covered(const struct isis_spftree *spftree_pc,
+				const struct isis_vertex *vertex)
+{
+	char buf[VID2STR_BUFFER];
+
+	if (VTYPE_IS(vertex->type)) {
+		struct isis_adjacency *adj;
+
+		adj = isis_adj_find(spftree_pc->area, spftree_pc->level,
+				    vertex->N.id);
+		if (!adj
+		    || !isis_sr_adj_sid_find(adj, spftree_pc->family,
+					     ISIS_SR_LAN_BACKUP))
+			return false;
+	}
+	if (VTYPE_IP(vertex->type)) {
+		struct route_table *route_table;
+
+		route_table = spftree_pc->lfa.old.spftree->route_table_backup;
+		if (!route_node_lookup(route_table, &vertex->N.ip.p.dest))
+			return false;
+	}
+
+	if (IS_DEBUG_LFA)
+		zlog_debug("ISIS-LFA: %s %s already covered by node protection",
+			   vtype2string(vertex->type),
+			   vid2string(vertex, buf, sizeof(buf)));
+
+	return true;
+}
+
 /**
  * Check if the given SPF vertex needs protection and, if so, compute and
  * install the corresponding repair paths.
@@ -918,38 +955,12 @@ int isis_tilfa_check(struct isis_spftree *spftree_pc,
 
 	/*
 	 * Check if the route/adjacency was already covered by node protection.
+	 * That depends on the other post-convergence SPTs, so it's done when
+	 * installing the queued vertices if they are computed in parallel.
 	 */
-	if (VTYPE_IS(vertex->type)) {
-		struct isis_adjacency *adj;
-
-		adj = isis_adj_find(spftree_pc->area, spftree_pc->level,
-				    vertex->N.id);
-		if (adj
-		    && isis_sr_adj_sid_find(adj, spftree_pc->family,
-					    ISIS_SR_LAN_BACKUP)) {
-			if (IS_DEBUG_LFA)
-				zlog_debug(
-					"ISIS-LFA: %s %s already covered by node protection",
-					vtype2string(vertex->type),
-					vid2string(vertex, buf, sizeof(buf)));
-
-			return -1;
-		}
-	}
-	if (VTYPE_IP(vertex->type)) {
-		struct route_table *route_table;
-
-		route_table = spftree_pc->lfa.old.spftree->route_table_backup;
-		if (route_node_lookup(route_table, &vertex->N.ip.p.dest)) {
-			if (IS_DEBUG_LFA)
-				zlog_debug(
-					"ISIS-LFA: %s %s already covered by node protection",
-					vtype2string(vertex->type),
-					vid2string(vertex, buf, sizeof(buf)));
-
-			return -1;
-		}
-	}
+	if (!spftree_pc->lfa.tilfa.install_queue
+	    && tilfa_check_covered(spftree_pc, vertex))
+		return -1;
 
 	if (IS_DEBUG_LFA)
 		zlog_debug(
@@ -1171,38 +1182,37 @@ static void lfa_calc_pq_spaces(struct isis_spftree *spftree_pc,
 	}
 }
 
-/**
- * Compute the TI-LFA backup paths for a given protected interface.
- *
- * @param area		  IS-IS area
- * @param spftree	  IS-IS SPF tree
- * @param spftree_reverse IS-IS Reverse SPF tree
- * @param resource	  Protected resource
- *
- * @return		  Pointer to the post-convergence SPF tree
+static void tilfa_resource_nodes_init(const struct isis_spftree *spftree,
+				      struct lfa_protected_resource *resource)
+{
+	struct isis_spf_node *adj_node;
+
+	isis_spf_node_list_init(&resource->nodes);
+	RB_FOREACH (adj_node, isis_spf_nodes, &spftree->adj_nodes) {
+		if (spf_adj_node_is_affected(adj_node, resource,
+					     spftree->sysid))
+			isis_spf_node_new(&resource->nodes, adj_node->sysid);
+	}
+}
+
+/*
+ * Create the post-convergence SPT of a protected resource and compute its
+ * extended P-space and Q-space, leaving the SPF itself to the caller.
  */
-struct isis_spftree *isis_tilfa_compute(struct isis_area *area,
-					struct isis_spftree *spftree,
-					struct isis_spftree *spftree_reverse,
-					struct lfa_protected_resource *resource)
+static struct isis_spftree *
+tilfa_spftree_new(struct isis_area *area, struct isis_spftree *spftree,
+		  struct isis_spftree *spftree_reverse,
+		  struct lfa_protected_resource *resource)
 {
 	struct isis_spftree *spftree_pc;
-	struct isis_spf_node *adj_node;
 
 	if (IS_DEBUG_LFA)
 		zlog_debug("ISIS-LFA: computing TI-LFAs for %s",
 			   lfa_protected_resource2str(resource));
 
 	/* Populate list of nodes affected by link failure. */
-	if (resource->type == LFA_NODE_PROTECTION) {
-		isis_spf_node_list_init(&resource->nodes);
-		RB_FOREACH (adj_node, isis_spf_nodes, &spftree->adj_nodes) {
-			if (spf_adj_node_is_affected(adj_node, resource,
-						     spftree->sysid))
-				isis_spf_node_new(&resource->nodes,
-						  adj_node->sysid);
-		}
-	}
+	if (resource->type == LFA_NODE_PROTECTION)
+		tilfa_resource_nodes_init(spftree, resource);
 
 	/* Create post-convergence SPF tree. */
 	spftree_pc = isis_spftree_new(area, spftree->lspdb, spftree->sysid,
@@ -1215,6 +1225,29 @@ struct isis_spftree *isis_tilfa_compute(struct isis_area *area,
 	/* Compute the extended P-space and Q-space. */
 	lfa_calc_pq_spaces(spftree_pc, resource);
 
+	return spftree_pc;
+}
+
+/**
+ * Compute the TI-LFA backup paths for a given protected interface.
+ *
+ * @param area		  IS-IS area
+ * @param spftree	  IS-IS SPF tree
+ * @param spftree_reverse IS-IS Reverse SPF tree
+ * @param resource	  Protected resource
+ *
+ * @return		  Pointer to the post-convergence SPF tree
+ */
+struct isis_spftree *isis_tilfa_compute(struct isis_area *area,
+					struct isis_spftree *spftree,
+					struct isis_spftree *spftree_reverse,
+					struct lfa_protected_resource *resource)
+{
+	struct isis_spftree *spftree_pc;
+
+	spftree_pc = tilfa_spftree_new(area, spftree, spftree_reverse,
+				       resource);
+
 	if (IS_DEBUG_LFA)
 		zlog_debug(
 			"ISIS-LFA: computing the post convergence SPT w.r.t. %s",
@@ -1230,6 +1263,63 @@ struct isis_spftree *isis_tilfa_compute(struct isis_area *area,
 	return spftree_pc;
 }
 
+struct lfa_spf_batch {
+	struct isis_spftree **spftrees;
+	unsigned int count;
+	atomic_uint next;
+};
+
+static void lfa_spf_batch_work(void *arg, unsigned int shard)
+{
+	struct lfa_spf_batch *batch = arg;
+	unsigned int i;
+
+	while ((i = atomic_fetch_add_explicit(&batch->next, 1,
+					      memory_order_relaxed))
+	       < batch->count)
+		isis_run_spf(batch->spftrees[i]);
+}
+
+/* Check if lfa_run_spftrees() spreads the given SPTs over worker pthreads. */
+static bool lfa_spf_parallel(const struct isis_area *area,
+			     const struct list *spftrees)
+{
+	return listcount(spftrees) > 1 && area->spf_threads
+	       && isis_spf_pool_size();
+}
+
+/*
+ * Run SPF on a list of SPTs, in parallel on the SPF worker pthreads if
+ * enabled.  The SPTs must not have any side effects outside of themselves
+ * while running, which holds for the neighbor SPTs (no routes) and for the
+ * TI-LFA post-convergence SPTs with an install queue.
+ */
+static void lfa_run_spftrees(struct isis_area *area, struct list *spftrees)
+{
+	struct lfa_spf_batch batch = {};
+	struct isis_spftree *spftree;
+	struct listnode *node;
+
+	if (!lfa_spf_parallel(area, spftrees)) {
+		for (ALL_LIST_ELEMENTS_RO(spftrees, node, spftree))
+			isis_run_spf(spftree);
+		return;
+	}
+
+	if (IS_DEBUG_LFA)
+		zlog_debug("ISIS-LFA: running %u SPFs on %u worker threads",
+			   listcount(spftrees), isis_spf_pool_size());
+
+	batch.spftrees = XCALLOC(MTYPE_TMP,
+				 listcount(spftrees) * sizeof(*batch.spftrees));
+	for (ALL_LIST_ELEMENTS_RO(spftrees, node, spftree))
+		batch.spftrees[batch.count++] = spftree;
+
+	isis_spf_pool_run(lfa_spf_batch_work, &batch);
+
+	XFREE(MTYPE_TMP, batch.spftrees);
+}
+
 /**
  * Run forward SPF on all adjacent routers.
  *
@@ -1241,23 +1331,29 @@ int isis_spf_run_neighbors(struct isis_spftree *spftree)
 {
 	struct isis_lsp *lsp;
 	struct isis_spf_node *adj_node;
+	struct list *spftrees;
 
 	lsp = isis_root_system_lsp(spftree->lspdb, spftree->sysid);
 	if (!lsp)
 		return -1;
 
+	spftrees = list_new();
 	RB_FOREACH (adj_node, isis_spf_nodes, &spftree->adj_nodes) {
 		if (IS_DEBUG_LFA)
 			zlog_debug("ISIS-LFA: running SPF on neighbor %s",
 				   print_sys_hostname(adj_node->sysid));
 
 		/* Compute the SPT on behalf of the neighbor. */
-		adj_node->lfa.spftree = isis_spftree_new(
-			spftree->area, spftree->lspdb, adj_node->sysid,
-			spftree->level, spftree->tree_id, SPF_TYPE_FORWARD,
-			F_SPFTREE_NO_ADJACENCIES | F_SPFTREE_NO_ROUTES);
-		isis_run_spf(adj_node->lfa.spftree);
+		if (!adj_node->lfa.spftree)
+			adj_node->lfa.spftree = isis_spftree_new(
+				spftree->area, spftree->lspdb, adj_node->sysid,
+				spftree->level, spftree->tree_id,
+				SPF_TYPE_FORWARD,
+				F_SPFTREE_NO_ADJACENCIES | F_SPFTREE_NO_ROUTES);
+		listnode_add(spftrees, adj_node->lfa.spftree);
 	}
+	lfa_run_spftrees(spftree->area, spftrees);
+	list_delete(&spftrees);
 
 	return 0;
 }
@@ -1539,6 +1635,7 @@ void isis_rlfa_deactivate(struct isis_spftree *spftree, struct rlfa *rlfa)
 	if (!rn)
 		return;
 	isis_route_delete(area, rn, spftree->route_table_backup);
+	isis_zebra_prefix_sid_flush();
 	spftree->lfa.protection_counters.rlfa[vertex->N.ip.priority] -= 1;
 
 	thread_cancel(&area->t_rlfa_rib_update);
@@ -2243,21 +2340,59 @@ void isis_lfa_compute(struct isis_area *area, struct isis_circuit *circuit,
 	}
 }
 
-static void isis_spf_run_tilfa(struct isis_area *area,
-			       struct isis_circuit *circuit,
-			       struct isis_spftree *spftree,
-			       struct isis_spftree *spftree_reverse,
-			       struct lfa_protected_resource *resource)
+/*
+ * Get the post-convergence SPT of a protected resource ready to be run,
+ * reusing the one of the last run if there is one.  It's only kept by
+ * partial runs (the P-space and Q-space don't change then), full runs start
+ * from scratch.
+ */
+static void isis_spf_prepare_tilfa_resource(
+	struct isis_area *area, struct isis_spftree *spftree,
+	struct isis_spftree *spftree_reverse,
+	struct lfa_protected_resource *resource, struct list *batch)
 {
-	struct isis_spftree *spftree_pc_link;
-	struct isis_spftree *spftree_pc_node;
+	struct isis_spftree *spftree_pc;
+	struct listnode *node;
+
+	for (ALL_LIST_ELEMENTS_RO(spftree->lfa.tilfa.pc_spftrees, node,
+				  spftree_pc)) {
+		struct lfa_protected_resource *pc_resource;
+
+		pc_resource = &spftree_pc->lfa.protected_resource;
+		if (pc_resource->type != resource->type
+		    || memcmp(pc_resource->adjacency, resource->adjacency,
+			      sizeof(resource->adjacency)))
+			continue;
+
+		if (IS_DEBUG_LFA)
+			zlog_debug("ISIS-LFA: recomputing TI-LFAs for %s",
+				   lfa_protected_resource2str(resource));
 
+		if (resource->type == LFA_NODE_PROTECTION)
+			tilfa_resource_nodes_init(spftree, resource);
+		spftree_pc->lfa.protected_resource = *resource;
+		listnode_add(batch, spftree_pc);
+		return;
+	}
+
+	spftree_pc =
+		tilfa_spftree_new(area, spftree, spftree_reverse, resource);
+	listnode_add(spftree->lfa.tilfa.pc_spftrees, spftree_pc);
+	listnode_add(batch, spftree_pc);
+}
+
+static void isis_spf_prepare_tilfa(struct isis_area *area,
+				   struct isis_circuit *circuit,
+				   struct isis_spftree *spftree,
+				   struct isis_spftree *spftree_reverse,
+				   struct lfa_protected_resource *resource,
+				   struct list *batch)
+{
 	/* Compute node protecting repair paths first (if necessary). */
 	if (circuit->tilfa_node_protection[spftree->level - 1]) {
 		resource->type = LFA_NODE_PROTECTION;
-		spftree_pc_node = isis_tilfa_compute(area, spftree,
-						     spftree_reverse, resource);
-		isis_spftree_del(spftree_pc_node);
+		isis_spf_prepare_tilfa_resource(area, spftree, spftree_reverse,
+						resource, batch);
 
 		/* don't do link protection unless link-fallback is configured
 		 */
@@ -2267,9 +2402,66 @@ static void isis_spf_run_tilfa(struct isis_area *area,
 
 	/* Compute link protecting repair paths. */
 	resource->type = LFA_LINK_PROTECTION;
-	spftree_pc_link =
-		isis_tilfa_compute(area, spftree, spftree_reverse, resource);
-	isis_spftree_del(spftree_pc_link);
+	isis_spf_prepare_tilfa_resource(area, spftree, spftree_reverse,
+					resource, batch);
+}
+
+/*
+ * Install the repair paths queued by a post-convergence SPF that ran on a
+ * worker pthread, skipping those already covered by the SPTs installed
+ * before it (just like a serial run would have done).
+ */
+static void tilfa_install_queued(struct isis_spftree *spftree_pc)
+{
+	struct isis_vertex_adj *vadj;
+	struct isis_vertex *vertex;
+	struct listnode *node, *anode;
+
+	for (ALL_LIST_ELEMENTS_RO(spftree_pc->lfa.tilfa.install_queue, node,
+				  vertex)) {
+		if (tilfa_check_covered(spftree_pc, vertex)) {
+			for (ALL_LIST_ELEMENTS_RO(vertex->Adj_N, anode, vadj))
+				XFREE(MTYPE_ISIS_NEXTHOP_LABELS,
+				      vadj->label_stack);
+			continue;
+		}
+
+		isis_spf_tilfa_install(spftree_pc, vertex);
+	}
+}
+
+/*
+ * Run the post-convergence SPFs of a batch of protected resources.  If they
+ * are run in parallel, the repair paths are installed afterwards, in batch
+ * order, on the main pthread.
+ */
+static void isis_spf_run_tilfa_batch(struct isis_area *area,
+				     struct list *batch)
+{
+	struct isis_spftree *spftree_pc;
+	struct listnode *node;
+
+	if (lfa_spf_parallel(area, batch)) {
+		for (ALL_LIST_ELEMENTS_RO(batch, node, spftree_pc))
+			spftree_pc->lfa.tilfa.install_queue = list_new();
+	}
+
+	lfa_run_spftrees(area, batch);
+
+	for (ALL_LIST_ELEMENTS_RO(batch, node, spftree_pc)) {
+		struct lfa_protected_resource *resource;
+
+		if (spftree_pc->lfa.tilfa.install_queue) {
+			tilfa_install_queued(spftree_pc);
+			list_delete(&spftree_pc->lfa.tilfa.install_queue);
+		}
+
+		/* Clear list of nodes affeted by node failure. */
+		resource = &spftree_pc->lfa.protected_resource;
+		if (resource->type == LFA_NODE_PROTECTION)
+			isis_spf_node_list_clear(&resource->nodes);
+	}
+	list_delete_all_node(batch);
 }
 
 /**
@@ -2283,17 +2475,25 @@ void isis_spf_run_lfa(struct isis_area *area, struct isis_spftree *spftree)
 	struct isis_spftree *spftree_reverse = NULL;
 	struct isis_circuit *circuit;
 	struct listnode *node;
+	struct list *tilfa_batch;
 	int level = spftree->level;
 
 	/* Run reverse SPF locally. */
 	if (area->rlfa_protected_links[level - 1] > 0
-	    || area->tilfa_protected_links[level - 1] > 0)
-		spftree_reverse = isis_spf_reverse_run(spftree);
+	    || area->tilfa_protected_links[level - 1] > 0) {
+		if (!spftree->lfa.spftree_reverse)
+			spftree->lfa.spftree_reverse =
+				isis_spf_reverse_run(spftree);
+		else
+			isis_run_spf(spftree->lfa.spftree_reverse);
+		spftree_reverse = spftree->lfa.spftree_reverse;
+	}
 
 	/* Run forward SPF on all adjacent routers. */
 	isis_spf_run_neighbors(spftree);
 
 	/* Check which interfaces are protected. */
+	tilfa_batch = list_new();
 	for (ALL_LIST_ELEMENTS_RO(area->circuit_list, node, circuit)) {
 		struct lfa_protected_resource resource = {};
 		struct isis_adjacency *adj;
@@ -2334,6 +2534,12 @@ void isis_spf_run_lfa(struct isis_area *area, struct isis_spftree *spftree)
 		}
 
 		if (circuit->lfa_protection[level - 1]) {
+			/*
+			 * The TI-LFAs of the previous interfaces are checked
+			 * against the local LFAs computed up to this point.
+			 */
+			isis_spf_run_tilfa_batch(area, tilfa_batch);
+
 			/* Run local LFA. */
 			isis_lfa_compute(area, circuit, spftree, &resource);
 
@@ -2354,11 +2560,11 @@ void isis_spf_run_lfa(struct isis_area *area, struct isis_spftree *spftree)
 		} else if (circuit->tilfa_protection[level - 1]) {
 			/* Run TI-LFA. */
 			assert(spftree_reverse);
-			isis_spf_run_tilfa(area, circuit, spftree,
-					   spftree_reverse, &resource);
+			isis_spf_prepare_tilfa(area, circuit, spftree,
+					       spftree_reverse, &resource,
+					       tilfa_batch);
 		}
 	}
-
-	if (spftree_reverse)
-		isis_spftree_del(spftree_reverse);
+	isis_spf_run_tilfa_batch(area, tilfa_batch);
+	list_delete(&tilfa_batch);
 }
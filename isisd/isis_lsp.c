@@ -57,8 +57,10 @@
 #include "isisd/isis_te.h"
 #include "isisd/isis_sr.h"
 #include "isisd/fabricd.h"
+#include "isisd/isis_flood_topo.h"
 #include "isisd/isis_tx_queue.h"
 #include "isisd/isis_nb.h"
+#include "isisd/isis_trace.h"
 
 DEFINE_MTYPE_STATIC(ISISD, ISIS_LSP, "ISIS LSP");
 
@@ -540,10 +542,29 @@ static void lsp_link_fragment(struct isis_lsp *lsp, struct isis_lsp *lsp0)
 	}
 }
 
+static void lsp_relink_fragment(struct isis_lsp *lsp, struct isis_area *area,
+				int level)
+{
+	uint8_t lspid[ISIS_SYS_ID_LEN + 2];
+	struct isis_lsp *lsp0;
+
+	if (!LSP_FRAGMENT(lsp->hdr.lsp_id) || lsp->lspu.zero_lsp)
+		return;
+
+	memcpy(lspid, lsp->hdr.lsp_id, ISIS_SYS_ID_LEN + 1);
+	LSP_FRAGMENT(lspid) = 0;
+	lsp0 = lsp_search(&area->lspdb[level - 1], lspid);
+	if (lsp0)
+		lsp_link_fragment(lsp, lsp0);
+}
+
 void lsp_update(struct isis_lsp *lsp, struct isis_lsp_hdr *hdr,
 		struct isis_tlvs *tlvs, struct stream *stream,
 		struct isis_area *area, int level, bool confusion)
 {
+	uint8_t old_lsp_bits = lsp->hdr.lsp_bits;
+	struct isis_tlvs *old_tlvs;
+
 	if (lsp->own_lsp) {
 		flog_err(
 			EC_LIB_DEVELOPMENT,
@@ -553,25 +574,55 @@ void lsp_update(struct isis_lsp *lsp, struct isis_lsp_hdr *hdr,
 		lsp->own_lsp = 0;
 	}
 
+	/* Keep the old TLVs until we know how much SPF the update needs. */
+	old_tlvs = lsp->tlvs;
+	lsp->tlvs = NULL;
+
 	if (confusion) {
 		lsp_purge(lsp, level, NULL);
 	} else {
 		lsp_update_data(lsp, hdr, tlvs, stream, area, level);
 	}
 
-	if (LSP_FRAGMENT(lsp->hdr.lsp_id) && !lsp->lspu.zero_lsp) {
-		uint8_t lspid[ISIS_SYS_ID_LEN + 2];
-		struct isis_lsp *lsp0;
-
-		memcpy(lspid, lsp->hdr.lsp_id, ISIS_SYS_ID_LEN + 1);
-		LSP_FRAGMENT(lspid) = 0;
-		lsp0 = lsp_search(&area->lspdb[level - 1], lspid);
-		if (lsp0)
-			lsp_link_fragment(lsp, lsp0);
-	}
+	lsp_relink_fragment(lsp, area, level);
 
 	if (lsp->hdr.seqno)
-		isis_spf_schedule(lsp->area, lsp->level);
+		isis_spf_schedule_lsp(lsp, confusion ? NULL : old_tlvs,
+				      old_lsp_bits);
+	isis_free_tlvs(old_tlvs);
+}
+
+bool lsp_same_tlvs(struct isis_lsp *lsp, struct stream *stream,
+		   size_t tlv_start)
+{
+	if (!lsp || lsp->own_lsp || !lsp->tlvs || !lsp->pdu
+	    || !lsp->hdr.rem_lifetime)
+		return false;
+	if (stream_get_endp(lsp->pdu) < tlv_start
+	    || stream_get_endp(stream) < tlv_start)
+		return false;
+
+	return isis_tlvs_raw_same(STREAM_DATA(lsp->pdu) + tlv_start,
+				  stream_get_endp(lsp->pdu) - tlv_start,
+				  STREAM_DATA(stream) + tlv_start,
+				  stream_get_endp(stream) - tlv_start);
+}
+
+void lsp_update_same(struct isis_lsp *lsp, struct isis_lsp_hdr *hdr,
+		     struct isis_tlvs *auth, struct stream *stream,
+		     struct isis_area *area, int level)
+{
+	uint8_t old_lsp_bits = lsp->hdr.lsp_bits;
+	struct isis_tlvs *tlvs = lsp->tlvs;
+
+	lsp->tlvs = NULL;
+	isis_tlvs_take_auth(tlvs, auth);
+	lsp_update_data(lsp, hdr, tlvs, stream, area, level);
+	lsp_relink_fragment(lsp, area, level);
+
+	/* nothing but the header bits can matter to SPF */
+	if (lsp->hdr.seqno && lsp->hdr.lsp_bits != old_lsp_bits)
+		isis_spf_schedule_lsp(lsp, lsp->tlvs, old_lsp_bits);
 }
 
 /* creation of LSP directly from what we received */
@@ -929,9 +980,12 @@ static struct isis_lsp *lsp_next_frag(uint8_t frag_num, struct isis_lsp *lsp0,
 
 /*
  * Builds the LSP data part. This func creates a new frag whenever
- * area->lsp_frag_threshold is exceeded.
+ * area->lsp_frag_threshold is exceeded.  With prev, the TLVs the fragments
+ * had so far (indexed by fragment number), items stay in the fragment they
+ * were in.
  */
-static void lsp_build(struct isis_lsp *lsp, struct isis_area *area)
+static void lsp_build(struct isis_lsp *lsp, struct isis_area *area,
+		      struct isis_tlvs *const *prev)
 {
 	int level = lsp->level;
 	struct listnode *node;
@@ -1241,7 +1295,10 @@ static void lsp_build(struct isis_lsp *lsp, struct isis_area *area)
 	size_t tlv_space = STREAM_WRITEABLE(lsp->pdu) - LLC_LEN;
 	lsp_clear_data(lsp);
 
-	struct list *fragments = isis_fragment_tlvs(tlvs, tlv_space);
+	struct list *fragments =
+		prev ? isis_fragment_tlvs_stable(tlvs, tlv_space, prev,
+						 ISIS_LSP_FRAGMENTS)
+		     : isis_fragment_tlvs(tlvs, tlv_space);
 	if (!fragments) {
 		zlog_warn("BUG: could not fragment own LSP:");
 		log_multiline(LOG_WARNING, "    ", "%s",
@@ -1314,7 +1371,7 @@ int lsp_generate(struct isis_area *area, int level)
 
 	lsp_insert(&area->lspdb[level - 1], newlsp);
 	/* build_lsp_data (newlsp, area); */
-	lsp_build(newlsp, area);
+	lsp_build(newlsp, area, NULL);
 	/* time to calculate our checksum */
 	lsp_seqno_update(newlsp);
 	newlsp->last_generated = time(NULL);
@@ -1322,6 +1379,8 @@ int lsp_generate(struct isis_area *area, int level)
 	area->lsp_gen_count[level - 1]++;
 
 	refresh_time = lsp_refresh_time(newlsp, rem_lifetime);
+	area->lsp_refresh_due[level - 1] =
+		newlsp->last_generated + refresh_time;
 
 	thread_cancel(&area->t_lsp_refresh[level - 1]);
 	area->lsp_regenerate_pending[level - 1] = 0;
@@ -1351,15 +1410,55 @@ int lsp_generate(struct isis_area *area, int level)
 }
 
 /*
- * Search own LSPs, update holding time and flood
+ * Take the TLVs off our own fragments, keeping a copy of the PDUs they are
+ * advertising.
+ */
+static void lsp_stash_frag(struct isis_lsp *lsp, struct isis_tlvs **tlvs,
+			   struct stream **pdus)
+{
+	uint8_t n = LSP_FRAGMENT(lsp->hdr.lsp_id);
+
+	tlvs[n] = lsp->tlvs;
+	lsp->tlvs = NULL;
+	if (tlvs[n] && lsp->hdr.rem_lifetime && lsp->pdu)
+		pdus[n] = stream_dup(lsp->pdu);
+}
+
+/*
+ * Check if the fragment's new content, packed with the sequence number it
+ * has, gives the PDU it is advertising already.
+ */
+static bool lsp_frag_unchanged(struct isis_lsp *lsp, struct stream *prev)
+{
+	size_t len;
+
+	if (!prev)
+		return false;
+
+	lsp_pack_pdu(lsp);
+	len = stream_get_endp(lsp->pdu);
+	/* from the LSP ID on, as the checksum */
+	return len == stream_get_endp(prev)
+	       && !memcmp(STREAM_DATA(lsp->pdu) + 12, STREAM_DATA(prev) + 12,
+			  len - 12);
+}
+
+/*
+ * Search own LSPs, update holding time and flood.  Unless full is set or
+ * it's time to refresh all of them anyway, only the fragments whose content
+ * changed get a new sequence number and are flooded.
  */
-static int lsp_regenerate(struct isis_area *area, int level)
+static int lsp_regenerate(struct isis_area *area, int level, bool full)
 {
 	struct lspdb_head *head;
 	struct isis_lsp *lsp, *frag;
 	struct listnode *node;
 	uint8_t lspid[ISIS_SYS_ID_LEN + 2];
 	uint16_t rem_lifetime, refresh_time;
+	struct isis_tlvs *prev_tlvs[ISIS_LSP_FRAGMENTS] = {};
+	struct stream *prev_pdus[ISIS_LSP_FRAGMENTS] = {};
+	unsigned int n, unchanged = 0;
+	time_t now;
 
 	if ((area == NULL) || (area->is_type & level) != level)
 		return ISIS_ERROR;
@@ -1377,35 +1476,75 @@ static int lsp_regenerate(struct isis_area *area, int level)
 		return ISIS_ERROR;
 	}
 
-	lsp_clear_data(lsp);
-	lsp_build(lsp, area);
+	now = time(NULL);
+	if (now >= area->lsp_refresh_due[level - 1])
+		full = true;
+
+	/*
+	 * Without a full refresh, the items are kept in the fragments they
+	 * were in so the unaffected ones come out the same.  A full refresh
+	 * packs them tightly again.
+	 */
+	lsp_stash_frag(lsp, prev_tlvs, prev_pdus);
+	for (ALL_LIST_ELEMENTS_RO(lsp->lspu.frags, node, frag))
+		lsp_stash_frag(frag, prev_tlvs, prev_pdus);
+
+	lsp_build(lsp, area, full ? NULL : prev_tlvs);
 	rem_lifetime = lsp_rem_lifetime(area, level);
-	lsp->hdr.rem_lifetime = rem_lifetime;
-	lsp->last_generated = time(NULL);
-	lsp_flood(lsp, NULL);
+	lsp->last_generated = now;
 	area->lsp_gen_count[level - 1]++;
+
+	if (lsp->tlvs && !full && lsp_frag_unchanged(lsp, prev_pdus[0]))
+		unchanged++;
+	else {
+		lsp->hdr.rem_lifetime = rem_lifetime;
+		lsp_inc_seqno(lsp, 0);
+		lsp_flood(lsp, NULL);
+	}
+
 	for (ALL_LIST_ELEMENTS_RO(lsp->lspu.frags, node, frag)) {
 		if (!frag->tlvs) {
-			/* Updating and flooding should only affect fragments
-			 * carrying data
+			/* Purge should only be applied when the fragment has
+			 * non-zero remaining lifetime.
 			 */
+			if (frag->hdr.rem_lifetime)
+				lsp_purge(frag, level, NULL);
 			continue;
 		}
 
 		frag->hdr.lsp_bits =
 			lsp_bits_generate(level, area->overload_bit,
 					  area->attached_bit_send, area);
+		if (!full
+		    && lsp_frag_unchanged(
+			    frag, prev_pdus[LSP_FRAGMENT(frag->hdr.lsp_id)])) {
+			unchanged++;
+			continue;
+		}
+
 		/* Set the lifetime values of all the fragments to the same
 		 * value,
 		 * so that no fragment expires before the lsp is refreshed.
 		 */
 		frag->hdr.rem_lifetime = rem_lifetime;
 		frag->age_out = ZERO_AGE_LIFETIME;
+		lsp_inc_seqno(frag, 0);
 		lsp_flood(frag, NULL);
 	}
-	lsp_seqno_update(lsp);
 
+	for (n = 0; n < ISIS_LSP_FRAGMENTS; n++) {
+		isis_free_tlvs(prev_tlvs[n]);
+		if (prev_pdus[n])
+			stream_free(prev_pdus[n]);
+	}
+
+	/* the unchanged fragments still need refreshing by the old due time */
 	refresh_time = lsp_refresh_time(lsp, rem_lifetime);
+	if (full)
+		area->lsp_refresh_due[level - 1] = now + refresh_time;
+	else
+		refresh_time = MIN(refresh_time,
+				   area->lsp_refresh_due[level - 1] - now);
 	thread_add_timer(master, lsp_refresh,
 			 &area->lsp_refresh_arg[level - 1], refresh_time,
 			 &area->t_lsp_refresh[level - 1]);
@@ -1413,10 +1552,10 @@ static int lsp_regenerate(struct isis_area *area, int level)
 
 	if (IS_DEBUG_UPDATE_PACKETS) {
 		zlog_debug(
-			"ISIS-Upd (%s): Refreshed our L%d LSP %s, len %hu, seq 0x%08x, cksum 0x%04hx, lifetime %hus refresh %hus",
+			"ISIS-Upd (%s): Refreshed our L%d LSP %s, len %hu, seq 0x%08x, cksum 0x%04hx, lifetime %hus refresh %hus, %u fragments unchanged",
 			area->area_tag, level, rawlspid_print(lsp->hdr.lsp_id),
 			lsp->hdr.pdu_len, lsp->hdr.seqno, lsp->hdr.checksum,
-			lsp->hdr.rem_lifetime, refresh_time);
+			lsp->hdr.rem_lifetime, refresh_time, unchanged);
 	}
 	sched_debug(
 		"ISIS (%s): Rebuilt L%d LSP. Set triggered regenerate to non-pending.",
@@ -1439,6 +1578,8 @@ static int lsp_refresh(struct thread *thread)
 	assert(area);
 
 	int level = arg->level;
+	/* the timer runs for a triggered update or a periodic refresh */
+	bool full = !area->lsp_regenerate_pending[level - 1];
 
 	area->t_lsp_refresh[level - 1] = NULL;
 	area->lsp_regenerate_pending[level - 1] = 0;
@@ -1463,7 +1604,7 @@ static int lsp_refresh(struct thread *thread)
 	sched_debug(
 		"ISIS (%s): LSP L%d refresh timer expired. Refreshing LSP...",
 		area->area_tag, level);
-	return lsp_regenerate(area, level);
+	return lsp_regenerate(area, level, full);
 }
 
 int _lsp_regenerate_schedule(struct isis_area *area, int level,
@@ -2108,6 +2249,13 @@ void lsp_set_all_srmflags(struct isis_lsp *lsp, bool set)
 	}
 }
 
+/* Acknowledge lsp with the circuit's next PSNP. */
+void lsp_set_ssn(struct isis_lsp *lsp, struct isis_circuit *circuit)
+{
+	ISIS_SET_FLAG(lsp->SSNflags, circuit);
+	circuit->psnp_pending[lsp->level - 1] = true;
+}
+
 void _lsp_flood(struct isis_lsp *lsp, struct isis_circuit *circuit,
 		const char *func, const char *file, int line)
 {
@@ -2119,10 +2267,14 @@ void _lsp_flood(struct isis_lsp *lsp, struct isis_circuit *circuit,
 			   func, file, line);
 	}
 
-	if (!fabricd)
-		lsp_set_all_srmflags(lsp, true);
-	else
+	frrtrace(2, frr_isis, lsp_flood, lsp, circuit);
+
+	if (fabricd)
 		fabricd_lsp_flood(lsp, circuit);
+	else if (isis_flood_topo_active(lsp))
+		isis_flood_topo_flood(lsp);
+	else
+		lsp_set_all_srmflags(lsp, true);
 
 	if (circuit)
 		isis_tx_queue_del(circuit->tx_queue, lsp);
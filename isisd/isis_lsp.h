@@ -107,6 +107,7 @@ void lsp_purge_non_exist(int level, struct isis_lsp_hdr *hdr,
 
 #define LSP_PSEUDO_ID(I) ((I)[ISIS_SYS_ID_LEN])
 #define LSP_FRAGMENT(I) ((I)[ISIS_SYS_ID_LEN + 1])
+#define ISIS_LSP_FRAGMENTS 256
 #define OWNLSPID(I)                                                            \
 	memcpy((I), isis->sysid, ISIS_SYS_ID_LEN);                             \
 	(I)[ISIS_SYS_ID_LEN] = 0;                                              \
@@ -117,6 +118,15 @@ int lsp_compare(char *areatag, struct isis_lsp *lsp, uint32_t seqno,
 void lsp_update(struct isis_lsp *lsp, struct isis_lsp_hdr *hdr,
 		struct isis_tlvs *tlvs, struct stream *stream,
 		struct isis_area *area, int level, bool confusion);
+/* Check if a received LSP PDU carries the same TLVs as lsp, apart from
+ * authentication, so it can be taken with lsp_update_same() without
+ * decoding them.
+ */
+bool lsp_same_tlvs(struct isis_lsp *lsp, struct stream *stream,
+		   size_t tlv_start);
+void lsp_update_same(struct isis_lsp *lsp, struct isis_lsp_hdr *hdr,
+		     struct isis_tlvs *auth, struct stream *stream,
+		     struct isis_area *area, int level);
 void lsp_inc_seqno(struct isis_lsp *lsp, uint32_t seqno);
 void lspid_print(uint8_t *lsp_id, char *dest, size_t dest_len, char dynhost,
 		 char frag, struct isis *isis);
@@ -128,6 +138,7 @@ int lsp_print_all(struct vty *vty, struct lspdb_head *head, char detail,
 		  char dynhost, struct isis *isis);
 /* sets SRMflags for all active circuits of an lsp */
 void lsp_set_all_srmflags(struct isis_lsp *lsp, bool set);
+void lsp_set_ssn(struct isis_lsp *lsp, struct isis_circuit *circuit);
 
 #define LSP_ITER_CONTINUE 0
 #define LSP_ITER_STOP -1
@@ -100,6 +100,13 @@ const struct frr_yang_module_info frr_isisd_info = {
 				.modify = isis_instance_purge_originator_modify,
 			},
 		},
+		{
+			.xpath = "/frr-isisd:isis/instance/dynamic-flooding",
+			.cbs = {
+				.cli_show = cli_show_isis_dynamic_flooding,
+				.modify = isis_instance_dynamic_flooding_modify,
+			},
+		},
 		{
 			.xpath = "/frr-isisd:isis/instance/lsp/mtu",
 			.cbs = {
@@ -107,6 +114,24 @@ const struct frr_yang_module_info frr_isisd_info = {
 				.modify = isis_instance_lsp_mtu_modify,
 			},
 		},
+		{
+			.xpath = "/frr-isisd:isis/instance/lsp/flooding",
+			.cbs = {
+				.cli_show = cli_show_isis_lsp_flooding,
+			},
+		},
+		{
+			.xpath = "/frr-isisd:isis/instance/lsp/flooding/rate",
+			.cbs = {
+				.modify = isis_instance_lsp_flooding_rate_modify,
+			},
+		},
+		{
+			.xpath = "/frr-isisd:isis/instance/lsp/flooding/burst",
+			.cbs = {
+				.modify = isis_instance_lsp_flooding_burst_modify,
+			},
+		},
 		{
 			.xpath = "/frr-isisd:isis/instance/lsp/timers",
 			.cbs = {
@@ -230,6 +255,13 @@ const struct frr_yang_module_info frr_isisd_info = {
 				.destroy = isis_instance_spf_prefix_priorities_medium_access_list_name_destroy,
 			}
 		},
+		{
+			.xpath = "/frr-isisd:isis/instance/spf/threads",
+			.cbs = {
+				.cli_show = cli_show_isis_spf_threads,
+				.modify = isis_instance_spf_threads_modify,
+			},
+		},
 		{
 			.xpath = "/frr-isisd:isis/instance/area-password",
 			.cbs = {
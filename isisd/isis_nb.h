@@ -40,7 +40,10 @@ int isis_instance_attached_modify(struct nb_cb_modify_args *args);
 int isis_instance_overload_modify(struct nb_cb_modify_args *args);
 int isis_instance_metric_style_modify(struct nb_cb_modify_args *args);
 int isis_instance_purge_originator_modify(struct nb_cb_modify_args *args);
+int isis_instance_dynamic_flooding_modify(struct nb_cb_modify_args *args);
 int isis_instance_lsp_mtu_modify(struct nb_cb_modify_args *args);
+int isis_instance_lsp_flooding_rate_modify(struct nb_cb_modify_args *args);
+int isis_instance_lsp_flooding_burst_modify(struct nb_cb_modify_args *args);
 int isis_instance_lsp_refresh_interval_level_1_modify(
 	struct nb_cb_modify_args *args);
 int isis_instance_lsp_refresh_interval_level_2_modify(
@@ -82,6 +85,7 @@ int isis_instance_spf_prefix_priorities_medium_access_list_name_modify(
 	struct nb_cb_modify_args *args);
 int isis_instance_spf_prefix_priorities_medium_access_list_name_destroy(
 	struct nb_cb_destroy_args *args);
+int isis_instance_spf_threads_modify(struct nb_cb_modify_args *args);
 int isis_instance_area_password_create(struct nb_cb_create_args *args);
 int isis_instance_area_password_destroy(struct nb_cb_destroy_args *args);
 int isis_instance_area_password_password_modify(struct nb_cb_modify_args *args);
@@ -443,14 +447,20 @@ void cli_show_isis_lsp_timers(struct vty *vty, struct lyd_node *dnode,
 			      bool show_defaults);
 void cli_show_isis_lsp_mtu(struct vty *vty, struct lyd_node *dnode,
 			   bool show_defaults);
+void cli_show_isis_lsp_flooding(struct vty *vty, struct lyd_node *dnode,
+				bool show_defaults);
 void cli_show_isis_spf_min_interval(struct vty *vty, struct lyd_node *dnode,
 				    bool show_defaults);
 void cli_show_isis_spf_ietf_backoff(struct vty *vty, struct lyd_node *dnode,
 				    bool show_defaults);
 void cli_show_isis_spf_prefix_priority(struct vty *vty, struct lyd_node *dnode,
 				       bool show_defaults);
+void cli_show_isis_spf_threads(struct vty *vty, struct lyd_node *dnode,
+			       bool show_defaults);
 void cli_show_isis_purge_origin(struct vty *vty, struct lyd_node *dnode,
 				bool show_defaults);
+void cli_show_isis_dynamic_flooding(struct vty *vty, struct lyd_node *dnode,
+				    bool show_defaults);
 void cli_show_isis_mpls_te(struct vty *vty, struct lyd_node *dnode,
 			   bool show_defaults);
 void cli_show_isis_mpls_te_router_addr(struct vty *vty, struct lyd_node *dnode,
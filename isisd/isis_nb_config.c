@@ -45,6 +45,8 @@
 #include "isisd/isis_csm.h"
 #include "isisd/isis_adjacency.h"
 #include "isisd/isis_spf.h"
+#include "isisd/isis_spf_pool.h"
+#include "isisd/isis_flood_topo.h"
 #include "isisd/isis_spf_private.h"
 #include "isisd/isis_te.h"
 #include "isisd/isis_mt.h"
@@ -386,6 +388,24 @@ int isis_instance_purge_originator_modify(struct nb_cb_modify_args *args)
 	return NB_OK;
 }
 
+/*
+ * XPath: /frr-isisd:isis/instance/dynamic-flooding
+ */
+int isis_instance_dynamic_flooding_modify(struct nb_cb_modify_args *args)
+{
+	struct isis_area *area;
+
+	if (args->event != NB_EV_APPLY)
+		return NB_OK;
+
+	area = nb_running_get_entry(args->dnode, NULL, true);
+	area->dynamic_flooding = yang_dnode_get_bool(args->dnode, NULL);
+	isis_flood_topo_compute(area, ISIS_LEVEL1);
+	isis_flood_topo_compute(area, ISIS_LEVEL2);
+
+	return NB_OK;
+}
+
 /*
  * XPath: /frr-isisd:isis/instance/lsp/mtu
  */
@@ -427,6 +447,38 @@ int isis_instance_lsp_mtu_modify(struct nb_cb_modify_args *args)
 	return NB_OK;
 }
 
+/*
+ * XPath: /frr-isisd:isis/instance/lsp/flooding/rate
+ */
+int isis_instance_lsp_flooding_rate_modify(struct nb_cb_modify_args *args)
+{
+	struct isis_area *area;
+
+	if (args->event != NB_EV_APPLY)
+		return NB_OK;
+
+	area = nb_running_get_entry(args->dnode, NULL, true);
+	area->flood_rate = yang_dnode_get_uint16(args->dnode, NULL);
+
+	return NB_OK;
+}
+
+/*
+ * XPath: /frr-isisd:isis/instance/lsp/flooding/burst
+ */
+int isis_instance_lsp_flooding_burst_modify(struct nb_cb_modify_args *args)
+{
+	struct isis_area *area;
+
+	if (args->event != NB_EV_APPLY)
+		return NB_OK;
+
+	area = nb_running_get_entry(args->dnode, NULL, true);
+	area->flood_burst = yang_dnode_get_uint16(args->dnode, NULL);
+
+	return NB_OK;
+}
+
 /*
  * XPath: /frr-isisd:isis/instance/lsp/timers/level-1/refresh-interval
  */
@@ -817,6 +869,23 @@ int isis_instance_spf_prefix_priorities_medium_access_list_name_destroy(
 	return NB_OK;
 }
 
+/*
+ * XPath: /frr-isisd:isis/instance/spf/threads
+ */
+int isis_instance_spf_threads_modify(struct nb_cb_modify_args *args)
+{
+	struct isis_area *area;
+
+	if (args->event != NB_EV_APPLY)
+		return NB_OK;
+
+	area = nb_running_get_entry(args->dnode, NULL, true);
+	area->spf_threads = yang_dnode_get_uint8(args->dnode, NULL);
+	isis_spf_pool_update();
+
+	return NB_OK;
+}
+
 /*
  * XPath: /frr-isisd:isis/instance/area-password
  */
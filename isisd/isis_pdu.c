@@ -818,6 +818,80 @@ static void lsp_flood_or_update(struct isis_lsp *lsp,
  * ISO - 10589
  * Section 7.3.15.1 - Action on receipt of a link state PDU
  */
+static void lsp_unpack_error(struct isis_circuit *circuit, uint8_t *lsp_id,
+			     char *raw_pdu, size_t raw_pdu_len,
+			     const char *error_log)
+{
+	zlog_warn("Something went wrong unpacking the LSP: %s", error_log);
+#ifndef FABRICD
+	/* send northbound notification. Note that the tlv-type and
+	 * offset cannot correctly be set here as they are not returned
+	 * by isis_unpack_tlvs, but in there I cannot fire a
+	 * notification because I have no circuit information. So until
+	 * we change the code above to return those extra fields, we
+	 * will send dummy values which are ignored in the callback
+	 */
+	circuit->lsp_error_counter++;
+	if (circuit->is_type == IS_LEVEL_1) {
+		circuit->area->lsp_error_counter[0]++;
+	} else if (circuit->is_type == IS_LEVEL_2) {
+		circuit->area->lsp_error_counter[1]++;
+	} else {
+		circuit->area->lsp_error_counter[0]++;
+		circuit->area->lsp_error_counter[1]++;
+	}
+
+	isis_notif_lsp_error(circuit, lsp_id, raw_pdu, raw_pdu_len, 0, 0);
+#endif /* ifndef FABRICD */
+}
+
+/*
+ * Decode all TLVs of a received LSP, which so far only has its
+ * authentication ones in tlvs.
+ */
+static bool lsp_unpack_all(struct isis_circuit *circuit, uint8_t *lsp_id,
+			   size_t tlv_start, struct isis_tlvs **tlvs,
+			   char *raw_pdu, size_t raw_pdu_len)
+{
+	const char *error_log;
+
+	isis_free_tlvs(*tlvs);
+	*tlvs = NULL;
+
+	stream_set_getp(circuit->rcv_stream, tlv_start);
+	if (!isis_unpack_tlvs(STREAM_READABLE(circuit->rcv_stream),
+			      circuit->rcv_stream, tlvs, &error_log))
+		return true;
+
+	lsp_unpack_error(circuit, lsp_id, raw_pdu, raw_pdu_len, error_log);
+	return false;
+}
+
+/*
+ * Update an LSP from a received instance.  If it carries the same TLVs,
+ * typically a refresh, the decoded ones are kept.
+ */
+static bool lsp_recv_update(struct isis_circuit *circuit, struct isis_lsp *lsp,
+			    struct isis_lsp_hdr *hdr, size_t tlv_start,
+			    struct isis_tlvs **tlvs, int level, char *raw_pdu,
+			    size_t raw_pdu_len)
+{
+	if (lsp_same_tlvs(lsp, circuit->rcv_stream, tlv_start)) {
+		lsp_update_same(lsp, hdr, *tlvs, circuit->rcv_stream,
+				circuit->area, level);
+		return true;
+	}
+
+	if (!lsp_unpack_all(circuit, hdr->lsp_id, tlv_start, tlvs, raw_pdu,
+			    raw_pdu_len))
+		return false;
+
+	lsp_update(lsp, hdr, *tlvs, circuit->rcv_stream, circuit->area, level,
+		   false);
+	*tlvs = NULL;
+	return true;
+}
+
 static int process_lsp(uint8_t pdu_type, struct isis_circuit *circuit,
 		       const uint8_t *ssnpa, uint8_t max_area_addrs)
 {
@@ -936,32 +1010,15 @@ static int process_lsp(uint8_t pdu_type, struct isis_circuit *circuit,
 	struct isis_tlvs *tlvs = NULL;
 	int retval = ISIS_WARNING;
 	const char *error_log;
+	size_t tlv_start = stream_get_getp(circuit->rcv_stream);
 
-	if (isis_unpack_tlvs(STREAM_READABLE(circuit->rcv_stream),
-			     circuit->rcv_stream, &tlvs, &error_log)) {
-		zlog_warn("Something went wrong unpacking the LSP: %s",
-			  error_log);
-#ifndef FABRICD
-		/* send northbound notification. Note that the tlv-type and
-		 * offset cannot correctly be set here as they are not returned
-		 * by isis_unpack_tlvs, but in there I cannot fire a
-		 * notification because I have no circuit information. So until
-		 * we change the code above to return those extra fields, we
-		 * will send dummy values which are ignored in the callback
-		 */
-		circuit->lsp_error_counter++;
-		if (circuit->is_type == IS_LEVEL_1) {
-			circuit->area->lsp_error_counter[0]++;
-		} else if (circuit->is_type == IS_LEVEL_2) {
-			circuit->area->lsp_error_counter[1]++;
-		} else {
-			circuit->area->lsp_error_counter[0]++;
-			circuit->area->lsp_error_counter[1]++;
-		}
-
-		isis_notif_lsp_error(circuit, hdr.lsp_id, raw_pdu,
-				     sizeof(raw_pdu), 0, 0);
-#endif /* ifndef FABRICD */
+	/* The rest is only decoded if the LSP goes into the LSPDB and
+	 * changed, see lsp_unpack_all().
+	 */
+	if (isis_unpack_auth_tlvs(STREAM_READABLE(circuit->rcv_stream),
+				  circuit->rcv_stream, &tlvs, &error_log)) {
+		lsp_unpack_error(circuit, hdr.lsp_id, raw_pdu, sizeof(raw_pdu),
+				 error_log);
 		goto out;
 	}
 
@@ -1093,6 +1150,11 @@ dontcheckadj:
 				/* LSP by some other system -> do 7.3.16.4 b) */
 				/* 7.3.16.4 b) 1)  */
 				if (comp == LSP_NEWER) {
+					if (!lsp_unpack_all(circuit, hdr.lsp_id,
+							    tlv_start, &tlvs,
+							    raw_pdu,
+							    sizeof(raw_pdu)))
+						goto out;
 					lsp_update(lsp, &hdr, tlvs,
 						   circuit->rcv_stream,
 						   circuit->area, level,
@@ -1123,9 +1185,8 @@ dontcheckadj:
 						/* iv */
 						if (circuit->circ_type
 						    != CIRCUIT_T_BROADCAST)
-							ISIS_SET_FLAG(
-								lsp->SSNflags,
-								circuit);
+							lsp_set_ssn(lsp,
+								    circuit);
 					}
 				} /* 7.3.16.4 b) 2) */
 				else if (comp == LSP_EQUAL) {
@@ -1135,8 +1196,7 @@ dontcheckadj:
 					/* ii */
 					if (circuit->circ_type
 					    != CIRCUIT_T_BROADCAST)
-						ISIS_SET_FLAG(lsp->SSNflags,
-							      circuit);
+						lsp_set_ssn(lsp, circuit);
 				} /* 7.3.16.4 b) 3) */
 				else {
 					isis_tx_queue_add(circuit->tx_queue,
@@ -1216,7 +1276,7 @@ dontcheckadj:
 		} else if (comp == LSP_EQUAL) {
 			isis_tx_queue_del(circuit->tx_queue, lsp);
 			if (circuit->circ_type != CIRCUIT_T_BROADCAST)
-				ISIS_SET_FLAG(lsp->SSNflags, circuit);
+				lsp_set_ssn(lsp, circuit);
 		} else {
 			isis_tx_queue_add(circuit->tx_queue, lsp,
 					  TX_LSP_NORMAL);
@@ -1247,6 +1307,10 @@ dontcheckadj:
 			}
 			/* i */
 			if (!lsp) {
+				if (!lsp_unpack_all(circuit, hdr.lsp_id,
+						    tlv_start, &tlvs, raw_pdu,
+						    sizeof(raw_pdu)))
+					goto out;
 				lsp = lsp_new_from_recv(
 					&hdr, tlvs, circuit->rcv_stream, lsp0,
 					circuit->area, level);
@@ -1255,25 +1319,27 @@ dontcheckadj:
 					   lsp);
 			} else /* exists, so we overwrite */
 			{
-				lsp_update(lsp, &hdr, tlvs, circuit->rcv_stream,
-					   circuit->area, level, false);
-				tlvs = NULL;
+				if (!lsp_recv_update(circuit, lsp, &hdr,
+						     tlv_start, &tlvs, level,
+						     raw_pdu, sizeof(raw_pdu)))
+					goto out;
 			}
 			lsp_flood_or_update(lsp, circuit, circuit_scoped);
 
 			/* iv */
 			if (circuit->circ_type != CIRCUIT_T_BROADCAST)
-				ISIS_SET_FLAG(lsp->SSNflags, circuit);
+				lsp_set_ssn(lsp, circuit);
 			/* FIXME: v) */
 		}
 		/* 7.3.15.1 e) 2) LSP equal to the one in db */
 		else if (comp == LSP_EQUAL) {
+			if (!lsp_recv_update(circuit, lsp, &hdr, tlv_start,
+					     &tlvs, level, raw_pdu,
+					     sizeof(raw_pdu)))
+				goto out;
 			isis_tx_queue_del(circuit->tx_queue, lsp);
-			lsp_update(lsp, &hdr, tlvs, circuit->rcv_stream,
-				   circuit->area, level, false);
-			tlvs = NULL;
 			if (circuit->circ_type != CIRCUIT_T_BROADCAST)
-				ISIS_SET_FLAG(lsp->SSNflags, circuit);
+				lsp_set_ssn(lsp, circuit);
 		}
 		/* 7.3.15.1 e) 3) LSP older than the one in db */
 		else {
@@ -1513,7 +1579,7 @@ static int process_snp(uint8_t pdu_type, struct isis_circuit *circuit,
 					isis_tx_queue_add(circuit->tx_queue, lsp,
 							TX_LSP_NORMAL);
 				} else {
-					ISIS_SET_FLAG(lsp->SSNflags, circuit);
+					lsp_set_ssn(lsp, circuit);
 					/* if (circuit->circ_type !=
 					 * CIRCUIT_T_BROADCAST) */
 					isis_tx_queue_del(circuit->tx_queue, lsp);
@@ -1551,7 +1617,7 @@ static int process_snp(uint8_t pdu_type, struct isis_circuit *circuit,
 					   lsp);
 
 				lsp_set_all_srmflags(lsp, false);
-				ISIS_SET_FLAG(lsp->SSNflags, circuit);
+				lsp_set_ssn(lsp, circuit);
 				resync_needed = true;
 			}
 		}
@@ -2305,6 +2371,10 @@ static int send_psnp(int level, struct isis_circuit *circuit)
 	uint8_t pdu_type = (level == ISIS_LEVEL1) ? L1_PARTIAL_SEQ_NUM
 						  : L2_PARTIAL_SEQ_NUM;
 
+	/* nothing to acknowledge, no need to go through the LSPDB */
+	if (!circuit->psnp_pending[level - 1])
+		return ISIS_OK;
+
 	isis_circuit_stream(circuit, &circuit->snd_stream);
 	fill_fixed_hdr(pdu_type, circuit->snd_stream);
 
@@ -2349,6 +2419,7 @@ static int send_psnp(int level, struct isis_circuit *circuit)
 		}
 
 		if (!tlvs->lsp_entries.count) {
+			circuit->psnp_pending[level - 1] = false;
 			isis_free_tlvs(tlvs);
 			return ISIS_OK;
 		}
@@ -600,6 +600,9 @@ static void _isis_route_verify_table(struct isis_area *area,
 
 		isis_route_delete(area, rnode, table);
 	}
+
+	/* Only the Prefix-SIDs of changed routes were queued */
+	isis_zebra_prefix_sid_flush();
 }
 
 void isis_route_verify_table(struct isis_area *area, struct route_table *table,
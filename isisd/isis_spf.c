@@ -58,7 +58,9 @@
 #include "isis_tlvs.h"
 #include "isis_zebra.h"
 #include "fabricd.h"
+#include "isis_flood_topo.h"
 #include "isis_spf_private.h"
+#include "isis_trace.h"
 
 DEFINE_MTYPE_STATIC(ISISD, ISIS_SPFTREE,    "ISIS SPFtree");
 DEFINE_MTYPE_STATIC(ISISD, ISIS_SPF_RUN,    "ISIS SPF Run Info");
@@ -374,6 +376,8 @@ struct isis_spftree *isis_spftree_new(struct isis_area *area,
 	isis_rlfa_list_init(tree);
 	tree->lfa.remote.pc_spftrees = list_new();
 	tree->lfa.remote.pc_spftrees->del = (void (*)(void *))isis_spftree_del;
+	tree->lfa.tilfa.pc_spftrees = list_new();
+	tree->lfa.tilfa.pc_spftrees->del = (void (*)(void *))isis_spftree_del;
 	if (tree->type == SPF_TYPE_RLFA || tree->type == SPF_TYPE_TI_LFA) {
 		isis_spf_node_list_init(&tree->lfa.p_space);
 		isis_spf_node_list_init(&tree->lfa.q_space);
@@ -389,6 +393,9 @@ void isis_spftree_del(struct isis_spftree *spftree)
 	isis_zebra_rlfa_unregister_all(spftree);
 	isis_rlfa_list_clear(spftree);
 	list_delete(&spftree->lfa.remote.pc_spftrees);
+	list_delete(&spftree->lfa.tilfa.pc_spftrees);
+	if (spftree->lfa.spftree_reverse)
+		isis_spftree_del(spftree->lfa.spftree_reverse);
 	if (spftree->type == SPF_TYPE_RLFA
 	    || spftree->type == SPF_TYPE_TI_LFA) {
 		isis_spf_node_list_clear(&spftree->lfa.q_space);
@@ -466,6 +473,7 @@ static int spf_adj_state_change(struct isis_adjacency *adj)
 				continue;
 			isis_spftree_adj_del(area->spftree[tree][level - 1],
 					     adj);
+			area->spftree[tree][level - 1]->spt_current = false;
 		}
 	}
 
@@ -789,11 +797,14 @@ static void process_N(struct isis_spftree *spftree, enum vertextype vtype,
 
 /*
  * C.2.6 Step 1
+ *
+ * With ip_only set the IS reachability is skipped, which is used to add the
+ * IP prefixes to an SPT kept from the previous run.
  */
 static int isis_spf_process_lsp(struct isis_spftree *spftree,
 				struct isis_lsp *lsp, uint32_t cost,
 				uint16_t depth, uint8_t *root_sysid,
-				struct isis_vertex *parent)
+				struct isis_vertex *parent, bool ip_only)
 {
 	bool pseudo_lsp = LSP_PSEUDO_ID(lsp->hdr.lsp_id);
 	struct listnode *fragnode = NULL;
@@ -843,7 +854,7 @@ lspfragloop:
 		   print_sys_hostname(lsp->hdr.lsp_id));
 #endif /* EXTREME_DEBUG */
 
-	if (no_overload) {
+	if (no_overload && !ip_only) {
 		if ((pseudo_lsp || spftree->mtid == ISIS_MT_IPV4_UNICAST)
 		    && spftree->area->oldmetric) {
 			struct isis_oldstyle_reach *r;
@@ -1233,7 +1244,7 @@ static void isis_spf_preload_tent(struct isis_spftree *spftree,
 					   parent);
 		} else if (sadj->lsp) {
 			isis_spf_process_lsp(spftree, sadj->lsp, metric, 0,
-					     spftree->sysid, parent);
+					     spftree->sysid, parent, false);
 		}
 	}
 }
@@ -1495,6 +1506,11 @@ static void init_spt(struct isis_spftree *spftree, int mtid)
 	isis_zebra_rlfa_unregister_all(spftree);
 	isis_rlfa_list_clear(spftree);
 	list_delete_all_node(spftree->lfa.remote.pc_spftrees);
+	list_delete_all_node(spftree->lfa.tilfa.pc_spftrees);
+	if (spftree->lfa.spftree_reverse) {
+		isis_spftree_del(spftree->lfa.spftree_reverse);
+		spftree->lfa.spftree_reverse = NULL;
+	}
 	memset(&spftree->lfa.protection_counters, 0,
 	       sizeof(spftree->lfa.protection_counters));
 
@@ -1535,6 +1551,48 @@ spf_prefix_priority(struct isis_spftree *spftree, struct isis_vertex *vertex)
 	return SPF_PREFIX_PRIO_LOW;
 }
 
+/**
+ * Install the repair paths of a TI-LFA post-convergence SPF vertex: a backup
+ * Adj-SID for IS vertices, a backup route for IP vertices.
+ *
+ * @param spftree	The post-convergence SPF tree
+ * @param vertex	IS-IS SPF vertex that passed isis_tilfa_check()
+ */
+void isis_spf_tilfa_install(struct isis_spftree *spftree,
+			    struct isis_vertex *vertex)
+{
+	struct isis_spftree *pre_spftree = spftree->lfa.old.spftree;
+	struct isis_area *area = spftree->area;
+	int level = spftree->level;
+	struct isis_adjacency *adj;
+
+	if (VTYPE_IS(vertex->type)) {
+		adj = isis_adj_find(area, level, vertex->N.id);
+		if (adj)
+			sr_adj_sid_add_single(adj, spftree->family, true,
+					      vertex->Adj_N);
+		return;
+	}
+
+	pre_spftree->lfa.protection_counters.tilfa[vertex->N.ip.priority] += 1;
+	isis_route_create(&vertex->N.ip.p.dest, &vertex->N.ip.p.src,
+			  vertex->d_N, vertex->depth, &vertex->N.ip.sr,
+			  vertex->Adj_N, area->lfa_load_sharing[level - 1],
+			  area, pre_spftree->route_table_backup);
+}
+
+static void spf_path_process_tilfa(struct isis_spftree *spftree,
+				   struct isis_vertex *vertex)
+{
+	if (isis_tilfa_check(spftree, vertex) != 0)
+		return;
+
+	if (spftree->lfa.tilfa.install_queue)
+		listnode_add(spftree->lfa.tilfa.install_queue, vertex);
+	else
+		isis_spf_tilfa_install(spftree, vertex);
+}
+
 static void spf_path_process(struct isis_spftree *spftree,
 			     struct isis_vertex *vertex)
 {
@@ -1544,17 +1602,9 @@ static void spf_path_process(struct isis_spftree *spftree,
 
 	if (spftree->type == SPF_TYPE_TI_LFA && VTYPE_IS(vertex->type)
 	    && !CHECK_FLAG(spftree->flags, F_SPFTREE_NO_ADJACENCIES)) {
-		if (listcount(vertex->Adj_N) > 0) {
-			struct isis_adjacency *adj;
-
-			if (isis_tilfa_check(spftree, vertex) != 0)
-				return;
-
-			adj = isis_adj_find(area, level, vertex->N.id);
-			if (adj)
-				sr_adj_sid_add_single(adj, spftree->family,
-						      true, vertex->Adj_N);
-		} else if (IS_DEBUG_SPF_EVENTS)
+		if (listcount(vertex->Adj_N) > 0)
+			spf_path_process_tilfa(spftree, vertex);
+		else if (IS_DEBUG_SPF_EVENTS)
 			zlog_debug(
 				"ISIS-SPF: no adjacencies, do not install backup Adj-SID for %s depth %d dist %d",
 				vid2string(vertex, buff, sizeof(buff)),
@@ -1568,7 +1618,6 @@ static void spf_path_process(struct isis_spftree *spftree,
 		priority = spf_prefix_priority(spftree, vertex);
 		vertex->N.ip.priority = priority;
 		if (vertex->depth == 1 || listcount(vertex->Adj_N) > 0) {
-			struct isis_spftree *pre_spftree;
 			struct route_table *route_table;
 			bool allow_ecmp;
 
@@ -1597,15 +1646,8 @@ static void spf_path_process(struct isis_spftree *spftree,
 				isis_rlfa_check(spftree, vertex);
 				return;
 			case SPF_TYPE_TI_LFA:
-				if (isis_tilfa_check(spftree, vertex) != 0)
-					return;
-
-				pre_spftree = spftree->lfa.old.spftree;
-				route_table = pre_spftree->route_table_backup;
-				allow_ecmp = area->lfa_load_sharing[level - 1];
-				pre_spftree->lfa.protection_counters
-					.tilfa[vertex->N.ip.priority] += 1;
-				break;
+				spf_path_process_tilfa(spftree, vertex);
+				return;
 			default:
 				route_table = spftree->route_table;
 				allow_ecmp = true;
@@ -1666,7 +1708,7 @@ static void isis_spf_loop(struct isis_spftree *spftree,
 		}
 
 		isis_spf_process_lsp(spftree, lsp, vertex->d_N, vertex->depth,
-				     root_sysid, vertex);
+				     root_sysid, vertex, false);
 	}
 
 	/* Generate routes once the SPT is formed. */
@@ -1687,6 +1729,97 @@ static void isis_spf_loop(struct isis_spftree *spftree,
 	}
 }
 
+/*
+ * Partial route calculation: drop the IP prefixes from the SPT of the last
+ * run, keeping its IS vertices, and add them back from the current LSPs.
+ * Only valid if the IS reachability that led to the kept SPT is unchanged,
+ * see spf_lsp_change_mode().
+ */
+static void isis_spf_reuse_spt(struct isis_spftree *spftree,
+			       struct isis_lsp *root_lsp)
+{
+	struct spf_preload_tent_ip_reach_args ip_reach_args;
+	struct isis_vertex *root_vertex, *vertex;
+	struct isis_vertex_adj *vadj;
+	struct isis_spf_adj *sadj;
+	struct listnode *node, *nnode, *anode;
+	struct isis_lsp *lsp;
+
+	hash_clean(spftree->prefix_sids, NULL);
+	isis_vertex_queue_clear(&spftree->tents);
+	memset(&spftree->lfa.protection_counters, 0,
+	       sizeof(spftree->lfa.protection_counters));
+
+	for (ALL_LIST_ELEMENTS(spftree->paths.l.list, node, nnode, vertex)) {
+		if (!VTYPE_IP(vertex->type)) {
+			/* Handed over to the backup Adj-SIDs of the last run. */
+			for (ALL_LIST_ELEMENTS_RO(vertex->Adj_N, anode, vadj))
+				vadj->label_stack = NULL;
+			continue;
+		}
+
+		list_delete_node(spftree->paths.l.list, node);
+		hash_release(spftree->paths.hash, vertex);
+		isis_vertex_del(vertex);
+	}
+
+	/* Same as isis_spf_preload_tent(), minus the adjacencies. */
+	root_vertex = listgetdata(listhead(spftree->paths.l.list));
+	if (!CHECK_FLAG(spftree->flags, F_SPFTREE_HOPCOUNT_METRIC)) {
+		ip_reach_args.spftree = spftree;
+		ip_reach_args.parent = root_vertex;
+		isis_lsp_iterate_ip_reach(
+			root_lsp, spftree->family, spftree->mtid,
+			isis_spf_preload_tent_ip_reach_cb, &ip_reach_args);
+	}
+
+	for (ALL_LIST_ELEMENTS_RO(spftree->sadj_list, node, sadj)) {
+		const uint8_t *adj_id;
+
+		if (!LSP_PSEUDO_ID(sadj->id) || !sadj->lsp)
+			continue;
+
+		if (CHECK_FLAG(sadj->flags, F_ISIS_SPF_ADJ_BROADCAST))
+			adj_id = sadj->lan.desig_is_id;
+		else
+			adj_id = sadj->id;
+		if (isis_lfa_excise_adj_check(spftree, adj_id))
+			continue;
+
+		isis_spf_process_lsp(spftree, sadj->lsp, sadj->metric, 0,
+				     spftree->sysid, root_vertex, true);
+	}
+
+	/*
+	 * PATHS has the IS vertices in the order they were popped from TENT,
+	 * so the prefixes are offered in the same order as in a full run.
+	 */
+	for (ALL_QUEUE_ELEMENTS_RO(&spftree->paths, node, vertex)) {
+		if (vertex == root_vertex)
+			continue;
+
+		lsp = lsp_for_vertex(spftree, vertex);
+		if (!lsp)
+			continue;
+
+		isis_spf_process_lsp(spftree, lsp, vertex->d_N, vertex->depth,
+				     spftree->sysid, vertex, true);
+	}
+
+	isis_spf_loop(spftree, spftree->sysid);
+}
+
+static bool isis_spf_can_reuse(struct isis_spftree *spftree, uint16_t mtid)
+{
+	struct isis_area *area = spftree->area;
+
+	if (CHECK_FLAG(spftree->flags, F_SPFTREE_HOPCOUNT_METRIC))
+		return false;
+
+	return spftree->spt_current && spftree->mtid == mtid
+	       && area->spf_mode[spftree->level - 1] != ISIS_SPF_FULL;
+}
+
 struct isis_spftree *isis_run_hopcount_spf(struct isis_area *area,
 					   uint8_t *sysid,
 					   struct isis_spftree *spftree)
@@ -1731,6 +1864,7 @@ void isis_run_spf(struct isis_spftree *spftree)
 	struct timeval time_start;
 	struct timeval time_end;
 	struct isis_mt_router_info *mt_router_info;
+	enum isis_spf_mode mode;
 	uint16_t mtid = 0;
 
 	/* Get time that can't roll backwards. */
@@ -1765,6 +1899,13 @@ void isis_run_spf(struct isis_spftree *spftree)
 		exit(1);
 	}
 
+	if (isis_spf_can_reuse(spftree, mtid)) {
+		mode = spftree->area->spf_mode[spftree->level - 1];
+		isis_spf_reuse_spt(spftree, root_lsp);
+		goto out;
+	}
+	mode = ISIS_SPF_FULL;
+
 	/*
 	 * C.2.5 Step 0
 	 */
@@ -1785,12 +1926,18 @@ void isis_run_spf(struct isis_spftree *spftree)
 	}
 
 	isis_spf_loop(spftree, spftree->sysid);
+
+out:
+	spftree->spt_current = true;
+	spftree->mode_count[mode]++;
 	spftree->runcount++;
 	spftree->last_run_timestamp = time(NULL);
 	spftree->last_run_monotime = monotime(&time_end);
 	spftree->last_run_duration =
 		((time_end.tv_sec - time_start.tv_sec) * 1000000)
 		+ (time_end.tv_usec - time_start.tv_usec);
+
+	frrtrace(2, frr_isis, spf_run, spftree, mode);
 }
 
 static void isis_run_spf_with_protection(struct isis_area *area,
@@ -1849,33 +1996,48 @@ static int isis_run_spf_cb(struct thread *thread)
 		return ISIS_WARNING;
 	}
 
+	area->spf_mode[level - 1] = area->spf_pending_mode[level - 1];
+	area->spf_pending_mode[level - 1] = ISIS_SPF_PRC;
+	/* RLFAs are activated by LDP later on, so don't reuse any SPT. */
+	if (area->rlfa_protected_links[level - 1] > 0)
+		area->spf_mode[level - 1] = ISIS_SPF_FULL;
+
+	frrtrace(2, frr_isis, spf_start, area, level);
+
 	isis_area_delete_backup_adj_sids(area, level);
 	isis_area_invalidate_routes(area, level);
 
 	if (IS_DEBUG_SPF_EVENTS)
-		zlog_debug("ISIS-SPF (%s) L%d SPF needed, periodic SPF",
-			   area->area_tag, level);
+		zlog_debug("ISIS-SPF (%s) L%d SPF needed, periodic SPF (%s)",
+			   area->area_tag, level,
+			   isis_spf_mode2str(area->spf_mode[level - 1]));
 
 	if (area->ip_circuits) {
 		isis_run_spf_with_protection(
 			area, area->spftree[SPFTREE_IPV4][level - 1]);
 		have_run = 1;
-	}
+	} else
+		area->spftree[SPFTREE_IPV4][level - 1]->spt_current = false;
 	if (area->ipv6_circuits) {
 		isis_run_spf_with_protection(
 			area, area->spftree[SPFTREE_IPV6][level - 1]);
 		have_run = 1;
-	}
+	} else
+		area->spftree[SPFTREE_IPV6][level - 1]->spt_current = false;
 	if (area->ipv6_circuits && isis_area_ipv6_dstsrc_enabled(area)) {
 		isis_run_spf_with_protection(
 			area, area->spftree[SPFTREE_DSTSRC][level - 1]);
 		have_run = 1;
-	}
+	} else
+		area->spftree[SPFTREE_DSTSRC][level - 1]->spt_current = false;
 
-	if (have_run)
+	if (have_run) {
 		area->spf_run_count[level]++;
+		area->spf_mode_count[level - 1][area->spf_mode[level - 1]]++;
+	}
 
 	isis_area_verify_routes(area);
+	frrtrace(2, frr_isis, spf_done, area, level);
 
 	/* walk all circuits and reset any spf specific flags */
 	struct listnode *node;
@@ -1884,6 +2046,7 @@ static int isis_run_spf_cb(struct thread *thread)
 		UNSET_FLAG(circuit->flags, ISIS_CIRCUIT_FLAPPED_AFTER_SPF);
 
 	fabricd_run_spf(area);
+	isis_flood_topo_compute(area, level);
 
 	return 0;
 }
@@ -1904,7 +2067,8 @@ void isis_spf_timer_free(void *run)
 }
 
 int _isis_spf_schedule(struct isis_area *area, int level,
-		       const char *func, const char *file, int line)
+		       enum isis_spf_mode mode, const char *func,
+		       const char *file, int line)
 {
 	struct isis_spftree *spftree = area->spftree[SPFTREE_IPV4][level - 1];
 	time_t now = monotime(NULL);
@@ -1916,6 +2080,9 @@ int _isis_spf_schedule(struct isis_area *area, int level,
 	assert(diff >= 0);
 	assert(area->is_type & level);
 
+	area->spf_pending_mode[level - 1] =
+		MIN(area->spf_pending_mode[level - 1], mode);
+
 	if (IS_DEBUG_SPF_EVENTS) {
 		zlog_debug(
 			"ISIS-SPF (%s) L%d SPF schedule called, lastrun %d sec ago Caller: %s %s:%d",
@@ -1972,6 +2139,313 @@ int _isis_spf_schedule(struct isis_area *area, int level,
 	return ISIS_OK;
 }
 
+const char *isis_spf_mode2str(enum isis_spf_mode mode)
+{
+	switch (mode) {
+	case ISIS_SPF_FULL:
+		return "full";
+	case ISIS_SPF_INCREMENTAL:
+		return "incremental";
+	case ISIS_SPF_PRC:
+		return "partial";
+	case ISIS_SPF_MODE_MAX:
+		break;
+	}
+
+	return "unknown";
+}
+
+static void spf_reach_item(const struct isis_item *i, bool oldstyle,
+			   const uint8_t **id, uint32_t *metric)
+{
+	if (oldstyle) {
+		const struct isis_oldstyle_reach *r = (const void *)i;
+
+		*id = r->id;
+		*metric = r->metric;
+	} else {
+		const struct isis_extended_reach *r = (const void *)i;
+
+		*id = r->id;
+		*metric = r->metric;
+	}
+}
+
+/* Lowest metric towards id, as used by process_N(), or UINT32_MAX. */
+static uint32_t spf_reach_metric(const struct isis_item *head, bool oldstyle,
+				 const uint8_t *id)
+{
+	uint32_t best = UINT32_MAX;
+
+	for (const struct isis_item *i = head; i; i = i->next) {
+		const uint8_t *reach_id;
+		uint32_t metric;
+
+		spf_reach_item(i, oldstyle, &reach_id, &metric);
+		if (!memcmp(reach_id, id, ISIS_SYS_ID_LEN + 1))
+			best = MIN(best, metric);
+	}
+
+	return best;
+}
+
+static bool spf_reach_same(const struct isis_item *a,
+			   const struct isis_item *b, bool oldstyle)
+{
+	for (; a && b; a = a->next, b = b->next) {
+		const uint8_t *id_a, *id_b;
+		uint32_t metric_a, metric_b;
+
+		spf_reach_item(a, oldstyle, &id_a, &metric_a);
+		spf_reach_item(b, oldstyle, &id_b, &metric_b);
+		if (metric_a != metric_b
+		    || memcmp(id_a, id_b, ISIS_SYS_ID_LEN + 1))
+			return false;
+	}
+
+	return !a && !b;
+}
+
+/* Compares the IS reachability used by the SPTs of the area and level. */
+static bool spf_is_reach_same(struct isis_area *area, int level,
+			      struct isis_tlvs *a, struct isis_tlvs *b)
+{
+	if (!spf_reach_same(a->oldstyle_reach.head, b->oldstyle_reach.head,
+			    true)
+	    || !spf_reach_same(a->extended_reach.head, b->extended_reach.head,
+			       false))
+		return false;
+
+	for (int tree = SPFTREE_IPV4; tree < SPFTREE_COUNT; tree++) {
+		struct isis_spftree *spftree = area->spftree[tree][level - 1];
+		struct isis_item_list *list_a, *list_b;
+
+		if (!spftree || spftree->mtid == ISIS_MT_IPV4_UNICAST)
+			continue;
+
+		list_a = isis_lookup_mt_items(&a->mt_reach, spftree->mtid);
+		list_b = isis_lookup_mt_items(&b->mt_reach, spftree->mtid);
+		if (!spf_reach_same(list_a ? list_a->head : NULL,
+				    list_b ? list_b->head : NULL, false))
+			return false;
+	}
+
+	return true;
+}
+
+static bool spf_mt_router_info_same(const struct isis_item *a,
+				    const struct isis_item *b)
+{
+	for (; a && b; a = a->next, b = b->next) {
+		const struct isis_mt_router_info *info_a = (const void *)a;
+		const struct isis_mt_router_info *info_b = (const void *)b;
+
+		if (info_a->mtid != info_b->mtid
+		    || info_a->overload != info_b->overload)
+			return false;
+	}
+
+	return !a && !b;
+}
+
+/*
+ * A changed link from node to neighbor leaves the SPT alone if the SPT
+ * didn't use the link before, and the link doesn't now offer a path to the
+ * neighbor as short as (that would be a new ECMP path) or shorter than the
+ * one in the SPT.
+ */
+static bool spf_link_change_affects(struct isis_spftree *spftree,
+				    const uint8_t *node,
+				    const uint8_t *neighbor, bool oldstyle,
+				    uint32_t old_metric, uint32_t new_metric)
+{
+	enum vertextype node_vtypes[2];
+	enum vertextype neighbor_vtype;
+	struct isis_vertex *vertex_node, *vertex_neighbor;
+
+	if (LSP_PSEUDO_ID(node)) {
+		node_vtypes[0] = VTYPE_PSEUDO_IS;
+		node_vtypes[1] = VTYPE_PSEUDO_TE_IS;
+	} else {
+		node_vtypes[0] = VTYPE_NONPSEUDO_IS;
+		node_vtypes[1] = VTYPE_NONPSEUDO_TE_IS;
+	}
+	if (LSP_PSEUDO_ID(neighbor))
+		neighbor_vtype = oldstyle ? VTYPE_PSEUDO_IS : VTYPE_PSEUDO_TE_IS;
+	else
+		neighbor_vtype =
+			oldstyle ? VTYPE_NONPSEUDO_IS : VTYPE_NONPSEUDO_TE_IS;
+
+	vertex_neighbor =
+		isis_find_vertex(&spftree->paths, neighbor, neighbor_vtype);
+
+	for (unsigned int i = 0; i < array_size(node_vtypes); i++) {
+		/* LSPs of nodes outside of the SPT are never processed. */
+		vertex_node =
+			isis_find_vertex(&spftree->paths, node, node_vtypes[i]);
+		if (!vertex_node)
+			continue;
+
+		if (old_metric != UINT32_MAX && vertex_neighbor
+		    && listnode_lookup(vertex_neighbor->parents, vertex_node))
+			return true;
+
+		if (new_metric != UINT32_MAX
+		    && (!vertex_neighbor
+			|| vertex_node->d_N + new_metric
+				   <= vertex_neighbor->d_N))
+			return true;
+	}
+
+	return false;
+}
+
+static bool spf_reach_change_affects(struct isis_spftree *spftree,
+				     const uint8_t *lsp_id,
+				     const struct isis_item *old_head,
+				     const struct isis_item *new_head,
+				     bool oldstyle)
+{
+	static const uint8_t null_sysid[ISIS_SYS_ID_LEN];
+	const struct isis_item *heads[] = {old_head, new_head};
+
+	for (unsigned int h = 0; h < array_size(heads); h++) {
+		for (const struct isis_item *i = heads[h]; i; i = i->next) {
+			uint32_t old_metric, new_metric, metric;
+			const uint8_t *id;
+
+			spf_reach_item(i, oldstyle, &id, &metric);
+
+			/* Skipped by isis_spf_process_lsp() as well. */
+			if (!LSP_PSEUDO_ID(id)
+			    && !memcmp(id, spftree->sysid, ISIS_SYS_ID_LEN))
+				continue;
+			if (!LSP_PSEUDO_ID(lsp_id)
+			    && !memcmp(id, null_sysid, ISIS_SYS_ID_LEN))
+				continue;
+
+			old_metric = spf_reach_metric(old_head, oldstyle, id);
+			new_metric = spf_reach_metric(new_head, oldstyle, id);
+			if (old_metric == new_metric)
+				continue;
+
+			if (spf_link_change_affects(spftree, lsp_id, id,
+						    oldstyle, old_metric,
+						    new_metric))
+				return true;
+		}
+	}
+
+	return false;
+}
+
+/*
+ * Finds out how much of the last SPF run the update of an LSP allows to be
+ * reused: only the IS vertices and the SPT if nothing but IP reachability
+ * changed (PRC), the same if the IS reachability changed without affecting
+ * any of the SPTs (incremental), or nothing.
+ */
+static enum isis_spf_mode spf_lsp_change_mode(struct isis_lsp *lsp,
+					      struct isis_tlvs *old_tlvs,
+					      uint8_t old_lsp_bits)
+{
+	struct isis_area *area = lsp->area;
+	struct isis_tlvs *new_tlvs = lsp->tlvs;
+	int level = lsp->level;
+	bool pseudo_lsp = LSP_PSEUDO_ID(lsp->hdr.lsp_id);
+	struct isis_spf_adj *sadj;
+	struct listnode *node;
+
+	if (!old_tlvs || !new_tlvs || !lsp->hdr.seqno
+	    || !lsp->hdr.rem_lifetime)
+		return ISIS_SPF_FULL;
+	if (!memcmp(lsp->hdr.lsp_id, area->isis->sysid, ISIS_SYS_ID_LEN))
+		return ISIS_SPF_FULL;
+	if (ISIS_MASK_LSP_OL_BIT(old_lsp_bits)
+	    != ISIS_MASK_LSP_OL_BIT(lsp->hdr.lsp_bits))
+		return ISIS_SPF_FULL;
+	if (old_tlvs->protocols_supported.count
+		    != new_tlvs->protocols_supported.count
+	    || memcmp(old_tlvs->protocols_supported.protocols,
+		      new_tlvs->protocols_supported.protocols,
+		      new_tlvs->protocols_supported.count))
+		return ISIS_SPF_FULL;
+	if (!spf_mt_router_info_same(old_tlvs->mt_router_info.head,
+				     new_tlvs->mt_router_info.head))
+		return ISIS_SPF_FULL;
+
+	if (spf_is_reach_same(area, level, old_tlvs, new_tlvs))
+		return ISIS_SPF_PRC;
+
+	/* The LFA SPTs are only ever reused by partial runs. */
+	if (area->lfa_protected_links[level - 1] > 0
+	    || area->rlfa_protected_links[level - 1] > 0
+	    || area->tilfa_protected_links[level - 1] > 0)
+		return ISIS_SPF_FULL;
+
+	for (int tree = SPFTREE_IPV4; tree < SPFTREE_COUNT; tree++) {
+		struct isis_spftree *spftree = area->spftree[tree][level - 1];
+		struct isis_item_list *old_reach, *new_reach;
+
+		if (!spftree || !spftree->spt_current)
+			continue;
+
+		/* Pseudonode LSPs of our own LANs are read without vertex. */
+		if (pseudo_lsp) {
+			for (ALL_LIST_ELEMENTS_RO(spftree->sadj_list, node,
+						  sadj))
+				if (!memcmp(sadj->id, lsp->hdr.lsp_id,
+					    ISIS_SYS_ID_LEN + 1))
+					return ISIS_SPF_FULL;
+		}
+
+		if ((pseudo_lsp || spftree->mtid == ISIS_MT_IPV4_UNICAST)
+		    && area->oldmetric
+		    && spf_reach_change_affects(spftree, lsp->hdr.lsp_id,
+						old_tlvs->oldstyle_reach.head,
+						new_tlvs->oldstyle_reach.head,
+						true))
+			return ISIS_SPF_FULL;
+
+		if (!area->newmetric)
+			continue;
+
+		if (pseudo_lsp || spftree->mtid == ISIS_MT_IPV4_UNICAST) {
+			old_reach = &old_tlvs->extended_reach;
+			new_reach = &new_tlvs->extended_reach;
+		} else {
+			old_reach = isis_lookup_mt_items(&old_tlvs->mt_reach,
+							 spftree->mtid);
+			new_reach = isis_lookup_mt_items(&new_tlvs->mt_reach,
+							 spftree->mtid);
+		}
+		if (spf_reach_change_affects(
+			    spftree, lsp->hdr.lsp_id,
+			    old_reach ? old_reach->head : NULL,
+			    new_reach ? new_reach->head : NULL, false))
+			return ISIS_SPF_FULL;
+	}
+
+	return ISIS_SPF_INCREMENTAL;
+}
+
+int _isis_spf_schedule_lsp(struct isis_lsp *lsp, struct isis_tlvs *old_tlvs,
+			   uint8_t old_lsp_bits, const char *func,
+			   const char *file, int line)
+{
+	enum isis_spf_mode mode;
+
+	mode = spf_lsp_change_mode(lsp, old_tlvs, old_lsp_bits);
+	if (IS_DEBUG_SPF_EVENTS)
+		zlog_debug("ISIS-SPF (%s) L%d LSP %s changed, %s SPF needed",
+			   lsp->area->area_tag, lsp->level,
+			   rawlspid_print(lsp->hdr.lsp_id),
+			   isis_spf_mode2str(mode));
+
+	return _isis_spf_schedule(lsp->area, lsp->level, mode, func, file,
+				  line);
+}
+
 static void isis_print_paths(struct vty *vty, struct isis_vertex_queue *queue,
 			     uint8_t *root_sysid)
 {
@@ -2685,4 +3159,10 @@ void isis_spf_print(struct isis_spftree *spftree, struct vty *vty)
 		(uint32_t)spftree->last_run_duration);
 
 	vty_out(vty, "      run count         : %u\n", spftree->runcount);
+
+	vty_out(vty,
+		"      run modes         : %u full, %u incremental, %u partial\n",
+		spftree->mode_count[ISIS_SPF_FULL],
+		spftree->mode_count[ISIS_SPF_INCREMENTAL],
+		spftree->mode_count[ISIS_SPF_PRC]);
 }
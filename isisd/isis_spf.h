@@ -66,16 +66,30 @@ void spftree_area_del(struct isis_area *area);
 struct isis_lsp *isis_root_system_lsp(struct lspdb_head *lspdb,
 				      const uint8_t *sysid);
 #define isis_spf_schedule(area, level) \
-	_isis_spf_schedule((area), (level), __func__, \
+	_isis_spf_schedule((area), (level), ISIS_SPF_FULL, __func__, \
 			   __FILE__, __LINE__)
 int _isis_spf_schedule(struct isis_area *area, int level,
-		       const char *func, const char *file, int line);
+		       enum isis_spf_mode mode, const char *func,
+		       const char *file, int line);
+/*
+ * Schedules SPF after an LSP was updated from old_tlvs and old_lsp_bits,
+ * reusing as much of the last run as the change allows.
+ */
+#define isis_spf_schedule_lsp(lsp, old_tlvs, old_lsp_bits) \
+	_isis_spf_schedule_lsp((lsp), (old_tlvs), (old_lsp_bits), __func__, \
+			       __FILE__, __LINE__)
+int _isis_spf_schedule_lsp(struct isis_lsp *lsp, struct isis_tlvs *old_tlvs,
+			   uint8_t old_lsp_bits, const char *func,
+			   const char *file, int line);
+const char *isis_spf_mode2str(enum isis_spf_mode mode);
 void isis_print_spftree(struct vty *vty, struct isis_spftree *spftree);
 void isis_print_routes(struct vty *vty, struct isis_spftree *spftree,
 		       bool prefix_sid, bool backup);
 void isis_spf_init(void);
 void isis_spf_print(struct isis_spftree *spftree, struct vty *vty);
 void isis_run_spf(struct isis_spftree *spftree);
+void isis_spf_tilfa_install(struct isis_spftree *spftree,
+			    struct isis_vertex *vertex);
 struct isis_spftree *isis_run_hopcount_spf(struct isis_area *area,
 					   uint8_t *sysid,
 					   struct isis_spftree *spftree);
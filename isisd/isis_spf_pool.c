@@ -0,0 +1,144 @@
+/*
+ * IS-IS SPF worker pool.
+ * Copyright (C) 2021  FRRouting
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+#include <pthread.h>
+
+#include "frr_pthread.h"
+#include "linklist.h"
+#include "memory.h"
+#include "thread.h"
+
+#include "isisd/isisd.h"
+#include "isisd/isis_spf_pool.h"
+
+DEFINE_MTYPE_STATIC(ISISD, ISIS_SPF_POOL, "ISIS SPF worker pool");
+
+struct isis_spf_shard {
+	void (*fn)(void *arg, unsigned int shard);
+	void *arg;
+	unsigned int shard;
+};
+
+/* only touched by the main pthread */
+static struct frr_pthread **pool;
+static struct isis_spf_shard *shards;
+static unsigned int pool_size;
+
+/* number of shards still running on the workers */
+static pthread_mutex_t pool_mtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_cond = PTHREAD_COND_INITIALIZER;
+static unsigned int pool_pending;
+
+static int isis_spf_pool_work(struct thread *thread)
+{
+	struct isis_spf_shard *shard = THREAD_ARG(thread);
+
+	shard->fn(shard->arg, shard->shard);
+
+	frr_with_mutex(&pool_mtx) {
+		if (--pool_pending == 0)
+			pthread_cond_signal(&pool_cond);
+	}
+	return 0;
+}
+
+void isis_spf_pool_run(void (*fn)(void *arg, unsigned int shard), void *arg)
+{
+	unsigned int i;
+
+	frr_with_mutex(&pool_mtx) {
+		pool_pending = pool_size;
+	}
+
+	for (i = 0; i < pool_size; i++) {
+		shards[i].fn = fn;
+		shards[i].arg = arg;
+		shards[i].shard = i;
+		thread_add_event(pool[i]->master, isis_spf_pool_work,
+				 &shards[i], 0, NULL);
+	}
+
+	fn(arg, pool_size);
+
+	frr_with_mutex(&pool_mtx) {
+		while (pool_pending)
+			pthread_cond_wait(&pool_cond, &pool_mtx);
+	}
+}
+
+unsigned int isis_spf_pool_size(void)
+{
+	return pool_size;
+}
+
+static void isis_spf_pool_set(unsigned int nthreads)
+{
+	struct frr_pthread_attr attr = {
+		.start = frr_pthread_attr_default.start,
+		.stop = frr_pthread_attr_default.stop,
+	};
+	char name[32], os_name[OS_THREAD_NAMELEN];
+	unsigned int i;
+
+	if (nthreads > ISIS_SPF_THREADS_MAX)
+		nthreads = ISIS_SPF_THREADS_MAX;
+	if (nthreads == pool_size)
+		return;
+
+	/* the workers carry no state, so resizing is just rebuilding */
+	for (i = 0; i < pool_size; i++) {
+		frr_pthread_stop(pool[i], NULL);
+		frr_pthread_destroy(pool[i]);
+	}
+	XFREE(MTYPE_ISIS_SPF_POOL, pool);
+	XFREE(MTYPE_ISIS_SPF_POOL, shards);
+	pool_size = 0;
+
+	if (!nthreads)
+		return;
+
+	pool = XCALLOC(MTYPE_ISIS_SPF_POOL, nthreads * sizeof(*pool));
+	shards = XCALLOC(MTYPE_ISIS_SPF_POOL, nthreads * sizeof(*shards));
+
+	for (i = 0; i < nthreads; i++) {
+		snprintf(name, sizeof(name), "ISIS SPF thread %u", i);
+		snprintf(os_name, sizeof(os_name), "isisd_spf%u", i);
+		pool[i] = frr_pthread_new(&attr, name, os_name);
+		frr_pthread_run(pool[i], NULL);
+	}
+	for (i = 0; i < nthreads; i++)
+		frr_pthread_wait_running(pool[i]);
+
+	pool_size = nthreads;
+}
+
+void isis_spf_pool_update(void)
+{
+	struct isis *isis;
+	struct isis_area *area;
+	struct listnode *node, *anode;
+	unsigned int nthreads = 0;
+
+	for (ALL_LIST_ELEMENTS_RO(im->isis, node, isis))
+		for (ALL_LIST_ELEMENTS_RO(isis->area_list, anode, area))
+			nthreads = MAX(nthreads, area->spf_threads);
+
+	isis_spf_pool_set(nthreads);
+}
@@ -0,0 +1,53 @@
+/*
+ * IS-IS SPF worker pool.
+ * Copyright (C) 2021  FRRouting
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _FRR_ISIS_SPF_POOL_H
+#define _FRR_ISIS_SPF_POOL_H
+
+#define ISIS_SPF_THREADS_MAX 64
+
+/**
+ * Resizes the pool to the largest number of SPF worker pthreads configured
+ * in any area (see isis_area->spf_threads).
+ *
+ * Must be called from the main pthread, after that setting changed or an
+ * area was deleted.
+ */
+extern void isis_spf_pool_update(void);
+
+/**
+ * Number of worker pthreads currently running.
+ */
+extern unsigned int isis_spf_pool_size(void);
+
+/**
+ * Runs fn once for each shard in [0, isis_spf_pool_size()].
+ *
+ * The last shard is run on the calling pthread, all others on the workers.
+ * Returns once every shard has completed.  fn may only read the LSDB and the
+ * rest of the daemon state, which the main pthread doesn't change while it
+ * is waiting in here.
+ *
+ * @param fn - work function, called with arg and the shard number
+ * @param arg - passed to fn
+ */
+extern void isis_spf_pool_run(void (*fn)(void *arg, unsigned int shard),
+			      void *arg);
+
+#endif /* _FRR_ISIS_SPF_POOL_H */
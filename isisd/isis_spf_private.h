@@ -317,6 +317,8 @@ struct isis_spftree {
 	time_t last_run_timestamp; /* last run timestamp as wall time for display */
 	time_t last_run_monotime;  /* last run as monotime for scheduling */
 	time_t last_run_duration;  /* last run duration in msec */
+	unsigned int mode_count[ISIS_SPF_MODE_MAX]; /* runs per SPF mode */
+	bool spt_current; /* SPT is up to date as of the last run */
 
 	enum spf_type type;
 	uint8_t sysid[ISIS_SYS_ID_LEN];
@@ -331,6 +333,9 @@ struct isis_spftree {
 			struct isis_spftree *spftree_reverse;
 		} old;
 
+		/* Local reverse SPT, kept between runs. */
+		struct isis_spftree *spftree_reverse;
+
 		/* Protected resource. */
 		struct lfa_protected_resource protected_resource;
 
@@ -353,6 +358,22 @@ struct isis_spftree {
 			uint32_t max_metric;
 		} remote;
 
+		/* TI-LFA related information. */
+		struct {
+			/*
+			 * Post-convergence SPTs, one per protected resource
+			 * (kept so that partial runs can reuse them).
+			 */
+			struct list *pc_spftrees;
+
+			/*
+			 * Vertices whose repair paths are installed once the
+			 * post-convergence SPF is done (only set while it runs
+			 * on a worker pthread).
+			 */
+			struct list *install_queue;
+		} tilfa;
+
 		/* Protection counters. */
 		struct {
 			uint32_t lfa[SPF_PREFIX_PRIO_MAX];
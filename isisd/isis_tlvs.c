@@ -27,10 +27,12 @@
 #ifdef CRYPTO_INTERNAL
 #include "md5.h"
 #endif
+#include "jhash.h"
 #include "memory.h"
 #include "stream.h"
 #include "sbuf.h"
 #include "network.h"
+#include "typesafe.h"
 
 #include "isisd/isisd.h"
 #include "isisd/isis_tlvs.h"
@@ -47,6 +49,7 @@
 DEFINE_MTYPE_STATIC(ISISD, ISIS_TLV, "ISIS TLVs");
 DEFINE_MTYPE(ISISD, ISIS_SUBTLV, "ISIS Sub-TLVs");
 DEFINE_MTYPE_STATIC(ISISD, ISIS_MT_ITEM_LIST, "ISIS MT Item Lists");
+DEFINE_MTYPE_STATIC(ISISD, ISIS_FRAG_ITEM, "ISIS fragment items");
 
 typedef int (*unpack_tlv_func)(enum isis_tlv_context context, uint8_t tlv_type,
 			       uint8_t tlv_len, struct stream *s,
@@ -3877,23 +3880,12 @@ static int handle_pack_entry(const struct pack_order_entry *pe,
 	return rv;
 }
 
-static int pack_tlvs(struct isis_tlvs *tlvs, struct stream *stream,
-		     struct isis_tlvs *fragment_tlvs,
-		     struct isis_tlvs *(*new_fragment)(struct list *l),
-		     struct list *new_fragment_arg)
+/* The TLVs that always go into the first fragment. */
+static int pack_tlvs_fixed(struct isis_tlvs *tlvs, struct stream *stream,
+			   struct isis_tlvs *fragment_tlvs)
 {
 	int rv;
 
-	/* When fragmenting, don't add auth as it's already accounted for in the
-	 * size we are given. */
-	if (!fragment_tlvs) {
-		rv = pack_items(ISIS_CONTEXT_LSP, ISIS_TLV_AUTH,
-				&tlvs->isis_auth, stream, NULL, NULL, NULL,
-				NULL);
-		if (rv)
-			return rv;
-	}
-
 	rv = pack_tlv_purge_originator(tlvs->purge_originator, stream);
 	if (rv)
 		return rv;
@@ -3981,6 +3973,30 @@ static int pack_tlvs(struct isis_tlvs *tlvs, struct stream *stream,
 			copy_tlv_spine_leaf(tlvs->spine_leaf);
 	}
 
+	return 0;
+}
+
+static int pack_tlvs(struct isis_tlvs *tlvs, struct stream *stream,
+		     struct isis_tlvs *fragment_tlvs,
+		     struct isis_tlvs *(*new_fragment)(struct list *l),
+		     struct list *new_fragment_arg)
+{
+	int rv;
+
+	/* When fragmenting, don't add auth as it's already accounted for in the
+	 * size we are given. */
+	if (!fragment_tlvs) {
+		rv = pack_items(ISIS_CONTEXT_LSP, ISIS_TLV_AUTH,
+				&tlvs->isis_auth, stream, NULL, NULL, NULL,
+				NULL);
+		if (rv)
+			return rv;
+	}
+
+	rv = pack_tlvs_fixed(tlvs, stream, fragment_tlvs);
+	if (rv)
+		return rv;
+
 	for (size_t pack_idx = 0; pack_idx < array_size(pack_order);
 	     pack_idx++) {
 		rv = handle_pack_entry(&pack_order[pack_idx], tlvs, stream,
@@ -4040,6 +4056,309 @@ struct list *isis_fragment_tlvs(struct isis_tlvs *tlvs, size_t size)
 	return rv;
 }
 
+/*
+ * Fragmenting that keeps the items where they were.  An item whose packed
+ * form was found in fragment n of the previous fragments goes into fragment
+ * n again, anything else into the first fragment with room for it (or a new
+ * one), so a change only affects the fragments it's in.  Items keep their
+ * order within a fragment.
+ */
+#define FRAG_MAX 256
+#define FRAG_UNPLACED 0xffff
+
+PREDECL_HASH(frag_items);
+
+struct frag_item {
+	struct frag_items_item item;
+
+	uint32_t hash;
+	uint16_t mtid;
+	uint8_t pack_idx;
+	uint8_t fragment;
+	uint16_t len;
+	uint8_t data[];
+};
+
+static int frag_item_cmp(const struct frag_item *a, const struct frag_item *b)
+{
+	if (a->pack_idx != b->pack_idx)
+		return numcmp(a->pack_idx, b->pack_idx);
+	if (a->mtid != b->mtid)
+		return numcmp(a->mtid, b->mtid);
+	if (a->len != b->len)
+		return numcmp(a->len, b->len);
+	return memcmp(a->data, b->data, a->len);
+}
+
+static uint32_t frag_item_hash(const struct frag_item *a)
+{
+	return a->hash;
+}
+
+DECLARE_HASH(frag_items, struct frag_item, item, frag_item_cmp,
+	     frag_item_hash);
+
+struct frag_state {
+	struct frag_items_head items;
+	/* packed form of the item at hand */
+	struct stream *s;
+	struct frag_item *key;
+
+	struct isis_tlvs *frags[FRAG_MAX];
+	unsigned int nitems[FRAG_MAX];
+	size_t used[FRAG_MAX];
+	unsigned int nfrags;
+	size_t size;
+
+	/* fragment of each item of the new TLVs, in walk order */
+	uint16_t *target;
+	unsigned int count, pos;
+	unsigned int fragment;
+	bool failed;
+};
+
+typedef void (*frag_walk_fn)(struct frag_state *st, unsigned int pack_idx,
+			     uint16_t mtid, struct isis_item *item);
+
+/* Calls fn for each item pack_tlvs() spreads over fragments. */
+static void frag_walk(struct frag_state *st, struct isis_tlvs *tlvs,
+		      frag_walk_fn fn)
+{
+	const struct pack_order_entry *pe;
+	struct isis_item_list *l;
+	struct isis_mt_item_list *m;
+	struct isis_item *item;
+
+	for (unsigned int idx = 0; idx < array_size(pack_order); idx++) {
+		pe = &pack_order[idx];
+		if (pe->how_to_pack == ISIS_ITEMS) {
+			l = (struct isis_item_list *)(((char *)tlvs)
+						      + pe->what_to_pack);
+			for (item = l->head; item; item = item->next)
+				fn(st, idx, ISIS_MT_IPV4_UNICAST, item);
+			continue;
+		}
+
+		m = (struct isis_mt_item_list *)(((char *)tlvs)
+						 + pe->what_to_pack);
+		RB_FOREACH (l, isis_mt_item_list, m)
+			for (item = l->head; item; item = item->next)
+				fn(st, idx, l->mtid, item);
+	}
+}
+
+/* Pack an item into st->key, false if it can't be packed on its own. */
+static bool frag_key(struct frag_state *st, unsigned int pack_idx,
+		     uint16_t mtid, struct isis_item *item)
+{
+	const struct pack_order_entry *pe = &pack_order[pack_idx];
+	size_t min_len = 0;
+
+	stream_reset(st->s);
+	if (pack_item(pe->context, pe->type, item, st->s, &min_len, NULL, pe,
+		      mtid))
+		return false;
+
+	st->key->pack_idx = pack_idx;
+	st->key->mtid = mtid;
+	st->key->len = stream_get_endp(st->s);
+	memcpy(st->key->data, STREAM_DATA(st->s), st->key->len);
+	st->key->hash = jhash(st->key->data, st->key->len,
+			      (pack_idx << 16) | mtid);
+	return true;
+}
+
+static void frag_index(struct frag_state *st, unsigned int pack_idx,
+		       uint16_t mtid, struct isis_item *item)
+{
+	struct frag_item *fi;
+
+	if (!frag_key(st, pack_idx, mtid, item)
+	    || frag_items_find(&st->items, st->key))
+		return;
+
+	fi = XMALLOC(MTYPE_ISIS_FRAG_ITEM, sizeof(*fi) + st->key->len);
+	memcpy(fi, st->key, sizeof(*fi) + st->key->len);
+	fi->fragment = st->fragment;
+	frag_items_add(&st->items, fi);
+}
+
+static void frag_count(struct frag_state *st, unsigned int pack_idx,
+		       uint16_t mtid, struct isis_item *item)
+{
+	st->count++;
+}
+
+static void frag_sticky(struct frag_state *st, unsigned int pack_idx,
+			uint16_t mtid, struct isis_item *item)
+{
+	struct frag_item *fi = NULL;
+
+	if (frag_key(st, pack_idx, mtid, item))
+		fi = frag_items_find(&st->items, st->key);
+	st->target[st->pos++] = fi ? fi->fragment : FRAG_UNPLACED;
+}
+
+static void frag_place(struct frag_state *st, unsigned int pack_idx,
+		       uint16_t mtid, struct isis_item *item)
+{
+	const struct pack_order_entry *pe = &pack_order[pack_idx];
+	unsigned int pos = st->pos++, n;
+	size_t cost;
+
+	if (st->target[pos] != FRAG_UNPLACED || st->failed)
+		return;
+	if (!frag_key(st, pack_idx, mtid, item)) {
+		st->failed = true;
+		return;
+	}
+
+	/* as if the item needed a TLV of its own */
+	cost = st->key->len + 2;
+	if (IS_COMPAT_MT_TLV(pe->type) && mtid != ISIS_MT_IPV4_UNICAST)
+		cost += 2;
+	if (pe->type == ISIS_TLV_OLDSTYLE_REACH)
+		cost += 1;
+
+	for (n = 0; n < st->nfrags; n++)
+		if (st->used[n] + cost <= st->size)
+			break;
+	if (n == st->nfrags) {
+		if (n == FRAG_MAX) {
+			st->failed = true;
+			return;
+		}
+		st->used[st->nfrags++] = 0;
+	}
+
+	st->used[n] += cost;
+	st->target[pos] = n;
+}
+
+static void frag_add(struct frag_state *st, unsigned int pack_idx,
+		     uint16_t mtid, struct isis_item *item)
+{
+	uint16_t n = st->target[st->pos++];
+
+	if (n == FRAG_UNPLACED)
+		return;
+
+	if (!st->frags[n])
+		st->frags[n] = isis_alloc_tlvs();
+	add_item_to_fragment(item, &pack_order[pack_idx], st->frags[n], mtid);
+	st->nitems[n]++;
+}
+
+static void frag_free(struct frag_state *st)
+{
+	for (unsigned int n = 0; n < FRAG_MAX; n++) {
+		isis_free_tlvs(st->frags[n]);
+		st->frags[n] = NULL;
+		st->nitems[n] = 0;
+	}
+}
+
+/*
+ * Build the fragments from the placed items and check they fit, noting how
+ * much of each is in use.
+ */
+static bool frag_build(struct frag_state *st, struct isis_tlvs *tlvs,
+		       struct stream *dummy)
+{
+	frag_free(st);
+
+	stream_reset(dummy);
+	st->frags[0] = isis_alloc_tlvs();
+	if (pack_tlvs_fixed(tlvs, dummy, st->frags[0]))
+		return false;
+
+	st->pos = 0;
+	frag_walk(st, tlvs, frag_add);
+
+	for (unsigned int n = 0; n < st->nfrags; n++) {
+		st->used[n] = 0;
+		if (!st->frags[n])
+			continue;
+		stream_reset(dummy);
+		if (pack_tlvs(st->frags[n], dummy, NULL, NULL, NULL))
+			return false;
+		st->used[n] = stream_get_endp(dummy);
+	}
+	return true;
+}
+
+struct list *isis_fragment_tlvs_stable(struct isis_tlvs *tlvs, size_t size,
+				       struct isis_tlvs *const *prev,
+				       unsigned int count)
+{
+	struct frag_state *st;
+	struct frag_item *fi;
+	struct stream *dummy;
+	struct list *rv = NULL;
+	unsigned int n;
+
+	st = XCALLOC(MTYPE_TMP, sizeof(*st));
+	frag_items_init(&st->items);
+	st->s = stream_new(size);
+	st->key = XMALLOC(MTYPE_TMP, sizeof(*st->key) + size);
+	st->size = size;
+	st->nfrags = 1;
+	dummy = stream_new(size);
+
+	for (n = 0; n < count && n < FRAG_MAX; n++) {
+		if (!prev[n])
+			continue;
+		st->fragment = n;
+		st->nfrags = n + 1;
+		frag_walk(st, prev[n], frag_index);
+	}
+	if (!frag_items_count(&st->items))
+		goto out;
+
+	frag_walk(st, tlvs, frag_count);
+	st->target = XCALLOC(MTYPE_TMP, (st->count + 1) * sizeof(*st->target));
+	frag_walk(st, tlvs, frag_sticky);
+
+	/* what is left of the old fragments */
+	if (!frag_build(st, tlvs, dummy))
+		goto out;
+
+	st->pos = 0;
+	frag_walk(st, tlvs, frag_place);
+	if (st->failed)
+		goto out;
+
+	if (!frag_build(st, tlvs, dummy))
+		goto out;
+
+	/* fragments left empty at the end go away */
+	while (st->nfrags > 1 && !st->nitems[st->nfrags - 1])
+		st->nfrags--;
+
+	rv = list_new();
+	for (n = 0; n < st->nfrags; n++) {
+		listnode_add(rv, st->frags[n] ? st->frags[n]
+					      : isis_alloc_tlvs());
+		st->frags[n] = NULL;
+	}
+
+out:
+	frag_free(st);
+	while ((fi = frag_items_pop(&st->items)))
+		XFREE(MTYPE_ISIS_FRAG_ITEM, fi);
+	frag_items_fini(&st->items);
+	XFREE(MTYPE_TMP, st->target);
+	XFREE(MTYPE_TMP, st->key);
+	stream_free(st->s);
+	stream_free(dummy);
+	XFREE(MTYPE_TMP, st);
+
+	/* no previous fragments, or the new items don't fit in there */
+	if (!rv)
+		rv = isis_fragment_tlvs(tlvs, size);
+	return rv;
+}
+
 static int unpack_tlv_unknown(enum isis_tlv_context context, uint8_t tlv_type,
 			      uint8_t tlv_len, struct stream *s,
 			      struct sbuf *log, int indent)
@@ -4148,6 +4467,113 @@ int isis_unpack_tlvs(size_t avail_len, struct stream *stream,
 	return rv;
 }
 
+/*
+ * Like isis_unpack_tlvs(), but only decodes the authentication TLVs and
+ * checks the others are well framed.  That is all a received LSP needs
+ * until it is known to go into the LSPDB; most don't, as they are copies
+ * of what we have already.
+ */
+int isis_unpack_auth_tlvs(size_t avail_len, struct stream *stream,
+			  struct isis_tlvs **dest, const char **log)
+{
+	static struct sbuf logbuf;
+	struct isis_tlvs *result;
+	size_t start, pos = 0;
+	uint8_t tlv_type, tlv_len;
+	int rv = 0;
+
+	if (!sbuf_buf(&logbuf))
+		sbuf_init(&logbuf, NULL, 0);
+
+	sbuf_reset(&logbuf);
+	if (avail_len > STREAM_READABLE(stream)) {
+		sbuf_push(&logbuf, 0,
+			  "Stream doesn't contain sufficient data. Claimed %zu, available %zu\n",
+			  avail_len, STREAM_READABLE(stream));
+		return 1;
+	}
+
+	result = isis_alloc_tlvs();
+	start = stream_get_getp(stream);
+	while (pos < avail_len) {
+		if (avail_len - pos < 2) {
+			sbuf_push(&logbuf, 0,
+				  "Available data %zu too short to contain a TLV header.\n",
+				  avail_len - pos);
+			rv = 1;
+			break;
+		}
+
+		tlv_type = stream_getc_from(stream, start + pos);
+		if (tlv_type == ISIS_TLV_AUTH) {
+			rv = unpack_tlv(ISIS_CONTEXT_LSP, avail_len - pos,
+					stream, &logbuf, result, 0, NULL);
+			if (rv)
+				break;
+		} else {
+			tlv_len = stream_getc_from(stream, start + pos + 1);
+			if (avail_len - pos - 2 < tlv_len) {
+				sbuf_push(&logbuf, 0,
+					  "Available data %zu too short for claimed TLV len %hhu.\n",
+					  avail_len - pos - 2, tlv_len);
+				rv = 1;
+				break;
+			}
+			stream_forward_getp(stream, tlv_len + 2);
+		}
+		pos = stream_get_getp(stream) - start;
+	}
+
+	*log = sbuf_buf(&logbuf);
+	*dest = result;
+
+	return rv;
+}
+
+/* Skip the authentication TLVs at pos. */
+static size_t raw_skip_auth(const uint8_t *tlvs, size_t len, size_t pos)
+{
+	while (pos + 2 <= len && tlvs[pos] == ISIS_TLV_AUTH)
+		pos += 2 + tlvs[pos + 1];
+	return pos;
+}
+
+bool isis_tlvs_raw_same(const uint8_t *a, size_t alen, const uint8_t *b,
+			size_t blen)
+{
+	size_t apos = 0, bpos = 0, len;
+
+	while (true) {
+		apos = raw_skip_auth(a, alen, apos);
+		bpos = raw_skip_auth(b, blen, bpos);
+		if (apos >= alen || bpos >= blen)
+			return apos == alen && bpos == blen;
+		if (apos + 2 > alen)
+			return false;
+
+		len = 2 + a[apos + 1];
+		if (apos + len > alen || bpos + len > blen
+		    || memcmp(a + apos, b + bpos, len))
+			return false;
+		apos += len;
+		bpos += len;
+	}
+}
+
+void isis_tlvs_take_auth(struct isis_tlvs *dest, struct isis_tlvs *src)
+{
+	free_items(ISIS_CONTEXT_LSP, ISIS_TLV_AUTH, &dest->isis_auth);
+	init_item_list(&dest->isis_auth);
+
+	if (!src->isis_auth.head)
+		return;
+
+	dest->isis_auth.head = src->isis_auth.head;
+	dest->isis_auth.tail = src->isis_auth.tail;
+	dest->isis_auth.count = src->isis_auth.count;
+	init_item_list(&src->isis_auth);
+}
+
 #define TLV_OPS(_name_, _desc_)                                                \
 	static const struct tlv_ops tlv_##_name_##_ops = {                     \
 		.name = _desc_, .unpack = unpack_tlv_##_name_,                 \
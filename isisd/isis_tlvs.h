@@ -544,9 +544,19 @@ void isis_free_tlvs(struct isis_tlvs *tlvs);
 struct isis_tlvs *isis_alloc_tlvs(void);
 int isis_unpack_tlvs(size_t avail_len, struct stream *stream,
 		     struct isis_tlvs **dest, const char **error_log);
+int isis_unpack_auth_tlvs(size_t avail_len, struct stream *stream,
+			  struct isis_tlvs **dest, const char **error_log);
+/* Check if two packed TLV areas are the same, apart from authentication. */
+bool isis_tlvs_raw_same(const uint8_t *a, size_t alen, const uint8_t *b,
+			size_t blen);
+/* Replace dest's authentication TLVs with those of src, emptying src's. */
+void isis_tlvs_take_auth(struct isis_tlvs *dest, struct isis_tlvs *src);
 const char *isis_format_tlvs(struct isis_tlvs *tlvs);
 struct isis_tlvs *isis_copy_tlvs(struct isis_tlvs *tlvs);
 struct list *isis_fragment_tlvs(struct isis_tlvs *tlvs, size_t size);
+struct list *isis_fragment_tlvs_stable(struct isis_tlvs *tlvs, size_t size,
+				       struct isis_tlvs *const *prev,
+				       unsigned int count);
 
 #define ISIS_EXTENDED_IP_REACH_DOWN 0x80
 #define ISIS_EXTENDED_IP_REACH_SUBTLV 0x40
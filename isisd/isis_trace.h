@@ -0,0 +1,113 @@
+/* Tracing for IS-IS
+ *
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#if !defined(_ISIS_TRACE_H) || defined(TRACEPOINT_HEADER_MULTI_READ)
+#define _ISIS_TRACE_H
+
+#include "lib/trace.h"
+
+#ifdef HAVE_LTTNG
+
+#undef TRACEPOINT_PROVIDER
+#define TRACEPOINT_PROVIDER frr_isis
+
+#undef TRACEPOINT_INCLUDE
+#define TRACEPOINT_INCLUDE "isisd/isis_trace.h"
+
+#include <lttng/tracepoint.h>
+
+#include "lib/if.h"
+#include "isisd/isisd.h"
+#include "isisd/isis_circuit.h"
+#include "isisd/isis_lsp.h"
+#include "isisd/isis_spf.h"
+#include "isisd/isis_spf_private.h"
+
+/* clang-format off */
+
+/* The SPF timer of a level fired */
+TRACEPOINT_EVENT(
+	frr_isis,
+	spf_start,
+	TP_ARGS(struct isis_area *, area, int, level),
+	TP_FIELDS(
+		ctf_string(area, area->area_tag ? area->area_tag : "")
+		ctf_integer(int, level, level)
+		ctf_string(mode, isis_spf_mode2str(area->spf_mode[level - 1]))
+	)
+)
+
+TRACEPOINT_LOGLEVEL(frr_isis, spf_start, TRACE_INFO)
+
+/* The SPT of one address family is done, or reused */
+TRACEPOINT_EVENT(
+	frr_isis,
+	spf_run,
+	TP_ARGS(struct isis_spftree *, spftree, enum isis_spf_mode, mode),
+	TP_FIELDS(
+		ctf_string(area, spftree->area->area_tag
+				 ? spftree->area->area_tag : "")
+		ctf_integer(int, level, spftree->level)
+		ctf_integer(int, tree_id, spftree->tree_id)
+		ctf_string(mode, isis_spf_mode2str(mode))
+		ctf_integer(int64_t, duration_usec,
+			    spftree->last_run_duration)
+	)
+)
+
+TRACEPOINT_LOGLEVEL(frr_isis, spf_run, TRACE_INFO)
+
+/* The routes of a level have been handed to zebra */
+TRACEPOINT_EVENT(
+	frr_isis,
+	spf_done,
+	TP_ARGS(struct isis_area *, area, int, level),
+	TP_FIELDS(
+		ctf_string(area, area->area_tag ? area->area_tag : "")
+		ctf_integer(int, level, level)
+	)
+)
+
+TRACEPOINT_LOGLEVEL(frr_isis, spf_done, TRACE_INFO)
+
+/* An LSP is flooded; circuit is the one it came in on, if any */
+TRACEPOINT_EVENT(
+	frr_isis,
+	lsp_flood,
+	TP_ARGS(struct isis_lsp *, lsp, struct isis_circuit *, circuit),
+	TP_FIELDS(
+		ctf_array_hex(uint8_t, lsp_id, lsp->hdr.lsp_id,
+			      ISIS_SYS_ID_LEN + 2)
+		ctf_integer_hex(uint32_t, seqno, lsp->hdr.seqno)
+		ctf_integer(uint16_t, rem_lifetime, lsp->hdr.rem_lifetime)
+		ctf_integer(int, level, lsp->level)
+		ctf_string(circuit, circuit && circuit->interface
+				    ? circuit->interface->name : "")
+	)
+)
+
+TRACEPOINT_LOGLEVEL(frr_isis, lsp_flood, TRACE_INFO)
+
+/* clang-format on */
+
+#include <lttng/tracepoint-event.h>
+
+#endif /* HAVE_LTTNG */
+
+#endif /* _ISIS_TRACE_H */
@@ -23,6 +23,8 @@
 
 #include "hash.h"
 #include "jhash.h"
+#include "monotime.h"
+#include "typesafe.h"
 
 #include "isisd/isisd.h"
 #include "isisd/isis_flags.h"
@@ -34,21 +36,49 @@
 DEFINE_MTYPE_STATIC(ISISD, TX_QUEUE, "ISIS TX Queue");
 DEFINE_MTYPE_STATIC(ISISD, TX_QUEUE_ENTRY, "ISIS TX Queue Entry");
 
+/* seconds until an unacknowledged LSP is sent again */
+#define TX_QUEUE_RETRY_INTERVAL 5
+/* LSPs sent per run of tx_queue_send_event() */
+#define TX_QUEUE_BATCH 64
+
+PREDECL_DLIST(tx_queue_list);
+
 struct isis_tx_queue {
 	struct isis_circuit *circuit;
 	void (*send_event)(struct isis_circuit *circuit,
 			   struct isis_lsp *, enum isis_tx_type);
 	struct hash *hash;
+
+	/*
+	 * LSPs waiting for their first transmission, and those sent already
+	 * in the order they are due for a retransmission.  As the retry
+	 * interval is fixed, the latter stays sorted by appending.
+	 */
+	struct tx_queue_list_head pending;
+	struct tx_queue_list_head retries;
+	struct thread *t_send;
+
+	/* token bucket, in millionths of an LSP */
+	uint64_t tokens;
+	struct timeval refilled;
+
+	struct isis_tx_queue_stats stats;
 };
 
 struct isis_tx_queue_entry {
+	struct tx_queue_list_item item;
+	struct tx_queue_list_head *list;
+
 	struct isis_lsp *lsp;
 	enum isis_tx_type type;
 	bool is_retry;
-	struct thread *retry;
+	struct timeval queued;
+	struct timeval due;
 	struct isis_tx_queue *queue;
 };
 
+DECLARE_DLIST(tx_queue_list, struct isis_tx_queue_entry, item);
+
 static unsigned tx_queue_hash_key(const void *p)
 {
 	const struct isis_tx_queue_entry *e = p;
@@ -85,6 +115,9 @@ struct isis_tx_queue *isis_tx_queue_new(
 	rv->send_event = send_event;
 
 	rv->hash = hash_create(tx_queue_hash_key, tx_queue_hash_cmp, NULL);
+	tx_queue_list_init(&rv->pending);
+	tx_queue_list_init(&rv->retries);
+	monotime(&rv->refilled);
 	return rv;
 }
 
@@ -92,15 +125,18 @@ static void tx_queue_element_free(void *element)
 {
 	struct isis_tx_queue_entry *e = element;
 
-	thread_cancel(&(e->retry));
+	tx_queue_list_del(e->list, e);
 
 	XFREE(MTYPE_TX_QUEUE_ENTRY, e);
 }
 
 void isis_tx_queue_free(struct isis_tx_queue *queue)
 {
+	thread_cancel(&queue->t_send);
 	hash_clean(queue->hash, tx_queue_element_free);
 	hash_free(queue->hash);
+	tx_queue_list_fini(&queue->pending);
+	tx_queue_list_fini(&queue->retries);
 	XFREE(MTYPE_TX_QUEUE, queue);
 }
 
@@ -114,22 +150,135 @@ static struct isis_tx_queue_entry *tx_queue_find(struct isis_tx_queue *queue,
 	return hash_lookup(queue->hash, &e);
 }
 
-static int tx_queue_send_event(struct thread *thread)
+/* a - b, in microseconds */
+static int64_t tx_queue_usec(const struct timeval *a, const struct timeval *b)
 {
-	struct isis_tx_queue_entry *e = THREAD_ARG(thread);
-	struct isis_tx_queue *queue = e->queue;
+	return (int64_t)(a->tv_sec - b->tv_sec) * 1000000
+	       + (a->tv_usec - b->tv_usec);
+}
 
-	e->retry = NULL;
-	thread_add_timer(master, tx_queue_send_event, e, 5, &e->retry);
+static void tx_queue_move(struct isis_tx_queue_entry *e,
+			  struct tx_queue_list_head *list)
+{
+	if (e->list)
+		tx_queue_list_del(e->list, e);
+	tx_queue_list_add_tail(list, e);
+	e->list = list;
+}
 
-	if (e->is_retry)
+/*
+ * Add the tokens accumulated since the last refill, up to the burst size.
+ * Returns false if the circuit isn't paced.
+ */
+static bool tx_queue_refill(struct isis_tx_queue *queue,
+			    const struct timeval *now)
+{
+	struct isis_area *area = queue->circuit->area;
+	uint64_t max;
+	int64_t elapsed;
+
+	if (!area->flood_rate)
+		return false;
+
+	max = (uint64_t)area->flood_burst * 1000000;
+	elapsed = tx_queue_usec(now, &queue->refilled);
+	queue->refilled = *now;
+	if (elapsed > 0)
+		queue->tokens += (uint64_t)elapsed * area->flood_rate;
+	if (queue->tokens > max)
+		queue->tokens = max;
+	return true;
+}
+
+static void tx_queue_send(struct isis_tx_queue *queue,
+			  struct isis_tx_queue_entry *e,
+			  const struct timeval *now)
+{
+	struct isis_tx_queue_stats *stats = &queue->stats;
+	struct timeval retry = {TX_QUEUE_RETRY_INTERVAL, 0};
+	uint64_t delay;
+
+	timeradd(now, &retry, &e->due);
+	tx_queue_move(e, &queue->retries);
+
+	stats->lsps_sent++;
+	if (e->is_retry) {
 		queue->circuit->area->lsp_rxmt_count++;
-	else
+		stats->lsps_rxmt++;
+	} else {
 		e->is_retry = true;
+		delay = tx_queue_usec(now, &e->queued);
+		stats->delay_total += delay;
+		stats->delay_count++;
+		if (delay > stats->delay_max)
+			stats->delay_max = delay;
+	}
 
 	queue->send_event(queue->circuit, e->lsp, e->type);
 	/* Don't access e here anymore, send_event might have destroyed it */
+}
+
+static int tx_queue_send_event(struct thread *thread);
+
+static void tx_queue_schedule(struct isis_tx_queue *queue,
+			      const struct timeval *now, bool paced)
+{
+	struct isis_tx_queue_entry *e;
+	struct isis_area *area = queue->circuit->area;
+	int64_t usec, wait = 0;
+
+	thread_cancel(&queue->t_send);
+
+	/* time until the next token */
+	if (paced && queue->tokens < 1000000)
+		wait = (1000000 - queue->tokens + area->flood_rate - 1)
+		       / area->flood_rate;
+
+	if (tx_queue_list_count(&queue->pending))
+		usec = wait;
+	else if ((e = tx_queue_list_first(&queue->retries)))
+		usec = MAX(tx_queue_usec(&e->due, now), wait);
+	else
+		return;
+
+	if (usec <= 0)
+		thread_add_event(master, tx_queue_send_event, queue, 0,
+				 &queue->t_send);
+	else
+		thread_add_timer_msec(master, tx_queue_send_event, queue,
+				      (usec + 999) / 1000, &queue->t_send);
+}
 
+static int tx_queue_send_event(struct thread *thread)
+{
+	struct isis_tx_queue *queue = THREAD_ARG(thread);
+	struct isis_tx_queue_entry *e;
+	struct timeval now;
+	unsigned int sent;
+	bool paced;
+
+	queue->t_send = NULL;
+
+	monotime(&now);
+	paced = tx_queue_refill(queue, &now);
+
+	for (sent = 0; sent < TX_QUEUE_BATCH; sent++) {
+		if (paced && queue->tokens < 1000000)
+			break;
+
+		e = tx_queue_list_first(&queue->pending);
+		if (!e) {
+			e = tx_queue_list_first(&queue->retries);
+			if (!e || timercmp(&now, &e->due, <))
+				break;
+		}
+
+		if (paced)
+			queue->tokens -= 1000000;
+		tx_queue_send(queue, e, &now);
+	}
+
+	tx_queue_schedule(queue, &now, paced);
 	return 0;
 }
 
@@ -164,10 +313,19 @@ void _isis_tx_queue_add(struct isis_tx_queue *queue,
 
 	e->type = type;
 
-	thread_cancel(&(e->retry));
-	thread_add_event(master, tx_queue_send_event, e, 0, &e->retry);
-
+	/* an LSP still waiting for its first transmission keeps its place */
+	if (e->list != &queue->pending) {
+		monotime(&e->queued);
+		tx_queue_move(e, &queue->pending);
+	}
 	e->is_retry = false;
+
+	if (!queue->t_send || tx_queue_list_count(&queue->pending) == 1) {
+		struct timeval now;
+
+		monotime(&now);
+		tx_queue_schedule(queue, &now, tx_queue_refill(queue, &now));
+	}
 }
 
 void _isis_tx_queue_del(struct isis_tx_queue *queue, struct isis_lsp *lsp,
@@ -187,7 +345,8 @@ void _isis_tx_queue_del(struct isis_tx_queue *queue, struct isis_lsp *lsp,
 			   func, file, line);
 	}
 
-	thread_cancel(&(e->retry));
+	/* the send timer just finds nothing to do, if this was next */
+	tx_queue_list_del(e->list, e);
 
 	hash_release(queue->hash, e);
 	XFREE(MTYPE_TX_QUEUE_ENTRY, e);
@@ -203,5 +362,12 @@ unsigned long isis_tx_queue_len(struct isis_tx_queue *queue)
 
 void isis_tx_queue_clean(struct isis_tx_queue *queue)
 {
+	thread_cancel(&queue->t_send);
 	hash_clean(queue->hash, tx_queue_element_free);
 }
+
+const struct isis_tx_queue_stats *
+isis_tx_queue_stats(struct isis_tx_queue *queue)
+{
+	return &queue->stats;
+}
@@ -29,6 +29,21 @@ enum isis_tx_type {
 
 struct isis_tx_queue;
 
+/*
+ * The LSPs put on a queue are sent at most isis_area->flood_rate per
+ * second, in bursts of up to isis_area->flood_burst; a rate of 0 doesn't
+ * pace them.  LSPs waiting for their first transmission go ahead of the
+ * retransmissions.
+ */
+struct isis_tx_queue_stats {
+	uint64_t lsps_sent;
+	uint64_t lsps_rxmt;
+	/* from queueing an LSP to its first transmission, in usec */
+	uint64_t delay_total;
+	uint64_t delay_count;
+	uint64_t delay_max;
+};
+
 struct isis_tx_queue *isis_tx_queue_new(
 		struct isis_circuit *circuit,
 		void(*send_event)(struct isis_circuit *circuit,
@@ -54,4 +69,7 @@ unsigned long isis_tx_queue_len(struct isis_tx_queue *queue);
 
 void isis_tx_queue_clean(struct isis_tx_queue *queue);
 
+const struct isis_tx_queue_stats *
+isis_tx_queue_stats(struct isis_tx_queue *queue);
+
 #endif
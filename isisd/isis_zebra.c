@@ -32,6 +32,7 @@
 #include "network.h"
 #include "prefix.h"
 #include "zclient.h"
+#include "zclient_nhg.h"
 #include "stream.h"
 #include "linklist.h"
 #include "nexthop.h"
@@ -59,6 +60,8 @@
 
 struct zclient *zclient;
 static struct zclient *zclient_sync;
+/* The nexthop groups the routes are sent with */
+static struct zclient_nhg_cache *nhg_cache;
 
 /* Router-id update message from zebra. */
 static int isis_router_id_update_zebra(ZAPI_CALLBACK_ARGS)
@@ -303,7 +306,7 @@ void isis_zebra_route_add_route(struct isis *isis, struct prefix *prefix,
 		return;
 	api.nexthop_num = count;
 
-	zclient_route_send(ZEBRA_ROUTE_ADD, zclient, &api);
+	zclient_nhg_route_add(nhg_cache, &api);
 }
 
 void isis_zebra_route_del_route(struct isis *isis,
@@ -326,7 +329,7 @@ void isis_zebra_route_del_route(struct isis *isis,
 		SET_FLAG(api.message, ZAPI_MESSAGE_SRCPFX);
 	}
 
-	zclient_route_send(ZEBRA_ROUTE_DELETE, zclient, &api);
+	zclient_nhg_route_delete(nhg_cache, &api);
 }
 
 /**
@@ -393,8 +396,8 @@ void isis_zebra_prefix_sid_install(struct isis_area *area,
 		zl.nexthop_num = count;
 	}
 
-	/* Send message to zebra. */
-	(void)zebra_send_mpls_labels(zclient, ZEBRA_MPLS_LABELS_REPLACE, &zl);
+	/* Queue message to zebra. */
+	(void)zclient_labels_bulk(zclient, ZEBRA_MPLS_LABELS_REPLACE, &zl);
 }
 
 /**
@@ -420,8 +423,17 @@ void isis_zebra_prefix_sid_uninstall(struct isis_area *area,
 	zl.type = ZEBRA_LSP_ISIS_SR;
 	zl.local_label = psid->label;
 
-	/* Send message to zebra. */
-	(void)zebra_send_mpls_labels(zclient, ZEBRA_MPLS_LABELS_DELETE, &zl);
+	/* Queue message to zebra. */
+	(void)zclient_labels_bulk(zclient, ZEBRA_MPLS_LABELS_DELETE, &zl);
+}
+
+/**
+ * Send the Prefix-SID label updates queued by isis_zebra_prefix_sid_install()
+ * and isis_zebra_prefix_sid_uninstall() to Zebra, in bulk messages.
+ */
+void isis_zebra_prefix_sid_flush(void)
+{
+	(void)zclient_labels_bulk_flush(zclient);
 }
 
 /**
@@ -740,6 +752,7 @@ void isis_zebra_vrf_deregister(struct isis *isis)
 
 static void isis_zebra_connected(struct zclient *zclient)
 {
+	zclient_nhg_cache_replay(nhg_cache);
 	zclient_send_reg_requests(zclient, VRF_DEFAULT);
 	zclient_register_opaque(zclient, LDP_RLFA_LABELS);
 	zclient_register_opaque(zclient, LDP_IGP_SYNC_IF_STATE_UPDATE);
@@ -785,6 +798,18 @@ stream_failure:
 	return ret;
 }
 
+static int isis_zebra_nhg_notify_owner(ZAPI_CALLBACK_ARGS)
+{
+	enum zapi_nhg_notify_owner note;
+	uint32_t id;
+
+	if (!zapi_nhg_notify_decode(zclient->ibuf, &id, &note))
+		return -1;
+
+	zclient_nhg_cache_notify(nhg_cache, id, note);
+	return 0;
+}
+
 static int isis_zebra_client_close_notify(ZAPI_CALLBACK_ARGS)
 {
 	int ret = 0;
@@ -812,6 +837,8 @@ void isis_zebra_init(struct thread_master *master, int instance)
 	zclient->interface_link_params = isis_zebra_link_params;
 	zclient->redistribute_route_add = isis_zebra_read;
 	zclient->redistribute_route_del = isis_zebra_read;
+	zclient->nhg_notify_owner = isis_zebra_nhg_notify_owner;
+	nhg_cache = zclient_nhg_cache_new(zclient);
 
 	/* Initialize special zclient for synchronous message exchanges. */
 	struct zclient_options options = zclient_options_default;
@@ -839,6 +866,7 @@ void isis_zebra_stop(void)
 	zclient_unregister_opaque(zclient, LDP_IGP_SYNC_ANNOUNCE_UPDATE);
 	zclient_stop(zclient_sync);
 	zclient_free(zclient_sync);
+	zclient_nhg_cache_free(&nhg_cache);
 	zclient_stop(zclient);
 	zclient_free(zclient);
 	frr_fini();
@@ -55,6 +55,7 @@ void isis_zebra_prefix_sid_uninstall(struct isis_area *area,
 				     struct prefix *prefix,
 				     struct isis_route_info *rinfo,
 				     struct isis_sr_psid_info *psid);
+void isis_zebra_prefix_sid_flush(void);
 void isis_zebra_send_adjacency_sid(int cmd, const struct sr_adjacency *sra);
 int isis_distribute_list_update(int routetype);
 void isis_zebra_redistribute_set(afi_t afi, int type, vrf_id_t vrf_id);
@@ -56,6 +56,8 @@
 #include "isisd/isis_constants.h"
 #include "isisd/isis_lsp.h"
 #include "isisd/isis_spf.h"
+#include "isisd/isis_spf_pool.h"
+#include "isisd/isis_flood_topo.h"
 #include "isisd/isis_route.h"
 #include "isisd/isis_zebra.h"
 #include "isisd/isis_events.h"
@@ -347,6 +349,10 @@ struct isis_area *isis_area_create(const char *area_tag, const char *vrf_name)
 	area->lsp_frag_threshold = 90; /* not currently configurable */
 	area->lsp_mtu =
 		yang_get_default_uint16("/frr-isisd:isis/instance/lsp/mtu");
+	area->flood_rate = yang_get_default_uint16(
+		"/frr-isisd:isis/instance/lsp/flooding/rate");
+	area->flood_burst = yang_get_default_uint16(
+		"/frr-isisd:isis/instance/lsp/flooding/burst");
 	area->lfa_load_sharing[0] = yang_get_default_bool(
 		"/frr-isisd:isis/instance/fast-reroute/level-1/lfa/load-sharing");
 	area->lfa_load_sharing[1] = yang_get_default_bool(
@@ -370,6 +376,7 @@ struct isis_area *isis_area_create(const char *area_tag, const char *vrf_name)
 	area->newmetric = 1;
 	area->lsp_frag_threshold = 90;
 	area->lsp_mtu = DEFAULT_LSP_MTU;
+	area->flood_burst = DEFAULT_LSP_FLOOD_BURST;
 	area->lfa_load_sharing[0] = true;
 	area->lfa_load_sharing[1] = true;
 	area->attached_bit_send = true;
@@ -540,7 +547,10 @@ void isis_area_destroy(struct isis_area *area)
 
 	thread_cancel_event(master, area);
 
+	isis_flood_topo_free(area);
+
 	listnode_delete(area->isis->area_list, area);
+	isis_spf_pool_update();
 
 	free(area->area_tag);
 
@@ -1982,6 +1992,14 @@ static void isis_spf_ietf_common(struct vty *vty, struct isis *isis)
 			} else {
 				vty_out(vty, "    Using legacy backoff algo\n");
 			}
+
+			vty_out(vty,
+				"    SPF runs: %u full, %u incremental, %u partial (last %s)\n",
+				area->spf_mode_count[level - 1][ISIS_SPF_FULL],
+				area->spf_mode_count[level - 1]
+						    [ISIS_SPF_INCREMENTAL],
+				area->spf_mode_count[level - 1][ISIS_SPF_PRC],
+				isis_spf_mode2str(area->spf_mode[level - 1]));
 		}
 	}
 }
@@ -2082,6 +2100,8 @@ static void common_isis_summary(struct vty *vty, struct isis *isis)
 			vty_out(vty, "         LSPs purged: %" PRIu64 "\n",
 				area->lsp_purge_count[level - 1]);
 
+			isis_flood_topo_show(vty, area, level);
+
 			if (area->spf_timer[level - 1])
 				vty_out(vty, "    SPF: (pending)\n");
 			else
@@ -71,6 +71,7 @@ extern struct zebra_privs_t isisd_privs;
 /* #define EXTREME_DEBUG  */
 
 struct fabricd;
+struct isis_flood_topo;
 
 struct isis_master {
 	/* ISIS instance. */
@@ -109,6 +110,17 @@ enum spf_tree_id {
 	SPFTREE_COUNT
 };
 
+/*
+ * How much of the previous SPF run can be reused, from nothing to only the
+ * shortest path trees.  Ordered so that combining two changes is MIN().
+ */
+enum isis_spf_mode {
+	ISIS_SPF_FULL = 0,
+	ISIS_SPF_INCREMENTAL,
+	ISIS_SPF_PRC,
+	ISIS_SPF_MODE_MAX
+};
+
 struct lsp_refresh_arg {
 	struct isis_area *area;
 	int level;
@@ -127,6 +139,9 @@ struct isis_area {
 	struct isis_spftree *spftree[SPFTREE_COUNT][ISIS_LEVELS];
 #define DEFAULT_LSP_MTU 1497
 	unsigned int lsp_mtu;      /* Size of LSPs to generate */
+#define DEFAULT_LSP_FLOOD_BURST 10
+	uint16_t flood_rate;  /* LSPs/s sent per circuit, 0 if unpaced */
+	uint16_t flood_burst; /* LSPs sent back to back when paced */
 	struct list *circuit_list; /* IS-IS circuits */
 	struct list *adjacency_list; /* IS-IS adjacencies */
 	struct flags flags;
@@ -146,6 +161,10 @@ struct isis_area {
 	 * be delayed until the next regular refresh.
 	 */
 	int lsp_regenerate_pending[ISIS_LEVELS];
+	/* Updates only reflood the fragments that changed, all of them are
+	 * refreshed again by this time at the latest.
+	 */
+	time_t lsp_refresh_due[ISIS_LEVELS];
 
 	bool bfd_signalled_down;
 	bool bfd_force_spf_refresh;
@@ -197,9 +216,14 @@ struct isis_area {
 	struct isis_sr_db srdb;
 	int ipv6_circuits;
 	bool purge_originator;
+	/* Flood along a sparse flooding topology, see isis_flood_topo.h */
+	bool dynamic_flooding;
+	struct isis_flood_topo *flood_topo[ISIS_LEVELS];
 	/* SPF prefix priorities. */
 	struct spf_prefix_priority_acl
 		spf_prefix_priorities[SPF_PREFIX_PRIO_MAX];
+	/* SPF worker pthreads for the Fast Re-Route SPTs. */
+	uint8_t spf_threads;
 	/* Fast Re-Route information. */
 	size_t lfa_protected_links[ISIS_LEVELS];
 	size_t lfa_load_sharing[ISIS_LEVELS];
@@ -221,6 +245,11 @@ struct isis_area {
 							    SPF algo
 							    parameters*/
 	struct thread *spf_timer[ISIS_LEVELS];
+	/* SPF mode needed by the LSDB changes since the last run */
+	enum isis_spf_mode spf_pending_mode[ISIS_LEVELS];
+	/* SPF mode of the current (or last) run */
+	enum isis_spf_mode spf_mode[ISIS_LEVELS];
+	uint32_t spf_mode_count[ISIS_LEVELS][ISIS_SPF_MODE_MAX];
 
 	struct lsp_refresh_arg lsp_refresh_arg[ISIS_LEVELS];
 
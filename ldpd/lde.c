@@ -48,6 +48,9 @@ static __inline	int	 lde_nbr_compare(const struct lde_nbr *,
 static struct lde_nbr	*lde_nbr_new(uint32_t, struct lde_nbr *);
 static void		 lde_nbr_del(struct lde_nbr *);
 static struct lde_nbr	*lde_nbr_find(uint32_t);
+static __inline int	 lde_addr_compare(const struct lde_addr *,
+			    const struct lde_addr *);
+static int		 lde_batch_flush_all(struct thread *);
 static void		 lde_nbr_clear(void);
 static void		 lde_nbr_addr_update(struct lde_nbr *,
 			    struct lde_addr *, int);
@@ -68,6 +71,7 @@ static void		 lde_check_filter_af(int, struct ldpd_af_conf *,
 			     const char *);
 
 RB_GENERATE(nbr_tree, lde_nbr, entry, lde_nbr_compare)
+RB_GENERATE(lde_addr_head, lde_addr, entry, lde_addr_compare)
 RB_GENERATE(lde_map_head, lde_map, entry, lde_map_compare)
 
 struct ldpd_conf	*ldeconf;
@@ -76,6 +80,7 @@ struct nbr_tree		 lde_nbrs = RB_INITIALIZER(&lde_nbrs);
 static struct imsgev	*iev_ldpe;
 static struct imsgev    iev_main_sync_data;
 static struct imsgev	*iev_main, *iev_main_sync;
+static struct thread	*lde_batch_ev;
 
 /* lde privileges */
 static zebra_capabilities_t _caps_p [] =
@@ -233,12 +238,128 @@ lde_imsg_compose_parent_sync(int type, pid_t pid, void *data, uint16_t datalen)
 	imsg_flush(&iev_main_sync->ibuf);
 }
 
+/*
+ * Label mappings, requests, releases and withdraws are queued per neighbor
+ * and passed to ldpe many to an imsg.  The _END markers, which make ldpe
+ * send what it has, are held until the current event is done or something
+ * else needs to go out to the same neighbor: a run of single label
+ * messages then ends up packed in as few PDUs as possible, in order.
+ */
+#define LDE_BATCH_MAX	((MAX_IMSGSIZE - IMSG_HEADER_SIZE) / sizeof(struct map))
+
+static int
+lde_batch_end_type(int type)
+{
+	switch (type) {
+	case IMSG_MAPPING_ADD:
+		return (IMSG_MAPPING_ADD_END);
+	case IMSG_RELEASE_ADD:
+		return (IMSG_RELEASE_ADD_END);
+	case IMSG_REQUEST_ADD:
+		return (IMSG_REQUEST_ADD_END);
+	case IMSG_WITHDRAW_ADD:
+		return (IMSG_WITHDRAW_ADD_END);
+	default:
+		return (0);
+	}
+}
+
+static int
+lde_batch_add_type(int type)
+{
+	switch (type) {
+	case IMSG_MAPPING_ADD_END:
+		return (IMSG_MAPPING_ADD);
+	case IMSG_RELEASE_ADD_END:
+		return (IMSG_RELEASE_ADD);
+	case IMSG_REQUEST_ADD_END:
+		return (IMSG_REQUEST_ADD);
+	case IMSG_WITHDRAW_ADD_END:
+		return (IMSG_WITHDRAW_ADD);
+	default:
+		return (0);
+	}
+}
+
+static void
+lde_batch_send(struct lde_nbr *ln)
+{
+	if (ln->batch_cnt == 0)
+		return;
+
+	imsg_compose_event(iev_ldpe, ln->batch_type, ln->peerid, 0, -1,
+	    ln->batch, ln->batch_cnt * sizeof(struct map));
+	ln->batch_cnt = 0;
+}
+
+static void
+lde_batch_flush(struct lde_nbr *ln)
+{
+	lde_batch_send(ln);
+	if (ln->batch_end)
+		imsg_compose_event(iev_ldpe, lde_batch_end_type(ln->batch_type),
+		    ln->peerid, 0, -1, NULL, 0);
+	ln->batch_end = 0;
+	ln->batch_type = 0;
+}
+
+/* ARGSUSED */
+static int
+lde_batch_flush_all(struct thread *thread)
+{
+	struct lde_nbr		*ln;
+
+	if (iev_ldpe->ibuf.fd == -1)
+		return (0);
+
+	RB_FOREACH(ln, nbr_tree, &lde_nbrs)
+		lde_batch_flush(ln);
+
+	return (0);
+}
+
 int
 lde_imsg_compose_ldpe(int type, uint32_t peerid, pid_t pid, void *data,
     uint16_t datalen)
 {
+	struct lde_nbr		*ln = NULL;
+	int			 add_type;
+
 	if (iev_ldpe->ibuf.fd == -1)
 		return (0);
+
+	if (peerid != 0)
+		ln = lde_nbr_find(peerid);
+	if (ln == NULL)
+		return (imsg_compose_event(iev_ldpe, type, peerid, pid,
+		     -1, data, datalen));
+
+	if (lde_batch_end_type(type) && datalen == sizeof(struct map)) {
+		if (ln->batch_type != type)
+			lde_batch_flush(ln);
+		if (ln->batch_cnt == LDE_BATCH_MAX)
+			lde_batch_send(ln);
+		if (ln->batch == NULL &&
+		    (ln->batch = calloc(LDE_BATCH_MAX, sizeof(struct map))) == NULL)
+			fatal(__func__);
+
+		ln->batch_type = type;
+		memcpy(&ln->batch[ln->batch_cnt++], data, sizeof(struct map));
+		return (0);
+	}
+
+	if ((add_type = lde_batch_add_type(type)) != 0) {
+		if (ln->batch_type != add_type)
+			lde_batch_flush(ln);
+		ln->batch_type = add_type;
+		ln->batch_end = 1;
+		thread_add_event(master, lde_batch_flush_all, NULL, 0,
+		    &lde_batch_ev);
+		return (0);
+	}
+
+	/* anything else for the neighbor goes out after what's queued */
+	lde_batch_flush(ln);
 	return (imsg_compose_event(iev_ldpe, type, peerid, pid,
 	     -1, data, datalen));
 }
@@ -1453,7 +1574,7 @@ lde_nbr_new(uint32_t peerid, struct lde_nbr *new)
 	fec_init(&ln->sent_req);
 	fec_init(&ln->sent_wdraw);
 
-	TAILQ_INIT(&ln->addr_list);
+	RB_INIT(lde_addr_head, &ln->addr_tree);
 
 	if (RB_INSERT(nbr_tree, &lde_nbrs, ln) != NULL)
 		fatalx("lde_nbr_new: RB_INSERT failed");
@@ -1464,60 +1585,74 @@ lde_nbr_new(uint32_t peerid, struct lde_nbr *new)
 static void
 lde_nbr_del(struct lde_nbr *ln)
 {
-	struct fec		*f;
+	struct fec		*f, key;
 	struct fec_node		*fn;
 	struct fec_nh		*fnh;
+	struct fec_nh_addr	*na;
+	struct lde_addr		*lde_addr;
 	struct l2vpn_pw		*pw;
 	struct lde_nbr		*lnbr;
 
 	if (ln == NULL)
 		return;
 
-	/* uninstall received mappings */
-	RB_FOREACH(f, fec_tree, &ft) {
-		fn = (struct fec_node *)f;
+	/* Update RLFA clients. */
+	lde_rlfa_nbr_del(ln);
 
-		/* Update RLFA clients. */
-		lde_rlfa_update_clients(f, ln, MPLS_INVALID_LABEL);
+	/*
+	 * Uninstall received mappings: the prefix FECs are found through
+	 * the neighbor addresses, the pseudowires come last in the FEC tree.
+	 */
+	RB_FOREACH(lde_addr, lde_addr_head, &ln->addr_tree) {
+		na = fec_nh_addr_find(lde_addr->af, &lde_addr->addr);
+		if (na == NULL)
+			continue;
 
-		LIST_FOREACH(fnh, &fn->nexthops, entry) {
-			switch (f->type) {
-			case FEC_TYPE_IPV4:
-			case FEC_TYPE_IPV6:
-				if (!lde_address_find(ln, fnh->af,
-				    &fnh->nexthop))
-					continue;
+		LIST_FOREACH(fnh, &na->nexthops, addr_entry) {
+			fn = fnh->fn;
+			if (fn->fec.type != FEC_TYPE_IPV4 &&
+			    fn->fec.type != FEC_TYPE_IPV6)
+				continue;
 
-				/*
-				 * Ordered Control: must mark any non-connected
-				 * NH to wait until we receive a labelmap msg
-				 * before installing in kernel and sending to
-				 * peer, must do this as NHs are not removed
-				 * when lsps go down.  Also send label withdraw
-				 * to other neighbors for all fecs from neighbor
-				 * going down
-				 */
-				if (ldeconf->flags & F_LDPD_ORDERED_CONTROL) {
-					fnh->flags |= F_FEC_NH_DEFER;
-
-					RB_FOREACH(lnbr, nbr_tree, &lde_nbrs) {
-						if (ln->peerid == lnbr->peerid)
-							continue;
-						lde_send_labelwithdraw(lnbr, fn, NULL, NULL);
-					}
-				}
-				break;
-			case FEC_TYPE_PWID:
-				if (f->u.pwid.lsr_id.s_addr != ln->id.s_addr)
-					continue;
-				pw = (struct l2vpn_pw *) fn->data;
-				if (pw) {
-					pw->reason = F_PW_NO_REMOTE_LABEL;
-					l2vpn_pw_reset(pw);
+			/*
+			 * Ordered Control: must mark any non-connected
+			 * NH to wait until we receive a labelmap msg
+			 * before installing in kernel and sending to
+			 * peer, must do this as NHs are not removed
+			 * when lsps go down.  Also send label withdraw
+			 * to other neighbors for all fecs from neighbor
+			 * going down
+			 */
+			if (ldeconf->flags & F_LDPD_ORDERED_CONTROL) {
+				fnh->flags |= F_FEC_NH_DEFER;
+
+				RB_FOREACH(lnbr, nbr_tree, &lde_nbrs) {
+					if (ln->peerid == lnbr->peerid)
+						continue;
+					lde_send_labelwithdraw(lnbr, fn, NULL, NULL);
 				}
-				break;
-			default:
-				break;
+			}
+
+			lde_send_delete_klabel(fn, fnh);
+			fnh->remote_label = NO_LABEL;
+		}
+	}
+
+	memset(&key, 0, sizeof(key));
+	key.type = FEC_TYPE_PWID;
+	for (f = RB_NFIND(fec_tree, &ft, &key); f != NULL;
+	    f = RB_NEXT(fec_tree, f)) {
+		if (f->type != FEC_TYPE_PWID)
+			break;
+		if (f->u.pwid.lsr_id.s_addr != ln->id.s_addr)
+			continue;
+		fn = (struct fec_node *)f;
+
+		LIST_FOREACH(fnh, &fn->nexthops, entry) {
+			pw = (struct l2vpn_pw *) fn->data;
+			if (pw) {
+				pw->reason = F_PW_NO_REMOTE_LABEL;
+				l2vpn_pw_reset(pw);
 			}
 
 			lde_send_delete_klabel(fn, fnh);
@@ -1536,6 +1671,8 @@ lde_nbr_del(struct lde_nbr *ln)
 
 	RB_REMOVE(nbr_tree, &lde_nbrs, ln);
 
+	/* the neighbor is gone from ldpe too */
+	free(ln->batch);
 	free(ln);
 }
 
@@ -2126,7 +2263,7 @@ lde_address_add(struct lde_nbr *ln, struct lde_addr *lde_addr)
 
 	new->af = lde_addr->af;
 	new->addr = lde_addr->addr;
-	TAILQ_INSERT_TAIL(&ln->addr_list, new, entry);
+	RB_INSERT(lde_addr_head, &ln->addr_tree, new);
 
 	/* reevaluate the previously received mappings from this neighbor */
 	lde_nbr_addr_update(ln, lde_addr, 0);
@@ -2144,23 +2281,29 @@ lde_address_del(struct lde_nbr *ln, struct lde_addr *lde_addr)
 	/* reevaluate the previously received mappings from this neighbor */
 	lde_nbr_addr_update(ln, lde_addr, 1);
 
-	TAILQ_REMOVE(&ln->addr_list, lde_addr, entry);
+	RB_REMOVE(lde_addr_head, &ln->addr_tree, lde_addr);
 	free(lde_addr);
 
 	return (0);
 }
 
+static __inline int
+lde_addr_compare(const struct lde_addr *a, const struct lde_addr *b)
+{
+	if (a->af != b->af)
+		return (a->af < b->af ? -1 : 1);
+
+	return (ldp_addrcmp(a->af, &a->addr, &b->addr));
+}
+
 struct lde_addr *
 lde_address_find(struct lde_nbr *ln, int af, union ldpd_addr *addr)
 {
-	struct lde_addr		*lde_addr;
-
-	TAILQ_FOREACH(lde_addr, &ln->addr_list, entry)
-		if (lde_addr->af == af &&
-		    ldp_addrcmp(af, &lde_addr->addr, addr) == 0)
-			return (lde_addr);
+	struct lde_addr		 key;
 
-	return (NULL);
+	key.af = af;
+	key.addr = *addr;
+	return (RB_FIND(lde_addr_head, &ln->addr_tree, &key));
 }
 
 static void
@@ -2168,8 +2311,11 @@ lde_address_list_free(struct lde_nbr *ln)
 {
 	struct lde_addr		*lde_addr;
 
-	while ((lde_addr = TAILQ_POP_FIRST(&ln->addr_list, entry)) != NULL)
+	while (!RB_EMPTY(lde_addr_head, &ln->addr_tree)) {
+		lde_addr = RB_ROOT(lde_addr_head, &ln->addr_tree);
+		RB_REMOVE(lde_addr_head, &ln->addr_tree, lde_addr);
 		free(lde_addr);
+	}
 }
 
 /*
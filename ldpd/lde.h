@@ -78,10 +78,12 @@ struct lde_wdraw {
 
 /* Addresses belonging to neighbor */
 struct lde_addr {
-	TAILQ_ENTRY(lde_addr)	 entry;
+	RB_ENTRY(lde_addr)	 entry;
 	int			 af;
 	union ldpd_addr		 addr;
 };
+RB_HEAD(lde_addr_head, lde_addr);
+RB_PROTOTYPE(lde_addr_head, lde_addr, entry, lde_addr_compare)
 
 /* just the info LDE needs */
 struct lde_nbr {
@@ -97,13 +99,20 @@ struct lde_nbr {
 	struct fec_tree		 sent_map;
 	struct fec_tree		 sent_map_pending;
 	struct fec_tree		 sent_wdraw;
-	TAILQ_HEAD(, lde_addr)	 addr_list;
+	struct lde_addr_head	 addr_tree;
+	/* label messages queued for ldpe, see lde_imsg_compose_ldpe() */
+	struct map		*batch;
+	uint16_t		 batch_cnt;
+	int			 batch_type;
+	int			 batch_end;
 };
 RB_HEAD(nbr_tree, lde_nbr);
 RB_PROTOTYPE(nbr_tree, lde_nbr, entry, lde_nbr_compare)
 
 struct fec_nh {
 	LIST_ENTRY(fec_nh)	 entry;
+	LIST_ENTRY(fec_nh)	 addr_entry;	/* same nexthop address */
+	struct fec_node		*fn;
 	int			 af;
 	union ldpd_addr		 nexthop;
 	ifindex_t		 ifindex;
@@ -117,6 +126,16 @@ struct fec_nh {
 #define F_FEC_NH_DEFER		0x04		/* running ordered control */
 #define F_FEC_NH_NO_LDP		0x08		/* no ldp on this interface */
 
+/* fib nexthops by address, to find those of a neighbor */
+struct fec_nh_addr {
+	RB_ENTRY(fec_nh_addr)	 entry;
+	int			 af;
+	union ldpd_addr		 addr;
+	LIST_HEAD(, fec_nh)	 nexthops;
+};
+RB_HEAD(fec_nh_addr_tree, fec_nh_addr);
+RB_PROTOTYPE(fec_nh_addr_tree, fec_nh_addr, entry, fec_nh_addr_compare)
+
 struct fec_node {
 	struct fec		 fec;
 
@@ -211,6 +230,7 @@ void		 fec_clear(struct fec_tree *, void (*)(void *));
 void		 rt_dump(pid_t);
 void		 fec_snap(struct lde_nbr *);
 void		 fec_tree_clear(void);
+struct fec_nh_addr *fec_nh_addr_find(int, union ldpd_addr *);
 struct fec_nh	*fec_nh_find(struct fec_node *, int, union ldpd_addr *,
 		    ifindex_t, uint8_t, unsigned short);
 void		 lde_kernel_insert(struct fec *, int, union ldpd_addr *,
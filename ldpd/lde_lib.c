@@ -35,10 +35,14 @@ static struct fec_node	*fec_add(struct fec *fec);
 static struct fec_nh	*fec_nh_add(struct fec_node *, int, union ldpd_addr *,
 			    ifindex_t, uint8_t, unsigned short);
 static void		 fec_nh_del(struct fec_nh *);
+static __inline int	 fec_nh_addr_compare(const struct fec_nh_addr *,
+			    const struct fec_nh_addr *);
 
 RB_GENERATE(fec_tree, fec, entry, fec_compare)
+RB_GENERATE(fec_nh_addr_tree, fec_nh_addr, entry, fec_nh_addr_compare)
 
 struct fec_tree		 ft = RB_INITIALIZER(&ft);
+static struct fec_nh_addr_tree fec_nh_addrs = RB_INITIALIZER(&fec_nh_addrs);
 struct thread		*gc_timer;
 
 /* FEC tree functions */
@@ -295,11 +299,31 @@ fec_nh_find(struct fec_node *fn, int af, union ldpd_addr *nexthop,
 	return (NULL);
 }
 
+static __inline int
+fec_nh_addr_compare(const struct fec_nh_addr *a, const struct fec_nh_addr *b)
+{
+	if (a->af != b->af)
+		return (a->af < b->af ? -1 : 1);
+
+	return (ldp_addrcmp(a->af, &a->addr, &b->addr));
+}
+
+struct fec_nh_addr *
+fec_nh_addr_find(int af, union ldpd_addr *addr)
+{
+	struct fec_nh_addr	 key;
+
+	key.af = af;
+	key.addr = *addr;
+	return (RB_FIND(fec_nh_addr_tree, &fec_nh_addrs, &key));
+}
+
 static struct fec_nh *
 fec_nh_add(struct fec_node *fn, int af, union ldpd_addr *nexthop,
     ifindex_t ifindex, uint8_t route_type, unsigned short route_instance)
 {
-	struct fec_nh	*fnh;
+	struct fec_nh		*fnh;
+	struct fec_nh_addr	*na;
 
 	fnh = calloc(1, sizeof(*fnh));
 	if (fnh == NULL)
@@ -311,15 +335,36 @@ fec_nh_add(struct fec_node *fn, int af, union ldpd_addr *nexthop,
 	fnh->remote_label = NO_LABEL;
 	fnh->route_type = route_type;
 	fnh->route_instance = route_instance;
+	fnh->fn = fn;
 	LIST_INSERT_HEAD(&fn->nexthops, fnh, entry);
 
+	na = fec_nh_addr_find(af, nexthop);
+	if (na == NULL) {
+		if ((na = calloc(1, sizeof(*na))) == NULL)
+			fatal(__func__);
+		na->af = af;
+		na->addr = *nexthop;
+		LIST_INIT(&na->nexthops);
+		RB_INSERT(fec_nh_addr_tree, &fec_nh_addrs, na);
+	}
+	LIST_INSERT_HEAD(&na->nexthops, fnh, addr_entry);
+
 	return (fnh);
 }
 
 static void
 fec_nh_del(struct fec_nh *fnh)
 {
+	struct fec_nh_addr	*na;
+
 	LIST_REMOVE(fnh, entry);
+	LIST_REMOVE(fnh, addr_entry);
+
+	na = fec_nh_addr_find(fnh->af, &fnh->nexthop);
+	if (na && LIST_EMPTY(&na->nexthops)) {
+		RB_REMOVE(fec_nh_addr_tree, &fec_nh_addrs, na);
+		free(na);
+	}
 	free(fnh);
 }
 
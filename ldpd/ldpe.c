@@ -646,8 +646,10 @@ ldpe_dispatch_lde(struct thread *thread)
 	struct imsgbuf		*ibuf = &iev->ibuf;
 	struct imsg		 imsg;
 	struct map		*map;
+	struct mapping_head	*mh;
 	struct notify_msg	*nm;
 	struct nbr		*nbr;
+	size_t			 len;
 	int			 n, shut = 0;
 
 	iev->ev_read = NULL;
@@ -668,10 +670,10 @@ ldpe_dispatch_lde(struct thread *thread)
 		case IMSG_RELEASE_ADD:
 		case IMSG_REQUEST_ADD:
 		case IMSG_WITHDRAW_ADD:
-			if (imsg.hdr.len - IMSG_HEADER_SIZE !=
-			    sizeof(struct map))
+			/* lde sends them in batches */
+			len = imsg.hdr.len - IMSG_HEADER_SIZE;
+			if (len == 0 || len % sizeof(struct map) != 0)
 				fatalx("invalid size of map request");
-			map = imsg.data;
 
 			nbr = nbr_find_peerid(imsg.hdr.peerid);
 			if (nbr == NULL)
@@ -681,18 +683,22 @@ ldpe_dispatch_lde(struct thread *thread)
 
 			switch (imsg.hdr.type) {
 			case IMSG_MAPPING_ADD:
-				mapping_list_add(&nbr->mapping_list, map);
+				mh = &nbr->mapping_list;
 				break;
 			case IMSG_RELEASE_ADD:
-				mapping_list_add(&nbr->release_list, map);
+				mh = &nbr->release_list;
 				break;
 			case IMSG_REQUEST_ADD:
-				mapping_list_add(&nbr->request_list, map);
+				mh = &nbr->request_list;
 				break;
 			case IMSG_WITHDRAW_ADD:
-				mapping_list_add(&nbr->withdraw_list, map);
+			default:
+				mh = &nbr->withdraw_list;
 				break;
 			}
+			for (map = imsg.data; len > 0;
+			    map++, len -= sizeof(struct map))
+				mapping_list_add(mh, map);
 			break;
 		case IMSG_MAPPING_ADD_END:
 		case IMSG_RELEASE_ADD_END:
@@ -258,6 +258,46 @@ void lde_rlfa_update_clients(struct fec *fec, struct lde_nbr *ln,
 		lde_rlfa_label_update(fec);
 }
 
+/*
+ * Same as calling lde_rlfa_update_clients() with an invalid label for every
+ * FEC when a neighbor goes down, but without walking the whole FEC tree.
+ */
+void lde_rlfa_nbr_del(struct lde_nbr *ln)
+{
+	struct ldp_rlfa_node	*rnode;
+	struct prefix		 pq_prefix;
+	struct fec		 fec;
+	bool			 notify;
+
+	RB_FOREACH (rnode, ldp_rlfa_node_head, &rlfa_node_tree) {
+		struct ldp_rlfa_client *rclient;
+
+		notify = false;
+		if (IPV4_ADDR_SAME(&rnode->pq_address, &ln->id)) {
+			lde_prefix2fec(&rnode->destination, &fec);
+			if (fec_find(&ft, &fec)) {
+				rnode->pq_label = MPLS_INVALID_LABEL;
+				notify = true;
+			}
+		}
+		if (!notify) {
+			memset(&pq_prefix, 0, sizeof(pq_prefix));
+			pq_prefix.family = AF_INET;
+			pq_prefix.prefixlen = IPV4_MAX_BITLEN;
+			pq_prefix.u.prefix4 = rnode->pq_address;
+			lde_prefix2fec(&pq_prefix, &fec);
+			if (fec_find(&ft, &fec)
+			    && rlfa_node_find(&pq_prefix, ln->id) == NULL)
+				notify = true;
+		}
+		if (!notify)
+			continue;
+
+		RB_FOREACH (rclient, ldp_rlfa_client_head, &rnode->clients)
+			lde_rlfa_client_send(rclient);
+	}
+}
+
 void ldpe_rlfa_init(struct ldp_rlfa_client *rclient)
 {
 	struct tnbr *tnbr;
@@ -72,6 +72,7 @@ void		 lde_rlfa_client_send(struct ldp_rlfa_client *rclient);
 void		 lde_rlfa_label_update(const struct fec *fec);
 void		 lde_rlfa_update_clients(struct fec *fec, struct lde_nbr *ln,
 		    uint32_t label);
+void		 lde_rlfa_nbr_del(struct lde_nbr *ln);
 void		 ldpe_rlfa_init(struct ldp_rlfa_client *rclient);
 void		 ldpe_rlfa_exit(struct ldp_rlfa_client *rclient);
 
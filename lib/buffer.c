@@ -114,6 +114,16 @@ char *buffer_getstr(struct buffer *b)
 	return s;
 }
 
+size_t buffer_pending(struct buffer *b)
+{
+	size_t totlen = 0;
+	struct buffer_data *data;
+
+	for (data = b->head; data; data = data->next)
+		totlen += data->cp - data->sp;
+	return totlen;
+}
+
 /* Clear and free all allocated data. */
 void buffer_reset(struct buffer *b)
 {
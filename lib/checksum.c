@@ -12,38 +12,56 @@
 int /* return checksum in low-order 16 bits */
 	in_cksum(void *parg, int nbytes)
 {
-	unsigned short *ptr = parg;
-	register long sum; /* assumes long == 32 bits */
-	unsigned short oddbyte;
-	register unsigned short answer; /* assumes unsigned short == 16 bits */
+	const uint8_t *ptr = parg;
+	uint64_t sum = 0;
+	uint32_t word;
+	uint16_t half;
+	uint16_t oddbyte;
 
 	/*
-	 * Our algorithm is simple, using a 32-bit accumulator (sum),
-	 * we add sequential 16-bit words to it, and at the end, fold back
-	 * all the carry bits from the top 16 bits into the lower 16 bits.
+	 * The ones' complement sum doesn't depend on the word size (RFC 1071,
+	 * 2.(C)), so sum 32-bit words into a 64-bit accumulator, which takes
+	 * half the additions and can't overflow for any IP packet, and fold
+	 * the carries back down to 16 bits at the end.  memcpy() keeps the
+	 * loads safe for unaligned buffers and compiles to plain loads.
 	 */
-
-	sum = 0;
-	while (nbytes > 1) {
-		sum += *ptr++;
+	while (nbytes >= 16) {
+		memcpy(&word, ptr, 4);
+		sum += word;
+		memcpy(&word, ptr + 4, 4);
+		sum += word;
+		memcpy(&word, ptr + 8, 4);
+		sum += word;
+		memcpy(&word, ptr + 12, 4);
+		sum += word;
+		ptr += 16;
+		nbytes -= 16;
+	}
+	while (nbytes >= 4) {
+		memcpy(&word, ptr, 4);
+		sum += word;
+		ptr += 4;
+		nbytes -= 4;
+	}
+	if (nbytes >= 2) {
+		memcpy(&half, ptr, 2);
+		sum += half;
+		ptr += 2;
 		nbytes -= 2;
 	}
 
 	/* mop up an odd byte, if necessary */
 	if (nbytes == 1) {
 		oddbyte = 0; /* make sure top half is zero */
-		*((uint8_t *)&oddbyte) = *(uint8_t *)ptr; /* one byte only */
+		*((uint8_t *)&oddbyte) = *ptr; /* one byte only */
 		sum += oddbyte;
 	}
 
-	/*
-	 * Add back carry outs from top 16 bits to low 16 bits.
-	 */
+	while (sum >> 16)
+		sum = (sum & 0xffff) + (sum >> 16);
 
-	sum = (sum >> 16) + (sum & 0xffff); /* add high-16 to low-16 */
-	sum += (sum >> 16);		    /* add carry */
-	answer = ~sum; /* ones-complement, then truncate to 16 bits */
-	return (answer);
+	/* ones-complement, then truncate to 16 bits */
+	return (uint16_t)~sum;
 }
 
 int in_cksum_with_ph4(struct ipv4_ph *ph, void *data, int nbytes)
@@ -96,7 +114,19 @@ uint16_t fletcher_checksum(uint8_t *buffer, const size_t len,
 	while (left != 0) {
 		partial_len = MIN(left, MODX);
 
-		for (i = 0; i < partial_len; i++) {
+		/*
+		 * Eight bytes at a time, c1 grows by 8 * c0 plus a weighted
+		 * sum of the bytes, which leaves only two additions per eight
+		 * bytes on the c0 -> c1 dependency chain instead of two per
+		 * byte.  MODX keeps c1 within an int either way.
+		 */
+		for (i = 0; i + 8 <= partial_len; i += 8, p += 8) {
+			c1 += (c0 << 3) + 8 * p[0] + 7 * p[1] + 6 * p[2]
+			      + 5 * p[3] + 4 * p[4] + 3 * p[5] + 2 * p[6] + p[7];
+			c0 += p[0] + p[1] + p[2] + p[3] + p[4] + p[5] + p[6]
+			      + p[7];
+		}
+		for (; i < partial_len; i++) {
 			c0 = c0 + *(p++);
 			c1 += c0;
 		}
@@ -37,6 +37,8 @@
 #include "linklist.h"
 #include "vty.h"
 #include "workqueue.h"
+#include "job_pool.h"
+#include "frr_pthread.h"
 #include "vrf.h"
 #include "command_match.h"
 #include "command_graph.h"
@@ -202,17 +204,26 @@ vector cmd_make_strvec(const char *string)
 	if (*copy == '\0' || *copy == '!' || *copy == '#')
 		return NULL;
 
-	vector result = frrstr_split_vec(copy, "\n\r\t ");
+	/*
+	 * Split on "\n\r\t " in a single pass, without empty tokens; this is
+	 * run for every configuration line.
+	 */
+	vector result = vector_init(8);
+
+	while (*copy != '\0') {
+		size_t len = strcspn(copy, "\n\r\t ");
+		char *token;
 
-	for (unsigned int i = 0; i < vector_active(result); i++) {
-		if (strlen(vector_slot(result, i)) == 0) {
-			XFREE(MTYPE_TMP, vector_slot(result, i));
-			vector_unset(result, i);
+		if (len) {
+			token = XMALLOC(MTYPE_TMP, len + 1);
+			memcpy(token, copy, len);
+			token[len] = '\0';
+			vector_set(result, token);
 		}
+		copy += len;
+		copy += strspn(copy, "\n\r\t ");
 	}
 
-	vector_compact(result);
-
 	return result;
 }
 
@@ -469,6 +480,12 @@ static int config_write_host(struct vty *vty)
 			vty_out(vty, "service walltime-warning %lu\n",
 				walltime_threshold);
 
+		if (timeline_threshold)
+			vty_out(vty, "service timeline-dump %lu\n",
+				timeline_threshold / 1000);
+
+		frr_pthread_config_write(vty);
+
 		if (host.advanced)
 			vty_out(vty, "service advanced-vty\n");
 
@@ -2556,6 +2573,8 @@ void cmd_init(int terminal)
 
 		thread_cmd_init();
 		workqueue_cmd_init();
+		job_pool_cmd_init();
+		frr_pthread_cmd_init();
 		hash_cmd_init();
 	}
 
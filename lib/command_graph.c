@@ -31,6 +31,37 @@ DEFINE_MTYPE_STATIC(LIB, CMD_DESC, "Command Token Text");
 DEFINE_MTYPE_STATIC(LIB, CMD_TEXT, "Command Token Help");
 DEFINE_MTYPE(LIB, CMD_ARG, "Command Argument");
 DEFINE_MTYPE_STATIC(LIB, CMD_VAR, "Command Argument Name");
+DEFINE_MTYPE_STATIC(LIB, CMD_NEXTHOPS, "Command Token Nexthops");
+
+unsigned long cmd_graph_gen;
+
+struct cmd_nexthops *cmd_nexthops_new(unsigned int count)
+{
+	struct cmd_nexthops *nexthops;
+	size_t alloc = MAX(count, 1U);
+
+	nexthops = XCALLOC(MTYPE_CMD_NEXTHOPS, sizeof(*nexthops));
+	nexthops->gen = cmd_graph_gen;
+	nexthops->nodes = XCALLOC(MTYPE_CMD_NEXTHOPS,
+				  alloc * sizeof(*nexthops->nodes));
+	nexthops->words = XCALLOC(MTYPE_CMD_NEXTHOPS,
+				  alloc * sizeof(*nexthops->words));
+	nexthops->other = XCALLOC(MTYPE_CMD_NEXTHOPS,
+				  alloc * sizeof(*nexthops->other));
+
+	return nexthops;
+}
+
+void cmd_nexthops_free(struct cmd_nexthops *nexthops)
+{
+	if (!nexthops)
+		return;
+
+	XFREE(MTYPE_CMD_NEXTHOPS, nexthops->nodes);
+	XFREE(MTYPE_CMD_NEXTHOPS, nexthops->words);
+	XFREE(MTYPE_CMD_NEXTHOPS, nexthops->other);
+	XFREE(MTYPE_CMD_NEXTHOPS, nexthops);
+}
 
 struct cmd_token *cmd_token_new(enum cmd_token_type type, uint8_t attr,
 				const char *text, const char *desc)
@@ -54,6 +85,7 @@ void cmd_token_del(struct cmd_token *token)
 	if (!token)
 		return;
 
+	cmd_nexthops_free(token->nexthops);
 	XFREE(MTYPE_CMD_TEXT, token->text);
 	XFREE(MTYPE_CMD_DESC, token->desc);
 	XFREE(MTYPE_CMD_ARG, token->arg);
@@ -350,6 +382,8 @@ static void cmd_merge_nodes(struct graph *oldgraph, struct graph *newgraph,
 
 void cmd_graph_merge(struct graph *old, struct graph *new, int direction)
 {
+	cmd_graph_gen++;
+
 	assert(vector_active(old->nodes) >= 1);
 	assert(vector_active(new->nodes) >= 1);
 
@@ -92,8 +92,41 @@ struct cmd_token {
 	char *varname;
 
 	struct graph_node *forkjoin; // paired FORK/JOIN for JOIN/FORK
+
+	struct cmd_nexthops *nexthops; // matcher cache, not copied
+};
+
+/*
+ * Nexthops of a graph node, as collected by the matcher, with the WORD_TKN
+ * ones sorted by text so that the ones an input token can match are found
+ * by binary search. Built on first use and thrown away once the graph
+ * changes (cmd_graph_gen).
+ */
+struct cmd_nexthop_word {
+	const char *text;
+	unsigned int idx;
+};
+
+struct cmd_nexthops {
+	unsigned long gen;
+
+	unsigned int count;
+	struct graph_node **nodes;
+
+	unsigned int nwords;
+	struct cmd_nexthop_word *words;
+
+	/* indices of everything that isn't a word */
+	unsigned int nother;
+	unsigned int *other;
 };
 
+/* Bumped whenever a command graph is modified. */
+extern unsigned long cmd_graph_gen;
+
+extern struct cmd_nexthops *cmd_nexthops_new(unsigned int count);
+extern void cmd_nexthops_free(struct cmd_nexthops *nexthops);
+
 /* Structure of command element. */
 struct cmd_element {
 	const char *string; /* Command specification by string. */
@@ -134,6 +134,127 @@ enum matcher_rv command_match(struct graph *cmdgraph, vector vline,
 	return status;
 }
 
+static int cmd_nexthop_word_cmp(const void *a, const void *b)
+{
+	const struct cmd_nexthop_word *wa = a, *wb = b;
+	int ret = strcmp(wa->text, wb->text);
+
+	if (ret)
+		return ret;
+	return (wa->idx > wb->idx) - (wa->idx < wb->idx);
+}
+
+static int cmd_nexthop_idx_cmp(const void *a, const void *b)
+{
+	unsigned int ia = *(const unsigned int *)a;
+	unsigned int ib = *(const unsigned int *)b;
+
+	return (ia > ib) - (ia < ib);
+}
+
+/* Gets the (cached) nexthops of a node. */
+static struct cmd_nexthops *cmd_nexthops_get(struct graph_node *gn)
+{
+	struct cmd_token *token = gn->data;
+	struct cmd_nexthops *nexthops = token->nexthops;
+	struct list *next;
+	struct listnode *ln;
+	struct graph_node *child;
+	struct cmd_token *tok;
+	unsigned int i = 0;
+
+	if (nexthops && nexthops->gen == cmd_graph_gen)
+		return nexthops;
+
+	cmd_nexthops_free(nexthops);
+
+	next = list_new();
+	add_nexthops(next, gn, NULL, 0);
+
+	nexthops = cmd_nexthops_new(listcount(next));
+	nexthops->count = listcount(next);
+	for (ALL_LIST_ELEMENTS_RO(next, ln, child)) {
+		tok = child->data;
+		nexthops->nodes[i] = child;
+		if (tok->type == WORD_TKN) {
+			nexthops->words[nexthops->nwords].text = tok->text;
+			nexthops->words[nexthops->nwords].idx = i;
+			nexthops->nwords++;
+		} else
+			nexthops->other[nexthops->nother++] = i;
+		i++;
+	}
+	qsort(nexthops->words, nexthops->nwords, sizeof(*nexthops->words),
+	      cmd_nexthop_word_cmp);
+
+	list_delete(&next);
+
+	token->nexthops = nexthops;
+	return nexthops;
+}
+
+/*
+ * Picks the nexthops that can match the next input token, in their
+ * original order. At the end of the line only END_TKN can match, otherwise
+ * words have to start with the input; anything else has to be tried.
+ *
+ * @param[in] nexthops nexthops of the current node
+ * @param[in] last whether the input is exhausted
+ * @param[in] input next input token, NULL if unknown
+ * @param[out] next room for nexthops->count nodes
+ * @return number of nodes put in next
+ */
+static unsigned int cmd_nexthops_select(const struct cmd_nexthops *nexthops,
+					bool last, const char *input,
+					struct graph_node **next)
+{
+	unsigned int idxbuf[32], *idx = idxbuf;
+	unsigned int i, lo, hi, count = 0;
+	size_t len;
+
+	if (!last && !input) {
+		memcpy(next, nexthops->nodes,
+		       nexthops->count * sizeof(*next));
+		return nexthops->count;
+	}
+
+	if (nexthops->count > array_size(idxbuf))
+		idx = XMALLOC(MTYPE_CMD_MATCHSTACK,
+			      nexthops->count * sizeof(*idx));
+
+	if (!last) {
+		/* find the first word >= input, then take all it prefixes */
+		lo = 0;
+		hi = nexthops->nwords;
+		while (lo < hi) {
+			unsigned int mid = lo + (hi - lo) / 2;
+
+			if (strcmp(nexthops->words[mid].text, input) < 0)
+				lo = mid + 1;
+			else
+				hi = mid;
+		}
+
+		len = strlen(input);
+		for (i = lo; i < nexthops->nwords
+			     && !strncmp(nexthops->words[i].text, input, len);
+		     i++)
+			idx[count++] = nexthops->words[i].idx;
+	}
+
+	for (i = 0; i < nexthops->nother; i++)
+		idx[count++] = nexthops->other[i];
+
+	qsort(idx, count, sizeof(*idx), cmd_nexthop_idx_cmp);
+	for (i = 0; i < count; i++)
+		next[i] = nexthops->nodes[idx[i]];
+
+	if (idx != idxbuf)
+		XFREE(MTYPE_CMD_MATCHSTACK, idx);
+
+	return count;
+}
+
 /**
  * Builds an argument list given a DFA and a matching input line.
  *
@@ -242,16 +363,26 @@ static enum matcher_rv command_match_r(struct graph_node *start, vector vline,
 
 	stack[n] = start;
 
-	// pointers for iterating linklist
-	struct listnode *ln;
 	struct graph_node *gn;
-
-	// get all possible nexthops
-	struct list *next = list_new();
-	add_nexthops(next, start, NULL, 0);
+	struct graph_node *nextbuf[32], **next = nextbuf;
+	struct cmd_nexthops *nexthops = cmd_nexthops_get(start);
+	unsigned int i, count;
+
+	// get the possible nexthops, leaving out words that can't match
+	if (nexthops->count > array_size(nextbuf))
+		next = XMALLOC(MTYPE_CMD_MATCHSTACK,
+			       nexthops->count * sizeof(*next));
+	count = cmd_nexthops_select(nexthops,
+				    n + 1 == vector_active(vline),
+				    n + 1 < vector_active(vline)
+					    ? vector_slot(vline, n + 1)
+					    : NULL,
+				    next);
 
 	// determine the best match
-	for (ALL_LIST_ELEMENTS_RO(next, ln, gn)) {
+	for (i = 0; i < count; i++) {
+		gn = next[i];
+
 		// if we've matched all input we're looking for END_TKN
 		if (n + 1 == vector_active(vline)) {
 			struct cmd_token *tok = gn->data;
@@ -334,7 +465,8 @@ static enum matcher_rv command_match_r(struct graph_node *start, vector vline,
 		status = MATCHER_INCOMPLETE;
 
 	// cleanup
-	list_delete(&next);
+	if (next != nextbuf)
+		XFREE(MTYPE_CMD_MATCHSTACK, next);
 
 	return status;
 }
@@ -0,0 +1,369 @@
+/*
+ * Per-prefix convergence timing
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "zebra.h"
+
+#include "convergence.h"
+#include "frr_pthread.h"
+#include "json.h"
+#include "memory.h"
+#include "vty.h"
+#include "libfrr_trace.h"
+
+DEFINE_MTYPE_STATIC(LIB, CONV_SAMPLER, "Convergence sampler");
+DEFINE_MTYPE_STATIC(LIB, CONV_SAMPLE, "Convergence sample");
+
+/* upper bound on the samples in flight, and how long one may take */
+#define CONV_PENDING_MAX 4096
+#define CONV_EXPIRE_USEC (60 * 1000000LL)
+
+struct conv_sample {
+	struct conv_pending_item item;
+
+	vrf_id_t vrf_id;
+	struct prefix p;
+
+	int64_t start, last;
+	unsigned int stage;
+};
+
+static int conv_sample_cmp(const struct conv_sample *a,
+			   const struct conv_sample *b)
+{
+	if (a->vrf_id != b->vrf_id)
+		return a->vrf_id < b->vrf_id ? -1 : 1;
+	return prefix_cmp(&a->p, &b->p);
+}
+
+static uint32_t conv_sample_hash(const struct conv_sample *a)
+{
+	return prefix_hash_key(&a->p) ^ a->vrf_id;
+}
+
+DECLARE_HASH(conv_pending, struct conv_sample, item, conv_sample_cmp,
+	     conv_sample_hash);
+
+/* same log-linear buckets as the thread latency histograms */
+static unsigned int conv_hist_bucket(uint64_t usec)
+{
+	unsigned int msb, shift;
+
+	if (usec > UINT32_MAX)
+		usec = UINT32_MAX;
+	if (usec < (1U << CONV_HIST_SUBBITS))
+		return usec;
+
+	msb = 63 - __builtin_clzll(usec);
+	shift = msb - CONV_HIST_SUBBITS;
+	return ((shift + 1) << CONV_HIST_SUBBITS)
+	       + ((usec >> shift) & ((1U << CONV_HIST_SUBBITS) - 1));
+}
+
+/* highest value that goes into a bucket */
+static uint64_t conv_hist_value(unsigned int bucket)
+{
+	unsigned int step = 1U << CONV_HIST_SUBBITS;
+	unsigned int shift;
+
+	if (bucket < step)
+		return bucket;
+
+	shift = bucket / step - 1;
+	return ((uint64_t)(step + bucket % step + 1) << shift) - 1;
+}
+
+static uint64_t conv_hist_percentile(const uint32_t *hist, uint64_t total,
+				     unsigned int permille)
+{
+	uint64_t want = (total * permille + 999) / 1000, seen = 0;
+	unsigned int i;
+
+	for (i = 0; i < CONV_HIST_BUCKETS; i++) {
+		seen += hist[i];
+		if (seen >= want && seen)
+			return conv_hist_value(i);
+	}
+	return 0;
+}
+
+struct conv_sampler *conv_sampler_new(const char *name,
+				      const char *const *stages,
+				      unsigned int nstages)
+{
+	struct conv_sampler *cs;
+
+	assert(nstages >= 2 && nstages <= CONV_STAGES_MAX);
+
+	cs = XCALLOC(MTYPE_CONV_SAMPLER, sizeof(*cs));
+	cs->name = name;
+	cs->stages = stages;
+	cs->nstages = nstages;
+	pthread_mutex_init(&cs->mtx, NULL);
+	conv_pending_init(&cs->pending);
+	return cs;
+}
+
+static void conv_clear(struct conv_sampler *cs)
+{
+	struct conv_sample *sample;
+
+	while ((sample = conv_pending_pop(&cs->pending)))
+		XFREE(MTYPE_CONV_SAMPLE, sample);
+
+	cs->started = cs->dropped = cs->expired = 0;
+	memset(cs->hist_total, 0, sizeof(cs->hist_total));
+	memset(cs->hist_step, 0, sizeof(cs->hist_step));
+}
+
+void conv_sampler_free(struct conv_sampler **csp)
+{
+	struct conv_sampler *cs = *csp;
+
+	if (!cs)
+		return;
+
+	conv_clear(cs);
+	conv_pending_fini(&cs->pending);
+	pthread_mutex_destroy(&cs->mtx);
+	XFREE(MTYPE_CONV_SAMPLER, *csp);
+}
+
+void conv_set_rate(struct conv_sampler *cs, uint32_t rate)
+{
+	frr_with_mutex(&cs->mtx) {
+		if (atomic_load_explicit(&cs->rate, memory_order_relaxed)
+		    == rate)
+			break;
+
+		atomic_store_explicit(&cs->rate, rate, memory_order_relaxed);
+		conv_clear(cs);
+	}
+}
+
+/* drop the samples that will never see their last stage */
+static void conv_expire(struct conv_sampler *cs, int64_t now)
+{
+	struct conv_sample *sample;
+
+	frr_each_safe (conv_pending, &cs->pending, sample) {
+		if (now - sample->start < CONV_EXPIRE_USEC)
+			continue;
+
+		conv_pending_del(&cs->pending, sample);
+		XFREE(MTYPE_CONV_SAMPLE, sample);
+		cs->expired++;
+	}
+}
+
+void _conv_start(struct conv_sampler *cs, vrf_id_t vrf_id,
+		 const struct prefix *p, int64_t start)
+{
+	struct conv_sample ref, *sample;
+	int64_t now = conv_now();
+
+	if (!start || start > now)
+		start = now;
+
+	ref.vrf_id = vrf_id;
+	prefix_copy(&ref.p, p);
+
+	frr_with_mutex(&cs->mtx) {
+		sample = conv_pending_find(&cs->pending, &ref);
+		if (!sample) {
+			if (conv_pending_count(&cs->pending)
+			    >= CONV_PENDING_MAX)
+				conv_expire(cs, now);
+			if (conv_pending_count(&cs->pending)
+			    >= CONV_PENDING_MAX) {
+				cs->dropped++;
+				break;
+			}
+
+			sample = XCALLOC(MTYPE_CONV_SAMPLE, sizeof(*sample));
+			sample->vrf_id = vrf_id;
+			prefix_copy(&sample->p, p);
+			conv_pending_add(&cs->pending, sample);
+		}
+
+		sample->start = sample->last = start;
+		sample->stage = 0;
+		cs->started++;
+	}
+
+	frrtrace(6, frr_libfrr, conv_stage, cs->name, cs->stages[0], vrf_id, p,
+		 now - start, now - start);
+}
+
+void _conv_stage(struct conv_sampler *cs, vrf_id_t vrf_id,
+		 const struct prefix *p, unsigned int stage)
+{
+	struct conv_sample ref, *sample;
+	int64_t now = conv_now(), total = 0, step = 0;
+	bool found = false;
+
+	assert(stage > 0 && stage < cs->nstages);
+
+	ref.vrf_id = vrf_id;
+	prefix_copy(&ref.p, p);
+
+	frr_with_mutex(&cs->mtx) {
+		sample = conv_pending_find(&cs->pending, &ref);
+		if (!sample || stage <= sample->stage)
+			break;
+
+		total = now - sample->start;
+		step = now - sample->last;
+		cs->hist_total[stage][conv_hist_bucket(total)]++;
+		cs->hist_step[stage][conv_hist_bucket(step)]++;
+		found = true;
+
+		if (stage == cs->nstages - 1) {
+			conv_pending_del(&cs->pending, sample);
+			XFREE(MTYPE_CONV_SAMPLE, sample);
+			break;
+		}
+
+		sample->stage = stage;
+		sample->last = now;
+	}
+
+	if (found)
+		frrtrace(6, frr_libfrr, conv_stage, cs->name, cs->stages[stage],
+			 vrf_id, p, total, step);
+}
+
+static void conv_show_json(struct vty *vty, struct conv_sampler *cs,
+			   uint32_t rate)
+{
+	static const unsigned int permille[] = {500, 900, 990, 999};
+	static const char *const pname[] = {"p50", "p90", "p99", "p999"};
+	uint32_t total[CONV_HIST_BUCKETS], step[CONV_HIST_BUCKETS];
+	json_object *json, *jstages, *jstage, *jtotal, *jstep;
+	uint64_t count;
+	unsigned int i, j;
+
+	json = json_object_new_object();
+	json_object_int_add(json, "rate", rate);
+	json_object_string_add(json, "start", cs->stages[0]);
+	jstages = json_object_new_array();
+	json_object_object_add(json, "stages", jstages);
+
+	for (i = 1; i < cs->nstages; i++) {
+		frr_with_mutex(&cs->mtx) {
+			memcpy(total, cs->hist_total[i], sizeof(total));
+			memcpy(step, cs->hist_step[i], sizeof(step));
+		}
+
+		count = 0;
+		for (j = 0; j < CONV_HIST_BUCKETS; j++)
+			count += total[j];
+
+		jstage = json_object_new_object();
+		json_object_array_add(jstages, jstage);
+		json_object_string_add(jstage, "stage", cs->stages[i]);
+		json_object_int_add(jstage, "count", count);
+		jtotal = json_object_new_object();
+		json_object_object_add(jstage, "totalUsec", jtotal);
+		jstep = json_object_new_object();
+		json_object_object_add(jstage, "stepUsec", jstep);
+		for (j = 0; j < array_size(permille); j++) {
+			json_object_int_add(jtotal, pname[j],
+					    conv_hist_percentile(total, count,
+								 permille[j]));
+			json_object_int_add(jstep, pname[j],
+					    conv_hist_percentile(step, count,
+								 permille[j]));
+		}
+	}
+
+	frr_with_mutex(&cs->mtx) {
+		json_object_int_add(json, "started", cs->started);
+		json_object_int_add(json, "inFlight",
+				    conv_pending_count(&cs->pending));
+		json_object_int_add(json, "expired", cs->expired);
+		json_object_int_add(json, "dropped", cs->dropped);
+	}
+
+	vty_out(vty, "%s\n",
+		json_object_to_json_string_ext(json, JSON_C_TO_STRING_PRETTY));
+	json_object_free(json);
+}
+
+void conv_show(struct vty *vty, struct conv_sampler *cs, bool uj)
+{
+	static const unsigned int permille[] = {500, 900, 990, 999};
+	uint32_t total[CONV_HIST_BUCKETS], step[CONV_HIST_BUCKETS];
+	uint64_t started, dropped, expired, count;
+	size_t pending;
+	uint32_t rate;
+	unsigned int i, j;
+
+	rate = conv_get_rate(cs);
+	if (uj) {
+		conv_show_json(vty, cs, rate);
+		return;
+	}
+	if (!rate) {
+		vty_out(vty, "Convergence sampling is off\n");
+		return;
+	}
+
+	vty_out(vty, "Sampling 1 in %u prefixes, times in microseconds since \"%s\"\n",
+		rate, cs->stages[0]);
+	vty_out(vty, "%-16s %9s %8s %8s %8s %8s  %8s %8s %8s %8s\n", "",
+		"", "Total:", "", "", "", "Step:", "", "", "");
+	vty_out(vty, "%-16s %9s %8s %8s %8s %8s  %8s %8s %8s %8s\n", "Stage",
+		"Count", "p50", "p90", "p99", "p99.9", "p50", "p90", "p99",
+		"p99.9");
+
+	for (i = 1; i < cs->nstages; i++) {
+		frr_with_mutex(&cs->mtx) {
+			memcpy(total, cs->hist_total[i], sizeof(total));
+			memcpy(step, cs->hist_step[i], sizeof(step));
+		}
+
+		count = 0;
+		for (j = 0; j < CONV_HIST_BUCKETS; j++)
+			count += total[j];
+
+		vty_out(vty, "%-16s %9" PRIu64, cs->stages[i], count);
+		for (j = 0; j < array_size(permille); j++)
+			vty_out(vty, " %8" PRIu64,
+				conv_hist_percentile(total, count,
+						     permille[j]));
+		vty_out(vty, " ");
+		for (j = 0; j < array_size(permille); j++)
+			vty_out(vty, " %8" PRIu64,
+				conv_hist_percentile(step, count,
+						     permille[j]));
+		vty_out(vty, "\n");
+	}
+
+	frr_with_mutex(&cs->mtx) {
+		started = cs->started;
+		dropped = cs->dropped;
+		expired = cs->expired;
+		pending = conv_pending_count(&cs->pending);
+	}
+
+	vty_out(vty,
+		"\nSamples: %" PRIu64 " started, %zu in flight, %" PRIu64
+		" expired, %" PRIu64 " dropped\n",
+		started, pending, expired, dropped);
+}
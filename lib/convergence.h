@@ -0,0 +1,136 @@
+/*
+ * Per-prefix convergence timing
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _FRR_CONVERGENCE_H
+#define _FRR_CONVERGENCE_H
+
+#include <pthread.h>
+
+#include "frratomic.h"
+#include "monotime.h"
+#include "prefix.h"
+#include "typesafe.h"
+#include "vrf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct vty;
+
+/*
+ * Follows a sample of the prefix updates through the stages of a daemon
+ * and keeps a histogram of the time from the first stage to each of the
+ * others, and from the stage before.  Which prefixes are sampled only
+ * depends on the prefix, so with the same rate bgpd and zebra look at the
+ * same ones.
+ *
+ * A sample is started with conv_start() and ends when it reaches the last
+ * stage; conv_stage() for a prefix that is not in flight, or for a stage
+ * that is not after the last one seen, does nothing.  Each stage is also a
+ * frr_libfrr:conv_stage tracepoint.
+ *
+ * conv_sampled() is all that is done for a prefix that is not sampled, so
+ * this can be left in the code paths; a rate of 0 turns it off entirely.
+ */
+
+#define CONV_STAGES_MAX 12
+
+#define CONV_HIST_SUBBITS 2
+#define CONV_HIST_BUCKETS ((32 - CONV_HIST_SUBBITS + 1) << CONV_HIST_SUBBITS)
+
+PREDECL_HASH(conv_pending);
+
+struct conv_sampler {
+	const char *name;
+	const char *const *stages;
+	unsigned int nstages;
+
+	/* 1 in rate prefixes is sampled, 0 is off */
+	_Atomic uint32_t rate;
+
+	/* everything below is protected by mtx */
+	pthread_mutex_t mtx;
+	struct conv_pending_head pending;
+
+	uint64_t started, dropped, expired;
+	uint32_t hist_total[CONV_STAGES_MAX][CONV_HIST_BUCKETS];
+	uint32_t hist_step[CONV_STAGES_MAX][CONV_HIST_BUCKETS];
+};
+
+extern struct conv_sampler *conv_sampler_new(const char *name,
+					     const char *const *stages,
+					     unsigned int nstages);
+extern void conv_sampler_free(struct conv_sampler **csp);
+
+/* changing the rate also clears what has been collected */
+extern void conv_set_rate(struct conv_sampler *cs, uint32_t rate);
+
+static inline uint32_t conv_get_rate(const struct conv_sampler *cs)
+{
+	if (!cs)
+		return 0;
+	return atomic_load_explicit(&cs->rate, memory_order_relaxed);
+}
+
+static inline bool conv_sampled(const struct conv_sampler *cs,
+				const struct prefix *p)
+{
+	uint32_t rate = conv_get_rate(cs);
+
+	if (!rate)
+		return false;
+	return rate == 1 || prefix_hash_key(p) % rate == 0;
+}
+
+static inline int64_t conv_now(void)
+{
+	struct timeval tv;
+
+	monotime(&tv);
+	return (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+extern void _conv_start(struct conv_sampler *cs, vrf_id_t vrf_id,
+			const struct prefix *p, int64_t start);
+extern void _conv_stage(struct conv_sampler *cs, vrf_id_t vrf_id,
+			const struct prefix *p, unsigned int stage);
+
+/* start is a conv_now() value, 0 for now; a sample in flight is restarted */
+static inline void conv_start(struct conv_sampler *cs, vrf_id_t vrf_id,
+			      const struct prefix *p, int64_t start)
+{
+	if (conv_sampled(cs, p))
+		_conv_start(cs, vrf_id, p, start);
+}
+
+static inline void conv_stage(struct conv_sampler *cs, vrf_id_t vrf_id,
+			      const struct prefix *p, unsigned int stage)
+{
+	if (conv_sampled(cs, p))
+		_conv_stage(cs, vrf_id, p, stage);
+}
+
+extern void conv_show(struct vty *vty, struct conv_sampler *cs, bool uj);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FRR_CONVERGENCE_H */
@@ -1647,7 +1647,8 @@ const struct frr_yang_module_info frr_filter_info = {
 			.cbs = {
 				.create = lib_access_list_create,
 				.destroy = lib_access_list_destroy,
-			}
+			},
+			.concurrent = true,
 		},
 		{
 			.xpath = "/frr-filter:lib/access-list/remark",
@@ -1771,7 +1772,8 @@ const struct frr_yang_module_info frr_filter_info = {
 			.cbs = {
 				.create = lib_prefix_list_create,
 				.destroy = lib_prefix_list_destroy,
-			}
+			},
+			.concurrent = true,
 		},
 		{
 			.xpath = "/frr-filter:lib/prefix-list/remark",
@@ -23,7 +23,9 @@
 #include <pthread_np.h>
 #endif
 #include <sched.h>
+#include <dirent.h>
 
+#include "command.h"
 #include "frr_pthread.h"
 #include "memory.h"
 #include "linklist.h"
@@ -33,6 +35,7 @@
 
 DEFINE_MTYPE_STATIC(LIB, FRR_PTHREAD, "FRR POSIX Thread");
 DEFINE_MTYPE_STATIC(LIB, PTHREAD_PRIM, "POSIX sync primitives");
+DEFINE_MTYPE_STATIC(LIB, PTHREAD_AFFINITY, "POSIX thread CPU affinity");
 
 /* default frr_pthread start/stop routine prototypes */
 static void *fpt_run(void *arg);
@@ -51,6 +54,10 @@ const struct frr_pthread_attr frr_pthread_attr_default = {
 static pthread_mutex_t frr_pthread_list_mtx = PTHREAD_MUTEX_INITIALIZER;
 static struct list *frr_pthread_list;
 
+static pthread_t frr_pthread_main;
+
+static void frr_pthread_affinity_apply(pthread_t thread, const char *os_name);
+
 /* ------------------------------------------------------------------------ */
 
 void frr_pthread_init(void)
@@ -58,6 +65,7 @@ void frr_pthread_init(void)
 	frr_with_mutex(&frr_pthread_list_mtx) {
 		frr_pthread_list = list_new();
 	}
+	frr_pthread_main = pthread_self();
 }
 
 void frr_pthread_finish(void)
@@ -155,6 +163,7 @@ static void *frr_pthread_inner(void *arg)
 	struct frr_pthread *fpt = arg;
 
 	rcu_thread_start(fpt->rcu_thread);
+	frr_pthread_affinity_apply(pthread_self(), fpt->os_name);
 	return fpt->attr.start(fpt);
 }
 
@@ -319,3 +328,331 @@ static void *fpt_run(void *arg)
 
 	return NULL;
 }
+
+/*
+ * ----------------------------------------------------------------------------
+ * CPU affinity
+ * ----------------------------------------------------------------------------
+ */
+
+/*
+ * Configured with "service thread-affinity", by OS thread name ("main" for
+ * the main pthread, a trailing '*' matching any name with that prefix).
+ * Pthreads without an entry of their own follow "main", so that pinning it
+ * keeps the whole pipeline of a daemon on the same CPUs.
+ */
+struct fpt_affinity {
+	char name[OS_THREAD_NAMELEN];
+	/* as configured: a CPU list or "local" */
+	char *cpus;
+#ifdef GNU_LINUX
+	cpu_set_t set;
+#endif
+};
+
+static pthread_mutex_t affinity_mtx = PTHREAD_MUTEX_INITIALIZER;
+static struct list *affinity_list;
+
+static bool affinity_name_match(const char *pattern, const char *os_name)
+{
+	size_t len = strlen(pattern);
+
+	if (len && pattern[len - 1] == '*')
+		return !strncmp(pattern, os_name, len - 1);
+	return !strcmp(pattern, os_name);
+}
+
+/* Requires: affinity_mtx */
+static struct fpt_affinity *affinity_find(const char *os_name, bool exact)
+{
+	struct fpt_affinity *aff, *main_aff = NULL;
+	struct listnode *n;
+
+	for (ALL_LIST_ELEMENTS_RO(affinity_list, n, aff)) {
+		if (exact ? !strcmp(aff->name, os_name)
+			  : affinity_name_match(aff->name, os_name))
+			return aff;
+		if (!strcmp(aff->name, "main"))
+			main_aff = aff;
+	}
+	return exact ? NULL : main_aff;
+}
+
+#ifdef GNU_LINUX
+/* "0-3,8,10-11", as in the kernel's cpulist files */
+static bool cpulist_parse(const char *str, cpu_set_t *set)
+{
+	unsigned long first, last, cpu;
+	char *end;
+
+	CPU_ZERO(set);
+	while (*str) {
+		if (!isdigit((unsigned char)*str))
+			return false;
+		first = last = strtoul(str, &end, 10);
+		if (*end == '-') {
+			if (!isdigit((unsigned char)end[1]))
+				return false;
+			last = strtoul(end + 1, &end, 10);
+		}
+		if (last < first || last >= CPU_SETSIZE)
+			return false;
+		for (cpu = first; cpu <= last; cpu++)
+			CPU_SET(cpu, set);
+
+		if (*end == ',')
+			end++;
+		else if (*end && !isspace((unsigned char)*end))
+			return false;
+		str = end;
+		while (isspace((unsigned char)*str))
+			str++;
+	}
+	return CPU_COUNT(set) > 0;
+}
+
+static void cpulist_print(char *buf, size_t size, const cpu_set_t *set)
+{
+	int cpu, last;
+	size_t pos = 0;
+
+	buf[0] = '\0';
+	for (cpu = 0; cpu < CPU_SETSIZE && pos < size; cpu++) {
+		if (!CPU_ISSET(cpu, set))
+			continue;
+		for (last = cpu; last + 1 < CPU_SETSIZE
+				 && CPU_ISSET(last + 1, set);
+		     last++)
+			;
+		if (last == cpu)
+			pos += snprintf(buf + pos, size - pos, "%s%d",
+					pos ? "," : "", cpu);
+		else
+			pos += snprintf(buf + pos, size - pos, "%s%d-%d",
+					pos ? "," : "", cpu, last);
+		cpu = last;
+	}
+}
+
+/* the CPUs of the NUMA node the calling pthread is running on */
+static bool cpulist_local(cpu_set_t *set)
+{
+	char path[128], line[1024];
+	struct dirent *de;
+	bool ret = false;
+	FILE *fp = NULL;
+	int cpu, node;
+	DIR *dir;
+
+	cpu = sched_getcpu();
+	if (cpu < 0)
+		return false;
+
+	snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d", cpu);
+	dir = opendir(path);
+	if (!dir)
+		return false;
+	while ((de = readdir(dir))) {
+		if (sscanf(de->d_name, "node%d", &node) != 1)
+			continue;
+		snprintf(path, sizeof(path),
+			 "/sys/devices/system/node/node%d/cpulist", node);
+		fp = fopen(path, "r");
+		break;
+	}
+	closedir(dir);
+
+	if (!fp) {
+		/* no NUMA: all of them are local */
+		return sched_getaffinity(0, sizeof(*set), set) == 0;
+	}
+	if (fgets(line, sizeof(line), fp))
+		ret = cpulist_parse(line, set);
+	fclose(fp);
+	return ret;
+}
+#endif /* GNU_LINUX */
+
+static void frr_pthread_affinity_apply(pthread_t thread, const char *os_name)
+{
+#ifdef GNU_LINUX
+	struct fpt_affinity *aff;
+	int ret;
+
+	frr_with_mutex(&affinity_mtx) {
+		if (!affinity_list)
+			break;
+		aff = affinity_find(os_name, false);
+		if (!aff)
+			break;
+
+		ret = pthread_setaffinity_np(thread, sizeof(aff->set),
+					     &aff->set);
+		if (ret)
+			zlog_warn("cannot set CPU affinity of %s to %s: %s",
+				  os_name, aff->cpus, safe_strerror(ret));
+	}
+#endif
+}
+
+/* (re)apply to the running pthreads */
+static void frr_pthread_affinity_apply_all(void)
+{
+	struct frr_pthread *fpt;
+	struct listnode *n;
+
+	frr_pthread_affinity_apply(frr_pthread_main, "main");
+
+	frr_with_mutex(&frr_pthread_list_mtx) {
+		for (ALL_LIST_ELEMENTS_RO(frr_pthread_list, n, fpt))
+			if (atomic_load_explicit(&fpt->running,
+						 memory_order_relaxed))
+				frr_pthread_affinity_apply(fpt->thread,
+							   fpt->os_name);
+	}
+}
+
+DEFUN (service_thread_affinity,
+       service_thread_affinity_cmd,
+       "service thread-affinity NAME <local|CPULIST>",
+       "Set up miscellaneous service\n"
+       "Pin pthreads to a set of CPUs\n"
+       "OS name of the pthread, \"main\" for the main one, may end in '*'\n"
+       "The CPUs of the NUMA node the main pthread is running on\n"
+       "List of CPUs, e.g. 0-3,8\n")
+{
+#ifdef GNU_LINUX
+	const char *name = argv[2]->arg, *cpus = argv[3]->arg;
+	struct fpt_affinity *aff;
+	cpu_set_t set;
+
+	if (strlen(name) >= OS_THREAD_NAMELEN) {
+		vty_out(vty, "%% Pthread names are at most %d characters\n",
+			OS_THREAD_NAMELEN - 1);
+		return CMD_WARNING_CONFIG_FAILED;
+	}
+	if (strmatch(cpus, "local") ? !cpulist_local(&set)
+				    : !cpulist_parse(cpus, &set)) {
+		vty_out(vty, "%% Invalid or unavailable CPU list %s\n", cpus);
+		return CMD_WARNING_CONFIG_FAILED;
+	}
+
+	frr_with_mutex(&affinity_mtx) {
+		if (!affinity_list)
+			affinity_list = list_new();
+
+		aff = affinity_find(name, true);
+		if (!aff) {
+			aff = XCALLOC(MTYPE_PTHREAD_AFFINITY, sizeof(*aff));
+			strlcpy(aff->name, name, sizeof(aff->name));
+			listnode_add(affinity_list, aff);
+		}
+		XFREE(MTYPE_PTHREAD_AFFINITY, aff->cpus);
+		aff->cpus = XSTRDUP(MTYPE_PTHREAD_AFFINITY, cpus);
+		aff->set = set;
+	}
+
+	frr_pthread_affinity_apply_all();
+	return CMD_SUCCESS;
+#else
+	vty_out(vty, "%% CPU affinity is not supported on this platform\n");
+	return CMD_WARNING_CONFIG_FAILED;
+#endif
+}
+
+DEFUN (no_service_thread_affinity,
+       no_service_thread_affinity_cmd,
+       "no service thread-affinity NAME [<local|CPULIST>]",
+       NO_STR
+       "Set up miscellaneous service\n"
+       "Pin pthreads to a set of CPUs\n"
+       "OS name of the pthread, \"main\" for the main one, may end in '*'\n"
+       "The CPUs of the NUMA node the main pthread is running on\n"
+       "List of CPUs, e.g. 0-3,8\n")
+{
+	struct fpt_affinity *aff = NULL;
+
+	frr_with_mutex(&affinity_mtx) {
+		if (affinity_list)
+			aff = affinity_find(argv[3]->arg, true);
+		if (aff) {
+			listnode_delete(affinity_list, aff);
+			XFREE(MTYPE_PTHREAD_AFFINITY, aff->cpus);
+			XFREE(MTYPE_PTHREAD_AFFINITY, aff);
+		}
+	}
+
+	/* the pthreads keep where they are until restarted or repinned */
+	return CMD_SUCCESS;
+}
+
+static void show_affinity_line(struct vty *vty, pthread_t thread,
+			       const char *os_name)
+{
+	char configured[64] = "-", allowed[256] = "?";
+	struct fpt_affinity *aff;
+#ifdef GNU_LINUX
+	cpu_set_t set;
+
+	if (!pthread_getaffinity_np(thread, sizeof(set), &set))
+		cpulist_print(allowed, sizeof(allowed), &set);
+#endif
+
+	frr_with_mutex(&affinity_mtx) {
+		aff = affinity_list ? affinity_find(os_name, false) : NULL;
+		if (aff)
+			snprintf(configured, sizeof(configured), "%s%s",
+				 aff->cpus,
+				 affinity_name_match(aff->name, os_name)
+					 ? ""
+					 : " (main)");
+	}
+
+	vty_out(vty, "%-16s %-24s %s\n", os_name, configured, allowed);
+}
+
+DEFUN_NOSH (show_thread_affinity,
+	    show_thread_affinity_cmd,
+	    "show thread affinity",
+	    SHOW_STR
+	    "Thread information\n"
+	    "CPU placement of the pthreads\n")
+{
+	struct frr_pthread *fpt;
+	struct listnode *n;
+
+	vty_out(vty, "%-16s %-24s %s\n", "Pthread", "Configured",
+		"Allowed CPUs");
+	show_affinity_line(vty, frr_pthread_main, "main");
+
+	frr_with_mutex(&frr_pthread_list_mtx) {
+		for (ALL_LIST_ELEMENTS_RO(frr_pthread_list, n, fpt))
+			if (atomic_load_explicit(&fpt->running,
+						 memory_order_relaxed))
+				show_affinity_line(vty, fpt->thread,
+						   fpt->os_name);
+	}
+
+	return CMD_SUCCESS;
+}
+
+void frr_pthread_config_write(struct vty *vty)
+{
+	struct fpt_affinity *aff;
+	struct listnode *n;
+
+	frr_with_mutex(&affinity_mtx) {
+		if (!affinity_list)
+			break;
+		for (ALL_LIST_ELEMENTS_RO(affinity_list, n, aff))
+			vty_out(vty, "service thread-affinity %s %s\n",
+				aff->name, aff->cpus);
+	}
+}
+
+void frr_pthread_cmd_init(void)
+{
+	install_element(VIEW_NODE, &show_thread_affinity_cmd);
+	install_element(CONFIG_NODE, &service_thread_affinity_cmd);
+	install_element(CONFIG_NODE, &no_service_thread_affinity_cmd);
+}
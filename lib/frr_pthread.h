@@ -118,6 +118,14 @@ void frr_pthread_init(void);
  */
 void frr_pthread_finish(void);
 
+/*
+ * CLI for the CPU placement of the pthreads ("service thread-affinity",
+ * "show thread affinity"); the config is written by config_write_host().
+ */
+struct vty;
+void frr_pthread_cmd_init(void);
+void frr_pthread_config_write(struct vty *vty);
+
 /*
  * Creates a new frr_pthread with the given attributes.
  *
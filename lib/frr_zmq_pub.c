@@ -0,0 +1,163 @@
+/*
+ * Batching ZeroMQ publisher for routing state change events
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+#include <zmq.h>
+
+#include "frr_zmq.h"
+#include "frr_zmq_pub.h"
+#include "lib_errors.h"
+#include "log.h"
+#include "memory.h"
+
+DEFINE_MTYPE_STATIC(LIB, ZEROMQ_PUB, "ZeroMQ publisher");
+
+/* how long events may wait for a batch to fill up */
+#define FRRZMQ_PUB_FLUSH_MSEC 10
+#define FRRZMQ_PUB_BATCH_SIZE 16384
+
+struct frrzmq_pub {
+	struct thread_master *master;
+	void *zmqsock;
+	char *endpoint;
+	enum frrzmq_pub_source source;
+
+	struct thread *t_flush;
+	uint32_t seq;
+	uint16_t count;
+	size_t len;
+	uint8_t buf[FRRZMQ_PUB_BATCH_SIZE];
+
+	uint64_t events;
+	uint64_t batches;
+	uint64_t dropped_batches;
+	uint64_t dropped_events;
+};
+
+struct frrzmq_pub *frrzmq_pub_new(struct thread_master *master,
+				  const char *endpoint,
+				  enum frrzmq_pub_source source)
+{
+	struct frrzmq_pub *pub;
+	int one = 1;
+
+	frrzmq_init();
+
+	pub = XCALLOC(MTYPE_ZEROMQ_PUB, sizeof(*pub));
+	pub->master = master;
+	pub->source = source;
+	pub->endpoint = XSTRDUP(MTYPE_ZEROMQ_PUB, endpoint);
+	pub->len = sizeof(struct frrzmq_pub_hdr);
+
+	pub->zmqsock = zmq_socket(frrzmq_context, ZMQ_PUB);
+	if (!pub->zmqsock)
+		goto out_err;
+#ifdef ZMQ_XPUB_NODROP
+	/* have zmq_send() fail instead of silently dropping, so we can count
+	 * what subscribers missed
+	 */
+	zmq_setsockopt(pub->zmqsock, ZMQ_XPUB_NODROP, &one, sizeof(one));
+#else
+	(void)one;
+#endif
+	if (zmq_bind(pub->zmqsock, endpoint)) {
+		flog_err(EC_LIB_ZMQ, "ZeroMQ publisher %s: %s", endpoint,
+			     zmq_strerror(errno));
+		goto out_err;
+	}
+	return pub;
+
+out_err:
+	frrzmq_pub_free(&pub);
+	return NULL;
+}
+
+void frrzmq_pub_free(struct frrzmq_pub **pubp)
+{
+	struct frrzmq_pub *pub = *pubp;
+
+	if (!pub)
+		return;
+
+	thread_cancel(&pub->t_flush);
+	if (pub->zmqsock)
+		zmq_close(pub->zmqsock);
+	XFREE(MTYPE_ZEROMQ_PUB, pub->endpoint);
+	XFREE(MTYPE_ZEROMQ_PUB, pub);
+	*pubp = NULL;
+
+	frrzmq_finish();
+}
+
+void frrzmq_pub_flush(struct frrzmq_pub *pub)
+{
+	struct frrzmq_pub_hdr *hdr = (struct frrzmq_pub_hdr *)pub->buf;
+
+	THREAD_OFF(pub->t_flush);
+	if (!pub->count)
+		return;
+
+	hdr->version = FRRZMQ_PUB_VERSION;
+	hdr->source = pub->source;
+	hdr->count = htons(pub->count);
+	hdr->seq = htonl(pub->seq++);
+
+	if (zmq_send(pub->zmqsock, pub->buf, pub->len, ZMQ_DONTWAIT) < 0) {
+		pub->dropped_batches++;
+		pub->dropped_events += pub->count;
+	} else
+		pub->batches++;
+
+	pub->count = 0;
+	pub->len = sizeof(*hdr);
+}
+
+static int frrzmq_pub_flush_timer(struct thread *t)
+{
+	frrzmq_pub_flush(THREAD_ARG(t));
+	return 0;
+}
+
+void frrzmq_pub_add(struct frrzmq_pub *pub, const void *event, size_t len)
+{
+	assert(len <= sizeof(pub->buf) - sizeof(struct frrzmq_pub_hdr));
+
+	if (pub->len + len > sizeof(pub->buf) || pub->count == UINT16_MAX)
+		frrzmq_pub_flush(pub);
+
+	memcpy(pub->buf + pub->len, event, len);
+	pub->len += len;
+	pub->count++;
+	pub->events++;
+
+	if (!pub->t_flush)
+		thread_add_timer_msec(pub->master, frrzmq_pub_flush_timer, pub,
+				      FRRZMQ_PUB_FLUSH_MSEC, &pub->t_flush);
+}
+
+void frrzmq_pub_show(struct vty *vty, const struct frrzmq_pub *pub)
+{
+	vty_out(vty, "ZeroMQ publisher on %s\n", pub->endpoint);
+	vty_out(vty, "  Events:          %" PRIu64 "\n", pub->events);
+	vty_out(vty, "  Batches sent:    %" PRIu64 " (next seq %u)\n",
+		pub->batches, pub->seq);
+	vty_out(vty, "  Batches dropped: %" PRIu64 " (%" PRIu64 " events)\n",
+		pub->dropped_batches, pub->dropped_events);
+	vty_out(vty, "  Events queued:   %u\n", pub->count);
+}
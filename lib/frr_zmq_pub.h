@@ -0,0 +1,115 @@
+/*
+ * Batching ZeroMQ publisher for routing state change events
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _FRR_ZMQ_PUB_H
+#define _FRR_ZMQ_PUB_H
+
+#include "prefix.h"
+#include "thread.h"
+#include "vty.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* part of libfrrzmq, see the linking note in frr_zmq.h.  This header doesn't
+ * pull in <zmq.h>, so it can also be used in files scanned by vtysh.
+ */
+
+#define FRRZMQ_PUB_VERSION 1
+
+/* what a publisher's batches carry, second byte of every message; subscribe
+ * to { FRRZMQ_PUB_VERSION, source } to only get one kind
+ */
+enum frrzmq_pub_source {
+	FRRZMQ_SRC_ZEBRA_RIB = 1,
+	FRRZMQ_SRC_BGP_BESTPATH = 2,
+};
+
+/*
+ * Each ZeroMQ message is a batch: this header, followed by 'count' events.
+ * 'seq' counts batches, so subscribers can tell they missed some.  All fields
+ * are in network byte order.
+ */
+struct frrzmq_pub_hdr {
+	uint8_t version;
+	uint8_t source;
+	uint16_t count;
+	uint32_t seq;
+};
+
+#define FRRZMQ_ROUTE_ADD 1
+#define FRRZMQ_ROUTE_DEL 2
+
+/* route events, for both sources */
+struct frrzmq_route_event {
+	uint8_t op;
+	uint8_t afi;
+	uint8_t prefixlen;
+	/* ZEBRA_ROUTE_*, the protocol the route is from */
+	uint8_t type;
+	uint8_t safi;
+	uint8_t distance;
+	/* afi of 'nexthop', 0 if there's none */
+	uint8_t nh_afi;
+	uint8_t reserved;
+
+	uint32_t vrf_id;
+	uint32_t table;
+	/* zebra: route metric, bgpd: MED */
+	uint32_t metric;
+	uint32_t ifindex;
+
+	uint8_t prefix[16];
+	uint8_t nexthop[16];
+};
+
+static inline void frrzmq_route_event_prefix(struct frrzmq_route_event *ev,
+					     const struct prefix *p)
+{
+	ev->afi = family2afi(p->family);
+	ev->prefixlen = p->prefixlen;
+	memcpy(ev->prefix, &p->u.prefix, prefix_blen(p));
+}
+
+struct frrzmq_pub;
+
+/* the PUB socket is bound to 'endpoint'.  Returns NULL if that fails. */
+extern struct frrzmq_pub *frrzmq_pub_new(struct thread_master *master,
+					 const char *endpoint,
+					 enum frrzmq_pub_source source);
+extern void frrzmq_pub_free(struct frrzmq_pub **pub);
+
+/*
+ * Queue an event of 'len' bytes.  Events are sent in batches, when the batch
+ * is full, or shortly after its first event otherwise.  A batch that can't be
+ * sent right away because subscribers don't keep up is dropped and counted,
+ * instead of blocking the daemon.
+ */
+extern void frrzmq_pub_add(struct frrzmq_pub *pub, const void *event,
+			   size_t len);
+extern void frrzmq_pub_flush(struct frrzmq_pub *pub);
+
+extern void frrzmq_pub_show(struct vty *vty, const struct frrzmq_pub *pub);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FRR_ZMQ_PUB_H */
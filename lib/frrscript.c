@@ -106,8 +106,10 @@ static void codec_free(struct codec *c)
 
 int _frrscript_call(struct frrscript *fs)
 {
+	int ret;
 
-	int ret = lua_pcall(fs->L, 0, 0, 0);
+	lua_rawgeti(fs->L, LUA_REGISTRYINDEX, fs->chunk);
+	ret = lua_pcall(fs->L, 0, 0, 0);
 
 	switch (ret) {
 	case LUA_OK:
@@ -193,7 +195,11 @@ struct frrscript *frrscript_load(const char *name,
 	frrlua_export_logging(fs->L);
 
 	char fname[MAXPATHLEN * 2];
+	struct stat st;
+
 	snprintf(fname, sizeof(fname), "%s/%s.lua", scriptdir, fs->name);
+	if (stat(fname, &st) == 0)
+		fs->mtime = st.st_mtime;
 
 	int ret = luaL_loadfile(fs->L, fname);
 
@@ -226,6 +232,8 @@ struct frrscript *frrscript_load(const char *name,
 	if (ret != LUA_OK)
 		goto fail;
 
+	fs->chunk = luaL_ref(fs->L, LUA_REGISTRYINDEX);
+
 	if (load_cb && (*load_cb)(fs) != 0)
 		goto fail;
 
@@ -242,6 +250,17 @@ void frrscript_unload(struct frrscript *fs)
 	XFREE(MTYPE_SCRIPT, fs);
 }
 
+bool frrscript_is_stale(struct frrscript *fs)
+{
+	char fname[MAXPATHLEN * 2];
+	struct stat st;
+
+	snprintf(fname, sizeof(fname), "%s/%s.lua", scriptdir, fs->name);
+	if (stat(fname, &st) != 0)
+		return true;
+	return st.st_mtime != fs->mtime;
+}
+
 void frrscript_init(const char *sd)
 {
 	codec_hash = hash_create(codec_hash_key, codec_hash_cmp,
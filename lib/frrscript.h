@@ -46,6 +46,12 @@ struct frrscript {
 
 	/* Lua state */
 	struct lua_State *L;
+
+	/* Compiled chunk, in the registry, so it can be called repeatedly */
+	int chunk;
+
+	/* Modification time of the file it was loaded from */
+	time_t mtime;
 };
 
 struct frrscript_env {
@@ -70,6 +76,12 @@ struct frrscript *frrscript_load(const char *name,
  */
 void frrscript_unload(struct frrscript *fs);
 
+/*
+ * Whether the file the script was loaded from has changed since, in which
+ * case callers keeping a script around should load it again.
+ */
+bool frrscript_is_stale(struct frrscript *fs);
+
 /*
  * Register a Lua codec for a type.
  *
@@ -172,11 +184,14 @@ int _frrscript_call(struct frrscript *fs);
 #define frrscript_call(fs, ...)                                                \
 	({                                                                     \
 		lua_State *L = fs->L;                                          \
+		int top = lua_gettop(L);                                       \
 		MAP_LISTS(ENCODE_ARGS, ##__VA_ARGS__);                         \
 		int ret = _frrscript_call(fs);                                 \
 		if (ret == 0) {                                                \
 			MAP_LISTS(DECODE_ARGS, ##__VA_ARGS__);                 \
 		}                                                              \
+		/* not all decoders pop their value */                         \
+		lua_settop(L, top);                                            \
 		ret;                                                           \
 	})
 
@@ -38,17 +38,20 @@ DEFINE_MTYPE_STATIC(LIB, HASH_INDEX, "Hash Index");
 static pthread_mutex_t _hashes_mtx = PTHREAD_MUTEX_INITIALIZER;
 static struct list *_hashes;
 
-struct hash *hash_create_size(unsigned int size,
-			      unsigned int (*hash_key)(const void *),
-			      bool (*hash_cmp)(const void *, const void *),
-			      const char *name)
+/* Open addressing, see below */
+#define HASH_OPEN_MIN_SIZE 8
+#define HASH_OPEN_THRESHOLD(used, size) ((used) > (size) / 4 * 3)
+#define HASH_OPEN_MIGRATE_STEP 8
+
+static struct hash *hash_new(unsigned int size,
+			     unsigned int (*hash_key)(const void *),
+			     bool (*hash_cmp)(const void *, const void *),
+			     const char *name)
 {
 	struct hash *hash;
 
 	assert((size & (size - 1)) == 0);
 	hash = XCALLOC(MTYPE_HASH, sizeof(struct hash));
-	hash->index =
-		XCALLOC(MTYPE_HASH_INDEX, sizeof(struct hash_bucket *) * size);
 	hash->size = size;
 	hash->hash_key = hash_key;
 	hash->hash_cmp = hash_cmp;
@@ -66,6 +69,37 @@ struct hash *hash_create_size(unsigned int size,
 	return hash;
 }
 
+struct hash *hash_create_size(unsigned int size,
+			      unsigned int (*hash_key)(const void *),
+			      bool (*hash_cmp)(const void *, const void *),
+			      const char *name)
+{
+	struct hash *hash;
+
+	hash = hash_new(size, hash_key, hash_cmp, name);
+	hash->index =
+		XCALLOC(MTYPE_HASH_INDEX, sizeof(struct hash_bucket *) * size);
+
+	return hash;
+}
+
+struct hash *hash_create_open(unsigned int size,
+			      unsigned int (*hash_key)(const void *),
+			      bool (*hash_cmp)(const void *, const void *),
+			      const char *name)
+{
+	struct hash *hash;
+
+	/* Needs room for some empty slots at the highest load. */
+	if (size < HASH_OPEN_MIN_SIZE)
+		size = HASH_OPEN_MIN_SIZE;
+
+	hash = hash_new(size, hash_key, hash_cmp, name);
+	hash->slots = XCALLOC(MTYPE_HASH_INDEX, sizeof(*hash->slots) * size);
+
+	return hash;
+}
+
 struct hash *hash_create(unsigned int (*hash_key)(const void *),
 			 bool (*hash_cmp)(const void *, const void *),
 			 const char *name)
@@ -93,6 +127,260 @@ void *hash_alloc_intern(void *arg)
 						  memory_order_relaxed);       \
 	} while (0)
 
+/* Open addressing ------------------------------------------------------- */
+
+/*
+ * Slots are indexed by linear probing from key & (size - 1), keeping every
+ * element at most as far from its home slot as the ones probed before it
+ * (Robin Hood hashing).  That keeps probe sequences short at high load, lets
+ * lookups stop as soon as they would pass a closer element and makes removal
+ * a backward shift of the rest of the sequence, without tombstones.
+ *
+ * Expansion moves the slots to old_slots and starts over with an array twice
+ * the size.  Every insertion then migrates HASH_OPEN_MIGRATE_STEP old slots,
+ * which is enough to empty old_slots long before the new array reaches the
+ * threshold in turn.  Until then lookups and removals look at both arrays.
+ * Removals from old_slots leave a tombstone (len -1) so that they don't move
+ * the elements not migrated yet, migrated slots are marked the same way.
+ */
+
+static struct hash_bucket *hash_open_find(struct hash *hash,
+					  struct hash_bucket *slots,
+					  unsigned int size, unsigned int key,
+					  void *data)
+{
+	unsigned int mask = size - 1;
+	unsigned int i = key & mask;
+	int dist;
+
+	for (dist = 1; dist <= (int)size; dist++, i = (i + 1) & mask) {
+		struct hash_bucket *hb = &slots[i];
+
+		if (hb->len < 0)
+			continue;
+		if (hb->len < dist)
+			return NULL;
+		if (hb->key == key && (*hash->hash_cmp)(hb->data, data))
+			return hb;
+	}
+
+	return NULL;
+}
+
+static void hash_open_insert(struct hash_bucket *slots, unsigned int size,
+			     unsigned int key, void *data)
+{
+	unsigned int mask = size - 1;
+	unsigned int i = key & mask;
+	struct hash_bucket cur = {.len = 1, .key = key, .data = data};
+	struct hash_bucket tmp;
+
+	for (;; i = (i + 1) & mask, cur.len++) {
+		struct hash_bucket *hb = &slots[i];
+
+		if (!hb->len) {
+			*hb = cur;
+			return;
+		}
+		if (hb->len < cur.len) {
+			tmp = *hb;
+			*hb = cur;
+			cur = tmp;
+		}
+	}
+}
+
+static void hash_open_remove(struct hash_bucket *slots, unsigned int size,
+			     struct hash_bucket *hb)
+{
+	unsigned int mask = size - 1;
+	unsigned int i = hb - slots;
+	unsigned int next;
+
+	for (;; i = next) {
+		next = (i + 1) & mask;
+		if (slots[next].len <= 1) {
+			memset(&slots[i], 0, sizeof(slots[i]));
+			return;
+		}
+		slots[i] = slots[next];
+		slots[i].len--;
+	}
+}
+
+static void hash_open_migrate(struct hash *hash, unsigned int step)
+{
+	while (hash->old_slots && step--) {
+		struct hash_bucket *hb = &hash->old_slots[hash->old_pos++];
+
+		if (hb->len > 0) {
+			hash_open_insert(hash->slots, hash->size, hb->key,
+					 hb->data);
+			hb->len = -1;
+			hash->old_count--;
+		}
+
+		if (!hash->old_count || hash->old_pos == hash->old_size) {
+			XFREE(MTYPE_HASH_INDEX, hash->old_slots);
+			hash->old_size = 0;
+			hash->old_pos = 0;
+			hash->old_count = 0;
+		}
+	}
+}
+
+static void hash_open_expand(struct hash *hash)
+{
+	/* Not supposed to happen, see HASH_OPEN_MIGRATE_STEP. */
+	hash_open_migrate(hash, UINT_MAX);
+
+	hash->old_slots = hash->slots;
+	hash->old_size = hash->size;
+	hash->old_pos = 0;
+	hash->old_count = hash->count;
+
+	hash->size *= 2;
+	hash->slots =
+		XCALLOC(MTYPE_HASH_INDEX, sizeof(*hash->slots) * hash->size);
+}
+
+static void *hash_open_get(struct hash *hash, void *data,
+			   void *(*alloc_func)(void *))
+{
+	struct hash_bucket *hb;
+	unsigned int key;
+	void *newdata;
+
+	if (!alloc_func && !hash->count)
+		return NULL;
+
+	key = (*hash->hash_key)(data);
+	hb = hash_open_find(hash, hash->slots, hash->size, key, data);
+	if (!hb && hash->old_slots)
+		hb = hash_open_find(hash, hash->old_slots, hash->old_size, key,
+				    data);
+	if (hb)
+		return hb->data;
+	if (!alloc_func)
+		return NULL;
+
+	newdata = (*alloc_func)(data);
+	if (newdata == NULL)
+		return NULL;
+
+	hash_open_migrate(hash, HASH_OPEN_MIGRATE_STEP);
+	if (HASH_OPEN_THRESHOLD(hash->count - hash->old_count + 1, hash->size))
+		hash_open_expand(hash);
+
+	hash_open_insert(hash->slots, hash->size, key, newdata);
+	hash->count++;
+
+	frrtrace(3, frr_libfrr, hash_insert, hash, data, key);
+
+	return newdata;
+}
+
+static void *hash_open_release(struct hash *hash, void *data)
+{
+	struct hash_bucket *hb;
+	unsigned int key;
+	void *ret = NULL;
+
+	key = (*hash->hash_key)(data);
+	hb = hash_open_find(hash, hash->slots, hash->size, key, data);
+	if (hb) {
+		ret = hb->data;
+		hash_open_remove(hash->slots, hash->size, hb);
+	} else if (hash->old_slots) {
+		hb = hash_open_find(hash, hash->old_slots, hash->old_size, key,
+				    data);
+		if (hb) {
+			ret = hb->data;
+			hb->len = -1;
+			hb->data = NULL;
+			hash->old_count--;
+		}
+	}
+	if (ret)
+		hash->count--;
+
+	frrtrace(3, frr_libfrr, hash_release, hash, data, ret);
+
+	return ret;
+}
+
+static void hash_open_walk(struct hash *hash,
+			   int (*func)(struct hash_bucket *, void *), void *arg)
+{
+	unsigned int mask = hash->size - 1;
+	unsigned int i, n, start;
+
+	/* Elements of old_slots never move, only inserting migrates them. */
+	for (i = 0; hash->old_slots && i < hash->old_size; i++) {
+		if (hash->old_slots[i].len <= 0)
+			continue;
+		if ((*func)(&hash->old_slots[i], arg) == HASHWALK_ABORT)
+			return;
+	}
+
+	/*
+	 * Removing the current element shifts the next ones back by one slot,
+	 * so the same slot is looked at again if its element changed.  Start
+	 * at an empty slot or an element in its home slot: those never move,
+	 * so nothing can shift from the first slots walked to the last ones.
+	 */
+	for (start = 0; start < hash->size; start++)
+		if (hash->slots[start].len <= 1)
+			break;
+
+	for (n = 0; n < hash->size; n++) {
+		struct hash_bucket *hb = &hash->slots[(start + n) & mask];
+
+		while (hb->len) {
+			void *data = hb->data;
+
+			if ((*func)(hb, arg) == HASHWALK_ABORT)
+				return;
+			if (hb->len && hb->data == data)
+				break;
+		}
+	}
+}
+
+struct hash_iterate_arg {
+	void (*func)(struct hash_bucket *, void *);
+	void *arg;
+};
+
+static int hash_iterate_walker(struct hash_bucket *hb, void *arg)
+{
+	struct hash_iterate_arg *iter = arg;
+
+	(*iter->func)(hb, iter->arg);
+	return HASHWALK_CONTINUE;
+}
+
+static void hash_open_clean(struct hash *hash, void (*free_func)(void *))
+{
+	unsigned int i;
+
+	for (i = 0; hash->old_slots && i < hash->old_size; i++)
+		if (hash->old_slots[i].len > 0 && free_func)
+			(*free_func)(hash->old_slots[i].data);
+	for (i = 0; i < hash->size; i++)
+		if (hash->slots[i].len > 0 && free_func)
+			(*free_func)(hash->slots[i].data);
+
+	XFREE(MTYPE_HASH_INDEX, hash->old_slots);
+	hash->old_size = 0;
+	hash->old_pos = 0;
+	hash->old_count = 0;
+	memset(hash->slots, 0, sizeof(*hash->slots) * hash->size);
+	hash->count = 0;
+}
+
+/* Chaining ---------------------------------------------------------------- */
+
 /* Expand hash if the chain length exceeds the threshold. */
 static void hash_expand(struct hash *hash)
 {
@@ -146,6 +434,9 @@ void *hash_get(struct hash *hash, void *data, void *(*alloc_func)(void *))
 	void *newdata;
 	struct hash_bucket *bucket;
 
+	if (hash->slots)
+		return hash_open_get(hash, data, alloc_func);
+
 	if (!alloc_func && !hash->count)
 		return NULL;
 
@@ -217,6 +508,9 @@ void *hash_release(struct hash *hash, void *data)
 	struct hash_bucket *bucket;
 	struct hash_bucket *pp;
 
+	if (hash->slots)
+		return hash_open_release(hash, data);
+
 	key = (*hash->hash_key)(data);
 	index = key & (hash->size - 1);
 
@@ -258,6 +552,13 @@ void hash_iterate(struct hash *hash, void (*func)(struct hash_bucket *, void *),
 	struct hash_bucket *hb;
 	struct hash_bucket *hbnext;
 
+	if (hash->slots) {
+		struct hash_iterate_arg iter = {.func = func, .arg = arg};
+
+		hash_open_walk(hash, hash_iterate_walker, &iter);
+		return;
+	}
+
 	for (i = 0; i < hash->size; i++)
 		for (hb = hash->index[i]; hb; hb = hbnext) {
 			/* get pointer to next hash bucket here, in case (*func)
@@ -276,6 +577,11 @@ void hash_walk(struct hash *hash, int (*func)(struct hash_bucket *, void *),
 	struct hash_bucket *hbnext;
 	int ret = HASHWALK_CONTINUE;
 
+	if (hash->slots) {
+		hash_open_walk(hash, func, arg);
+		return;
+	}
+
 	for (i = 0; i < hash->size; i++) {
 		for (hb = hash->index[i]; hb; hb = hbnext) {
 			/* get pointer to next hash bucket here, in case (*func)
@@ -295,6 +601,11 @@ void hash_clean(struct hash *hash, void (*free_func)(void *))
 	struct hash_bucket *hb;
 	struct hash_bucket *next;
 
+	if (hash->slots) {
+		hash_open_clean(hash, free_func);
+		return;
+	}
+
 	for (i = 0; i < hash->size; i++) {
 		for (hb = hash->index[i]; hb; hb = next) {
 			next = hb->next;
@@ -341,6 +652,8 @@ void hash_free(struct hash *hash)
 	XFREE(MTYPE_HASH, hash->name);
 
 	XFREE(MTYPE_HASH_INDEX, hash->index);
+	XFREE(MTYPE_HASH_INDEX, hash->slots);
+	XFREE(MTYPE_HASH_INDEX, hash->old_slots);
 	XFREE(MTYPE_HASH, hash);
 }
 
@@ -401,6 +714,7 @@ DEFUN_NOSH(show_hash_stats,
 	long double ldc;  // (long double) h->count
 	long double full; // h->size - h->stats.empty
 	long double ssq;  // ssq casted to long double
+	unsigned int empty;
 
 	pthread_mutex_lock(&_hashes_mtx);
 	if (!_hashes) {
@@ -414,10 +728,18 @@ DEFUN_NOSH(show_hash_stats,
 		if (!h->name)
 			continue;
 
-		ssq = (long double)h->stats.ssq;
+		/* each slot of an open addressing table is a chain of one */
+		if (h->slots) {
+			full = h->count - h->old_count;
+			ssq = full;
+			empty = h->size - full;
+		} else {
+			full = h->size - h->stats.empty;
+			ssq = (long double)h->stats.ssq;
+			empty = h->stats.empty;
+		}
 		x2 = h->count * h->count;
 		ldc = (long double)h->count;
-		full = h->size - h->stats.empty;
 		lf = h->count / (double)h->size;
 		flf = full ? h->count / (double)(full) : 0;
 		var = ldc ? (1.0 / ldc) * (ssq - x2 / ldc) : 0;
@@ -429,7 +751,7 @@ DEFUN_NOSH(show_hash_stats,
 
 		ttable_add_row(tt, "%s|%d|%ld|%.0f%%|%.2lf|%.2lf|%.2lf|%.2lf",
 			       h->name, h->size, h->count,
-			       (h->stats.empty / (double)h->size) * 100, lf,
+			       (empty / (double)h->size) * 100, lf,
 			       stdv, flf, fstdv);
 	}
 	pthread_mutex_unlock(&_hashes_mtx);
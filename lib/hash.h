@@ -40,15 +40,18 @@ struct hash_bucket {
 	/*
 	 * if this bucket is the head of the linked listed, len denotes the
 	 * number of elements in the list
+	 *
+	 * In open addressing tables this is the distance of the slot from the
+	 * one the key hashes to, plus one (0 for empty slots).
 	 */
 	int len;
 
-	/* Linked list.  */
-	struct hash_bucket *next;
-
 	/* Hash key. */
 	unsigned int key;
 
+	/* Linked list.  */
+	struct hash_bucket *next;
+
 	/* Data.  */
 	void *data;
 };
@@ -83,6 +86,17 @@ struct hash {
 
 	/* hash name */
 	char *name;
+
+	/*
+	 * Open addressing tables (see hash_create_open()) keep their elements
+	 * in slots instead of index.  After an expansion, the previous slots
+	 * are migrated a few at a time by the following insertions.
+	 */
+	struct hash_bucket *slots;
+	struct hash_bucket *old_slots;
+	unsigned int old_size;
+	unsigned int old_pos;
+	unsigned long old_count;
 };
 
 #define hashcount(X) ((X)->count)
@@ -154,6 +168,26 @@ hash_create_size(unsigned int size, unsigned int (*hash_key)(const void *),
 		 bool (*hash_cmp)(const void *, const void *),
 		 const char *name);
 
+/*
+ * Create a hash table using open addressing.
+ *
+ * Same as hash_create_size(), except that the created hash table stores its
+ * elements in a flat array, resolving collisions with Robin Hood linear
+ * probing. This saves a memory allocation per element and a pointer
+ * dereference per lookup. When the table grows, the elements are not all
+ * rehashed at once but moved to the new array a few at a time by the
+ * following insertions, so that no single insertion stalls on a big table.
+ *
+ * It is meant for big, busy tables. Every hash_*() function works on it, but
+ * its index field is NULL, so the table can't be walked by hand; max_size is
+ * ignored. Deleting anything but the current element during hash_iterate() or
+ * hash_walk() may cause elements to be skipped.
+ */
+extern struct hash *
+hash_create_open(unsigned int size, unsigned int (*hash_key)(const void *),
+		 bool (*hash_cmp)(const void *, const void *),
+		 const char *name);
+
 /*
  * Retrieve or insert data from / into a hash table.
  *
@@ -0,0 +1,158 @@
+/*
+ * Main event loop heartbeat, for watchfrr.
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+
+#include <sys/mman.h>
+
+#include "heartbeat.h"
+#include "lib_errors.h"
+#include "log.h"
+#include "monotime.h"
+
+static struct frr_heartbeat *heartbeat;
+static char heartbeat_path[512];
+
+static inline uint64_t tv_usec(const struct timeval *tv)
+{
+	return (uint64_t)tv->tv_sec * 1000000 + tv->tv_usec;
+}
+
+void frr_heartbeat_init(const char *path)
+{
+	struct frr_heartbeat *hb;
+	int fd;
+
+	/* a new file, so that watchfrr's mapping of a previous instance's
+	 * isn't mistaken for this one
+	 */
+	unlink(path);
+	fd = open(path, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0644);
+	if (fd < 0) {
+		flog_err_sys(EC_LIB_SYSTEM_CALL, "heartbeat: open(%s): %s",
+			     path, safe_strerror(errno));
+		return;
+	}
+	if (ftruncate(fd, sizeof(*hb))) {
+		flog_err_sys(EC_LIB_SYSTEM_CALL, "heartbeat: ftruncate(%s): %s",
+			     path, safe_strerror(errno));
+		close(fd);
+		unlink(path);
+		return;
+	}
+
+	hb = mmap(NULL, sizeof(*hb), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (hb == MAP_FAILED) {
+		flog_err_sys(EC_LIB_SYSTEM_CALL, "heartbeat: mmap(%s): %s",
+			     path, safe_strerror(errno));
+		unlink(path);
+		return;
+	}
+
+	hb->version = FRR_HEARTBEAT_VERSION;
+	hb->pid = getpid();
+	/* last, so a reader never takes a half set up file as valid */
+	atomic_store_explicit(&hb->magic, FRR_HEARTBEAT_MAGIC,
+			      memory_order_release);
+
+	strlcpy(heartbeat_path, path, sizeof(heartbeat_path));
+	heartbeat = hb;
+}
+
+void frr_heartbeat_fini(void)
+{
+	if (!heartbeat)
+		return;
+
+	munmap(heartbeat, sizeof(*heartbeat));
+	heartbeat = NULL;
+	unlink(heartbeat_path);
+}
+
+void frr_heartbeat_task_start(void)
+{
+	struct timeval now;
+
+	if (!heartbeat)
+		return;
+
+	monotime(&now);
+	atomic_store_explicit(&heartbeat->task_start, tv_usec(&now),
+			      memory_order_relaxed);
+}
+
+void frr_heartbeat_task_end(const struct timeval *end)
+{
+	uint64_t start, latency;
+
+	if (!heartbeat)
+		return;
+
+	start = atomic_load_explicit(&heartbeat->task_start,
+				     memory_order_relaxed);
+	latency = tv_usec(end) > start ? tv_usec(end) - start : 0;
+
+	atomic_store_explicit(&heartbeat->last_latency, latency,
+			      memory_order_relaxed);
+	if (latency > atomic_load_explicit(&heartbeat->max_latency,
+					   memory_order_relaxed))
+		atomic_store_explicit(&heartbeat->max_latency, latency,
+				      memory_order_relaxed);
+	atomic_store_explicit(&heartbeat->task_start, 0, memory_order_relaxed);
+	atomic_fetch_add_explicit(&heartbeat->tasks, 1, memory_order_release);
+}
+
+const struct frr_heartbeat *frr_heartbeat_open(const char *path)
+{
+	struct frr_heartbeat *hb;
+	struct stat st;
+	int fd;
+
+	fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0)
+		return NULL;
+
+	if (fstat(fd, &st) || st.st_size < (off_t)sizeof(*hb)) {
+		close(fd);
+		return NULL;
+	}
+
+	hb = mmap(NULL, sizeof(*hb), PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (hb == MAP_FAILED)
+		return NULL;
+
+	if (atomic_load_explicit(&hb->magic, memory_order_acquire)
+		    != FRR_HEARTBEAT_MAGIC
+	    || hb->version != FRR_HEARTBEAT_VERSION) {
+		munmap(hb, sizeof(*hb));
+		return NULL;
+	}
+	return hb;
+}
+
+void frr_heartbeat_close(const struct frr_heartbeat **hb)
+{
+	if (!*hb)
+		return;
+
+	munmap((void *)*hb, sizeof(**hb));
+	*hb = NULL;
+}
@@ -0,0 +1,72 @@
+/*
+ * Main event loop heartbeat, for watchfrr.
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _FRR_HEARTBEAT_H
+#define _FRR_HEARTBEAT_H
+
+#include "frratomic.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Each daemon publishes a few counters of its main event loop in a small
+ * shared file next to its vty socket ("<daemon>.vty" -> "<daemon>.hb").
+ * watchfrr maps it read-only, which tells a daemon whose loop is still
+ * running tasks, however slowly, apart from one that is stuck in a single
+ * task - without sending the daemon anything.
+ *
+ * Times are monotime() in microseconds, and the layout must stay the same
+ * between watchfrr and the daemons, hence the version field.
+ */
+#define FRR_HEARTBEAT_MAGIC	0x46524842U /* "FRHB" */
+#define FRR_HEARTBEAT_VERSION	1
+#define FRR_HEARTBEAT_SUFFIX	".hb"
+
+struct frr_heartbeat {
+	/* set once the rest is filled in */
+	_Atomic uint32_t magic;
+	uint32_t version;
+	uint64_t pid;
+
+	/* tasks run so far */
+	_Atomic uint64_t tasks;
+	/* start of the task running right now, 0 while waiting for events */
+	_Atomic uint64_t task_start;
+	/* run time of the last task, and of the longest one */
+	_Atomic uint64_t last_latency;
+	_Atomic uint64_t max_latency;
+};
+
+/* daemon side, called by libfrr */
+extern void frr_heartbeat_init(const char *path);
+extern void frr_heartbeat_fini(void);
+extern void frr_heartbeat_task_start(void);
+extern void frr_heartbeat_task_end(const struct timeval *end);
+
+/* watchfrr side, NULL if the daemon doesn't publish a (usable) heartbeat */
+extern const struct frr_heartbeat *frr_heartbeat_open(const char *path);
+extern void frr_heartbeat_close(const struct frr_heartbeat **hb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FRR_HEARTBEAT_H */
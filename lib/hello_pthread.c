@@ -0,0 +1,334 @@
+/*
+ * Protocol hellos and dead timers on a separate pthread.
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+
+#include "frr_pthread.h"
+#include "frratomic.h"
+#include "hello_pthread.h"
+#include "memory.h"
+#include "monotime.h"
+#include "typesafe.h"
+
+DEFINE_MTYPE_STATIC(LIB, HELLO_SENDER, "Hello sender");
+DEFINE_MTYPE_STATIC(LIB, HELLO_WATCH, "Hello dead timer");
+
+PREDECL_DLIST(hello_senders);
+PREDECL_DLIST(hello_watches);
+
+struct hello_sender {
+	struct hello_senders_item item;
+
+	void (*send)(void *arg);
+	void *arg;
+	uint32_t interval;
+	struct timeval next;
+};
+
+struct hello_watch {
+	struct hello_watches_item item;
+
+	struct thread_master *master;
+	int (*dead)(struct thread *);
+	void *arg;
+	uint32_t interval;
+
+	/* monotime of the last hello in usec, written from any pthread */
+	_Atomic int64_t heard;
+	/* set once 'dead' has been posted, until the next hello */
+	atomic_bool fired;
+	int64_t fired_heard;
+	struct thread *t_dead;
+};
+
+DECLARE_DLIST(hello_senders, struct hello_sender, item);
+DECLARE_DLIST(hello_watches, struct hello_watch, item);
+
+static struct frr_pthread *hello_pth;
+static pthread_mutex_t hello_mtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t hello_cond;
+static struct hello_senders_head senders;
+static struct hello_watches_head watches;
+
+static int64_t hello_now(const struct timeval *tv)
+{
+	return (int64_t)tv->tv_sec * 1000000 + tv->tv_usec;
+}
+
+static void hello_wake(void)
+{
+	frr_with_mutex(&hello_mtx) {
+		pthread_cond_signal(&hello_cond);
+	}
+}
+
+/*
+ * Send whatever is due and post the dead timers that ran out.  Returns the
+ * absolute time of the next deadline in 'next', or false if there is none.
+ * Needs hello_mtx.
+ */
+static bool hello_process(const struct timeval *now, struct timeval *next)
+{
+	struct hello_sender *hs;
+	struct hello_watch *hw;
+	struct timeval tv;
+	int64_t usec = hello_now(now);
+	int64_t heard, due;
+	bool any = false;
+
+	frr_each (hello_senders, &senders, hs) {
+		if (!timercmp(now, &hs->next, <)) {
+			hs->send(hs->arg);
+			tv.tv_sec = hs->interval / 1000;
+			tv.tv_usec = (hs->interval % 1000) * 1000;
+			timeradd(now, &tv, &hs->next);
+		}
+		if (!any || timercmp(&hs->next, next, <))
+			*next = hs->next;
+		any = true;
+	}
+
+	frr_each (hello_watches, &watches, hw) {
+		heard = atomic_load_explicit(&hw->heard, memory_order_relaxed);
+		if (atomic_load_explicit(&hw->fired, memory_order_relaxed)) {
+			if (heard == hw->fired_heard)
+				continue;
+			atomic_store_explicit(&hw->fired, false,
+					      memory_order_relaxed);
+		}
+
+		due = heard + (int64_t)hw->interval * 1000;
+		if (due <= usec) {
+			hw->fired_heard = heard;
+			atomic_store_explicit(&hw->fired, true,
+					      memory_order_relaxed);
+			thread_add_event(hw->master, hw->dead, hw->arg, 0,
+					 &hw->t_dead);
+			continue;
+		}
+
+		tv.tv_sec = due / 1000000;
+		tv.tv_usec = due % 1000000;
+		if (!any || timercmp(&tv, next, <))
+			*next = tv;
+		any = true;
+	}
+
+	return any;
+}
+
+static void *hello_pthread_start(void *arg)
+{
+	struct frr_pthread *fpt = arg;
+	struct timeval now, next;
+	struct timespec next_ts;
+
+	fpt->master->owner = pthread_self();
+
+	/* not using the thread_master, like the BGP keepalives pthread */
+	frr_pthread_set_name(fpt);
+
+	pthread_mutex_lock(&hello_mtx);
+	frr_pthread_notify_running(fpt);
+
+	while (atomic_load_explicit(&fpt->running, memory_order_relaxed)) {
+		monotime(&now);
+		if (hello_process(&now, &next)) {
+			TIMEVAL_TO_TIMESPEC(&next, &next_ts);
+			pthread_cond_timedwait(&hello_cond, &hello_mtx,
+					       &next_ts);
+		} else
+			pthread_cond_wait(&hello_cond, &hello_mtx);
+	}
+
+	pthread_mutex_unlock(&hello_mtx);
+	return NULL;
+}
+
+static int hello_pthread_stop(struct frr_pthread *fpt, void **result)
+{
+	assert(fpt->running);
+
+	atomic_store_explicit(&fpt->running, false, memory_order_relaxed);
+	hello_wake();
+
+	pthread_join(fpt->thread, result);
+	return 0;
+}
+
+void hello_pthread_init(void)
+{
+	struct frr_pthread_attr attr = {
+		.start = hello_pthread_start,
+		.stop = hello_pthread_stop,
+	};
+	pthread_condattr_t attrs;
+
+	assert(!hello_pth);
+
+	/* the wait deadlines come from monotime() */
+	pthread_condattr_init(&attrs);
+	pthread_condattr_setclock(&attrs, CLOCK_MONOTONIC);
+	pthread_cond_init(&hello_cond, &attrs);
+	pthread_condattr_destroy(&attrs);
+
+	hello_senders_init(&senders);
+	hello_watches_init(&watches);
+
+	hello_pth = frr_pthread_new(&attr, "Hello thread", "hello");
+	frr_pthread_run(hello_pth, NULL);
+	frr_pthread_wait_running(hello_pth);
+}
+
+void hello_pthread_finish(void)
+{
+	struct hello_sender *hs;
+	struct hello_watch *hw;
+
+	if (!hello_pth)
+		return;
+
+	frr_pthread_stop(hello_pth, NULL);
+	frr_pthread_destroy(hello_pth);
+	hello_pth = NULL;
+
+	while ((hs = hello_senders_pop(&senders)))
+		XFREE(MTYPE_HELLO_SENDER, hs);
+	while ((hw = hello_watches_pop(&watches))) {
+		THREAD_OFF(hw->t_dead);
+		XFREE(MTYPE_HELLO_WATCH, hw);
+	}
+	hello_senders_fini(&senders);
+	hello_watches_fini(&watches);
+	pthread_cond_destroy(&hello_cond);
+}
+
+struct hello_sender *hello_sender_add(void (*send)(void *arg), void *arg,
+				      uint32_t interval)
+{
+	struct hello_sender *hs;
+
+	assert(hello_pth);
+
+	hs = XCALLOC(MTYPE_HELLO_SENDER, sizeof(*hs));
+	hs->send = send;
+	hs->arg = arg;
+	hs->interval = interval;
+	/* first one right away */
+	monotime(&hs->next);
+
+	frr_with_mutex(&hello_mtx) {
+		hello_senders_add_tail(&senders, hs);
+		pthread_cond_signal(&hello_cond);
+	}
+	return hs;
+}
+
+void hello_sender_set_interval(struct hello_sender *hs, uint32_t interval)
+{
+	struct timeval now, tv;
+
+	frr_with_mutex(&hello_mtx) {
+		hs->interval = interval;
+		/* a shorter interval takes effect right away */
+		monotime(&now);
+		tv.tv_sec = interval / 1000;
+		tv.tv_usec = (interval % 1000) * 1000;
+		timeradd(&now, &tv, &tv);
+		if (timercmp(&tv, &hs->next, <))
+			hs->next = tv;
+		pthread_cond_signal(&hello_cond);
+	}
+}
+
+void hello_sender_del(struct hello_sender **hsp)
+{
+	struct hello_sender *hs = *hsp;
+
+	if (!hs)
+		return;
+
+	/* once this returns, send() isn't running and won't be called again */
+	frr_with_mutex(&hello_mtx) {
+		hello_senders_del(&senders, hs);
+	}
+	XFREE(MTYPE_HELLO_SENDER, hs);
+	*hsp = NULL;
+}
+
+struct hello_watch *hello_watch_add(struct thread_master *master,
+				    int (*dead)(struct thread *), void *arg,
+				    uint32_t interval)
+{
+	struct hello_watch *hw;
+	struct timeval now;
+
+	assert(hello_pth);
+
+	hw = XCALLOC(MTYPE_HELLO_WATCH, sizeof(*hw));
+	hw->master = master;
+	hw->dead = dead;
+	hw->arg = arg;
+	hw->interval = interval;
+	monotime(&now);
+	atomic_store_explicit(&hw->heard, hello_now(&now),
+			      memory_order_relaxed);
+
+	frr_with_mutex(&hello_mtx) {
+		hello_watches_add_tail(&watches, hw);
+		pthread_cond_signal(&hello_cond);
+	}
+	return hw;
+}
+
+void hello_watch_set_interval(struct hello_watch *hw, uint32_t interval)
+{
+	frr_with_mutex(&hello_mtx) {
+		hw->interval = interval;
+		pthread_cond_signal(&hello_cond);
+	}
+}
+
+void hello_watch_heard(struct hello_watch *hw)
+{
+	struct timeval now;
+
+	monotime(&now);
+	atomic_store_explicit(&hw->heard, hello_now(&now),
+			      memory_order_relaxed);
+
+	/* nothing to wake up for unless the timer had run out */
+	if (atomic_load_explicit(&hw->fired, memory_order_relaxed))
+		hello_wake();
+}
+
+void hello_watch_del(struct hello_watch **hwp)
+{
+	struct hello_watch *hw = *hwp;
+
+	if (!hw)
+		return;
+
+	frr_with_mutex(&hello_mtx) {
+		hello_watches_del(&watches, hw);
+	}
+	THREAD_OFF(hw->t_dead);
+	XFREE(MTYPE_HELLO_WATCH, hw);
+	*hwp = NULL;
+}
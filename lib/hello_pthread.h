@@ -0,0 +1,66 @@
+/*
+ * Protocol hellos and dead timers on a separate pthread.
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _FRR_HELLO_PTHREAD_H
+#define _FRR_HELLO_PTHREAD_H
+
+#include "thread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Keeps adjacencies alive while the main pthread is busy, along the lines of
+ * bgpd's keepalive pthread.  A sender calls its send function every
+ * 'interval' milliseconds on the hello pthread; the function must only use
+ * what it protects itself, typically a packet prebuilt by the owner under a
+ * mutex and a socket.  A watch posts its 'dead' callback as an event onto the
+ * owner's thread_master if hello_watch_heard() hasn't been called for
+ * 'interval' milliseconds; it's rearmed by the next hello_watch_heard().
+ *
+ * All functions but hello_watch_heard() are for the owner's pthread, and none
+ * of them may be called from a send function.
+ */
+struct hello_sender;
+struct hello_watch;
+
+extern void hello_pthread_init(void);
+extern void hello_pthread_finish(void);
+
+extern struct hello_sender *hello_sender_add(void (*send)(void *arg),
+					     void *arg, uint32_t interval);
+extern void hello_sender_set_interval(struct hello_sender *hs,
+				      uint32_t interval);
+extern void hello_sender_del(struct hello_sender **hs);
+
+extern struct hello_watch *hello_watch_add(struct thread_master *master,
+					   int (*dead)(struct thread *),
+					   void *arg, uint32_t interval);
+extern void hello_watch_set_interval(struct hello_watch *hw,
+				     uint32_t interval);
+/* any pthread, e.g. a packet reader */
+extern void hello_watch_heard(struct hello_watch *hw);
+extern void hello_watch_del(struct hello_watch **hw);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FRR_HELLO_PTHREAD_H */
@@ -50,8 +50,12 @@ static struct interface *if_lookup_by_ifindex(ifindex_t ifindex,
 static int if_cmp_func(const struct interface *, const struct interface *);
 static int if_cmp_index_func(const struct interface *ifp1,
 			     const struct interface *ifp2);
+static void if_connected_index_update(struct interface *ifp,
+				      struct vrf *vrf);
 RB_GENERATE(if_name_head, interface, name_entry, if_cmp_func);
 RB_GENERATE(if_index_head, interface, index_entry, if_cmp_index_func);
+DECLARE_ATOMSORT_UNIQ(if_index_rcu, struct interface, index_rcu_entry,
+		      if_cmp_index_func);
 
 DEFINE_QOBJ_TYPE(interface);
 
@@ -255,6 +259,8 @@ void if_update_to_new_vrf(struct interface *ifp, vrf_id_t vrf_id)
 	if (ifp->ifindex != IFINDEX_INTERNAL)
 		IFINDEX_RB_INSERT(vrf, ifp);
 
+	if_connected_index_update(ifp, vrf);
+
 	/*
 	 * HACK: Change the interface VRF in the running configuration directly,
 	 * bypassing the northbound layer. This is necessary to avoid deleting
@@ -322,7 +328,8 @@ void if_delete(struct interface **ifp)
 
 	XFREE(MTYPE_TMP, ptr->desc);
 
-	XFREE(MTYPE_IF, ptr);
+	/* other pthreads may still be looking at it */
+	rcu_free(MTYPE_IF, ptr, rcu_head);
 	*ifp = NULL;
 }
 
@@ -354,6 +361,49 @@ struct interface *if_lookup_by_index(ifindex_t ifindex, vrf_id_t vrf_id)
 	return NULL;
 }
 
+static struct interface *if_lookup_by_ifindex_rcu(struct vrf *vrf,
+						  ifindex_t ifindex)
+{
+	struct interface *ifp;
+
+	/* sorted, so stop at the first index that isn't smaller */
+	frr_each (if_index_rcu, &vrf->ifaces_rcu, ifp) {
+		ifindex_t idx = ifp->ifindex;
+
+		if (idx == ifindex)
+			return ifp;
+		if (idx > ifindex)
+			break;
+	}
+	return NULL;
+}
+
+struct interface *if_lookup_by_index_rcu(ifindex_t ifindex, vrf_id_t vrf_id)
+{
+	struct vrf *vrf;
+	struct interface *ifp;
+
+	rcu_assert_read_locked();
+
+	if (ifindex == IFINDEX_INTERNAL)
+		return NULL;
+
+	switch (vrf_get_backend()) {
+	case VRF_BACKEND_UNKNOWN:
+	case VRF_BACKEND_NETNS:
+		vrf = vrf_lookup_by_id_rcu(vrf_id);
+		return vrf ? if_lookup_by_ifindex_rcu(vrf, ifindex) : NULL;
+	case VRF_BACKEND_VRF_LITE:
+		for (vrf = vrf_first_rcu(); vrf; vrf = vrf_next_rcu(vrf)) {
+			ifp = if_lookup_by_ifindex_rcu(vrf, ifindex);
+			if (ifp)
+				return ifp;
+		}
+		return NULL;
+	}
+	return NULL;
+}
+
 /* Interface existance check by index. */
 struct interface *if_vrf_lookup_by_index_next(ifindex_t ifindex,
 					      vrf_id_t vrf_id)
@@ -465,32 +515,61 @@ struct interface *if_lookup_by_index_all_vrf(ifindex_t ifindex)
 	return NULL;
 }
 
+static void if_lookup_host_prefix(struct prefix *p, const void *addr,
+				  int family)
+{
+	memset(p, 0, sizeof(*p));
+	p->family = family;
+	if (family == AF_INET) {
+		p->u.prefix4 = *((struct in_addr *)addr);
+		p->prefixlen = IPV4_MAX_BITLEN;
+	} else if (family == AF_INET6) {
+		p->u.prefix6 = *((struct in6_addr *)addr);
+		p->prefixlen = IPV6_MAX_BITLEN;
+	}
+}
+
+static struct route_table *if_connected_index(struct vrf *vrf, int family,
+					      bool peer)
+{
+	afi_t afi = family2afi(family);
+
+	if (vrf == NULL || (afi != AFI_IP && afi != AFI_IP6))
+		return NULL;
+
+	return peer ? vrf->connected_by_peer[afi] : vrf->connected_by_addr[afi];
+}
+
 /* Lookup interface by IP address. */
 struct interface *if_lookup_exact_address(const void *src, int family,
 					  vrf_id_t vrf_id)
 {
-	struct vrf *vrf = vrf_lookup_by_id(vrf_id);
+	struct route_table *table;
+	struct route_node *rn;
 	struct listnode *cnode;
-	struct interface *ifp;
+	struct prefix addr;
 	struct prefix *p;
 	struct connected *c;
 
-	FOR_ALL_INTERFACES (vrf, ifp) {
-		for (ALL_LIST_ELEMENTS_RO(ifp->connected, cnode, c)) {
+	table = if_connected_index(vrf_lookup_by_id(vrf_id), family, false);
+	if (table == NULL)
+		return NULL;
+
+	/* An address is within its own prefix, look at all covering it */
+	if_lookup_host_prefix(&addr, src, family);
+	for (rn = route_node_match_unlocked(table, &addr); rn;
+	     rn = rn->parent) {
+		for (ALL_LIST_ELEMENTS_RO((struct list *)rn->info, cnode, c)) {
 			p = c->address;
 
-			if (p && (p->family == family)) {
-				if (family == AF_INET) {
-					if (IPV4_ADDR_SAME(
-						    &p->u.prefix4,
-						    (struct in_addr *)src))
-						return ifp;
-				} else if (family == AF_INET6) {
-					if (IPV6_ADDR_SAME(
-						    &p->u.prefix6,
-						    (struct in6_addr *)src))
-						return ifp;
-				}
+			if (family == AF_INET) {
+				if (IPV4_ADDR_SAME(&p->u.prefix4,
+						   (struct in_addr *)src))
+					return c->ifp;
+			} else if (family == AF_INET6) {
+				if (IPV6_ADDR_SAME(&p->u.prefix6,
+						   (struct in6_addr *)src))
+					return c->ifp;
 			}
 		}
 	}
@@ -502,34 +581,46 @@ struct connected *if_lookup_address(const void *matchaddr, int family,
 				    vrf_id_t vrf_id)
 {
 	struct vrf *vrf = vrf_lookup_by_id(vrf_id);
+	struct route_table *table;
+	struct route_node *rn;
 	struct prefix addr;
 	int bestlen = 0;
 	struct listnode *cnode;
-	struct interface *ifp;
 	struct connected *c;
 	struct connected *match;
+	bool peer;
 
-	if (family == AF_INET) {
-		addr.family = AF_INET;
-		addr.u.prefix4 = *((struct in_addr *)matchaddr);
-		addr.prefixlen = IPV4_MAX_BITLEN;
-	} else if (family == AF_INET6) {
-		addr.family = AF_INET6;
-		addr.u.prefix6 = *((struct in6_addr *)matchaddr);
-		addr.prefixlen = IPV6_MAX_BITLEN;
-	}
+	if_lookup_host_prefix(&addr, matchaddr, family);
 
 	match = NULL;
 
-	FOR_ALL_INTERFACES (vrf, ifp) {
-		for (ALL_LIST_ELEMENTS_RO(ifp->connected, cnode, c)) {
-			if (c->address && (c->address->family == AF_INET)
-			    && prefix_match(CONNECTED_PREFIX(c), &addr)
-			    && (c->address->prefixlen > bestlen)) {
-				bestlen = c->address->prefixlen;
-				match = c;
+	/*
+	 * The connected prefix is the peer's for addresses with one, so the
+	 * candidates are in one index or the other.
+	 */
+	for (peer = false; ; peer = true) {
+		table = if_connected_index(vrf, family, peer);
+		if (table)
+			rn = route_node_match_unlocked(table, &addr);
+		else
+			rn = NULL;
+
+		for (; rn; rn = rn->parent) {
+			for (ALL_LIST_ELEMENTS_RO((struct list *)rn->info,
+						  cnode, c)) {
+				if (CONNECTED_PEER(c) != peer)
+					continue;
+				if (c->address->prefixlen > bestlen
+				    && prefix_match(CONNECTED_PREFIX(c),
+						    &addr)) {
+					bestlen = c->address->prefixlen;
+					match = c;
+				}
 			}
 		}
+
+		if (peer)
+			break;
 	}
 	return match;
 }
@@ -537,18 +628,27 @@ struct connected *if_lookup_address(const void *matchaddr, int family,
 /* Lookup interface by prefix */
 struct interface *if_lookup_prefix(const struct prefix *prefix, vrf_id_t vrf_id)
 {
-	struct vrf *vrf = vrf_lookup_by_id(vrf_id);
+	struct route_table *table;
+	struct route_node *rn;
 	struct listnode *cnode;
-	struct interface *ifp;
 	struct connected *c;
 
-	FOR_ALL_INTERFACES (vrf, ifp) {
-		for (ALL_LIST_ELEMENTS_RO(ifp->connected, cnode, c)) {
-			if (prefix_cmp(c->address, prefix) == 0) {
-				return ifp;
-			}
+	table = if_connected_index(vrf_lookup_by_id(vrf_id), prefix->family,
+				   false);
+	if (table == NULL)
+		return NULL;
+
+	rn = route_node_lookup(table, prefix);
+	if (rn == NULL)
+		return NULL;
+
+	for (ALL_LIST_ELEMENTS_RO((struct list *)rn->info, cnode, c)) {
+		if (prefix_cmp(c->address, prefix) == 0) {
+			route_unlock_node(rn);
+			return c->ifp;
 		}
 	}
+	route_unlock_node(rn);
 	return NULL;
 }
 
@@ -839,6 +939,124 @@ void if_dump_all(void)
 			if_dump(ifp);
 }
 
+static void connected_index_node_add(struct route_table **table,
+				     const struct prefix *p,
+				     struct connected *ifc,
+				     struct route_node **rnp)
+{
+	struct route_node *rn;
+
+	if (*table == NULL)
+		*table = route_table_init();
+
+	/* The node stays locked as long as ifc is on its list */
+	rn = route_node_get(*table, p);
+	if (rn->info == NULL)
+		rn->info = list_new();
+	listnode_add(rn->info, ifc);
+	*rnp = rn;
+}
+
+static void connected_index_node_del(struct connected *ifc,
+				     struct route_node **rnp)
+{
+	struct route_node *rn = *rnp;
+	struct list *list;
+
+	if (rn == NULL)
+		return;
+
+	list = rn->info;
+	listnode_delete(list, ifc);
+	if (list->count == 0) {
+		list_delete(&list);
+		rn->info = NULL;
+	}
+	route_unlock_node(rn);
+	*rnp = NULL;
+}
+
+static void connected_index_add(struct vrf *vrf, struct connected *ifc)
+{
+	afi_t afi;
+
+	if (vrf == NULL || ifc->address == NULL || ifc->idx_addr)
+		return;
+
+	afi = family2afi(ifc->address->family);
+	if (afi != AFI_IP && afi != AFI_IP6)
+		return;
+
+	connected_index_node_add(&vrf->connected_by_addr[afi], ifc->address,
+				 ifc, &ifc->idx_addr);
+	if (CONNECTED_PEER(ifc) && ifc->destination
+	    && ifc->destination->family == ifc->address->family)
+		connected_index_node_add(&vrf->connected_by_peer[afi],
+					 ifc->destination, ifc,
+					 &ifc->idx_peer);
+}
+
+static void connected_index_del(struct connected *ifc)
+{
+	connected_index_node_del(ifc, &ifc->idx_addr);
+	connected_index_node_del(ifc, &ifc->idx_peer);
+}
+
+static void if_connected_index_update(struct interface *ifp,
+				      struct vrf *vrf)
+{
+	struct listnode *node;
+	struct connected *ifc;
+
+	for (ALL_LIST_ELEMENTS_RO(ifp->connected, node, ifc)) {
+		connected_index_del(ifc);
+		connected_index_add(vrf, ifc);
+	}
+}
+
+static void connected_index_table_finish(struct route_table **table)
+{
+	/* Nodes still in use belong to an address of some other interface */
+	if (*table == NULL || route_table_count(*table))
+		return;
+
+	route_table_finish(*table);
+	*table = NULL;
+}
+
+static void connected_index_finish(struct vrf *vrf)
+{
+	afi_t afi;
+
+	for (afi = AFI_IP; afi < AFI_MAX; afi++) {
+		connected_index_table_finish(&vrf->connected_by_addr[afi]);
+		connected_index_table_finish(&vrf->connected_by_peer[afi]);
+	}
+}
+
+/*
+ * Add ifc to the addresses of ifp, or remove it, which also keeps the
+ * VRF's connected address indices in step; ifc->address must be set.
+ */
+void if_connected_add(struct interface *ifp, struct connected *ifc)
+{
+	listnode_add(ifp->connected, ifc);
+	connected_index_add(vrf_lookup_by_id(ifp->vrf_id), ifc);
+}
+
+void if_connected_delete(struct interface *ifp, struct connected *ifc)
+{
+	listnode_delete(ifp->connected, ifc);
+	connected_index_del(ifc);
+}
+
+/* The address, peer or flags of ifc, one of ifp's addresses, changed. */
+void if_connected_update(struct interface *ifp, struct connected *ifc)
+{
+	connected_index_del(ifc);
+	connected_index_add(vrf_lookup_by_id(ifp->vrf_id), ifc);
+}
+
 /* Allocate connected structure. */
 struct connected *connected_new(void)
 {
@@ -856,6 +1074,8 @@ void connected_free(struct connected **connected)
 {
 	struct connected *ptr = *connected;
 
+	connected_index_del(ptr);
+
 	prefix_free(&ptr->address);
 	prefix_free(&ptr->destination);
 
@@ -990,7 +1210,7 @@ struct connected *connected_delete_by_prefix(struct interface *ifp,
 		next = node->next;
 
 		if (connected_same_prefix(ifc->address, p)) {
-			listnode_delete(ifp->connected, ifc);
+			if_connected_delete(ifp, ifc);
 			return ifc;
 		}
 	}
@@ -1039,7 +1259,7 @@ struct connected *connected_add_by_prefix(struct interface *ifp,
 	}
 
 	/* Add connected address to the interface. */
-	listnode_add(ifp->connected, ifc);
+	if_connected_add(ifp, ifc);
 	return ifc;
 }
 
@@ -1084,6 +1304,8 @@ void if_terminate(struct vrf *vrf)
 			if_update_to_new_vrf(ifp, VRF_DEFAULT);
 		}
 	}
+
+	connected_index_finish(vrf);
 }
 
 const char *if_link_type_str(enum zebra_link_type llt)
@@ -26,6 +26,7 @@
 #include "memory.h"
 #include "qobj.h"
 #include "hook.h"
+#include "frrcu.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -202,10 +203,16 @@ struct if_link_params {
 #define INTERFACE_LINK_PARAMS_SIZE   sizeof(struct if_link_params)
 #define HAS_LINK_PARAMS(ifp)  ((ifp)->link_params != NULL)
 
+PREDECL_ATOMSORT_UNIQ(if_index_rcu);
+
 /* Interface structure */
 struct interface {
 	RB_ENTRY(interface) name_entry, index_entry;
 
+	/* Copy of the index, for pthreads other than the main one */
+	struct if_index_rcu_item index_rcu_entry;
+	struct rcu_head rcu_head;
+
 	/* Interface name.  This should probably never be changed after the
 	   interface is created, because the configuration info for this
 	   interface
@@ -347,6 +354,8 @@ DECLARE_QOBJ_TYPE(interface);
 				"%s(%u): corruption detected -- interface with this " \
 				"ifindex exists already in VRF %u!",                  \
 				__func__, (ifp)->ifindex, (ifp)->vrf_id);             \
+		else                                                                  \
+			if_index_rcu_add(&vrf->ifaces_rcu, (ifp));                    \
 		_iz;                                                                  \
 	})
 
@@ -360,6 +369,8 @@ DECLARE_QOBJ_TYPE(interface);
 				"%s(%u): corruption detected -- interface with this " \
 				"ifindex doesn't exist in VRF %u!",                   \
 				__func__, (ifp)->ifindex, (ifp)->vrf_id);             \
+		else                                                                  \
+			if_index_rcu_del(&vrf->ifaces_rcu, (ifp));                    \
 		_iz;                                                                  \
 	})
 
@@ -436,6 +447,10 @@ struct connected {
 	 * "struct interface"
 	 */
 	uint32_t metric;
+
+	/* Where the address is in the VRF's connected address indices */
+	struct route_node *idx_addr;
+	struct route_node *idx_peer;
 };
 
 /* Nbr Connected address structure. */
@@ -519,6 +534,15 @@ extern struct interface *if_lookup_by_index(ifindex_t, vrf_id_t vrf_id);
 extern struct interface *if_vrf_lookup_by_index_next(ifindex_t ifindex,
 						     vrf_id_t vrf_id);
 extern struct interface *if_lookup_by_index_all_vrf(ifindex_t);
+
+/*
+ * Same as if_lookup_by_index(), for pthreads other than the main one.  Must
+ * be called under rcu_read_lock(); the interface stays allocated until
+ * rcu_read_unlock(), but only its ifindex and vrf_id may be relied on,
+ * everything else belongs to the main pthread.
+ */
+extern struct interface *if_lookup_by_index_rcu(ifindex_t ifindex,
+						vrf_id_t vrf_id);
 extern struct interface *if_lookup_exact_address(const void *matchaddr,
 						 int family, vrf_id_t vrf_id);
 extern struct connected *if_lookup_address(const void *matchaddr, int family,
@@ -580,6 +604,9 @@ extern void connected_free(struct connected **connected);
 extern void connected_add(struct interface *, struct connected *);
 extern struct connected *
 connected_add_by_prefix(struct interface *, struct prefix *, struct prefix *);
+extern void if_connected_add(struct interface *ifp, struct connected *ifc);
+extern void if_connected_delete(struct interface *ifp, struct connected *ifc);
+extern void if_connected_update(struct interface *ifp, struct connected *ifc);
 extern struct connected *connected_delete_by_prefix(struct interface *,
 						    struct prefix *);
 extern struct connected *connected_lookup_prefix(struct interface *,
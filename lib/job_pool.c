@@ -0,0 +1,264 @@
+/*
+ * Job pool on frr_pthreads, with work stealing.
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+
+#include "command.h"
+#include "frr_pthread.h"
+#include "frratomic.h"
+#include "job_pool.h"
+#include "memory.h"
+#include "typesafe.h"
+
+DEFINE_MTYPE_STATIC(LIB, JOB_POOL, "Job pool");
+DEFINE_MTYPE_STATIC(LIB, JOB, "Job pool job");
+
+PREDECL_DLIST(job_queue);
+PREDECL_DLIST(job_pools);
+
+struct job {
+	struct job_queue_item item;
+
+	struct thread_master *owner;
+	void (*run)(void *arg);
+	int (*done)(struct thread *);
+	void *arg;
+};
+
+struct job_worker {
+	struct job_pool *pool;
+	unsigned int idx;
+	struct frr_pthread *fpt;
+	struct thread *t_drain;
+
+	/* jobs not started yet, also taken by the other workers when idle */
+	pthread_mutex_t mtx;
+	struct job_queue_head queue;
+
+	/* for "show thread pool" */
+	_Atomic uint64_t run;
+	_Atomic uint64_t stolen;
+};
+
+struct job_pool {
+	struct job_pools_item item;
+
+	char *name;
+	struct job_worker *workers;
+	unsigned int size;
+	/* round robin position for job_pool_submit() */
+	unsigned int next;
+};
+
+DECLARE_DLIST(job_queue, struct job, item);
+DECLARE_DLIST(job_pools, struct job_pool, item);
+
+static pthread_mutex_t pools_mtx = PTHREAD_MUTEX_INITIALIZER;
+static struct job_pools_head pools = INIT_DLIST(pools);
+
+static struct job *job_pool_take(struct job_worker *w)
+{
+	struct job_pool *pool = w->pool;
+	struct job_worker *victim;
+	struct job *job;
+	unsigned int i;
+
+	frr_with_mutex(&w->mtx) {
+		job = job_queue_pop(&w->queue);
+	}
+	if (job)
+		return job;
+
+	for (i = 1; i < pool->size; i++) {
+		victim = &pool->workers[(w->idx + i) % pool->size];
+
+		frr_with_mutex(&victim->mtx) {
+			job = job_queue_pop(&victim->queue);
+		}
+		if (job) {
+			atomic_fetch_add_explicit(&w->stolen, 1,
+						  memory_order_relaxed);
+			return job;
+		}
+	}
+	return NULL;
+}
+
+static int job_pool_drain(struct thread *thread)
+{
+	struct job_worker *w = THREAD_ARG(thread);
+	struct job *job;
+
+	while ((job = job_pool_take(w))) {
+		job->run(job->arg);
+		thread_add_event(job->owner, job->done, job->arg, 0, NULL);
+		XFREE(MTYPE_JOB, job);
+
+		atomic_fetch_add_explicit(&w->run, 1, memory_order_relaxed);
+	}
+	return 0;
+}
+
+struct job_pool *job_pool_new(const char *name, const char *os_name,
+			      unsigned int nworkers)
+{
+	struct frr_pthread_attr attr = {
+		.start = frr_pthread_attr_default.start,
+		.stop = frr_pthread_attr_default.stop,
+	};
+	char tname[64], tos_name[OS_THREAD_NAMELEN];
+	struct job_pool *pool;
+	struct job_worker *w;
+	unsigned int i;
+
+	if (nworkers < 1)
+		nworkers = 1;
+	if (nworkers > JOB_POOL_WORKERS_MAX)
+		nworkers = JOB_POOL_WORKERS_MAX;
+
+	pool = XCALLOC(MTYPE_JOB_POOL, sizeof(*pool));
+	pool->name = XSTRDUP(MTYPE_JOB_POOL, name);
+	pool->workers =
+		XCALLOC(MTYPE_JOB_POOL, nworkers * sizeof(*pool->workers));
+	pool->size = nworkers;
+
+	for (i = 0; i < nworkers; i++) {
+		w = &pool->workers[i];
+		w->pool = pool;
+		w->idx = i;
+		pthread_mutex_init(&w->mtx, NULL);
+		job_queue_init(&w->queue);
+	}
+	for (i = 0; i < nworkers; i++) {
+		w = &pool->workers[i];
+		snprintf(tname, sizeof(tname), "%s %u", name, i);
+		snprintf(tos_name, sizeof(tos_name), "%s%u", os_name, i);
+		w->fpt = frr_pthread_new(&attr, tname, tos_name);
+		frr_pthread_run(w->fpt, NULL);
+	}
+	for (i = 0; i < nworkers; i++)
+		frr_pthread_wait_running(pool->workers[i].fpt);
+
+	frr_with_mutex(&pools_mtx) {
+		job_pools_add_tail(&pools, pool);
+	}
+	return pool;
+}
+
+void job_pool_free(struct job_pool **poolp)
+{
+	struct job_pool *pool = *poolp;
+	struct job_worker *w;
+	struct job *job;
+	unsigned int i;
+
+	if (!pool)
+		return;
+
+	frr_with_mutex(&pools_mtx) {
+		job_pools_del(&pools, pool);
+	}
+
+	/* workers steal from each other, so stop them all first */
+	for (i = 0; i < pool->size; i++)
+		frr_pthread_stop(pool->workers[i].fpt, NULL);
+
+	for (i = 0; i < pool->size; i++) {
+		w = &pool->workers[i];
+		frr_pthread_destroy(w->fpt);
+		while ((job = job_queue_pop(&w->queue)))
+			XFREE(MTYPE_JOB, job);
+		job_queue_fini(&w->queue);
+		pthread_mutex_destroy(&w->mtx);
+	}
+
+	XFREE(MTYPE_JOB_POOL, pool->workers);
+	XFREE(MTYPE_JOB_POOL, pool->name);
+	XFREE(MTYPE_JOB_POOL, pool);
+	*poolp = NULL;
+}
+
+unsigned int job_pool_size(const struct job_pool *pool)
+{
+	return pool->size;
+}
+
+void job_pool_submit(struct job_pool *pool, struct thread_master *owner,
+		     void (*run)(void *arg), int (*done)(struct thread *),
+		     void *arg)
+{
+	struct job_worker *w = &pool->workers[pool->next];
+	struct job *job;
+
+	pool->next = (pool->next + 1) % pool->size;
+
+	job = XCALLOC(MTYPE_JOB, sizeof(*job));
+	job->owner = owner;
+	job->run = run;
+	job->done = done;
+	job->arg = arg;
+
+	frr_with_mutex(&w->mtx) {
+		job_queue_add_tail(&w->queue, job);
+	}
+	thread_add_event(w->fpt->master, job_pool_drain, w, 0, &w->t_drain);
+}
+
+DEFUN_NOSH (show_thread_pool,
+	    show_thread_pool_cmd,
+	    "show thread pool",
+	    SHOW_STR
+	    "Thread information\n"
+	    "Job pools and their workers\n")
+{
+	struct job_pool *pool;
+	struct job_worker *w;
+	unsigned int i;
+	size_t queued;
+
+	frr_with_mutex(&pools_mtx) {
+		frr_each (job_pools, &pools, pool) {
+			vty_out(vty, "\nJob pool %s, %u workers\n", pool->name,
+				pool->size);
+			vty_out(vty, "%6s %8s %12s %12s\n", "Worker", "Queued",
+				"Run", "Stolen");
+
+			for (i = 0; i < pool->size; i++) {
+				w = &pool->workers[i];
+				frr_with_mutex(&w->mtx) {
+					queued = job_queue_count(&w->queue);
+				}
+				vty_out(vty, "%6u %8zu %12" PRIu64 " %12" PRIu64 "\n",
+					i, queued,
+					atomic_load_explicit(
+						&w->run, memory_order_relaxed),
+					atomic_load_explicit(
+						&w->stolen,
+						memory_order_relaxed));
+			}
+		}
+	}
+
+	return CMD_SUCCESS;
+}
+
+void job_pool_cmd_init(void)
+{
+	install_element(VIEW_NODE, &show_thread_pool_cmd);
+}
@@ -0,0 +1,63 @@
+/*
+ * Job pool on frr_pthreads, with work stealing.
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _FRR_JOB_POOL_H
+#define _FRR_JOB_POOL_H
+
+#include "thread.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define JOB_POOL_WORKERS_MAX 64
+
+/*
+ * A set of worker pthreads running independent jobs.  Each worker has its own
+ * queue of jobs, filled round robin by job_pool_submit(); a worker whose
+ * queue is empty takes jobs off the other workers' queues, so one long job
+ * doesn't hold up those queued behind it.
+ *
+ * A job's 'run' function is called on a worker pthread and must only touch
+ * what the submitter handed over to it.  Once it returns, 'done' is posted as
+ * an event onto the submitter's thread_master with the same argument, which
+ * is where the results are picked up (the "future" of the job).
+ *
+ * All functions are for the pthread owning the pool, usually the main one.
+ */
+struct job_pool;
+
+extern struct job_pool *job_pool_new(const char *name, const char *os_name,
+				     unsigned int nworkers);
+/* Jobs that haven't started are dropped, without their 'done' being posted */
+extern void job_pool_free(struct job_pool **pool);
+
+extern unsigned int job_pool_size(const struct job_pool *pool);
+
+extern void job_pool_submit(struct job_pool *pool, struct thread_master *owner,
+			    void (*run)(void *arg), int (*done)(struct thread *),
+			    void *arg);
+
+extern void job_pool_cmd_init(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FRR_JOB_POOL_H */
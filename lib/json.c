@@ -21,6 +21,7 @@
 #include <zebra.h>
 
 #include "command.h"
+#include "vty.h"
 #include "lib/json.h"
 
 /*
@@ -84,3 +85,120 @@ void json_object_free(struct json_object *obj)
 {
 	json_object_put(obj);
 }
+
+void json_stream_init(struct json_stream *js, struct vty *vty, int flags)
+{
+	memset(js, 0, sizeof(*js));
+	js->vty = vty;
+	js->flags = flags;
+	js->first[0] = true;
+}
+
+static void json_stream_escape(struct json_stream *js, const char *str)
+{
+	size_t len;
+
+	vty_out(js->vty, "\"");
+	while (*str) {
+		/* plain runs in one go, keys are rarely escaped at all */
+		for (len = 0; str[len] && str[len] != '"' && str[len] != '\\'
+			      && (unsigned char)str[len] >= 0x20;
+		     len++)
+			;
+		if (len)
+			vty_out(js->vty, "%.*s", (int)len, str);
+		str += len;
+		if (!*str)
+			break;
+
+		if (*str == '"' || *str == '\\')
+			vty_out(js->vty, "\\%c", *str);
+		else
+			vty_out(js->vty, "\\u%04x", (unsigned char)*str);
+		str++;
+	}
+	vty_out(js->vty, "\"");
+}
+
+/* separator and key of the next member */
+static void json_stream_member(struct json_stream *js, const char *key)
+{
+	if (!js->first[js->depth])
+		vty_out(js->vty, ",");
+	js->first[js->depth] = false;
+
+	if (key) {
+		json_stream_escape(js, key);
+		vty_out(js->vty, ": ");
+	}
+}
+
+static void json_stream_open(struct json_stream *js, const char *key,
+			     bool array)
+{
+	assert(js->depth + 1 < JSON_STREAM_DEPTH);
+
+	json_stream_member(js, key);
+	vty_out(js->vty, "%s", array ? "[" : "{");
+	js->depth++;
+	js->first[js->depth] = true;
+	js->array[js->depth] = array;
+}
+
+void json_stream_object_open(struct json_stream *js, const char *key)
+{
+	json_stream_open(js, key, false);
+}
+
+void json_stream_array_open(struct json_stream *js, const char *key)
+{
+	json_stream_open(js, key, true);
+}
+
+void json_stream_close(struct json_stream *js)
+{
+	assert(js->depth > 0);
+
+	vty_out(js->vty, "%s", js->array[js->depth] ? "]" : "}");
+	js->depth--;
+	if (!js->depth)
+		vty_out(js->vty, "\n");
+}
+
+void json_stream_add(struct json_stream *js, const char *key,
+		     struct json_object *obj)
+{
+	json_stream_member(js, key);
+	vty_out(js->vty, "%s",
+		json_object_to_json_string_ext(obj, js->flags));
+	json_object_free(obj);
+}
+
+void json_stream_add_string(struct json_stream *js, const char *key,
+			    const char *val)
+{
+	json_stream_member(js, key);
+	json_stream_escape(js, val);
+}
+
+void json_stream_add_int(struct json_stream *js, const char *key, int64_t val)
+{
+	json_stream_member(js, key);
+	vty_out(js->vty, "%" PRId64, val);
+}
+
+void json_stream_enter(struct json_stream *js)
+{
+	assert(js->depth + 1 < JSON_STREAM_DEPTH);
+
+	js->depth++;
+	js->first[js->depth] = true;
+	js->array[js->depth] = false;
+}
+
+void json_stream_leave(struct json_stream *js)
+{
+	assert(js->depth > 0);
+
+	js->depth--;
+}
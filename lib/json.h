@@ -61,6 +61,48 @@ extern void json_array_string_add(json_object *json, const char *str);
 
 #define JSON_STR "JavaScript Object Notation\n"
 
+/*
+ * Writes a JSON document to a vty piece by piece, so that show commands
+ * with huge output need not build the whole json-c tree first.  Containers
+ * are opened and closed on the stream; the members are either scalars or
+ * small json-c objects that are serialized and freed right away.
+ *
+ * Keys are NULL for array elements and for the top level value.
+ */
+#define JSON_STREAM_DEPTH 16
+
+struct vty;
+struct json_stream {
+	struct vty *vty;
+	/* JSON_C_TO_STRING_* flags for json_stream_add() */
+	int flags;
+	unsigned int depth;
+	/* nothing written into the container at that depth yet */
+	bool first[JSON_STREAM_DEPTH];
+	bool array[JSON_STREAM_DEPTH];
+};
+
+extern void json_stream_init(struct json_stream *js, struct vty *vty,
+			     int flags);
+extern void json_stream_object_open(struct json_stream *js, const char *key);
+extern void json_stream_array_open(struct json_stream *js, const char *key);
+/* closes the innermost container, the document ends with a newline */
+extern void json_stream_close(struct json_stream *js);
+/* takes over the reference to obj */
+extern void json_stream_add(struct json_stream *js, const char *key,
+			    struct json_object *obj);
+extern void json_stream_add_string(struct json_stream *js, const char *key,
+				   const char *val);
+extern void json_stream_add_int(struct json_stream *js, const char *key,
+				int64_t val);
+
+/*
+ * For callers that print the start and end of a container themselves:
+ * members written between enter and leave go into that container.
+ */
+extern void json_stream_enter(struct json_stream *js);
+extern void json_stream_leave(struct json_stream *js);
+
 /* NOTE: json-c lib has following commit 316da85 which
  * handles escape of forward slash.
  * This allows prefix  "20.0.14.0\/24":{
@@ -98,13 +98,16 @@ static int qmem_walker(void *arg, struct memgroup *mg, struct memtype *mt)
 #endif
 			);
 	} else {
-		if (mt->n_max != 0) {
+		struct mtype_stats st;
+
+		mtype_stats(mt, &st);
+		if (st.n_max != 0) {
 			char size[32];
-			snprintf(size, sizeof(size), "%6zu", mt->size);
+			snprintf(size, sizeof(size), "%6zu", st.size);
 #ifdef HAVE_MALLOC_USABLE_SIZE
 #define TSTR " %9zu"
-#define TARG , mt->total
-#define TARG2 , mt->max_size
+#define TARG , st.total
+#define TARG2 , st.max_size
 #else
 #define TSTR ""
 #define TARG
@@ -112,19 +115,46 @@ static int qmem_walker(void *arg, struct memgroup *mg, struct memtype *mt)
 #endif
 			vty_out(vty, "%-30s: %8zu %-8s"TSTR" %8zu"TSTR"\n",
 				mt->name,
-				mt->n_alloc,
-				mt->size == 0 ? ""
-					      : mt->size == SIZE_VAR
+				st.n_alloc,
+				st.size == 0 ? ""
+					     : st.size == SIZE_VAR
 							? "variable"
 							: size
 				TARG,
-				mt->n_max
+				st.n_max
 				TARG2);
 		}
 	}
 	return 0;
 }
 
+struct qmem_slab_walk {
+	struct vty *vty;
+	bool header;
+};
+
+static int qmem_slab_walker(void *arg, struct memgroup *mg,
+			    struct memtype *mt)
+{
+	struct qmem_slab_walk *walk = arg;
+	struct vty *vty = walk->vty;
+	struct mtype_slab_stats st;
+
+	if (!mt || !mtype_slab_stats(mt, &st))
+		return 0;
+
+	if (!walk->header) {
+		vty_out(vty, "--- qmem slab pools ---\n");
+		vty_out(vty, "%-30s: %6s %8s %8s %10s %10s\n", "Type", "Size",
+			"Chunks", "Huge", "Used#", "Free#");
+		walk->header = true;
+	}
+	vty_out(vty, "%-30s: %6zu %8zu %8zu %10zu %10zu\n", mt->name,
+		st.objsize, st.n_chunks, st.n_huge, st.n_used,
+		st.n_chunks * st.per_chunk - st.n_used);
+	return 0;
+}
+
 
 DEFUN_NOSH (show_memory,
 	    show_memory_cmd,
@@ -137,6 +167,21 @@ DEFUN_NOSH (show_memory,
 #endif /* HAVE_MALLINFO */
 
 	qmem_walk(qmem_walker, vty);
+
+	struct qmem_slab_walk slab_walk = {.vty = vty};
+
+	qmem_walk(qmem_slab_walker, &slab_walk);
+
+	struct mtype_hugepages_stats hst;
+	char buf[MTYPE_MEMSTR_LEN], fbuf[MTYPE_MEMSTR_LEN];
+
+	mtype_hugepages_stats(&hst);
+	if (hst.mapped)
+		vty_out(vty, "Huge page arena (%s): %s mapped, %s free\n",
+			hst.mode == MTYPE_HUGEPAGES_EXPLICIT ? "explicit"
+							     : "transparent",
+			mtype_memstr(buf, sizeof(buf), hst.mapped),
+			mtype_memstr(fbuf, sizeof(fbuf), hst.free));
 	return CMD_SUCCESS;
 }
 
@@ -41,7 +41,9 @@
 #include "northbound_db.h"
 #include "debug.h"
 #include "frrcu.h"
+#include "stream.h"
 #include "frr_pthread.h"
+#include "heartbeat.h"
 #include "defaults.h"
 #include "frrscript.h"
 #include "systemd.h"
@@ -71,6 +73,14 @@ static char dbfile_default[512];
 #endif
 static char vtypath_default[512];
 
+/* how long it takes until the daemon has read its configuration, logged
+ * once that is done
+ */
+static struct {
+	struct timeval begin;
+	int64_t yang_us;
+} frr_startup;
+
 /* cleared in frr_preinit(), then re-set after daemonizing */
 bool frr_is_after_fork = true;
 bool debug_memstats_at_exit = false;
@@ -108,6 +118,9 @@ static void opt_extend(const struct optspec *os)
 #define OPTION_LOGGING   1007
 #define OPTION_LIMIT_FDS 1008
 #define OPTION_SCRIPTDIR 1009
+#define OPTION_IO_BACKEND 1010
+#define OPTION_NB_WORKERS 1011
+#define OPTION_HUGEPAGES 1012
 
 static const struct option lo_always[] = {
 	{"help", no_argument, NULL, 'h'},
@@ -124,6 +137,9 @@ static const struct option lo_always[] = {
 	{"tcli", no_argument, NULL, OPTION_TCLI},
 	{"command-log-always", no_argument, NULL, OPTION_LOGGING},
 	{"limit-fds", required_argument, NULL, OPTION_LIMIT_FDS},
+	{"io-backend", required_argument, NULL, OPTION_IO_BACKEND},
+	{"nb-workers", required_argument, NULL, OPTION_NB_WORKERS},
+	{"hugepages", required_argument, NULL, OPTION_HUGEPAGES},
 	{NULL}};
 static const struct optspec os_always = {
 	"hvdM:F:N:",
@@ -139,7 +155,10 @@ static const struct optspec os_always = {
 	"      --log          Set Logging to stdout, syslog, or file:<name>\n"
 	"      --log-level    Set Logging Level to use, debug, info, warn, etc\n"
 	"      --tcli         Use transaction-based CLI\n"
-	"      --limit-fds    Limit number of fds supported\n",
+	"      --limit-fds    Limit number of fds supported\n"
+	"      --io-backend   I/O multiplexer to use: poll, epoll or kqueue\n"
+	"      --nb-workers   Number of pthreads validating configuration changes\n"
+	"      --hugepages    Put routing tables on transparent or explicit huge pages\n",
 	lo_always};
 
 
@@ -312,6 +331,7 @@ void frr_preinit(struct frr_daemon_info *daemon, int argc, char **argv)
 {
 	di = daemon;
 	frr_is_after_fork = false;
+	monotime(&frr_startup.begin);
 
 	/* basename(), opencoded. */
 	char *p = strrchr(argv[0], '/');
@@ -604,6 +624,30 @@ static int frr_opt(int opt)
 	case OPTION_LIMIT_FDS:
 		di->limit_fds = strtoul(optarg, &err, 0);
 		break;
+	case OPTION_IO_BACKEND:
+		di->io_backend = optarg;
+		break;
+	case OPTION_NB_WORKERS:
+		di->nb_workers = strtoul(optarg, &err, 0);
+		if (*err || !*optarg || di->nb_workers > NB_WORKERS_MAX) {
+			fprintf(stderr,
+				"invalid number \"%s\" for --nb-workers option (0-%u)\n",
+				optarg, NB_WORKERS_MAX);
+			errors++;
+		}
+		break;
+	case OPTION_HUGEPAGES:
+		if (!strcmp(optarg, "transparent"))
+			mtype_hugepages_set(MTYPE_HUGEPAGES_TRANSPARENT);
+		else if (!strcmp(optarg, "explicit"))
+			mtype_hugepages_set(MTYPE_HUGEPAGES_EXPLICIT);
+		else {
+			fprintf(stderr,
+				"invalid value \"%s\" for --hugepages option (transparent or explicit)\n",
+				optarg);
+			errors++;
+		}
+		break;
 	default:
 		return 1;
 	}
@@ -771,7 +815,11 @@ struct thread_master *frr_init(void)
 	log_ref_vty_init();
 	lib_error_init();
 
+	struct timeval yang_begin;
+
+	monotime(&yang_begin);
 	nb_init(master, di->yang_modules, di->n_yang_modules, true);
+	frr_startup.yang_us = monotime_since(&yang_begin, NULL);
 	if (nb_db_init() != NB_OK)
 		flog_warn(EC_LIB_NB_DATABASE,
 			  "%s: failed to initialize northbound database",
@@ -797,6 +845,11 @@ uint32_t frr_get_fd_limit(void)
 	return di ? di->limit_fds : 0;
 }
 
+const char *frr_get_io_backend(void)
+{
+	return di ? di->io_backend : NULL;
+}
+
 static int rcvd_signal = 0;
 
 static void rcv_signal(int signum)
@@ -939,6 +992,9 @@ static void frr_daemonize(void)
  */
 static int frr_config_read_in(struct thread *t)
 {
+	struct timeval config_begin;
+
+	monotime(&config_begin);
 	hook_call(frr_config_pre, master);
 
 	if (!vty_read_config(vty_shared_candidate_config, di->config_file,
@@ -976,6 +1032,12 @@ static int frr_config_read_in(struct thread *t)
 
 	hook_call(frr_config_post, master);
 
+	zlog_info("%s started up in %" PRId64 " ms: %" PRId64
+		  " ms loading %zu YANG modules, %" PRId64
+		  " ms reading the configuration",
+		  di->name, monotime_since(&frr_startup.begin, NULL) / 1000,
+		  frr_startup.yang_us / 1000, di->n_yang_modules,
+		  monotime_since(&config_begin, NULL) / 1000);
 	return 0;
 }
 
@@ -999,12 +1061,28 @@ void frr_config_fork(void)
 
 	frr_is_after_fork = true;
 
+	/* pthreads don't survive the fork above */
+	nb_workers_set(di->nb_workers);
+
 	if (!di->pid_file)
 		di->pid_file = pidfile_default;
 	pid_output(di->pid_file);
 	zlog_tls_buffer_init();
 }
 
+/* "<daemon>.vty" -> "<daemon>.hb" */
+static void frr_vty_heartbeat_init(void)
+{
+	char path[512];
+	size_t len = strlen(di->vty_path);
+
+	if (len > 4 && !strcmp(di->vty_path + len - 4, ".vty"))
+		len -= 4;
+	snprintf(path, sizeof(path), "%.*s%s", (int)len, di->vty_path,
+		 FRR_HEARTBEAT_SUFFIX);
+	frr_heartbeat_init(path);
+}
+
 static void frr_vty_serv(void)
 {
 	/* allow explicit override of vty_path in the future
@@ -1027,6 +1105,9 @@ static void frr_vty_serv(void)
 		di->vty_path = vtypath_default;
 	}
 
+	/* before the vty socket, watchfrr looks for it once connected */
+	frr_vty_heartbeat_init();
+
 	vty_serv_sock(di->vty_addr, di->vty_port, di->vty_path);
 }
 
@@ -1157,8 +1238,11 @@ void frr_run(struct thread_master *master)
 	zlog_startup_end();
 
 	struct thread thread;
-	while (thread_fetch(master, &thread))
+	while (thread_fetch(master, &thread)) {
+		frr_heartbeat_task_start();
 		thread_call(&thread);
+		frr_heartbeat_task_end(&master->last_getrusage.real);
+	}
 }
 
 void frr_early_fini(void)
@@ -1174,6 +1258,7 @@ void frr_fini(void)
 
 	hook_call(frr_fini);
 
+	frr_heartbeat_fini();
 	vty_terminate();
 	cmd_terminate();
 	nb_terminate();
@@ -1191,6 +1276,7 @@ void frr_fini(void)
 	zlog_fini();
 	/* frrmod_init -> nothing needed / hooks */
 	rcu_shutdown();
+	stream_pool_finish();
 
 	if (!debug_memstats_at_exit)
 		return;
@@ -106,6 +106,12 @@ struct frr_daemon_info {
 
 	/* Optional upper limit on the number of fds used in select/poll */
 	uint32_t limit_fds;
+
+	/* Optional I/O multiplexer override (poll, epoll, kqueue) */
+	const char *io_backend;
+
+	/* Number of northbound worker pthreads */
+	uint32_t nb_workers;
 };
 
 /* execname is the daemon's executable (and pidfile and configfile) name,
@@ -139,6 +145,7 @@ extern struct thread_master *frr_init(void);
 extern const char *frr_get_progname(void);
 extern enum frr_cli_mode frr_get_cli_mode(void);
 extern uint32_t frr_get_fd_limit(void);
+extern const char *frr_get_io_backend(void);
 extern bool frr_is_startup_fd(int fd);
 
 /* call order of these hooks is as ordered here */
@@ -38,6 +38,7 @@
 #include "memory.h"
 #include "linklist.h"
 #include "table.h"
+#include "zclient.h"
 
 /* clang-format off */
 
@@ -230,6 +231,48 @@ TRACEPOINT_EVENT(
 	)
 )
 
+/* A route is sent to zebra; the other end is frr_zebra:zapi_route_* */
+TRACEPOINT_EVENT(
+	frr_libfrr,
+	zclient_route_send,
+	TP_ARGS(
+		uint8_t, cmd, struct zapi_route *, api
+	),
+	TP_FIELDS(
+		ctf_string(command, zserv_command_string(cmd))
+		ctf_string(type, zebra_route_string(api->type))
+		ctf_integer(unsigned short, instance, api->instance)
+		ctf_integer(vrf_id_t, vrf_id, api->vrf_id)
+		ctf_integer(uint8_t, family, api->prefix.family)
+		ctf_integer(uint16_t, prefixlen, api->prefix.prefixlen)
+		ctf_array(unsigned char, prefix, &api->prefix.u.prefix, 16)
+	)
+)
+
+TRACEPOINT_LOGLEVEL(frr_libfrr, zclient_route_send, TRACE_INFO)
+
+/* A sampled prefix reached a stage, see lib/convergence.h */
+TRACEPOINT_EVENT(
+	frr_libfrr,
+	conv_stage,
+	TP_ARGS(
+		const char *, sampler, const char *, stage, vrf_id_t, vrf_id,
+		const struct prefix *, p, int64_t, total, int64_t, step
+	),
+	TP_FIELDS(
+		ctf_string(sampler, sampler)
+		ctf_string(stage, stage)
+		ctf_integer(vrf_id_t, vrf_id, vrf_id)
+		ctf_integer(uint8_t, family, p->family)
+		ctf_integer(uint16_t, prefixlen, p->prefixlen)
+		ctf_array(unsigned char, prefix, &p->u.prefix, 16)
+		ctf_integer(int64_t, total_usec, total)
+		ctf_integer(int64_t, step_usec, step)
+	)
+)
+
+TRACEPOINT_LOGLEVEL(frr_libfrr, conv_stage, TRACE_INFO)
+
 /* clang-format on */
 
 #include <lttng/tracepoint-event.h>
@@ -808,7 +808,7 @@ struct ls_ted *ls_ted_new(const uint32_t key, const char *name,
 	new->as_number = as_number;
 	strlcpy(new->name, name, MAX_NAME_LENGTH);
 
-	/* Initialize the various RB tree */
+	/* Initialize the various B+trees */
 	vertices_init(&new->vertices);
 	edges_init(&new->edges);
 	subnets_init(&new->subnets);
@@ -826,7 +826,7 @@ void ls_ted_del(struct ls_ted *ted)
 	    || subnets_count(&ted->subnets))
 		return;
 
-	/* Release RB Tree */
+	/* Release B+trees */
 	vertices_fini(&ted->vertices);
 	edges_fini(&ted->edges);
 	subnets_fini(&ted->subnets);
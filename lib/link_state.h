@@ -363,11 +363,11 @@ enum ls_status { UNSET = 0, NEW, UPDATE, DELETE, SYNC, ORPHAN };
 enum ls_type { GENERIC = 0, VERTEX, EDGE, SUBNET };
 
 /* Link State Vertex structure */
-PREDECL_RBTREE_UNIQ(vertices);
+PREDECL_BPTREE_UNIQ(vertices);
 struct ls_vertex {
 	enum ls_type type;		/* Link State Type */
 	enum ls_status status;		/* Status of the Vertex in the TED */
-	struct vertices_item entry;	/* Entry in RB Tree */
+	struct vertices_item entry;	/* Entry in B+tree */
 	uint64_t key;			/* Unique Key identifier */
 	struct ls_node *node;		/* Link State Node */
 	struct list *incoming_edges;	/* List of incoming Link State links */
@@ -376,11 +376,11 @@ struct ls_vertex {
 };
 
 /* Link State Edge structure */
-PREDECL_RBTREE_UNIQ(edges);
+PREDECL_BPTREE_UNIQ(edges);
 struct ls_edge {
 	enum ls_type type;		/* Link State Type */
 	enum ls_status status;		/* Status of the Edge in the TED */
-	struct edges_item entry;	/* Entry in RB tree */
+	struct edges_item entry;	/* Entry in B+tree */
 	uint64_t key;			/* Unique Key identifier */
 	struct ls_attributes *attributes;	/* Link State attributes */
 	struct ls_vertex *source;	/* Pointer to the source Vertex */
@@ -388,37 +388,37 @@ struct ls_edge {
 };
 
 /* Link State Subnet structure */
-PREDECL_RBTREE_UNIQ(subnets);
+PREDECL_BPTREE_UNIQ(subnets);
 struct ls_subnet {
 	enum ls_type type;		/* Link State Type */
 	enum ls_status status;		/* Status of the Subnet in the TED */
-	struct subnets_item entry;	/* Entry in RB tree */
+	struct subnets_item entry;	/* Entry in B+tree */
 	struct prefix key;		/* Unique Key identifier */
 	struct ls_prefix *ls_pref;	/* Link State Prefix */
 	struct ls_vertex *vertex;	/* Back pointer to the Vertex owner */
 };
 
-/* Declaration of Vertices, Edges and Prefixes RB Trees */
+/* Declaration of Vertices, Edges and Prefixes B+trees */
 macro_inline int vertex_cmp(const struct ls_vertex *node1,
 			    const struct ls_vertex *node2)
 {
 	return (node1->key - node2->key);
 }
-DECLARE_RBTREE_UNIQ(vertices, struct ls_vertex, entry, vertex_cmp);
+DECLARE_BPTREE_UNIQ(vertices, struct ls_vertex, entry, vertex_cmp);
 
 macro_inline int edge_cmp(const struct ls_edge *edge1,
 			  const struct ls_edge *edge2)
 {
 	return (edge1->key - edge2->key);
 }
-DECLARE_RBTREE_UNIQ(edges, struct ls_edge, entry, edge_cmp);
+DECLARE_BPTREE_UNIQ(edges, struct ls_edge, entry, edge_cmp);
 
 macro_inline int subnet_cmp(const struct ls_subnet *a,
 			     const struct ls_subnet *b)
 {
 	return prefix_cmp(&a->key, &b->key);
 }
-DECLARE_RBTREE_UNIQ(subnets, struct ls_subnet, entry, subnet_cmp);
+DECLARE_BPTREE_UNIQ(subnets, struct ls_subnet, entry, subnet_cmp);
 
 /* Link State TED Structure */
 struct ls_ted {
@@ -464,7 +464,12 @@ static const struct zebra_desc_table command_types[] = {
 	DESC_ENTRY(ZEBRA_CONFIGURE_ARP),
 	DESC_ENTRY(ZEBRA_GRE_GET),
 	DESC_ENTRY(ZEBRA_GRE_UPDATE),
-	DESC_ENTRY(ZEBRA_GRE_SOURCE_SET)};
+	DESC_ENTRY(ZEBRA_GRE_SOURCE_SET),
+	DESC_ENTRY(ZEBRA_ROUTE_ADD_BULK),
+	DESC_ENTRY(ZEBRA_ROUTE_NOTIFY_OWNER_BULK),
+	DESC_ENTRY(ZEBRA_SHM_RING_SETUP),
+	DESC_ENTRY(ZEBRA_SHM_RING_KICK),
+	DESC_ENTRY(ZEBRA_MPLS_LABELS_BULK)};
 #undef DESC_ENTRY
 
 static const struct zebra_desc_table unknown = {0, "unknown", '?'};
@@ -24,6 +24,7 @@
 #include "command.h"
 #include "lib/log.h"
 #include "lib/zlog_targets.h"
+#include "lib/zlog_binary.h"
 #include "lib/lib_errors.h"
 #include "lib/printfrr.h"
 
@@ -57,6 +58,10 @@ static struct zlog_cfg_filterfile zt_filterfile = {
 		.prio_min = ZLOG_DISABLED,
 	},
 };
+static struct zlog_cfg_bin zt_bin;
+
+/* in MB */
+#define LOG_BINFILE_SIZE_DEFAULT 16
 
 const char *zlog_progname;
 static const char *zlog_protoname;
@@ -184,6 +189,12 @@ DEFUN_NOSH (show_logging,
 			zlog_priority[zt_filterfile.parent.prio_min],
 			zt_filterfile.parent.filename);
 
+	if (zt_bin.prio_min != ZLOG_DISABLED && zt_bin.filename)
+		vty_out(vty,
+			"Binary file logging: level %s, filename %s, size %zuMB\n",
+			zlog_priority[zt_bin.prio_min], zt_bin.filename,
+			zt_bin.size >> 20);
+
 	if (log_cmdline_syslog_lvl != ZLOG_DISABLED)
 		vty_out(vty,
 			"From command line: \"--log syslog --log-level %s\"\n",
@@ -202,6 +213,9 @@ DEFUN_NOSH (show_logging,
 	vty_out(vty, "Record priority: %s\n",
 		(zt_file.record_priority ? "enabled" : "disabled"));
 	vty_out(vty, "Timestamp precision: %d\n", zt_file.ts_subsec);
+	vty_out(vty, "Asynchronous writer: %s, %zu messages dropped\n",
+		zlog_async_get() ? "enabled" : "disabled",
+		zlog_async_dropped());
 
 	hook_call(zlog_cli_show, vty);
 	return CMD_SUCCESS;
@@ -596,6 +610,56 @@ DEFUN (no_config_log_filterfile,
 	return CMD_SUCCESS;
 }
 
+DEFPY (config_log_binfile,
+       config_log_binfile_cmd,
+       "log binary-file FILENAME [size (1-1024)$size_mb] [<emergencies|alerts|critical|errors|warnings|notifications|informational|debugging>$levelarg]",
+       "Logging control\n"
+       "Logging to a binary ring file, for tools/frr-zlog-decode.py\n"
+       "Logging filename\n"
+       "Size of the ring\n"
+       "Size in megabytes\n"
+       LOG_LEVEL_DESC)
+{
+	size_t ring_size;
+	int level = log_default_lvl;
+
+	if (levelarg) {
+		level = log_level_match(levelarg);
+		if (level == ZLOG_DISABLED)
+			return CMD_ERR_NO_MATCH;
+	}
+	ring_size = (size_t)(size_mb ? size_mb : LOG_BINFILE_SIZE_DEFAULT) << 20;
+
+	zt_bin.prio_min = level;
+	/* a new ring only if needed, that moves the old one to .prev */
+	if (zt_bin.filename && !strcmp(zt_bin.filename, filename)
+	    && zt_bin.size == ring_size) {
+		zlog_bin_set_other(&zt_bin);
+		return CMD_SUCCESS;
+	}
+	if (!zlog_bin_set_filename(&zt_bin, filename, ring_size)) {
+		vty_out(vty, "can't open binary logfile %s\n", filename);
+		return CMD_WARNING_CONFIG_FAILED;
+	}
+	return CMD_SUCCESS;
+}
+
+DEFUN (no_config_log_binfile,
+       no_config_log_binfile_cmd,
+       "no log binary-file [FILENAME [size (1-1024)] [LEVEL]]",
+       NO_STR
+       "Logging control\n"
+       "Cancel logging to a binary ring file\n"
+       "Logging file name\n"
+       "Size of the ring\n"
+       "Size in megabytes\n"
+       "Logging level\n")
+{
+	zt_bin.prio_min = ZLOG_DISABLED;
+	zlog_bin_set_filename(&zt_bin, NULL, 0);
+	return CMD_SUCCESS;
+}
+
 DEFPY (log_filter,
        log_filter_cmd,
        "[no] log filter-text WORD$filter",
@@ -672,6 +736,17 @@ DEFPY (log_immediate_mode,
 	return CMD_SUCCESS;
 }
 
+DEFPY (config_log_async,
+       config_log_async_cmd,
+       "[no] log asynchronous",
+       NO_STR
+       "Logging control\n"
+       "Write to files and syslog from a separate pthread\n")
+{
+	zlog_async_set(!no);
+	return CMD_SUCCESS;
+}
+
 void log_config_write(struct vty *vty)
 {
 	bool show_cmdline_hint = false;
@@ -695,6 +770,16 @@ void log_config_write(struct vty *vty)
 		vty_out(vty, "\n");
 	}
 
+	if (zt_bin.prio_min != ZLOG_DISABLED && zt_bin.filename) {
+		vty_out(vty, "log binary-file %s", zt_bin.filename);
+
+		if (zt_bin.size != LOG_BINFILE_SIZE_DEFAULT << 20)
+			vty_out(vty, " size %zu", zt_bin.size >> 20);
+		if (zt_bin.prio_min != log_default_lvl)
+			vty_out(vty, " %s", zlog_priority[zt_bin.prio_min]);
+		vty_out(vty, "\n");
+	}
+
 	if (log_config_stdout_lvl != ZLOG_DISABLED) {
 		vty_out(vty, "log stdout");
 
@@ -751,6 +836,8 @@ void log_config_write(struct vty *vty)
 		vty_out(vty, "no log error-category\n");
 	if (!zlog_get_prefix_xid())
 		vty_out(vty, "no log unique-id\n");
+	if (zlog_async_get())
+		vty_out(vty, "log asynchronous\n");
 }
 
 static int log_vty_init(const char *progname, const char *protoname,
@@ -763,6 +850,7 @@ static int log_vty_init(const char *progname, const char *protoname,
 	zlog_set_prefix_xid(true);
 
 	zlog_filterfile_init(&zt_filterfile);
+	zlog_bin_init(&zt_bin);
 
 	zlog_file_set_fd(&zt_stdout, STDOUT_FILENO);
 	return 0;
@@ -800,5 +888,8 @@ void log_cmd_init(void)
 	install_element(CONFIG_NODE, &log_filter_clear_cmd);
 	install_element(CONFIG_NODE, &config_log_filterfile_cmd);
 	install_element(CONFIG_NODE, &no_config_log_filterfile_cmd);
+	install_element(CONFIG_NODE, &config_log_binfile_cmd);
+	install_element(CONFIG_NODE, &no_config_log_binfile_cmd);
 	install_element(CONFIG_NODE, &log_immediate_mode_cmd);
+	install_element(CONFIG_NODE, &config_log_async_cmd);
 }
@@ -17,6 +17,7 @@
 #include <zebra.h>
 
 #include <stdlib.h>
+#include <pthread.h>
 #ifdef HAVE_MALLOC_H
 #include <malloc.h>
 #endif
@@ -26,6 +27,7 @@
 #ifdef HAVE_MALLOC_MALLOC_H
 #include <malloc/malloc.h>
 #endif
+#include <sys/mman.h>
 
 #include "memory.h"
 #include "log.h"
@@ -38,22 +40,591 @@ DEFINE_MGROUP(LIB, "libfrr");
 DEFINE_MTYPE(LIB, TMP, "Temporary memory");
 DEFINE_MTYPE(LIB, BITFIELD, "Bitfield memory");
 
-static inline void mt_count_alloc(struct memtype *mt, size_t size, void *ptr)
+/* slab chunks are aligned to their size so XFREE can find the header */
+#define MEMSLAB_CHUNK_SIZE (64 * 1024)
+#define MEMSLAB_ALIGN 16
+
+struct memslab_chunk {
+	/* on slab->partial while it has free objects */
+	struct memslab_chunk *next, *prev;
+	struct memslab *slab;
+
+	/* objects that were handed out and freed again */
+	void *freelist;
+	/* everything from here on was never handed out */
+	char *fresh;
+	size_t n_used;
+	/* carved out of the huge page arena rather than posix_memalign()ed */
+	bool huge;
+};
+
+struct memslab {
+	pthread_mutex_t mtx;
+	size_t objsize;
+	size_t per_chunk;
+
+	struct memslab_chunk *partial;
+	/* one empty chunk is kept to avoid thrashing on alloc/free cycles */
+	struct memslab_chunk *spare;
+	size_t n_chunks;
+	size_t n_used;
+
+	/* set by mtype_slab_hugepages() */
+	bool want_huge;
+	size_t n_huge;
+};
+
+#define MEMSLAB_HDR_SIZE                                                       \
+	((sizeof(struct memslab_chunk) + MEMSLAB_ALIGN - 1)                    \
+	 & ~(size_t)(MEMSLAB_ALIGN - 1))
+
+/* huge page arena
+ *
+ * Slabs of memtypes marked with mtype_slab_hugepages() take their chunks
+ * from 2M regions backed by huge pages, so that walking millions of their
+ * objects needs a fraction of the TLB entries.  Regions are never unmapped;
+ * emptied chunks go back onto the arena's free list for any of those slabs
+ * to reuse.  If no region can be mapped, chunks come from posix_memalign()
+ * as for any other slab.
+ */
+#define MEMHUGE_REGION_SIZE (2 * 1024 * 1024)
+
+static pthread_mutex_t memhuge_mtx = PTHREAD_MUTEX_INITIALIZER;
+static enum mtype_hugepages memhuge_mode = MTYPE_HUGEPAGES_OFF;
+static struct memslab_chunk *memhuge_free;
+static size_t memhuge_regions, memhuge_n_free;
+
+/* needs memhuge_mtx */
+static bool memhuge_region_add(void)
 {
-	size_t current;
-	size_t oldsize;
+	size_t i, n = MEMHUGE_REGION_SIZE / MEMSLAB_CHUNK_SIZE;
+	struct memslab_chunk *chunk;
+	char *mem = MAP_FAILED;
+
+#ifdef MAP_HUGETLB
+	if (memhuge_mode == MTYPE_HUGEPAGES_EXPLICIT) {
+		mem = mmap(NULL, MEMHUGE_REGION_SIZE, PROT_READ | PROT_WRITE,
+			   MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (mem == MAP_FAILED && memhuge_regions == 0) {
+			zlog_warn("no explicit huge pages available (%s), using transparent ones",
+				  safe_strerror(errno));
+			memhuge_mode = MTYPE_HUGEPAGES_TRANSPARENT;
+		}
+	}
+#endif
+	if (mem == MAP_FAILED) {
+		/* map twice the size to be able to align to it */
+		char *raw = mmap(NULL, 2 * MEMHUGE_REGION_SIZE,
+				 PROT_READ | PROT_WRITE,
+				 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		size_t head;
+
+		if (raw == MAP_FAILED)
+			return false;
+
+		head = -(uintptr_t)raw & (MEMHUGE_REGION_SIZE - 1);
+		if (head)
+			munmap(raw, head);
+		mem = raw + head;
+		munmap(mem + MEMHUGE_REGION_SIZE, MEMHUGE_REGION_SIZE - head);
+#ifdef MADV_HUGEPAGE
+		madvise(mem, MEMHUGE_REGION_SIZE, MADV_HUGEPAGE);
+#endif
+	}
+
+	for (i = 0; i < n; i++) {
+		chunk = (struct memslab_chunk *)(mem + i * MEMSLAB_CHUNK_SIZE);
+		chunk->huge = true;
+		chunk->next = memhuge_free;
+		memhuge_free = chunk;
+	}
+	memhuge_n_free += n;
+	memhuge_regions++;
+	return true;
+}
+
+static struct memslab_chunk *memhuge_chunk_get(void)
+{
+	struct memslab_chunk *chunk = NULL;
+
+	pthread_mutex_lock(&memhuge_mtx);
+	if (memhuge_mode != MTYPE_HUGEPAGES_OFF
+	    && (memhuge_free || memhuge_region_add())) {
+		chunk = memhuge_free;
+		memhuge_free = chunk->next;
+		memhuge_n_free--;
+	}
+	pthread_mutex_unlock(&memhuge_mtx);
+	return chunk;
+}
+
+static void memhuge_chunk_put(struct memslab_chunk *chunk)
+{
+	pthread_mutex_lock(&memhuge_mtx);
+	chunk->next = memhuge_free;
+	memhuge_free = chunk;
+	memhuge_n_free++;
+	pthread_mutex_unlock(&memhuge_mtx);
+}
+
+void mtype_hugepages_set(enum mtype_hugepages mode)
+{
+	pthread_mutex_lock(&memhuge_mtx);
+	memhuge_mode = mode;
+	pthread_mutex_unlock(&memhuge_mtx);
+}
+
+void mtype_hugepages_stats(struct mtype_hugepages_stats *st)
+{
+	pthread_mutex_lock(&memhuge_mtx);
+	st->mode = memhuge_mode;
+	st->mapped = memhuge_regions * MEMHUGE_REGION_SIZE;
+	st->free = memhuge_n_free * MEMSLAB_CHUNK_SIZE;
+	pthread_mutex_unlock(&memhuge_mtx);
+}
+
+static inline struct memslab_chunk *memslab_chunk_of(void *ptr)
+{
+	return (struct memslab_chunk *)((uintptr_t)ptr
+					& ~(uintptr_t)(MEMSLAB_CHUNK_SIZE - 1));
+}
+
+static void memslab_chunk_reset(struct memslab_chunk *chunk)
+{
+	chunk->next = chunk->prev = NULL;
+	chunk->freelist = NULL;
+	chunk->fresh = (char *)chunk + MEMSLAB_HDR_SIZE;
+	chunk->n_used = 0;
+}
+
+static void memslab_partial_add(struct memslab *slab,
+				struct memslab_chunk *chunk)
+{
+	chunk->prev = NULL;
+	chunk->next = slab->partial;
+	if (slab->partial)
+		slab->partial->prev = chunk;
+	slab->partial = chunk;
+}
+
+static void memslab_partial_del(struct memslab *slab,
+				struct memslab_chunk *chunk)
+{
+	if (chunk->prev)
+		chunk->prev->next = chunk->next;
+	else
+		slab->partial = chunk->next;
+	if (chunk->next)
+		chunk->next->prev = chunk->prev;
+	chunk->next = chunk->prev = NULL;
+}
+
+static void *memslab_alloc(struct memtype *mt, size_t size)
+{
+	struct memslab *slab = mt->slab;
+	struct memslab_chunk *chunk;
+	void *obj;
+
+	assert(size <= slab->objsize);
+
+	pthread_mutex_lock(&slab->mtx);
+
+	chunk = slab->partial;
+	if (!chunk) {
+		if (slab->spare) {
+			chunk = slab->spare;
+			slab->spare = NULL;
+		} else {
+			void *mem;
+
+			chunk = slab->want_huge ? memhuge_chunk_get() : NULL;
+			if (chunk) {
+				slab->n_huge++;
+			} else {
+				if (posix_memalign(&mem, MEMSLAB_CHUNK_SIZE,
+						   MEMSLAB_CHUNK_SIZE))
+					memory_oom(MEMSLAB_CHUNK_SIZE,
+						   mt->name);
+				chunk = mem;
+				chunk->huge = false;
+			}
+			chunk->slab = slab;
+			memslab_chunk_reset(chunk);
+			slab->n_chunks++;
+		}
+		memslab_partial_add(slab, chunk);
+	}
+
+	if (chunk->freelist) {
+		obj = chunk->freelist;
+		chunk->freelist = *(void **)obj;
+	} else {
+		obj = chunk->fresh;
+		chunk->fresh += slab->objsize;
+	}
+
+	if (++chunk->n_used == slab->per_chunk)
+		memslab_partial_del(slab, chunk);
+	slab->n_used++;
+
+	pthread_mutex_unlock(&slab->mtx);
+	return obj;
+}
+
+static void memslab_free(struct memtype *mt, void *ptr)
+{
+	struct memslab *slab = mt->slab;
+	struct memslab_chunk *chunk = memslab_chunk_of(ptr);
+
+	assert(chunk->slab == slab);
+
+	pthread_mutex_lock(&slab->mtx);
+
+	*(void **)ptr = chunk->freelist;
+	chunk->freelist = ptr;
+
+	if (chunk->n_used-- == slab->per_chunk)
+		memslab_partial_add(slab, chunk);
+	slab->n_used--;
+
+	if (chunk->n_used == 0) {
+		memslab_partial_del(slab, chunk);
+		if (slab->spare) {
+			slab->n_chunks--;
+			if (chunk->huge) {
+				slab->n_huge--;
+				memhuge_chunk_put(chunk);
+			} else
+				free(chunk);
+		} else {
+			memslab_chunk_reset(chunk);
+			slab->spare = chunk;
+		}
+	}
+
+	pthread_mutex_unlock(&slab->mtx);
+}
+
+void mtype_slab_enable(struct memtype *mt, size_t objsize)
+{
+	struct memslab *slab;
+
+	if (mt->slab)
+		return;
+
+	/* objects already malloc()ed can't be told apart on free */
+	assert(!mtype_stats_alloc(mt));
+
+	objsize = (objsize + MEMSLAB_ALIGN - 1) & ~(size_t)(MEMSLAB_ALIGN - 1);
+	/* not worth it for big objects */
+	assert(objsize <= (MEMSLAB_CHUNK_SIZE - MEMSLAB_HDR_SIZE) / 16);
+
+	slab = calloc(1, sizeof(*slab));
+	if (!slab)
+		memory_oom(sizeof(*slab), mt->name);
+
+	pthread_mutex_init(&slab->mtx, NULL);
+	slab->objsize = objsize;
+	slab->per_chunk = (MEMSLAB_CHUNK_SIZE - MEMSLAB_HDR_SIZE) / objsize;
+	mt->slab = slab;
+}
+
+void mtype_slab_hugepages(struct memtype *mt)
+{
+	/* only slab chunks can be placed in the arena */
+	assert(mt->slab);
+
+	pthread_mutex_lock(&mt->slab->mtx);
+	mt->slab->want_huge = true;
+	pthread_mutex_unlock(&mt->slab->mtx);
+}
+
+bool mtype_slab_stats(struct memtype *mt, struct mtype_slab_stats *st)
+{
+	struct memslab *slab = mt->slab;
+
+	if (!slab)
+		return false;
+
+	pthread_mutex_lock(&slab->mtx);
+	st->objsize = slab->objsize;
+	st->per_chunk = slab->per_chunk;
+	st->n_chunks = slab->n_chunks;
+	st->n_used = slab->n_used;
+	st->n_huge = slab->n_huge;
+	pthread_mutex_unlock(&slab->mtx);
+	return true;
+}
+
+/* per-pthread counters
+ *
+ * Rather than having every pthread update the same atomics in struct memtype
+ * on each allocation, each one adds to a small direct-mapped cache of its
+ * own, and only this gets flushed to the memtype, on eviction or every
+ * MEMSHARD_FLUSH operations.  The hits don't need any locking as only the
+ * owner writes to its shard; evictions and flushes take the shard's mutex so
+ * that mtype_stats() sees each count exactly once.
+ */
+#define MEMSHARD_SLOTS 64
+#define MEMSHARD_FLUSH 64
+
+struct memshard_slot {
+	struct memtype *mt;
+	/* deltas, as size_t since frees make them wrap around */
+	atomic_size_t n_alloc;
+	atomic_size_t total;
+	unsigned int ops;
+};
+
+struct memshard {
+	struct memshard *next, **prevp;
+	pthread_mutex_t mtx;
+	struct memshard_slot slots[MEMSHARD_SLOTS];
+};
+
+static pthread_mutex_t memshards_mtx = PTHREAD_MUTEX_INITIALIZER;
+static struct memshard *memshards;
+static pthread_key_t memshard_key;
+
+#ifdef __OpenBSD__
+static inline struct memshard *memshard_tls_get(void)
+{
+	return pthread_getspecific(memshard_key);
+}
 
-	current = 1 + atomic_fetch_add_explicit(&mt->n_alloc, 1,
+static inline void memshard_tls_set(struct memshard *ms)
+{
+}
+#else
+# ifndef thread_local
+#  define thread_local __thread
+# endif
+
+static thread_local struct memshard *memshard_var
+	__attribute__((tls_model("initial-exec")));
+
+static inline struct memshard *memshard_tls_get(void)
+{
+	return memshard_var;
+}
+
+static inline void memshard_tls_set(struct memshard *ms)
+{
+	memshard_var = ms;
+}
+#endif
+
+static inline void mt_count_global(struct memtype *mt, size_t n, size_t total)
+{
+	size_t current, oldsize;
+
+	current = n + atomic_fetch_add_explicit(&mt->n_alloc, n,
 						memory_order_relaxed);
 
 	oldsize = atomic_load_explicit(&mt->n_max, memory_order_relaxed);
-	if (current > oldsize)
+	/* counts freed on another pthread may not have been added yet */
+	if ((ssize_t)current > (ssize_t)oldsize)
 		/* note that this may fail, but approximation is sufficient */
 		atomic_compare_exchange_weak_explicit(&mt->n_max, &oldsize,
 						      current,
 						      memory_order_relaxed,
 						      memory_order_relaxed);
 
+#ifdef HAVE_MALLOC_USABLE_SIZE
+	current = total + atomic_fetch_add_explicit(&mt->total, total,
+						    memory_order_relaxed);
+	oldsize = atomic_load_explicit(&mt->max_size, memory_order_relaxed);
+	if ((ssize_t)current > (ssize_t)oldsize)
+		/* note that this may fail, but approximation is sufficient */
+		atomic_compare_exchange_weak_explicit(&mt->max_size, &oldsize,
+						      current,
+						      memory_order_relaxed,
+						      memory_order_relaxed);
+#else
+	(void)total;
+#endif
+}
+
+/* needs ms->mtx */
+static void memshard_slot_flush(struct memshard_slot *slot)
+{
+	size_t n, total;
+
+	if (!slot->mt)
+		return;
+
+	n = atomic_load_explicit(&slot->n_alloc, memory_order_relaxed);
+	total = atomic_load_explicit(&slot->total, memory_order_relaxed);
+	if (n || total)
+		mt_count_global(slot->mt, n, total);
+
+	atomic_store_explicit(&slot->n_alloc, 0, memory_order_relaxed);
+	atomic_store_explicit(&slot->total, 0, memory_order_relaxed);
+	slot->ops = 0;
+}
+
+static void memshard_free(void *arg)
+{
+	struct memshard *ms = arg;
+	size_t i;
+
+	memshard_tls_set(NULL);
+
+	pthread_mutex_lock(&memshards_mtx);
+	pthread_mutex_lock(&ms->mtx);
+	for (i = 0; i < array_size(ms->slots); i++)
+		memshard_slot_flush(&ms->slots[i]);
+	pthread_mutex_unlock(&ms->mtx);
+
+	if (ms->next)
+		ms->next->prevp = ms->prevp;
+	*ms->prevp = ms->next;
+	pthread_mutex_unlock(&memshards_mtx);
+
+	pthread_mutex_destroy(&ms->mtx);
+	free(ms);
+}
+
+static void memshard_key_init(void) __attribute__((_CONSTRUCTOR(500)));
+static void memshard_key_init(void)
+{
+	pthread_key_create(&memshard_key, memshard_free);
+}
+
+static struct memshard *memshard_get(void)
+{
+	struct memshard *ms = memshard_tls_get();
+
+	if (__builtin_expect(ms != NULL, 1))
+		return ms;
+
+	/* not from qmalloc(), that's where we're coming from */
+	ms = calloc(1, sizeof(*ms));
+	if (!ms)
+		return NULL;
+	pthread_mutex_init(&ms->mtx, NULL);
+
+	pthread_mutex_lock(&memshards_mtx);
+	ms->next = memshards;
+	if (ms->next)
+		ms->next->prevp = &ms->next;
+	ms->prevp = &memshards;
+	memshards = ms;
+	pthread_mutex_unlock(&memshards_mtx);
+
+	memshard_tls_set(ms);
+	pthread_setspecific(memshard_key, ms);
+	return ms;
+}
+
+static inline struct memshard_slot *memshard_slot(struct memshard *ms,
+						  struct memtype *mt)
+{
+	/* memtypes are laid out next to each other in .data.mtypes */
+	return &ms->slots[((uintptr_t)mt / sizeof(*mt)) % MEMSHARD_SLOTS];
+}
+
+static inline void mt_count(struct memtype *mt, size_t n, size_t total)
+{
+	struct memshard *ms = memshard_get();
+	struct memshard_slot *slot;
+
+	if (!ms) {
+		mt_count_global(mt, n, total);
+		return;
+	}
+
+	slot = memshard_slot(ms, mt);
+	if (slot->mt != mt) {
+		pthread_mutex_lock(&ms->mtx);
+		memshard_slot_flush(slot);
+		slot->mt = mt;
+		pthread_mutex_unlock(&ms->mtx);
+	}
+
+	/* only this pthread writes to the slot, no need for fetch_add */
+	atomic_store_explicit(&slot->n_alloc,
+			      n + atomic_load_explicit(&slot->n_alloc,
+						       memory_order_relaxed),
+			      memory_order_relaxed);
+	atomic_store_explicit(&slot->total,
+			      total + atomic_load_explicit(&slot->total,
+							   memory_order_relaxed),
+			      memory_order_relaxed);
+
+	if (++slot->ops >= MEMSHARD_FLUSH) {
+		pthread_mutex_lock(&ms->mtx);
+		memshard_slot_flush(slot);
+		pthread_mutex_unlock(&ms->mtx);
+	}
+}
+
+void mtype_stats(struct memtype *mt, struct mtype_stats *st)
+{
+	struct memshard *ms;
+	struct memshard_slot *slot;
+	size_t n_alloc, total = 0;
+
+	pthread_mutex_lock(&memshards_mtx);
+
+	n_alloc = atomic_load_explicit(&mt->n_alloc, memory_order_relaxed);
+#ifdef HAVE_MALLOC_USABLE_SIZE
+	total = atomic_load_explicit(&mt->total, memory_order_relaxed);
+#endif
+	for (ms = memshards; ms; ms = ms->next) {
+		pthread_mutex_lock(&ms->mtx);
+		slot = memshard_slot(ms, mt);
+		if (slot->mt == mt) {
+			n_alloc += atomic_load_explicit(&slot->n_alloc,
+							memory_order_relaxed);
+			total += atomic_load_explicit(&slot->total,
+						      memory_order_relaxed);
+		}
+		pthread_mutex_unlock(&ms->mtx);
+	}
+
+	pthread_mutex_unlock(&memshards_mtx);
+
+	st->n_alloc = n_alloc;
+	st->n_max = atomic_load_explicit(&mt->n_max, memory_order_relaxed);
+	if (n_alloc > st->n_max)
+		st->n_max = n_alloc;
+	st->size = atomic_load_explicit(&mt->size, memory_order_relaxed);
+#ifdef HAVE_MALLOC_USABLE_SIZE
+	st->total = total;
+	st->max_size = atomic_load_explicit(&mt->max_size,
+					    memory_order_relaxed);
+	if (total > st->max_size)
+		st->max_size = total;
+#else
+	(void)total;
+	st->total = st->max_size = 0;
+#endif
+}
+
+size_t mtype_stats_alloc(struct memtype *mt)
+{
+	struct mtype_stats st;
+
+	mtype_stats(mt, &st);
+	return st.n_alloc;
+}
+
+static inline size_t mt_usable_size(struct memtype *mt, void *ptr)
+{
+	if (mt->slab)
+		return mt->slab->objsize;
+#ifdef HAVE_MALLOC_USABLE_SIZE
+	return malloc_usable_size(ptr);
+#else
+	return 0;
+#endif
+}
+
+static inline void mt_count_alloc(struct memtype *mt, size_t size, void *ptr)
+{
+	size_t oldsize;
+
 	oldsize = atomic_load_explicit(&mt->size, memory_order_relaxed);
 	if (oldsize == 0)
 		oldsize = atomic_exchange_explicit(&mt->size, size,
@@ -63,17 +634,9 @@ static inline void mt_count_alloc(struct memtype *mt, size_t size, void *ptr)
 				      memory_order_relaxed);
 
 #ifdef HAVE_MALLOC_USABLE_SIZE
-	size_t mallocsz = malloc_usable_size(ptr);
-
-	current = mallocsz + atomic_fetch_add_explicit(&mt->total, mallocsz,
-						       memory_order_relaxed);
-	oldsize = atomic_load_explicit(&mt->max_size, memory_order_relaxed);
-	if (current > oldsize)
-		/* note that this may fail, but approximation is sufficient */
-		atomic_compare_exchange_weak_explicit(&mt->max_size, &oldsize,
-						      current,
-						      memory_order_relaxed,
-						      memory_order_relaxed);
+	mt_count(mt, 1, mt_usable_size(mt, ptr));
+#else
+	mt_count(mt, 1, 0);
 #endif
 }
 
@@ -81,13 +644,10 @@ static inline void mt_count_free(struct memtype *mt, void *ptr)
 {
 	frrtrace(2, frr_libfrr, memfree, mt, ptr);
 
-	assert(mt->n_alloc);
-	atomic_fetch_sub_explicit(&mt->n_alloc, 1, memory_order_relaxed);
-
 #ifdef HAVE_MALLOC_USABLE_SIZE
-	size_t mallocsz = malloc_usable_size(ptr);
-
-	atomic_fetch_sub_explicit(&mt->total, mallocsz, memory_order_relaxed);
+	mt_count(mt, -(size_t)1, -mt_usable_size(mt, ptr));
+#else
+	mt_count(mt, -(size_t)1, 0);
 #endif
 }
 
@@ -108,16 +668,31 @@ static inline void *mt_checkalloc(struct memtype *mt, void *ptr, size_t size)
 
 void *qmalloc(struct memtype *mt, size_t size)
 {
+	if (mt->slab)
+		return mt_checkalloc(mt, memslab_alloc(mt, size), size);
 	return mt_checkalloc(mt, malloc(size), size);
 }
 
 void *qcalloc(struct memtype *mt, size_t size)
 {
+	if (mt->slab)
+		return memset(qmalloc(mt, size), 0, size);
 	return mt_checkalloc(mt, calloc(size, 1), size);
 }
 
 void *qrealloc(struct memtype *mt, void *ptr, size_t size)
 {
+	if (mt->slab) {
+		/* all objects have the same size, so this is just a copy */
+		void *new = qmalloc(mt, size);
+
+		if (ptr) {
+			memcpy(new, ptr, mt->slab->objsize);
+			qfree(mt, ptr);
+		}
+		return new;
+	}
+
 	if (ptr)
 		mt_count_free(mt, ptr);
 	return mt_checkalloc(mt, ptr ? realloc(ptr, size) : malloc(size), size);
@@ -125,11 +700,16 @@ void *qrealloc(struct memtype *mt, void *ptr, size_t size)
 
 void *qstrdup(struct memtype *mt, const char *str)
 {
+	if (str && mt->slab)
+		return strcpy(qmalloc(mt, strlen(str) + 1), str);
 	return str ? mt_checkalloc(mt, strdup(str), strlen(str) + 1) : NULL;
 }
 
 void qcountfree(struct memtype *mt, void *ptr)
 {
+	/* the caller would free() memory it doesn't own */
+	assert(!mt->slab);
+
 	if (ptr)
 		mt_count_free(mt, ptr);
 }
@@ -138,6 +718,11 @@ void qfree(struct memtype *mt, void *ptr)
 {
 	if (ptr)
 		mt_count_free(mt, ptr);
+	if (mt->slab) {
+		if (ptr)
+			memslab_free(mt, ptr);
+		return;
+	}
 	free(ptr);
 }
 
@@ -166,20 +751,24 @@ struct exit_dump_args {
 static int qmem_exit_walker(void *arg, struct memgroup *mg, struct memtype *mt)
 {
 	struct exit_dump_args *eda = arg;
+	struct mtype_stats st;
 
 	if (!mt) {
 		fprintf(eda->fp,
 			"%s: showing active allocations in memory group %s\n",
 			eda->prefix, mg->name);
+		return 0;
+	}
 
-	} else if (mt->n_alloc) {
+	mtype_stats(mt, &st);
+	if (st.n_alloc) {
 		char size[32];
 		if (!mg->active_at_exit)
 			eda->error++;
-		snprintf(size, sizeof(size), "%10zu", mt->size);
+		snprintf(size, sizeof(size), "%10zu", st.size);
 		fprintf(eda->fp, "%s: memstats:  %-30s: %6zu * %s\n",
-			eda->prefix, mt->name, mt->n_alloc,
-			mt->size == SIZE_VAR ? "(variably sized)" : size);
+			eda->prefix, mt->name, st.n_alloc,
+			st.size == SIZE_VAR ? "(variably sized)" : size);
 	}
 	return 0;
 }
@@ -33,6 +33,8 @@ extern "C" {
 #endif
 
 #define SIZE_VAR ~0UL
+struct memslab;
+
 struct memtype {
 	struct memtype *next, **ref;
 	const char *name;
@@ -43,6 +45,8 @@ struct memtype {
 	atomic_size_t total;
 	atomic_size_t max_size;
 #endif
+	/* set by mtype_slab_enable() */
+	struct memslab *slab;
 };
 
 struct memgroup {
@@ -177,10 +181,74 @@ extern void qfree(struct memtype *mt, void *ptr) __attribute__((nonnull(1)));
 		ptr = NULL;                                                    \
 	} while (0)
 
-static inline size_t mtype_stats_alloc(struct memtype *mt)
-{
-	return mt->n_alloc;
-}
+/* The counters in struct memtype don't include what each pthread counted
+ * recently, these functions add it up.
+ */
+struct mtype_stats {
+	size_t n_alloc;
+	size_t n_max;
+	size_t size;
+	size_t total;
+	size_t max_size;
+};
+
+extern void mtype_stats(struct memtype *mt, struct mtype_stats *st);
+extern size_t mtype_stats_alloc(struct memtype *mt);
+
+/* slab pools
+ *
+ * A memtype that only ever holds objects of one (small) size can be switched
+ * to a slab pool.  Its objects are then carved out of 64k chunks instead of
+ * being malloc()ed one by one, and chunks that become empty are returned to
+ * the system as a whole.  XMALLOC/XCALLOC/XFREE work as usual, XCOUNTFREE
+ * can't be used on such a memtype.
+ *
+ * mtype_slab_enable() must be called before the first allocation, e.g.
+ *
+ *    mtype_slab_enable(MTYPE_MYDAEMON_NODE, sizeof(struct mynode));
+ *
+ * Allocations larger than objsize are a bug and will assert.
+ */
+extern void mtype_slab_enable(struct memtype *mt, size_t objsize);
+
+/* Back the slab pool of mt with huge pages, for memtypes with a lot of
+ * objects that are walked often (route nodes, paths, attributes).  Whether
+ * this happens, and with which kind of huge pages, is up to
+ * mtype_hugepages_set(), i.e. the --hugepages option; chunks allocated
+ * before that are left where they are.
+ */
+extern void mtype_slab_hugepages(struct memtype *mt);
+
+enum mtype_hugepages {
+	MTYPE_HUGEPAGES_OFF = 0,
+	/* madvise(MADV_HUGEPAGE) */
+	MTYPE_HUGEPAGES_TRANSPARENT,
+	/* MAP_HUGETLB, with transparent ones if none are reserved */
+	MTYPE_HUGEPAGES_EXPLICIT,
+};
+
+extern void mtype_hugepages_set(enum mtype_hugepages mode);
+
+struct mtype_hugepages_stats {
+	enum mtype_hugepages mode;
+	size_t mapped;
+	/* not used by any slab at the moment */
+	size_t free;
+};
+
+extern void mtype_hugepages_stats(struct mtype_hugepages_stats *st);
+
+struct mtype_slab_stats {
+	size_t objsize;
+	size_t per_chunk;
+	size_t n_chunks;
+	size_t n_used;
+	/* of n_chunks, those in the huge page arena */
+	size_t n_huge;
+};
+
+/* returns false if mt isn't using a slab pool */
+extern bool mtype_slab_stats(struct memtype *mt, struct mtype_slab_stats *st);
 
 /* NB: calls are ordered by memgroup; and there is a call with mt == NULL for
  * each memgroup (so that a header can be printed, and empty memgroups show)
@@ -34,7 +34,7 @@
 #include "vrf.h"
 #include "nexthop_group.h"
 
-DEFINE_MTYPE_STATIC(LIB, NEXTHOP, "Nexthop");
+DEFINE_MTYPE(LIB, NEXTHOP, "Nexthop");
 DEFINE_MTYPE_STATIC(LIB, NH_LABEL, "Nexthop label");
 DEFINE_MTYPE_STATIC(LIB, NH_SRV6, "Nexthop srv6");
 
@@ -773,24 +773,68 @@ uint32_t nexthop_hash_quick(const struct nexthop *nexthop)
 
 #define GATE_SIZE 4 /* Number of uint32_t words in struct g_addr */
 
-/* For a more granular hash */
+/* type, vrf_id, label type, ifindex, onlink, weight, srte color */
+#define NEXTHOP_HASH_FIXED 7
+#define NEXTHOP_HASH_WORDS                                                     \
+	(NEXTHOP_HASH_FIXED + MPLS_MAX_LABELS + NEXTHOP_MAX_BACKUPS            \
+	 + GATE_SIZE * 3)
+
+/* For a more granular hash
+ *
+ * Everything but the SRv6 data is packed into one array of words and hashed
+ * in one go, rather than a jhash round for each field.
+ */
 uint32_t nexthop_hash(const struct nexthop *nexthop)
 {
-	uint32_t gate_src_rmap_raw[GATE_SIZE * 3] = {};
-	/* Get all the quick stuff */
-	uint32_t key = nexthop_hash_quick(nexthop);
+	uint32_t words[NEXTHOP_HASH_WORDS];
+	uint32_t key = 0x45afe398;
+	size_t n = 0;
+	int i;
+
+	_Static_assert(sizeof(union g_addr) == GATE_SIZE * sizeof(uint32_t),
+		       "g_addr must be GATE_SIZE words");
+
+	words[n++] = nexthop->type;
+	words[n++] = nexthop->vrf_id;
+	words[n++] = nexthop->nh_label_type;
+	words[n++] = nexthop->ifindex;
+	words[n++] = CHECK_FLAG(nexthop->flags, NEXTHOP_FLAG_ONLINK);
+	words[n++] = nexthop->weight;
+	words[n++] = nexthop->srte_color;
+
+	if (nexthop->nh_label) {
+		for (i = 0; i < nexthop->nh_label->num_labels
+			    && i < MPLS_MAX_LABELS;
+		     i++)
+			words[n++] = nexthop->nh_label->label[i];
+	}
+
+	/* Include backup nexthops, if present */
+	if (CHECK_FLAG(nexthop->flags, NEXTHOP_FLAG_HAS_BACKUP)) {
+		for (i = 0; i < nexthop->backup_num && i < NEXTHOP_MAX_BACKUPS;
+		     i++)
+			words[n++] = nexthop->backup_idx[i];
+	}
 
-	assert(((sizeof(nexthop->gate) + sizeof(nexthop->src)
-		 + sizeof(nexthop->rmap_src))
-		/ 3)
-	       == (GATE_SIZE * sizeof(uint32_t)));
+	/* all of the addresses; IPv6 gateways on the same link used to share
+	 * a hash value since only their first word was used
+	 */
+	memcpy(&words[n], &nexthop->gate, GATE_SIZE * sizeof(uint32_t));
+	n += GATE_SIZE;
+	memcpy(&words[n], &nexthop->src, GATE_SIZE * sizeof(uint32_t));
+	n += GATE_SIZE;
+	memcpy(&words[n], &nexthop->rmap_src, GATE_SIZE * sizeof(uint32_t));
+	n += GATE_SIZE;
 
-	memcpy(gate_src_rmap_raw, &nexthop->gate, GATE_SIZE);
-	memcpy(gate_src_rmap_raw + GATE_SIZE, &nexthop->src, GATE_SIZE);
-	memcpy(gate_src_rmap_raw + (2 * GATE_SIZE), &nexthop->rmap_src,
-	       GATE_SIZE);
+	key = jhash2(words, n, key);
 
-	key = jhash2(gate_src_rmap_raw, (GATE_SIZE * 3), key);
+	if (nexthop->nh_srv6) {
+		key = jhash_1word(nexthop->nh_srv6->seg6local_action, key);
+		key = jhash(&nexthop->nh_srv6->seg6local_ctx,
+			    sizeof(nexthop->nh_srv6->seg6local_ctx), key);
+		key = jhash(&nexthop->nh_srv6->seg6_segs,
+			    sizeof(nexthop->nh_srv6->seg6_segs), key);
+	}
 
 	return key;
 }
@@ -32,6 +32,8 @@
 extern "C" {
 #endif
 
+DECLARE_MTYPE(NEXTHOP);
+
 /* Maximum next hop string length - gateway + ifindex */
 #define NEXTHOP_STRLEN (INET6_ADDRSTRLEN + 30)
 
@@ -35,6 +35,8 @@
 DEFINE_MTYPE_STATIC(LIB, NB_NODE, "Northbound Node");
 DEFINE_MTYPE_STATIC(LIB, NB_CONFIG, "Northbound Configuration");
 DEFINE_MTYPE_STATIC(LIB, NB_CONFIG_ENTRY, "Northbound Configuration Entry");
+DEFINE_MTYPE_STATIC(LIB, NB_CONFIG_EDIT, "Northbound Configuration Edit");
+DEFINE_MTYPE_STATIC(LIB, NB_WORKERS, "Northbound workers");
 
 /* Running configuration - shouldn't be modified directly. */
 struct nb_config *running_config;
@@ -78,6 +80,10 @@ nb_transaction_new(struct nb_context *context, struct nb_config *config,
 		   struct nb_config_cbs *changes, const char *comment,
 		   char *errmsg, size_t errmsg_len);
 static void nb_transaction_free(struct nb_transaction *transaction);
+static int nb_callbacks_configuration(struct nb_context *context,
+				      const enum nb_event event,
+				      struct nb_config_cbs *changes,
+				      char *errmsg, size_t errmsg_len);
 static int nb_transaction_process(enum nb_event event,
 				  struct nb_transaction *transaction,
 				  char *errmsg, size_t errmsg_len);
@@ -299,6 +305,117 @@ static int nb_node_validate(const struct lysc_node *snode, void *arg)
 	return YANG_ITER_CONTINUE;
 }
 
+static int nb_config_edit_cmp(const struct nb_config_edit *a,
+			      const struct nb_config_edit *b)
+{
+	return strcmp(a->xpath, b->xpath);
+}
+
+static uint32_t nb_config_edit_hash(const struct nb_config_edit *a)
+{
+	return string_hash_make(a->xpath);
+}
+
+DECLARE_DLIST(nb_config_edits, struct nb_config_edit, item);
+DECLARE_HASH(nb_config_edits_hash, struct nb_config_edit, hitem,
+	     nb_config_edit_cmp, nb_config_edit_hash);
+
+static void nb_config_edits_clear(struct nb_config *config)
+{
+	struct nb_config_edit *edit;
+
+	while ((edit = nb_config_edits_pop(&config->edits))) {
+		nb_config_edits_hash_del(&config->edits_hash, edit);
+		XFREE(MTYPE_NB_CONFIG_EDIT, edit->xpath);
+		XFREE(MTYPE_NB_CONFIG_EDIT, edit);
+	}
+	config->edits_valid = false;
+}
+
+static void nb_config_edit_record(struct nb_config *config, const char *xpath)
+{
+	struct nb_config_edit *edit, s;
+
+	if (!config->edits_valid)
+		return;
+
+	s.xpath = (char *)xpath;
+	if (nb_config_edits_hash_find(&config->edits_hash, &s))
+		return;
+
+	if (nb_config_edits_count(&config->edits) >= NB_CONFIG_EDITS_MAX) {
+		nb_config_edits_clear(config);
+		return;
+	}
+
+	edit = XCALLOC(MTYPE_NB_CONFIG_EDIT, sizeof(*edit));
+	edit->xpath = XSTRDUP(MTYPE_NB_CONFIG_EDIT, xpath);
+	nb_config_edits_hash_add(&config->edits_hash, edit);
+	nb_config_edits_add_tail(&config->edits, edit);
+}
+
+static void nb_config_edit_record_dnode(struct nb_config *config,
+					const struct lyd_node *dnode)
+{
+	char xpath[XPATH_MAXLEN];
+
+	if (!config->edits_valid)
+		return;
+
+	yang_dnode_get_path(dnode, xpath, sizeof(xpath));
+	nb_config_edit_record(config, xpath);
+}
+
+/*
+ * Whether the subtree at xpath is part of a bigger one that was edited as
+ * well. Recorded paths are canonical, so looking for each prefix ending
+ * right before a '/' is enough.
+ */
+static bool nb_config_edit_covered(const struct nb_config *config,
+				   const char *xpath)
+{
+	char prefix[XPATH_MAXLEN];
+	struct nb_config_edit s = {.xpath = prefix};
+	const char *p;
+
+	for (p = strchr(xpath + 1, '/'); p; p = strchr(p + 1, '/')) {
+		if ((size_t)(p - xpath) >= sizeof(prefix))
+			break;
+		strlcpy(prefix, xpath, p - xpath + 1);
+		if (nb_config_edits_hash_const_find(&config->edits_hash, &s))
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * Let config_dst track its edits against the running configuration: it
+ * starts doing so when copied from the running configuration, and takes
+ * over the edits of config_src otherwise.
+ */
+static void nb_config_edits_copy(struct nb_config *config_dst,
+				 const struct nb_config *config_src)
+{
+	const struct nb_config_edit *edit;
+
+	nb_config_edits_clear(config_dst);
+
+	if (config_src == running_config) {
+		config_dst->edits_valid = true;
+		config_dst->edits_version = config_src->version;
+		return;
+	}
+	if (!config_src->edits_valid)
+		return;
+
+	config_dst->edits_valid = true;
+	config_dst->edits_version = config_src->edits_version;
+	for (edit = nb_config_edits_const_first(&config_src->edits); edit;
+	     edit = nb_config_edits_const_next(&config_src->edits, edit))
+		nb_config_edit_record(config_dst, edit->xpath);
+}
+
 struct nb_config *nb_config_new(struct lyd_node *dnode)
 {
 	struct nb_config *config;
@@ -309,6 +426,8 @@ struct nb_config *nb_config_new(struct lyd_node *dnode)
 	else
 		config->dnode = yang_dnode_new(ly_native_ctx, true);
 	config->version = 0;
+	nb_config_edits_init(&config->edits);
+	nb_config_edits_hash_init(&config->edits_hash);
 
 	return config;
 }
@@ -317,6 +436,9 @@ void nb_config_free(struct nb_config *config)
 {
 	if (config->dnode)
 		yang_dnode_free(config->dnode);
+	nb_config_edits_clear(config);
+	nb_config_edits_fini(&config->edits);
+	nb_config_edits_hash_fini(&config->edits_hash);
 	XFREE(MTYPE_NB_CONFIG, config);
 }
 
@@ -327,6 +449,9 @@ struct nb_config *nb_config_dup(const struct nb_config *config)
 	dup = XCALLOC(MTYPE_NB_CONFIG, sizeof(*dup));
 	dup->dnode = yang_dnode_dup(config->dnode);
 	dup->version = config->version;
+	nb_config_edits_init(&dup->edits);
+	nb_config_edits_hash_init(&dup->edits_hash);
+	nb_config_edits_copy(dup, config);
 
 	return dup;
 }
@@ -339,6 +464,7 @@ int nb_config_merge(struct nb_config *config_dst, struct nb_config *config_src,
 	ret = lyd_merge_siblings(&config_dst->dnode, config_src->dnode, 0);
 	if (ret != 0)
 		flog_warn(EC_LIB_LIBYANG, "%s: lyd_merge() failed", __func__);
+	nb_config_edits_clear(config_dst);
 
 	if (!preserve_source)
 		nb_config_free(config_src);
@@ -356,6 +482,7 @@ void nb_config_replace(struct nb_config *config_dst,
 	/* Update dnode. */
 	if (config_dst->dnode)
 		yang_dnode_free(config_dst->dnode);
+	nb_config_edits_copy(config_dst, config_src);
 	if (preserve_source) {
 		config_dst->dnode = yang_dnode_dup(config_src->dnode);
 	} else {
@@ -512,6 +639,23 @@ static int nb_lyd_diff_get_op(const struct lyd_node *dnode)
 	return 'n';
 }
 
+/* Record the subtrees changed in a libyang diff as edits. */
+static void nb_config_edit_record_diff(struct nb_config *config,
+				       const struct lyd_node *diff)
+{
+	const struct lyd_node *root, *dnode;
+
+	LY_LIST_FOR (diff, root) {
+		LYD_TREE_DFS_BEGIN (root, dnode) {
+			if (nb_lyd_diff_get_op(dnode) != 'n') {
+				nb_config_edit_record_dnode(config, dnode);
+				LYD_TREE_DFS_continue = 1;
+			}
+			LYD_TREE_DFS_END(root, dnode);
+		}
+	}
+}
+
 #if 0 /* Used below in nb_config_diff inside normally disabled code */
 static inline void nb_config_diff_dnode_log_path(const char *context,
 						 const char *path,
@@ -538,51 +682,17 @@ static inline void nb_config_diff_dnode_log(const char *context,
 }
 #endif
 
-/* Calculate the delta between two different configurations. */
-static void nb_config_diff(const struct nb_config *config1,
-			   const struct nb_config *config2,
-			   struct nb_config_cbs *changes)
+/* Calculate the changes described by a libyang diff. */
+static void nb_config_diff_walk(const struct lyd_node *diff,
+				const struct nb_config *config1,
+				const struct nb_config *config2, uint32_t *seq,
+				struct nb_config_cbs *changes)
 {
-	struct lyd_node *diff = NULL;
 	const struct lyd_node *root, *dnode;
 	struct lyd_node *target;
 	int op;
-	LY_ERR err;
 	char *path;
 
-#if 0 /* Useful (noisy) when debugging diff code, and for improving later */
-	if (DEBUG_MODE_CHECK(&nb_dbg_cbs_config, DEBUG_MODE_ALL)) {
-		LY_LIST_FOR(config1->dnode, root) {
-			LYD_TREE_DFS_BEGIN(root, dnode) {
-				nb_config_diff_dnode_log("from", dnode);
-				LYD_TREE_DFS_END(root, dnode);
-			}
-		}
-		LY_LIST_FOR(config2->dnode, root) {
-			LYD_TREE_DFS_BEGIN(root, dnode) {
-				nb_config_diff_dnode_log("to", dnode);
-				LYD_TREE_DFS_END(root, dnode);
-			}
-		}
-	}
-#endif
-
-	err = lyd_diff_siblings(config1->dnode, config2->dnode,
-				LYD_DIFF_DEFAULTS, &diff);
-	assert(!err);
-
-	if (diff && DEBUG_MODE_CHECK(&nb_dbg_cbs_config, DEBUG_MODE_ALL)) {
-		char *s;
-
-		if (!lyd_print_mem(&s, diff, LYD_JSON,
-				   LYD_PRINT_WITHSIBLINGS | LYD_PRINT_WD_ALL)) {
-			zlog_debug("%s: %s", __func__, s);
-			free(s);
-		}
-	}
-
-	uint32_t seq = 0;
-
 	LY_LIST_FOR (diff, root) {
 		LYD_TREE_DFS_BEGIN (root, dnode) {
 			op = nb_lyd_diff_get_op(dnode);
@@ -593,7 +703,7 @@ static void nb_config_diff(const struct nb_config *config1,
 			if (DEBUG_MODE_CHECK(&nb_dbg_cbs_config, DEBUG_MODE_ALL)) {
 				char context[80];
 				snprintf(context, sizeof(context),
-					 "iterating diff: oper: %c seq: %u", op, seq);
+					 "iterating diff: oper: %c seq: %u", op, *seq);
 				nb_config_diff_dnode_log_path(context, path, dnode);
 			}
 #endif
@@ -608,7 +718,7 @@ static void nb_config_diff(const struct nb_config *config1,
 				   */
 				target = yang_dnode_get(config2->dnode, path);
 				assert(target);
-				nb_config_diff_created(target, &seq, changes);
+				nb_config_diff_created(target, seq, changes);
 
 				/* Skip rest of sub-tree, move to next sibling
 				 */
@@ -617,7 +727,7 @@ static void nb_config_diff(const struct nb_config *config1,
 			case 'd': /* delete */
 				target = yang_dnode_get(config1->dnode, path);
 				assert(target);
-				nb_config_diff_deleted(target, &seq, changes);
+				nb_config_diff_deleted(target, seq, changes);
 
 				/* Skip rest of sub-tree, move to next sibling
 				 */
@@ -628,7 +738,7 @@ static void nb_config_diff(const struct nb_config *config1,
 				target = yang_dnode_get(config2->dnode, path);
 				assert(target);
 				nb_config_diff_add_change(changes, NB_OP_MODIFY,
-							  &seq, target);
+							  seq, target);
 				break;
 			case 'n': /* none */
 			default:
@@ -638,6 +748,98 @@ static void nb_config_diff(const struct nb_config *config1,
 			LYD_TREE_DFS_END(root, dnode);
 		}
 	}
+}
+
+/*
+ * Calculate the delta between the running configuration and a candidate
+ * copied from it by only looking at the subtrees that were edited. Returns
+ * false if the candidate doesn't have (current) edit tracking.
+ */
+static bool nb_config_diff_edits(const struct nb_config *config1,
+				 const struct nb_config *config2,
+				 struct nb_config_cbs *changes)
+{
+	const struct nb_config_edit *edit;
+	const struct lyd_node *dnode1, *dnode2;
+	struct lyd_node *diff;
+	uint32_t seq = 0;
+	LY_ERR err;
+
+	if (config1 != running_config || !config2->edits_valid
+	    || config2->edits_version != config1->version)
+		return false;
+
+	for (edit = nb_config_edits_const_first(&config2->edits); edit;
+	     edit = nb_config_edits_const_next(&config2->edits, edit)) {
+		if (nb_config_edit_covered(config2, edit->xpath))
+			continue;
+
+		dnode1 = yang_dnode_get(config1->dnode, edit->xpath);
+		dnode2 = yang_dnode_get(config2->dnode, edit->xpath);
+		if (dnode1 && dnode2) {
+			diff = NULL;
+			err = lyd_diff_tree(dnode1, dnode2, LYD_DIFF_DEFAULTS,
+					    &diff);
+			assert(!err);
+			nb_config_diff_walk(diff, config1, config2, &seq,
+					    changes);
+			lyd_free_all(diff);
+		} else if (dnode1)
+			nb_config_diff_deleted(dnode1, &seq, changes);
+		else if (dnode2)
+			nb_config_diff_created(dnode2, &seq, changes);
+	}
+
+	return true;
+}
+
+/* Calculate the delta between two different configurations. */
+static void nb_config_diff(const struct nb_config *config1,
+			   const struct nb_config *config2,
+			   struct nb_config_cbs *changes)
+{
+	struct lyd_node *diff = NULL;
+	LY_ERR err;
+
+	if (nb_config_diff_edits(config1, config2, changes))
+		return;
+
+#if 0 /* Useful (noisy) when debugging diff code, and for improving later */
+	const struct lyd_node *root, *dnode;
+
+	if (DEBUG_MODE_CHECK(&nb_dbg_cbs_config, DEBUG_MODE_ALL)) {
+		LY_LIST_FOR(config1->dnode, root) {
+			LYD_TREE_DFS_BEGIN(root, dnode) {
+				nb_config_diff_dnode_log("from", dnode);
+				LYD_TREE_DFS_END(root, dnode);
+			}
+		}
+		LY_LIST_FOR(config2->dnode, root) {
+			LYD_TREE_DFS_BEGIN(root, dnode) {
+				nb_config_diff_dnode_log("to", dnode);
+				LYD_TREE_DFS_END(root, dnode);
+			}
+		}
+	}
+#endif
+
+	err = lyd_diff_siblings(config1->dnode, config2->dnode,
+				LYD_DIFF_DEFAULTS, &diff);
+	assert(!err);
+
+	if (diff && DEBUG_MODE_CHECK(&nb_dbg_cbs_config, DEBUG_MODE_ALL)) {
+		char *s;
+
+		if (!lyd_print_mem(&s, diff, LYD_JSON,
+				   LYD_PRINT_WITHSIBLINGS | LYD_PRINT_WD_ALL)) {
+			zlog_debug("%s: %s", __func__, s);
+			free(s);
+		}
+	}
+
+	uint32_t seq = 0;
+
+	nb_config_diff_walk(diff, config1, config2, &seq, changes);
 
 	lyd_free_all(diff);
 }
@@ -672,6 +874,8 @@ int nb_candidate_edit(struct nb_config *candidate,
 				  xpath_edit, err);
 			return NB_ERR;
 		} else if (dnode) {
+			nb_config_edit_record_dnode(candidate, dnode);
+
 			/* Create default nodes */
 			LY_ERR err = lyd_new_implicit_tree(
 				dnode, LYD_IMPLICIT_NO_STATE, NULL);
@@ -705,9 +909,18 @@ int nb_candidate_edit(struct nb_config *candidate,
 						EC_LIB_LIBYANG,
 						"%s: dependency: lyd_new_path(%s) failed: %d",
 						__func__, dep_xpath, err);
+					nb_config_edits_clear(candidate);
 					return NB_ERR;
 				}
+				if (dep_dnode)
+					nb_config_edit_record_dnode(candidate,
+								    dep_dnode);
 			}
+		} else if (candidate->edits_valid) {
+			/* Nothing was created, but a value may have changed. */
+			dnode = yang_dnode_get(candidate->dnode, xpath_edit);
+			if (dnode)
+				nb_config_edit_record_dnode(candidate, dnode);
 		}
 		break;
 	case NB_OP_DESTROY:
@@ -723,9 +936,13 @@ int nb_candidate_edit(struct nb_config *candidate,
 			nb_node->dep_cbs.get_dependant_xpath(dnode, dep_xpath);
 
 			dep_dnode = yang_dnode_get(candidate->dnode, dep_xpath);
-			if (dep_dnode)
+			if (dep_dnode) {
+				nb_config_edit_record_dnode(candidate,
+							    dep_dnode);
 				lyd_free_tree(dep_dnode);
+			}
 		}
+		nb_config_edit_record_dnode(candidate, dnode);
 		lyd_free_tree(dnode);
 		break;
 	case NB_OP_MOVE:
@@ -771,13 +988,22 @@ int nb_candidate_update(struct nb_config *candidate)
 static int nb_candidate_validate_yang(struct nb_config *candidate, char *errmsg,
 				      size_t errmsg_len)
 {
+	struct lyd_node *diff = NULL;
+
+	/* Keep track of the defaults and when-false nodes it touches. */
 	if (lyd_validate_all(&candidate->dnode, ly_native_ctx,
-			     LYD_VALIDATE_NO_STATE, NULL)
+			     LYD_VALIDATE_NO_STATE,
+			     candidate->edits_valid ? &diff : NULL)
 	    != 0) {
 		yang_print_errors(ly_native_ctx, errmsg, errmsg_len);
+		lyd_free_all(diff);
+		nb_config_edits_clear(candidate);
 		return NB_ERR_VALIDATION;
 	}
 
+	nb_config_edit_record_diff(candidate, diff);
+	lyd_free_all(diff);
+
 	return NB_OK;
 }
 
@@ -787,7 +1013,6 @@ static int nb_candidate_validate_code(struct nb_context *context,
 				      struct nb_config_cbs *changes,
 				      char *errmsg, size_t errmsg_len)
 {
-	struct nb_config_cb *cb;
 	struct lyd_node *root, *child;
 	int ret;
 
@@ -811,14 +1036,10 @@ static int nb_candidate_validate_code(struct nb_context *context,
 	}
 
 	/* Now validate the configuration changes. */
-	RB_FOREACH (cb, nb_config_cbs, changes) {
-		struct nb_config_change *change = (struct nb_config_change *)cb;
-
-		ret = nb_callback_configuration(context, NB_EV_VALIDATE, change,
-						errmsg, errmsg_len);
-		if (ret != NB_OK)
-			return NB_ERR_VALIDATION;
-	}
+	ret = nb_callbacks_configuration(context, NB_EV_VALIDATE, changes,
+					 errmsg, errmsg_len);
+	if (ret != NB_OK)
+		return NB_ERR_VALIDATION;
 
 	return NB_OK;
 }
@@ -900,6 +1121,69 @@ void nb_candidate_commit_abort(struct nb_transaction *transaction, char *errmsg,
 	nb_transaction_free(transaction);
 }
 
+/*
+ * Update the running configuration by copying only the subtrees that were
+ * edited in the candidate. Returns false if that isn't possible, in which
+ * case the caller has to replace the whole configuration (which also undoes
+ * anything done here).
+ */
+static bool nb_config_apply_edits(struct nb_config *running,
+				  const struct nb_config *candidate)
+{
+	const struct nb_config_edit *edit;
+	struct lyd_node *dnode1, *dnode2, *parent, *dup;
+	char xpath[XPATH_MAXLEN];
+
+	if (!candidate->edits_valid
+	    || candidate->edits_version != running->version)
+		return false;
+
+	for (edit = nb_config_edits_const_first(&candidate->edits); edit;
+	     edit = nb_config_edits_const_next(&candidate->edits, edit)) {
+		if (nb_config_edit_covered(candidate, edit->xpath))
+			continue;
+
+		dnode1 = yang_dnode_get(running->dnode, edit->xpath);
+		dnode2 = yang_dnode_get(candidate->dnode, edit->xpath);
+
+		/* Re-inserting would lose the position of the entry. */
+		if (dnode2
+		    && CHECK_FLAG(dnode2->schema->nodetype,
+				  LYS_LIST | LYS_LEAFLIST)
+		    && CHECK_FLAG(dnode2->schema->flags, LYS_ORDBY_USER))
+			return false;
+
+		if (dnode1) {
+			if (running->dnode == dnode1)
+				running->dnode = dnode1->next;
+			lyd_free_tree(dnode1);
+		}
+		if (!dnode2)
+			continue;
+
+		parent = NULL;
+		if (lyd_parent(dnode2)) {
+			yang_dnode_get_path(lyd_parent(dnode2), xpath,
+					    sizeof(xpath));
+			parent = yang_dnode_get(running->dnode, xpath);
+			if (!parent)
+				return false;
+		}
+		if (lyd_dup_single(dnode2, (struct lyd_node_inner *)parent,
+				   LYD_DUP_RECURSIVE, &dup))
+			return false;
+		if (!parent && lyd_insert_sibling(running->dnode, dup,
+						  &running->dnode)) {
+			lyd_free_tree(dup);
+			return false;
+		}
+	}
+
+	running->version = candidate->version;
+
+	return true;
+}
+
 void nb_candidate_commit_apply(struct nb_transaction *transaction,
 			       bool save_transaction, uint32_t *transaction_id,
 			       char *errmsg, size_t errmsg_len)
@@ -910,7 +1194,12 @@ void nb_candidate_commit_apply(struct nb_transaction *transaction,
 
 	/* Replace running by candidate. */
 	transaction->config->version++;
-	nb_config_replace(running_config, transaction->config, true);
+	if (!nb_config_apply_edits(running_config, transaction->config))
+		nb_config_replace(running_config, transaction->config, true);
+	nb_config_edits_clear(running_config);
+
+	/* The candidate now matches running again. */
+	nb_config_edits_copy(transaction->config, running_config);
 
 	/* Record transaction. */
 	if (save_transaction && nb_db_enabled
@@ -1412,6 +1701,230 @@ static int nb_callback_configuration(struct nb_context *context,
 	return ret;
 }
 
+/*
+ * Changes of a transaction processed by one pthread, in transaction order:
+ * either all changes below one concurrent subtree, or all changes outside of
+ * them (run on the main pthread).
+ */
+struct nb_batch {
+	struct nb_context *context;
+	enum nb_event event;
+
+	/* All changes of the transaction, and the ones of this batch. */
+	struct nb_config_change **changes;
+	unsigned int *idx;
+	unsigned int count;
+
+	/* Index of the change that failed, UINT_MAX if none did. */
+	unsigned int failed;
+	int ret;
+	char errmsg[BUFSIZ];
+};
+
+/* Only touched by the main pthread. */
+static struct frr_pthread **nb_workers;
+static unsigned int nb_nworkers;
+
+/* Number of batches still running on the workers. */
+static pthread_mutex_t nb_workers_mtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t nb_workers_cond = PTHREAD_COND_INITIALIZER;
+static unsigned int nb_workers_pending;
+
+/* Topmost node flagged as concurrent above (or at) the given one. */
+static const struct nb_node *
+nb_node_concurrent_root(const struct nb_node *nb_node)
+{
+	const struct nb_node *root = NULL;
+
+	for (; nb_node; nb_node = nb_node->parent)
+		if (CHECK_FLAG(nb_node->flags, F_NB_NODE_CONCURRENT))
+			root = nb_node;
+
+	return root;
+}
+
+static void nb_batch_run(struct nb_batch *batch)
+{
+	for (unsigned int i = 0; i < batch->count; i++) {
+		struct nb_config_change *change = batch->changes[batch->idx[i]];
+		int ret;
+
+		ret = nb_callback_configuration(batch->context, batch->event,
+						change, batch->errmsg,
+						sizeof(batch->errmsg));
+		if (ret != NB_OK) {
+			batch->ret = ret;
+			batch->failed = batch->idx[i];
+			return;
+		}
+		if (batch->event == NB_EV_PREPARE)
+			change->prepare_ok = true;
+	}
+}
+
+static int nb_batch_work(struct thread *thread)
+{
+	nb_batch_run(THREAD_ARG(thread));
+
+	frr_with_mutex(&nb_workers_mtx) {
+		if (--nb_workers_pending == 0)
+			pthread_cond_signal(&nb_workers_cond);
+	}
+	return 0;
+}
+
+/*
+ * Call the validate or prepare callbacks of all configuration changes,
+ * stopping at the first failure.
+ *
+ * The changes below each concurrent subtree are handed to the workers as one
+ * batch, while the main pthread processes the rest. Nothing modifies the
+ * configuration until all batches are done. If several batches fail, the
+ * error of the change coming first in the transaction is returned.
+ */
+static int nb_callbacks_configuration(struct nb_context *context,
+				      const enum nb_event event,
+				      struct nb_config_cbs *changes,
+				      char *errmsg, size_t errmsg_len)
+{
+	struct nb_config_cb *cb;
+	struct nb_config_change **array;
+	const struct nb_node **roots;
+	struct nb_batch *batches, *failed = NULL;
+	unsigned int *idx, *which;
+	unsigned int count = 0, nbatches = 1, i, j, off;
+	int ret = NB_OK;
+
+	if (!nb_nworkers) {
+		RB_FOREACH (cb, nb_config_cbs, changes) {
+			struct nb_config_change *change =
+				(struct nb_config_change *)cb;
+
+			ret = nb_callback_configuration(context, event, change,
+							errmsg, errmsg_len);
+			if (ret != NB_OK)
+				return ret;
+			if (event == NB_EV_PREPARE)
+				change->prepare_ok = true;
+		}
+		return NB_OK;
+	}
+
+	RB_FOREACH (cb, nb_config_cbs, changes)
+		count++;
+	if (!count)
+		return NB_OK;
+
+	array = XMALLOC(MTYPE_NB_WORKERS, count * sizeof(*array));
+	idx = XMALLOC(MTYPE_NB_WORKERS, count * sizeof(*idx));
+	which = XMALLOC(MTYPE_NB_WORKERS, count * sizeof(*which));
+	roots = XMALLOC(MTYPE_NB_WORKERS, (count + 1) * sizeof(*roots));
+
+	/* Group the changes by subtree; there are few distinct ones. */
+	roots[0] = NULL;
+	i = 0;
+	RB_FOREACH (cb, nb_config_cbs, changes) {
+		const struct nb_node *root;
+
+		array[i] = (struct nb_config_change *)cb;
+		root = nb_node_concurrent_root(cb->nb_node);
+		for (j = 0; j < nbatches; j++)
+			if (roots[j] == root)
+				break;
+		if (j == nbatches)
+			roots[nbatches++] = root;
+		which[i++] = j;
+	}
+
+	batches = XCALLOC(MTYPE_NB_WORKERS, nbatches * sizeof(*batches));
+	for (i = 0; i < count; i++)
+		batches[which[i]].count++;
+	for (j = 0, off = 0; j < nbatches; j++) {
+		batches[j].context = context;
+		batches[j].event = event;
+		batches[j].changes = array;
+		batches[j].idx = idx + off;
+		batches[j].failed = UINT_MAX;
+		batches[j].ret = NB_OK;
+		off += batches[j].count;
+		batches[j].count = 0;
+	}
+	for (i = 0; i < count; i++) {
+		struct nb_batch *batch = &batches[which[i]];
+
+		batch->idx[batch->count++] = i;
+	}
+
+	frr_with_mutex(&nb_workers_mtx) {
+		nb_workers_pending = nbatches - 1;
+	}
+	for (j = 1; j < nbatches; j++)
+		thread_add_event(nb_workers[(j - 1) % nb_nworkers]->master,
+				 nb_batch_work, &batches[j], 0, NULL);
+
+	nb_batch_run(&batches[0]);
+
+	frr_with_mutex(&nb_workers_mtx) {
+		while (nb_workers_pending)
+			pthread_cond_wait(&nb_workers_cond, &nb_workers_mtx);
+	}
+
+	for (j = 0; j < nbatches; j++)
+		if (batches[j].ret != NB_OK
+		    && (!failed || batches[j].failed < failed->failed))
+			failed = &batches[j];
+	if (failed) {
+		ret = failed->ret;
+		strlcpy(errmsg, failed->errmsg, errmsg_len);
+	}
+
+	XFREE(MTYPE_NB_WORKERS, batches);
+	XFREE(MTYPE_NB_WORKERS, roots);
+	XFREE(MTYPE_NB_WORKERS, which);
+	XFREE(MTYPE_NB_WORKERS, idx);
+	XFREE(MTYPE_NB_WORKERS, array);
+
+	return ret;
+}
+
+void nb_workers_set(unsigned int nworkers)
+{
+	struct frr_pthread_attr attr = {
+		.start = frr_pthread_attr_default.start,
+		.stop = frr_pthread_attr_default.stop,
+	};
+	char name[32], os_name[OS_THREAD_NAMELEN];
+	unsigned int i;
+
+	if (nworkers > NB_WORKERS_MAX)
+		nworkers = NB_WORKERS_MAX;
+	if (nworkers == nb_nworkers)
+		return;
+
+	/* The workers carry no state, so resizing is just rebuilding. */
+	for (i = 0; i < nb_nworkers; i++) {
+		frr_pthread_stop(nb_workers[i], NULL);
+		frr_pthread_destroy(nb_workers[i]);
+	}
+	XFREE(MTYPE_NB_WORKERS, nb_workers);
+	nb_nworkers = 0;
+
+	if (!nworkers)
+		return;
+
+	nb_workers = XCALLOC(MTYPE_NB_WORKERS, nworkers * sizeof(*nb_workers));
+	for (i = 0; i < nworkers; i++) {
+		snprintf(name, sizeof(name), "Northbound worker %u", i);
+		snprintf(os_name, sizeof(os_name), "nb_worker%u", i);
+		nb_workers[i] = frr_pthread_new(&attr, name, os_name);
+		frr_pthread_run(nb_workers[i], NULL);
+	}
+	for (i = 0; i < nworkers; i++)
+		frr_pthread_wait_running(nb_workers[i]);
+
+	nb_nworkers = nworkers;
+}
+
 static struct nb_transaction *
 nb_transaction_new(struct nb_context *context, struct nb_config *config,
 		   struct nb_config_cbs *changes, const char *comment,
@@ -1459,26 +1972,27 @@ static int nb_transaction_process(enum nb_event event,
 {
 	struct nb_config_cb *cb;
 
+	/* Preparation can be spread over the workers. */
+	if (event == NB_EV_PREPARE)
+		return nb_callbacks_configuration(transaction->context, event,
+						  &transaction->changes, errmsg,
+						  errmsg_len);
+
 	RB_FOREACH (cb, nb_config_cbs, &transaction->changes) {
 		struct nb_config_change *change = (struct nb_config_change *)cb;
-		int ret;
 
 		/*
 		 * Only try to release resources that were allocated
-		 * successfully.
+		 * successfully. With workers, changes following a failed one
+		 * may have been prepared too.
 		 */
 		if (event == NB_EV_ABORT && !change->prepare_ok)
-			break;
+			continue;
 
 		/* Call the appropriate callback. */
-		ret = nb_callback_configuration(transaction->context, event,
+		(void)nb_callback_configuration(transaction->context, event,
 						change, errmsg, errmsg_len);
 		switch (event) {
-		case NB_EV_PREPARE:
-			if (ret != NB_OK)
-				return ret;
-			change->prepare_ok = true;
-			break;
 		case NB_EV_ABORT:
 		case NB_EV_APPLY:
 			/*
@@ -2408,6 +2922,8 @@ static void nb_load_callbacks(const struct frr_yang_module_info *module)
 		priority = module->nodes[i].priority;
 		if (priority != 0)
 			nb_node->priority = priority;
+		if (module->nodes[i].concurrent)
+			SET_FLAG(nb_node->flags, F_NB_NODE_CONCURRENT);
 	}
 }
 
@@ -2448,9 +2964,12 @@ void nb_init(struct thread_master *tm,
 
 	/* Load YANG modules and their corresponding northbound callbacks. */
 	for (size_t i = 0; i < nmodules; i++) {
-		DEBUGD(&nb_dbg_events, "northbound: loading %s.yang",
-		       modules[i]->name);
+		struct timeval begin;
+
+		monotime(&begin);
 		*loadedp++ = yang_module_load(modules[i]->name);
+		DEBUGD(&nb_dbg_events, "northbound: loaded %s.yang in %" PRId64
+		       " us", modules[i]->name, monotime_since(&begin, NULL));
 	}
 
 	if (explicit_compile)
@@ -2478,6 +2997,9 @@ void nb_init(struct thread_master *tm,
 
 void nb_terminate(void)
 {
+	/* Stop the workers. */
+	nb_workers_set(0);
+
 	/* Terminate the northbound CLI. */
 	nb_cli_terminate();
 
@@ -570,6 +570,8 @@ struct nb_node {
 #define F_NB_NODE_CONFIG_ONLY 0x01
 /* The YANG list doesn't contain key leafs. */
 #define F_NB_NODE_KEYLESS_LIST 0x02
+/* Validate/prepare callbacks of this subtree can run on worker pthreads. */
+#define F_NB_NODE_CONCURRENT 0x04
 
 /*
  * HACK: old gcc versions (< 5.x) have a bug that prevents C99 flexible arrays
@@ -592,6 +594,15 @@ struct frr_yang_module_info {
 
 		/* Priority - lower priorities are processed first. */
 		uint32_t priority;
+
+		/*
+		 * The validate and prepare callbacks of this subtree only look
+		 * at their own data nodes and state, so they can run on the
+		 * northbound worker pthreads while other subtrees of the same
+		 * transaction are processed.  Apply and abort callbacks always
+		 * run on the main pthread, in transaction order.
+		 */
+		bool concurrent;
 #if defined(__GNUC__) && ((__GNUC__ - 0) < 5) && !defined(__clang__)
 	} nodes[YANG_MODULE_MAX_NODES + 1];
 #else
@@ -614,6 +625,9 @@ enum nb_error {
 /* Default priority. */
 #define NB_DFLT_PRIORITY (UINT32_MAX / 2)
 
+/* Maximum number of northbound worker pthreads. */
+#define NB_WORKERS_MAX 64
+
 /* Default maximum of configuration rollbacks to store. */
 #define NB_DLFT_MAX_CONFIG_ROLLBACKS 20
 
@@ -652,10 +666,33 @@ struct nb_context {
 #endif
 };
 
+PREDECL_DLIST(nb_config_edits);
+PREDECL_HASH(nb_config_edits_hash);
+
+/* Path of a subtree that was edited since the config was copied. */
+struct nb_config_edit {
+	struct nb_config_edits_item item;
+	struct nb_config_edits_hash_item hitem;
+	char *xpath;
+};
+
+/* Give up tracking edits after this many, a full diff is cheaper then. */
+#define NB_CONFIG_EDITS_MAX 1024
+
 /* Northbound configuration. */
 struct nb_config {
 	struct lyd_node *dnode;
 	uint32_t version;
+
+	/*
+	 * When edits_valid is set, the configuration is a copy of the running
+	 * configuration at version edits_version plus the recorded edits,
+	 * which lets commits compare and copy only those subtrees.
+	 */
+	bool edits_valid;
+	uint32_t edits_version;
+	struct nb_config_edits_head edits;
+	struct nb_config_edits_hash_head edits_hash;
 };
 
 /* Northbound configuration callback. */
@@ -1302,6 +1339,17 @@ extern void nb_init(struct thread_master *tm,
 		    const struct frr_yang_module_info *const modules[],
 		    size_t nmodules, bool db_enabled);
 
+/*
+ * Set the number of worker pthreads running the validate and prepare
+ * callbacks of concurrent subtrees (see the "concurrent" flag of
+ * frr_yang_module_info). With 0 workers, all callbacks run on the main
+ * pthread.
+ *
+ * nworkers
+ *    Number of worker pthreads, up to NB_WORKERS_MAX.
+ */
+extern void nb_workers_set(unsigned int nworkers);
+
 /*
  * Finish the northbound layer gracefully. Should be called only when the daemon
  * is exiting.
@@ -38,6 +38,8 @@
 #include <string>
 
 #define GRPC_DEFAULT_PORT 50051
+#define GRPC_DEFAULT_CALLS 4
+#define GRPC_MAX_CALLS 64
 
 /*
  * NOTE: we can't use the FRR debugging infrastructure here since it uses
@@ -116,7 +118,7 @@ class Candidates
 class RpcStateBase
 {
       public:
-	virtual CallState doCallback() = 0;
+	virtual CallState doCallback(bool ok) = 0;
 	virtual void do_request(::frr::Northbound::AsyncService *service,
 				::grpc::ServerCompletionQueue *cq) = 0;
 };
@@ -146,13 +148,37 @@ template <typename Q, typename S> class NewRpcState : RpcStateBase
 	    : requestsf(rfunc), callback(cb), responder(&ctx),
 	      async_responder(&ctx), name(name), cdb(cdb){};
 
-	CallState doCallback() override
+	CallState doCallback(bool ok) override
 	{
+		/*
+		 * Wait for the main thread to be done with whatever step of
+		 * the RPC produced this completion; it holds the lock while
+		 * it runs the callback.
+		 */
+		pthread_mutex_lock(&this->cmux);
+
 		CallState enter_state = this->state;
 		CallState new_state;
+		if (!ok && enter_state == CREATE) {
+			/* The server is shutting down, there's no call. */
+			pthread_mutex_unlock(&this->cmux);
+			grpc_debug("%s RPC: -> [DELETED]", name);
+			delete this;
+			return DELETED;
+		}
+		if (!ok && enter_state == MORE) {
+			/* The client went away, clean up. */
+			grpc_debug("%s RPC cancelled", name);
+			enter_state = FINISH;
+		}
 		if (enter_state == FINISH) {
 			grpc_debug("%s RPC FINISH -> DELETED", name);
 			new_state = FINISH;
+			/*
+			 * Our side is done, receive new requests of this type
+			 * in our slot before the main thread deletes us.
+			 */
+			do_request(service, cq);
 		} else {
 			grpc_debug("%s RPC: %s -> PROCESS", name,
 				   call_states[this->state]);
@@ -161,30 +187,18 @@ template <typename Q, typename S> class NewRpcState : RpcStateBase
 		/*
 		 * We are either in state CREATE, MORE or FINISH. If CREATE or
 		 * MORE move back to PROCESS, otherwise we are cleaning up
-		 * (FINISH) so leave it in that state. Run the callback on the
-		 * main threadmaster/pthread; and wait for expected transition
-		 * from main thread. If transition is to FINISH->DELETED.
-		 * delete us.
-		 *
-		 * We update the state prior to scheduling the callback which
-		 * may then update the state in the master pthread. Then we
-		 * obtain the lock in the condvar-check-loop as the callback
-		 * will be modifying updating the state value.
+		 * (FINISH) so leave it in that state. Then run the callback
+		 * on the main threadmaster/pthread without waiting for it, so
+		 * that other RPCs keep flowing through the completion queue
+		 * while this one is being handled. The callback deletes us
+		 * once it moves us to DELETED.
 		 */
 		this->state = new_state;
-		thread_add_event(main_master, c_callback, (void *)this, 0,
-				 NULL);
-		pthread_mutex_lock(&this->cmux);
-		while (this->state == new_state)
-			pthread_cond_wait(&this->cond, &this->cmux);
 		pthread_mutex_unlock(&this->cmux);
 
-		if (this->state == DELETED) {
-			grpc_debug("%s RPC: -> [DELETED]", name);
-			delete this;
-			return DELETED;
-		}
-		return this->state;
+		thread_add_event(main_master, c_callback, (void *)this, 0,
+				 NULL);
+		return new_state;
 	}
 
 	void do_request(::frr::Northbound::AsyncService *service,
@@ -194,11 +208,15 @@ template <typename Q, typename S> class NewRpcState : RpcStateBase
 		if (requestf) {
 			NewRpcState<Q, S> *copy =
 				new NewRpcState(cdb, requestf, callback, name);
+			copy->service = service;
+			copy->cq = cq;
 			(service->*requestf)(&copy->ctx, &copy->request,
 					     &copy->responder, cq, cq, copy);
 		} else {
 			NewRpcState<Q, S> *copy =
 				new NewRpcState(cdb, requestsf, callback, name);
+			copy->service = service;
+			copy->cq = cq;
 			(service->*requestsf)(&copy->ctx, &copy->request,
 					      &copy->async_responder, cq, cq,
 					      copy);
@@ -223,8 +241,12 @@ template <typename Q, typename S> class NewRpcState : RpcStateBase
 		grpc_debug("%s RPC: %s -> %s", _tag->name,
 			   call_states[enter_state], call_states[_tag->state]);
 
-		pthread_cond_signal(&_tag->cond);
 		pthread_mutex_unlock(&_tag->cmux);
+
+		if (_tag->state == DELETED) {
+			grpc_debug("%s RPC: -> [DELETED]", _tag->name);
+			delete _tag;
+		}
 		return 0;
 	}
 	NewRpcState<Q, S> *orig;
@@ -237,13 +259,15 @@ template <typename Q, typename S> class NewRpcState : RpcStateBase
 	grpc::ServerAsyncWriter<S> async_responder;
 
 	Candidates *cdb;
+	::frr::Northbound::AsyncService *service;
+	::grpc::ServerCompletionQueue *cq;
 	void (*callback)(NewRpcState<Q, S> *);
 	reqfunc_t requestf;
 	reqsfunc_t requestsf;
 
 	pthread_mutex_t cmux = PTHREAD_MUTEX_INITIALIZER;
-	pthread_cond_t cond = PTHREAD_COND_INITIALIZER;
 	void *context;
+	bool sample = false;
 
 	CallState state = CREATE;
 };
@@ -501,6 +525,15 @@ void HandleUnaryGetCapabilities(NewRpcState<frr::GetCapabilitiesRequest,
 	tag->state = FINISH;
 }
 
+static void get_paths_fill(std::list<std::string> *mypaths,
+			   const frr::GetRequest &request)
+{
+	auto paths = request.path();
+	for (const std::string &path : paths) {
+		mypaths->push_back(std::string(path));
+	}
+}
+
 void HandleStreamingGet(NewRpcState<frr::GetRequest, frr::GetResponse> *tag)
 {
 	grpc_debug("%s: state: %s", __func__, call_states[tag->state]);
@@ -511,14 +544,21 @@ void HandleStreamingGet(NewRpcState<frr::GetRequest, frr::GetResponse> *tag)
 		return;
 	}
 
+	if (tag->sample) {
+		typedef NewRpcState<frr::GetRequest, frr::GetResponse> GetState;
+
+		/* Last sample sent, wait for the next one. */
+		tag->sample = false;
+		thread_add_timer(main_master, GetState::c_callback, tag,
+				 tag->request.interval(), NULL);
+		return;
+	}
+
 	if (!tag->context) {
 		/* Creating, first time called for this RPC */
 		auto mypaths = new std::list<std::string>();
 		tag->context = mypaths;
-		auto paths = tag->request.path();
-		for (const std::string &path : paths) {
-			mypaths->push_back(std::string(path));
-		}
+		get_paths_fill(mypaths, tag->request);
 	}
 
 	// Request: DataType type = 1;
@@ -528,7 +568,15 @@ void HandleStreamingGet(NewRpcState<frr::GetRequest, frr::GetResponse> *tag)
 	// Request: bool with_defaults = 3;
 	bool with_defaults = tag->request.with_defaults();
 
+	// Request: uint32 interval = 5;
+	uint32_t interval = tag->request.interval();
+
 	auto mypathps = static_cast<std::list<std::string> *>(tag->context);
+	if (interval && tag->ctx.IsCancelled()) {
+		tag->async_responder.Finish(grpc::Status::CANCELLED, tag);
+		tag->state = FINISH;
+		return;
+	}
 	if (mypathps->empty()) {
 		tag->async_responder.Finish(grpc::Status::OK, tag);
 		tag->state = FINISH;
@@ -555,7 +603,16 @@ void HandleStreamingGet(NewRpcState<frr::GetRequest, frr::GetResponse> *tag)
 	}
 
 	mypathps->pop_back();
-	if (mypathps->empty()) {
+	if (mypathps->empty() && interval) {
+		/*
+		 * Sample subscription: send everything again once the interval
+		 * has passed, until the client cancels the call.
+		 */
+		get_paths_fill(mypathps, tag->request);
+		tag->async_responder.Write(response, tag);
+		tag->state = MORE;
+		tag->sample = true;
+	} else if (mypathps->empty()) {
 		tag->async_responder.WriteAndFinish(
 			response, grpc::WriteOptions(), grpc::Status::OK, tag);
 		tag->state = FINISH;
@@ -1216,13 +1273,19 @@ void HandleUnaryExecute(
 // ------------------------------------------------------
 
 
+/*
+ * Post "calls" requests of each type, so that many RPCs of the same type can
+ * be in flight at once; each finished RPC posts a new request in its place.
+ */
 #define REQUEST_NEWRPC(NAME, cdb)                                              \
 	do {                                                                   \
 		auto _rpcState = new NewRpcState<frr::NAME##Request,           \
 						 frr::NAME##Response>(         \
 			(cdb), &frr::Northbound::AsyncService::Request##NAME,  \
 			&HandleUnary##NAME, #NAME);                            \
-		_rpcState->do_request(service, s_cq);                          \
+		for (uint _i = 0; _i < calls; _i++)                            \
+			_rpcState->do_request(service, s_cq);                  \
+		delete _rpcState;                                              \
 	} while (0)
 
 #define REQUEST_NEWRPC_STREAMING(NAME, cdb)                                    \
@@ -1231,7 +1294,9 @@ void HandleUnaryExecute(
 						 frr::NAME##Response>(         \
 			(cdb), &frr::Northbound::AsyncService::Request##NAME,  \
 			&HandleStreaming##NAME, #NAME);                        \
-		_rpcState->do_request(service, s_cq);                          \
+		for (uint _i = 0; _i < calls; _i++)                            \
+			_rpcState->do_request(service, s_cq);                  \
+		delete _rpcState;                                              \
 	} while (0)
 
 struct grpc_pthread_attr {
@@ -1239,6 +1304,9 @@ struct grpc_pthread_attr {
 	unsigned long port;
 };
 
+/* Number of RPCs of each type that can be in flight at once */
+static uint calls = GRPC_DEFAULT_CALLS;
+
 // Capture these objects so we can try to shut down cleanly
 static std::unique_ptr<grpc::Server> s_server;
 static grpc::ServerCompletionQueue *s_cq;
@@ -1287,27 +1355,16 @@ static void *grpc_pthread_start(void *arg)
 		void *tag;
 		bool ok;
 
-		s_cq->Next(&tag, &ok);
-		if (!ok)
+		if (!s_cq->Next(&tag, &ok))
 			break;
 
 		grpc_debug("%s: Got next from CompletionQueue, %p %d", __func__,
 			   tag, ok);
 
 		RpcStateBase *rpc = static_cast<RpcStateBase *>(tag);
-		CallState state = rpc->doCallback();
+		CallState state = rpc->doCallback(ok);
 		grpc_debug("%s: Callback returned RPC State: %s", __func__,
 			   call_states[state]);
-
-		/*
-		 * Our side is done (FINISH) receive new requests of this type
-		 * We could do this earlier but that would mean we could be
-		 * handling multiple same type requests in parallel. We expect
-		 * to be called back once more in the FINISH state (from the
-		 * user indicating Finish() for cleanup.
-		 */
-		if (state == FINISH)
-			rpc->do_request(service, s_cq);
 	}
 
 	return NULL;
@@ -1369,14 +1426,26 @@ static int frr_grpc_module_very_late_init(struct thread *thread)
 	const char *args = THIS_MODULE->load_args;
 	uint port = GRPC_DEFAULT_PORT;
 
+	/* PORT[,CALLS] */
 	if (args) {
-		port = std::stoul(args);
+		size_t pos = 0;
+
+		port = std::stoul(args, &pos);
 		if (port < 1024 || port > UINT16_MAX) {
 			flog_err(EC_LIB_GRPC_INIT,
 				 "%s: port number must be between 1025 and %d",
 				 __func__, UINT16_MAX);
 			goto error;
 		}
+		if (args[pos] == ',') {
+			calls = std::stoul(args + pos + 1);
+			if (calls < 1 || calls > GRPC_MAX_CALLS) {
+				flog_err(EC_LIB_GRPC_INIT,
+					 "%s: number of calls must be between 1 and %d",
+					 __func__, GRPC_MAX_CALLS);
+				goto error;
+			}
+		}
 	}
 
 	if (frr_grpc_init(port) < 0)
@@ -32,38 +32,43 @@
 
 #define pos (*posx)
 
+/* decimal digits of each byte value, NUL-padded to 4 bytes for memcpy */
+static const char ntop_dec[256][4] = {
+	"0", "1", "2", "3", "4", "5", "6", "7", "8", "9",
+	"10", "11", "12", "13", "14", "15", "16", "17", "18", "19",
+	"20", "21", "22", "23", "24", "25", "26", "27", "28", "29",
+	"30", "31", "32", "33", "34", "35", "36", "37", "38", "39",
+	"40", "41", "42", "43", "44", "45", "46", "47", "48", "49",
+	"50", "51", "52", "53", "54", "55", "56", "57", "58", "59",
+	"60", "61", "62", "63", "64", "65", "66", "67", "68", "69",
+	"70", "71", "72", "73", "74", "75", "76", "77", "78", "79",
+	"80", "81", "82", "83", "84", "85", "86", "87", "88", "89",
+	"90", "91", "92", "93", "94", "95", "96", "97", "98", "99",
+	"100", "101", "102", "103", "104", "105", "106", "107", "108", "109",
+	"110", "111", "112", "113", "114", "115", "116", "117", "118", "119",
+	"120", "121", "122", "123", "124", "125", "126", "127", "128", "129",
+	"130", "131", "132", "133", "134", "135", "136", "137", "138", "139",
+	"140", "141", "142", "143", "144", "145", "146", "147", "148", "149",
+	"150", "151", "152", "153", "154", "155", "156", "157", "158", "159",
+	"160", "161", "162", "163", "164", "165", "166", "167", "168", "169",
+	"170", "171", "172", "173", "174", "175", "176", "177", "178", "179",
+	"180", "181", "182", "183", "184", "185", "186", "187", "188", "189",
+	"190", "191", "192", "193", "194", "195", "196", "197", "198", "199",
+	"200", "201", "202", "203", "204", "205", "206", "207", "208", "209",
+	"210", "211", "212", "213", "214", "215", "216", "217", "218", "219",
+	"220", "221", "222", "223", "224", "225", "226", "227", "228", "229",
+	"230", "231", "232", "233", "234", "235", "236", "237", "238", "239",
+	"240", "241", "242", "243", "244", "245", "246", "247", "248", "249",
+	"250", "251", "252", "253", "254", "255",
+};
+
 static inline void putbyte(uint8_t bytex, char **posx)
 	__attribute__((always_inline)) OPTIMIZE;
 
 static inline void putbyte(uint8_t bytex, char **posx)
 {
-	bool zero = false;
-	int byte = bytex, tmp, a, b;
-
-	tmp = byte - 200;
-	if (tmp >= 0) {
-		*pos++ = '2';
-		zero = true;
-		byte = tmp;
-	} else {
-		tmp = byte - 100;
-		if (tmp >= 0) {
-			*pos++ = '1';
-			zero = true;
-			byte = tmp;
-		}
-	}
-
-	/* make sure the compiler knows the value range of "byte" */
-	assume(byte < 100 && byte >= 0);
-
-	b = byte % 10;
-	a = byte / 10;
-	if (a || zero) {
-		*pos++ = '0' + a;
-		*pos++ = '0' + b;
-	} else
-		*pos++ = '0' + b;
+	memcpy(pos, ntop_dec[bytex], 4);
+	pos += 1 + (bytex >= 10) + (bytex >= 100);
 }
 
 static inline void puthex(uint16_t word, char **posx)
@@ -97,7 +102,8 @@ const char *frr_inet_ntop(int af, const void * restrict src,
 	 * it's shorter.
 	 */
 	char buf[8 * 5], *o = buf;
-	size_t best = 0, bestlen = 0, curlen = 0, i;
+	size_t best, bestlen = 0, i;
+	unsigned int zeroes = 0, run, starts = 0;
 
 	switch (af) {
 	case AF_INET:
@@ -112,21 +118,17 @@ inet4:
 		*o++ = '\0';
 		break;
 	case AF_INET6:
-		for (i = 0; i < 8; i++) {
-			if (b[i * 2] || b[i * 2 + 1]) {
-				if (curlen && curlen > bestlen) {
-					best = i - curlen;
-					bestlen = curlen;
-				}
-				curlen = 0;
-				continue;
-			}
-			curlen++;
-		}
-		if (curlen && curlen > bestlen) {
-			best = i - curlen;
-			bestlen = curlen;
+		/* bit i set: word i is zero, runs of zero words narrowed down
+		 * until only the start of the longest (first) one is left
+		 */
+		for (i = 0; i < 8; i++)
+			zeroes |= (unsigned int)!(b[i * 2] | b[i * 2 + 1]) << i;
+		for (run = zeroes; run; run &= run >> 1) {
+			starts = run;
+			bestlen++;
 		}
+		best = starts ? __builtin_ctz(starts) : 0;
+
 		/* do we want ::ffff:A.B.C.D? */
 		if (best == 0 && bestlen == 6) {
 			*o++ = ':';
@@ -142,9 +144,7 @@ inet4:
 				if (i == 0)
 					*o++ = ':';
 				*o++ = ':';
-				continue;
-			}
-			if (i > best && i < best + bestlen) {
+				i += bestlen - 1;
 				continue;
 			}
 			puthex((b[i * 2] << 8) | b[i * 2 + 1], &o);
@@ -30,33 +30,13 @@
 #include "routemap.h"
 #include "lib/json.h"
 #include "libfrr.h"
+#include "table.h"
 
 #include "plist_int.h"
 
 DEFINE_MTYPE_STATIC(LIB, PREFIX_LIST, "Prefix List");
 DEFINE_MTYPE_STATIC(LIB, MPREFIX_LIST_STR, "Prefix List Str");
 DEFINE_MTYPE_STATIC(LIB, PREFIX_LIST_ENTRY, "Prefix List Entry");
-DEFINE_MTYPE_STATIC(LIB, PREFIX_LIST_TRIE, "Prefix List Trie Table");
-
-/* not currently changeable, code assumes bytes further down */
-#define PLC_BITS	8
-#define PLC_LEN		(1 << PLC_BITS)
-#define PLC_MAXLEVELV4	2	/* /24 for IPv4 */
-#define PLC_MAXLEVELV6	4	/* /48 for IPv6 */
-#define PLC_MAXLEVEL	4	/* max(v4,v6) */
-
-struct pltrie_entry {
-	union {
-		struct pltrie_table *next_table;
-		struct prefix_list_entry *final_chain;
-	};
-
-	struct prefix_list_entry *up_chain;
-};
-
-struct pltrie_table {
-	struct pltrie_entry entries[PLC_LEN];
-};
 
 /* List of struct prefix_list. */
 struct prefix_list_list {
@@ -77,29 +57,26 @@ struct prefix_master {
 
 	/* Hook function which is executed when prefix_list is deleted. */
 	void (*delete_hook)(struct prefix_list *);
-
-	/* number of bytes that have a trie level */
-	size_t trie_depth;
 };
 
 /* Static structure of IPv4 prefix_list's master. */
 static struct prefix_master prefix_master_ipv4 = {
-	{NULL, NULL}, NULL, NULL, NULL, PLC_MAXLEVELV4,
+	{NULL, NULL}, NULL, NULL, NULL,
 };
 
 /* Static structure of IPv6 prefix-list's master. */
 static struct prefix_master prefix_master_ipv6 = {
-	{NULL, NULL}, NULL, NULL, NULL, PLC_MAXLEVELV6,
+	{NULL, NULL}, NULL, NULL, NULL,
 };
 
 /* Static structure of BGP ORF prefix_list's master. */
 static struct prefix_master prefix_master_orf_v4 = {
-	{NULL, NULL}, NULL, NULL, NULL, PLC_MAXLEVELV4,
+	{NULL, NULL}, NULL, NULL, NULL,
 };
 
 /* Static structure of BGP ORF prefix_list's master. */
 static struct prefix_master prefix_master_orf_v6 = {
-	{NULL, NULL}, NULL, NULL, NULL, PLC_MAXLEVELV6,
+	{NULL, NULL}, NULL, NULL, NULL,
 };
 
 static struct prefix_master *prefix_master_get(afi_t afi, int orf)
@@ -200,8 +177,7 @@ static struct prefix_list *prefix_list_insert(afi_t afi, int orf,
 	plist = prefix_list_new();
 	plist->name = XSTRDUP(MTYPE_MPREFIX_LIST_STR, name);
 	plist->master = master;
-	plist->trie =
-		XCALLOC(MTYPE_PREFIX_LIST_TRIE, sizeof(struct pltrie_table));
+	plist->trie = route_table_init();
 
 	/* Set prefix_list to string list. */
 	list = &master->str;
@@ -303,7 +279,7 @@ void prefix_list_delete(struct prefix_list *plist)
 
 	XFREE(MTYPE_MPREFIX_LIST_STR, plist->name);
 
-	XFREE(MTYPE_PREFIX_LIST_TRIE, plist->trie);
+	route_table_finish(plist->trie);
 
 	prefix_list_free(plist);
 }
@@ -347,14 +323,9 @@ int64_t prefix_new_seq_get(struct prefix_list *plist)
 {
 	int64_t maxseq;
 	int64_t newseq;
-	struct prefix_list_entry *pentry;
 
-	maxseq = 0;
-
-	for (pentry = plist->head; pentry; pentry = pentry->next) {
-		if (maxseq < pentry->seq)
-			maxseq = pentry->seq;
-	}
+	/* the list is sorted by sequence number */
+	maxseq = plist->tail ? plist->tail->seq : 0;
 
 	newseq = ((maxseq / 5) * 5) + 5;
 
@@ -397,70 +368,33 @@ prefix_list_entry_lookup(struct prefix_list *plist, struct prefix *prefix,
 	return NULL;
 }
 
-static void trie_walk_affected(size_t validbits, struct pltrie_table *table,
-			       uint8_t byte, struct prefix_list_entry *object,
-			       void (*fn)(struct prefix_list_entry *object,
-					  struct prefix_list_entry **updptr))
-{
-	uint8_t mask;
-	uint16_t bwalk;
-
-	if (validbits > PLC_BITS) {
-		fn(object, &table->entries[byte].final_chain);
-		return;
-	}
-
-	mask = (1 << (8 - validbits)) - 1;
-	for (bwalk = byte & ~mask; bwalk <= byte + mask; bwalk++) {
-		fn(object, &table->entries[bwalk].up_chain);
-	}
-}
-
-static void trie_uninstall_fn(struct prefix_list_entry *object,
-			      struct prefix_list_entry **updptr)
-{
-	for (; *updptr; updptr = &(*updptr)->next_best)
-		if (*updptr == object) {
-			*updptr = object->next_best;
-			break;
-		}
-}
-
-static int trie_table_empty(struct pltrie_table *table)
-{
-	size_t i;
-	for (i = 0; i < PLC_LEN; i++)
-		if (table->entries[i].next_table || table->entries[i].up_chain)
-			return 0;
-	return 1;
-}
-
+/* Entries hang off the trie node for their prefix, chained by sequence
+ * number through next_best.  Each node with entries holds one lock.
+ */
 static void prefix_list_trie_del(struct prefix_list *plist,
 				 struct prefix_list_entry *pentry)
 {
-	size_t depth, maxdepth = plist->master->trie_depth;
-	uint8_t *bytes = pentry->prefix.u.val;
-	size_t validbits = pentry->prefix.prefixlen;
-	struct pltrie_table *table, **tables[PLC_MAXLEVEL];
+	struct prefix_list_entry *prev = NULL, *cur;
+	struct route_node *rn;
 
-	table = plist->trie;
-	for (depth = 0; validbits > PLC_BITS && depth < maxdepth - 1; depth++) {
-		uint8_t byte = bytes[depth];
-		assert(table->entries[byte].next_table);
-
-		tables[depth + 1] = &table->entries[byte].next_table;
-		table = table->entries[byte].next_table;
+	rn = route_node_lookup(plist->trie, &pentry->prefix);
+	if (!rn)
+		return;
 
-		validbits -= PLC_BITS;
-	}
+	for (cur = rn->info; cur && cur != pentry; cur = cur->next_best)
+		prev = cur;
 
-	trie_walk_affected(validbits, table, bytes[depth], pentry,
-			   trie_uninstall_fn);
+	if (cur) {
+		if (prev)
+			prev->next_best = cur->next_best;
+		else
+			rn->info = cur->next_best;
+		cur->next_best = NULL;
 
-	for (; depth > 0; depth--)
-		if (trie_table_empty(*tables[depth])) {
-			XFREE(MTYPE_PREFIX_LIST_TRIE, *tables[depth]);
-		}
+		if (!rn->info)
+			route_unlock_node(rn);
+	}
+	route_unlock_node(rn);
 }
 
 
@@ -502,49 +436,28 @@ void prefix_list_entry_delete(struct prefix_list *plist,
 	}
 }
 
-static void trie_install_fn(struct prefix_list_entry *object,
-			    struct prefix_list_entry **updptr)
+static void prefix_list_trie_add(struct prefix_list *plist,
+				 struct prefix_list_entry *pentry)
 {
-	while (*updptr) {
-		if (*updptr == object)
+	struct prefix_list_entry *prev = NULL, *cur;
+	struct route_node *rn;
+
+	rn = route_node_get(plist->trie, &pentry->prefix);
+	if (rn->info)
+		route_unlock_node(rn);
+
+	for (cur = rn->info; cur; prev = cur, cur = cur->next_best) {
+		if (cur == pentry)
 			return;
-		if ((*updptr)->prefix.prefixlen < object->prefix.prefixlen)
-			break;
-		if ((*updptr)->prefix.prefixlen == object->prefix.prefixlen
-		    && (*updptr)->seq > object->seq)
+		if (cur->seq > pentry->seq)
 			break;
-		updptr = &(*updptr)->next_best;
 	}
 
-	if (!object->next_best)
-		object->next_best = *updptr;
+	pentry->next_best = cur;
+	if (prev)
+		prev->next_best = pentry;
 	else
-		assert(object->next_best == *updptr || !*updptr);
-
-	*updptr = object;
-}
-
-static void prefix_list_trie_add(struct prefix_list *plist,
-				 struct prefix_list_entry *pentry)
-{
-	size_t depth = plist->master->trie_depth;
-	uint8_t *bytes = pentry->prefix.u.val;
-	size_t validbits = pentry->prefix.prefixlen;
-	struct pltrie_table *table;
-
-	table = plist->trie;
-	while (validbits > PLC_BITS && depth > 1) {
-		if (!table->entries[*bytes].next_table)
-			table->entries[*bytes].next_table =
-				XCALLOC(MTYPE_PREFIX_LIST_TRIE,
-					sizeof(struct pltrie_table));
-		table = table->entries[*bytes].next_table;
-		bytes++;
-		depth--;
-		validbits -= PLC_BITS;
-	}
-
-	trie_walk_affected(validbits, table, *bytes, pentry, trie_install_fn);
+		rn->info = pentry;
 }
 
 static void prefix_list_entry_add(struct prefix_list *plist,
@@ -785,10 +698,7 @@ enum prefix_list_type prefix_list_apply_which_prefix(
 	struct prefix_list_entry *pentry, *pbest = NULL;
 
 	const struct prefix *p = (const struct prefix *)object;
-	const uint8_t *byte = p->u.val;
-	size_t depth;
-	size_t validbits = p->prefixlen;
-	struct pltrie_table *table;
+	struct route_node *rn;
 
 	if (plist == NULL) {
 		if (which)
@@ -802,38 +712,25 @@ enum prefix_list_type prefix_list_apply_which_prefix(
 		return PREFIX_PERMIT;
 	}
 
-	depth = plist->master->trie_depth;
-	table = plist->trie;
-	while (1) {
-		for (pentry = table->entries[*byte].up_chain; pentry;
-		     pentry = pentry->next_best) {
+	/* Walk down the nodes covering p, each chain is sorted by sequence
+	 * number so only its first match counts.  This visits at most
+	 * p->prefixlen + 1 nodes, however long the list is.
+	 */
+	rn = plist->trie->top;
+	while (rn && rn->p.prefixlen <= p->prefixlen
+	       && prefix_match(&rn->p, p)) {
+		for (pentry = rn->info; pentry; pentry = pentry->next_best) {
 			if (pbest && pbest->seq < pentry->seq)
-				continue;
-			if (prefix_list_entry_match(pentry, p))
+				break;
+			if (prefix_list_entry_match(pentry, p)) {
 				pbest = pentry;
-		}
-
-		if (validbits <= PLC_BITS)
-			break;
-		validbits -= PLC_BITS;
-
-		if (--depth) {
-			if (!table->entries[*byte].next_table)
 				break;
-
-			table = table->entries[*byte].next_table;
-			byte++;
-			continue;
+			}
 		}
 
-		for (pentry = table->entries[*byte].final_chain; pentry;
-		     pentry = pentry->next_best) {
-			if (pbest && pbest->seq < pentry->seq)
-				continue;
-			if (prefix_list_entry_match(pentry, p))
-				pbest = pentry;
-		}
-		break;
+		if (rn->p.prefixlen == p->prefixlen)
+			break;
+		rn = rn->link[prefix_bit(p->u.val, rn->p.prefixlen)];
 	}
 
 	if (which) {
@@ -846,7 +743,7 @@ enum prefix_list_type prefix_list_apply_which_prefix(
 	if (pbest == NULL)
 		return PREFIX_DENY;
 
-	pbest->hitcnt++;
+	atomic_fetch_add_explicit(&pbest->hitcnt, 1, memory_order_relaxed);
 	return pbest->type;
 }
 
@@ -882,10 +779,7 @@ static void __attribute__((unused)) prefix_list_print(struct prefix_list *plist)
 static struct prefix_list_entry *
 prefix_entry_dup_check(struct prefix_list *plist, struct prefix_list_entry *new)
 {
-	size_t depth, maxdepth = plist->master->trie_depth;
-	uint8_t byte, *bytes = new->prefix.u.val;
-	size_t validbits = new->prefix.prefixlen;
-	struct pltrie_table *table;
+	struct route_node *rn;
 	struct prefix_list_entry *pentry;
 	int64_t seq = 0;
 
@@ -894,29 +788,27 @@ prefix_entry_dup_check(struct prefix_list *plist, struct prefix_list_entry *new)
 	else
 		seq = new->seq;
 
-	table = plist->trie;
-	for (depth = 0; validbits > PLC_BITS && depth < maxdepth - 1; depth++) {
-		byte = bytes[depth];
-		if (!table->entries[byte].next_table)
-			return NULL;
-
-		table = table->entries[byte].next_table;
-		validbits -= PLC_BITS;
-	}
-
-	byte = bytes[depth];
-	if (validbits > PLC_BITS)
-		pentry = table->entries[byte].final_chain;
-	else
-		pentry = table->entries[byte].up_chain;
+	rn = route_node_lookup(plist->trie, &new->prefix);
+	if (!rn)
+		return NULL;
 
-	for (; pentry; pentry = pentry->next_best) {
+	for (pentry = rn->info; pentry; pentry = pentry->next_best) {
 		if (prefix_same(&pentry->prefix, &new->prefix)
 		    && pentry->type == new->type && pentry->le == new->le
 		    && pentry->ge == new->ge && pentry->seq != seq)
-			return pentry;
+			break;
 	}
-	return NULL;
+	route_unlock_node(rn);
+	return pentry;
+}
+
+/* Approximate memory held by a prefix-list, trie included */
+static size_t prefix_list_memory(struct prefix_list *plist)
+{
+	return sizeof(*plist) + strlen(plist->name) + 1
+	       + sizeof(struct route_table)
+	       + route_table_count(plist->trie) * sizeof(struct route_node)
+	       + plist->count * sizeof(struct prefix_list_entry);
 }
 
 enum display_type {
@@ -955,6 +847,8 @@ static void vty_show_prefix_entry(struct vty *vty, afi_t afi,
 			plist->count, plist->rangecount,
 			plist->head ? plist->head->seq : 0,
 			plist->tail ? plist->tail->seq : 0);
+		vty_out(vty, "   memory: %zu bytes\n",
+			prefix_list_memory(plist));
 	}
 
 	if (dtype != summary_display) {
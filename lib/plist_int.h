@@ -22,11 +22,13 @@
 #ifndef _QUAGGA_PLIST_INT_H
 #define _QUAGGA_PLIST_INT_H
 
+#include "frratomic.h"
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
-struct pltrie_table;
+struct route_table;
 
 struct prefix_list {
 	char *name;
@@ -40,7 +42,8 @@ struct prefix_list {
 	struct prefix_list_entry *head;
 	struct prefix_list_entry *tail;
 
-	struct pltrie_table *trie;
+	/* entries by prefix, see prefix_list_trie_add() */
+	struct route_table *trie;
 
 	struct prefix_list *next;
 	struct prefix_list *prev;
@@ -59,14 +62,14 @@ struct prefix_list_entry {
 	struct prefix prefix;
 
 	unsigned long refcnt;
-	unsigned long hitcnt;
+	_Atomic unsigned long hitcnt;
 
 	struct prefix_list *pl;
 
 	struct prefix_list_entry *next;
 	struct prefix_list_entry *prev;
 
-	/* up the chain for best match search */
+	/* next entry with the same prefix, by sequence number */
 	struct prefix_list_entry *next_best;
 
 	/* Flag to track trie/list installation status. */
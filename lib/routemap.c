@@ -41,6 +41,7 @@ DEFINE_MTYPE_STATIC(LIB, ROUTE_MAP_RULE_STR, "Route map rule str");
 DEFINE_MTYPE(LIB, ROUTE_MAP_COMPILED, "Route map compiled");
 DEFINE_MTYPE_STATIC(LIB, ROUTE_MAP_DEP, "Route map dependency");
 DEFINE_MTYPE_STATIC(LIB, ROUTE_MAP_DEP_DATA, "Route map dependency data");
+DEFINE_MTYPE_STATIC(LIB, ROUTE_MAP_DELTA, "Route map change tracking");
 
 DEFINE_QOBJ_TYPE(route_map_index);
 DEFINE_QOBJ_TYPE(route_map);
@@ -59,6 +60,12 @@ struct route_map_pentry_dep {
 	route_map_event_t event;
 };
 
+/* Generation of the route-map configuration, for route_map_memo_key() */
+static uint64_t route_map_memo_gen = 1;
+
+/* At most this many prefix-list rules are folded into the memo key */
+#define RMAP_MEMO_PLIST_MAX 64
+
 /* Vector for route match rules. */
 static vector route_match_vec;
 
@@ -571,6 +578,119 @@ static void route_map_rule_delete(struct route_map_rule_list *,
 				  struct route_map_rule *);
 static bool rmap_debug;
 
+/* Beyond this many modified sequences, don't try to narrow a change down */
+#define RMAP_DELTA_MAX 32
+
+/*
+ * The sequences of a route-map that were modified since its changes were
+ * last processed, see route_map_changed_prefix().  There's an entry for
+ * each address prefix-list a sequence matched on before one of the
+ * modifications, plist is NULL if it didn't exist then.
+ */
+struct route_map_delta_seq {
+	int pref;
+	afi_t afi;
+	char *plist;
+};
+
+struct route_map_delta {
+	/* Anything may have changed */
+	bool all;
+
+	unsigned int count;
+	struct route_map_delta_seq seq[RMAP_DELTA_MAX];
+};
+
+/* The address prefix-list a prefix must be permitted by to match index */
+static const char *route_map_index_bound(struct route_map_index *index,
+					 afi_t *afi)
+{
+	struct route_map_rule *rule;
+
+	for (rule = index->match_list.head; rule; rule = rule->next) {
+		if (IS_RULE_IPv4_PREFIX_LIST(rule->cmd->str)) {
+			*afi = AFI_IP;
+			return rule->rule_str;
+		}
+		if (IS_RULE_IPv6_PREFIX_LIST(rule->cmd->str)) {
+			*afi = AFI_IP6;
+			return rule->rule_str;
+		}
+	}
+	return NULL;
+}
+
+static struct route_map_delta *route_map_delta_get(struct route_map *map)
+{
+	if (!map->delta)
+		map->delta = XCALLOC(MTYPE_ROUTE_MAP_DELTA,
+				     sizeof(struct route_map_delta));
+	return map->delta;
+}
+
+static void route_map_delta_free(struct route_map *map)
+{
+	unsigned int i;
+
+	if (!map->delta)
+		return;
+
+	for (i = 0; i < map->delta->count; i++)
+		XFREE(MTYPE_ROUTE_MAP_NAME, map->delta->seq[i].plist);
+	XFREE(MTYPE_ROUTE_MAP_DELTA, map->delta);
+}
+
+static void route_map_delta_all(struct route_map *map)
+{
+	route_map_delta_get(map)->all = true;
+}
+
+/* Sequence pref of map, index if it exists, is about to be modified */
+static void route_map_delta_touch(struct route_map *map, int pref,
+				  struct route_map_index *index)
+{
+	struct route_map_delta *delta = route_map_delta_get(map);
+	struct route_map_delta_seq *seq;
+	const char *plist = NULL;
+	afi_t afi = AFI_IP;
+	unsigned int i;
+
+	if (delta->all)
+		return;
+
+	if (index) {
+		plist = route_map_index_bound(index, &afi);
+		if (!plist) {
+			delta->all = true;
+			return;
+		}
+	}
+
+	for (i = 0; i < delta->count; i++) {
+		seq = &delta->seq[i];
+		if (seq->pref != pref || seq->afi != afi)
+			continue;
+		if (plist ? seq->plist && strmatch(seq->plist, plist)
+			  : !seq->plist)
+			return;
+	}
+
+	if (delta->count == RMAP_DELTA_MAX) {
+		delta->all = true;
+		return;
+	}
+
+	seq = &delta->seq[delta->count++];
+	seq->pref = pref;
+	seq->afi = afi;
+	seq->plist = plist ? XSTRDUP(MTYPE_ROUTE_MAP_NAME, plist) : NULL;
+}
+
+void route_map_index_touch(struct route_map_index *index)
+{
+	route_map_delta_touch(index->map, index->pref, index);
+}
+
 /* New route map allocation. Please note route map's name must be
    specified. */
 static struct route_map *route_map_new(const char *name)
@@ -592,6 +712,9 @@ static struct route_map *route_map_add(const char *name)
 	map = route_map_new(name);
 	list = &route_map_master;
 
+	/* whoever referenced it by name before sees a whole new policy */
+	route_map_delta_all(map);
+
 	/* Add map to the hash */
 	hash_get(route_map_master_hash, map, hash_alloc_intern);
 
@@ -663,6 +786,7 @@ static void route_map_free_map(struct route_map *map)
 		list->head = map->next;
 
 	hash_release(route_map_master_hash, map);
+	route_map_delta_free(map);
 	XFREE(MTYPE_ROUTE_MAP_NAME, map->name);
 	XFREE(MTYPE_ROUTE_MAP, map);
 }
@@ -758,6 +882,7 @@ static int route_map_clear_updated(struct route_map *map)
 
 	if (map) {
 		map->to_be_processed = false;
+		route_map_delta_free(map);
 		if (map->deleted)
 			route_map_free_map(map);
 	}
@@ -849,6 +974,9 @@ static void vty_show_route_map_entry(struct vty *vty, struct route_map *map)
 		map->name, map->applied - map->applied_clear,
 		map->optimization_disabled ? "disabled" : "enabled",
 		map->to_be_processed ? "true" : "false");
+	if (map->memo_hits || map->memo_misses)
+		vty_out(vty, " Memoized: hits %" PRIu64 " misses %" PRIu64 "\n",
+			map->memo_hits, map->memo_misses);
 
 	for (index = map->head; index; index = index->next) {
 		vty_out(vty, " %s, sequence %d Invoked %" PRIu64 "\n",
@@ -978,6 +1106,7 @@ void route_map_index_delete(struct route_map_index *index, int notify)
 	struct routemap_hook_context *rhc;
 	struct route_map_rule *rule;
 
+	route_map_index_touch(index);
 	QOBJ_UNREG(index);
 
 	if (rmap_debug)
@@ -1023,6 +1152,7 @@ void route_map_index_delete(struct route_map_index *index, int notify)
 	XFREE(MTYPE_ROUTE_MAP_NAME, index->nextrm);
 
 	route_map_pfx_tbl_update(RMAP_EVENT_INDEX_DELETED, index, 0, NULL);
+	route_map_memo_gen++;
 
 	/* Execute event hook. */
 	if (route_map_master.event_hook && notify) {
@@ -1047,6 +1177,73 @@ static struct route_map_index *route_map_index_lookup(struct route_map *map,
 	return NULL;
 }
 
+static bool route_map_plist_permits(afi_t afi, const char *name,
+				    const struct prefix *p)
+{
+	struct prefix_list *plist;
+
+	plist = prefix_list_lookup(afi, name);
+	return plist && prefix_list_apply(plist, p) != PREFIX_DENY;
+}
+
+bool route_map_changed_all(struct route_map *map)
+{
+	return !map || !map->delta || map->delta->all;
+}
+
+bool route_map_changed_prefix(struct route_map *map, const struct prefix *p)
+{
+	struct route_map_delta_seq *seq;
+	struct route_map_index *index;
+	const char *plist;
+	unsigned int i;
+	afi_t afi;
+
+	if (route_map_changed_all(map))
+		return true;
+	if (p->family != AF_INET && p->family != AF_INET6)
+		return true;
+
+	/* A prefix that fails a sequence's match both as it was and as
+	 * it is now carries on to the next one either way.
+	 */
+	for (i = 0; i < map->delta->count; i++) {
+		seq = &map->delta->seq[i];
+		if (seq->plist && route_map_plist_permits(seq->afi, seq->plist, p))
+			return true;
+
+		index = route_map_index_lookup(map, RMAP_ANY, seq->pref);
+		if (!index)
+			continue;
+		plist = route_map_index_bound(index, &afi);
+		if (!plist || route_map_plist_permits(afi, plist, p))
+			return true;
+	}
+	return false;
+}
+
+bool route_map_may_permit(struct route_map *map, const struct prefix *p)
+{
+	struct route_map_index *index;
+	const char *plist;
+	afi_t afi;
+
+	if (p->family != AF_INET && p->family != AF_INET6)
+		return true;
+
+	/* Whatever follows, nothing is permitted unless a permit
+	 * sequence matched on the way.
+	 */
+	for (index = map->head; index; index = index->next) {
+		if (index->type != RMAP_PERMIT)
+			continue;
+		plist = route_map_index_bound(index, &afi);
+		if (!plist || route_map_plist_permits(afi, plist, p))
+			return true;
+	}
+	return false;
+}
+
 /* Add new index to route map. */
 static struct route_map_index *
 route_map_index_add(struct route_map *map, enum route_map_type type, int pref)
@@ -1054,6 +1251,8 @@ route_map_index_add(struct route_map *map, enum route_map_type type, int pref)
 	struct route_map_index *index;
 	struct route_map_index *point;
 
+	route_map_delta_touch(map, pref, NULL);
+
 	/* Allocate new route map inex. */
 	index = route_map_index_new();
 	index->map = map;
@@ -1084,6 +1283,7 @@ route_map_index_add(struct route_map *map, enum route_map_type type, int pref)
 	}
 
 	route_map_pfx_tbl_update(RMAP_EVENT_INDEX_ADDED, index, 0, NULL);
+	route_map_memo_gen++;
 
 	/* Execute event hook. */
 	if (route_map_master.event_hook) {
@@ -1298,6 +1498,8 @@ enum rmap_compile_rets route_map_add_match(struct route_map_index *index,
 	int8_t delete_rmap_event_type = 0;
 	const char *rule_key;
 
+	route_map_index_touch(index);
+
 	/* First lookup rule for add match statement. */
 	cmd = route_map_lookup_match(match_name);
 	if (cmd == NULL)
@@ -1407,6 +1609,8 @@ enum rmap_compile_rets route_map_delete_match(struct route_map_index *index,
 	const struct route_map_rule_cmd *cmd;
 	const char *rule_key;
 
+	route_map_index_touch(index);
+
 	cmd = route_map_lookup_match(match_name);
 	if (cmd == NULL)
 		return RMAP_RULE_MISSING;
@@ -1463,6 +1667,8 @@ enum rmap_compile_rets route_map_add_set(struct route_map_index *index,
 	const struct route_map_rule_cmd *cmd;
 	void *compile;
 
+	route_map_index_touch(index);
+
 	cmd = route_map_lookup_set(set_name);
 	if (cmd == NULL)
 		return RMAP_RULE_MISSING;
@@ -1513,6 +1719,8 @@ enum rmap_compile_rets route_map_delete_set(struct route_map_index *index,
 	struct route_map_rule *rule;
 	const struct route_map_rule_cmd *cmd;
 
+	route_map_index_touch(index);
+
 	cmd = route_map_lookup_set(set_name);
 	if (cmd == NULL)
 		return RMAP_RULE_MISSING;
@@ -1611,42 +1819,23 @@ route_map_apply_match(struct route_map_rule_list *match_list,
 	return ret;
 }
 
+/*
+ * The prefix tables only change with the configuration, so they are walked
+ * without taking locks on the nodes; the node lock counts aren't atomic.
+ */
 static struct list *route_map_get_index_list(struct route_node **rn,
 					     const struct prefix *prefix,
 					     struct route_table *table)
 {
-	struct route_node *tmp_rn = NULL;
-
-	if (!(*rn)) {
-		*rn = route_node_match(table, prefix);
-
-		if (!(*rn))
-			return NULL;
-
-		if ((*rn)->info)
-			return (struct list *)((*rn)->info);
-
-		/* If rn->info is NULL, get the parent.
-		 * Store the rn in tmp_rn and unlock it later.
-		 */
-		tmp_rn = *rn;
-	}
-
-	do {
+	if (!(*rn))
+		*rn = route_node_match_unlocked(table, prefix);
+	else
 		*rn = (*rn)->parent;
-		if (tmp_rn)
-			route_unlock_node(tmp_rn);
-
-		if (!(*rn))
-			break;
 
-		if ((*rn)->info) {
-			route_lock_node(*rn);
-			return (struct list *)((*rn)->info);
-		}
-	} while (!(*rn)->info);
+	while (*rn && !(*rn)->info)
+		*rn = (*rn)->parent;
 
-	return NULL;
+	return *rn ? (struct list *)((*rn)->info) : NULL;
 }
 
 /*
@@ -1687,10 +1876,8 @@ static struct route_map_index *route_map_get_index(struct route_map *map,
 		head_index = (struct route_map_index *)(listgetdata(
 			listhead(candidate_rmap_list)));
 		if (best_index && head_index
-		    && (best_index->pref < head_index->pref)) {
-			route_unlock_node(rn);
+		    && (best_index->pref < head_index->pref))
 			continue;
-		}
 
 		for (ALL_LIST_ELEMENTS(candidate_rmap_list, ln, nn, index)) {
 			/* If the index is of seq higher than that in
@@ -1728,9 +1915,6 @@ static struct route_map_index *route_map_get_index(struct route_map *map,
 					*match_ret = ret;
 			}
 		}
-
-		route_unlock_node(rn);
-
 	} while (rn);
 
 	return best_index;
@@ -2312,6 +2496,8 @@ void route_map_notify_pentry_dependencies(const char *affected_name,
 	struct hash *upd8_hash = NULL;
 	struct route_map_pentry_dep pentry_dep;
 
+	route_map_memo_gen++;
+
 	if (!affected_name || !pentry)
 		return;
 
@@ -2382,22 +2568,26 @@ void route_map_notify_pentry_dependencies(const char *affected_name,
 
    We need to make sure our route-map processing matches the above
 */
-route_map_result_t route_map_apply(struct route_map *map,
-				   const struct prefix *prefix, void *object)
+/*
+ * The depth of "call"s is passed along rather than kept in a static, and the
+ * counters are atomic, so that a route-map can be applied from several
+ * pthreads at once.
+ */
+static route_map_result_t route_map_apply_depth(struct route_map *map,
+						const struct prefix *prefix,
+						void *object, int depth)
 {
-	static int recursion = 0;
 	enum route_map_cmd_result_t match_ret = RMAP_NOMATCH;
 	route_map_result_t ret = RMAP_PERMITMATCH;
 	struct route_map_index *index = NULL;
 	struct route_map_rule *set = NULL;
 	bool skip_match_clause = false;
 
-	if (recursion > RMAP_RECURSION_LIMIT) {
+	if (depth > RMAP_RECURSION_LIMIT) {
 		flog_warn(
 			EC_LIB_RMAP_RECURSION_LIMIT,
 			"route-map recursion limit (%d) reached, discarding route",
 			RMAP_RECURSION_LIMIT);
-		recursion = 0;
 		return RMAP_DENYMATCH;
 	}
 
@@ -2406,14 +2596,15 @@ route_map_result_t route_map_apply(struct route_map *map,
 		goto route_map_apply_end;
 	}
 
-	map->applied++;
+	atomic_fetch_add_explicit(&map->applied, 1, memory_order_relaxed);
 
 	if ((!map->optimization_disabled)
 	    && (map->ipv4_prefix_table || map->ipv6_prefix_table)) {
 		index = route_map_get_index(map, prefix, object,
 					    (uint8_t *)&match_ret);
 		if (index) {
-			index->applied++;
+			atomic_fetch_add_explicit(&index->applied, 1,
+						  memory_order_relaxed);
 			if (rmap_debug)
 				zlog_debug(
 					"Best match route-map: %s, sequence: %d for pfx: %pFX, result: %s",
@@ -2442,7 +2633,8 @@ route_map_result_t route_map_apply(struct route_map *map,
 
 	for (; index; index = index->next) {
 		if (!skip_match_clause) {
-			index->applied++;
+			atomic_fetch_add_explicit(&index->applied, 1,
+						  memory_order_relaxed);
 			/* Apply this index. */
 			match_ret = route_map_apply_match(&index->match_list,
 							  prefix, object);
@@ -2515,10 +2707,9 @@ route_map_result_t route_map_apply(struct route_map *map,
 					if (nextrm) /* Target route-map found,
 						       jump to it */
 					{
-						recursion++;
-						ret = route_map_apply(
-							nextrm, prefix, object);
-						recursion--;
+						ret = route_map_apply_depth(
+							nextrm, prefix, object,
+							depth + 1);
 					}
 
 					/* If nextrm returned 'deny', finish. */
@@ -2565,6 +2756,12 @@ route_map_apply_end:
 	return (ret);
 }
 
+route_map_result_t route_map_apply(struct route_map *map,
+				   const struct prefix *prefix, void *object)
+{
+	return route_map_apply_depth(map, prefix, object, 0);
+}
+
 void route_map_add_hook(void (*func)(const char *))
 {
 	route_map_master.add_hook = func;
@@ -2852,10 +3049,16 @@ static void route_map_process_dependency(struct hash_bucket *bucket, void *data)
 {
 	struct route_map_dep_data *dep_data = NULL;
 	char *rmap_name = NULL;
+	struct route_map *map;
 
 	dep_data = bucket->data;
 	rmap_name = dep_data->rname;
 
+	/* whatever it depends on can change the outcome anywhere */
+	map = route_map_lookup_by_name(rmap_name);
+	if (map)
+		route_map_delta_all(map);
+
 	if (rmap_debug)
 		zlog_debug("Notifying %s of dependency", rmap_name);
 	if (route_map_master.event_hook)
@@ -2867,6 +3070,8 @@ void route_map_upd8_dependency(route_map_event_t type, const char *arg,
 {
 	struct hash *upd8_hash = NULL;
 
+	route_map_memo_gen++;
+
 	if ((upd8_hash = route_map_get_dep_hash(type))) {
 		route_map_dep_update(upd8_hash, arg, rmap_name, type);
 
@@ -2889,6 +3094,8 @@ void route_map_notify_dependencies(const char *affected_name,
 	struct hash *upd8_hash;
 	char *name;
 
+	route_map_memo_gen++;
+
 	if (!affected_name)
 		return;
 
@@ -2913,12 +3120,111 @@ void route_map_notify_dependencies(const char *affected_name,
 	XFREE(MTYPE_ROUTE_MAP_NAME, name);
 }
 
+static bool route_map_memo_check(struct route_map *map)
+{
+	struct route_map_index *index;
+	struct route_map_rule *rule;
+	unsigned int plists = 0;
+
+	for (index = map->head; index; index = index->next) {
+		if (index->nextrm)
+			return false;
+
+		for (rule = index->match_list.head; rule; rule = rule->next) {
+			if (IS_RULE_IPv4_PREFIX_LIST(rule->cmd->str)
+			    || IS_RULE_IPv6_PREFIX_LIST(rule->cmd->str)) {
+				if (++plists > RMAP_MEMO_PLIST_MAX)
+					return false;
+				continue;
+			}
+			if (!rule->cmd->func_memoizable
+			    || !rule->cmd->func_memoizable(rule->value))
+				return false;
+		}
+
+		for (rule = index->set_list.head; rule; rule = rule->next)
+			if (!rule->cmd->func_memoizable
+			    || !rule->cmd->func_memoizable(rule->value))
+				return false;
+	}
+
+	return true;
+}
+
+bool route_map_memo_key(struct route_map *map, const struct prefix *prefix,
+			struct route_map_memo_key *key)
+{
+	struct route_map_index *index;
+	struct route_map_rule *rule;
+	struct prefix_list *plist;
+	unsigned int bit = 0;
+	afi_t afi;
+
+	if (map->memo_gen != route_map_memo_gen) {
+		map->memoizable = route_map_memo_check(map);
+		map->memo_gen = route_map_memo_gen;
+	}
+	if (!map->memoizable || map->deleted)
+		return false;
+
+	if (prefix->family != AF_INET && prefix->family != AF_INET6)
+		return false;
+
+	key->gen = route_map_memo_gen;
+	key->plist = 0;
+	key->family = prefix->family;
+
+	/* the prefix-list rules themselves check the family too, so their
+	 * outcome is a function of the family and of prefix_list_apply()
+	 */
+	for (index = map->head; index; index = index->next) {
+		for (rule = index->match_list.head; rule; rule = rule->next) {
+			if (IS_RULE_IPv4_PREFIX_LIST(rule->cmd->str))
+				afi = AFI_IP;
+			else if (IS_RULE_IPv6_PREFIX_LIST(rule->cmd->str))
+				afi = AFI_IP6;
+			else
+				continue;
+
+			plist = prefix_list_lookup(afi, rule->rule_str);
+			if (plist && prefix_list_apply(plist, prefix)
+					     == PREFIX_PERMIT)
+				key->plist |= 1ULL << bit;
+			bit++;
+		}
+	}
+
+	return true;
+}
+
+void route_map_memo_count(struct route_map *map, bool hit)
+{
+	if (hit)
+		atomic_fetch_add_explicit(&map->memo_hits, 1,
+					  memory_order_relaxed);
+	else
+		atomic_fetch_add_explicit(&map->memo_misses, 1,
+					  memory_order_relaxed);
+}
+
+void route_map_memo_invalidate(void)
+{
+	route_map_memo_gen++;
+}
+
+bool route_map_rule_memoizable(void *val)
+{
+	return true;
+}
+
 /* VTY related functions. */
 static void clear_route_map_helper(struct route_map *map)
 {
 	struct route_map_index *index;
 
 	map->applied_clear = map->applied;
+	map->memo_hits = 0;
+	map->memo_misses = 0;
 	for (index = map->head; index; index = index->next)
 		index->applied_clear = index->applied;
 }
@@ -21,6 +21,7 @@
 #ifndef _ZEBRA_ROUTEMAP_H
 #define _ZEBRA_ROUTEMAP_H
 
+#include "frratomic.h"
 #include "prefix.h"
 #include "memory.h"
 #include "qobj.h"
@@ -116,6 +117,12 @@ struct route_map_rule_cmd {
 
 	/** To get the rule key after Compilation **/
 	void *(*func_get_rmap_rule_key)(void *val);
+
+	/* Returns true if the compiled rule only looks at the object (never at
+	 * the prefix or some other state), see route_map_memo_key().  NULL
+	 * means it never does.
+	 */
+	bool (*func_memoizable)(void *val);
 };
 
 /* Route map apply error. */
@@ -184,7 +191,7 @@ struct route_map_index {
 	struct route_map_index *prev;
 
 	/* Keep track how many times we've try to apply */
-	uint64_t applied;
+	_Atomic uint64_t applied;
 	uint64_t applied_clear;
 
 	/* List of match/sets contexts. */
@@ -218,12 +225,21 @@ struct route_map {
 	bool optimization_disabled;
 
 	/* How many times have we applied this route-map */
-	uint64_t applied;
+	_Atomic uint64_t applied;
 	uint64_t applied_clear;
 
 	/* Counter to track active usage of this route-map */
 	uint16_t use_count;
 
+	/* Changes not processed yet, see route_map_changed_prefix() */
+	struct route_map_delta *delta;
+
+	/* Memoization, see route_map_memo_key() */
+	uint64_t memo_gen;
+	bool memoizable;
+	_Atomic uint64_t memo_hits;
+	_Atomic uint64_t memo_misses;
+
 	/* Tables to maintain IPv4 and IPv6 prefixes from
 	 * the prefix-list match clause.
 	 */
@@ -436,6 +452,34 @@ extern route_map_result_t route_map_apply(struct route_map *map,
 					  const struct prefix *prefix,
 					  void *object);
 
+/*
+ * Route map memoization.
+ *
+ * If all rules of a map only look at the object, the outcome of
+ * route_map_apply() is a function of the object and of the prefix-list
+ * matches, which are the only rules allowed to look at the prefix.
+ * route_map_memo_key() folds the latter into a key; callers can cache the
+ * outcome under that key plus the object.  The key carries a generation that
+ * changes whenever any route-map or list does, so a cached outcome with a
+ * stale key must be dropped.
+ *
+ * Returns false if the map cannot be memoized.
+ */
+struct route_map_memo_key {
+	uint64_t gen;
+	uint64_t plist;
+	uint8_t family;
+};
+
+extern bool route_map_memo_key(struct route_map *map,
+			       const struct prefix *prefix,
+			       struct route_map_memo_key *key);
+extern void route_map_memo_count(struct route_map *map, bool hit);
+extern void route_map_memo_invalidate(void);
+
+/* func_memoizable for rules that are always memoizable */
+extern bool route_map_rule_memoizable(void *val);
+
 extern void route_map_add_hook(void (*func)(const char *));
 extern void route_map_delete_hook(void (*func)(const char *));
 
@@ -449,6 +493,29 @@ extern void route_map_delete_hook(void (*func)(const char *));
 extern void route_map_event_hook(void (*func)(const char *name));
 extern int route_map_mark_updated(const char *name);
 extern void route_map_walk_update_list(void (*update_fn)(char *name));
+
+/*
+ * What the changes to a route-map that weren't processed yet by
+ * route_map_walk_update_list() can affect.  Every modified sequence has
+ * route_map_index_touch() called on it beforehand; when each version of
+ * them matches on an "ip address prefix-list" or "ipv6 address
+ * prefix-list", only prefixes permitted by one of those can have a
+ * different outcome.  route_map_changed_prefix() returns false for the
+ * others; route_map_changed_all() is true if it can't be narrowed down, e.g.
+ * because something the route-map depends on changed.
+ */
+extern void route_map_index_touch(struct route_map_index *index);
+extern bool route_map_changed_all(struct route_map *map);
+extern bool route_map_changed_prefix(struct route_map *map,
+				     const struct prefix *p);
+
+/*
+ * False if map can't permit p whatever else it is applied to: no permit
+ * sequence either matches without an address prefix-list or has one that
+ * permits p.
+ */
+extern bool route_map_may_permit(struct route_map *map,
+				 const struct prefix *p);
 extern void route_map_upd8_dependency(route_map_event_t type, const char *arg,
 				      const char *rmap_name);
 extern void route_map_notify_dependencies(const char *affected_name,
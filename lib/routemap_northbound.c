@@ -281,6 +281,7 @@ static int lib_route_map_entry_action_modify(struct nb_cb_modify_args *args)
 		break;
 	case NB_EV_APPLY:
 		rmi = nb_running_get_entry(args->dnode, NULL, true);
+		route_map_index_touch(rmi);
 		rmi->type = yang_dnode_get_enum(args->dnode, NULL);
 		map = rmi->map;
 
@@ -324,6 +325,7 @@ static int lib_route_map_entry_call_modify(struct nb_cb_modify_args *args)
 		break;
 	case NB_EV_APPLY:
 		rmi = nb_running_get_entry(args->dnode, NULL, true);
+		route_map_index_touch(rmi);
 		if (rmi->nextrm) {
 			route_map_upd8_dependency(RMAP_EVENT_CALL_DELETED,
 						  rmi->nextrm, rmi->map->name);
@@ -350,6 +352,7 @@ static int lib_route_map_entry_call_destroy(struct nb_cb_destroy_args *args)
 		break;
 	case NB_EV_APPLY:
 		rmi = nb_running_get_entry(args->dnode, NULL, true);
+		route_map_index_touch(rmi);
 		route_map_upd8_dependency(RMAP_EVENT_CALL_DELETED, rmi->nextrm,
 					  rmi->map->name);
 		XFREE(MTYPE_ROUTE_MAP_NAME, rmi->nextrm);
@@ -396,6 +399,7 @@ lib_route_map_entry_exit_policy_modify(struct nb_cb_modify_args *args)
 		break;
 	case NB_EV_APPLY:
 		rmi = nb_running_get_entry(args->dnode, NULL, true);
+		route_map_index_touch(rmi);
 		policy = yang_dnode_get_enum(args->dnode, NULL);
 
 		switch (policy) {
@@ -409,6 +413,7 @@ lib_route_map_entry_exit_policy_modify(struct nb_cb_modify_args *args)
 			rmi->exitpolicy = RMAP_GOTO;
 			break;
 		}
+		route_map_memo_invalidate();
 		break;
 	}
 
@@ -439,7 +444,9 @@ static int lib_route_map_entry_goto_value_modify(struct nb_cb_modify_args *args)
 		break;
 	case NB_EV_APPLY:
 		rmi = nb_running_get_entry(args->dnode, NULL, true);
+		route_map_index_touch(rmi);
 		rmi->nextpref = yang_dnode_get_uint16(args->dnode, NULL);
+		route_map_memo_invalidate();
 		break;
 	}
 
@@ -459,7 +466,9 @@ lib_route_map_entry_goto_value_destroy(struct nb_cb_destroy_args *args)
 		break;
 	case NB_EV_APPLY:
 		rmi = nb_running_get_entry(args->dnode, NULL, true);
+		route_map_index_touch(rmi);
 		rmi->nextpref = 0;
+		route_map_memo_invalidate();
 		break;
 	}
 
@@ -1228,7 +1237,8 @@ const struct frr_yang_module_info frr_route_map_info = {
 			.cbs = {
 				.create = lib_route_map_create,
 				.destroy = lib_route_map_destroy,
-			}
+			},
+			.concurrent = true,
 		},
 		{
 			.xpath = "/frr-route-map:lib/route-map/optimization-disabled",
@@ -0,0 +1,239 @@
+/*
+ * Single producer / single consumer ring in shared memory.
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#include <zebra.h>
+#include <sys/mman.h>
+
+#include "shm_ring.h"
+#include "memory.h"
+#include "frratomic.h"
+#include "libfrr.h"
+#include "network.h"
+
+DEFINE_MTYPE_STATIC(LIB, SHM_RING, "Shared memory ring");
+
+/*
+ * Shared header, followed by the data.  head and tail run freely and are
+ * masked on access; they sit on their own cache lines since each side keeps
+ * writing one of them.
+ */
+struct shm_ring_hdr {
+	uint64_t size;
+	uint8_t pad0[56];
+
+	_Atomic uint64_t head;
+	uint8_t pad1[56];
+
+	_Atomic uint64_t tail;
+	uint8_t pad2[56];
+
+	/* consumer went to sleep, producer has to wake it */
+	_Atomic uint32_t waiting;
+	uint8_t pad3[60];
+};
+
+struct shm_ring {
+	struct shm_ring_hdr *hdr;
+	uint8_t *data;
+	size_t size;
+	size_t maplen;
+	int fd;
+};
+
+static struct shm_ring *shm_ring_map(int fd, size_t maplen)
+{
+	struct shm_ring *ring;
+	void *map;
+
+	map = mmap(NULL, maplen, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED)
+		return NULL;
+
+	ring = XCALLOC(MTYPE_SHM_RING, sizeof(*ring));
+	ring->hdr = map;
+	ring->data = (uint8_t *)map + sizeof(struct shm_ring_hdr);
+	ring->maplen = maplen;
+	ring->fd = -1;
+	return ring;
+}
+
+struct shm_ring *shm_ring_new(size_t size)
+{
+	struct shm_ring *ring;
+	char path[sizeof(frr_vtydir) + 32];
+	size_t actual = 4096;
+	int fd;
+
+	while (actual < size)
+		actual <<= 1;
+
+	snprintf(path, sizeof(path), "%s/shm_ring.XXXXXX", frr_vtydir);
+	fd = mkstemp(path);
+	if (fd < 0)
+		return NULL;
+	unlink(path);
+	set_cloexec(fd);
+
+	if (ftruncate(fd, sizeof(struct shm_ring_hdr) + actual) < 0) {
+		close(fd);
+		return NULL;
+	}
+
+	ring = shm_ring_map(fd, sizeof(struct shm_ring_hdr) + actual);
+	if (!ring) {
+		close(fd);
+		return NULL;
+	}
+
+	ring->fd = fd;
+	ring->size = actual;
+	ring->hdr->size = actual;
+	atomic_store_explicit(&ring->hdr->head, 0, memory_order_relaxed);
+	atomic_store_explicit(&ring->hdr->tail, 0, memory_order_relaxed);
+	atomic_store_explicit(&ring->hdr->waiting, 1, memory_order_release);
+	return ring;
+}
+
+struct shm_ring *shm_ring_attach(int fd)
+{
+	struct shm_ring *ring;
+	struct stat st;
+	uint64_t size;
+
+	if (fstat(fd, &st) < 0
+	    || st.st_size <= (off_t)sizeof(struct shm_ring_hdr))
+		return NULL;
+
+	ring = shm_ring_map(fd, st.st_size);
+	if (!ring)
+		return NULL;
+
+	/* the peer could have written anything in there */
+	size = ring->hdr->size;
+	if (size == 0 || (size & (size - 1))
+	    || size != st.st_size - sizeof(struct shm_ring_hdr)) {
+		shm_ring_del(&ring);
+		return NULL;
+	}
+	ring->size = size;
+	return ring;
+}
+
+int shm_ring_fd(const struct shm_ring *ring)
+{
+	return ring->fd;
+}
+
+void shm_ring_del(struct shm_ring **ring)
+{
+	if (!*ring)
+		return;
+
+	munmap((*ring)->hdr, (*ring)->maplen);
+	if ((*ring)->fd >= 0)
+		close((*ring)->fd);
+	XFREE(MTYPE_SHM_RING, *ring);
+}
+
+size_t shm_ring_used(struct shm_ring *ring)
+{
+	uint64_t head, tail;
+
+	head = atomic_load_explicit(&ring->hdr->head, memory_order_acquire);
+	tail = atomic_load_explicit(&ring->hdr->tail, memory_order_acquire);
+
+	/* a peer scribbling over the header must not make us read garbage */
+	if (head - tail > ring->size)
+		return 0;
+	return head - tail;
+}
+
+static void shm_ring_copy_out(struct shm_ring *ring, uint64_t pos, void *data,
+			      size_t size)
+{
+	size_t off = pos & (ring->size - 1);
+	size_t first = MIN(size, ring->size - off);
+
+	memcpy(data, ring->data + off, first);
+	memcpy((uint8_t *)data + first, ring->data, size - first);
+}
+
+bool shm_ring_put(struct shm_ring *ring, const void *data, size_t size,
+		  bool *wakeup)
+{
+	uint64_t head, tail;
+	size_t off, first;
+
+	head = atomic_load_explicit(&ring->hdr->head, memory_order_relaxed);
+	tail = atomic_load_explicit(&ring->hdr->tail, memory_order_acquire);
+	if (ring->size - (head - tail) < size)
+		return false;
+
+	off = head & (ring->size - 1);
+	first = MIN(size, ring->size - off);
+	memcpy(ring->data + off, data, first);
+	memcpy(ring->data, (const uint8_t *)data + first, size - first);
+
+	atomic_store_explicit(&ring->hdr->head, head + size,
+			      memory_order_seq_cst);
+
+	/* pairs with shm_ring_sleep(): either it sees the new head, or we see
+	 * the waiting flag
+	 */
+	if (atomic_exchange_explicit(&ring->hdr->waiting, 0,
+				     memory_order_seq_cst))
+		*wakeup = true;
+	return true;
+}
+
+bool shm_ring_peek(struct shm_ring *ring, void *data, size_t size)
+{
+	uint64_t tail;
+
+	if (shm_ring_used(ring) < size)
+		return false;
+
+	tail = atomic_load_explicit(&ring->hdr->tail, memory_order_relaxed);
+	shm_ring_copy_out(ring, tail, data, size);
+	return true;
+}
+
+bool shm_ring_get(struct shm_ring *ring, void *data, size_t size)
+{
+	uint64_t tail;
+
+	if (shm_ring_used(ring) < size)
+		return false;
+
+	tail = atomic_load_explicit(&ring->hdr->tail, memory_order_relaxed);
+	shm_ring_copy_out(ring, tail, data, size);
+	atomic_store_explicit(&ring->hdr->tail, tail + size,
+			      memory_order_release);
+	return true;
+}
+
+bool shm_ring_sleep(struct shm_ring *ring)
+{
+	atomic_store_explicit(&ring->hdr->waiting, 1, memory_order_seq_cst);
+	if (shm_ring_used(ring) == 0)
+		return true;
+
+	/* raced with a put; the producer may or may not have seen the flag */
+	atomic_store_explicit(&ring->hdr->waiting, 0, memory_order_seq_cst);
+	return false;
+}
@@ -0,0 +1,106 @@
+/*
+ * Single producer / single consumer ring in shared memory.
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#ifndef _FRR_SHM_RING_H_
+#define _FRR_SHM_RING_H_
+
+#include <zebra.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * The ring lives in an unlinked file that is mapped by both processes; the
+ * creator hands the file descriptor to the peer over a UNIX socket.  Exactly
+ * one process puts and exactly one process gets.
+ *
+ * The consumer is expected to sleep on some other channel (a socket) when the
+ * ring is empty.  Before sleeping it calls shm_ring_sleep(), and the producer
+ * learns from shm_ring_put() whether it has to wake the consumer up.
+ */
+struct shm_ring;
+
+/*
+ * Creates a new ring.
+ *
+ * @param size	data size in bytes, rounded up to a power of 2
+ * @return the new ring or NULL if the shared memory could not be set up
+ */
+struct shm_ring *shm_ring_new(size_t size);
+
+/*
+ * Maps a ring created by a peer.  The file descriptor is not closed.
+ *
+ * @return the ring or NULL if fd does not hold a valid ring
+ */
+struct shm_ring *shm_ring_attach(int fd);
+
+/*
+ * File descriptor to pass to the peer, -1 for an attached ring.
+ */
+int shm_ring_fd(const struct shm_ring *ring);
+
+/*
+ * Unmaps the ring and frees all associated resources.
+ */
+void shm_ring_del(struct shm_ring **ring);
+
+/*
+ * Amount of data waiting to be read.
+ */
+size_t shm_ring_used(struct shm_ring *ring);
+
+/*
+ * Put data into the ring, all of it or nothing.
+ *
+ * @param wakeup	set to true if the consumer is asleep and needs to be
+ *			woken up; left alone otherwise
+ * @return false if there was not enough space
+ */
+bool shm_ring_put(struct shm_ring *ring, const void *data, size_t size,
+		  bool *wakeup);
+
+/*
+ * Copy data from the ring without consuming it.
+ *
+ * @return false if less than size bytes are available
+ */
+bool shm_ring_peek(struct shm_ring *ring, void *data, size_t size);
+
+/*
+ * Get data from the ring.
+ *
+ * @return false if less than size bytes are available; nothing is consumed
+ * in that case
+ */
+bool shm_ring_get(struct shm_ring *ring, void *data, size_t size);
+
+/*
+ * Called by the consumer once it has found the ring empty.  Returns false if
+ * data arrived in the meantime, in which case the consumer must keep reading
+ * instead of going to sleep.
+ */
+bool shm_ring_sleep(struct shm_ring *ring);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FRR_SHM_RING_H_ */
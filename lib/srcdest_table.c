@@ -59,6 +59,11 @@ static struct route_node *srcdest_rnode_create(route_table_delegate_t *delegate,
 	return srcdest_rnode_to_rnode(srn);
 }
 
+void srcdest_rnode_slab_enable(void)
+{
+	mtype_slab_enable(MTYPE_ROUTE_NODE, sizeof(struct srcdest_rnode));
+}
+
 static void srcdest_rnode_destroy(route_table_delegate_t *delegate,
 				  struct route_table *table,
 				  struct route_node *rn)
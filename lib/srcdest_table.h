@@ -33,7 +33,9 @@
  *         srcdest table -...-> route_node [prefix = src] .info -> [obj]
  *
  * non-srcdest routes (src = ::/0) are treated just like before, their
- * information being directly there in the info pointer.
+ * information being directly there in the info pointer.  Only destinations
+ * that have srcdest routes get a src_table, so looking up the others is a
+ * single lookup in the destination table, as in a plain route table.
  *
  * srcdest routes are found by looking up destination first, then looking
  * up the source in the "src_table".  src_table contains normal route_nodes,
@@ -59,6 +61,10 @@ extern route_table_delegate_t _srcdest_dstnode_delegate;
 extern route_table_delegate_t _srcdest_srcnode_delegate;
 
 extern struct route_table *srcdest_table_init(void);
+/* Put MTYPE_ROUTE_NODE on a slab pool, sized for both plain and srcdest
+ * route nodes; must be called before any route table is created.
+ */
+extern void srcdest_rnode_slab_enable(void);
 extern struct route_node *srcdest_rnode_get(struct route_table *table,
 					    union prefixconstptr dst_pu,
 					    const struct prefix_ipv6 *src_p);
@@ -33,6 +33,8 @@
 
 DEFINE_MTYPE_STATIC(LIB, STREAM, "Stream");
 DEFINE_MTYPE_STATIC(LIB, STREAM_FIFO, "Stream FIFO");
+DEFINE_MTYPE_STATIC(LIB, STREAM_MAG, "Stream pool magazine");
+DEFINE_MTYPE_STATIC(LIB, STREAM_CACHE, "Stream pool cache");
 
 /* Tests whether a position is valid */
 #define GETP_VALID(S, G) ((G) <= (S)->endp)
@@ -100,6 +102,293 @@ DEFINE_MTYPE_STATIC(LIB, STREAM_FIFO, "Stream FIFO");
 		}                                                              \
 	} while (0);
 
+/*
+ * Stream pool
+ *
+ * Magazines, as in Bonwick's allocator: each pthread has two magazines of
+ * streams per size class, and only trades a full one or an empty one with
+ * the depot when both are empty, respectively full.  A stream freed on
+ * another pthread simply ends up in that one's cache.  The depot keeps up
+ * to STREAM_DEPOT_BYTES per class, beyond that the streams are freed.
+ */
+#define STREAM_MAG_SIZE 32
+#define STREAM_DEPOT_BYTES (4 * 1024 * 1024)
+
+struct stream_mag {
+	struct stream_mag *next;
+	unsigned int n;
+	struct stream *s[STREAM_MAG_SIZE];
+};
+
+struct stream_depot {
+	pthread_mutex_t mtx;
+	/* data size, 0 for the stream_slice() headers */
+	size_t size;
+
+	struct stream_mag *full, *empty;
+	unsigned int n_full, n_empty;
+};
+
+static struct stream_depot stream_depots[] = {
+	{ .mtx = PTHREAD_MUTEX_INITIALIZER, .size = 0 },
+	{ .mtx = PTHREAD_MUTEX_INITIALIZER, .size = 1024 },
+	{ .mtx = PTHREAD_MUTEX_INITIALIZER, .size = 4096 },
+	{ .mtx = PTHREAD_MUTEX_INITIALIZER, .size = 16384 },
+	{ .mtx = PTHREAD_MUTEX_INITIALIZER, .size = 65536 },
+};
+
+#define STREAM_POOL_CLASSES array_size(stream_depots)
+
+struct stream_cache {
+	struct stream_mag *loaded[STREAM_POOL_CLASSES];
+	struct stream_mag *prev[STREAM_POOL_CLASSES];
+};
+
+static pthread_key_t stream_cache_key;
+static atomic_bool stream_pool_closed;
+
+#ifdef __OpenBSD__
+static inline struct stream_cache *stream_cache_tls_get(void)
+{
+	return pthread_getspecific(stream_cache_key);
+}
+
+static inline void stream_cache_tls_set(struct stream_cache *sc)
+{
+}
+#else
+# ifndef thread_local
+#  define thread_local __thread
+# endif
+
+static thread_local struct stream_cache *stream_cache_var
+	__attribute__((tls_model("initial-exec")));
+
+static inline struct stream_cache *stream_cache_tls_get(void)
+{
+	return stream_cache_var;
+}
+
+static inline void stream_cache_tls_set(struct stream_cache *sc)
+{
+	stream_cache_var = sc;
+}
+#endif
+
+static unsigned int stream_depot_max(const struct stream_depot *d)
+{
+	size_t bytes = (sizeof(struct stream) + d->size) * STREAM_MAG_SIZE;
+
+	return MAX(STREAM_DEPOT_BYTES / bytes, 1);
+}
+
+/* free the streams in mag, and mag itself unless keep is set */
+static void stream_mag_drain(struct stream_mag *mag, bool keep)
+{
+	while (mag->n)
+		XFREE(MTYPE_STREAM, mag->s[--mag->n]);
+	if (!keep)
+		XFREE(MTYPE_STREAM_MAG, mag);
+}
+
+/* hand a magazine back to the depot, or free it if the depot is full */
+static void stream_depot_put(struct stream_depot *d, struct stream_mag *mag)
+{
+	if (!mag)
+		return;
+
+	frr_with_mutex(&d->mtx) {
+		if (mag->n && d->n_full < stream_depot_max(d)) {
+			mag->next = d->full;
+			d->full = mag;
+			d->n_full++;
+			return;
+		}
+		if (!mag->n && d->n_empty < stream_depot_max(d)) {
+			mag->next = d->empty;
+			d->empty = mag;
+			d->n_empty++;
+			return;
+		}
+	}
+	stream_mag_drain(mag, false);
+}
+
+static void stream_cache_free(void *arg)
+{
+	struct stream_cache *sc = arg;
+	unsigned int c;
+
+	stream_cache_tls_set(NULL);
+
+	for (c = 0; c < STREAM_POOL_CLASSES; c++) {
+		stream_depot_put(&stream_depots[c], sc->loaded[c]);
+		stream_depot_put(&stream_depots[c], sc->prev[c]);
+	}
+	XFREE(MTYPE_STREAM_CACHE, sc);
+}
+
+static void stream_cache_key_init(void) __attribute__((_CONSTRUCTOR(500)));
+static void stream_cache_key_init(void)
+{
+	pthread_key_create(&stream_cache_key, stream_cache_free);
+}
+
+static struct stream_cache *stream_cache_get(void)
+{
+	struct stream_cache *sc = stream_cache_tls_get();
+
+	if (__builtin_expect(sc != NULL, 1))
+		return sc;
+	if (atomic_load_explicit(&stream_pool_closed, memory_order_relaxed))
+		return NULL;
+
+	sc = XCALLOC(MTYPE_STREAM_CACHE, sizeof(*sc));
+	stream_cache_tls_set(sc);
+	pthread_setspecific(stream_cache_key, sc);
+	return sc;
+}
+
+static unsigned int stream_pool_class(size_t size)
+{
+	unsigned int c;
+
+	for (c = 1; c < STREAM_POOL_CLASSES; c++)
+		if (size <= stream_depots[c].size)
+			break;
+	return c;
+}
+
+static struct stream *stream_pool_get(unsigned int c)
+{
+	struct stream_cache *sc = stream_cache_get();
+	struct stream_depot *d = &stream_depots[c];
+	struct stream_mag *mag, *tmp;
+	struct stream *s;
+
+	if (sc) {
+		if (!sc->loaded[c] || !sc->loaded[c]->n) {
+			tmp = sc->loaded[c];
+			sc->loaded[c] = sc->prev[c];
+			sc->prev[c] = tmp;
+		}
+
+		if (!sc->loaded[c] || !sc->loaded[c]->n) {
+			/* trade the emptier magazine for a full one */
+			frr_with_mutex(&d->mtx) {
+				mag = d->full;
+				if (mag) {
+					d->full = mag->next;
+					d->n_full--;
+				}
+			}
+			if (mag) {
+				stream_depot_put(d, sc->prev[c]);
+				sc->prev[c] = sc->loaded[c];
+				sc->loaded[c] = mag;
+			}
+		}
+
+		mag = sc->loaded[c];
+		if (mag && mag->n)
+			return mag->s[--mag->n];
+	}
+
+	s = XMALLOC(MTYPE_STREAM, sizeof(struct stream) + d->size);
+	s->pool = c + 1;
+	return s;
+}
+
+static void stream_pool_put(struct stream *s)
+{
+	struct stream_cache *sc = stream_cache_get();
+	unsigned int c = s->pool - 1;
+	struct stream_depot *d = &stream_depots[c];
+	struct stream_mag *mag, *tmp;
+
+	if (!sc) {
+		XFREE(MTYPE_STREAM, s);
+		return;
+	}
+
+	if (!sc->loaded[c] || sc->loaded[c]->n == STREAM_MAG_SIZE) {
+		tmp = sc->loaded[c];
+		sc->loaded[c] = sc->prev[c];
+		sc->prev[c] = tmp;
+	}
+
+	if (!sc->loaded[c] || sc->loaded[c]->n == STREAM_MAG_SIZE) {
+		/* trade the fuller magazine for an empty one */
+		frr_with_mutex(&d->mtx) {
+			mag = d->empty;
+			if (mag) {
+				d->empty = mag->next;
+				d->n_empty--;
+			}
+		}
+		if (!mag)
+			mag = XCALLOC(MTYPE_STREAM_MAG, sizeof(*mag));
+
+		stream_depot_put(d, sc->prev[c]);
+		sc->prev[c] = sc->loaded[c];
+		sc->loaded[c] = mag;
+	}
+
+	mag = sc->loaded[c];
+	mag->s[mag->n++] = s;
+}
+
+/* give a stream allocation back, whichever way it was made */
+static void stream_release(struct stream *s)
+{
+	if (s->pool)
+		stream_pool_put(s);
+	else
+		XFREE(MTYPE_STREAM, s);
+}
+
+void stream_pool_finish(void)
+{
+	struct stream_cache *sc = stream_cache_tls_get();
+	struct stream_depot *d;
+	struct stream_mag *mag;
+	unsigned int c;
+
+	atomic_store_explicit(&stream_pool_closed, true, memory_order_relaxed);
+
+	if (sc) {
+		pthread_setspecific(stream_cache_key, NULL);
+		stream_cache_free(sc);
+	}
+
+	for (c = 0; c < STREAM_POOL_CLASSES; c++) {
+		d = &stream_depots[c];
+
+		frr_with_mutex(&d->mtx) {
+			while ((mag = d->full)) {
+				d->full = mag->next;
+				stream_mag_drain(mag, false);
+			}
+			while ((mag = d->empty)) {
+				d->empty = mag->next;
+				stream_mag_drain(mag, false);
+			}
+			d->n_full = d->n_empty = 0;
+		}
+	}
+}
+
+static void stream_init(struct stream *s, size_t size)
+{
+	s->getp = s->endp = 0;
+	s->next = NULL;
+	s->size = size;
+	s->data = s->buf;
+	s->shared = NULL;
+	s->rx_time = 0;
+	atomic_store_explicit(&s->refcount, 1, memory_order_relaxed);
+}
+
 /* Make stream buffer. */
 struct stream *stream_new(size_t size)
 {
@@ -108,20 +397,98 @@ struct stream *stream_new(size_t size)
 	assert(size > 0);
 
 	s = XMALLOC(MTYPE_STREAM, sizeof(struct stream) + size);
+	stream_init(s, size);
+	s->pool = 0;
+	return s;
+}
 
-	s->getp = s->endp = 0;
-	s->next = NULL;
-	s->size = size;
+struct stream *stream_new_pooled(size_t size)
+{
+	struct stream *s;
+	unsigned int c;
+
+	assert(size > 0);
+
+	c = stream_pool_class(size);
+	if (c == STREAM_POOL_CLASSES)
+		return stream_new(size);
+
+	s = stream_pool_get(c);
+	stream_init(s, size);
 	return s;
 }
 
 /* Free it now. */
 void stream_free(struct stream *s)
 {
+	struct stream *owner;
+
 	if (!s)
 		return;
 
-	XFREE(MTYPE_STREAM, s);
+	if (s->shared) {
+		owner = s->shared;
+		stream_release(s);
+		s = owner;
+	}
+
+	if (atomic_fetch_sub_explicit(&s->refcount, 1, memory_order_acq_rel)
+	    > 1)
+		return;
+
+	stream_release(s);
+}
+
+struct stream *stream_slice(struct stream *s, size_t offset, size_t len)
+{
+	struct stream *owner = s->shared ? s->shared : s;
+	struct stream *snew;
+
+	STREAM_VERIFY_SANE(s);
+	assert(offset + len <= s->size);
+
+	atomic_fetch_add_explicit(&owner->refcount, 1, memory_order_relaxed);
+
+	/* only the header, which comes from the pool */
+	snew = stream_pool_get(0);
+	snew->next = NULL;
+	snew->getp = 0;
+	snew->endp = len;
+	snew->size = len;
+	snew->data = s->data + offset;
+	snew->shared = owner;
+	snew->rx_time = s->rx_time;
+	atomic_store_explicit(&snew->refcount, 1, memory_order_relaxed);
+	return snew;
+}
+
+struct stream *stream_share(struct stream *s)
+{
+	struct stream *snew = stream_slice(s, 0, s->size);
+
+	snew->getp = s->getp;
+	snew->endp = s->endp;
+	return snew;
+}
+
+bool stream_is_shared(const struct stream *s)
+{
+	return s->shared
+	       || atomic_load_explicit(&s->refcount, memory_order_acquire) > 1;
+}
+
+void stream_unshare(struct stream **sptr)
+{
+	struct stream *s = *sptr;
+	struct stream *snew;
+
+	if (!stream_is_shared(s))
+		return;
+
+	snew = stream_new(s->size);
+	stream_copy(snew, s);
+	stream_free(s);
+	*sptr = snew;
 }
 
 struct stream *stream_copy(struct stream *dest, const struct stream *src)
@@ -175,10 +542,16 @@ size_t stream_resize_inplace(struct stream **sptr, size_t newsize)
 	struct stream *orig = *sptr;
 
 	STREAM_VERIFY_SANE(orig);
+	assert(!orig->shared
+	       && atomic_load_explicit(&orig->refcount, memory_order_relaxed)
+			  == 1);
 
+	/* pooled streams are malloc()ed too, they just stop being pooled */
 	orig = XREALLOC(MTYPE_STREAM, orig, sizeof(struct stream) + newsize);
 
+	orig->pool = 0;
 	orig->size = newsize;
+	orig->data = orig->buf;
 
 	if (orig->endp > orig->size)
 		orig->endp = orig->size;
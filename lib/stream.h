@@ -110,7 +110,19 @@ struct stream {
 	size_t getp;	       /* next get position */
 	size_t endp;	       /* last valid data position */
 	size_t size;	       /* size of data segment */
-	unsigned char data[];  /* data pointer */
+	unsigned char *data;   /* data pointer */
+
+	/* owner of data if this is a stream_share() of it, else NULL */
+	struct stream *shared;
+	/* number of streams using data, including the owner itself */
+	atomic_uint refcount;
+	/* 1 + size class if allocated from the stream pool, else 0 */
+	uint8_t pool;
+
+	/* when the data was received, see conv_now(); 0 if not known */
+	int64_t rx_time;
+
+	unsigned char buf[];   /* data, unless shared */
 };
 
 /* First in first out queue structure. */
@@ -150,11 +162,45 @@ struct stream_fifo {
  */
 extern struct stream *stream_new(size_t);
 extern void stream_free(struct stream *);
+
+/*
+ * Same as stream_new(), but taken from a per-pthread cache of streams of a
+ * few sizes, up to 64k, rather than malloc()ed.  Meant for the packets that
+ * are created and freed all the time; the rest of the API is the same, and
+ * they can be stream_free()d on any pthread.
+ */
+extern struct stream *stream_new_pooled(size_t size);
+/* Free the cached streams, from frr_fini(). */
+extern void stream_pool_finish(void);
 /* Copy 'src' into 'dest', returns 'dest' */
 extern struct stream *stream_copy(struct stream *dest,
 				  const struct stream *src);
 extern struct stream *stream_dup(const struct stream *s);
 
+/*
+ * Create a stream referring to the data of s instead of copying it.
+ *
+ * The result has its own getp, endp and next pointer, so it can be read and
+ * queued independently of s, but neither it nor s may be written to any
+ * more.  The data is freed once s and every stream sharing it have been
+ * stream_free()d, which is safe to do from different pthreads.
+ */
+extern struct stream *stream_share(struct stream *s);
+
+/*
+ * Like stream_share(), but only covering len bytes of s starting at offset,
+ * which become bytes 0 to len - 1 of the new stream.  Slices that don't
+ * overlap may be written to.
+ */
+extern struct stream *stream_slice(struct stream *s, size_t offset,
+				   size_t len);
+
+/* Make *sptr writable again, replacing it with a copy if it is shared. */
+extern void stream_unshare(struct stream **sptr);
+
+/* Is s sharing its data with any other stream? */
+extern bool stream_is_shared(const struct stream *s);
+
 extern size_t stream_resize_inplace(struct stream **sptr, size_t newsize);
 
 extern size_t stream_get_getp(const struct stream *s);
@@ -31,6 +31,7 @@
 
 DEFINE_MTYPE_STATIC(LIB, ROUTE_TABLE, "Route table");
 DEFINE_MTYPE(LIB, ROUTE_NODE, "Route node");
+DEFINE_MTYPE_STATIC(LIB, ROUTE_TABLE_LPM, "Route table LPM index");
 
 static void route_table_free(struct route_table *);
 
@@ -61,6 +62,162 @@ void route_table_finish(struct route_table *rt)
 	route_table_free(rt);
 }
 
+/*
+ * LPM index: for each value of the first LPM_BITS prefix bits, the deepest
+ * node whose prefix covers all prefixes starting with them.  Every node
+ * above it on the way down is a shorter match, so lookups for prefixes of
+ * at least LPM_BITS length can start there instead of at the top.
+ */
+#define LPM_BITS 16
+#define LPM_SLOTS (1U << LPM_BITS)
+/* not worth 512KiB below this */
+#define LPM_MIN_COUNT 4096
+
+static inline unsigned int lpm_slot(const struct prefix *p)
+{
+	const uint8_t *pnt = &p->u.prefix;
+
+	return (pnt[0] << 8) | pnt[1];
+}
+
+static void route_table_lpm_add(struct route_table *table,
+				struct route_node *node)
+{
+	unsigned int i, first, last;
+
+	if (!table->lpm)
+		return;
+
+	if (node->p.family != table->lpm_family) {
+		/* the index only works with a single family */
+		XFREE(MTYPE_ROUTE_TABLE_LPM, table->lpm);
+		table->lpm_enabled = false;
+		return;
+	}
+
+	if (node->p.prefixlen > LPM_BITS)
+		return;
+
+	first = lpm_slot(&node->p);
+	last = first + (1U << (LPM_BITS - node->p.prefixlen));
+	for (i = first; i < last; i++)
+		if (!table->lpm[i]
+		    || table->lpm[i]->p.prefixlen < node->p.prefixlen)
+			table->lpm[i] = node;
+}
+
+/* must be called before node is unlinked */
+static void route_table_lpm_del(struct route_table *table,
+				struct route_node *node)
+{
+	unsigned int i, first, last;
+
+	if (!table->lpm || node->p.prefixlen > LPM_BITS)
+		return;
+
+	first = lpm_slot(&node->p);
+	last = first + (1U << (LPM_BITS - node->p.prefixlen));
+	for (i = first; i < last; i++)
+		if (table->lpm[i] == node)
+			table->lpm[i] = node->parent;
+}
+
+static void route_table_lpm_fill(struct route_table *table,
+				 struct route_node *node)
+{
+	/* parents first, so deeper nodes overwrite them */
+	if (!node || node->p.prefixlen > LPM_BITS)
+		return;
+
+	route_table_lpm_add(table, node);
+	route_table_lpm_fill(table, node->l_left);
+	route_table_lpm_fill(table, node->l_right);
+}
+
+static void route_table_lpm_build(struct route_table *table)
+{
+	uint8_t family = table->top->p.family;
+
+	if (family != AF_INET && family != AF_INET6) {
+		table->lpm_enabled = false;
+		return;
+	}
+
+	table->lpm = XCALLOC(MTYPE_ROUTE_TABLE_LPM,
+			     LPM_SLOTS * sizeof(*table->lpm));
+	table->lpm_family = family;
+	route_table_lpm_fill(table, table->top);
+}
+
+/* where to start walking down towards p, NULL for the top */
+static inline struct route_node *
+route_table_lpm_start(const struct route_table *table, const struct prefix *p)
+{
+	if (!table->lpm || p->family != table->lpm_family
+	    || p->prefixlen < LPM_BITS)
+		return NULL;
+
+	return table->lpm[lpm_slot(p)];
+}
+
+void route_table_enable_lpm_index(struct route_table *table)
+{
+	table->lpm_enabled = true;
+	if (!table->lpm && table->count >= LPM_MIN_COUNT)
+		route_table_lpm_build(table);
+}
+
+/*
+ * Below this many nodes, tables aren't hashed: walking a tree this small is
+ * as quick, and many tables never grow any bigger (e.g. bgpd's per route
+ * distinguisher ones) so they are spared the buckets.
+ */
+#define HASH_MIN_COUNT 16
+
+static void route_table_hash_fill(struct route_table *table,
+				  struct route_node *node)
+{
+	if (!node)
+		return;
+
+	rn_hash_node_add(&table->hash, node);
+	route_table_hash_fill(table, node->l_left);
+	route_table_hash_fill(table, node->l_right);
+}
+
+static void route_table_hash_check(struct route_table *table,
+				   const struct prefix *p)
+{
+	/* walking only finds IPv4 and IPv6 prefixes reliably */
+	if (table->hashed
+	    || (table->count < HASH_MIN_COUNT
+		&& (p->family == AF_INET || p->family == AF_INET6)))
+		return;
+
+	table->hashed = true;
+	route_table_hash_fill(table, table->top);
+}
+
+static struct route_node *route_table_find(struct route_table *table,
+					   const struct route_node *search)
+{
+	const struct prefix *p = &search->p;
+	struct route_node *node;
+
+	if (table->hashed)
+		return rn_hash_node_find(&table->hash, search);
+
+	node = table->top;
+	while (node && node->p.prefixlen <= p->prefixlen
+	       && prefix_match(&node->p, p)) {
+		if (node->p.prefixlen == p->prefixlen)
+			return prefix_cmp(&node->p, p) ? NULL : node;
+
+		node = node->link[prefix_bit(&p->u.prefix, node->p.prefixlen)];
+	}
+	return NULL;
+}
+
 /* Allocate new route node. */
 static struct route_node *route_node_new(struct route_table *table)
 {
@@ -78,7 +235,8 @@ static struct route_node *route_node_set(struct route_table *table,
 	prefix_copy(&node->p, prefix);
 	node->table = table;
 
-	rn_hash_node_add(&node->table->hash, node);
+	if (table->hashed)
+		rn_hash_node_add(&table->hash, node);
 
 	return node;
 }
@@ -100,6 +258,8 @@ static void route_table_free(struct route_table *rt)
 	if (rt == NULL)
 		return;
 
+	XFREE(MTYPE_ROUTE_TABLE_LPM, rt->lpm);
+
 	node = rt->top;
 
 	/* Bulk deletion of nodes remaining in this table.  This function is not
@@ -122,7 +282,8 @@ static void route_table_free(struct route_table *rt)
 		tmp_node->table->count--;
 		tmp_node->lock =
 			0; /* to cause assert if unlocked after this */
-		rn_hash_node_del(&rt->hash, tmp_node);
+		if (rt->hashed)
+			rn_hash_node_del(&rt->hash, tmp_node);
 		route_node_free(rt, tmp_node);
 
 		if (node != NULL) {
@@ -195,13 +356,26 @@ static void set_link(struct route_node *node, struct route_node *new)
 /* Find matched prefix. */
 struct route_node *route_node_match(struct route_table *table,
 				    union prefixconstptr pu)
+{
+	struct route_node *matched = route_node_match_unlocked(table, pu);
+
+	if (matched)
+		return route_lock_node(matched);
+
+	return NULL;
+}
+
+struct route_node *route_node_match_unlocked(struct route_table *table,
+					     union prefixconstptr pu)
 {
 	const struct prefix *p = pu.p;
 	struct route_node *node;
 	struct route_node *matched;
+	struct route_node *start;
 
 	matched = NULL;
-	node = table->top;
+	start = route_table_lpm_start(table, p);
+	node = start ? start : table->top;
 
 	/* Walk down tree.  If there is matched route then store it to
 	   matched. */
@@ -216,11 +390,15 @@ struct route_node *route_node_match(struct route_table *table,
 		node = node->link[prefix_bit(&p->u.prefix, node->p.prefixlen)];
 	}
 
-	/* If matched route found, return it. */
-	if (matched)
-		return route_lock_node(matched);
+	/* Nodes above the index entry weren't looked at. */
+	if (!matched && start)
+		for (node = start->parent; node; node = node->parent)
+			if (node->info) {
+				matched = node;
+				break;
+			}
 
-	return NULL;
+	return matched;
 }
 
 struct route_node *route_node_match_ipv4(struct route_table *table,
@@ -257,7 +435,7 @@ struct route_node *route_node_lookup(struct route_table *table,
 	prefix_copy(&rn.p, pu.p);
 	apply_mask(&rn.p);
 
-	node = rn_hash_node_find(&table->hash, &rn);
+	node = route_table_find(table, &rn);
 	return (node && node->info) ? route_lock_node(node) : NULL;
 }
 
@@ -269,7 +447,7 @@ struct route_node *route_node_lookup_maynull(struct route_table *table,
 	prefix_copy(&rn.p, pu.p);
 	apply_mask(&rn.p);
 
-	node = rn_hash_node_find(&table->hash, &rn);
+	node = route_table_find(table, &rn);
 	return node ? route_lock_node(node) : NULL;
 }
 
@@ -295,12 +473,20 @@ struct route_node *route_node_get(struct route_table *table,
 	uint16_t prefixlen = p->prefixlen;
 	const uint8_t *prefix = &p->u.prefix;
 
-	node = rn_hash_node_find(&table->hash, &search);
-	if (node && node->info)
-		return route_lock_node(node);
+	route_table_hash_check(table, p);
+	if (table->hashed) {
+		node = rn_hash_node_find(&table->hash, &search);
+		if (node && node->info)
+			return route_lock_node(node);
+	}
 
-	match = NULL;
-	node = table->top;
+	node = route_table_lpm_start(table, p);
+	if (node)
+		match = node->parent;
+	else {
+		match = NULL;
+		node = table->top;
+	}
 	while (node && node->p.prefixlen <= prefixlen
 	       && prefix_match(&node->p, p)) {
 		if (node->p.prefixlen == prefixlen)
@@ -316,29 +502,36 @@ struct route_node *route_node_get(struct route_table *table,
 			set_link(match, new);
 		else
 			table->top = new;
+		route_table_lpm_add(table, new);
 	} else {
 		new = route_node_new(table);
 		route_common(&node->p, p, &new->p);
 		new->p.family = p->family;
 		new->table = table;
 		set_link(new, node);
-		rn_hash_node_add(&table->hash, new);
+		if (table->hashed)
+			rn_hash_node_add(&table->hash, new);
 
 		if (match)
 			set_link(match, new);
 		else
 			table->top = new;
+		route_table_lpm_add(table, new);
 
 		if (new->p.prefixlen != p->prefixlen) {
 			match = new;
 			new = route_node_set(table, p);
 			set_link(match, new);
 			table->count++;
+			route_table_lpm_add(table, new);
 		}
 	}
 	table->count++;
 	route_lock_node(new);
 
+	if (table->lpm_enabled && !table->lpm && table->count >= LPM_MIN_COUNT)
+		route_table_lpm_build(table);
+
 	return new;
 }
 
@@ -361,6 +554,8 @@ void route_node_delete(struct route_node *node)
 
 	parent = node->parent;
 
+	route_table_lpm_del(node->table, node);
+
 	if (child)
 		child->parent = parent;
 
@@ -374,7 +569,8 @@ void route_node_delete(struct route_node *node)
 
 	node->table->count--;
 
-	rn_hash_node_del(&node->table->hash, node);
+	if (node->table->hashed)
+		rn_hash_node_del(&node->table->hash, node);
 
 	/* WARNING: FRAGILE CODE!
 	 * route_node_free may have the side effect of free'ing the entire
@@ -64,6 +64,12 @@ PREDECL_HASH(rn_hash_node);
 /* Routing table top structure. */
 struct route_table {
 	struct route_node *top;
+
+	/*
+	 * Exact match index, only built once the table has grown past a few
+	 * nodes; small tables are searched by walking the tree.
+	 */
+	bool hashed;
 	struct rn_hash_node_head hash;
 
 	/*
@@ -74,6 +80,13 @@ struct route_table {
 
 	unsigned long count;
 
+	/*
+	 * Longest-prefix-match index, see route_table_enable_lpm_index().
+	 */
+	bool lpm_enabled;
+	uint8_t lpm_family;
+	struct route_node **lpm;
+
 	/*
 	 * User data.
 	 */
@@ -198,6 +211,13 @@ static inline void route_table_set_info(struct route_table *table, void *d)
 }
 
 extern void route_table_finish(struct route_table *table);
+/*
+ * Speed up route_node_match() and route_node_get() with an index on the
+ * first 16 prefix bits, so lookups skip the top levels of the tree.  The
+ * table must only hold IPv4 or only IPv6 prefixes.  The index (512KiB) is
+ * only built once the table has grown past a few thousand nodes.
+ */
+extern void route_table_enable_lpm_index(struct route_table *table);
 extern struct route_node *route_top(struct route_table *table);
 extern struct route_node *route_next(struct route_node *node);
 extern struct route_node *route_next_until(struct route_node *node,
@@ -210,6 +230,13 @@ extern struct route_node *route_node_lookup_maynull(struct route_table *table,
 						    union prefixconstptr pu);
 extern struct route_node *route_node_match(struct route_table *table,
 					   union prefixconstptr pu);
+/*
+ * route_node_match() without taking a lock on the node.  The lookup writes
+ * nothing, so it can run on several pthreads at once, as long as none of
+ * them changes the table meanwhile.
+ */
+extern struct route_node *route_node_match_unlocked(struct route_table *table,
+						    union prefixconstptr pu);
 extern struct route_node *route_node_match_ipv4(struct route_table *table,
 						const struct in_addr *addr);
 extern struct route_node *route_node_match_ipv6(struct route_table *table,
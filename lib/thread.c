@@ -22,6 +22,12 @@
 
 #include <zebra.h>
 #include <sys/resource.h>
+#ifdef HAVE_EPOLL
+#include <sys/epoll.h>
+#endif
+#ifdef HAVE_KQUEUE
+#include <sys/event.h>
+#endif
 
 #include "thread.h"
 #include "memory.h"
@@ -70,6 +76,61 @@ static int thread_timer_cmp(const struct thread *a, const struct thread *b)
 
 DECLARE_HEAP(thread_timer_list, struct thread, timeritem, thread_timer_cmp);
 
+static struct thread_list_head *thread_ready_list(struct thread_master *m,
+						  struct thread *thread)
+{
+	switch (thread->prio) {
+	case THREAD_PRIO_URGENT:
+		return &m->ready_urgent;
+	case THREAD_PRIO_BACKGROUND:
+		return &m->ready_bg;
+	default:
+		return &m->ready;
+	}
+}
+
+static inline unsigned int thread_ready_count(struct thread_master *m)
+{
+	return thread_list_count(&m->ready_urgent)
+	       + thread_list_count(&m->ready) + thread_list_count(&m->ready_bg);
+}
+
+/* Recompute when the next urgent task is due.  Needs m->mtx held. */
+static void thread_urgent_update(struct thread_master *m)
+{
+	struct thread *thread;
+	int64_t due = 0;
+
+	if (thread_list_count(&m->ready_urgent))
+		due = 1;
+	else if ((thread = thread_timer_list_first(&m->timer_urgent)))
+		due = thread->u.sands.tv_sec * TIMER_SECOND_MICRO
+		      + thread->u.sands.tv_usec;
+
+	atomic_store_explicit(&m->urgent_due, due, memory_order_relaxed);
+}
+
+/* Put a thread on the ready list matching its priority.  Needs m->mtx. */
+static void thread_ready_add(struct thread_master *m, struct thread *thread)
+{
+	struct timeval now;
+
+	/* for the flight recorder; events got it when they were added */
+	if (thread->type == THREAD_TIMER)
+		thread->ready_since = thread->u.sands.tv_sec * TIMER_SECOND_MICRO
+				      + thread->u.sands.tv_usec;
+	else if (thread->type == THREAD_READ || thread->type == THREAD_WRITE) {
+		monotime(&now);
+		thread->ready_since = now.tv_sec * TIMER_SECOND_MICRO
+				      + now.tv_usec;
+	}
+
+	thread->type = THREAD_READY;
+	thread_list_add_tail(thread_ready_list(m, thread), thread);
+	if (thread->prio == THREAD_PRIO_URGENT)
+		thread_urgent_update(m);
+}
+
 #if defined(__APPLE__)
 #include <mach/mach.h>
 #include <mach/mach_time.h>
@@ -89,6 +150,329 @@ static pthread_mutex_t masters_mtx = PTHREAD_MUTEX_INITIALIZER;
 static struct list *masters;
 
 static void thread_free(struct thread_master *master, struct thread *thread);
+static enum thread_io_backend thread_io_backend_default(void);
+
+static const char *const thread_io_backend_names[] = {
+	[THREAD_IO_POLL] = "poll",
+	[THREAD_IO_EPOLL] = "epoll",
+	[THREAD_IO_KQUEUE] = "kqueue",
+};
+
+/* true if pfds is mirrored into an epoll/kqueue instance */
+#define IO_KERNEL(m) ((m)->handler.backend != THREAD_IO_POLL)
+
+/* max. number of ready events fetched from the kernel per wakeup */
+#define THREAD_IO_EVENTS 256
+
+/*
+ * Hierarchical timing wheel (Varghese & Lauck), used in place of the timer
+ * heap on thread_masters that ask for it.  Resolution is 1ms: level 0 has a
+ * slot for each of the next 256ms, and every further level has 64 slots each
+ * covering one full turn of the level below.  Timers are moved down a level
+ * ("cascaded") when the level below wraps around, so each timer is touched
+ * at most once per level.  Anything beyond the top level (~49 days) is
+ * parked in it and re-inserted when it comes up.
+ */
+#define WHEEL_L0_BITS 8
+#define WHEEL_LN_BITS 6
+#define WHEEL_LEVELS 5
+#define WHEEL_L0_SIZE (1U << WHEEL_L0_BITS)
+#define WHEEL_LN_SIZE (1U << WHEEL_LN_BITS)
+#define WHEEL_SLOTS (WHEEL_L0_SIZE + (WHEEL_LEVELS - 1) * WHEEL_LN_SIZE)
+#define WHEEL_MAX_DELTA                                                        \
+	((1ULL << (WHEEL_L0_BITS + (WHEEL_LEVELS - 1) * WHEEL_LN_BITS)) - 1)
+
+DECLARE_DLIST(thread_wheel_list, struct thread, wheelitem);
+
+struct thread_wheel {
+	/* next tick (ms of monotonic time) that hasn't been processed yet */
+	uint64_t base;
+	/* tick the owner last went to sleep until, 0 if no timer was set */
+	uint64_t wait_tick;
+	size_t count;
+
+	uint64_t occupied[WHEEL_SLOTS / 64];
+	struct thread_wheel_list_head slots[WHEEL_SLOTS];
+};
+
+/* timers may not run early, so round up */
+static uint64_t wheel_tick(const struct timeval *tv)
+{
+	return tv->tv_sec * 1000ULL + (tv->tv_usec + 999) / 1000;
+}
+
+static uint64_t wheel_tick_floor(const struct timeval *tv)
+{
+	return tv->tv_sec * 1000ULL + tv->tv_usec / 1000;
+}
+
+static struct thread_wheel *wheel_new(void)
+{
+	struct thread_wheel *w;
+	struct timeval now;
+
+	w = XCALLOC(MTYPE_THREAD_MASTER, sizeof(*w));
+	for (size_t i = 0; i < WHEEL_SLOTS; i++)
+		thread_wheel_list_init(&w->slots[i]);
+
+	monotime(&now);
+	w->base = wheel_tick_floor(&now);
+	return w;
+}
+
+static void wheel_slot_add(struct thread_wheel *w, unsigned int slot,
+			   struct thread *thread)
+{
+	thread_wheel_list_add_tail(&w->slots[slot], thread);
+	thread->wheelslot = slot;
+	w->occupied[slot / 64] |= 1ULL << (slot % 64);
+}
+
+static void wheel_add(struct thread_wheel *w, struct thread *thread)
+{
+	uint64_t expires = wheel_tick(&thread->u.sands);
+	uint64_t delta;
+	unsigned int level, shift, slot;
+
+	if (expires < w->base)
+		expires = w->base;
+	delta = expires - w->base;
+	if (delta > WHEEL_MAX_DELTA) {
+		delta = WHEEL_MAX_DELTA;
+		expires = w->base + delta;
+	}
+
+	if (delta < WHEEL_L0_SIZE)
+		slot = expires & (WHEEL_L0_SIZE - 1);
+	else {
+		for (level = 1; level < WHEEL_LEVELS - 1; level++)
+			if (delta < (1ULL << (WHEEL_L0_BITS
+					      + level * WHEEL_LN_BITS)))
+				break;
+
+		shift = WHEEL_L0_BITS + (level - 1) * WHEEL_LN_BITS;
+		slot = WHEEL_L0_SIZE + (level - 1) * WHEEL_LN_SIZE
+		       + ((expires >> shift) & (WHEEL_LN_SIZE - 1));
+	}
+
+	wheel_slot_add(w, slot, thread);
+	w->count++;
+}
+
+static void wheel_del(struct thread_wheel *w, struct thread *thread)
+{
+	unsigned int slot = thread->wheelslot;
+
+	thread_wheel_list_del(&w->slots[slot], thread);
+	if (!thread_wheel_list_count(&w->slots[slot]))
+		w->occupied[slot / 64] &= ~(1ULL << (slot % 64));
+	w->count--;
+}
+
+/* Re-insert the contents of the slots that come up on the higher levels
+ * now that level 0 wrapped around.
+ */
+static void wheel_cascade(struct thread_wheel *w)
+{
+	struct thread_wheel_list_head tmp;
+	struct thread *thread;
+	unsigned int level, shift, idx, slot;
+
+	for (level = 1; level < WHEEL_LEVELS; level++) {
+		shift = WHEEL_L0_BITS + (level - 1) * WHEEL_LN_BITS;
+		idx = (w->base >> shift) & (WHEEL_LN_SIZE - 1);
+		slot = WHEEL_L0_SIZE + (level - 1) * WHEEL_LN_SIZE + idx;
+
+		thread_wheel_list_init(&tmp);
+		thread_wheel_list_swap_all(&tmp, &w->slots[slot]);
+		w->occupied[slot / 64] &= ~(1ULL << (slot % 64));
+
+		while ((thread = thread_wheel_list_pop(&tmp))) {
+			w->count--;
+			wheel_add(w, thread);
+		}
+
+		/* next level only comes up if this one wrapped too */
+		if (idx)
+			break;
+	}
+}
+
+/* first occupied level 0 slot in [from, WHEEL_L0_SIZE), -1 if none */
+static int wheel_l0_next(const struct thread_wheel *w, unsigned int from)
+{
+	for (unsigned int i = from / 64; i < WHEEL_L0_SIZE / 64; i++) {
+		uint64_t bits = w->occupied[i];
+
+		if (i == from / 64)
+			bits &= ~0ULL << (from % 64);
+		if (bits)
+			return i * 64 + __builtin_ctzll(bits);
+	}
+	return -1;
+}
+
+static bool wheel_upper_occupied(const struct thread_wheel *w)
+{
+	for (unsigned int i = WHEEL_L0_SIZE / 64; i < WHEEL_SLOTS / 64; i++)
+		if (w->occupied[i])
+			return true;
+	return false;
+}
+
+/* Earliest tick at which something may need doing, false if no timers.
+ * This can be early (when timers need to be cascaded), but never late.
+ */
+static bool wheel_next_tick(const struct thread_wheel *w, uint64_t *tick)
+{
+	unsigned int idx = w->base & (WHEEL_L0_SIZE - 1);
+	uint64_t boundary = w->base - idx + WHEEL_L0_SIZE;
+	int next;
+
+	if (!w->count)
+		return false;
+
+	/* level 0 wrapped but the cascade hasn't run yet */
+	if (!idx) {
+		*tick = w->base;
+		return true;
+	}
+
+	next = wheel_l0_next(w, idx);
+	if (next >= 0) {
+		*tick = w->base - idx + next;
+		return true;
+	}
+
+	/* what's left on level 0 belongs to the next turn */
+	next = wheel_l0_next(w, 0);
+	if (next >= 0 && !wheel_upper_occupied(w))
+		*tick = boundary + next;
+	else
+		*tick = boundary;
+	return true;
+}
+
+/* Move everything expiring up to timenow onto the ready list, one batch per
+ * level 0 slot.  Empty slots are skipped using the occupancy bitmap.
+ */
+static unsigned int wheel_expire(struct thread_master *m,
+				 const struct timeval *timenow)
+{
+	struct thread_wheel *w = m->wheel;
+	uint64_t now = wheel_tick_floor(timenow);
+	struct thread *thread;
+	unsigned int ready = 0;
+	unsigned int idx;
+	int next;
+
+	while (w->base <= now) {
+		if (!w->count) {
+			w->base = now + 1;
+			break;
+		}
+
+		idx = w->base & (WHEEL_L0_SIZE - 1);
+		if (!idx)
+			wheel_cascade(w);
+
+		while ((thread = thread_wheel_list_pop(&w->slots[idx]))) {
+			w->count--;
+			thread_ready_add(m, thread);
+			ready++;
+		}
+		w->occupied[idx / 64] &= ~(1ULL << (idx % 64));
+
+		w->base++;
+		if (idx == WHEEL_L0_SIZE - 1)
+			continue;
+
+		/* fast forward to the next slot with timers, or the next
+		 * turn of level 0 since that needs a cascade
+		 */
+		next = wheel_l0_next(w, idx + 1);
+		if (next < 0)
+			next = WHEEL_L0_SIZE;
+		w->base = MIN(w->base - (idx + 1) + next, now + 1);
+	}
+
+	return ready;
+}
+
+static void wheel_free(struct thread_master *m)
+{
+	struct thread_wheel *w = m->wheel;
+	struct thread *thread;
+
+	for (size_t i = 0; i < WHEEL_SLOTS; i++) {
+		while ((thread = thread_wheel_list_pop(&w->slots[i])))
+			thread_free(m, thread);
+		thread_wheel_list_fini(&w->slots[i]);
+	}
+	XFREE(MTYPE_THREAD_MASTER, m->wheel);
+}
+
+/* Timer storage dispatch, heap or wheel.  All need m->mtx held. */
+static void thread_timer_add(struct thread_master *m, struct thread *thread)
+{
+	if (thread->prio == THREAD_PRIO_URGENT) {
+		thread_timer_list_add(&m->timer_urgent, thread);
+		thread_urgent_update(m);
+	} else if (m->wheel)
+		wheel_add(m->wheel, thread);
+	else
+		thread_timer_list_add(&m->timer, thread);
+}
+
+static void thread_timer_del(struct thread_master *m, struct thread *thread)
+{
+	if (thread->prio == THREAD_PRIO_URGENT) {
+		thread_timer_list_del(&m->timer_urgent, thread);
+		thread_urgent_update(m);
+	} else if (m->wheel)
+		wheel_del(m->wheel, thread);
+	else
+		thread_timer_list_del(&m->timer, thread);
+}
+
+/* would the owner need to wake up earlier to run this new timer? */
+static bool thread_timer_is_next(struct thread_master *m,
+				 struct thread *thread)
+{
+	if (thread->prio == THREAD_PRIO_URGENT)
+		return thread_timer_list_first(&m->timer_urgent) == thread;
+	if (m->wheel)
+		return !m->wheel->wait_tick
+		       || wheel_tick(&thread->u.sands) < m->wheel->wait_tick;
+
+	return thread_timer_list_first(&m->timer) == thread;
+}
+
+void thread_master_set_timer_wheel(struct thread_master *m, bool enable)
+{
+	struct thread *thread;
+	size_t i;
+
+	frr_with_mutex(&m->mtx) {
+		if (enable == !!m->wheel)
+			break;
+
+		if (enable) {
+			m->wheel = wheel_new();
+			while ((thread = thread_timer_list_pop(&m->timer)))
+				wheel_add(m->wheel, thread);
+		} else {
+			for (i = 0; i < WHEEL_SLOTS; i++)
+				while ((thread = thread_wheel_list_pop(
+						&m->wheel->slots[i])))
+					thread_timer_list_add(&m->timer, thread);
+			m->wheel->count = 0;
+			wheel_free(m);
+		}
+
+		AWAKEN(m);
+	}
+}
 
 #ifndef EXCLUDE_CPU_TIME
 #define EXCLUDE_CPU_TIME 0
@@ -100,6 +484,7 @@ static void thread_free(struct thread_master *master, struct thread *thread);
 bool cputime_enabled = !EXCLUDE_CPU_TIME;
 unsigned long cputime_threshold = CONSUMED_TIME_CHECK;
 unsigned long walltime_threshold = CONSUMED_TIME_CHECK;
+unsigned long timeline_threshold;
 
 /* CLI start ---------------------------------------------------------------- */
 #ifndef VTYSH_EXTRACT_PL
@@ -128,6 +513,55 @@ static void *cpu_record_hash_alloc(struct cpu_thread_history *a)
 	return new;
 }
 
+static unsigned int thread_hist_bucket(uint64_t usec)
+{
+	unsigned int msb, shift;
+
+	if (usec > UINT32_MAX)
+		usec = UINT32_MAX;
+	if (usec < (1U << THREAD_HIST_SUBBITS))
+		return usec;
+
+	msb = 63 - __builtin_clzll(usec);
+	shift = msb - THREAD_HIST_SUBBITS;
+	return ((shift + 1) << THREAD_HIST_SUBBITS)
+	       + ((usec >> shift) & ((1U << THREAD_HIST_SUBBITS) - 1));
+}
+
+/* highest value that goes into a bucket */
+static uint64_t thread_hist_value(unsigned int bucket)
+{
+	unsigned int step = 1U << THREAD_HIST_SUBBITS;
+	unsigned int shift;
+
+	if (bucket < step)
+		return bucket;
+
+	shift = bucket / step - 1;
+	return ((uint64_t)(step + bucket % step + 1) << shift) - 1;
+}
+
+static void thread_hist_add(_Atomic uint32_t *hist, uint64_t usec)
+{
+	atomic_fetch_add_explicit(&hist[thread_hist_bucket(usec)], 1,
+				  memory_order_relaxed);
+}
+
+/* permille of the recorded values are at or below the result */
+static uint64_t thread_hist_percentile(const uint32_t *hist, uint64_t total,
+				       unsigned int permille)
+{
+	uint64_t want = (total * permille + 999) / 1000, seen = 0;
+	unsigned int i;
+
+	for (i = 0; i < THREAD_HIST_BUCKETS; i++) {
+		seen += hist[i];
+		if (seen >= want && seen)
+			return thread_hist_value(i);
+	}
+	return 0;
+}
+
 static void cpu_record_hash_free(void *a)
 {
 	struct cpu_thread_history *hist = a;
@@ -419,8 +853,12 @@ static void show_thread_poll_helper(struct vty *vty, struct thread_master *m)
 
 	vty_out(vty, "\nShowing poll FD's for %s\n", name);
 	vty_out(vty, "----------------------%s\n", underline);
+	vty_out(vty, "Backend: %s\n",
+		thread_io_backend_names[m->handler.backend]);
 	vty_out(vty, "Count: %u/%d\n", (uint32_t)m->handler.pfdcount,
 		m->fd_limit);
+	vty_out(vty, "Wakeups: %" PRIu64 ", ready events: %" PRIu64 "\n",
+		m->handler.wakeups, m->handler.ready_events);
 	for (i = 0; i < m->handler.pfdcount; i++) {
 		vty_out(vty, "\t%6d fd:%6d events:%2d revents:%2d\t\t", i,
 			m->handler.pfds[i].fd, m->handler.pfds[i].events,
@@ -467,6 +905,143 @@ DEFUN_NOSH (show_thread_poll,
 	return CMD_SUCCESS;
 }
 
+static void show_thread_timeline_helper(struct vty *vty,
+					struct thread_master *m,
+					unsigned int count)
+{
+	const char *name = m->name ? m->name : "main";
+	const struct thread_timeline_entry *te;
+	struct timeval tv;
+	int64_t now;
+	size_t pos;
+
+	vty_out(vty, "\nShowing the last tasks for pthread %s\n", name);
+	vty_out(vty, "%10s %11s %11s  %s\n", "Ago(ms)", "Run(uSec)",
+		"Queue(uSec)", "Thread");
+
+	monotime(&tv);
+	now = tv.tv_sec * TIMER_SECOND_MICRO + tv.tv_usec;
+
+	pos = atomic_load_explicit(&m->timeline_pos, memory_order_acquire);
+	count = MIN(count, MIN(pos, THREAD_TIMELINE_SIZE));
+
+	/* most recent first */
+	while (count--) {
+		te = &m->timeline[--pos % THREAD_TIMELINE_SIZE];
+		if (!te->xref)
+			continue;
+
+		vty_out(vty, "%10" PRId64 " %11u %11u  %s (%s:%d)\n",
+			(now - te->start) / 1000, te->real, te->delay,
+			te->xref->funcname, te->xref->xref.file,
+			te->xref->xref.line);
+	}
+}
+
+DEFPY_NOSH (show_thread_timeline,
+	    show_thread_timeline_cmd,
+	    "show thread timeline [(1-1024)$count]",
+	    SHOW_STR
+	    "Thread information\n"
+	    "Last tasks run, with their run time and queueing delay\n"
+	    "Number of tasks to show per pthread (default 32)\n")
+{
+	struct listnode *node;
+	struct thread_master *m;
+
+	frr_with_mutex(&masters_mtx) {
+		for (ALL_LIST_ELEMENTS_RO(masters, node, m))
+			show_thread_timeline_helper(vty, m,
+						    count ? count : 32);
+	}
+
+	return CMD_SUCCESS;
+}
+
+static void thread_latency_hash_print(struct hash_bucket *bucket,
+				      struct vty *vty)
+{
+	static const unsigned int permille[] = {500, 900, 990, 999};
+	struct cpu_thread_history *a = bucket->data;
+	uint32_t real[THREAD_HIST_BUCKETS], delay[THREAD_HIST_BUCKETS];
+	uint64_t total = 0;
+	unsigned int i;
+
+	for (i = 0; i < THREAD_HIST_BUCKETS; i++) {
+		real[i] = atomic_load_explicit(&a->hist_real[i],
+					       memory_order_relaxed);
+		delay[i] = atomic_load_explicit(&a->hist_delay[i],
+						memory_order_relaxed);
+		total += real[i];
+	}
+	if (!total)
+		return;
+
+	vty_out(vty, "%9" PRIu64, total);
+	for (i = 0; i < array_size(permille); i++)
+		vty_out(vty, " %8" PRIu64,
+			thread_hist_percentile(real, total, permille[i]));
+	vty_out(vty, " ");
+	for (i = 0; i < array_size(permille); i++)
+		vty_out(vty, " %8" PRIu64,
+			thread_hist_percentile(delay, total, permille[i]));
+	vty_out(vty, "  %s\n", a->funcname);
+}
+
+DEFUN_NOSH (show_thread_latency,
+	    show_thread_latency_cmd,
+	    "show thread latency",
+	    SHOW_STR
+	    "Thread information\n"
+	    "Run time and queueing delay percentiles per task\n")
+{
+	struct listnode *node;
+	struct thread_master *m;
+
+	frr_with_mutex(&masters_mtx) {
+		for (ALL_LIST_ELEMENTS_RO(masters, node, m)) {
+			vty_out(vty, "\nShowing latencies for pthread %s\n",
+				m->name ? m->name : "main");
+			vty_out(vty, "%9s %35s %35s\n", "",
+				"Run time (uSec):", "Queueing delay (uSec):");
+			vty_out(vty,
+				"%9s %8s %8s %8s %8s  %8s %8s %8s %8s  Thread\n",
+				"Invoked", "p50", "p90", "p99", "p99.9", "p50",
+				"p90", "p99", "p99.9");
+
+			frr_with_mutex(&m->mtx) {
+				hash_iterate(m->cpu_record,
+					     (void (*)(struct hash_bucket *,
+						       void *))thread_latency_hash_print,
+					     vty);
+			}
+		}
+	}
+
+	return CMD_SUCCESS;
+}
+
+DEFPY (service_timeline_dump,
+       service_timeline_dump_cmd,
+       "[no] service timeline-dump (1-4294967295)",
+       NO_STR
+       "Set up miscellaneous service\n"
+       "Log the last tasks run when one exceeds a wallclock threshold\n"
+       "Threshold in milliseconds\n")
+{
+	if (no)
+		timeline_threshold = 0;
+	else
+		timeline_threshold = timeline_dump * 1000;
+	return CMD_SUCCESS;
+}
+
+ALIAS (service_timeline_dump,
+       no_service_timeline_dump_cmd,
+       "no service timeline-dump",
+       NO_STR
+       "Set up miscellaneous service\n"
+       "Log the last tasks run when one exceeds a wallclock threshold\n")
 
 DEFUN (clear_thread_cpu,
        clear_thread_cpu_cmd,
@@ -497,6 +1072,8 @@ void thread_cmd_init(void)
 {
 	install_element(VIEW_NODE, &show_thread_cpu_cmd);
 	install_element(VIEW_NODE, &show_thread_poll_cmd);
+	install_element(VIEW_NODE, &show_thread_timeline_cmd);
+	install_element(VIEW_NODE, &show_thread_latency_cmd);
 	install_element(ENABLE_NODE, &clear_thread_cpu_cmd);
 
 	install_element(CONFIG_NODE, &service_cputime_stats_cmd);
@@ -504,6 +1081,8 @@ void thread_cmd_init(void)
 	install_element(CONFIG_NODE, &no_service_cputime_warning_cmd);
 	install_element(CONFIG_NODE, &service_walltime_warning_cmd);
 	install_element(CONFIG_NODE, &no_service_walltime_warning_cmd);
+	install_element(CONFIG_NODE, &service_timeline_dump_cmd);
+	install_element(CONFIG_NODE, &no_service_timeline_dump_cmd);
 }
 /* CLI end ------------------------------------------------------------------ */
 
@@ -551,6 +1130,9 @@ struct thread_master *thread_master_create(const char *name)
 	rv->write = XCALLOC(MTYPE_THREAD_POLL,
 			    sizeof(struct thread *) * rv->fd_limit);
 
+	rv->timeline = XCALLOC(MTYPE_THREAD_STATS,
+			       sizeof(*rv->timeline) * THREAD_TIMELINE_SIZE);
+
 	char tmhashname[strlen(name) + 32];
 	snprintf(tmhashname, sizeof(tmhashname), "%s - threadmaster event hash",
 		 name);
@@ -561,8 +1143,11 @@ struct thread_master *thread_master_create(const char *name)
 
 	thread_list_init(&rv->event);
 	thread_list_init(&rv->ready);
+	thread_list_init(&rv->ready_urgent);
+	thread_list_init(&rv->ready_bg);
 	thread_list_init(&rv->unuse);
 	thread_timer_list_init(&rv->timer);
+	thread_timer_list_init(&rv->timer_urgent);
 
 	/* Initialize thread_fetch() settings */
 	rv->spin = true;
@@ -587,6 +1172,17 @@ struct thread_master *thread_master_create(const char *name)
 	rv->handler.copy = XCALLOC(MTYPE_THREAD_MASTER,
 				   sizeof(struct pollfd) * rv->handler.pfdsize);
 
+	/* The kernel event queue itself is only created by the owning
+	 * pthread in thread_fetch(), since kqueues don't survive fork().
+	 */
+	rv->handler.backend = thread_io_backend_default();
+	rv->handler.kqfd = -1;
+	if (IO_KERNEL(rv)) {
+		rv->handler.pfdpos = XMALLOC(MTYPE_THREAD_POLL,
+					     sizeof(int) * rv->fd_limit);
+		memset(rv->handler.pfdpos, 0xff, sizeof(int) * rv->fd_limit);
+	}
+
 	/* add to list of threadmasters */
 	frr_with_mutex(&masters_mtx) {
 		if (!masters)
@@ -689,8 +1285,14 @@ void thread_master_free(struct thread_master *m)
 	thread_array_free(m, m->write);
 	while ((t = thread_timer_list_pop(&m->timer)))
 		thread_free(m, t);
+	while ((t = thread_timer_list_pop(&m->timer_urgent)))
+		thread_free(m, t);
+	if (m->wheel)
+		wheel_free(m);
 	thread_list_free(m, &m->event);
 	thread_list_free(m, &m->ready);
+	thread_list_free(m, &m->ready_urgent);
+	thread_list_free(m, &m->ready_bg);
 	thread_list_free(m, &m->unuse);
 	pthread_mutex_destroy(&m->mtx);
 	pthread_cond_destroy(&m->cancel_cond);
@@ -702,8 +1304,13 @@ void thread_master_free(struct thread_master *m)
 	hash_clean(m->cpu_record, cpu_record_hash_free);
 	hash_free(m->cpu_record);
 	m->cpu_record = NULL;
+	XFREE(MTYPE_THREAD_STATS, m->timeline);
 
 	XFREE(MTYPE_THREAD_MASTER, m->name);
+	if (m->handler.kqfd >= 0)
+		close(m->handler.kqfd);
+	XFREE(MTYPE_THREAD_POLL, m->handler.pfdpos);
+	XFREE(MTYPE_THREAD_POLL, m->handler.evbuf);
 	XFREE(MTYPE_THREAD_MASTER, m->handler.pfds);
 	XFREE(MTYPE_THREAD_MASTER, m->handler.copy);
 	XFREE(MTYPE_THREAD_MASTER, m);
@@ -783,10 +1390,12 @@ static struct thread *thread_get(struct thread_master *m, uint8_t type,
 
 	thread->type = type;
 	thread->add_type = type;
+	thread->prio = THREAD_PRIO_NORMAL;
 	thread->master = m;
 	thread->arg = arg;
 	thread->yield = THREAD_YIELD_TIME_SLOT; /* default */
 	thread->ref = NULL;
+	thread->ready_since = 0;
 
 	/*
 	 * So if the passed in funcname is not what we have
@@ -824,8 +1433,351 @@ static void thread_free(struct thread_master *master, struct thread *thread)
 	XFREE(MTYPE_THREAD, thread);
 }
 
+/* I/O multiplexer backends ------------------------------------------------- */
+
+static bool thread_io_backend_supported(enum thread_io_backend backend)
+{
+	switch (backend) {
+	case THREAD_IO_POLL:
+		return true;
+	case THREAD_IO_EPOLL:
+#ifdef HAVE_EPOLL
+		return true;
+#else
+		return false;
+#endif
+	case THREAD_IO_KQUEUE:
+#ifdef HAVE_KQUEUE
+		return true;
+#else
+		return false;
+#endif
+	}
+	return false;
+}
+
+static enum thread_io_backend thread_io_backend_default(void)
+{
+	const char *name = frr_get_io_backend();
+	size_t i;
+
+	if (name) {
+		for (i = 0; i < array_size(thread_io_backend_names); i++)
+			if (!strcmp(name, thread_io_backend_names[i])
+			    && thread_io_backend_supported(i))
+				return i;
+
+		zlog_warn("I/O backend \"%s\" is not available, using default",
+			  name);
+	}
+
+#if defined(HAVE_EPOLL)
+	return THREAD_IO_EPOLL;
+#elif defined(HAVE_KQUEUE)
+	return THREAD_IO_KQUEUE;
+#else
+	return THREAD_IO_POLL;
+#endif
+}
+
+/* Find the pfds index for fd, -1 if there is none. */
+static int thread_pfd_find(struct thread_master *m, int fd)
+{
+	struct fd_handler *h = &m->handler;
+	int pos;
+
+	if (IO_KERNEL(m)) {
+		pos = h->pfdpos[fd];
+		if (pos >= 0 && (nfds_t)pos < h->pfdcount
+		    && h->pfds[pos].fd == fd)
+			return pos;
+		return -1;
+	}
+
+	for (nfds_t i = 0; i < h->pfdcount; i++)
+		if (h->pfds[i].fd == fd)
+			return i;
+	return -1;
+}
+
+/* Remove entry i from pfds.  Does not touch the poll() copy. */
+static void thread_pfd_remove(struct thread_master *m, nfds_t i)
+{
+	struct fd_handler *h = &m->handler;
+
+	if (IO_KERNEL(m)) {
+		/* nobody depends on the order here, so just fill the hole
+		 * with the last entry.
+		 */
+		h->pfdpos[h->pfds[i].fd] = -1;
+		h->pfdcount--;
+		if (i != h->pfdcount) {
+			h->pfds[i] = h->pfds[h->pfdcount];
+			h->pfdpos[h->pfds[i].fd] = i;
+		}
+	} else {
+		memmove(h->pfds + i, h->pfds + i + 1,
+			(h->pfdcount - i - 1) * sizeof(struct pollfd));
+		h->pfdcount--;
+	}
+
+	h->pfds[h->pfdcount].fd = 0;
+	h->pfds[h->pfdcount].events = 0;
+}
+
+/* Change the kernel's interest for fd from old to new (POLLIN/POLLOUT). */
+static int thread_io_kernel_ctl(struct thread_master *m, int fd, short old,
+				short new)
+{
+#ifdef HAVE_EPOLL
+	if (m->handler.backend == THREAD_IO_EPOLL) {
+		struct epoll_event ev = {};
+		int op;
+
+		ev.data.fd = fd;
+		if (new & POLLIN)
+			ev.events |= EPOLLIN;
+		if (new & POLLOUT)
+			ev.events |= EPOLLOUT;
+
+		if (!new)
+			op = EPOLL_CTL_DEL;
+		else if (!old)
+			op = EPOLL_CTL_ADD;
+		else
+			op = EPOLL_CTL_MOD;
+
+		if (epoll_ctl(m->handler.kqfd, op, fd, &ev) == 0)
+			return 0;
+
+		/* if the fd was closed (and possibly reused) behind our back,
+		 * the kernel already forgot about it
+		 */
+		if (op == EPOLL_CTL_DEL && (errno == ENOENT || errno == EBADF))
+			return 0;
+		if (op == EPOLL_CTL_ADD && errno == EEXIST)
+			return epoll_ctl(m->handler.kqfd, EPOLL_CTL_MOD, fd,
+					 &ev);
+		if (op == EPOLL_CTL_MOD && errno == ENOENT)
+			return epoll_ctl(m->handler.kqfd, EPOLL_CTL_ADD, fd,
+					 &ev);
+		return -1;
+	}
+#endif
+#ifdef HAVE_KQUEUE
+	if (m->handler.backend == THREAD_IO_KQUEUE) {
+		static const struct {
+			short pollev;
+			short filter;
+		} filters[] = {
+			{POLLIN, EVFILT_READ},
+			{POLLOUT, EVFILT_WRITE},
+		};
+		struct kevent kev;
+
+		/* one change at a time, so errors map to a single filter */
+		for (size_t i = 0; i < array_size(filters); i++) {
+			bool add = !!(new & filters[i].pollev);
+
+			if (add == !!(old & filters[i].pollev))
+				continue;
+
+			EV_SET(&kev, fd, filters[i].filter,
+			       add ? EV_ADD : EV_DELETE, 0, 0, NULL);
+			if (kevent(m->handler.kqfd, &kev, 1, NULL, 0, NULL) < 0
+			    && (add || (errno != ENOENT && errno != EBADF)))
+				return -1;
+		}
+		return 0;
+	}
+#endif
+	errno = ENOTSUP;
+	return -1;
+}
+
+/* Drop back to poll() for this thread_master.  pfds already holds the full
+ * interest set, so nothing is lost; the kernel queue gets closed by the
+ * owner in thread_fetch() since it may currently be waiting on it.
+ */
+static void thread_io_fallback(struct thread_master *m)
+{
+	m->handler.backend = THREAD_IO_POLL;
+	AWAKEN(m);
+}
+
+/* Push a change of pfds[].events for fd to the kernel event queue. */
+static void thread_io_update(struct thread_master *m, int fd, short old,
+			     short new)
+{
+	old &= (POLLIN | POLLOUT);
+	new &= (POLLIN | POLLOUT);
+
+	if (!IO_KERNEL(m) || m->handler.kqfd < 0 || old == new)
+		return;
+
+	if (thread_io_kernel_ctl(m, fd, old, new) == 0)
+		return;
+
+	if (errno == EPERM) {
+		/* epoll refuses regular files, poll() handles them fine */
+		zlog_info("%s: fd %d can't be watched with %s, falling back to poll()",
+			  m->name, fd, thread_io_backend_names[m->handler.backend]);
+		thread_io_fallback(m);
+		return;
+	}
+
+	flog_err(EC_LIB_SYSTEM_CALL, "%s: failed to update %s for fd %d: %s",
+		 m->name, thread_io_backend_names[m->handler.backend], fd,
+		 safe_strerror(errno));
+}
+
+/* Create the kernel event queue and load the current interest set into it.
+ * Must be called by the owning pthread with m->mtx held.
+ */
+static void thread_io_kernel_init(struct thread_master *m)
+{
+	struct fd_handler *h = &m->handler;
+	size_t evsize = 0;
+
+	if (h->kqfd >= 0)
+		return;
+
+#ifdef HAVE_EPOLL
+	if (h->backend == THREAD_IO_EPOLL) {
+		h->kqfd = epoll_create1(EPOLL_CLOEXEC);
+		evsize = sizeof(struct epoll_event);
+	}
+#endif
+#ifdef HAVE_KQUEUE
+	if (h->backend == THREAD_IO_KQUEUE) {
+		h->kqfd = kqueue();
+		if (h->kqfd >= 0)
+			fcntl(h->kqfd, F_SETFD, FD_CLOEXEC);
+		evsize = sizeof(struct kevent);
+	}
+#endif
+	if (h->kqfd < 0) {
+		flog_err(EC_LIB_SYSTEM_CALL,
+			 "%s: failed to create %s instance, falling back to poll(): %s",
+			 m->name, thread_io_backend_names[h->backend],
+			 safe_strerror(errno));
+		h->backend = THREAD_IO_POLL;
+		return;
+	}
+
+	if (!h->evbuf) {
+		h->evbufsize = MIN(THREAD_IO_EVENTS, (int)h->pfdsize - 1);
+		h->evbuf = XCALLOC(MTYPE_THREAD_POLL, evsize * h->evbufsize);
+	}
+
+	if (thread_io_kernel_ctl(m, m->io_pipe[0], 0, POLLIN) < 0) {
+		flog_err(EC_LIB_SYSTEM_CALL,
+			 "%s: failed to register wakeup pipe with %s: %s",
+			 m->name, thread_io_backend_names[h->backend],
+			 safe_strerror(errno));
+		thread_io_fallback(m);
+		return;
+	}
+
+	for (nfds_t i = 0; i < h->pfdcount && IO_KERNEL(m); i++)
+		thread_io_update(m, h->pfds[i].fd, 0, h->pfds[i].events);
+}
+
+/* Wait on the kernel event queue and translate whatever is ready into poll()
+ * style entries in m->handler.copy.  Returns the number of entries.
+ */
+static int thread_io_kernel_wait(struct thread_master *m, int timeout,
+				 sigset_t *origsigs)
+{
+	struct fd_handler *h = &m->handler;
+	unsigned char trash[64];
+	bool poked = false;
+	int num = -1;
+
+	h->copycount = 0;
+
+#ifdef HAVE_EPOLL
+	if (h->backend == THREAD_IO_EPOLL) {
+		struct epoll_event *evs = h->evbuf;
+
+		num = epoll_pwait(h->kqfd, evs, h->evbufsize, timeout,
+				  origsigs);
+		pthread_sigmask(SIG_SETMASK, origsigs, NULL);
+
+		for (int i = 0; i < num; i++) {
+			struct pollfd *pfd;
+
+			if (evs[i].data.fd == m->io_pipe[0]) {
+				poked = true;
+				continue;
+			}
+
+			pfd = &h->copy[h->copycount++];
+			pfd->fd = evs[i].data.fd;
+			pfd->events = 0;
+			pfd->revents = 0;
+			if (evs[i].events & EPOLLIN)
+				pfd->revents |= POLLIN;
+			if (evs[i].events & EPOLLOUT)
+				pfd->revents |= POLLOUT;
+			if (evs[i].events & EPOLLERR)
+				pfd->revents |= POLLERR;
+			if (evs[i].events & EPOLLHUP)
+				pfd->revents |= POLLHUP;
+		}
+	}
+#endif
+#ifdef HAVE_KQUEUE
+	if (h->backend == THREAD_IO_KQUEUE) {
+		struct kevent *evs = h->evbuf;
+		struct timespec ts, *tsp = NULL;
+
+		if (timeout >= 0) {
+			ts.tv_sec = timeout / 1000;
+			ts.tv_nsec = (timeout % 1000) * 1000000;
+			tsp = &ts;
+		}
+
+		/* Not ideal - same signal race as plain poll() */
+		pthread_sigmask(SIG_SETMASK, origsigs, NULL);
+		num = kevent(h->kqfd, NULL, 0, evs, h->evbufsize, tsp);
+
+		for (int i = 0; i < num; i++) {
+			struct pollfd *pfd;
+
+			if ((int)evs[i].ident == m->io_pipe[0]) {
+				poked = true;
+				continue;
+			}
+
+			/* read and write readiness come in as separate
+			 * events, thread_process_io_kernel() copes with that
+			 */
+			pfd = &h->copy[h->copycount++];
+			pfd->fd = evs[i].ident;
+			pfd->events = 0;
+			pfd->revents = 0;
+			if (evs[i].filter == EVFILT_READ)
+				pfd->revents |= POLLIN;
+			if (evs[i].filter == EVFILT_WRITE)
+				pfd->revents |= POLLOUT;
+			if (evs[i].flags & EV_EOF)
+				pfd->revents |= POLLHUP;
+			if (evs[i].flags & EV_ERROR)
+				pfd->revents |= POLLERR;
+		}
+	}
+#endif
+
+	if (poked)
+		while (read(m->io_pipe[0], &trash, sizeof(trash)) > 0)
+			;
+
+	return num < 0 ? num : (int)h->copycount;
+}
+
 static int fd_poll(struct thread_master *m, const struct timeval *timer_wait,
-		   bool *eintr_p)
+		   bool *eintr_p, bool kernel)
 {
 	sigset_t origsigs;
 	unsigned char trash[64];
@@ -861,10 +1813,12 @@ static int fd_poll(struct thread_master *m, const struct timeval *timer_wait,
 	rcu_assert_read_unlocked();
 
 	/* add poll pipe poker */
-	assert(count + 1 < m->handler.pfdsize);
-	m->handler.copy[count].fd = m->io_pipe[0];
-	m->handler.copy[count].events = POLLIN;
-	m->handler.copy[count].revents = 0x00;
+	if (!kernel) {
+		assert(count + 1 < m->handler.pfdsize);
+		m->handler.copy[count].fd = m->io_pipe[0];
+		m->handler.copy[count].events = POLLIN;
+		m->handler.copy[count].revents = 0x00;
+	}
 
 	/* We need to deal with a signal-handling race here: we
 	 * don't want to miss a crucial signal, such as SIGTERM or SIGINT,
@@ -889,6 +1843,11 @@ static int fd_poll(struct thread_master *m, const struct timeval *timer_wait,
 		pthread_sigmask(SIG_SETMASK, NULL, &origsigs);
 	}
 
+	if (kernel) {
+		num = thread_io_kernel_wait(m, timeout, &origsigs);
+		goto done;
+	}
+
 #if defined(HAVE_PPOLL)
 	struct timespec ts, *tsp;
 
@@ -912,7 +1871,7 @@ done:
 	if (num < 0 && errno == EINTR)
 		*eintr_p = true;
 
-	if (num > 0 && m->handler.copy[count].revents != 0 && num--)
+	if (!kernel && num > 0 && m->handler.copy[count].revents != 0 && num--)
 		while (read(m->io_pipe[0], &trash, sizeof(trash)) > 0)
 			;
 
@@ -951,6 +1910,8 @@ struct thread *_thread_add_read_write(const struct xref_threadsched *xref,
 
 		/* default to a new pollfd */
 		nfds_t queuepos = m->handler.pfdcount;
+		short oldevents = 0;
+		int pos;
 
 		if (dir == THREAD_READ)
 			thread_array = m->read;
@@ -959,20 +1920,20 @@ struct thread *_thread_add_read_write(const struct xref_threadsched *xref,
 
 		/* if we already have a pollfd for our file descriptor, find and
 		 * use it */
-		for (nfds_t i = 0; i < m->handler.pfdcount; i++)
-			if (m->handler.pfds[i].fd == fd) {
-				queuepos = i;
+		pos = thread_pfd_find(m, fd);
+		if (pos >= 0) {
+			queuepos = pos;
+			oldevents = m->handler.pfds[queuepos].events;
 
 #ifdef DEV_BUILD
-				/*
-				 * What happens if we have a thread already
-				 * created for this event?
-				 */
-				if (thread_array[fd])
-					assert(!"Thread already scheduled for file descriptor");
+			/*
+			 * What happens if we have a thread already
+			 * created for this event?
+			 */
+			if (thread_array[fd])
+				assert(!"Thread already scheduled for file descriptor");
 #endif
-				break;
-			}
+		}
 
 		/* make sure we have room for this fd + pipe poker fd */
 		assert(queuepos + 1 < m->handler.pfdsize);
@@ -983,8 +1944,14 @@ struct thread *_thread_add_read_write(const struct xref_threadsched *xref,
 		m->handler.pfds[queuepos].events |=
 			(dir == THREAD_READ ? POLLIN : POLLOUT);
 
-		if (queuepos == m->handler.pfdcount)
+		if (queuepos == m->handler.pfdcount) {
 			m->handler.pfdcount++;
+			if (IO_KERNEL(m))
+				m->handler.pfdpos[fd] = queuepos;
+		}
+
+		thread_io_update(m, fd, oldevents,
+				 m->handler.pfds[queuepos].events);
 
 		if (thread) {
 			frr_with_mutex(&thread->mtx) {
@@ -998,7 +1965,9 @@ struct thread *_thread_add_read_write(const struct xref_threadsched *xref,
 			}
 		}
 
-		AWAKEN(m);
+		/* the kernel event queue picked up the change already */
+		if (!IO_KERNEL(m) || m->handler.kqfd < 0)
+			AWAKEN(m);
 	}
 
 	return thread;
@@ -1034,7 +2003,7 @@ _thread_add_timer_timeval(const struct xref_threadsched *xref,
 
 		frr_with_mutex(&thread->mtx) {
 			thread->u.sands = t;
-			thread_timer_list_add(&m->timer, thread);
+			thread_timer_add(m, thread);
 			if (t_ptr) {
 				*t_ptr = thread;
 				thread->ref = t_ptr;
@@ -1045,7 +2014,7 @@ _thread_add_timer_timeval(const struct xref_threadsched *xref,
 		 * might change the time we'll wait for, give the pthread
 		 * a chance to re-compute.
 		 */
-		if (thread_timer_list_first(&m->timer) == thread)
+		if (thread_timer_is_next(m, thread))
 			AWAKEN(m);
 	}
 
@@ -1117,7 +2086,12 @@ struct thread *_thread_add_event(const struct xref_threadsched *xref,
 
 		thread = thread_get(m, THREAD_EVENT, func, arg, xref);
 		frr_with_mutex(&thread->mtx) {
+			struct timeval now;
+
 			thread->u.val = val;
+			monotime(&now);
+			thread->ready_since = now.tv_sec * TIMER_SECOND_MICRO
+					      + now.tv_usec;
 			thread_list_add_tail(&m->event, thread);
 		}
 
@@ -1151,51 +2125,45 @@ struct thread *_thread_add_event(const struct xref_threadsched *xref,
 static void thread_cancel_rw(struct thread_master *master, int fd, short state,
 			     int idx_hint)
 {
-	bool found = false;
-
 	/* find the index of corresponding pollfd */
 	nfds_t i;
+	int pos;
+	short oldevents;
 
 	/* Cancel POLLHUP too just in case some bozo set it */
 	state |= POLLHUP;
 
 	/* Some callers know the index of the pfd already */
-	if (idx_hint >= 0) {
-		i = idx_hint;
-		found = true;
-	} else {
+	if (idx_hint >= 0)
+		pos = idx_hint;
+	else
 		/* Have to look for the fd in the pfd array */
-		for (i = 0; i < master->handler.pfdcount; i++)
-			if (master->handler.pfds[i].fd == fd) {
-				found = true;
-				break;
-			}
-	}
+		pos = thread_pfd_find(master, fd);
 
-	if (!found) {
+	if (pos < 0) {
 		zlog_debug(
 			"[!] Received cancellation request for nonexistent rw job");
 		zlog_debug("[!] threadmaster: %s | fd: %d",
 			   master->name ? master->name : "", fd);
 		return;
 	}
+	i = pos;
 
 	/* NOT out event. */
+	oldevents = master->handler.pfds[i].events;
 	master->handler.pfds[i].events &= ~(state);
+	thread_io_update(master, master->handler.pfds[i].fd, oldevents,
+			 master->handler.pfds[i].events);
 
 	/* If all events are canceled, delete / resize the pollfd array. */
-	if (master->handler.pfds[i].events == 0) {
-		memmove(master->handler.pfds + i, master->handler.pfds + i + 1,
-			(master->handler.pfdcount - i - 1)
-				* sizeof(struct pollfd));
-		master->handler.pfdcount--;
-		master->handler.pfds[master->handler.pfdcount].fd = 0;
-		master->handler.pfds[master->handler.pfdcount].events = 0;
-	}
+	if (master->handler.pfds[i].events == 0)
+		thread_pfd_remove(master, i);
 
 	/* If we have the same pollfd in the copy, perform the same operations,
-	 * otherwise return. */
-	if (i >= master->handler.copycount)
+	 * otherwise return.  (Kernel backends don't use a copy - their ready
+	 * list is consumed before anything can be canceled.)
+	 */
+	if (IO_KERNEL(master) || i >= master->handler.copycount)
 		return;
 
 	master->handler.copy[i].events &= ~(state);
@@ -1214,6 +2182,21 @@ static void thread_cancel_rw(struct thread_master *master, int fd, short state,
  * Process task cancellation given a task argument: iterate through the
  * various lists of tasks, looking for any that match the argument.
  */
+static void cancel_arg_list(struct thread_master *master,
+			    struct thread_list_head *list, void *arg)
+{
+	struct thread *t;
+
+	frr_each_safe(thread_list, list, t) {
+		if (t->arg != arg)
+			continue;
+		thread_list_del(list, t);
+		if (t->ref)
+			*t->ref = NULL;
+		thread_add_unuse(master, t);
+	}
+}
+
 static void cancel_arg_helper(struct thread_master *master,
 			      const struct cancel_req *cr)
 {
@@ -1227,23 +2210,11 @@ static void cancel_arg_helper(struct thread_master *master,
 		return;
 
 	/* First process the ready lists. */
-	frr_each_safe(thread_list, &master->event, t) {
-		if (t->arg != cr->eventobj)
-			continue;
-		thread_list_del(&master->event, t);
-		if (t->ref)
-			*t->ref = NULL;
-		thread_add_unuse(master, t);
-	}
-
-	frr_each_safe(thread_list, &master->ready, t) {
-		if (t->arg != cr->eventobj)
-			continue;
-		thread_list_del(&master->ready, t);
-		if (t->ref)
-			*t->ref = NULL;
-		thread_add_unuse(master, t);
-	}
+	cancel_arg_list(master, &master->event, cr->eventobj);
+	cancel_arg_list(master, &master->ready_urgent, cr->eventobj);
+	cancel_arg_list(master, &master->ready, cr->eventobj);
+	cancel_arg_list(master, &master->ready_bg, cr->eventobj);
+	thread_urgent_update(master);
 
 	/* If requested, stop here and ignore io and timers */
 	if (CHECK_FLAG(cr->flags, THREAD_CANCEL_FLAG_READY))
@@ -1282,6 +2253,30 @@ static void cancel_arg_helper(struct thread_master *master,
 	}
 
 	/* Check the timer tasks */
+	frr_each_safe (thread_timer_list, &master->timer_urgent, t) {
+		if (t->arg != cr->eventobj)
+			continue;
+		thread_timer_list_del(&master->timer_urgent, t);
+		if (t->ref)
+			*t->ref = NULL;
+		thread_add_unuse(master, t);
+	}
+	thread_urgent_update(master);
+
+	if (master->wheel) {
+		for (i = 0; i < WHEEL_SLOTS; i++)
+			frr_each_safe (thread_wheel_list,
+				       &master->wheel->slots[i], t) {
+				if (t->arg != cr->eventobj)
+					continue;
+				wheel_del(master->wheel, t);
+				if (t->ref)
+					*t->ref = NULL;
+				thread_add_unuse(master, t);
+			}
+		return;
+	}
+
 	t = thread_timer_list_first(&master->timer);
 	while (t) {
 		struct thread *t_next;
@@ -1348,13 +2343,13 @@ static void do_thread_cancel(struct thread_master *master)
 			thread_array = master->write;
 			break;
 		case THREAD_TIMER:
-			thread_timer_list_del(&master->timer, thread);
+			thread_timer_del(master, thread);
 			break;
 		case THREAD_EVENT:
 			list = &master->event;
 			break;
 		case THREAD_READY:
-			list = &master->ready;
+			list = thread_ready_list(master, thread);
 			break;
 		default:
 			continue;
@@ -1363,6 +2358,8 @@ static void do_thread_cancel(struct thread_master *master)
 
 		if (list) {
 			thread_list_del(list, thread);
+			if (list == &master->ready_urgent)
+				thread_urgent_update(master);
 		} else if (thread_array) {
 			thread_array[thread->u.fd] = NULL;
 		}
@@ -1534,14 +2531,43 @@ void thread_cancel_async(struct thread_master *master, struct thread **thread,
 }
 /* ------------------------------------------------------------------------- */
 
-static struct timeval *thread_timer_wait(struct thread_timer_list_head *timers,
+static struct timeval *thread_timer_wait(struct thread_master *m,
 					 struct timeval *timer_val)
 {
-	if (!thread_timer_list_count(timers))
+	struct thread_timer_list_head *timers = &m->timer;
+	struct thread *urgent = thread_timer_list_first(&m->timer_urgent);
+	struct timeval deadline;
+
+	if (m->wheel) {
+		uint64_t tick;
+
+		if (!wheel_next_tick(m->wheel, &tick)) {
+			m->wheel->wait_tick = 0;
+			if (!urgent)
+				return NULL;
+			monotime_until(&urgent->u.sands, timer_val);
+			return timer_val;
+		}
+
+		m->wheel->wait_tick = tick;
+		deadline.tv_sec = tick / 1000;
+		deadline.tv_usec = (tick % 1000) * 1000;
+		if (urgent && timercmp(&urgent->u.sands, &deadline, <))
+			deadline = urgent->u.sands;
+		monotime_until(&deadline, timer_val);
+		return timer_val;
+	}
+
+	if (thread_timer_list_count(timers)) {
+		deadline = thread_timer_list_first(timers)->u.sands;
+		if (urgent && timercmp(&urgent->u.sands, &deadline, <))
+			deadline = urgent->u.sands;
+	} else if (urgent)
+		deadline = urgent->u.sands;
+	else
 		return NULL;
 
-	struct thread *next_timer = thread_timer_list_first(timers);
-	monotime_until(&next_timer->u.sands, timer_val);
+	monotime_until(&deadline, timer_val);
 	return timer_val;
 }
 
@@ -1586,8 +2612,7 @@ static int thread_process_io_helper(struct thread_master *m,
 		thread_array = m->write;
 
 	thread_array[thread->u.fd] = NULL;
-	thread_list_add_tail(&m->ready, thread);
-	thread->type = THREAD_READY;
+	thread_ready_add(m, thread);
 
 	return 1;
 }
@@ -1658,19 +2683,85 @@ static void thread_process_io(struct thread_master *m, unsigned int num)
 	}
 }
 
+/**
+ * Process I/O events returned by a kernel event queue.
+ *
+ * Unlike with poll(), m->handler.copy only holds the fds that are actually
+ * ready, and the kernel interest set must be updated to match whatever got
+ * dispatched.
+ *
+ * @param m the thread master
+ */
+static void thread_process_io_kernel(struct thread_master *m)
+{
+	struct pollfd *evs = m->handler.copy;
+
+	for (nfds_t i = 0; i < m->handler.copycount; i++) {
+		int fd = evs[i].fd;
+		short revents = evs[i].revents;
+		short events;
+		int pos;
+
+		/* may have been canceled while we were waiting */
+		pos = thread_pfd_find(m, fd);
+		if (pos < 0)
+			continue;
+
+		events = m->handler.pfds[pos].events;
+
+		/* Errors and hangups are given to both directions; the read
+		 * or write should fail and the handler deal with it.  Level
+		 * triggered queues would keep reporting them otherwise.
+		 */
+		if ((events & POLLIN) && (revents & (POLLIN | POLLHUP | POLLERR)))
+			thread_process_io_helper(m, m->read[fd], POLLIN,
+						 revents, pos);
+		if ((events & POLLOUT)
+		    && (revents & (POLLOUT | POLLHUP | POLLERR)))
+			thread_process_io_helper(m, m->write[fd], POLLOUT,
+						 revents, pos);
+
+		thread_io_update(m, fd, events, m->handler.pfds[pos].events);
+	}
+
+	m->handler.copycount = 0;
+}
+
+/* Same for the urgent timers only. */
+static unsigned int thread_process_urgent(struct thread_master *m,
+					  const struct timeval *timenow)
+{
+	struct thread *thread;
+	unsigned int ready = 0;
+
+	while ((thread = thread_timer_list_first(&m->timer_urgent))) {
+		if (timercmp(timenow, &thread->u.sands, <))
+			break;
+		thread_timer_list_pop(&m->timer_urgent);
+		thread_ready_add(m, thread);
+		ready++;
+	}
+
+	return ready;
+}
+
 /* Add all timers that have popped to the ready list. */
 static unsigned int thread_process_timers(struct thread_master *m,
 					  struct timeval *timenow)
 {
 	struct thread *thread;
-	unsigned int ready = 0;
+	unsigned int ready;
+
+	ready = thread_process_urgent(m, timenow);
+
+	if (m->wheel)
+		return ready + wheel_expire(m, timenow);
 
 	while ((thread = thread_timer_list_first(&m->timer))) {
 		if (timercmp(timenow, &thread->u.sands, <))
 			break;
 		thread_timer_list_pop(&m->timer);
-		thread->type = THREAD_READY;
-		thread_list_add_tail(&m->ready, thread);
+		thread_ready_add(m, thread);
 		ready++;
 	}
 
@@ -1684,8 +2775,7 @@ static unsigned int thread_process(struct thread_list_head *list)
 	unsigned int ready = 0;
 
 	while ((thread = thread_list_pop(list))) {
-		thread->type = THREAD_READY;
-		thread_list_add_tail(&thread->master->ready, thread);
+		thread_ready_add(thread->master, thread);
 		ready++;
 	}
 	return ready;
@@ -1701,6 +2791,7 @@ struct thread *thread_fetch(struct thread_master *m, struct thread *fetch)
 	struct timeval tv;
 	struct timeval *tw = NULL;
 	bool eintr_p = false;
+	bool kernel;
 	int num = 0;
 
 	do {
@@ -1713,11 +2804,25 @@ struct thread *thread_fetch(struct thread_master *m, struct thread *fetch)
 		/* Process any pending cancellation requests */
 		do_thread_cancel(m);
 
+		/*
+		 * Urgent timers don't wait for the ready queue to drain.
+		 */
+		if (thread_timer_list_count(&m->timer_urgent)
+		    && thread_ready_count(m)) {
+			monotime(&now);
+			thread_process_urgent(m, &now);
+		}
+
 		/*
 		 * Attempt to flush ready queue before going into poll().
 		 * This is performance-critical. Think twice before modifying.
 		 */
-		if ((thread = thread_list_pop(&m->ready))) {
+		if ((thread = thread_list_pop(&m->ready_urgent)))
+			thread_urgent_update(m);
+		else if (!(thread = thread_list_pop(&m->ready)))
+			thread = thread_list_pop(&m->ready_bg);
+
+		if (thread) {
 			fetch = thread_run(m, thread, fetch);
 			if (fetch->ref)
 				*fetch->ref = NULL;
@@ -1753,10 +2858,10 @@ struct thread *thread_fetch(struct thread_master *m, struct thread *fetch)
 		 * In every case except the last, we need to hit poll() at least
 		 * once per loop to avoid starvation by events
 		 */
-		if (!thread_list_count(&m->ready))
-			tw = thread_timer_wait(&m->timer, &tv);
+		if (!thread_ready_count(m))
+			tw = thread_timer_wait(m, &tv);
 
-		if (thread_list_count(&m->ready) ||
+		if (thread_ready_count(m) ||
 				(tw && !timercmp(tw, &zerotime, >)))
 			tw = &zerotime;
 
@@ -1766,21 +2871,38 @@ struct thread *thread_fetch(struct thread_master *m, struct thread *fetch)
 			break;
 		}
 
-		/*
-		 * Copy pollfd array + # active pollfds in it. Not necessary to
-		 * copy the array size as this is fixed.
-		 */
-		m->handler.copycount = m->handler.pfdcount;
-		memcpy(m->handler.copy, m->handler.pfds,
-		       m->handler.copycount * sizeof(struct pollfd));
+		if (IO_KERNEL(m))
+			thread_io_kernel_init(m);
+
+		kernel = IO_KERNEL(m);
+		if (!kernel) {
+			/* left over after falling back to poll() */
+			if (m->handler.kqfd >= 0) {
+				close(m->handler.kqfd);
+				m->handler.kqfd = -1;
+			}
+
+			/*
+			 * Copy pollfd array + # active pollfds in it. Not
+			 * necessary to copy the array size as this is fixed.
+			 */
+			m->handler.copycount = m->handler.pfdcount;
+			memcpy(m->handler.copy, m->handler.pfds,
+			       m->handler.copycount * sizeof(struct pollfd));
+		}
 
 		pthread_mutex_unlock(&m->mtx);
 		{
 			eintr_p = false;
-			num = fd_poll(m, tw, &eintr_p);
+			num = fd_poll(m, tw, &eintr_p, kernel);
 		}
 		pthread_mutex_lock(&m->mtx);
 
+		if (num >= 0) {
+			m->handler.wakeups++;
+			m->handler.ready_events += num;
+		}
+
 		/* Handle any errors received in poll() */
 		if (num < 0) {
 			if (eintr_p) {
@@ -1802,7 +2924,9 @@ struct thread *thread_fetch(struct thread_master *m, struct thread *fetch)
 		thread_process_timers(m, &now);
 
 		/* Post I/O to ready queue. */
-		if (num > 0)
+		if (kernel)
+			thread_process_io_kernel(m);
+		else if (num > 0)
 			thread_process_io(m, num);
 
 		pthread_mutex_unlock(&m->mtx);
@@ -1845,11 +2969,23 @@ unsigned long thread_consumed_time(RUSAGE_T *now, RUSAGE_T *start,
 int thread_should_yield(struct thread *thread)
 {
 	int result;
+	int64_t due;
+	struct timeval now;
+
 	frr_with_mutex(&thread->mtx) {
 		result = monotime_since(&thread->real, NULL)
 			 > (int64_t)thread->yield;
 	}
-	return result;
+	if (result || !thread->master)
+		return result;
+
+	/* give way to urgent tasks, whatever the time slice says */
+	due = atomic_load_explicit(&thread->master->urgent_due,
+				   memory_order_relaxed);
+	if (!due)
+		return 0;
+	monotime(&now);
+	return due <= (int64_t)now.tv_sec * TIMER_SECOND_MICRO + now.tv_usec;
 }
 
 void thread_set_yield_time(struct thread *thread, unsigned long yield_time)
@@ -1859,6 +2995,36 @@ void thread_set_yield_time(struct thread *thread, unsigned long yield_time)
 	}
 }
 
+void thread_set_priority(struct thread *thread, uint8_t prio)
+{
+	struct thread_master *m = thread->master;
+
+	frr_with_mutex(&m->mtx) {
+		if (thread->prio == prio)
+			break;
+
+		switch (thread->type) {
+		case THREAD_TIMER:
+			thread_timer_del(m, thread);
+			thread->prio = prio;
+			thread_timer_add(m, thread);
+			if (thread_timer_is_next(m, thread))
+				AWAKEN(m);
+			break;
+		case THREAD_READY:
+			thread_list_del(thread_ready_list(m, thread), thread);
+			if (thread->prio == THREAD_PRIO_URGENT)
+				thread_urgent_update(m);
+			thread->prio = prio;
+			thread_ready_add(m, thread);
+			break;
+		default:
+			thread->prio = prio;
+			break;
+		}
+	}
+}
+
 void thread_getrusage(RUSAGE_T *r)
 {
 	monotime(&r->real);
@@ -1893,6 +3059,57 @@ void thread_getrusage(RUSAGE_T *r)
  * particular, the maximum real and cpu times must be monotonically increasing
  * or this code is not correct.
  */
+/* log what ran before, and the task that exceeded timeline_threshold */
+static void thread_timeline_dump(struct thread_master *m, int64_t now)
+{
+	const struct thread_timeline_entry *te;
+	size_t pos, count;
+
+	/* once per second at most */
+	if (now - m->timeline_dumped < TIMER_SECOND_MICRO)
+		return;
+	m->timeline_dumped = now;
+
+	pos = atomic_load_explicit(&m->timeline_pos, memory_order_relaxed);
+	count = MIN(pos, 16);
+
+	zlog_warn("TIMELINE: last %zu tasks on pthread %s, most recent first:",
+		  count, m->name ? m->name : "main");
+	while (count--) {
+		te = &m->timeline[--pos % THREAD_TIMELINE_SIZE];
+		zlog_warn("TIMELINE:   -%" PRId64 "us %s ran %uus (queued %uus)",
+			  now - te->start, te->xref->funcname, te->real,
+			  te->delay);
+	}
+}
+
+static void thread_timeline_record(struct thread *thread, RUSAGE_T *before,
+				   unsigned long walltime)
+{
+	struct thread_master *m = thread->master;
+	struct thread_timeline_entry *te;
+	int64_t start, delay = 0;
+	size_t pos;
+
+	start = before->real.tv_sec * TIMER_SECOND_MICRO + before->real.tv_usec;
+	if (thread->ready_since && start > thread->ready_since)
+		delay = start - thread->ready_since;
+
+	thread_hist_add(thread->hist->hist_real, walltime);
+	thread_hist_add(thread->hist->hist_delay, delay);
+
+	pos = atomic_load_explicit(&m->timeline_pos, memory_order_relaxed);
+	te = &m->timeline[pos % THREAD_TIMELINE_SIZE];
+	te->xref = thread->xref;
+	te->start = start;
+	te->real = MIN(walltime, UINT32_MAX);
+	te->delay = MIN(delay, UINT32_MAX);
+	atomic_store_explicit(&m->timeline_pos, pos + 1, memory_order_release);
+
+	if (timeline_threshold && walltime > timeline_threshold)
+		thread_timeline_dump(m, start + walltime);
+}
+
 void thread_call(struct thread *thread)
 {
 	RUSAGE_T before, after;
@@ -1956,6 +3173,8 @@ void thread_call(struct thread *thread)
 	atomic_fetch_or_explicit(&thread->hist->types, 1 << thread->add_type,
 				 memory_order_seq_cst);
 
+	thread_timeline_record(thread, &before, walltime);
+
 	if (cputime_enabled_here && cputime_enabled && cputime_threshold
 	    && cputime > cputime_threshold) {
 		/*
@@ -39,6 +39,8 @@ extern unsigned long cputime_threshold;
  * hardware TSC w/o syscalls)
  */
 extern unsigned long walltime_threshold;
+/* log the recent tasks of a pthread when one runs for longer (usec) */
+extern unsigned long timeline_threshold;
 
 struct rusage_t {
 #ifdef HAVE_CLOCK_THREAD_CPUTIME_ID
@@ -54,6 +56,17 @@ struct rusage_t {
 
 PREDECL_LIST(thread_list);
 PREDECL_HEAP(thread_timer_list);
+PREDECL_DLIST(thread_wheel_list);
+
+/* timing wheel, see thread_master_set_timer_wheel() */
+struct thread_wheel;
+
+/* I/O multiplexer used by a thread_master to wait for fd events */
+enum thread_io_backend {
+	THREAD_IO_POLL = 0,
+	THREAD_IO_EPOLL,
+	THREAD_IO_KQUEUE,
+};
 
 struct fd_handler {
 	/* number of pfd that fit in the allocated space of pfds. This is a
@@ -70,6 +83,25 @@ struct fd_handler {
 	struct pollfd *copy;
 	/* number of pollfds stored in copy */
 	nfds_t copycount;
+
+	enum thread_io_backend backend;
+
+	/* epoll/kqueue descriptor, -1 when not (yet) created.  With a kernel
+	 * backend, pfds is only our record of the interest set; the kernel
+	 * returns just the ready fds, which get translated into copy.
+	 */
+	int kqfd;
+	/* index of each fd in pfds (-1 if none), only kept for kernel
+	 * backends so lookups don't need to scan pfds
+	 */
+	int *pfdpos;
+	/* raw events returned by epoll_wait()/kevent() */
+	void *evbuf;
+	int evbufsize;
+
+	/* statistics */
+	uint64_t wakeups;
+	uint64_t ready_events;
 };
 
 struct xref_threadsched {
@@ -87,7 +119,17 @@ struct thread_master {
 	struct thread **read;
 	struct thread **write;
 	struct thread_timer_list_head timer;
+	/* if non-NULL, timers are kept here instead of in the heap above */
+	struct thread_wheel *wheel;
+	/* THREAD_PRIO_URGENT timers, always in a heap of their own */
+	struct thread_timer_list_head timer_urgent;
 	struct thread_list_head event, ready, unuse;
+	/* ready tasks ahead of and behind the ones on 'ready' */
+	struct thread_list_head ready_urgent, ready_bg;
+	/* monotime in usec at which an urgent task wants to run, 0 if none;
+	 * read by thread_should_yield() without the lock.
+	 */
+	_Atomic int64_t urgent_due;
 	struct list *cancel_req;
 	bool canceled;
 	pthread_cond_t cancel_cond;
@@ -104,14 +146,30 @@ struct thread_master {
 
 	bool ready_run_loop;
 	RUSAGE_T last_getrusage;
+
+	/* flight recorder of the last THREAD_TIMELINE_SIZE tasks, only written
+	 * by the pthread running this thread_master
+	 */
+	struct thread_timeline_entry *timeline;
+	atomic_size_t timeline_pos;
+	int64_t timeline_dumped;
 };
 
 /* Thread itself. */
 struct thread {
 	uint8_t type;		  /* thread type */
 	uint8_t add_type;	  /* thread type */
+	uint8_t prio;		  /* THREAD_PRIO_* */
 	struct thread_list_item threaditem;
-	struct thread_timer_list_item timeritem;
+	union {
+		/* timer heap */
+		struct thread_timer_list_item timeritem;
+		/* or slot in the timing wheel */
+		struct {
+			struct thread_wheel_list_item wheelitem;
+			uint16_t wheelslot;
+		};
+	};
 	struct thread **ref;	  /* external reference (if given) */
 	struct thread_master *master; /* pointer to the struct thread_master */
 	int (*func)(struct thread *); /* event function */
@@ -126,8 +184,14 @@ struct thread {
 	unsigned long yield;		 /* yield time in microseconds */
 	const struct xref_threadsched *xref;   /* origin location */
 	pthread_mutex_t mtx;   /* mutex for thread.c functions */
+	/* monotime in usec at which the task could have run, 0 if unknown */
+	int64_t ready_since;
 };
 
+/* latency histograms: 4 linear steps per power of 2, in usec */
+#define THREAD_HIST_SUBBITS 2
+#define THREAD_HIST_BUCKETS ((32 - THREAD_HIST_SUBBITS + 1) << THREAD_HIST_SUBBITS)
+
 struct cpu_thread_history {
 	int (*func)(struct thread *);
 	atomic_size_t total_cpu_warn;
@@ -140,6 +204,21 @@ struct cpu_thread_history {
 	struct time_stats cpu;
 	atomic_uint_fast32_t types;
 	const char *funcname;
+
+	/* wall-clock run time, and time spent waiting on the ready queue */
+	_Atomic uint32_t hist_real[THREAD_HIST_BUCKETS];
+	_Atomic uint32_t hist_delay[THREAD_HIST_BUCKETS];
+};
+
+#define THREAD_TIMELINE_SIZE 1024
+
+struct thread_timeline_entry {
+	const struct xref_threadsched *xref;
+	/* monotime in usec */
+	int64_t start;
+	/* usec */
+	uint32_t real;
+	uint32_t delay;
 };
 
 /* Struct timeval's tv_usec one second value.  */
@@ -154,6 +233,11 @@ struct cpu_thread_history {
 #define THREAD_UNUSED         5
 #define THREAD_EXECUTE        6
 
+/* Thread priorities, see thread_set_priority(). */
+#define THREAD_PRIO_NORMAL     0
+#define THREAD_PRIO_URGENT     1
+#define THREAD_PRIO_BACKGROUND 2
+
 /* Thread yield time.  */
 #define THREAD_YIELD_TIME_SLOT     10 * 1000L /* 10ms */
 
@@ -219,6 +303,15 @@ void thread_master_set_name(struct thread_master *master, const char *name);
 extern void thread_master_free(struct thread_master *);
 extern void thread_master_free_unused(struct thread_master *);
 
+/* Switch between the timer heap (default) and a hierarchical timing wheel.
+ * The wheel makes adding and cancelling timers O(1), which helps with large
+ * numbers of timers that mostly get cancelled before they expire.  Its
+ * resolution is 1ms; timers expiring in the same millisecond run in no
+ * particular order.  Pending timers are carried over.
+ */
+extern void thread_master_set_timer_wheel(struct thread_master *m,
+					  bool enable);
+
 extern struct thread *_thread_add_read_write(
 	const struct xref_threadsched *xref, struct thread_master *master,
 	int (*fn)(struct thread *), void *arg, int fd, struct thread **tref);
@@ -260,6 +353,15 @@ extern int thread_should_yield(struct thread *);
 /* set yield time for thread */
 extern void thread_set_yield_time(struct thread *, unsigned long);
 
+/* Change the priority of a scheduled task; it goes back to
+ * THREAD_PRIO_NORMAL once run or cancelled.  Urgent tasks run before any
+ * other ready task, and an urgent timer coming due makes
+ * thread_should_yield() return true so long running tasks (work queues)
+ * get out of its way within one yield check.  Background tasks only run when
+ * nothing else is ready.
+ */
+extern void thread_set_priority(struct thread *thread, uint8_t prio);
+
 /* Internal libfrr exports */
 extern void thread_getrusage(RUSAGE_T *);
 extern void thread_cmd_init(void);
@@ -28,6 +28,7 @@
 DEFINE_MTYPE_STATIC(LIB, TYPEDHASH_BUCKET, "Typed-hash bucket");
 DEFINE_MTYPE_STATIC(LIB, SKIPLIST_OFLOW, "Skiplist overflow");
 DEFINE_MTYPE_STATIC(LIB, HEAP_ARRAY, "Typed-heap array");
+DEFINE_MTYPE_STATIC(LIB, BPTREE_NODE, "B+tree node");
 
 #if 0
 static void hash_consistency_check(struct thash_head *head)
@@ -424,6 +425,378 @@ struct sskip_item *typesafe_skiplist_pop(struct sskip_head *head)
 	return item;
 }
 
+/* B+tree */
+
+#define BPTREE_HALF (BPTREE_WIDTH / 2)
+
+#if 0
+static void bptree_consistency_check(struct bpt_node *node)
+{
+	unsigned int i;
+
+	if (!node)
+		return;
+
+	for (i = 0; i < node->count; i++) {
+		if (node->leaf) {
+			assert(node->items[i]->leaf == node);
+			continue;
+		}
+		assert(node->child[i]->parent == node);
+		assert(node->child[i]->items[0] == node->items[i]);
+		bptree_consistency_check(node->child[i]);
+	}
+}
+#else
+#define bptree_consistency_check(x)
+#endif
+
+static struct bpt_node *bpt_node_new(bool leaf)
+{
+	struct bpt_node *node;
+	size_t size = sizeof(*node);
+
+	if (!leaf)
+		size += BPTREE_WIDTH * sizeof(node->child[0]);
+
+	node = XCALLOC(MTYPE_BPTREE_NODE, size);
+	node->leaf = leaf;
+	return node;
+}
+
+/* number of entries in node that are < item (bias = 0) or <= item (bias = 1)
+ */
+static unsigned int bpt_bsearch(const struct bpt_node *node,
+		const struct bpt_item *item, int bias, int (*cmpfn)(
+				const struct bpt_item *a,
+				const struct bpt_item *b))
+{
+	unsigned int lo = 0, hi = node->count, mid;
+
+	while (lo < hi) {
+		mid = (lo + hi) / 2;
+		if (cmpfn(node->items[mid], item) < bias)
+			lo = mid + 1;
+		else
+			hi = mid;
+	}
+	return lo;
+}
+
+/* inner nodes hold the first item of each child, so the child to go into is
+ * the one before the first entry that doesn't pass bpt_bsearch
+ */
+static struct bpt_node *bpt_descend(const struct bpt_head *head,
+		const struct bpt_item *item, int bias, unsigned int *pos,
+		int (*cmpfn)(const struct bpt_item *a,
+			     const struct bpt_item *b))
+{
+	struct bpt_node *node = head->root;
+	unsigned int i;
+
+	if (!node)
+		return NULL;
+
+	while (true) {
+		i = bpt_bsearch(node, item, bias, cmpfn);
+		if (node->leaf)
+			break;
+		node = node->child[i ? i - 1 : 0];
+	}
+	*pos = i;
+	return node;
+}
+
+static unsigned int bpt_child_idx(const struct bpt_node *parent,
+				  const struct bpt_node *node)
+{
+	unsigned int i;
+
+	for (i = 0; parent->child[i] != node; i++)
+		assert(i + 1 < parent->count);
+	return i;
+}
+
+/* node's first item changed, update the copies of it further up */
+static void bpt_fix_key(struct bpt_node *node)
+{
+	struct bpt_node *parent;
+	unsigned int i;
+
+	while ((parent = node->parent)) {
+		i = bpt_child_idx(parent, node);
+		parent->items[i] = node->items[0];
+		if (i)
+			break;
+		node = parent;
+	}
+}
+
+static void bpt_insert(struct bpt_node *node, unsigned int pos,
+		       struct bpt_item *item, struct bpt_node *child)
+{
+	memmove(&node->items[pos + 1], &node->items[pos],
+		(node->count - pos) * sizeof(node->items[0]));
+	node->items[pos] = item;
+
+	if (node->leaf)
+		item->leaf = node;
+	else {
+		memmove(&node->child[pos + 1], &node->child[pos],
+			(node->count - pos) * sizeof(node->child[0]));
+		node->child[pos] = child;
+		child->parent = node;
+	}
+	node->count++;
+}
+
+static void bpt_remove(struct bpt_node *node, unsigned int pos)
+{
+	node->count--;
+	memmove(&node->items[pos], &node->items[pos + 1],
+		(node->count - pos) * sizeof(node->items[0]));
+	if (!node->leaf)
+		memmove(&node->child[pos], &node->child[pos + 1],
+			(node->count - pos) * sizeof(node->child[0]));
+}
+
+/* node is full, move its upper half into a new right sibling */
+static struct bpt_node *bpt_split(struct bpt_head *head, struct bpt_node *node)
+{
+	struct bpt_node *right = bpt_node_new(node->leaf), *parent;
+	unsigned int i;
+
+	right->count = node->count - BPTREE_HALF;
+	node->count = BPTREE_HALF;
+	memcpy(right->items, &node->items[BPTREE_HALF],
+	       right->count * sizeof(right->items[0]));
+
+	if (node->leaf) {
+		for (i = 0; i < right->count; i++)
+			right->items[i]->leaf = right;
+		right->next = node->next;
+		node->next = right;
+	} else {
+		memcpy(right->child, &node->child[BPTREE_HALF],
+		       right->count * sizeof(right->child[0]));
+		for (i = 0; i < right->count; i++)
+			right->child[i]->parent = right;
+	}
+
+	if (!node->parent) {
+		parent = bpt_node_new(false);
+		parent->count = 1;
+		parent->items[0] = node->items[0];
+		parent->child[0] = node;
+		node->parent = parent;
+		head->root = parent;
+	} else if (node->parent->count == BPTREE_WIDTH)
+		/* may move node over to the parent's new sibling */
+		bpt_split(head, node->parent);
+
+	parent = node->parent;
+	bpt_insert(parent, bpt_child_idx(parent, node) + 1, right->items[0],
+		   right);
+	return right;
+}
+
+/* node has fewer than BPTREE_HALF entries, refill it from a sibling or merge
+ * it with one, which may in turn leave the parent short
+ */
+static void bpt_rebalance(struct bpt_head *head, struct bpt_node *node)
+{
+	struct bpt_node *parent, *left, *right;
+	struct bpt_item *item;
+	unsigned int i, j;
+
+	while ((parent = node->parent)) {
+		if (node->count >= BPTREE_HALF)
+			return;
+
+		i = bpt_child_idx(parent, node);
+		if (i + 1 < parent->count) {
+			left = node;
+			right = parent->child[i + 1];
+		} else {
+			left = parent->child[--i];
+			right = node;
+		}
+
+		if (left->count + right->count > BPTREE_WIDTH) {
+			if (left == node) {
+				item = right->items[0];
+				bpt_insert(left, left->count, item,
+					   left->leaf ? NULL : right->child[0]);
+				bpt_remove(right, 0);
+			} else {
+				j = left->count - 1;
+				bpt_insert(right, 0, left->items[j],
+					   left->leaf ? NULL : left->child[j]);
+				left->count--;
+			}
+			bpt_fix_key(right);
+			return;
+		}
+
+		for (j = 0; j < right->count; j++)
+			bpt_insert(left, left->count, right->items[j],
+				   left->leaf ? NULL : right->child[j]);
+		if (left->leaf)
+			left->next = right->next;
+		XFREE(MTYPE_BPTREE_NODE, right);
+
+		bpt_remove(parent, i + 1);
+		node = parent;
+	}
+
+	/* root */
+	if (node->count == 0) {
+		XFREE(MTYPE_BPTREE_NODE, node);
+		head->root = head->first = NULL;
+	} else if (!node->leaf && node->count == 1) {
+		head->root = node->child[0];
+		head->root->parent = NULL;
+		XFREE(MTYPE_BPTREE_NODE, node);
+	}
+}
+
+struct bpt_item *typesafe_bptree_add(struct bpt_head *head,
+		struct bpt_item *item, int (*cmpfn)(
+			const struct bpt_item *a,
+			const struct bpt_item *b))
+{
+	struct bpt_node *leaf, *right;
+	unsigned int pos = 0;
+
+	leaf = bpt_descend(head, item, 1, &pos, cmpfn);
+	if (!leaf) {
+		leaf = bpt_node_new(true);
+		head->root = head->first = leaf;
+	} else if (pos && cmpfn(leaf->items[pos - 1], item) == 0)
+		return leaf->items[pos - 1];
+
+	if (leaf->count == BPTREE_WIDTH) {
+		right = bpt_split(head, leaf);
+		if (pos > BPTREE_HALF) {
+			leaf = right;
+			pos -= BPTREE_HALF;
+		}
+	}
+
+	bpt_insert(leaf, pos, item, NULL);
+	if (pos == 0)
+		bpt_fix_key(leaf);
+	head->count++;
+
+	bptree_consistency_check(head->root);
+	return NULL;
+}
+
+const struct bpt_item *typesafe_bptree_find(
+		const struct bpt_head *head,
+		const struct bpt_item *item, int (*cmpfn)(
+				const struct bpt_item *a,
+				const struct bpt_item *b))
+{
+	const struct bpt_node *leaf;
+	unsigned int pos;
+
+	leaf = bpt_descend(head, item, 1, &pos, cmpfn);
+	if (!leaf || !pos || cmpfn(leaf->items[pos - 1], item))
+		return NULL;
+	return leaf->items[pos - 1];
+}
+
+const struct bpt_item *typesafe_bptree_find_gteq(
+		const struct bpt_head *head,
+		const struct bpt_item *item, int (*cmpfn)(
+				const struct bpt_item *a,
+				const struct bpt_item *b))
+{
+	const struct bpt_node *leaf;
+	unsigned int pos;
+
+	leaf = bpt_descend(head, item, 0, &pos, cmpfn);
+	if (!leaf)
+		return NULL;
+	if (pos < leaf->count)
+		return leaf->items[pos];
+	return leaf->next ? leaf->next->items[0] : NULL;
+}
+
+const struct bpt_item *typesafe_bptree_find_lt(
+		const struct bpt_head *head,
+		const struct bpt_item *item, int (*cmpfn)(
+				const struct bpt_item *a,
+				const struct bpt_item *b))
+{
+	const struct bpt_node *leaf;
+	unsigned int pos;
+
+	/* pos can only be 0 in the first leaf, since every other leaf was
+	 * picked for its first item being < item
+	 */
+	leaf = bpt_descend(head, item, 0, &pos, cmpfn);
+	if (!leaf || !pos)
+		return NULL;
+	return leaf->items[pos - 1];
+}
+
+static void bpt_del_at(struct bpt_head *head, struct bpt_node *leaf,
+		       unsigned int pos)
+{
+	struct bpt_item *item = leaf->items[pos];
+
+	bpt_remove(leaf, pos);
+	if (pos == 0 && leaf->count)
+		bpt_fix_key(leaf);
+	bpt_rebalance(head, leaf);
+	head->count--;
+
+	memset(item, 0, sizeof(*item));
+	bptree_consistency_check(head->root);
+}
+
+struct bpt_item *typesafe_bptree_del(
+	struct bpt_head *head, struct bpt_item *item,
+	int (*cmpfn)(const struct bpt_item *a, const struct bpt_item *b))
+{
+	struct bpt_node *leaf;
+	unsigned int pos;
+
+	leaf = bpt_descend(head, item, 1, &pos, cmpfn);
+	if (!leaf || !pos || leaf->items[pos - 1] != item)
+		return NULL;
+
+	bpt_del_at(head, leaf, pos - 1);
+	return item;
+}
+
+struct bpt_item *typesafe_bptree_pop(struct bpt_head *head)
+{
+	struct bpt_item *item;
+
+	if (!head->first)
+		return NULL;
+
+	item = head->first->items[0];
+	bpt_del_at(head, head->first, 0);
+	return item;
+}
+
+const struct bpt_item *typesafe_bptree_next(const struct bpt_item *item)
+{
+	const struct bpt_node *leaf = item->leaf;
+	unsigned int i;
+
+	for (i = 0; i + 1 < leaf->count; i++)
+		if (leaf->items[i] == item)
+			return leaf->items[i + 1];
+
+	leaf = leaf->next;
+	return leaf ? leaf->items[0] : NULL;
+}
+
 /* heap */
 
 #if 0
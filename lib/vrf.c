@@ -56,6 +56,29 @@ RB_GENERATE(vrf_name_head, vrf, name_entry, vrf_name_compare);
 struct vrf_id_head vrfs_by_id = RB_INITIALIZER(&vrfs_by_id);
 struct vrf_name_head vrfs_by_name = RB_INITIALIZER(&vrfs_by_name);
 
+static int vrf_id_rcu_compare(const struct vrf *a, const struct vrf *b)
+{
+	return numcmp(a->vrf_id, b->vrf_id);
+}
+
+DECLARE_ATOMSORT_UNIQ(vrf_id_rcu, struct vrf, id_rcu_entry,
+		      vrf_id_rcu_compare);
+
+/* vrfs_by_id, for the other pthreads; only changed by the main pthread */
+static struct vrf_id_rcu_head vrfs_by_id_rcu;
+
+static void vrf_id_index_add(struct vrf *vrf)
+{
+	RB_INSERT(vrf_id_head, &vrfs_by_id, vrf);
+	vrf_id_rcu_add(&vrfs_by_id_rcu, vrf);
+}
+
+static void vrf_id_index_del(struct vrf *vrf)
+{
+	RB_REMOVE(vrf_id_head, &vrfs_by_id, vrf);
+	vrf_id_rcu_del(&vrfs_by_id_rcu, vrf);
+}
+
 static int vrf_backend;
 static int vrf_backend_configured;
 static struct zebra_privs_t *vrf_daemon_privs;
@@ -113,9 +136,9 @@ static void vrf_update_vrf_id(ns_id_t ns_id, void *opaqueptr)
 	if (vrf_id == vrf->vrf_id)
 		return;
 	if (vrf->vrf_id != VRF_UNKNOWN)
-		RB_REMOVE(vrf_id_head, &vrfs_by_id, vrf);
+		vrf_id_index_del(vrf);
 	vrf->vrf_id = vrf_id;
-	RB_INSERT(vrf_id_head, &vrfs_by_id, vrf);
+	vrf_id_index_add(vrf);
 	if (old_vrf_id == VRF_UNKNOWN)
 		vrf_enable(vrf);
 }
@@ -191,7 +214,7 @@ struct vrf *vrf_get(vrf_id_t vrf_id, const char *name)
 	/* Set identifier */
 	if (vrf_id != VRF_UNKNOWN && vrf->vrf_id == VRF_UNKNOWN) {
 		vrf->vrf_id = vrf_id;
-		RB_INSERT(vrf_id_head, &vrfs_by_id, vrf);
+		vrf_id_index_add(vrf);
 	}
 
 	/* Set name */
@@ -247,9 +270,9 @@ struct vrf *vrf_update(vrf_id_t new_vrf_id, const char *name)
 		vrf_disable(vrf);
 
 
-		RB_REMOVE(vrf_id_head, &vrfs_by_id, vrf);
+		vrf_id_index_del(vrf);
 		vrf->vrf_id = new_vrf_id;
-		RB_INSERT(vrf_id_head, &vrfs_by_id, vrf);
+		vrf_id_index_add(vrf);
 
 	} else {
 
@@ -284,7 +307,7 @@ void vrf_delete(struct vrf *vrf)
 			 * been moved out of the VRF.
 			 */
 			if_terminate(vrf);
-			RB_REMOVE(vrf_id_head, &vrfs_by_id, vrf);
+			vrf_id_index_del(vrf);
 			vrf->vrf_id = VRF_UNKNOWN;
 		}
 		return;
@@ -297,11 +320,12 @@ void vrf_delete(struct vrf *vrf)
 	if_terminate(vrf);
 
 	if (vrf->vrf_id != VRF_UNKNOWN)
-		RB_REMOVE(vrf_id_head, &vrfs_by_id, vrf);
+		vrf_id_index_del(vrf);
 	if (vrf->name[0] != '\0')
 		RB_REMOVE(vrf_name_head, &vrfs_by_name, vrf);
 
-	XFREE(MTYPE_VRF, vrf);
+	/* other pthreads may still be looking at it */
+	rcu_free(MTYPE_VRF, vrf, rcu_head);
 }
 
 /* Look up a VRF by identifier. */
@@ -312,6 +336,36 @@ struct vrf *vrf_lookup_by_id(vrf_id_t vrf_id)
 	return (RB_FIND(vrf_id_head, &vrfs_by_id, &vrf));
 }
 
+struct vrf *vrf_lookup_by_id_rcu(vrf_id_t vrf_id)
+{
+	struct vrf *vrf;
+
+	rcu_assert_read_locked();
+
+	/* sorted, so stop at the first id that isn't smaller */
+	frr_each (vrf_id_rcu, &vrfs_by_id_rcu, vrf) {
+		vrf_id_t id = vrf->vrf_id;
+
+		if (id == vrf_id)
+			return vrf;
+		if (id > vrf_id)
+			break;
+	}
+	return NULL;
+}
+
+struct vrf *vrf_first_rcu(void)
+{
+	rcu_assert_read_locked();
+
+	return vrf_id_rcu_first(&vrfs_by_id_rcu);
+}
+
+struct vrf *vrf_next_rcu(struct vrf *vrf)
+{
+	return vrf_id_rcu_next(&vrfs_by_id_rcu, vrf);
+}
+
 /*
  * Enable a VRF - that is, let the VRF be ready to use.
  * The VRF_ENABLE_HOOK callback will be called to inform
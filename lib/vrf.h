@@ -27,11 +27,14 @@
 #include "qobj.h"
 #include "vty.h"
 #include "ns.h"
+#include "frrcu.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+struct route_table;
+
 /* The default VRF ID */
 #define VRF_UNKNOWN UINT32_MAX
 
@@ -68,9 +71,15 @@ struct vrf_data {
 	};
 };
 
+PREDECL_ATOMSORT_UNIQ(vrf_id_rcu);
+
 struct vrf {
 	RB_ENTRY(vrf) id_entry, name_entry;
 
+	/* Copy of the id index, for pthreads other than the main one */
+	struct vrf_id_rcu_item id_rcu_entry;
+	struct rcu_head rcu_head;
+
 	/* Identifier, same as the vector index */
 	vrf_id_t vrf_id;
 
@@ -85,6 +94,14 @@ struct vrf {
 	/* Interfaces belonging to this VRF */
 	struct if_name_head ifaces_by_name;
 	struct if_index_head ifaces_by_index;
+	struct if_index_rcu_head ifaces_rcu;
+
+	/*
+	 * Their connected addresses, by address and mask and, for those
+	 * with a peer, by peer prefix.  Each node has a list of them.
+	 */
+	struct route_table *connected_by_addr[AFI_MAX];
+	struct route_table *connected_by_peer[AFI_MAX];
 
 	/* User data */
 	void *info;
@@ -115,6 +132,17 @@ extern struct vrf_id_head vrfs_by_id;
 extern struct vrf_name_head vrfs_by_name;
 
 extern struct vrf *vrf_lookup_by_id(vrf_id_t);
+
+/*
+ * Same as vrf_lookup_by_id(), for pthreads other than the main one.  Must be
+ * called under rcu_read_lock(); the VRF stays allocated until
+ * rcu_read_unlock(), but only its vrf_id may be relied on, everything else
+ * belongs to the main pthread.  vrf_first_rcu() and vrf_next_rcu() walk all
+ * VRFs with an id the same way.
+ */
+extern struct vrf *vrf_lookup_by_id_rcu(vrf_id_t vrf_id);
+extern struct vrf *vrf_first_rcu(void);
+extern struct vrf *vrf_next_rcu(struct vrf *vrf);
 extern struct vrf *vrf_lookup_by_name(const char *);
 extern struct vrf *vrf_get(vrf_id_t, const char *);
 extern struct vrf *vrf_update(vrf_id_t new_vrf_id, const char *name);
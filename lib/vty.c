@@ -59,6 +59,8 @@
 DEFINE_MTYPE_STATIC(LIB, VTY, "VTY");
 DEFINE_MTYPE_STATIC(LIB, VTY_OUT_BUF, "VTY output buffer");
 DEFINE_MTYPE_STATIC(LIB, VTY_HIST, "VTY history");
+DEFINE_MTYPE_STATIC(LIB, VTY_WALK, "VTY show walk");
+DEFINE_MTYPE_STATIC(LIB, VTY_BATCH, "VTY config batch");
 
 /* Vty events */
 enum event {
@@ -2069,6 +2071,101 @@ static int vtysh_flush(struct vty *vty)
 	return 0;
 }
 
+bool vty_suspend(struct vty *vty, void (*abort)(void *arg), void *arg)
+{
+	if (vty->type != VTY_SHELL_SERV || vty->suspend_abort)
+		return false;
+
+	vty->suspend_abort = abort;
+	vty->suspend_arg = arg;
+	return true;
+}
+
+void vty_resume(struct vty *vty, int ret)
+{
+	uint8_t header[4] = {0, 0, 0, ret};
+
+	vty->suspend_abort = NULL;
+	vty->suspend_arg = NULL;
+
+	buffer_put(vty->obuf, header, 4);
+	if (!vty->t_write)
+		vtysh_flush(vty);
+}
+
+bool vty_output_blocked(struct vty *vty)
+{
+	if (vty->t_write)
+		/* vtysh_write() will flush once the socket is writable */
+		return buffer_pending(vty->obuf) > VTY_OUTPUT_HIGHWATER;
+
+	if (vtysh_flush(vty) < 0)
+		/* vty_close() has called the suspend_abort hook */
+		return true;
+	return buffer_pending(vty->obuf) > VTY_OUTPUT_HIGHWATER;
+}
+
+/* Queue the result of a command; returns false if the vty was closed. */
+static bool vtysh_result(struct vty *vty, int ret)
+{
+	/* warning: watchfrr hardcodes this result write */
+	uint8_t header[4] = {0, 0, 0, ret};
+
+	buffer_put(vty->obuf, header, 4);
+
+	/* Try to flush results; exit if a write error occurs. */
+	return vty->t_write || vtysh_flush(vty) >= 0;
+}
+
+/*
+ * Execute a batch of configuration lines, as if they had been sent one by
+ * one, and return the first error. Errors are reported with the line
+ * number since vtysh only gets a single result for the whole batch.
+ */
+static int vty_batch_execute(struct vty *vty)
+{
+	char *line, *next, *end = vty->batch + vty->batch_len;
+	unsigned int lineno = 0;
+	int ret, retcode = CMD_SUCCESS;
+
+	*end = '\0';
+	for (line = vty->batch; line < end; line = next) {
+		next = strchrnul(line, '\n');
+		if (*next)
+			*next++ = '\0';
+		lineno++;
+
+		if (strlcpy(vty->buf, line, VTY_BUFSIZ) >= VTY_BUFSIZ) {
+			vty_out(vty, "%% Batch line %u is too long\n", lineno);
+			retcode = CMD_WARNING_CONFIG_FAILED;
+			vty->cp = vty->length = 0;
+			vty_clear_buf(vty);
+			continue;
+		}
+		vty->length = strlen(vty->buf);
+
+		ret = vty_execute(vty);
+		switch (ret) {
+		case CMD_SUCCESS:
+		case CMD_WARNING:
+		case CMD_ERR_NOTHING_TODO:
+		case CMD_NOT_MY_INSTANCE:
+			break;
+		default:
+			vty_out(vty, "%% Batch line %u failed[%d]: %s\n",
+				lineno, ret, line);
+			if (retcode == CMD_SUCCESS)
+				retcode = ret;
+			break;
+		}
+	}
+
+	XFREE(MTYPE_VTY_BATCH, vty->batch);
+	vty->batch_len = vty->batch_pos = 0;
+
+	return retcode;
+}
+
 static int vtysh_read(struct thread *thread)
 {
 	int ret;
@@ -2077,12 +2174,19 @@ static int vtysh_read(struct thread *thread)
 	struct vty *vty;
 	unsigned char buf[VTY_READ_BUFSIZ];
 	unsigned char *p;
-	uint8_t header[4] = {0, 0, 0, 0};
+	size_t n;
 
 	sock = THREAD_FD(thread);
 	vty = THREAD_ARG(thread);
 
-	if ((nbytes = read(sock, buf, VTY_READ_BUFSIZ)) <= 0) {
+	/* Batch contents go straight into the batch buffer. */
+	if (vty->batch)
+		nbytes = read(sock, vty->batch + vty->batch_pos,
+			      vty->batch_len - vty->batch_pos);
+	else
+		nbytes = read(sock, buf, VTY_READ_BUFSIZ);
+
+	if (nbytes <= 0) {
 		if (nbytes < 0) {
 			if (ERRNO_IO_RETRY(errno)) {
 				vty_event(VTYSH_READ, vty);
@@ -2104,6 +2208,14 @@ static int vtysh_read(struct thread *thread)
 		return 0;
 	}
 
+	if (vty->batch) {
+		vty->batch_pos += nbytes;
+		if (vty->batch_pos == vty->batch_len
+		    && !vtysh_result(vty, vty_batch_execute(vty)))
+			return 0;
+		nbytes = 0;
+	}
+
 #ifdef VTYSH_DEBUG
 	printf("line: %.*s\n", nbytes, buf);
 #endif /* VTYSH_DEBUG */
@@ -2115,6 +2227,20 @@ static int vtysh_read(struct thread *thread)
 		vty_out(vty, "%% Command is too long.\n");
 	} else {
 		for (p = buf; p < buf + nbytes; p++) {
+			if (vty->batch) {
+				/* the rest of this read starts the batch */
+				n = MIN((size_t)(buf + nbytes - p),
+					vty->batch_len - vty->batch_pos);
+				memcpy(vty->batch + vty->batch_pos, p, n);
+				vty->batch_pos += n;
+				p += n - 1;
+				if (vty->batch_pos == vty->batch_len
+				    && !vtysh_result(vty,
+						     vty_batch_execute(vty)))
+					return 0;
+				continue;
+			}
+
 			vty->buf[vty->length++] = *p;
 			if (*p == '\0') {
 				/* Pass this line to parser. */
@@ -2135,14 +2261,7 @@ static int vtysh_read(struct thread *thread)
 				if (ret == CMD_SUSPEND)
 					break;
 
-				/* warning: watchfrr hardcodes this result write
-				 */
-				header[3] = ret;
-				buffer_put(vty->obuf, header, 4);
-
-				if (!vty->t_write && (vtysh_flush(vty) < 0))
-					/* Try to flush results; exit if a write
-					 * error occurs. */
+				if (!vtysh_result(vty, ret))
 					return 0;
 			}
 		}
@@ -2164,6 +2283,22 @@ static int vtysh_write(struct thread *thread)
 	return 0;
 }
 
+#else /* VTYSH */
+
+bool vty_suspend(struct vty *vty, void (*abort)(void *arg), void *arg)
+{
+	return false;
+}
+
+void vty_resume(struct vty *vty, int ret)
+{
+}
+
+bool vty_output_blocked(struct vty *vty)
+{
+	return false;
+}
+
 #endif /* VTYSH */
 
 /* Determine address family to bind. */
@@ -2194,6 +2329,14 @@ void vty_close(struct vty *vty)
 	int i;
 	bool was_stdio = false;
 
+	/* Stop a suspended command from writing to us. */
+	if (vty->suspend_abort) {
+		void (*abort)(void *arg) = vty->suspend_abort;
+
+		vty->suspend_abort = NULL;
+		abort(vty->suspend_arg);
+	}
+
 	/* Drop out of configure / transaction if needed. */
 	vty_config_exit(vty);
 
@@ -2238,6 +2381,7 @@ void vty_close(struct vty *vty)
 		was_stdio = true;
 
 	XFREE(MTYPE_VTY, vty->buf);
+	XFREE(MTYPE_VTY_BATCH, vty->batch);
 
 	if (vty->error) {
 		vty->error->del = vty_error_delete;
@@ -2756,6 +2900,113 @@ static void vty_event(enum event event, struct vty *vty)
 	}
 }
 
+struct vty_walk {
+	struct vty *vty;
+	const struct vty_walk_ops *ops;
+	void *arg;
+	struct thread *t_walk;
+};
+
+static void vty_walk_free(struct vty_walk *walk)
+{
+	THREAD_OFF(walk->t_walk);
+	walk->ops->finish(walk->vty, walk->arg);
+	XFREE(MTYPE_VTY_WALK, walk);
+}
+
+/* the vtysh session went away, see vty_suspend() */
+static void vty_walk_abort(void *arg)
+{
+	struct vty_walk *walk = arg;
+
+	walk->vty = NULL;
+	if (!walk->t_walk)
+		/* from within vty_walk_run(), which cleans up */
+		return;
+	vty_walk_free(walk);
+}
+
+static int vty_walk_run(struct thread *thread)
+{
+	struct vty_walk *walk = THREAD_ARG(thread);
+	struct timeval start;
+	unsigned int count = 0;
+	struct vty *vty;
+	int ret;
+
+	/* don't queue more output than the client takes */
+	if (vty_output_blocked(walk->vty)) {
+		if (!walk->vty) {
+			vty_walk_free(walk);
+			return 0;
+		}
+		thread_add_timer_msec(vty_master, vty_walk_run, walk,
+				      VTY_WALK_BLOCKED_WAIT, &walk->t_walk);
+		return 0;
+	}
+
+	monotime(&start);
+	while (walk->ops->step(walk->vty, walk->arg)) {
+		if (++count < VTY_WALK_BATCH
+		    && monotime_since(&start, NULL) < VTY_WALK_SLICE)
+			continue;
+
+		if (walk->ops->pause)
+			walk->ops->pause(walk->arg);
+		thread_add_event(vty_master, vty_walk_run, walk, 0,
+				 &walk->t_walk);
+		return 0;
+	}
+
+	vty = walk->vty;
+	ret = walk->ops->finish(vty, walk->arg);
+	XFREE(MTYPE_VTY_WALK, walk);
+	vty_resume(vty, ret);
+	return 0;
+}
+
+int vty_walk(struct vty *vty, const struct vty_walk_ops *ops, void *arg)
+{
+	struct vty_walk *walk;
+
+	walk = XCALLOC(MTYPE_VTY_WALK, sizeof(*walk));
+	if (!vty_master || !vty_suspend(vty, vty_walk_abort, walk)) {
+		XFREE(MTYPE_VTY_WALK, walk);
+		while (ops->step(vty, arg))
+			;
+		return ops->finish(vty, arg);
+	}
+
+	walk->vty = vty;
+	walk->ops = ops;
+	walk->arg = arg;
+	thread_add_event(vty_master, vty_walk_run, walk, 0, &walk->t_walk);
+	return CMD_SUSPEND;
+}
+
+/*
+ * Sent by vtysh when loading a configuration file: the next <length> bytes
+ * on the socket are newline separated configuration lines, executed in one
+ * go. Not available from vtysh itself.
+ */
+DEFUN_ATTR (config_batch,
+	    config_batch_cmd,
+	    "XFRR_config_batch (1-1073741824)",
+	    "Configuration lines follow\n"
+	    "Length in bytes\n",
+	    CMD_ATTR_HIDDEN)
+{
+	if (vty->type != VTY_SHELL_SERV || vty->batch) {
+		vty_out(vty, "%% Only supported from vtysh\n");
+		return CMD_WARNING;
+	}
+
+	vty->batch_len = strtoul(argv[1]->arg, NULL, 10);
+	vty->batch_pos = 0;
+	vty->batch = XMALLOC(MTYPE_VTY_BATCH, vty->batch_len + 1);
+	return CMD_SUCCESS;
+}
+
 DEFUN_NOSH (config_who,
        config_who_cmd,
        "who",
@@ -3176,6 +3427,7 @@ void vty_init(struct thread_master *master_thread, bool do_command_logging)
 	install_element(CONFIG_NODE, &no_service_advanced_vty_cmd);
 	install_element(CONFIG_NODE, &show_history_cmd);
 	install_element(CONFIG_NODE, &log_commands_cmd);
+	install_element(CONFIG_NODE, &config_batch_cmd);
 
 	if (do_command_logging) {
 		do_log_commands = true;
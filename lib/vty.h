@@ -141,6 +141,11 @@ struct vty {
 	size_t pending_cmds_buflen;
 	size_t pending_cmds_bufpos;
 
+	/* Configuration lines being received from vtysh in one batch. */
+	char *batch;
+	size_t batch_len;
+	size_t batch_pos;
+
 	/* Confirmed-commit timeout and rollback configuration. */
 	struct thread *t_confirmed_commit_timeout;
 	struct nb_config *confirmed_commit_rollback;
@@ -191,6 +196,10 @@ struct vty {
 	unsigned long v_timeout;
 	struct thread *t_timeout;
 
+	/* Suspended command still producing output, see vty_suspend() */
+	void (*suspend_abort)(void *arg);
+	void *suspend_arg;
+
 	/* What address is this vty comming from. */
 	char address[SU_ADDRSTRLEN];
 
@@ -336,6 +345,55 @@ extern int vty_shell(struct vty *);
 extern int vty_shell_serv(struct vty *);
 extern void vty_hello(struct vty *);
 
+/*
+ * Long running show commands can produce their output from events instead
+ * of blocking the daemon: the command calls vty_suspend() and returns
+ * CMD_SUSPEND, the events keep writing with vty_out() and finally call
+ * vty_resume() with the command's result.  If the session goes away in the
+ * meantime, abort is called instead and the vty must not be touched again.
+ *
+ * Only vtysh sessions can be suspended; returns false otherwise, in which
+ * case the command has to do its work synchronously.
+ */
+extern bool vty_suspend(struct vty *vty, void (*abort)(void *arg), void *arg);
+extern void vty_resume(struct vty *vty, int ret);
+
+/*
+ * Writes out as much pending output as the socket takes.  Returns true if
+ * more than VTY_OUTPUT_HIGHWATER bytes are still queued, in which case a
+ * suspended command should wait before producing more.
+ */
+#define VTY_OUTPUT_HIGHWATER (1024 * 1024)
+extern bool vty_output_blocked(struct vty *vty);
+
+/*
+ * Resumable walk for show commands going over large tables.  On vtysh
+ * sessions the entries are shown from events, at most VTY_WALK_BATCH of
+ * them or VTY_WALK_SLICE microseconds at a time, and the walk waits while
+ * the client is not reading its output.  Elsewhere it all runs right away.
+ *
+ * Before going back to the event loop the pause hook is called; it must drop
+ * anything that can go away in the meantime (e.g. route_table_iter_pause()),
+ * and step has to look it up again.  finish is called exactly once: vty is
+ * NULL if the session went away, otherwise it writes the end of the output,
+ * and in either case it frees arg.
+ */
+struct vty_walk_ops {
+	/* shows one entry; returns false once there is nothing left */
+	bool (*step)(struct vty *vty, void *arg);
+	void (*pause)(void *arg);
+	/* returns the command's result */
+	int (*finish)(struct vty *vty, void *arg);
+};
+
+#define VTY_WALK_BATCH 1000
+#define VTY_WALK_SLICE 10000 /* usec */
+#define VTY_WALK_BLOCKED_WAIT 10 /* msec */
+
+/* Returns CMD_SUSPEND if the walk continues from events. */
+extern int vty_walk(struct vty *vty, const struct vty_walk_ops *ops,
+		    void *arg);
+
 /* ^Z / SIGTSTP handling */
 extern void vty_stdio_suspend(void);
 extern void vty_stdio_resume(void);
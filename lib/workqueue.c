@@ -145,6 +145,10 @@ static int work_queue_schedule(struct work_queue *wq, unsigned int delay)
 		/* set thread yield time, if needed */
 		if (wq->thread && wq->spec.yield != THREAD_YIELD_TIME_SLOT)
 			thread_set_yield_time(wq->thread, wq->spec.yield);
+		/* bulk work, let protocol timers and I/O go first */
+		if (wq->thread)
+			thread_set_priority(wq->thread,
+					    THREAD_PRIO_BACKGROUND);
 		return 1;
 	} else
 		return 0;
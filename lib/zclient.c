@@ -42,10 +42,15 @@
 #include "srte.h"
 #include "printfrr.h"
 #include "srv6.h"
+#include "shm_ring.h"
+#include "libfrr_trace.h"
 
 DEFINE_MTYPE_STATIC(LIB, ZCLIENT, "Zclient");
 DEFINE_MTYPE_STATIC(LIB, REDIST_INST, "Redistribution instance IDs");
 
+/* Large enough to hold a few thousand route adds */
+#define ZCLIENT_SHM_RING_SIZE (4 * 1024 * 1024)
+
 /* Zebra client events. */
 enum event { ZCLIENT_SCHEDULE, ZCLIENT_READ, ZCLIENT_CONNECT };
 
@@ -56,7 +61,8 @@ static void zebra_interface_if_set_value(struct stream *s,
 					 struct interface *ifp);
 
 struct zclient_options zclient_options_default = {.receive_notify = false,
-						  .synchronous = false};
+						  .synchronous = false,
+						  .shm_ring = false};
 
 struct sockaddr_storage zclient_addr;
 socklen_t zclient_addr_len;
@@ -81,6 +87,9 @@ struct zclient *zclient_new(struct thread_master *master,
 
 	zclient->receive_notify = opt->receive_notify;
 	zclient->synchronous = opt->synchronous;
+	zclient->shm_ring = opt->shm_ring && !opt->synchronous;
+	if (zclient->shm_ring)
+		zclient->ring_overflow = stream_fifo_new();
 
 	return zclient;
 }
@@ -96,8 +105,14 @@ void zclient_free(struct zclient *zclient)
 		stream_free(zclient->ibuf);
 	if (zclient->obuf)
 		stream_free(zclient->obuf);
+	if (zclient->bulk)
+		stream_free(zclient->bulk);
+	if (zclient->labels_bulk)
+		stream_free(zclient->labels_bulk);
 	if (zclient->wb)
 		buffer_free(zclient->wb);
+	if (zclient->ring_overflow)
+		stream_fifo_free(zclient->ring_overflow);
 
 	XFREE(MTYPE_ZCLIENT, zclient);
 }
@@ -173,14 +188,27 @@ void zclient_stop(struct zclient *zclient)
 	THREAD_OFF(zclient->t_read);
 	THREAD_OFF(zclient->t_connect);
 	THREAD_OFF(zclient->t_write);
+	THREAD_OFF(zclient->t_ring);
 
 	/* Reset streams. */
 	stream_reset(zclient->ibuf);
 	stream_reset(zclient->obuf);
+	if (zclient->bulk)
+		stream_reset(zclient->bulk);
+	zclient->bulk_count = 0;
+	if (zclient->labels_bulk)
+		stream_reset(zclient->labels_bulk);
+	zclient->labels_bulk_count = 0;
 
 	/* Empty the write buffer. */
 	buffer_reset(zclient->wb);
 
+	/* Drop the ring, zebra unmaps its side when the socket closes. */
+	shm_ring_del(&zclient->ring);
+	zclient->ring_active = false;
+	if (zclient->ring_overflow)
+		stream_fifo_clean(zclient->ring_overflow);
+
 	/* Close socket. */
 	if (zclient->sock >= 0) {
 		close(zclient->sock);
@@ -286,19 +314,11 @@ static int zclient_flush_data(struct thread *thread)
 	return 0;
 }
 
-/*
- * Returns:
- * ZCLIENT_SEND_FAILED   - is a failure
- * ZCLIENT_SEND_SUCCESS  - means we sent data to zebra
- * ZCLIENT_SEND_BUFFERED - means we are buffering
- */
-enum zclient_send_status zclient_send_message(struct zclient *zclient)
+static enum zclient_send_status zclient_send_socket(struct zclient *zclient,
+						    const uint8_t *data,
+						    size_t size)
 {
-	if (zclient->sock < 0)
-		return ZCLIENT_SEND_FAILURE;
-	switch (buffer_write(zclient->wb, zclient->sock,
-			     STREAM_DATA(zclient->obuf),
-			     stream_get_endp(zclient->obuf))) {
+	switch (buffer_write(zclient->wb, zclient->sock, data, size)) {
 	case BUFFER_ERROR:
 		flog_err(EC_LIB_ZAPI_SOCKET,
 			 "%s: buffer_write failed to zclient fd %d, closing",
@@ -317,6 +337,167 @@ enum zclient_send_status zclient_send_message(struct zclient *zclient)
 	return ZCLIENT_SEND_SUCCESS;
 }
 
+/*
+ * Wake zebra up after putting data into the ring.  This goes through the
+ * write buffer, behind anything sent over the socket before the ring was
+ * in use; zebra does not look at the ring before the first kick.
+ */
+static enum zclient_send_status zclient_ring_kick(struct zclient *zclient)
+{
+	struct stream *s = stream_new(ZEBRA_HEADER_SIZE);
+	enum zclient_send_status ret;
+
+	zclient_create_header(s, ZEBRA_SHM_RING_KICK, VRF_DEFAULT);
+	ret = zclient_send_socket(zclient, STREAM_DATA(s), stream_get_endp(s));
+	stream_free(s);
+	return ret;
+}
+
+/* Move messages that did not fit earlier into the ring. */
+static int zclient_ring_flush(struct thread *thread)
+{
+	struct zclient *zclient = THREAD_ARG(thread);
+	struct stream *s;
+	bool wakeup = false;
+
+	while ((s = stream_fifo_head(zclient->ring_overflow))) {
+		if (!shm_ring_put(zclient->ring, STREAM_DATA(s),
+				  stream_get_endp(s), &wakeup))
+			break;
+		stream_free(stream_fifo_pop(zclient->ring_overflow));
+	}
+
+	if (wakeup && zclient_ring_kick(zclient) == ZCLIENT_SEND_FAILURE)
+		return -1;
+
+	if (stream_fifo_head(zclient->ring_overflow))
+		thread_add_timer_msec(zclient->master, zclient_ring_flush,
+				      zclient, 1, &zclient->t_ring);
+	else if (zclient->zebra_buffer_write_ready)
+		(*zclient->zebra_buffer_write_ready)();
+	return 0;
+}
+
+static enum zclient_send_status zclient_send_ring(struct zclient *zclient,
+						  struct stream *s)
+{
+	bool wakeup = false;
+
+	if (!stream_fifo_head(zclient->ring_overflow)
+	    && shm_ring_put(zclient->ring, STREAM_DATA(s), stream_get_endp(s),
+			    &wakeup))
+		return wakeup ? zclient_ring_kick(zclient)
+			      : ZCLIENT_SEND_SUCCESS;
+
+	/* zebra is busy reading, it will not need another kick */
+	stream_fifo_push(zclient->ring_overflow, stream_dup(s));
+	thread_add_timer_msec(zclient->master, zclient_ring_flush, zclient, 1,
+			      &zclient->t_ring);
+	return ZCLIENT_SEND_BUFFERED;
+}
+
+/*
+ * Returns:
+ * ZCLIENT_SEND_FAILED   - is a failure
+ * ZCLIENT_SEND_SUCCESS  - means we sent data to zebra
+ * ZCLIENT_SEND_BUFFERED - means we are buffering
+ */
+static enum zclient_send_status zclient_send_stream(struct zclient *zclient,
+						    struct stream *s)
+{
+	if (zclient->sock < 0)
+		return ZCLIENT_SEND_FAILURE;
+	if (zclient->ring_active)
+		return zclient_send_ring(zclient, s);
+	return zclient_send_socket(zclient, STREAM_DATA(s),
+				   stream_get_endp(s));
+}
+
+/*
+ * Offer zebra a shared memory ring; the file descriptor is passed along
+ * with the ZEBRA_SHM_RING_SETUP message.  Messages keep going through the
+ * socket until zebra's answer arrives.
+ */
+static void zclient_ring_setup(struct zclient *zclient)
+{
+	struct stream *s;
+	union {
+		char buf[CMSG_SPACE(sizeof(int))];
+		struct cmsghdr align;
+	} cmsgbuf;
+	struct iovec iov;
+	struct msghdr msgh = {};
+	struct cmsghdr *cmsg;
+	ssize_t nb;
+	int fd;
+
+	/* the fd has to travel with these bytes, nothing may be queued */
+	if (!buffer_empty(zclient->wb))
+		return;
+
+	zclient->ring = shm_ring_new(ZCLIENT_SHM_RING_SIZE);
+	if (!zclient->ring) {
+		if (zclient_debug)
+			zlog_debug("%s: cannot create ring: %s", __func__,
+				   safe_strerror(errno));
+		return;
+	}
+
+	s = stream_new(ZEBRA_HEADER_SIZE);
+	zclient_create_header(s, ZEBRA_SHM_RING_SETUP, VRF_DEFAULT);
+	iov.iov_base = STREAM_DATA(s);
+	iov.iov_len = stream_get_endp(s);
+
+	memset(&cmsgbuf, 0, sizeof(cmsgbuf));
+	msgh.msg_iov = &iov;
+	msgh.msg_iovlen = 1;
+	msgh.msg_control = cmsgbuf.buf;
+	msgh.msg_controllen = sizeof(cmsgbuf.buf);
+	cmsg = CMSG_FIRSTHDR(&msgh);
+	cmsg->cmsg_level = SOL_SOCKET;
+	cmsg->cmsg_type = SCM_RIGHTS;
+	cmsg->cmsg_len = CMSG_LEN(sizeof(int));
+	fd = shm_ring_fd(zclient->ring);
+	memcpy(CMSG_DATA(cmsg), &fd, sizeof(fd));
+
+	nb = sendmsg(zclient->sock, &msgh, 0);
+	stream_free(s);
+	if (nb != ZEBRA_HEADER_SIZE) {
+		/* a short write of 10 bytes on a fresh socket does not
+		 * happen; the connection is broken anyway if it does
+		 */
+		if (zclient_debug)
+			zlog_debug("%s: cannot offer ring: %s", __func__,
+				   safe_strerror(errno));
+		shm_ring_del(&zclient->ring);
+	}
+}
+
+static void zclient_ring_setup_reply(struct zclient *zclient)
+{
+	uint8_t accepted = 0;
+
+	STREAM_GETC(zclient->ibuf, accepted);
+
+stream_failure:
+	if (!zclient->ring || zclient->ring_active)
+		return;
+
+	if (accepted)
+		zclient->ring_active = true;
+	else
+		shm_ring_del(&zclient->ring);
+
+	if (zclient_debug)
+		zlog_debug("zclient %p: zebra %s the shared memory ring",
+			   zclient, accepted ? "accepted" : "declined");
+}
+
+enum zclient_send_status zclient_send_message(struct zclient *zclient)
+{
+	return zclient_send_stream(zclient, zclient->obuf);
+}
+
 /*
  * If we add more data to this structure please ensure that
  * struct zmsghdr in lib/zclient.h is updated as appropriate.
@@ -704,6 +885,9 @@ int zclient_start(struct zclient *zclient)
 
 	zclient_send_hello(zclient);
 
+	if (zclient->shm_ring && zclient->redist_default)
+		zclient_ring_setup(zclient);
+
 	zebra_message_send(zclient, ZEBRA_INTERFACE_ADD, VRF_DEFAULT);
 
 	/* Inform the successful connection. */
@@ -816,11 +1000,72 @@ enum zclient_send_status zclient_send_rnh(struct zclient *zclient, int command,
 enum zclient_send_status
 zclient_route_send(uint8_t cmd, struct zclient *zclient, struct zapi_route *api)
 {
+	frrtrace(2, frr_libfrr, zclient_route_send, cmd, api);
+
 	if (zapi_route_encode(cmd, zclient->obuf, api) < 0)
 		return ZCLIENT_SEND_FAILURE;
 	return zclient_send_message(zclient);
 }
 
+/*
+ * A ZEBRA_ROUTE_ADD_BULK message is the header, with the vrf of all of
+ * its routes, a 2 byte count and that many ZEBRA_ROUTE_ADD bodies.
+ */
+enum zclient_send_status zclient_route_bulk_flush(struct zclient *zclient)
+{
+	struct stream *s = zclient->bulk;
+
+	if (!zclient->bulk_count)
+		return ZCLIENT_SEND_SUCCESS;
+
+	stream_putw_at(s, ZEBRA_HEADER_SIZE, zclient->bulk_count);
+	stream_putw_at(s, 0, stream_get_endp(s));
+	zclient->bulk_count = 0;
+
+	return zclient_send_stream(zclient, s);
+}
+
+enum zclient_send_status zclient_route_add_bulk(struct zclient *zclient,
+						struct zapi_route *api)
+{
+	enum zclient_send_status ret = ZCLIENT_SEND_SUCCESS;
+	struct stream *s;
+	size_t len;
+
+	frrtrace(2, frr_libfrr, zclient_route_send, ZEBRA_ROUTE_ADD, api);
+
+	if (zapi_route_encode(ZEBRA_ROUTE_ADD, zclient->obuf, api) < 0)
+		return ZCLIENT_SEND_FAILURE;
+	len = stream_get_endp(zclient->obuf) - ZEBRA_HEADER_SIZE;
+
+	if (!zclient->bulk)
+		zclient->bulk = stream_new(ZEBRA_MAX_PACKET_SIZ);
+	s = zclient->bulk;
+
+	if (zclient->bulk_count
+	    && (STREAM_WRITEABLE(s) < len || zclient->bulk_count == UINT16_MAX
+		|| stream_getl_from(s, ZEBRA_HEADER_SIZE - 6) != api->vrf_id))
+		ret = zclient_route_bulk_flush(zclient);
+
+	/* Too big to share a message */
+	if (len + ZEBRA_HEADER_SIZE + 2 > STREAM_SIZE(s)) {
+		if (ret == ZCLIENT_SEND_FAILURE)
+			return ret;
+		return zclient_send_message(zclient);
+	}
+
+	if (!zclient->bulk_count) {
+		stream_reset(s);
+		zclient_create_header(s, ZEBRA_ROUTE_ADD_BULK, api->vrf_id);
+		stream_putw(s, 0);
+	}
+
+	stream_put(s, STREAM_DATA(zclient->obuf) + ZEBRA_HEADER_SIZE, len);
+	zclient->bulk_count++;
+
+	return ret;
+}
+
 static int zapi_nexthop_labels_cmp(const struct zapi_nexthop *next1,
 				   const struct zapi_nexthop *next2)
 {
@@ -941,7 +1186,7 @@ static int zapi_nexthop_cmp_no_labels(const struct zapi_nexthop *next1,
 	return 0;
 }
 
-static int zapi_nexthop_cmp(const void *item1, const void *item2)
+int zapi_nexthop_cmp(const void *item1, const void *item2)
 {
 	int ret = 0;
 
@@ -961,8 +1206,8 @@ static int zapi_nexthop_cmp(const void *item1, const void *item2)
 	return ret;
 }
 
-static void zapi_nexthop_group_sort(struct zapi_nexthop *nh_grp,
-				    uint16_t nexthop_num)
+void zapi_nexthop_group_sort(struct zapi_nexthop *nh_grp,
+			     uint16_t nexthop_num)
 {
 	qsort(nh_grp, nexthop_num, sizeof(struct zapi_nexthop),
 	      &zapi_nexthop_cmp);
@@ -2501,6 +2746,7 @@ struct connected *zebra_interface_address_read(int type, struct stream *s,
 					ifp->name, ifc->address);
 				UNSET_FLAG(ifc->flags, ZEBRA_IFA_PEER);
 			}
+			if_connected_update(ifp, ifc);
 		}
 	} else {
 		assert(type == ZEBRA_INTERFACE_ADDRESS_DELETE);
@@ -3297,11 +3543,74 @@ stream_failure:
 enum zclient_send_status zebra_send_mpls_labels(struct zclient *zclient,
 						int cmd, struct zapi_labels *zl)
 {
+	/* Don't overtake queued updates for the same LSPs */
+	if (zclient->labels_bulk_count)
+		(void)zclient_labels_bulk_flush(zclient);
+
 	if (zapi_labels_encode(zclient->obuf, cmd, zl) < 0)
 		return ZCLIENT_SEND_FAILURE;
 	return zclient_send_message(zclient);
 }
 
+/*
+ * A ZEBRA_MPLS_LABELS_BULK message is the header, a 2 byte count and that
+ * many entries, each a 2 byte ZEBRA_MPLS_LABELS_ADD/DELETE/REPLACE command
+ * followed by the body of that message.
+ */
+enum zclient_send_status zclient_labels_bulk_flush(struct zclient *zclient)
+{
+	struct stream *s = zclient->labels_bulk;
+
+	if (!zclient->labels_bulk_count)
+		return ZCLIENT_SEND_SUCCESS;
+
+	stream_putw_at(s, ZEBRA_HEADER_SIZE, zclient->labels_bulk_count);
+	stream_putw_at(s, 0, stream_get_endp(s));
+	zclient->labels_bulk_count = 0;
+
+	return zclient_send_stream(zclient, s);
+}
+
+enum zclient_send_status zclient_labels_bulk(struct zclient *zclient, int cmd,
+					     struct zapi_labels *zl)
+{
+	enum zclient_send_status ret = ZCLIENT_SEND_SUCCESS;
+	struct stream *s;
+	size_t len;
+
+	if (zapi_labels_encode(zclient->obuf, cmd, zl) < 0)
+		return ZCLIENT_SEND_FAILURE;
+	len = stream_get_endp(zclient->obuf) - ZEBRA_HEADER_SIZE;
+
+	if (!zclient->labels_bulk)
+		zclient->labels_bulk = stream_new(ZEBRA_MAX_PACKET_SIZ);
+	s = zclient->labels_bulk;
+
+	if (zclient->labels_bulk_count
+	    && (STREAM_WRITEABLE(s) < len + 2
+		|| zclient->labels_bulk_count == UINT16_MAX))
+		ret = zclient_labels_bulk_flush(zclient);
+
+	/* Too big to share a message */
+	if (len + ZEBRA_HEADER_SIZE + 4 > STREAM_SIZE(s)) {
+		if (ret == ZCLIENT_SEND_FAILURE)
+			return ret;
+		return zclient_send_message(zclient);
+	}
+
+	if (!zclient->labels_bulk_count) {
+		stream_reset(s);
+		zclient_create_header(s, ZEBRA_MPLS_LABELS_BULK, VRF_DEFAULT);
+		stream_putw(s, 0);
+	}
+
+	stream_putw(s, cmd);
+	stream_put(s, STREAM_DATA(zclient->obuf) + ZEBRA_HEADER_SIZE, len);
+	zclient->labels_bulk_count++;
+
+	return ret;
+}
+
 int zapi_labels_encode(struct stream *s, int cmd, struct zapi_labels *zl)
 {
 	struct zapi_nexthop *znh;
@@ -3799,6 +4108,37 @@ stream_failure:
 }
 
 /* Zebra client message read function. */
+/*
+ * Each notification in a ZEBRA_ROUTE_NOTIFY_OWNER_BULK carries its vrf and
+ * length, followed by the body of a ZEBRA_ROUTE_NOTIFY_OWNER; hand them to
+ * the daemon one by one.
+ */
+static void zclient_route_notify_owner_bulk(struct zclient *zclient)
+{
+	struct stream *s = zclient->ibuf;
+	uint16_t count, len;
+	vrf_id_t vrf_id;
+	size_t next;
+
+	STREAM_GETW(s, count);
+	while (count--) {
+		STREAM_GETL(s, vrf_id);
+		STREAM_GETW(s, len);
+
+		next = stream_get_getp(s) + len;
+		if (next > stream_get_endp(s))
+			return;
+
+		if (zclient->route_notify_owner)
+			(*zclient->route_notify_owner)(ZEBRA_ROUTE_NOTIFY_OWNER,
+						       zclient, len, vrf_id);
+		stream_set_getp(s, next);
+	}
+
+stream_failure:
+	return;
+}
+
 static int zclient_read(struct thread *thread)
 {
 	size_t already;
@@ -4064,6 +4404,12 @@ static int zclient_read(struct thread *thread)
 			(*zclient->route_notify_owner)(command, zclient, length,
 						       vrf_id);
 		break;
+	case ZEBRA_ROUTE_NOTIFY_OWNER_BULK:
+		zclient_route_notify_owner_bulk(zclient);
+		break;
+	case ZEBRA_SHM_RING_SETUP:
+		zclient_ring_setup_reply(zclient);
+		break;
 	case ZEBRA_RULE_NOTIFY_OWNER:
 		if (zclient->rule_notify_owner)
 			(*zclient->rule_notify_owner)(command, zclient, length,
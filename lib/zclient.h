@@ -240,6 +240,11 @@ typedef enum {
 	ZEBRA_GRE_GET,
 	ZEBRA_GRE_UPDATE,
 	ZEBRA_GRE_SOURCE_SET,
+	ZEBRA_ROUTE_ADD_BULK,
+	ZEBRA_ROUTE_NOTIFY_OWNER_BULK,
+	ZEBRA_SHM_RING_SETUP,
+	ZEBRA_SHM_RING_KICK,
+	ZEBRA_MPLS_LABELS_BULK,
 } zebra_message_types_t;
 
 enum zebra_error_types {
@@ -316,6 +321,18 @@ struct zclient {
 	/* Output buffer for zebra message. */
 	struct stream *obuf;
 
+	/* ZEBRA_ROUTE_ADD_BULK message being filled, see
+	 * zclient_route_add_bulk().
+	 */
+	struct stream *bulk;
+	uint16_t bulk_count;
+
+	/* ZEBRA_MPLS_LABELS_BULK message being filled, see
+	 * zclient_labels_bulk().
+	 */
+	struct stream *labels_bulk;
+	uint16_t labels_bulk_count;
+
 	/* Buffer of data waiting to be written to zebra. */
 	struct buffer *wb;
 
@@ -326,6 +343,17 @@ struct zclient {
 	/* Thread to write buffered data to zebra. */
 	struct thread *t_write;
 
+	/* Send messages through a shared memory ring instead of the socket;
+	 * the socket then only carries ZEBRA_SHM_RING_KICK wakeups.  The
+	 * ring is offered after ZEBRA_HELLO and used once zebra accepts it.
+	 */
+	bool shm_ring;
+	struct shm_ring *ring;
+	bool ring_active;
+	/* Messages that did not fit into the ring, and the retry timer */
+	struct stream_fifo *ring_overflow;
+	struct thread *t_ring;
+
 	/* Redistribute information. */
 	uint8_t redist_default; /* clients protocol */
 	unsigned short instance;
@@ -848,6 +876,7 @@ enum zebra_neigh_state { ZEBRA_NEIGH_INACTIVE = 0, ZEBRA_NEIGH_ACTIVE = 1 };
 struct zclient_options {
 	bool receive_notify;
 	bool synchronous;
+	bool shm_ring;
 };
 
 extern struct zclient_options zclient_options_default;
@@ -1081,6 +1110,17 @@ extern enum zclient_send_status zebra_send_mpls_labels(struct zclient *zclient,
 						       struct zapi_labels *zl);
 extern int zapi_labels_encode(struct stream *s, int cmd,
 			      struct zapi_labels *zl);
+
+/*
+ * Queue a ZEBRA_MPLS_LABELS_ADD/DELETE/REPLACE in a ZEBRA_MPLS_LABELS_BULK
+ * message.  The message is sent when it is full, when
+ * zclient_labels_bulk_flush() is called or ahead of the next
+ * zebra_send_mpls_labels(), so LSP updates stay in order.
+ */
+extern enum zclient_send_status
+zclient_labels_bulk(struct zclient *zclient, int cmd, struct zapi_labels *zl);
+extern enum zclient_send_status
+zclient_labels_bulk_flush(struct zclient *zclient);
 extern int zapi_labels_decode(struct stream *s, struct zapi_labels *zl);
 
 extern int zapi_srv6_locator_chunk_encode(struct stream *s,
@@ -1095,11 +1135,27 @@ extern int zebra_read_pw_status_update(ZAPI_CALLBACK_ARGS,
 
 extern enum zclient_send_status zclient_route_send(uint8_t, struct zclient *,
 						   struct zapi_route *);
+
+/*
+ * Queue a route add in a ZEBRA_ROUTE_ADD_BULK message.  The message is
+ * sent when it is full, when a route for another vrf is queued or when
+ * zclient_route_bulk_flush() is called; the status returned is that of
+ * the last message sent.  Zebra then sends its owner notifications in
+ * batches as well, to the route_notify_owner callback as usual.
+ */
+extern enum zclient_send_status
+zclient_route_add_bulk(struct zclient *zclient, struct zapi_route *api);
+extern enum zclient_send_status
+zclient_route_bulk_flush(struct zclient *zclient);
 extern enum zclient_send_status
 zclient_send_rnh(struct zclient *zclient, int command, const struct prefix *p,
 		 bool exact_match, vrf_id_t vrf_id);
 int zapi_nexthop_encode(struct stream *s, const struct zapi_nexthop *api_nh,
 			uint32_t api_flags, uint32_t api_message);
+/* The order zebra gets the nexthops of routes and nexthop groups in */
+extern int zapi_nexthop_cmp(const void *item1, const void *item2);
+extern void zapi_nexthop_group_sort(struct zapi_nexthop *nh_grp,
+				    uint16_t nexthop_num);
 extern int zapi_route_encode(uint8_t, struct stream *, struct zapi_route *);
 extern int zapi_route_decode(struct stream *s, struct zapi_route *api);
 extern int zapi_nexthop_decode(struct stream *s, struct zapi_nexthop *api_nh,
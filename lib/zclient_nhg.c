@@ -0,0 +1,730 @@
+/*
+ * Nexthop groups shared by the routes a daemon sends to zebra.
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+
+#include "id_alloc.h"
+#include "jhash.h"
+#include "lib_errors.h"
+#include "memory.h"
+#include "prefix.h"
+#include "thread.h"
+#include "typesafe.h"
+#include "zclient.h"
+#include "zclient_nhg.h"
+
+DEFINE_MTYPE_STATIC(LIB, ZCLIENT_NHG_CACHE, "Zclient nexthop group cache");
+DEFINE_MTYPE_STATIC(LIB, ZCLIENT_NHG, "Zclient nexthop group");
+DEFINE_MTYPE_STATIC(LIB, ZCLIENT_NHG_NEXTHOPS, "Zclient nexthop group nexthops");
+DEFINE_MTYPE_STATIC(LIB, ZCLIENT_NHG_ROUTE, "Zclient nexthop group route");
+
+PREDECL_HASH(nhg_content);
+PREDECL_HASH(nhg_ids);
+PREDECL_DLIST(nhg_work);
+PREDECL_DLIST(nhg_members);
+PREDECL_HASH(nhg_routes);
+
+enum nhg_state {
+	NHG_IDLE,
+	/* some members were added with other nexthops since the last flush */
+	NHG_PENDING,
+	/* no members left, deleted on the next flush unless reused */
+	NHG_DEAD,
+};
+
+struct nhg {
+	struct nhg_content_item citem;
+	struct nhg_ids_item iitem;
+	/* on the cache's pending or dead list */
+	struct nhg_work_item witem;
+
+	uint32_t id;
+	enum nhg_state state;
+	/* in the content hash, not the case if its nexthops were a duplicate */
+	bool indexed;
+
+	struct nhg_members_head members;
+	/* members added with the pending nexthops */
+	unsigned int votes;
+
+	/* generation a member was last added with the nexthops in */
+	uint32_t gen;
+	/* generation the members parted ways in, no more in place updates */
+	uint32_t split_gen;
+
+	uint16_t nexthop_num;
+	struct zapi_nexthop *nexthops;
+
+	uint16_t pending_num;
+	struct zapi_nexthop *pending;
+};
+
+/* A route sent with a group, without its nexthops */
+struct nhg_route {
+	struct nhg_routes_item item;
+	struct nhg_members_item mitem;
+
+	struct nhg *nhg;
+	/* generation it was added with its group's pending nexthops in */
+	uint32_t vote;
+	/* zebra connection it was last sent on */
+	uint32_t epoch;
+
+	vrf_id_t vrf_id;
+	uint32_t tableid;
+	safi_t safi;
+	uint8_t type;
+	unsigned short instance;
+	struct prefix prefix;
+	struct prefix_ipv6 src_prefix;
+
+	uint32_t flags;
+	uint32_t message;
+	uint8_t distance;
+	uint32_t metric;
+	route_tag_t tag;
+	uint32_t mtu;
+};
+
+struct zclient_nhg_cache {
+	struct zclient *zclient;
+	struct id_alloc *ids;
+	uint32_t id_base;
+	bool disabled;
+
+	/* flushes since the start, 0 is used for "never" */
+	uint32_t gen;
+	/* zebra connections since the start */
+	uint32_t epoch;
+
+	struct nhg_content_head content;
+	struct nhg_ids_head byid;
+	struct nhg_work_head pending;
+	struct nhg_work_head dead;
+	struct nhg_routes_head routes;
+
+	struct thread *t_flush;
+};
+
+static int nhg_nexthops_cmp(const struct zapi_nexthop *nh1, uint16_t num1,
+			    const struct zapi_nexthop *nh2, uint16_t num2)
+{
+	int ret;
+	int i;
+
+	if (num1 != num2)
+		return numcmp(num1, num2);
+
+	for (i = 0; i < num1; i++) {
+		ret = zapi_nexthop_cmp(&nh1[i], &nh2[i]);
+		if (ret)
+			return ret;
+		if (nh1[i].flags != nh2[i].flags)
+			return numcmp(nh1[i].flags, nh2[i].flags);
+	}
+	return 0;
+}
+
+static int nhg_content_cmp(const struct nhg *a, const struct nhg *b)
+{
+	return nhg_nexthops_cmp(a->nexthops, a->nexthop_num, b->nexthops,
+				b->nexthop_num);
+}
+
+static uint32_t nhg_content_hash(const struct nhg *a)
+{
+	const struct zapi_nexthop *nh;
+	uint32_t key = a->nexthop_num;
+	int i;
+
+	/* only the gateway and interface types are ever used */
+	for (i = 0; i < a->nexthop_num; i++) {
+		nh = &a->nexthops[i];
+		key = jhash_3words(nh->type, nh->vrf_id, nh->ifindex, key);
+		key = jhash(&nh->gate,
+			    nh->type == NEXTHOP_TYPE_IPV4_IFINDEX
+				    ? sizeof(struct in_addr)
+				    : sizeof(struct in6_addr),
+			    key);
+		key = jhash_2words(nh->weight, nh->flags, key);
+	}
+	return key;
+}
+
+DECLARE_HASH(nhg_content, struct nhg, citem, nhg_content_cmp,
+	     nhg_content_hash);
+
+static int nhg_ids_cmp(const struct nhg *a, const struct nhg *b)
+{
+	return numcmp(a->id, b->id);
+}
+
+static uint32_t nhg_ids_hash(const struct nhg *a)
+{
+	return jhash_1word(a->id, 0x5eed);
+}
+
+DECLARE_HASH(nhg_ids, struct nhg, iitem, nhg_ids_cmp, nhg_ids_hash);
+DECLARE_DLIST(nhg_work, struct nhg, witem);
+DECLARE_DLIST(nhg_members, struct nhg_route, mitem);
+
+static int nhg_routes_cmp(const struct nhg_route *a, const struct nhg_route *b)
+{
+	int ret;
+
+	if (a->vrf_id != b->vrf_id)
+		return numcmp(a->vrf_id, b->vrf_id);
+	if (a->tableid != b->tableid)
+		return numcmp(a->tableid, b->tableid);
+	if (a->safi != b->safi)
+		return numcmp(a->safi, b->safi);
+	if (a->type != b->type)
+		return numcmp(a->type, b->type);
+	if (a->instance != b->instance)
+		return numcmp(a->instance, b->instance);
+	ret = prefix_cmp(&a->prefix, &b->prefix);
+	if (ret)
+		return ret;
+	if (a->src_prefix.prefixlen != b->src_prefix.prefixlen)
+		return numcmp(a->src_prefix.prefixlen, b->src_prefix.prefixlen);
+	if (!a->src_prefix.prefixlen)
+		return 0;
+	return prefix_cmp(&a->src_prefix, &b->src_prefix);
+}
+
+static uint32_t nhg_routes_hash(const struct nhg_route *a)
+{
+	return jhash_3words(prefix_hash_key(&a->prefix), a->vrf_id,
+			    a->tableid, a->src_prefix.prefixlen);
+}
+
+DECLARE_HASH(nhg_routes, struct nhg_route, item, nhg_routes_cmp,
+	     nhg_routes_hash);
+
+static int zclient_nhg_flush(struct thread *thread);
+
+static void nhg_schedule(struct zclient_nhg_cache *cache)
+{
+	thread_add_event(cache->zclient->master, zclient_nhg_flush, cache, 0,
+			 &cache->t_flush);
+}
+
+static void nhg_send(struct zclient_nhg_cache *cache, int cmd,
+		     struct nhg *nhg)
+{
+	struct zapi_nhg api_nhg = {};
+
+	/* zclient_nhg_cache_replay() sends them once connected */
+	if (cache->zclient->sock < 0)
+		return;
+
+	api_nhg.id = nhg->id;
+	if (cmd == ZEBRA_NHG_ADD) {
+		api_nhg.nexthop_num = nhg->nexthop_num;
+		memcpy(api_nhg.nexthops, nhg->nexthops,
+		       nhg->nexthop_num * sizeof(api_nhg.nexthops[0]));
+	}
+
+	if (zclient_nhg_send(cache->zclient, cmd, &api_nhg)
+	    == ZCLIENT_SEND_FAILURE)
+		flog_err(EC_LIB_ZAPI_SOCKET,
+			 "%s: nexthop group %u %s failed: %s", __func__,
+			 nhg->id, cmd == ZEBRA_NHG_ADD ? "add" : "delete",
+			 safe_strerror(errno));
+}
+
+static void nhg_free(struct zclient_nhg_cache *cache, struct nhg *nhg)
+{
+	if (nhg->state == NHG_PENDING)
+		nhg_work_del(&cache->pending, nhg);
+	else if (nhg->state == NHG_DEAD)
+		nhg_work_del(&cache->dead, nhg);
+	if (nhg->indexed)
+		nhg_content_del(&cache->content, nhg);
+	nhg_ids_del(&cache->byid, nhg);
+	idalloc_free(cache->ids, nhg->id - cache->id_base);
+
+	nhg_members_fini(&nhg->members);
+	XFREE(MTYPE_ZCLIENT_NHG_NEXTHOPS, nhg->nexthops);
+	XFREE(MTYPE_ZCLIENT_NHG_NEXTHOPS, nhg->pending);
+	XFREE(MTYPE_ZCLIENT_NHG, nhg);
+}
+
+static struct zapi_nexthop *nhg_nexthops_dup(const struct zapi_nexthop *nh,
+					     uint16_t num)
+{
+	struct zapi_nexthop *copy;
+
+	copy = XMALLOC(MTYPE_ZCLIENT_NHG_NEXTHOPS, num * sizeof(*copy));
+	memcpy(copy, nh, num * sizeof(*copy));
+	return copy;
+}
+
+/* A group with these nexthops, NULL when out of ids */
+static struct nhg *nhg_get(struct zclient_nhg_cache *cache,
+			   const struct zapi_nexthop *nh, uint16_t num)
+{
+	struct nhg key = {}, *nhg;
+	uint32_t id;
+
+	key.nexthops = (struct zapi_nexthop *)nh;
+	key.nexthop_num = num;
+	nhg = nhg_content_find(&cache->content, &key);
+	if (nhg) {
+		if (nhg->state == NHG_DEAD) {
+			nhg_work_del(&cache->dead, nhg);
+			nhg->state = NHG_IDLE;
+		}
+		return nhg;
+	}
+
+	id = idalloc_allocate(cache->ids);
+	if (id == IDALLOC_INVALID)
+		return NULL;
+	if (id >= ZEBRA_NHG_PROTO_SPACING) {
+		idalloc_free(cache->ids, id);
+		return NULL;
+	}
+
+	nhg = XCALLOC(MTYPE_ZCLIENT_NHG, sizeof(*nhg));
+	nhg->id = cache->id_base + id;
+	nhg->nexthop_num = num;
+	nhg->nexthops = nhg_nexthops_dup(nh, num);
+	nhg_members_init(&nhg->members);
+	nhg_content_add(&cache->content, nhg);
+	nhg->indexed = true;
+	nhg_ids_add(&cache->byid, nhg);
+
+	nhg_send(cache, ZEBRA_NHG_ADD, nhg);
+	return nhg;
+}
+
+static void nhg_route_unbind(struct zclient_nhg_cache *cache,
+			     struct nhg_route *rt)
+{
+	struct nhg *nhg = rt->nhg;
+
+	if (!nhg)
+		return;
+
+	if (nhg->state == NHG_PENDING && rt->vote == cache->gen)
+		nhg->votes--;
+	rt->vote = 0;
+	nhg_members_del(&nhg->members, rt);
+	rt->nhg = NULL;
+
+	if (nhg_members_count(&nhg->members))
+		return;
+
+	if (nhg->state == NHG_PENDING)
+		nhg_work_del(&cache->pending, nhg);
+	nhg->state = NHG_DEAD;
+	nhg_work_add_tail(&cache->dead, nhg);
+	nhg_schedule(cache);
+}
+
+static struct nhg *nhg_route_move(struct zclient_nhg_cache *cache,
+				  struct nhg_route *rt,
+				  const struct zapi_nexthop *nh, uint16_t num)
+{
+	struct nhg *nhg;
+
+	nhg = nhg_get(cache, nh, num);
+	nhg_route_unbind(cache, rt);
+	if (!nhg)
+		return NULL;
+
+	rt->nhg = nhg;
+	nhg_members_add_tail(&nhg->members, rt);
+	/* it's no longer free to take other nexthops during this flush */
+	nhg->gen = cache->gen;
+	return nhg;
+}
+
+/*
+ * Put the route in a group with nexthops nh, or in its current group which
+ * is going to be given these nexthops on the next flush.
+ */
+static struct nhg *nhg_route_bind(struct zclient_nhg_cache *cache,
+				  struct nhg_route *rt,
+				  const struct zapi_nexthop *nh, uint16_t num)
+{
+	struct nhg *nhg = rt->nhg;
+
+	if (!nhg)
+		return nhg_route_move(cache, rt, nh, num);
+
+	/* the route may have been added with other nexthops before */
+	if (nhg->state == NHG_PENDING && rt->vote == cache->gen) {
+		nhg->votes--;
+		rt->vote = 0;
+	}
+
+	if (nhg->state == NHG_PENDING
+	    && !nhg_nexthops_cmp(nh, num, nhg->pending, nhg->pending_num)) {
+		nhg->votes++;
+		rt->vote = cache->gen;
+		return nhg;
+	}
+
+	if (!nhg_nexthops_cmp(nh, num, nhg->nexthops, nhg->nexthop_num)) {
+		nhg->gen = cache->gen;
+		return nhg;
+	}
+
+	if (nhg->state == NHG_IDLE && nhg->gen != cache->gen
+	    && nhg->split_gen != cache->gen) {
+		nhg->state = NHG_PENDING;
+		nhg->pending_num = num;
+		nhg->pending = nhg_nexthops_dup(nh, num);
+		nhg->votes = 1;
+		rt->vote = cache->gen;
+		nhg_work_add_tail(&cache->pending, nhg);
+		nhg_schedule(cache);
+		return nhg;
+	}
+
+	return nhg_route_move(cache, rt, nh, num);
+}
+
+/* Sent with its group, or with nexthops nh if it has none */
+static enum zclient_send_status
+nhg_route_send(struct zclient_nhg_cache *cache, struct nhg_route *rt,
+	       const struct zapi_nexthop *nh, uint16_t num)
+{
+	struct zapi_route api;
+
+	memset(&api, 0, sizeof(api));
+	api.vrf_id = rt->vrf_id;
+	api.tableid = rt->tableid;
+	api.safi = rt->safi;
+	api.type = rt->type;
+	api.instance = rt->instance;
+	prefix_copy(&api.prefix, &rt->prefix);
+	api.src_prefix = rt->src_prefix;
+	api.flags = rt->flags;
+	api.message = rt->message;
+	api.distance = rt->distance;
+	api.metric = rt->metric;
+	api.tag = rt->tag;
+	api.mtu = rt->mtu;
+
+	if (rt->nhg) {
+		SET_FLAG(api.message, ZAPI_MESSAGE_NHG);
+		api.nhgid = rt->nhg->id;
+	} else {
+		SET_FLAG(api.message, ZAPI_MESSAGE_NEXTHOP);
+		api.nexthop_num = num;
+		memcpy(api.nexthops, nh, num * sizeof(api.nexthops[0]));
+	}
+
+	rt->epoch = cache->epoch;
+	nhg_schedule(cache);
+	return zclient_route_add_bulk(cache->zclient, &api);
+}
+
+static void nhg_route_free(struct zclient_nhg_cache *cache,
+			   struct nhg_route *rt)
+{
+	nhg_route_unbind(cache, rt);
+	nhg_routes_del(&cache->routes, rt);
+	XFREE(MTYPE_ZCLIENT_NHG_ROUTE, rt);
+}
+
+static void nhg_route_key(struct nhg_route *rt, const struct zapi_route *api)
+{
+	rt->vrf_id = api->vrf_id;
+	rt->tableid = api->tableid;
+	rt->safi = api->safi;
+	rt->type = api->type;
+	rt->instance = api->instance;
+	prefix_copy(&rt->prefix, &api->prefix);
+	if (CHECK_FLAG(api->message, ZAPI_MESSAGE_SRCPFX))
+		rt->src_prefix = api->src_prefix;
+	else
+		memset(&rt->src_prefix, 0, sizeof(rt->src_prefix));
+}
+
+static bool nhg_route_same(const struct zclient_nhg_cache *cache,
+			   const struct nhg_route *rt,
+			   const struct zapi_route *api)
+{
+	uint32_t message = api->message & ~ZAPI_MESSAGE_NEXTHOP;
+
+	return rt->epoch == cache->epoch && rt->flags == api->flags
+	       && rt->message == message && rt->distance == api->distance
+	       && rt->metric == api->metric && rt->tag == api->tag
+	       && rt->mtu == api->mtu;
+}
+
+static bool nhg_eligible(const struct zclient_nhg_cache *cache,
+			 const struct zapi_route *api)
+{
+	const struct zapi_nexthop *nh;
+	int i;
+
+	if (cache->disabled)
+		return false;
+
+	if (!CHECK_FLAG(api->message, ZAPI_MESSAGE_NEXTHOP)
+	    || CHECK_FLAG(api->message,
+			  ZAPI_MESSAGE_NHG | ZAPI_MESSAGE_BACKUP_NEXTHOPS
+				  | ZAPI_MESSAGE_SRTE | ZAPI_MESSAGE_OPAQUE))
+		return false;
+
+	/* zapi_nhg_encode() takes one less than routes do */
+	if (api->nexthop_num == 0 || api->nexthop_num >= MULTIPATH_NUM)
+		return false;
+
+	/* what zebra_nhg_proto_add() and its nexthop resolution accept */
+	for (i = 0; i < api->nexthop_num; i++) {
+		nh = &api->nexthops[i];
+		if (nh->type != NEXTHOP_TYPE_IPV4_IFINDEX
+		    && nh->type != NEXTHOP_TYPE_IPV6_IFINDEX)
+			return false;
+		if (!nh->ifindex || nh->label_num)
+			return false;
+		if (CHECK_FLAG(nh->flags, ZAPI_NEXTHOP_FLAG_LABEL
+						  | ZAPI_NEXTHOP_FLAG_HAS_BACKUP
+						  | ZAPI_NEXTHOP_FLAG_SEG6
+						  | ZAPI_NEXTHOP_FLAG_SEG6LOCAL))
+			return false;
+	}
+	return true;
+}
+
+enum zclient_send_status zclient_nhg_route_add(struct zclient_nhg_cache *cache,
+					       struct zapi_route *api)
+{
+	struct nhg_route key = {}, *rt;
+	struct nhg *old, *nhg = NULL;
+
+	nhg_route_key(&key, api);
+	rt = nhg_routes_find(&cache->routes, &key);
+
+	if (nhg_eligible(cache, api)) {
+		if (!rt) {
+			rt = XCALLOC(MTYPE_ZCLIENT_NHG_ROUTE, sizeof(*rt));
+			nhg_route_key(rt, api);
+			nhg_routes_add(&cache->routes, rt);
+		}
+
+		zapi_nexthop_group_sort(api->nexthops, api->nexthop_num);
+		old = rt->nhg;
+		nhg = nhg_route_bind(cache, rt, api->nexthops,
+				     api->nexthop_num);
+		if (nhg && nhg == old && nhg_route_same(cache, rt, api))
+			return ZCLIENT_SEND_SUCCESS;
+	}
+
+	if (!nhg) {
+		if (rt)
+			nhg_route_free(cache, rt);
+		nhg_schedule(cache);
+		return zclient_route_add_bulk(cache->zclient, api);
+	}
+
+	rt->flags = api->flags;
+	rt->message = api->message & ~ZAPI_MESSAGE_NEXTHOP;
+	rt->distance = api->distance;
+	rt->metric = api->metric;
+	rt->tag = api->tag;
+	rt->mtu = api->mtu;
+	return nhg_route_send(cache, rt, NULL, 0);
+}
+
+enum zclient_send_status
+zclient_nhg_route_delete(struct zclient_nhg_cache *cache,
+			 struct zapi_route *api)
+{
+	struct nhg_route key = {}, *rt;
+
+	nhg_route_key(&key, api);
+	rt = nhg_routes_find(&cache->routes, &key);
+	if (rt)
+		nhg_route_free(cache, rt);
+
+	if (zclient_route_bulk_flush(cache->zclient) == ZCLIENT_SEND_FAILURE)
+		return ZCLIENT_SEND_FAILURE;
+	return zclient_route_send(ZEBRA_ROUTE_DELETE, cache->zclient, api);
+}
+
+/* Give the group its pending nexthops, keeping its id */
+static void nhg_retarget(struct zclient_nhg_cache *cache, struct nhg *nhg)
+{
+	if (nhg->indexed)
+		nhg_content_del(&cache->content, nhg);
+
+	XFREE(MTYPE_ZCLIENT_NHG_NEXTHOPS, nhg->nexthops);
+	nhg->nexthops = nhg->pending;
+	nhg->nexthop_num = nhg->pending_num;
+	nhg->pending = NULL;
+	nhg->pending_num = 0;
+
+	nhg->indexed = !nhg_content_add(&cache->content, nhg);
+	nhg_send(cache, ZEBRA_NHG_ADD, nhg);
+}
+
+/* Move the members added with the pending nexthops to another group */
+static void nhg_split(struct zclient_nhg_cache *cache, struct nhg *nhg)
+{
+	struct nhg_route *rt;
+
+	nhg->split_gen = cache->gen;
+	frr_each_safe (nhg_members, &nhg->members, rt) {
+		if (rt->vote != cache->gen)
+			continue;
+		nhg_route_move(cache, rt, nhg->pending, nhg->pending_num);
+		nhg_route_send(cache, rt, nhg->pending, nhg->pending_num);
+	}
+
+	XFREE(MTYPE_ZCLIENT_NHG_NEXTHOPS, nhg->pending);
+	nhg->pending_num = 0;
+}
+
+static int zclient_nhg_flush(struct thread *thread)
+{
+	struct zclient_nhg_cache *cache = THREAD_ARG(thread);
+	struct nhg *nhg;
+
+	while ((nhg = nhg_work_pop(&cache->pending))) {
+		nhg->state = NHG_IDLE;
+		if (nhg->votes == nhg_members_count(&nhg->members)
+		    && nhg->gen != cache->gen)
+			nhg_retarget(cache, nhg);
+		else
+			nhg_split(cache, nhg);
+		nhg->votes = 0;
+	}
+
+	/* the groups left behind are only deleted after the routes moved */
+	if (zclient_route_bulk_flush(cache->zclient) == ZCLIENT_SEND_FAILURE)
+		flog_err(EC_LIB_ZAPI_SOCKET,
+			 "%s: zclient_route_bulk_flush() failed: %s", __func__,
+			 safe_strerror(errno));
+
+	while ((nhg = nhg_work_first(&cache->dead))) {
+		nhg_send(cache, ZEBRA_NHG_DEL, nhg);
+		nhg_free(cache, nhg);
+	}
+
+	if (++cache->gen == 0)
+		cache->gen = 1;
+	return 0;
+}
+
+void zclient_nhg_cache_notify(struct zclient_nhg_cache *cache, uint32_t id,
+			      enum zapi_nhg_notify_owner note)
+{
+	struct nhg key = {}, *nhg;
+	struct nhg_route *rt;
+	bool voted;
+
+	if (note != ZAPI_NHG_FAIL_INSTALL)
+		return;
+
+	key.id = id;
+	nhg = nhg_ids_find(&cache->byid, &key);
+	if (!nhg || nhg->state == NHG_DEAD)
+		return;
+
+	if (!cache->disabled)
+		flog_warn(EC_LIB_ZAPI_MISSMATCH,
+			  "%s: zebra failed to install nexthop group %u, routes are sent with their nexthops from now on",
+			  __func__, id);
+	cache->disabled = true;
+
+	/* nhg stays around on the dead list until the next flush */
+	frr_each_safe (nhg_members, &nhg->members, rt) {
+		voted = nhg->state == NHG_PENDING && rt->vote == cache->gen;
+		nhg_route_unbind(cache, rt);
+		if (voted)
+			nhg_route_send(cache, rt, nhg->pending,
+				       nhg->pending_num);
+		else
+			nhg_route_send(cache, rt, nhg->nexthops,
+				       nhg->nexthop_num);
+		nhg_route_free(cache, rt);
+	}
+}
+
+void zclient_nhg_cache_replay(struct zclient_nhg_cache *cache)
+{
+	struct nhg *nhg;
+
+	if (++cache->epoch == 0)
+		cache->epoch = 1;
+
+	/* nothing to delete on the new zebra */
+	while ((nhg = nhg_work_first(&cache->dead)))
+		nhg_free(cache, nhg);
+
+	frr_each (nhg_ids, &cache->byid, nhg)
+		nhg_send(cache, ZEBRA_NHG_ADD, nhg);
+}
+
+struct zclient_nhg_cache *zclient_nhg_cache_new(struct zclient *zclient)
+{
+	struct zclient_nhg_cache *cache;
+
+	cache = XCALLOC(MTYPE_ZCLIENT_NHG_CACHE, sizeof(*cache));
+	cache->zclient = zclient;
+	cache->ids = idalloc_new("Zclient nexthop groups");
+	cache->id_base = zclient_get_nhg_start(zclient->redist_default);
+	cache->gen = 1;
+	cache->epoch = 1;
+	/* the instances of a daemon share its id space */
+	cache->disabled = zclient->instance != 0;
+
+	nhg_content_init(&cache->content);
+	nhg_ids_init(&cache->byid);
+	nhg_work_init(&cache->pending);
+	nhg_work_init(&cache->dead);
+	nhg_routes_init(&cache->routes);
+	return cache;
+}
+
+void zclient_nhg_cache_free(struct zclient_nhg_cache **cachep)
+{
+	struct zclient_nhg_cache *cache = *cachep;
+	struct nhg_route *rt;
+	struct nhg *nhg;
+
+	if (!cache)
+		return;
+
+	THREAD_OFF(cache->t_flush);
+
+	while ((rt = nhg_routes_pop(&cache->routes))) {
+		if (rt->nhg)
+			nhg_members_del(&rt->nhg->members, rt);
+		XFREE(MTYPE_ZCLIENT_NHG_ROUTE, rt);
+	}
+	while ((nhg = nhg_ids_first(&cache->byid)))
+		nhg_free(cache, nhg);
+
+	nhg_content_fini(&cache->content);
+	nhg_ids_fini(&cache->byid);
+	nhg_work_fini(&cache->pending);
+	nhg_work_fini(&cache->dead);
+	nhg_routes_fini(&cache->routes);
+	idalloc_destroy(cache->ids);
+	XFREE(MTYPE_ZCLIENT_NHG_CACHE, cache);
+	*cachep = NULL;
+}
@@ -0,0 +1,80 @@
+/*
+ * Nexthop groups shared by the routes a daemon sends to zebra.
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _FRR_ZCLIENT_NHG_H
+#define _FRR_ZCLIENT_NHG_H
+
+#include "zclient.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Sends a daemon's routes with ZAPI_MESSAGE_NHG instead of their nexthops.
+ * Each distinct set of nexthops becomes a nexthop group owned by the daemon
+ * (ZEBRA_NHG_ADD), which all the routes using that set share.
+ *
+ * Groups keep their id when their nexthops change: if every route of a
+ * group is added again with the same new nexthops before the next flush, as
+ * when SPF changes an ECMP set, the group is updated in place with a single
+ * ZEBRA_NHG_ADD and none of its routes are sent again, unless something else
+ * about them changed too.  Otherwise the routes that changed move to another
+ * group and are sent again.
+ *
+ * Routes zebra can't take nexthop groups for (backup nexthops, labels,
+ * nexthops without both a gateway and an interface) keep being sent with
+ * their nexthops, as do all the routes of a daemon instance, whose group ids
+ * would clash with those of the other instances, and all the routes added
+ * after zebra failed to install a group.
+ *
+ * Route adds are queued with zclient_route_add_bulk() and sent from an
+ * event; deletes send the queue first and then go out right away.  A daemon
+ * sending other routes directly must call zclient_route_bulk_flush() first.
+ */
+struct zclient_nhg_cache;
+
+extern struct zclient_nhg_cache *zclient_nhg_cache_new(struct zclient *zclient);
+/* Doesn't delete the groups, zebra does that when the daemon goes away */
+extern void zclient_nhg_cache_free(struct zclient_nhg_cache **cache);
+
+/* Sorts the nexthops of api */
+extern enum zclient_send_status
+zclient_nhg_route_add(struct zclient_nhg_cache *cache, struct zapi_route *api);
+extern enum zclient_send_status
+zclient_nhg_route_delete(struct zclient_nhg_cache *cache,
+			 struct zapi_route *api);
+
+/* For the zclient's nhg_notify_owner callback */
+extern void zclient_nhg_cache_notify(struct zclient_nhg_cache *cache,
+				     uint32_t id,
+				     enum zapi_nhg_notify_owner note);
+
+/*
+ * For the zebra_connected callback: a new zebra has none of the groups, so
+ * they are sent again, and none of the routes, so the next add of each one
+ * is sent even if nothing changed.
+ */
+extern void zclient_nhg_cache_replay(struct zclient_nhg_cache *cache);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FRR_ZCLIENT_NHG_H */
@@ -395,7 +395,7 @@ void zlog_tls_buffer_flush(void)
 
 	rcu_read_lock();
 	frr_each (zlog_targets, &zlog_targets, zt) {
-		if (!zt->logfn)
+		if (!zt->logfn || zt->raw)
 			continue;
 
 		zt->logfn(zt, zlog_tls->msgp, zlog_tls->nmsgs);
@@ -439,13 +439,45 @@ static void vzlog_notls(const struct xref_logmsg *xref, int prio,
 		XFREE(MTYPE_LOG_MESSAGE, msg->text);
 }
 
+static void vzlog_raw(const struct xref_logmsg *xref, int prio,
+		      const char *fmt, va_list ap)
+{
+	struct zlog_target *zt;
+	struct zlog_msg stackmsg = {
+		.prio = prio & LOG_PRIMASK,
+		.fmt = fmt,
+		.xref = xref,
+	}, *msg = &stackmsg;
+	char stackbuf[512];
+
+	clock_gettime(CLOCK_REALTIME, &msg->ts);
+	va_copy(msg->args, ap);
+	msg->stackbuf = stackbuf;
+	msg->stackbufsz = sizeof(stackbuf);
+
+	rcu_read_lock();
+	frr_each (zlog_targets, &zlog_targets, zt) {
+		if (prio > zt->prio_min)
+			continue;
+		if (!zt->logfn || !zt->raw)
+			continue;
+
+		zt->logfn(zt, &msg, 1);
+	}
+	rcu_read_unlock();
+
+	va_end(msg->args);
+	if (msg->text && msg->text != stackbuf)
+		XFREE(MTYPE_LOG_MESSAGE, msg->text);
+}
+
 static void vzlog_tls(struct zlog_tls *zlog_tls, const struct xref_logmsg *xref,
 		      int prio, const char *fmt, va_list ap)
 {
 	struct zlog_target *zt;
 	struct zlog_msg *msg;
 	char *buf;
-	bool ignoremsg = true;
+	bool ignoremsg = true, raw = false;
 	bool immediate = default_immediate;
 
 	/* avoid further processing cost if no target wants this message */
@@ -453,11 +485,16 @@ static void vzlog_tls(struct zlog_tls *zlog_tls, const struct xref_logmsg *xref,
 	frr_each (zlog_targets, &zlog_targets, zt) {
 		if (prio > zt->prio_min)
 			continue;
-		ignoremsg = false;
-		break;
+		if (zt->raw)
+			raw = true;
+		else
+			ignoremsg = false;
 	}
 	rcu_read_unlock();
 
+	if (raw)
+		vzlog_raw(xref, prio, fmt, ap);
+
 	if (ignoremsg)
 		return;
 
@@ -608,6 +645,17 @@ int zlog_msg_prio(struct zlog_msg *msg)
 	return msg->prio;
 }
 
+const char *zlog_msg_fmt(struct zlog_msg *msg, va_list *args)
+{
+	va_copy(*args, msg->args);
+	return msg->fmt;
+}
+
+void zlog_msg_timespec(struct zlog_msg *msg, struct timespec *ts)
+{
+	*ts = msg->ts;
+}
+
 const struct xref_logmsg *zlog_msg_xref(struct zlog_msg *msg)
 {
 	return msg->xref;
@@ -843,6 +891,7 @@ struct zlog_target *zlog_target_clone(struct memtype *mt,
 		newzt->prio_min = oldzt->prio_min;
 		newzt->logfn = oldzt->logfn;
 		newzt->logfn_sigsafe = oldzt->logfn_sigsafe;
+		newzt->raw = oldzt->raw;
 	}
 
 	return newzt;
@@ -160,6 +160,12 @@ extern const char *zlog_msg_text(struct zlog_msg *msg, size_t *textlen);
 extern void zlog_msg_args(struct zlog_msg *msg, size_t *hdrlen,
 			  size_t *n_argpos, const struct fmt_outpos **argpos);
 
+/* for raw targets: the format string, and a copy of the arguments in args
+ * that the caller needs to va_end().
+ */
+extern const char *zlog_msg_fmt(struct zlog_msg *msg, va_list *args);
+extern void zlog_msg_timespec(struct zlog_msg *msg, struct timespec *ts);
+
 /* timestamp formatting control flags */
 
 /* sub-second digit count */
@@ -224,6 +230,13 @@ struct zlog_target {
 	void (*logfn_sigsafe)(struct zlog_target *zt, const char *text,
 			      size_t len);
 
+	/* raw targets record the format string & arguments rather than the
+	 * text.  They get each message on its own right away, while the
+	 * arguments are still valid, and the message is not formatted unless
+	 * some other target needs it.
+	 */
+	bool raw;
+
 	struct rcu_head rcu_head;
 };
 
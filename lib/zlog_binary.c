@@ -0,0 +1,612 @@
+/*
+ * Binary zlog target, for decoding offline.
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include "zebra.h"
+
+#include <sys/mman.h>
+
+#include "memory.h"
+#include "frrcu.h"
+#include "frr_pthread.h"
+#include "prefix.h"
+#include "xref.h"
+#include "zlog.h"
+#include "zlog_binary.h"
+
+DEFINE_MTYPE_STATIC(LOG, LOG_BIN, "binary log target");
+DEFINE_MTYPE_STATIC(LOG, LOG_BIN_RING, "binary log ring");
+DEFINE_MTYPE_STATIC(LOG, LOG_BIN_NAME, "binary log filename");
+
+/* File layout, in host byte order.  Keep tools/frr-zlog-decode.py in sync.
+ *
+ * The header is followed by the ring buffer.  head and tail count bytes
+ * since the file was created; the ring holds the records in [tail, head),
+ * at offset (position % size).  Records are padded to 8 bytes and never
+ * wrap around the end of the ring, a len of 0 says the next record is at
+ * the start.
+ */
+#define ZLB_MAGIC "FRRZLB\0\1"
+#define ZLB_ALIGN(x) (((x) + 7) & ~(size_t)7)
+
+struct zlb_file_hdr {
+	char magic[8];
+	uint32_t hdrlen;
+	uint32_t byteorder;
+	uint64_t size;
+
+	uint64_t head;
+	uint64_t tail;
+
+	int64_t pid;
+	int32_t instance;
+	uint32_t resvd;
+	char progname[32];
+};
+
+enum zlb_rec_type {
+	/* uid + arguments */
+	ZLB_REC_ARGS = 1,
+	/* uid (if any) + formatted text, for what can't be decoded */
+	ZLB_REC_TEXT = 2,
+};
+
+struct zlb_rec {
+	/* including this header, before padding */
+	uint32_t len;
+	uint32_t ts_nsec;
+	uint64_t ts_sec;
+	uint8_t type;
+	uint8_t prio;
+	uint16_t resvd;
+	char uid[12];
+};
+
+/* argument tags, followed by:
+ *  'i', 'u', 'p': 8 byte integer
+ *  'f': double
+ *  's': 2 byte length + the string
+ *  'x': 2 extension chars + 2 byte length + the raw bytes (none for NULL)
+ */
+#define ZLB_ARG_INT 'i'
+#define ZLB_ARG_UINT 'u'
+#define ZLB_ARG_PTR 'p'
+#define ZLB_ARG_DBL 'f'
+#define ZLB_ARG_STR 's'
+#define ZLB_ARG_EXT 'x'
+
+#define ZLB_REC_MAX 1024
+
+struct zlb_ring {
+	struct rcu_head rcu_head;
+
+	pthread_mutex_t mtx;
+	struct zlb_file_hdr *hdr;
+	uint8_t *data;
+	size_t size;
+	size_t mapsz;
+};
+
+struct zlt_bin {
+	struct zlog_target zt;
+
+	struct zlb_ring *ring;
+};
+
+struct zlb_buf {
+	uint8_t *pos, *end;
+};
+
+static inline bool zlb_put(struct zlb_buf *zb, const void *data, size_t len)
+{
+	if ((size_t)(zb->end - zb->pos) < len)
+		return false;
+	memcpy(zb->pos, data, len);
+	zb->pos += len;
+	return true;
+}
+
+static bool zlb_put_num(struct zlb_buf *zb, char tag, uint64_t val)
+{
+	return zlb_put(zb, &tag, 1) && zlb_put(zb, &val, sizeof(val));
+}
+
+static bool zlb_put_blob(struct zlb_buf *zb, const void *data, size_t len)
+{
+	uint16_t len16 = len;
+
+	if (len > UINT16_MAX)
+		return false;
+	return zlb_put(zb, &len16, sizeof(len16)) && zlb_put(zb, data, len);
+}
+
+/* printfrr extensions that are recorded as raw bytes, anything else ends up
+ * as a text record.
+ */
+static bool zlb_put_ext(struct zlb_buf *zb, const char *ext, const void *ptr)
+{
+	const struct prefix *p = ptr;
+	uint8_t pfx[2 + sizeof(struct in6_addr)];
+	const void *data = ptr;
+	size_t len;
+
+	if (ext[0] == 'I' && ext[1] == '4')
+		len = sizeof(struct in_addr);
+	else if (ext[0] == 'I' && ext[1] == '6')
+		len = sizeof(struct in6_addr);
+	else if (ext[0] == 'E' && ext[1] == 'A')
+		len = sizeof(struct ethaddr);
+	else if (ext[0] == 'F' && ext[1] == 'X') {
+		if (p && p->family != AF_INET && p->family != AF_INET6)
+			return false;
+
+		len = 0;
+		if (p) {
+			len = p->family == AF_INET ? sizeof(struct in_addr)
+						   : sizeof(struct in6_addr);
+			pfx[0] = p->family == AF_INET ? 4 : 6;
+			pfx[1] = p->prefixlen;
+			memcpy(pfx + 2, &p->u.prefix, len);
+			len += 2;
+			data = pfx;
+		}
+	} else
+		return false;
+
+	/* no bytes for NULL */
+	if (!ptr)
+		len = 0;
+	return zlb_put(zb, "x", 1) && zlb_put(zb, ext, 2)
+	       && zlb_put_blob(zb, data, len);
+}
+
+/* walk the format string the same way printfrr does, and record the
+ * arguments.  Returns false for anything the decoder couldn't reproduce.
+ */
+static bool zlb_put_args(struct zlb_buf *zb, const char *fmt, va_list ap)
+{
+	const char *p = fmt, *s;
+	enum { LEN_INT, LEN_CHAR, LEN_SHORT, LEN_LONG, LEN_LLONG, LEN_INT64,
+	       LEN_SIZE, LEN_MAX, LEN_PTRDIFF } len;
+	uint64_t uval;
+	int64_t ival;
+	double dval;
+	char conv;
+
+	while ((p = strchr(p, '%'))) {
+		p++;
+		if (*p == '%') {
+			p++;
+			continue;
+		}
+
+		p += strspn(p, "#0- +'");
+		if (*p == '*') {
+			if (!zlb_put_num(zb, ZLB_ARG_INT, va_arg(ap, int)))
+				return false;
+			p++;
+		} else
+			while (isdigit((unsigned char)*p))
+				p++;
+		/* positional arguments */
+		if (*p == '$')
+			return false;
+		if (*p == '.') {
+			p++;
+			if (*p == '*') {
+				if (!zlb_put_num(zb, ZLB_ARG_INT,
+						 va_arg(ap, int)))
+					return false;
+				p++;
+			} else
+				while (isdigit((unsigned char)*p))
+					p++;
+		}
+
+		len = LEN_INT;
+		switch (*p) {
+		case 'h':
+			len = (p[1] == 'h') ? LEN_CHAR : LEN_SHORT;
+			p += (p[1] == 'h') ? 2 : 1;
+			break;
+		case 'l':
+			len = (p[1] == 'l') ? LEN_LLONG : LEN_LONG;
+			p += (p[1] == 'l') ? 2 : 1;
+			break;
+		case 'q':
+			len = LEN_LLONG;
+			p++;
+			break;
+		case 'L':
+			/* printfrr: int64_t for integers, long double else */
+			len = LEN_INT64;
+			p++;
+			break;
+		case 'z':
+			len = LEN_SIZE;
+			p++;
+			break;
+		case 'j':
+			len = LEN_MAX;
+			p++;
+			break;
+		case 't':
+			len = LEN_PTRDIFF;
+			p++;
+			break;
+		}
+
+		conv = *p++;
+		switch (conv) {
+		case 'd':
+		case 'i':
+			/* printfrr_exti() extension */
+			if (isupper((unsigned char)*p))
+				return false;
+
+			switch (len) {
+			case LEN_LONG:
+				ival = va_arg(ap, long);
+				break;
+			case LEN_LLONG:
+				ival = va_arg(ap, long long);
+				break;
+			case LEN_INT64:
+				ival = va_arg(ap, int64_t);
+				break;
+			case LEN_SIZE:
+				ival = va_arg(ap, ssize_t);
+				break;
+			case LEN_MAX:
+				ival = va_arg(ap, intmax_t);
+				break;
+			case LEN_PTRDIFF:
+				ival = va_arg(ap, ptrdiff_t);
+				break;
+			case LEN_CHAR:
+				ival = (signed char)va_arg(ap, int);
+				break;
+			case LEN_SHORT:
+				ival = (short)va_arg(ap, int);
+				break;
+			default:
+				ival = va_arg(ap, int);
+				break;
+			}
+			if (!zlb_put_num(zb, ZLB_ARG_INT, ival))
+				return false;
+			break;
+
+		case 'u':
+		case 'o':
+		case 'x':
+		case 'X':
+			switch (len) {
+			case LEN_LONG:
+				uval = va_arg(ap, unsigned long);
+				break;
+			case LEN_LLONG:
+				uval = va_arg(ap, unsigned long long);
+				break;
+			case LEN_INT64:
+				uval = va_arg(ap, uint64_t);
+				break;
+			case LEN_SIZE:
+				uval = va_arg(ap, size_t);
+				break;
+			case LEN_MAX:
+				uval = va_arg(ap, uintmax_t);
+				break;
+			case LEN_PTRDIFF:
+				uval = va_arg(ap, ptrdiff_t);
+				break;
+			case LEN_CHAR:
+				uval = (unsigned char)va_arg(ap, unsigned int);
+				break;
+			case LEN_SHORT:
+				uval = (unsigned short)va_arg(ap, unsigned int);
+				break;
+			default:
+				uval = va_arg(ap, unsigned int);
+				break;
+			}
+			if (!zlb_put_num(zb, ZLB_ARG_UINT, uval))
+				return false;
+			break;
+
+		case 'c':
+			if (len != LEN_INT)
+				return false;
+			if (!zlb_put_num(zb, ZLB_ARG_INT, va_arg(ap, int)))
+				return false;
+			break;
+
+		case 'e':
+		case 'E':
+		case 'f':
+		case 'F':
+		case 'g':
+		case 'G':
+		case 'a':
+		case 'A':
+			if (len == LEN_INT64)
+				dval = va_arg(ap, long double);
+			else
+				dval = va_arg(ap, double);
+			if (!zlb_put(zb, "f", 1)
+			    || !zlb_put(zb, &dval, sizeof(dval)))
+				return false;
+			break;
+
+		case 's':
+			if (len != LEN_INT)
+				return false;
+			s = va_arg(ap, const char *);
+			if (!s)
+				s = "(null)";
+			if (!zlb_put(zb, "s", 1) || !zlb_put_blob(zb, s, strlen(s)))
+				return false;
+			break;
+
+		case 'p':
+			if (isupper((unsigned char)*p)) {
+				if (!zlb_put_ext(zb, p, va_arg(ap, void *)))
+					return false;
+				p += 2;
+				break;
+			}
+			if (!zlb_put_num(zb, ZLB_ARG_PTR,
+					 (uintptr_t)va_arg(ap, void *)))
+				return false;
+			break;
+
+		default:
+			/* %m, %n, wide characters, ... */
+			return false;
+		}
+	}
+	return true;
+}
+
+/* needs ring->mtx */
+static void zlb_ring_make_room(struct zlb_ring *ring, size_t need)
+{
+	struct zlb_file_hdr *hdr = ring->hdr;
+	size_t offs;
+	uint32_t len;
+
+	while (hdr->head + need - hdr->tail > ring->size) {
+		offs = hdr->tail % ring->size;
+		memcpy(&len, ring->data + offs, sizeof(len));
+
+		if (len == 0)
+			hdr->tail += ring->size - offs;
+		else
+			hdr->tail += ZLB_ALIGN(len);
+	}
+}
+
+static void zlb_ring_write(struct zlb_ring *ring, const void *data,
+			   size_t len)
+{
+	struct zlb_file_hdr *hdr = ring->hdr;
+	size_t need = ZLB_ALIGN(len), offs;
+	uint32_t zero = 0;
+
+	frr_with_mutex(&ring->mtx) {
+		offs = hdr->head % ring->size;
+
+		if (offs + need > ring->size) {
+			zlb_ring_make_room(ring, ring->size - offs);
+			memcpy(ring->data + offs, &zero, sizeof(zero));
+			hdr->head += ring->size - offs;
+			offs = 0;
+		}
+
+		zlb_ring_make_room(ring, need);
+		memcpy(ring->data + offs, data, len);
+		hdr->head += need;
+	}
+}
+
+static void zlog_bin(struct zlog_target *zt, struct zlog_msg *msgs[],
+		     size_t nmsgs)
+{
+	struct zlt_bin *zlt = container_of(zt, struct zlt_bin, zt);
+	uint64_t buf[ZLB_REC_MAX / sizeof(uint64_t)];
+	struct zlb_rec *rec = (struct zlb_rec *)buf;
+	const struct xref_logmsg *xref;
+	struct zlb_buf zb;
+	struct timespec ts;
+	const char *fmt, *text;
+	size_t i, textlen, hdrlen;
+	va_list args;
+	bool ok;
+
+	for (i = 0; i < nmsgs; i++) {
+		memset(rec, 0, sizeof(*rec));
+		rec->prio = zlog_msg_prio(msgs[i]);
+		zlog_msg_timespec(msgs[i], &ts);
+		rec->ts_sec = ts.tv_sec;
+		rec->ts_nsec = ts.tv_nsec;
+
+		xref = zlog_msg_xref(msgs[i]);
+		if (xref && xref->xref.xrefdata)
+			memcpy(rec->uid, xref->xref.xrefdata->uid,
+			       sizeof(rec->uid));
+
+		zb.pos = (uint8_t *)(rec + 1);
+		zb.end = (uint8_t *)buf + sizeof(buf);
+
+		/* without an UID, the decoder can't find the format string */
+		if (rec->uid[0]) {
+			fmt = zlog_msg_fmt(msgs[i], &args);
+			ok = zlb_put_args(&zb, fmt, args);
+			va_end(args);
+		} else
+			ok = false;
+
+		if (ok)
+			rec->type = ZLB_REC_ARGS;
+		else {
+			text = zlog_msg_text(msgs[i], &textlen);
+			zlog_msg_args(msgs[i], &hdrlen, NULL, NULL);
+
+			zb.pos = (uint8_t *)(rec + 1);
+			rec->type = ZLB_REC_TEXT;
+			zlb_put(&zb, text + hdrlen,
+				MIN(textlen - hdrlen,
+				    (size_t)(zb.end - zb.pos)));
+		}
+
+		rec->len = zb.pos - (uint8_t *)buf;
+		zlb_ring_write(zlt->ring, rec, rec->len);
+	}
+}
+
+static void zlb_ring_free(struct zlb_ring *ring)
+{
+	munmap(ring->hdr, ring->mapsz);
+	pthread_mutex_destroy(&ring->mtx);
+	XFREE(MTYPE_LOG_BIN_RING, ring);
+}
+
+static struct zlb_ring *zlb_ring_open(const char *filename, size_t size)
+{
+	struct zlb_ring *ring;
+	struct zlb_file_hdr *hdr;
+	char prevname[PATH_MAX];
+	size_t mapsz;
+	void *map;
+	int fd;
+
+	snprintf(prevname, sizeof(prevname), "%s.prev", filename);
+	rename(filename, prevname);
+
+	size = ZLB_ALIGN(size);
+	mapsz = sizeof(*hdr) + size;
+
+	fd = open(filename, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC | O_NOCTTY,
+		  LOGFILE_MASK);
+	if (fd < 0)
+		return NULL;
+	if (ftruncate(fd, mapsz)) {
+		close(fd);
+		return NULL;
+	}
+
+	map = mmap(NULL, mapsz, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (map == MAP_FAILED)
+		return NULL;
+
+	hdr = map;
+	memcpy(hdr->magic, ZLB_MAGIC, sizeof(hdr->magic));
+	hdr->hdrlen = sizeof(*hdr);
+	hdr->byteorder = 0x01020304;
+	hdr->size = size;
+	hdr->pid = getpid();
+	strlcpy(hdr->progname, zlog_progname, sizeof(hdr->progname));
+	hdr->instance = zlog_instance;
+
+	ring = XCALLOC(MTYPE_LOG_BIN_RING, sizeof(*ring));
+	pthread_mutex_init(&ring->mtx, NULL);
+	ring->hdr = hdr;
+	ring->data = (uint8_t *)(hdr + 1);
+	ring->size = size;
+	ring->mapsz = mapsz;
+	return ring;
+}
+
+void zlog_bin_init(struct zlog_cfg_bin *zcb)
+{
+	memset(zcb, 0, sizeof(*zcb));
+	zcb->prio_min = ZLOG_DISABLED;
+	pthread_mutex_init(&zcb->cfg_mtx, NULL);
+}
+
+/* needs zcb->cfg_mtx */
+static void zlog_bin_cycle(struct zlog_cfg_bin *zcb, struct zlb_ring *oldring)
+{
+	struct zlog_target *zt = NULL, *old;
+	struct zlt_bin *zlt;
+
+	if (zcb->prio_min != ZLOG_DISABLED && zcb->ring) {
+		zt = zlog_target_clone(MTYPE_LOG_BIN, zcb->active,
+				       sizeof(*zlt));
+		zlt = container_of(zt, struct zlt_bin, zt);
+
+		zlt->ring = zcb->ring;
+		zlt->zt.prio_min = zcb->prio_min;
+		zlt->zt.logfn = zlog_bin;
+		zlt->zt.logfn_sigsafe = NULL;
+		zlt->zt.raw = true;
+	}
+
+	old = zlog_target_replace(zcb->active, zt);
+	zcb->active = zt;
+
+	if (old)
+		zlog_target_free(MTYPE_LOG_BIN, old);
+	/* after the old target, in RCU order */
+	if (oldring)
+		rcu_call(zlb_ring_free, oldring, rcu_head);
+}
+
+void zlog_bin_fini(struct zlog_cfg_bin *zcb)
+{
+	frr_with_mutex(&zcb->cfg_mtx) {
+		struct zlb_ring *oldring = zcb->ring;
+
+		zcb->ring = NULL;
+		zlog_bin_cycle(zcb, oldring);
+		XFREE(MTYPE_LOG_BIN_NAME, zcb->filename);
+	}
+	pthread_mutex_destroy(&zcb->cfg_mtx);
+}
+
+void zlog_bin_set_other(struct zlog_cfg_bin *zcb)
+{
+	frr_with_mutex(&zcb->cfg_mtx) {
+		zlog_bin_cycle(zcb, NULL);
+	}
+}
+
+bool zlog_bin_set_filename(struct zlog_cfg_bin *zcb, const char *filename,
+			   size_t size)
+{
+	frr_with_mutex(&zcb->cfg_mtx) {
+		struct zlb_ring *oldring = zcb->ring, *ring = NULL;
+
+		if (filename) {
+			ring = zlb_ring_open(filename, size);
+			if (!ring)
+				return false;
+		}
+
+		XFREE(MTYPE_LOG_BIN_NAME, zcb->filename);
+		zcb->filename = filename ? XSTRDUP(MTYPE_LOG_BIN_NAME, filename)
+					 : NULL;
+		zcb->size = size;
+		zcb->ring = ring;
+		zlog_bin_cycle(zcb, oldring);
+		return true;
+	}
+	assert(0);
+	return false;
+}
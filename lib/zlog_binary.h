@@ -0,0 +1,69 @@
+/*
+ * Binary zlog target, for decoding offline.
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _FRR_ZLOG_BINARY_H
+#define _FRR_ZLOG_BINARY_H
+
+#include <pthread.h>
+
+#include "zlog.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * Records the xref UID and the raw arguments of each message, rather than
+ * its text, into a ring in a memory-mapped file.  tools/frr-zlog-decode.py
+ * turns that back into text, using the format strings from frr.xref.  Most
+ * of the cost of debug logging is formatting, so this is cheap enough to
+ * leave on.
+ *
+ * A previous file with the same name is renamed to "<filename>.prev" on
+ * start, so the messages leading up to a crash are kept.
+ */
+struct zlb_ring;
+
+struct zlog_cfg_bin {
+	struct zlog_target *active;
+	struct zlb_ring *ring;
+
+	pthread_mutex_t cfg_mtx;
+
+	/* call zlog_bin_set_other() to apply this */
+	int prio_min;
+
+	/* call zlog_bin_set_filename() to change these */
+	char *filename;
+	size_t size;
+};
+
+extern void zlog_bin_init(struct zlog_cfg_bin *zcb);
+extern void zlog_bin_fini(struct zlog_cfg_bin *zcb);
+
+extern void zlog_bin_set_other(struct zlog_cfg_bin *zcb);
+/* NULL filename to stop logging; size is that of the ring in bytes */
+extern bool zlog_bin_set_filename(struct zlog_cfg_bin *zcb,
+				  const char *filename, size_t size);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _FRR_ZLOG_BINARY_H */
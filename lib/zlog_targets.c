@@ -37,6 +37,8 @@ DEFINE_MTYPE_STATIC(LOG, LOG_FD,        "log file target");
 DEFINE_MTYPE_STATIC(LOG, LOG_FD_NAME,   "log file name");
 DEFINE_MTYPE_STATIC(LOG, LOG_FD_ROTATE, "log file rotate helper");
 DEFINE_MTYPE_STATIC(LOG, LOG_SYSL,      "syslog target");
+DEFINE_MTYPE_STATIC(LOG, LOG_ASYNC_MSG, "log writer message");
+DEFINE_MTYPE_STATIC(LOG, LOG_ASYNC_CLOSE, "log writer close helper");
 
 struct zlt_fd {
 	struct zlog_target zt;
@@ -60,6 +62,336 @@ static const char * const prionames[] = {
 	[LOG_DEBUG] =	"debugging: ",
 };
 
+/* asynchronous writer
+ *
+ * With "log asynchronous", the file (including stdout) and syslog targets
+ * don't write themselves, the text is put on a bounded lockless queue (a
+ * Vyukov MPMC ring, with a single consumer) for a separate pthread to
+ * write.  Logging is then never slowed down by a slow disk or syslog
+ * daemon; if the writer can't keep up, messages are dropped and counted.
+ *
+ * The messages only record the fd, so the targets' fds are closed from the
+ * RCU thread once the writer has caught up with the queue.
+ */
+#define ZLT_ASYNC_QUEUE 4096
+#define ZLT_ASYNC_BATCH 64
+
+struct zlt_async_msg {
+	/* -1 for syslog */
+	int fd;
+	int syslog_prio;
+	size_t len;
+	char text[];
+};
+
+struct zlt_async_cell {
+	atomic_size_t seq;
+	struct zlt_async_msg *msg;
+};
+
+static struct zlt_async_cell zlt_async_queue[ZLT_ASYNC_QUEUE];
+static atomic_size_t zlt_async_enq;
+static size_t zlt_async_deq;
+/* how far the writer is, for zlt_async_drain() */
+static atomic_size_t zlt_async_done;
+
+static struct frr_pthread *zlt_async_pth;
+static atomic_bool zlt_async_on;
+static atomic_bool zlt_async_sleeping;
+static atomic_size_t zlt_async_drops;
+static pthread_mutex_t zlt_async_mtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t zlt_async_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t zlt_async_drained = PTHREAD_COND_INITIALIZER;
+
+static bool zlt_async_push(struct zlt_async_msg *msg)
+{
+	struct zlt_async_cell *cell;
+	size_t pos, seq;
+
+	pos = atomic_load_explicit(&zlt_async_enq, memory_order_relaxed);
+	for (;;) {
+		cell = &zlt_async_queue[pos % ZLT_ASYNC_QUEUE];
+		seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+
+		if (seq == pos) {
+			if (atomic_compare_exchange_weak_explicit(
+				    &zlt_async_enq, &pos, pos + 1,
+				    memory_order_relaxed, memory_order_relaxed))
+				break;
+		} else if ((ssize_t)(seq - pos) < 0)
+			/* full */
+			return false;
+		else
+			pos = atomic_load_explicit(&zlt_async_enq,
+						   memory_order_relaxed);
+	}
+
+	cell->msg = msg;
+	atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+
+	if (atomic_load_explicit(&zlt_async_sleeping, memory_order_seq_cst)) {
+		frr_with_mutex(&zlt_async_mtx) {
+			pthread_cond_signal(&zlt_async_cond);
+		}
+	}
+	return true;
+}
+
+/* only ever called by one pthread at a time */
+static struct zlt_async_msg *zlt_async_pop(void)
+{
+	struct zlt_async_cell *cell;
+	struct zlt_async_msg *msg;
+	size_t pos = zlt_async_deq;
+
+	cell = &zlt_async_queue[pos % ZLT_ASYNC_QUEUE];
+	if (atomic_load_explicit(&cell->seq, memory_order_acquire) != pos + 1)
+		return NULL;
+
+	msg = cell->msg;
+	atomic_store_explicit(&cell->seq, pos + ZLT_ASYNC_QUEUE,
+			      memory_order_release);
+	zlt_async_deq = pos + 1;
+	return msg;
+}
+
+static bool zlt_async_queue_msg(struct zlt_async_msg *msg)
+{
+	if (zlt_async_push(msg))
+		return true;
+
+	atomic_fetch_add_explicit(&zlt_async_drops, 1, memory_order_relaxed);
+	XFREE(MTYPE_LOG_ASYNC_MSG, msg);
+	return true;
+}
+
+/* returns false if the caller should write itself */
+static bool zlt_async_writev(int fd, struct iovec *iov, int iovcnt)
+{
+	struct zlt_async_msg *msg;
+	size_t len = 0;
+	char *pos;
+	int i;
+
+	if (!atomic_load_explicit(&zlt_async_on, memory_order_relaxed))
+		return false;
+
+	for (i = 0; i < iovcnt; i++)
+		len += iov[i].iov_len;
+
+	msg = XMALLOC(MTYPE_LOG_ASYNC_MSG, sizeof(*msg) + len);
+	msg->fd = fd;
+	msg->syslog_prio = 0;
+	msg->len = len;
+	for (pos = msg->text, i = 0; i < iovcnt; i++) {
+		memcpy(pos, iov[i].iov_base, iov[i].iov_len);
+		pos += iov[i].iov_len;
+	}
+	return zlt_async_queue_msg(msg);
+}
+
+static bool zlt_async_syslog(int prio, const char *text, size_t len)
+{
+	struct zlt_async_msg *msg;
+
+	if (!atomic_load_explicit(&zlt_async_on, memory_order_relaxed))
+		return false;
+
+	msg = XMALLOC(MTYPE_LOG_ASYNC_MSG, sizeof(*msg) + len);
+	msg->fd = -1;
+	msg->syslog_prio = prio;
+	msg->len = len;
+	memcpy(msg->text, text, len);
+	return zlt_async_queue_msg(msg);
+}
+
+/* write out what's queued, returns false if there was nothing */
+static bool zlt_async_flush(void)
+{
+	struct zlt_async_msg *msgs[ZLT_ASYNC_BATCH];
+	struct iovec iov[ZLT_ASYNC_BATCH];
+	size_t i, j, n;
+
+	for (n = 0; n < array_size(msgs); n++) {
+		msgs[n] = zlt_async_pop();
+		if (!msgs[n])
+			break;
+	}
+	if (!n)
+		return false;
+
+	/* consecutive messages to the same fd go in one writev() */
+	for (i = 0; i < n; i = j) {
+		if (msgs[i]->fd < 0) {
+			syslog(msgs[i]->syslog_prio, "%.*s",
+			       (int)msgs[i]->len, msgs[i]->text);
+			j = i + 1;
+			continue;
+		}
+
+		for (j = i; j < n && msgs[j]->fd == msgs[i]->fd; j++) {
+			iov[j - i].iov_base = msgs[j]->text;
+			iov[j - i].iov_len = msgs[j]->len;
+		}
+		writev(msgs[i]->fd, iov, j - i);
+	}
+
+	for (i = 0; i < n; i++)
+		XFREE(MTYPE_LOG_ASYNC_MSG, msgs[i]);
+
+	frr_with_mutex(&zlt_async_mtx) {
+		atomic_store_explicit(&zlt_async_done, zlt_async_deq,
+				      memory_order_relaxed);
+		pthread_cond_broadcast(&zlt_async_drained);
+	}
+	return true;
+}
+
+static void *zlt_async_start(void *arg)
+{
+	struct frr_pthread *fpt = arg;
+
+	fpt->master->owner = pthread_self();
+	frr_pthread_set_name(fpt);
+	frr_pthread_notify_running(fpt);
+
+	while (atomic_load_explicit(&fpt->running, memory_order_relaxed)) {
+		if (zlt_async_flush())
+			continue;
+
+		frr_with_mutex(&zlt_async_mtx) {
+			atomic_store_explicit(&zlt_async_sleeping, true,
+					      memory_order_seq_cst);
+			if (atomic_load_explicit(&fpt->running,
+						 memory_order_relaxed)
+			    && atomic_load_explicit(
+				       &zlt_async_queue[zlt_async_deq
+							% ZLT_ASYNC_QUEUE]
+						.seq,
+				       memory_order_seq_cst)
+				       != zlt_async_deq + 1)
+				pthread_cond_wait(&zlt_async_cond,
+						  &zlt_async_mtx);
+			atomic_store_explicit(&zlt_async_sleeping, false,
+					      memory_order_relaxed);
+		}
+	}
+
+	while (zlt_async_flush())
+		;
+	return NULL;
+}
+
+static int zlt_async_stop(struct frr_pthread *fpt, void **result)
+{
+	assert(fpt->running);
+
+	/* new messages are written directly again */
+	atomic_store_explicit(&zlt_async_on, false, memory_order_relaxed);
+	atomic_store_explicit(&fpt->running, false, memory_order_relaxed);
+	frr_with_mutex(&zlt_async_mtx) {
+		pthread_cond_signal(&zlt_async_cond);
+	}
+
+	pthread_join(fpt->thread, result);
+
+	/* anything queued while the writer was finishing */
+	while (zlt_async_flush())
+		;
+	frr_with_mutex(&zlt_async_mtx) {
+		zlt_async_pth = NULL;
+		pthread_cond_broadcast(&zlt_async_drained);
+	}
+	return 0;
+}
+
+/* wait until everything queued so far has been written */
+static void zlt_async_drain(void)
+{
+	size_t target = atomic_load_explicit(&zlt_async_enq,
+					     memory_order_relaxed);
+
+	frr_with_mutex(&zlt_async_mtx) {
+		while (zlt_async_pth
+		       && (ssize_t)(atomic_load_explicit(&zlt_async_done,
+							 memory_order_relaxed)
+				    - target)
+				  < 0)
+			pthread_cond_wait(&zlt_async_drained, &zlt_async_mtx);
+	}
+}
+
+void zlog_async_set(bool enable)
+{
+	struct frr_pthread_attr attr = {
+		.start = zlt_async_start,
+		.stop = zlt_async_stop,
+	};
+	static bool queue_init;
+	struct frr_pthread *fpt;
+	size_t i;
+
+	if (enable == !!zlt_async_pth)
+		return;
+
+	if (!enable) {
+		fpt = zlt_async_pth;
+		frr_pthread_stop(fpt, NULL);
+		frr_pthread_destroy(fpt);
+		return;
+	}
+
+	/* the queue is left empty when the writer stops, no need to redo */
+	if (!queue_init) {
+		for (i = 0; i < ZLT_ASYNC_QUEUE; i++)
+			atomic_store_explicit(&zlt_async_queue[i].seq, i,
+					      memory_order_relaxed);
+		queue_init = true;
+	}
+
+	zlt_async_pth = frr_pthread_new(&attr, "Log writer", "logwriter");
+	frr_pthread_run(zlt_async_pth, NULL);
+	frr_pthread_wait_running(zlt_async_pth);
+	atomic_store_explicit(&zlt_async_on, true, memory_order_relaxed);
+}
+
+bool zlog_async_get(void)
+{
+	return zlt_async_pth != NULL;
+}
+
+size_t zlog_async_dropped(void)
+{
+	return atomic_load_explicit(&zlt_async_drops, memory_order_relaxed);
+}
+
+struct zlt_close_drained {
+	struct rcu_head head;
+	int fd;
+};
+
+static void zlt_close_drained(struct zlt_close_drained *zcd)
+{
+	zlt_async_drain();
+	close(zcd->fd);
+	XFREE(MTYPE_LOG_ASYNC_CLOSE, zcd);
+}
+
+/* rcu_close(), that also waits for the writer to be done with fd */
+static void zlt_close(struct rcu_head_close *head, int fd)
+{
+	struct zlt_close_drained *zcd;
+
+	if (!zlt_async_pth) {
+		rcu_close(head, fd);
+		return;
+	}
+
+	zcd = XCALLOC(MTYPE_LOG_ASYNC_CLOSE, sizeof(*zcd));
+	zcd->fd = fd;
+	rcu_call(zlt_close_drained, zcd, head);
+}
+
 void zlog_fd(struct zlog_target *zt, struct zlog_msg *msgs[], size_t nmsgs)
 {
 	struct zlt_fd *zte = container_of(zt, struct zlt_fd, zt);
@@ -123,7 +455,8 @@ void zlog_fd(struct zlog_target *zt, struct zlog_msg *msgs[], size_t nmsgs)
 		if (iovpos > 0 && (ts_buf + sizeof(ts_buf) - ts_pos < TS_LEN
 				   || i + 1 == nmsgs
 				   || array_size(iov) - iovpos < 5)) {
-			writev(fd, iov, iovpos);
+			if (!zlt_async_writev(fd, iov, iovpos))
+				writev(fd, iov, iovpos);
 
 			iovpos = 0;
 			ts_pos = ts_buf;
@@ -174,7 +507,7 @@ static void zlog_file_target_free(struct zlt_fd *zlt)
 	if (!zlt)
 		return;
 
-	rcu_close(&zlt->head_close, zlt->fd);
+	zlt_close(&zlt->head_close, zlt->fd);
 	rcu_free(MTYPE_LOG_FD, zlt, zt.rcu_head);
 }
 
@@ -299,7 +632,7 @@ bool zlog_file_rotate(struct zlog_cfg_file *zcf)
 	}
 
 	rcr = XCALLOC(MTYPE_LOG_FD_ROTATE, sizeof(*rcr));
-	rcu_close(&rcr->head_close, fd);
+	zlt_close(&rcr->head_close, fd);
 	rcu_free(MTYPE_LOG_FD_ROTATE, rcr, head_self);
 
 	return true;
@@ -445,6 +778,10 @@ static void zlog_syslog(struct zlog_target *zt, struct zlog_msg *msgs[],
 			continue;
 
 		text = zlog_msg_text(msgs[i], &text_len);
+		if (zlt_async_syslog(zlog_msg_prio(msgs[i])
+					     | zte->syslog_facility,
+				     text, text_len))
+			continue;
 		syslog(zlog_msg_prio(msgs[i]) | zte->syslog_facility, "%.*s",
 		       (int)text_len, text);
 	}
@@ -58,6 +58,13 @@ extern bool zlog_file_rotate(struct zlog_cfg_file *zcf);
 extern void zlog_fd(struct zlog_target *zt, struct zlog_msg *msgs[],
 		    size_t nmsgs);
 
+/* hand the writes of the file and syslog targets to a separate pthread,
+ * which drops messages it can't keep up with
+ */
+extern void zlog_async_set(bool enable);
+extern bool zlog_async_get(void);
+extern size_t zlog_async_dropped(void);
+
 /* syslog is always limited to one target */
 
 extern void zlog_syslog_set_facility(int facility);
@@ -13,20 +13,36 @@
 #include "hash.h"
 #include "thread.h"
 #include "jhash.h"
+#include "typesafe.h"
 
 #include "nhrpd.h"
 #include "os.h"
 
 DEFINE_MTYPE_STATIC(NHRPD, NHRP_VC, "NHRP virtual connection");
 
+PREDECL_HASH(childlist);
+
 struct child_sa {
 	uint32_t id;
 	struct nhrp_vc *vc;
-	struct list_head childlist_entry;
+	struct childlist_item childlist_entry;
 };
 
+static int child_sa_cmp(const struct child_sa *a, const struct child_sa *b)
+{
+	return numcmp(a->id, b->id);
+}
+
+static uint32_t child_sa_hash(const struct child_sa *sa)
+{
+	return jhash_1word(sa->id, 0);
+}
+
+DECLARE_HASH(childlist, struct child_sa, childlist_entry, child_sa_cmp,
+	     child_sa_hash);
+
 static struct hash *nhrp_vc_hash;
-static struct list_head childlist_head[512];
+static struct childlist_head childlist_head;
 
 static unsigned int nhrp_vc_key(const void *peer_data)
 {
@@ -100,18 +116,10 @@ static void nhrp_vc_ipsec_reset(struct nhrp_vc *vc)
 
 int nhrp_vc_ipsec_updown(uint32_t child_id, struct nhrp_vc *vc)
 {
-	struct child_sa *sa = NULL, *lsa;
-	uint32_t child_hash = child_id % array_size(childlist_head);
+	struct child_sa *sa, key = {.id = child_id};
 	int abort_migration = 0;
 
-	list_for_each_entry(lsa, &childlist_head[child_hash], childlist_entry)
-	{
-		if (lsa->id == child_id) {
-			sa = lsa;
-			break;
-		}
-	}
-
+	sa = childlist_find(&childlist_head, &key);
 	if (!sa) {
 		if (!vc)
 			return 0;
@@ -120,12 +128,9 @@ int nhrp_vc_ipsec_updown(uint32_t child_id, struct nhrp_vc *vc)
 
 		*sa = (struct child_sa){
 			.id = child_id,
-			.childlist_entry =
-				LIST_INITIALIZER(sa->childlist_entry),
 			.vc = NULL,
 		};
-		list_add_tail(&sa->childlist_entry,
-			      &childlist_head[child_hash]);
+		childlist_add(&childlist_head, sa);
 	}
 
 	if (sa->vc == vc)
@@ -155,7 +160,7 @@ int nhrp_vc_ipsec_updown(uint32_t child_id, struct nhrp_vc *vc)
 	/* Update */
 	sa->vc = vc;
 	if (!vc) {
-		list_del(&sa->childlist_entry);
+		childlist_del(&childlist_head, sa);
 		XFREE(MTYPE_NHRP_VC, sa);
 	}
 
@@ -196,23 +201,16 @@ void nhrp_vc_foreach(void (*cb)(struct nhrp_vc *, void *), void *ctx)
 
 void nhrp_vc_init(void)
 {
-	size_t i;
-
 	nhrp_vc_hash = hash_create(nhrp_vc_key, nhrp_vc_cmp, "NHRP VC hash");
-	for (i = 0; i < array_size(childlist_head); i++)
-		list_init(&childlist_head[i]);
+	childlist_init(&childlist_head);
 }
 
 void nhrp_vc_reset(void)
 {
-	struct child_sa *sa, *n;
-	size_t i;
+	struct child_sa *sa;
 
-	for (i = 0; i < array_size(childlist_head); i++) {
-		list_for_each_entry_safe(sa, n, &childlist_head[i],
-					 childlist_entry)
-			nhrp_vc_ipsec_updown(sa->id, 0);
-	}
+	frr_each_safe (childlist, &childlist_head, sa)
+		nhrp_vc_ipsec_updown(sa->id, 0);
 }
 
 void nhrp_vc_terminate(void)
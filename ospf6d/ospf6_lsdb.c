@@ -23,6 +23,7 @@
 #include "memory.h"
 #include "log.h"
 #include "command.h"
+#include "jhash.h"
 #include "prefix.h"
 #include "table.h"
 #include "vty.h"
@@ -35,6 +36,50 @@
 #include "bitfield.h"
 
 DEFINE_MTYPE_STATIC(OSPF6D, OSPF6_LSDB, "OSPF6 LSA database");
+DEFINE_MTYPE_STATIC(OSPF6D, OSPF6_LSDB_HASH, "OSPF6 LSDB hash entry");
+
+/*
+ * The route table keeps the LSAs ordered for the typed walks and the show
+ * commands; exact lookups go through a hash of its nodes instead of walking
+ * the trie.  There is an entry for every node that holds an LSA.
+ */
+struct ospf6_lsdb_hent {
+	struct ospf6_lsdb_hash_item item;
+	uint16_t type;
+	uint32_t id;
+	uint32_t adv_router;
+	struct route_node *rn;
+};
+
+static int ospf6_lsdb_hent_cmp(const struct ospf6_lsdb_hent *a,
+			       const struct ospf6_lsdb_hent *b)
+{
+	if (a->type != b->type)
+		return numcmp(a->type, b->type);
+	if (a->adv_router != b->adv_router)
+		return numcmp(a->adv_router, b->adv_router);
+	return numcmp(a->id, b->id);
+}
+
+static uint32_t ospf6_lsdb_hent_hash(const struct ospf6_lsdb_hent *a)
+{
+	return jhash_3words(a->type, a->id, a->adv_router, 0);
+}
+
+DECLARE_HASH(ospf6_lsdb_hash, struct ospf6_lsdb_hent, item,
+	     ospf6_lsdb_hent_cmp, ospf6_lsdb_hent_hash);
+
+static struct ospf6_lsdb_hent *ospf6_lsdb_hent_find(struct ospf6_lsdb *lsdb,
+						    uint16_t type, uint32_t id,
+						    uint32_t adv_router)
+{
+	struct ospf6_lsdb_hent ref;
+
+	ref.type = type;
+	ref.id = id;
+	ref.adv_router = adv_router;
+	return ospf6_lsdb_hash_find(&lsdb->hash, &ref);
+}
 
 struct ospf6_lsdb *ospf6_lsdb_create(void *data)
 {
@@ -45,6 +90,7 @@ struct ospf6_lsdb *ospf6_lsdb_create(void *data)
 
 	lsdb->data = data;
 	lsdb->table = route_table_init();
+	ospf6_lsdb_hash_init(&lsdb->hash);
 	return lsdb;
 }
 
@@ -53,6 +99,7 @@ void ospf6_lsdb_delete(struct ospf6_lsdb *lsdb)
 	if (lsdb != NULL) {
 		ospf6_lsdb_remove_all(lsdb);
 		route_table_finish(lsdb->table);
+		ospf6_lsdb_hash_fini(&lsdb->hash);
 		XFREE(MTYPE_OSPF6_LSDB, lsdb);
 	}
 }
@@ -95,16 +142,33 @@ void ospf6_lsdb_add(struct ospf6_lsa *lsa, struct ospf6_lsdb *lsdb)
 {
 	struct prefix_ipv6 key;
 	struct route_node *current;
+	struct ospf6_lsdb_hent *hent;
 	struct ospf6_lsa *old = NULL;
 
-	memset(&key, 0, sizeof(key));
-	ospf6_lsdb_set_key(&key, &lsa->header->type, sizeof(lsa->header->type));
-	ospf6_lsdb_set_key(&key, &lsa->header->adv_router,
-			   sizeof(lsa->header->adv_router));
-	ospf6_lsdb_set_key(&key, &lsa->header->id, sizeof(lsa->header->id));
-
-	current = route_node_get(lsdb->table, (struct prefix *)&key);
-	old = current->info;
+	hent = ospf6_lsdb_hent_find(lsdb, lsa->header->type, lsa->header->id,
+				    lsa->header->adv_router);
+	if (hent) {
+		current = hent->rn;
+		old = current->info;
+	} else {
+		memset(&key, 0, sizeof(key));
+		ospf6_lsdb_set_key(&key, &lsa->header->type,
+				   sizeof(lsa->header->type));
+		ospf6_lsdb_set_key(&key, &lsa->header->adv_router,
+				   sizeof(lsa->header->adv_router));
+		ospf6_lsdb_set_key(&key, &lsa->header->id,
+				   sizeof(lsa->header->id));
+
+		current = route_node_get(lsdb->table, (struct prefix *)&key);
+		assert(!current->info);
+
+		hent = XCALLOC(MTYPE_OSPF6_LSDB_HASH, sizeof(*hent));
+		hent->type = lsa->header->type;
+		hent->id = lsa->header->id;
+		hent->adv_router = lsa->header->adv_router;
+		hent->rn = current;
+		ospf6_lsdb_hash_add(&lsdb->hash, hent);
+	}
 	current->info = lsa;
 	lsa->rn = current;
 	ospf6_lsa_lock(lsa);
@@ -136,8 +200,6 @@ void ospf6_lsdb_add(struct ospf6_lsa *lsa, struct ospf6_lsdb *lsdb)
 					(*lsdb->hook_add)(lsa);
 			}
 		}
-		/* to free the lookup lock in node get*/
-		route_unlock_node(current);
 		ospf6_lsa_unlock(old);
 	}
 
@@ -147,16 +209,14 @@ void ospf6_lsdb_add(struct ospf6_lsa *lsa, struct ospf6_lsdb *lsdb)
 void ospf6_lsdb_remove(struct ospf6_lsa *lsa, struct ospf6_lsdb *lsdb)
 {
 	struct route_node *node;
-	struct prefix_ipv6 key;
+	struct ospf6_lsdb_hent *hent;
 
-	memset(&key, 0, sizeof(key));
-	ospf6_lsdb_set_key(&key, &lsa->header->type, sizeof(lsa->header->type));
-	ospf6_lsdb_set_key(&key, &lsa->header->adv_router,
-			   sizeof(lsa->header->adv_router));
-	ospf6_lsdb_set_key(&key, &lsa->header->id, sizeof(lsa->header->id));
-
-	node = route_node_lookup(lsdb->table, (struct prefix *)&key);
-	assert(node && node->info == lsa);
+	hent = ospf6_lsdb_hent_find(lsdb, lsa->header->type, lsa->header->id,
+				    lsa->header->adv_router);
+	assert(hent && hent->rn->info == lsa);
+	node = hent->rn;
+	ospf6_lsdb_hash_del(&lsdb->hash, hent);
+	XFREE(MTYPE_OSPF6_LSDB_HASH, hent);
 
 	node->info = NULL;
 	lsdb->count--;
@@ -164,7 +224,6 @@ void ospf6_lsdb_remove(struct ospf6_lsa *lsa, struct ospf6_lsdb *lsdb)
 	if (lsdb->hook_remove)
 		(*lsdb->hook_remove)(lsa);
 
-	route_unlock_node(node); /* to free the lookup lock */
 	route_unlock_node(node); /* to free the original lock */
 	ospf6_lsa_unlock(lsa);
 
@@ -175,23 +234,16 @@ struct ospf6_lsa *ospf6_lsdb_lookup(uint16_t type, uint32_t id,
 				    uint32_t adv_router,
 				    struct ospf6_lsdb *lsdb)
 {
-	struct route_node *node;
-	struct prefix_ipv6 key;
+	struct ospf6_lsdb_hent *hent;
 
 	if (lsdb == NULL)
 		return NULL;
 
-	memset(&key, 0, sizeof(key));
-	ospf6_lsdb_set_key(&key, &type, sizeof(type));
-	ospf6_lsdb_set_key(&key, &adv_router, sizeof(adv_router));
-	ospf6_lsdb_set_key(&key, &id, sizeof(id));
-
-	node = route_node_lookup(lsdb->table, (struct prefix *)&key);
-	if (node == NULL || node->info == NULL)
+	hent = ospf6_lsdb_hent_find(lsdb, type, id, adv_router);
+	if (hent == NULL)
 		return NULL;
 
-	route_unlock_node(node);
-	return (struct ospf6_lsa *)node->info;
+	return (struct ospf6_lsa *)hent->rn->info;
 }
 
 struct ospf6_lsa *ospf6_lsdb_lookup_next(uint16_t type, uint32_t id,
@@ -23,11 +23,16 @@
 
 #include "prefix.h"
 #include "table.h"
+#include "typesafe.h"
 #include "ospf6_route.h"
 
+PREDECL_HASH(ospf6_lsdb_hash);
+
 struct ospf6_lsdb {
 	void *data; /* data structure that holds this lsdb */
 	struct route_table *table;
+	/* (type, adv router, id) -> node of table, for exact lookups */
+	struct ospf6_lsdb_hash_head hash;
 	uint32_t count;
 	void (*hook_add)(struct ospf6_lsa *);
 	void (*hook_remove)(struct ospf6_lsa *);
@@ -112,10 +112,8 @@ static void __attribute__((noreturn)) ospf6_exit(int status)
 
 	vrf_terminate();
 
-	if (zclient) {
-		zclient_stop(zclient);
-		zclient_free(zclient);
-	}
+	if (zclient)
+		ospf6_zebra_terminate();
 
 	frr_fini();
 	exit(status);
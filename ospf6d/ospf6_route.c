@@ -701,6 +701,7 @@ struct ospf6_route *ospf6_route_add(struct ospf6_route *route,
 		route->next = old->next;
 
 		route->installed = old->installed;
+		route->zebra_digest = old->zebra_digest;
 		route->changed = now;
 		assert(route->table == NULL);
 		route->table = table;
@@ -747,6 +748,8 @@ struct ospf6_route *ospf6_route_add(struct ospf6_route *route,
 			node->info = route;
 			UNSET_FLAG(next->flag, OSPF6_ROUTE_BEST);
 			SET_FLAG(route->flag, OSPF6_ROUTE_BEST);
+			route->zebra_digest = next->zebra_digest;
+			next->zebra_digest = 0;
 			if (IS_OSPF6_DEBUG_ROUTE(MEMORY))
 				zlog_debug(
 					"%s %p: route add %p cost %u: replacing previous best: %p cost %u",
@@ -161,6 +161,10 @@ struct ospf6_route {
 
 	/* nexthop */
 	struct list *nh_list;
+
+	/* Digest of what zebra got for the prefix last, 0 for nothing.  Kept
+	 * on the best route, see ospf6_zebra_route_update(). */
+	uint64_t zebra_digest;
 };
 
 #define OSPF6_DEST_TYPE_NONE       0
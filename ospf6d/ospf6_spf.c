@@ -39,6 +39,7 @@
 #include "ospf6_abr.h"
 #include "ospf6_asbr.h"
 #include "ospf6_spf.h"
+#include "ospf6_spf_pool.h"
 #include "ospf6_intra.h"
 #include "ospf6_interface.h"
 #include "ospf6d.h"
@@ -589,13 +590,79 @@ static void ospf6_spf_log_database(struct ospf6_area *oa)
 	zlog_debug("%s", buffer);
 }
 
+static void ospf6_spf_area_start(struct ospf6 *ospf6, struct ospf6_area *oa)
+{
+	monotime(&oa->ts_spf);
+	if (IS_OSPF6_DEBUG_SPF(PROCESS)) {
+		if (oa == ospf6->backbone)
+			zlog_debug("SPF calculation for Backbone area %s",
+				   oa->name);
+		else
+			zlog_debug("SPF calculation for Area %s", oa->name);
+	}
+	if (IS_OSPF6_DEBUG_SPF(DATABASE))
+		ospf6_spf_log_database(oa);
+}
+
+/* Intra-area and border router routes from the area's SPF result. */
+static void ospf6_spf_area_routes(struct ospf6_area *oa)
+{
+	ospf6_intra_route_calculation(oa);
+	ospf6_intra_brouter_calculation(oa);
+}
+
+struct ospf6_spf_batch {
+	uint32_t router_id;
+	struct ospf6_area **areas;
+	unsigned int count;
+	atomic_uint next;
+};
+
+static void ospf6_spf_batch_work(void *arg, unsigned int shard)
+{
+	struct ospf6_spf_batch *batch = arg;
+	struct ospf6_area *oa;
+	unsigned int i;
+
+	while ((i = atomic_fetch_add_explicit(&batch->next, 1,
+					      memory_order_relaxed))
+	       < batch->count) {
+		oa = batch->areas[i];
+		ospf6_spf_calculation(batch->router_id, oa->spf_table, oa);
+	}
+}
+
+/*
+ * Run the SPF of each area on the SPF worker pthreads.  An area's SPF only
+ * reads its own LSDBs (area and interfaces) and writes its spf_table and
+ * temporary router-LSAs, so the areas don't share anything but read-only
+ * state while the main pthread waits.  Everything feeding the global tables
+ * is left to the caller.
+ */
+static void ospf6_spf_batch_run(struct ospf6 *ospf6, struct ospf6_area **areas,
+				unsigned int count)
+{
+	struct ospf6_spf_batch batch = {
+		.router_id = ospf6->router_id,
+		.areas = areas,
+		.count = count,
+	};
+
+	if (IS_OSPF6_DEBUG_SPF(PROCESS))
+		zlog_debug("SPF calculation for %u areas on %u worker threads",
+			   count, ospf6_spf_pool_size());
+
+	ospf6_spf_pool_run(ospf6_spf_batch_work, &batch);
+}
+
 static int ospf6_spf_calculation_thread(struct thread *t)
 {
 	struct ospf6_area *oa;
+	struct ospf6_area **areas;
 	struct ospf6 *ospf6;
 	struct timeval start, end, runtime;
 	struct listnode *node;
-	int areas_processed = 0;
+	unsigned int i, count = 0;
 	char rbuf[32];
 
 	ospf6 = (struct ospf6 *)THREAD_ARG(t);
@@ -608,39 +675,36 @@ static int ospf6_spf_calculation_thread(struct thread *t)
 	if (ospf6_check_and_set_router_abr(ospf6))
 		ospf6_abr_range_reset_cost(ospf6);
 
-	for (ALL_LIST_ELEMENTS_RO(ospf6->area_list, node, oa)) {
-
-		if (oa == ospf6->backbone)
-			continue;
-
-		monotime(&oa->ts_spf);
-		if (IS_OSPF6_DEBUG_SPF(PROCESS))
-			zlog_debug("SPF calculation for Area %s", oa->name);
-		if (IS_OSPF6_DEBUG_SPF(DATABASE))
-			ospf6_spf_log_database(oa);
-
-		ospf6_spf_calculation(ospf6->router_id, oa->spf_table, oa);
-		ospf6_intra_route_calculation(oa);
-		ospf6_intra_brouter_calculation(oa);
-
-		areas_processed++;
+	/* the non-backbone areas first, then the backbone */
+	areas = XCALLOC(MTYPE_TMP,
+			(listcount(ospf6->area_list) + 1) * sizeof(*areas));
+	for (ALL_LIST_ELEMENTS_RO(ospf6->area_list, node, oa))
+		if (oa != ospf6->backbone)
+			areas[count++] = oa;
+	if (ospf6->backbone)
+		areas[count++] = ospf6->backbone;
+
+	if (count > 1 && ospf6->spf_threads && ospf6_spf_pool_size()) {
+		/*
+		 * The SPFs run in parallel, the routes derived from them are
+		 * merged in the same order as when running serially.
+		 */
+		for (i = 0; i < count; i++)
+			ospf6_spf_area_start(ospf6, areas[i]);
+		ospf6_spf_batch_run(ospf6, areas, count);
+		for (i = 0; i < count; i++)
+			ospf6_spf_area_routes(areas[i]);
+	} else {
+		for (i = 0; i < count; i++) {
+			oa = areas[i];
+			ospf6_spf_area_start(ospf6, oa);
+			ospf6_spf_calculation(ospf6->router_id, oa->spf_table,
+					      oa);
+			ospf6_spf_area_routes(oa);
+		}
 	}
 
-	if (ospf6->backbone) {
-		monotime(&ospf6->backbone->ts_spf);
-		if (IS_OSPF6_DEBUG_SPF(PROCESS))
-			zlog_debug("SPF calculation for Backbone area %s",
-				   ospf6->backbone->name);
-		if (IS_OSPF6_DEBUG_SPF(DATABASE))
-			ospf6_spf_log_database(ospf6->backbone);
-
-		ospf6_spf_calculation(ospf6->router_id,
-				      ospf6->backbone->spf_table,
-				      ospf6->backbone);
-		ospf6_intra_route_calculation(ospf6->backbone);
-		ospf6_intra_brouter_calculation(ospf6->backbone);
-		areas_processed++;
-	}
+	XFREE(MTYPE_TMP, areas);
 
 	/* External LSA calculation */
 	ospf6_ase_calculate_timer_add(ospf6);
@@ -657,8 +721,8 @@ static int ospf6_spf_calculation_thread(struct thread *t)
 
 	if (IS_OSPF6_DEBUG_SPF(PROCESS) || IS_OSPF6_DEBUG_SPF(TIME))
 		zlog_debug(
-			"SPF processing: # Areas: %d, SPF runtime: %lld sec %lld usec, Reason: %s",
-			areas_processed, (long long)runtime.tv_sec,
+			"SPF processing: # Areas: %u, SPF runtime: %lld sec %lld usec, Reason: %s",
+			count, (long long)runtime.tv_sec,
 			(long long)runtime.tv_usec, rbuf);
 
 	ospf6->last_spf_reason = ospf6->spf_reason;
@@ -875,6 +939,40 @@ DEFUN (no_debug_ospf6_spf_database,
 	return CMD_SUCCESS;
 }
 
+static int ospf6_spf_threads_set(struct vty *vty, unsigned int nthreads)
+{
+	VTY_DECLVAR_CONTEXT(ospf6, ospf);
+
+	ospf->spf_threads = nthreads;
+	ospf6_spf_pool_update();
+
+	return CMD_SUCCESS;
+}
+
+DEFUN (ospf6_spf_threads,
+       ospf6_spf_threads_cmd,
+       "spf threads (1-64)",
+       "SPF configuration\n"
+       "Run the per-area SPFs on worker threads\n"
+       "Number of worker threads\n")
+{
+	int idx_number = 2;
+
+	return ospf6_spf_threads_set(
+		vty, strtoul(argv[idx_number]->arg, NULL, 10));
+}
+
+DEFUN (no_ospf6_spf_threads,
+       no_ospf6_spf_threads_cmd,
+       "no spf threads [(1-64)]",
+       NO_STR
+       "SPF configuration\n"
+       "Run the per-area SPFs on worker threads\n"
+       "Number of worker threads\n")
+{
+	return ospf6_spf_threads_set(vty, 0);
+}
+
 static int ospf6_timers_spf_set(struct vty *vty, unsigned int delay,
 				unsigned int hold, unsigned int max)
 {
@@ -946,6 +1044,8 @@ void ospf6_spf_config_write(struct vty *vty, struct ospf6 *ospf6)
 		vty_out(vty, " timers throttle spf %d %d %d\n",
 			ospf6->spf_delay, ospf6->spf_holdtime,
 			ospf6->spf_max_holdtime);
+	if (ospf6->spf_threads)
+		vty_out(vty, " spf threads %u\n", ospf6->spf_threads);
 }
 
 void install_element_ospf6_debug_spf(void)
@@ -968,6 +1068,8 @@ void ospf6_spf_init(void)
 {
 	install_element(OSPF6_NODE, &ospf6_timers_throttle_spf_cmd);
 	install_element(OSPF6_NODE, &no_ospf6_timers_throttle_spf_cmd);
+	install_element(OSPF6_NODE, &ospf6_spf_threads_cmd);
+	install_element(OSPF6_NODE, &no_ospf6_spf_threads_cmd);
 }
 
 /* Create Aggregated Large Router-LSA from multiple Link-State IDs
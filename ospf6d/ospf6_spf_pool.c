@@ -0,0 +1,143 @@
+/*
+ * OSPFv3 SPF worker pool.
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+#include <pthread.h>
+
+#include "frr_pthread.h"
+#include "linklist.h"
+#include "memory.h"
+#include "thread.h"
+
+#include "ospf6d.h"
+#include "ospf6_top.h"
+#include "ospf6_spf_pool.h"
+
+DEFINE_MTYPE_STATIC(OSPF6D, OSPF6_SPF_POOL, "OSPF6 SPF worker pool");
+
+struct ospf6_spf_shard {
+	void (*fn)(void *arg, unsigned int shard);
+	void *arg;
+	unsigned int shard;
+};
+
+/* only touched by the main pthread */
+static struct frr_pthread **pool;
+static struct ospf6_spf_shard *shards;
+static unsigned int pool_size;
+
+/* number of shards still running on the workers */
+static pthread_mutex_t pool_mtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pool_cond = PTHREAD_COND_INITIALIZER;
+static unsigned int pool_pending;
+
+static int ospf6_spf_pool_work(struct thread *thread)
+{
+	struct ospf6_spf_shard *shard = THREAD_ARG(thread);
+
+	shard->fn(shard->arg, shard->shard);
+
+	frr_with_mutex(&pool_mtx) {
+		if (--pool_pending == 0)
+			pthread_cond_signal(&pool_cond);
+	}
+	return 0;
+}
+
+void ospf6_spf_pool_run(void (*fn)(void *arg, unsigned int shard), void *arg)
+{
+	unsigned int i;
+
+	frr_with_mutex(&pool_mtx) {
+		pool_pending = pool_size;
+	}
+
+	for (i = 0; i < pool_size; i++) {
+		shards[i].fn = fn;
+		shards[i].arg = arg;
+		shards[i].shard = i;
+		thread_add_event(pool[i]->master, ospf6_spf_pool_work,
+				 &shards[i], 0, NULL);
+	}
+
+	fn(arg, pool_size);
+
+	frr_with_mutex(&pool_mtx) {
+		while (pool_pending)
+			pthread_cond_wait(&pool_cond, &pool_mtx);
+	}
+}
+
+unsigned int ospf6_spf_pool_size(void)
+{
+	return pool_size;
+}
+
+static void ospf6_spf_pool_set(unsigned int nthreads)
+{
+	struct frr_pthread_attr attr = {
+		.start = frr_pthread_attr_default.start,
+		.stop = frr_pthread_attr_default.stop,
+	};
+	char name[32], os_name[OS_THREAD_NAMELEN];
+	unsigned int i;
+
+	if (nthreads > OSPF6_SPF_THREADS_MAX)
+		nthreads = OSPF6_SPF_THREADS_MAX;
+	if (nthreads == pool_size)
+		return;
+
+	/* the workers carry no state, so resizing is just rebuilding */
+	for (i = 0; i < pool_size; i++) {
+		frr_pthread_stop(pool[i], NULL);
+		frr_pthread_destroy(pool[i]);
+	}
+	XFREE(MTYPE_OSPF6_SPF_POOL, pool);
+	XFREE(MTYPE_OSPF6_SPF_POOL, shards);
+	pool_size = 0;
+
+	if (!nthreads)
+		return;
+
+	pool = XCALLOC(MTYPE_OSPF6_SPF_POOL, nthreads * sizeof(*pool));
+	shards = XCALLOC(MTYPE_OSPF6_SPF_POOL, nthreads * sizeof(*shards));
+
+	for (i = 0; i < nthreads; i++) {
+		snprintf(name, sizeof(name), "OSPF6 SPF thread %u", i);
+		snprintf(os_name, sizeof(os_name), "ospf6d_spf%u", i);
+		pool[i] = frr_pthread_new(&attr, name, os_name);
+		frr_pthread_run(pool[i], NULL);
+	}
+	for (i = 0; i < nthreads; i++)
+		frr_pthread_wait_running(pool[i]);
+
+	pool_size = nthreads;
+}
+
+void ospf6_spf_pool_update(void)
+{
+	struct ospf6 *ospf6;
+	struct listnode *node;
+	unsigned int nthreads = 0;
+
+	for (ALL_LIST_ELEMENTS_RO(om6->ospf6, node, ospf6))
+		nthreads = MAX(nthreads, ospf6->spf_threads);
+
+	ospf6_spf_pool_set(nthreads);
+}
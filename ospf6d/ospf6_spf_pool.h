@@ -0,0 +1,44 @@
+/*
+ * OSPFv3 SPF worker pool.
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef OSPF6_SPF_POOL_H
+#define OSPF6_SPF_POOL_H
+
+#define OSPF6_SPF_THREADS_MAX 64
+
+/*
+ * Resizes the pool to the largest number of SPF worker pthreads configured
+ * in any instance (see ospf6->spf_threads).  Main pthread only, after that
+ * setting changed or an instance was deleted.
+ */
+extern void ospf6_spf_pool_update(void);
+
+/* Number of worker pthreads currently running. */
+extern unsigned int ospf6_spf_pool_size(void);
+
+/*
+ * Runs fn once for each shard in [0, ospf6_spf_pool_size()], the last one on
+ * the calling pthread and the others on the workers, and returns once all of
+ * them completed.  The main pthread doesn't touch the LSDBs while it waits in
+ * here, so fn sees them as they were when this was called.
+ */
+extern void ospf6_spf_pool_run(void (*fn)(void *arg, unsigned int shard),
+			       void *arg);
+
+#endif /* OSPF6_SPF_POOL_H */
@@ -50,6 +50,7 @@
 #include "ospf6_abr.h"
 #include "ospf6_intra.h"
 #include "ospf6_spf.h"
+#include "ospf6_spf_pool.h"
 #include "ospf6d.h"
 #include "lib/json.h"
 #include "ospf6_nssa.h"
@@ -469,6 +470,7 @@ void ospf6_delete(struct ospf6 *o)
 	ospf6_flush_self_originated_lsas_now(o);
 	ospf6_disable(o);
 	ospf6_del(o);
+	ospf6_spf_pool_update();
 
 	ospf6_zebra_vrf_deregister(o);
 
@@ -118,6 +118,7 @@ struct ospf6 {
 	unsigned int
 		spf_hold_multiplier; /* Adaptive multiplier for hold time */
 	unsigned int spf_reason;     /* reason bits while scheduling SPF */
+	unsigned int spf_threads;    /* SPF worker pthreads, 0 for none */
 
 	struct timeval ts_spf;		/* SPF calculation time stamp. */
 	struct timeval ts_spf_duration; /* Execution time of last SPF */
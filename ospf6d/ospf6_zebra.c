@@ -26,9 +26,11 @@
 #include "prefix.h"
 #include "stream.h"
 #include "zclient.h"
+#include "zclient_nhg.h"
 #include "memory.h"
 #include "lib/bfd.h"
 #include "lib_errors.h"
+#include "jhash.h"
 
 #include "ospf6_proto.h"
 #include "ospf6_top.h"
@@ -49,6 +51,15 @@ unsigned char conf_debug_ospf6_zebra = 0;
 /* information about zebra. */
 struct zclient *zclient = NULL;
 
+/* The nexthop groups the routes are sent with */
+static struct zclient_nhg_cache *nhg_cache;
+
+/* for "show ipv6 ospf6 zebra" */
+static struct {
+	uint32_t sent;
+	uint32_t unchanged;
+} route_stats;
+
 void ospf6_zebra_vrf_register(struct ospf6 *ospf6)
 {
 	if (!zclient || zclient->sock < 0 || !ospf6)
@@ -282,6 +293,9 @@ DEFUN(show_zebra,
 						zebra_route_string(i)));
 		}
 		json_object_object_add(json_zebra, "redistribute", json_array);
+		json_object_int_add(json_zebra, "routesSent", route_stats.sent);
+		json_object_int_add(json_zebra, "routesUnchanged",
+				    route_stats.unchanged);
 		json_object_object_add(json, "zebraInformation", json_zebra);
 
 		vty_out(vty, "%s\n",
@@ -300,12 +314,45 @@ DEFUN(show_zebra,
 				vty_out(vty, " %s", zebra_route_string(i));
 		}
 		vty_out(vty, "\n");
+		vty_out(vty, "  route updates: %u sent, %u unchanged\n",
+			route_stats.sent, route_stats.unchanged);
 	}
 	return CMD_SUCCESS;
 }
 
 #define ADD    0
 #define REM    1
+/*
+ * What zebra would be told about a route, to tell whether it changed since:
+ * the SPF runs and LSA updates hand over every route they touch, most of
+ * them the same as before.
+ */
+static uint64_t ospf6_zebra_route_digest(const struct zapi_route *api)
+{
+	uint32_t a, b;
+
+	/* api was zeroed before it was filled, padding included */
+	a = jhash(api, offsetof(struct zapi_route, nexthops), 0x5eed);
+	a = jhash(api->nexthops, api->nexthop_num * sizeof(api->nexthops[0]),
+		  a);
+	a = jhash_3words(api->metric, api->tag, api->distance, a);
+	b = jhash(api, offsetof(struct zapi_route, nexthops), 0x0f5f);
+	b = jhash(api->nexthops, api->nexthop_num * sizeof(api->nexthops[0]),
+		  b);
+	b = jhash_3words(api->metric, api->tag, api->distance, b);
+
+	return ((uint64_t)a << 32 | b) ?: 1;
+}
+
+/* Blackholes are sent right away, after the adds before them */
+static void ospf6_zebra_route_flush_now(void)
+{
+	if (zclient_route_bulk_flush(zclient) == ZCLIENT_SEND_FAILURE)
+		flog_err(EC_LIB_ZAPI_SOCKET,
+			 "zclient_route_bulk_flush() failed: %s",
+			 safe_strerror(errno));
+}
+
 static void ospf6_zebra_route_update(int type, struct ospf6_route *request,
 				     struct ospf6 *ospf6)
 {
@@ -313,6 +360,7 @@ static void ospf6_zebra_route_update(int type, struct ospf6_route *request,
 	int nhcount;
 	int ret = 0;
 	struct prefix *dest;
+	uint64_t digest;
 
 	if (IS_OSPF6_DEBUG_ZEBRA(SEND))
 		zlog_debug("Zebra Send %s route: %pFX",
@@ -340,6 +388,8 @@ static void ospf6_zebra_route_update(int type, struct ospf6_route *request,
 			zlog_debug(
 				"  Best-path removal resulted Secondary addition");
 		type = ADD;
+		request->next->zebra_digest = request->zebra_digest;
+		request->zebra_digest = 0;
 		request = request->next;
 	}
 
@@ -388,10 +438,22 @@ static void ospf6_zebra_route_update(int type, struct ospf6_route *request,
 	api.distance = ospf6_distance_apply((struct prefix_ipv6 *)dest, request,
 					    ospf6);
 
-	if (type == REM)
-		ret = zclient_route_send(ZEBRA_ROUTE_DELETE, zclient, &api);
-	else
-		ret = zclient_route_send(ZEBRA_ROUTE_ADD, zclient, &api);
+	if (type == REM) {
+		request->zebra_digest = 0;
+		ret = zclient_nhg_route_delete(nhg_cache, &api);
+	} else {
+		digest = ospf6_zebra_route_digest(&api);
+		if (digest == request->zebra_digest) {
+			if (IS_OSPF6_DEBUG_ZEBRA(SEND))
+				zlog_debug("  Unchanged, not sent");
+			route_stats.unchanged++;
+			return;
+		}
+		request->zebra_digest = digest;
+
+		ret = zclient_nhg_route_add(nhg_cache, &api);
+	}
+	route_stats.sent++;
 
 	if (ret == ZCLIENT_SEND_FAILURE)
 		flog_err(EC_LIB_ZAPI_SOCKET,
@@ -427,6 +489,7 @@ void ospf6_zebra_add_discard(struct ospf6_route *request, struct ospf6 *ospf6)
 		api.prefix = *dest;
 		zapi_route_set_blackhole(&api, BLACKHOLE_NULL);
 
+		ospf6_zebra_route_flush_now();
 		zclient_route_send(ZEBRA_ROUTE_ADD, zclient, &api);
 
 		if (IS_OSPF6_DEBUG_ZEBRA(SEND))
@@ -455,6 +518,7 @@ void ospf6_zebra_delete_discard(struct ospf6_route *request,
 		api.prefix = *dest;
 		zapi_route_set_blackhole(&api, BLACKHOLE_NULL);
 
+		ospf6_zebra_route_flush_now();
 		zclient_route_send(ZEBRA_ROUTE_DELETE, zclient, &api);
 
 		if (IS_OSPF6_DEBUG_ZEBRA(SEND))
@@ -600,12 +664,39 @@ uint8_t ospf6_distance_apply(struct prefix_ipv6 *p, struct ospf6_route * or,
 
 static void ospf6_zebra_connected(struct zclient *zclient)
 {
+	struct listnode *node;
+	struct ospf6 *ospf6;
+	struct ospf6_route *route;
+
+	/* A new zebra has none of the routes */
+	for (ALL_LIST_ELEMENTS_RO(om6->ospf6, node, ospf6))
+		for (route = ospf6_route_head(ospf6->route_table); route;
+		     route = ospf6_route_next(route))
+			route->zebra_digest = 0;
+	zclient_nhg_cache_replay(nhg_cache);
+
 	/* Send the client registration */
 	bfd_client_sendmsg(zclient, ZEBRA_BFD_CLIENT_REGISTER, VRF_DEFAULT);
 
 	zclient_send_reg_requests(zclient, VRF_DEFAULT);
 }
 
+static int ospf6_zebra_nhg_notify_owner(ZAPI_CALLBACK_ARGS)
+{
+	enum zapi_nhg_notify_owner note;
+	uint32_t id;
+
+	if (!zapi_nhg_notify_decode(zclient->ibuf, &id, &note))
+		return -1;
+
+	if (IS_OSPF6_DEBUG_ZEBRA(RECV))
+		zlog_debug("Zebra Rcv nexthop group %u %s", id,
+			   zapi_nhg_notify_owner2str(note));
+
+	zclient_nhg_cache_notify(nhg_cache, id, note);
+	return 0;
+}
+
 void ospf6_zebra_init(struct thread_master *master)
 {
 	/* Allocate zebra structure. */
@@ -618,11 +709,21 @@ void ospf6_zebra_init(struct thread_master *master)
 		ospf6_zebra_if_address_update_delete;
 	zclient->redistribute_route_add = ospf6_zebra_read_route;
 	zclient->redistribute_route_del = ospf6_zebra_read_route;
+	zclient->nhg_notify_owner = ospf6_zebra_nhg_notify_owner;
+	nhg_cache = zclient_nhg_cache_new(zclient);
 
 	/* Install command element for zebra node. */
 	install_element(VIEW_NODE, &show_ospf6_zebra_cmd);
 }
 
+void ospf6_zebra_terminate(void)
+{
+	zclient_nhg_cache_free(&nhg_cache);
+	zclient_stop(zclient);
+	zclient_free(zclient);
+	zclient = NULL;
+}
+
 /* Debug */
 
 DEFUN (debug_ospf6_zebra_sendrecv,
@@ -423,6 +423,40 @@ out:
 	return rc;
 }
 
+/*
+ * Synchronous request to get a snapshot of the LSDB in batches, and
+ * possibly (OSPF_API_SYNC_SUBSCRIBE) the changes to it after that.
+ * Unlike with ospf_apiclient_sync_lsdb(), no change can get lost in
+ * between.
+ */
+int ospf_apiclient_sync_lsdb_batch(struct ospf_apiclient *oclient,
+				   uint16_t typemask, uint8_t num_areas,
+				   struct in_addr *areas, uint8_t flags,
+				   void (*sync_done)(void))
+{
+	struct {
+		struct lsa_filter_type filter;
+		struct in_addr areas[UINT8_MAX];
+	} buf;
+	struct msg *msg;
+
+	buf.filter.typemask = typemask;
+	buf.filter.origin = ANY_ORIGIN;
+	buf.filter.num_areas = num_areas;
+	if (num_areas)
+		memcpy(buf.areas, areas, num_areas * sizeof(struct in_addr));
+
+	oclient->sync_done = sync_done;
+
+	msg = new_msg_sync_lsdb_batch(ospf_apiclient_get_seqnr(), flags,
+				      &buf.filter);
+	if (!msg) {
+		fprintf(stderr, "new_msg_sync_lsdb_batch failed\n");
+		return -1;
+	}
+	return ospf_apiclient_send_request(oclient, msg);
+}
+
 /*
  * Synchronous request to originate or update an LSA.
  */
@@ -633,6 +667,51 @@ static void ospf_apiclient_handle_lsa_delete(struct ospf_apiclient *oclient,
 	XFREE(MTYPE_OSPF_APICLIENT, p);
 }
 
+static void ospf_apiclient_handle_lsa_batch(struct ospf_apiclient *oclient,
+					    struct msg *msg)
+{
+	struct msg_lsa_batch_notify *bn;
+	struct msg_lsa_batch_record *rec;
+	size_t pos, len, reclen;
+	uint16_t count, lsalen;
+
+	bn = (struct msg_lsa_batch_notify *)STREAM_DATA(msg->s);
+	len = ntohs(msg->hdr.msglen);
+	if (len < sizeof(*bn))
+		return;
+
+	pos = sizeof(*bn);
+	for (count = ntohs(bn->count); count; count--) {
+		rec = (struct msg_lsa_batch_record *)(STREAM_DATA(msg->s) + pos);
+		if (pos + sizeof(*rec) > len)
+			break;
+		lsalen = ntohs(rec->notify.data.length);
+		reclen = offsetof(struct msg_lsa_batch_record, notify.data)
+			 + lsalen;
+		if (lsalen < sizeof(struct lsa_header) || pos + reclen > len)
+			break;
+		pos += (reclen + 3) & ~(size_t)3;
+
+		/* the LSA is aligned within the message, no copy needed */
+		if (rec->msgtype == MSG_LSA_UPDATE_NOTIFY && oclient->update_notify)
+			(oclient->update_notify)(
+				rec->notify.ifaddr, rec->notify.area_id,
+				rec->notify.is_self_originated,
+				&rec->notify.data);
+		else if (rec->msgtype == MSG_LSA_DELETE_NOTIFY
+			 && oclient->delete_notify)
+			(oclient->delete_notify)(
+				rec->notify.ifaddr, rec->notify.area_id,
+				rec->notify.is_self_originated,
+				&rec->notify.data);
+	}
+	if (count)
+		fprintf(stderr, "%s: truncated LSA batch\n", __func__);
+
+	if ((bn->flags & OSPF_API_BATCH_SNAPSHOT_END) && oclient->sync_done)
+		(oclient->sync_done)();
+}
+
 static void ospf_apiclient_msghandle(struct ospf_apiclient *oclient,
 				     struct msg *msg)
 {
@@ -659,6 +738,9 @@ static void ospf_apiclient_msghandle(struct ospf_apiclient *oclient,
 	case MSG_LSA_DELETE_NOTIFY:
 		ospf_apiclient_handle_lsa_delete(oclient, msg);
 		break;
+	case MSG_LSA_BATCH_NOTIFY:
+		ospf_apiclient_handle_lsa_batch(oclient, msg);
+		break;
 	default:
 		fprintf(stderr,
 			"ospf_apiclient_read: Unknown message type: %d\n",
@@ -42,6 +42,7 @@ struct ospf_apiclient {
 			      uint8_t self_origin, struct lsa_header *lsa);
 	void (*delete_notify)(struct in_addr ifaddr, struct in_addr area_id,
 			      uint8_t self_origin, struct lsa_header *lsa);
+	void (*sync_done)(void);
 };
 
 
@@ -83,6 +84,16 @@ void ospf_apiclient_register_callback(
 /* Synchronous request to synchronize LSDB. */
 int ospf_apiclient_sync_lsdb(struct ospf_apiclient *oclient);
 
+/* Synchronous request to synchronize the LSAs selected by 'typemask' (as in
+   struct lsa_filter_type) in 'areas' (all if num_areas is 0), with the LSDB
+   sent in batches.  'flags' are OSPF_API_SYNC_*.  The LSAs go to the update
+   callback as usual, then 'sync_done' (if given) is called once all of the
+   snapshot is in. */
+int ospf_apiclient_sync_lsdb_batch(struct ospf_apiclient *oclient,
+				   uint16_t typemask, uint8_t num_areas,
+				   struct in_addr *areas, uint8_t flags,
+				   void (*sync_done)(void));
+
 /* Synchronous request to originate or update opaque LSA. */
 int ospf_apiclient_lsa_originate(struct ospf_apiclient *oclient,
 				 struct in_addr ifaddr, struct in_addr area_id,
@@ -153,6 +153,9 @@ const char *ospf_api_typename(int msgtype)
 		{
 			MSG_DELETE_REQUEST, "Delete request",
 		},
+		{
+			MSG_SYNC_LSDB_BATCH, "Sync LSDB batched",
+		},
 		{
 			MSG_REPLY, "Reply",
 		},
@@ -177,6 +180,9 @@ const char *ospf_api_typename(int msgtype)
 		{
 			MSG_NSM_CHANGE, "NSM change",
 		},
+		{
+			MSG_LSA_BATCH_NOTIFY, "LSA batch notify",
+		},
 	};
 
 	int i, n = array_size(NameTab);
@@ -357,7 +363,7 @@ struct msg *msg_read(int fd)
 {
 	struct msg *msg;
 	struct apimsghdr hdr;
-	uint8_t buf[OSPF_API_MAX_MSG_SIZE];
+	uint8_t buf[OSPF_API_MAX_BATCH_SIZE]; /* > OSPF_API_MAX_MSG_SIZE */
 	ssize_t bodylen;
 	ssize_t rlen;
 
@@ -383,7 +389,9 @@ struct msg *msg_read(int fd)
 
 	/* Determine body length. */
 	bodylen = ntohs(hdr.msglen);
-	if (bodylen > (ssize_t)sizeof(buf)) {
+	if (bodylen > (ssize_t)(hdr.msgtype == MSG_LSA_BATCH_NOTIFY
+					? sizeof(buf)
+					: OSPF_API_MAX_MSG_SIZE)) {
 		zlog_warn("%s: Body Length of message greater than what we can read",
 			  __func__);
 		return NULL;
@@ -412,7 +420,7 @@ struct msg *msg_read(int fd)
 
 int msg_write(int fd, struct msg *msg)
 {
-	uint8_t buf[OSPF_API_MAX_MSG_SIZE];
+	uint8_t buf[sizeof(struct apimsghdr) + OSPF_API_MAX_BATCH_SIZE];
 	uint16_t l;
 	int wlen;
 
@@ -421,7 +429,9 @@ int msg_write(int fd, struct msg *msg)
 
 	/* Length of OSPF LSA payload */
 	l = ntohs(msg->hdr.msglen);
-	if (l > OSPF_MAX_LSA_SIZE) {
+	if (l > (msg->hdr.msgtype == MSG_LSA_BATCH_NOTIFY
+			 ? OSPF_API_MAX_BATCH_SIZE
+			 : OSPF_MAX_LSA_SIZE)) {
 		zlog_warn("%s: wrong LSA size %d", __func__, l);
 		return -1;
 	}
@@ -501,6 +511,29 @@ struct msg *new_msg_sync_lsdb(uint32_t seqnum, struct lsa_filter_type *filter)
 	return msg_new(MSG_SYNC_LSDB, smsg, seqnum, len);
 }
 
+struct msg *new_msg_sync_lsdb_batch(uint32_t seqnum, uint8_t flags,
+				    struct lsa_filter_type *filter)
+{
+	uint8_t buf[OSPF_API_MAX_MSG_SIZE];
+	struct msg_sync_lsdb_batch *smsg;
+	unsigned int len, areas_len;
+
+	areas_len = filter->num_areas * sizeof(struct in_addr);
+	len = sizeof(struct msg_sync_lsdb_batch) + areas_len;
+	if (len > sizeof(buf))
+		return NULL;
+
+	smsg = (struct msg_sync_lsdb_batch *)buf;
+	smsg->flags = flags;
+	memset(&smsg->pad, 0, sizeof(smsg->pad));
+	smsg->filter.typemask = htons(filter->typemask);
+	smsg->filter.origin = filter->origin;
+	smsg->filter.num_areas = filter->num_areas;
+	memcpy(&smsg->filter + 1, filter + 1, areas_len);
+
+	return msg_new(MSG_SYNC_LSDB_BATCH, smsg, seqnum, len);
+}
+
 
 struct msg *new_msg_originate_request(uint32_t seqnum, struct in_addr ifaddr,
 				      struct in_addr area_id,
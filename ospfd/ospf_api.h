@@ -112,6 +112,7 @@ extern void msg_fifo_free(struct msg_fifo *fifo);
 #define MSG_SYNC_LSDB             4
 #define MSG_ORIGINATE_REQUEST     5
 #define MSG_DELETE_REQUEST        6
+#define MSG_SYNC_LSDB_BATCH       7
 
 /* Messages from OSPF daemon. */
 #define MSG_REPLY                10
@@ -122,6 +123,7 @@ extern void msg_fifo_free(struct msg_fifo *fifo);
 #define MSG_DEL_IF               15
 #define MSG_ISM_CHANGE           16
 #define MSG_NSM_CHANGE           17
+#define MSG_LSA_BATCH_NOTIFY     18
 
 struct msg_register_opaque_type {
 	uint8_t lsatype;
@@ -164,6 +166,20 @@ struct msg_sync_lsdb {
 	struct lsa_filter_type filter;
 };
 
+/* Like MSG_SYNC_LSDB, but the LSDB snapshot comes in MSG_LSA_BATCH_NOTIFY
+ * messages.  With OSPF_API_SYNC_SUBSCRIBE the filter also replaces the
+ * client's event filter (as MSG_REGISTER_EVENT), effective right after the
+ * snapshot, so the changes that follow it are exactly the deltas to it.
+ * With OSPF_API_SYNC_BATCH_DELTAS those changes are batched too.
+ */
+struct msg_sync_lsdb_batch {
+	uint8_t flags;
+#define OSPF_API_SYNC_SUBSCRIBE    0x01
+#define OSPF_API_SYNC_BATCH_DELTAS 0x02
+	uint8_t pad[3];
+	struct lsa_filter_type filter; /* must be last, areas follow */
+};
+
 struct msg_originate_request {
 	/* Used for LSA type 9 otherwise ignored */
 	struct in_addr ifaddr;
@@ -223,6 +239,30 @@ struct msg_lsa_change_notify {
 	struct lsa_header data;
 };
 
+/* A run of LSA update/delete notifies, in one message.  'count' records
+ * follow, each padded to four octets.  Batches of a MSG_SYNC_LSDB_BATCH
+ * snapshot are flagged, the last one (possibly with no records) with
+ * OSPF_API_BATCH_SNAPSHOT_END as well.
+ */
+struct msg_lsa_batch_notify {
+	uint16_t count;
+	uint8_t flags;
+#define OSPF_API_BATCH_SNAPSHOT     0x01
+#define OSPF_API_BATCH_SNAPSHOT_END 0x02
+	uint8_t pad;
+};
+
+struct msg_lsa_batch_record {
+	uint8_t msgtype; /* MSG_LSA_UPDATE_NOTIFY or MSG_LSA_DELETE_NOTIFY */
+	uint8_t pad[3];
+	struct msg_lsa_change_notify notify;
+};
+
+/* Body size limit of MSG_LSA_BATCH_NOTIFY, other messages stay within
+ * OSPF_API_MAX_MSG_SIZE.
+ */
+#define OSPF_API_MAX_BATCH_SIZE 32768U
+
 struct msg_new_if {
 	struct in_addr ifaddr;  /* interface IP address */
 	struct in_addr area_id; /* area this interface belongs to */
@@ -285,6 +325,9 @@ extern struct msg *new_msg_register_event(uint32_t seqnum,
 					  struct lsa_filter_type *filter);
 extern struct msg *new_msg_sync_lsdb(uint32_t seqnum,
 				     struct lsa_filter_type *filter);
+/* 'filter' is followed by its num_areas area IDs */
+extern struct msg *new_msg_sync_lsdb_batch(uint32_t seqnum, uint8_t flags,
+					   struct lsa_filter_type *filter);
 extern struct msg *new_msg_originate_request(uint32_t seqnum,
 					     struct in_addr ifaddr,
 					     struct in_addr area_id,
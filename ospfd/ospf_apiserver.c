@@ -72,6 +72,18 @@
 /* List of all active connections. */
 struct list *apiserver_list;
 
+/* Active connections by the LSA types their event filter selects, so LSA
+ * changes only go over the clients interested in them.
+ */
+static struct list *apiserver_by_type[array_size(Power2)];
+
+struct apiserver_batch {
+	uint8_t flags;
+	uint16_t count;
+	size_t len;
+	uint8_t buf[OSPF_API_MAX_BATCH_SIZE];
+};
+
 /* -----------------------------------------------------------
  * Functions to lookup interfaces
  * -----------------------------------------------------------
@@ -127,6 +139,7 @@ unsigned short ospf_apiserver_getport(void)
 /* Initialize OSPF API module. Invoked from ospf_opaque_init() */
 int ospf_apiserver_init(void)
 {
+	unsigned int i;
 	int fd;
 	int rc = -1;
 
@@ -141,6 +154,8 @@ int ospf_apiserver_init(void)
 
 	/* Initialize list that keeps track of all connections. */
 	apiserver_list = list_new();
+	for (i = 1; i < array_size(apiserver_by_type); i++)
+		apiserver_by_type[i] = list_new();
 
 	/* Register opaque-independent call back functions. These functions
 	   are invoked on ISM, NSM changes and LSA update and LSA deletes */
@@ -168,6 +183,7 @@ out:
 void ospf_apiserver_term(void)
 {
 	struct ospf_apiserver *apiserv;
+	unsigned int i;
 
 	/* Unregister wildcard [0/0] type */
 	ospf_delete_opaque_functab(0 /* all LSAs */, 0 /* all opaque types */);
@@ -183,6 +199,9 @@ void ospf_apiserver_term(void)
 	/* Free client list itself */
 	if (apiserver_list)
 		list_delete(&apiserver_list);
+	for (i = 1; i < array_size(apiserver_by_type); i++)
+		if (apiserver_by_type[i])
+			list_delete(&apiserver_by_type[i]);
 
 	/* Free wildcard list */
 	/* XXX  */
@@ -240,6 +259,21 @@ static int ospf_apiserver_del_lsa_hook(struct ospf_lsa *lsa)
 	return 0;
 }
 
+/* Put apiserv on the apiserver_by_type lists its (new) filter selects. */
+static void apiserver_filter_index(struct ospf_apiserver *apiserv)
+{
+	uint16_t mask = apiserv->filter ? ntohs(apiserv->filter->typemask) : 0;
+	unsigned int i;
+
+	for (i = 1; i < array_size(apiserver_by_type); i++) {
+		if (!apiserver_by_type[i])
+			continue;
+		listnode_delete(apiserver_by_type[i], apiserv);
+		if (mask & Power2[i])
+			listnode_add(apiserver_by_type[i], apiserv);
+	}
+}
+
 /* Allocate new connection structure. */
 struct ospf_apiserver *ospf_apiserver_new(int fd_sync, int fd_async)
 {
@@ -270,6 +304,9 @@ struct ospf_apiserver *ospf_apiserver_new(int fd_sync, int fd_async)
 #endif /* USE_ASYNC_READ */
 	new->t_sync_write = NULL;
 	new->t_async_write = NULL;
+	new->t_batch_flush = NULL;
+	new->batch = NULL;
+	new->batch_deltas = false;
 
 	new->filter->typemask = 0; /* filter all LSAs */
 	new->filter->origin = ANY_ORIGIN;
@@ -323,6 +360,12 @@ void ospf_apiserver_free(struct ospf_apiserver *apiserv)
 #endif /* USE_ASYNC_READ */
 	thread_cancel(&apiserv->t_sync_write);
 	thread_cancel(&apiserv->t_async_write);
+	thread_cancel(&apiserv->t_batch_flush);
+
+	/* No more LSA change notifies for this one. */
+	XFREE(MTYPE_OSPF_APISERVER_MSGFILTER, apiserv->filter);
+	apiserver_filter_index(apiserv);
+	XFREE(MTYPE_OSPF_APISERVER, apiserv->batch);
 
 	/* Unregister all opaque types that application registered
 	   and flush opaque LSAs if still in LSDB. */
@@ -736,6 +779,7 @@ static int ospf_apiserver_send_msg(struct ospf_apiserver *apiserv,
 	case MSG_DEL_IF:
 	case MSG_ISM_CHANGE:
 	case MSG_NSM_CHANGE:
+	case MSG_LSA_BATCH_NOTIFY:
 		fifo = apiserv->out_async_fifo;
 		fd = apiserv->fd_async;
 		event = OSPF_APISERVER_ASYNC_WRITE;
@@ -803,6 +847,9 @@ int ospf_apiserver_handle_msg(struct ospf_apiserver *apiserv, struct msg *msg)
 	case MSG_SYNC_LSDB:
 		rc = ospf_apiserver_handle_sync_lsdb(apiserv, msg);
 		break;
+	case MSG_SYNC_LSDB_BATCH:
+		rc = ospf_apiserver_handle_sync_lsdb_batch(apiserv, msg);
+		break;
 	case MSG_ORIGINATE_REQUEST:
 		rc = ospf_apiserver_handle_originate_request(apiserv, msg);
 		break;
@@ -1176,6 +1223,7 @@ int ospf_apiserver_handle_register_event(struct ospf_apiserver *apiserv,
 		rc = OSPF_API_OK;
 	} else
 		rc = OSPF_API_NOMEMORY;
+	apiserver_filter_index(apiserv);
 
 	/* Send a reply back to client with return code */
 	rc = ospf_apiserver_send_reply(apiserv, seqnum, rc);
@@ -1250,17 +1298,15 @@ out:
 	return rc;
 }
 
-int ospf_apiserver_handle_sync_lsdb(struct ospf_apiserver *apiserv,
-				    struct msg *msg)
+/* Call 'callback' for the LSAs in the LSDB selected by type and area in
+ * 'filter' (origin is up to 'callback').
+ */
+static void apiserver_lsdb_walk(struct lsa_filter_type *filter,
+				int (*callback)(struct ospf_lsa *lsa,
+						void *p_arg, int int_arg),
+				void *p_arg, int int_arg)
 {
 	struct listnode *node, *nnode;
-	uint32_t seqnum;
-	int rc = 0;
-	struct msg_sync_lsdb *smsg;
-	struct ospf_apiserver_param_t {
-		struct ospf_apiserver *apiserv;
-		struct lsa_filter_type *filter;
-	} param;
 	uint16_t mask;
 	struct route_node *rn;
 	struct ospf_lsa *lsa;
@@ -1268,18 +1314,11 @@ int ospf_apiserver_handle_sync_lsdb(struct ospf_apiserver *apiserv,
 	struct ospf_area *area;
 
 	ospf = ospf_lookup_by_vrf_id(VRF_DEFAULT);
-
-	/* Get request sequence number */
-	seqnum = msg_get_seq(msg);
-	/* Set sync msg. */
-	smsg = (struct msg_sync_lsdb *)STREAM_DATA(msg->s);
-
-	/* Set parameter struct. */
-	param.apiserv = apiserv;
-	param.filter = &smsg->filter;
+	if (!ospf)
+		return;
 
 	/* Remember mask. */
-	mask = ntohs(smsg->filter.typemask);
+	mask = ntohs(filter->typemask);
 
 	/* Iterate over all areas. */
 	for (ALL_LIST_ELEMENTS(ospf->areas, node, nnode, area)) {
@@ -1287,10 +1326,10 @@ int ospf_apiserver_handle_sync_lsdb(struct ospf_apiserver *apiserv,
 		uint32_t *area_id = NULL;
 
 		/* Compare area_id with area_ids in sync request. */
-		if ((i = smsg->filter.num_areas) > 0) {
+		if ((i = filter->num_areas) > 0) {
 			/* Let area_id point to the list of area IDs,
-			 * which is at the end of smsg->filter. */
-			area_id = (uint32_t *)(&smsg->filter + 1);
+			 * which is at the end of filter. */
+			area_id = (uint32_t *)(filter + 1);
 			while (i) {
 				if (*area_id == area->area_id.s_addr) {
 					break;
@@ -1307,28 +1346,22 @@ int ospf_apiserver_handle_sync_lsdb(struct ospf_apiserver *apiserv,
 			/* Check msg type. */
 			if (mask & Power2[OSPF_ROUTER_LSA])
 				LSDB_LOOP (ROUTER_LSDB(area), rn, lsa)
-					apiserver_sync_callback(
-						lsa, (void *)&param, seqnum);
+					callback(lsa, p_arg, int_arg);
 			if (mask & Power2[OSPF_NETWORK_LSA])
 				LSDB_LOOP (NETWORK_LSDB(area), rn, lsa)
-					apiserver_sync_callback(
-						lsa, (void *)&param, seqnum);
+					callback(lsa, p_arg, int_arg);
 			if (mask & Power2[OSPF_SUMMARY_LSA])
 				LSDB_LOOP (SUMMARY_LSDB(area), rn, lsa)
-					apiserver_sync_callback(
-						lsa, (void *)&param, seqnum);
+					callback(lsa, p_arg, int_arg);
 			if (mask & Power2[OSPF_ASBR_SUMMARY_LSA])
 				LSDB_LOOP (ASBR_SUMMARY_LSDB(area), rn, lsa)
-					apiserver_sync_callback(
-						lsa, (void *)&param, seqnum);
+					callback(lsa, p_arg, int_arg);
 			if (mask & Power2[OSPF_OPAQUE_LINK_LSA])
 				LSDB_LOOP (OPAQUE_LINK_LSDB(area), rn, lsa)
-					apiserver_sync_callback(
-						lsa, (void *)&param, seqnum);
+					callback(lsa, p_arg, int_arg);
 			if (mask & Power2[OSPF_OPAQUE_AREA_LSA])
 				LSDB_LOOP (OPAQUE_AREA_LSDB(area), rn, lsa)
-					apiserver_sync_callback(
-						lsa, (void *)&param, seqnum);
+					callback(lsa, p_arg, int_arg);
 		}
 	}
 
@@ -1336,23 +1369,177 @@ int ospf_apiserver_handle_sync_lsdb(struct ospf_apiserver *apiserv,
 	if (ospf->lsdb) {
 		if (mask & Power2[OSPF_AS_EXTERNAL_LSA])
 			LSDB_LOOP (EXTERNAL_LSDB(ospf), rn, lsa)
-				apiserver_sync_callback(lsa, (void *)&param,
-							seqnum);
+				callback(lsa, p_arg, int_arg);
 	}
 
 	/* For AS-external opaque LSAs */
 	if (ospf->lsdb) {
 		if (mask & Power2[OSPF_OPAQUE_AS_LSA])
 			LSDB_LOOP (OPAQUE_AS_LSDB(ospf), rn, lsa)
-				apiserver_sync_callback(lsa, (void *)&param,
-							seqnum);
+				callback(lsa, p_arg, int_arg);
 	}
+}
+
+int ospf_apiserver_handle_sync_lsdb(struct ospf_apiserver *apiserv,
+				    struct msg *msg)
+{
+	uint32_t seqnum;
+	int rc = 0;
+	struct msg_sync_lsdb *smsg;
+	struct ospf_apiserver_param_t {
+		struct ospf_apiserver *apiserv;
+		struct lsa_filter_type *filter;
+	} param;
+
+	/* Get request sequence number */
+	seqnum = msg_get_seq(msg);
+	/* Set sync msg. */
+	smsg = (struct msg_sync_lsdb *)STREAM_DATA(msg->s);
+
+	/* Set parameter struct. */
+	param.apiserv = apiserv;
+	param.filter = &smsg->filter;
+
+	apiserver_lsdb_walk(&smsg->filter, apiserver_sync_callback,
+			    (void *)&param, seqnum);
 
 	/* Send a reply back to client with return code */
 	rc = ospf_apiserver_send_reply(apiserv, seqnum, rc);
 	return rc;
 }
 
+/* Send what is collected in apiserv->batch. */
+static void apiserver_batch_flush(struct ospf_apiserver *apiserv,
+				  uint8_t flags)
+{
+	struct apiserver_batch *batch = apiserv->batch;
+	struct msg_lsa_batch_notify *bmsg;
+	struct msg *msg;
+
+	if (!batch || (!batch->count && !flags))
+		return;
+
+	bmsg = (struct msg_lsa_batch_notify *)batch->buf;
+	bmsg->count = htons(batch->count);
+	bmsg->flags = batch->flags | flags;
+	bmsg->pad = 0;
+
+	msg = msg_new(MSG_LSA_BATCH_NOTIFY, batch->buf, 0, batch->len);
+	if (msg) {
+		ospf_apiserver_send_msg(apiserv, msg);
+		msg_free(msg);
+	} else
+		zlog_warn("%s: msg_new failed", __func__);
+
+	batch->flags = 0;
+	batch->count = 0;
+	batch->len = sizeof(struct msg_lsa_batch_notify);
+}
+
+static int apiserver_batch_flush_event(struct thread *thread)
+{
+	struct ospf_apiserver *apiserv = THREAD_ARG(thread);
+
+	apiserver_batch_flush(apiserv, 0);
+	return 0;
+}
+
+/* Add a notify for 'lsa' to apiserv->batch, sending it first if the notify
+ * doesn't fit or the batch was for something else ('flags').
+ */
+static void apiserver_batch_add(struct ospf_apiserver *apiserv,
+				uint8_t msgtype, struct ospf_lsa *lsa,
+				uint8_t flags)
+{
+	struct apiserver_batch *batch = apiserv->batch;
+	struct msg_lsa_batch_record *rec;
+	size_t lsalen, reclen;
+
+	if (!batch) {
+		batch = XCALLOC(MTYPE_OSPF_APISERVER, sizeof(*batch));
+		batch->len = sizeof(struct msg_lsa_batch_notify);
+		apiserv->batch = batch;
+	}
+
+	lsalen = MIN(ntohs(lsa->data->length), OSPF_MAX_LSA_SIZE);
+	reclen = offsetof(struct msg_lsa_batch_record, notify.data) + lsalen;
+	reclen = (reclen + 3) & ~(size_t)3;
+
+	if (batch->count
+	    && (batch->flags != flags || batch->len + reclen > sizeof(batch->buf)))
+		apiserver_batch_flush(apiserv, 0);
+	batch->flags = flags;
+
+	rec = (struct msg_lsa_batch_record *)(batch->buf + batch->len);
+	memset(rec, 0, reclen);
+	rec->msgtype = msgtype;
+	if (lsa->area)
+		rec->notify.area_id = lsa->area->area_id;
+	if (lsa->data->type == OSPF_OPAQUE_LINK_LSA)
+		rec->notify.ifaddr = lsa->oi->address->u.prefix4;
+	rec->notify.is_self_originated = lsa->flags & OSPF_LSA_SELF;
+	memcpy(&rec->notify.data, lsa->data, lsalen);
+
+	batch->len += reclen;
+	batch->count++;
+}
+
+static int apiserver_sync_batch_callback(struct ospf_lsa *lsa, void *p_arg,
+					 int int_arg)
+{
+	struct ospf_apiserver *apiserv = p_arg;
+	uint8_t origin = int_arg;
+
+	if ((origin == ANY_ORIGIN) || (origin == (lsa->flags & OSPF_LSA_SELF)))
+		apiserver_batch_add(apiserv, MSG_LSA_UPDATE_NOTIFY, lsa,
+				    OSPF_API_BATCH_SNAPSHOT);
+	return 0;
+}
+
+int ospf_apiserver_handle_sync_lsdb_batch(struct ospf_apiserver *apiserv,
+					  struct msg *msg)
+{
+	struct msg_sync_lsdb_batch *smsg;
+	uint32_t seqnum;
+	size_t size;
+	int rc = OSPF_API_OK;
+
+	seqnum = msg_get_seq(msg);
+	smsg = (struct msg_sync_lsdb_batch *)STREAM_DATA(msg->s);
+
+	size = ntohs(msg->hdr.msglen);
+	if (size < sizeof(*smsg)
+	    || size < sizeof(*smsg)
+				+ smsg->filter.num_areas * sizeof(uint32_t)) {
+		rc = OSPF_API_ERROR;
+		goto out;
+	}
+	size -= offsetof(struct msg_sync_lsdb_batch, filter);
+
+	/* Changes from before the snapshot go out first. */
+	apiserver_batch_flush(apiserv, 0);
+
+	apiserver_lsdb_walk(&smsg->filter, apiserver_sync_batch_callback,
+			    apiserv, smsg->filter.origin);
+	apiserver_batch_flush(apiserv, OSPF_API_BATCH_SNAPSHOT
+						| OSPF_API_BATCH_SNAPSHOT_END);
+
+	/* Nothing can change in between, so the client sees the deltas to
+	 * the snapshot from here on.
+	 */
+	if (smsg->flags & OSPF_API_SYNC_SUBSCRIBE) {
+		XFREE(MTYPE_OSPF_APISERVER_MSGFILTER, apiserv->filter);
+		apiserv->filter = XMALLOC(MTYPE_OSPF_APISERVER_MSGFILTER, size);
+		memcpy(apiserv->filter, &smsg->filter, size);
+		apiserv->batch_deltas =
+			!!(smsg->flags & OSPF_API_SYNC_BATCH_DELTAS);
+		apiserver_filter_index(apiserv);
+	}
+
+out:
+	return ospf_apiserver_send_reply(apiserv, seqnum, rc);
+}
+
 
 /* -----------------------------------------------------------
  * Followings are functions to originate or update LSA
@@ -2342,7 +2529,7 @@ void ospf_apiserver_clients_notify_nsm_change(struct ospf_neighbor *nbr)
 static void apiserver_clients_lsa_change_notify(uint8_t msgtype,
 						struct ospf_lsa *lsa)
 {
-	struct msg *msg;
+	struct msg *msg = NULL;
 	struct listnode *node, *nnode;
 	struct ospf_apiserver *apiserv;
 
@@ -2352,6 +2539,10 @@ static void apiserver_clients_lsa_change_notify(uint8_t msgtype,
 	/* Default interface for non Opaque9 LSAs */
 	struct in_addr ifaddr = {.s_addr = 0L};
 
+	if (lsa->data->type >= array_size(apiserver_by_type)
+	    || !apiserver_by_type[lsa->data->type])
+		return;
+
 	if (lsa->area) {
 		area_id = lsa->area->area_id;
 	}
@@ -2360,21 +2551,12 @@ static void apiserver_clients_lsa_change_notify(uint8_t msgtype,
 		ifaddr = lsa->oi->address->u.prefix4;
 	}
 
-	/* Prepare message that can be sent to clients that have a matching
-	   filter */
-	msg = new_msg_lsa_change_notify(msgtype, 0L, /* no sequence number */
-					ifaddr, area_id,
-					lsa->flags & OSPF_LSA_SELF, lsa->data);
-	if (!msg) {
-		zlog_warn(
-			"apiserver_clients_lsa_change_notify: msg_new failed");
-		return;
-	}
-
-	/* Now send message to all clients with a matching filter */
-	for (ALL_LIST_ELEMENTS(apiserver_list, node, nnode, apiserv)) {
+	/* Now send message to all clients with a matching filter; the type
+	 * matches for all of these.
+	 */
+	for (ALL_LIST_ELEMENTS(apiserver_by_type[lsa->data->type], node, nnode,
+			       apiserv)) {
 		struct lsa_filter_type *filter;
-		uint16_t mask;
 		uint32_t *area;
 		int i;
 
@@ -2404,21 +2586,39 @@ static void apiserver_clients_lsa_change_notify(uint8_t msgtype,
 			i = 1;
 		}
 
-		if (i > 0) {
-			/* Area match. Check LSA type. */
-			mask = ntohs(filter->typemask);
-
-			if (mask & Power2[lsa->data->type]) {
-				/* Type also matches. Check origin. */
-				if ((filter->origin == ANY_ORIGIN)
-				    || (filter->origin == IS_LSA_SELF(lsa))) {
-					ospf_apiserver_send_msg(apiserv, msg);
-				}
+		if (i == 0)
+			continue;
+
+		/* Area and type match. Check origin. */
+		if ((filter->origin != ANY_ORIGIN)
+		    && (filter->origin != IS_LSA_SELF(lsa)))
+			continue;
+
+		if (apiserv->batch_deltas) {
+			apiserver_batch_add(apiserv, msgtype, lsa, 0);
+			thread_add_event(master, apiserver_batch_flush_event,
+					 apiserv, 0, &apiserv->t_batch_flush);
+			continue;
+		}
+
+		/* Prepare message that can be sent to clients that have a
+		   matching filter */
+		if (!msg) {
+			msg = new_msg_lsa_change_notify(
+				msgtype, 0L, /* no sequence number */
+				ifaddr, area_id, lsa->flags & OSPF_LSA_SELF,
+				lsa->data);
+			if (!msg) {
+				zlog_warn(
+					"apiserver_clients_lsa_change_notify: msg_new failed");
+				return;
 			}
 		}
+		ospf_apiserver_send_msg(apiserv, msg);
 	}
 	/* Free message since it is not used anymore */
-	msg_free(msg);
+	if (msg)
+		msg_free(msg);
 }
 
 
@@ -2430,13 +2630,6 @@ static void apiserver_clients_lsa_change_notify(uint8_t msgtype,
 
 static int apiserver_notify_clients_lsa(uint8_t msgtype, struct ospf_lsa *lsa)
 {
-	struct msg *msg;
-	/* default area for AS-External and Opaque11 LSAs */
-	struct in_addr area_id = {.s_addr = 0L};
-
-	/* default interface for non Opaque9 LSAs */
-	struct in_addr ifaddr = {.s_addr = 0L};
-
 	/* Only notify this update if the LSA's age is smaller than
 	   MAXAGE. Otherwise clients would see LSA updates with max age just
 	   before they are deleted from the LSDB. LSA delete messages have
@@ -2445,25 +2638,9 @@ static int apiserver_notify_clients_lsa(uint8_t msgtype, struct ospf_lsa *lsa)
 		return 0;
 	}
 
-	if (lsa->area) {
-		area_id = lsa->area->area_id;
-	}
-	if (lsa->data->type == OSPF_OPAQUE_LINK_LSA) {
-		ifaddr = lsa->oi->address->u.prefix4;
-	}
-	msg = new_msg_lsa_change_notify(msgtype, 0L, /* no sequence number */
-					ifaddr, area_id,
-					lsa->flags & OSPF_LSA_SELF, lsa->data);
-	if (!msg) {
-		zlog_warn("notify_clients_lsa: msg_new failed");
-		return -1;
-	}
 	/* Notify all clients that new LSA is added/updated */
 	apiserver_clients_lsa_change_notify(msgtype, lsa);
 
-	/* Clients made their own copies of msg so we can free msg here */
-	msg_free(msg);
-
 	return 0;
 }
 
@@ -55,6 +55,12 @@ struct ospf_apiserver {
 	/* filter for LSA update/delete notifies */
 	struct lsa_filter_type *filter;
 
+	/* LSA notifies collected into the next MSG_LSA_BATCH_NOTIFY; changes
+	   only go there with OSPF_API_SYNC_BATCH_DELTAS */
+	struct apiserver_batch *batch;
+	bool batch_deltas;
+	struct thread *t_batch_flush;
+
 	/* Fifo buffers for outgoing messages */
 	struct msg_fifo *out_sync_fifo;
 	struct msg_fifo *out_async_fifo;
@@ -144,6 +150,9 @@ extern int ospf_apiserver_handle_delete_request(struct ospf_apiserver *apiserv,
 						struct msg *msg);
 extern int ospf_apiserver_handle_sync_lsdb(struct ospf_apiserver *apiserv,
 					   struct msg *msg);
+extern int
+ospf_apiserver_handle_sync_lsdb_batch(struct ospf_apiserver *apiserv,
+				      struct msg *msg);
 
 
 /* -----------------------------------------------------------
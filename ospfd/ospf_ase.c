@@ -24,6 +24,7 @@
 #include "thread.h"
 #include "memory.h"
 #include "hash.h"
+#include "jhash.h"
 #include "linklist.h"
 #include "prefix.h"
 #include "if.h"
@@ -156,6 +157,280 @@ static int ospf_ase_forward_address_check(struct ospf *ospf,
 	return 1;
 }
 
+/*
+ * External routes depend on the route to their ASBR and, if they have one,
+ * on the route to their forwarding address.  The LSAs are indexed by both
+ * addresses, along with how the address resolved at the last calculation,
+ * so that after an SPF run only the externals whose ASBR or forwarding
+ * address route changed are recalculated.
+ */
+DEFINE_MTYPE_STATIC(OSPFD, OSPF_ASE_DEP, "OSPF external route dependency");
+
+/* what an external route takes from its ASBR/forwarding address route */
+struct ospf_ase_res {
+	bool reachable;
+	uint8_t path_type;
+	uint8_t flags;
+	struct in_addr area_id;
+	uint32_t cost;
+	uint32_t paths;
+};
+
+struct ospf_ase_dep {
+	struct ospf_ase_deps_item item;
+	struct in_addr addr;
+
+	/* LSAs originated by addr, and LSAs with addr as forwarding address */
+	struct ospf_ase_asbr_lsas_head asbr_lsas;
+	struct ospf_ase_fwd_lsas_head fwd_lsas;
+	struct ospf_ase_res asbr_res;
+	struct ospf_ase_res fwd_res;
+};
+
+static int ospf_ase_dep_cmp(const struct ospf_ase_dep *a,
+			    const struct ospf_ase_dep *b)
+{
+	return IPV4_ADDR_CMP(&a->addr, &b->addr);
+}
+
+static uint32_t ospf_ase_dep_hash(const struct ospf_ase_dep *a)
+{
+	return jhash_1word(a->addr.s_addr, 0);
+}
+
+DECLARE_HASH(ospf_ase_deps, struct ospf_ase_dep, item, ospf_ase_dep_cmp,
+	     ospf_ase_dep_hash);
+DECLARE_DLIST(ospf_ase_asbr_lsas, struct ospf_lsa, ase_asbr_item);
+DECLARE_DLIST(ospf_ase_fwd_lsas, struct ospf_lsa, ase_fwd_item);
+
+static struct ospf_ase_dep *ospf_ase_dep_get(struct ospf *ospf,
+					     struct in_addr addr)
+{
+	struct ospf_ase_dep ref, *dep;
+
+	ref.addr = addr;
+	dep = ospf_ase_deps_find(&ospf->ase_deps, &ref);
+	if (dep)
+		return dep;
+
+	dep = XCALLOC(MTYPE_OSPF_ASE_DEP, sizeof(*dep));
+	dep->addr = addr;
+	ospf_ase_asbr_lsas_init(&dep->asbr_lsas);
+	ospf_ase_fwd_lsas_init(&dep->fwd_lsas);
+	ospf_ase_deps_add(&ospf->ase_deps, dep);
+	return dep;
+}
+
+static void ospf_ase_dep_free(struct ospf_ase_dep *dep)
+{
+	ospf_ase_asbr_lsas_fini(&dep->asbr_lsas);
+	ospf_ase_fwd_lsas_fini(&dep->fwd_lsas);
+	XFREE(MTYPE_OSPF_ASE_DEP, dep);
+}
+
+static void ospf_ase_dep_put(struct ospf *ospf, struct ospf_ase_dep *dep)
+{
+	if (ospf_ase_asbr_lsas_count(&dep->asbr_lsas)
+	    || ospf_ase_fwd_lsas_count(&dep->fwd_lsas))
+		return;
+
+	ospf_ase_deps_del(&ospf->ase_deps, dep);
+	ospf_ase_dep_free(dep);
+}
+
+static void ospf_ase_dep_add_lsa(struct ospf *ospf, struct ospf_lsa *lsa)
+{
+	struct as_external_lsa *al = (struct as_external_lsa *)lsa->data;
+	struct ospf_ase_dep *dep;
+
+	dep = ospf_ase_dep_get(ospf, lsa->data->adv_router);
+	ospf_ase_asbr_lsas_add_tail(&dep->asbr_lsas, lsa);
+
+	if (al->e[0].fwd_addr.s_addr != INADDR_ANY) {
+		dep = ospf_ase_dep_get(ospf, al->e[0].fwd_addr);
+		ospf_ase_fwd_lsas_add_tail(&dep->fwd_lsas, lsa);
+	}
+}
+
+static void ospf_ase_dep_del_lsa(struct ospf *ospf, struct ospf_lsa *lsa)
+{
+	struct as_external_lsa *al = (struct as_external_lsa *)lsa->data;
+	struct ospf_ase_dep *dep;
+
+	dep = ospf_ase_dep_get(ospf, lsa->data->adv_router);
+	ospf_ase_asbr_lsas_del(&dep->asbr_lsas, lsa);
+	ospf_ase_dep_put(ospf, dep);
+
+	if (al->e[0].fwd_addr.s_addr != INADDR_ANY) {
+		dep = ospf_ase_dep_get(ospf, al->e[0].fwd_addr);
+		ospf_ase_fwd_lsas_del(&dep->fwd_lsas, lsa);
+		ospf_ase_dep_put(ospf, dep);
+	}
+}
+
+static void ospf_ase_res_set(struct ospf_ase_res *res, struct ospf_route *or)
+{
+	struct listnode *node;
+	struct ospf_path *path;
+
+	memset(res, 0, sizeof(*res));
+	if (!or)
+		return;
+
+	res->reachable = true;
+	res->path_type = or->path_type;
+	res->flags = or->u.std.flags;
+	res->area_id = or->u.std.area_id;
+	res->cost = or->cost;
+	for (ALL_LIST_ELEMENTS_RO(or->paths, node, path))
+		res->paths = jhash_3words(path->nexthop.s_addr, path->ifindex,
+					  res->paths, 0);
+}
+
+/* Resolve dep's address the way ospf_ase_calculate_route() does. */
+static bool ospf_ase_dep_update(struct ospf *ospf, struct ospf_ase_dep *dep,
+				bool asbr)
+{
+	struct ospf_ase_res *res = asbr ? &dep->asbr_res : &dep->fwd_res;
+	struct ospf_ase_res new;
+	struct ospf_route *or = NULL;
+	struct prefix_ipv4 p;
+	struct route_node *rn;
+
+	p.family = AF_INET;
+	p.prefix = dep->addr;
+	p.prefixlen = IPV4_MAX_BITLEN;
+
+	if (asbr)
+		or = ospf_find_asbr_route(ospf, ospf->new_rtrs, &p);
+	else if (ospf->new_table
+		 && ospf_ase_forward_address_check(ospf, dep->addr)) {
+		rn = route_node_match(ospf->new_table, (struct prefix *)&p);
+		if (rn) {
+			or = rn->info;
+			route_unlock_node(rn);
+		}
+	}
+
+	ospf_ase_res_set(&new, or);
+	if (!memcmp(&new, res, sizeof(new)))
+		return false;
+
+	*res = new;
+	return true;
+}
+
+static void ospf_ase_dirty_add(struct route_table *dirty,
+			       const struct prefix *p)
+{
+	struct route_node *rn;
+
+	rn = route_node_get(dirty, p);
+	if (rn->info)
+		route_unlock_node(rn);
+	else
+		rn->info = dirty;
+}
+
+static void ospf_ase_dirty_add_lsa(struct route_table *dirty,
+				   struct ospf_lsa *lsa)
+{
+	struct as_external_lsa *al = (struct as_external_lsa *)lsa->data;
+	struct prefix_ipv4 p;
+
+	p.family = AF_INET;
+	p.prefix = lsa->data->id;
+	p.prefixlen = ip_masklen(al->mask);
+	apply_mask_ipv4(&p);
+
+	ospf_ase_dirty_add(dirty, (struct prefix *)&p);
+}
+
+/*
+ * Refresh the resolution of all ASBRs and forwarding addresses, and add the
+ * prefixes of the LSAs depending on those that changed to 'dirty'.
+ */
+static void ospf_ase_deps_update(struct ospf *ospf, struct route_table *dirty)
+{
+	struct ospf_ase_dep *dep;
+	struct ospf_lsa *lsa;
+
+	frr_each (ospf_ase_deps, &ospf->ase_deps, dep) {
+		if (ospf_ase_asbr_lsas_count(&dep->asbr_lsas)
+		    && ospf_ase_dep_update(ospf, dep, true) && dirty)
+			frr_each (ospf_ase_asbr_lsas, &dep->asbr_lsas, lsa)
+				ospf_ase_dirty_add_lsa(dirty, lsa);
+		if (ospf_ase_fwd_lsas_count(&dep->fwd_lsas)
+		    && ospf_ase_dep_update(ospf, dep, false) && dirty)
+			frr_each (ospf_ase_fwd_lsas, &dep->fwd_lsas, lsa)
+				ospf_ase_dirty_add_lsa(dirty, lsa);
+	}
+}
+
+/*
+ * Refresh the set of prefixes with both externals and an intra/inter-area
+ * route, and add those that lost the internal route to 'dirty'.  Externals
+ * that gained one are already taken care of by ospf_route_install().
+ */
+static void ospf_ase_hidden_update(struct ospf *ospf, struct route_table *dirty)
+{
+	struct route_table *hidden;
+	struct route_node *rn, *ext;
+
+	hidden = route_table_init();
+
+	if (ospf->new_table)
+		for (rn = route_top(ospf->new_table); rn; rn = route_next(rn)) {
+			if (!rn->info)
+				continue;
+			ext = route_node_lookup(ospf->external_lsas, &rn->p);
+			if (!ext)
+				continue;
+			route_unlock_node(ext);
+			if (!listcount((struct list *)ext->info))
+				continue;
+			route_node_get(hidden, &rn->p)->info = hidden;
+		}
+
+	if (dirty)
+		for (rn = route_top(ospf->ase_hidden); rn;
+		     rn = route_next(rn)) {
+			if (!rn->info)
+				continue;
+			ext = route_node_lookup(hidden, &rn->p);
+			if (ext)
+				route_unlock_node(ext);
+			else
+				ospf_ase_dirty_add(dirty, &rn->p);
+		}
+
+	route_table_finish(ospf->ase_hidden);
+	ospf->ase_hidden = hidden;
+}
+
+void ospf_ase_init(struct ospf *ospf)
+{
+	ospf_ase_deps_init(&ospf->ase_deps);
+	ospf->ase_hidden = route_table_init();
+	ospf->ase_calc_full = true;
+}
+
+void ospf_ase_finish(struct ospf *ospf)
+{
+	struct ospf_ase_dep *dep;
+
+	while ((dep = ospf_ase_deps_pop(&ospf->ase_deps))) {
+		while (ospf_ase_asbr_lsas_pop(&dep->asbr_lsas))
+			;
+		while (ospf_ase_fwd_lsas_pop(&dep->fwd_lsas))
+			;
+		ospf_ase_dep_free(dep);
+	}
+	ospf_ase_deps_fini(&ospf->ase_deps);
+	route_table_finish(ospf->ase_hidden);
+	ospf->ase_hidden = NULL;
+}
+
 static struct ospf_route *
 ospf_ase_calculate_new_route(struct ospf_lsa *lsa,
 			     struct ospf_route *asbr_route, uint32_t metric)
@@ -551,14 +826,157 @@ static int ospf_ase_compare_tables(struct ospf *ospf,
 	return 0;
 }
 
-static int ospf_ase_calculate_timer(struct thread *t)
+/*
+ * Recalculate the external route to p from all of its LSAs and install the
+ * difference.  ospf->new_external_route is only used as scratch space, the
+ * result ends up in ospf->old_external_route.
+ */
+static void ospf_ase_update_prefix(struct ospf *ospf, struct prefix_ipv4 *p)
+{
+	struct list *lsas;
+	struct listnode *node;
+	struct route_node *rn, *rn2;
+	struct route_table *tmp_old;
+	struct ospf_lsa *lsa;
+
+	/* If there is already an intra-area or inter-area route
+	   to the destination, no recalculation is necessary
+	   (internal routes take precedence). */
+
+	rn = route_node_lookup(ospf->new_table, (struct prefix *)p);
+	if (rn) {
+		route_unlock_node(rn);
+		if (rn->info)
+			return;
+	}
+
+	/* the LSAs may all be gone when called for a changed dependency */
+	rn = route_node_lookup(ospf->external_lsas, (struct prefix *)p);
+	if (rn) {
+		lsas = rn->info;
+		route_unlock_node(rn);
+
+		for (ALL_LIST_ELEMENTS_RO(lsas, node, lsa))
+			ospf_ase_calculate_route(ospf, lsa);
+	}
+
+	/* prepare temporary old routing table for compare */
+	tmp_old = route_table_init();
+	rn = route_node_lookup(ospf->old_external_route, (struct prefix *)p);
+	if (rn && rn->info) {
+		rn2 = route_node_get(tmp_old, (struct prefix *)p);
+		rn2->info = rn->info;
+		route_unlock_node(rn);
+	}
+
+	/* install changes to zebra */
+	ospf_ase_compare_tables(ospf, ospf->new_external_route, tmp_old);
+
+	/* update ospf->old_external_route table */
+	if (rn && rn->info)
+		ospf_route_free((struct ospf_route *)rn->info);
+
+	rn2 = route_node_lookup(ospf->new_external_route, (struct prefix *)p);
+	/* if new route exists, install it to ospf->old_external_route */
+	if (rn2 && rn2->info) {
+		if (!rn)
+			rn = route_node_get(ospf->old_external_route,
+					    (struct prefix *)p);
+		rn->info = rn2->info;
+	} else {
+		/* remove route node from ospf->old_external_route */
+		if (rn) {
+			rn->info = NULL;
+			route_unlock_node(rn);
+		}
+	}
+
+	if (rn2) {
+		/* rn2->info is stored in route node of ospf->old_external_route
+		 */
+		rn2->info = NULL;
+		route_unlock_node(rn2);
+		route_unlock_node(rn2);
+	}
+
+	route_table_finish(tmp_old);
+}
+
+/* Recalculate the external routes from all AS-external/NSSA-LSAs. */
+static void ospf_ase_calculate_all(struct ospf *ospf)
 {
-	struct ospf *ospf;
 	struct ospf_lsa *lsa;
 	struct route_node *rn;
 	struct listnode *node;
 	struct ospf_area *area;
-	struct timeval start_time, stop_time;
+
+	/* Calculate external route for each AS-external-LSA */
+	LSDB_LOOP (EXTERNAL_LSDB(ospf), rn, lsa)
+		ospf_ase_calculate_route(ospf, lsa);
+
+	/*  This version simple adds to the table all NSSA areas  */
+	if (ospf->anyNSSA)
+		for (ALL_LIST_ELEMENTS_RO(ospf->areas, node, area)) {
+			if (IS_DEBUG_OSPF_NSSA)
+				zlog_debug(
+					"ospf_ase_calculate_timer(): looking at area %pI4",
+					&area->area_id);
+
+			if (area->external_routing == OSPF_AREA_NSSA)
+				LSDB_LOOP (NSSA_LSDB(area), rn, lsa)
+					ospf_ase_calculate_route(ospf, lsa);
+		}
+	/* kevinm: And add the NSSA routes in ospf_top */
+	LSDB_LOOP (NSSA_LSDB(ospf), rn, lsa)
+		ospf_ase_calculate_route(ospf, lsa);
+
+	/* Compare old and new external routing table and install the
+	   difference info zebra/kernel */
+	ospf_ase_compare_tables(ospf, ospf->new_external_route,
+				ospf->old_external_route);
+
+	/* Delete old external routing table */
+	ospf_route_table_free(ospf->old_external_route);
+	ospf->old_external_route = ospf->new_external_route;
+	ospf->new_external_route = route_table_init();
+
+	/* Record what the routes were calculated from. */
+	ospf_ase_deps_update(ospf, NULL);
+	ospf_ase_hidden_update(ospf, NULL);
+}
+
+/*
+ * Recalculate only the external routes whose ASBR or forwarding address
+ * route changed, or that are no longer hidden by an intra/inter-area route.
+ * Returns the number of prefixes recalculated.
+ */
+static unsigned long ospf_ase_calculate_changed(struct ospf *ospf)
+{
+	struct route_table *dirty;
+	struct route_node *rn;
+	unsigned long count = 0;
+
+	dirty = route_table_init();
+	ospf_ase_deps_update(ospf, dirty);
+	ospf_ase_hidden_update(ospf, dirty);
+
+	for (rn = route_top(dirty); rn; rn = route_next(rn))
+		if (rn->info) {
+			ospf_ase_update_prefix(ospf,
+					       (struct prefix_ipv4 *)&rn->p);
+			count++;
+		}
+
+	route_table_finish(dirty);
+	return count;
+}
+
+static int ospf_ase_calculate_timer(struct thread *t)
+{
+	struct ospf *ospf;
+	struct timeval start_time;
+	unsigned long count = 0;
+	bool full;
 
 	ospf = THREAD_ARG(t);
 	ospf->t_ase_calc = NULL;
@@ -568,53 +986,39 @@ static int ospf_ase_calculate_timer(struct thread *t)
 
 		monotime(&start_time);
 
-		/* Calculate external route for each AS-external-LSA */
-		LSDB_LOOP (EXTERNAL_LSDB(ospf), rn, lsa)
-			ospf_ase_calculate_route(ospf, lsa);
-
-		/*  This version simple adds to the table all NSSA areas  */
-		if (ospf->anyNSSA)
-			for (ALL_LIST_ELEMENTS_RO(ospf->areas, node, area)) {
-				if (IS_DEBUG_OSPF_NSSA)
-					zlog_debug(
-						"ospf_ase_calculate_timer(): looking at area %pI4",
-						&area->area_id);
-
-				if (area->external_routing == OSPF_AREA_NSSA)
-					LSDB_LOOP (NSSA_LSDB(area), rn, lsa)
-						ospf_ase_calculate_route(ospf,
-									 lsa);
-			}
-		/* kevinm: And add the NSSA routes in ospf_top */
-		LSDB_LOOP (NSSA_LSDB(ospf), rn, lsa)
-			ospf_ase_calculate_route(ospf, lsa);
-
-		/* Compare old and new external routing table and install the
-		   difference info zebra/kernel */
-		ospf_ase_compare_tables(ospf, ospf->new_external_route,
-					ospf->old_external_route);
-
-		/* Delete old external routing table */
-		ospf_route_table_free(ospf->old_external_route);
-		ospf->old_external_route = ospf->new_external_route;
-		ospf->new_external_route = route_table_init();
-
-		monotime(&stop_time);
-
-		if (IS_DEBUG_OSPF_EVENT)
-			zlog_info(
-				"SPF Processing Time(usecs): External Routes: %lld",
-				(stop_time.tv_sec - start_time.tv_sec)
-						* 1000000LL
-					+ (stop_time.tv_usec
-					   - start_time.tv_usec));
+		full = ospf->ase_calc_full;
+		ospf->ase_calc_full = false;
+		if (full)
+			ospf_ase_calculate_all(ospf);
+		else
+			count = ospf_ase_calculate_changed(ospf);
+
+		if (IS_DEBUG_OSPF_EVENT) {
+			if (full)
+				zlog_info(
+					"SPF Processing Time(usecs): External Routes: %lld",
+					monotime_since(&start_time, NULL));
+			else
+				zlog_info(
+					"SPF Processing Time(usecs): External Routes: %lld (%lu prefixes recalculated)",
+					monotime_since(&start_time, NULL),
+					count);
+		}
 	}
 
 	/*
-	 * Uninstall remnant routes that were installed before the restart, but
-	 * that are no longer valid.
+	 * Install the external routes, which were only calculated during the
+	 * restart, and uninstall remnant routes that were installed before the
+	 * restart, but that are no longer valid.
 	 */
 	if (ospf->gr_info.finishing_restart) {
+		struct route_node *rn;
+
+		for (rn = route_top(ospf->old_external_route); rn;
+		     rn = route_next(rn))
+			if (rn->info)
+				ospf_zebra_add(ospf, (struct prefix_ipv4 *)&rn->p,
+					       rn->info);
 		ospf_zebra_gr_disable(ospf);
 		ospf->gr_info.finishing_restart = false;
 	}
@@ -655,12 +1059,16 @@ void ospf_ase_register_external_lsa(struct ospf_lsa *lsa, struct ospf *top)
 	rn = route_node_get(top->external_lsas, (struct prefix *)&p);
 	if ((lst = rn->info) == NULL)
 		rn->info = lst = list_new();
-	else
+	else {
 		route_unlock_node(rn);
+		if (listnode_lookup(lst, lsa))
+			return;
+	}
 
 	/* We assume that if LSA is deleted from DB
 	   is is also deleted from this RT */
 	listnode_add(lst, ospf_lsa_lock(lsa)); /* external_lsas lst */
+	ospf_ase_dep_add_lsa(top, lsa);
 }
 
 void ospf_ase_unregister_external_lsa(struct ospf_lsa *lsa, struct ospf *top)
@@ -684,6 +1092,7 @@ void ospf_ase_unregister_external_lsa(struct ospf_lsa *lsa, struct ospf *top)
 		/* Unlock lsa only if node is present in the list */
 		if (node) {
 			listnode_delete(lst, lsa);
+			ospf_ase_dep_del_lsa(top, lsa);
 			ospf_lsa_unlock(&lsa); /* external_lsas list */
 		}
 
@@ -710,11 +1119,7 @@ void ospf_ase_external_lsas_finish(struct route_table *rt)
 
 void ospf_ase_incremental_update(struct ospf *ospf, struct ospf_lsa *lsa)
 {
-	struct list *lsas;
-	struct listnode *node;
-	struct route_node *rn, *rn2;
 	struct prefix_ipv4 p;
-	struct route_table *tmp_old;
 	struct as_external_lsa *al;
 
 	al = (struct as_external_lsa *)lsa->data;
@@ -728,64 +1133,5 @@ void ospf_ase_incremental_update(struct ospf *ospf, struct ospf_lsa *lsa)
 	if (!ospf->new_table)
 		return;
 
-	/* If there is already an intra-area or inter-area route
-	   to the destination, no recalculation is necessary
-	   (internal routes take precedence). */
-
-	rn = route_node_lookup(ospf->new_table, (struct prefix *)&p);
-	if (rn) {
-		route_unlock_node(rn);
-		if (rn->info)
-			return;
-	}
-
-	rn = route_node_lookup(ospf->external_lsas, (struct prefix *)&p);
-	assert(rn);
-	assert(rn->info);
-	lsas = rn->info;
-	route_unlock_node(rn);
-
-	for (ALL_LIST_ELEMENTS_RO(lsas, node, lsa))
-		ospf_ase_calculate_route(ospf, lsa);
-
-	/* prepare temporary old routing table for compare */
-	tmp_old = route_table_init();
-	rn = route_node_lookup(ospf->old_external_route, (struct prefix *)&p);
-	if (rn && rn->info) {
-		rn2 = route_node_get(tmp_old, (struct prefix *)&p);
-		rn2->info = rn->info;
-		route_unlock_node(rn);
-	}
-
-	/* install changes to zebra */
-	ospf_ase_compare_tables(ospf, ospf->new_external_route, tmp_old);
-
-	/* update ospf->old_external_route table */
-	if (rn && rn->info)
-		ospf_route_free((struct ospf_route *)rn->info);
-
-	rn2 = route_node_lookup(ospf->new_external_route, (struct prefix *)&p);
-	/* if new route exists, install it to ospf->old_external_route */
-	if (rn2 && rn2->info) {
-		if (!rn)
-			rn = route_node_get(ospf->old_external_route,
-					    (struct prefix *)&p);
-		rn->info = rn2->info;
-	} else {
-		/* remove route node from ospf->old_external_route */
-		if (rn) {
-			rn->info = NULL;
-			route_unlock_node(rn);
-		}
-	}
-
-	if (rn2) {
-		/* rn2->info is stored in route node of ospf->old_external_route
-		 */
-		rn2->info = NULL;
-		route_unlock_node(rn2);
-		route_unlock_node(rn2);
-	}
-
-	route_table_finish(tmp_old);
+	ospf_ase_update_prefix(ospf, &p);
 }
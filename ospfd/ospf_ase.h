@@ -32,6 +32,8 @@ extern int ospf_ase_calculate_route(struct ospf *, struct ospf_lsa *);
 extern void ospf_ase_calculate_schedule(struct ospf *);
 extern void ospf_ase_calculate_timer_add(struct ospf *);
 
+extern void ospf_ase_init(struct ospf *ospf);
+extern void ospf_ase_finish(struct ospf *ospf);
 extern void ospf_ase_external_lsas_finish(struct route_table *);
 extern void ospf_ase_incremental_update(struct ospf *, struct ospf_lsa *);
 extern void ospf_ase_register_external_lsa(struct ospf_lsa *, struct ospf *);
@@ -22,6 +22,8 @@
 #include <zebra.h>
 
 #include "monotime.h"
+#include "id_alloc.h"
+#include "jhash.h"
 #include "linklist.h"
 #include "prefix.h"
 #include "if.h"
@@ -47,6 +49,7 @@
 #include "ospfd/ospf_route.h"
 #include "ospfd/ospf_zebra.h"
 #include "ospfd/ospf_dump.h"
+#include "ospfd/ospf_trace.h"
 
 extern struct zclient *zclient;
 
@@ -323,6 +326,8 @@ int ospf_flood(struct ospf *ospf, struct ospf_neighbor *nbr,
 			lookup_msg(ospf_nsm_state_msg, nbr->state, NULL),
 			(void *)current, dump_lsa_key(new));
 
+	frrtrace(2, frr_ospf, lsa_receive, nbr, new);
+
 	oi = nbr->oi;
 
 	/* If there is already a database copy, and if the
@@ -773,6 +778,8 @@ int ospf_flood_through(struct ospf *ospf, struct ospf_neighbor *inbr,
 {
 	int lsa_ack_flag = 0;
 
+	frrtrace(2, frr_ospf, lsa_flood, inbr, lsa);
+
 	/* Type-7 LSA's for NSSA are flooded throughout the AS here, and
 	   upon return are updated in the LSDB for Type-7's.  Later,
 	   re-fresh will re-send them (and also, if ABR, packet code will
@@ -886,92 +893,274 @@ struct ospf_lsa *ospf_ls_request_new(struct lsa_header *lsah)
 }
 
 
-/* Management functions for neighbor's ls-retransmit list. */
+/*
+ * Management functions for neighbor's ls-retransmit list.
+ *
+ * An LSA waiting to be acknowledged by a number of neighbors is kept only
+ * once per instance, in a slot keyed by its flooding scope and LSA key.  A
+ * neighbor's list is a bitmap of slot indexes, so putting an LSA on every
+ * adjacency of an area costs a bit per neighbor rather than an LSDB node.
+ * The slot holds the most recent instance it was given; neighbors that were
+ * still waiting for an older one get the newer one retransmitted instead.
+ */
+struct ospf_rxmt_slot {
+	struct ospf_rxmt_slots_item item;
+
+	/* interface, area or NULL for AS scope */
+	const void *scope;
+	uint8_t type;
+	struct in_addr id;
+	struct in_addr adv_router;
+
+	uint32_t idx;
+	/* number of neighbors with this slot's bit set */
+	uint32_t refcnt;
+	struct ospf_lsa *lsa;
+};
+
+static int ospf_rxmt_slot_cmp(const struct ospf_rxmt_slot *a,
+			      const struct ospf_rxmt_slot *b)
+{
+	if (a->scope != b->scope)
+		return numcmp((uintptr_t)a->scope, (uintptr_t)b->scope);
+	if (a->type != b->type)
+		return numcmp(a->type, b->type);
+	if (a->id.s_addr != b->id.s_addr)
+		return numcmp(a->id.s_addr, b->id.s_addr);
+	return numcmp(a->adv_router.s_addr, b->adv_router.s_addr);
+}
+
+static uint32_t ospf_rxmt_slot_hash(const struct ospf_rxmt_slot *a)
+{
+	return jhash_3words(a->id.s_addr, a->adv_router.s_addr,
+			    a->type ^ (uint32_t)(uintptr_t)a->scope, 0);
+}
+
+DECLARE_HASH(ospf_rxmt_slots, struct ospf_rxmt_slot, item, ospf_rxmt_slot_cmp,
+	     ospf_rxmt_slot_hash);
+
+/* The scope comes from the neighbor, acknowledged LSAs have no area set. */
+static const void *ospf_rxmt_scope(struct ospf_neighbor *nbr, uint8_t type)
+{
+	switch (type) {
+	case OSPF_AS_EXTERNAL_LSA:
+	case OSPF_OPAQUE_AS_LSA:
+		return NULL;
+	case OSPF_OPAQUE_LINK_LSA:
+		return nbr->oi;
+	default:
+		return nbr->oi->area;
+	}
+}
+
+static struct ospf_rxmt_slot *ospf_rxmt_slot_lookup(struct ospf_neighbor *nbr,
+						    struct ospf_lsa *lsa)
+{
+	struct ospf_rxmt_slot ref = {};
+
+	ref.scope = ospf_rxmt_scope(nbr, lsa->data->type);
+	ref.type = lsa->data->type;
+	ref.id = lsa->data->id;
+	ref.adv_router = lsa->data->adv_router;
+
+	return ospf_rxmt_slots_find(&nbr->oi->ospf->rxmt_slots, &ref);
+}
+
+static struct ospf_rxmt_slot *ospf_rxmt_slot_get(struct ospf_neighbor *nbr,
+						 struct ospf_lsa *lsa)
+{
+	struct ospf *ospf = nbr->oi->ospf;
+	struct ospf_rxmt_slot *slot;
+	uint32_t max;
+
+	slot = ospf_rxmt_slot_lookup(nbr, lsa);
+	if (slot)
+		return slot;
+
+	slot = XCALLOC(MTYPE_OSPF_RXMT_SLOT, sizeof(*slot));
+	slot->scope = ospf_rxmt_scope(nbr, lsa->data->type);
+	slot->type = lsa->data->type;
+	slot->id = lsa->data->id;
+	slot->adv_router = lsa->data->adv_router;
+	slot->lsa = ospf_lsa_lock(lsa);
+
+	/* id_alloc hands out the lowest free index, keeping bitmaps short */
+	slot->idx = idalloc_allocate(ospf->rxmt_ids);
+	if (slot->idx >= ospf->rxmt_slot_max) {
+		max = MAX(ospf->rxmt_slot_max * 2, 64U);
+		while (slot->idx >= max)
+			max *= 2;
+		ospf->rxmt_slot_idx =
+			XREALLOC(MTYPE_OSPF_RXMT_SLOT, ospf->rxmt_slot_idx,
+				 max * sizeof(*ospf->rxmt_slot_idx));
+		memset(ospf->rxmt_slot_idx + ospf->rxmt_slot_max, 0,
+		       (max - ospf->rxmt_slot_max)
+			       * sizeof(*ospf->rxmt_slot_idx));
+		ospf->rxmt_slot_max = max;
+	}
+	ospf->rxmt_slot_idx[slot->idx] = slot;
+	ospf_rxmt_slots_add(&ospf->rxmt_slots, slot);
+
+	return slot;
+}
+
+static void ospf_rxmt_slot_free(struct ospf *ospf, struct ospf_rxmt_slot *slot)
+{
+	ospf_rxmt_slots_del(&ospf->rxmt_slots, slot);
+	ospf->rxmt_slot_idx[slot->idx] = NULL;
+	idalloc_free(ospf->rxmt_ids, slot->idx);
+	ospf_lsa_unlock(&slot->lsa);
+	XFREE(MTYPE_OSPF_RXMT_SLOT, slot);
+}
+
+static bool ospf_rxmt_bit_test(struct ospf_rxmt_bits *rxmt, uint32_t idx)
+{
+	return idx / 64 < rxmt->words
+	       && (rxmt->bits[idx / 64] & (1ULL << (idx % 64)));
+}
+
+static void ospf_rxmt_bit_set(struct ospf_rxmt_bits *rxmt, uint32_t idx)
+{
+	uint32_t words;
+
+	if (idx / 64 >= rxmt->words) {
+		words = MAX(rxmt->words * 2, idx / 64 + 1);
+		rxmt->bits = XREALLOC(MTYPE_OSPF_RXMT_BITS, rxmt->bits,
+				      words * sizeof(*rxmt->bits));
+		memset(rxmt->bits + rxmt->words, 0,
+		       (words - rxmt->words) * sizeof(*rxmt->bits));
+		rxmt->words = words;
+	}
+	rxmt->bits[idx / 64] |= 1ULL << (idx % 64);
+	rxmt->count++;
+}
+
+/* Take a neighbor off a slot it is on; the slot may be freed. */
+static void ospf_rxmt_unset(struct ospf_neighbor *nbr,
+			    struct ospf_rxmt_slot *slot)
+{
+	struct ospf_rxmt_bits *rxmt = &nbr->ls_rxmt;
+
+	rxmt->bits[slot->idx / 64] &= ~(1ULL << (slot->idx % 64));
+	rxmt->count--;
+	slot->lsa->retransmit_counter--;
+
+	if (IS_DEBUG_OSPF(lsa, LSA_FLOODING)) /* -- endo. */
+		zlog_debug("RXmtL(%lu)--, NBR(%pI4(%s)), LSA[%s]",
+			   ospf_ls_retransmit_count(nbr), &nbr->router_id,
+			   ospf_get_name(nbr->oi->ospf),
+			   dump_lsa_key(slot->lsa));
+
+	if (--slot->refcnt == 0)
+		ospf_rxmt_slot_free(nbr->oi->ospf, slot);
+}
+
+void ospf_ls_retransmit_init(struct ospf *ospf)
+{
+	ospf_rxmt_slots_init(&ospf->rxmt_slots);
+	ospf->rxmt_ids = idalloc_new("OSPF retransmit slots");
+}
+
+void ospf_ls_retransmit_fini(struct ospf *ospf)
+{
+	struct ospf_rxmt_slot *slot;
+
+	/* the neighbors are gone by now, this is only a safety net */
+	while ((slot = ospf_rxmt_slots_pop(&ospf->rxmt_slots))) {
+		idalloc_free(ospf->rxmt_ids, slot->idx);
+		ospf_lsa_unlock(&slot->lsa);
+		XFREE(MTYPE_OSPF_RXMT_SLOT, slot);
+	}
+	ospf_rxmt_slots_fini(&ospf->rxmt_slots);
+	idalloc_destroy(ospf->rxmt_ids);
+	ospf->rxmt_ids = NULL;
+	XFREE(MTYPE_OSPF_RXMT_SLOT, ospf->rxmt_slot_idx);
+	ospf->rxmt_slot_max = 0;
+}
+
 unsigned long ospf_ls_retransmit_count(struct ospf_neighbor *nbr)
 {
-	return ospf_lsdb_count_all(&nbr->ls_rxmt);
+	return nbr->ls_rxmt.count;
 }
 
 unsigned long ospf_ls_retransmit_count_self(struct ospf_neighbor *nbr,
 					    int lsa_type)
 {
-	return ospf_lsdb_count_self(&nbr->ls_rxmt, lsa_type);
+	struct ospf_lsa *lsa;
+	unsigned long count = 0;
+	uint32_t pos = 0;
+
+	while ((lsa = ospf_ls_retransmit_next(nbr, &pos)))
+		if (lsa->data->type == lsa_type && IS_LSA_SELF(lsa))
+			count++;
+
+	return count;
 }
 
 int ospf_ls_retransmit_isempty(struct ospf_neighbor *nbr)
 {
-	return ospf_lsdb_isempty(&nbr->ls_rxmt);
+	return nbr->ls_rxmt.count == 0;
 }
 
 /* Add LSA to be retransmitted to neighbor's ls-retransmit list. */
 void ospf_ls_retransmit_add(struct ospf_neighbor *nbr, struct ospf_lsa *lsa)
 {
-	struct ospf_lsa *old;
+	struct ospf_rxmt_slot *slot;
 
-	old = ospf_ls_retransmit_lookup(nbr, lsa);
+	slot = ospf_rxmt_slot_get(nbr, lsa);
 
-	if (ospf_lsa_more_recent(old, lsa) < 0) {
-		if (old) {
-			old->retransmit_counter--;
-			if (IS_DEBUG_OSPF(lsa, LSA_FLOODING))
-				zlog_debug("RXmtL(%lu)--, NBR(%pI4(%s)), LSA[%s]",
-					   ospf_ls_retransmit_count(nbr),
-					   &nbr->router_id,
-					   ospf_get_name(nbr->oi->ospf),
-					   dump_lsa_key(old));
-			ospf_lsdb_delete(&nbr->ls_rxmt, old);
-		}
-		lsa->retransmit_counter++;
-		/*
-		 * We cannot make use of the newly introduced callback function
-		 * "lsdb->new_lsa_hook" to replace debug output below, just
-		 * because
-		 * it seems no simple and smart way to pass neighbor information
-		 * to
-		 * the common function "ospf_lsdb_add()" -- endo.
-		 */
+	if (slot->lsa != lsa && ospf_lsa_more_recent(slot->lsa, lsa) < 0) {
+		/* A newer instance, for all neighbors waiting on the slot. */
 		if (IS_DEBUG_OSPF(lsa, LSA_FLOODING))
-			zlog_debug("RXmtL(%lu)++, NBR(%pI4(%s)), LSA[%s]",
-				   ospf_ls_retransmit_count(nbr),
+			zlog_debug("RXmtL, NBR(%pI4(%s)), LSA[%s] replaces instance for %u neighbors",
 				   &nbr->router_id,
 				   ospf_get_name(nbr->oi->ospf),
-				   dump_lsa_key(lsa));
-		ospf_lsdb_add(&nbr->ls_rxmt, lsa);
+				   dump_lsa_key(lsa), slot->refcnt);
+		slot->lsa->retransmit_counter -= slot->refcnt;
+		lsa->retransmit_counter += slot->refcnt;
+		ospf_lsa_unlock(&slot->lsa);
+		slot->lsa = ospf_lsa_lock(lsa);
 	}
+
+	if (ospf_rxmt_bit_test(&nbr->ls_rxmt, slot->idx))
+		return;
+
+	ospf_rxmt_bit_set(&nbr->ls_rxmt, slot->idx);
+	slot->refcnt++;
+	slot->lsa->retransmit_counter++;
+	/*
+	 * We cannot make use of the newly introduced callback function
+	 * "lsdb->new_lsa_hook" to replace debug output below, just
+	 * because
+	 * it seems no simple and smart way to pass neighbor information
+	 * to
+	 * the common function "ospf_lsdb_add()" -- endo.
+	 */
+	if (IS_DEBUG_OSPF(lsa, LSA_FLOODING))
+		zlog_debug("RXmtL(%lu)++, NBR(%pI4(%s)), LSA[%s]",
+			   ospf_ls_retransmit_count(nbr), &nbr->router_id,
+			   ospf_get_name(nbr->oi->ospf),
+			   dump_lsa_key(slot->lsa));
 }
 
 /* Remove LSA from neibghbor's ls-retransmit list. */
 void ospf_ls_retransmit_delete(struct ospf_neighbor *nbr, struct ospf_lsa *lsa)
 {
-	if (ospf_ls_retransmit_lookup(nbr, lsa)) {
-		lsa->retransmit_counter--;
-		if (IS_DEBUG_OSPF(lsa, LSA_FLOODING)) /* -- endo. */
-			zlog_debug("RXmtL(%lu)--, NBR(%pI4(%s)), LSA[%s]",
-				   ospf_ls_retransmit_count(nbr),
-				   &nbr->router_id,
-				   ospf_get_name(nbr->oi->ospf),
-				   dump_lsa_key(lsa));
-		ospf_lsdb_delete(&nbr->ls_rxmt, lsa);
-	}
+	struct ospf_rxmt_slot *slot;
+
+	slot = ospf_rxmt_slot_lookup(nbr, lsa);
+	if (slot && ospf_rxmt_bit_test(&nbr->ls_rxmt, slot->idx))
+		ospf_rxmt_unset(nbr, slot);
 }
 
 /* Clear neighbor's ls-retransmit list. */
 void ospf_ls_retransmit_clear(struct ospf_neighbor *nbr)
 {
-	struct ospf_lsdb *lsdb;
-	int i;
-
-	lsdb = &nbr->ls_rxmt;
+	struct ospf_rxmt_slot **slots = nbr->oi->ospf->rxmt_slot_idx;
+	uint32_t pos = 0;
 
-	for (i = OSPF_MIN_LSA; i < OSPF_MAX_LSA; i++) {
-		struct route_table *table = lsdb->type[i].db;
-		struct route_node *rn;
-		struct ospf_lsa *lsa;
-
-		for (rn = route_top(table); rn; rn = route_next(rn))
-			if ((lsa = rn->info) != NULL)
-				ospf_ls_retransmit_delete(nbr, lsa);
-	}
+	while (ospf_ls_retransmit_next(nbr, &pos))
+		ospf_rxmt_unset(nbr, slots[pos - 1]);
 
 	ospf_lsa_unlock(&nbr->ls_req_last);
 	nbr->ls_req_last = NULL;
@@ -981,7 +1170,35 @@ void ospf_ls_retransmit_clear(struct ospf_neighbor *nbr)
 struct ospf_lsa *ospf_ls_retransmit_lookup(struct ospf_neighbor *nbr,
 					   struct ospf_lsa *lsa)
 {
-	return ospf_lsdb_lookup(&nbr->ls_rxmt, lsa);
+	struct ospf_rxmt_slot *slot;
+
+	slot = ospf_rxmt_slot_lookup(nbr, lsa);
+	if (slot && ospf_rxmt_bit_test(&nbr->ls_rxmt, slot->idx))
+		return slot->lsa;
+	return NULL;
+}
+
+/* Walk neighbor's ls-retransmit list, starting with *pos = 0. */
+struct ospf_lsa *ospf_ls_retransmit_next(struct ospf_neighbor *nbr,
+					 uint32_t *pos)
+{
+	struct ospf_rxmt_bits *rxmt = &nbr->ls_rxmt;
+	uint32_t idx = *pos;
+	uint64_t word;
+
+	while (idx / 64 < rxmt->words) {
+		word = rxmt->bits[idx / 64] >> (idx % 64);
+		if (!word) {
+			idx = (idx / 64 + 1) * 64;
+			continue;
+		}
+		idx += __builtin_ctzll(word);
+		*pos = idx + 1;
+		return nbr->oi->ospf->rxmt_slot_idx[idx]->lsa;
+	}
+
+	*pos = idx;
+	return NULL;
 }
 
 static void ospf_ls_retransmit_delete_nbr_if(struct ospf_interface *oi,
@@ -44,6 +44,8 @@ extern void ospf_ls_request_delete_all(struct ospf_neighbor *);
 extern struct ospf_lsa *ospf_ls_request_lookup(struct ospf_neighbor *,
 					       struct ospf_lsa *);
 
+extern void ospf_ls_retransmit_init(struct ospf *ospf);
+extern void ospf_ls_retransmit_fini(struct ospf *ospf);
 extern unsigned long ospf_ls_retransmit_count(struct ospf_neighbor *);
 extern unsigned long ospf_ls_retransmit_count_self(struct ospf_neighbor *, int);
 extern int ospf_ls_retransmit_isempty(struct ospf_neighbor *);
@@ -53,6 +55,8 @@ extern void ospf_ls_retransmit_delete(struct ospf_neighbor *,
 extern void ospf_ls_retransmit_clear(struct ospf_neighbor *);
 extern struct ospf_lsa *ospf_ls_retransmit_lookup(struct ospf_neighbor *,
 						  struct ospf_lsa *);
+extern struct ospf_lsa *ospf_ls_retransmit_next(struct ospf_neighbor *nbr,
+						uint32_t *pos);
 extern void ospf_ls_retransmit_delete_nbr_area(struct ospf_area *,
 					       struct ospf_lsa *);
 extern void ospf_ls_retransmit_delete_nbr_as(struct ospf *, struct ospf_lsa *);
@@ -260,6 +260,8 @@ static void ospf_gr_restart_exit(struct ospf *ospf, const char *reason)
 	for (ALL_LIST_ELEMENTS_RO(ospf->areas, onode, area)) {
 		struct ospf_interface *oi;
 
+		ospf_gr_lsa_check_clear(area);
+
 		/*
 		 * 1) The router should reoriginate its router-LSAs for all
 		 *    attached areas in order to make sure they have the correct
@@ -360,31 +362,105 @@ static bool ospf_gr_check_router_lsa_consistency(struct ospf *ospf,
 	return true;
 }
 
+/*
+ * Queue a router-LSA installed during the restart for the next consistency
+ * check.  The check of a neighbor's router-LSA only involves that LSA and our
+ * own, so unless our own changed, only the queued ones need to be looked at.
+ */
+void ospf_gr_lsa_check_add(struct ospf_area *area, struct ospf_lsa *lsa)
+{
+	if (area->gr_check_all)
+		return;
+
+	if (IS_LSA_SELF(lsa)) {
+		ospf_gr_lsa_check_clear(area);
+		area->gr_check_all = true;
+		return;
+	}
+
+	if (!area->gr_check_lsas)
+		area->gr_check_lsas = list_new();
+	listnode_add(area->gr_check_lsas, ospf_lsa_lock(lsa));
+}
+
+static void ospf_gr_lsa_list_free(struct list **lsas)
+{
+	struct listnode *node;
+	struct ospf_lsa *lsa;
+
+	if (!*lsas)
+		return;
+
+	for (ALL_LIST_ELEMENTS_RO(*lsas, node, lsa))
+		ospf_lsa_unlock(&lsa);
+	list_delete(lsas);
+}
+
+void ospf_gr_lsa_check_clear(struct ospf_area *area)
+{
+	area->gr_check_all = false;
+	ospf_gr_lsa_list_free(&area->gr_check_lsas);
+}
+
+static bool ospf_gr_check_lsa(struct ospf *ospf, struct ospf_area *area,
+			      struct ospf_lsa *lsa)
+{
+	char reason[256];
+
+	if (ospf_gr_check_router_lsa_consistency(ospf, area, lsa))
+		return true;
+
+	snprintfrr(reason, sizeof(reason),
+		   "detected inconsistent LSA[%s] [area %pI4]",
+		   dump_lsa_key(lsa), &area->area_id);
+	ospf_gr_restart_exit(ospf, reason);
+	return false;
+}
+
 /*
  * Check for LSAs that are inconsistent with the pre-restart LSAs, and abort the
- * ongoing graceful restart when that's the case.
+ * ongoing graceful restart when that's the case.  Only the router-LSAs queued
+ * by ospf_gr_lsa_check_add() since the last call are checked.
  */
 void ospf_gr_check_lsdb_consistency(struct ospf *ospf, struct ospf_area *area)
 {
 	struct route_node *rn;
+	struct listnode *node;
 	struct ospf_lsa *lsa;
+	struct list *lsas;
 
-	for (rn = route_top(ROUTER_LSDB(area)); rn; rn = route_next(rn)) {
-		lsa = rn->info;
-		if (!lsa)
-			continue;
+	if (area->gr_check_all) {
+		ospf_gr_lsa_check_clear(area);
 
-		if (!ospf_gr_check_router_lsa_consistency(ospf, area, lsa)) {
-			char reason[256];
+		for (rn = route_top(ROUTER_LSDB(area)); rn;
+		     rn = route_next(rn)) {
+			lsa = rn->info;
+			if (!lsa)
+				continue;
 
-			snprintfrr(reason, sizeof(reason),
-				   "detected inconsistent LSA[%s] [area %pI4]",
-				   dump_lsa_key(lsa), &area->area_id);
-			ospf_gr_restart_exit(ospf, reason);
-			route_unlock_node(rn);
-			return;
+			if (!ospf_gr_check_lsa(ospf, area, lsa)) {
+				route_unlock_node(rn);
+				return;
+			}
 		}
+		return;
+	}
+
+	/* exiting the restart clears the queue, so take it off the area */
+	lsas = area->gr_check_lsas;
+	area->gr_check_lsas = NULL;
+	if (!lsas)
+		return;
+
+	for (ALL_LIST_ELEMENTS_RO(lsas, node, lsa)) {
+		/* replaced by a newer instance, which is queued as well */
+		if (ospf_lsdb_lookup(area->lsdb, lsa) != lsa)
+			continue;
+
+		if (!ospf_gr_check_lsa(ospf, area, lsa))
+			break;
 	}
+	ospf_gr_lsa_list_free(&lsas);
 }
 
 /* Lookup neighbor by address in a given OSPF area. */
@@ -182,6 +182,9 @@ extern void ospf_gr_helper_supported_gracetime_set(struct ospf *ospf,
 extern void ospf_gr_helper_set_supported_planned_only_restart(struct ospf *ospf,
 							     bool planned_only);
 
+extern void ospf_gr_lsa_check_add(struct ospf_area *area,
+				  struct ospf_lsa *lsa);
+extern void ospf_gr_lsa_check_clear(struct ospf_area *area);
 extern void ospf_gr_check_lsdb_consistency(struct ospf *ospf,
 						  struct ospf_area *area);
 extern void ospf_gr_check_adjs(struct ospf *ospf);
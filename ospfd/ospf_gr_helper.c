@@ -570,38 +570,24 @@ int ospf_process_grace_lsa(struct ospf *ospf, struct ospf_lsa *lsa,
  */
 static bool ospf_check_change_in_rxmt_list(struct ospf_neighbor *nbr)
 {
-	struct route_node *rn;
 	struct ospf_lsa *lsa;
-	struct route_table *tbl;
-
-	tbl = nbr->ls_rxmt.type[OSPF_ROUTER_LSA].db;
-	LSDB_LOOP (tbl, rn, lsa)
-		if (lsa->to_be_acknowledged)
-			return OSPF_GR_TRUE;
-	tbl = nbr->ls_rxmt.type[OSPF_NETWORK_LSA].db;
-	LSDB_LOOP (tbl, rn, lsa)
-		if (lsa->to_be_acknowledged)
-			return OSPF_GR_TRUE;
-
-	tbl = nbr->ls_rxmt.type[OSPF_SUMMARY_LSA].db;
-	LSDB_LOOP (tbl, rn, lsa)
-		if (lsa->to_be_acknowledged)
-			return OSPF_GR_TRUE;
-
-	tbl = nbr->ls_rxmt.type[OSPF_ASBR_SUMMARY_LSA].db;
-	LSDB_LOOP (tbl, rn, lsa)
-		if (lsa->to_be_acknowledged)
-			return OSPF_GR_TRUE;
-
-	tbl = nbr->ls_rxmt.type[OSPF_AS_EXTERNAL_LSA].db;
-	LSDB_LOOP (tbl, rn, lsa)
-		if (lsa->to_be_acknowledged)
-			return OSPF_GR_TRUE;
-
-	tbl = nbr->ls_rxmt.type[OSPF_AS_NSSA_LSA].db;
-	LSDB_LOOP (tbl, rn, lsa)
-		if (lsa->to_be_acknowledged)
-			return OSPF_GR_TRUE;
+	uint32_t pos = 0;
+
+	while ((lsa = ospf_ls_retransmit_next(nbr, &pos))) {
+		switch (lsa->data->type) {
+		case OSPF_ROUTER_LSA:
+		case OSPF_NETWORK_LSA:
+		case OSPF_SUMMARY_LSA:
+		case OSPF_ASBR_SUMMARY_LSA:
+		case OSPF_AS_EXTERNAL_LSA:
+		case OSPF_AS_NSSA_LSA:
+			if (lsa->to_be_acknowledged)
+				return OSPF_GR_TRUE;
+			break;
+		default:
+			break;
+		}
+	}
 
 	return OSPF_GR_FALSE;
 }
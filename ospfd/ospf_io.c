@@ -0,0 +1,298 @@
+/*
+ * OSPF packet reception on a separate pthread.
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+
+#include "frr_pthread.h"
+#include "linklist.h"
+#include "memory.h"
+#include "network.h"
+#include "sockopt.h"
+#include "stream.h"
+#include "thread.h"
+
+#include "ospfd/ospfd.h"
+#include "ospfd/ospf_errors.h"
+#include "ospfd/ospf_io.h"
+#include "ospfd/ospf_packet.h"
+
+DEFINE_MTYPE_STATIC(OSPFD, OSPF_IO_PKT, "OSPF received packet");
+DEFINE_MTYPE_STATIC(OSPFD, OSPF_IO_BUF, "OSPF receive buffers");
+
+/* non-hello packets processed per run of ospf_io_process() */
+#define OSPF_IO_PROCESS_MAX 64
+
+PREDECL_LIST(ospf_rxq);
+
+struct ospf_rx_pkt {
+	struct ospf_rxq_item item;
+
+	struct ospf *ospf;
+	ifindex_t ifindex;
+	struct stream *s;
+};
+
+DECLARE_LIST(ospf_rxq, struct ospf_rx_pkt, item);
+
+static struct frr_pthread *ospf_pth_io;
+
+/* filled by the I/O pthread, drained by the main pthread */
+static pthread_mutex_t rx_mtx = PTHREAD_MUTEX_INITIALIZER;
+static struct ospf_rxq_head rx_hello, rx_other;
+static struct thread *t_rx_process;
+
+/* only touched by the I/O pthread */
+static uint8_t (*rx_bufs)[OSPF_MAX_PACKET_SIZE + 1];
+
+static void ospf_rx_pkt_free(struct ospf_rx_pkt *pkt)
+{
+	stream_free(pkt->s);
+	XFREE(MTYPE_OSPF_IO_PKT, pkt);
+}
+
+static void ospf_rxq_move(struct ospf_rxq_head *to, struct ospf_rxq_head *from,
+			  unsigned int max)
+{
+	struct ospf_rx_pkt *pkt;
+
+	while (max-- && (pkt = ospf_rxq_pop(from)))
+		ospf_rxq_add_tail(to, pkt);
+}
+
+/* main pthread */
+static int ospf_io_process(struct thread *thread)
+{
+	struct ospf_rxq_head hello, other;
+	struct ospf_rx_pkt *pkt;
+	bool more;
+
+	ospf_rxq_init(&hello);
+	ospf_rxq_init(&other);
+
+	frr_with_mutex(&rx_mtx) {
+		ospf_rxq_move(&hello, &rx_hello, UINT_MAX);
+		ospf_rxq_move(&other, &rx_other, OSPF_IO_PROCESS_MAX);
+		more = ospf_rxq_count(&rx_other) > 0;
+	}
+
+	/* hellos first, they are what keeps the adjacencies up */
+	while ((pkt = ospf_rxq_pop(&hello))) {
+		ospf_packet_input(pkt->ospf, pkt->s, pkt->ifindex);
+		ospf_rx_pkt_free(pkt);
+	}
+	while ((pkt = ospf_rxq_pop(&other))) {
+		ospf_packet_input(pkt->ospf, pkt->s, pkt->ifindex);
+		ospf_rx_pkt_free(pkt);
+	}
+
+	ospf_rxq_fini(&hello);
+	ospf_rxq_fini(&other);
+
+	if (more)
+		thread_add_event(master, ospf_io_process, NULL, 0,
+				 &t_rx_process);
+	return 0;
+}
+
+#ifndef HAVE_RECVMMSG
+struct mmsghdr {
+	struct msghdr msg_hdr;
+	unsigned int msg_len;
+};
+
+static int recvmmsg(int fd, struct mmsghdr *msgs, unsigned int n, int flags,
+		    struct timespec *timeout)
+{
+	unsigned int i;
+	ssize_t len;
+
+	for (i = 0; i < n; i++) {
+		len = recvmsg(fd, &msgs[i].msg_hdr, flags);
+		if (len < 0)
+			return i ? (int)i : -1;
+		msgs[i].msg_len = len;
+	}
+	return n;
+}
+#endif
+
+/* I/O pthread */
+static int ospf_io_read(struct thread *thread)
+{
+	struct ospf *ospf = THREAD_ARG(thread);
+	struct mmsghdr msgs[OSPF_IO_BATCH];
+	struct iovec iov[OSPF_IO_BATCH];
+	char cmsg[OSPF_IO_BATCH][CMSG_SPACE(SOPT_SIZE_CMSG_IFINDEX_IPV4())];
+	struct ospf_rxq_head hello, other;
+	struct ospf_rx_pkt *pkt;
+	struct ospf_header *ospfh;
+	struct stream *s;
+	unsigned int len;
+	int i, n;
+
+	thread_add_read(ospf_pth_io->master, ospf_io_read, ospf, ospf->fd,
+			&ospf->t_read);
+
+	memset(msgs, 0, sizeof(msgs));
+	for (i = 0; i < OSPF_IO_BATCH; i++) {
+		iov[i].iov_base = rx_bufs[i];
+		iov[i].iov_len = sizeof(rx_bufs[i]);
+		msgs[i].msg_hdr.msg_iov = &iov[i];
+		msgs[i].msg_hdr.msg_iovlen = 1;
+		msgs[i].msg_hdr.msg_control = cmsg[i];
+		msgs[i].msg_hdr.msg_controllen = sizeof(cmsg[i]);
+	}
+
+	n = recvmmsg(ospf->fd, msgs, OSPF_IO_BATCH, MSG_DONTWAIT, NULL);
+	if (n < 0) {
+		if (!ERRNO_IO_RETRY(errno))
+			flog_warn(EC_OSPF_PACKET, "recvmmsg failed: %s",
+				  safe_strerror(errno));
+		return 0;
+	}
+
+	ospf_rxq_init(&hello);
+	ospf_rxq_init(&other);
+
+	for (i = 0; i < n; i++) {
+		len = msgs[i].msg_len;
+		s = stream_new(len + 1);
+		stream_put(s, rx_bufs[i], len);
+
+		if (ospf_packet_verify(s, len) < 0) {
+			stream_free(s);
+			continue;
+		}
+
+		pkt = XCALLOC(MTYPE_OSPF_IO_PKT, sizeof(*pkt));
+		pkt->ospf = ospf;
+		pkt->ifindex = getsockopt_ifindex(AF_INET, &msgs[i].msg_hdr);
+		pkt->s = s;
+
+		ospfh = (struct ospf_header *)stream_pnt(s);
+		if (ospfh->type == OSPF_MSG_HELLO)
+			ospf_rxq_add_tail(&hello, pkt);
+		else
+			ospf_rxq_add_tail(&other, pkt);
+	}
+
+	if (ospf_rxq_count(&hello) || ospf_rxq_count(&other)) {
+		frr_with_mutex(&rx_mtx) {
+			ospf_rxq_move(&rx_hello, &hello, UINT_MAX);
+			ospf_rxq_move(&rx_other, &other, UINT_MAX);
+		}
+		thread_add_event(master, ospf_io_process, NULL, 0,
+				 &t_rx_process);
+	}
+
+	ospf_rxq_fini(&hello);
+	ospf_rxq_fini(&other);
+	return 0;
+}
+
+void ospf_reads_on(struct ospf *ospf)
+{
+	if (!ospf_pth_io) {
+		thread_add_read(master, ospf_read, ospf, ospf->fd,
+				&ospf->t_read);
+		return;
+	}
+
+	thread_add_read(ospf_pth_io->master, ospf_io_read, ospf, ospf->fd,
+			&ospf->t_read);
+}
+
+static void ospf_rxq_drop(struct ospf_rxq_head *q, struct ospf *ospf)
+{
+	struct ospf_rx_pkt *pkt;
+
+	frr_each_safe (ospf_rxq, q, pkt) {
+		if (pkt->ospf != ospf)
+			continue;
+		ospf_rxq_del(q, pkt);
+		ospf_rx_pkt_free(pkt);
+	}
+}
+
+void ospf_reads_off(struct ospf *ospf)
+{
+	if (!ospf_pth_io) {
+		THREAD_OFF(ospf->t_read);
+		return;
+	}
+
+	thread_cancel_async(ospf_pth_io->master, &ospf->t_read, NULL);
+
+	frr_with_mutex(&rx_mtx) {
+		ospf_rxq_drop(&rx_hello, ospf);
+		ospf_rxq_drop(&rx_other, ospf);
+	}
+}
+
+void ospf_io_init(void)
+{
+	struct frr_pthread_attr attr = {
+		.start = frr_pthread_attr_default.start,
+		.stop = frr_pthread_attr_default.stop,
+	};
+
+	assert(!ospf_pth_io);
+
+	ospf_rxq_init(&rx_hello);
+	ospf_rxq_init(&rx_other);
+	rx_bufs = XMALLOC(MTYPE_OSPF_IO_BUF, OSPF_IO_BATCH * sizeof(*rx_bufs));
+
+	ospf_pth_io = frr_pthread_new(&attr, "OSPF I/O thread", "ospfd_io");
+}
+
+void ospf_io_run(void)
+{
+	if (!ospf_pth_io)
+		return;
+
+	frr_pthread_run(ospf_pth_io, NULL);
+	frr_pthread_wait_running(ospf_pth_io);
+}
+
+void ospf_io_finish(void)
+{
+	struct ospf_rx_pkt *pkt;
+	struct listnode *node;
+	struct ospf *ospf;
+
+	if (!ospf_pth_io)
+		return;
+
+	for (ALL_LIST_ELEMENTS_RO(om->ospf, node, ospf))
+		ospf_reads_off(ospf);
+
+	frr_pthread_stop(ospf_pth_io, NULL);
+	frr_pthread_destroy(ospf_pth_io);
+	ospf_pth_io = NULL;
+
+	THREAD_OFF(t_rx_process);
+	while ((pkt = ospf_rxq_pop(&rx_hello)))
+		ospf_rx_pkt_free(pkt);
+	while ((pkt = ospf_rxq_pop(&rx_other)))
+		ospf_rx_pkt_free(pkt);
+	ospf_rxq_fini(&rx_hello);
+	ospf_rxq_fini(&rx_other);
+
+	XFREE(MTYPE_OSPF_IO_BUF, rx_bufs);
+}
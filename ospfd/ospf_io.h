@@ -0,0 +1,47 @@
+/*
+ * OSPF packet reception on a separate pthread.
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _FRR_OSPF_IO_H
+#define _FRR_OSPF_IO_H
+
+/*
+ * With --io-pthread, the OSPF sockets are read on a pthread of their own,
+ * in batches of up to OSPF_IO_BATCH packets.  Packets that pass the checks
+ * not needing any OSPF state (ospf_packet_verify()) are queued for the main
+ * pthread, which processes hellos ahead of everything else so a flood of
+ * LS Updates doesn't make neighbors miss their dead interval.
+ */
+
+#define OSPF_IO_BATCH 32
+
+struct ospf;
+
+/* Create the I/O pthread; ospf_io_run() starts it after daemonizing. */
+extern void ospf_io_init(void);
+extern void ospf_io_run(void);
+extern void ospf_io_finish(void);
+
+/* Start/stop reading an instance's socket, on the I/O pthread if there is
+ * one.  After ospf_reads_off() returns, nothing from the socket is left
+ * queued and it can be closed.
+ */
+extern void ospf_reads_on(struct ospf *ospf);
+extern void ospf_reads_off(struct ospf *ospf);
+
+#endif /* _FRR_OSPF_IO_H */
@@ -52,6 +52,7 @@
 #include "ospfd/ospf_zebra.h"
 #include "ospfd/ospf_abr.h"
 #include "ospfd/ospf_errors.h"
+#include "ospfd/ospf_gr.h"
 
 uint32_t get_metric(uint8_t *metric)
 {
@@ -2460,6 +2461,10 @@ ospf_router_lsa_install(struct ospf *ospf, struct ospf_lsa *new, int rt_recalc)
 	   area whose link-state database has changed).
 	*/
 
+	/* To be checked against the pre-restart LSAs */
+	if (ospf->gr_info.restart_in_progress)
+		ospf_gr_lsa_check_add(area, new);
+
 	if (IS_LSA_SELF(new)) {
 
 		/* Only install LSA if it is originated/refreshed by us.
@@ -2707,6 +2712,8 @@ struct ospf_lsa *ospf_lsa_install(struct ospf *ospf, struct ospf_interface *oi,
 		if (CHECK_LSA_TYPE_1_TO_5_OR_7(lsa->data->type))
 			ospf_helper_handle_topo_chg(ospf, lsa);
 
+		ospf_spf_lsa_changed(old, lsa);
+
 		rt_recalc = 1;
 	}
 
@@ -3066,6 +3073,7 @@ static int ospf_lsa_maxage_walker_remover(struct ospf *ospf,
 				ospf_ase_incremental_update(ospf, lsa);
 				break;
 			default:
+				ospf_spf_lsa_changed(lsa, NULL);
 				ospf_spf_calculate_schedule(ospf,
 							    SPF_FLAG_MAXAGE);
 				break;
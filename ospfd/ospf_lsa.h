@@ -23,6 +23,7 @@
 #define _ZEBRA_OSPF_LSA_H
 
 #include "stream.h"
+#include "typesafe.h"
 
 /* OSPF LSA Default metric values */
 #define DEFAULT_DEFAULT_METRIC 20
@@ -72,6 +73,9 @@ struct lsa_header {
 struct vertex;
 
 /* OSPF LSA. */
+PREDECL_DLIST(ospf_ase_asbr_lsas);
+PREDECL_DLIST(ospf_ase_fwd_lsas);
+
 struct ospf_lsa {
 	/* LSA origination flag. */
 	uint8_t flags;
@@ -123,6 +127,10 @@ struct ospf_lsa {
 
 	/*For topo chg detection in HELPER role*/
 	bool to_be_acknowledged;
+
+	/* AS-external/NSSA-LSAs, indexed by ASBR and forwarding address */
+	struct ospf_ase_asbr_lsas_item ase_asbr_item;
+	struct ospf_ase_fwd_lsas_item ase_fwd_item;
 };
 
 /* OSPF LSA Link Type. */
@@ -21,6 +21,7 @@
 
 #include <zebra.h>
 
+#include "jhash.h"
 #include "prefix.h"
 #include "table.h"
 #include "memory.h"
@@ -31,6 +32,59 @@
 #include "ospfd/ospf_lsa.h"
 #include "ospfd/ospf_lsdb.h"
 
+DEFINE_MTYPE_STATIC(OSPFD, OSPF_LSDB_HASH, "OSPF LSDB hash entry");
+
+/*
+ * The route tables keep each type's LSAs ordered, for the show commands,
+ * DD exchange and the _next lookups.  Exact lookups, which is what SPF and
+ * flooding do, go through a hash of the tables' nodes instead of walking the
+ * trie.  There is an entry for every node that holds an LSA.
+ */
+struct ospf_lsdb_hent {
+	struct ospf_lsdb_hash_item item;
+	struct in_addr id;
+	struct in_addr adv_router;
+	struct route_node *rn;
+};
+
+static int ospf_lsdb_hent_cmp(const struct ospf_lsdb_hent *a,
+			      const struct ospf_lsdb_hent *b)
+{
+	if (a->id.s_addr != b->id.s_addr)
+		return numcmp(a->id.s_addr, b->id.s_addr);
+	return numcmp(a->adv_router.s_addr, b->adv_router.s_addr);
+}
+
+static uint32_t ospf_lsdb_hent_hash(const struct ospf_lsdb_hent *a)
+{
+	return jhash_2words(a->id.s_addr, a->adv_router.s_addr, 0);
+}
+
+DECLARE_HASH(ospf_lsdb_hash, struct ospf_lsdb_hent, item, ospf_lsdb_hent_cmp,
+	     ospf_lsdb_hent_hash);
+
+static struct ospf_lsdb_hent *ospf_lsdb_hent_find(struct ospf_lsdb *lsdb,
+						  uint8_t type,
+						  struct in_addr id,
+						  struct in_addr adv_router)
+{
+	struct ospf_lsdb_hent ref;
+
+	ref.id = id;
+	ref.adv_router = adv_router;
+	return ospf_lsdb_hash_find(&lsdb->type[type].hash, &ref);
+}
+
+static struct route_node *ospf_lsdb_node_find(struct ospf_lsdb *lsdb,
+					      uint8_t type, struct in_addr id,
+					      struct in_addr adv_router)
+{
+	struct ospf_lsdb_hent *hent;
+
+	hent = ospf_lsdb_hent_find(lsdb, type, id, adv_router);
+	return hent ? hent->rn : NULL;
+}
+
 struct ospf_lsdb *ospf_lsdb_new(void)
 {
 	struct ospf_lsdb *new;
@@ -45,8 +99,10 @@ void ospf_lsdb_init(struct ospf_lsdb *lsdb)
 {
 	int i;
 
-	for (i = OSPF_MIN_LSA; i < OSPF_MAX_LSA; i++)
+	for (i = OSPF_MIN_LSA; i < OSPF_MAX_LSA; i++) {
 		lsdb->type[i].db = route_table_init();
+		ospf_lsdb_hash_init(&lsdb->type[i].hash);
+	}
 }
 
 void ospf_lsdb_free(struct ospf_lsdb *lsdb)
@@ -63,8 +119,10 @@ void ospf_lsdb_cleanup(struct ospf_lsdb *lsdb)
 
 	ospf_lsdb_delete_all(lsdb);
 
-	for (i = OSPF_MIN_LSA; i < OSPF_MAX_LSA; i++)
+	for (i = OSPF_MIN_LSA; i < OSPF_MAX_LSA; i++) {
 		route_table_finish(lsdb->type[i].db);
+		ospf_lsdb_hash_fini(&lsdb->type[i].hash);
+	}
 }
 
 void ls_prefix_set(struct prefix_ls *lp, struct ospf_lsa *lsa)
@@ -81,12 +139,19 @@ static void ospf_lsdb_delete_entry(struct ospf_lsdb *lsdb,
 				   struct route_node *rn)
 {
 	struct ospf_lsa *lsa = rn->info;
+	struct ospf_lsdb_hent *hent;
 
 	if (!lsa)
 		return;
 
 	assert(rn->table == lsdb->type[lsa->data->type].db);
 
+	hent = ospf_lsdb_hent_find(lsdb, lsa->data->type, lsa->data->id,
+				   lsa->data->adv_router);
+	assert(hent && hent->rn == rn);
+	ospf_lsdb_hash_del(&lsdb->type[lsa->data->type].hash, hent);
+	XFREE(MTYPE_OSPF_LSDB_HASH, hent);
+
 	if (IS_LSA_SELF(lsa))
 		lsdb->type[lsa->data->type].count_self--;
 	lsdb->type[lsa->data->type].count--;
@@ -108,20 +173,29 @@ void ospf_lsdb_add(struct ospf_lsdb *lsdb, struct ospf_lsa *lsa)
 	struct route_table *table;
 	struct prefix_ls lp;
 	struct route_node *rn;
+	struct ospf_lsdb_hent *hent;
 
-	table = lsdb->type[lsa->data->type].db;
-	ls_prefix_set(&lp, lsa);
-	rn = route_node_get(table, (struct prefix *)&lp);
+	rn = ospf_lsdb_node_find(lsdb, lsa->data->type, lsa->data->id,
+				 lsa->data->adv_router);
+	if (rn) {
+		/* nothing to do? */
+		if (rn->info == lsa)
+			return;
 
-	/* nothing to do? */
-	if (rn->info && rn->info == lsa) {
-		route_unlock_node(rn);
-		return;
+		/* purge old entry, keeping the node for the new one */
+		route_lock_node(rn);
+		ospf_lsdb_delete_entry(lsdb, rn);
+	} else {
+		table = lsdb->type[lsa->data->type].db;
+		ls_prefix_set(&lp, lsa);
+		rn = route_node_get(table, (struct prefix *)&lp);
 	}
 
-	/* purge old entry? */
-	if (rn->info)
-		ospf_lsdb_delete_entry(lsdb, rn);
+	hent = XCALLOC(MTYPE_OSPF_LSDB_HASH, sizeof(*hent));
+	hent->id = lsa->data->id;
+	hent->adv_router = lsa->data->adv_router;
+	hent->rn = rn;
+	ospf_lsdb_hash_add(&lsdb->type[lsa->data->type].hash, hent);
 
 	if (IS_LSA_SELF(lsa))
 		lsdb->type[lsa->data->type].count_self++;
@@ -138,21 +212,16 @@ void ospf_lsdb_add(struct ospf_lsdb *lsdb, struct ospf_lsa *lsa)
 
 void ospf_lsdb_delete(struct ospf_lsdb *lsdb, struct ospf_lsa *lsa)
 {
-	struct route_table *table;
-	struct prefix_ls lp;
 	struct route_node *rn;
 
 	if (!lsdb || !lsa)
 		return;
 
 	assert(lsa->data->type < OSPF_MAX_LSA);
-	table = lsdb->type[lsa->data->type].db;
-	ls_prefix_set(&lp, lsa);
-	if ((rn = route_node_lookup(table, (struct prefix *)&lp))) {
-		if (rn->info == lsa)
-			ospf_lsdb_delete_entry(lsdb, rn);
-		route_unlock_node(rn); /* route_node_lookup */
-	}
+	rn = ospf_lsdb_node_find(lsdb, lsa->data->type, lsa->data->id,
+				 lsa->data->adv_router);
+	if (rn && rn->info == lsa)
+		ospf_lsdb_delete_entry(lsdb, rn);
 }
 
 void ospf_lsdb_delete_all(struct ospf_lsdb *lsdb)
@@ -171,46 +240,21 @@ void ospf_lsdb_delete_all(struct ospf_lsdb *lsdb)
 
 struct ospf_lsa *ospf_lsdb_lookup(struct ospf_lsdb *lsdb, struct ospf_lsa *lsa)
 {
-	struct route_table *table;
-	struct prefix_ls lp;
 	struct route_node *rn;
-	struct ospf_lsa *find;
 
-	table = lsdb->type[lsa->data->type].db;
-	ls_prefix_set(&lp, lsa);
-	rn = route_node_lookup(table, (struct prefix *)&lp);
-	if (rn) {
-		find = rn->info;
-		route_unlock_node(rn);
-		return find;
-	}
-	return NULL;
+	rn = ospf_lsdb_node_find(lsdb, lsa->data->type, lsa->data->id,
+				 lsa->data->adv_router);
+	return rn ? rn->info : NULL;
 }
 
 struct ospf_lsa *ospf_lsdb_lookup_by_id(struct ospf_lsdb *lsdb, uint8_t type,
 					struct in_addr id,
 					struct in_addr adv_router)
 {
-	struct route_table *table;
-	struct prefix_ls lp;
 	struct route_node *rn;
-	struct ospf_lsa *find;
-
-	table = lsdb->type[type].db;
 
-	memset(&lp, 0, sizeof(struct prefix_ls));
-	lp.family = 0;
-	lp.prefixlen = 64;
-	lp.id = id;
-	lp.adv_router = adv_router;
-
-	rn = route_node_lookup(table, (struct prefix *)&lp);
-	if (rn) {
-		find = rn->info;
-		route_unlock_node(rn);
-		return find;
-	}
-	return NULL;
+	rn = ospf_lsdb_node_find(lsdb, type, id, adv_router);
+	return rn ? rn->info : NULL;
 }
 
 struct ospf_lsa *ospf_lsdb_lookup_by_id_next(struct ospf_lsdb *lsdb,
@@ -218,25 +262,16 @@ struct ospf_lsa *ospf_lsdb_lookup_by_id_next(struct ospf_lsdb *lsdb,
 					     struct in_addr adv_router,
 					     int first)
 {
-	struct route_table *table;
-	struct prefix_ls lp;
 	struct route_node *rn;
 	struct ospf_lsa *find;
 
-	table = lsdb->type[type].db;
-
-	memset(&lp, 0, sizeof(struct prefix_ls));
-	lp.family = 0;
-	lp.prefixlen = 64;
-	lp.id = id;
-	lp.adv_router = adv_router;
-
 	if (first)
-		rn = route_top(table);
+		rn = route_top(lsdb->type[type].db);
 	else {
-		if ((rn = route_node_lookup(table, (struct prefix *)&lp))
-		    == NULL)
+		rn = ospf_lsdb_node_find(lsdb, type, id, adv_router);
+		if (rn == NULL)
 			return NULL;
+		route_lock_node(rn);
 		rn = route_next(rn);
 	}
 
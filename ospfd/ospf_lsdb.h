@@ -22,6 +22,10 @@
 #ifndef _ZEBRA_OSPF_LSDB_H
 #define _ZEBRA_OSPF_LSDB_H
 
+#include "typesafe.h"
+
+PREDECL_HASH(ospf_lsdb_hash);
+
 /* OSPF LSDB structure. */
 struct ospf_lsdb {
 	struct {
@@ -29,6 +33,8 @@ struct ospf_lsdb {
 		unsigned long count_self;
 		unsigned int checksum;
 		struct route_table *db;
+		/* (LS ID, Adv Router) -> node of db, for exact lookups */
+		struct ospf_lsdb_hash_head hash;
 	} type[OSPF_MAX_LSA];
 	unsigned long total;
 #define MONITOR_LSDB_CHANGE 1 /* XXX */
@@ -58,6 +58,7 @@
 #include "ospfd/ospf_errors.h"
 #include "ospfd/ospf_ldp_sync.h"
 #include "ospfd/ospf_routemap_nb.h"
+#include "ospfd/ospf_io.h"
 
 /* ospfd privileges */
 zebra_capabilities_t _caps_p[] = {ZCAP_NET_RAW, ZCAP_BIND, ZCAP_NET_ADMIN,
@@ -76,9 +77,11 @@ struct zebra_privs_t ospfd_privs = {
 	.cap_num_i = 0};
 
 /* OSPFd options. */
+#define OPTION_IO_PTHREAD 2000
 const struct option longopts[] = {
 	{"instance", required_argument, NULL, 'n'},
 	{"apiserver", no_argument, NULL, 'a'},
+	{"io-pthread", no_argument, NULL, OPTION_IO_PTHREAD},
 	{0}
 };
 
@@ -152,6 +155,8 @@ FRR_DAEMON_INFO(ospfd, OSPF, .vty_port = OSPF_VTY_PORT,
 /* OSPFd main routine. */
 int main(int argc, char **argv)
 {
+	bool io_pthread = false;
+
 #ifdef SUPPORT_OSPF_API
 	/* OSPF apiserver is disabled by default. */
 	ospf_apiserver_enable = 0;
@@ -160,7 +165,8 @@ int main(int argc, char **argv)
 	frr_preinit(&ospfd_di, argc, argv);
 	frr_opt_add("n:a", longopts,
 		    "  -n, --instance     Set the instance id\n"
-		    "  -a, --apiserver    Enable OSPF apiserver\n");
+		    "  -a, --apiserver    Enable OSPF apiserver\n"
+		    "      --io-pthread   Receive packets on a separate pthread\n");
 
 	while (1) {
 		int opt;
@@ -183,6 +189,9 @@ int main(int argc, char **argv)
 			ospf_apiserver_enable = 1;
 			break;
 #endif /* SUPPORT_OSPF_API */
+		case OPTION_IO_PTHREAD:
+			io_pthread = true;
+			break;
 		default:
 			frr_help_exit(1);
 			break;
@@ -232,7 +241,11 @@ int main(int argc, char **argv)
 	/* OSPF errors init */
 	ospf_error_init();
 
+	if (io_pthread)
+		ospf_io_init();
+
 	frr_config_fork();
+	ospf_io_run();
 	frr_run(master);
 
 	/* Not reached. */
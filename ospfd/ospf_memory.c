@@ -38,6 +38,8 @@ DEFINE_MTYPE(OSPFD, OSPF_TMP, "OSPF tmp mem");
 DEFINE_MTYPE(OSPFD, OSPF_LSA, "OSPF LSA");
 DEFINE_MTYPE(OSPFD, OSPF_LSA_DATA, "OSPF LSA data");
 DEFINE_MTYPE(OSPFD, OSPF_LSDB, "OSPF LSDB");
+DEFINE_MTYPE(OSPFD, OSPF_RXMT_SLOT, "OSPF retransmit slot");
+DEFINE_MTYPE(OSPFD, OSPF_RXMT_BITS, "OSPF retransmit bitmap");
 DEFINE_MTYPE(OSPFD, OSPF_PACKET, "OSPF packet");
 DEFINE_MTYPE(OSPFD, OSPF_FIFO, "OSPF FIFO queue");
 DEFINE_MTYPE(OSPFD, OSPF_VERTEX, "OSPF vertex");
@@ -37,6 +37,8 @@ DECLARE_MTYPE(OSPF_TMP);
 DECLARE_MTYPE(OSPF_LSA);
 DECLARE_MTYPE(OSPF_LSA_DATA);
 DECLARE_MTYPE(OSPF_LSDB);
+DECLARE_MTYPE(OSPF_RXMT_SLOT);
+DECLARE_MTYPE(OSPF_RXMT_BITS);
 DECLARE_MTYPE(OSPF_PACKET);
 DECLARE_MTYPE(OSPF_FIFO);
 DECLARE_MTYPE(OSPF_VERTEX);
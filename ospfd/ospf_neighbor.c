@@ -95,7 +95,6 @@ struct ospf_neighbor *ospf_nbr_new(struct ospf_interface *oi)
 	nbr->nbr_nbma = NULL;
 
 	ospf_lsdb_init(&nbr->db_sum);
-	ospf_lsdb_init(&nbr->ls_rxmt);
 	ospf_lsdb_init(&nbr->ls_req);
 
 	nbr->crypt_seqnum = 0;
@@ -128,7 +127,7 @@ void ospf_nbr_free(struct ospf_neighbor *nbr)
 	/* Cleanup LSDBs. */
 	ospf_lsdb_cleanup(&nbr->db_sum);
 	ospf_lsdb_cleanup(&nbr->ls_req);
-	ospf_lsdb_cleanup(&nbr->ls_rxmt);
+	XFREE(MTYPE_OSPF_RXMT_BITS, nbr->ls_rxmt.bits);
 
 	/* Clear last send packet. */
 	if (nbr->last_send)
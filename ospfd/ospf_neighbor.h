@@ -25,6 +25,13 @@
 #include <ospfd/ospf_gr.h>
 #include <ospfd/ospf_packet.h>
 
+/* LS retransmit list, a bit per slot of the instance's ospf_rxmt_slots */
+struct ospf_rxmt_bits {
+	uint64_t *bits;
+	uint32_t words;
+	uint32_t count;
+};
+
 /* Neighbor Data Structure */
 struct ospf_neighbor {
 	/* This neighbor's parent ospf interface. */
@@ -58,7 +65,7 @@ struct ospf_neighbor {
 	} last_recv;
 
 	/* LSA data. */
-	struct ospf_lsdb ls_rxmt;
+	struct ospf_rxmt_bits ls_rxmt;
 	struct ospf_lsdb db_sum;
 	struct ospf_lsdb ls_req;
 	struct ospf_lsa *ls_req_last;
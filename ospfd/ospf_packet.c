@@ -115,6 +115,7 @@ static const uint16_t ospf_lsa_minlen[] = {
 
 /* for ospf_check_auth() */
 static int ospf_check_sum(struct ospf_header *);
+static unsigned ospf_packet_examin(struct ospf_header *, const unsigned);
 
 /* OSPF authentication checking function */
 static int ospf_auth_type(struct ospf_interface *oi)
@@ -139,7 +140,7 @@ static struct ospf_packet *ospf_packet_new(size_t size)
 	struct ospf_packet *new;
 
 	new = XCALLOC(MTYPE_OSPF_PACKET, sizeof(struct ospf_packet));
-	new->s = stream_new(size);
+	new->s = stream_new_pooled(size);
 
 	return new;
 }
@@ -484,42 +485,27 @@ int ospf_ls_upd_timer(struct thread *thread)
 	/* Send Link State Update. */
 	if (ospf_ls_retransmit_count(nbr) > 0) {
 		struct list *update;
-		struct ospf_lsdb *lsdb;
-		int i;
+		struct ospf_lsa *lsa;
+		uint32_t pos = 0;
 		int retransmit_interval;
 
 		retransmit_interval =
 			OSPF_IF_PARAM(nbr->oi, retransmit_interval);
 
-		lsdb = &nbr->ls_rxmt;
 		update = list_new();
 
-		for (i = OSPF_MIN_LSA; i < OSPF_MAX_LSA; i++) {
-			struct route_table *table = lsdb->type[i].db;
-			struct route_node *rn;
-
-			for (rn = route_top(table); rn; rn = route_next(rn)) {
-				struct ospf_lsa *lsa;
-
-				if ((lsa = rn->info) != NULL) {
-					/* Don't retransmit an LSA if we
-					  received it within
-					  the last RxmtInterval seconds - this
-					  is to allow the
-					  neighbour a chance to acknowledge the
-					  LSA as it may
-					  have ben just received before the
-					  retransmit timer
-					  fired.  This is a small tweak to what
-					  is in the RFC,
-					  but it will cut out out a lot of
-					  retransmit traffic
-					  - MAG */
-					if (monotime_since(&lsa->tv_recv, NULL)
-					    >= retransmit_interval * 1000000LL)
-						listnode_add(update, rn->info);
-				}
-			}
+		while ((lsa = ospf_ls_retransmit_next(nbr, &pos))) {
+			/* Don't retransmit an LSA if we received it within
+			 * the last RxmtInterval seconds - this is to allow the
+			 * neighbour a chance to acknowledge the LSA as it may
+			 * have ben just received before the retransmit timer
+			 * fired.  This is a small tweak to what is in the RFC,
+			 * but it will cut out out a lot of retransmit traffic
+			 * - MAG
+			 */
+			if (monotime_since(&lsa->tv_recv, NULL)
+			    >= retransmit_interval * 1000000LL)
+				listnode_add(update, lsa);
 		}
 
 		if (listcount(update) > 0)
@@ -2281,14 +2267,9 @@ static void ospf_ls_ack(struct ip *iph, struct ospf_header *ospfh,
 	return;
 }
 
-static struct stream *ospf_recv_packet(struct ospf *ospf, int fd,
-				       struct interface **ifp,
-				       struct stream *ibuf)
+static int ospf_recv_packet(int fd, ifindex_t *ifindex, struct stream *ibuf)
 {
 	int ret;
-	struct ip *iph;
-	uint16_t ip_len;
-	ifindex_t ifindex = 0;
 	struct iovec iov;
 	/* Header and data both require alignment. */
 	char buff[CMSG_SPACE(SOPT_SIZE_CMSG_IFINDEX_IPV4())];
@@ -2306,14 +2287,30 @@ static struct stream *ospf_recv_packet(struct ospf *ospf, int fd,
 		if (errno != EAGAIN && errno != EWOULDBLOCK)
 			flog_warn(EC_OSPF_PACKET, "stream_recvmsg failed: %s",
 				  safe_strerror(errno));
-		return NULL;
+		return -1;
 	}
-	if ((unsigned int)ret < sizeof(struct ip)) {
+
+	*ifindex = getsockopt_ifindex(AF_INET, &msgh);
+	return ret;
+}
+
+/*
+ * Checks that only need the packet itself: IP header, OSPF header and the
+ * length/alignment of the body.  'len' is what the socket returned.  Leaves
+ * the stream's getp at the OSPF header.  Doesn't touch any OSPF state, so
+ * it can run on the I/O pthread.
+ */
+int ospf_packet_verify(struct stream *ibuf, int len)
+{
+	struct ip *iph;
+	uint16_t ip_len;
+
+	if ((unsigned int)len < sizeof(struct ip)) {
 		flog_warn(
 			EC_OSPF_PACKET,
 			"ospf_recv_packet: discarding runt packet of length %d (ip header size is %u)",
-			ret, (unsigned int)sizeof(iph));
-		return NULL;
+			len, (unsigned int)sizeof(iph));
+		return -1;
 	}
 
 	/* Note that there should not be alignment problems with this assignment
@@ -2350,23 +2347,39 @@ static struct stream *ospf_recv_packet(struct ospf *ospf, int fd,
 	ip_len = ntohs(iph->ip_len) + (iph->ip_hl << 2);
 #endif
 
-	ifindex = getsockopt_ifindex(AF_INET, &msgh);
-
-	*ifp = if_lookup_by_index(ifindex, ospf->vrf_id);
-
-	if (ret != ip_len) {
+	if (len != ip_len) {
 		flog_warn(
 			EC_OSPF_PACKET,
 			"ospf_recv_packet read length mismatch: ip_len is %d, but recvmsg returned %d",
-			ip_len, ret);
-		return NULL;
+			ip_len, len);
+		return -1;
 	}
 
-	if (IS_DEBUG_OSPF_PACKET(0, RECV))
-		zlog_debug("%s: fd %d(%s) on interface %d(%s)", __func__, fd,
-			   ospf_get_name(ospf), ifindex,
-			   *ifp ? (*ifp)->name : "Unknown");
-	return ibuf;
+	/* Check that we have enough for an IP header */
+	if ((unsigned int)(iph->ip_hl << 2) >= STREAM_READABLE(ibuf)) {
+		if ((unsigned int)(iph->ip_hl << 2) == STREAM_READABLE(ibuf)) {
+			flog_warn(
+				EC_OSPF_PACKET,
+				"Rx'd IP packet with OSPF protocol number but no payload");
+		} else {
+			flog_warn(
+				EC_OSPF_PACKET,
+				"IP header length field claims header is %u bytes, but we only have %zu",
+				(unsigned int)(iph->ip_hl << 2),
+				STREAM_READABLE(ibuf));
+		}
+
+		return -1;
+	}
+	stream_forward_getp(ibuf, iph->ip_hl << 2);
+
+	if (MSG_OK
+	    != ospf_packet_examin((struct ospf_header *)stream_pnt(ibuf),
+				  stream_get_endp(ibuf)
+					  - stream_get_getp(ibuf)))
+		return -1;
+
+	return 0;
 }
 
 static struct ospf_interface *
@@ -2940,21 +2953,20 @@ enum ospf_read_return_enum {
 	OSPF_READ_CONTINUE,
 };
 
-static enum ospf_read_return_enum ospf_read_helper(struct ospf *ospf)
+/*
+ * Process a packet that passed ospf_packet_verify(), received on 'ifindex'
+ * (0 if unknown).
+ */
+void ospf_packet_input(struct ospf *ospf, struct stream *ibuf,
+		       ifindex_t ifindex)
 {
 	int ret;
-	struct stream *ibuf;
 	struct ospf_interface *oi;
 	struct ip *iph;
 	struct ospf_header *ospfh;
 	uint16_t length;
 	struct connected *c;
-	struct interface *ifp = NULL;
-
-	stream_reset(ospf->ibuf);
-	ibuf = ospf_recv_packet(ospf, ospf->fd, &ifp, ospf->ibuf);
-	if (ibuf == NULL)
-		return OSPF_READ_ERROR;
+	struct interface *ifp;
 
 	/*
 	 * This raw packet is known to be at least as big as its
@@ -2965,8 +2977,15 @@ static enum ospf_read_return_enum ospf_read_helper(struct ospf *ospf)
 	iph = (struct ip *)STREAM_DATA(ibuf);
 	/*
 	 * Note that sockopt_iphdrincl_swab_systoh was called in
-	 * ospf_recv_packet.
+	 * ospf_packet_verify.
 	 */
+	ifp = if_lookup_by_index(ifindex, ospf->vrf_id);
+
+	if (IS_DEBUG_OSPF_PACKET(0, RECV))
+		zlog_debug("%s: fd %d(%s) on interface %d(%s)", __func__,
+			   ospf->fd, ospf_get_name(ospf), ifindex,
+			   ifp ? ifp->name : "Unknown");
+
 	if (ifp == NULL) {
 		/*
 		 * Handle cases where the platform does not support
@@ -2984,7 +3003,7 @@ static enum ospf_read_return_enum ospf_read_helper(struct ospf *ospf)
 					"%s: Unable to determine incoming interface from: %pI4(%s)",
 					__func__, &iph->ip_src,
 					ospf_get_name(ospf));
-			return OSPF_READ_CONTINUE;
+			return;
 		}
 	}
 
@@ -2995,7 +3014,7 @@ static enum ospf_read_return_enum ospf_read_helper(struct ospf *ospf)
 		 * ospf really really really does not like when
 		 * we receive the same packet multiple times.
 		 */
-		return OSPF_READ_CONTINUE;
+		return;
 	}
 
 	/* Self-originated packet should be discarded silently. */
@@ -3005,32 +3024,10 @@ static enum ospf_read_return_enum ospf_read_helper(struct ospf *ospf)
 				"ospf_read[%pI4]: Dropping self-originated packet",
 				&iph->ip_src);
 		}
-		return OSPF_READ_CONTINUE;
-	}
-
-	/* Check that we have enough for an IP header */
-	if ((unsigned int)(iph->ip_hl << 2) >= STREAM_READABLE(ibuf)) {
-		if ((unsigned int)(iph->ip_hl << 2) == STREAM_READABLE(ibuf)) {
-			flog_warn(
-				EC_OSPF_PACKET,
-				"Rx'd IP packet with OSPF protocol number but no payload");
-		} else {
-			flog_warn(
-				EC_OSPF_PACKET,
-				"IP header length field claims header is %u bytes, but we only have %zu",
-				(unsigned int)(iph->ip_hl << 2),
-				STREAM_READABLE(ibuf));
-		}
-
-		return OSPF_READ_ERROR;
+		return;
 	}
-	stream_forward_getp(ibuf, iph->ip_hl << 2);
 
 	ospfh = (struct ospf_header *)stream_pnt(ibuf);
-	if (MSG_OK
-	    != ospf_packet_examin(ospfh, stream_get_endp(ibuf)
-						 - stream_get_getp(ibuf)))
-		return OSPF_READ_CONTINUE;
 	/* Now it is safe to access all fields of OSPF packet header. */
 
 	/* associate packet with ospf interface */
@@ -3060,7 +3057,7 @@ static enum ospf_read_return_enum ospf_read_helper(struct ospf *ospf)
 			OI_MEMBER_JOINED(oi, MEMBER_ALLROUTERS);
 			ospf_if_set_multicast(oi);
 		}
-		return OSPF_READ_CONTINUE;
+		return;
 	}
 
 
@@ -3077,7 +3074,7 @@ static enum ospf_read_return_enum ospf_read_helper(struct ospf *ospf)
 				zlog_debug(
 					"Packet from [%pI4] received on link %s but no ospf_interface",
 					&iph->ip_src, ifp->name);
-			return OSPF_READ_CONTINUE;
+			return;
 		}
 	}
 
@@ -3090,7 +3087,7 @@ static enum ospf_read_return_enum ospf_read_helper(struct ospf *ospf)
 			flog_warn(EC_OSPF_PACKET,
 				  "Packet from [%pI4] received on wrong link %s",
 				  &iph->ip_src, ifp->name);
-		return OSPF_READ_CONTINUE;
+		return;
 	} else if (oi->state == ISM_Down) {
 		flog_warn(
 			EC_OSPF_PACKET,
@@ -3104,7 +3101,7 @@ static enum ospf_read_return_enum ospf_read_helper(struct ospf *ospf)
 			OI_MEMBER_JOINED(oi, MEMBER_DROUTERS);
 		if (oi->multicast_memberships)
 			ospf_if_set_multicast(oi);
-		return OSPF_READ_CONTINUE;
+		return;
 	}
 
 	/*
@@ -3124,7 +3121,7 @@ static enum ospf_read_return_enum ospf_read_helper(struct ospf *ospf)
 		/* Try to fix multicast membership. */
 		SET_FLAG(oi->multicast_memberships, MEMBER_DROUTERS);
 		ospf_if_set_multicast(oi);
-		return OSPF_READ_CONTINUE;
+		return;
 	}
 
 	/* Verify more OSPF header fields. */
@@ -3134,7 +3131,7 @@ static enum ospf_read_return_enum ospf_read_helper(struct ospf *ospf)
 			zlog_debug(
 				"ospf_read[%pI4]: Header check failed, dropping.",
 				&iph->ip_src);
-		return OSPF_READ_CONTINUE;
+		return;
 	}
 
 	/* Show debug receiving packet. */
@@ -3186,7 +3183,22 @@ static enum ospf_read_return_enum ospf_read_helper(struct ospf *ospf)
 			IF_NAME(oi), ospf_get_name(ospf), ospfh->type);
 		break;
 	}
+}
+
+static enum ospf_read_return_enum ospf_read_helper(struct ospf *ospf)
+{
+	ifindex_t ifindex = 0;
+	int len;
+
+	stream_reset(ospf->ibuf);
+	len = ospf_recv_packet(ospf->fd, &ifindex, ospf->ibuf);
+	if (len < 0)
+		return OSPF_READ_ERROR;
+
+	if (ospf_packet_verify(ospf->ibuf, len) < 0)
+		return OSPF_READ_CONTINUE;
 
+	ospf_packet_input(ospf, ospf->ibuf, ifindex);
 	return OSPF_READ_CONTINUE;
 }
 
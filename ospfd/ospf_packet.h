@@ -140,6 +140,9 @@ extern void ospf_fifo_flush(struct ospf_fifo *);
 extern void ospf_fifo_free(struct ospf_fifo *);
 
 extern int ospf_read(struct thread *);
+extern int ospf_packet_verify(struct stream *ibuf, int len);
+extern void ospf_packet_input(struct ospf *ospf, struct stream *ibuf,
+			      ifindex_t ifindex);
 extern void ospf_hello_send(struct ospf_interface *);
 extern void ospf_db_desc_send(struct ospf_neighbor *);
 extern void ospf_db_desc_resend(struct ospf_neighbor *);
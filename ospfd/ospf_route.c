@@ -309,6 +309,7 @@ void ospf_route_install(struct ospf *ospf, struct route_table *rt)
 {
 	struct route_node *rn;
 	struct ospf_route * or ;
+	struct route_table *installed;
 
 	/* rt contains new routing table, new_table contains an old one.
 	   updating pointers */
@@ -324,12 +325,17 @@ void ospf_route_install(struct ospf *ospf, struct route_table *rt)
 	if (ospf->old_external_route)
 		ospf_route_delete_same_ext(ospf, ospf->old_external_route, rt);
 
-	/* Install new routes. */
+	/*
+	 * Install new routes.  Nothing calculated during a graceful restart
+	 * made it into zebra, so once it's over everything is sent.
+	 */
+	installed = ospf->gr_info.finishing_restart ? NULL : ospf->old_table;
+
 	for (rn = route_top(rt); rn; rn = route_next(rn))
 		if ((or = rn->info) != NULL) {
 			if (or->type == OSPF_DESTINATION_NETWORK) {
 				if (!ospf_route_match_same(
-					    ospf->old_table,
+					    installed,
 					    (struct prefix_ipv4 *)&rn->p, or))
 					ospf_zebra_add(
 						ospf,
@@ -337,7 +343,7 @@ void ospf_route_install(struct ospf *ospf, struct route_table *rt)
 						or);
 			} else if (or->type == OSPF_DESTINATION_DISCARD)
 				if (!ospf_route_match_same(
-					    ospf->old_table,
+					    installed,
 					    (struct prefix_ipv4 *)&rn->p, or))
 					ospf_zebra_add_discard(
 						ospf,
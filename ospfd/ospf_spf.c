@@ -48,6 +48,7 @@
 #include "ospfd/ospf_sr.h"
 #include "ospfd/ospf_ti_lfa.h"
 #include "ospfd/ospf_errors.h"
+#include "ospfd/ospf_trace.h"
 
 /* Variables to ensure a SPF scheduled log message is printed only once */
 
@@ -201,7 +202,8 @@ static struct vertex *ospf_vertex_new(struct ospf_area *area,
 	new->parents = list_new();
 	new->parents->del = vertex_parent_free;
 	new->parents->cmp = vertex_parent_cmp;
-	new->lsa_p = lsa;
+	/* trees may be kept across LSDB changes, see ospf_spf_reuse_area() */
+	new->lsa_p = ospf_lsa_lock(lsa);
 
 	lsa->stat = new;
 
@@ -232,6 +234,7 @@ static void ospf_vertex_free(void *data)
 		list_delete(&v->parents);
 
 	v->lsa = NULL;
+	ospf_lsa_unlock(&v->lsa_p);
 
 	XFREE(MTYPE_OSPF_VERTEX, v);
 }
@@ -341,6 +344,7 @@ static struct vertex *ospf_spf_vertex_copy(struct vertex *vertex)
 	copy = XCALLOC(MTYPE_OSPF_VERTEX, sizeof(struct vertex));
 
 	memcpy(copy, vertex, sizeof(struct vertex));
+	ospf_lsa_lock(copy->lsa_p);
 	copy->parents = list_new();
 	copy->parents->del = vertex_parent_free;
 	copy->parents->cmp = vertex_parent_cmp;
@@ -1769,10 +1773,178 @@ void ospf_spf_calculate(struct ospf_area *area, struct ospf_lsa *root_lsa,
 			   mtype_stats_alloc(MTYPE_OSPF_VERTEX));
 }
 
+/* next non-stub link of a router-LSA, or NULL */
+static struct router_lsa_link *ospf_router_lsa_next_transit(uint8_t **p,
+							     uint8_t *lim)
+{
+	struct router_lsa_link *l;
+
+	while (*p < lim) {
+		l = (struct router_lsa_link *)*p;
+		*p += OSPF_ROUTER_LSA_LINK_SIZE
+		      + (l->m[0].tos_count * OSPF_ROUTER_LSA_TOS_SIZE);
+
+		if (l->m[0].type != LSA_LINK_TYPE_STUB)
+			return l;
+	}
+
+	return NULL;
+}
+
+/*
+ * Do two router-LSAs only differ in their stub links?  Stubs are leaves
+ * of the shortest-path tree, so the tree itself is the same either way.
+ */
+static bool ospf_router_lsa_same_tree(struct lsa_header *a,
+				      struct lsa_header *b)
+{
+	struct router_lsa_link *la, *lb;
+	uint8_t *pa, *pb, *lima, *limb;
+
+	if (((struct router_lsa *)a)->flags != ((struct router_lsa *)b)->flags)
+		return false;
+
+	pa = ((uint8_t *)a) + OSPF_LSA_HEADER_SIZE + 4;
+	lima = ((uint8_t *)a) + ntohs(a->length);
+	pb = ((uint8_t *)b) + OSPF_LSA_HEADER_SIZE + 4;
+	limb = ((uint8_t *)b) + ntohs(b->length);
+
+	while (true) {
+		la = ospf_router_lsa_next_transit(&pa, lima);
+		lb = ospf_router_lsa_next_transit(&pb, limb);
+
+		if (!la || !lb)
+			return la == lb;
+
+		if (la->m[0].type != lb->m[0].type
+		    || la->m[0].metric != lb->m[0].metric
+		    || la->link_id.s_addr != lb->link_id.s_addr
+		    || la->link_data.s_addr != lb->link_data.s_addr)
+			return false;
+	}
+}
+
+void ospf_spf_lsa_changed(struct ospf_lsa *old, struct ospf_lsa *new)
+{
+	struct ospf_lsa *lsa = new ? new : old;
+	struct ospf_area *area = lsa->area;
+
+	if (!area)
+		return;
+
+	switch (lsa->data->type) {
+	case OSPF_ROUTER_LSA:
+		/*
+		 * Our own stubs are also used for point-to-point nexthops,
+		 * see match_stub_prefix().
+		 */
+		if (old && new && !IS_LSA_MAXAGE(new) && !IS_LSA_SELF(new)
+		    && ospf_router_lsa_same_tree(old->data, new->data))
+			return;
+		break;
+	case OSPF_NETWORK_LSA:
+		break;
+	default:
+		return;
+	}
+
+	area->spf_changed = true;
+}
+
+static void ospf_spf_tree_free(struct ospf_area *area)
+{
+	ospf_spf_cleanup(area->spf, area->spf_vertex_list);
+	area->spf = NULL;
+	area->spf_vertex_list = NULL;
+}
+
+void ospf_spf_area_free(struct ospf_area *area)
+{
+	ospf_spf_tree_free(area);
+}
+
+/*
+ * Partial route calculation: rebuild an area's intra-area routes from the
+ * shortest-path tree kept from its last calculation, without running
+ * Dijkstra.  This is the same as RFC2328 16.1. (4) and the stub stage,
+ * just walking the tree instead of the candidate list.  Only possible if
+ * no router- or network-LSA in the area changed the tree since.
+ *
+ * Returns false if the area needs a full calculation.
+ */
+static bool ospf_spf_reuse_area(struct ospf_area *area,
+				struct route_table *new_table,
+				struct route_table *new_rtrs)
+{
+	struct listnode *node;
+	struct vertex *v;
+	struct ospf_lsa *lsa, *old;
+
+	if (!area->spf || area->spf_changed || !area->router_lsa_self)
+		return false;
+
+	/* Pick up refreshed LSAs, they may only differ in their stubs. */
+	for (ALL_LIST_ELEMENTS_RO(area->spf_vertex_list, node, v)) {
+		if (v->type == OSPF_VERTEX_ROUTER)
+			lsa = ospf_lsdb_lookup_by_id(area->lsdb,
+						     OSPF_ROUTER_LSA, v->id,
+						     v->id);
+		else
+			lsa = ospf_lsdb_lookup_by_id(area->lsdb,
+						     OSPF_NETWORK_LSA, v->id,
+						     v->lsa->adv_router);
+
+		if (!lsa || IS_LSA_MAXAGE(lsa))
+			return false;
+
+		if (lsa == v->lsa_p)
+			continue;
+
+		if (v->type == OSPF_VERTEX_ROUTER && !IS_LSA_SELF(lsa)) {
+			if (!ospf_router_lsa_same_tree(v->lsa, lsa->data))
+				return false;
+		} else if (ospf_lsa_different(v->lsa_p, lsa))
+			return false;
+
+		old = v->lsa_p;
+		ospf_lsa_unlock(&old);
+		v->lsa_p = ospf_lsa_lock(lsa);
+		v->lsa = lsa->data;
+		lsa->stat = v;
+	}
+
+	if (IS_DEBUG_OSPF_EVENT)
+		zlog_debug("%s: reusing SPF tree for area %pI4, %u vertices",
+			   __func__, &area->area_id,
+			   listcount(area->spf_vertex_list));
+
+	area->shortcut_capability = 1;
+	area->abr_count = 0;
+	area->asbr_count = 0;
+
+	for (ALL_LIST_ELEMENTS_RO(area->spf_vertex_list, node, v)) {
+		UNSET_FLAG(v->flags, OSPF_VERTEX_PROCESSED);
+
+		if (v == area->spf)
+			continue;
+
+		if (v->type == OSPF_VERTEX_ROUTER)
+			ospf_intra_add_router(new_rtrs, v, area);
+		else
+			ospf_intra_add_transit(new_table, v, area);
+	}
+
+	ospf_spf_process_stubs(area, area->spf, new_table, 0);
+
+	return true;
+}
+
 void ospf_spf_calculate_area(struct ospf *ospf, struct ospf_area *area,
 			     struct route_table *new_table,
 			     struct route_table *new_rtrs)
 {
+	ospf_spf_tree_free(area);
+
 	ospf_spf_calculate(area, area->router_lsa_self, new_table, new_rtrs,
 			   false, true);
 
@@ -1780,14 +1952,32 @@ void ospf_spf_calculate_area(struct ospf *ospf, struct ospf_area *area,
 		ospf_ti_lfa_compute(area, new_table,
 				    ospf->ti_lfa_protection_type);
 
-	ospf_spf_cleanup(area->spf, area->spf_vertex_list);
+	/* The tree is kept for ospf_spf_reuse_area(). */
+	area->spf_changed = false;
+}
+
+/* Returns true if Dijkstra was run, false if the tree was reused. */
+static bool ospf_spf_calculate_area_incr(struct ospf *ospf,
+					 struct ospf_area *area,
+					 struct route_table *new_table,
+					 struct route_table *new_rtrs,
+					 bool incremental)
+{
+	if (incremental && ospf_spf_reuse_area(area, new_table, new_rtrs))
+		return false;
+
+	ospf_spf_calculate_area(ospf, area, new_table, new_rtrs);
+	return true;
 }
 
-void ospf_spf_calculate_areas(struct ospf *ospf, struct route_table *new_table,
-			      struct route_table *new_rtrs)
+enum ospf_spf_mode ospf_spf_calculate_areas(struct ospf *ospf,
+					    struct route_table *new_table,
+					    struct route_table *new_rtrs,
+					    bool incremental)
 {
 	struct ospf_area *area;
 	struct listnode *node, *nnode;
+	unsigned int ran = 0, reused = 0;
 
 	/* Calculate SPF for each area. */
 	for (ALL_LIST_ELEMENTS(ospf->areas, node, nnode, area)) {
@@ -1796,13 +1986,68 @@ void ospf_spf_calculate_areas(struct ospf *ospf, struct route_table *new_table,
 		if (ospf->backbone && ospf->backbone == area)
 			continue;
 
-		ospf_spf_calculate_area(ospf, area, new_table, new_rtrs);
+		if (ospf_spf_calculate_area_incr(ospf, area, new_table,
+						 new_rtrs, incremental))
+			ran++;
+		else
+			reused++;
 	}
 
 	/* SPF for backbone, if required */
-	if (ospf->backbone)
-		ospf_spf_calculate_area(ospf, ospf->backbone, new_table,
-					new_rtrs);
+	if (ospf->backbone) {
+		if (ospf_spf_calculate_area_incr(ospf, ospf->backbone,
+						 new_table, new_rtrs,
+						 incremental))
+			ran++;
+		else
+			reused++;
+	}
+
+	if (!reused)
+		return OSPF_SPF_FULL;
+	if (!ran)
+		return OSPF_SPF_PRC;
+	return OSPF_SPF_INCREMENTAL;
+}
+
+/*
+ * Can this run reuse the trees of areas whose topology didn't change?
+ * Anything but LSA changes, which are tracked per area by
+ * ospf_spf_lsa_changed(), needs a full run.  The end of a graceful restart
+ * doesn't change the topology by itself; the routes calculated during the
+ * restart only still have to be installed, which ospf_route_install() and
+ * the ASE calculation take care of.
+ */
+static bool ospf_spf_incremental_ok(struct ospf *ospf)
+{
+	unsigned int ok = (1 << SPF_FLAG_ROUTER_LSA_INSTALL)
+			  | (1 << SPF_FLAG_NETWORK_LSA_INSTALL)
+			  | (1 << SPF_FLAG_SUMMARY_LSA_INSTALL)
+			  | (1 << SPF_FLAG_ASBR_SUMMARY_LSA_INSTALL)
+			  | (1 << SPF_FLAG_MAXAGE)
+			  | (1 << SPF_FLAG_GR_FINISH);
+
+	/* TI-LFA backup paths are computed along with Dijkstra */
+	if (ospf->ti_lfa_enabled)
+		return false;
+
+	return spf_reason_flags && !(spf_reason_flags & ~ok);
+}
+
+const char *ospf_spf_mode_str(enum ospf_spf_mode mode)
+{
+	switch (mode) {
+	case OSPF_SPF_FULL:
+		return "full";
+	case OSPF_SPF_INCREMENTAL:
+		return "incremental";
+	case OSPF_SPF_PRC:
+		return "partial";
+	case OSPF_SPF_MODE_MAX:
+		break;
+	}
+
+	return "unknown";
 }
 
 /* Worker for SPF calculation scheduler. */
@@ -1813,6 +2058,7 @@ static int ospf_spf_calculate_schedule_worker(struct thread *thread)
 	struct timeval start_time, spf_start_time;
 	unsigned long ia_time, prune_time, rt_time;
 	unsigned long abr_time, total_spf_time, spf_time;
+	enum ospf_spf_mode mode;
 	char rbuf[32]; /* reason_buf */
 
 	if (IS_DEBUG_OSPF_EVENT)
@@ -1820,14 +2066,24 @@ static int ospf_spf_calculate_schedule_worker(struct thread *thread)
 
 	ospf->t_spf_calc = NULL;
 
+	frrtrace(2, frr_ospf, spf_start, ospf, spf_reason_flags);
+
 	ospf_vl_unapprove(ospf);
 
 	/* Execute SPF for each area including backbone, see RFC 2328 16.1. */
 	monotime(&spf_start_time);
 	new_table = route_table_init(); /* routing table */
 	new_rtrs = route_table_init();  /* ABR/ASBR routing table */
-	ospf_spf_calculate_areas(ospf, new_table, new_rtrs);
+	mode = ospf_spf_calculate_areas(ospf, new_table, new_rtrs,
+					ospf_spf_incremental_ok(ospf));
 	spf_time = monotime_since(&spf_start_time, NULL);
+	frrtrace(3, frr_ospf, spf_phase, ospf, "dijkstra", spf_time);
+
+	ospf->spf_mode_count[mode]++;
+	ospf->spf_last_mode = mode;
+	/* no area ran Dijkstra, but the routes were still recalculated */
+	if (mode == OSPF_SPF_PRC)
+		monotime(&ospf->ts_spf);
 
 	ospf_vl_shut_unapproved(ospf);
 
@@ -1835,20 +2091,26 @@ static int ospf_spf_calculate_schedule_worker(struct thread *thread)
 	monotime(&start_time);
 	ospf_ia_routing(ospf, new_table, new_rtrs);
 	ia_time = monotime_since(&start_time, NULL);
+	frrtrace(3, frr_ospf, spf_phase, ospf, "inter-area", ia_time);
 
 	/* Get rid of transit networks and routers we cannot reach anyway. */
 	monotime(&start_time);
 	ospf_prune_unreachable_networks(new_table);
 	ospf_prune_unreachable_routers(new_rtrs);
 	prune_time = monotime_since(&start_time, NULL);
+	frrtrace(3, frr_ospf, spf_phase, ospf, "prune", prune_time);
 
 	/* Note: RFC 2328 16.3. is apparently missing. */
 
 	/*
 	 * Calculate AS external routes, see RFC 2328 16.4.
 	 * There is a dedicated routing table for external routes which is not
-	 * handled here directly
+	 * handled here directly.  Unless this run was only about LSA changes,
+	 * all of them are recalculated rather than those whose ASBR or
+	 * forwarding address route changed.
 	 */
+	if (!ospf_spf_incremental_ok(ospf))
+		ospf->ase_calc_full = true;
 	ospf_ase_calculate_schedule(ospf);
 	ospf_ase_calculate_timer_add(ospf);
 
@@ -1862,6 +2124,7 @@ static int ospf_spf_calculate_schedule_worker(struct thread *thread)
 	monotime(&start_time);
 	ospf_route_install(ospf, new_table);
 	rt_time = monotime_since(&start_time, NULL);
+	frrtrace(3, frr_ospf, spf_phase, ospf, "route-install", rt_time);
 
 	/* Free old ABR/ASBR routing table */
 	if (ospf->old_rtrs)
@@ -1880,12 +2143,14 @@ static int ospf_spf_calculate_schedule_worker(struct thread *thread)
 		ospf_abr_task(ospf);
 	}
 	abr_time = monotime_since(&start_time, NULL);
+	frrtrace(3, frr_ospf, spf_phase, ospf, "abr", abr_time);
 
 	/* Schedule Segment Routing update */
 	ospf_sr_update_task(ospf);
 
 	total_spf_time =
 		monotime_since(&spf_start_time, &ospf->ts_spf_duration);
+	frrtrace(3, frr_ospf, spf_done, ospf, mode, total_spf_time);
 
 	rbuf[0] = '\0';
 	if (spf_reason_flags) {
@@ -1915,7 +2180,8 @@ static int ospf_spf_calculate_schedule_worker(struct thread *thread)
 
 	if (IS_DEBUG_OSPF_EVENT) {
 		zlog_info("SPF Processing Time(usecs): %ld", total_spf_time);
-		zlog_info("            SPF Time: %ld", spf_time);
+		zlog_info("            SPF Time: %ld (%s)", spf_time,
+			  ospf_spf_mode_str(mode));
 		zlog_info("           InterArea: %ld", ia_time);
 		zlog_info("               Prune: %ld", prune_time);
 		zlog_info("        RouteInstall: %ld", rt_time);
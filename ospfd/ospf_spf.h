@@ -81,9 +81,21 @@ extern void ospf_spf_calculate(struct ospf_area *area,
 extern void ospf_spf_calculate_area(struct ospf *ospf, struct ospf_area *area,
 				    struct route_table *new_table,
 				    struct route_table *new_rtrs);
-extern void ospf_spf_calculate_areas(struct ospf *ospf,
-				     struct route_table *new_table,
-				     struct route_table *new_rtrs);
+/*
+ * With incremental set, areas whose topology didn't change since their last
+ * calculation reuse their shortest-path tree.  Returns the kind of run.
+ */
+extern enum ospf_spf_mode ospf_spf_calculate_areas(struct ospf *ospf,
+						   struct route_table *new_table,
+						   struct route_table *new_rtrs,
+						   bool incremental);
+/*
+ * Call for router- and network-LSA changes that need a new routing table,
+ * new is NULL or MaxAge if the LSA is going away.
+ */
+extern void ospf_spf_lsa_changed(struct ospf_lsa *old, struct ospf_lsa *new);
+extern void ospf_spf_area_free(struct ospf_area *area);
+extern const char *ospf_spf_mode_str(enum ospf_spf_mode mode);
 extern void ospf_rtrs_free(struct route_table *);
 extern void ospf_spf_cleanup(struct vertex *spf, struct list *vertex_list);
 extern void ospf_spf_copy(struct vertex *vertex, struct list *vertex_list);
@@ -1947,7 +1947,7 @@ static void ospf_sr_nhlfe_update(struct hash_bucket *bucket, void *args)
 			break;
 		/* There is at least one route, update NHLFE */
 		case 1:
-			ospf_zebra_update_prefix_sid(srp);
+			ospf_zebra_sync_prefix_sid(srp);
 			break;
 		default:
 			break;
@@ -1971,6 +1971,7 @@ void ospf_sr_update_task(struct ospf *ospf)
 	hash_iterate(OspfSR.neighbors, (void (*)(struct hash_bucket *,
 						 void *))ospf_sr_nhlfe_update,
 		     NULL);
+	ospf_zebra_prefix_sid_flush();
 
 	monotime(&stop_time);
 
@@ -336,6 +336,9 @@ struct sr_prefix {
 	/* NHLFE for local prefix */
 	struct sr_nhlfe nhlfe;
 
+	/* Digest of the LSP zebra got last, 0 if none */
+	uint64_t lsp_digest;
+
 	/* Back pointer to SR Node which advertise this Prefix */
 	struct sr_node *srn;
 };
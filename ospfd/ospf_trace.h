@@ -0,0 +1,131 @@
+/* Tracing for OSPF
+ *
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#if !defined(_OSPF_TRACE_H) || defined(TRACEPOINT_HEADER_MULTI_READ)
+#define _OSPF_TRACE_H
+
+#include "lib/trace.h"
+
+#ifdef HAVE_LTTNG
+
+#undef TRACEPOINT_PROVIDER
+#define TRACEPOINT_PROVIDER frr_ospf
+
+#undef TRACEPOINT_INCLUDE
+#define TRACEPOINT_INCLUDE "ospfd/ospf_trace.h"
+
+#include <lttng/tracepoint.h>
+
+#include "lib/if.h"
+#include "ospfd/ospfd.h"
+#include "ospfd/ospf_asbr.h"
+#include "ospfd/ospf_lsa.h"
+#include "ospfd/ospf_lsdb.h"
+#include "ospfd/ospf_neighbor.h"
+#include "ospfd/ospf_spf.h"
+
+/* clang-format off */
+
+/* The SPF timer fired; reasons is the SPF_FLAG_* bitmask */
+TRACEPOINT_EVENT(
+	frr_ospf,
+	spf_start,
+	TP_ARGS(struct ospf *, ospf, unsigned int, reasons),
+	TP_FIELDS(
+		ctf_integer(vrf_id_t, vrf_id, ospf->vrf_id)
+		ctf_integer(unsigned short, instance, ospf->instance)
+		ctf_integer_hex(unsigned int, reasons, reasons)
+	)
+)
+
+TRACEPOINT_LOGLEVEL(frr_ospf, spf_start, TRACE_INFO)
+
+/* A phase of the SPF run is done, see ospf_spf_calculate_schedule_worker() */
+TRACEPOINT_EVENT(
+	frr_ospf,
+	spf_phase,
+	TP_ARGS(struct ospf *, ospf, const char *, phase, unsigned long, usec),
+	TP_FIELDS(
+		ctf_integer(vrf_id_t, vrf_id, ospf->vrf_id)
+		ctf_integer(unsigned short, instance, ospf->instance)
+		ctf_string(phase, phase)
+		ctf_integer(unsigned long, duration_usec, usec)
+	)
+)
+
+TRACEPOINT_LOGLEVEL(frr_ospf, spf_phase, TRACE_INFO)
+
+TRACEPOINT_EVENT(
+	frr_ospf,
+	spf_done,
+	TP_ARGS(struct ospf *, ospf, enum ospf_spf_mode, mode, unsigned long,
+		usec),
+	TP_FIELDS(
+		ctf_integer(vrf_id_t, vrf_id, ospf->vrf_id)
+		ctf_integer(unsigned short, instance, ospf->instance)
+		ctf_string(mode, ospf_spf_mode_str(mode))
+		ctf_integer(unsigned long, duration_usec, usec)
+	)
+)
+
+TRACEPOINT_LOGLEVEL(frr_ospf, spf_done, TRACE_INFO)
+
+/* A new LSA has been received from nbr */
+TRACEPOINT_EVENT(
+	frr_ospf,
+	lsa_receive,
+	TP_ARGS(struct ospf_neighbor *, nbr, struct ospf_lsa *, lsa),
+	TP_FIELDS(
+		ctf_integer_network_hex(uint32_t, neighbor,
+					nbr->router_id.s_addr)
+		ctf_integer(uint8_t, type, lsa->data->type)
+		ctf_integer_network_hex(uint32_t, ls_id, lsa->data->id.s_addr)
+		ctf_integer_network_hex(uint32_t, adv_router,
+					lsa->data->adv_router.s_addr)
+		ctf_integer_hex(uint32_t, seqnum, ntohl(lsa->data->ls_seqnum))
+	)
+)
+
+TRACEPOINT_LOGLEVEL(frr_ospf, lsa_receive, TRACE_INFO)
+
+/* An LSA is flooded; inbr is NULL for our own LSAs */
+TRACEPOINT_EVENT(
+	frr_ospf,
+	lsa_flood,
+	TP_ARGS(struct ospf_neighbor *, inbr, struct ospf_lsa *, lsa),
+	TP_FIELDS(
+		ctf_integer_network_hex(uint32_t, neighbor,
+					inbr ? inbr->router_id.s_addr : 0)
+		ctf_integer(uint8_t, type, lsa->data->type)
+		ctf_integer_network_hex(uint32_t, ls_id, lsa->data->id.s_addr)
+		ctf_integer_network_hex(uint32_t, adv_router,
+					lsa->data->adv_router.s_addr)
+		ctf_integer_hex(uint32_t, seqnum, ntohl(lsa->data->ls_seqnum))
+	)
+)
+
+TRACEPOINT_LOGLEVEL(frr_ospf, lsa_flood, TRACE_INFO)
+
+/* clang-format on */
+
+#include <lttng/tracepoint-event.h>
+
+#endif /* HAVE_LTTNG */
+
+#endif /* _OSPF_TRACE_H */
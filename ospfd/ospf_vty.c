@@ -3191,6 +3191,18 @@ static int show_ip_ospf_common(struct vty *vty, struct ospf *ospf,
 				     + (ospf->ts_spf_duration.tv_usec / 1000);
 			json_object_int_add(json_vrf, "spfLastDurationMsecs",
 					    time_store);
+			json_object_string_add(
+				json_vrf, "spfLastMode",
+				ospf_spf_mode_str(ospf->spf_last_mode));
+			json_object_int_add(
+				json_vrf, "spfFullCounter",
+				ospf->spf_mode_count[OSPF_SPF_FULL]);
+			json_object_int_add(
+				json_vrf, "spfIncrementalCounter",
+				ospf->spf_mode_count[OSPF_SPF_INCREMENTAL]);
+			json_object_int_add(
+				json_vrf, "spfPartialCounter",
+				ospf->spf_mode_count[OSPF_SPF_PRC]);
 		} else
 			json_object_boolean_true_add(json_vrf, "spfHasNotRun");
 	} else {
@@ -3203,6 +3215,12 @@ static int show_ip_ospf_common(struct vty *vty, struct ospf *ospf,
 			vty_out(vty, " Last SPF duration %s\n",
 				ospf_timeval_dump(&ospf->ts_spf_duration,
 						  timebuf, sizeof(timebuf)));
+			vty_out(vty,
+				" Last SPF mode %s, %u full, %u incremental, %u partial runs\n",
+				ospf_spf_mode_str(ospf->spf_last_mode),
+				ospf->spf_mode_count[OSPF_SPF_FULL],
+				ospf->spf_mode_count[OSPF_SPF_INCREMENTAL],
+				ospf->spf_mode_count[OSPF_SPF_PRC]);
 		} else
 			vty_out(vty, "has not been run\n");
 	}
@@ -30,11 +30,13 @@
 #include "stream.h"
 #include "memory.h"
 #include "zclient.h"
+#include "zclient_nhg.h"
 #include "filter.h"
 #include "plist.h"
 #include "log.h"
 #include "lib/bfd.h"
 #include "nexthop.h"
+#include "jhash.h"
 
 #include "ospfd/ospfd.h"
 #include "ospfd/ospf_interface.h"
@@ -62,6 +64,8 @@ DEFINE_MTYPE_STATIC(OSPFD, OSPF_DIST_ARGS, "OSPF Distribute arguments");
 struct zclient *zclient = NULL;
 /* and for the Synchronous connection to the Label Manager */
 static struct zclient *zclient_sync;
+/* The nexthop groups the routes are sent with */
+static struct zclient_nhg_cache *nhg_cache;
 
 /* For registering threads. */
 extern struct thread_master *master;
@@ -323,7 +327,7 @@ void ospf_zebra_add(struct ospf *ospf, struct prefix_ipv4 *p,
 		}
 	}
 
-	zclient_route_send(ZEBRA_ROUTE_ADD, zclient, &api);
+	zclient_nhg_route_add(nhg_cache, &api);
 }
 
 void ospf_zebra_delete(struct ospf *ospf, struct prefix_ipv4 *p,
@@ -349,7 +353,7 @@ void ospf_zebra_delete(struct ospf *ospf, struct prefix_ipv4 *p,
 	if (IS_DEBUG_OSPF(zebra, ZEBRA_REDISTRIBUTE))
 		zlog_debug("Zebra: Route delete %pFX", p);
 
-	zclient_route_send(ZEBRA_ROUTE_DELETE, zclient, &api);
+	zclient_nhg_route_delete(nhg_cache, &api);
 }
 
 void ospf_zebra_add_discard(struct ospf *ospf, struct prefix_ipv4 *p)
@@ -372,6 +376,7 @@ void ospf_zebra_add_discard(struct ospf *ospf, struct prefix_ipv4 *p)
 	memcpy(&api.prefix, p, sizeof(*p));
 	zapi_route_set_blackhole(&api, BLACKHOLE_NULL);
 
+	zclient_route_bulk_flush(zclient);
 	zclient_route_send(ZEBRA_ROUTE_ADD, zclient, &api);
 
 	if (IS_DEBUG_OSPF(zebra, ZEBRA_REDISTRIBUTE))
@@ -398,6 +403,7 @@ void ospf_zebra_delete_discard(struct ospf *ospf, struct prefix_ipv4 *p)
 	memcpy(&api.prefix, p, sizeof(*p));
 	zapi_route_set_blackhole(&api, BLACKHOLE_NULL);
 
+	zclient_route_bulk_flush(zclient);
 	zclient_route_send(ZEBRA_ROUTE_DELETE, zclient, &api);
 
 	if (IS_DEBUG_OSPF(zebra, ZEBRA_REDISTRIBUTE))
@@ -565,24 +571,24 @@ void ospf_external_del(struct ospf *ospf, uint8_t type, unsigned short instance)
 			 0, &ospf->t_default_routemap_timer);
 }
 
-/* Update NHLFE for Prefix SID */
-void ospf_zebra_update_prefix_sid(const struct sr_prefix *srp)
+/* Build the LSP for a Prefix SID, false if there is nothing to install */
+static bool ospf_zebra_prefix_sid_build(const struct sr_prefix *srp,
+					struct zapi_labels *zl)
 {
-	struct zapi_labels zl;
 	struct zapi_nexthop *znh;
 	struct zapi_nexthop *znh_backup;
 	struct listnode *node;
 	struct ospf_path *path;
 
 	/* Prepare message. */
-	memset(&zl, 0, sizeof(zl));
-	zl.type = ZEBRA_LSP_OSPF_SR;
-	zl.local_label = srp->label_in;
+	memset(zl, 0, sizeof(*zl));
+	zl->type = ZEBRA_LSP_OSPF_SR;
+	zl->local_label = srp->label_in;
 
 	switch (srp->type) {
 	case LOCAL_SID:
 		/* Set Label for local Prefix */
-		znh = &zl.nexthops[zl.nexthop_num++];
+		znh = &zl->nexthops[zl->nexthop_num++];
 		znh->type = NEXTHOP_TYPE_IFINDEX;
 		znh->ifindex = srp->nhlfe.ifindex;
 		znh->label_num = 1;
@@ -596,16 +602,16 @@ void ospf_zebra_update_prefix_sid(const struct sr_prefix *srp)
 
 	case PREF_SID:
 		/* Update route in the RIB too. */
-		SET_FLAG(zl.message, ZAPI_LABELS_FTN);
-		zl.route.prefix.u.prefix4 = srp->prefv4.prefix;
-		zl.route.prefix.prefixlen = srp->prefv4.prefixlen;
-		zl.route.prefix.family = srp->prefv4.family;
-		zl.route.type = ZEBRA_ROUTE_OSPF;
-		zl.route.instance = 0;
+		SET_FLAG(zl->message, ZAPI_LABELS_FTN);
+		zl->route.prefix.u.prefix4 = srp->prefv4.prefix;
+		zl->route.prefix.prefixlen = srp->prefv4.prefixlen;
+		zl->route.prefix.family = srp->prefv4.family;
+		zl->route.type = ZEBRA_ROUTE_OSPF;
+		zl->route.instance = 0;
 
 		/* Check that SRP contains at least one valid path */
 		if (srp->route == NULL) {
-			return;
+			return false;
 		}
 
 		osr_debug("SR (%s): Configure Prefix %pFX with",
@@ -615,7 +621,7 @@ void ospf_zebra_update_prefix_sid(const struct sr_prefix *srp)
 			if (path->srni.label_out == MPLS_INVALID_LABEL)
 				continue;
 
-			if (zl.nexthop_num >= MULTIPATH_NUM)
+			if (zl->nexthop_num >= MULTIPATH_NUM)
 				break;
 
 			/*
@@ -623,8 +629,8 @@ void ospf_zebra_update_prefix_sid(const struct sr_prefix *srp)
 			 * present.
 			 */
 			if (path->srni.backup_label_stack) {
-				znh_backup = &zl.backup_nexthops
-						      [zl.backup_nexthop_num++];
+				znh_backup = &zl->backup_nexthops
+						      [zl->backup_nexthop_num++];
 				znh_backup->type = NEXTHOP_TYPE_IPV4;
 				znh_backup->gate.ipv4 =
 					path->srni.backup_nexthop;
@@ -647,7 +653,7 @@ void ospf_zebra_update_prefix_sid(const struct sr_prefix *srp)
 						path->srni.label_out;
 			}
 
-			znh = &zl.nexthops[zl.nexthop_num++];
+			znh = &zl->nexthops[zl->nexthop_num++];
 			znh->type = NEXTHOP_TYPE_IPV4_IFINDEX;
 			znh->gate.ipv4 = path->nexthop;
 			znh->ifindex = path->ifindex;
@@ -659,31 +665,90 @@ void ospf_zebra_update_prefix_sid(const struct sr_prefix *srp)
 
 			/* Set TI-LFA backup nexthop info if present */
 			if (path->srni.backup_label_stack) {
-				SET_FLAG(zl.message, ZAPI_LABELS_HAS_BACKUPS);
+				SET_FLAG(zl->message, ZAPI_LABELS_HAS_BACKUPS);
 				SET_FLAG(znh->flags,
 					 ZAPI_NEXTHOP_FLAG_HAS_BACKUP);
 
 				/* Just care about a single TI-LFA backup path
 				 * for now */
 				znh->backup_num = 1;
-				znh->backup_idx[0] = zl.backup_nexthop_num - 1;
+				znh->backup_idx[0] = zl->backup_nexthop_num - 1;
 			}
 		}
 		break;
 	case ADJ_SID:
 	case LAN_ADJ_SID:
-		return;
+		return false;
 	}
 
+	return true;
+}
+
+/* What was sent to zebra for a Prefix SID, to detect unchanged LSPs */
+static uint64_t ospf_zebra_prefix_sid_digest(const struct zapi_labels *zl)
+{
+	uint32_t a, b;
+
+	/* zl was zeroed before it was filled, padding included */
+	a = jhash(zl, offsetof(struct zapi_labels, nexthops), 0x5eed);
+	a = jhash(zl->nexthops, zl->nexthop_num * sizeof(zl->nexthops[0]), a);
+	a = jhash(zl->backup_nexthops,
+		  zl->backup_nexthop_num * sizeof(zl->backup_nexthops[0]), a);
+	b = jhash(zl, offsetof(struct zapi_labels, nexthops), 0x0f5f);
+	b = jhash(zl->nexthops, zl->nexthop_num * sizeof(zl->nexthops[0]), b);
+	b = jhash(zl->backup_nexthops,
+		  zl->backup_nexthop_num * sizeof(zl->backup_nexthops[0]), b);
+
+	return ((uint64_t)a << 32 | b) ?: 1;
+}
+
+/* Update NHLFE for Prefix SID */
+void ospf_zebra_update_prefix_sid(struct sr_prefix *srp)
+{
+	struct zapi_labels zl;
+
+	if (!ospf_zebra_prefix_sid_build(srp, &zl))
+		return;
+
+	srp->lsp_digest = ospf_zebra_prefix_sid_digest(&zl);
+
 	/* Finally, send message to zebra. */
 	(void)zebra_send_mpls_labels(zclient, ZEBRA_MPLS_LABELS_REPLACE, &zl);
 }
 
+/*
+ * Update NHLFE for Prefix SID after a SPF run: the LSP is only sent if it
+ * differs from what zebra got last, and is queued in a bulk message that
+ * ospf_zebra_prefix_sid_flush() sends.
+ */
+void ospf_zebra_sync_prefix_sid(struct sr_prefix *srp)
+{
+	struct zapi_labels zl;
+	uint64_t digest;
+
+	if (!ospf_zebra_prefix_sid_build(srp, &zl))
+		return;
+
+	digest = ospf_zebra_prefix_sid_digest(&zl);
+	if (digest == srp->lsp_digest)
+		return;
+	srp->lsp_digest = digest;
+
+	(void)zclient_labels_bulk(zclient, ZEBRA_MPLS_LABELS_REPLACE, &zl);
+}
+
+void ospf_zebra_prefix_sid_flush(void)
+{
+	(void)zclient_labels_bulk_flush(zclient);
+}
+
 /* Remove NHLFE for Prefix-SID */
-void ospf_zebra_delete_prefix_sid(const struct sr_prefix *srp)
+void ospf_zebra_delete_prefix_sid(struct sr_prefix *srp)
 {
 	struct zapi_labels zl;
 
+	srp->lsp_digest = 0;
+
 	osr_debug("SR (%s): Delete Labels %u for Prefix %pFX", __func__,
 		  srp->label_in, (struct prefix *)&srp->prefv4);
 
@@ -2060,12 +2125,30 @@ int ospf_zebra_label_manager_connect(void)
 
 static void ospf_zebra_connected(struct zclient *zclient)
 {
+	zclient_nhg_cache_replay(nhg_cache);
+
 	/* Send the client registration */
 	bfd_client_sendmsg(zclient, ZEBRA_BFD_CLIENT_REGISTER, VRF_DEFAULT);
 
 	zclient_send_reg_requests(zclient, VRF_DEFAULT);
 }
 
+static int ospf_zebra_nhg_notify_owner(ZAPI_CALLBACK_ARGS)
+{
+	enum zapi_nhg_notify_owner note;
+	uint32_t id;
+
+	if (!zapi_nhg_notify_decode(zclient->ibuf, &id, &note))
+		return -1;
+
+	if (IS_DEBUG_OSPF(zebra, ZEBRA_REDISTRIBUTE))
+		zlog_debug("Zebra: nexthop group %u %s", id,
+			   zapi_nhg_notify_owner2str(note));
+
+	zclient_nhg_cache_notify(nhg_cache, id, note);
+	return 0;
+}
+
 /*
  * opaque messages between processes
  */
@@ -2136,6 +2219,8 @@ void ospf_zebra_init(struct thread_master *master, unsigned short instance)
 
 	zclient->redistribute_route_add = ospf_zebra_read_route;
 	zclient->redistribute_route_del = ospf_zebra_read_route;
+	zclient->nhg_notify_owner = ospf_zebra_nhg_notify_owner;
+	nhg_cache = zclient_nhg_cache_new(zclient);
 
 	/* Initialize special zclient for synchronous message exchanges. */
 	struct zclient_options options = zclient_options_default;
@@ -2161,6 +2246,13 @@ void ospf_zebra_init(struct thread_master *master, unsigned short instance)
 	zclient->zebra_client_close_notify = ospf_zebra_client_close_notify;
 }
 
+void ospf_zebra_terminate(void)
+{
+	zclient_nhg_cache_free(&nhg_cache);
+	zclient_stop(zclient);
+	zclient_free(zclient);
+}
+
 void ospf_zebra_send_arp(const struct interface *ifp, const struct prefix *p)
 {
 	zclient_send_neigh_discovery_req(zclient, ifp, p);
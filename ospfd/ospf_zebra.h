@@ -67,8 +67,10 @@ extern struct ospf_external *ospf_external_add(struct ospf *, uint8_t,
 
 struct sr_prefix;
 struct sr_nhlfe;
-extern void ospf_zebra_update_prefix_sid(const struct sr_prefix *srp);
-extern void ospf_zebra_delete_prefix_sid(const struct sr_prefix *srp);
+extern void ospf_zebra_update_prefix_sid(struct sr_prefix *srp);
+extern void ospf_zebra_sync_prefix_sid(struct sr_prefix *srp);
+extern void ospf_zebra_prefix_sid_flush(void);
+extern void ospf_zebra_delete_prefix_sid(struct sr_prefix *srp);
 extern void ospf_zebra_send_adjacency_sid(int cmd, struct sr_nhlfe nhlfe);
 
 extern void ospf_external_del(struct ospf *, uint8_t, unsigned short);
@@ -95,6 +97,7 @@ extern int ospf_distance_set(struct vty *, struct ospf *, const char *,
 extern int ospf_distance_unset(struct vty *, struct ospf *, const char *,
 			       const char *, const char *);
 extern void ospf_zebra_init(struct thread_master *, unsigned short);
+extern void ospf_zebra_terminate(void);
 extern void ospf_zebra_vrf_register(struct ospf *ospf);
 extern void ospf_zebra_vrf_deregister(struct ospf *ospf);
 bool ospf_external_default_routemap_apply_walk(
@@ -61,6 +61,7 @@
 #include "ospfd/ospf_ase.h"
 #include "ospfd/ospf_ldp_sync.h"
 #include "ospfd/ospf_gr.h"
+#include "ospfd/ospf_io.h"
 
 
 DEFINE_QOBJ_TYPE(ospf);
@@ -332,6 +333,7 @@ struct ospf *ospf_new_alloc(unsigned short instance, const char *name)
 	new->nbr_nbma = route_table_init();
 
 	new->lsdb = ospf_lsdb_new();
+	ospf_ls_retransmit_init(new);
 
 	new->default_originate = DEFAULT_ORIGINATE_NONE;
 
@@ -340,6 +342,7 @@ struct ospf *ospf_new_alloc(unsigned short instance, const char *name)
 	new->new_external_route = route_table_init();
 	new->old_external_route = route_table_init();
 	new->external_lsas = route_table_init();
+	ospf_ase_init(new);
 
 	new->stub_router_startup_time = OSPF_STUB_ROUTER_UNCONFIGURED;
 	new->stub_router_shutdown_time = OSPF_STUB_ROUTER_UNCONFIGURED;
@@ -418,7 +421,7 @@ static struct ospf *ospf_new(unsigned short instance, const char *name)
 	thread_add_timer(master, ospf_lsa_refresh_walker, new,
 			 new->lsa_refresh_interval, &new->t_lsa_refresher);
 
-	thread_add_read(master, ospf_read, new, new->fd, &new->t_read);
+	ospf_reads_on(new);
 
 	/*
 	 * Read from non-volatile memory whether this instance is performing a
@@ -675,10 +678,10 @@ void ospf_terminate(void)
 	 * One or more ospf_finish()'s may have deferred shutdown to a timer
 	 * thread
 	 */
-	zclient_stop(zclient);
-	zclient_free(zclient);
+	ospf_zebra_terminate();
 
 done:
+	ospf_io_finish();
 	frr_fini();
 }
 
@@ -797,7 +800,7 @@ static void ospf_finish_final(struct ospf *ospf)
 	}
 
 	/* Cancel all timers. */
-	OSPF_TIMER_OFF(ospf->t_read);
+	ospf_reads_off(ospf);
 	OSPF_TIMER_OFF(ospf->t_write);
 	OSPF_TIMER_OFF(ospf->t_spf_calc);
 	OSPF_TIMER_OFF(ospf->t_ase_calc);
@@ -852,6 +855,7 @@ static void ospf_finish_final(struct ospf *ospf)
 			ospf_route_delete(ospf, ospf->old_external_route);
 		ospf_route_table_free(ospf->old_external_route);
 	}
+	ospf_ase_finish(ospf);
 	if (ospf->external_lsas) {
 		ospf_ase_external_lsas_finish(ospf->external_lsas);
 	}
@@ -903,6 +907,8 @@ static void ospf_finish_final(struct ospf *ospf)
 	list_delete(&ospf->areas);
 	list_delete(&ospf->oi_write_q);
 
+	ospf_ls_retransmit_fini(ospf);
+
 	/* Reset GR helper data structers */
 	ospf_gr_helper_instance_stop(ospf);
 
@@ -983,6 +989,10 @@ static void ospf_area_free(struct ospf_area *area)
 {
 	ospf_opaque_type10_lsa_term(area);
 
+	/* Free the SPF tree, it holds locks on LSAs. */
+	ospf_spf_area_free(area);
+	ospf_gr_lsa_check_clear(area);
+
 	/* Free LSDBs. */
 	ospf_area_lsdb_discard_delete(area);
 
@@ -2236,8 +2246,7 @@ static int ospf_vrf_enable(struct vrf *vrf)
 			ret = ospf_sock_init(ospf);
 			if (ret < 0 || ospf->fd <= 0)
 				return 0;
-			thread_add_read(master, ospf_read, ospf, ospf->fd,
-					&ospf->t_read);
+			ospf_reads_on(ospf);
 			ospf->oi_running = 1;
 			ospf_router_id_update(ospf);
 		}
@@ -2275,7 +2284,7 @@ static int ospf_vrf_disable(struct vrf *vrf)
 		if (IS_DEBUG_OSPF_EVENT)
 			zlog_debug("%s: ospf old_vrf_id %d unlinked", __func__,
 				   old_vrf_id);
-		thread_cancel(&ospf->t_read);
+		ospf_reads_off(ospf);
 		close(ospf->fd);
 		ospf->fd = -1;
 	}
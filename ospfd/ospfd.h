@@ -127,6 +127,14 @@ enum {
 	OSPF_LOG_ADJACENCY_DETAIL =	(1 << 4),
 };
 
+/* How the last routing table calculation was done */
+enum ospf_spf_mode {
+	OSPF_SPF_FULL,	      /* Dijkstra for every area */
+	OSPF_SPF_INCREMENTAL, /* Dijkstra only for areas whose topology changed */
+	OSPF_SPF_PRC,	      /* no Dijkstra, only routes were recalculated */
+	OSPF_SPF_MODE_MAX,
+};
+
 /* TI-LFA */
 enum protection_type {
 	OSPF_TI_LFA_UNDEFINED_PROTECTION,
@@ -144,6 +152,9 @@ struct ospf_gr_info {
 	struct thread *t_grace_period;
 };
 
+PREDECL_HASH(ospf_rxmt_slots);
+PREDECL_HASH(ospf_ase_deps);
+
 /* OSPF instance structure. */
 struct ospf {
 	/* OSPF's running state based on the '[no] router ospf [<instance>]'
@@ -224,8 +235,15 @@ struct ospf {
 	/* LSDB of AS-external-LSAs. */
 	struct ospf_lsdb *lsdb;
 
+	/* LSAs on the neighbors' retransmit lists, see ospf_flood.c. */
+	struct ospf_rxmt_slots_head rxmt_slots;
+	struct ospf_rxmt_slot **rxmt_slot_idx;
+	uint32_t rxmt_slot_max;
+	struct id_alloc *rxmt_ids;
+
 	/* Flags. */
 	int ase_calc;	/* ASE calculation flag. */
+	bool ase_calc_full; /* Next ASE calculation can't be incremental. */
 
 	struct list *opaque_lsa_self; /* Type-11 Opaque-LSAs */
 
@@ -241,11 +259,19 @@ struct ospf {
 
 	struct route_table *external_lsas; /* Database of external LSAs,
 					      prefix is LSA's adv. network*/
+	/* External LSAs by ASBR and forwarding address, and the prefixes
+	 * hidden by intra/inter-area routes, see ospf_ase.c. */
+	struct ospf_ase_deps_head ase_deps;
+	struct route_table *ase_hidden;
 
 	/* Time stamps */
 	struct timeval ts_spf;		/* SPF calculation time stamp. */
 	struct timeval ts_spf_duration; /* Execution time of last SPF */
 
+	/* Routing table calculations by mode, and the last one's mode */
+	uint32_t spf_mode_count[OSPF_SPF_MODE_MAX];
+	enum ospf_spf_mode spf_last_mode;
+
 	struct route_table *maxage_lsa; /* List of MaxAge LSA for deletion. */
 	int redistribute;		/* Num of redistributed protocols. */
 
@@ -550,10 +576,22 @@ struct ospf_area {
 #define PREFIX_LIST_OUT(A)  (A)->plist_out.list
 #define PREFIX_NAME_OUT(A)  (A)->plist_out.name
 
-	/* Shortest Path Tree. */
+	/* Shortest Path Tree, kept until the next calculation. */
 	struct vertex *spf;
 	struct list *spf_vertex_list;
 
+	/* A router- or network-LSA change may have changed the tree. */
+	bool spf_changed;
+
+	/*
+	 * Router-LSAs received during a graceful restart that haven't been
+	 * checked against the pre-restart LSAs yet, see
+	 * ospf_gr_check_lsdb_consistency().  A copy of our own router-LSA
+	 * needs all of them checked again.
+	 */
+	struct list *gr_check_lsas;
+	bool gr_check_all;
+
 	bool spf_dry_run;   /* flag for checking if the SPF calculation is
 			       intended for the local RIB */
 	bool spf_root_node; /* flag for checking if the calculating node is the
@@ -752,9 +752,10 @@ void pbr_map_check_nh_group_change(const char *nh_group)
 	struct pbr_map *pbrm;
 	struct listnode *node, *inode;
 	struct pbr_map_interface *pmi;
-	bool found_name;
+	bool found_name, checked;
 
 	RB_FOREACH (pbrm, pbr_map_entry_head, &pbr_maps) {
+		checked = false;
 		for (ALL_LIST_ELEMENTS_RO(pbrm->seqnumbers, node, pbrms)) {
 			found_name = false;
 			if (pbrms->nhgrp_name)
@@ -767,7 +768,14 @@ void pbr_map_check_nh_group_change(const char *nh_group)
 			if (found_name) {
 				bool original = pbrm->valid;
 
-				pbr_map_check_valid_internal(pbrm);
+				/*
+				 * The whole map is validated, so once is
+				 * enough however many sequences use the group.
+				 */
+				if (!checked) {
+					pbr_map_check_valid_internal(pbrm);
+					checked = true;
+				}
 
 				if (pbrm->valid && (original != pbrm->valid))
 					pbr_map_install(pbrm);
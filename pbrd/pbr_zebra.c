@@ -251,6 +251,54 @@ static int rule_notify_owner(ZAPI_CALLBACK_ARGS)
 	return 0;
 }
 
+/*
+ * zebra takes any number of rules in one ZEBRA_RULE_ADD/DELETE message:
+ * the rules are collected here and sent together once the current event
+ * is done, or before any route so that zebra still sees them in order.
+ */
+#define PBR_RULE_ENCODED_MAX                                                   \
+	(4 * 3 + 2 * (2 + IPV6_MAX_BYTELEN + 2) + 1 + 4 + 4 + INTERFACE_NAMSIZ)
+
+static struct {
+	struct stream *s;
+	uint16_t cmd;
+	uint32_t count;
+	struct thread *t_flush;
+} pbr_rule_batch;
+
+static void pbr_rule_batch_flush(void)
+{
+	struct stream *s;
+
+	THREAD_OFF(pbr_rule_batch.t_flush);
+
+	if (!pbr_rule_batch.count)
+		return;
+
+	s = zclient->obuf;
+	stream_reset(s);
+
+	zclient_create_header(s, pbr_rule_batch.cmd, VRF_DEFAULT);
+	stream_putl(s, pbr_rule_batch.count);
+	stream_put(s, STREAM_DATA(pbr_rule_batch.s),
+		   stream_get_endp(pbr_rule_batch.s));
+	stream_putw_at(s, 0, stream_get_endp(s));
+
+	DEBUGD(&pbr_dbg_zebra, "%s: %s %u rules", __func__,
+	       zserv_command_string(pbr_rule_batch.cmd), pbr_rule_batch.count);
+
+	zclient_send_message(zclient);
+
+	stream_reset(pbr_rule_batch.s);
+	pbr_rule_batch.count = 0;
+}
+
+static int pbr_rule_batch_timer(struct thread *t)
+{
+	pbr_rule_batch_flush();
+	return 0;
+}
+
 static void zebra_connected(struct zclient *zclient)
 {
 	DEBUGD(&pbr_dbg_zebra, "%s: Registering for fun and profit", __func__);
@@ -302,6 +350,7 @@ static void route_add_helper(struct zapi_route *api, struct nexthop_group nhg,
 	}
 	api->nexthop_num = i;
 
+	pbr_rule_batch_flush();
 	zclient_route_send(ZEBRA_ROUTE_ADD, zclient, api);
 }
 
@@ -369,6 +418,7 @@ void route_delete(struct pbr_nexthop_group_cache *pnhgc, afi_t afi)
 	api.tableid = pnhgc->table_id;
 	SET_FLAG(api.message, ZAPI_MESSAGE_TABLEID);
 
+	pbr_rule_batch_flush();
 	switch (afi) {
 	case AFI_IP:
 		api.prefix.family = AF_INET;
@@ -554,7 +604,7 @@ bool pbr_send_pbr_map(struct pbr_map_sequence *pbrms,
 		      struct pbr_map_interface *pmi, bool install, bool changed)
 {
 	struct pbr_map *pbrm = pbrms->parent;
-	struct stream *s;
+	uint16_t cmd = install ? ZEBRA_RULE_ADD : ZEBRA_RULE_DELETE;
 	uint64_t is_installed = (uint64_t)1 << pmi->install_bit;
 
 	is_installed &= pbrms->installed;
@@ -575,27 +625,25 @@ bool pbr_send_pbr_map(struct pbr_map_sequence *pbrms,
 	if (!install && !is_installed)
 		return false;
 
-	s = zclient->obuf;
-	stream_reset(s);
+	if (!pbr_rule_batch.s)
+		pbr_rule_batch.s = stream_new(ZEBRA_MAX_PACKET_SIZ);
 
-	zclient_create_header(s,
-			      install ? ZEBRA_RULE_ADD : ZEBRA_RULE_DELETE,
-			      VRF_DEFAULT);
-
-	/*
-	 * We are sending one item at a time at the moment
-	 */
-	stream_putl(s, 1);
+	if (pbr_rule_batch.count
+	    && (pbr_rule_batch.cmd != cmd
+		|| STREAM_WRITEABLE(pbr_rule_batch.s)
+			   < ZEBRA_HEADER_SIZE + 4 + PBR_RULE_ENCODED_MAX))
+		pbr_rule_batch_flush();
 
 	DEBUGD(&pbr_dbg_zebra, "%s:    %s %s seq %u %d %s %u", __func__,
 	       install ? "Installing" : "Deleting", pbrm->name, pbrms->seqno,
 	       install, pmi->ifp->name, pmi->delete);
 
-	pbr_encode_pbr_map_sequence(s, pbrms, pmi->ifp);
-
-	stream_putw_at(s, 0, stream_get_endp(s));
+	pbr_rule_batch.cmd = cmd;
+	pbr_encode_pbr_map_sequence(pbr_rule_batch.s, pbrms, pmi->ifp);
+	pbr_rule_batch.count++;
 
-	zclient_send_message(zclient);
+	thread_add_event(master, pbr_rule_batch_timer, NULL, 0,
+			 &pbr_rule_batch.t_flush);
 
 	return true;
 }
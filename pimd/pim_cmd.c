@@ -2485,8 +2485,11 @@ static void pim_show_upstream(struct pim_instance *pim, struct vty *vty,
 
 		pim_time_timer_to_hhmmss(rs_timer, sizeof(rs_timer),
 					 up->t_rs_timer);
-		pim_time_timer_to_hhmmss(ka_timer, sizeof(ka_timer),
-					 up->t_ka_timer);
+		if (pim_upstream_is_kat_running(up))
+			pim_time_uptime(ka_timer, sizeof(ka_timer),
+					pim_upstream_keep_alive_timer_remain(up));
+		else
+			snprintf(ka_timer, sizeof(ka_timer), "--:--:--");
 		pim_time_timer_to_hhmmss(msdp_reg_timer, sizeof(msdp_reg_timer),
 					 up->t_msdp_reg_timer);
 
@@ -4578,6 +4581,16 @@ DEFUN (show_ip_pim_mlag_summary,
 				    router->mlag_stats.msg.pim_status_updates);
 		json_object_int_add(json_stat, "vxlanUpdates",
 				    router->mlag_stats.msg.vxlan_updates);
+		json_object_int_add(json_stat, "mrouteBulkTx",
+				    router->mlag_stats.msg.mroute_bulk_tx);
+		json_object_int_add(json_stat, "txQueueMax",
+				    router->mlag_stats.msg.tx_queue_max);
+		json_object_boolean_add(json_stat, "replayInProgress",
+					router->mlag_replay.active);
+		json_object_int_add(json_stat, "replayTx",
+				    router->mlag_stats.msg.replay_tx);
+		json_object_int_add(json_stat, "replayPauses",
+				    router->mlag_stats.msg.replay_pauses);
 		json_object_object_add(json, "connStats", json_stat);
 
 		vty_out(vty, "%s\n", json_object_to_json_string_ext(
@@ -4621,6 +4634,13 @@ DEFUN (show_ip_pim_mlag_summary,
 		router->mlag_stats.msg.pim_status_updates);
 	vty_out(vty, "  VxLAN updates: %d\n",
 		router->mlag_stats.msg.vxlan_updates);
+	vty_out(vty, "  mroute bulk messages tx: %u, tx queue max: %u\n",
+		router->mlag_stats.msg.mroute_bulk_tx,
+		router->mlag_stats.msg.tx_queue_max);
+	vty_out(vty, "  mroute replay: %s, tx: %u, paused: %u\n",
+		router->mlag_replay.active ? "in progress" : "done",
+		router->mlag_stats.msg.replay_tx,
+		router->mlag_stats.msg.replay_pauses);
 
 	return CMD_SUCCESS;
 }
@@ -6555,6 +6575,7 @@ DEFUN (clear_ip_mroute_count,
 		return CMD_WARNING;
 
 	pim = vrf->info;
+	pim_mroute_stats_refresh(pim);
 	frr_each(rb_pim_oil, &pim->channel_oil_head, c_oil) {
 		if (!c_oil->installed)
 			continue;
@@ -6640,6 +6661,7 @@ static void show_mroute_count(struct pim_instance *pim, struct vty *vty,
 	}
 
 	/* Print PIM and IGMP route counts */
+	pim_mroute_stats_refresh(pim);
 	frr_each (rb_pim_oil, &pim->channel_oil_head, c_oil)
 		show_mroute_count_per_channel_oil(c_oil, json, vty);
 
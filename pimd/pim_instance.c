@@ -72,6 +72,9 @@ static void pim_instance_terminate(struct pim_instance *pim)
 	XFREE(MTYPE_PIM_PLIST_NAME, pim->spt.plist);
 	XFREE(MTYPE_PIM_PLIST_NAME, pim->register_plist);
 
+	/* after everything that could still queue MFC updates */
+	pim_mroute_queue_finish(pim);
+
 	pim->vrf = NULL;
 	XFREE(MTYPE_PIM_PIM_INSTANCE, pim);
 }
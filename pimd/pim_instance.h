@@ -60,6 +60,24 @@ struct pim_mlag_msg_stats {
 	uint32_t pim_status_updates;
 	uint32_t vxlan_updates;
 	uint32_t peer_zebra_status_updates;
+	/* bulk messages sent to zebra, carrying more than one mroute */
+	uint32_t mroute_bulk_tx;
+	/* mroute adds sent by the replay to a (re)connected mlagd */
+	uint32_t replay_tx;
+	/* times the replay waited for the tx queue to drain */
+	uint32_t replay_pauses;
+	/* longest tx queue towards zebra, in messages */
+	uint32_t tx_queue_max;
+};
+
+/* Replay of the local MLAG mroutes to mlagd, done a queue's worth at a time;
+ * resumes at sg in the VRF named vrf_name.
+ */
+struct pim_mlag_replay {
+	bool active;
+	char vrf_name[VRF_NAMSIZ];
+	struct prefix_sg sg;
+	struct thread *t_replay;
 };
 
 struct pim_mlag_stats {
@@ -117,6 +135,7 @@ struct pim_router {
 	struct stream_fifo *mlag_fifo;
 	struct stream *mlag_stream;
 	struct thread *zpthread_mlag_write;
+	struct pim_mlag_replay mlag_replay;
 	struct in_addr anycast_vtep_ip;
 	struct in_addr local_vtep_ip;
 	struct pim_mlag_stats mlag_stats;
@@ -151,6 +170,11 @@ struct pim_instance {
 	int64_t mroute_add_last;
 	int64_t mroute_del_events;
 	int64_t mroute_del_last;
+	/* MFC updates not written to the kernel yet */
+	struct pim_mfc_queue *mfc_queue;
+	/* kernel counter dumps, see pim_mroute_stats_refresh() */
+	uint32_t mroute_stats_gen;
+	int64_t mroute_stats_time;
 
 	struct interface *regiface;
 
@@ -159,7 +183,13 @@ struct pim_instance {
 
 	// Upstream vrf specific information
 	struct rb_pim_upstream_head upstream_head;
+	/*
+	 * The (*,G)s of upstream_head, which are all that RP changes have to
+	 * look at
+	 */
+	struct pim_star_g_list_head upstream_star_g;
 	struct timer_wheel *upstream_sg_wheel;
+	struct pim_kat_wheel *kat_wheel;
 
 	/*
 	 * RP information
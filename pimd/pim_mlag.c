@@ -508,22 +508,95 @@ void pim_mlag_up_local_del(struct pim_instance *pim,
 	pim_mlag_up_local_del_send(pim, up);
 }
 
-/* When connection to local MLAG daemon is established all the local
- * MLAG upstream entries are replayed to it.
+/* The replay stops queueing adds while the tx queue holds HIGH_WM messages
+ * and is restarted by the tx side once it's down to LOW_WM.
  */
-static void pim_mlag_up_local_replay(void)
+#define PIM_MLAG_REPLAY_HIGH_WM 1000
+#define PIM_MLAG_REPLAY_LOW_WM 250
+
+static int pim_mlag_up_local_replay_run(struct thread *thread)
 {
+	struct pim_mlag_replay *rp = &router->mlag_replay;
+	struct pim_upstream lookup;
 	struct pim_upstream *up;
 	struct vrf *vrf;
 	struct pim_instance *pim;
+	int cmp;
 
 	RB_FOREACH(vrf, vrf_name_head, &vrfs_by_name) {
+		cmp = strcmp(vrf->name, rp->vrf_name);
+		if (cmp < 0)
+			continue;
+
 		pim = vrf->info;
-		frr_each (rb_pim_upstream, &pim->upstream_head, up) {
-			if (pim_up_mlag_is_local(up))
-				pim_mlag_up_local_add_send(pim, up);
+		if (cmp == 0) {
+			lookup.sg = rp->sg;
+			up = rb_pim_upstream_find_gteq(&pim->upstream_head,
+						       &lookup);
+		} else
+			up = rb_pim_upstream_first(&pim->upstream_head);
+
+		for (; up; up = rb_pim_upstream_next(&pim->upstream_head, up)) {
+			if (!pim_up_mlag_is_local(up))
+				continue;
+
+			if (stream_fifo_count_safe(router->mlag_fifo)
+			    >= PIM_MLAG_REPLAY_HIGH_WM) {
+				strlcpy(rp->vrf_name, vrf->name,
+					sizeof(rp->vrf_name));
+				rp->sg = up->sg;
+				++router->mlag_stats.msg.replay_pauses;
+				return 0;
+			}
+
+			pim_mlag_up_local_add_send(pim, up);
+			++router->mlag_stats.msg.replay_tx;
 		}
 	}
+
+	rp->active = false;
+	if (PIM_DEBUG_MLAG)
+		zlog_debug("%s: replayed %u local MLAG mroutes", __func__,
+			   router->mlag_stats.msg.replay_tx);
+	return 0;
+}
+
+/* Called by the tx side as it drains the queue */
+void pim_mlag_up_local_replay_kick(void)
+{
+	struct pim_mlag_replay *rp = &router->mlag_replay;
+
+	if (!rp->active
+	    || stream_fifo_count_safe(router->mlag_fifo)
+		       > PIM_MLAG_REPLAY_LOW_WM)
+		return;
+
+	thread_add_event(router->master, pim_mlag_up_local_replay_run, NULL, 0,
+			 &rp->t_replay);
+}
+
+static void pim_mlag_up_local_replay_stop(void)
+{
+	THREAD_OFF(router->mlag_replay.t_replay);
+	router->mlag_replay.active = false;
+}
+
+/* When connection to local MLAG daemon is established all the local
+ * MLAG upstream entries are replayed to it.  There can be tens of thousands
+ * of them, so they are queued as the queue to zebra drains (and get bulked
+ * there) instead of all at once.
+ */
+static void pim_mlag_up_local_replay(void)
+{
+	struct pim_mlag_replay *rp = &router->mlag_replay;
+
+	pim_mlag_up_local_replay_stop();
+
+	rp->active = true;
+	rp->vrf_name[0] = '\0';
+	memset(&rp->sg, 0, sizeof(rp->sg));
+	thread_add_event(router->master, pim_mlag_up_local_replay_run, NULL, 0,
+			 &rp->t_replay);
 }
 
 /* on local/peer mlag connection and role changes the DF status needs
@@ -921,6 +994,7 @@ int pim_zebra_mlag_process_down(void)
 	if (router->mlag_flags & PIM_MLAGF_PEER_ZEBRA_UP)
 		++router->mlag_stats.peer_zebra_downs;
 	router->connected_to_mlag = false;
+	pim_mlag_up_local_replay_stop();
 	pim_mlag_param_reset();
 	/* on mlagd session down re-eval DF status */
 	pim_mlag_up_local_reeval(false /*mlagd_send*/, "mlagd_down");
@@ -1084,6 +1158,7 @@ void pim_instance_mlag_terminate(struct pim_instance *pim)
 
 void pim_mlag_terminate(void)
 {
+	pim_mlag_up_local_replay_stop();
 	stream_free(router->mlag_stream);
 	router->mlag_stream = NULL;
 	stream_fifo_free(router->mlag_fifo);
@@ -39,6 +39,7 @@ extern int pim_zebra_mlag_handle_msg(struct stream *msg, int len);
 
 /* pm_zpthread.c */
 extern int pim_mlag_signal_zpthread(void);
+extern void pim_mlag_up_local_replay_kick(void);
 extern void pim_zpthread_init(void);
 extern void pim_zpthread_terminate(void);
 
@@ -44,6 +44,35 @@
 #include "pim_sock.h"
 #include "pim_vxlan.h"
 
+#ifdef HAVE_NETLINK
+#include <linux/rtnetlink.h>
+#endif
+
+DEFINE_MTYPE_STATIC(PIMD, PIM_MFC_QUEUE, "PIM MFC update queue");
+DEFINE_MTYPE_STATIC(PIMD, PIM_MFC_REQ, "PIM MFC update");
+
+/* MFC updates written to the kernel per run of pim_mroute_flush() */
+#define PIM_MFC_FLUSH_MAX 1000
+/* seconds a counter dump is used for */
+#define PIM_MROUTE_STATS_MAX_AGE 5
+
+PREDECL_DLIST(pim_mfcq);
+
+struct pim_mfc_req {
+	struct pim_mfcq_item item;
+
+	/* an add is written from c_oil as it is when flushed */
+	struct channel_oil *c_oil;
+	struct mfcctl del;
+};
+
+DECLARE_DLIST(pim_mfcq, struct pim_mfc_req, item);
+
+struct pim_mfc_queue {
+	struct pim_mfcq_head reqs;
+	struct thread *t_flush;
+};
+
 static void mroute_read_on(struct pim_instance *pim);
 
 static int pim_mroute_set(struct pim_instance *pim, int enable)
@@ -956,18 +985,59 @@ static inline void pim_mroute_copy(struct mfcctl *oil,
 	}
 }
 
-/* This function must not be called directly 0
- * use pim_upstream_mroute_add or pim_static_mroute_add instead
- */
-static int pim_mroute_add(struct channel_oil *c_oil, const char *name)
+static int pim_mroute_flush(struct thread *t);
+
+static void pim_mroute_queue(struct pim_instance *pim,
+			     struct pim_mfc_req *req)
+{
+	struct pim_mfc_queue *q = pim->mfc_queue;
+
+	if (!q) {
+		q = pim->mfc_queue = XCALLOC(MTYPE_PIM_MFC_QUEUE, sizeof(*q));
+		pim_mfcq_init(&q->reqs);
+	}
+
+	pim_mfcq_add_tail(&q->reqs, req);
+	thread_add_event(router->master, pim_mroute_flush, pim, 0,
+			 &q->t_flush);
+}
+
+void pim_mroute_unqueue(struct channel_oil *c_oil)
+{
+	struct pim_mfc_req *req = c_oil->mfc_req;
+
+	if (!req)
+		return;
+
+	pim_mfcq_del(&c_oil->pim->mfc_queue->reqs, req);
+	XFREE(MTYPE_PIM_MFC_REQ, req);
+	c_oil->mfc_req = NULL;
+}
+
+void pim_mroute_queue_finish(struct pim_instance *pim)
+{
+	struct pim_mfc_queue *q = pim->mfc_queue;
+	struct pim_mfc_req *req;
+
+	if (!q)
+		return;
+
+	THREAD_OFF(q->t_flush);
+	while ((req = pim_mfcq_pop(&q->reqs))) {
+		if (req->c_oil)
+			req->c_oil->mfc_req = NULL;
+		XFREE(MTYPE_PIM_MFC_REQ, req);
+	}
+	pim_mfcq_fini(&q->reqs);
+	XFREE(MTYPE_PIM_MFC_QUEUE, pim->mfc_queue);
+}
+
+static void pim_mroute_kernel_add(struct channel_oil *c_oil)
 {
 	struct pim_instance *pim = c_oil->pim;
 	struct mfcctl tmp_oil = { {0} };
 	int err;
 
-	pim->mroute_add_last = pim_time_monotonic_sec();
-	++pim->mroute_add_events;
-
 	/* Copy the oil to a temporary structure to fixup (without need to
 	 * later restore) before sending the mroute add to the dataplane
 	 */
@@ -988,14 +1058,15 @@ static int pim_mroute_add(struct channel_oil *c_oil, const char *name)
 	 * the packets to be forwarded.  Then set it
 	 * to the correct IIF afterwords.
 	 */
-	if (!c_oil->installed && c_oil->oil.mfcc_origin.s_addr != INADDR_ANY
+	if (!c_oil->kernel_installed
+	    && c_oil->oil.mfcc_origin.s_addr != INADDR_ANY
 	    && c_oil->oil.mfcc_parent != 0) {
 		tmp_oil.mfcc_parent = 0;
 	}
 	err = setsockopt(pim->mroute_socket, IPPROTO_IP, MRT_ADD_MFC,
 			 &tmp_oil, sizeof(tmp_oil));
 
-	if (!err && !c_oil->installed
+	if (!err && !c_oil->kernel_installed
 	    && c_oil->oil.mfcc_origin.s_addr != INADDR_ANY
 	    && c_oil->oil.mfcc_parent != 0) {
 		tmp_oil.mfcc_parent = c_oil->oil.mfcc_parent;
@@ -1008,12 +1079,85 @@ static int pim_mroute_add(struct channel_oil *c_oil, const char *name)
 			"%s %s: failure: setsockopt(fd=%d,IPPROTO_IP,MRT_ADD_MFC): errno=%d: %s",
 			__FILE__, __func__, pim->mroute_socket, errno,
 			safe_strerror(errno));
-		return -2;
+		if (!c_oil->kernel_installed)
+			c_oil->installed = 0;
+		return;
 	}
 
 	if (PIM_DEBUG_MROUTE) {
 		char buf[1000];
-		zlog_debug("%s(%s), vrf %s Added Route: %s", __func__, name,
+		zlog_debug("%s: vrf %s Added Route: %s", __func__,
+			   pim->vrf->name,
+			   pim_channel_oil_dump(c_oil, buf, sizeof(buf)));
+	}
+
+	c_oil->kernel_installed = 1;
+}
+
+static void pim_mroute_kernel_del(struct pim_instance *pim,
+				  struct mfcctl *mfc)
+{
+	int err;
+
+	err = setsockopt(pim->mroute_socket, IPPROTO_IP, MRT_DEL_MFC, mfc,
+			 sizeof(*mfc));
+	if (err && PIM_DEBUG_MROUTE)
+		zlog_warn(
+			"%s %s: failure: setsockopt(fd=%d,IPPROTO_IP,MRT_DEL_MFC): errno=%d: %s",
+			__FILE__, __func__, pim->mroute_socket, errno,
+			safe_strerror(errno));
+}
+
+/*
+ * Write the queued updates to the kernel.  Like zebra's dataplane, this
+ * takes the kernel calls out of the code paths that change many routes at
+ * once (RP changes, RPF changes, interface events), and a route changed
+ * several times meanwhile is only written once.
+ */
+static int pim_mroute_flush(struct thread *t)
+{
+	struct pim_instance *pim = THREAD_ARG(t);
+	struct pim_mfc_queue *q = pim->mfc_queue;
+	struct pim_mfc_req *req;
+	unsigned int n;
+
+	for (n = 0; n < PIM_MFC_FLUSH_MAX && (req = pim_mfcq_pop(&q->reqs));
+	     n++) {
+		if (req->c_oil) {
+			req->c_oil->mfc_req = NULL;
+			pim_mroute_kernel_add(req->c_oil);
+		} else
+			pim_mroute_kernel_del(pim, &req->del);
+		XFREE(MTYPE_PIM_MFC_REQ, req);
+	}
+
+	if (pim_mfcq_count(&q->reqs))
+		thread_add_event(router->master, pim_mroute_flush, pim, 0,
+				 &q->t_flush);
+	return 0;
+}
+
+/* This function must not be called directly 0
+ * use pim_upstream_mroute_add or pim_static_mroute_add instead
+ */
+static int pim_mroute_add(struct channel_oil *c_oil, const char *name)
+{
+	struct pim_instance *pim = c_oil->pim;
+	struct pim_mfc_req *req;
+
+	pim->mroute_add_last = pim_time_monotonic_sec();
+	++pim->mroute_add_events;
+
+	if (!c_oil->mfc_req) {
+		req = XCALLOC(MTYPE_PIM_MFC_REQ, sizeof(*req));
+		req->c_oil = c_oil;
+		c_oil->mfc_req = req;
+		pim_mroute_queue(pim, req);
+	}
+
+	if (PIM_DEBUG_MROUTE) {
+		char buf[1000];
+		zlog_debug("%s(%s), vrf %s Queued Route: %s", __func__, name,
 			   pim->vrf->name,
 			   pim_channel_oil_dump(c_oil, buf, sizeof(buf)));
 	}
@@ -1165,7 +1309,6 @@ void pim_static_mroute_iif_update(struct channel_oil *c_oil,
 int pim_mroute_del(struct channel_oil *c_oil, const char *name)
 {
 	struct pim_instance *pim = c_oil->pim;
-	int err;
 
 	pim->mroute_del_last = pim_time_monotonic_sec();
 	++pim->mroute_del_events;
@@ -1181,15 +1324,16 @@ int pim_mroute_del(struct channel_oil *c_oil, const char *name)
 		return -2;
 	}
 
-	err = setsockopt(pim->mroute_socket, IPPROTO_IP, MRT_DEL_MFC,
-			 &c_oil->oil, sizeof(c_oil->oil));
-	if (err) {
-		if (PIM_DEBUG_MROUTE)
-			zlog_warn(
-				"%s %s: failure: setsockopt(fd=%d,IPPROTO_IP,MRT_DEL_MFC): errno=%d: %s",
-				__FILE__, __func__, pim->mroute_socket, errno,
-				safe_strerror(errno));
-		return -2;
+	/* an add that hasn't been written yet is simply dropped */
+	pim_mroute_unqueue(c_oil);
+	if (c_oil->kernel_installed) {
+		struct pim_mfc_req *req;
+
+		/* c_oil may be gone by the time this is written */
+		req = XCALLOC(MTYPE_PIM_MFC_REQ, sizeof(*req));
+		req->del = c_oil->oil;
+		pim_mroute_queue(pim, req);
+		c_oil->kernel_installed = 0;
 	}
 
 	if (PIM_DEBUG_MROUTE) {
@@ -1205,6 +1349,161 @@ int pim_mroute_del(struct channel_oil *c_oil, const char *name)
 	return 0;
 }
 
+#ifdef HAVE_NETLINK
+/* shared by all instances, the dump covers every table */
+static int mroute_nl_sock = -1;
+static uint32_t mroute_nl_seq;
+
+static void pim_mroute_stats_parse(struct pim_instance *pim,
+				   struct nlmsghdr *h, uint32_t table)
+{
+	struct rtmsg *rtm = NLMSG_DATA(h);
+	struct rtattr *rta;
+	struct rta_mfc_stats *mfcs = NULL;
+	unsigned long long lastused = 0;
+	uint32_t rtable = rtm->rtm_table;
+	struct channel_oil *c_oil;
+	struct prefix_sg sg = {};
+	int len;
+
+	len = h->nlmsg_len - NLMSG_LENGTH(sizeof(*rtm));
+	for (rta = RTM_RTA(rtm); RTA_OK(rta, len); rta = RTA_NEXT(rta, len)) {
+		switch (rta->rta_type) {
+		case RTA_TABLE:
+			rtable = *(uint32_t *)RTA_DATA(rta);
+			break;
+		case RTA_SRC:
+			sg.src = *(struct in_addr *)RTA_DATA(rta);
+			break;
+		case RTA_DST:
+			sg.grp = *(struct in_addr *)RTA_DATA(rta);
+			break;
+		case RTA_MFC_STATS:
+			mfcs = RTA_DATA(rta);
+			break;
+		case RTA_EXPIRES:
+			lastused = *(unsigned long long *)RTA_DATA(rta);
+			break;
+		}
+	}
+
+	if (rtable != table || !mfcs)
+		return;
+
+	c_oil = pim_find_channel_oil(pim, &sg);
+	if (!c_oil)
+		return;
+
+	c_oil->kc.pktcnt = mfcs->mfcs_packets;
+	c_oil->kc.bytecnt = mfcs->mfcs_bytes;
+	c_oil->kc.wrong_if = mfcs->mfcs_wrong_if;
+	c_oil->kc.lastused = lastused;
+	c_oil->kc.gen = pim->mroute_stats_gen;
+}
+
+/* One RTM_GETROUTE dump instead of a SIOCGETSGCNT ioctl and a zebra
+ * lookup for each (S,G).
+ */
+static void pim_mroute_stats_dump(struct pim_instance *pim)
+{
+	static char buf[65536] __attribute__((aligned(NLMSG_ALIGNTO)));
+	struct {
+		struct nlmsghdr n;
+		struct rtmsg rtm;
+	} req = {};
+	struct nlmsghdr *h;
+	uint32_t table;
+	ssize_t len;
+
+	if (mroute_nl_sock < 0) {
+		mroute_nl_sock = socket(AF_NETLINK, SOCK_RAW | SOCK_CLOEXEC,
+					NETLINK_ROUTE);
+		if (mroute_nl_sock < 0)
+			return;
+	}
+
+	/* what MRT_TABLE was given, or the kernel's default */
+	table = pim->vrf->vrf_id != VRF_DEFAULT ? pim->vrf->data.l.table_id
+						: RT_TABLE_DEFAULT;
+
+	req.n.nlmsg_len = NLMSG_LENGTH(sizeof(req.rtm));
+	req.n.nlmsg_type = RTM_GETROUTE;
+	req.n.nlmsg_flags = NLM_F_REQUEST | NLM_F_DUMP;
+	req.n.nlmsg_seq = ++mroute_nl_seq;
+	req.rtm.rtm_family = RTNL_FAMILY_IPMR;
+
+	if (send(mroute_nl_sock, &req, req.n.nlmsg_len, 0) < 0)
+		goto fail;
+
+	pim->mroute_stats_gen++;
+	for (;;) {
+		len = recv(mroute_nl_sock, buf, sizeof(buf), 0);
+		if (len < 0) {
+			if (errno == EINTR)
+				continue;
+			goto fail;
+		}
+
+		for (h = (struct nlmsghdr *)buf; NLMSG_OK(h, len);
+		     h = NLMSG_NEXT(h, len)) {
+			if (h->nlmsg_seq != mroute_nl_seq)
+				continue;
+			if (h->nlmsg_type == NLMSG_DONE)
+				return;
+			if (h->nlmsg_type == NLMSG_ERROR)
+				goto fail;
+			if (h->nlmsg_type == RTM_NEWROUTE)
+				pim_mroute_stats_parse(pim, h, table);
+		}
+	}
+
+fail:
+	zlog_warn("%s: mroute counter dump failed: errno=%d: %s", __func__,
+		  errno, safe_strerror(errno));
+	/* don't leave the rest of a dump in the way of the next one */
+	close(mroute_nl_sock);
+	mroute_nl_sock = -1;
+	return;
+}
+#endif /* HAVE_NETLINK */
+
+void pim_mroute_stats_refresh(struct pim_instance *pim)
+{
+#ifdef HAVE_NETLINK
+	/* after a failure too, so it isn't retried once per (S,G) */
+	pim->mroute_stats_time = pim_time_monotonic_sec();
+	pim_mroute_stats_dump(pim);
+#endif
+}
+
+/*
+ * Take c_oil's counters from the last dump, if it's recent and they
+ * haven't been used already.
+ */
+static bool pim_mroute_stats_get(struct channel_oil *c_oil)
+{
+#ifdef HAVE_NETLINK
+	struct pim_instance *pim = c_oil->pim;
+
+	if (!pim->mroute_stats_gen
+	    || pim_time_monotonic_sec() - pim->mroute_stats_time
+		       >= PIM_MROUTE_STATS_MAX_AGE)
+		pim_mroute_stats_refresh(pim);
+
+	if (!pim->mroute_stats_gen || c_oil->kc.gen != pim->mroute_stats_gen)
+		return false;
+
+	c_oil->kc.gen = 0;
+	c_oil->cc.pktcnt = c_oil->kc.pktcnt;
+	c_oil->cc.bytecnt = c_oil->kc.bytecnt;
+	c_oil->cc.wrong_if = c_oil->kc.wrong_if;
+	c_oil->cc.lastused = c_oil->kc.lastused;
+	return true;
+#else
+	return false;
+#endif
+}
+
 void pim_mroute_update_counters(struct channel_oil *c_oil)
 {
 	struct pim_instance *pim = c_oil->pim;
@@ -1214,7 +1513,7 @@ void pim_mroute_update_counters(struct channel_oil *c_oil)
 	c_oil->cc.oldbytecnt = c_oil->cc.bytecnt;
 	c_oil->cc.oldwrong_if = c_oil->cc.wrong_if;
 
-	if (!c_oil->installed) {
+	if (!c_oil->installed || !c_oil->kernel_installed) {
 		c_oil->cc.lastused = 100 * pim->keep_alive_time;
 		if (PIM_DEBUG_MROUTE) {
 			struct prefix_sg sg;
@@ -1228,6 +1527,9 @@ void pim_mroute_update_counters(struct channel_oil *c_oil)
 		return;
 	}
 
+	if (pim_mroute_stats_get(c_oil))
+		return;
+
 	memset(&sgreq, 0, sizeof(sgreq));
 	sgreq.src = c_oil->oil.mfcc_origin;
 	sgreq.grp = c_oil->oil.mfcc_mcastgrp;
@@ -182,6 +182,15 @@ void pim_static_mroute_iif_update(struct channel_oil *c_oil,
 				const char *name);
 int pim_mroute_del(struct channel_oil *c_oil, const char *name);
 
+/* Drop the queued MFC updates, for a channel_oil or the whole instance. */
+void pim_mroute_unqueue(struct channel_oil *c_oil);
+void pim_mroute_queue_finish(struct pim_instance *pim);
+
+/* Get the counters of all (S,G)s at once where the kernel can, so that
+ * the pim_mroute_update_counters() calls that follow don't each need one
+ * query.
+ */
+void pim_mroute_stats_refresh(struct pim_instance *pim);
 void pim_mroute_update_counters(struct channel_oil *c_oil);
 bool pim_mroute_allow_iif_in_oil(struct channel_oil *c_oil,
 		int oif_index);
@@ -202,6 +202,9 @@ struct pim_msdp {
 
 	/* keep a scratch pad for building SA TLVs */
 	struct stream *work_obuf;
+	/* the SA TLVs of the local SAs, as of the last advertisement */
+	struct stream_fifo *sa_cache;
+	bool sa_cache_valid;
 
 	struct in_addr originator_id;
 
@@ -313,8 +313,8 @@ void pim_msdp_pkt_ka_tx(struct pim_msdp_peer *mp)
 	pim_msdp_pkt_send(mp, s);
 }
 
-static void pim_msdp_pkt_sa_push_to_one_peer(struct pim_instance *pim,
-					     struct pim_msdp_peer *mp)
+static void pim_msdp_pkt_sa_push_to_one_peer(struct pim_msdp_peer *mp,
+					     struct stream *pkt)
 {
 	struct stream *s;
 
@@ -322,7 +322,7 @@ static void pim_msdp_pkt_sa_push_to_one_peer(struct pim_instance *pim,
 		/* don't tx anything unless a session is established */
 		return;
 	}
-	s = stream_dup(pim->msdp.work_obuf);
+	s = stream_dup(pkt);
 	if (s) {
 		pim_msdp_pkt_send(mp, s);
 		mp->flags |= PIM_MSDP_PEERF_SA_JUST_SENT;
@@ -331,19 +331,19 @@ static void pim_msdp_pkt_sa_push_to_one_peer(struct pim_instance *pim,
 
 /* push the stream into the obuf fifo of all the peers */
 static void pim_msdp_pkt_sa_push(struct pim_instance *pim,
-				 struct pim_msdp_peer *mp)
+				 struct pim_msdp_peer *mp, struct stream *pkt)
 {
 	struct listnode *mpnode;
 
 	if (mp) {
-		pim_msdp_pkt_sa_push_to_one_peer(pim, mp);
+		pim_msdp_pkt_sa_push_to_one_peer(mp, pkt);
 	} else {
 		for (ALL_LIST_ELEMENTS_RO(pim->msdp.peer_list, mpnode, mp)) {
 			if (PIM_DEBUG_MSDP_INTERNAL) {
 				zlog_debug("MSDP peer %s pim_msdp_pkt_sa_push",
 					   mp->key_str);
 			}
-			pim_msdp_pkt_sa_push_to_one_peer(pim, mp);
+			pim_msdp_pkt_sa_push_to_one_peer(mp, pkt);
 		}
 	}
 }
@@ -375,14 +375,36 @@ static void pim_msdp_pkt_sa_fill_one(struct pim_msdp_sa *sa)
 	stream_put_ipv4(sa->pim->msdp.work_obuf, sa->sg.src.s_addr);
 }
 
-static void pim_msdp_pkt_sa_gen(struct pim_instance *pim,
-				struct pim_msdp_peer *mp)
+/* the local SAs changed, re-encode them on the next advertisement */
+void pim_msdp_pkt_sa_cache_flush(struct pim_instance *pim)
+{
+	pim->msdp.sa_cache_valid = false;
+}
+
+/* keep a copy of the SA TLV built in the scratch pad */
+static void pim_msdp_pkt_sa_cache_push(struct pim_instance *pim)
+{
+	struct stream *s;
+
+	s = stream_dup(pim->msdp.work_obuf);
+	if (s)
+		stream_fifo_push(pim->msdp.sa_cache, s);
+}
+
+/*
+ * The local SAs are encoded once into sa_cache, and the same packets are
+ * then queued to every peer, on every advertisement, until they change.
+ */
+static void pim_msdp_pkt_sa_cache_build(struct pim_instance *pim)
 {
 	struct listnode *sanode;
 	struct pim_msdp_sa *sa;
 	int sa_count;
 	int local_cnt = pim->msdp.local_cnt;
 
+	stream_fifo_clean(pim->msdp.sa_cache);
+	pim->msdp.sa_cache_valid = true;
+
 	sa_count = 0;
 	if (PIM_DEBUG_MSDP_INTERNAL) {
 		zlog_debug("  sa gen  %d", local_cnt);
@@ -403,7 +425,7 @@ static void pim_msdp_pkt_sa_gen(struct pim_instance *pim,
 		pim_msdp_pkt_sa_fill_one(sa);
 		++sa_count;
 		if (sa_count >= PIM_MSDP_SA_MAX_ENTRY_CNT) {
-			pim_msdp_pkt_sa_push(pim, mp);
+			pim_msdp_pkt_sa_cache_push(pim);
 			/* reset headers */
 			sa_count = 0;
 			if (PIM_DEBUG_MSDP_INTERNAL) {
@@ -416,9 +438,20 @@ static void pim_msdp_pkt_sa_gen(struct pim_instance *pim,
 	}
 
 	if (sa_count) {
-		pim_msdp_pkt_sa_push(pim, mp);
+		pim_msdp_pkt_sa_cache_push(pim);
 	}
-	return;
+}
+
+static void pim_msdp_pkt_sa_gen(struct pim_instance *pim,
+				struct pim_msdp_peer *mp)
+{
+	struct stream *s;
+
+	if (!pim->msdp.sa_cache_valid)
+		pim_msdp_pkt_sa_cache_build(pim);
+
+	for (s = stream_fifo_head(pim->msdp.sa_cache); s; s = s->next)
+		pim_msdp_pkt_sa_push(pim, mp, s);
 }
 
 static void pim_msdp_pkt_sa_tx_done(struct pim_instance *pim)
@@ -446,7 +479,7 @@ void pim_msdp_pkt_sa_tx_one(struct pim_msdp_sa *sa)
 {
 	pim_msdp_pkt_sa_fill_hdr(sa->pim, 1 /* cnt */, sa->rp);
 	pim_msdp_pkt_sa_fill_one(sa);
-	pim_msdp_pkt_sa_push(sa->pim, NULL);
+	pim_msdp_pkt_sa_push(sa->pim, NULL, sa->pim->msdp.work_obuf);
 	pim_msdp_pkt_sa_tx_done(sa->pim);
 }
 
@@ -471,7 +504,7 @@ void pim_msdp_pkt_sa_tx_one_to_one_peer(struct pim_msdp_peer *mp,
 	pim_msdp_pkt_sa_fill_one(&sa);
 
 	/* Pushes the message. */
-	pim_msdp_pkt_sa_push(sa.pim, mp);
+	pim_msdp_pkt_sa_push(sa.pim, mp, sa.pim->msdp.work_obuf);
 	pim_msdp_pkt_sa_tx_done(sa.pim);
 }
 
@@ -184,14 +184,11 @@ void pim_delete_tracked_nexthop(struct pim_instance *pim, struct prefix *addr,
 			/* Release the (*, G)upstream from pnc->upstream_hash,
 			 * whose Group belongs to the RP getting deleted
 			 */
-			frr_each (rb_pim_upstream, &pim->upstream_head,
+			frr_each (pim_star_g_list, &pim->upstream_star_g,
 				  upstream) {
 				struct prefix grp;
 				struct rp_info *trp_info;
 
-				if (upstream->sg.src.s_addr != INADDR_ANY)
-					continue;
-
 				grp.family = AF_INET;
 				grp.prefixlen = IPV4_MAX_BITLEN;
 				grp.u.prefix4 = upstream->sg.grp;
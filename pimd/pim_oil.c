@@ -100,6 +100,7 @@ void pim_oil_terminate(struct pim_instance *pim)
 
 void pim_channel_oil_free(struct channel_oil *c_oil)
 {
+	pim_mroute_unqueue(c_oil);
 	XFREE(MTYPE_PIM_CHANNEL_OIL, c_oil);
 }
 
@@ -107,6 +107,21 @@ struct channel_oil {
 	struct channel_counts cc;
 	struct pim_upstream *up;
 	time_t mroute_creation;
+
+	/*
+	 * installed is what the kernel is meant to have; the updates are
+	 * queued (mfc_req) and kernel_installed says what it does have.
+	 */
+	struct pim_mfc_req *mfc_req;
+	int kernel_installed;
+	/* from the last counter dump, until pim_mroute_update_counters() */
+	struct {
+		unsigned long long lastused;
+		unsigned long pktcnt;
+		unsigned long bytecnt;
+		unsigned long wrong_if;
+		uint32_t gen;
+	} kc;
 };
 
 extern int pim_channel_oil_compare(const struct channel_oil *c1,
@@ -511,12 +511,11 @@ int pim_rp_new(struct pim_instance *pim, struct in_addr rp_addr,
 					"%s: NHT Register rp_all addr %pFX grp %pFX ",
 					__func__, &nht_p, &rp_all->group);
 
-			frr_each (rb_pim_upstream, &pim->upstream_head, up) {
+			frr_each (pim_star_g_list, &pim->upstream_star_g, up) {
 				/* Find (*, G) upstream whose RP is not
 				 * configured yet
 				 */
-				if ((up->upstream_addr.s_addr == INADDR_ANY)
-				    && (up->sg.src.s_addr == INADDR_ANY)) {
+				if (up->upstream_addr.s_addr == INADDR_ANY) {
 					struct prefix grp;
 					struct rp_info *trp_info;
 
@@ -602,19 +601,17 @@ int pim_rp_new(struct pim_instance *pim, struct in_addr rp_addr,
 			   rp_info, &rp_info->group,
 			   route_node_get_lock_count(rn));
 
-	frr_each (rb_pim_upstream, &pim->upstream_head, up) {
-		if (up->sg.src.s_addr == INADDR_ANY) {
-			struct prefix grp;
-			struct rp_info *trp_info;
+	frr_each (pim_star_g_list, &pim->upstream_star_g, up) {
+		struct prefix grp;
+		struct rp_info *trp_info;
 
-			grp.family = AF_INET;
-			grp.prefixlen = IPV4_MAX_BITLEN;
-			grp.u.prefix4 = up->sg.grp;
-			trp_info = pim_rp_find_match_group(pim, &grp);
+		grp.family = AF_INET;
+		grp.prefixlen = IPV4_MAX_BITLEN;
+		grp.u.prefix4 = up->sg.grp;
+		trp_info = pim_rp_find_match_group(pim, &grp);
 
-			if (trp_info == rp_info)
-				pim_upstream_update(pim, up);
-		}
+		if (trp_info == rp_info)
+			pim_upstream_update(pim, up);
 	}
 
 	pim_rp_check_interfaces(pim, rp_info);
@@ -743,13 +740,12 @@ int pim_rp_del(struct pim_instance *pim, struct in_addr rp_addr,
 	rp_all = pim_rp_find_match_group(pim, &g_all);
 
 	if (rp_all == rp_info) {
-		frr_each (rb_pim_upstream, &pim->upstream_head, up) {
+		frr_each (pim_star_g_list, &pim->upstream_star_g, up) {
 			/* Find the upstream (*, G) whose upstream address is
 			 * same as the deleted RP
 			 */
-			if ((up->upstream_addr.s_addr
-			     == rp_info->rp.rpf_addr.u.prefix4.s_addr)
-			    && (up->sg.src.s_addr == INADDR_ANY)) {
+			if (up->upstream_addr.s_addr
+			    == rp_info->rp.rpf_addr.u.prefix4.s_addr) {
 				struct prefix grp;
 				grp.family = AF_INET;
 				grp.prefixlen = IPV4_MAX_BITLEN;
@@ -791,13 +787,12 @@ int pim_rp_del(struct pim_instance *pim, struct in_addr rp_addr,
 
 	pim_rp_refresh_group_to_rp_mapping(pim);
 
-	frr_each (rb_pim_upstream, &pim->upstream_head, up) {
+	frr_each (pim_star_g_list, &pim->upstream_star_g, up) {
 		/* Find the upstream (*, G) whose upstream address is same as
 		 * the deleted RP
 		 */
-		if ((up->upstream_addr.s_addr
-		     == rp_info->rp.rpf_addr.u.prefix4.s_addr)
-		    && (up->sg.src.s_addr == INADDR_ANY)) {
+		if (up->upstream_addr.s_addr
+		    == rp_info->rp.rpf_addr.u.prefix4.s_addr) {
 			struct prefix grp;
 
 			grp.family = AF_INET;
@@ -876,19 +871,17 @@ int pim_rp_change(struct pim_instance *pim, struct in_addr new_rp_addr,
 
 	listnode_add_sort(pim->rp_list, rp_info);
 
-	frr_each (rb_pim_upstream, &pim->upstream_head, up) {
-		if (up->sg.src.s_addr == INADDR_ANY) {
-			struct prefix grp;
-			struct rp_info *trp_info;
+	frr_each (pim_star_g_list, &pim->upstream_star_g, up) {
+		struct prefix grp;
+		struct rp_info *trp_info;
 
-			grp.family = AF_INET;
-			grp.prefixlen = IPV4_MAX_BITLEN;
-			grp.u.prefix4 = up->sg.grp;
-			trp_info = pim_rp_find_match_group(pim, &grp);
+		grp.family = AF_INET;
+		grp.prefixlen = IPV4_MAX_BITLEN;
+		grp.u.prefix4 = up->sg.grp;
+		trp_info = pim_rp_find_match_group(pim, &grp);
 
-			if (trp_info == rp_info)
-				pim_upstream_update(pim, up);
-		}
+		if (trp_info == rp_info)
+			pim_upstream_update(pim, up);
 	}
 
 	/* Register new RP addr with Zebra NHT */
@@ -34,6 +34,7 @@
 
 void pim_static_route_free(struct static_route *s_route)
 {
+	pim_mroute_unqueue(&s_route->c_oil);
 	XFREE(MTYPE_PIM_STATIC_ROUTE, s_route);
 }
 
@@ -55,6 +55,8 @@
 #include "pim_vxlan.h"
 #include "pim_mlag.h"
 
+DEFINE_MTYPE_STATIC(PIMD, PIM_KAT_WHEEL, "PIM KAT wheel");
+
 static void join_timer_stop(struct pim_upstream *up);
 static void
 pim_upstream_update_assert_tracking_desired(struct pim_upstream *up);
@@ -210,7 +212,7 @@ struct pim_upstream *pim_upstream_del(struct pim_instance *pim,
 	if (pim_up_mlag_is_local(up))
 		pim_mlag_up_local_del(pim, up);
 
-	THREAD_OFF(up->t_ka_timer);
+	pim_upstream_keep_alive_timer_stop(up);
 	THREAD_OFF(up->t_rs_timer);
 	THREAD_OFF(up->t_msdp_reg_timer);
 
@@ -251,6 +253,8 @@ struct pim_upstream *pim_upstream_del(struct pim_instance *pim,
 	up->parent = NULL;
 
 	rb_pim_upstream_del(&pim->upstream_head, up);
+	if (up->sg.src.s_addr == INADDR_ANY)
+		pim_star_g_list_del(&pim->upstream_star_g, up);
 
 	if (notify_msdp) {
 		pim_msdp_up_del(pim, &up->sg);
@@ -879,6 +883,8 @@ static struct pim_upstream *pim_upstream_new(struct pim_instance *pim,
 		ch->upstream = up;
 
 	rb_pim_upstream_add(&pim->upstream_head, up);
+	if (up->sg.src.s_addr == INADDR_ANY)
+		pim_star_g_list_add_tail(&pim->upstream_star_g, up);
 	/* Set up->upstream_addr as INADDR_ANY, if RP is not
 	 * configured and retain the upstream data structure
 	 */
@@ -901,7 +907,7 @@ static struct pim_upstream *pim_upstream_new(struct pim_instance *pim,
 	up->flags = flags;
 	up->ref_count = 1;
 	up->t_join_timer = NULL;
-	up->t_ka_timer = NULL;
+	up->ka_expire = 0;
 	up->t_rs_timer = NULL;
 	up->t_msdp_reg_timer = NULL;
 	up->join_state = PIM_UPSTREAM_NOTJOINED;
@@ -1504,31 +1510,157 @@ struct pim_upstream *pim_upstream_keep_alive_timer_proc(
 
 	return up;
 }
-static int pim_upstream_keep_alive_timer(struct thread *t)
+
+/*
+ * The KATs of all the (S,G)s of an instance share a single one second timer:
+ * an upstream sits in the slot of the second its KAT runs out at, modulo the
+ * number of slots, and each tick only looks at the slots that came due.
+ * Restarting a KAT, which is done whenever traffic is seen, is then just
+ * moving it to another slot.
+ */
+#define PIM_KAT_SLOTS 256
+/* ka_expire of the upstreams whose KAT is being expired */
+#define PIM_KAT_EXPIRING (-1)
+
+struct pim_kat_wheel {
+	struct pim_kat_list_head slots[PIM_KAT_SLOTS];
+	/* upstreams taken off their slot, for the tick being run */
+	struct pim_kat_list_head expiring;
+	size_t count;
+	int64_t last;
+	struct thread *t_tick;
+};
+
+static int pim_kat_wheel_tick(struct thread *t);
+
+static void pim_kat_wheel_schedule(struct pim_kat_wheel *kw)
 {
+	if (!kw->count) {
+		THREAD_OFF(kw->t_tick);
+		return;
+	}
+	if (!kw->t_tick)
+		thread_add_timer(router->master, pim_kat_wheel_tick, kw, 1,
+				 &kw->t_tick);
+}
+
+static int pim_kat_wheel_tick(struct thread *t)
+{
+	struct pim_kat_wheel *kw = THREAD_ARG(t);
+	struct pim_kat_list_head *slot;
 	struct pim_upstream *up;
+	int64_t now = pim_time_monotonic_sec();
+	int64_t sec;
+
+	/* catch up with the seconds the tick came late for */
+	sec = MAX(kw->last + 1, now - PIM_KAT_SLOTS + 1);
+	for (; sec <= now; sec++) {
+		slot = &kw->slots[sec % PIM_KAT_SLOTS];
+		frr_each_safe (pim_kat_list, slot, up) {
+			if (up->ka_expire > now)
+				continue;
+			pim_kat_list_del(slot, up);
+			up->ka_expire = PIM_KAT_EXPIRING;
+			pim_kat_list_add_tail(&kw->expiring, up);
+		}
+	}
+	kw->last = now;
 
-	up = THREAD_ARG(t);
+	/*
+	 * The upstreams can restart their KAT or go away from here, along
+	 * with others of the list; they take themselves off it either way.
+	 */
+	while ((up = pim_kat_list_pop(&kw->expiring))) {
+		kw->count--;
+		up->ka_expire = 0;
 
-	/* pull the stats and re-check */
-	if (pim_upstream_sg_running_proc(up))
-		/* kat was restarted because of new activity */
-		return 0;
+		/* pull the stats and re-check */
+		if (pim_upstream_sg_running_proc(up))
+			/* kat was restarted because of new activity */
+			continue;
+
+		pim_upstream_keep_alive_timer_proc(up);
+	}
 
-	pim_upstream_keep_alive_timer_proc(up);
+	pim_kat_wheel_schedule(kw);
 	return 0;
 }
 
+static void pim_kat_wheel_init(struct pim_instance *pim)
+{
+	struct pim_kat_wheel *kw;
+	int i;
+
+	kw = XCALLOC(MTYPE_PIM_KAT_WHEEL, sizeof(*kw));
+	for (i = 0; i < PIM_KAT_SLOTS; i++)
+		pim_kat_list_init(&kw->slots[i]);
+	pim_kat_list_init(&kw->expiring);
+	kw->last = pim_time_monotonic_sec();
+	pim->kat_wheel = kw;
+}
+
+static void pim_kat_wheel_free(struct pim_instance *pim)
+{
+	struct pim_kat_wheel *kw = pim->kat_wheel;
+	int i;
+
+	if (!kw)
+		return;
+
+	/* the upstreams are all gone by now */
+	assert(!kw->count);
+	THREAD_OFF(kw->t_tick);
+	for (i = 0; i < PIM_KAT_SLOTS; i++)
+		pim_kat_list_fini(&kw->slots[i]);
+	pim_kat_list_fini(&kw->expiring);
+	XFREE(MTYPE_PIM_KAT_WHEEL, pim->kat_wheel);
+}
+
+void pim_upstream_keep_alive_timer_stop(struct pim_upstream *up)
+{
+	struct pim_kat_wheel *kw = up->pim->kat_wheel;
+
+	if (!up->ka_expire)
+		return;
+
+	if (up->ka_expire == PIM_KAT_EXPIRING)
+		pim_kat_list_del(&kw->expiring, up);
+	else
+		pim_kat_list_del(&kw->slots[up->ka_expire % PIM_KAT_SLOTS],
+				 up);
+	up->ka_expire = 0;
+	kw->count--;
+	pim_kat_wheel_schedule(kw);
+}
+
+long pim_upstream_keep_alive_timer_remain(struct pim_upstream *up)
+{
+	if (!pim_upstream_is_kat_running(up))
+		return -1;
+
+	return MAX(up->ka_expire - pim_time_monotonic_sec(), 0);
+}
+
 void pim_upstream_keep_alive_timer_start(struct pim_upstream *up, uint32_t time)
 {
+	struct pim_kat_wheel *kw = up->pim->kat_wheel;
+	int64_t expire;
+
 	if (!PIM_UPSTREAM_FLAG_TEST_SRC_STREAM(up->flags)) {
 		if (PIM_DEBUG_PIM_TRACE)
 			zlog_debug("kat start on %s with no stream reference",
 				   up->sg_str);
 	}
-	THREAD_OFF(up->t_ka_timer);
-	thread_add_timer(router->master, pim_upstream_keep_alive_timer, up,
-			 time, &up->t_ka_timer);
+
+	/* expires on the first tick at least 'time' seconds from now */
+	expire = pim_time_monotonic_sec() + MAX(time, 1U);
+	if (up->ka_expire != expire) {
+		pim_upstream_keep_alive_timer_stop(up);
+		up->ka_expire = expire;
+		pim_kat_list_add_tail(&kw->slots[expire % PIM_KAT_SLOTS], up);
+		kw->count++;
+		pim_kat_wheel_schedule(kw);
+	}
 
 	/* any time keepalive is started against a SG we will have to
 	 * re-evaluate our active source database */
@@ -1972,10 +2104,13 @@ void pim_upstream_terminate(struct pim_instance *pim)
 	}
 
 	rb_pim_upstream_fini(&pim->upstream_head);
+	pim_star_g_list_fini(&pim->upstream_star_g);
 
 	if (pim->upstream_sg_wheel)
 		wheel_delete(pim->upstream_sg_wheel);
 	pim->upstream_sg_wheel = NULL;
+
+	pim_kat_wheel_free(pim);
 }
 
 bool pim_upstream_equal(const void *arg1, const void *arg2)
@@ -2208,6 +2343,8 @@ void pim_upstream_init(struct pim_instance *pim)
 	pim->upstream_sg_wheel =
 		wheel_init(router->master, 31000, 100, pim_upstream_hash_key,
 			   pim_upstream_sg_running, name);
+	pim_kat_wheel_init(pim);
 
 	rb_pim_upstream_init(&pim->upstream_head);
+	pim_star_g_list_init(&pim->upstream_star_g);
 }
@@ -197,7 +197,9 @@ struct pim_up_mlag {
 	uint32_t peer_mrib_metric;
 };
 
-PREDECL_RBTREE_UNIQ(rb_pim_upstream);
+PREDECL_BPTREE_UNIQ(rb_pim_upstream);
+PREDECL_DLIST(pim_kat_list);
+PREDECL_DLIST(pim_star_g_list);
 /*
   Upstream (S,G) channel in Joined state
   (S,G) in the "Not Joined" state is not represented
@@ -228,6 +230,8 @@ PREDECL_RBTREE_UNIQ(rb_pim_upstream);
 struct pim_upstream {
 	struct pim_instance *pim;
 	struct rb_pim_upstream_item upstream_rb;
+	/* on pim->upstream_star_g if this is a (*,G) */
+	struct pim_star_g_list_item star_g_item;
 	struct pim_upstream *parent;
 	struct in_addr upstream_addr;     /* Who we are talking to */
 	struct in_addr upstream_register; /*Who we received a register from*/
@@ -260,9 +264,12 @@ struct pim_upstream {
 #define PIM_REGISTER_PROBE_PERIOD        (5)
 
 	/*
-	 * KAT(S,G)
+	 * KAT(S,G), kept on the instance's KAT wheel instead of a thread of
+	 * its own.  ka_expire is the monotonic second it runs out at, 0 if it
+	 * isn't running.
 	 */
-	struct thread *t_ka_timer;
+	struct pim_kat_list_item kat_item;
+	int64_t ka_expire;
 #define PIM_KEEPALIVE_PERIOD  (210)
 #define PIM_RP_KEEPALIVE_PERIOD                                                \
 	(3 * router->register_suppress_time + router->register_probe_time)
@@ -278,7 +285,7 @@ struct pim_upstream {
 
 static inline bool pim_upstream_is_kat_running(struct pim_upstream *up)
 {
-	return (up->t_ka_timer != NULL);
+	return (up->ka_expire > 0);
 }
 
 static inline bool pim_up_mlag_is_local(struct pim_upstream *up)
@@ -336,6 +343,9 @@ void pim_upstream_update_my_assert_metric(struct pim_upstream *up);
 
 void pim_upstream_keep_alive_timer_start(struct pim_upstream *up,
 					 uint32_t time);
+void pim_upstream_keep_alive_timer_stop(struct pim_upstream *up);
+/* seconds left on the KAT, -1 if it isn't running */
+long pim_upstream_keep_alive_timer_remain(struct pim_upstream *up);
 
 int pim_upstream_switch_to_spt_desired_on_rp(struct pim_instance *pim,
 				       struct prefix_sg *sg);
@@ -373,8 +383,10 @@ void pim_upstream_terminate(struct pim_instance *pim);
 void join_timer_start(struct pim_upstream *up);
 int pim_upstream_compare(const struct pim_upstream *up1,
 			 const struct pim_upstream *up2);
-DECLARE_RBTREE_UNIQ(rb_pim_upstream, struct pim_upstream, upstream_rb,
+DECLARE_BPTREE_UNIQ(rb_pim_upstream, struct pim_upstream, upstream_rb,
 		    pim_upstream_compare);
+DECLARE_DLIST(pim_kat_list, struct pim_upstream, kat_item);
+DECLARE_DLIST(pim_star_g_list, struct pim_upstream, star_g_item);
 
 void pim_upstream_register_reevaluate(struct pim_instance *pim);
 
@@ -79,6 +79,7 @@ static void pim_mlag_zebra_flush_buffer(void)
 
 	/* Stream had bulk messages update the Hedaer */
 	if (mlag_bulk_cnt > 1) {
+		++router->mlag_stats.msg.mroute_bulk_tx;
 		/*
 		 * No need to reset the pointer, below api reads from data[0]
 		 */
@@ -157,6 +158,9 @@ static int pim_mlag_zthread_handler(struct thread *event)
 	if (wr_count == 0)
 		return 0;
 
+	if (wr_count > router->mlag_stats.msg.tx_queue_max)
+		router->mlag_stats.msg.tx_queue_max = wr_count;
+
 	for (wr_count = 0; wr_count < PIM_MLAG_POST_LIMIT; wr_count++) {
 		/* FIFO is empty,wait for teh message to be add */
 		if (stream_fifo_count_safe(router->mlag_fifo) == 0)
@@ -208,6 +212,8 @@ stream_failure:
 	if (wr_count >= PIM_MLAG_POST_LIMIT)
 		pim_mlag_signal_zpthread();
 
+	pim_mlag_up_local_replay_kick();
+
 	return 0;
 }
 
@@ -64,8 +64,7 @@ static void clear_rip_route(struct rip *rip)
 		}
 
 		if (rinfo) {
-			RIP_TIMER_OFF(rinfo->t_timeout);
-			RIP_TIMER_OFF(rinfo->t_garbage_collect);
+			rip_age_off(rip, rinfo, RIP_AGE_ANY);
 			listnode_delete(list, rinfo);
 			rip_info_free(rinfo);
 		}
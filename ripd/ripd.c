@@ -135,17 +135,60 @@ struct rip *rip_info_get_instance(const struct rip_info *rinfo)
 	return route_table_get_info(rinfo->rp->table);
 }
 
-/* RIP route garbage collect timer. */
-static int rip_garbage_collect(struct thread *t)
+static int rip_age_sweep(struct thread *t);
+
+/* Stop the timeout or garbage-collection time of a route, if it is in one of
+ * the given states.
+ */
+void rip_age_off(struct rip *rip, struct rip_info *rinfo, uint8_t state)
 {
-	struct rip_info *rinfo;
-	struct route_node *rp;
+	if (!(rinfo->age_state & state))
+		return;
+
+	rip_age_list_del(&rip->age[rinfo->expire % RIP_AGE_BUCKETS], rinfo);
+	rinfo->age_state = RIP_AGE_NONE;
+	rip->age_count--;
+}
+
+static void rip_age_on(struct rip *rip, struct rip_info *rinfo, uint8_t state,
+		       uint32_t secs)
+{
+	time_t now = monotime(NULL);
+
+	rip_age_off(rip, rinfo, RIP_AGE_ANY);
+
+	rinfo->age_state = state;
+	rinfo->expire = now + secs;
+	rip_age_list_add_tail(&rip->age[rinfo->expire % RIP_AGE_BUCKETS],
+			      rinfo);
+	rip->age_count++;
+
+	if (!rip->t_age) {
+		rip->age_last = now;
+		thread_add_timer(master, rip_age_sweep, rip, 1, &rip->t_age);
+	}
+}
+
+/* A copied rip_info is not on any age list yet. */
+static void rip_age_reset(struct rip_info *rinfo)
+{
+	rinfo->age_state = RIP_AGE_NONE;
+	memset(&rinfo->age_item, 0, sizeof(rinfo->age_item));
+}
+
+/* Start the garbage collection time, unless it is running already. */
+static void rip_garbage_on(struct rip *rip, struct rip_info *rinfo)
+{
+	if (rinfo->age_state == RIP_AGE_GARBAGE)
+		return;
 
-	rinfo = THREAD_ARG(t);
-	rinfo->t_garbage_collect = NULL;
+	rip_age_on(rip, rinfo, RIP_AGE_GARBAGE, rip->garbage_time);
+}
 
-	/* Off timeout timer. */
-	RIP_TIMER_OFF(rinfo->t_timeout);
+/* RIP route garbage collection. */
+static void rip_garbage_collect(struct rip_info *rinfo)
+{
+	struct route_node *rp;
 
 	/* Get route_node pointer. */
 	rp = rinfo->rp;
@@ -159,8 +202,6 @@ static int rip_garbage_collect(struct thread *t)
 
 	/* Free RIP routing information. */
 	rip_info_free(rinfo);
-
-	return 0;
 }
 
 static void rip_timeout_update(struct rip *rip, struct rip_info *rinfo);
@@ -186,6 +227,7 @@ struct rip_info *rip_ecmp_add(struct rip *rip, struct rip_info *rinfo_new)
 
 	rinfo = rip_info_new();
 	memcpy(rinfo, rinfo_new, sizeof(struct rip_info));
+	rip_age_reset(rinfo);
 	listnode_add(list, rinfo);
 
 	if (rip_route_rte(rinfo)) {
@@ -227,15 +269,14 @@ struct rip_info *rip_ecmp_replace(struct rip *rip, struct rip_info *rinfo_new)
 	/* Re-use the first entry, and delete the others. */
 	for (ALL_LIST_ELEMENTS(list, node, nextnode, tmp_rinfo))
 		if (tmp_rinfo != rinfo) {
-			RIP_TIMER_OFF(tmp_rinfo->t_timeout);
-			RIP_TIMER_OFF(tmp_rinfo->t_garbage_collect);
+			rip_age_off(rip, tmp_rinfo, RIP_AGE_ANY);
 			list_delete_node(list, node);
 			rip_info_free(tmp_rinfo);
 		}
 
-	RIP_TIMER_OFF(rinfo->t_timeout);
-	RIP_TIMER_OFF(rinfo->t_garbage_collect);
+	rip_age_off(rip, rinfo, RIP_AGE_ANY);
 	memcpy(rinfo, rinfo_new, sizeof(struct rip_info));
+	rip_age_reset(rinfo);
 
 	if (rip_route_rte(rinfo)) {
 		rip_timeout_update(rip, rinfo);
@@ -263,12 +304,12 @@ struct rip_info *rip_ecmp_delete(struct rip *rip, struct rip_info *rinfo)
 	struct route_node *rp = rinfo->rp;
 	struct list *list = (struct list *)rp->info;
 
-	RIP_TIMER_OFF(rinfo->t_timeout);
+	rip_age_off(rip, rinfo, RIP_AGE_TIMEOUT);
 
 	if (listcount(list) > 1) {
 		/* Some other ECMP entries still exist. Just delete this entry.
 		 */
-		RIP_TIMER_OFF(rinfo->t_garbage_collect);
+		rip_age_off(rip, rinfo, RIP_AGE_GARBAGE);
 		listnode_delete(list, rinfo);
 		if (rip_route_rte(rinfo)
 		    && CHECK_FLAG(rinfo->flags, RIP_RTF_FIB))
@@ -284,8 +325,7 @@ struct rip_info *rip_ecmp_delete(struct rip *rip, struct rip_info *rinfo)
 		 */
 
 		rinfo->metric = RIP_METRIC_INFINITY;
-		RIP_TIMER_ON(rinfo->t_garbage_collect, rip_garbage_collect,
-			     rip->garbage_time);
+		rip_garbage_on(rip, rinfo);
 
 		if (rip_route_rte(rinfo)
 		    && CHECK_FLAG(rinfo->flags, RIP_RTF_FIB))
@@ -302,24 +342,45 @@ struct rip_info *rip_ecmp_delete(struct rip *rip, struct rip_info *rinfo)
 	return rinfo;
 }
 
-/* Timeout RIP routes. */
-static int rip_timeout(struct thread *t)
+/* Timeout RIP routes, and garbage-collect the deleted ones, whose time has
+ * come since the last run.
+ */
+static int rip_age_sweep(struct thread *t)
 {
-	struct rip_info *rinfo = THREAD_ARG(t);
-	struct rip *rip = rip_info_get_instance(rinfo);
+	struct rip *rip = THREAD_ARG(t);
+	struct rip_age_list_head *head;
+	struct rip_info *rinfo;
+	time_t now = monotime(NULL);
+	time_t sec;
+	uint8_t state;
+
+	sec = MAX(rip->age_last + 1, now - RIP_AGE_BUCKETS + 1);
+	for (; sec <= now; sec++) {
+		head = &rip->age[sec % RIP_AGE_BUCKETS];
+		frr_each_safe (rip_age_list, head, rinfo) {
+			if (rinfo->expire > now)
+				continue;
+
+			state = rinfo->age_state;
+			rip_age_off(rip, rinfo, RIP_AGE_ANY);
+			if (state == RIP_AGE_TIMEOUT)
+				rip_ecmp_delete(rip, rinfo);
+			else
+				rip_garbage_collect(rinfo);
+		}
+	}
+	rip->age_last = now;
 
-	rip_ecmp_delete(rip, rinfo);
+	if (rip->age_count)
+		thread_add_timer(master, rip_age_sweep, rip, 1, &rip->t_age);
 
 	return 0;
 }
 
 static void rip_timeout_update(struct rip *rip, struct rip_info *rinfo)
 {
-	if (rinfo->metric != RIP_METRIC_INFINITY) {
-		RIP_TIMER_OFF(rinfo->t_timeout);
-		thread_add_timer(master, rip_timeout, rinfo, rip->timeout_time,
-				 &rinfo->t_timeout);
-	}
+	if (rinfo->metric != RIP_METRIC_INFINITY)
+		rip_age_on(rip, rinfo, RIP_AGE_TIMEOUT, rip->timeout_time);
 }
 
 static int rip_filter(int rip_distribute, struct prefix_ipv4 *p,
@@ -391,6 +452,26 @@ static int rip_filter(int rip_distribute, struct prefix_ipv4 *p,
 	return 0;
 }
 
+/*
+ * Output filtering of a route, reusing the result of the previous
+ * interface of the update if it has the same filters.
+ */
+static int rip_filter_out(struct rip *rip, struct prefix_ipv4 *p,
+			  struct rip_info *rinfo, struct rip_interface *ri)
+{
+	if (!rip->updating)
+		return rip_filter(RIP_FILTER_OUT, p, ri);
+
+	if (rinfo->out_filter_cycle == rip->update_cycle
+	    && rinfo->out_filter_group == ri->out_filter_group)
+		return rinfo->out_filter_ret;
+
+	rinfo->out_filter_ret = rip_filter(RIP_FILTER_OUT, p, ri);
+	rinfo->out_filter_group = ri->out_filter_group;
+	rinfo->out_filter_cycle = rip->update_cycle;
+	return rinfo->out_filter_ret;
+}
+
 /* Check nexthop address validity. */
 static int rip_nexthop_check(struct rip *rip, struct in_addr *addr)
 {
@@ -667,10 +748,10 @@ static void rip_rte_process(struct rte *rte, struct sockaddr_in *from,
 					assert(newinfo.metric
 					       != RIP_METRIC_INFINITY);
 
-					RIP_TIMER_OFF(rinfo->t_timeout);
-					RIP_TIMER_OFF(rinfo->t_garbage_collect);
+					rip_age_off(rip, rinfo, RIP_AGE_ANY);
 					memcpy(rinfo, &newinfo,
 					       sizeof(struct rip_info));
+					rip_age_reset(rinfo);
 					rip_timeout_update(rip, rinfo);
 
 					if (update)
@@ -1619,10 +1700,7 @@ void rip_redistribute_delete(struct rip *rip, int type, int sub_type,
 			    && rinfo->nh.ifindex == ifindex) {
 				/* Perform poisoned reverse. */
 				rinfo->metric = RIP_METRIC_INFINITY;
-				RIP_TIMER_ON(rinfo->t_garbage_collect,
-					     rip_garbage_collect,
-					     rip->garbage_time);
-				RIP_TIMER_OFF(rinfo->t_timeout);
+				rip_garbage_on(rip, rinfo);
 				rinfo->flags |= RIP_RTF_CHANGED;
 
 				if (IS_RIP_DEBUG_EVENT)
@@ -2163,7 +2241,7 @@ void rip_output_process(struct connected *ifc, struct sockaddr_in *to,
 				p = (struct prefix_ipv4 *)&rp->p;
 
 			/* Apply output filters. */
-			ret = rip_filter(RIP_FILTER_OUT, p, ri);
+			ret = rip_filter_out(rip, p, rinfo, ri);
 			if (ret < 0)
 				continue;
 
@@ -2453,6 +2531,48 @@ static void rip_update_interface(struct connected *ifc, uint8_t version,
 }
 
 /* Update send to all interface and neighbor. */
+/* Beyond this many, interfaces get an output filter group of their own */
+#define RIP_OUT_FILTER_GROUP_MAX 64
+
+/*
+ * Group the interfaces by output distribute-list and prefix-list, so
+ * that each route is matched once per update for all of a group.
+ */
+static void rip_update_filter_groups(struct rip *rip)
+{
+	struct {
+		struct access_list *alist;
+		struct prefix_list *plist;
+	} groups[RIP_OUT_FILTER_GROUP_MAX];
+	uint32_t ngroups = 0, unique = RIP_OUT_FILTER_GROUP_MAX;
+	uint32_t i;
+	struct interface *ifp;
+	struct rip_interface *ri;
+
+	if (++rip->update_cycle == 0)
+		rip->update_cycle = 1;
+
+	FOR_ALL_INTERFACES (rip->vrf, ifp) {
+		ri = ifp->info;
+
+		for (i = 0; i < ngroups; i++)
+			if (groups[i].alist == ri->list[RIP_FILTER_OUT]
+			    && groups[i].plist == ri->prefix[RIP_FILTER_OUT])
+				break;
+
+		if (i == ngroups) {
+			if (ngroups == RIP_OUT_FILTER_GROUP_MAX) {
+				ri->out_filter_group = unique++;
+				continue;
+			}
+			groups[i].alist = ri->list[RIP_FILTER_OUT];
+			groups[i].plist = ri->prefix[RIP_FILTER_OUT];
+			ngroups++;
+		}
+		ri->out_filter_group = i;
+	}
+}
+
 static void rip_update_process(struct rip *rip, int route_type)
 {
 	struct listnode *ifnode, *ifnnode;
@@ -2463,6 +2583,9 @@ static void rip_update_process(struct rip *rip, int route_type)
 	struct sockaddr_in to;
 	struct prefix *p;
 
+	rip_update_filter_groups(rip);
+	rip->updating = true;
+
 	/* Send RIP update to each interface. */
 	FOR_ALL_INTERFACES (rip->vrf, ifp) {
 		if (if_is_loopback(ifp))
@@ -2534,6 +2657,8 @@ static void rip_update_process(struct rip *rip, int route_type)
 			rip_output_process(connected, &to, route_type,
 					   rip->version_send);
 		}
+
+	rip->updating = false;
 }
 
 /* RIP's periodical timer. */
@@ -2645,10 +2770,7 @@ void rip_redistribute_withdraw(struct rip *rip, int type)
 			    && rinfo->sub_type != RIP_ROUTE_INTERFACE) {
 				/* Perform poisoned reverse. */
 				rinfo->metric = RIP_METRIC_INFINITY;
-				RIP_TIMER_ON(rinfo->t_garbage_collect,
-					     rip_garbage_collect,
-					     rip->garbage_time);
-				RIP_TIMER_OFF(rinfo->t_timeout);
+				rip_garbage_on(rip, rinfo);
 				rinfo->flags |= RIP_RTF_CHANGED;
 
 				if (IS_RIP_DEBUG_EVENT) {
@@ -2744,6 +2866,9 @@ struct rip *rip_create(const char *vrf_name, struct vrf *vrf, int socket)
 	/* Make output stream. */
 	rip->obuf = stream_new(1500);
 
+	for (int i = 0; i < RIP_AGE_BUCKETS; i++)
+		rip_age_list_init(&rip->age[i]);
+
 	/* Enable the routing instance if possible. */
 	if (vrf && vrf_is_enabled(vrf))
 		rip_instance_enable(rip, vrf, socket);
@@ -2955,9 +3080,8 @@ void rip_ecmp_disable(struct rip *rip)
 			/* Drop all other entries, except the first one. */
 			for (ALL_LIST_ELEMENTS(list, node, nextnode, tmp_rinfo))
 				if (tmp_rinfo != rinfo) {
-					RIP_TIMER_OFF(tmp_rinfo->t_timeout);
-					RIP_TIMER_OFF(
-						tmp_rinfo->t_garbage_collect);
+					rip_age_off(rip, tmp_rinfo,
+						    RIP_AGE_ANY);
 					list_delete_node(list, node);
 					rip_info_free(tmp_rinfo);
 				}
@@ -2980,15 +3104,9 @@ static void rip_vty_out_uptime(struct vty *vty, struct rip_info *rinfo)
 	struct tm tm;
 #define TIME_BUF 25
 	char timebuf[TIME_BUF];
-	struct thread *thread;
 
-	if ((thread = rinfo->t_timeout) != NULL) {
-		clock = thread_timer_remain_second(thread);
-		gmtime_r(&clock, &tm);
-		strftime(timebuf, TIME_BUF, "%M:%S", &tm);
-		vty_out(vty, "%5s", timebuf);
-	} else if ((thread = rinfo->t_garbage_collect) != NULL) {
-		clock = thread_timer_remain_second(thread);
+	if (rinfo->age_state != RIP_AGE_NONE) {
+		clock = MAX(rinfo->expire - monotime(NULL), 0);
 		gmtime_r(&clock, &tm);
 		strftime(timebuf, TIME_BUF, "%M:%S", &tm);
 		vty_out(vty, "%5s", timebuf);
@@ -3409,6 +3527,9 @@ void rip_clean(struct rip *rip)
 	list_delete(&rip->offset_list_master);
 	route_table_finish(rip->distance_table);
 
+	for (int i = 0; i < RIP_AGE_BUCKETS; i++)
+		rip_age_list_fini(&rip->age[i]);
+
 	RB_REMOVE(rip_instance_head, &rip_instances, rip);
 	XFREE(MTYPE_RIP_VRF_NAME, rip->vrf_name);
 	XFREE(MTYPE_RIP, rip);
@@ -3555,8 +3676,7 @@ static void rip_instance_disable(struct rip *rip)
 			rip_zebra_ipv4_delete(rip, rp);
 
 		for (ALL_LIST_ELEMENTS_RO(list, listnode, rinfo)) {
-			RIP_TIMER_OFF(rinfo->t_timeout);
-			RIP_TIMER_OFF(rinfo->t_garbage_collect);
+			rip_age_off(rip, rinfo, RIP_AGE_ANY);
 			rip_info_free(rinfo);
 		}
 		list_delete(&list);
@@ -3571,6 +3691,7 @@ static void rip_instance_disable(struct rip *rip)
 	RIP_TIMER_OFF(rip->t_update);
 	RIP_TIMER_OFF(rip->t_triggered_update);
 	RIP_TIMER_OFF(rip->t_triggered_interval);
+	RIP_TIMER_OFF(rip->t_age);
 
 	/* Cancel read thread. */
 	thread_cancel(&rip->t_read);
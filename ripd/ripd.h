@@ -99,6 +99,13 @@
 
 DECLARE_MGROUP(RIPD);
 
+/* Routes waiting for their timeout or garbage-collection time are kept in
+ * one list per second, indexed by the expiry time modulo the number of
+ * lists, and a single timer per instance walks the lists as time passes.
+ */
+#define RIP_AGE_BUCKETS 256
+PREDECL_DLIST(rip_age_list);
+
 /* RIP structure. */
 struct rip {
 	RB_ENTRY(rip) entry;
@@ -122,6 +129,12 @@ struct rip {
 	/* Output buffer of RIP. */
 	struct stream *obuf;
 
+	/* Update being sent, numbered so that filter results can be reused
+	 * for the interfaces sharing the same filters.
+	 */
+	uint32_t update_cycle;
+	bool updating;
+
 	/* RIP routing information base. */
 	struct route_table *table;
 
@@ -142,6 +155,12 @@ struct rip {
 	struct thread *t_triggered_update;
 	struct thread *t_triggered_interval;
 
+	/* Route timeout and garbage-collection lists. */
+	struct rip_age_list_head age[RIP_AGE_BUCKETS];
+	uint32_t age_count;
+	time_t age_last;
+	struct thread *t_age;
+
 	/* RIP timer values. */
 	uint32_t update_time;
 	uint32_t timeout_time;
@@ -253,9 +272,14 @@ struct rip_info {
 #define RIP_RTF_CHANGED  2
 	uint8_t flags;
 
-	/* Garbage collect timer. */
-	struct thread *t_timeout;
-	struct thread *t_garbage_collect;
+	/* Timeout or garbage-collection time, and the list it is kept on. */
+#define RIP_AGE_NONE     0
+#define RIP_AGE_TIMEOUT  1
+#define RIP_AGE_GARBAGE  2
+#define RIP_AGE_ANY      (RIP_AGE_TIMEOUT | RIP_AGE_GARBAGE)
+	uint8_t age_state;
+	time_t expire;
+	struct rip_age_list_item age_item;
 
 	/* Route-map futures - this variables can be changed. */
 	struct in_addr nexthop_out;
@@ -267,8 +291,15 @@ struct rip_info {
 	struct route_node *rp;
 
 	uint8_t distance;
+
+	/* Output filter result for the last filter group of an update */
+	int8_t out_filter_ret;
+	uint32_t out_filter_group;
+	uint32_t out_filter_cycle;
 };
 
+DECLARE_DLIST(rip_age_list, struct rip_info, age_item);
+
 typedef enum {
 	RIP_NO_SPLIT_HORIZON = 0,
 	RIP_SPLIT_HORIZON,
@@ -323,6 +354,9 @@ struct rip_interface {
 	/* Route-map. */
 	struct route_map *routemap[RIP_FILTER_MAX];
 
+	/* Interfaces with the same output filters share a group */
+	uint32_t out_filter_group;
+
 	/* Wake up thread. */
 	struct thread *t_wakeup;
 
@@ -492,6 +526,8 @@ extern void rip_peer_list_del(void *arg);
 
 extern void rip_info_free(struct rip_info *);
 extern struct rip *rip_info_get_instance(const struct rip_info *rinfo);
+extern void rip_age_off(struct rip *rip, struct rip_info *rinfo,
+			uint8_t state);
 extern struct rip_distance *rip_distance_new(void);
 extern void rip_distance_free(struct rip_distance *rdistance);
 extern uint8_t rip_distance_apply(struct rip *rip, struct rip_info *rinfo);
@@ -66,8 +66,7 @@ static void clear_ripng_route(struct ripng *ripng)
 		}
 
 		if (rinfo) {
-			RIPNG_TIMER_OFF(rinfo->t_timeout);
-			RIPNG_TIMER_OFF(rinfo->t_garbage_collect);
+			ripng_age_off(ripng, rinfo, RIPNG_AGE_ANY);
 			listnode_delete(list, rinfo);
 			ripng_info_free(rinfo);
 		}
@@ -422,17 +422,63 @@ static int ripng_lladdr_check(struct interface *ifp, struct in6_addr *addr)
 	return 0;
 }
 
-/* RIPng route garbage collect timer. */
-static int ripng_garbage_collect(struct thread *t)
+static int ripng_age_sweep(struct thread *t);
+
+/* Stop the timeout or garbage-collection time of a route, if it is in one of
+ * the given states.
+ */
+void ripng_age_off(struct ripng *ripng, struct ripng_info *rinfo,
+		   uint8_t state)
 {
-	struct ripng_info *rinfo;
-	struct agg_node *rp;
+	if (!(rinfo->age_state & state))
+		return;
+
+	ripng_age_list_del(&ripng->age[rinfo->expire % RIPNG_AGE_BUCKETS],
+			   rinfo);
+	rinfo->age_state = RIPNG_AGE_NONE;
+	ripng->age_count--;
+}
+
+static void ripng_age_on(struct ripng *ripng, struct ripng_info *rinfo,
+			 uint8_t state, uint32_t secs)
+{
+	time_t now = monotime(NULL);
+
+	ripng_age_off(ripng, rinfo, RIPNG_AGE_ANY);
 
-	rinfo = THREAD_ARG(t);
-	rinfo->t_garbage_collect = NULL;
+	rinfo->age_state = state;
+	rinfo->expire = now + secs;
+	ripng_age_list_add_tail(&ripng->age[rinfo->expire % RIPNG_AGE_BUCKETS],
+				rinfo);
+	ripng->age_count++;
 
-	/* Off timeout timer. */
-	RIPNG_TIMER_OFF(rinfo->t_timeout);
+	if (!ripng->t_age) {
+		ripng->age_last = now;
+		thread_add_timer(master, ripng_age_sweep, ripng, 1,
+				 &ripng->t_age);
+	}
+}
+
+/* A copied ripng_info is not on any age list yet. */
+static void ripng_age_reset(struct ripng_info *rinfo)
+{
+	rinfo->age_state = RIPNG_AGE_NONE;
+	memset(&rinfo->age_item, 0, sizeof(rinfo->age_item));
+}
+
+/* Start the garbage collection time, unless it is running already. */
+static void ripng_garbage_on(struct ripng *ripng, struct ripng_info *rinfo)
+{
+	if (rinfo->age_state == RIPNG_AGE_GARBAGE)
+		return;
+
+	ripng_age_on(ripng, rinfo, RIPNG_AGE_GARBAGE, ripng->garbage_time);
+}
+
+/* RIPng route garbage collection. */
+static void ripng_garbage_collect(struct ripng_info *rinfo)
+{
+	struct agg_node *rp;
 
 	/* Get route_node pointer. */
 	rp = rinfo->rp;
@@ -446,8 +492,6 @@ static int ripng_garbage_collect(struct thread *t)
 
 	/* Free RIPng routing information. */
 	ripng_info_free(rinfo);
-
-	return 0;
 }
 
 static void ripng_timeout_update(struct ripng *ripng, struct ripng_info *rinfo);
@@ -474,6 +518,7 @@ struct ripng_info *ripng_ecmp_add(struct ripng *ripng,
 
 	rinfo = ripng_info_new();
 	memcpy(rinfo, rinfo_new, sizeof(struct ripng_info));
+	ripng_age_reset(rinfo);
 	listnode_add(list, rinfo);
 
 	if (ripng_route_rte(rinfo)) {
@@ -521,15 +566,14 @@ struct ripng_info *ripng_ecmp_replace(struct ripng *ripng,
 	/* Re-use the first entry, and delete the others. */
 	for (ALL_LIST_ELEMENTS(list, node, nextnode, tmp_rinfo))
 		if (tmp_rinfo != rinfo) {
-			RIPNG_TIMER_OFF(tmp_rinfo->t_timeout);
-			RIPNG_TIMER_OFF(tmp_rinfo->t_garbage_collect);
+			ripng_age_off(ripng, tmp_rinfo, RIPNG_AGE_ANY);
 			list_delete_node(list, node);
 			ripng_info_free(tmp_rinfo);
 		}
 
-	RIPNG_TIMER_OFF(rinfo->t_timeout);
-	RIPNG_TIMER_OFF(rinfo->t_garbage_collect);
+	ripng_age_off(ripng, rinfo, RIPNG_AGE_ANY);
 	memcpy(rinfo, rinfo_new, sizeof(struct ripng_info));
+	ripng_age_reset(rinfo);
 
 	if (ripng_route_rte(rinfo)) {
 		ripng_timeout_update(ripng, rinfo);
@@ -560,7 +604,7 @@ struct ripng_info *ripng_ecmp_delete(struct ripng *ripng,
 	struct agg_node *rp = rinfo->rp;
 	struct list *list = (struct list *)rp->info;
 
-	RIPNG_TIMER_OFF(rinfo->t_timeout);
+	ripng_age_off(ripng, rinfo, RIPNG_AGE_TIMEOUT);
 
 	if (rinfo->metric != RIPNG_METRIC_INFINITY)
 		ripng_aggregate_decrement(rp, rinfo);
@@ -568,7 +612,7 @@ struct ripng_info *ripng_ecmp_delete(struct ripng *ripng,
 	if (listcount(list) > 1) {
 		/* Some other ECMP entries still exist. Just delete this entry.
 		 */
-		RIPNG_TIMER_OFF(rinfo->t_garbage_collect);
+		ripng_age_off(ripng, rinfo, RIPNG_AGE_GARBAGE);
 		listnode_delete(list, rinfo);
 		if (ripng_route_rte(rinfo)
 		    && CHECK_FLAG(rinfo->flags, RIPNG_RTF_FIB))
@@ -584,8 +628,7 @@ struct ripng_info *ripng_ecmp_delete(struct ripng *ripng,
 		 */
 
 		rinfo->metric = RIPNG_METRIC_INFINITY;
-		RIPNG_TIMER_ON(rinfo->t_garbage_collect, ripng_garbage_collect,
-			       ripng->garbage_time);
+		ripng_garbage_on(ripng, rinfo);
 
 		if (ripng_route_rte(rinfo)
 		    && CHECK_FLAG(rinfo->flags, RIPNG_RTF_FIB))
@@ -602,24 +645,47 @@ struct ripng_info *ripng_ecmp_delete(struct ripng *ripng,
 	return rinfo;
 }
 
-/* Timeout RIPng routes. */
-static int ripng_timeout(struct thread *t)
+/* Timeout RIPng routes, and garbage-collect the deleted ones, whose time
+ * has come since the last run.
+ */
+static int ripng_age_sweep(struct thread *t)
 {
-	struct ripng_info *rinfo = THREAD_ARG(t);
-	struct ripng *ripng = ripng_info_get_instance(rinfo);
+	struct ripng *ripng = THREAD_ARG(t);
+	struct ripng_age_list_head *head;
+	struct ripng_info *rinfo;
+	time_t now = monotime(NULL);
+	time_t sec;
+	uint8_t state;
+
+	sec = MAX(ripng->age_last + 1, now - RIPNG_AGE_BUCKETS + 1);
+	for (; sec <= now; sec++) {
+		head = &ripng->age[sec % RIPNG_AGE_BUCKETS];
+		frr_each_safe (ripng_age_list, head, rinfo) {
+			if (rinfo->expire > now)
+				continue;
 
-	ripng_ecmp_delete(ripng, rinfo);
+			state = rinfo->age_state;
+			ripng_age_off(ripng, rinfo, RIPNG_AGE_ANY);
+			if (state == RIPNG_AGE_TIMEOUT)
+				ripng_ecmp_delete(ripng, rinfo);
+			else
+				ripng_garbage_collect(rinfo);
+		}
+	}
+	ripng->age_last = now;
+
+	if (ripng->age_count)
+		thread_add_timer(master, ripng_age_sweep, ripng, 1,
+				 &ripng->t_age);
 
 	return 0;
 }
 
 static void ripng_timeout_update(struct ripng *ripng, struct ripng_info *rinfo)
 {
-	if (rinfo->metric != RIPNG_METRIC_INFINITY) {
-		RIPNG_TIMER_OFF(rinfo->t_timeout);
-		thread_add_timer(master, ripng_timeout, rinfo,
-				 ripng->timeout_time, &rinfo->t_timeout);
-	}
+	if (rinfo->metric != RIPNG_METRIC_INFINITY)
+		ripng_age_on(ripng, rinfo, RIPNG_AGE_TIMEOUT,
+			     ripng->timeout_time);
 }
 
 static int ripng_filter(int ripng_distribute, struct prefix_ipv6 *p,
@@ -898,8 +964,8 @@ static void ripng_route_process(struct rte *rte, struct sockaddr_in6 *from,
 		 * highly recommended".
 		 */
 		if (!ripng->ecmp && !same && rinfo->metric == rte->metric
-		    && rinfo->t_timeout
-		    && (thread_timer_remain_second(rinfo->t_timeout)
+		    && rinfo->age_state == RIPNG_AGE_TIMEOUT
+		    && (rinfo->expire - monotime(NULL)
 			< (ripng->timeout_time / 2))) {
 			ripng_ecmp_replace(ripng, &newinfo);
 		}
@@ -1024,10 +1090,7 @@ void ripng_redistribute_delete(struct ripng *ripng, int type, int sub_type,
 			    && rinfo->ifindex == ifindex) {
 				/* Perform poisoned reverse. */
 				rinfo->metric = RIPNG_METRIC_INFINITY;
-				RIPNG_TIMER_ON(rinfo->t_garbage_collect,
-					       ripng_garbage_collect,
-					       ripng->garbage_time);
-				RIPNG_TIMER_OFF(rinfo->t_timeout);
+				ripng_garbage_on(ripng, rinfo);
 
 				/* Aggregate count decrement. */
 				ripng_aggregate_decrement(rp, rinfo);
@@ -1063,10 +1126,7 @@ void ripng_redistribute_withdraw(struct ripng *ripng, int type)
 			    && (rinfo->sub_type != RIPNG_ROUTE_INTERFACE)) {
 				/* Perform poisoned reverse. */
 				rinfo->metric = RIPNG_METRIC_INFINITY;
-				RIPNG_TIMER_ON(rinfo->t_garbage_collect,
-					       ripng_garbage_collect,
-					       ripng->garbage_time);
-				RIPNG_TIMER_OFF(rinfo->t_timeout);
+				ripng_garbage_on(ripng, rinfo);
 
 				/* Aggregate count decrement. */
 				ripng_aggregate_decrement(rp, rinfo);
@@ -1855,6 +1915,9 @@ struct ripng *ripng_create(const char *vrf_name, struct vrf *vrf, int socket)
 	ripng->ibuf = stream_new(RIPNG_MAX_PACKET_SIZE * 5);
 	ripng->obuf = stream_new(RIPNG_MAX_PACKET_SIZE);
 
+	for (int i = 0; i < RIPNG_AGE_BUCKETS; i++)
+		ripng_age_list_init(&ripng->age[i]);
+
 	/* Initialize RIPng data structures. */
 	ripng->table = agg_table_init();
 	agg_set_table_info(ripng->table, ripng);
@@ -1967,15 +2030,9 @@ static void ripng_vty_out_uptime(struct vty *vty, struct ripng_info *rinfo)
 	struct tm tm;
 #define TIME_BUF 25
 	char timebuf[TIME_BUF];
-	struct thread *thread;
 
-	if ((thread = rinfo->t_timeout) != NULL) {
-		clock = thread_timer_remain_second(thread);
-		gmtime_r(&clock, &tm);
-		strftime(timebuf, TIME_BUF, "%M:%S", &tm);
-		vty_out(vty, "%5s", timebuf);
-	} else if ((thread = rinfo->t_garbage_collect) != NULL) {
-		clock = thread_timer_remain_second(thread);
+	if (rinfo->age_state != RIPNG_AGE_NONE) {
+		clock = MAX(rinfo->expire - monotime(NULL), 0);
 		gmtime_r(&clock, &tm);
 		strftime(timebuf, TIME_BUF, "%M:%S", &tm);
 		vty_out(vty, "%5s", timebuf);
@@ -2230,9 +2287,8 @@ void ripng_ecmp_disable(struct ripng *ripng)
 			/* Drop all other entries, except the first one. */
 			for (ALL_LIST_ELEMENTS(list, node, nextnode, tmp_rinfo))
 				if (tmp_rinfo != rinfo) {
-					RIPNG_TIMER_OFF(tmp_rinfo->t_timeout);
-					RIPNG_TIMER_OFF(
-						tmp_rinfo->t_garbage_collect);
+					ripng_age_off(ripng, tmp_rinfo,
+						      RIPNG_AGE_ANY);
 					list_delete_node(list, node);
 					ripng_info_free(tmp_rinfo);
 				}
@@ -2399,6 +2455,9 @@ void ripng_clean(struct ripng *ripng)
 	vector_free(ripng->passive_interface);
 	list_delete(&ripng->offset_list_master);
 
+	for (int i = 0; i < RIPNG_AGE_BUCKETS; i++)
+		ripng_age_list_fini(&ripng->age[i]);
+
 	RB_REMOVE(ripng_instance_head, &ripng_instances, ripng);
 	XFREE(MTYPE_RIPNG_VRF_NAME, ripng->vrf_name);
 	XFREE(MTYPE_RIPNG, ripng);
@@ -2547,8 +2606,7 @@ static void ripng_instance_disable(struct ripng *ripng)
 				ripng_zebra_ipv6_delete(ripng, rp);
 
 			for (ALL_LIST_ELEMENTS_RO(list, listnode, rinfo)) {
-				RIPNG_TIMER_OFF(rinfo->t_timeout);
-				RIPNG_TIMER_OFF(rinfo->t_garbage_collect);
+				ripng_age_off(ripng, rinfo, RIPNG_AGE_ANY);
 				ripng_info_free(rinfo);
 			}
 			list_delete(&list);
@@ -2570,6 +2628,7 @@ static void ripng_instance_disable(struct ripng *ripng)
 	RIPNG_TIMER_OFF(ripng->t_update);
 	RIPNG_TIMER_OFF(ripng->t_triggered_update);
 	RIPNG_TIMER_OFF(ripng->t_triggered_interval);
+	RIPNG_TIMER_OFF(ripng->t_age);
 
 	/* Cancel the read thread */
 	thread_cancel(&ripng->t_read);
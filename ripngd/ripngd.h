@@ -88,6 +88,13 @@
 
 DECLARE_MGROUP(RIPNGD);
 
+/* Routes waiting for their timeout or garbage-collection time are kept in
+ * one list per second, indexed by the expiry time modulo the number of
+ * lists, and a single timer per instance walks the lists as time passes.
+ */
+#define RIPNG_AGE_BUCKETS 256
+PREDECL_DLIST(ripng_age_list);
+
 /* RIPng structure. */
 struct ripng {
 	RB_ENTRY(ripng) entry;
@@ -147,6 +154,12 @@ struct ripng {
 	struct thread *t_triggered_update;
 	struct thread *t_triggered_interval;
 
+	/* Route timeout and garbage-collection lists. */
+	struct ripng_age_list_head age[RIPNG_AGE_BUCKETS];
+	uint32_t age_count;
+	time_t age_last;
+	struct thread *t_age;
+
 	/* RIPng ECMP flag */
 	bool ecmp;
 
@@ -217,9 +230,14 @@ struct ripng_info {
 #define RIPNG_RTF_CHANGED  2
 	uint8_t flags;
 
-	/* Garbage collect timer. */
-	struct thread *t_timeout;
-	struct thread *t_garbage_collect;
+	/* Timeout or garbage-collection time, and the list it is kept on. */
+#define RIPNG_AGE_NONE     0
+#define RIPNG_AGE_TIMEOUT  1
+#define RIPNG_AGE_GARBAGE  2
+#define RIPNG_AGE_ANY      (RIPNG_AGE_TIMEOUT | RIPNG_AGE_GARBAGE)
+	uint8_t age_state;
+	time_t expire;
+	struct ripng_age_list_item age_item;
 
 	/* Route-map features - this variables can be changed. */
 	struct in6_addr nexthop_out;
@@ -230,6 +248,8 @@ struct ripng_info {
 	struct agg_node *rp;
 };
 
+DECLARE_DLIST(ripng_age_list, struct ripng_info, age_item);
+
 typedef enum {
 	RIPNG_NO_SPLIT_HORIZON = 0,
 	RIPNG_SPLIT_HORIZON,
@@ -396,6 +416,8 @@ extern int ripng_route_rte(struct ripng_info *rinfo);
 extern struct ripng_info *ripng_info_new(void);
 extern void ripng_info_free(struct ripng_info *rinfo);
 extern struct ripng *ripng_info_get_instance(const struct ripng_info *rinfo);
+extern void ripng_age_off(struct ripng *ripng, struct ripng_info *rinfo,
+			  uint8_t state);
 extern void ripng_event(struct ripng *ripng, enum ripng_event event, int sock);
 extern int ripng_request(struct interface *ifp);
 extern void ripng_redistribute_add(struct ripng *ripng, int type, int sub_type,
@@ -0,0 +1,387 @@
+/*
+ * SHARP - route install benchmark
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This file is part of FRR.
+ *
+ * FRR is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * FRR is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#include <zebra.h>
+
+#include "convergence.h"
+#include "json.h"
+#include "log.h"
+#include "memory.h"
+#include "nexthop.h"
+#include "nexthop_group.h"
+#include "vty.h"
+#include "zclient.h"
+
+#include "sharp_bench.h"
+#include "sharp_globals.h"
+#include "sharp_zebra.h"
+
+DEFINE_MTYPE_STATIC(SHARPD, BENCH, "Benchmark batches");
+
+struct sharp_bench_phase {
+	int64_t start, end;
+	uint32_t done, failed;
+
+	/* per batch */
+	int64_t *batch_start;
+	int64_t *batch_usec;
+	uint32_t *batch_left;
+};
+
+static struct sharp_bench {
+	bool running;
+	bool removing;
+	/* zclient_route_*() told us to wait for the buffer to drain */
+	bool blocked;
+
+	struct prefix start;
+	vrf_id_t vrf_id;
+	uint32_t routes, width, groups, batch, nbatches;
+	struct zapi_nexthop nexthops[MULTIPATH_NUM];
+
+	/* routes of the current phase handed to the zclient */
+	uint32_t sent;
+
+	struct sharp_bench_phase install, remove;
+} bench;
+
+static struct sharp_bench_phase *sharp_bench_phase(void)
+{
+	return bench.removing ? &bench.remove : &bench.install;
+}
+
+static void sharp_bench_phase_init(struct sharp_bench_phase *ph)
+{
+	uint32_t i;
+
+	XFREE(MTYPE_BENCH, ph->batch_start);
+	XFREE(MTYPE_BENCH, ph->batch_usec);
+	XFREE(MTYPE_BENCH, ph->batch_left);
+	memset(ph, 0, sizeof(*ph));
+
+	ph->batch_start = XCALLOC(MTYPE_BENCH, bench.nbatches * sizeof(int64_t));
+	ph->batch_usec = XCALLOC(MTYPE_BENCH, bench.nbatches * sizeof(int64_t));
+	ph->batch_left = XCALLOC(MTYPE_BENCH, bench.nbatches * sizeof(uint32_t));
+
+	for (i = 0; i < bench.nbatches; i++)
+		ph->batch_left[i] = MIN(bench.batch,
+					bench.routes - i * bench.batch);
+
+	ph->start = conv_now();
+}
+
+static void sharp_bench_prefix(struct prefix *p, uint32_t idx)
+{
+	*p = bench.start;
+	if (p->family == AF_INET)
+		p->u.prefix4.s_addr = htonl(ntohl(p->u.prefix4.s_addr) + idx);
+	else
+		p->u.val32[3] = htonl(ntohl(p->u.val32[3]) + idx);
+}
+
+static bool sharp_bench_index(const struct prefix *p, uint32_t *idx)
+{
+	if (p->family != bench.start.family
+	    || p->prefixlen != bench.start.prefixlen)
+		return false;
+
+	if (p->family == AF_INET)
+		*idx = ntohl(p->u.prefix4.s_addr)
+		       - ntohl(bench.start.u.prefix4.s_addr);
+	else {
+		if (memcmp(&p->u.prefix6, &bench.start.u.prefix6, 12))
+			return false;
+		*idx = ntohl(p->u.val32[3]) - ntohl(bench.start.u.val32[3]);
+	}
+	return *idx < bench.routes;
+}
+
+static enum zclient_send_status sharp_bench_send_one(uint32_t idx)
+{
+	struct zapi_route api;
+
+	memset(&api, 0, sizeof(api));
+	api.vrf_id = bench.vrf_id;
+	api.type = ZEBRA_ROUTE_SHARP;
+	api.safi = SAFI_UNICAST;
+	sharp_bench_prefix(&api.prefix, idx);
+
+	if (bench.removing)
+		return zclient_route_send(ZEBRA_ROUTE_DELETE, zclient, &api);
+
+	SET_FLAG(api.flags, ZEBRA_FLAG_ALLOW_RECURSION);
+	SET_FLAG(api.message, ZAPI_MESSAGE_NEXTHOP);
+	memcpy(api.nexthops, bench.nexthops,
+	       bench.width * sizeof(api.nexthops[0]));
+	api.nexthop_num = bench.width;
+
+	/* a different weight makes it a different nexthop group for zebra */
+	if (bench.groups > 1) {
+		api.nexthops[0].weight = idx % bench.groups + 1;
+		SET_FLAG(api.nexthops[0].flags, ZAPI_NEXTHOP_FLAG_WEIGHT);
+	}
+
+	return zclient_route_add_bulk(zclient, &api);
+}
+
+static void sharp_bench_send(void)
+{
+	struct sharp_bench_phase *ph = sharp_bench_phase();
+	enum zclient_send_status status;
+	uint32_t idx;
+
+	bench.blocked = false;
+
+	while (bench.sent < bench.routes) {
+		idx = bench.sent++;
+		if (idx % bench.batch == 0)
+			ph->batch_start[idx / bench.batch] = conv_now();
+
+		status = sharp_bench_send_one(idx);
+		if (status == ZCLIENT_SEND_FAILURE) {
+			zlog_warn("Benchmark stopped, cannot send to zebra");
+			bench.running = false;
+			return;
+		}
+		if (status == ZCLIENT_SEND_BUFFERED) {
+			bench.blocked = true;
+			break;
+		}
+	}
+
+	if (!bench.removing)
+		zclient_route_bulk_flush(zclient);
+}
+
+bool sharp_bench_start(const struct prefix *p, vrf_id_t vrf_id,
+		       const struct nexthop_group *nhg, uint32_t routes,
+		       uint32_t width, uint32_t groups, uint32_t batch)
+{
+	struct nexthop *nh;
+	uint32_t i = 0;
+
+	if (bench.running)
+		return false;
+
+	for (ALL_NEXTHOPS_PTR(nhg, nh)) {
+		if (i == width || i == MULTIPATH_NUM)
+			break;
+		zapi_nexthop_from_nexthop(&bench.nexthops[i++], nh);
+	}
+
+	bench.start = *p;
+	bench.vrf_id = vrf_id;
+	bench.routes = routes;
+	bench.width = i;
+	bench.groups = groups;
+	bench.batch = MIN(batch, routes);
+	bench.nbatches = (routes + bench.batch - 1) / bench.batch;
+	bench.running = true;
+	bench.removing = false;
+	bench.sent = 0;
+
+	zlog_debug("Benchmark of %u routes, %u-way ECMP, %u nexthop groups",
+		   routes, bench.width, groups);
+
+	sharp_bench_phase_init(&bench.install);
+	sharp_bench_phase_init(&bench.remove);
+	sharp_bench_send();
+	return true;
+}
+
+void sharp_bench_stop(void)
+{
+	bench.running = false;
+}
+
+bool sharp_bench_resume(void)
+{
+	if (!bench.running || !bench.blocked)
+		return false;
+
+	sharp_bench_send();
+	return true;
+}
+
+static void sharp_bench_phase_done(void)
+{
+	struct sharp_bench_phase *ph = sharp_bench_phase();
+
+	ph->end = conv_now();
+	zlog_debug("Benchmark %s of %u routes done in %" PRId64 "us",
+		   bench.removing ? "removal" : "install", bench.routes,
+		   ph->end - ph->start);
+
+	if (bench.removing) {
+		bench.running = false;
+		return;
+	}
+
+	bench.removing = true;
+	bench.sent = 0;
+	sharp_bench_phase_init(&bench.remove);
+	sharp_bench_send();
+}
+
+bool sharp_bench_notify(const struct prefix *p,
+			enum zapi_route_notify_owner note)
+{
+	struct sharp_bench_phase *ph = sharp_bench_phase();
+	uint32_t idx, b;
+
+	if (!bench.running || !sharp_bench_index(p, &idx))
+		return false;
+
+	switch (note) {
+	case ZAPI_ROUTE_FAIL_INSTALL:
+	case ZAPI_ROUTE_BETTER_ADMIN_WON:
+		if (bench.removing)
+			return true;
+		ph->failed++;
+		break;
+	case ZAPI_ROUTE_INSTALLED:
+		if (bench.removing)
+			return true;
+		break;
+	case ZAPI_ROUTE_REMOVE_FAIL:
+		ph->failed++;
+		/* fallthrough */
+	case ZAPI_ROUTE_REMOVED:
+		if (!bench.removing)
+			return true;
+		break;
+	}
+
+	b = idx / bench.batch;
+	if (!ph->batch_left[b])
+		return true;
+
+	if (--ph->batch_left[b] == 0)
+		ph->batch_usec[b] = conv_now() - ph->batch_start[b];
+
+	if (++ph->done == bench.routes)
+		sharp_bench_phase_done();
+	return true;
+}
+
+static int sharp_bench_cmp(const void *a, const void *b)
+{
+	int64_t va = *(const int64_t *)a, vb = *(const int64_t *)b;
+
+	return va < vb ? -1 : va > vb;
+}
+
+static void sharp_bench_show_phase(struct vty *vty, json_object *json,
+				   const char *name,
+				   struct sharp_bench_phase *ph)
+{
+	static const unsigned int permille[] = {500, 900, 990, 1000};
+	static const char *const pname[] = {"p50", "p90", "p99", "max"};
+	json_object *jphase = NULL, *jbatch = NULL;
+	int64_t *sorted, usec;
+	uint32_t i, n = 0;
+	uint64_t rate;
+
+	if (!ph->start)
+		return;
+
+	usec = (ph->end ? ph->end : conv_now()) - ph->start;
+	rate = usec ? (uint64_t)ph->done * 1000000 / usec : 0;
+
+	sorted = XCALLOC(MTYPE_BENCH, bench.nbatches * sizeof(int64_t));
+	for (i = 0; i < bench.nbatches; i++)
+		if (!ph->batch_left[i])
+			sorted[n++] = ph->batch_usec[i];
+	qsort(sorted, n, sizeof(*sorted), sharp_bench_cmp);
+
+	if (json) {
+		jphase = json_object_new_object();
+		json_object_object_add(json, name, jphase);
+		json_object_boolean_add(jphase, "complete", ph->end != 0);
+		json_object_int_add(jphase, "routes", ph->done);
+		json_object_int_add(jphase, "failed", ph->failed);
+		json_object_int_add(jphase, "usec", usec);
+		json_object_int_add(jphase, "routesPerSec", rate);
+		jbatch = json_object_new_object();
+		json_object_object_add(jphase, "batchUsec", jbatch);
+		json_object_int_add(jbatch, "count", n);
+	} else {
+		vty_out(vty,
+			"%s: %u routes, %u failed, in %" PRId64
+			".%06" PRId64 "s, %" PRIu64 " routes/s%s\n",
+			name, ph->done, ph->failed, usec / 1000000,
+			usec % 1000000, rate, ph->end ? "" : " (running)");
+		vty_out(vty, "  %u batches, latency in usec:", n);
+	}
+
+	for (i = 0; i < array_size(permille); i++) {
+		usec = n ? sorted[((uint64_t)n * permille[i] + 999) / 1000 - 1]
+			 : 0;
+		if (json)
+			json_object_int_add(jbatch, pname[i], usec);
+		else
+			vty_out(vty, " %s %" PRId64, pname[i], usec);
+	}
+	if (!json)
+		vty_out(vty, "\n");
+
+	XFREE(MTYPE_BENCH, sorted);
+}
+
+void sharp_bench_show(struct vty *vty, bool uj)
+{
+	json_object *json = NULL;
+
+	if (uj)
+		json = json_object_new_object();
+
+	if (!bench.routes) {
+		if (json) {
+			vty_out(vty, "%s\n",
+				json_object_to_json_string_ext(
+					json, JSON_C_TO_STRING_PRETTY));
+			json_object_free(json);
+		} else
+			vty_out(vty, "No benchmark has been run\n");
+		return;
+	}
+
+	if (json) {
+		json_object_int_add(json, "routes", bench.routes);
+		json_object_int_add(json, "ecmp", bench.width);
+		json_object_int_add(json, "nexthopGroups", bench.groups);
+		json_object_int_add(json, "batch", bench.batch);
+		json_object_boolean_add(json, "running", bench.running);
+	} else
+		vty_out(vty,
+			"%u routes, %u-way ECMP, %u nexthop groups, batches of %u%s\n",
+			bench.routes, bench.width, bench.groups, bench.batch,
+			bench.running ? ", running" : "");
+
+	sharp_bench_show_phase(vty, json, "install", &bench.install);
+	sharp_bench_show_phase(vty, json, "remove", &bench.remove);
+
+	if (json) {
+		vty_out(vty, "%s\n",
+			json_object_to_json_string_ext(json,
+						       JSON_C_TO_STRING_PRETTY));
+		json_object_free(json);
+	}
+}
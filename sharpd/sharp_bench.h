@@ -0,0 +1,46 @@
+/*
+ * SHARP - route install benchmark
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This file is part of FRR.
+ *
+ * FRR is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * FRR is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#ifndef __SHARP_BENCH_H__
+#define __SHARP_BENCH_H__
+
+/*
+ * Installs routes, in batches, until zebra has acknowledged all of them,
+ * then removes them again, and keeps the time taken by each batch.  The
+ * routes are /32s or /128s counting up from p; they are spread over groups
+ * different nexthop groups made of the first width nexthops of nhg.
+ *
+ * Returns false if a benchmark is running already.
+ */
+extern bool sharp_bench_start(const struct prefix *p, vrf_id_t vrf_id,
+			      const struct nexthop_group *nhg, uint32_t routes,
+			      uint32_t width, uint32_t groups, uint32_t batch);
+extern void sharp_bench_stop(void);
+
+/* The zclient can take more messages; returns true if we were waiting */
+extern bool sharp_bench_resume(void);
+
+/* Returns true if the notification was for one of our routes */
+extern bool sharp_bench_notify(const struct prefix *p,
+			       enum zapi_route_notify_owner note);
+
+extern void sharp_bench_show(struct vty *vty, bool uj);
+
+#endif
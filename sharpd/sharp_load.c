@@ -0,0 +1,735 @@
+/*
+ * SHARP - sustained zapi load generator
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This file is part of FRR.
+ *
+ * FRR is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * FRR is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#include <zebra.h>
+
+#include "convergence.h"
+#include "json.h"
+#include "log.h"
+#include "memory.h"
+#include "network.h"
+#include "nexthop.h"
+#include "nexthop_group.h"
+#include "privs.h"
+#include "thread.h"
+#include "vty.h"
+#include "zclient.h"
+
+#include "sharp_load.h"
+#include "sharp_globals.h"
+
+DEFINE_MTYPE_STATIC(SHARPD, LOAD, "Load generator");
+
+extern struct thread_master *master;
+extern struct zebra_privs_t sharp_privs;
+
+#define SHARP_LOAD_TICK_MSEC 10
+/* don't make up for more than this much time spent waiting on zebra */
+#define SHARP_LOAD_BACKLOG_USEC 1000000
+#define SHARP_LOAD_OPAQUE_MAGIC 0x5348524c
+
+struct sharp_load_client {
+	struct zclient *zclient;
+	bool connected;
+	/* zclient told us to wait for its buffer to drain */
+	bool blocked;
+
+	uint64_t sent, failed, backpressure;
+};
+
+/* Sends rate messages a second from start until stop */
+struct sharp_load_pace {
+	bool running;
+	uint32_t rate, nclients;
+	int64_t start, stop;
+	uint64_t done;
+};
+
+struct sharp_load_routes {
+	struct sharp_load_pace pace;
+	struct prefix start;
+	vrf_id_t vrf_id;
+	uint32_t prefixes, withdraw;
+	uint16_t nexthop_num;
+	struct zapi_nexthop nexthops[MULTIPATH_NUM];
+
+	bool *installed;
+	uint32_t cursor;
+
+	uint64_t adds, updates, withdraws;
+	uint64_t notify_installed, notify_removed, notify_failed;
+};
+
+struct sharp_load_nht {
+	struct sharp_load_pace pace;
+	struct prefix start;
+	vrf_id_t vrf_id;
+	uint32_t count;
+
+	uint32_t cursor;
+	/* all count nexthops are registered, each step re-registers one */
+	bool wrapped;
+
+	uint64_t registers, unregisters, updates;
+};
+
+struct sharp_load_opaque {
+	struct sharp_load_pace pace;
+	uint32_t type;
+
+	uint32_t seq;
+	uint64_t received, unknown;
+};
+
+static const char *const sharp_load_route_stages[] = {"sent", "notified"};
+static const char *const sharp_load_nht_stages[] = {"registered", "updated"};
+static const char *const sharp_load_opaque_stages[] = {"sent", "received"};
+
+static struct sharp_load {
+	struct sharp_load_client clients[SHARP_LOAD_CLIENTS_MAX];
+	uint32_t nclients;
+
+	struct thread *t_tick;
+
+	struct sharp_load_routes routes;
+	struct sharp_load_nht nht;
+	struct sharp_load_opaque opaque;
+
+	struct conv_sampler *conv[SHARP_LOAD_OPAQUE + 1];
+} load;
+
+static void sharp_load_prefix(struct prefix *p, const struct prefix *start,
+			      uint32_t idx)
+{
+	*p = *start;
+	if (p->family == AF_INET)
+		p->u.prefix4.s_addr = htonl(ntohl(p->u.prefix4.s_addr) + idx);
+	else
+		p->u.val32[3] = htonl(ntohl(p->u.val32[3]) + idx);
+}
+
+/* Opaque messages have no prefix, the samples are keyed by a made up one */
+static void sharp_load_opaque_prefix(struct prefix *p, uint32_t seq)
+{
+	memset(p, 0, sizeof(*p));
+	p->family = AF_INET;
+	p->prefixlen = IPV4_MAX_BITLEN;
+	p->u.prefix4.s_addr = htonl(seq);
+}
+
+static struct sharp_load_client *sharp_load_client(struct zclient *zclient)
+{
+	uint32_t i = zclient->instance - SHARP_LOAD_INSTANCE_BASE;
+
+	return i < load.nclients ? &load.clients[i] : NULL;
+}
+
+static bool sharp_load_client_ready(const struct sharp_load_client *c)
+{
+	return c->connected && !c->blocked;
+}
+
+/* Returns false if the message didn't make it to the zclient */
+static bool sharp_load_sent(struct sharp_load_client *c,
+			    enum zclient_send_status status)
+{
+	switch (status) {
+	case ZCLIENT_SEND_FAILURE:
+		c->failed++;
+		return false;
+	case ZCLIENT_SEND_BUFFERED:
+		c->blocked = true;
+		c->backpressure++;
+		break;
+	case ZCLIENT_SEND_SUCCESS:
+		break;
+	}
+
+	c->sent++;
+	return true;
+}
+
+static bool sharp_load_routes_step(void)
+{
+	struct sharp_load_routes *r = &load.routes;
+	struct sharp_load_client *c;
+	enum zclient_send_status status;
+	struct zapi_route api;
+	uint32_t idx = r->cursor;
+	bool withdraw;
+
+	c = &load.clients[idx % r->pace.nclients];
+	if (!sharp_load_client_ready(c))
+		return false;
+
+	memset(&api, 0, sizeof(api));
+	api.vrf_id = r->vrf_id;
+	api.type = ZEBRA_ROUTE_SHARP;
+	api.instance = c->zclient->instance;
+	api.safi = SAFI_UNICAST;
+	sharp_load_prefix(&api.prefix, &r->start, idx);
+
+	withdraw = r->installed[idx]
+		   && frr_weak_random() % 100 < r->withdraw;
+	if (!withdraw) {
+		SET_FLAG(api.flags, ZEBRA_FLAG_ALLOW_RECURSION);
+		SET_FLAG(api.message, ZAPI_MESSAGE_NEXTHOP);
+		memcpy(api.nexthops, r->nexthops,
+		       r->nexthop_num * sizeof(api.nexthops[0]));
+		api.nexthop_num = r->nexthop_num;
+
+		/* a new metric makes every update a change for zebra */
+		SET_FLAG(api.message, ZAPI_MESSAGE_METRIC);
+		api.metric = r->pace.done;
+	}
+
+	conv_start(load.conv[SHARP_LOAD_ROUTES], api.vrf_id, &api.prefix, 0);
+	status = zclient_route_send(withdraw ? ZEBRA_ROUTE_DELETE
+					     : ZEBRA_ROUTE_ADD,
+				    c->zclient, &api);
+
+	if (sharp_load_sent(c, status)) {
+		if (withdraw)
+			r->withdraws++;
+		else if (r->installed[idx])
+			r->updates++;
+		else
+			r->adds++;
+		r->installed[idx] = !withdraw;
+	}
+
+	r->cursor = (idx + 1) % r->prefixes;
+	return true;
+}
+
+static bool sharp_load_nht_step(void)
+{
+	struct sharp_load_nht *n = &load.nht;
+	struct sharp_load_client *c;
+	enum zclient_send_status status;
+	struct prefix p;
+	uint32_t idx = n->cursor;
+
+	c = &load.clients[idx % n->pace.nclients];
+	if (!sharp_load_client_ready(c))
+		return false;
+
+	sharp_load_prefix(&p, &n->start, idx);
+
+	if (n->wrapped) {
+		status = zclient_send_rnh(c->zclient, ZEBRA_NEXTHOP_UNREGISTER,
+					  &p, false, n->vrf_id);
+		if (sharp_load_sent(c, status))
+			n->unregisters++;
+	}
+
+	conv_start(load.conv[SHARP_LOAD_NHT], n->vrf_id, &p, 0);
+	status = zclient_send_rnh(c->zclient, ZEBRA_NEXTHOP_REGISTER, &p, false,
+				  n->vrf_id);
+	if (sharp_load_sent(c, status))
+		n->registers++;
+
+	if (++n->cursor == n->count) {
+		n->cursor = 0;
+		n->wrapped = true;
+	}
+	return true;
+}
+
+static bool sharp_load_opaque_step(void)
+{
+	struct sharp_load_opaque *o = &load.opaque;
+	struct sharp_load_client *c, *dst;
+	enum zclient_send_status status;
+	uint32_t payload[2];
+	struct prefix p;
+
+	c = &load.clients[o->seq % o->pace.nclients];
+	dst = &load.clients[(o->seq + 1) % o->pace.nclients];
+	if (!sharp_load_client_ready(c) || !dst->connected)
+		return false;
+
+	payload[0] = htonl(SHARP_LOAD_OPAQUE_MAGIC);
+	payload[1] = htonl(o->seq);
+
+	sharp_load_opaque_prefix(&p, o->seq);
+	conv_start(load.conv[SHARP_LOAD_OPAQUE], VRF_DEFAULT, &p, 0);
+	status = zclient_send_opaque_unicast(c->zclient, o->type,
+					     ZEBRA_ROUTE_SHARP,
+					     dst->zclient->instance, 0,
+					     (const uint8_t *)payload,
+					     sizeof(payload));
+	sharp_load_sent(c, status);
+
+	o->seq++;
+	return true;
+}
+
+/* Takes as many steps as are due by now, until one has to wait */
+static void sharp_load_run(struct sharp_load_pace *pace, int64_t now,
+			   bool (*step)(void))
+{
+	uint64_t due;
+
+	due = (uint64_t)(now - pace->start) * pace->rate / 1000000;
+	if (due <= pace->done)
+		return;
+
+	if (due - pace->done > (uint64_t)pace->rate * SHARP_LOAD_BACKLOG_USEC
+				       / 1000000)
+		pace->done = due - (uint64_t)pace->rate
+					   * SHARP_LOAD_BACKLOG_USEC / 1000000;
+
+	while (pace->done < due && step())
+		pace->done++;
+}
+
+static int sharp_load_tick(struct thread *t)
+{
+	int64_t now = conv_now();
+
+	if (load.routes.pace.running)
+		sharp_load_run(&load.routes.pace, now, sharp_load_routes_step);
+	if (load.nht.pace.running)
+		sharp_load_run(&load.nht.pace, now, sharp_load_nht_step);
+	if (load.opaque.pace.running)
+		sharp_load_run(&load.opaque.pace, now, sharp_load_opaque_step);
+
+	thread_add_timer_msec(master, sharp_load_tick, NULL,
+			      SHARP_LOAD_TICK_MSEC, &load.t_tick);
+	return 0;
+}
+
+static void sharp_load_zebra_connected(struct zclient *zclient)
+{
+	struct sharp_load_client *c = sharp_load_client(zclient);
+
+	if (!c)
+		return;
+
+	c->connected = true;
+	c->blocked = false;
+
+	if (load.opaque.pace.running)
+		zclient_register_opaque(zclient, load.opaque.type);
+}
+
+static int sharp_load_route_notify(ZAPI_CALLBACK_ARGS)
+{
+	struct sharp_load_routes *r = &load.routes;
+	enum zapi_route_notify_owner note;
+	struct prefix p;
+	uint32_t table;
+
+	if (!zapi_route_notify_decode(zclient->ibuf, &p, &table, &note, NULL,
+				      NULL))
+		return -1;
+
+	switch (note) {
+	case ZAPI_ROUTE_INSTALLED:
+		r->notify_installed++;
+		break;
+	case ZAPI_ROUTE_REMOVED:
+		r->notify_removed++;
+		break;
+	case ZAPI_ROUTE_FAIL_INSTALL:
+	case ZAPI_ROUTE_BETTER_ADMIN_WON:
+	case ZAPI_ROUTE_REMOVE_FAIL:
+		r->notify_failed++;
+		break;
+	}
+
+	conv_stage(load.conv[SHARP_LOAD_ROUTES], vrf_id, &p, 1);
+	return 0;
+}
+
+static int sharp_load_nexthop_update(ZAPI_CALLBACK_ARGS)
+{
+	struct zapi_route nhr;
+
+	if (!zapi_nexthop_update_decode(zclient->ibuf, &nhr))
+		return -1;
+
+	load.nht.updates++;
+	conv_stage(load.conv[SHARP_LOAD_NHT], vrf_id, &nhr.prefix, 1);
+	return 0;
+}
+
+static int sharp_load_opaque_handler(ZAPI_CALLBACK_ARGS)
+{
+	struct stream *s = zclient->ibuf;
+	struct zapi_opaque_msg info;
+	uint32_t magic, seq;
+	struct prefix p;
+
+	if (zclient_opaque_decode(s, &info) != 0)
+		return -1;
+
+	if (info.type != load.opaque.type || info.len < sizeof(uint32_t) * 2)
+		goto unknown;
+
+	STREAM_GETL(s, magic);
+	STREAM_GETL(s, seq);
+	if (magic != SHARP_LOAD_OPAQUE_MAGIC)
+		goto unknown;
+
+	load.opaque.received++;
+	sharp_load_opaque_prefix(&p, seq);
+	conv_stage(load.conv[SHARP_LOAD_OPAQUE], VRF_DEFAULT, &p, 1);
+	return 0;
+
+stream_failure:
+unknown:
+	load.opaque.unknown++;
+	return 0;
+}
+
+/* Doesn't say which zclient, the blocked ones just find out again */
+static void sharp_load_buffer_ready(void)
+{
+	uint32_t i;
+
+	for (i = 0; i < load.nclients; i++)
+		load.clients[i].blocked = false;
+}
+
+static void sharp_load_clients_add(uint32_t nclients)
+{
+	struct zclient_options opt = {.receive_notify = true};
+	struct sharp_load_client *c;
+	uint32_t i;
+
+	for (i = 0; i < nclients; i++) {
+		c = &load.clients[i];
+		if (c->zclient)
+			continue;
+		memset(c, 0, sizeof(*c));
+
+		c->zclient = zclient_new(master, &opt);
+		zclient_init(c->zclient, ZEBRA_ROUTE_SHARP,
+			     SHARP_LOAD_INSTANCE_BASE + i, &sharp_privs);
+		c->zclient->zebra_connected = sharp_load_zebra_connected;
+		c->zclient->route_notify_owner = sharp_load_route_notify;
+		c->zclient->nexthop_update = sharp_load_nexthop_update;
+		c->zclient->opaque_msg_handler = sharp_load_opaque_handler;
+		c->zclient->zebra_buffer_write_ready = sharp_load_buffer_ready;
+	}
+
+	load.nclients = MAX(load.nclients, nclients);
+}
+
+static void sharp_load_pace_start(struct sharp_load_pace *pace,
+				  enum sharp_load_kind kind, uint32_t rate,
+				  uint32_t clients, uint32_t sample)
+{
+	sharp_load_clients_add(clients);
+
+	memset(pace, 0, sizeof(*pace));
+	pace->running = true;
+	pace->rate = rate;
+	pace->nclients = clients;
+	pace->start = conv_now();
+
+	/* starts the latency over */
+	conv_set_rate(load.conv[kind], 0);
+	conv_set_rate(load.conv[kind], sample);
+
+	thread_add_timer_msec(master, sharp_load_tick, NULL,
+			      SHARP_LOAD_TICK_MSEC, &load.t_tick);
+}
+
+bool sharp_load_routes_start(const struct prefix *p, vrf_id_t vrf_id,
+			     const struct nexthop_group *nhg,
+			     uint32_t prefixes, uint32_t withdraw,
+			     uint32_t rate, uint32_t clients, uint32_t sample)
+{
+	struct sharp_load_routes *r = &load.routes;
+	struct nexthop *nh;
+	uint16_t i = 0;
+
+	if (r->pace.running)
+		return false;
+
+	XFREE(MTYPE_LOAD, r->installed);
+	memset(r, 0, sizeof(*r));
+
+	for (ALL_NEXTHOPS_PTR(nhg, nh)) {
+		if (i == MULTIPATH_NUM)
+			break;
+		zapi_nexthop_from_nexthop(&r->nexthops[i++], nh);
+	}
+
+	r->start = *p;
+	r->vrf_id = vrf_id;
+	r->prefixes = prefixes;
+	r->withdraw = withdraw;
+	r->nexthop_num = i;
+	r->installed = XCALLOC(MTYPE_LOAD, prefixes * sizeof(bool));
+
+	zlog_debug("Route load over %u prefixes, %u/s from %u clients",
+		   prefixes, rate, clients);
+
+	sharp_load_pace_start(&r->pace, SHARP_LOAD_ROUTES, rate, clients,
+			      sample);
+	return true;
+}
+
+bool sharp_load_nht_start(const struct prefix *p, vrf_id_t vrf_id,
+			  uint32_t count, uint32_t rate, uint32_t clients,
+			  uint32_t sample)
+{
+	struct sharp_load_nht *n = &load.nht;
+
+	if (n->pace.running)
+		return false;
+
+	memset(n, 0, sizeof(*n));
+	n->start = *p;
+	n->vrf_id = vrf_id;
+	n->count = count;
+
+	zlog_debug("Nexthop tracking load over %u nexthops, %u/s from %u clients",
+		   count, rate, clients);
+
+	sharp_load_pace_start(&n->pace, SHARP_LOAD_NHT, rate, clients, sample);
+	return true;
+}
+
+bool sharp_load_opaque_start(uint32_t type, uint32_t rate, uint32_t clients,
+			     uint32_t sample)
+{
+	struct sharp_load_opaque *o = &load.opaque;
+	uint32_t i;
+
+	if (o->pace.running)
+		return false;
+
+	memset(o, 0, sizeof(*o));
+	o->type = type;
+
+	zlog_debug("Opaque load of type %u, %u/s from %u clients", type, rate,
+		   clients);
+
+	sharp_load_pace_start(&o->pace, SHARP_LOAD_OPAQUE, rate, clients,
+			      sample);
+
+	/* the new ones register when they connect */
+	for (i = 0; i < load.nclients; i++)
+		if (load.clients[i].connected)
+			zclient_register_opaque(load.clients[i].zclient, type);
+	return true;
+}
+
+void sharp_load_stop(void)
+{
+	struct sharp_load_pace *paces[] = {&load.routes.pace, &load.nht.pace,
+					   &load.opaque.pace};
+	int64_t now = conv_now();
+	uint32_t i;
+
+	THREAD_OFF(load.t_tick);
+
+	for (i = 0; i < array_size(paces); i++) {
+		if (!paces[i]->running)
+			continue;
+		paces[i]->running = false;
+		paces[i]->stop = now;
+	}
+
+	for (i = 0; i < load.nclients; i++) {
+		zclient_stop(load.clients[i].zclient);
+		zclient_free(load.clients[i].zclient);
+		load.clients[i].zclient = NULL;
+		load.clients[i].connected = false;
+	}
+	/* the counters of the clients stay around for show */
+
+	XFREE(MTYPE_LOAD, load.routes.installed);
+}
+
+static void sharp_load_show_pace(struct vty *vty, json_object *json,
+				 const char *name,
+				 const struct sharp_load_pace *pace)
+{
+	int64_t usec;
+	uint64_t rate;
+
+	usec = (pace->running ? conv_now() : pace->stop) - pace->start;
+	rate = usec > 0 ? pace->done * 1000000 / usec : 0;
+
+	if (json) {
+		json_object_boolean_add(json, "running", pace->running);
+		json_object_int_add(json, "rate", pace->rate);
+		json_object_int_add(json, "clients", pace->nclients);
+		json_object_int_add(json, "usec", usec);
+		json_object_int_add(json, "sent", pace->done);
+		json_object_int_add(json, "sentPerSec", rate);
+	} else
+		vty_out(vty,
+			"%s: %" PRIu64 " sent in %" PRId64 ".%06" PRId64
+			"s, %" PRIu64 "/s of %u/s from %u clients%s\n",
+			name, pace->done, usec / 1000000, usec % 1000000, rate,
+			pace->rate, pace->nclients,
+			pace->running ? " (running)" : "");
+}
+
+void sharp_load_show(struct vty *vty, bool uj)
+{
+	struct sharp_load_routes *r = &load.routes;
+	struct sharp_load_nht *n = &load.nht;
+	struct sharp_load_opaque *o = &load.opaque;
+	json_object *json = NULL, *jobj, *jclients;
+	struct sharp_load_client *c;
+	uint32_t i;
+
+	if (uj)
+		json = json_object_new_object();
+
+	if (r->pace.start) {
+		jobj = NULL;
+		if (json) {
+			jobj = json_object_new_object();
+			json_object_object_add(json, "routes", jobj);
+		}
+		sharp_load_show_pace(vty, jobj, "Routes", &r->pace);
+		if (json) {
+			json_object_int_add(jobj, "prefixes", r->prefixes);
+			json_object_int_add(jobj, "withdrawPercent",
+					    r->withdraw);
+			json_object_int_add(jobj, "adds", r->adds);
+			json_object_int_add(jobj, "updates", r->updates);
+			json_object_int_add(jobj, "withdraws", r->withdraws);
+			json_object_int_add(jobj, "installed",
+					    r->notify_installed);
+			json_object_int_add(jobj, "removed", r->notify_removed);
+			json_object_int_add(jobj, "failed", r->notify_failed);
+		} else {
+			vty_out(vty,
+				"  %u prefixes from %pFX, %u%% withdraws\n",
+				r->prefixes, &r->start, r->withdraw);
+			vty_out(vty,
+				"  %" PRIu64 " adds, %" PRIu64
+				" updates, %" PRIu64 " withdraws\n",
+				r->adds, r->updates, r->withdraws);
+			vty_out(vty,
+				"  notified %" PRIu64 " installed, %" PRIu64
+				" removed, %" PRIu64 " failed\n",
+				r->notify_installed, r->notify_removed,
+				r->notify_failed);
+		}
+	}
+
+	if (n->pace.start) {
+		jobj = NULL;
+		if (json) {
+			jobj = json_object_new_object();
+			json_object_object_add(json, "nht", jobj);
+		}
+		sharp_load_show_pace(vty, jobj, "Nexthop tracking", &n->pace);
+		if (json) {
+			json_object_int_add(jobj, "nexthops", n->count);
+			json_object_int_add(jobj, "registers", n->registers);
+			json_object_int_add(jobj, "unregisters",
+					    n->unregisters);
+			json_object_int_add(jobj, "updates", n->updates);
+		} else
+			vty_out(vty,
+				"  %u nexthops from %pFX, %" PRIu64
+				" registers, %" PRIu64 " unregisters, %" PRIu64
+				" updates\n",
+				n->count, &n->start, n->registers,
+				n->unregisters, n->updates);
+	}
+
+	if (o->pace.start) {
+		jobj = NULL;
+		if (json) {
+			jobj = json_object_new_object();
+			json_object_object_add(json, "opaque", jobj);
+		}
+		sharp_load_show_pace(vty, jobj, "Opaque", &o->pace);
+		if (json) {
+			json_object_int_add(jobj, "type", o->type);
+			json_object_int_add(jobj, "received", o->received);
+			json_object_int_add(jobj, "unknown", o->unknown);
+		} else
+			vty_out(vty,
+				"  type %u, %" PRIu64 " received, %" PRIu64
+				" unknown\n",
+				o->type, o->received, o->unknown);
+	}
+
+	if (json) {
+		jclients = json_object_new_array();
+		json_object_object_add(json, "clients", jclients);
+	} else if (load.nclients)
+		vty_out(vty, "%-8s %-9s %12s %8s %12s\n", "Instance",
+			"Connected", "Sent", "Failed", "Backpressure");
+	else if (!r->pace.start && !n->pace.start && !o->pace.start)
+		vty_out(vty, "No load has been generated\n");
+
+	for (i = 0; i < load.nclients; i++) {
+		c = &load.clients[i];
+		if (json) {
+			jobj = json_object_new_object();
+			json_object_array_add(jclients, jobj);
+			json_object_int_add(jobj, "instance",
+					    SHARP_LOAD_INSTANCE_BASE + i);
+			json_object_boolean_add(jobj, "connected",
+						c->connected);
+			json_object_int_add(jobj, "sent", c->sent);
+			json_object_int_add(jobj, "failed", c->failed);
+			json_object_int_add(jobj, "backpressure",
+					    c->backpressure);
+		} else
+			vty_out(vty,
+				"%-8u %-9s %12" PRIu64 " %8" PRIu64
+				" %12" PRIu64 "\n",
+				SHARP_LOAD_INSTANCE_BASE + i,
+				c->connected ? "yes" : "no", c->sent,
+				c->failed, c->backpressure);
+	}
+
+	if (json) {
+		vty_out(vty, "%s\n",
+			json_object_to_json_string_ext(json,
+						       JSON_C_TO_STRING_PRETTY));
+		json_object_free(json);
+	}
+}
+
+void sharp_load_show_latency(struct vty *vty, enum sharp_load_kind kind,
+			     bool uj)
+{
+	conv_show(vty, load.conv[kind], uj);
+}
+
+void sharp_load_init(void)
+{
+	load.conv[SHARP_LOAD_ROUTES] = conv_sampler_new(
+		"sharp-load-routes", sharp_load_route_stages,
+		array_size(sharp_load_route_stages));
+	load.conv[SHARP_LOAD_NHT] = conv_sampler_new(
+		"sharp-load-nht", sharp_load_nht_stages,
+		array_size(sharp_load_nht_stages));
+	load.conv[SHARP_LOAD_OPAQUE] = conv_sampler_new(
+		"sharp-load-opaque", sharp_load_opaque_stages,
+		array_size(sharp_load_opaque_stages));
+}
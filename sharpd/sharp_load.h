@@ -0,0 +1,77 @@
+/*
+ * SHARP - sustained zapi load generator
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This file is part of FRR.
+ *
+ * FRR is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the
+ * Free Software Foundation; either version 2, or (at your option) any
+ * later version.
+ *
+ * FRR is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#ifndef __SHARP_LOAD_H__
+#define __SHARP_LOAD_H__
+
+/*
+ * Keeps zebra busy at a steady rate until stopped, from up to
+ * SHARP_LOAD_CLIENTS_MAX zapi clients of their own.  Each one is a sharp
+ * instance of its own (from SHARP_LOAD_INSTANCE_BASE up), so zebra handles
+ * them as separate daemons and sends each the notifications for its routes.
+ *
+ * - routes: churns prefixes /32s or /128s counting up from p.  Each step
+ *   adds the next prefix if it isn't installed, otherwise withdraws it with
+ *   a probability of withdraw percent, or updates its metric.
+ * - nht: registers count nexthops counting up from p, then keeps
+ *   registering them again, rate times a second overall.
+ * - opaque: each client sends opaque messages of the type to the next one.
+ *
+ * The time from sending each message to zebra's answer (the route owner
+ * notification, the first nexthop update, the opaque message arriving) is
+ * kept by a convergence sampler for each kind of load, which samples 1 in
+ * sample of them.
+ *
+ * The start functions return false if that kind of load is running already.
+ */
+
+#define SHARP_LOAD_CLIENTS_MAX 16
+#define SHARP_LOAD_INSTANCE_BASE 256
+
+enum sharp_load_kind {
+	SHARP_LOAD_ROUTES,
+	SHARP_LOAD_NHT,
+	SHARP_LOAD_OPAQUE,
+};
+
+extern bool sharp_load_routes_start(const struct prefix *p, vrf_id_t vrf_id,
+				    const struct nexthop_group *nhg,
+				    uint32_t prefixes, uint32_t withdraw,
+				    uint32_t rate, uint32_t clients,
+				    uint32_t sample);
+extern bool sharp_load_nht_start(const struct prefix *p, vrf_id_t vrf_id,
+				 uint32_t count, uint32_t rate,
+				 uint32_t clients, uint32_t sample);
+extern bool sharp_load_opaque_start(uint32_t type, uint32_t rate,
+				    uint32_t clients, uint32_t sample);
+
+/*
+ * Stops all of it and disconnects the clients, zebra then removes their
+ * routes and nexthop registrations itself.
+ */
+extern void sharp_load_stop(void);
+
+extern void sharp_load_show(struct vty *vty, bool uj);
+extern void sharp_load_show_latency(struct vty *vty,
+				    enum sharp_load_kind kind, bool uj);
+
+extern void sharp_load_init(void);
+
+#endif
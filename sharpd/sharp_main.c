@@ -49,6 +49,7 @@
 #include "sharp_vty.h"
 #include "sharp_globals.h"
 #include "sharp_nht.h"
+#include "sharp_load.h"
 
 DEFINE_MGROUP(SHARPD, "sharpd");
 
@@ -185,6 +186,7 @@ int main(int argc, char **argv, char **envp)
 	vrf_init(NULL, NULL, NULL, NULL, NULL);
 
 	sharp_zebra_init();
+	sharp_load_init();
 
 	/* Get configuration file. */
 	sharp_vty_init();
@@ -31,6 +31,8 @@
 #include "nexthop_group.h"
 #include "link_state.h"
 
+#include "sharpd/sharp_bench.h"
+#include "sharpd/sharp_load.h"
 #include "sharpd/sharp_globals.h"
 #include "sharpd/sharp_zebra.h"
 #include "sharpd/sharp_nht.h"
@@ -1156,6 +1158,293 @@ DEFPY (show_sharp_segment_routing_srv6,
 	return CMD_SUCCESS;
 }
 
+DEFPY (sharp_benchmark_routes,
+       sharp_benchmark_routes_cmd,
+       "sharp benchmark routes [vrf NAME$vrf_name]\
+	  <A.B.C.D$start4|X:X::X:X$start6>\
+	  nexthop-group NHGNAME$nexthop_group\
+	  (1-10000000)$routes [ecmp (1-256)$width]\
+	  [shared-nhgs (1-4096)$groups] [batch (1-1000000)$batch_size]",
+       "Sharp routing Protocol\n"
+       "Time route installation and removal\n"
+       "Routes to install\n"
+       "The vrf we would like to install into if non-default\n"
+       "The NAME of the vrf\n"
+       "v4 Address to start /32 generation at\n"
+       "v6 Address to start /128 generation at\n"
+       "Nexthop-Group to use\n"
+       "The Name of the nexthop-group\n"
+       "How many to create\n"
+       "Use only the first nexthops of the group\n"
+       "How many nexthops\n"
+       "Spread the routes over several nexthop groups\n"
+       "How many nexthop groups\n"
+       "Count the time taken for groups of routes\n"
+       "Routes in a group (default 10000)\n")
+{
+	struct nexthop_group_cmd *nhgc;
+	struct prefix prefix;
+	struct vrf *vrf;
+
+	memset(&prefix, 0, sizeof(prefix));
+	if (start4.s_addr != INADDR_ANY) {
+		prefix.family = AF_INET;
+		prefix.prefixlen = IPV4_MAX_BITLEN;
+		prefix.u.prefix4 = start4;
+	} else {
+		prefix.family = AF_INET6;
+		prefix.prefixlen = IPV6_MAX_BITLEN;
+		prefix.u.prefix6 = start6;
+	}
+
+	if (!vrf_name)
+		vrf_name = VRF_DEFAULT_NAME;
+
+	vrf = vrf_lookup_by_name(vrf_name);
+	if (!vrf) {
+		vty_out(vty, "The vrf NAME specified: %s does not exist\n",
+			vrf_name);
+		return CMD_WARNING;
+	}
+
+	nhgc = nhgc_find(nexthop_group);
+	if (!nhgc || !nhgc->nhg.nexthop) {
+		vty_out(vty, "Specified Nexthop Group: %s does not exist\n",
+			nexthop_group);
+		return CMD_WARNING;
+	}
+
+	if (!sharp_bench_start(&prefix, vrf->vrf_id, &nhgc->nhg, routes,
+			       width ? width : MULTIPATH_NUM,
+			       groups ? groups : 1,
+			       batch_size ? batch_size : 10000)) {
+		vty_out(vty, "%% A benchmark is running already\n");
+		return CMD_WARNING;
+	}
+
+	return CMD_SUCCESS;
+}
+
+DEFPY (sharp_benchmark_stop,
+       sharp_benchmark_stop_cmd,
+       "sharp benchmark stop",
+       "Sharp routing Protocol\n"
+       "Time route installation and removal\n"
+       "Stop waiting for the routes of the benchmark\n")
+{
+	sharp_bench_stop();
+	return CMD_SUCCESS;
+}
+
+DEFPY (show_sharp_benchmark,
+       show_sharp_benchmark_cmd,
+       "show sharp benchmark [json]",
+       SHOW_STR
+       SHARP_STR
+       "Results of the last benchmark\n"
+       JSON_STR)
+{
+	sharp_bench_show(vty, use_json(argc, argv));
+	return CMD_SUCCESS;
+}
+
+DEFPY (load_routes,
+       load_routes_cmd,
+       "sharp load routes [vrf NAME$vrf_name]\
+	  <A.B.C.D$start4|X:X::X:X$start6>\
+	  nexthop-group NHGNAME$nexthop_group\
+	  prefixes (1-1000000)$prefixes rate (1-1000000)$rate\
+	  [withdraw (0-100)$withdraw] [clients (1-16)$clients]\
+	  [sample (1-65535)$sample]",
+       "Sharp routing Protocol\n"
+       "Keep zebra busy at a steady rate\n"
+       "Add, update and withdraw routes\n"
+       "The vrf we would like to install into if non-default\n"
+       "The NAME of the vrf\n"
+       "v4 Address to start /32 generation at\n"
+       "v6 Address to start /128 generation at\n"
+       "Nexthop-Group to use\n"
+       "The Name of the nexthop-group\n"
+       "Prefixes to go over\n"
+       "How many prefixes\n"
+       "Routes to send each second\n"
+       "How many routes\n"
+       "Withdraw installed prefixes instead of updating them\n"
+       "Percentage of them (default 0)\n"
+       "Send from several zapi clients\n"
+       "How many clients (default 1)\n"
+       "Time from sending to the owner notification\n"
+       "Measure 1 route in (default 1)\n")
+{
+	struct nexthop_group_cmd *nhgc;
+	struct prefix prefix;
+	struct vrf *vrf;
+
+	memset(&prefix, 0, sizeof(prefix));
+	if (start4.s_addr != INADDR_ANY) {
+		prefix.family = AF_INET;
+		prefix.prefixlen = IPV4_MAX_BITLEN;
+		prefix.u.prefix4 = start4;
+	} else {
+		prefix.family = AF_INET6;
+		prefix.prefixlen = IPV6_MAX_BITLEN;
+		prefix.u.prefix6 = start6;
+	}
+
+	if (!vrf_name)
+		vrf_name = VRF_DEFAULT_NAME;
+
+	vrf = vrf_lookup_by_name(vrf_name);
+	if (!vrf) {
+		vty_out(vty, "The vrf NAME specified: %s does not exist\n",
+			vrf_name);
+		return CMD_WARNING;
+	}
+
+	nhgc = nhgc_find(nexthop_group);
+	if (!nhgc || !nhgc->nhg.nexthop) {
+		vty_out(vty, "Specified Nexthop Group: %s does not exist\n",
+			nexthop_group);
+		return CMD_WARNING;
+	}
+
+	if (!sharp_load_routes_start(&prefix, vrf->vrf_id, &nhgc->nhg,
+				     prefixes, withdraw_str ? withdraw : 0,
+				     rate, clients ? clients : 1,
+				     sample ? sample : 1)) {
+		vty_out(vty, "%% A route load is running already\n");
+		return CMD_WARNING;
+	}
+
+	return CMD_SUCCESS;
+}
+
+DEFPY (load_nht,
+       load_nht_cmd,
+       "sharp load nht [vrf NAME$vrf_name]\
+	  <A.B.C.D$start4|X:X::X:X$start6>\
+	  count (1-1000000)$count rate (1-1000000)$rate\
+	  [clients (1-16)$clients] [sample (1-65535)$sample]",
+       "Sharp routing Protocol\n"
+       "Keep zebra busy at a steady rate\n"
+       "Register nexthops for tracking, over and over\n"
+       "The vrf the nexthops are in if non-default\n"
+       "The NAME of the vrf\n"
+       "v4 Address of the first nexthop\n"
+       "v6 Address of the first nexthop\n"
+       "Nexthops to go over\n"
+       "How many nexthops\n"
+       "Registrations to send each second\n"
+       "How many registrations\n"
+       "Send from several zapi clients\n"
+       "How many clients (default 1)\n"
+       "Time from registering to the nexthop update\n"
+       "Measure 1 registration in (default 1)\n")
+{
+	struct prefix prefix;
+	struct vrf *vrf;
+
+	memset(&prefix, 0, sizeof(prefix));
+	if (start4.s_addr != INADDR_ANY) {
+		prefix.family = AF_INET;
+		prefix.prefixlen = IPV4_MAX_BITLEN;
+		prefix.u.prefix4 = start4;
+	} else {
+		prefix.family = AF_INET6;
+		prefix.prefixlen = IPV6_MAX_BITLEN;
+		prefix.u.prefix6 = start6;
+	}
+
+	if (!vrf_name)
+		vrf_name = VRF_DEFAULT_NAME;
+
+	vrf = vrf_lookup_by_name(vrf_name);
+	if (!vrf) {
+		vty_out(vty, "The vrf NAME specified: %s does not exist\n",
+			vrf_name);
+		return CMD_WARNING;
+	}
+
+	if (!sharp_load_nht_start(&prefix, vrf->vrf_id, count, rate,
+				  clients ? clients : 1, sample ? sample : 1)) {
+		vty_out(vty, "%% A nexthop tracking load is running already\n");
+		return CMD_WARNING;
+	}
+
+	return CMD_SUCCESS;
+}
+
+DEFPY (load_opaque,
+       load_opaque_cmd,
+       "sharp load opaque type (1-255)$type rate (1-1000000)$rate\
+	  [clients (1-16)$clients] [sample (1-65535)$sample]",
+       "Sharp routing Protocol\n"
+       "Keep zebra busy at a steady rate\n"
+       "Send opaque messages from each client to the next\n"
+       "Opaque sub-type code\n"
+       "Opaque sub-type code\n"
+       "Messages to send each second\n"
+       "How many messages\n"
+       "Send from several zapi clients\n"
+       "How many clients (default 2)\n"
+       "Time from sending to the message arriving\n"
+       "Measure 1 message in (default 1)\n")
+{
+	if (!sharp_load_opaque_start(type, rate, clients ? clients : 2,
+				     sample ? sample : 1)) {
+		vty_out(vty, "%% An opaque load is running already\n");
+		return CMD_WARNING;
+	}
+
+	return CMD_SUCCESS;
+}
+
+DEFPY (load_stop,
+       load_stop_cmd,
+       "sharp load stop",
+       "Sharp routing Protocol\n"
+       "Keep zebra busy at a steady rate\n"
+       "Stop all of it and disconnect the clients\n")
+{
+	sharp_load_stop();
+	return CMD_SUCCESS;
+}
+
+DEFPY (show_sharp_load,
+       show_sharp_load_cmd,
+       "show sharp load [json]",
+       SHOW_STR
+       SHARP_STR
+       "What the load generator sent\n"
+       JSON_STR)
+{
+	sharp_load_show(vty, use_json(argc, argv));
+	return CMD_SUCCESS;
+}
+
+DEFPY (show_sharp_load_latency,
+       show_sharp_load_latency_cmd,
+       "show sharp load latency <routes$routes|nht$nht|opaque> [json]",
+       SHOW_STR
+       SHARP_STR
+       "What the load generator sent\n"
+       "How long zebra took to answer\n"
+       "Route owner notifications\n"
+       "Nexthop updates\n"
+       "Opaque messages\n"
+       JSON_STR)
+{
+	enum sharp_load_kind kind = SHARP_LOAD_OPAQUE;
+
+	if (routes)
+		kind = SHARP_LOAD_ROUTES;
+	else if (nht)
+		kind = SHARP_LOAD_NHT;
+
+	sharp_load_show_latency(vty, kind, use_json(argc, argv));
+	return CMD_SUCCESS;
+}
+
 void sharp_vty_init(void)
 {
 	install_element(ENABLE_NODE, &install_routes_data_dump_cmd);
@@ -1163,6 +1452,12 @@ void sharp_vty_init(void)
 	install_element(ENABLE_NODE, &install_seg6_routes_cmd);
 	install_element(ENABLE_NODE, &install_seg6local_routes_cmd);
 	install_element(ENABLE_NODE, &remove_routes_cmd);
+	install_element(ENABLE_NODE, &sharp_benchmark_routes_cmd);
+	install_element(ENABLE_NODE, &sharp_benchmark_stop_cmd);
+	install_element(ENABLE_NODE, &load_routes_cmd);
+	install_element(ENABLE_NODE, &load_nht_cmd);
+	install_element(ENABLE_NODE, &load_opaque_cmd);
+	install_element(ENABLE_NODE, &load_stop_cmd);
 	install_element(ENABLE_NODE, &vrf_label_cmd);
 	install_element(ENABLE_NODE, &sharp_nht_data_dump_cmd);
 	install_element(ENABLE_NODE, &watch_redistribute_cmd);
@@ -1186,6 +1481,9 @@ void sharp_vty_init(void)
 	install_element(ENABLE_NODE,
 			&sharp_srv6_manager_release_locator_chunk_cmd);
 	install_element(ENABLE_NODE, &show_sharp_segment_routing_srv6_cmd);
+	install_element(ENABLE_NODE, &show_sharp_benchmark_cmd);
+	install_element(ENABLE_NODE, &show_sharp_load_cmd);
+	install_element(ENABLE_NODE, &show_sharp_load_latency_cmd);
 
 	return;
 }
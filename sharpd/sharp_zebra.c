@@ -32,6 +32,7 @@
 #include "nexthop_group.h"
 #include "link_state.h"
 
+#include "sharp_bench.h"
 #include "sharp_globals.h"
 #include "sharp_nht.h"
 #include "sharp_zebra.h"
@@ -238,9 +239,9 @@ struct buffer_delay {
 } wb;
 
 /*
- * route_add - Encodes a route to zebra
+ * route_add - Encodes a route to zebra, in a bulk route add message
  *
- * This function returns true when the route was buffered
+ * This function returns true when a message was buffered
  * by the underlying stream system
  */
 static bool route_add(const struct prefix *p, vrf_id_t vrf_id, uint8_t instance,
@@ -302,8 +303,7 @@ static bool route_add(const struct prefix *p, vrf_id_t vrf_id, uint8_t instance,
 		memcpy(api.opaque.data, opaque, api.opaque.length);
 	}
 
-	if (zclient_route_send(ZEBRA_ROUTE_ADD, zclient, &api)
-	    == ZCLIENT_SEND_BUFFERED)
+	if (zclient_route_add_bulk(zclient, &api) == ZCLIENT_SEND_BUFFERED)
 		return true;
 	else
 		return false;
@@ -371,9 +371,12 @@ static void sharp_install_routes_restart(struct prefix *p, uint32_t count,
 			wb.opaque = opaque;
 			wb.restart = SHARP_INSTALL_ROUTES_RESTART;
 
+			zclient_route_bulk_flush(zclient);
 			return;
 		}
 	}
+
+	zclient_route_bulk_flush(zclient);
 }
 
 void sharp_install_routes_helper(struct prefix *p, vrf_id_t vrf_id,
@@ -463,6 +466,9 @@ static void handle_repeated(bool installed)
 
 static void sharp_zclient_buffer_ready(void)
 {
+	if (sharp_bench_resume())
+		return;
+
 	switch (wb.restart) {
 	case SHARP_INSTALL_ROUTES_RESTART:
 		sharp_install_routes_restart(
@@ -488,6 +494,9 @@ static int route_notify_owner(ZAPI_CALLBACK_ARGS)
 				      NULL, NULL))
 		return -1;
 
+	if (sharp_bench_notify(&p, note))
+		return 0;
+
 	switch (note) {
 	case ZAPI_ROUTE_INSTALLED:
 		sg.r.installed_routes++;
@@ -971,7 +980,8 @@ static void sharp_zebra_process_srv6_locator_chunk(ZAPI_CALLBACK_ARGS)
 
 void sharp_zebra_init(void)
 {
-	struct zclient_options opt = {.receive_notify = true};
+	struct zclient_options opt = {.receive_notify = true,
+				      .shm_ring = true};
 
 	if_zapi_callbacks(sharp_ifp_create, sharp_ifp_up,
 			  sharp_ifp_down, sharp_ifp_destroy);
@@ -22,6 +22,8 @@
 #ifndef __SHARP_ZEBRA_H__
 #define __SHARP_ZEBRA_H__
 
+extern struct zclient *zclient;
+
 extern void sharp_zebra_init(void);
 
 /* Add and delete extra zapi client sessions, for testing */
@@ -61,6 +61,7 @@ void zebra_stable_node_cleanup(struct route_table *table,
 				XFREE(MTYPE_STATIC_NEXTHOP, nh);
 			}
 			static_path_list_del(&si->path_list, pn);
+			static_zebra_route_pending_del(pn, false);
 			XFREE(MTYPE_STATIC_PATH, pn);
 		}
 
@@ -86,6 +87,8 @@ void zebra_stable_node_cleanup(struct route_table *table,
 					}
 					static_path_list_del(&src_si->path_list,
 							     src_pn);
+					static_zebra_route_pending_del(src_pn,
+								       false);
 					XFREE(MTYPE_STATIC_PATH, src_pn);
 				}
 
@@ -252,6 +255,7 @@ void static_del_path(struct route_node *rn, struct static_path *pn, safi_t safi,
 		static_delete_nexthop(rn, pn, safi, svrf, nh);
 	}
 
+	static_zebra_route_pending_del(pn, true);
 	route_unlock_node(rn);
 
 	XFREE(MTYPE_STATIC_PATH, pn);
@@ -78,6 +78,7 @@ enum static_install_states {
 
 PREDECL_DLIST(static_path_list);
 PREDECL_DLIST(static_nexthop_list);
+PREDECL_DLIST(static_route_pending);
 
 /* Static route information */
 struct static_route_info {
@@ -97,9 +98,17 @@ struct static_path {
 	uint32_t table_id;
 	/* Nexthop list */
 	struct static_nexthop_list_head nexthop_list;
+
+	/* Route message waiting to be sent to zebra */
+	struct static_route_pending_item pending;
+	struct route_node *pending_rn;
+	safi_t pending_safi;
+	bool pending_install;
+	bool is_pending;
 };
 
 DECLARE_DLIST(static_path_list, struct static_path, list);
+DECLARE_DLIST(static_route_pending, struct static_path, pending);
 
 /* Static route information. */
 struct static_nexthop {
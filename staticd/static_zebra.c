@@ -48,6 +48,15 @@
 struct zclient *zclient;
 static struct hash *static_nht_hash;
 
+/*
+ * Paths whose route must be sent to zebra once the current event, usually
+ * a northbound commit, is done: a path changed several times, one nexthop
+ * at a time say, is sent only once, with its final nexthops.
+ */
+static struct static_route_pending_head static_route_pending =
+	INIT_DLIST(static_route_pending);
+static struct thread *t_static_route_pending;
+
 /* Inteface addition message from zebra. */
 static int static_ifp_create(struct interface *ifp)
 {
@@ -381,9 +390,9 @@ int static_zebra_nh_update(struct route_node *rn, struct static_nexthop *nh)
 	return 0;
 }
 
-extern void static_zebra_route_add(struct route_node *rn,
-				   struct static_path *pn, safi_t safi,
-				   bool install)
+static void static_zebra_route_send(struct route_node *rn,
+				    struct static_path *pn, safi_t safi,
+				    bool install)
 {
 	struct static_nexthop *nh;
 	const struct prefix *p, *src_pp;
@@ -507,6 +516,52 @@ extern void static_zebra_route_add(struct route_node *rn,
 			   zclient, &api);
 }
 
+static int static_zebra_route_pending_send(struct thread *t)
+{
+	struct static_path *pn;
+
+	while ((pn = static_route_pending_pop(&static_route_pending))) {
+		pn->is_pending = false;
+		static_zebra_route_send(pn->pending_rn, pn, pn->pending_safi,
+					pn->pending_install);
+	}
+
+	return 0;
+}
+
+void static_zebra_route_add(struct route_node *rn, struct static_path *pn,
+			    safi_t safi, bool install)
+{
+	pn->pending_rn = rn;
+	pn->pending_safi = safi;
+	pn->pending_install = install;
+
+	if (!pn->is_pending) {
+		static_route_pending_add_tail(&static_route_pending, pn);
+		pn->is_pending = true;
+	}
+
+	thread_add_event(master, static_zebra_route_pending_send, NULL, 0,
+			 &t_static_route_pending);
+}
+
+/*
+ * The path is going away: send its pending route now if asked to, or
+ * forget about it.
+ */
+void static_zebra_route_pending_del(struct static_path *pn, bool send)
+{
+	if (!pn->is_pending)
+		return;
+
+	static_route_pending_del(&static_route_pending, pn);
+	pn->is_pending = false;
+
+	if (send)
+		static_zebra_route_send(pn->pending_rn, pn, pn->pending_safi,
+					pn->pending_install);
+}
+
 void static_zebra_init(void)
 {
 	struct zclient_options opt = { .receive_notify = true };
@@ -532,6 +587,12 @@ void static_zebra_init(void)
 /* static_zebra_stop used by tests/lib/test_grpc.cpp */
 void static_zebra_stop(void)
 {
+	struct static_path *pn;
+
+	THREAD_OFF(t_static_route_pending);
+	while ((pn = static_route_pending_pop(&static_route_pending)))
+		pn->is_pending = false;
+
 	if (!zclient)
 		return;
 	zclient_stop(zclient);
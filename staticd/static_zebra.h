@@ -31,6 +31,7 @@ extern void static_zebra_nht_register(struct route_node *rn,
 extern void static_zebra_route_add(struct route_node *rn,
 				   struct static_path *pn, safi_t safi,
 				   bool install);
+extern void static_zebra_route_pending_del(struct static_path *pn, bool send);
 extern void static_zebra_init(void);
 /* static_zebra_stop used by tests/lib/test_grpc.cpp */
 extern void static_zebra_stop(void);
@@ -0,0 +1,141 @@
+/*
+ * BGP attribute intern micro-benchmark.
+ *
+ * Interns attributes the way received UPDATEs do: the AS path and the
+ * communities were interned by the parser already, bgp_attr_intern() hashes
+ * the attribute and either finds it (most UPDATEs) or adds it.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+
+#include "vty.h"
+#include "stream.h"
+#include "privs.h"
+#include "memory.h"
+#include "queue.h"
+#include "filter.h"
+
+#include "bgpd/bgpd.h"
+#include "bgpd/bgp_attr.h"
+#include "bgpd/bgp_aspath.h"
+#include "bgpd/bgp_community.h"
+#include "bgpd/bgp_lcommunity.h"
+#include "bgpd/bgp_community_alias.h"
+
+/* need these to link in libbgp */
+struct zebra_privs_t *bgpd_privs = NULL;
+struct thread_master *master = NULL;
+
+#define ATTRS 100000
+#define PATHS 10000
+#define ROUNDS 10
+
+static struct aspath *paths[PATHS];
+static struct community *comms[PATHS];
+static struct lcommunity *lcomms[PATHS];
+static struct attr *attrs[ATTRS];
+
+static unsigned long elapsed_usec(struct timeval *start, struct timeval *stop)
+{
+	return 1000000 * (stop->tv_sec - start->tv_sec)
+	       + (stop->tv_usec - start->tv_usec);
+}
+
+static void build_attr(struct attr *attr, unsigned int i)
+{
+	bgp_attr_default_set(attr, BGP_ORIGIN_IGP);
+	aspath_unintern(&attr->aspath);
+
+	attr->aspath = paths[i % PATHS];
+	attr->community = comms[i % PATHS];
+	attr->lcommunity = lcomms[i % PATHS];
+	attr->nexthop.s_addr = htonl(0x0a000000 + i / PATHS);
+	attr->med = i / PATHS;
+	attr->flag |= ATTR_FLAG_BIT(BGP_ATTR_COMMUNITIES)
+		      | ATTR_FLAG_BIT(BGP_ATTR_LARGE_COMMUNITIES)
+		      | ATTR_FLAG_BIT(BGP_ATTR_MULTI_EXIT_DISC);
+}
+
+int main(void)
+{
+	struct timeval start, stop;
+	struct attr attr, *find;
+	unsigned long usec_add, usec_find;
+	char buf[256];
+	unsigned int i, r;
+
+	bgp_attr_init();
+	bgp_community_alias_init();
+
+	for (i = 0; i < PATHS; i++) {
+		snprintf(buf, sizeof(buf),
+			 "64512 %u 174 3356 %u %u 2914 65000 %u", i % 97,
+			 i % 1009, i, i % 11);
+		paths[i] = aspath_intern(aspath_str2aspath(buf));
+
+		snprintf(buf, sizeof(buf),
+			 "64512:%u 64512:%u 174:%u 3356:%u 65000:100",
+			 i % 13, i % 101, i, i % 7);
+		comms[i] = community_intern(community_str2com(buf));
+
+		snprintf(buf, sizeof(buf), "64512:%u:%u 4200000000:1:%u",
+			 i % 17, i, i % 3);
+		lcomms[i] = lcommunity_intern(lcommunity_str2com(buf));
+	}
+
+	monotime(&start);
+	for (i = 0; i < ATTRS; i++) {
+		build_attr(&attr, i);
+		attrs[i] = bgp_attr_intern(&attr);
+	}
+	monotime(&stop);
+	usec_add = elapsed_usec(&start, &stop);
+	assert(attr_count() == ATTRS);
+
+	monotime(&start);
+	for (r = 0; r < ROUNDS; r++) {
+		for (i = 0; i < ATTRS; i++) {
+			build_attr(&attr, i);
+			find = bgp_attr_intern(&attr);
+			assert(find == attrs[i]);
+			bgp_attr_unintern(&find);
+		}
+	}
+	monotime(&stop);
+	usec_find = elapsed_usec(&start, &stop);
+	assert(attr_count() == ATTRS);
+
+	for (i = 0; i < ATTRS; i++)
+		bgp_attr_unintern(&attrs[i]);
+	assert(attr_count() == 0);
+
+	for (i = 0; i < PATHS; i++) {
+		aspath_unintern(&paths[i]);
+		community_unintern(&comms[i]);
+		lcommunity_unintern(&lcomms[i]);
+	}
+
+	printf("new attributes:      %u in %lu usec, %.0f/s\n", ATTRS,
+	       usec_add, ATTRS / (usec_add / 1e6));
+	printf("existing attributes: %u in %lu usec, %.0f/s\n",
+	       ATTRS * ROUNDS, usec_find,
+	       ATTRS * ROUNDS / (usec_find / 1e6));
+
+	bgp_community_alias_finish();
+	bgp_attr_finish();
+	return 0;
+}
@@ -134,6 +134,47 @@ static void parse_test(struct test_segment *t)
 	ecommunity_unintern(&ecom);
 }
 
+/* intersection, with and without the summary of interned ones */
+static void intersect_test(void)
+{
+	static const uint8_t rt1[] = {ECOMMUNITY_ENCODE_AS,
+				      ECOMMUNITY_ROUTE_TARGET,
+				      0, 1, 0, 0, 0, 1,
+				      ECOMMUNITY_ENCODE_AS,
+				      ECOMMUNITY_ROUTE_TARGET,
+				      0, 1, 0, 0, 0, 2};
+	static const uint8_t rt2[] = {ECOMMUNITY_ENCODE_AS,
+				      ECOMMUNITY_ROUTE_TARGET,
+				      0, 1, 0, 0, 0, 2};
+	static const uint8_t rt3[] = {ECOMMUNITY_ENCODE_AS,
+				      ECOMMUNITY_ROUTE_TARGET,
+				      0, 1, 0, 0, 0, 3};
+	struct ecommunity *e1, *e2, *e3, *d2, *d3;
+	int fails = failed;
+
+	printf("intersect: summarized route-targets\n");
+
+	e1 = ecommunity_parse((uint8_t *)rt1, sizeof(rt1));
+	e2 = ecommunity_parse((uint8_t *)rt2, sizeof(rt2));
+	e3 = ecommunity_parse((uint8_t *)rt3, sizeof(rt3));
+	d2 = ecommunity_dup(e2);
+	d3 = ecommunity_dup(e3);
+
+	if (!ecommunity_intersect(e1, e2) || !ecommunity_intersect(d2, e1)
+	    || !ecommunity_intersect(e1, d2))
+		failed++;
+	if (ecommunity_intersect(e1, e3) || ecommunity_intersect(d3, e1)
+	    || ecommunity_intersect(d2, d3) || ecommunity_intersect(NULL, e1))
+		failed++;
+
+	printf("%s\n\n", failed == fails ? "OK" : "failed");
+
+	ecommunity_free(&d2);
+	ecommunity_free(&d3);
+	ecommunity_unintern(&e1);
+	ecommunity_unintern(&e2);
+	ecommunity_unintern(&e3);
+}
 
 int main(void)
 {
@@ -141,6 +182,7 @@ int main(void)
 	ecommunity_init();
 	while (test_segments[i].name)
 		parse_test(&test_segments[i++]);
+	intersect_test();
 
 	printf("failures: %d\n", failed);
 	// printf ("aspath count: %ld\n", aspath_count());
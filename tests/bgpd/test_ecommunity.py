@@ -9,3 +9,4 @@ TestEcommunity.okfail("ipaddr")
 TestEcommunity.okfail("ipaddr-so")
 TestEcommunity.okfail("asn")
 TestEcommunity.okfail("asn4")
+TestEcommunity.okfail("intersect")
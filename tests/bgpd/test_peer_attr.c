@@ -260,6 +260,8 @@ TEST_ATTR_HANDLER_DECL(timers_1, keepalive, 10, 20);
 TEST_ATTR_HANDLER_DECL(timers_2, holdtime, 30, 60);
 TEST_ATTR_HANDLER_DECL(addpath_types, addpath_type[pa->afi][pa->safi],
 		       BGP_ADDPATH_ALL, BGP_ADDPATH_BEST_PER_AS);
+TEST_ATTR_HANDLER_DECL(addpath_best_selected,
+		       addpath_best_selected[pa->afi][pa->safi], 3, 2);
 TEST_SU_ATTR_HANDLER_DECL(update_source_su, update_source, "255.255.255.1",
 			  "255.255.255.2");
 TEST_STR_ATTR_HANDLER_DECL(update_source_if, update_if, "IF-PEER", "IF-GROUP");
@@ -426,6 +428,13 @@ static struct test_peer_attr test_peer_attrs[] = {
 		.type = PEER_AT_AF_CUSTOM,
 		.handlers[0] = TEST_HANDLER(addpath_types),
 	},
+	{
+		.cmd = "addpath best-selected",
+		.peer_cmd = "addpath-tx-best-selected 3",
+		.group_cmd = "addpath-tx-best-selected 2",
+		.type = PEER_AT_AF_CUSTOM,
+		.handlers[0] = TEST_HANDLER(addpath_best_selected),
+	},
 	{
 		.cmd = "allowas-in",
 		.peer_cmd = "allowas-in 1",
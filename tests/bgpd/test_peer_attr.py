@@ -32,6 +32,10 @@ TestFlag.okfail("peer\\ipv4-unicast\\addpath")
 TestFlag.okfail("peer\\ipv4-multicast\\addpath")
 TestFlag.okfail("peer\\ipv6-unicast\\addpath")
 TestFlag.okfail("peer\\ipv6-multicast\\addpath")
+TestFlag.okfail("peer\\ipv4-unicast\\addpath best-selected")
+TestFlag.okfail("peer\\ipv4-multicast\\addpath best-selected")
+TestFlag.okfail("peer\\ipv6-unicast\\addpath best-selected")
+TestFlag.okfail("peer\\ipv6-multicast\\addpath best-selected")
 TestFlag.okfail("peer\\ipv4-unicast\\allowas-in")
 TestFlag.okfail("peer\\ipv4-multicast\\allowas-in")
 TestFlag.okfail("peer\\ipv6-unicast\\allowas-in")
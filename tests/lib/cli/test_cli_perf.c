@@ -0,0 +1,125 @@
+/*
+ * CLI parsing performance test.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+
+#include "command.h"
+#include "memory.h"
+#include "monotime.h"
+#include "northbound.h"
+#include "vector.h"
+
+/* a node with a lot of sibling keywords, like CONFIG_NODE in a real daemon */
+#define PERF_COMMANDS 2000
+#define PERF_LINES 200000
+
+struct thread_master *master; /* dummy for libfrr*/
+
+static unsigned long perf_hits;
+
+static int perf_callback(const struct cmd_element *cmd, struct vty *vty,
+			 int argc, struct cmd_token *argv[])
+{
+	perf_hits++;
+	return CMD_SUCCESS;
+}
+
+static struct cmd_element perf_cmds[PERF_COMMANDS];
+static char *perf_strings[PERF_COMMANDS];
+
+static void perf_init(void)
+{
+	char buf[256];
+	unsigned int i;
+
+	cmd_init(1);
+	nb_init(master, NULL, 0, false);
+
+	for (i = 0; i < PERF_COMMANDS; i++) {
+		struct cmd_element *cmd = &perf_cmds[i];
+
+		if (i % 2)
+			snprintf(buf, sizeof(buf),
+				 "perf-%04u WORD seq (1-4294967295) <permit|deny> A.B.C.D/M [le (0-32)]",
+				 i);
+		else
+			snprintf(buf, sizeof(buf),
+				 "perf-%04u NAME remote-as <(1-4294967295)|internal|external>",
+				 i);
+		perf_strings[i] = XSTRDUP(MTYPE_TMP, buf);
+
+		cmd->string = perf_strings[i];
+		cmd->doc = (i % 2) ? "a\nb\nc\nd\ne\nf\ng\nh\ni\n"
+				   : "a\nb\nc\nd\ne\nf\n";
+		cmd->func = perf_callback;
+		cmd->name = "perf";
+		_install_element(CONFIG_NODE, cmd);
+	}
+}
+
+static void perf_terminate(void)
+{
+	unsigned int i;
+
+	cmd_terminate();
+	nb_terminate();
+	yang_terminate();
+	for (i = 0; i < PERF_COMMANDS; i++)
+		XFREE(MTYPE_TMP, perf_strings[i]);
+}
+
+int main(int argc, char **argv)
+{
+	struct vty *vty;
+	struct timeval start;
+	char line[256];
+	unsigned long i;
+	int64_t usec;
+	vector vline;
+
+	perf_init();
+	vty = vty_new();
+	vty->node = CONFIG_NODE;
+
+	monotime(&start);
+	for (i = 0; i < PERF_LINES; i++) {
+		unsigned int cmd = (i * 7919) % PERF_COMMANDS;
+
+		if (cmd % 2)
+			snprintf(line, sizeof(line),
+				 "perf-%04u PL%lu seq %lu permit 10.%lu.%lu.0/24 le 32",
+				 cmd, i % 100, i + 1, (i >> 8) & 0xff, i & 0xff);
+		else
+			snprintf(line, sizeof(line),
+				 "  perf-%04u 10.0.%lu.%lu  remote-as %lu\n", cmd,
+				 (i >> 8) & 0xff, i & 0xff, 64512 + i % 1000);
+
+		vline = cmd_make_strvec(line);
+		assert(cmd_execute_command(vline, vty, NULL, 0) == CMD_SUCCESS);
+		cmd_free_strvec(vline);
+	}
+	usec = monotime_since(&start, NULL);
+	assert(perf_hits == PERF_LINES);
+
+	printf("%d lines in %" PRId64 " ms, %.0f lines/sec\n", PERF_LINES,
+	       usec / 1000, (double)PERF_LINES * 1000000.0 / MAX(usec, 1));
+
+	vty_close(vty);
+	perf_terminate();
+	return 0;
+}
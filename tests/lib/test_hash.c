@@ -0,0 +1,202 @@
+/*
+ * Hash table tests, covering both the chained and the open addressing
+ * flavours against a flat array of expected members.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "hash.h"
+
+#define NITEMS 20000
+
+struct item {
+	unsigned int val;
+	bool member;
+	bool seen;
+};
+
+static struct item items[NITEMS];
+static unsigned long members;
+
+static unsigned int item_key(const void *arg)
+{
+	const struct item *item = arg;
+
+	/* deliberately poor, to get long probe sequences and chains */
+	return item->val * 16;
+}
+
+static bool item_cmp(const void *a, const void *b)
+{
+	return ((const struct item *)a)->val == ((const struct item *)b)->val;
+}
+
+static void *item_alloc(void *arg)
+{
+	struct item *item = &items[((struct item *)arg)->val];
+
+	assert(!item->member);
+	item->member = true;
+	members++;
+	return item;
+}
+
+static void item_free(void *arg)
+{
+	struct item *item = arg;
+
+	assert(item->member);
+	item->member = false;
+	members--;
+}
+
+static void check_seen(struct hash *hash, struct hash_bucket *hb)
+{
+	struct item *item = hb->data;
+
+	assert(item->member);
+	assert(!item->seen);
+	item->seen = true;
+}
+
+static void seen_iter(struct hash_bucket *hb, void *arg)
+{
+	check_seen(arg, hb);
+}
+
+/* releases every other element from within the iteration */
+static void release_iter(struct hash_bucket *hb, void *arg)
+{
+	struct hash *hash = arg;
+	struct item *item = hb->data;
+
+	check_seen(hash, hb);
+	if (item->val % 2) {
+		assert(hash_release(hash, item) == item);
+		item_free(item);
+	}
+}
+
+static int abort_walk(struct hash_bucket *hb, void *arg)
+{
+	unsigned int *left = arg;
+
+	check_seen(NULL, hb);
+	return --*left ? HASHWALK_CONTINUE : HASHWALK_ABORT;
+}
+
+static void check_all_seen(struct hash *hash, unsigned long expect)
+{
+	unsigned long seen = 0;
+	unsigned int i;
+
+	for (i = 0; i < NITEMS; i++) {
+		if (items[i].seen) {
+			seen++;
+			items[i].seen = false;
+		} else
+			assert(!items[i].member);
+	}
+	assert(seen == expect);
+	assert(hashcount(hash) == members);
+}
+
+static void run(struct hash *hash, unsigned int seed)
+{
+	struct item key;
+	unsigned int i, op, left;
+
+	srandom(seed);
+	memset(items, 0, sizeof(items));
+	members = 0;
+	for (i = 0; i < NITEMS; i++)
+		items[i].val = i;
+
+	for (op = 0; op < 20 * NITEMS; op++) {
+		key.val = random() % NITEMS;
+
+		switch (random() % 4) {
+		case 0:
+		case 1:
+			assert(hash_get(hash, &key, item_alloc)
+			       == &items[key.val]);
+			break;
+		case 2:
+			assert(hash_lookup(hash, &key)
+			       == (items[key.val].member ? &items[key.val]
+							 : NULL));
+			break;
+		case 3:
+			if (items[key.val].member) {
+				assert(hash_release(hash, &key)
+				       == &items[key.val]);
+				item_free(&items[key.val]);
+			} else
+				assert(!hash_release(hash, &key));
+			break;
+		}
+
+		if (op % 10007 == 0) {
+			hash_iterate(hash, seen_iter, hash);
+			check_all_seen(hash, members);
+		}
+		if (op % 30011 == 0) {
+			unsigned long before = members;
+
+			hash_iterate(hash, release_iter, hash);
+			check_all_seen(hash, before);
+		}
+		if (op % 50021 == 0 && members > 10) {
+			left = 10;
+			hash_walk(hash, abort_walk, &left);
+			assert(left == 0);
+			for (i = 0; i < NITEMS; i++)
+				items[i].seen = false;
+		}
+	}
+
+	hash_clean(hash, item_free);
+	assert(hashcount(hash) == 0 && members == 0);
+	key.val = 1;
+	assert(!hash_lookup(hash, &key));
+	assert(hash_get(hash, &key, item_alloc) == &items[1]);
+	hash_clean(hash, item_free);
+	hash_free(hash);
+}
+
+int main(int argc, char **argv)
+{
+	unsigned int seed;
+
+	for (seed = 1; seed <= 4; seed++) {
+		run(hash_create_size(8, item_key, item_cmp, "test chained"),
+		    seed);
+		run(hash_create_open(8, item_key, item_cmp, "test open"),
+		    seed);
+	}
+	run(hash_create_open(0, item_key, item_cmp, NULL), 5);
+
+	printf("Hash test successful.\n");
+	return 0;
+}
@@ -0,0 +1,96 @@
+/*
+ * Hello pthread tests.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#include <zebra.h>
+#include <assert.h>
+
+#include "frr_pthread.h"
+#include "frratomic.h"
+#include "hello_pthread.h"
+#include "thread.h"
+
+#define SEND_INTERVAL 10
+#define DEAD_INTERVAL 200
+#define FEED_INTERVAL 20
+#define FEEDS 20
+
+static struct thread_master *master;
+static struct hello_watch *hw;
+static struct thread *t_feed;
+static atomic_size_t sends;
+static unsigned int feeds, deaths;
+
+static void do_send(void *arg)
+{
+	atomic_fetch_add_explicit(&sends, 1, memory_order_relaxed);
+}
+
+static int do_feed(struct thread *t)
+{
+	hello_watch_heard(hw);
+	if (++feeds < FEEDS)
+		thread_add_timer_msec(master, do_feed, NULL, FEED_INTERVAL,
+				      &t_feed);
+	return 0;
+}
+
+static int do_dead(struct thread *t)
+{
+	/* must not run while it's being fed */
+	assert(feeds == FEEDS);
+	deaths++;
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	struct hello_sender *hs;
+	struct thread thread;
+	size_t n;
+
+	master = thread_master_create(NULL);
+	frr_pthread_init();
+	hello_pthread_init();
+
+	hs = hello_sender_add(do_send, NULL, SEND_INTERVAL);
+	hw = hello_watch_add(master, do_dead, NULL, DEAD_INTERVAL);
+	thread_add_timer_msec(master, do_feed, NULL, FEED_INTERVAL, &t_feed);
+
+	while (!deaths && thread_fetch(master, &thread))
+		thread_call(&thread);
+
+	/* fed for FEEDS * FEED_INTERVAL, then DEAD_INTERVAL until dead */
+	n = atomic_load_explicit(&sends, memory_order_relaxed);
+	assert(n >= (FEEDS * FEED_INTERVAL + DEAD_INTERVAL) / SEND_INTERVAL / 2);
+	printf("%zu hellos sent\n", n);
+
+	/* rearmed by the next hello */
+	hello_watch_heard(hw);
+	while (deaths < 2 && thread_fetch(master, &thread))
+		thread_call(&thread);
+
+	hello_sender_del(&hs);
+	n = atomic_load_explicit(&sends, memory_order_relaxed);
+	usleep(SEND_INTERVAL * 3 * 1000);
+	assert(n == atomic_load_explicit(&sends, memory_order_relaxed));
+
+	hello_watch_del(&hw);
+	hello_pthread_finish();
+	frr_pthread_finish();
+	thread_master_free(master);
+	return 0;
+}
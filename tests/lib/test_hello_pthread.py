@@ -0,0 +1,8 @@
+import frrtest
+
+
+class TestHelloPthread(frrtest.TestMultiOut):
+    program = "./test_hello_pthread"
+
+
+TestHelloPthread.exit_cleanly()
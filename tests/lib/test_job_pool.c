@@ -0,0 +1,91 @@
+/*
+ * Job pool tests.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+#include <assert.h>
+
+#include "frr_pthread.h"
+#include "job_pool.h"
+#include "thread.h"
+
+#define WORKERS 4
+#define JOBS 1000
+#define SLOW_JOB_USEC 100000
+
+struct test_job {
+	unsigned int n;
+	unsigned int square;
+	bool done;
+};
+
+static struct thread_master *master;
+static struct test_job jobs[JOBS];
+static unsigned int dones;
+
+static void do_run(void *arg)
+{
+	struct test_job *job = arg;
+
+	/* everything queued behind this one gets stolen */
+	if (job->n == 0)
+		usleep(SLOW_JOB_USEC);
+	job->square = job->n * job->n;
+}
+
+static int do_done(struct thread *t)
+{
+	struct test_job *job = THREAD_ARG(t);
+
+	assert(!job->done);
+	assert(job->square == job->n * job->n);
+	job->done = true;
+	dones++;
+	return 0;
+}
+
+int main(int argc, char **argv)
+{
+	struct job_pool *pool;
+	struct thread thread;
+	unsigned int i;
+
+	master = thread_master_create(NULL);
+	frr_pthread_init();
+
+	pool = job_pool_new("Test job pool", "testjob", WORKERS);
+	assert(job_pool_size(pool) == WORKERS);
+
+	for (i = 0; i < JOBS; i++) {
+		jobs[i].n = i;
+		job_pool_submit(pool, master, do_run, do_done, &jobs[i]);
+	}
+
+	while (dones < JOBS && thread_fetch(master, &thread))
+		thread_call(&thread);
+
+	for (i = 0; i < JOBS; i++)
+		assert(jobs[i].done);
+	printf("%u jobs done\n", dones);
+
+	job_pool_free(&pool);
+	assert(!pool);
+
+	frr_pthread_finish();
+	thread_master_free(master);
+	return 0;
+}
@@ -0,0 +1,8 @@
+import frrtest
+
+
+class TestJobPool(frrtest.TestMultiOut):
+    program = "./test_job_pool"
+
+
+TestJobPool.exit_cleanly()
@@ -0,0 +1,109 @@
+/*
+ * Streaming JSON writer tests.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#include <zebra.h>
+#include <assert.h>
+
+#include "buffer.h"
+#include "memory.h"
+#include "vty.h"
+#include "lib/json.h"
+
+struct thread_master *master;
+
+static char *vty_take(struct vty *vty)
+{
+	char *str = buffer_getstr(vty->obuf);
+
+	buffer_reset(vty->obuf);
+	return str;
+}
+
+int main(int argc, char **argv)
+{
+	struct json_stream js;
+	struct vty *vty;
+	json_object *json, *obj;
+	char *str;
+	unsigned int i;
+
+	vty = vty_new();
+	vty->type = VTY_SHELL_SERV;
+
+	/* nested containers and escaped keys */
+	json_stream_init(&js, vty, JSON_C_TO_STRING_PLAIN);
+	json_stream_object_open(&js, NULL);
+	json_stream_add_string(&js, "name", "a \"quoted\"\\name\n");
+	json_stream_add_int(&js, "count", -42);
+	json_stream_array_open(&js, "list");
+	for (i = 0; i < 3; i++)
+		json_stream_add_int(&js, NULL, i);
+	json_stream_close(&js);
+	json_stream_object_open(&js, "empty");
+	json_stream_close(&js);
+	obj = json_object_new_object();
+	json_object_int_add(obj, "x", 1);
+	json_stream_add(&js, "obj\001", obj);
+	json_stream_close(&js);
+	assert(js.depth == 0);
+
+	str = vty_take(vty);
+	assert(str[strlen(str) - 1] == '\n');
+	json = json_tokener_parse(str);
+	assert(json);
+	assert(!strcmp(json_object_get_string(
+			       json_object_object_get(json, "name")),
+		       "a \"quoted\"\\name\n"));
+	assert(json_object_get_int(json_object_object_get(json, "count"))
+	       == -42);
+	assert(json_object_array_length(json_object_object_get(json, "list"))
+	       == 3);
+	assert(json_object_object_length(json_object_object_get(json, "empty"))
+	       == 0);
+	assert(json_object_get_int(json_object_object_get(
+		       json_object_object_get(json, "obj\001"), "x"))
+	       == 1);
+	json_object_free(json);
+	XFREE(MTYPE_TMP, str);
+
+	/* members of a container the caller prints by hand */
+	json_stream_init(&js, vty, JSON_C_TO_STRING_PLAIN);
+	vty_out(vty, "{\"routes\": { ");
+	json_stream_enter(&js);
+	for (i = 0; i < 1000; i++) {
+		char key[16];
+
+		snprintf(key, sizeof(key), "10.0.%u.0/24", i);
+		json_stream_add(&js, key, json_object_new_array());
+	}
+	json_stream_leave(&js);
+	vty_out(vty, " } }\n");
+	assert(js.depth == 0);
+
+	str = vty_take(vty);
+	json = json_tokener_parse(str);
+	assert(json);
+	assert(json_object_object_length(json_object_object_get(json, "routes"))
+	       == 1000);
+	json_object_free(json);
+	XFREE(MTYPE_TMP, str);
+
+	vty_close(vty);
+
+	printf("Streaming JSON test successful.\n");
+	return 0;
+}
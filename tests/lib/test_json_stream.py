@@ -0,0 +1,8 @@
+import frrtest
+
+
+class TestJsonStream(frrtest.TestMultiOut):
+    program = "./test_json_stream"
+
+
+TestJsonStream.exit_cleanly()
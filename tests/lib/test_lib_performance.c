@@ -0,0 +1,738 @@
+/*
+ * Micro-benchmarks for the lib data structures
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+/*
+ * Prints the time and, where the kernel lets us, the cache misses per
+ * operation of the lib hash tables, route tables, skiplist, stream,
+ * printfrr, checksums and thread_master.  The keys are IPv4 prefixes, either read
+ * from a file with one prefix per line, e.g. from a BGP table dump with
+ *
+ *   bgpdump -m rib.mrt | cut -d'|' -f6 | grep -v : | sort -u > prefixes
+ *   test_lib_performance prefixes
+ *
+ * or generated with the prefix length mix of a full table.  Lookups are
+ * done in a random order so they are not helped by the cache more than in
+ * a daemon.
+ */
+
+#include <zebra.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+#include "checksum.h"
+#include "hash.h"
+#include "jhash.h"
+#include "log.h"
+#ifdef CRYPTO_INTERNAL
+#include "md5.h"
+#endif
+#include "monotime.h"
+#include "prefix.h"
+#include "printfrr.h"
+#include "prng.h"
+#include "skiplist.h"
+#include "srcdest_table.h"
+#include "stream.h"
+#include "table.h"
+#include "thread.h"
+#include "typesafe.h"
+#include "vty.h"
+
+#define SYNTHETIC_PREFIXES 900000
+
+struct thread_master *master;
+
+PREDECL_HASH(bench_hash);
+
+struct bench_item {
+	struct bench_hash_item hitem;
+	struct prefix p;
+};
+
+static struct bench_item *items;
+static struct prefix_ipv6 *items6, srcs6[16];
+static unsigned int *order;
+static size_t nitems;
+
+/* which benchmarks to run, NULL for all */
+static const char *only;
+
+static int perf_fd = -1;
+static struct timeval bench_tv;
+static uint64_t bench_misses;
+
+static uint64_t perf_read(void)
+{
+	uint64_t value = 0;
+
+	if (perf_fd < 0 || read(perf_fd, &value, sizeof(value)) != sizeof(value))
+		return 0;
+	return value;
+}
+
+static void perf_init(void)
+{
+#ifdef __linux__
+	struct perf_event_attr attr;
+
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = PERF_TYPE_HARDWARE;
+	attr.config = PERF_COUNT_HW_CACHE_MISSES;
+	attr.exclude_kernel = 1;
+	attr.exclude_hv = 1;
+
+	perf_fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+	if (perf_fd < 0)
+		printf("(cache misses are not available: %s)\n",
+		       safe_strerror(errno));
+}
+
+static bool bench_begin(const char *name)
+{
+	if (only && !strstr(name, only))
+		return false;
+
+	bench_misses = perf_read();
+	monotime(&bench_tv);
+	return true;
+}
+
+static void bench_end(const char *name, uint64_t ops)
+{
+	uint64_t usec = monotime_since(&bench_tv, NULL);
+	uint64_t misses = perf_read() - bench_misses;
+
+	if (!ops)
+		ops = 1;
+
+	printf("%-34s %9" PRIu64 " ops %9.1f ns/op", name, ops,
+	       usec * 1000.0 / ops);
+	if (perf_fd >= 0)
+		printf(" %7.2f misses/op", (double)misses / ops);
+	printf("\n");
+	fflush(stdout);
+}
+
+/*
+ * Rough IPv4 full table prefix length mix, in percent: mostly /24s, then
+ * /22s, /23s and /21s, a few shorter ones.
+ */
+static const struct {
+	uint8_t len, percent;
+} len_mix[] = {
+	{24, 59}, {22, 12}, {23, 10}, {21, 5}, {20, 5}, {19, 3},
+	{16, 2},  {18, 2},  {17, 1},  {12, 1},
+};
+
+static void keys_synthetic(struct prng *prng)
+{
+	size_t i;
+
+	nitems = SYNTHETIC_PREFIXES;
+	items = calloc(nitems, sizeof(*items));
+
+	for (i = 0; i < nitems; i++) {
+		unsigned int pick = prng_rand(prng) % 100, j;
+		struct prefix *p = &items[i].p;
+
+		for (j = 0; j < array_size(len_mix) - 1; j++) {
+			if (pick < len_mix[j].percent)
+				break;
+			pick -= len_mix[j].percent;
+		}
+
+		/* public space, roughly 1.0.0.0 to 223.255.255.255 */
+		p->family = AF_INET;
+		p->prefixlen = len_mix[j].len;
+		p->u.prefix4.s_addr =
+			htonl(0x01000000 + prng_rand(prng) % 0xdf000000);
+		apply_mask(p);
+	}
+}
+
+static bool keys_read(const char *path)
+{
+	char line[128];
+	size_t alloc = 0;
+	FILE *fp;
+
+	fp = fopen(path, "r");
+	if (!fp) {
+		fprintf(stderr, "%s: %s\n", path, safe_strerror(errno));
+		return false;
+	}
+
+	while (fgets(line, sizeof(line), fp)) {
+		line[strcspn(line, " \t\r\n")] = '\0';
+
+		if (nitems == alloc) {
+			alloc = alloc ? alloc * 2 : 65536;
+			items = realloc(items, alloc * sizeof(*items));
+		}
+		memset(&items[nitems], 0, sizeof(items[nitems]));
+		if (str2prefix(line, &items[nitems].p)
+		    && items[nitems].p.family == AF_INET) {
+			apply_mask(&items[nitems].p);
+			nitems++;
+		}
+	}
+	fclose(fp);
+
+	if (!nitems) {
+		fprintf(stderr, "%s: no IPv4 prefixes\n", path);
+		return false;
+	}
+	return true;
+}
+
+static void keys_prepare(struct prng *prng)
+{
+	size_t i, j;
+
+	order = calloc(nitems, sizeof(*order));
+	for (i = 0; i < nitems; i++)
+		order[i] = i;
+	for (i = nitems - 1; i > 0; i--) {
+		unsigned int tmp = order[i];
+
+		j = prng_rand(prng) % (i + 1);
+		order[i] = order[j];
+		order[j] = tmp;
+	}
+
+	/* the same table as IPv6 destinations in 2000::/3 */
+	items6 = calloc(nitems, sizeof(*items6));
+	for (i = 0; i < nitems; i++) {
+		items6[i].family = AF_INET6;
+		items6[i].prefixlen = items[i].p.prefixlen + 8;
+		items6[i].prefix.s6_addr[0] = 0x20;
+		memcpy(&items6[i].prefix.s6_addr[1], &items[i].p.u.prefix4, 4);
+	}
+	for (i = 0; i < array_size(srcs6); i++) {
+		srcs6[i].family = AF_INET6;
+		srcs6[i].prefixlen = 48;
+		srcs6[i].prefix.s6_addr[0] = 0xfd;
+		srcs6[i].prefix.s6_addr[5] = i;
+	}
+}
+
+/* a host address inside the prefix */
+static struct prefix host_of(const struct prefix *p, struct prng *prng)
+{
+	struct prefix h = *p;
+	uint32_t hostmask = p->prefixlen ? (1U << (32 - p->prefixlen)) - 1
+					 : UINT32_MAX;
+
+	h.prefixlen = IPV4_MAX_BITLEN;
+	h.u.prefix4.s_addr =
+		htonl(ntohl(p->u.prefix4.s_addr) | (prng_rand(prng) & hostmask));
+	return h;
+}
+
+static unsigned int bench_hash_key(const void *arg)
+{
+	const struct bench_item *item = arg;
+
+	return prefix_hash_key(&item->p);
+}
+
+static bool bench_hash_cmp(const void *a, const void *b)
+{
+	const struct bench_item *ia = a, *ib = b;
+
+	return prefix_same(&ia->p, &ib->p);
+}
+
+static int bench_item_cmp(const struct bench_item *a,
+			  const struct bench_item *b)
+{
+	return prefix_cmp(&a->p, &b->p);
+}
+
+static uint32_t bench_item_hash(const struct bench_item *a)
+{
+	return prefix_hash_key(&a->p);
+}
+
+DECLARE_HASH(bench_hash, struct bench_item, hitem, bench_item_cmp,
+	     bench_item_hash);
+
+static void bench_lib_hash(void)
+{
+	struct hash *hash;
+	struct bench_item key;
+	size_t i, found = 0;
+
+	hash = hash_create(bench_hash_key, bench_hash_cmp, "bench");
+
+	if (bench_begin("hash insert")) {
+		for (i = 0; i < nitems; i++)
+			hash_get(hash, &items[i], hash_alloc_intern);
+		bench_end("hash insert", nitems);
+	} else
+		for (i = 0; i < nitems; i++)
+			hash_get(hash, &items[i], hash_alloc_intern);
+
+	if (bench_begin("hash lookup")) {
+		for (i = 0; i < nitems; i++) {
+			key.p = items[order[i]].p;
+			found += !!hash_lookup(hash, &key);
+		}
+		bench_end("hash lookup", nitems);
+	}
+
+	hash_clean(hash, NULL);
+	hash_free(hash);
+	assert(!found || found == nitems);
+}
+
+static void bench_typesafe_hash(void)
+{
+	struct bench_hash_head head;
+	struct bench_item key;
+	size_t i, found = 0;
+
+	bench_hash_init(&head);
+
+	if (bench_begin("typesafe hash insert")) {
+		for (i = 0; i < nitems; i++)
+			bench_hash_add(&head, &items[i]);
+		bench_end("typesafe hash insert", nitems);
+	} else
+		for (i = 0; i < nitems; i++)
+			bench_hash_add(&head, &items[i]);
+
+	if (bench_begin("typesafe hash lookup")) {
+		for (i = 0; i < nitems; i++) {
+			key.p = items[order[i]].p;
+			found += !!bench_hash_find(&head, &key);
+		}
+		bench_end("typesafe hash lookup", nitems);
+	}
+
+	while (bench_hash_pop(&head))
+		;
+	bench_hash_fini(&head);
+	assert(!found || found == nitems);
+}
+
+static void bench_table(struct prng *prng, bool lpm_index)
+{
+	const char *n_get = lpm_index ? "table insert (lpm index)"
+				      : "table insert";
+	const char *n_match = lpm_index ? "table lpm match (lpm index)"
+					: "table lpm match";
+	struct route_table *table;
+	struct route_node *rn;
+	struct prefix *hosts;
+	size_t i;
+
+	table = route_table_init();
+	if (lpm_index)
+		route_table_enable_lpm_index(table);
+
+	hosts = calloc(nitems, sizeof(*hosts));
+	for (i = 0; i < nitems; i++)
+		hosts[i] = host_of(&items[order[i]].p, prng);
+
+	if (bench_begin(n_get)) {
+		for (i = 0; i < nitems; i++)
+			route_node_get(table, &items[i].p);
+		bench_end(n_get, nitems);
+	} else
+		for (i = 0; i < nitems; i++)
+			route_node_get(table, &items[i].p);
+
+	if (bench_begin(n_match)) {
+		for (i = 0; i < nitems; i++) {
+			rn = route_node_match(table, &hosts[i]);
+			if (rn)
+				route_unlock_node(rn);
+		}
+		bench_end(n_match, nitems);
+	}
+
+	free(hosts);
+	route_table_finish(table);
+}
+
+static void bench_srcdest(void)
+{
+	struct route_table *table;
+	struct route_node *rn;
+	size_t i;
+
+	table = srcdest_table_init();
+
+	if (bench_begin("srcdest insert")) {
+		for (i = 0; i < nitems; i++)
+			srcdest_rnode_get(table, &items6[i],
+					  &srcs6[i % array_size(srcs6)]);
+		bench_end("srcdest insert", nitems);
+	} else
+		for (i = 0; i < nitems; i++)
+			srcdest_rnode_get(table, &items6[i],
+					  &srcs6[i % array_size(srcs6)]);
+
+	if (bench_begin("srcdest lookup")) {
+		for (i = 0; i < nitems; i++) {
+			rn = srcdest_rnode_lookup(
+				table, &items6[order[i]],
+				&srcs6[order[i] % array_size(srcs6)]);
+			if (rn)
+				route_unlock_node(rn);
+		}
+		bench_end("srcdest lookup", nitems);
+	}
+
+	route_table_finish(table);
+
+	/* the same destinations without sources, which should cost no more
+	 * than in a plain table since they don't get source tables
+	 */
+	table = srcdest_table_init();
+	for (i = 0; i < nitems; i++)
+		srcdest_rnode_get(table, &items6[i], NULL)->info = &items6[i];
+
+	if (bench_begin("srcdest lookup, no source")) {
+		for (i = 0; i < nitems; i++) {
+			rn = srcdest_rnode_lookup(table, &items6[order[i]],
+						  NULL);
+			if (rn)
+				route_unlock_node(rn);
+		}
+		bench_end("srcdest lookup, no source", nitems);
+	}
+
+	route_table_finish(table);
+
+	table = route_table_init();
+	for (i = 0; i < nitems; i++)
+		route_node_get(table, &items6[i])->info = &items6[i];
+
+	if (bench_begin("route_table lookup IPv6")) {
+		for (i = 0; i < nitems; i++) {
+			rn = route_node_lookup(table, &items6[order[i]]);
+			if (rn)
+				route_unlock_node(rn);
+		}
+		bench_end("route_table lookup IPv6", nitems);
+	}
+
+	route_table_finish(table);
+}
+
+static int bench_skiplist_cmp(const void *a, const void *b)
+{
+	return prefix_cmp(a, b);
+}
+
+static void bench_skiplist(void)
+{
+	struct skiplist *sl;
+	void *value;
+	size_t i;
+
+	sl = skiplist_new(0, bench_skiplist_cmp, NULL);
+
+	if (bench_begin("skiplist insert")) {
+		for (i = 0; i < nitems; i++)
+			skiplist_insert(sl, &items[i].p, &items[i]);
+		bench_end("skiplist insert", nitems);
+	} else
+		for (i = 0; i < nitems; i++)
+			skiplist_insert(sl, &items[i].p, &items[i]);
+
+	if (bench_begin("skiplist search")) {
+		for (i = 0; i < nitems; i++)
+			skiplist_search(sl, &items[order[i]].p, &value);
+		bench_end("skiplist search", nitems);
+	}
+
+	skiplist_free(sl);
+}
+
+static void bench_stream(void)
+{
+	struct stream *s;
+	struct prefix p;
+	size_t i;
+
+	s = stream_new(nitems * (1 + IPV4_MAX_BYTELEN));
+
+	if (bench_begin("stream put prefix")) {
+		for (i = 0; i < nitems; i++)
+			stream_put_prefix(s, &items[i].p);
+		bench_end("stream put prefix", nitems);
+	} else
+		for (i = 0; i < nitems; i++)
+			stream_put_prefix(s, &items[i].p);
+
+	/* the way the NLRI parsers read them back */
+	if (bench_begin("stream get prefix")) {
+		memset(&p, 0, sizeof(p));
+		p.family = AF_INET;
+		for (i = 0; i < nitems; i++) {
+			p.prefixlen = stream_getc(s);
+			stream_get(&p.u.prefix4, s, PSIZE(p.prefixlen));
+		}
+		bench_end("stream get prefix", nitems);
+	}
+
+	stream_free(s);
+}
+
+static void bench_printfrr(void)
+{
+	char buf[PREFIX_STRLEN];
+	size_t i, n = MIN(nitems, 200000);
+
+	if (bench_begin("printfrr %pFX")) {
+		for (i = 0; i < n; i++)
+			snprintfrr(buf, sizeof(buf), "%pFX",
+				   &items[order[i]].p);
+		bench_end("printfrr %pFX", n);
+	}
+
+	if (bench_begin("printfrr %pFX IPv6")) {
+		for (i = 0; i < n; i++)
+			snprintfrr(buf, sizeof(buf), "%pFX", &items6[order[i]]);
+		bench_end("printfrr %pFX IPv6", n);
+	}
+
+	if (bench_begin("inet_ntop IPv4")) {
+		for (i = 0; i < n; i++)
+			inet_ntop(AF_INET, &items[order[i]].p.u.prefix4, buf,
+				  sizeof(buf));
+		bench_end("inet_ntop IPv4", n);
+	}
+
+	if (bench_begin("inet_ntop IPv6")) {
+		for (i = 0; i < n; i++)
+			inet_ntop(AF_INET6, &items6[order[i]].prefix, buf,
+				  sizeof(buf));
+		bench_end("inet_ntop IPv6", n);
+	}
+
+	if (bench_begin("prefix2str")) {
+		for (i = 0; i < n; i++)
+			prefix2str(&items[order[i]].p, buf, sizeof(buf));
+		bench_end("prefix2str", n);
+	}
+}
+
+static void bench_jhash(void)
+{
+	uint32_t sum = 0;
+	size_t i;
+
+	if (bench_begin("jhash 4 bytes")) {
+		for (i = 0; i < nitems; i++)
+			sum += jhash(&items[order[i]].p.u.prefix4,
+				     IPV4_MAX_BYTELEN,
+				     items[order[i]].p.prefixlen);
+		bench_end("jhash 4 bytes", nitems);
+	}
+
+	if (bench_begin("jhash_2words")) {
+		for (i = 0; i < nitems; i++)
+			sum += jhash_2words(items[order[i]].p.u.prefix4.s_addr,
+					    items[order[i]].p.prefixlen, 0);
+		bench_end("jhash_2words", nitems);
+	}
+
+	if (bench_begin("prefix_hash_key")) {
+		for (i = 0; i < nitems; i++)
+			sum += prefix_hash_key(&items[order[i]].p);
+		bench_end("prefix_hash_key", nitems);
+	}
+
+	/* keep the compiler from dropping the loops */
+	if (sum == 0x12345678)
+		printf("\n");
+}
+
+/* packet and LSA checksums, and the per packet authentication digest */
+static void bench_checksum(struct prng *prng)
+{
+	static uint8_t buf[1500];
+	uint8_t digest[16];
+	uint32_t sum = 0;
+	size_t i, n = 200000;
+
+	for (i = 0; i < sizeof(buf); i++)
+		buf[i] = prng_rand(prng);
+
+	if (bench_begin("in_cksum 1500 bytes")) {
+		for (i = 0; i < n; i++)
+			sum += in_cksum(buf, sizeof(buf));
+		bench_end("in_cksum 1500 bytes", n);
+	}
+
+	if (bench_begin("fletcher_checksum 1500 bytes")) {
+		for (i = 0; i < n; i++)
+			sum += fletcher_checksum(buf, sizeof(buf),
+						 FLETCHER_CHECKSUM_VALIDATE);
+		bench_end("fletcher_checksum 1500 bytes", n);
+	}
+
+	/* as with --with-crypto, to compare the implementations */
+	if (bench_begin("hmac-md5 1500 bytes")) {
+		for (i = 0; i < n; i++) {
+#ifdef CRYPTO_OPENSSL
+			HMAC(EVP_md5(), "secret", 6, buf, sizeof(buf), digest,
+			     NULL);
+#elif CRYPTO_INTERNAL
+			hmac_md5(buf, sizeof(buf), (unsigned char *)"secret", 6,
+				 digest);
+#endif
+			sum += digest[0];
+		}
+		bench_end("hmac-md5 1500 bytes", n);
+	}
+
+	if (sum == 0x12345678)
+		printf("\n");
+}
+
+static int dummy_func(struct thread *thread)
+{
+	return 0;
+}
+
+static void bench_thread(struct prng *prng, bool wheel)
+{
+	const char *n_add = wheel ? "timer add (wheel)" : "timer add (heap)";
+	const char *n_cancel = wheel ? "timer cancel (wheel)"
+				     : "timer cancel (heap)";
+	size_t i, j, n = MIN(nitems, 500000);
+	struct thread **timers;
+	unsigned int *perm;
+	struct thread t;
+
+	master = thread_master_create(NULL);
+	thread_master_set_timer_wheel(master, wheel);
+	timers = calloc(n, sizeof(*timers));
+
+	/* cancel in a random order */
+	perm = calloc(n, sizeof(*perm));
+	for (i = 0; i < n; i++) {
+		j = prng_rand(prng) % (i + 1);
+		perm[i] = perm[j];
+		perm[j] = i;
+	}
+
+	/* the events: queue them all, then run them */
+	if (!wheel && bench_begin("event add + fetch")) {
+		for (i = 0; i < n; i++)
+			thread_add_event(master, dummy_func, NULL, i, NULL);
+		for (i = 0; i < n; i++)
+			thread_fetch(master, &t);
+		bench_end("event add + fetch", n);
+	}
+
+	/* allocate the thread structures before measuring */
+	for (i = 0; i < n; i++)
+		thread_add_timer_msec(master, dummy_func, NULL, 0, &timers[i]);
+	for (i = 0; i < n; i++)
+		thread_cancel(&timers[i]);
+
+	if (bench_begin(n_add)) {
+		for (i = 0; i < n; i++)
+			thread_add_timer_msec(master, dummy_func, NULL,
+					      prng_rand(prng) % 3600000,
+					      &timers[i]);
+		bench_end(n_add, n);
+	} else
+		for (i = 0; i < n; i++)
+			thread_add_timer_msec(master, dummy_func, NULL,
+					      prng_rand(prng) % 3600000,
+					      &timers[i]);
+
+	if (bench_begin(n_cancel)) {
+		for (i = 0; i < n; i++)
+			thread_cancel(&timers[perm[i]]);
+		bench_end(n_cancel, n);
+	}
+
+	for (i = 0; i < n; i++)
+		thread_cancel(&timers[i]);
+	free(perm);
+	free(timers);
+	thread_master_free(master);
+}
+
+int main(int argc, char **argv)
+{
+	struct prng *prng;
+	int opt;
+
+	while ((opt = getopt(argc, argv, "b:h")) != -1) {
+		switch (opt) {
+		case 'b':
+			only = optarg;
+			break;
+		default:
+			fprintf(stderr,
+				"usage: %s [-b NAME] [PREFIX-FILE]\n"
+				"  -b NAME  only run the benchmarks matching NAME\n",
+				argv[0]);
+			return 1;
+		}
+	}
+
+	prng = prng_new(0);
+
+	if (optind < argc) {
+		if (!keys_read(argv[optind]))
+			return 1;
+		printf("%zu prefixes from %s\n", nitems, argv[optind]);
+	} else {
+		keys_synthetic(prng);
+		printf("%zu synthetic prefixes\n", nitems);
+	}
+	keys_prepare(prng);
+	perf_init();
+
+	bench_lib_hash();
+	bench_typesafe_hash();
+	bench_table(prng, false);
+	bench_table(prng, true);
+	bench_srcdest();
+	bench_skiplist();
+	bench_stream();
+	bench_printfrr();
+	bench_jhash();
+	bench_checksum(prng);
+	bench_thread(prng, false);
+	bench_thread(prng, true);
+
+	if (perf_fd >= 0)
+		close(perf_fd);
+	free(items6);
+	free(order);
+	free(items);
+	prng_free(prng);
+	return 0;
+}
@@ -17,10 +17,14 @@
  */
 
 #include <zebra.h>
+#include <pthread.h>
 #include <memory.h>
 
 DEFINE_MGROUP(TEST_MEMORY, "memory test");
 DEFINE_MTYPE_STATIC(TEST_MEMORY, TEST, "generic test mtype");
+DEFINE_MTYPE_STATIC(TEST_MEMORY, TEST_SLAB, "slab test mtype");
+DEFINE_MTYPE_STATIC(TEST_MEMORY, TEST_SHARD, "pthread test mtype");
+DEFINE_MTYPE_STATIC(TEST_MEMORY, TEST_HUGE, "huge page test mtype");
 
 /* Memory torture tests
  *
@@ -44,6 +48,18 @@ struct thread_master *master;
 
 #define TIMES 10
 
+#define SHARD_OBJS 1000
+static void *shard_objs[SHARD_OBJS];
+
+static void *shard_alloc(void *arg)
+{
+	int i;
+
+	for (i = 0; i < SHARD_OBJS; i++)
+		shard_objs[i] = XMALLOC(MTYPE_TEST_SHARD, 16);
+	return NULL;
+}
+
 int main(int argc, char **argv)
 {
 	void *a[10];
@@ -116,5 +132,92 @@ int main(int argc, char **argv)
 		XFREE(MTYPE_TEST, a[2]);
 		/* alloc == 0, cache valid next request */
 	}
+
+	printf("slab\n\n");
+	/* enough objects to need a few chunks */
+	{
+		struct mtype_slab_stats st;
+		static void *objs[10000];
+
+		mtype_slab_enable(MTYPE_TEST_SLAB, 40);
+
+		for (i = 0; i < 10000; i++) {
+			objs[i] = XCALLOC(MTYPE_TEST_SLAB, 40);
+			assert(((uintptr_t)objs[i] & 15) == 0);
+			memset(objs[i], i & 0xff, 40);
+		}
+		assert(mtype_slab_stats(MTYPE_TEST_SLAB, &st));
+		assert(st.objsize == 48 && st.n_used == 10000);
+		assert(st.n_chunks == (10000 + st.per_chunk - 1) / st.per_chunk);
+
+		for (i = 0; i < 10000; i += 2)
+			XFREE(MTYPE_TEST_SLAB, objs[i]);
+		for (i = 1; i < 10000; i += 2)
+			assert(((unsigned char *)objs[i])[39] == (i & 0xff));
+		for (i = 0; i < 10000; i += 2)
+			objs[i] = XCALLOC(MTYPE_TEST_SLAB, 40);
+		for (i = 0; i < 10000; i++)
+			XFREE(MTYPE_TEST_SLAB, objs[i]);
+
+		/* only the spare chunk is left */
+		assert(mtype_slab_stats(MTYPE_TEST_SLAB, &st));
+		assert(st.n_used == 0 && st.n_chunks == 1);
+		assert(mtype_stats_alloc(MTYPE_TEST_SLAB) == 0);
+	}
+
+	printf("huge pages\n\n");
+	/* chunks come out of the arena and go back to it */
+	{
+		struct mtype_slab_stats st;
+		struct mtype_hugepages_stats hst;
+		static void *objs[10000];
+
+		mtype_slab_enable(MTYPE_TEST_HUGE, 64);
+		mtype_slab_hugepages(MTYPE_TEST_HUGE);
+		mtype_hugepages_set(MTYPE_HUGEPAGES_TRANSPARENT);
+
+		for (i = 0; i < 10000; i++) {
+			objs[i] = XCALLOC(MTYPE_TEST_HUGE, 64);
+			memset(objs[i], i & 0xff, 64);
+		}
+		assert(mtype_slab_stats(MTYPE_TEST_HUGE, &st));
+		assert(st.n_huge == st.n_chunks);
+		mtype_hugepages_stats(&hst);
+		assert(hst.mapped >= st.n_chunks * 64 * 1024);
+
+		for (i = 0; i < 10000; i++) {
+			assert(((unsigned char *)objs[i])[63] == (i & 0xff));
+			XFREE(MTYPE_TEST_HUGE, objs[i]);
+		}
+
+		/* all but the spare chunk are free in the arena */
+		assert(mtype_slab_stats(MTYPE_TEST_HUGE, &st));
+		assert(st.n_chunks == 1 && st.n_huge == 1);
+		mtype_hugepages_stats(&hst);
+		assert(hst.free == hst.mapped - 64 * 1024);
+
+		mtype_hugepages_set(MTYPE_HUGEPAGES_OFF);
+	}
+
+	printf("pthreads\n\n");
+	/* allocated on one pthread, freed on another */
+	{
+		struct mtype_stats st;
+		pthread_t pth;
+
+		pthread_create(&pth, NULL, shard_alloc, NULL);
+		pthread_join(pth, NULL);
+		mtype_stats(MTYPE_TEST_SHARD, &st);
+		assert(st.n_alloc == SHARD_OBJS && st.n_max == SHARD_OBJS);
+
+		for (i = 0; i < SHARD_OBJS / 2; i++)
+			XFREE(MTYPE_TEST_SHARD, shard_objs[i]);
+		assert(mtype_stats_alloc(MTYPE_TEST_SHARD) == SHARD_OBJS / 2);
+
+		for (; i < SHARD_OBJS; i++)
+			XFREE(MTYPE_TEST_SHARD, shard_objs[i]);
+		mtype_stats(MTYPE_TEST_SHARD, &st);
+		assert(st.n_alloc == 0 && st.n_max == SHARD_OBJS);
+	}
 	return 0;
 }
@@ -192,10 +192,44 @@ static void test_run_first(void)
 	nexthop_free(nh2);
 }
 
+static void test_run_hash(void)
+{
+	struct nexthop *nh1, *nh2;
+	struct in6_addr addr6;
+	mpls_label_t labels[2] = {111, 222};
+	int i;
+
+	/* equal nexthops hash the same */
+	inet_pton(AF_INET6, "fe80::1", &addr6);
+	nh1 = nexthop_from_ipv6_ifindex(&addr6, 5, 0);
+	nh2 = nexthop_from_ipv6_ifindex(&addr6, 5, 0);
+	nexthop_add_labels(nh1, ZEBRA_LSP_STATIC, 2, labels);
+	nexthop_add_labels(nh2, ZEBRA_LSP_STATIC, 2, labels);
+
+	assert(nexthop_same(nh1, nh2));
+	assert(nexthop_hash(nh1) == nexthop_hash(nh2));
+
+	/* and so do unequal ones that differ beyond the first word */
+	for (i = 2; i < 16; i++) {
+		nexthop_free(nh2);
+		addr6.s6_addr[15] = i;
+		nh2 = nexthop_from_ipv6_ifindex(&addr6, 5, 0);
+		nexthop_add_labels(nh2, ZEBRA_LSP_STATIC, 2, labels);
+
+		assert(!nexthop_same(nh1, nh2));
+		assert(nexthop_hash(nh1) != nexthop_hash(nh2));
+	}
+
+	nexthop_free(nh1);
+	nexthop_free(nh2);
+}
+
 int main(int argc, char **argv)
 {
 	if (argc >= 2 && !strcmp("-v", argv[1]))
 		verbose = true;
 	test_run_first();
 	printf("Simple test passed.\n");
+	test_run_hash();
+	printf("Hash test passed.\n");
 }
@@ -6,3 +6,4 @@ class TestNexthopIter(frrtest.TestMultiOut):
 
 
 TestNexthopIter.onesimple("Simple test passed.")
+TestNexthopIter.onesimple("Hash test passed.")
@@ -48,6 +48,15 @@ int main(int argc, char **argv)
 		assert(!strcmp(buf1, buf2));
 	}
 
+	/* every value of every byte, for the digit table */
+	for (i = 0; i < 256 * 4; i++) {
+		i4.s_addr = 0x01010101;
+		((uint8_t *)&i4)[i / 256] = i % 256;
+		assert(frr_inet_ntop(AF_INET, &i4, buf1, sizeof(buf1)));
+		assert(inet_ntop(AF_INET, &i4, buf2, sizeof(buf2)));
+		assert(!strcmp(buf1, buf2));
+	}
+
 	/* check size limit */
 	for (i = 0; i < sizeof(buf1); i++) {
 		memset(buf2, 0xcc, sizeof(buf2));
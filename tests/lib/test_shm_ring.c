@@ -0,0 +1,101 @@
+/*
+ * Shared memory ring tests.
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+#include <zebra.h>
+#include <assert.h>
+
+#include "libfrr.h"
+#include "shm_ring.h"
+
+#define RING_SIZE 4096
+
+int main(int argc, char **argv)
+{
+	struct shm_ring *prod, *cons, *bad;
+	uint8_t in[1000], out[1000];
+	bool wakeup;
+	uint64_t total = 0;
+	unsigned int i, j;
+	int fd;
+
+	snprintf(frr_vtydir, sizeof(frr_vtydir), ".");
+
+	prod = shm_ring_new(RING_SIZE - 1);
+	assert(prod);
+	cons = shm_ring_attach(shm_ring_fd(prod));
+	assert(cons);
+	assert(shm_ring_fd(cons) == -1);
+
+	/* the consumer starts out asleep, the first put wakes it */
+	wakeup = false;
+	assert(shm_ring_put(prod, "hello", 5, &wakeup));
+	assert(wakeup);
+	wakeup = false;
+	assert(shm_ring_put(prod, "world", 5, &wakeup));
+	assert(!wakeup);
+	assert(shm_ring_used(cons) == 10);
+
+	assert(!shm_ring_get(cons, out, 11));
+	assert(shm_ring_peek(cons, out, 5) && !memcmp(out, "hello", 5));
+	assert(shm_ring_get(cons, out, 10) && !memcmp(out, "helloworld", 10));
+	assert(shm_ring_used(prod) == 0);
+
+	/* it cannot go to sleep while there is data */
+	assert(shm_ring_put(prod, "x", 1, &wakeup));
+	assert(!shm_ring_sleep(cons));
+	assert(shm_ring_get(cons, out, 1));
+	assert(shm_ring_sleep(cons));
+	wakeup = false;
+	assert(shm_ring_put(prod, "y", 1, &wakeup));
+	assert(wakeup);
+	assert(shm_ring_get(cons, out, 1) && out[0] == 'y');
+
+	/* puts are all or nothing */
+	for (i = 0; shm_ring_put(prod, in, sizeof(in), &wakeup); i++)
+		;
+	assert(i == RING_SIZE / sizeof(in));
+	assert(shm_ring_used(cons) == i * sizeof(in));
+	while (shm_ring_get(cons, out, sizeof(in)))
+		;
+	assert(shm_ring_used(cons) == 0);
+
+	/* data survives wrapping around, at odd offsets */
+	for (i = 0; i < 1000; i++) {
+		size_t len = 1 + (i * 37) % sizeof(in);
+
+		for (j = 0; j < len; j++)
+			in[j] = (uint8_t)(total + j);
+		assert(shm_ring_put(prod, in, len, &wakeup));
+		assert(shm_ring_get(cons, out, len));
+		assert(!memcmp(in, out, len));
+		total += len;
+	}
+
+	/* only rings can be attached */
+	fd = open("/dev/null", O_RDWR);
+	assert(fd >= 0);
+	bad = shm_ring_attach(fd);
+	assert(!bad);
+	close(fd);
+
+	shm_ring_del(&cons);
+	shm_ring_del(&prod);
+	assert(!prod && !cons);
+
+	printf("Shared memory ring test successful.\n");
+	return 0;
+}
@@ -0,0 +1,8 @@
+import frrtest
+
+
+class TestShmRing(frrtest.TestMultiOut):
+    program = "./test_shm_ring"
+
+
+TestShmRing.exit_cleanly()
@@ -48,7 +48,7 @@ static void print_stream(struct stream *s)
 
 int main(void)
 {
-	struct stream *s;
+	struct stream *s, *s2;
 
 	s = stream_new(1024);
 
@@ -68,5 +68,39 @@ int main(void)
 	printfrr("l: 0x%x\n", stream_getl(s));
 	printfrr("q: 0x%" PRIx64 "\n", stream_getq(s));
 
+	/* shared data has to outlive the original stream */
+	stream_set_getp(s, 0);
+	s2 = stream_share(s);
+	stream_free(s);
+
+	stream_forward_getp(s2, 3);
+	print_stream(s2);
+
+	s = stream_share(s2);
+	stream_unshare(&s2);
+	stream_putc_at(s2, 3, 0x42);
+	print_stream(s2);
+	print_stream(s);
+
+	stream_free(s);
+
+	/* slices only see their part of the data */
+	s = stream_slice(s2, 4, 8);
+	stream_free(s2);
+	printfrr("l: 0x%x\n", stream_getl(s));
+	print_stream(s);
+	stream_free(s);
+
+	/* pooled streams get reused, with the size asked for */
+	s = stream_new_pooled(100);
+	s2 = s;
+	stream_putl(s, ham);
+	stream_free(s);
+	s = stream_new_pooled(200);
+	printfrr("pooled: %s, writeable: %zu\n", s == s2 ? "reused" : "new",
+		 STREAM_WRITEABLE(s));
+	stream_free(s);
+	stream_pool_finish();
+
 	return 0;
 }
@@ -490,6 +490,152 @@ static void test_iter_pause(void)
 	route_table_finish(table);
 }
 
+#define LPM_TEST_PREFIXES 20000
+
+static void lpm_test_prefix(struct prefix_ipv4 *p, unsigned int i)
+{
+	memset(p, 0, sizeof(*p));
+	p->family = AF_INET;
+	/* a few short ones, so the index has something to point at */
+	p->prefixlen = (i % 97) ? 12 + random() % 21 : random() % 16;
+	p->prefix.s_addr = random();
+	apply_mask_ipv4(p);
+}
+
+static void lpm_test_add(struct route_table *table, struct prefix_ipv4 *p)
+{
+	struct route_node *rn;
+
+	rn = route_node_get(table, (struct prefix *)p);
+	if (rn->info)
+		route_unlock_node(rn);
+	rn->info = table;
+}
+
+static void lpm_test_del(struct route_table *table, struct prefix_ipv4 *p)
+{
+	struct route_node *rn;
+
+	rn = route_node_lookup(table, (struct prefix *)p);
+	if (!rn)
+		return;
+	rn->info = NULL;
+	route_unlock_node(rn);
+	route_unlock_node(rn);
+}
+
+static void verify_lpm_match(struct route_table *plain,
+			     struct route_table *indexed)
+{
+	struct route_node *rn1, *rn2;
+	struct in_addr addr;
+	int i;
+
+	for (i = 0; i < 100000; i++) {
+		addr.s_addr = random();
+
+		rn1 = route_node_match_ipv4(plain, &addr);
+		rn2 = route_node_match_ipv4(indexed, &addr);
+		assert(!rn1 == !rn2);
+		if (!rn1)
+			continue;
+		assert(!prefix_cmp(&rn1->p, &rn2->p));
+		route_unlock_node(rn1);
+		route_unlock_node(rn2);
+	}
+}
+
+/*
+ * test_lpm_index
+ */
+static void test_lpm_index(void)
+{
+	struct route_table *plain, *indexed;
+	struct prefix_ipv4 *prefixes;
+	int i;
+
+	printf("\n\nTesting route_node_match() with an LPM index\n");
+	srandom(1);
+
+	plain = route_table_init();
+	indexed = route_table_init();
+	route_table_enable_lpm_index(indexed);
+
+	prefixes = calloc(LPM_TEST_PREFIXES, sizeof(*prefixes));
+	assert(prefixes);
+	for (i = 0; i < LPM_TEST_PREFIXES; i++) {
+		lpm_test_prefix(&prefixes[i], i);
+		lpm_test_add(plain, &prefixes[i]);
+		lpm_test_add(indexed, &prefixes[i]);
+	}
+	assert(indexed->lpm);
+	verify_lpm_match(plain, indexed);
+
+	/* deleting has to leave the index pointing at live nodes */
+	for (i = 0; i < LPM_TEST_PREFIXES; i += 2) {
+		lpm_test_del(plain, &prefixes[i]);
+		lpm_test_del(indexed, &prefixes[i]);
+	}
+	verify_lpm_match(plain, indexed);
+
+	for (i = 0; i < LPM_TEST_PREFIXES; i++) {
+		lpm_test_del(plain, &prefixes[i]);
+		lpm_test_del(indexed, &prefixes[i]);
+	}
+	assert(plain->top == NULL && indexed->top == NULL);
+
+	free(prefixes);
+	route_table_finish(plain);
+	route_table_finish(indexed);
+	printf("Verified LPM index\n");
+}
+
+/*
+ * test_small_lookup
+ *
+ * Lookups in small tables walk the tree instead of using the hash, check
+ * that they find the same before and after the table grows past that.
+ */
+static void test_small_lookup(void)
+{
+	struct route_table *table;
+	struct prefix_ipv4 prefixes[64];
+	struct route_node *rn;
+	int i, j;
+
+	printf("\n\nTesting route_node_lookup() on small tables\n");
+
+	table = route_table_init();
+	memset(prefixes, 0, sizeof(prefixes));
+	for (i = 0; i < 64; i++) {
+		/* all distinct, the first covering the others */
+		prefixes[i].family = AF_INET;
+		prefixes[i].prefixlen = i ? 20 + i % 13 : 8;
+		prefixes[i].prefix.s_addr = htonl(0x0a000000 | (i << 12));
+		apply_mask_ipv4(&prefixes[i]);
+	}
+
+	for (i = 0; i < 64; i++) {
+		lpm_test_add(table, &prefixes[i]);
+
+		for (j = 0; j < 64; j++) {
+			rn = route_node_lookup(table,
+					       (struct prefix *)&prefixes[j]);
+			assert(!rn == (j > i));
+			if (rn)
+				route_unlock_node(rn);
+		}
+	}
+	assert(table->hashed);
+
+	for (i = 0; i < 64; i++)
+		lpm_test_del(table, &prefixes[i]);
+	assert(table->top == NULL);
+
+	route_table_finish(table);
+	printf("Verified small table lookups\n");
+}
+
 /*
  * run_tests
  */
@@ -498,6 +644,8 @@ static void run_tests(void)
 	test_prefix_iter_cmp();
 	test_get_next();
 	test_iter_pause();
+	test_lpm_index();
+	test_small_lookup();
 }
 
 /*
@@ -70,6 +70,8 @@
 #define _T_SKIPLIST_NONUNIQ	(T_SORTED)
 #define _T_RBTREE_UNIQ		(T_SORTED | T_UNIQ)
 #define _T_RBTREE_NONUNIQ	(T_SORTED)
+#define _T_BPTREE_UNIQ		(T_SORTED | T_UNIQ)
+#define _T_BPTREE_NONUNIQ	(T_SORTED)
 #define _T_ATOMSORT_UNIQ	(T_SORTED | T_UNIQ | T_ATOMIC)
 #define _T_ATOMSORT_NONUNIQ	(T_SORTED          | T_ATOMIC)
 
@@ -140,6 +142,12 @@ static void ts_end(void)
 #define TYPE RBTREE_NONUNIQ
 #include "test_typelist.h"
 
+#define TYPE BPTREE_UNIQ
+#include "test_typelist.h"
+
+#define TYPE BPTREE_NONUNIQ
+#include "test_typelist.h"
+
 #define TYPE ATOMSORT_UNIQ
 #include "test_typelist.h"
 
@@ -162,6 +170,8 @@ int main(int argc, char **argv)
 	test_SKIPLIST_NONUNIQ();
 	test_RBTREE_UNIQ();
 	test_RBTREE_NONUNIQ();
+	test_BPTREE_UNIQ();
+	test_BPTREE_NONUNIQ();
 	test_ATOMSORT_UNIQ();
 	test_ATOMSORT_NONUNIQ();
 
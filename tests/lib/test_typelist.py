@@ -17,5 +17,7 @@ TestTypelist.onesimple("SKIPLIST_UNIQ end")
 TestTypelist.onesimple("SKIPLIST_NONUNIQ end")
 TestTypelist.onesimple("RBTREE_UNIQ end")
 TestTypelist.onesimple("RBTREE_NONUNIQ end")
+TestTypelist.onesimple("BPTREE_UNIQ end")
+TestTypelist.onesimple("BPTREE_NONUNIQ end")
 TestTypelist.onesimple("ATOMSORT_UNIQ end")
 TestTypelist.onesimple("ATOMSORT_NONUNIQ end")
@@ -0,0 +1,632 @@
+#!/usr/bin/env python3
+#
+# Feed a table into bgpd and time how long it takes to come back out.
+# Copyright (C) 2026  The FRRouting Project
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 2
+# of the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; see the file COPYING; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+#
+
+"""
+Full-table convergence benchmark for bgpd.
+
+One feeder session sends the routes from an MRT dump (TABLE_DUMP_V2 RIBs or
+BGP4MP_MESSAGE_AS4 updates, as written by "dump bgp") or a synthetic table
+as fast as bgpd will take them; N receiver sessions count what bgpd sends
+back out.  The sessions are opened from the given local addresses, so bgpd
+needs a neighbor for each of them.  The result is printed as JSON.
+"""
+
+import argparse
+import ipaddress
+import json
+import select
+import socket
+import struct
+import subprocess
+import sys
+import threading
+import time
+
+BGP_OPEN = 1
+BGP_UPDATE = 2
+BGP_NOTIFY = 3
+BGP_KEEPALIVE = 4
+
+ATTR_ORIGIN = 1
+ATTR_AS_PATH = 2
+ATTR_NEXT_HOP = 3
+ATTR_MP_REACH = 14
+ATTR_MP_UNREACH = 15
+ATTR_FLAG_EXTLEN = 0x10
+
+AS_SEQUENCE = 2
+AS_TRANS = 23456
+
+# bgpd/bgp_dump.h
+MRT_BGP4MP = 16
+MRT_BGP4MP_ET = 17
+MRT_TABLE_DUMP_V2 = 13
+BGP4MP_MESSAGE_AS4 = 4
+TDV2_RIB_IPV4_UNICAST = 2
+TDV2_RIB_IPV6_UNICAST = 4
+TDV2_RIB_IPV4_UNICAST_ADDPATH = 8
+TDV2_RIB_IPV6_UNICAST_ADDPATH = 10
+
+MAX_UPDATE = 4096
+
+
+class BenchError(Exception):
+    pass
+
+
+def bgp_msg(mtype, body):
+    return b"\xff" * 16 + struct.pack("!HB", 19 + len(body), mtype) + body
+
+
+def bgp_attr(flags, atype, value):
+    if len(value) > 255:
+        return struct.pack("!BBH", flags | ATTR_FLAG_EXTLEN, atype, len(value)) + value
+    return struct.pack("!BBB", flags & ~ATTR_FLAG_EXTLEN, atype, len(value)) + value
+
+
+def parse_attrs(data):
+    """[(flags, type, value)] of a path attribute blob"""
+    attrs, pos = [], 0
+    while pos < len(data):
+        flags, atype = data[pos], data[pos + 1]
+        if flags & ATTR_FLAG_EXTLEN:
+            (alen,) = struct.unpack_from("!H", data, pos + 2)
+            pos += 4
+        else:
+            alen = data[pos + 2]
+            pos += 3
+        attrs.append((flags & ~ATTR_FLAG_EXTLEN, atype, data[pos : pos + alen]))
+        pos += alen
+    return attrs
+
+
+def parse_nlri(data):
+    out, pos = [], 0
+    while pos < len(data):
+        plen = data[pos]
+        nbytes = (plen + 7) // 8
+        out.append(data[pos : pos + 1 + nbytes])
+        pos += 1 + nbytes
+    return out
+
+
+class Table:
+    """
+    Routes to feed: {(afi, attrs, nexthop6): [nlri, ...]}, where attrs is the
+    attribute blob without NEXT_HOP / MP_REACH and nlri is the wire encoding
+    of one prefix.
+    """
+
+    def __init__(self):
+        self.groups = {}
+        self.count = 0
+        self.skipped = 0
+
+    def add(self, afi, attrs, nlri, nexthop6=b""):
+        self.groups.setdefault((afi, attrs, nexthop6), []).append(nlri)
+        self.count += 1
+
+    def afis(self):
+        return sorted(set(k[0] for k in self.groups))
+
+    def add_path(self, afi, nlri, attrs, nexthop6=None):
+        kept = []
+        for flags, atype, value in parse_attrs(attrs):
+            if atype == ATTR_NEXT_HOP:
+                continue
+            if atype == ATTR_MP_REACH:
+                # RFC 6396 abbreviates this to next hop length and next hop;
+                # bgpd's own dumps have the full attribute
+                if value[0] + 1 == len(value):
+                    nh = value[1:]
+                else:
+                    nh = value[4 : 4 + value[3]]
+                if nexthop6 is None:
+                    nexthop6 = nh
+                continue
+            kept.append(bgp_attr(flags, atype, value))
+        self.add(afi, b"".join(kept), nlri, nexthop6 if afi == 2 else b"")
+
+    def load_mrt(self, path, peer_index):
+        with open(path, "rb") as fd:
+            data = fd.read()
+
+        pos = 0
+        while pos + 12 <= len(data):
+            _, mtype, subtype, mlen = struct.unpack_from("!IHHI", data, pos)
+            body = data[pos + 12 : pos + 12 + mlen]
+            pos += 12 + mlen
+
+            if mtype == MRT_TABLE_DUMP_V2:
+                self._load_rib(subtype, body, peer_index)
+            elif mtype in (MRT_BGP4MP, MRT_BGP4MP_ET):
+                if mtype == MRT_BGP4MP_ET:
+                    body = body[4:]
+                self._load_bgp4mp(subtype, body)
+            else:
+                self.skipped += 1
+
+    def _load_rib(self, subtype, body, peer_index):
+        if subtype in (TDV2_RIB_IPV4_UNICAST, TDV2_RIB_IPV4_UNICAST_ADDPATH):
+            afi = 1
+        elif subtype in (TDV2_RIB_IPV6_UNICAST, TDV2_RIB_IPV6_UNICAST_ADDPATH):
+            afi = 2
+        else:
+            return
+        addpath = subtype >= TDV2_RIB_IPV4_UNICAST_ADDPATH
+
+        plen = body[4]
+        nbytes = (plen + 7) // 8
+        nlri = body[4 : 5 + nbytes]
+        pos = 5 + nbytes
+        (count,) = struct.unpack_from("!H", body, pos)
+        pos += 2
+
+        for i in range(count):
+            (idx,) = struct.unpack_from("!H", body, pos)
+            pos += 6 + (4 if addpath else 0)
+            (alen,) = struct.unpack_from("!H", body, pos)
+            attrs = body[pos + 2 : pos + 2 + alen]
+            pos += 2 + alen
+
+            if idx == peer_index or (peer_index < 0 and i == 0):
+                self.add_path(afi, nlri, attrs)
+                return
+        self.skipped += 1
+
+    def _load_bgp4mp(self, subtype, body):
+        if subtype != BGP4MP_MESSAGE_AS4:
+            self.skipped += 1
+            return
+
+        (afi,) = struct.unpack_from("!H", body, 10)
+        pos = 12 + (8 if afi == 1 else 32)
+        msg = body[pos:]
+        if len(msg) < 19 or msg[18] != BGP_UPDATE:
+            return
+
+        msg = msg[19:]
+        (wlen,) = struct.unpack_from("!H", msg, 0)
+        (alen,) = struct.unpack_from("!H", msg, 2 + wlen)
+        attrs = msg[4 + wlen : 4 + wlen + alen]
+
+        for nlri in parse_nlri(msg[4 + wlen + alen :]):
+            self.add_path(1, nlri, attrs)
+
+        for flags, atype, value in parse_attrs(attrs):
+            if atype != ATTR_MP_REACH:
+                continue
+            mafi, safi, nhlen = struct.unpack_from("!HBB", value, 0)
+            if mafi != 2 or safi != 1:
+                continue
+            nh = value[4 : 4 + nhlen]
+            for nlri in parse_nlri(value[5 + nhlen :]):
+                self.add_path(2, nlri, attrs, nh)
+
+    def load_synthetic(self, count, paths):
+        base = int(ipaddress.IPv4Address("16.0.0.0"))
+        for i in range(count):
+            path = struct.pack("!BBI", AS_SEQUENCE, 1, 4200000000 + i % paths)
+            attrs = bgp_attr(0x40, ATTR_ORIGIN, b"\0") + bgp_attr(
+                0x40, ATTR_AS_PATH, path
+            )
+            nlri = struct.pack("!B", 24) + struct.pack("!I", base + (i << 8))[:3]
+            self.add(1, attrs, nlri)
+
+
+def prepend_as(attrs, asn):
+    """eBGP wants our AS first in the path"""
+    out = []
+    for flags, atype, value in parse_attrs(attrs):
+        if atype == ATTR_AS_PATH:
+            if value and value[0] == AS_SEQUENCE and value[1] < 255:
+                value = (
+                    struct.pack("!BBI", AS_SEQUENCE, value[1] + 1, asn) + value[2:]
+                )
+            else:
+                value = struct.pack("!BBI", AS_SEQUENCE, 1, asn) + value
+        out.append(bgp_attr(flags, atype, value))
+    return b"".join(out)
+
+
+def encode_updates(table, asn, ebgp, nexthop4, nexthop6):
+    """the UPDATE messages for the table, and the matching withdrawals"""
+    updates, withdrawals = [], []
+
+    for (afi, attrs, nh6), nlris in table.groups.items():
+        if ebgp:
+            attrs = prepend_as(attrs, asn)
+        if afi == 2:
+            nh6 = nexthop6 or nh6
+            if not nh6:
+                table.skipped += len(nlris)
+                continue
+
+        room = MAX_UPDATE - 19 - 4 - len(attrs) - 64
+        if room < 64:
+            table.skipped += len(nlris)
+            continue
+
+        chunk, size = [], 0
+        for nlri in nlris + [None]:
+            if nlri is not None and size + len(nlri) <= room:
+                chunk.append(nlri)
+                size += len(nlri)
+                continue
+            if chunk:
+                blob = b"".join(chunk)
+                if afi == 1:
+                    pattrs = attrs + bgp_attr(0x40, ATTR_NEXT_HOP, nexthop4)
+                    body = struct.pack("!HH", 0, len(pattrs)) + pattrs + blob
+                    wbody = struct.pack("!H", len(blob)) + blob + b"\0\0"
+                else:
+                    mp = struct.pack("!HBB", 2, 1, len(nh6)) + nh6 + b"\0" + blob
+                    pattrs = attrs + bgp_attr(0x80, ATTR_MP_REACH, mp)
+                    body = struct.pack("!HH", 0, len(pattrs)) + pattrs
+                    unreach = bgp_attr(0x80, ATTR_MP_UNREACH, b"\0\2\1" + blob)
+                    wbody = struct.pack("!HH", 0, len(unreach)) + unreach
+                updates.append(bgp_msg(BGP_UPDATE, body))
+                withdrawals.append(bgp_msg(BGP_UPDATE, wbody))
+            if nlri is not None:
+                chunk, size = [nlri], len(nlri)
+
+    return updates, withdrawals
+
+
+def end_of_rib(afi):
+    if afi == 1:
+        return bgp_msg(BGP_UPDATE, b"\0\0\0\0")
+    unreach = bgp_attr(0x80, ATTR_MP_UNREACH, struct.pack("!HB", afi, 1))
+    return bgp_msg(BGP_UPDATE, struct.pack("!HH", 0, len(unreach)) + unreach)
+
+
+class Session:
+    def __init__(self, name, local, asn, args, afis):
+        self.name = name
+        self.local = local
+        self.asn = asn
+        self.args = args
+        self.afis = afis
+        self.lock = threading.Lock()
+        self.buf = b""
+        self.sock = None
+
+    def connect(self):
+        family = socket.AF_INET6 if ":" in self.args.target else socket.AF_INET
+        self.sock = socket.socket(family, socket.SOCK_STREAM)
+        self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_SNDBUF, 4 << 20)
+        self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, 4 << 20)
+        self.sock.bind((self.local, 0))
+        self.sock.connect((self.args.target, self.args.port))
+
+        asn = self.asn
+        caps = b"".join(
+            struct.pack("!BBHBB", 1, 4, afi, 0, 1) for afi in self.afis
+        ) + struct.pack("!BBI", 65, 4, asn)
+        opt = struct.pack("!BB", 2, len(caps)) + caps
+        rid = socket.inet_aton(self.args.router_id or self.local)
+        body = struct.pack("!BHH", 4, asn if asn < 65536 else AS_TRANS, 180)
+        self.send(bgp_msg(BGP_OPEN, body + rid + struct.pack("!B", len(opt)) + opt))
+
+        mtype, _ = self.recv(timeout=30)
+        if mtype != BGP_OPEN:
+            raise BenchError("%s: expected OPEN, got %d" % (self.name, mtype))
+        self.send(bgp_msg(BGP_KEEPALIVE, b""))
+        mtype, _ = self.recv(timeout=30)
+        if mtype != BGP_KEEPALIVE:
+            raise BenchError("%s: expected KEEPALIVE, got %d" % (self.name, mtype))
+
+        threading.Thread(target=self._keepalive, daemon=True).start()
+
+    def _keepalive(self):
+        while True:
+            time.sleep(30)
+            try:
+                self.send(bgp_msg(BGP_KEEPALIVE, b""))
+            except OSError:
+                return
+
+    def send(self, data):
+        with self.lock:
+            self.sock.sendall(data)
+
+    def recv(self, timeout=None):
+        """(type, body) of the next message, None on timeout"""
+        while True:
+            if len(self.buf) >= 19:
+                (mlen,) = struct.unpack_from("!H", self.buf, 16)
+                if len(self.buf) >= mlen:
+                    mtype, body = self.buf[18], self.buf[19:mlen]
+                    self.buf = self.buf[mlen:]
+                    if mtype == BGP_NOTIFY:
+                        raise BenchError(
+                            "%s: NOTIFICATION %d/%d"
+                            % (self.name, body[0], body[1] if len(body) > 1 else 0)
+                        )
+                    return mtype, body
+            if timeout is not None:
+                ready, _, _ = select.select([self.sock], [], [], timeout)
+                if not ready:
+                    return None, None
+            data = self.sock.recv(1 << 20)
+            if not data:
+                raise BenchError("%s: connection closed" % self.name)
+            self.buf += data
+
+    def close(self):
+        if self.sock:
+            self.sock.close()
+
+
+class Receiver(Session):
+    """counts the prefixes bgpd announces and withdraws to us"""
+
+    def __init__(self, name, local, asn, args, afis):
+        super().__init__(name, local, asn, args, afis)
+        self.cond = threading.Condition()
+        self.have = set()
+        self.updates = 0
+        self.nlri = 0
+        self.last = None
+        self.error = None
+
+    def start(self):
+        threading.Thread(target=self._run, daemon=True).start()
+
+    def _run(self):
+        try:
+            while True:
+                mtype, body = self.recv()
+                if mtype == BGP_UPDATE:
+                    self._update(body)
+        except (BenchError, OSError) as e:
+            with self.cond:
+                self.error = str(e)
+                self.cond.notify_all()
+
+    def _update(self, body):
+        (wlen,) = struct.unpack_from("!H", body, 0)
+        (alen,) = struct.unpack_from("!H", body, 2 + wlen)
+        attrs = body[4 + wlen : 4 + wlen + alen]
+        add = [(1, n) for n in parse_nlri(body[4 + wlen + alen :])]
+        withdraw = [(1, n) for n in parse_nlri(body[2 : 2 + wlen])]
+
+        for _, atype, value in parse_attrs(attrs):
+            if atype == ATTR_MP_REACH:
+                (afi,) = struct.unpack_from("!H", value, 0)
+                nhlen = value[3]
+                add += [(afi, n) for n in parse_nlri(value[5 + nhlen :])]
+            elif atype == ATTR_MP_UNREACH:
+                (afi,) = struct.unpack_from("!H", value, 0)
+                withdraw += [(afi, n) for n in parse_nlri(value[3:])]
+
+        with self.cond:
+            self.updates += 1
+            self.nlri += len(add) + len(withdraw)
+            self.have.update(add)
+            self.have.difference_update(withdraw)
+            self.last = time.monotonic()
+            self.cond.notify_all()
+
+    def reset(self):
+        with self.cond:
+            self.updates = self.nlri = 0
+            self.last = None
+
+    def wait(self, pred, timeout):
+        """wait for pred(len(self.have)) or for things to go quiet"""
+        begin = time.monotonic()
+        with self.cond:
+            while not pred(len(self.have)) and not self.error:
+                idle = time.monotonic() - max(self.last or begin, begin)
+                if idle > timeout:
+                    break
+                self.cond.wait(1)
+            return pred(len(self.have))
+
+
+def rss_kib(pid):
+    """(VmRSS, VmHWM) of a process, in KiB"""
+    if not pid:
+        return None, None
+    vals = {}
+    with open("/proc/%d/status" % pid) as fd:
+        for line in fd:
+            key, _, val = line.partition(":")
+            if key in ("VmRSS", "VmHWM"):
+                vals[key] = int(val.split()[0])
+    return vals.get("VmRSS"), vals.get("VmHWM")
+
+
+def accepted(args, peer):
+    """prefixes bgpd has accepted from the feeder, over all address families"""
+    total = 0
+    for afi in ("ipv4", "ipv6"):
+        out = subprocess.run(
+            [args.vtysh, "-c", "show bgp %s unicast summary json" % afi],
+            stdout=subprocess.PIPE,
+            check=True,
+        ).stdout
+        peers = json.loads(out or b"{}").get("peers", {})
+        total += peers.get(peer, {}).get("pfxRcd", 0)
+    return total
+
+
+def rate(count, secs):
+    return round(count / secs) if secs > 0 else None
+
+
+def run(args):
+    table = Table()
+    if args.mrt:
+        table.load_mrt(args.mrt, args.mrt_peer)
+    else:
+        table.load_synthetic(args.synthetic, args.paths)
+    if not table.count:
+        raise BenchError("nothing to feed")
+
+    afis = table.afis()
+    ebgp = args.local_as != args.remote_as
+    nexthop4 = socket.inet_aton(args.next_hop or args.feeder)
+    nexthop6 = ipaddress.IPv6Address(args.next_hop6).packed if args.next_hop6 else b""
+
+    updates, withdrawals = encode_updates(table, args.local_as, ebgp, nexthop4, nexthop6)
+    feed = b"".join(updates) + b"".join(end_of_rib(afi) for afi in afis)
+    nprefixes = table.count - table.skipped
+    result = {
+        "prefixes": nprefixes,
+        "skipped": table.skipped,
+        "updates": len(updates),
+        "bytes": len(feed),
+    }
+
+    receivers = [
+        Receiver("receiver %s" % addr, addr, args.receiver_as, args, afis)
+        for addr in args.receiver
+    ]
+    for r in receivers:
+        r.connect()
+        r.start()
+    # whatever bgpd has already, so only the feeder's routes are counted
+    for r in receivers:
+        r.wait(lambda n: False, 2)
+    base = [len(r.have) for r in receivers]
+
+    pid = args.pid
+    if args.pidfile:
+        with open(args.pidfile) as fd:
+            pid = int(fd.read().strip())
+    result["rss_kib_start"] = rss_kib(pid)[0]
+
+    feeder = Session("feeder", args.feeder, args.local_as, args, afis)
+    feeder.connect()
+
+    for r in receivers:
+        r.reset()
+
+    start = time.monotonic()
+    feeder.send(feed)
+    sent = time.monotonic() - start
+    result["feed"] = {"seconds": round(sent, 6), "prefixes_per_sec": rate(nprefixes, sent)}
+
+    if args.vtysh:
+        while accepted(args, args.feeder) < nprefixes:
+            if time.monotonic() - start > args.timeout:
+                break
+            time.sleep(0.05)
+        secs = time.monotonic() - start
+        result["ingest"] = {
+            "seconds": round(secs, 6),
+            "prefixes_per_sec": rate(nprefixes, secs),
+        }
+
+    result["receivers"] = []
+    for r, b in zip(receivers, base):
+        done = r.wait(lambda n, b=b: n >= b + nprefixes, args.timeout)
+        secs = (r.last or start) - start
+        result["receivers"].append(
+            {
+                "address": r.local,
+                "complete": done,
+                "prefixes": len(r.have) - b,
+                "updates": r.updates,
+                "seconds": round(secs, 6),
+                "prefixes_per_sec": rate(r.nlri, secs),
+                "updates_per_sec": rate(r.updates, secs),
+                "error": r.error,
+            }
+        )
+
+    if args.withdraw:
+        for r in receivers:
+            r.reset()
+        start = time.monotonic()
+        feeder.send(b"".join(withdrawals))
+        result["withdraw"] = []
+        for r, b in zip(receivers, base):
+            done = r.wait(lambda n, b=b: n <= b, args.timeout)
+            secs = (r.last or start) - start
+            result["withdraw"].append(
+                {
+                    "address": r.local,
+                    "complete": done,
+                    "seconds": round(secs, 6),
+                    "prefixes_per_sec": rate(r.nlri, secs),
+                }
+            )
+
+    result["rss_kib_end"], result["rss_kib_peak"] = rss_kib(pid)
+
+    feeder.close()
+    for r in receivers:
+        r.close()
+    return result
+
+
+def main():
+    argp = argparse.ArgumentParser(description=__doc__)
+    argp.add_argument("-t", "--target", default="127.0.0.1", help="bgpd address")
+    argp.add_argument("-p", "--port", type=int, default=179)
+    argp.add_argument("--local-as", type=int, default=65001, help="feeder AS")
+    argp.add_argument("--receiver-as", type=int, default=65002, help="receiver AS")
+    argp.add_argument("--remote-as", type=int, default=65000, help="bgpd's AS")
+    argp.add_argument("--router-id", help="our router-id (default: local address)")
+    argp.add_argument("-f", "--feeder", required=True, help="feeder local address")
+    argp.add_argument(
+        "-r", "--receiver", action="append", default=[], help="receiver local address"
+    )
+    src = argp.add_mutually_exclusive_group(required=True)
+    src.add_argument("-m", "--mrt", help="MRT file to replay")
+    src.add_argument(
+        "-s", "--synthetic", type=int, help="feed this many synthetic IPv4 /24s"
+    )
+    argp.add_argument(
+        "--paths", type=int, default=1000, help="distinct AS paths for --synthetic"
+    )
+    argp.add_argument(
+        "--mrt-peer",
+        type=int,
+        default=-1,
+        help="TABLE_DUMP_V2 peer index to use (default: first entry)",
+    )
+    argp.add_argument("--next-hop", help="IPv4 next hop (default: feeder address)")
+    argp.add_argument("--next-hop6", help="IPv6 next hop (default: from the MRT file)")
+    argp.add_argument("--withdraw", action="store_true", help="time withdrawing too")
+    argp.add_argument("--pid", type=int, help="bgpd pid, for memory usage")
+    argp.add_argument("--pidfile", help="bgpd pid file, for memory usage")
+    argp.add_argument("--vtysh", help="vtysh binary, to time the ingest in bgpd")
+    argp.add_argument(
+        "--timeout", type=float, default=60, help="give up after this long idle"
+    )
+    args = argp.parse_args()
+
+    try:
+        result = run(args)
+    except (BenchError, OSError) as e:
+        sys.stderr.write("%s\n" % e)
+        return 1
+
+    json.dump(result, sys.stdout, indent=2)
+    sys.stdout.write("\n")
+    return 0 if all(r["complete"] for r in result["receivers"]) else 2
+
+
+if __name__ == "__main__":
+    sys.exit(main())
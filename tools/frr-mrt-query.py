@@ -0,0 +1,338 @@
+#!/usr/bin/env python3
+#
+# Query the RIB dumps written by "dump bgp routes-mrt".
+# Copyright (C) 2026  The FRRouting Project
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 2
+# of the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; see the file COPYING; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+#
+
+"""
+Run longer-prefixes, community and AS path queries against an MRT
+TABLE_DUMP_V2 file (RFC 6396) written by bgpd, instead of against the
+running daemon.  The AS path regular expressions use the same "_" shorthand
+as "bgp as-path access-list".
+"""
+
+import argparse
+import ipaddress
+import json
+import mmap
+import re
+import struct
+import sys
+
+MRT_HDR = ">IHHI"
+MSG_TABLE_DUMP_V2 = 13
+
+PEER_INDEX_TABLE = 1
+# subtype: (afi, addpath)
+RIB_SUBTYPES = {
+    2: (4, False),
+    4: (6, False),
+    8: (4, True),
+    10: (6, True),
+}
+
+ATTR_ORIGIN = 1
+ATTR_AS_PATH = 2
+ATTR_NEXT_HOP = 3
+ATTR_MED = 4
+ATTR_LOCAL_PREF = 5
+ATTR_COMMUNITIES = 8
+ATTR_MP_REACH_NLRI = 14
+ATTR_LARGE_COMMUNITIES = 32
+
+ORIGINS = ["i", "e", "?"]
+WELL_KNOWN_COMMUNITIES = {
+    "internet": 0,
+    "graceful-shutdown": 0xFFFF0000,
+    "accept-own": 0xFFFF0001,
+    "blackhole": 0xFFFF029A,
+    "no-export": 0xFFFFFF01,
+    "no-advertise": 0xFFFFFF02,
+    "local-AS": 0xFFFFFF03,
+    "no-peer": 0xFFFFFF04,
+}
+
+
+class MrtError(Exception):
+    pass
+
+
+def parse_community(text):
+    if text in WELL_KNOWN_COMMUNITIES:
+        return WELL_KNOWN_COMMUNITIES[text]
+    try:
+        high, low = text.split(":")
+        return (int(high) << 16) | int(low)
+    except ValueError:
+        raise argparse.ArgumentTypeError("bad community %r" % text)
+
+
+def parse_large_community(text):
+    try:
+        return tuple(int(v) for v in text.split(":", 2))
+    except ValueError:
+        raise argparse.ArgumentTypeError("bad large community %r" % text)
+
+
+def aspath_regex(text):
+    # same expansion as bgp_regcomp()
+    return re.compile(text.replace("_", "(^|[,{}() ]|$)"))
+
+
+def format_aspath(segments):
+    out = []
+    for stype, asns in segments:
+        if stype == 1:
+            out.append("{%s}" % ",".join(str(a) for a in asns))
+        else:
+            out.extend(str(a) for a in asns)
+    return " ".join(out)
+
+
+def format_community(val):
+    for name, wk in WELL_KNOWN_COMMUNITIES.items():
+        if val == wk:
+            return name
+    return "%d:%d" % (val >> 16, val & 0xFFFF)
+
+
+class Path:
+    def __init__(self, peer, originated, path_id, attrs, afi):
+        self.peer = peer
+        self.originated = originated
+        self.path_id = path_id
+        self.origin = None
+        self.segments = []
+        self.nexthop = None
+        self.med = None
+        self.local_pref = None
+        self.communities = []
+        self.large_communities = []
+        self.parse_attrs(attrs, afi)
+        self.aspath = format_aspath(self.segments)
+
+    def parse_attrs(self, data, afi):
+        pos = 0
+        while pos < len(data):
+            flags, atype = data[pos], data[pos + 1]
+            if flags & 0x10:
+                (alen,) = struct.unpack_from(">H", data, pos + 2)
+                pos += 4
+            else:
+                alen = data[pos + 2]
+                pos += 3
+            val = data[pos : pos + alen]
+            pos += alen
+
+            if atype == ATTR_ORIGIN and alen == 1:
+                self.origin = val[0]
+            elif atype == ATTR_AS_PATH:
+                vpos = 0
+                while vpos + 2 <= alen:
+                    stype, count = val[vpos], val[vpos + 1]
+                    asns = struct.unpack_from(">%dI" % count, val, vpos + 2)
+                    self.segments.append((stype, asns))
+                    vpos += 2 + 4 * count
+            elif atype == ATTR_NEXT_HOP and alen == 4:
+                self.nexthop = ipaddress.IPv4Address(val)
+            elif atype == ATTR_MED and alen == 4:
+                (self.med,) = struct.unpack(">I", val)
+            elif atype == ATTR_LOCAL_PREF and alen == 4:
+                (self.local_pref,) = struct.unpack(">I", val)
+            elif atype == ATTR_COMMUNITIES:
+                self.communities = list(struct.unpack(">%dI" % (alen // 4), val))
+            elif atype == ATTR_LARGE_COMMUNITIES:
+                vals = struct.unpack(">%dI" % (alen // 4), val)
+                self.large_communities = [
+                    tuple(vals[i : i + 3]) for i in range(0, len(vals), 3)
+                ]
+            elif atype == ATTR_MP_REACH_NLRI and alen > 1:
+                # MRT abbreviates this to the next hop length and next hops
+                nhlen = val[0]
+                if afi == 6 and nhlen >= 16:
+                    self.nexthop = ipaddress.IPv6Address(val[1:17])
+                elif afi == 4 and nhlen >= 4:
+                    self.nexthop = ipaddress.IPv4Address(val[1:5])
+
+    def as_dict(self):
+        return {
+            "peer": str(self.peer[0]),
+            "peerAs": self.peer[1],
+            "originated": self.originated,
+            "pathId": self.path_id,
+            "nexthop": str(self.nexthop) if self.nexthop else None,
+            "med": self.med,
+            "localPref": self.local_pref,
+            "path": self.aspath,
+            "origin": ORIGINS[self.origin] if self.origin is not None else None,
+            "community": [format_community(c) for c in self.communities],
+            "largeCommunity": ["%d:%d:%d" % lc for lc in self.large_communities],
+        }
+
+
+class MrtRibFile:
+    def __init__(self, data):
+        self.data = data
+        self.peers = []
+
+    def records(self):
+        hdrlen = struct.calcsize(MRT_HDR)
+        pos = 0
+        while pos + hdrlen <= len(self.data):
+            _, mtype, subtype, length = struct.unpack_from(MRT_HDR, self.data, pos)
+            body = pos + hdrlen
+            if body + length > len(self.data):
+                raise MrtError("truncated record at %d" % pos)
+            pos = body + length
+
+            if mtype != MSG_TABLE_DUMP_V2:
+                continue
+            if subtype == PEER_INDEX_TABLE:
+                self.parse_peers(body)
+            elif subtype in RIB_SUBTYPES:
+                yield self.parse_rib(body, *RIB_SUBTYPES[subtype])
+
+    def parse_peers(self, pos):
+        (namelen,) = struct.unpack_from(">H", self.data, pos + 4)
+        pos += 6 + namelen
+        (count,) = struct.unpack_from(">H", self.data, pos)
+        pos += 2
+
+        self.peers = []
+        for _ in range(count):
+            ptype = self.data[pos]
+            pos += 5
+            if ptype & 1:
+                addr = ipaddress.IPv6Address(self.data[pos : pos + 16])
+                pos += 16
+            else:
+                addr = ipaddress.IPv4Address(self.data[pos : pos + 4])
+                pos += 4
+            if ptype & 2:
+                (asn,) = struct.unpack_from(">I", self.data, pos)
+                pos += 4
+            else:
+                (asn,) = struct.unpack_from(">H", self.data, pos)
+                pos += 2
+            self.peers.append((addr, asn))
+
+    def parse_rib(self, pos, afi, addpath):
+        plen = self.data[pos + 4]
+        pos += 5
+        nbytes = (plen + 7) // 8
+        size = 4 if afi == 4 else 16
+        raw = bytes(self.data[pos : pos + nbytes]) + b"\0" * (size - nbytes)
+        pos += nbytes
+        if afi == 4:
+            prefix = ipaddress.IPv4Network((raw, plen), strict=False)
+        else:
+            prefix = ipaddress.IPv6Network((raw, plen), strict=False)
+
+        (count,) = struct.unpack_from(">H", self.data, pos)
+        pos += 2
+
+        def paths(pos=pos):
+            for _ in range(count):
+                peer_index, originated = struct.unpack_from(">HI", self.data, pos)
+                pos += 6
+                path_id = None
+                if addpath:
+                    (path_id,) = struct.unpack_from(">I", self.data, pos)
+                    pos += 4
+                (alen,) = struct.unpack_from(">H", self.data, pos)
+                pos += 2
+                attrs = self.data[pos : pos + alen]
+                pos += alen
+                if peer_index >= len(self.peers):
+                    raise MrtError("unknown peer index %d" % peer_index)
+                yield Path(self.peers[peer_index], originated, path_id, attrs, afi)
+
+        return prefix, paths
+
+
+def main():
+    argp = argparse.ArgumentParser(description=__doc__)
+    argp.add_argument("-p", "--prefix", type=ipaddress.ip_network,
+                      help="only this prefix")
+    argp.add_argument("-l", "--longer-prefixes", action="store_true",
+                      help="also the prefixes covered by --prefix")
+    argp.add_argument("-c", "--community", type=parse_community,
+                      action="append", default=[],
+                      help="paths carrying this community (repeatable)")
+    argp.add_argument("-L", "--large-community", type=parse_large_community,
+                      action="append", default=[],
+                      help="paths carrying this large community (repeatable)")
+    argp.add_argument("-r", "--regexp", type=aspath_regex,
+                      help="paths whose AS path matches this expression")
+    argp.add_argument("-j", "--json", action="store_true", help="JSON output")
+    argp.add_argument("dumpfile", help="routes-mrt dump file")
+    args = argp.parse_args()
+
+    def want_prefix(prefix):
+        if not args.prefix:
+            return True
+        if prefix.version != args.prefix.version:
+            return False
+        if args.longer_prefixes:
+            return prefix.subnet_of(args.prefix)
+        return prefix == args.prefix
+
+    def want_path(path):
+        if any(c not in path.communities for c in args.community):
+            return False
+        if any(lc not in path.large_communities for lc in args.large_community):
+            return False
+        if args.regexp and not args.regexp.search(path.aspath):
+            return False
+        return True
+
+    with open(args.dumpfile, "rb") as fd:
+        data = mmap.mmap(fd.fileno(), 0, access=mmap.ACCESS_READ)
+
+    result = {}
+    if not args.json:
+        sys.stdout.write("%-43s %-39s %10s %6s %s\n" % (
+            "Network", "Next Hop", "Metric", "LocPrf", "Path"))
+
+    try:
+        for prefix, paths in MrtRibFile(data).records():
+            if not want_prefix(prefix):
+                continue
+            for path in paths():
+                if not want_path(path):
+                    continue
+                if args.json:
+                    result.setdefault(str(prefix), []).append(path.as_dict())
+                    continue
+                sys.stdout.write("%-43s %-39s %10s %6s %s %s\n" % (
+                    prefix,
+                    path.nexthop or "",
+                    "" if path.med is None else path.med,
+                    "" if path.local_pref is None else path.local_pref,
+                    path.aspath,
+                    ORIGINS[path.origin] if path.origin is not None else ""))
+    except (MrtError, struct.error, IndexError) as e:
+        sys.stderr.write("%s: %s\n" % (args.dumpfile, e))
+        sys.exit(1)
+
+    if args.json:
+        json.dump({"routes": result}, sys.stdout, indent=2)
+        sys.stdout.write("\n")
+
+
+if __name__ == "__main__":
+    main()
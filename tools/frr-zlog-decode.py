@@ -0,0 +1,248 @@
+#!/usr/bin/env python3
+#
+# Decode the files written by "log binary-file".
+# Copyright (C) 2026  The FRRouting Project
+#
+# This program is free software; you can redistribute it and/or
+# modify it under the terms of the GNU General Public License
+# as published by the Free Software Foundation; either version 2
+# of the License, or (at your option) any later version.
+#
+# This program is distributed in the hope that it will be useful,
+# but WITHOUT ANY WARRANTY; without even the implied warranty of
+# MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+# GNU General Public License for more details.
+#
+# You should have received a copy of the GNU General Public License along
+# with this program; see the file COPYING; if not, write to the Free Software
+# Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+#
+
+"""
+Turn a binary log file (lib/zlog_binary.c) back into text.  The format
+strings come from frr.xref, which is created in the top build directory;
+it needs to be from the same build as the daemon that wrote the file.
+"""
+
+import argparse
+import ipaddress
+import json
+import re
+import struct
+import sys
+import time
+
+ZLB_MAGIC = b"FRRZLB\0\1"
+# struct zlb_file_hdr
+HDR_FMT = "8sIIQQQqiI32s"
+# struct zlb_rec
+REC_FMT = "IIQBBH12s"
+
+ZLB_REC_ARGS = 1
+ZLB_REC_TEXT = 2
+
+prios = ["emerg", "alert", "crit", "error", "warn", "notif", "info", "debug"]
+
+# same walk as zlb_put_args()
+conv_re = re.compile(
+    r"%(?P<flags>[#0\- +']*)(?P<width>\*|\d+)?(?:\.(?P<prec>\*|\d*))?"
+    r"(?P<len>hh|h|ll|l|q|L|z|j|t)?(?P<conv>[%a-zA-Z])"
+)
+
+
+class DecodeError(Exception):
+    pass
+
+
+class ArgReader:
+    def __init__(self, data, order):
+        self.data = data
+        self.order = order
+        self.pos = 0
+
+    def get(self, fmt):
+        fmt = self.order + fmt
+        size = struct.calcsize(fmt)
+        if self.pos + size > len(self.data):
+            raise DecodeError("record too short")
+        val = struct.unpack_from(fmt, self.data, self.pos)
+        self.pos += size
+        return val[0] if len(val) == 1 else val
+
+    def blob(self):
+        size = self.get("H")
+        val = self.data[self.pos : self.pos + size]
+        self.pos += size
+        return val
+
+    def arg(self, want):
+        tag = chr(self.get("B"))
+        if tag not in want:
+            raise DecodeError("expected %r, got %r" % (want, tag))
+        if tag == "i":
+            return self.get("q")
+        if tag in "up":
+            return self.get("Q")
+        if tag == "f":
+            return self.get("d")
+        if tag == "s":
+            return self.blob().decode("utf-8", "replace")
+        if tag == "x":
+            ext = self.data[self.pos : self.pos + 2].decode()
+            self.pos += 2
+            return (ext, self.blob())
+        raise DecodeError("unknown argument tag %r" % tag)
+
+
+def fmt_ext(ext, raw):
+    if not raw:
+        return "(null)"
+    if ext == "I4":
+        return str(ipaddress.IPv4Address(raw))
+    if ext == "I6":
+        return str(ipaddress.IPv6Address(raw))
+    if ext == "EA":
+        return ":".join("%02x" % b for b in raw)
+    if ext == "FX":
+        if raw[0] == 4:
+            addr = ipaddress.IPv4Address(raw[2:6])
+        else:
+            addr = ipaddress.IPv6Address(raw[2:18])
+        return "%s/%d" % (addr, raw[1])
+    raise DecodeError("unknown extension %r" % ext)
+
+
+def format_args(fmt, reader):
+    out = []
+    pos = 0
+
+    for m in conv_re.finditer(fmt):
+        out.append(fmt[pos : m.start()])
+        pos = m.end()
+
+        conv = m.group("conv")
+        if conv == "%":
+            out.append("%")
+            continue
+
+        width, prec = m.group("width"), m.group("prec")
+        if width == "*":
+            width = str(reader.arg("i"))
+        if prec == "*":
+            prec = str(reader.arg("i"))
+
+        flags = m.group("flags").replace("'", "")
+        spec = "%" + flags + (width or "") + ("." + prec if prec is not None else "")
+
+        if conv in "di":
+            out.append((spec + "d") % reader.arg("i"))
+        elif conv in "uoxX":
+            out.append((spec + conv) % reader.arg("u"))
+        elif conv == "c":
+            out.append((spec + "c") % chr(reader.arg("i") & 0xFF))
+        elif conv in "eEfFgG":
+            out.append((spec + conv) % reader.arg("f"))
+        elif conv in "aA":
+            val = float.hex(reader.arg("f"))
+            out.append(val.upper() if conv == "A" else val)
+        elif conv == "s":
+            out.append((spec + "s") % reader.arg("s"))
+        elif conv == "p" and fmt[pos : pos + 1].isupper():
+            ext, raw = reader.arg("x")
+            pos += 2
+            out.append(("%" + (width or "") + "s") % fmt_ext(ext, raw))
+        elif conv == "p":
+            out.append(("%" + (width or "") + "s") % hex(reader.arg("p")))
+        else:
+            raise DecodeError("unsupported conversion %r" % m.group(0))
+
+    out.append(fmt[pos:])
+    return "".join(out)
+
+
+class ZlogBinFile:
+    def __init__(self, data):
+        self.data = data
+        (magic,) = struct.unpack_from("8s", data, 0)
+        if magic != ZLB_MAGIC:
+            raise DecodeError("not a binary log file")
+
+        for order in ["<", ">"]:
+            byteorder = struct.unpack_from(order + "I", data, 12)[0]
+            if byteorder == 0x01020304:
+                self.order = order
+                break
+        else:
+            raise DecodeError("unknown byte order")
+
+        (
+            _,
+            self.hdrlen,
+            _,
+            self.size,
+            self.head,
+            self.tail,
+            self.pid,
+            self.instance,
+            _,
+            progname,
+        ) = struct.unpack_from(self.order + HDR_FMT, data, 0)
+        self.progname = progname.rstrip(b"\0").decode()
+
+    def records(self):
+        ring = self.data[self.hdrlen : self.hdrlen + self.size]
+        recsize = struct.calcsize(self.order + REC_FMT)
+        pos = self.tail
+
+        while pos < self.head:
+            offs = pos % self.size
+            (length,) = struct.unpack_from(self.order + "I", ring, offs)
+            if length == 0:
+                pos += self.size - offs
+                continue
+            if length < recsize or offs + length > self.size:
+                raise DecodeError("corrupt record at %d" % pos)
+
+            rec = struct.unpack_from(self.order + REC_FMT, ring, offs)
+            _, nsec, sec, rtype, prio, _, uid = rec
+            yield (rtype, prio, sec, nsec, uid.rstrip(b"\0").decode(),
+                   ring[offs + recsize : offs + length])
+            pos += (length + 7) & ~7
+
+
+def main():
+    argp = argparse.ArgumentParser(description=__doc__)
+    argp.add_argument("-x", "--xref", required=True, help="frr.xref file")
+    argp.add_argument("-u", "--utc", action="store_true", help="UTC timestamps")
+    argp.add_argument("logfile", help="binary log file")
+    args = argp.parse_args()
+
+    with open(args.xref, "r") as fd:
+        refs = json.load(fd)["refs"]
+    with open(args.logfile, "rb") as fd:
+        zlb = ZlogBinFile(fd.read())
+
+    tsfn = time.gmtime if args.utc else time.localtime
+    prefix = zlb.progname
+
+    for rtype, prio, sec, nsec, uid, payload in zlb.records():
+        ts = time.strftime("%Y/%m/%d %H:%M:%S", tsfn(sec))
+        ts += ".%06d" % (nsec // 1000)
+
+        if rtype == ZLB_REC_TEXT:
+            text = payload.decode("utf-8", "replace")
+        else:
+            items = [i for i in refs.get(uid, []) if i.get("type") == "logmsg"]
+            try:
+                if not items:
+                    raise DecodeError("UID not in frr.xref")
+                text = format_args(items[0]["fmtstring"], ArgReader(payload, zlb.order))
+            except DecodeError as e:
+                text = "<cannot decode: %s>" % e
+
+        uidstr = "[%s] " % uid if uid else ""
+        sys.stdout.write("%s %s: %s: %s%s\n" % (ts, prefix, prios[prio & 7], uidstr, text))
+
+
+if __name__ == "__main__":
+    main()
@@ -411,6 +411,20 @@ static bool vrrp_has_ip(struct vrrp_vrouter *vr, struct ipaddr *ip)
 	return false;
 }
 
+/*
+ * Drops the ADVERTISEMENT kept for a VRRP router, so that the next one is
+ * built from its current addresses.
+ */
+static void vrrp_adver_reset(struct vrrp_router *r)
+{
+	if (!r->adver)
+		return;
+
+	vrrp_pkt_free(r->adver);
+	r->adver = NULL;
+	r->adver_size = 0;
+}
+
 int vrrp_add_ip(struct vrrp_vrouter *vr, struct ipaddr *ip)
 {
 	struct vrrp_router *r = IS_IPADDR_V4(ip) ? vr->v4 : vr->v6;
@@ -437,6 +451,7 @@ int vrrp_add_ip(struct vrrp_vrouter *vr, struct ipaddr *ip)
 
 	*new = *ip;
 	listnode_add(r->addrs, new);
+	vrrp_adver_reset(r);
 
 	if (r->fsm.state == VRRP_STATE_MASTER) {
 		switch (r->family) {
@@ -486,6 +501,7 @@ int vrrp_del_ip(struct vrrp_vrouter *vr, struct ipaddr *ip)
 	for (ALL_LIST_ELEMENTS(r->addrs, ln, nn, iter))
 		if (!memcmp(&iter->ip, &ip->ip, IPADDRSZ(ip)))
 			list_delete_node(r->addrs, ln);
+	vrrp_adver_reset(r);
 
 	/*
 	 * NB: Deleting the last address and then issuing a shutdown will cause
@@ -625,6 +641,7 @@ static void vrrp_router_destroy(struct vrrp_router *r)
 
 	/* FIXME: also delete list elements */
 	list_delete(&r->addrs);
+	vrrp_adver_reset(r);
 	XFREE(MTYPE_VRRP_RTR, r);
 }
 
@@ -785,11 +802,29 @@ static void vrrp_send_advertisement(struct vrrp_router *r)
 	    && vrrp_bind_to_primary_connected(r) < 0)
 		return;
 
-	list_to_array(r->addrs, (void **)addrs, r->addrs->count);
-
-	pktsz = vrrp_pkt_adver_build(&pkt, &r->src, r->vr->version, r->vr->vrid,
-				     r->priority, r->vr->advertisement_interval,
-				     r->addrs->count, (struct ipaddr **)&addrs);
+	if (r->adver
+	    && (r->adver_src.ipa_type != r->src.ipa_type
+		|| memcmp(&r->adver_src.ip, &r->src.ip, IPADDRSZ(&r->src))
+		|| r->adver_version != r->vr->version
+		|| r->adver_interval != r->vr->advertisement_interval))
+		vrrp_adver_reset(r);
+
+	if (!r->adver) {
+		list_to_array(r->addrs, (void **)addrs, r->addrs->count);
+
+		r->adver_size = vrrp_pkt_adver_build(
+			&r->adver, &r->src, r->vr->version, r->vr->vrid,
+			r->priority, r->vr->advertisement_interval,
+			r->addrs->count, (struct ipaddr **)&addrs);
+		r->adver_src = r->src;
+		r->adver_version = r->vr->version;
+		r->adver_interval = r->vr->advertisement_interval;
+	} else if (r->adver->hdr.priority != r->priority)
+		vrrp_pkt_adver_set_priority(r->adver, (size_t)r->adver_size,
+					    &r->src, r->priority);
+
+	pkt = r->adver;
+	pktsz = r->adver_size;
 
 	if (DEBUG_MODE_CHECK(&vrrp_dbg_pkt, DEBUG_MODE_ALL))
 		zlog_hexdump(pkt, (size_t)pktsz);
@@ -801,8 +836,6 @@ static void vrrp_send_advertisement(struct vrrp_router *r)
 	ssize_t sent = sendto(r->sock_tx, pkt, (size_t)pktsz, 0, &dest.sa,
 			      sockunion_sizeof(&dest));
 
-	vrrp_pkt_free(pkt);
-
 	if (sent < 0) {
 		zlog_warn(VRRP_LOGPFX VRRP_LOGPFX_VRID VRRP_LOGPFX_FAM
 			  "Failed to send VRRP Advertisement: %s",
@@ -134,6 +134,17 @@ struct vrrp_router {
 	 */
 	struct list *addrs;
 
+	/*
+	 * Last ADVERTISEMENT sent, with the source address, version and
+	 * interval it was built for. It is sent again as long as those and the
+	 * addresses are unchanged, with only the priority patched if needed.
+	 */
+	struct vrrp_pkt *adver;
+	ssize_t adver_size;
+	struct ipaddr adver_src;
+	uint8_t adver_version;
+	uint16_t adver_interval;
+
 	/*
 	 * This flag says whether we are waiting on an interface up
 	 * notification from Zebra before we send an ADVERTISEMENT.
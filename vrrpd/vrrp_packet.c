@@ -152,6 +152,13 @@ ssize_t vrrp_pkt_adver_build(struct vrrp_pkt **pkt, struct ipaddr *src,
 	return pktsize;
 }
 
+void vrrp_pkt_adver_set_priority(struct vrrp_pkt *pkt, size_t pktsize,
+				 struct ipaddr *src, uint8_t prio)
+{
+	pkt->hdr.priority = prio;
+	pkt->hdr.chksum = vrrp_pkt_checksum(pkt, pktsize, src);
+}
+
 void vrrp_pkt_free(struct vrrp_pkt *pkt)
 {
 	XFREE(MTYPE_VRRP_PKT, pkt);
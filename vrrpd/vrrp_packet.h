@@ -133,6 +133,25 @@ ssize_t vrrp_pkt_adver_build(struct vrrp_pkt **pkt, struct ipaddr *src,
 			     uint16_t max_adver_int, uint8_t numip,
 			     struct ipaddr **ips);
 
+/*
+ * Changes the priority of an ADVERTISEMENT built by vrrp_pkt_adver_build and
+ * updates its checksum, so that the packet can be sent again.
+ *
+ * pkt
+ *    Packet to change
+ *
+ * pktsize
+ *    Size of pkt, as returned by vrrp_pkt_adver_build
+ *
+ * src
+ *    Source address the packet was built for
+ *
+ * prio
+ *    New Virtual Router Priority
+ */
+void vrrp_pkt_adver_set_priority(struct vrrp_pkt *pkt, size_t pktsize,
+				 struct ipaddr *src, uint8_t prio);
+
 /* free memory allocated by vrrp_pkt_adver_build's pkt arg */
 void vrrp_pkt_free(struct vrrp_pkt *pkt);
 
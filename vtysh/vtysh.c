@@ -178,6 +178,11 @@ static void vclient_close(struct vtysh_client *vclient)
 	}
 }
 
+static int vtysh_client_receive(struct vtysh_client *vclient,
+				void (*callback)(void *, const char *),
+				void *cbarg);
+static bool vtysh_client_send(struct vtysh_client *vclient, const char *line);
+
 /*
  * Send a CLI command to a client and read the response.
  *
@@ -202,13 +207,23 @@ static void vclient_close(struct vtysh_client *vclient)
  */
 static int vtysh_client_run(struct vtysh_client *vclient, const char *line,
 			    void (*callback)(void *, const char *), void *cbarg)
+{
+	if (!vtysh_client_send(vclient, line))
+		return CMD_SUCCESS;
+
+	return vtysh_client_receive(vclient, callback, cbarg);
+}
+
+/*
+ * Send a CLI command to a client, reconnecting to it if needed.
+ *
+ * Returns:
+ *    false if the daemon isn't running or can't be reached, true if it now
+ *    has the command and a reply is to be read
+ */
+static bool vtysh_client_send(struct vtysh_client *vclient, const char *line)
 {
 	int ret;
-	char stackbuf[4096];
-	char *buf = stackbuf;
-	size_t bufsz = sizeof(stackbuf);
-	char *bufvalid, *end = NULL;
-	char terminator[3] = {0, 0, 0};
 
 	/* vclinet was previously active, try to reconnect */
 	if (vclient->fd == VTYSH_WAS_ACTIVE) {
@@ -218,7 +233,7 @@ static int vtysh_client_run(struct vtysh_client *vclient, const char *line,
 	}
 
 	if (vclient->fd < 0)
-		return CMD_SUCCESS;
+		return false;
 
 	ret = write(vclient->fd, line, strlen(line) + 1);
 	if (ret <= 0) {
@@ -233,6 +248,25 @@ static int vtysh_client_run(struct vtysh_client *vclient, const char *line,
 			goto out_err;
 	}
 
+	return true;
+
+out_err:
+	vclient_close(vclient);
+	return false;
+}
+
+/* Read the output and the result of a command from a client. */
+static int vtysh_client_receive(struct vtysh_client *vclient,
+				void (*callback)(void *, const char *),
+				void *cbarg)
+{
+	int ret;
+	char stackbuf[4096];
+	char *buf = stackbuf;
+	size_t bufsz = sizeof(stackbuf);
+	char *bufvalid, *end = NULL;
+	char terminator[3] = {0, 0, 0};
+
 	bufvalid = buf;
 	do {
 		ssize_t nread =
@@ -435,31 +469,342 @@ static int vtysh_client_execute_name(const char *name, const char *line)
 	return ret;
 }
 
+/*
+ * A command can also be sent to several daemons at once, with their replies
+ * read as they come in and kept until all of them are done.  They are then
+ * printed or parsed in daemon order, so the output doesn't change, but the
+ * wait is that for the slowest daemon instead of the sum of all of them.
+ */
+struct vtysh_reply {
+	struct vtysh_client *vclient;
+	bool pending;
+	int ret;
+
+	char *buf;
+	size_t len;
+	size_t size;
+};
+
+/*
+ * Set up replies for every running instance of every daemon, or just of
+ * 'daemon' if given.  watchfrr is left out if 'config' is set; it doesn't load
+ * any config, and has some hardcoded settings that show up in "show run".
+ * Skip it so we don't get that mangled up in config-write.
+ */
+static struct vtysh_reply *vtysh_replies_new(const char *daemon, bool config,
+					     size_t *np)
+{
+	struct vtysh_client *vclient;
+	struct vtysh_reply *replies;
+	size_t n = 0;
+
+	for (unsigned int i = 0; i < array_size(vtysh_client); i++)
+		for (vclient = &vtysh_client[i]; vclient;
+		     vclient = vclient->next)
+			n++;
+	replies = XCALLOC(MTYPE_TMP, n * sizeof(*replies));
+
+	n = 0;
+	for (unsigned int i = 0; i < array_size(vtysh_client); i++) {
+		if (config && vtysh_client[i].flag == VTYSH_WATCHFRR)
+			continue;
+		if (daemon && !strmatch(vtysh_client[i].name, daemon))
+			continue;
+		for (vclient = &vtysh_client[i]; vclient;
+		     vclient = vclient->next)
+			replies[n++].vclient = vclient;
+	}
+
+	*np = n;
+	return replies;
+}
+
+static void vtysh_replies_free(struct vtysh_reply *replies, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+		XFREE(MTYPE_TMP, replies[i].buf);
+	XFREE(MTYPE_TMP, replies);
+}
+
+/* Returns whether more of the reply is still to come. */
+static bool vtysh_reply_read(struct vtysh_reply *reply)
+{
+	struct vtysh_client *vclient = reply->vclient;
+	ssize_t nread;
+
+	if (reply->size - reply->len < 4096) {
+		reply->size = reply->size ? reply->size * 2 : 65536;
+		reply->buf = XREALLOC(MTYPE_TMP, reply->buf, reply->size);
+	}
+
+	/* keep a byte for the \0 that vtysh_reply_output() adds */
+	nread = read(vclient->fd, reply->buf + reply->len,
+		     reply->size - reply->len - 1);
+
+	if (nread < 0 && (errno == EINTR || errno == EAGAIN))
+		return true;
+
+	if (nread <= 0) {
+		if (vty->of)
+			vty_out(vty, "vtysh: error reading from %s: %s (%d)",
+				vclient->name, safe_strerror(errno), errno);
+		vclient_close(vclient);
+		return false;
+	}
+
+	reply->len += nread;
+
+	/*
+	 * Daemons send nothing after the terminator until they get the next
+	 * command, so if it's there, it's the last 4 bytes.
+	 */
+	if (reply->len >= 4
+	    && !memcmp(reply->buf + reply->len - 4, "\0\0\0", 3)) {
+		reply->ret = reply->buf[reply->len - 1];
+		reply->len -= 4;
+		return false;
+	}
+	return true;
+}
+
+/* Send a command to all clients in 'replies' and wait for all of them. */
+static void vtysh_replies_run(struct vtysh_reply *replies, size_t n,
+			      const char *line)
+{
+	struct pollfd *pfds;
+	struct vtysh_reply **polled;
+	size_t i, npfds, npending = 0;
+
+	for (i = 0; i < n; i++) {
+		replies[i].ret = CMD_SUCCESS;
+		replies[i].pending = vtysh_client_send(replies[i].vclient, line);
+		if (replies[i].pending)
+			npending++;
+	}
+	if (!npending)
+		return;
+
+	pfds = XCALLOC(MTYPE_TMP, npending * sizeof(*pfds));
+	polled = XCALLOC(MTYPE_TMP, npending * sizeof(*polled));
+
+	while (npending) {
+		npfds = 0;
+		for (i = 0; i < n; i++) {
+			if (!replies[i].pending)
+				continue;
+			pfds[npfds].fd = replies[i].vclient->fd;
+			pfds[npfds].events = POLLIN;
+			pfds[npfds].revents = 0;
+			polled[npfds++] = &replies[i];
+		}
+
+		if (poll(pfds, npfds, -1) < 0) {
+			if (errno == EINTR || errno == EAGAIN)
+				continue;
+
+			for (i = 0; i < npfds; i++) {
+				polled[i]->pending = false;
+				vclient_close(polled[i]->vclient);
+			}
+			break;
+		}
+
+		for (i = 0; i < npfds; i++) {
+			if (!pfds[i].revents)
+				continue;
+			if (!vtysh_reply_read(polled[i])) {
+				polled[i]->pending = false;
+				npending--;
+			}
+		}
+	}
+
+	XFREE(MTYPE_TMP, polled);
+	XFREE(MTYPE_TMP, pfds);
+}
+
+/*
+ * Print a reply to vty->of, and if 'callback' is given, feed it the reply
+ * line by line like vtysh_client_run() does.
+ */
+static void vtysh_reply_output(struct vtysh_reply *reply,
+			       void (*callback)(void *, const char *),
+			       void *cbarg)
+{
+	char *pos, *eol, *end;
+
+	if (!reply->len)
+		return;
+
+	end = reply->buf + reply->len;
+	*end = '\0';
+
+	if (!callback) {
+		if (vty->of)
+			vty_out(vty, "%s", reply->buf);
+		return;
+	}
+
+	for (pos = reply->buf; pos < end; pos = eol + 1) {
+		eol = memchr(pos, '\n', end - pos);
+		if (!eol)
+			eol = end;
+		*eol = '\0';
+
+		if (vty->of)
+			vty_out(vty, "%s\n", pos);
+		callback(cbarg, pos);
+	}
+}
+
+/*
+ * While a configuration file is being read, the lines for each daemon are
+ * collected here and sent as one batch at the end, rather than doing a
+ * round trip to every daemon for every line.
+ */
+struct vtysh_batch {
+	char *buf;
+	size_t len;
+	size_t size;
+};
+
+static bool vtysh_batching;
+static struct vtysh_batch vtysh_batch[array_size(vtysh_client)];
+
+static void vtysh_batch_add(struct vtysh_batch *batch, const char *line)
+{
+	size_t len = strlen(line);
+
+	while (batch->len + len + 1 > batch->size) {
+		batch->size = batch->size ? batch->size * 2 : 65536;
+		batch->buf = XREALLOC(MTYPE_TMP, batch->buf, batch->size);
+	}
+
+	memcpy(batch->buf + batch->len, line, len);
+	batch->len += len;
+	if (!len || line[len - 1] != '\n')
+		batch->buf[batch->len++] = '\n';
+}
+
+/* For daemons that don't know about batches. */
+static int vtysh_batch_send_lines(struct vtysh_client *vclient,
+				  const struct vtysh_batch *batch)
+{
+	char line[VTY_BUFSIZ];
+	const char *pos, *end = batch->buf + batch->len, *eol;
+	int ret, retcode = CMD_SUCCESS;
+
+	for (pos = batch->buf; pos < end; pos = eol + 1) {
+		eol = memchr(pos, '\n', end - pos);
+		strlcpy(line, pos, MIN((size_t)(eol - pos + 1), sizeof(line)));
+
+		ret = vtysh_client_run(vclient, line, NULL, NULL);
+		if (ret != CMD_SUCCESS && ret != CMD_WARNING
+		    && ret != CMD_NOT_MY_INSTANCE) {
+			fprintf(stderr,
+				"Failure to communicate[%d] to %s, line: %s\n",
+				ret, vclient->name, line);
+			retcode = ret;
+		}
+	}
+
+	return retcode;
+}
+
+static int vtysh_batch_send(struct vtysh_client *vclient,
+			    const struct vtysh_batch *batch)
+{
+	char cmd[64];
+	const char *pos = batch->buf;
+	size_t left = batch->len;
+	ssize_t nwrite;
+	int ret;
+
+	snprintf(cmd, sizeof(cmd), "XFRR_config_batch %zu", batch->len);
+	ret = vtysh_client_run(vclient, cmd, NULL, NULL);
+	if (vclient->fd < 0)
+		return CMD_SUCCESS;
+	if (ret == CMD_ERR_NO_MATCH)
+		return vtysh_batch_send_lines(vclient, batch);
+	if (ret != CMD_SUCCESS)
+		return ret;
+
+	while (left) {
+		nwrite = write(vclient->fd, pos, left);
+		if (nwrite < 0 && (errno == EINTR || errno == EAGAIN))
+			continue;
+		if (nwrite <= 0) {
+			vclient_close(vclient);
+			return CMD_WARNING_CONFIG_FAILED;
+		}
+		pos += nwrite;
+		left -= nwrite;
+	}
+
+	return vtysh_client_receive(vclient, NULL, NULL);
+}
+
+void vtysh_batch_start(void)
+{
+	vtysh_batching = true;
+}
+
+int vtysh_batch_finish(void)
+{
+	struct vtysh_client *client;
+	int ret, retcode = CMD_SUCCESS;
+
+	vtysh_batching = false;
+
+	for (unsigned int i = 0; i < array_size(vtysh_client); i++) {
+		struct vtysh_batch *batch = &vtysh_batch[i];
+
+		if (!batch->len)
+			continue;
+
+		for (client = &vtysh_client[i]; client; client = client->next) {
+			ret = vtysh_batch_send(client, batch);
+			if (ret != CMD_SUCCESS && ret != CMD_WARNING) {
+				fprintf(stderr,
+					"Failure to apply configuration[%d] to %s\n",
+					ret, client->name);
+				retcode = ret;
+			}
+		}
+
+		XFREE(MTYPE_TMP, batch->buf);
+		memset(batch, 0, sizeof(*batch));
+	}
+
+	return retcode;
+}
+
 /*
  * Retrieve all running config from daemons and parse it with the vtysh config
  * parser. Returned output is not displayed to the user.
  *
- * head_client
- *    where to start walking in the daemon list
+ * daemon
+ *    only this daemon, or all of them if NULL
  *
  * line
  *    the specific command to execute
  */
-static void vtysh_client_config(struct vtysh_client *head_client, char *line)
+static void vtysh_client_config(const char *daemon, const char *line)
 {
-	/* watchfrr currently doesn't load any config, and has some hardcoded
-	 * settings that show up in "show run".  skip it here (for now at
-	 * least) so we don't get that mangled up in config-write.
-	 */
-	if (head_client->flag == VTYSH_WATCHFRR)
-		return;
+	struct vtysh_reply *replies;
+	size_t n;
+
+	replies = vtysh_replies_new(daemon, true, &n);
 
 	/* suppress output to user */
 	vty->of_saved = vty->of;
 	vty->of = NULL;
-	vtysh_client_run_all(head_client, line, 1, vtysh_config_parse_line,
-			     NULL);
+	vtysh_replies_run(replies, n, line);
+	for (size_t i = 0; i < n; i++)
+		vtysh_reply_output(&replies[i], vtysh_config_parse_line, NULL);
 	vty->of = vty->of_saved;
+
+	vtysh_replies_free(replies, n);
 }
 
 /* Command execution over the vty interface. */
@@ -987,6 +1332,16 @@ int vtysh_config_from_file(struct vty *vty, FILE *fp)
 			unsigned int i;
 			int cmd_stat = CMD_SUCCESS;
 
+			if (vtysh_batching) {
+				for (i = 0; i < array_size(vtysh_client); i++)
+					if (cmd->daemon & vtysh_client[i].flag)
+						vtysh_batch_add(&vtysh_batch[i],
+								vty->buf);
+				if (cmd->func)
+					(*cmd->func)(cmd, vty, 0, NULL);
+				break;
+			}
+
 			for (i = 0; i < array_size(vtysh_client); i++) {
 				if (cmd->daemon & vtysh_client[i].flag) {
 					cmd_stat = vtysh_client_execute(
@@ -2861,6 +3216,16 @@ DEFUN (vtysh_show_poll,
 	return show_per_daemon(vty, argv, argc, "Thread statistics for %s:\n");
 }
 
+DEFUN (vtysh_show_thread_pool,
+       vtysh_show_thread_pool_cmd,
+       "show thread pool",
+       SHOW_STR
+       "Thread information\n"
+       "Job pools and their workers\n")
+{
+	return show_per_daemon(vty, argv, argc, "Job pools for %s:\n");
+}
+
 DEFUN (vtysh_show_thread,
        vtysh_show_thread_cmd,
        "show thread cpu [FILTER]",
@@ -3199,7 +3564,6 @@ DEFUN (vtysh_write_terminal,
        DAEMONS_STR
        "Skip \"Building configuration...\" header\n")
 {
-	unsigned int i;
 	char line[] = "do write terminal\n";
 
 	if (!strcmp(argv[argc - 1]->arg, "no-header"))
@@ -3210,10 +3574,7 @@ DEFUN (vtysh_write_terminal,
 		vty_out(vty, "!\n");
 	}
 
-	for (i = 0; i < array_size(vtysh_client); i++)
-		if ((argc < 3)
-		    || (strmatch(vtysh_client[i].name, argv[2]->text)))
-			vtysh_client_config(&vtysh_client[i], line);
+	vtysh_client_config(argc < 3 ? NULL : argv[2]->text, line);
 
 	/* Integrate vtysh specific configuration. */
 	vty_open_pager(vty);
@@ -3278,7 +3639,6 @@ static void backup_config_file(const char *fbackup)
 
 int vtysh_write_config_integrated(void)
 {
-	unsigned int i;
 	char line[] = "do write terminal\n";
 	FILE *fp;
 	int fd;
@@ -3305,8 +3665,7 @@ int vtysh_write_config_integrated(void)
 	}
 	fd = fileno(fp);
 
-	for (i = 0; i < array_size(vtysh_client); i++)
-		vtysh_client_config(&vtysh_client[i], line);
+	vtysh_client_config(NULL, line);
 
 	vtysh_config_write();
 	vty->of_saved = vty->of;
@@ -3393,7 +3752,8 @@ DEFUN (vtysh_write_memory,
 {
 	int ret = CMD_SUCCESS;
 	char line[] = "do write memory\n";
-	unsigned int i;
+	struct vtysh_reply *replies;
+	size_t i, n;
 
 	vty_out(vty, "Note: this version of vtysh never writes vtysh.conf\n");
 
@@ -3426,8 +3786,14 @@ DEFUN (vtysh_write_memory,
 
 	vty_out(vty, "Building Configuration...\n");
 
-	for (i = 0; i < array_size(vtysh_client); i++)
-		ret = vtysh_client_execute(&vtysh_client[i], line);
+	replies = vtysh_replies_new(NULL, false, &n);
+	vtysh_replies_run(replies, n, line);
+	for (i = 0; i < n; i++) {
+		vtysh_reply_output(&replies[i], NULL, NULL);
+		if (replies[i].ret != CMD_SUCCESS)
+			ret = replies[i].ret;
+	}
+	vtysh_replies_free(replies, n);
 
 	return ret;
 }
@@ -4577,6 +4943,7 @@ void vtysh_init_vty(void)
 	install_element(VIEW_NODE, &vtysh_show_work_queues_daemon_cmd);
 	install_element(VIEW_NODE, &vtysh_show_thread_cmd);
 	install_element(VIEW_NODE, &vtysh_show_poll_cmd);
+	install_element(VIEW_NODE, &vtysh_show_thread_pool_cmd);
 
 	/* Logging */
 	install_element(VIEW_NODE, &vtysh_show_logging_cmd);
@@ -90,6 +90,13 @@ void vtysh_config_write(void);
 
 int vtysh_config_from_file(struct vty *, FILE *);
 
+/*
+ * Between these, vtysh_config_from_file() collects the lines for each daemon
+ * and vtysh_batch_finish() sends them in one message per daemon.
+ */
+void vtysh_batch_start(void);
+int vtysh_batch_finish(void);
+
 void config_add_line(struct list *, const char *);
 
 int vtysh_mark_file(const char *filename);
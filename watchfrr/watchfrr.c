@@ -26,6 +26,7 @@
 #include <lib/version.h>
 #include "command.h"
 #include "libfrr.h"
+#include "heartbeat.h"
 #include "lib_errors.h"
 #include "zlog_targets.h"
 #include "network.h"
@@ -162,6 +163,10 @@ struct daemon {
 	struct daemon *next;
 	struct restart_info restart;
 
+	/* the daemon's main loop heartbeat, and its task count when seen last */
+	const struct frr_heartbeat *hb;
+	uint64_t hb_tasks;
+
 	/*
 	 * For a given daemon, if we've turned on ignore timeouts
 	 * ignore the timeout value and assume everything is ok
@@ -232,8 +237,12 @@ static void printhelp(FILE *target)
 Watchdog program to monitor status of frr daemons and try to restart\n\
 them if they are down or unresponsive.  It determines whether a daemon is\n\
 up based on whether it can connect to the daemon's vty unix stream socket.\n\
-It then repeatedly sends echo commands over that socket to determine whether\n\
-the daemon is responsive.  If the daemon crashes, we will receive an EOF\n\
+It then repeatedly checks the heartbeat the daemon's event loop publishes\n\
+next to that socket, or sends echo commands over the socket while the\n\
+daemon is idle, to determine whether the daemon is responsive.  A daemon\n\
+that keeps running tasks is never considered unresponsive, one stuck in a\n\
+single task is once that task has run for the timeout.\n\
+If the daemon crashes, we will receive an EOF\n\
 on the socket connection and know immediately that the daemon is down.\n\n\
 The daemons to be monitored should be listed on the command line.\n\n\
 In order to avoid attempting to restart the daemons in a fast loop,\n\
@@ -605,6 +614,7 @@ static void daemon_down(struct daemon *dmn, const char *why)
 	THREAD_OFF(dmn->t_read);
 	THREAD_OFF(dmn->t_write);
 	THREAD_OFF(dmn->t_wakeup);
+	frr_heartbeat_close(&dmn->hb);
 	if (try_connect(dmn) < 0)
 		SET_WAKEUP_DOWN(dmn);
 	phase_check();
@@ -721,11 +731,31 @@ static void daemon_send_ready(int exitcode)
 	sent = 1;
 }
 
+static void daemon_heartbeat_open(struct daemon *dmn)
+{
+	char path[sizeof(((struct sockaddr_un *)0)->sun_path)];
+
+	frr_heartbeat_close(&dmn->hb);
+
+	snprintf(path, sizeof(path), "%s/%s%s", gs.vtydir, dmn->name,
+		 FRR_HEARTBEAT_SUFFIX);
+	dmn->hb = frr_heartbeat_open(path);
+	if (!dmn->hb) {
+		if (gs.loglevel > LOG_DEBUG)
+			zlog_debug("%s: no heartbeat, using echo commands",
+				   dmn->name);
+		return;
+	}
+	dmn->hb_tasks = atomic_load_explicit(&dmn->hb->tasks,
+					     memory_order_acquire);
+}
+
 static void daemon_up(struct daemon *dmn, const char *why)
 {
 	dmn->state = DAEMON_UP;
 	gs.numdown--;
 	dmn->connect_tries = 0;
+	daemon_heartbeat_open(dmn);
 	zlog_notice("%s state -> up : %s", dmn->name, why);
 	if (gs.numdown == 0)
 		daemon_send_ready(0);
@@ -990,22 +1020,81 @@ static int wakeup_unresponsive(struct thread *t_wakeup)
 	return 0;
 }
 
-static int wakeup_no_answer(struct thread *t_wakeup)
+static void daemon_unresponsive(struct daemon *dmn, const char *why)
 {
-	struct daemon *dmn = THREAD_ARG(t_wakeup);
-
-	dmn->t_wakeup = NULL;
 	dmn->state = DAEMON_UNRESPONSIVE;
 	if (dmn->ignore_timeout)
-		return 0;
-	flog_err(EC_WATCHFRR_CONNECTION,
-		 "%s state -> unresponsive : no response yet to ping sent %ld seconds ago",
-		 dmn->name, gs.timeout);
+		return;
+	flog_err(EC_WATCHFRR_CONNECTION, "%s state -> unresponsive : %s",
+		 dmn->name, why);
 	SET_WAKEUP_UNRESPONSIVE(dmn);
 	try_restart(dmn);
+}
+
+static int wakeup_no_answer(struct thread *t_wakeup)
+{
+	struct daemon *dmn = THREAD_ARG(t_wakeup);
+	char why[100];
+
+	dmn->t_wakeup = NULL;
+	snprintf(why, sizeof(why),
+		 "no response yet to ping sent %ld seconds ago", gs.timeout);
+	daemon_unresponsive(dmn, why);
 	return 0;
 }
 
+/*
+ * Check the daemon's heartbeat instead of sending it an echo.  Returns true
+ * if that settled it: the daemon ran tasks since the last check, or is in
+ * the middle of one that hasn't hit the timeout yet ("slow"), or is stuck
+ * in one that has ("hung").  A daemon waiting for events gets the echo, which
+ * doesn't get in the way of anything there.
+ */
+static bool daemon_heartbeat_check(struct daemon *dmn)
+{
+	const struct frr_heartbeat *hb = dmn->hb;
+	uint64_t tasks, start, now;
+	struct timeval tv;
+	char why[128];
+
+	if (!hb)
+		return false;
+
+	tasks = atomic_load_explicit(&hb->tasks, memory_order_acquire);
+	if (tasks != dmn->hb_tasks) {
+		dmn->hb_tasks = tasks;
+		if (dmn->state == DAEMON_UNRESPONSIVE) {
+			dmn->state = DAEMON_UP;
+			zlog_warn("%s state -> up : main loop running tasks again",
+				  dmn->name);
+		}
+		return true;
+	}
+
+	start = atomic_load_explicit(&hb->task_start, memory_order_relaxed);
+	if (!start)
+		return false;
+
+	monotime(&tv);
+	now = (uint64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+	if (now < start + (uint64_t)gs.timeout * 1000000) {
+		if (gs.loglevel > LOG_DEBUG + 1)
+			zlog_debug("%s: slow, current task running for %" PRIu64
+				   " ms",
+				   dmn->name, (now - start) / 1000);
+		return true;
+	}
+
+	snprintf(why, sizeof(why),
+		 "current task running for %" PRIu64
+		 " seconds (longest before: %" PRIu64 " ms)",
+		 (now - start) / 1000000,
+		 atomic_load_explicit(&hb->max_latency, memory_order_relaxed)
+			 / 1000);
+	daemon_unresponsive(dmn, why);
+	return true;
+}
+
 static int wakeup_send_echo(struct thread *t_wakeup)
 {
 	static const char echocmd[] = "echo " PING_TOKEN;
@@ -1013,6 +1102,12 @@ static int wakeup_send_echo(struct thread *t_wakeup)
 	struct daemon *dmn = THREAD_ARG(t_wakeup);
 
 	dmn->t_wakeup = NULL;
+	if (daemon_heartbeat_check(dmn)) {
+		if (dmn->state == DAEMON_UP || dmn->ignore_timeout)
+			SET_WAKEUP_ECHO(dmn);
+		return 0;
+	}
+
 	if (((rc = write(dmn->fd, echocmd, sizeof(echocmd))) < 0)
 	    || ((size_t)rc != sizeof(echocmd))) {
 		char why[100 + sizeof(echocmd)];
@@ -1052,6 +1147,16 @@ void watchfrr_status(struct vty *vty)
 	for (dmn = gs.daemons; dmn; dmn = dmn->next) {
 		vty_out(vty, "  %-20s %s%s", dmn->name, state_str[dmn->state],
 			dmn->ignore_timeout ? "/Ignoring Timeout\n" : "\n");
+		if (dmn->hb)
+			vty_out(vty,
+				"      %" PRIu64 " tasks, last took %" PRIu64
+				" us, longest %" PRIu64 " us\n",
+				atomic_load_explicit(&dmn->hb->tasks,
+						     memory_order_relaxed),
+				atomic_load_explicit(&dmn->hb->last_latency,
+						     memory_order_relaxed),
+				atomic_load_explicit(&dmn->hb->max_latency,
+						     memory_order_relaxed));
 		if (dmn->restart.pid)
 			vty_out(vty, "      restart running, pid %ld\n",
 				(long)dmn->restart.pid);
@@ -40,6 +40,7 @@
 #include "zebra/zebra_mpls.h"
 #include "zebra/zebra_errors.h"
 #include "zebra/zebra_router.h"
+#include "zebra/rt.h"
 
 /* communicate the withdrawal of a connected address */
 static void connected_withdraw(struct connected *ifc)
@@ -63,7 +64,7 @@ static void connected_withdraw(struct connected *ifc)
 	UNSET_FLAG(ifc->conf, ZEBRA_IFC_QUEUED);
 
 	if (!CHECK_FLAG(ifc->conf, ZEBRA_IFC_CONFIGURED)) {
-		listnode_delete(ifc->ifp->connected, ifc);
+		if_connected_delete(ifc->ifp, ifc);
 		connected_free(&ifc);
 	}
 }
@@ -81,7 +82,7 @@ static void connected_announce(struct interface *ifp, struct connected *ifc)
 			UNSET_FLAG(ifc->flags, ZEBRA_IFA_UNNUMBERED);
 	}
 
-	listnode_add(ifp->connected, ifc);
+	if_connected_add(ifp, ifc);
 
 	/* Update interface address information to protocol daemon. */
 	if (ifc->address->family == AF_INET)
@@ -411,6 +412,9 @@ void connected_down(struct interface *ifp, struct connected *ifc)
 		return;
 	}
 
+	/* The kernel drops routes through the address without telling us */
+	kernel_fib_shadow_flush();
+
 	prefix_copy(&p, CONNECTED_PREFIX(ifc));
 
 	/* Apply mask to the network. */
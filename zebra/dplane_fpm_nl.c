@@ -68,6 +68,17 @@
  */
 #define FPM_HEADER_SIZE 4
 
+/*
+ * Data plane contexts taken from the provider queue but not written to obuf
+ * yet.  The rest stays in the provider queue, which zebra counts against its
+ * data plane queue limit: a slow FPM server slows down the RIB processing
+ * instead of making us buffer without bounds.
+ */
+#define FPM_CTX_WINDOW 4096
+
+/* Route nodes visited by a RIB walk before yielding the main thread. */
+#define FPM_RIB_WALK_BATCH 1000
+
 static const char *prov_name = "dplane_fpm_nl";
 
 struct fpm_nl_ctx {
@@ -90,10 +101,14 @@ struct fpm_nl_ctx {
 	 */
 	struct dplane_ctx_q ctxqueue;
 	pthread_mutex_t ctxqueue_mutex;
+	/* Context that did not fit in obuf, encoded first next time. */
+	struct zebra_dplane_ctx *ctx_retry;
 
 	/* data plane events. */
 	struct zebra_dplane_provider *prov;
 	struct frr_pthread *fthread;
+	/* Encodes ctxqueue into obuf while fthread writes it out. */
+	struct frr_pthread *ethread;
 	struct thread *t_connect;
 	struct thread *t_read;
 	struct thread *t_write;
@@ -110,6 +125,17 @@ struct fpm_nl_ctx {
 	struct thread *t_rmacreset;
 	struct thread *t_rmacwalk;
 
+	/* RIB walk position, see fpm_rib_send(). */
+	struct {
+		/* Iterator state that yields the table being walked ... */
+		rib_tables_iter_t tables;
+		/* ... and the one after it, which identifies that table. */
+		rib_tables_iter_t current;
+		/* Last destination sent from that table. */
+		struct prefix last;
+		bool has_last;
+	} rib_walk;
+
 	/* Statistic counters. */
 	struct {
 		/* Amount of bytes read into ibuf. */
@@ -140,6 +166,8 @@ struct fpm_nl_ctx {
 
 		/* Amount of buffer full events. */
 		_Atomic uint32_t buffer_full;
+		/* Amount of times FPM_CTX_WINDOW was full. */
+		_Atomic uint32_t window_full;
 	} counters;
 } *gfnc;
 
@@ -177,6 +205,7 @@ enum fpm_nl_events {
  * Prototypes.
  */
 static int fpm_process_event(struct thread *t);
+static int fpm_process_queue(struct thread *t);
 static int fpm_nl_enqueue(struct fpm_nl_ctx *fnc, struct zebra_dplane_ctx *ctx);
 static int fpm_lsp_send(struct thread *t);
 static int fpm_lsp_reset(struct thread *t);
@@ -327,6 +356,7 @@ DEFUN(fpm_show_counters, fpm_show_counters_cmd,
 	SHOW_COUNTER("Data plane items queue peak",
 		     gfnc->counters.ctxqueue_len_peak);
 	SHOW_COUNTER("Buffer full hits", gfnc->counters.buffer_full);
+	SHOW_COUNTER("Context window full hits", gfnc->counters.window_full);
 	SHOW_COUNTER("User FPM configurations", gfnc->counters.user_configures);
 	SHOW_COUNTER("User FPM disable requests", gfnc->counters.user_disables);
 
@@ -360,6 +390,7 @@ DEFUN(fpm_show_counters_json, fpm_show_counters_json_cmd,
 	json_object_int_add(jo, "data-plane-contexts-queue-peak",
 			    gfnc->counters.ctxqueue_len_peak);
 	json_object_int_add(jo, "buffer-full-hits", gfnc->counters.buffer_full);
+	json_object_int_add(jo, "window-full-hits", gfnc->counters.window_full);
 	json_object_int_add(jo, "user-configures",
 			    gfnc->counters.user_configures);
 	json_object_int_add(jo, "user-disables", gfnc->counters.user_disables);
@@ -451,6 +482,10 @@ static void fpm_reconnect(struct fpm_nl_ctx *fnc)
 	THREAD_OFF(fnc->t_read);
 	THREAD_OFF(fnc->t_write);
 
+	/* The encoder may be waiting for the space we just freed. */
+	thread_add_event(fnc->ethread->master, fpm_process_queue, fnc, 0,
+			 &fnc->t_dequeue);
+
 	/* FPM is disabled, don't attempt to connect. */
 	if (fnc->disabled)
 		return;
@@ -599,6 +634,13 @@ static int fpm_write(struct thread *t)
 		stream_forward_getp(fnc->obuf, (size_t)bwritten);
 	}
 
+	/* Let the encoder fill the space we made. */
+	if (atomic_load_explicit(&fnc->counters.ctxqueue_len,
+				 memory_order_relaxed)
+	    > 0)
+		thread_add_event(fnc->ethread->master, fpm_process_queue, fnc,
+				 0, &fnc->t_dequeue);
+
 	/* Stream is not empty yet, we must schedule more writes. */
 	if (STREAM_READABLE(fnc->obuf)) {
 		stream_pulldown(fnc->obuf);
@@ -702,8 +744,6 @@ static int fpm_nl_enqueue(struct fpm_nl_ctx *fnc, struct zebra_dplane_ctx *ctx)
 
 	nl_buf_len = 0;
 
-	frr_mutex_lock_autounlock(&fnc->obuf_mutex);
-
 	switch (op) {
 	case DPLANE_OP_ROUTE_UPDATE:
 	case DPLANE_OP_ROUTE_DELETE:
@@ -818,6 +858,9 @@ static int fpm_nl_enqueue(struct fpm_nl_ctx *fnc, struct zebra_dplane_ctx *ctx)
 	/* We must know if someday a message goes beyond 65KiB. */
 	assert((nl_buf_len + FPM_HEADER_SIZE) <= UINT16_MAX);
 
+	/* Encoding was done without the lock, fpm_write() kept going. */
+	frr_mutex_lock_autounlock(&fnc->obuf_mutex);
+
 	/* Check if we have enough buffer space. */
 	if (STREAM_WRITEABLE(fnc->obuf) < (nl_buf_len + FPM_HEADER_SIZE)) {
 		atomic_fetch_add_explicit(&fnc->counters.buffer_full, 1,
@@ -856,6 +899,17 @@ static int fpm_nl_enqueue(struct fpm_nl_ctx *fnc, struct zebra_dplane_ctx *ctx)
 		atomic_store_explicit(&fnc->counters.obuf_peak, obytes,
 				      memory_order_relaxed);
 
+	switch (dplane_ctx_get_op(ctx)) {
+	case DPLANE_OP_ROUTE_INSTALL:
+	case DPLANE_OP_ROUTE_UPDATE:
+	case DPLANE_OP_ROUTE_DELETE:
+		conv_stage(zrouter.conv, dplane_ctx_get_vrf(ctx),
+			   dplane_ctx_get_dest(ctx), ZEBRA_CONV_FPM_SEND);
+		break;
+	default:
+		break;
+	}
+
 	/* Tell the thread to start writing. */
 	thread_add_write(fnc->fthread->master, fpm_write, fnc, fnc->socket,
 			 &fnc->t_write);
@@ -984,49 +1038,102 @@ static int fpm_nhg_send(struct thread *t)
 	return 0;
 }
 
+/*
+ * Sends the route selected for a destination, and the source specific
+ * routes below it.
+ *
+ * @return false if we ran out of buffer space.
+ */
+static bool fpm_rib_send_dest(struct fpm_nl_ctx *fnc,
+			      struct zebra_dplane_ctx *ctx,
+			      struct route_node *rn)
+{
+	rib_dest_t *dest = rib_dest_from_rnode(rn);
+	struct route_table *src_table;
+	struct route_node *srn;
+
+	if (dest && dest->selected_fib) {
+		dplane_ctx_reset(ctx);
+		dplane_ctx_route_init(ctx, DPLANE_OP_ROUTE_INSTALL, rn,
+				      dest->selected_fib);
+		if (fpm_nl_enqueue(fnc, ctx) == -1)
+			return false;
+	}
+
+	if (!rnode_is_dstnode(rn))
+		return true;
+
+	src_table = srcdest_srcnode_table(rn);
+	if (!src_table)
+		return true;
+
+	for (srn = route_top(src_table); srn; srn = route_next(srn)) {
+		if (!fpm_rib_send_dest(fnc, ctx, srn)) {
+			route_unlock_node(srn);
+			return false;
+		}
+	}
+
+	return true;
+}
+
 /**
  * Send all RIB installed routes to the connected data plane.
+ *
+ * The walk runs in batches and remembers where it stopped, so it neither
+ * blocks the main thread nor starts over when the output buffer is full.
+ * Routes that change in the meantime reach the FPM through the data plane
+ * anyway.
  */
 static int fpm_rib_send(struct thread *t)
 {
 	struct fpm_nl_ctx *fnc = THREAD_ARG(t);
-	rib_dest_t *dest;
 	struct route_node *rn;
 	struct route_table *rt;
 	struct zebra_dplane_ctx *ctx;
 	rib_tables_iter_t rt_iter;
+	unsigned int count = 0;
 
 	/* Allocate temporary context for all transactions. */
 	ctx = dplane_ctx_alloc();
 
-	rt_iter.state = RIB_TABLES_ITER_S_INIT;
+	rt_iter = fnc->rib_walk.tables;
 	while ((rt = rib_tables_iter_next(&rt_iter))) {
-		for (rn = route_top(rt); rn; rn = srcdest_route_next(rn)) {
-			dest = rib_dest_from_rnode(rn);
-			/* Skip bad route entries. */
-			if (dest == NULL || dest->selected_fib == NULL)
-				continue;
-
-			/* Check for already sent routes. */
-			if (CHECK_FLAG(dest->flags, RIB_DEST_UPDATE_FPM))
-				continue;
+		/* The table we stopped in went away, this is the next one. */
+		if (rt_iter.vrf_id != fnc->rib_walk.current.vrf_id
+		    || rt_iter.afi_safi_ix
+			       != fnc->rib_walk.current.afi_safi_ix)
+			fnc->rib_walk.has_last = false;
+		fnc->rib_walk.current = rt_iter;
+
+		if (fnc->rib_walk.has_last)
+			rn = route_table_get_next(rt, &fnc->rib_walk.last);
+		else
+			rn = route_top(rt);
+
+		for (; rn; rn = route_next(rn)) {
+			if (count++ == FPM_RIB_WALK_BATCH) {
+				route_unlock_node(rn);
+				thread_add_event(zrouter.master, fpm_rib_send,
+						 fnc, 0, &fnc->t_ribwalk);
+				goto yield;
+			}
 
-			/* Enqueue route install. */
-			dplane_ctx_reset(ctx);
-			dplane_ctx_route_init(ctx, DPLANE_OP_ROUTE_INSTALL, rn,
-					      dest->selected_fib);
-			if (fpm_nl_enqueue(fnc, ctx) == -1) {
-				/* Free the temporary allocated context. */
-				dplane_ctx_fini(&ctx);
-
-				thread_add_timer(zrouter.master, fpm_rib_send,
-						 fnc, 1, &fnc->t_ribwalk);
-				return 0;
+			if (!fpm_rib_send_dest(fnc, ctx, rn)) {
+				route_unlock_node(rn);
+				thread_add_timer_msec(zrouter.master,
+						      fpm_rib_send, fnc, 10,
+						      &fnc->t_ribwalk);
+				goto yield;
 			}
 
-			/* Mark as sent. */
-			SET_FLAG(dest->flags, RIB_DEST_UPDATE_FPM);
+			prefix_copy(&fnc->rib_walk.last, &rn->p);
+			fnc->rib_walk.has_last = true;
 		}
+
+		/* Done with this table. */
+		fnc->rib_walk.tables = rt_iter;
+		fnc->rib_walk.has_last = false;
 	}
 
 	/* Free the temporary allocated context. */
@@ -1040,6 +1147,10 @@ static int fpm_rib_send(struct thread *t)
 			 &fnc->t_rmacreset);
 
 	return 0;
+
+yield:
+	dplane_ctx_fini(&ctx);
+	return 0;
 }
 
 /*
@@ -1157,27 +1268,14 @@ static int fpm_lsp_reset(struct thread *t)
 }
 
 /**
- * Resets the RIB FPM flags so we send all routes again.
+ * Restarts the RIB walk from the first table so we send all routes again.
  */
 static int fpm_rib_reset(struct thread *t)
 {
 	struct fpm_nl_ctx *fnc = THREAD_ARG(t);
-	rib_dest_t *dest;
-	struct route_node *rn;
-	struct route_table *rt;
-	rib_tables_iter_t rt_iter;
-
-	rt_iter.state = RIB_TABLES_ITER_S_INIT;
-	while ((rt = rib_tables_iter_next(&rt_iter))) {
-		for (rn = route_top(rt); rn; rn = srcdest_route_next(rn)) {
-			dest = rib_dest_from_rnode(rn);
-			/* Skip bad route entries. */
-			if (dest == NULL)
-				continue;
 
-			UNSET_FLAG(dest->flags, RIB_DEST_UPDATE_FPM);
-		}
-	}
+	memset(&fnc->rib_walk, 0, sizeof(fnc->rib_walk));
+	fnc->rib_walk.tables.state = RIB_TABLES_ITER_S_INIT;
 
 	/* Schedule next step: send RIB routes. */
 	thread_add_event(zrouter.master, fpm_rib_send, fnc, 0, &fnc->t_ribwalk);
@@ -1215,34 +1313,46 @@ static int fpm_rmac_reset(struct thread *t)
 	return 0;
 }
 
+static size_t fpm_obuf_writeable(struct fpm_nl_ctx *fnc)
+{
+	frr_mutex_lock_autounlock(&fnc->obuf_mutex);
+	return STREAM_WRITEABLE(fnc->obuf);
+}
+
+/*
+ * Encodes queued data plane contexts into obuf; runs on ethread, so the
+ * encoding overlaps with fpm_write() on fthread.  There is one encoder
+ * only: the FPM server must see the messages in order, e.g. next hop groups
+ * before the routes using them.
+ */
 static int fpm_process_queue(struct thread *t)
 {
 	struct fpm_nl_ctx *fnc = THREAD_ARG(t);
 	struct zebra_dplane_ctx *ctx;
-	bool no_bufs = false;
 	uint64_t processed_contexts = 0;
 
 	while (true) {
-		/* No space available yet. */
-		if (STREAM_WRITEABLE(fnc->obuf) < NL_PKT_BUF_SIZE) {
-			no_bufs = true;
+		/* No space available yet, fpm_write() calls us back. */
+		if (fpm_obuf_writeable(fnc) < NL_PKT_BUF_SIZE)
 			break;
-		}
 
 		/* Dequeue next item or quit processing. */
-		frr_with_mutex (&fnc->ctxqueue_mutex) {
-			ctx = dplane_ctx_dequeue(&fnc->ctxqueue);
+		if (fnc->ctx_retry) {
+			ctx = fnc->ctx_retry;
+			fnc->ctx_retry = NULL;
+		} else {
+			frr_with_mutex (&fnc->ctxqueue_mutex) {
+				ctx = dplane_ctx_dequeue(&fnc->ctxqueue);
+			}
 		}
 		if (ctx == NULL)
 			break;
 
-		/*
-		 * Intentionally ignoring the return value
-		 * as that we are ensuring that we can write to
-		 * the output data in the STREAM_WRITEABLE
-		 * check above, so we can ignore the return
-		 */
-		(void)fpm_nl_enqueue(fnc, ctx);
+		/* A RIB walk on the main thread took the space meanwhile. */
+		if (fpm_nl_enqueue(fnc, ctx) == -1) {
+			fnc->ctx_retry = ctx;
+			break;
+		}
 
 		/* Account the processed entries. */
 		processed_contexts++;
@@ -1257,11 +1367,6 @@ static int fpm_process_queue(struct thread *t)
 	atomic_fetch_add_explicit(&fnc->counters.dplane_contexts,
 				  processed_contexts, memory_order_relaxed);
 
-	/* Re-schedule if we ran out of buffer space */
-	if (no_bufs)
-		thread_add_timer(fnc->fthread->master, fpm_process_queue,
-				 fnc, 0, &fnc->t_dequeue);
-
 	/*
 	 * Let the dataplane thread know if there are items in the
 	 * output queue to be processed. Otherwise they may sit
@@ -1301,10 +1406,19 @@ static int fpm_process_event(struct thread *t)
 		fpm_reconnect(fnc);
 		break;
 
-	case FNE_RESET_COUNTERS:
+	case FNE_RESET_COUNTERS: {
+		uint32_t ctxqueue_len;
+
 		zlog_info("%s: manual FPM counters reset event", __func__);
+
+		/* Not a statistic, the context window depends on it. */
+		ctxqueue_len = atomic_load_explicit(
+			&fnc->counters.ctxqueue_len, memory_order_relaxed);
 		memset(&fnc->counters, 0, sizeof(fnc->counters));
+		atomic_store_explicit(&fnc->counters.ctxqueue_len,
+				      ctxqueue_len, memory_order_relaxed);
 		break;
+	}
 
 	case FNE_TOGGLE_NHG:
 		zlog_info("%s: toggle next hop groups support", __func__);
@@ -1353,6 +1467,8 @@ static int fpm_nl_start(struct zebra_dplane_provider *prov)
 	fnc = dplane_provider_get_data(prov);
 	fnc->fthread = frr_pthread_new(NULL, prov_name, prov_name);
 	assert(frr_pthread_run(fnc->fthread, NULL) == 0);
+	fnc->ethread = frr_pthread_new(NULL, "FPM encoder", "fpm_nl_encoder");
+	assert(frr_pthread_run(fnc->ethread, NULL) == 0);
 	fnc->ibuf = stream_new(NL_PKT_BUF_SIZE);
 	fnc->obuf = stream_new(NL_PKT_BUF_SIZE * 128);
 	pthread_mutex_init(&fnc->obuf_mutex, NULL);
@@ -1382,6 +1498,7 @@ static int fpm_nl_finish_early(struct fpm_nl_ctx *fnc)
 	thread_cancel_async(fnc->fthread->master, &fnc->t_read, NULL);
 	thread_cancel_async(fnc->fthread->master, &fnc->t_write, NULL);
 	thread_cancel_async(fnc->fthread->master, &fnc->t_connect, NULL);
+	thread_cancel_async(fnc->ethread->master, &fnc->t_dequeue, NULL);
 
 	if (fnc->socket != -1) {
 		close(fnc->socket);
@@ -1393,9 +1510,13 @@ static int fpm_nl_finish_early(struct fpm_nl_ctx *fnc)
 
 static int fpm_nl_finish_late(struct fpm_nl_ctx *fnc)
 {
-	/* Stop the running thread. */
+	/* Stop the running threads. */
+	frr_pthread_stop(fnc->ethread, NULL);
 	frr_pthread_stop(fnc->fthread, NULL);
 
+	if (fnc->ctx_retry)
+		dplane_ctx_fini(&fnc->ctx_retry);
+
 	/* Free all allocated resources. */
 	pthread_mutex_destroy(&fnc->obuf_mutex);
 	pthread_mutex_destroy(&fnc->ctxqueue_mutex);
@@ -1428,6 +1549,20 @@ static int fpm_nl_process(struct zebra_dplane_provider *prov)
 	fnc = dplane_provider_get_data(prov);
 	limit = dplane_provider_get_work_limit(prov);
 	for (counter = 0; counter < limit; counter++) {
+		/*
+		 * Leave the rest in the provider queue once the window is
+		 * full; fpm_process_queue() gets the data plane to call us
+		 * again when it made progress.
+		 */
+		if (fnc->socket != -1 && fnc->connecting == false
+		    && atomic_load_explicit(&fnc->counters.ctxqueue_len,
+					    memory_order_relaxed)
+			       >= FPM_CTX_WINDOW) {
+			atomic_fetch_add_explicit(&fnc->counters.window_full,
+						  1, memory_order_relaxed);
+			break;
+		}
+
 		ctx = dplane_provider_dequeue_in_ctx(prov);
 		if (ctx == NULL)
 			break;
@@ -1470,7 +1605,7 @@ static int fpm_nl_process(struct zebra_dplane_provider *prov)
 	if (atomic_load_explicit(&fnc->counters.ctxqueue_len,
 				 memory_order_relaxed)
 	    > 0)
-		thread_add_timer(fnc->fthread->master, fpm_process_queue,
+		thread_add_timer(fnc->ethread->master, fpm_process_queue,
 				 fnc, 0, &fnc->t_dequeue);
 
 	/* Ensure dataplane thread is rescheduled if we hit the work limit */
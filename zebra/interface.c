@@ -234,6 +234,7 @@ static int if_zebra_delete_hook(struct interface *ifp)
 		struct rtadvconf *rtadv;
 
 		rtadv = &zebra_if->rtadv;
+		rtadv_ra_changed(zebra_if);
 		list_delete(&rtadv->AdvPrefixList);
 		list_delete(&rtadv->AdvRDNSSList);
 		list_delete(&rtadv->AdvDNSSLList);
@@ -732,7 +733,7 @@ static void if_delete_connected(struct interface *ifp)
 					 * (unconditionally). */
 					if (!CHECK_FLAG(ifc->conf,
 							ZEBRA_IFC_CONFIGURED)) {
-						listnode_delete(ifp->connected,
+						if_connected_delete(ifp,
 								ifc);
 						connected_free(&ifc);
 					} else
@@ -754,7 +755,7 @@ static void if_delete_connected(struct interface *ifp)
 			if (CHECK_FLAG(ifc->conf, ZEBRA_IFC_CONFIGURED))
 				last = node;
 			else {
-				listnode_delete(ifp->connected, ifc);
+				if_connected_delete(ifp, ifc);
 				connected_free(&ifc);
 			}
 		} else {
@@ -1093,6 +1094,7 @@ void if_down(struct interface *ifp)
 	quagga_timestamp(2, zif->down_last, sizeof(zif->down_last));
 
 	if_down_nhg_dependents(ifp);
+	zebra_nhg_fast_reroute(&zif->nhg_dependents);
 
 	/* Handle interface down for specific types for EVPN. Non-VxLAN
 	 * interfaces
@@ -2995,7 +2997,7 @@ int if_ip_address_install(struct interface *ifp, struct prefix *prefix,
 			ifc->label = XSTRDUP(MTYPE_CONNECTED_LABEL, label);
 
 		/* Add to linked list. */
-		listnode_add(ifp->connected, ifc);
+		if_connected_add(ifp, ifc);
 	}
 
 	/* This address is configured from zebra. */
@@ -3090,7 +3092,7 @@ static int ip_address_install(struct vty *vty, struct interface *ifp,
 			ifc->label = XSTRDUP(MTYPE_CONNECTED_LABEL, label);
 
 		/* Add to linked list. */
-		listnode_add(ifp->connected, ifc);
+		if_connected_add(ifp, ifc);
 	}
 
 	/* This address is configured from zebra. */
@@ -3152,7 +3154,7 @@ int if_ip_address_uinstall(struct interface *ifp, struct prefix *prefix)
 	/* This is not real address or interface is not active. */
 	if (!CHECK_FLAG(ifc->conf, ZEBRA_IFC_QUEUED)
 	    || !CHECK_FLAG(ifp->status, ZEBRA_INTERFACE_ACTIVE)) {
-		listnode_delete(ifp->connected, ifc);
+		if_connected_delete(ifp, ifc);
 		connected_free(&ifc);
 		return CMD_WARNING_CONFIG_FAILED;
 	}
@@ -3215,7 +3217,7 @@ static int ip_address_uninstall(struct vty *vty, struct interface *ifp,
 	/* This is not real address or interface is not active. */
 	if (!CHECK_FLAG(ifc->conf, ZEBRA_IFC_QUEUED)
 	    || !CHECK_FLAG(ifp->status, ZEBRA_INTERFACE_ACTIVE)) {
-		listnode_delete(ifp->connected, ifc);
+		if_connected_delete(ifp, ifc);
 		connected_free(&ifc);
 		return CMD_WARNING_CONFIG_FAILED;
 	}
@@ -3353,7 +3355,7 @@ int if_ipv6_address_install(struct interface *ifp, struct prefix *prefix,
 			ifc->label = XSTRDUP(MTYPE_CONNECTED_LABEL, label);
 
 		/* Add to linked list. */
-		listnode_add(ifp->connected, ifc);
+		if_connected_add(ifp, ifc);
 	}
 
 	/* This address is configured from zebra. */
@@ -3426,7 +3428,7 @@ static int ipv6_address_install(struct vty *vty, struct interface *ifp,
 			ifc->label = XSTRDUP(MTYPE_CONNECTED_LABEL, label);
 
 		/* Add to linked list. */
-		listnode_add(ifp->connected, ifc);
+		if_connected_add(ifp, ifc);
 	}
 
 	/* This address is configured from zebra. */
@@ -3505,7 +3507,7 @@ static int ipv6_address_uninstall(struct vty *vty, struct interface *ifp,
 	/* This is not real address or interface is not active. */
 	if (!CHECK_FLAG(ifc->conf, ZEBRA_IFC_QUEUED)
 	    || !CHECK_FLAG(ifp->status, ZEBRA_INTERFACE_ACTIVE)) {
-		listnode_delete(ifp->connected, ifc);
+		if_connected_delete(ifp, ifc);
 		connected_free(&ifc);
 		return CMD_WARNING_CONFIG_FAILED;
 	}
@@ -213,6 +213,14 @@ struct rtadvconf {
 
 #define RTADV_FAST_REXMIT_PERIOD 1 /* 1 sec */
 #define RTADV_NUM_FAST_REXMITS   4 /* Fast Rexmit RA 4 times on certain events */
+
+	/* Unsolicited RA as last built, with the link's MTU and hardware
+	 * address it was built for.  Dropped by rtadv_ra_changed(). */
+	uint8_t *ra_cache;
+	int ra_cache_len;
+	unsigned int ra_cache_mtu;
+	uint8_t ra_cache_hwaddr[INTERFACE_HWADDR_MAX];
+	int ra_cache_hwaddr_len;
 };
 
 struct rtadv_rdnss {
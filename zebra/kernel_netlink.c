@@ -36,6 +36,7 @@
 #include "vrf.h"
 #include "mpls.h"
 #include "lib_errors.h"
+#include "frr_pthread.h"
 
 //#include "zebra/zserv.h"
 #include "zebra/zebra_router.h"
@@ -91,6 +92,12 @@
 
 #define NL_BATCH_RX_BUFSIZE NL_RCV_PKT_BUF_SIZE
 
+/*
+ * 0: read the kernel's responses after every batch and don't keep contexts
+ * across kernel_update_multi() calls.
+ */
+#define NL_DEFAULT_BATCH_WINDOW 0
+
 static const struct message nlmsg_str[] = {{RTM_NEWROUTE, "RTM_NEWROUTE"},
 					   {RTM_DELROUTE, "RTM_DELROUTE"},
 					   {RTM_GETROUTE, "RTM_GETROUTE"},
@@ -160,15 +167,23 @@ extern struct zebra_privs_t zserv_privs;
 
 DEFINE_MTYPE_STATIC(ZEBRA, NL_BUF, "Zebra Netlink buffers");
 
-size_t nl_batch_tx_bufsize;
-char *nl_batch_tx_buf;
+/* batch buffers, one set per pthread sending batches */
+struct nl_batch_bufs {
+	size_t tx_bufsize;
+	char *tx_buf;
 
-char nl_batch_rx_buf[NL_BATCH_RX_BUFSIZE];
+	char rx_buf[NL_BATCH_RX_BUFSIZE];
+};
+
+static struct nl_batch_bufs nl_batch_bufs;
 
 _Atomic uint32_t nl_batch_bufsize = NL_DEFAULT_BATCH_BUFSIZE;
 _Atomic uint32_t nl_batch_send_threshold = NL_DEFAULT_BATCH_SEND_THRESHOLD;
+_Atomic uint32_t nl_batch_window = NL_DEFAULT_BATCH_WINDOW;
 
 struct nl_batch {
+	struct nl_batch_bufs *bufs;
+
 	void *buf;
 	size_t bufsiz;
 	size_t limit;
@@ -179,8 +194,14 @@ struct nl_batch {
 
 	const struct zebra_dplane_info *zns;
 
+	/* contexts whose messages are in buf */
 	struct dplane_ctx_q ctx_list;
 
+	/* contexts that were sent, but whose responses weren't read yet */
+	struct dplane_ctx_q inflight;
+	size_t inflight_cnt;
+	size_t window;
+
 	/*
 	 * Pointer to the queue of completed contexts outbound back
 	 * towards the dataplane module.
@@ -188,6 +209,47 @@ struct nl_batch {
 	struct dplane_ctx_q *ctx_out_q;
 };
 
+/* kept across kernel_update_multi() calls with a batch window set */
+static struct nl_batch nl_pipeline;
+static bool nl_pipeline_active;
+
+/* written by the dplane pthread, read by "show zebra dplane" */
+static struct {
+	_Atomic uint64_t batches;
+	_Atomic uint64_t msgs;
+	_Atomic uint32_t max_batch;
+	_Atomic uint32_t inflight;
+	_Atomic uint32_t max_inflight;
+} nl_batch_stats;
+
+/*
+ * Kernel shards: with --dplane-shards, route contexts are split by table
+ * (see dplane_ctx_ns_init()) and each shard sends its batches on its own
+ * dataplane socket.  Shard 0 runs on the dataplane pthread, the others on
+ * their own pthreads.  Only touched by the dataplane pthread, except for
+ * each shard's own work and done queues while it runs.
+ */
+struct nl_shard {
+	struct frr_pthread *pthread;
+	struct nl_batch_bufs bufs;
+
+	/* contexts to send, and the ones whose results are in */
+	struct dplane_ctx_q work;
+	struct dplane_ctx_q done;
+
+	/* for "show zebra dplane" */
+	_Atomic uint64_t ctx_cnt;
+	_Atomic uint64_t runs;
+};
+
+static struct nl_shard *nl_shards;
+static _Atomic unsigned int nl_shard_cnt;
+
+/* shards still running */
+static pthread_mutex_t nl_shard_mtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t nl_shard_cond = PTHREAD_COND_INITIALIZER;
+static unsigned int nl_shard_pending;
+
 int netlink_config_write_helper(struct vty *vty)
 {
 	uint32_t size =
@@ -195,14 +257,69 @@ int netlink_config_write_helper(struct vty *vty)
 	uint32_t threshold = atomic_load_explicit(&nl_batch_send_threshold,
 						  memory_order_relaxed);
 
+	uint32_t window =
+		atomic_load_explicit(&nl_batch_window, memory_order_relaxed);
+
 	if (size != NL_DEFAULT_BATCH_BUFSIZE
 	    || threshold != NL_DEFAULT_BATCH_SEND_THRESHOLD)
 		vty_out(vty, "zebra kernel netlink batch-tx-buf %u %u\n", size,
 			threshold);
 
+	if (window != NL_DEFAULT_BATCH_WINDOW)
+		vty_out(vty, "zebra kernel netlink batch-window %u\n", window);
+
 	return 0;
 }
 
+void netlink_set_batch_window(uint32_t window, bool set)
+{
+	if (!set)
+		window = NL_DEFAULT_BATCH_WINDOW;
+
+	atomic_store_explicit(&nl_batch_window, window, memory_order_relaxed);
+}
+
+void netlink_batch_show_helper(struct vty *vty)
+{
+	vty_out(vty, "Netlink batches sent:     %" PRIu64 "\n",
+		atomic_load_explicit(&nl_batch_stats.batches,
+				     memory_order_relaxed));
+	vty_out(vty, "Netlink batch messages:   %" PRIu64 "\n",
+		atomic_load_explicit(&nl_batch_stats.msgs,
+				     memory_order_relaxed));
+	vty_out(vty, "Netlink batch size max:   %u\n",
+		atomic_load_explicit(&nl_batch_stats.max_batch,
+				     memory_order_relaxed));
+	vty_out(vty, "Netlink in-flight window: %u\n",
+		atomic_load_explicit(&nl_batch_window, memory_order_relaxed));
+	vty_out(vty, "Netlink in-flight depth:  %u\n",
+		atomic_load_explicit(&nl_batch_stats.inflight,
+				     memory_order_relaxed));
+	vty_out(vty, "Netlink in-flight max:    %u\n",
+		atomic_load_explicit(&nl_batch_stats.max_inflight,
+				     memory_order_relaxed));
+
+	if (zrouter.dplane_shards > 1) {
+		unsigned int i, cnt;
+
+		vty_out(vty, "Kernel dataplane shards:  %u\n",
+			zrouter.dplane_shards);
+
+		/* the shards are created on the first kernel update */
+		cnt = atomic_load_explicit(&nl_shard_cnt,
+					   memory_order_acquire);
+		for (i = 0; i < cnt; i++)
+			vty_out(vty,
+				"  Shard %u: %" PRIu64 " updates, %" PRIu64
+				" runs\n",
+				i,
+				atomic_load_explicit(&nl_shards[i].ctx_cnt,
+						     memory_order_relaxed),
+				atomic_load_explicit(&nl_shards[i].runs,
+						     memory_order_relaxed));
+	}
+}
+
 void netlink_set_batch_buffer_size(uint32_t size, uint32_t threshold, bool set)
 {
 	if (!set) {
@@ -420,66 +537,74 @@ static int kernel_read(struct thread *thread)
  * so that we only had to write one way to handle incoming
  * address add/delete changes.
  */
-static void netlink_install_filter(int sock, __u32 pid, __u32 dplane_pid)
+static void netlink_install_filter(int sock, const __u32 *pids,
+				   unsigned int npids)
 {
+	/* the pid compares, plus 5 fixed statements */
+	struct sock_filter filter[ZEBRA_DPLANE_SHARDS_MAX + 1 + 5];
+	unsigned int i, n = 0;
+
+	assert(npids >= 1 && npids <= ZEBRA_DPLANE_SHARDS_MAX + 1);
+
 	/*
 	 * BPF_JUMP instructions and where you jump to are based upon
 	 * 0 as being the next statement.  So count from 0.  Writing
 	 * this down because every time I look at this I have to
 	 * re-remember it.
+	 *
+	 * Logic:
+	 *   if (nlmsg_pid == pids[0] || ... ||
+	 *       nlmsg_pid == pids[npids - 1]) {
+	 *       if (the incoming nlmsg_type ==
+	 *           RTM_NEWADDR | RTM_DELADDR)
+	 *           keep this message
+	 *       else
+	 *           skip this message
+	 *   } else
+	 *       keep this netlink message
 	 */
-	struct sock_filter filter[] = {
-		/*
-		 * Logic:
-		 *   if (nlmsg_pid == pid ||
-		 *       nlmsg_pid == dplane_pid) {
-		 *       if (the incoming nlmsg_type ==
-		 *           RTM_NEWADDR | RTM_DELADDR)
-		 *           keep this message
-		 *       else
-		 *           skip this message
-		 *   } else
-		 *       keep this netlink message
-		 */
-		/*
-		 * 0: Load the nlmsg_pid into the BPF register
-		 */
-		BPF_STMT(BPF_LD | BPF_ABS | BPF_W,
-			 offsetof(struct nlmsghdr, nlmsg_pid)),
-		/*
-		 * 1: Compare to pid
-		 */
-		BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, htonl(pid), 1, 0),
-		/*
-		 * 2: Compare to dplane pid
-		 */
-		BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, htonl(dplane_pid), 0, 4),
-		/*
-		 * 3: Load the nlmsg_type into BPF register
-		 */
-		BPF_STMT(BPF_LD | BPF_ABS | BPF_H,
-			 offsetof(struct nlmsghdr, nlmsg_type)),
-		/*
-		 * 4: Compare to RTM_NEWADDR
-		 */
-		BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, htons(RTM_NEWADDR), 2, 0),
-		/*
-		 * 5: Compare to RTM_DELADDR
-		 */
-		BPF_JUMP(BPF_JMP | BPF_JEQ | BPF_K, htons(RTM_DELADDR), 1, 0),
-		/*
-		 * 6: This is the end state of we want to skip the
-		 *    message
-		 */
-		BPF_STMT(BPF_RET | BPF_K, 0),
-		/* 7: This is the end state of we want to keep
-		 *     the message
-		 */
-		BPF_STMT(BPF_RET | BPF_K, 0xffff),
-	};
+
+	/*
+	 * 0: Load the nlmsg_pid into the BPF register
+	 */
+	filter[n++] = (struct sock_filter)BPF_STMT(
+		BPF_LD | BPF_ABS | BPF_W, offsetof(struct nlmsghdr, nlmsg_pid));
+	/*
+	 * 1 .. npids: Compare to our pids, the last one jumps to the keep
+	 *             state if it doesn't match either
+	 */
+	for (i = 0; i < npids; i++)
+		filter[n++] = (struct sock_filter)BPF_JUMP(
+			BPF_JMP | BPF_JEQ | BPF_K, htonl(pids[i]),
+			npids - 1 - i, (i == npids - 1) ? 4 : 0);
+	/*
+	 * npids + 1: Load the nlmsg_type into BPF register
+	 */
+	filter[n++] = (struct sock_filter)BPF_STMT(
+		BPF_LD | BPF_ABS | BPF_H, offsetof(struct nlmsghdr, nlmsg_type));
+	/*
+	 * npids + 2: Compare to RTM_NEWADDR
+	 */
+	filter[n++] = (struct sock_filter)BPF_JUMP(
+		BPF_JMP | BPF_JEQ | BPF_K, htons(RTM_NEWADDR), 2, 0);
+	/*
+	 * npids + 3: Compare to RTM_DELADDR
+	 */
+	filter[n++] = (struct sock_filter)BPF_JUMP(
+		BPF_JMP | BPF_JEQ | BPF_K, htons(RTM_DELADDR), 1, 0);
+	/*
+	 * npids + 4: This is the end state of we want to skip the
+	 *            message
+	 */
+	filter[n++] = (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, 0);
+	/*
+	 * npids + 5: This is the end state of we want to keep
+	 *            the message
+	 */
+	filter[n++] = (struct sock_filter)BPF_STMT(BPF_RET | BPF_K, 0xffff);
 
 	struct sock_fprog prog = {
-		.len = array_size(filter), .filter = filter,
+		.len = n, .filter = filter,
 	};
 
 	if (setsockopt(sock, SOL_SOCKET, SO_ATTACH_FILTER, &prog, sizeof(prog))
@@ -1069,6 +1194,392 @@ int netlink_request(struct nlsock *nl, void *req)
 	return 0;
 }
 
+/*
+ * Messages received on another pthread, to be run through a filter on the
+ * main pthread as zebra's data structures are not thread-safe.
+ */
+PREDECL_LIST(nl_chunks);
+
+struct nl_chunk {
+	struct nl_chunks_item item;
+	const struct nlsock *nl;
+	size_t len;
+	char buf[];
+};
+
+DECLARE_LIST(nl_chunks, struct nl_chunk, item);
+
+static int nl_chunk_parse(int (*filter)(struct nlmsghdr *, ns_id_t, int),
+			  struct nl_chunk *chunk,
+			  const struct zebra_dplane_info *zns, int startup)
+{
+	struct nlmsghdr *h;
+	int status = chunk->len;
+	int ret = 0, error;
+
+	for (h = (struct nlmsghdr *)chunk->buf;
+	     NLMSG_OK(h, (unsigned int)status); h = NLMSG_NEXT(h, status)) {
+		if (h->nlmsg_type == NLMSG_ERROR) {
+			error = netlink_parse_error(chunk->nl, h, zns,
+						    startup);
+			if (error < 0)
+				ret = error;
+			continue;
+		}
+
+		if (IS_ZEBRA_DEBUG_KERNEL)
+			zlog_debug(
+				"%s: %s type %s(%u), len=%d, seq=%u, pid=%u",
+				__func__, chunk->nl->name,
+				nl_msg_type_to_str(h->nlmsg_type),
+				h->nlmsg_type, h->nlmsg_len, h->nlmsg_seq,
+				h->nlmsg_pid);
+
+		error = (*filter)(h, zns->ns_id, startup);
+		if (error < 0) {
+			zlog_debug("%s filter function error",
+				   chunk->nl->name);
+			ret = error;
+		}
+	}
+	return ret;
+}
+
+/*
+ * Parallel dumps
+ *
+ * Each request gets its own socket and a pthread that receives the kernel's
+ * replies, which is where the kernel does the work of walking its tables.
+ * The messages the prefilter lets through are queued up in chunks and run
+ * through the filter on the calling pthread.
+ */
+struct nl_dump {
+	struct nlsock nl;
+	bool (*prefilter)(const struct nlmsghdr *h);
+	struct frr_pthread *pthread;
+	int ret;
+};
+
+static pthread_mutex_t nl_dump_mtx = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t nl_dump_cond = PTHREAD_COND_INITIALIZER;
+static struct nl_chunks_head nl_dump_queue;
+static unsigned int nl_dump_pending;
+
+static int nl_dump_work(struct thread *thread)
+{
+	struct nl_dump *dump = THREAD_ARG(thread);
+	struct nl_chunk *chunk;
+	struct nlmsghdr *h;
+	bool done = false;
+	int status;
+
+	while (!done) {
+		char buf[NL_RCV_PKT_BUF_SIZE];
+		struct sockaddr_nl snl;
+		struct msghdr msg = {.msg_name = (void *)&snl,
+				     .msg_namelen = sizeof(snl)};
+
+		status = netlink_recv_msg(&dump->nl, msg, buf, sizeof(buf));
+		if (status <= 0) {
+			dump->ret = -1;
+			break;
+		}
+		if (msg.msg_flags & MSG_TRUNC) {
+			flog_err(EC_ZEBRA_NETLINK_LENGTH_ERROR,
+				 "%s error: message truncated", dump->nl.name);
+			continue;
+		}
+		if (snl.nl_pid != 0)
+			continue;
+
+		chunk = XMALLOC(MTYPE_NL_BUF,
+				sizeof(*chunk) + status + NLMSG_ALIGNTO);
+		chunk->nl = &dump->nl;
+		chunk->len = 0;
+
+		for (h = (struct nlmsghdr *)buf;
+		     NLMSG_OK(h, (unsigned int)status);
+		     h = NLMSG_NEXT(h, status)) {
+			if (h->nlmsg_type == NLMSG_DONE) {
+				done = true;
+				break;
+			}
+			/* errors end the dump, and are dealt with in order */
+			if (h->nlmsg_type == NLMSG_ERROR)
+				done = true;
+			else if (dump->prefilter && !dump->prefilter(h))
+				continue;
+
+			memcpy(chunk->buf + chunk->len, h, h->nlmsg_len);
+			chunk->len += NLMSG_ALIGN(h->nlmsg_len);
+			if (done)
+				break;
+		}
+
+		if (!chunk->len) {
+			XFREE(MTYPE_NL_BUF, chunk);
+			continue;
+		}
+
+		frr_with_mutex(&nl_dump_mtx) {
+			nl_chunks_add_tail(&nl_dump_queue, chunk);
+			pthread_cond_signal(&nl_dump_cond);
+		}
+	}
+
+	frr_with_mutex(&nl_dump_mtx) {
+		nl_dump_pending--;
+		pthread_cond_signal(&nl_dump_cond);
+	}
+	return 0;
+}
+
+/*
+ * netlink_dump_parallel - send the dump requests in 'reqs' at once and run
+ * the replies through 'filter'.  Messages for which 'prefilter' returns
+ * false are dropped on the receiving pthreads already.
+ *
+ * Returns -1 if a dump could not be started or failed, the last filter
+ * error otherwise.
+ */
+int netlink_dump_parallel(int (*filter)(struct nlmsghdr *, ns_id_t, int),
+			  bool (*prefilter)(const struct nlmsghdr *h),
+			  struct zebra_ns *zns, void **reqs, unsigned int nreqs,
+			  int startup)
+{
+	struct frr_pthread_attr attr = {
+		.start = frr_pthread_attr_default.start,
+		.stop = frr_pthread_attr_default.stop,
+	};
+	struct zebra_dplane_info dp_info;
+	struct nl_chunks_head chunks;
+	struct nl_chunk *chunk;
+	struct nl_dump *dumps;
+	char name[32], os_name[OS_THREAD_NAMELEN];
+	unsigned int i, started = 0, pending;
+	int ret = 0, error;
+
+	zebra_dplane_info_from_zns(&dp_info, zns, true /*is_cmd*/);
+	nl_chunks_init(&chunks);
+	frr_with_mutex(&nl_dump_mtx) {
+		nl_chunks_init(&nl_dump_queue);
+	}
+
+	dumps = XCALLOC(MTYPE_NL_BUF, nreqs * sizeof(*dumps));
+	for (i = 0; i < nreqs; i++) {
+		snprintf(dumps[i].nl.name, sizeof(dumps[i].nl.name),
+			 "netlink-dump-%u (NS %u)", i, zns->ns_id);
+		dumps[i].nl.sock = -1;
+		dumps[i].prefilter = prefilter;
+		if (netlink_socket(&dumps[i].nl, 0, zns->ns_id) < 0) {
+			ret = -1;
+			break;
+		}
+		if (nl_rcvbufsize)
+			netlink_recvbuf(&dumps[i].nl, nl_rcvbufsize);
+		if (netlink_request(&dumps[i].nl, reqs[i]) < 0) {
+			ret = -1;
+			break;
+		}
+
+		snprintf(name, sizeof(name), "Zebra netlink dump %u", i);
+		snprintf(os_name, sizeof(os_name), "zebra_nld%u", i);
+		dumps[i].pthread = frr_pthread_new(&attr, name, os_name);
+		frr_pthread_run(dumps[i].pthread, NULL);
+		frr_pthread_wait_running(dumps[i].pthread);
+
+		frr_with_mutex(&nl_dump_mtx) {
+			nl_dump_pending++;
+		}
+		thread_add_event(dumps[i].pthread->master, nl_dump_work,
+				 &dumps[i], 0, NULL);
+		started++;
+	}
+
+	do {
+		frr_with_mutex(&nl_dump_mtx) {
+			while (nl_dump_pending
+			       && !nl_chunks_count(&nl_dump_queue))
+				pthread_cond_wait(&nl_dump_cond, &nl_dump_mtx);
+
+			while ((chunk = nl_chunks_pop(&nl_dump_queue)))
+				nl_chunks_add_tail(&chunks, chunk);
+			pending = nl_dump_pending;
+		}
+
+		while ((chunk = nl_chunks_pop(&chunks))) {
+			error = nl_chunk_parse(filter, chunk, &dp_info,
+						    startup);
+			if (error < 0 && ret == 0)
+				ret = error;
+			XFREE(MTYPE_NL_BUF, chunk);
+		}
+	} while (pending);
+
+	for (i = 0; i < nreqs; i++) {
+		if (i < started) {
+			frr_pthread_stop(dumps[i].pthread, NULL);
+			frr_pthread_destroy(dumps[i].pthread);
+			if (dumps[i].ret < 0)
+				ret = -1;
+		}
+		if (dumps[i].nl.sock >= 0)
+			close(dumps[i].nl.sock);
+	}
+	XFREE(MTYPE_NL_BUF, dumps);
+	nl_chunks_fini(&chunks);
+
+	return ret;
+}
+
+/*
+ * Reader pthread (--nl-reader)
+ *
+ * Drains the kernel message socket as fast as the kernel fills it, so
+ * bursts of events end up queued here rather than overflowing the socket's
+ * receive buffer.  Datagrams are received back to back into large chunks,
+ * and the main pthread runs them through netlink_information_fetch() a few
+ * chunks at a time.
+ */
+#define NL_READER_CHUNK_SIZE (16 * NL_RCV_PKT_BUF_SIZE)
+#define NL_READER_CHUNKS_PER_RUN 4
+
+struct nl_reader {
+	struct zebra_ns *zns;
+	struct frr_pthread *pthread;
+	/* on the reader pthread */
+	struct thread *t_read;
+	/* on the main pthread */
+	struct thread *t_process;
+
+	pthread_mutex_t mtx;
+	struct nl_chunks_head chunks;
+};
+
+static int nl_reader_process(struct thread *thread)
+{
+	struct nl_reader *reader = THREAD_ARG(thread);
+	struct zebra_dplane_info dp_info;
+	struct nl_chunk *chunk;
+	unsigned int i;
+	bool more;
+
+	zebra_dplane_info_from_zns(&dp_info, reader->zns, false);
+
+	for (i = 0; i < NL_READER_CHUNKS_PER_RUN; i++) {
+		frr_with_mutex(&reader->mtx) {
+			chunk = nl_chunks_pop(&reader->chunks);
+		}
+		if (!chunk)
+			break;
+
+		nl_chunk_parse(netlink_information_fetch, chunk, &dp_info, 0);
+		XFREE(MTYPE_NL_BUF, chunk);
+	}
+
+	frr_with_mutex(&reader->mtx) {
+		more = nl_chunks_count(&reader->chunks) != 0;
+	}
+	if (more)
+		thread_add_event(zrouter.master, nl_reader_process, reader, 0,
+				 &reader->t_process);
+	return 0;
+}
+
+static int nl_reader_read(struct thread *thread)
+{
+	struct nl_reader *reader = THREAD_ARG(thread);
+	const struct nlsock *nl = &reader->zns->netlink;
+	struct nl_chunk *chunk;
+	int status;
+
+	chunk = XMALLOC(MTYPE_NL_BUF, sizeof(*chunk) + NL_READER_CHUNK_SIZE);
+	chunk->nl = nl;
+	chunk->len = 0;
+
+	while (chunk->len + NL_RCV_PKT_BUF_SIZE <= NL_READER_CHUNK_SIZE) {
+		struct sockaddr_nl snl;
+		struct msghdr msg = {.msg_name = (void *)&snl,
+				     .msg_namelen = sizeof(snl)};
+
+		status = netlink_recv_msg(nl, msg, chunk->buf + chunk->len,
+					  NL_RCV_PKT_BUF_SIZE);
+		if (status <= 0)
+			break;
+
+		if (msg.msg_flags & MSG_TRUNC) {
+			flog_err(EC_ZEBRA_NETLINK_LENGTH_ERROR,
+				 "%s error: message truncated", nl->name);
+			continue;
+		}
+		/* see netlink_parse_info() */
+		if (snl.nl_pid != 0)
+			continue;
+
+		chunk->len += NLMSG_ALIGN(status);
+	}
+
+	if (chunk->len) {
+		frr_with_mutex(&reader->mtx) {
+			nl_chunks_add_tail(&reader->chunks, chunk);
+		}
+		thread_add_event(zrouter.master, nl_reader_process, reader, 0,
+				 &reader->t_process);
+	} else
+		XFREE(MTYPE_NL_BUF, chunk);
+
+	thread_add_read(reader->pthread->master, nl_reader_read, reader,
+			nl->sock, &reader->t_read);
+	return 0;
+}
+
+static void nl_reader_start(struct zebra_ns *zns)
+{
+	struct frr_pthread_attr attr = {
+		.start = frr_pthread_attr_default.start,
+		.stop = frr_pthread_attr_default.stop,
+	};
+	struct nl_reader *reader;
+	char name[32], os_name[OS_THREAD_NAMELEN];
+
+	reader = XCALLOC(MTYPE_NL_BUF, sizeof(*reader));
+	reader->zns = zns;
+	pthread_mutex_init(&reader->mtx, NULL);
+	nl_chunks_init(&reader->chunks);
+
+	snprintf(name, sizeof(name), "Zebra netlink reader NS %u", zns->ns_id);
+	snprintf(os_name, sizeof(os_name), "zebra_nlr%u", zns->ns_id);
+	reader->pthread = frr_pthread_new(&attr, name, os_name);
+	frr_pthread_run(reader->pthread, NULL);
+	frr_pthread_wait_running(reader->pthread);
+
+	thread_add_read(reader->pthread->master, nl_reader_read, reader,
+			zns->netlink.sock, &reader->t_read);
+	zns->netlink_reader = reader;
+}
+
+static void nl_reader_stop(struct zebra_ns *zns)
+{
+	struct nl_reader *reader = zns->netlink_reader;
+	struct nl_chunk *chunk;
+
+	if (!reader)
+		return;
+
+	/* takes the reader's own tasks with it */
+	frr_pthread_stop(reader->pthread, NULL);
+	frr_pthread_destroy(reader->pthread);
+	thread_cancel(&reader->t_process);
+
+	while ((chunk = nl_chunks_pop(&reader->chunks)))
+		XFREE(MTYPE_NL_BUF, chunk);
+	nl_chunks_fini(&reader->chunks);
+	pthread_mutex_destroy(&reader->mtx);
+
+	XFREE(MTYPE_NL_BUF, reader);
+	zns->netlink_reader = NULL;
+}
+
 static int nl_batch_read_resp(struct nl_batch *bth)
 {
 	struct nlmsghdr *h;
@@ -1089,12 +1600,12 @@ static int nl_batch_read_resp(struct nl_batch *bth)
 	 * message at a time.
 	 */
 	while (true) {
-		status = netlink_recv_msg(nl, msg, nl_batch_rx_buf,
-					  sizeof(nl_batch_rx_buf));
+		status = netlink_recv_msg(nl, msg, bth->bufs->rx_buf,
+					  sizeof(bth->bufs->rx_buf));
 		if (status == -1 || status == 0)
 			return status;
 
-		h = (struct nlmsghdr *)nl_batch_rx_buf;
+		h = (struct nlmsghdr *)bth->bufs->rx_buf;
 		ignore_msg = false;
 		seq = h->nlmsg_seq;
 		/*
@@ -1104,7 +1615,7 @@ static int nl_batch_read_resp(struct nl_batch *bth)
 		 * requests at same time.
 		 */
 		while (true) {
-			ctx = dplane_ctx_dequeue(&(bth->ctx_list));
+			ctx = dplane_ctx_dequeue(&(bth->inflight));
 			if (ctx == NULL)
 				break;
 
@@ -1178,12 +1689,14 @@ static void nl_batch_reset(struct nl_batch *bth)
 	bth->buf_head = bth->buf;
 	bth->curlen = 0;
 	bth->msgcnt = 0;
-	bth->zns = NULL;
+	if (TAILQ_EMPTY(&(bth->inflight)))
+		bth->zns = NULL;
 
 	TAILQ_INIT(&(bth->ctx_list));
 }
 
-static void nl_batch_init(struct nl_batch *bth, struct dplane_ctx_q *ctx_out_q)
+static void nl_batch_init(struct nl_batch *bth, struct nl_batch_bufs *bufs,
+			  struct dplane_ctx_q *ctx_out_q)
 {
 	/*
 	 * If the size of the buffer has changed, free and then allocate a new
@@ -1191,24 +1704,65 @@ static void nl_batch_init(struct nl_batch *bth, struct dplane_ctx_q *ctx_out_q)
 	 */
 	size_t bufsize =
 		atomic_load_explicit(&nl_batch_bufsize, memory_order_relaxed);
-	if (bufsize != nl_batch_tx_bufsize) {
-		if (nl_batch_tx_buf)
-			XFREE(MTYPE_NL_BUF, nl_batch_tx_buf);
+	if (bufsize != bufs->tx_bufsize) {
+		if (bufs->tx_buf)
+			XFREE(MTYPE_NL_BUF, bufs->tx_buf);
 
-		nl_batch_tx_buf = XCALLOC(MTYPE_NL_BUF, bufsize);
-		nl_batch_tx_bufsize = bufsize;
+		bufs->tx_buf = XCALLOC(MTYPE_NL_BUF, bufsize);
+		bufs->tx_bufsize = bufsize;
 	}
 
-	bth->buf = nl_batch_tx_buf;
+	bth->bufs = bufs;
+	bth->buf = bufs->tx_buf;
 	bth->bufsiz = bufsize;
 	bth->limit = atomic_load_explicit(&nl_batch_send_threshold,
 					  memory_order_relaxed);
+	bth->window =
+		atomic_load_explicit(&nl_batch_window, memory_order_relaxed);
 
 	bth->ctx_out_q = ctx_out_q;
 
+	TAILQ_INIT(&(bth->inflight));
+	bth->inflight_cnt = 0;
 	nl_batch_reset(bth);
 }
 
+/*
+ * Read the responses to everything in flight and hand all of those
+ * contexts back.
+ */
+static void nl_batch_drain(struct nl_batch *bth)
+{
+	struct zebra_dplane_ctx *ctx;
+	bool err = false;
+
+	if (TAILQ_EMPTY(&(bth->inflight)))
+		return;
+
+	/* no zns if none of these needed a message */
+	if (bth->zns && nl_batch_read_resp(bth) == -1)
+		err = true;
+
+	/* Move remaining contexts to the outbound queue. */
+	while (true) {
+		ctx = dplane_ctx_dequeue(&(bth->inflight));
+		if (ctx == NULL)
+			break;
+
+		if (err)
+			dplane_ctx_set_status(ctx,
+					      ZEBRA_DPLANE_REQUEST_FAILURE);
+
+		dplane_ctx_enqueue_tail(bth->ctx_out_q, ctx);
+	}
+
+	bth->inflight_cnt = 0;
+	atomic_store_explicit(&nl_batch_stats.inflight, 0,
+			      memory_order_relaxed);
+	if (TAILQ_EMPTY(&(bth->ctx_list)))
+		bth->zns = NULL;
+}
+
 static void nl_batch_send(struct nl_batch *bth)
 {
 	struct zebra_dplane_ctx *ctx;
@@ -1224,28 +1778,59 @@ static void nl_batch_send(struct nl_batch *bth)
 		    == -1)
 			err = true;
 
-		if (!err) {
-			if (nl_batch_read_resp(bth) == -1)
-				err = true;
-		}
+		atomic_fetch_add_explicit(&nl_batch_stats.batches, 1,
+					  memory_order_relaxed);
+		atomic_fetch_add_explicit(&nl_batch_stats.msgs, bth->msgcnt,
+					  memory_order_relaxed);
+		if (bth->msgcnt > atomic_load_explicit(&nl_batch_stats.max_batch,
+						       memory_order_relaxed))
+			atomic_store_explicit(&nl_batch_stats.max_batch,
+					      bth->msgcnt,
+					      memory_order_relaxed);
 	}
 
-	/* Move remaining contexts to the outbound queue. */
-	while (true) {
-		ctx = dplane_ctx_dequeue(&(bth->ctx_list));
-		if (ctx == NULL)
-			break;
+	if (err) {
+		/* nothing in this batch made it, earlier ones may have */
+		while (true) {
+			ctx = dplane_ctx_dequeue(&(bth->ctx_list));
+			if (ctx == NULL)
+				break;
 
-		if (err)
 			dplane_ctx_set_status(ctx,
 					      ZEBRA_DPLANE_REQUEST_FAILURE);
-
-		dplane_ctx_enqueue_tail(bth->ctx_out_q, ctx);
+			dplane_ctx_enqueue_tail(bth->ctx_out_q, ctx);
+		}
+	} else {
+		bth->inflight_cnt += bth->msgcnt;
+		dplane_ctx_list_append(&(bth->inflight), &(bth->ctx_list));
 	}
 
+	atomic_store_explicit(&nl_batch_stats.inflight, bth->inflight_cnt,
+			      memory_order_relaxed);
+	if (bth->inflight_cnt
+	    > atomic_load_explicit(&nl_batch_stats.max_inflight,
+				   memory_order_relaxed))
+		atomic_store_explicit(&nl_batch_stats.max_inflight,
+				      bth->inflight_cnt, memory_order_relaxed);
+
+	/*
+	 * The kernel has acted on the whole batch by the time sendmsg()
+	 * returns, so all its errors are already queued on the socket.  They
+	 * only have to be read before the socket's receive buffer fills up.
+	 */
+	if (bth->inflight_cnt >= bth->window)
+		nl_batch_drain(bth);
+
 	nl_batch_reset(bth);
 }
 
+/* send whatever is pending and read all responses */
+static void nl_batch_flush(struct nl_batch *bth)
+{
+	nl_batch_send(bth);
+	nl_batch_drain(bth);
+}
+
 enum netlink_msg_status netlink_batch_add_msg(
 	struct nl_batch *bth, struct zebra_dplane_ctx *ctx,
 	ssize_t (*msg_encoder)(struct zebra_dplane_ctx *, void *, size_t),
@@ -1372,24 +1957,21 @@ static enum netlink_msg_status nl_put_msg(struct nl_batch *bth,
 	return FRR_NETLINK_ERROR;
 }
 
-void kernel_update_multi(struct dplane_ctx_q *ctx_list)
+/* encode and batch up everything on ctx_list */
+static void nl_batch_put_list(struct nl_batch *bth,
+			      struct dplane_ctx_q *ctx_list)
 {
-	struct nl_batch batch;
 	struct zebra_dplane_ctx *ctx;
-	struct dplane_ctx_q handled_list;
 	enum netlink_msg_status res;
 
-	TAILQ_INIT(&handled_list);
-	nl_batch_init(&batch, &handled_list);
-
 	while (true) {
 		ctx = dplane_ctx_dequeue(ctx_list);
 		if (ctx == NULL)
 			break;
 
-		if (batch.zns != NULL
-		    && batch.zns->ns_id != dplane_ctx_get_ns(ctx)->ns_id)
-			nl_batch_send(&batch);
+		if (bth->zns != NULL
+		    && bth->zns->ns_id != dplane_ctx_get_ns(ctx)->ns_id)
+			nl_batch_flush(bth);
 
 		/*
 		 * Assume all messages will succeed and then mark only the ones
@@ -1397,28 +1979,280 @@ void kernel_update_multi(struct dplane_ctx_q *ctx_list)
 		 */
 		dplane_ctx_set_status(ctx, ZEBRA_DPLANE_REQUEST_SUCCESS);
 
-		res = nl_put_msg(&batch, ctx);
+		res = nl_put_msg(bth, ctx);
 
-		dplane_ctx_enqueue_tail(&(batch.ctx_list), ctx);
+		dplane_ctx_enqueue_tail(&(bth->ctx_list), ctx);
 		if (res == FRR_NETLINK_ERROR)
 			dplane_ctx_set_status(ctx,
 					      ZEBRA_DPLANE_REQUEST_FAILURE);
 
-		if (batch.curlen > batch.limit)
-			nl_batch_send(&batch);
+		if (bth->curlen > bth->limit)
+			nl_batch_send(bth);
+	}
+}
+
+/* runs one shard's work queue to completion */
+static void nl_shard_process(struct nl_shard *shard)
+{
+	struct nl_batch bth;
+
+	nl_batch_init(&bth, &shard->bufs, &shard->done);
+	/* no pipelining across calls in sharded mode */
+	bth.window = 0;
+
+	nl_batch_put_list(&bth, &shard->work);
+	nl_batch_flush(&bth);
+
+	atomic_fetch_add_explicit(&shard->runs, 1, memory_order_relaxed);
+}
+
+static int nl_shard_work(struct thread *thread)
+{
+	struct nl_shard *shard = THREAD_ARG(thread);
+
+	nl_shard_process(shard);
+
+	frr_with_mutex(&nl_shard_mtx) {
+		if (--nl_shard_pending == 0)
+			pthread_cond_signal(&nl_shard_cond);
+	}
+	return 0;
+}
+
+static void nl_shards_init(void)
+{
+	struct frr_pthread_attr attr = {
+		.start = frr_pthread_attr_default.start,
+		.stop = frr_pthread_attr_default.stop,
+	};
+	char name[32], os_name[OS_THREAD_NAMELEN];
+	struct nl_shard *shards;
+	unsigned int i, cnt = zrouter.dplane_shards;
+
+	shards = XCALLOC(MTYPE_NL_BUF, cnt * sizeof(*shards));
+
+	for (i = 0; i < cnt; i++) {
+		TAILQ_INIT(&shards[i].work);
+		TAILQ_INIT(&shards[i].done);
+
+		/* shard 0 is run by the dataplane pthread itself */
+		if (i == 0)
+			continue;
+
+		snprintf(name, sizeof(name), "Zebra dplane kernel shard %u", i);
+		snprintf(os_name, sizeof(os_name), "zebra_dpk%u", i);
+		shards[i].pthread = frr_pthread_new(&attr, name, os_name);
+		frr_pthread_run(shards[i].pthread, NULL);
 	}
+	for (i = 1; i < cnt; i++)
+		frr_pthread_wait_running(shards[i].pthread);
 
-	nl_batch_send(&batch);
+	/* "show zebra dplane" only looks at the first nl_shard_cnt shards */
+	nl_shards = shards;
+	atomic_store_explicit(&nl_shard_cnt, cnt, memory_order_release);
+}
+
+/*
+ * Send everything queued on the shards, in parallel, and collect the
+ * results on out_list.
+ */
+static void nl_shards_run(struct dplane_ctx_q *out_list)
+{
+	unsigned int i;
+
+	frr_with_mutex(&nl_shard_mtx) {
+		nl_shard_pending = 0;
+		for (i = 1; i < nl_shard_cnt; i++)
+			if (!TAILQ_EMPTY(&nl_shards[i].work))
+				nl_shard_pending++;
+	}
+
+	for (i = 1; i < nl_shard_cnt; i++)
+		if (!TAILQ_EMPTY(&nl_shards[i].work))
+			thread_add_event(nl_shards[i].pthread->master,
+					 nl_shard_work, &nl_shards[i], 0, NULL);
+
+	if (!TAILQ_EMPTY(&nl_shards[0].work))
+		nl_shard_process(&nl_shards[0]);
+
+	frr_with_mutex(&nl_shard_mtx) {
+		while (nl_shard_pending)
+			pthread_cond_wait(&nl_shard_cond, &nl_shard_mtx);
+	}
+
+	for (i = 0; i < nl_shard_cnt; i++)
+		dplane_ctx_list_append(out_list, &nl_shards[i].done);
+}
+
+/*
+ * Sharded version of kernel_update_multi().
+ *
+ * Per-prefix ordering holds because a table always maps to the same shard.
+ * Anything that isn't a route (nexthop groups, addresses, ...) may be
+ * needed by, or refer to, routes on any shard, so it acts as a barrier:
+ * all shards are run before it is queued on shard 0, and again before a
+ * route queued after it goes out on another shard.
+ */
+static void nl_shards_update(struct dplane_ctx_q *ctx_list)
+{
+	struct zebra_dplane_ctx *ctx;
+	struct dplane_ctx_q handled_list;
+	unsigned int shard, i;
+	bool barrier = false;
+	bool pending = false;
+
+	if (nl_shards == NULL)
+		nl_shards_init();
+
+	TAILQ_INIT(&handled_list);
+
+	while (true) {
+		ctx = dplane_ctx_dequeue(ctx_list);
+		if (ctx == NULL)
+			break;
+
+		switch (dplane_ctx_get_op(ctx)) {
+		case DPLANE_OP_ROUTE_INSTALL:
+		case DPLANE_OP_ROUTE_UPDATE:
+		case DPLANE_OP_ROUTE_DELETE:
+			shard = dplane_ctx_get_ns(ctx)->shard;
+			if (shard >= nl_shard_cnt)
+				shard = 0;
+
+			if (shard != 0 && barrier) {
+				nl_shards_run(&handled_list);
+				barrier = false;
+			}
+			if (shard != 0)
+				pending = true;
+			break;
+		default:
+			shard = 0;
+			if (pending) {
+				nl_shards_run(&handled_list);
+				pending = false;
+			}
+			barrier = true;
+			break;
+		}
+
+		dplane_ctx_enqueue_tail(&nl_shards[shard].work, ctx);
+		atomic_fetch_add_explicit(&nl_shards[shard].ctx_cnt, 1,
+					  memory_order_relaxed);
+	}
+
+	for (i = 0; i < nl_shard_cnt; i++) {
+		if (!TAILQ_EMPTY(&nl_shards[i].work)) {
+			nl_shards_run(&handled_list);
+			break;
+		}
+	}
+
+	TAILQ_INIT(ctx_list);
+	dplane_ctx_list_append(ctx_list, &handled_list);
+}
+
+void kernel_update_multi(struct dplane_ctx_q *ctx_list, bool more)
+{
+	struct nl_batch local_batch;
+	struct nl_batch *bth;
+	struct dplane_ctx_q handled_list;
+
+	if (zrouter.dplane_shards > 1) {
+		nl_shards_update(ctx_list);
+		return;
+	}
+
+	TAILQ_INIT(&handled_list);
+
+	/*
+	 * With a batch window, contexts may stay in the batch (unsent or in
+	 * flight) across calls for as long as more work is coming.
+	 */
+	if (nl_pipeline_active) {
+		bth = &nl_pipeline;
+		bth->ctx_out_q = &handled_list;
+	} else {
+		bth = &local_batch;
+		nl_batch_init(bth, &nl_batch_bufs, &handled_list);
+		if (bth->window) {
+			nl_pipeline = local_batch;
+			TAILQ_INIT(&nl_pipeline.inflight);
+			TAILQ_INIT(&nl_pipeline.ctx_list);
+			bth = &nl_pipeline;
+			nl_pipeline_active = true;
+		}
+	}
+
+	nl_batch_put_list(bth, ctx_list);
+
+	if (!more || !nl_pipeline_active) {
+		nl_batch_flush(bth);
+		/* picks up configuration changes on the next run */
+		nl_pipeline_active = false;
+	}
 
 	TAILQ_INIT(ctx_list);
 	dplane_ctx_list_append(ctx_list, &handled_list);
 }
 
+/* dataplane socket setup, shared by all kernel shards */
+static void netlink_dplane_socket_init(struct zebra_ns *zns,
+				       struct nlsock *nls, unsigned int shard)
+{
+#if defined SOL_NETLINK
+	int one, ret;
+#endif
+
+	if (shard == 0)
+		snprintf(nls->name, sizeof(nls->name), "netlink-dp (NS %u)",
+			 zns->ns_id);
+	else
+		snprintf(nls->name, sizeof(nls->name),
+			 "netlink-dp%u (NS %u)", shard, zns->ns_id);
+	nls->sock = -1;
+	if (netlink_socket(nls, 0, zns->ns_id) < 0) {
+		zlog_err("Failure to create %s socket", nls->name);
+		exit(-1);
+	}
+
+#if defined SOL_NETLINK
+	one = 1;
+	ret = setsockopt(nls->sock, SOL_NETLINK, NETLINK_EXT_ACK, &one,
+			 sizeof(one));
+
+	if (ret < 0)
+		zlog_notice("Registration for extended dp ACK failed : %d %s",
+			    errno, safe_strerror(errno));
+
+	/*
+	 * Trim off the payload of the original netlink message in the
+	 * acknowledgment. This option is available since Linux 4.2, so if
+	 * setsockopt fails, ignore the error.
+	 */
+	one = 1;
+	ret = setsockopt(nls->sock, SOL_NETLINK, NETLINK_CAP_ACK, &one,
+			 sizeof(one));
+	if (ret < 0)
+		zlog_notice(
+			"Registration for reduced ACK packet size failed, probably running an early kernel");
+#endif
+
+	if (fcntl(nls->sock, F_SETFL, O_NONBLOCK) < 0)
+		zlog_err("Can't set %s socket error: %s(%d)", nls->name,
+			 safe_strerror(errno), errno);
+
+	if (nl_rcvbufsize)
+		netlink_recvbuf(nls, nl_rcvbufsize);
+}
+
 /* Exported interface function.  This function simply calls
    netlink_socket (). */
 void kernel_init(struct zebra_ns *zns)
 {
 	uint32_t groups;
+	__u32 pids[ZEBRA_DPLANE_SHARDS_MAX + 1];
+	unsigned int i;
 #if defined SOL_NETLINK
 	int one, ret;
 #endif
@@ -1461,14 +2295,12 @@ void kernel_init(struct zebra_ns *zns)
 		exit(-1);
 	}
 
-	snprintf(zns->netlink_dplane.name, sizeof(zns->netlink_dplane.name),
-		 "netlink-dp (NS %u)", zns->ns_id);
-	zns->netlink_dplane.sock = -1;
-	if (netlink_socket(&zns->netlink_dplane, 0, zns->ns_id) < 0) {
-		zlog_err("Failure to create %s socket",
-			 zns->netlink_dplane.name);
-		exit(-1);
-	}
+	for (i = 0; i < ZEBRA_DPLANE_SHARDS_MAX - 1; i++)
+		zns->netlink_dplane_shard[i].sock = -1;
+
+	for (i = 0; i < zrouter.dplane_shards; i++)
+		netlink_dplane_socket_init(zns, zebra_ns_dplane_sock(zns, i),
+					   i);
 
 	/*
 	 * SOL_NETLINK is not available on all platforms yet
@@ -1487,26 +2319,6 @@ void kernel_init(struct zebra_ns *zns)
 	if (ret < 0)
 		zlog_notice("Registration for extended cmd ACK failed : %d %s",
 			    errno, safe_strerror(errno));
-
-	one = 1;
-	ret = setsockopt(zns->netlink_dplane.sock, SOL_NETLINK, NETLINK_EXT_ACK,
-			 &one, sizeof(one));
-
-	if (ret < 0)
-		zlog_notice("Registration for extended dp ACK failed : %d %s",
-			    errno, safe_strerror(errno));
-
-	/*
-	 * Trim off the payload of the original netlink message in the
-	 * acknowledgment. This option is available since Linux 4.2, so if
-	 * setsockopt fails, ignore the error.
-	 */
-	one = 1;
-	ret = setsockopt(zns->netlink_dplane.sock, SOL_NETLINK, NETLINK_CAP_ACK,
-			 &one, sizeof(one));
-	if (ret < 0)
-		zlog_notice(
-			"Registration for reduced ACK packet size failed, probably running an early kernel");
 #endif
 
 	/* Register kernel socket. */
@@ -1518,25 +2330,26 @@ void kernel_init(struct zebra_ns *zns)
 		zlog_err("Can't set %s socket error: %s(%d)",
 			 zns->netlink_cmd.name, safe_strerror(errno), errno);
 
-	if (fcntl(zns->netlink_dplane.sock, F_SETFL, O_NONBLOCK) < 0)
-		zlog_err("Can't set %s socket error: %s(%d)",
-			 zns->netlink_dplane.name, safe_strerror(errno), errno);
-
 	/* Set receive buffer size if it's set from command line */
 	if (nl_rcvbufsize) {
 		netlink_recvbuf(&zns->netlink, nl_rcvbufsize);
 		netlink_recvbuf(&zns->netlink_cmd, nl_rcvbufsize);
-		netlink_recvbuf(&zns->netlink_dplane, nl_rcvbufsize);
 	}
 
-	netlink_install_filter(zns->netlink.sock,
-			       zns->netlink_cmd.snl.nl_pid,
-			       zns->netlink_dplane.snl.nl_pid);
+	pids[0] = zns->netlink_cmd.snl.nl_pid;
+	for (i = 0; i < zrouter.dplane_shards; i++)
+		pids[i + 1] = zebra_ns_dplane_sock(zns, i)->snl.nl_pid;
+
+	netlink_install_filter(zns->netlink.sock, pids,
+			       zrouter.dplane_shards + 1);
 
 	zns->t_netlink = NULL;
 
-	thread_add_read(zrouter.master, kernel_read, zns,
-			zns->netlink.sock, &zns->t_netlink);
+	if (zrouter.netlink_reader)
+		nl_reader_start(zns);
+	else
+		thread_add_read(zrouter.master, kernel_read, zns,
+				zns->netlink.sock, &zns->t_netlink);
 
 	rt_netlink_init();
 }
@@ -1544,6 +2357,7 @@ void kernel_init(struct zebra_ns *zns)
 void kernel_terminate(struct zebra_ns *zns, bool complete)
 {
 	thread_cancel(&zns->t_netlink);
+	nl_reader_stop(zns);
 
 	if (zns->netlink.sock >= 0) {
 		close(zns->netlink.sock);
@@ -1559,9 +2373,15 @@ void kernel_terminate(struct zebra_ns *zns, bool complete)
 	 * around until all work is done.
 	 */
 	if (complete) {
-		if (zns->netlink_dplane.sock >= 0) {
-			close(zns->netlink_dplane.sock);
-			zns->netlink_dplane.sock = -1;
+		struct nlsock *nls;
+		unsigned int i;
+
+		for (i = 0; i < zrouter.dplane_shards; i++) {
+			nls = zebra_ns_dplane_sock(zns, i);
+			if (nls->sock >= 0) {
+				close(nls->sock);
+				nls->sock = -1;
+			}
 		}
 	}
 }
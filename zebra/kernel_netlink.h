@@ -98,6 +98,11 @@ extern int netlink_talk(int (*filter)(struct nlmsghdr *, ns_id_t, int startup),
 			struct nlmsghdr *n, struct nlsock *nl,
 			struct zebra_ns *zns, int startup);
 extern int netlink_request(struct nlsock *nl, void *req);
+extern int netlink_dump_parallel(int (*filter)(struct nlmsghdr *, ns_id_t,
+					       int),
+				 bool (*prefilter)(const struct nlmsghdr *h),
+				 struct zebra_ns *zns, void **reqs,
+				 unsigned int nreqs, int startup);
 
 enum netlink_msg_status {
 	FRR_NETLINK_SUCCESS,
@@ -140,6 +145,16 @@ extern int netlink_config_write_helper(struct vty *vty);
 extern void netlink_set_batch_buffer_size(uint32_t size, uint32_t threshold,
 					  bool set);
 
+/*
+ * Configure how many messages may be sent before the kernel's responses to
+ * them are read.  A window also lets batches fill up across dataplane
+ * cycles while more work is queued.  If 'unset', reset to default value.
+ */
+extern void netlink_set_batch_window(uint32_t window, bool set);
+
+/* Batch counters for "show zebra dplane". */
+extern void netlink_batch_show_helper(struct vty *vty);
+
 #endif /* HAVE_NETLINK */
 
 #ifdef __cplusplus
@@ -1457,7 +1457,7 @@ void kernel_terminate(struct zebra_ns *zns, bool complete)
 	return;
 }
 
-void kernel_update_multi(struct dplane_ctx_q *ctx_list)
+void kernel_update_multi(struct dplane_ctx_q *ctx_list, bool more)
 {
 	struct zebra_dplane_ctx *ctx;
 	struct dplane_ctx_q handled_list;
@@ -33,6 +33,7 @@
 #include "lib/stream.h"
 #include "lib/zclient.h"
 #include "lib/libfrr.h"
+#include "lib/jhash.h"
 
 //#include "zebra/zserv.h"
 #include "zebra/zebra_router.h"
@@ -48,6 +49,36 @@ struct label_manager lbl_mgr;
 DEFINE_MGROUP(LBL_MGR, "Label Manager");
 DEFINE_MTYPE_STATIC(LBL_MGR, LM_CHUNK, "Label Manager Chunk");
 
+static inline uint32_t lm_chunk_size(const struct label_manager_chunk *lmc)
+{
+	return lmc->end - lmc->start + 1;
+}
+
+static int lm_chunk_starts_cmp(const struct label_manager_chunk *a,
+			       const struct label_manager_chunk *b)
+{
+	return numcmp(a->start, b->start);
+}
+
+static uint32_t lm_chunk_starts_hash(const struct label_manager_chunk *lmc)
+{
+	return jhash_1word(lmc->start, 0);
+}
+
+DECLARE_HASH(lm_chunk_starts, struct label_manager_chunk, starts_item,
+	     lm_chunk_starts_cmp, lm_chunk_starts_hash);
+
+static int lm_chunk_free_cmp(const struct label_manager_chunk *a,
+			     const struct label_manager_chunk *b)
+{
+	if (lm_chunk_size(a) != lm_chunk_size(b))
+		return numcmp(lm_chunk_size(a), lm_chunk_size(b));
+	return numcmp(a->start, b->start);
+}
+
+DECLARE_RBTREE_UNIQ(lm_chunk_free, struct label_manager_chunk, free_item,
+		    lm_chunk_free_cmp);
+
 /* define hooks for the basic API, so that it can be specialized or served
  * externally
  */
@@ -165,6 +196,9 @@ void label_manager_init(void)
 {
 	lbl_mgr.lc_list = list_new();
 	lbl_mgr.lc_list->del = delete_label_chunk;
+	lm_chunk_starts_init(&lbl_mgr.starts);
+	lm_chunk_free_init(&lbl_mgr.free);
+	lbl_mgr.chunk_labels = 0;
 	hook_register(zserv_client_close, lm_client_disconnect_cb);
 
 	/* register default hooks for the label manager actions */
@@ -193,6 +227,33 @@ create_label_chunk(uint8_t proto, unsigned short instance, uint32_t session_id,
 	return lmc;
 }
 
+/* link a new chunk in the list, before node or at the tail */
+static void lm_chunk_link(struct listnode *node,
+			  struct label_manager_chunk *lmc)
+{
+	if (node)
+		listnode_add_before(lbl_mgr.lc_list, node, lmc);
+	else
+		listnode_add(lbl_mgr.lc_list, lmc);
+
+	lm_chunk_starts_add(&lbl_mgr.starts, lmc);
+	if (lmc->proto == NO_PROTO)
+		lm_chunk_free_add(&lbl_mgr.free, lmc);
+	lbl_mgr.chunk_labels += lm_chunk_size(lmc);
+}
+
+static void lm_chunk_unlink(struct listnode *node)
+{
+	struct label_manager_chunk *lmc = listgetdata(node);
+
+	list_delete_node(lbl_mgr.lc_list, node);
+
+	lm_chunk_starts_del(&lbl_mgr.starts, lmc);
+	if (lmc->proto == NO_PROTO)
+		lm_chunk_free_del(&lbl_mgr.free, lmc);
+	lbl_mgr.chunk_labels -= lm_chunk_size(lmc);
+}
+
 /* attempt to get a specific label chunk */
 static struct label_manager_chunk *
 assign_specific_label_chunk(uint8_t proto, unsigned short instance,
@@ -248,7 +309,7 @@ assign_specific_label_chunk(uint8_t proto, unsigned short instance,
 	if (insert_node) {
 		lmc = create_label_chunk(proto, instance, session_id, keep,
 					 base, end);
-		listnode_add_before(lbl_mgr.lc_list, insert_node, lmc);
+		lm_chunk_link(insert_node, lmc);
 		return lmc;
 	}
 
@@ -265,16 +326,13 @@ assign_specific_label_chunk(uint8_t proto, unsigned short instance,
 
 			next = listnextnode(node);
 			death = listgetdata(node);
-			list_delete_node(lbl_mgr.lc_list, node);
+			lm_chunk_unlink(node);
 			delete_label_chunk(death);
 		}
 
 		lmc = create_label_chunk(proto, instance, session_id, keep,
 					 base, end);
-		if (last_node)
-			listnode_add_before(lbl_mgr.lc_list, last_node, lmc);
-		else
-			listnode_add(lbl_mgr.lc_list, lmc);
+		lm_chunk_link(last_node, lmc);
 
 		return lmc;
 	} else {
@@ -282,7 +340,7 @@ assign_specific_label_chunk(uint8_t proto, unsigned short instance,
 		 * tail */
 		lmc = create_label_chunk(proto, instance, session_id, keep,
 					 base, end);
-		listnode_add(lbl_mgr.lc_list, lmc);
+		lm_chunk_link(NULL, lmc);
 		return lmc;
 	}
 }
@@ -290,8 +348,9 @@ assign_specific_label_chunk(uint8_t proto, unsigned short instance,
 /**
  * Core function, assigns label chunks
  *
- * It first searches through the list to check if there's one available
- * (previously released). Otherwise it creates and assigns a new one
+ * It first looks for a chunk of that size available (previously released),
+ * then for a hole between the existing chunks if there may be one. Otherwise
+ * it creates and assigns a new one past the last chunk
  *
  * @param proto Daemon protocol of client, to identify the owner
  * @param instance Instance, to identify the owner
@@ -304,9 +363,10 @@ struct label_manager_chunk *
 assign_label_chunk(uint8_t proto, unsigned short instance, uint32_t session_id,
 		   uint8_t keep, uint32_t size, uint32_t base)
 {
-	struct label_manager_chunk *lmc;
+	struct label_manager_chunk *lmc, ref;
 	struct listnode *node;
 	uint32_t prev_end = MPLS_LABEL_UNRESERVED_MIN;
+	uint32_t start_free;
 
 	/* handle chunks request with a specific base label */
 	if (base != MPLS_LABEL_BASE_ANY)
@@ -317,28 +377,17 @@ assign_label_chunk(uint8_t proto, unsigned short instance, uint32_t session_id,
 	assert(lbl_mgr.lc_list);
 
 	/* first check if there's one available */
-	for (ALL_LIST_ELEMENTS_RO(lbl_mgr.lc_list, node, lmc)) {
-		if (lmc->proto == NO_PROTO
-		    && lmc->end - lmc->start + 1 == size) {
-			lmc->proto = proto;
-			lmc->instance = instance;
-			lmc->session_id = session_id;
-			lmc->keep = keep;
-			return lmc;
-		}
-		/* check if we hadve a "hole" behind us that we can squeeze into
-		 */
-		if ((lmc->start > prev_end) && (lmc->start - prev_end > size)) {
-			lmc = create_label_chunk(proto, instance, session_id,
-						 keep, prev_end + 1,
-						 prev_end + size);
-			listnode_add_before(lbl_mgr.lc_list, node, lmc);
-			return lmc;
-		}
-		prev_end = lmc->end;
+	ref.start = 0;
+	ref.end = size - 1;
+	lmc = lm_chunk_free_find_gteq(&lbl_mgr.free, &ref);
+	if (lmc && lm_chunk_size(lmc) == size) {
+		lm_chunk_free_del(&lbl_mgr.free, lmc);
+		lmc->proto = proto;
+		lmc->instance = instance;
+		lmc->session_id = session_id;
+		lmc->keep = keep;
+		return lmc;
 	}
-	/* otherwise create a new one */
-	uint32_t start_free;
 
 	if (list_isempty(lbl_mgr.lc_list))
 		start_free = MPLS_LABEL_UNRESERVED_MIN;
@@ -348,6 +397,31 @@ assign_label_chunk(uint8_t proto, unsigned short instance, uint32_t session_id,
 				     ->end
 			     + 1;
 
+	/*
+	 * Holes are only left by the chunks requested with a specific base,
+	 * only look for one if there are enough labels missing in the list.
+	 */
+	if (start_free - MPLS_LABEL_UNRESERVED_MIN - lbl_mgr.chunk_labels
+	    >= size) {
+		for (ALL_LIST_ELEMENTS_RO(lbl_mgr.lc_list, node, lmc)) {
+			/* check if we have a "hole" behind us that we can
+			 * squeeze into
+			 */
+			if ((lmc->start > prev_end)
+			    && (lmc->start - prev_end > size)) {
+				lmc = create_label_chunk(proto, instance,
+							 session_id, keep,
+							 prev_end + 1,
+							 prev_end + size);
+				lm_chunk_link(node, lmc);
+				return lmc;
+			}
+			prev_end = lmc->end;
+		}
+	}
+
+	/* otherwise create a new one */
+
 	if (start_free > MPLS_LABEL_UNRESERVED_MAX - size + 1) {
 		flog_err(EC_ZEBRA_LM_EXHAUSTED_LABELS,
 			 "Reached max labels. Start: %u, size: %u", start_free,
@@ -358,7 +432,7 @@ assign_label_chunk(uint8_t proto, unsigned short instance, uint32_t session_id,
 	/* create chunk and link at tail */
 	lmc = create_label_chunk(proto, instance, session_id, keep, start_free,
 				 start_free + size - 1);
-	listnode_add(lbl_mgr.lc_list, lmc);
+	lm_chunk_link(NULL, lmc);
 	return lmc;
 }
 
@@ -393,31 +467,28 @@ static int label_manager_release_label_chunk(struct zserv *client,
 int release_label_chunk(uint8_t proto, unsigned short instance,
 			uint32_t session_id, uint32_t start, uint32_t end)
 {
-	struct listnode *node;
-	struct label_manager_chunk *lmc;
+	struct label_manager_chunk *lmc, ref;
 	int ret = -1;
 
 	/* check that size matches */
 	if (IS_ZEBRA_DEBUG_PACKET)
 		zlog_debug("Releasing label chunk: %u - %u", start, end);
 	/* find chunk and disown */
-	for (ALL_LIST_ELEMENTS_RO(lbl_mgr.lc_list, node, lmc)) {
-		if (lmc->start != start)
-			continue;
-		if (lmc->end != end)
-			continue;
+	ref.start = start;
+	lmc = lm_chunk_starts_find(&lbl_mgr.starts, &ref);
+	if (lmc && lmc->end == end) {
 		if (lmc->proto != proto || lmc->instance != instance ||
 		    lmc->session_id != session_id) {
 			flog_err(EC_ZEBRA_LM_DAEMON_MISMATCH,
 				 "%s: Daemon mismatch!!", __func__);
-			continue;
+		} else {
+			lmc->proto = NO_PROTO;
+			lmc->instance = 0;
+			lmc->session_id = 0;
+			lmc->keep = 0;
+			lm_chunk_free_add(&lbl_mgr.free, lmc);
+			ret = 0;
 		}
-		lmc->proto = NO_PROTO;
-		lmc->instance = 0;
-		lmc->session_id = 0;
-		lmc->keep = 0;
-		ret = 0;
-		break;
 	}
 	if (ret != 0)
 		flog_err(EC_ZEBRA_LM_UNRELEASED_CHUNK,
@@ -485,5 +556,13 @@ int lm_get_chunk_response(struct label_manager_chunk *lmc, struct zserv *client,
 
 void label_manager_close(void)
 {
+	while (lm_chunk_free_pop(&lbl_mgr.free))
+		;
+	while (lm_chunk_starts_pop(&lbl_mgr.starts))
+		;
+	lm_chunk_free_fini(&lbl_mgr.free);
+	lm_chunk_starts_fini(&lbl_mgr.starts);
+	lbl_mgr.chunk_labels = 0;
+
 	list_delete(&lbl_mgr.lc_list);
 }
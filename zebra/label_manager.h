@@ -29,6 +29,7 @@
 #include "lib/linklist.h"
 #include "lib/thread.h"
 #include "lib/hook.h"
+#include "lib/typesafe.h"
 
 #include "zebra/zserv.h"
 
@@ -38,6 +39,9 @@ extern "C" {
 
 #define NO_PROTO 0
 
+PREDECL_HASH(lm_chunk_starts);
+PREDECL_RBTREE_UNIQ(lm_chunk_free);
+
 /*
  * Label chunk struct
  * Client daemon which the chunk belongs to can be identified by a tuple of:
@@ -57,6 +61,10 @@ struct label_manager_chunk {
 	uint8_t keep;
 	uint32_t start; /* First label of the chunk */
 	uint32_t end;   /* Last label of the chunk */
+
+	/* only used for the chunks in the label manager list */
+	struct lm_chunk_starts_item starts_item;
+	struct lm_chunk_free_item free_item;
 };
 
 /* declare hooks for the basic API, so that it can be specialized or served
@@ -106,10 +114,15 @@ void lm_hooks_unregister(void);
 
 /*
  * Main label manager struct
- * Holds a linked list of label chunks.
+ * Holds a linked list of label chunks, sorted by label, as well as an index
+ * of the chunks by first label and one of the unowned chunks by size.
  */
 struct label_manager {
 	struct list *lc_list;
+	struct lm_chunk_starts_head starts;
+	struct lm_chunk_free_head free;
+	/* number of labels in lc_list */
+	uint32_t chunk_labels;
 };
 
 void label_manager_init(void);
@@ -59,6 +59,7 @@
 #include "zebra/zebra_srte.h"
 #include "zebra/zebra_srv6.h"
 #include "zebra/zebra_srv6_vty.h"
+#include "zebra/zebra_rib_snapshot.h"
 
 #define ZEBRA_PTM_SUPPORT
 
@@ -85,6 +86,9 @@ uint32_t nl_rcvbufsize = 4194304;
 
 #define OPTION_V6_RR_SEMANTICS 2000
 #define OPTION_ASIC_OFFLOAD    2001
+#define OPTION_DPLANE_SHARDS   2002
+#define OPTION_RIB_SNAPSHOT    2003
+#define OPTION_NL_READER       2004
 
 /* Command line options. */
 const struct option longopts[] = {
@@ -96,10 +100,13 @@ const struct option longopts[] = {
 	{"vrfdefaultname", required_argument, NULL, 'o'},
 	{"graceful_restart", required_argument, NULL, 'K'},
 	{"asic-offload", optional_argument, NULL, OPTION_ASIC_OFFLOAD},
+	{"rib-snapshot", required_argument, NULL, OPTION_RIB_SNAPSHOT},
 #ifdef HAVE_NETLINK
 	{"vrfwnetns", no_argument, NULL, 'n'},
 	{"nl-bufsize", required_argument, NULL, 's'},
 	{"v6-rr-semantics", no_argument, NULL, OPTION_V6_RR_SEMANTICS},
+	{"dplane-shards", required_argument, NULL, OPTION_DPLANE_SHARDS},
+	{"nl-reader", no_argument, NULL, OPTION_NL_READER},
 #endif /* HAVE_NETLINK */
 	{0}};
 
@@ -151,6 +158,11 @@ static void sigint(void)
 	/* send RA lifetime of 0 before stopping. rfc4861/6.2.5 */
 	rtadv_stop_ra_all();
 
+	/* The routes stay in the kernel, save them for the next start */
+	if (retain_mode)
+		zebra_rib_snapshot_write();
+	zebra_rib_snapshot_finish();
+
 	frr_early_fini();
 
 	/* Stop the opaque module pthread */
@@ -288,8 +300,22 @@ int main(int argc, char **argv)
 	socklen_t dummylen;
 	bool asic_offload = false;
 	bool notify_on_ack = true;
+	unsigned long rib_snapshot = 0;
+
+	/* one or more of each of these per route, keep them out of the general
+	 * purpose allocator; on huge pages with --hugepages
+	 */
+	srcdest_rnode_slab_enable();
+	mtype_slab_enable(MTYPE_RIB_DEST, sizeof(rib_dest_t));
+	mtype_slab_enable(MTYPE_RE, sizeof(struct route_entry));
+	mtype_slab_enable(MTYPE_NEXTHOP, sizeof(struct nexthop));
+	mtype_slab_hugepages(MTYPE_ROUTE_NODE);
+	mtype_slab_hugepages(MTYPE_RIB_DEST);
+	mtype_slab_hugepages(MTYPE_RE);
+	mtype_slab_hugepages(MTYPE_NEXTHOP);
 
 	graceful_restart = 0;
+	zrouter.dplane_shards = 1;
 	vrf_configure_backend(VRF_BACKEND_VRF_LITE);
 
 	frr_preinit(&zebra_di, argc, argv);
@@ -309,10 +335,13 @@ int main(int argc, char **argv)
 		"  -o, --vrfdefaultname     Set default VRF name.\n"
 		"  -K, --graceful_restart   Graceful restart at the kernel level, timer in seconds for expiration\n"
 		"  -A, --asic-offload       FRR is interacting with an asic underneath the linux kernel\n"
+		"      --rib-snapshot       Interval in seconds for saving the RIB for warm restarts\n"
 #ifdef HAVE_NETLINK
 		"  -n, --vrfwnetns          Use NetNS as VRF backend\n"
 		"  -s, --nl-bufsize         Set netlink receive buffer size\n"
 		"      --v6-rr-semantics    Use v6 RR semantics\n"
+		"      --dplane-shards      Number of parallel kernel dataplane shards\n"
+		"      --nl-reader          Receive kernel messages on a separate pthread\n"
 #endif /* HAVE_NETLINK */
 	);
 
@@ -364,6 +393,14 @@ int main(int argc, char **argv)
 		case 'K':
 			graceful_restart = atoi(optarg);
 			break;
+		case OPTION_RIB_SNAPSHOT:
+			rib_snapshot = strtoul(optarg, NULL, 10);
+			if (rib_snapshot == 0) {
+				fprintf(stderr,
+					"RIB snapshot interval must be at least 1 second\n");
+				exit(1);
+			}
+			break;
 #ifdef HAVE_NETLINK
 		case 's':
 			nl_rcvbufsize = atoi(optarg);
@@ -381,6 +418,21 @@ int main(int argc, char **argv)
 				notify_on_ack = true;
 			asic_offload = true;
 			break;
+		case OPTION_DPLANE_SHARDS: {
+			unsigned long int shards = strtoul(optarg, NULL, 10);
+
+			if (shards == 0 || shards > ZEBRA_DPLANE_SHARDS_MAX) {
+				fprintf(stderr,
+					"Dataplane shards must be between 1 and %u\n",
+					ZEBRA_DPLANE_SHARDS_MAX);
+				exit(1);
+			}
+			zrouter.dplane_shards = shards;
+			break;
+		}
+		case OPTION_NL_READER:
+			zrouter.netlink_reader = true;
+			break;
 #endif /* HAVE_NETLINK */
 		default:
 			frr_help_exit(1);
@@ -401,6 +453,14 @@ int main(int argc, char **argv)
 	 * Initialize NS( and implicitly the VRF module), and make kernel
 	 * routing socket. */
 	zebra_ns_init((const char *)vrf_default_name_configured);
+
+	/* Put back what we had before restarting, now that the kernel has
+	 * been read.
+	 */
+	zebra_rib_snapshot_init(MIN(rib_snapshot, UINT_MAX));
+	if (graceful_restart)
+		zebra_rib_snapshot_restore();
+
 	router_id_cmd_init();
 	zebra_vty_init();
 	access_list_init();
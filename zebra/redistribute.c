@@ -190,6 +190,10 @@ void redistribute_update(const struct prefix *p, const struct prefix *src_p,
 {
 	struct listnode *node, *nnode;
 	struct zserv *client;
+	struct zserv_redist_msg add = ZSERV_REDIST_MSG_INIT(
+		ZEBRA_REDISTRIBUTE_ROUTE_ADD, p, src_p, re);
+	struct zserv_redist_msg del = ZSERV_REDIST_MSG_INIT(
+		ZEBRA_REDISTRIBUTE_ROUTE_DEL, p, src_p, prev_re);
 	int afi;
 
 	if (IS_ZEBRA_DEBUG_RIB)
@@ -222,12 +226,13 @@ void redistribute_update(const struct prefix *p, const struct prefix *src_p,
 					re->vrf_id, re->table, re->type,
 					re->distance, re->metric);
 			}
-			zsend_redistribute_route(ZEBRA_REDISTRIBUTE_ROUTE_ADD,
-						 client, p, src_p, re);
+			zsend_redistribute_route_msg(client, &add);
 		} else if (zebra_redistribute_check(prev_re, client, p, afi))
-			zsend_redistribute_route(ZEBRA_REDISTRIBUTE_ROUTE_DEL,
-						 client, p, src_p, prev_re);
+			zsend_redistribute_route_msg(client, &del);
 	}
+
+	zserv_redist_msg_done(&add);
+	zserv_redist_msg_done(&del);
 }
 
 /*
@@ -244,6 +249,8 @@ void redistribute_delete(const struct prefix *p, const struct prefix *src_p,
 {
 	struct listnode *node, *nnode;
 	struct zserv *client;
+	struct zserv_redist_msg del = ZSERV_REDIST_MSG_INIT(
+		ZEBRA_REDISTRIBUTE_ROUTE_DEL, p, src_p, old_re);
 	int afi;
 	vrf_id_t vrfid;
 
@@ -293,9 +300,10 @@ void redistribute_delete(const struct prefix *p, const struct prefix *src_p,
 
 		/* Send a delete for the 'old' re to any subscribed client. */
 		if (zebra_redistribute_check(old_re, client, p, afi))
-			zsend_redistribute_route(ZEBRA_REDISTRIBUTE_ROUTE_DEL,
-						 client, p, src_p, old_re);
+			zsend_redistribute_route_msg(client, &del);
 	}
+
+	zserv_redist_msg_done(&del);
 }
 
 
@@ -45,10 +45,12 @@ extern "C" {
 DECLARE_MGROUP(ZEBRA);
 
 DECLARE_MTYPE(RE);
+DECLARE_MTYPE(RIB_DEST);
 
 enum rnh_type { RNH_NEXTHOP_TYPE, RNH_IMPORT_CHECK_TYPE };
 
 PREDECL_LIST(rnh_list);
+PREDECL_DLIST(rnh_notify);
 
 /* Nexthop structure. */
 struct rnh {
@@ -57,6 +59,7 @@ struct rnh {
 #define ZEBRA_NHT_CONNECTED     0x1
 #define ZEBRA_NHT_DELETED       0x2
 #define ZEBRA_NHT_EXACT_MATCH   0x4
+#define ZEBRA_NHT_NOTIFY_PENDING 0x8
 
 	/* VRF identifier. */
 	vrf_id_t vrf_id;
@@ -82,12 +85,16 @@ struct rnh {
 	int filtered[ZEBRA_ROUTE_MAX];
 
 	struct rnh_list_item rnh_list_item;
+
+	/* on the list of rnh's waiting for their clients to be notified */
+	struct rnh_notify_item rnh_notify_item;
 };
 
 #define DISTANCE_INFINITY  255
 #define ZEBRA_KERNEL_TABLE_MAX 252 /* support for no more than this rt tables */
 
 PREDECL_LIST(re_list);
+PREDECL_DLIST(re_type_list);
 
 struct opaque {
 	uint16_t length;
@@ -98,6 +105,12 @@ struct route_entry {
 	/* Link list. */
 	struct re_list_item next;
 
+	/* Routes of the same type in the table, see rib_table_info */
+	struct re_type_list_item type_item;
+
+	/* The route node this entry is linked to */
+	struct route_node *rn;
+
 	/* Nexthop group, shared/refcounted, based on the nexthop(s)
 	 * provided by the owner of the route
 	 */
@@ -185,11 +198,30 @@ struct route_entry {
  * sub-queue 6: iBGP, eBGP
  * sub-queue 7: any other origin (if any) typically those that
  *              don't generate routes
+ *
+ * Sub-queue 0 is always served first; the others take turns, each getting
+ * to process up to its weight in entries per turn, see meta_queue_process().
  */
 #define MQ_SIZE 8
+
+/* queueing latency buckets: < 1ms, < 4ms, ... < 4s, longer */
+#define MQ_LAT_BUCKETS 8
+
 struct meta_queue {
 	struct list *subq[MQ_SIZE];
 	uint32_t size; /* sum of lengths of all subqueues */
+
+	/* sub-queue being served and what is left of its turn */
+	uint8_t cur;
+	uint16_t credit;
+
+	/* Latency is sampled: the entry marked here is timed until it is
+	 * dequeued, then the next one enqueued gets marked.
+	 */
+	struct listnode *mark[MQ_SIZE];
+	struct timeval mark_time[MQ_SIZE];
+	uint64_t dequeued[MQ_SIZE];
+	uint64_t lat_hist[MQ_SIZE][MQ_LAT_BUCKETS];
 };
 
 /*
@@ -233,6 +265,7 @@ typedef struct rib_dest_t_ {
 
 DECLARE_LIST(rnh_list, struct rnh, rnh_list_item);
 DECLARE_LIST(re_list, struct route_entry, next);
+DECLARE_DLIST(re_type_list, struct route_entry, type_item);
 
 #define RIB_ROUTE_QUEUED(x)	(1 << (x))
 // If MQ_SIZE is modified this value needs to be updated.
@@ -330,6 +363,13 @@ struct rib_table_info {
 	afi_t afi;
 	safi_t safi;
 	uint32_t table_id;
+
+	/*
+	 * Routes linked in the table, by type, so that a sweep of one
+	 * client's routes or a kernel route update doesn't have to walk
+	 * the whole table.
+	 */
+	struct re_type_list_head type_routes[ZEBRA_ROUTE_MAX];
 };
 
 enum rib_tables_iter_state {
@@ -478,6 +518,8 @@ int zebra_rib_queue_evpn_rem_vtep_del(vrf_id_t vrf_id, vni_t vni,
 				      struct in_addr vtep_ip);
 
 extern void meta_queue_free(struct meta_queue *mq);
+extern void meta_queue_vrf_free(struct meta_queue *mq, struct zebra_vrf *zvrf);
+extern void meta_queue_show(struct vty *vty, struct meta_queue *mq);
 extern int zebra_rib_labeled_unicast(struct route_entry *re);
 extern struct route_table *rib_table_ipv6;
 
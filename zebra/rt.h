@@ -99,6 +99,13 @@ extern void neigh_read_for_vlan(struct zebra_ns *zns, struct interface *ifp);
 extern void neigh_read_specific_ip(const struct ipaddr *ip,
 				   struct interface *vlan_if);
 extern void route_read(struct zebra_ns *zns);
+
+/*
+ * Forget which routes were found in the kernel at startup, so that all
+ * further installs are sent to the kernel again.
+ */
+extern void kernel_fib_shadow_flush(void);
+
 extern int kernel_upd_mac_nh(uint32_t nh_id, struct in_addr vtep_ip);
 extern int kernel_del_mac_nh(uint32_t nh_id);
 extern int kernel_upd_mac_nhg(uint32_t nhg_id, uint32_t nh_cnt,
@@ -107,8 +114,12 @@ extern int kernel_del_mac_nhg(uint32_t nhg_id);
 
 /*
  * Message batching interface.
+ *
+ * 'more' tells the kernel code that further contexts are queued already.
+ * It may then hold on to some of the contexts until a later call, instead
+ * of returning all of them in ctx_list.
  */
-extern void kernel_update_multi(struct dplane_ctx_q *ctx_list);
+extern void kernel_update_multi(struct dplane_ctx_q *ctx_list, bool more);
 
 #ifdef __cplusplus
 }
@@ -61,6 +61,9 @@
 #include "mpls.h"
 #include "vxlan.h"
 #include "printfrr.h"
+#include "jhash.h"
+#include "frr_pthread.h"
+#include "typesafe.h"
 
 #include "zebra/zapi_msg.h"
 #include "zebra/zebra_ns.h"
@@ -666,6 +669,318 @@ static uint8_t parse_multipath_nexthops_unicast(ns_id_t ns_id,
 	return nhop_num;
 }
 
+/*
+ * Kernel FIB shadow.
+ *
+ * When zebra starts up it finds the routes a previous instance left in the
+ * kernel.  A digest of each of them is kept here until the startup sweep,
+ * and when zebra installs the very same route again, e.g. restored from a
+ * RIB snapshot or re-announced by a client, the write to the kernel is
+ * skipped.  The kernel removes routes on link and address changes without
+ * always telling us, so any such change drops the whole shadow.
+ */
+PREDECL_HASH(fib_shadow);
+
+struct fib_shadow_key {
+	uint32_t table;
+	uint8_t family;
+	uint8_t dst_len;
+	uint8_t src_len;
+	uint8_t pad;
+	uint8_t dst[16];
+	uint8_t src[16];
+};
+
+struct fib_shadow {
+	struct fib_shadow_item item;
+	struct fib_shadow_key key;
+	uint64_t digest;
+};
+
+static int fib_shadow_cmp(const struct fib_shadow *a,
+			  const struct fib_shadow *b)
+{
+	return memcmp(&a->key, &b->key, sizeof(a->key));
+}
+
+static uint32_t fib_shadow_hash(const struct fib_shadow *s)
+{
+	return jhash(&s->key, sizeof(s->key), 0x7f1b5ad0);
+}
+
+DECLARE_HASH(fib_shadow, struct fib_shadow, item, fib_shadow_cmp,
+	     fib_shadow_hash);
+
+DEFINE_MTYPE_STATIC(ZEBRA, FIB_SHADOW, "Kernel FIB shadow");
+
+/* learned on the main pthread, used from the dataplane pthreads */
+static pthread_mutex_t fib_shadow_mtx = PTHREAD_MUTEX_INITIALIZER;
+static struct fib_shadow_head fib_shadow_head = INIT_HASH(fib_shadow_head);
+static atomic_bool fib_shadow_active;
+
+#define FIB_DIGEST_INIT 0xcbf29ce484222325ULL /* FNV-1a */
+#define FIB_DIGEST_PRIME 0x100000001b3ULL
+
+static uint64_t fib_digest_add(uint64_t d, const void *data, size_t len)
+{
+	const uint8_t *p = data;
+
+	while (len--) {
+		d ^= *p++;
+		d *= FIB_DIGEST_PRIME;
+	}
+	return d;
+}
+
+/* Attributes zebra sets on a route, in the order they are digested */
+static const unsigned short fib_route_attrs[] = {
+	RTA_DST,     RTA_SRC,	   RTA_PRIORITY,   RTA_FLOW,
+	RTA_NH_ID,   RTA_OIF,	   RTA_GATEWAY,	   RTA_VIA,
+	RTA_PREFSRC, RTA_METRICS,  RTA_ENCAP_TYPE, RTA_ENCAP,
+	RTA_MULTIPATH,
+};
+
+static const unsigned short fib_nexthop_attrs[] = {
+	RTA_FLOW, RTA_GATEWAY, RTA_VIA, RTA_ENCAP_TYPE, RTA_ENCAP,
+};
+
+static bool fib_digest_attrs(uint64_t *d, struct rtattr *rta, int len,
+			     const unsigned short *types, size_t ntypes,
+			     bool strict);
+
+static bool fib_digest_multipath(uint64_t *d, struct rtattr *rta, bool strict)
+{
+	struct rtnexthop *rtnh = RTA_DATA(rta);
+	int len = RTA_PAYLOAD(rta);
+	uint8_t flags;
+
+	while (len >= (int)sizeof(*rtnh) && rtnh->rtnh_len >= sizeof(*rtnh)
+	       && rtnh->rtnh_len <= len) {
+		flags = rtnh->rtnh_flags & RTNH_F_ONLINK;
+		*d = fib_digest_add(*d, &flags, sizeof(flags));
+		*d = fib_digest_add(*d, &rtnh->rtnh_hops,
+				    sizeof(rtnh->rtnh_hops));
+		*d = fib_digest_add(*d, &rtnh->rtnh_ifindex,
+				    sizeof(rtnh->rtnh_ifindex));
+		if (!fib_digest_attrs(d, RTNH_DATA(rtnh),
+				      rtnh->rtnh_len - sizeof(*rtnh),
+				      fib_nexthop_attrs,
+				      array_size(fib_nexthop_attrs), strict))
+			return false;
+
+		len -= NLMSG_ALIGN(rtnh->rtnh_len);
+		rtnh = RTNH_NEXT(rtnh);
+	}
+	return true;
+}
+
+/*
+ * Kernel dumps carry more attributes than zebra sends (RTA_CACHEINFO,
+ * RTA_PREF, ...), those are ignored.  For messages built by zebra, 'strict'
+ * refuses any attribute that is not digested, since a change to it would
+ * then go unnoticed.
+ */
+static bool fib_digest_attrs(uint64_t *d, struct rtattr *rta, int len,
+			     const unsigned short *types, size_t ntypes,
+			     bool strict)
+{
+	struct rtattr *tb[RTA_MAX + 1] = {};
+	struct rtattr *mxrta[RTAX_MAX + 1];
+	uint32_t mtu = 0;
+	size_t i;
+
+	for (; RTA_OK(rta, len); rta = RTA_NEXT(rta, len)) {
+		for (i = 0; i < ntypes; i++)
+			if (rta->rta_type == types[i])
+				break;
+		if (i < ntypes)
+			tb[rta->rta_type] = rta;
+		else if (strict && rta->rta_type != RTA_TABLE)
+			return false;
+	}
+
+	for (i = 0; i < ntypes; i++) {
+		rta = tb[types[i]];
+		if (!rta)
+			continue;
+
+		*d = fib_digest_add(*d, &rta->rta_type, sizeof(rta->rta_type));
+		if (types[i] == RTA_METRICS) {
+			netlink_parse_rtattr(mxrta, RTAX_MAX, RTA_DATA(rta),
+					     RTA_PAYLOAD(rta));
+			if (mxrta[RTAX_MTU])
+				mtu = *(uint32_t *)RTA_DATA(mxrta[RTAX_MTU]);
+			*d = fib_digest_add(*d, &mtu, sizeof(mtu));
+		} else if (types[i] == RTA_MULTIPATH) {
+			if (!fib_digest_multipath(d, rta, strict))
+				return false;
+		} else {
+			*d = fib_digest_add(*d, &rta->rta_len,
+					    sizeof(rta->rta_len));
+			*d = fib_digest_add(*d, RTA_DATA(rta),
+					    RTA_PAYLOAD(rta));
+		}
+	}
+	return true;
+}
+
+static bool netlink_route_key(struct nlmsghdr *h, struct fib_shadow_key *key)
+{
+	struct rtmsg *rtm = NLMSG_DATA(h);
+	struct rtattr *tb[RTA_MAX + 1];
+	int len;
+
+	len = h->nlmsg_len - NLMSG_LENGTH(sizeof(struct rtmsg));
+	if (len < 0)
+		return false;
+
+	netlink_parse_rtattr(tb, RTA_MAX, RTM_RTA(rtm), len);
+
+	memset(key, 0, sizeof(*key));
+	if (tb[RTA_TABLE])
+		key->table = *(uint32_t *)RTA_DATA(tb[RTA_TABLE]);
+	else
+		key->table = rtm->rtm_table;
+	key->family = rtm->rtm_family;
+	key->dst_len = rtm->rtm_dst_len;
+	key->src_len = rtm->rtm_src_len;
+	if (tb[RTA_DST])
+		memcpy(key->dst, RTA_DATA(tb[RTA_DST]),
+		       MIN(RTA_PAYLOAD(tb[RTA_DST]), sizeof(key->dst)));
+	if (tb[RTA_SRC])
+		memcpy(key->src, RTA_DATA(tb[RTA_SRC]),
+		       MIN(RTA_PAYLOAD(tb[RTA_SRC]), sizeof(key->src)));
+	return true;
+}
+
+static bool netlink_route_digest(struct nlmsghdr *h, bool strict,
+				 uint64_t *digest)
+{
+	struct rtmsg *rtm = NLMSG_DATA(h);
+	uint8_t hdr[8];
+	uint64_t d = FIB_DIGEST_INIT;
+	int len;
+
+	len = h->nlmsg_len - NLMSG_LENGTH(sizeof(struct rtmsg));
+	if (len < 0)
+		return false;
+
+	hdr[0] = rtm->rtm_family;
+	hdr[1] = rtm->rtm_dst_len;
+	hdr[2] = rtm->rtm_src_len;
+	hdr[3] = rtm->rtm_tos;
+	hdr[4] = rtm->rtm_protocol;
+	hdr[5] = rtm->rtm_scope;
+	hdr[6] = rtm->rtm_type;
+	hdr[7] = rtm->rtm_flags & RTNH_F_ONLINK;
+	d = fib_digest_add(d, hdr, sizeof(hdr));
+
+	if (!fib_digest_attrs(&d, RTM_RTA(rtm), len, fib_route_attrs,
+			      array_size(fib_route_attrs), strict))
+		return false;
+
+	*digest = d;
+	return true;
+}
+
+/* A route of ours found in the kernel at startup */
+static void fib_shadow_learn(struct nlmsghdr *h)
+{
+	struct fib_shadow *s, *prev;
+
+	s = XCALLOC(MTYPE_FIB_SHADOW, sizeof(*s));
+	if (!netlink_route_key(h, &s->key)
+	    || !netlink_route_digest(h, false, &s->digest)) {
+		XFREE(MTYPE_FIB_SHADOW, s);
+		return;
+	}
+
+	frr_with_mutex (&fib_shadow_mtx) {
+		prev = fib_shadow_add(&fib_shadow_head, s);
+		if (prev) {
+			/* two routes for one prefix, don't guess */
+			fib_shadow_del(&fib_shadow_head, prev);
+			XFREE(MTYPE_FIB_SHADOW, prev);
+			XFREE(MTYPE_FIB_SHADOW, s);
+		}
+		atomic_store_explicit(&fib_shadow_active, true,
+				      memory_order_relaxed);
+	}
+}
+
+/* The kernel changed a route behind our back */
+static void fib_shadow_forget(struct nlmsghdr *h)
+{
+	struct fib_shadow lookup, *s;
+
+	if (!atomic_load_explicit(&fib_shadow_active, memory_order_relaxed))
+		return;
+	if (!netlink_route_key(h, &lookup.key))
+		return;
+
+	frr_with_mutex (&fib_shadow_mtx) {
+		s = fib_shadow_find(&fib_shadow_head, &lookup);
+		if (s) {
+			fib_shadow_del(&fib_shadow_head, s);
+			XFREE(MTYPE_FIB_SHADOW, s);
+		}
+	}
+}
+
+/*
+ * Is the kernel known to have exactly this route already?  Any other update
+ * for the prefix takes it out of the shadow.
+ */
+static bool fib_shadow_match(struct zebra_dplane_ctx *ctx, int cmd)
+{
+	uint8_t buf[NL_PKT_BUF_SIZE];
+	struct nlmsghdr *h = (struct nlmsghdr *)buf;
+	struct fib_shadow lookup, *s;
+	uint64_t digest = 0;
+	bool valid, match = false;
+
+	if (!atomic_load_explicit(&fib_shadow_active, memory_order_relaxed))
+		return false;
+
+	if (netlink_route_multipath_msg_encode(cmd, ctx, buf, sizeof(buf),
+					       false, false)
+		    <= 0
+	    || !netlink_route_key(h, &lookup.key))
+		return false;
+
+	valid = cmd == RTM_NEWROUTE && netlink_route_digest(h, true, &digest);
+
+	frr_with_mutex (&fib_shadow_mtx) {
+		s = fib_shadow_find(&fib_shadow_head, &lookup);
+		if (s && valid && s->digest == digest)
+			match = true;
+		else if (s) {
+			fib_shadow_del(&fib_shadow_head, s);
+			XFREE(MTYPE_FIB_SHADOW, s);
+		}
+	}
+
+	if (match && IS_ZEBRA_DEBUG_KERNEL)
+		zlog_debug("%s: %pFX is already in the kernel, not sending",
+			   __func__, dplane_ctx_get_dest(ctx));
+	return match;
+}
+
+void kernel_fib_shadow_flush(void)
+{
+	struct fib_shadow *s;
+
+	if (!atomic_load_explicit(&fib_shadow_active, memory_order_relaxed))
+		return;
+
+	frr_with_mutex (&fib_shadow_mtx) {
+		atomic_store_explicit(&fib_shadow_active, false,
+				      memory_order_relaxed);
+		while ((s = fib_shadow_pop(&fib_shadow_head)))
+			XFREE(MTYPE_FIB_SHADOW, s);
+	}
+}
+
 /* Looking up routing table by netlink interface. */
 static int netlink_route_change_read_unicast(struct nlmsghdr *h, ns_id_t ns_id,
 					     int startup)
@@ -754,6 +1069,11 @@ static int netlink_route_change_read_unicast(struct nlmsghdr *h, ns_id_t ns_id,
 	if (rtm->rtm_family == AF_MPLS)
 		return 0;
 
+	if (startup && selfroute)
+		fib_shadow_learn(h);
+	else if (!startup)
+		fib_shadow_forget(h);
+
 	/* Table corresponding to route. */
 	if (tb[RTA_TABLE])
 		table = *(int *)RTA_DATA(tb[RTA_TABLE]);
@@ -1133,52 +1453,59 @@ int netlink_route_change(struct nlmsghdr *h, ns_id_t ns_id, int startup)
 	return 0;
 }
 
-/* Request for specific route information from the kernel */
-static int netlink_request_route(struct zebra_ns *zns, int family, int type)
+/*
+ * The part of netlink_route_change_read_unicast()'s checks at startup that
+ * only needs the message itself, so it can be done by the dump pthreads.
+ */
+static bool netlink_route_read_prefilter(const struct nlmsghdr *h)
 {
-	struct {
-		struct nlmsghdr n;
-		struct rtmsg rtm;
-	} req;
+	const struct rtmsg *rtm = NLMSG_DATA(h);
 
-	/* Form the request, specifying filter (rtattr) if needed. */
-	memset(&req, 0, sizeof(req));
-	req.n.nlmsg_type = type;
-	req.n.nlmsg_flags = NLM_F_ROOT | NLM_F_MATCH | NLM_F_REQUEST;
-	req.n.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
-	req.rtm.rtm_family = family;
+	if (h->nlmsg_type != RTM_NEWROUTE
+	    || h->nlmsg_len < NLMSG_LENGTH(sizeof(struct rtmsg)))
+		return true;
 
-	return netlink_request(&zns->netlink_cmd, &req);
+	switch (rtm->rtm_type) {
+	case RTN_UNICAST:
+	case RTN_BLACKHOLE:
+	case RTN_UNREACHABLE:
+	case RTN_PROHIBIT:
+		break;
+	default:
+		return false;
+	}
+
+	if (rtm->rtm_flags & RTM_F_CLONED)
+		return false;
+	if (rtm->rtm_protocol == RTPROT_REDIRECT
+	    || rtm->rtm_protocol == RTPROT_KERNEL)
+		return false;
+	return true;
 }
 
 /* Routing table read function using netlink interface.  Only called
-   bootstrap time. */
+   bootstrap time.  The IPv4 and IPv6 tables are dumped in parallel. */
 int netlink_route_read(struct zebra_ns *zns)
 {
-	int ret;
-	struct zebra_dplane_info dp_info;
-
-	zebra_dplane_info_from_zns(&dp_info, zns, true /*is_cmd*/);
-
-	/* Get IPv4 routing table. */
-	ret = netlink_request_route(zns, AF_INET, RTM_GETROUTE);
-	if (ret < 0)
-		return ret;
-	ret = netlink_parse_info(netlink_route_change_read_unicast,
-				 &zns->netlink_cmd, &dp_info, 0, 1);
-	if (ret < 0)
-		return ret;
+	struct {
+		struct nlmsghdr n;
+		struct rtmsg rtm;
+	} req[2];
+	void *reqs[2] = {&req[0], &req[1]};
+	int family[2] = {AF_INET, AF_INET6};
+	unsigned int i;
 
-	/* Get IPv6 routing table. */
-	ret = netlink_request_route(zns, AF_INET6, RTM_GETROUTE);
-	if (ret < 0)
-		return ret;
-	ret = netlink_parse_info(netlink_route_change_read_unicast,
-				 &zns->netlink_cmd, &dp_info, 0, 1);
-	if (ret < 0)
-		return ret;
+	memset(&req, 0, sizeof(req));
+	for (i = 0; i < array_size(req); i++) {
+		req[i].n.nlmsg_type = RTM_GETROUTE;
+		req[i].n.nlmsg_flags = NLM_F_ROOT | NLM_F_MATCH | NLM_F_REQUEST;
+		req[i].n.nlmsg_len = NLMSG_LENGTH(sizeof(struct rtmsg));
+		req[i].rtm.rtm_family = family[i];
+	}
 
-	return 0;
+	return netlink_dump_parallel(netlink_route_change_read_unicast,
+				     netlink_route_read_prefilter, zns, reqs,
+				     array_size(reqs), 1);
 }
 
 /*
@@ -2678,6 +3005,13 @@ netlink_put_route_update_msg(struct nl_batch *bth, struct zebra_dplane_ctx *ctx)
 	int cmd;
 	const struct prefix *p = dplane_ctx_get_dest(ctx);
 
+	if (!RSYSTEM_ROUTE(dplane_ctx_get_type(ctx))
+	    && fib_shadow_match(ctx, dplane_ctx_get_op(ctx)
+						     == DPLANE_OP_ROUTE_DELETE
+					     ? RTM_DELROUTE
+					     : RTM_NEWROUTE))
+		return FRR_NETLINK_SUCCESS;
+
 	if (dplane_ctx_get_op(ctx) == DPLANE_OP_ROUTE_DELETE) {
 		cmd = RTM_DELROUTE;
 	} else if (dplane_ctx_get_op(ctx) == DPLANE_OP_ROUTE_INSTALL) {
@@ -426,4 +426,8 @@ int kernel_del_mac_nhg(uint32_t nhg_id)
 	return 0;
 }
 
+void kernel_fib_shadow_flush(void)
+{
+}
+
 #endif /* !HAVE_NETLINK */
@@ -73,6 +73,7 @@ DEFINE_MTYPE_STATIC(ZEBRA, ADV_IF, "Advertised Interface");
 
 DEFINE_MTYPE_STATIC(ZEBRA, RTADV_RDNSS, "Router Advertisement RDNSS");
 DEFINE_MTYPE_STATIC(ZEBRA, RTADV_DNSSL, "Router Advertisement DNSSL");
+DEFINE_MTYPE_STATIC(ZEBRA, RTADV_RA, "Router Advertisement packet");
 
 /* Order is intentional.  Matches RFC4191.  This array is also used for
    command matching, so only modify with care. */
@@ -171,67 +172,66 @@ static int rtadv_recv_packet(struct zebra_vrf *zvrf, int sock, uint8_t *buf,
 
 #define RTADV_MSG_SIZE 4096
 
-/* Send router advertisement packet. */
-static void rtadv_send_packet(int sock, struct interface *ifp,
-			      enum ipv6_nd_suppress_ra_status stop)
-{
-	struct msghdr msg;
-	struct iovec iov;
-	struct cmsghdr *cmsgptr;
-	struct in6_pktinfo *pkt;
+/* RAs handed to the kernel per sendmmsg() call */
+#define RTADV_TX_BATCH 32
+
+/*
+ * Most unsolicited RAs sent per timer tick.  Interfaces beyond that stay due
+ * and go out on the following ticks, so a burst of them - thousands of
+ * interfaces coming up together - is spread out instead of sent all at once,
+ * and keeps that spread on the intervals after.
+ */
+#define RTADV_TX_PER_TICK 256
+
+struct rtadv_tx_batch {
+	int sock;
+	unsigned int count;
 	struct sockaddr_in6 addr;
-	static void *adata = NULL;
-	unsigned char buf[RTADV_MSG_SIZE];
+	struct interface *ifp[RTADV_TX_BATCH];
+	struct mmsghdr msgs[RTADV_TX_BATCH];
+	struct iovec iov[RTADV_TX_BATCH];
+	union {
+		struct cmsghdr hdr;
+		uint8_t buf[CMSG_SPACE(sizeof(struct in6_pktinfo))];
+	} cmsg[RTADV_TX_BATCH];
+};
+
+#ifndef HAVE_SENDMMSG
+struct mmsghdr {
+	struct msghdr msg_hdr;
+	unsigned int msg_len;
+};
+
+static int sendmmsg(int fd, struct mmsghdr *msgs, unsigned int n, int flags)
+{
+	unsigned int i;
+	ssize_t len;
+
+	for (i = 0; i < n; i++) {
+		len = sendmsg(fd, &msgs[i].msg_hdr, flags);
+		if (len < 0)
+			return i ? (int)i : -1;
+		msgs[i].msg_len = len;
+	}
+	return n;
+}
+#endif
+
+/* Make router advertisement message, returns its length. */
+static int rtadv_build_packet(struct interface *ifp, unsigned char *buf,
+			      size_t size, enum ipv6_nd_suppress_ra_status stop)
+{
 	struct nd_router_advert *rtadv;
-	int ret;
 	int len = 0;
 	struct zebra_if *zif;
 	struct rtadv_prefix *rprefix;
-	uint8_t all_nodes_addr[] = {0xff, 0x02, 0, 0, 0, 0, 0, 0,
-				    0,    0,    0, 0, 0, 0, 0, 1};
 	struct listnode *node;
 	uint16_t pkt_RouterLifetime;
 
-	/*
-	 * Allocate control message bufffer.  This is dynamic because
-	 * CMSG_SPACE is not guaranteed not to call a function.  Note that
-	 * the size will be different on different architectures due to
-	 * differing alignment rules.
-	 */
-	if (adata == NULL) {
-		/* XXX Free on shutdown. */
-		adata = calloc(1, CMSG_SPACE(sizeof(struct in6_pktinfo)));
-
-		if (adata == NULL) {
-			zlog_debug(
-				"rtadv_send_packet: can't malloc control data");
-			exit(-1);
-		}
-	}
-
-	/* Logging of packet. */
-	if (IS_ZEBRA_DEBUG_PACKET) {
-		struct vrf *vrf = vrf_lookup_by_id(ifp->vrf_id);
-
-		zlog_debug("%s(%s:%u): Tx RA, socket %u", ifp->name,
-			   VRF_LOGNAME(vrf), ifp->ifindex, sock);
-	}
-
-	/* Fill in sockaddr_in6. */
-	memset(&addr, 0, sizeof(struct sockaddr_in6));
-	addr.sin6_family = AF_INET6;
-#ifdef SIN6_LEN
-	addr.sin6_len = sizeof(struct sockaddr_in6);
-#endif /* SIN6_LEN */
-	addr.sin6_port = htons(IPPROTO_ICMPV6);
-	IPV6_ADDR_COPY(&addr.sin6_addr, all_nodes_addr);
-
 	/* Fetch interface information. */
 	zif = ifp->info;
 
-	/* Make router advertisement message. */
 	rtadv = (struct nd_router_advert *)buf;
-
 	rtadv->nd_ra_type = ND_ROUTER_ADVERT;
 	rtadv->nd_ra_code = 0;
 	rtadv->nd_ra_cksum = 0;
@@ -377,7 +377,7 @@ static void rtadv_send_packet(int sock, struct interface *ifp,
 	 * to exceed the link's MTU (risking fragmentation) or even
 	 * blow the stack buffer allocated for it.
 	 */
-	size_t max_len = MIN(ifp->mtu6 - 40, sizeof(buf));
+	size_t max_len = MIN(ifp->mtu6 - 40, size);
 
 	/* Recursive DNS servers */
 	struct rtadv_rdnss *rdnss;
@@ -444,18 +444,124 @@ static void rtadv_send_packet(int sock, struct interface *ifp,
 	}
 
 no_more_opts:
+	return len;
+}
 
-	msg.msg_name = (void *)&addr;
-	msg.msg_namelen = sizeof(struct sockaddr_in6);
-	msg.msg_iov = &iov;
-	msg.msg_iovlen = 1;
-	msg.msg_control = (void *)adata;
-	msg.msg_controllen = CMSG_SPACE(sizeof(struct in6_pktinfo));
-	msg.msg_flags = 0;
-	iov.iov_base = buf;
-	iov.iov_len = len;
+void rtadv_ra_changed(struct zebra_if *zif)
+{
+	XFREE(MTYPE_RTADV_RA, zif->rtadv.ra_cache);
+	zif->rtadv.ra_cache_len = 0;
+}
+
+/*
+ * The unsolicited RA of an interface only changes along with its
+ * configuration, prefixes, MTU or hardware address, so it is built once and
+ * sent as is until one of these changes.
+ */
+static const uint8_t *rtadv_ra_cached(struct interface *ifp, int *len)
+{
+	struct zebra_if *zif = ifp->info;
+	struct rtadvconf *rtadv = &zif->rtadv;
+	unsigned char buf[RTADV_MSG_SIZE];
+
+	if (rtadv->ra_cache
+	    && (rtadv->ra_cache_mtu != ifp->mtu6
+		|| rtadv->ra_cache_hwaddr_len != ifp->hw_addr_len
+		|| memcmp(rtadv->ra_cache_hwaddr, ifp->hw_addr,
+			  ifp->hw_addr_len)))
+		rtadv_ra_changed(zif);
 
-	cmsgptr = CMSG_FIRSTHDR(&msg);
+	if (!rtadv->ra_cache) {
+		rtadv->ra_cache_len =
+			rtadv_build_packet(ifp, buf, sizeof(buf), RA_ENABLE);
+		rtadv->ra_cache = XMALLOC(MTYPE_RTADV_RA, rtadv->ra_cache_len);
+		memcpy(rtadv->ra_cache, buf, rtadv->ra_cache_len);
+
+		rtadv->ra_cache_mtu = ifp->mtu6;
+		rtadv->ra_cache_hwaddr_len = ifp->hw_addr_len;
+		memcpy(rtadv->ra_cache_hwaddr, ifp->hw_addr, ifp->hw_addr_len);
+	}
+
+	*len = rtadv->ra_cache_len;
+	return rtadv->ra_cache;
+}
+
+/* Send the RAs queued up by rtadv_tx_add(), as few syscalls as it takes. */
+static void rtadv_tx_flush(struct rtadv_tx_batch *batch)
+{
+	struct interface *ifp;
+	struct zebra_if *zif;
+	unsigned int i = 0;
+	int ret;
+
+	while (i < batch->count) {
+		ret = sendmmsg(batch->sock, &batch->msgs[i], batch->count - i,
+			       0);
+		if (ret <= 0) {
+			/* the first one not sent is the one that failed */
+			ifp = batch->ifp[i++];
+			flog_err_sys(EC_LIB_SOCKET,
+				     "%s(%u): Tx RA failed, socket %u error %d (%s)",
+				     ifp->name, ifp->ifindex, batch->sock,
+				     errno, safe_strerror(errno));
+			continue;
+		}
+
+		for (; ret > 0; ret--, i++) {
+			zif = batch->ifp[i]->info;
+			zif->ra_sent++;
+		}
+	}
+
+	batch->count = 0;
+}
+
+/*
+ * Queue up an RA to send on an interface.  'buf' has to stay put until
+ * the batch is flushed.
+ */
+static void rtadv_tx_add(struct rtadv_tx_batch *batch, struct interface *ifp,
+			 const uint8_t *buf, int len)
+{
+	uint8_t all_nodes_addr[] = {0xff, 0x02, 0, 0, 0, 0, 0, 0,
+				    0,    0,    0, 0, 0, 0, 0, 1};
+	unsigned int i = batch->count;
+	struct msghdr *msg = &batch->msgs[i].msg_hdr;
+	struct cmsghdr *cmsgptr;
+	struct in6_pktinfo *pkt;
+
+	/* Logging of packet. */
+	if (IS_ZEBRA_DEBUG_PACKET) {
+		struct vrf *vrf = vrf_lookup_by_id(ifp->vrf_id);
+
+		zlog_debug("%s(%s:%u): Tx RA, socket %u", ifp->name,
+			   VRF_LOGNAME(vrf), ifp->ifindex, batch->sock);
+	}
+
+	/* Fill in sockaddr_in6, shared by the whole batch. */
+	if (i == 0) {
+		memset(&batch->addr, 0, sizeof(struct sockaddr_in6));
+		batch->addr.sin6_family = AF_INET6;
+#ifdef SIN6_LEN
+		batch->addr.sin6_len = sizeof(struct sockaddr_in6);
+#endif /* SIN6_LEN */
+		batch->addr.sin6_port = htons(IPPROTO_ICMPV6);
+		IPV6_ADDR_COPY(&batch->addr.sin6_addr, all_nodes_addr);
+	}
+
+	batch->ifp[i] = ifp;
+	batch->iov[i].iov_base = (void *)buf;
+	batch->iov[i].iov_len = len;
+
+	memset(&batch->msgs[i], 0, sizeof(batch->msgs[i]));
+	msg->msg_name = (void *)&batch->addr;
+	msg->msg_namelen = sizeof(struct sockaddr_in6);
+	msg->msg_iov = &batch->iov[i];
+	msg->msg_iovlen = 1;
+	msg->msg_control = (void *)batch->cmsg[i].buf;
+	msg->msg_controllen = CMSG_SPACE(sizeof(struct in6_pktinfo));
+
+	cmsgptr = CMSG_FIRSTHDR(msg);
 	cmsgptr->cmsg_len = CMSG_LEN(sizeof(struct in6_pktinfo));
 	cmsgptr->cmsg_level = IPPROTO_IPV6;
 	cmsgptr->cmsg_type = IPV6_PKTINFO;
@@ -464,14 +570,38 @@ no_more_opts:
 	memset(&pkt->ipi6_addr, 0, sizeof(struct in6_addr));
 	pkt->ipi6_ifindex = ifp->ifindex;
 
-	ret = sendmsg(sock, &msg, 0);
-	if (ret < 0) {
-		flog_err_sys(EC_LIB_SOCKET,
-			     "%s(%u): Tx RA failed, socket %u error %d (%s)",
-			     ifp->name, ifp->ifindex, sock, errno,
-			     safe_strerror(errno));
+	if (++batch->count == RTADV_TX_BATCH)
+		rtadv_tx_flush(batch);
+}
+
+/* Send router advertisement packet. */
+static void rtadv_send_packet(int sock, struct interface *ifp,
+			      enum ipv6_nd_suppress_ra_status stop)
+{
+	struct rtadv_tx_batch batch = {.sock = sock};
+	unsigned char buf[RTADV_MSG_SIZE];
+	const uint8_t *pkt;
+	int len;
+
+	/* the final RA, with a zero lifetime, isn't worth caching */
+	if (stop == RA_SUPPRESS) {
+		len = rtadv_build_packet(ifp, buf, sizeof(buf), stop);
+		pkt = buf;
 	} else
-		zif->ra_sent++;
+		pkt = rtadv_ra_cached(ifp, &len);
+
+	rtadv_tx_add(&batch, ifp, pkt, len);
+	rtadv_tx_flush(&batch);
+}
+
+static void rtadv_timer_send(struct rtadv_tx_batch *batch,
+			     struct interface *ifp)
+{
+	const uint8_t *pkt;
+	int len;
+
+	pkt = rtadv_ra_cached(ifp, &len);
+	rtadv_tx_add(batch, ifp, pkt, len);
 }
 
 static int rtadv_timer(struct thread *thread)
@@ -480,6 +610,8 @@ static int rtadv_timer(struct thread *thread)
 	struct vrf *vrf;
 	struct interface *ifp;
 	struct zebra_if *zif;
+	struct rtadv_tx_batch batch = {.sock = zvrf->rtadv.sock};
+	unsigned int budget = RTADV_TX_PER_TICK;
 	int period;
 
 	zvrf->rtadv.ra_timer = NULL;
@@ -504,6 +636,9 @@ static int rtadv_timer(struct thread *thread)
 			if (zif->rtadv.AdvSendAdvertisements) {
 				if (zif->rtadv.inFastRexmit
 				    && zif->rtadv.UseFastRexmit) {
+					if (!budget)
+						continue;
+
 					/* We assume we fast rexmit every sec so
 					 * no
 					 * additional vars */
@@ -523,11 +658,12 @@ static int rtadv_timer(struct thread *thread)
 							ifp->ifindex);
 					}
 
-					rtadv_send_packet(zvrf->rtadv.sock, ifp,
-							  RA_ENABLE);
+					rtadv_timer_send(&batch, ifp);
+					budget--;
 				} else {
 					zif->rtadv.AdvIntervalTimer -= period;
-					if (zif->rtadv.AdvIntervalTimer <= 0) {
+					if (zif->rtadv.AdvIntervalTimer <= 0
+					    && budget) {
 						/* FIXME: using
 						   MaxRtrAdvInterval each
 						   time isn't what section
@@ -536,14 +672,14 @@ static int rtadv_timer(struct thread *thread)
 						zif->rtadv.AdvIntervalTimer =
 							zif->rtadv
 								.MaxRtrAdvInterval;
-						rtadv_send_packet(
-							zvrf->rtadv.sock, ifp,
-							RA_ENABLE);
+						rtadv_timer_send(&batch, ifp);
+						budget--;
 					}
 				}
 			}
 		}
 
+	rtadv_tx_flush(&batch);
 	return 0;
 }
 
@@ -1114,6 +1250,7 @@ static void rtadv_prefix_set(struct zebra_if *zif, struct rtadv_prefix *rp)
 	struct rtadv_prefix *rprefix;
 
 	rprefix = rtadv_prefix_get(zif->rtadv.AdvPrefixList, &rp->prefix);
+	rtadv_ra_changed(zif);
 
 	/*
 	 * Set parameters based on where the prefix is created.
@@ -1150,6 +1287,7 @@ static int rtadv_prefix_reset(struct zebra_if *zif, struct rtadv_prefix *rp)
 
 	rprefix = rtadv_prefix_lookup(zif->rtadv.AdvPrefixList, &rp->prefix);
 	if (rprefix != NULL) {
+		rtadv_ra_changed(zif);
 
 		/*
 		 * When deleting an address from the list, need to take care
@@ -1327,6 +1465,7 @@ static void zebra_interface_radv_set(ZAPI_HANDLER_ARGS, int enable)
 		if (!CHECK_FLAG(zif->rtadv.ra_configured, VTY_RA_CONFIGURED))
 			ipv6_nd_suppress_ra_set(ifp, RA_SUPPRESS);
 	}
+	rtadv_ra_changed(zif);
 stream_failure:
 	return;
 }
@@ -1519,6 +1658,7 @@ DEFPY (ipv6_nd_ra_hop_limit,
 	}
 
 	zif->rtadv.AdvCurHopLimit = hopcount;
+	rtadv_ra_changed(zif);
 
 	return CMD_SUCCESS;
 }
@@ -1543,6 +1683,7 @@ DEFPY (no_ipv6_nd_ra_hop_limit,
 	}
 
 	zif->rtadv.AdvCurHopLimit = RTADV_DEFAULT_HOPLIMIT;
+	rtadv_ra_changed(zif);
 
 	return CMD_SUCCESS;
 }
@@ -1566,6 +1707,7 @@ DEFPY (ipv6_nd_ra_retrans_interval,
 	}
 
 	zif->rtadv.AdvRetransTimer = interval;
+	rtadv_ra_changed(zif);
 
 	return CMD_SUCCESS;
 }
@@ -1590,6 +1732,7 @@ DEFPY (no_ipv6_nd_ra_retrans_interval,
 	}
 
 	zif->rtadv.AdvRetransTimer = 0;
+	rtadv_ra_changed(zif);
 
 	return CMD_SUCCESS;
 }
@@ -1680,6 +1823,7 @@ DEFUN (ipv6_nd_ra_interval_msec,
 	zif->rtadv.MaxRtrAdvInterval = interval;
 	zif->rtadv.MinRtrAdvInterval = 0.33 * interval;
 	zif->rtadv.AdvIntervalTimer = 0;
+	rtadv_ra_changed(zif);
 
 	return CMD_SUCCESS;
 }
@@ -1722,6 +1866,7 @@ DEFUN (ipv6_nd_ra_interval,
 	zif->rtadv.MaxRtrAdvInterval = interval;
 	zif->rtadv.MinRtrAdvInterval = 0.33 * interval;
 	zif->rtadv.AdvIntervalTimer = 0;
+	rtadv_ra_changed(zif);
 
 	return CMD_SUCCESS;
 }
@@ -1759,6 +1904,7 @@ DEFUN (no_ipv6_nd_ra_interval,
 
 	zif->rtadv.AdvIntervalTimer = zif->rtadv.MaxRtrAdvInterval;
 	zif->rtadv.MinRtrAdvInterval = RTADV_MIN_RTR_ADV_INTERVAL;
+	rtadv_ra_changed(zif);
 
 	return CMD_SUCCESS;
 }
@@ -1789,6 +1935,7 @@ DEFUN (ipv6_nd_ra_lifetime,
 	}
 
 	zif->rtadv.AdvDefaultLifetime = lifetime;
+	rtadv_ra_changed(zif);
 
 	return CMD_SUCCESS;
 }
@@ -1806,6 +1953,7 @@ DEFUN (no_ipv6_nd_ra_lifetime,
 	struct zebra_if *zif = ifp->info;
 
 	zif->rtadv.AdvDefaultLifetime = -1;
+	rtadv_ra_changed(zif);
 
 	return CMD_SUCCESS;
 }
@@ -1822,6 +1970,7 @@ DEFUN (ipv6_nd_reachable_time,
 	VTY_DECLVAR_CONTEXT(interface, ifp);
 	struct zebra_if *zif = ifp->info;
 	zif->rtadv.AdvReachableTime = strtoul(argv[idx_number]->arg, NULL, 10);
+	rtadv_ra_changed(zif);
 	return CMD_SUCCESS;
 }
 
@@ -1838,6 +1987,7 @@ DEFUN (no_ipv6_nd_reachable_time,
 	struct zebra_if *zif = ifp->info;
 
 	zif->rtadv.AdvReachableTime = 0;
+	rtadv_ra_changed(zif);
 
 	return CMD_SUCCESS;
 }
@@ -1855,6 +2005,7 @@ DEFUN (ipv6_nd_homeagent_preference,
 	struct zebra_if *zif = ifp->info;
 	zif->rtadv.HomeAgentPreference =
 		strtoul(argv[idx_number]->arg, NULL, 10);
+	rtadv_ra_changed(zif);
 	return CMD_SUCCESS;
 }
 
@@ -1871,6 +2022,7 @@ DEFUN (no_ipv6_nd_homeagent_preference,
 	struct zebra_if *zif = ifp->info;
 
 	zif->rtadv.HomeAgentPreference = 0;
+	rtadv_ra_changed(zif);
 
 	return CMD_SUCCESS;
 }
@@ -1887,6 +2039,7 @@ DEFUN (ipv6_nd_homeagent_lifetime,
 	VTY_DECLVAR_CONTEXT(interface, ifp);
 	struct zebra_if *zif = ifp->info;
 	zif->rtadv.HomeAgentLifetime = strtoul(argv[idx_number]->arg, NULL, 10);
+	rtadv_ra_changed(zif);
 	return CMD_SUCCESS;
 }
 
@@ -1903,6 +2056,7 @@ DEFUN (no_ipv6_nd_homeagent_lifetime,
 	struct zebra_if *zif = ifp->info;
 
 	zif->rtadv.HomeAgentLifetime = -1;
+	rtadv_ra_changed(zif);
 
 	return CMD_SUCCESS;
 }
@@ -1918,6 +2072,7 @@ DEFUN (ipv6_nd_managed_config_flag,
 	struct zebra_if *zif = ifp->info;
 
 	zif->rtadv.AdvManagedFlag = 1;
+	rtadv_ra_changed(zif);
 
 	return CMD_SUCCESS;
 }
@@ -1934,6 +2089,7 @@ DEFUN (no_ipv6_nd_managed_config_flag,
 	struct zebra_if *zif = ifp->info;
 
 	zif->rtadv.AdvManagedFlag = 0;
+	rtadv_ra_changed(zif);
 
 	return CMD_SUCCESS;
 }
@@ -1949,6 +2105,7 @@ DEFUN (ipv6_nd_homeagent_config_flag,
 	struct zebra_if *zif = ifp->info;
 
 	zif->rtadv.AdvHomeAgentFlag = 1;
+	rtadv_ra_changed(zif);
 
 	return CMD_SUCCESS;
 }
@@ -1965,6 +2122,7 @@ DEFUN (no_ipv6_nd_homeagent_config_flag,
 	struct zebra_if *zif = ifp->info;
 
 	zif->rtadv.AdvHomeAgentFlag = 0;
+	rtadv_ra_changed(zif);
 
 	return CMD_SUCCESS;
 }
@@ -1980,6 +2138,7 @@ DEFUN (ipv6_nd_adv_interval_config_option,
 	struct zebra_if *zif = ifp->info;
 
 	zif->rtadv.AdvIntervalOption = 1;
+	rtadv_ra_changed(zif);
 
 	return CMD_SUCCESS;
 }
@@ -1996,6 +2155,7 @@ DEFUN (no_ipv6_nd_adv_interval_config_option,
 	struct zebra_if *zif = ifp->info;
 
 	zif->rtadv.AdvIntervalOption = 0;
+	rtadv_ra_changed(zif);
 
 	return CMD_SUCCESS;
 }
@@ -2011,6 +2171,7 @@ DEFUN (ipv6_nd_other_config_flag,
 	struct zebra_if *zif = ifp->info;
 
 	zif->rtadv.AdvOtherConfigFlag = 1;
+	rtadv_ra_changed(zif);
 
 	return CMD_SUCCESS;
 }
@@ -2027,6 +2188,7 @@ DEFUN (no_ipv6_nd_other_config_flag,
 	struct zebra_if *zif = ifp->info;
 
 	zif->rtadv.AdvOtherConfigFlag = 0;
+	rtadv_ra_changed(zif);
 
 	return CMD_SUCCESS;
 }
@@ -2176,6 +2338,7 @@ DEFUN (ipv6_nd_router_preference,
 			    1)
 		    == 0) {
 			zif->rtadv.DefaultPreference = i;
+			rtadv_ra_changed(zif);
 			return CMD_SUCCESS;
 		}
 		i++;
@@ -2202,6 +2365,7 @@ DEFUN (no_ipv6_nd_router_preference,
 		RTADV_PREF_MEDIUM; /* Default per RFC4191. */
 
 	return CMD_SUCCESS;
+	rtadv_ra_changed(zif);
 }
 
 DEFUN (ipv6_nd_mtu,
@@ -2216,6 +2380,7 @@ DEFUN (ipv6_nd_mtu,
 	VTY_DECLVAR_CONTEXT(interface, ifp);
 	struct zebra_if *zif = ifp->info;
 	zif->rtadv.AdvLinkMTU = strtoul(argv[idx_number]->arg, NULL, 10);
+	rtadv_ra_changed(zif);
 	return CMD_SUCCESS;
 }
 
@@ -2231,6 +2396,7 @@ DEFUN (no_ipv6_nd_mtu,
 	VTY_DECLVAR_CONTEXT(interface, ifp);
 	struct zebra_if *zif = ifp->info;
 	zif->rtadv.AdvLinkMTU = 0;
+	rtadv_ra_changed(zif);
 	return CMD_SUCCESS;
 }
 
@@ -2279,6 +2445,7 @@ static void rtadv_rdnss_set(struct zebra_if *zif, struct rtadv_rdnss *rdnss)
 	p = rtadv_rdnss_get(zif->rtadv.AdvRDNSSList, rdnss);
 	p->lifetime = rdnss->lifetime;
 	p->lifetime_set = rdnss->lifetime_set;
+	rtadv_ra_changed(zif);
 }
 
 static int rtadv_rdnss_reset(struct zebra_if *zif, struct rtadv_rdnss *rdnss)
@@ -2287,6 +2454,7 @@ static int rtadv_rdnss_reset(struct zebra_if *zif, struct rtadv_rdnss *rdnss)
 
 	p = rtadv_rdnss_lookup(zif->rtadv.AdvRDNSSList, rdnss);
 	if (p) {
+		rtadv_ra_changed(zif);
 		listnode_delete(zif->rtadv.AdvRDNSSList, p);
 		rtadv_rdnss_free(p);
 		return 1;
@@ -2339,6 +2507,7 @@ static void rtadv_dnssl_set(struct zebra_if *zif, struct rtadv_dnssl *dnssl)
 
 	p = rtadv_dnssl_get(zif->rtadv.AdvDNSSLList, dnssl);
 	memcpy(p, dnssl, sizeof(struct rtadv_dnssl));
+	rtadv_ra_changed(zif);
 }
 
 static int rtadv_dnssl_reset(struct zebra_if *zif, struct rtadv_dnssl *dnssl)
@@ -2347,6 +2516,7 @@ static int rtadv_dnssl_reset(struct zebra_if *zif, struct rtadv_dnssl *dnssl)
 
 	p = rtadv_dnssl_lookup(zif->rtadv.AdvDNSSLList, dnssl);
 	if (p) {
+		rtadv_ra_changed(zif);
 		listnode_delete(zif->rtadv.AdvDNSSLList, p);
 		rtadv_dnssl_free(p);
 		return 1;
@@ -2931,6 +3101,11 @@ void rtadv_delete_prefix(struct zebra_if *zif, const struct prefix *p)
 	/* Empty.*/;
 }
 
+void rtadv_ra_changed(struct zebra_if *zif)
+{
+	/* Empty.*/;
+}
+
 void rtadv_stop_ra(struct interface *ifp)
 {
 	/* Empty.*/;
@@ -35,6 +35,7 @@
 #include "lib/vrf.h"
 #include "lib/libfrr.h"
 #include "lib/lib_errors.h"
+#include "lib/frr_pthread.h"
 
 #include "zebra/zebra_router.h"
 #include "zebra/rib.h"
@@ -61,6 +62,7 @@
 #include "zebra/zebra_opaque.h"
 #include "zebra/zebra_srte.h"
 #include "zebra/zebra_srv6.h"
+#include "zebra/zebra_trace.h"
 
 DEFINE_MTYPE_STATIC(ZEBRA, OPAQUE, "Opaque Data");
 
@@ -189,7 +191,9 @@ int zsend_interface_add(struct zserv *client, struct interface *ifp)
 	zserv_encode_interface(s, ifp);
 
 	client->ifadd_cnt++;
-	return zserv_send_message(client, s);
+	zserv_send_message_packed(client, s);
+	stream_free(s);
+	return 0;
 }
 
 /* Interface deletion from zebra daemon. */
@@ -201,7 +205,9 @@ int zsend_interface_delete(struct zserv *client, struct interface *ifp)
 	zserv_encode_interface(s, ifp);
 
 	client->ifdel_cnt++;
-	return zserv_send_message(client, s);
+	zserv_send_message_packed(client, s);
+	stream_free(s);
+	return 0;
 }
 
 int zsend_vrf_add(struct zserv *client, struct zebra_vrf *zvrf)
@@ -212,7 +218,9 @@ int zsend_vrf_add(struct zserv *client, struct zebra_vrf *zvrf)
 	zserv_encode_vrf(s, zvrf);
 
 	client->vrfadd_cnt++;
-	return zserv_send_message(client, s);
+	zserv_send_message_packed(client, s);
+	stream_free(s);
+	return 0;
 }
 
 /* VRF deletion from zebra daemon. */
@@ -225,7 +233,9 @@ int zsend_vrf_delete(struct zserv *client, struct zebra_vrf *zvrf)
 	zserv_encode_vrf(s, zvrf);
 
 	client->vrfdel_cnt++;
-	return zserv_send_message(client, s);
+	zserv_send_message_packed(client, s);
+	stream_free(s);
+	return 0;
 }
 
 int zsend_interface_link_params(struct zserv *client, struct interface *ifp)
@@ -251,7 +261,9 @@ int zsend_interface_link_params(struct zserv *client, struct interface *ifp)
 	/* Write packet size. */
 	stream_putw_at(s, 0, stream_get_endp(s));
 
-	return zserv_send_message(client, s);
+	zserv_send_message_packed(client, s);
+	stream_free(s);
+	return 0;
 }
 
 /* Interface address is added/deleted. Send ZEBRA_INTERFACE_ADDRESS_ADD or
@@ -330,7 +342,9 @@ int zsend_interface_address(int cmd, struct zserv *client,
 	stream_putw_at(s, 0, stream_get_endp(s));
 
 	client->connected_rt_add_cnt++;
-	return zserv_send_message(client, s);
+	zserv_send_message_packed(client, s);
+	stream_free(s);
+	return 0;
 }
 
 static int zsend_interface_nbr_address(int cmd, struct zserv *client,
@@ -361,7 +375,9 @@ static int zsend_interface_nbr_address(int cmd, struct zserv *client,
 	/* Write packet size. */
 	stream_putw_at(s, 0, stream_get_endp(s));
 
-	return zserv_send_message(client, s);
+	zserv_send_message_packed(client, s);
+	stream_free(s);
+	return 0;
 }
 
 /* Interface address addition. */
@@ -469,7 +485,9 @@ int zsend_interface_vrf_update(struct zserv *client, struct interface *ifp,
 	stream_putw_at(s, 0, stream_get_endp(s));
 
 	client->if_vrfchg_cnt++;
-	return zserv_send_message(client, s);
+	zserv_send_message_packed(client, s);
+	stream_free(s);
+	return 0;
 }
 
 /* Add new nbr connected IPv6 address */
@@ -542,19 +560,19 @@ int zsend_interface_update(int cmd, struct zserv *client, struct interface *ifp)
 	else
 		client->ifdown_cnt++;
 
-	return zserv_send_message(client, s);
+	zserv_send_message_packed(client, s);
+	stream_free(s);
+	return 0;
 }
 
-int zsend_redistribute_route(int cmd, struct zserv *client,
-			     const struct prefix *p,
-			     const struct prefix *src_p,
-			     const struct route_entry *re)
+static struct stream *zapi_redistribute_route_encode(
+	int cmd, const struct prefix *p, const struct prefix *src_p,
+	const struct route_entry *re)
 {
 	struct zapi_route api;
 	struct zapi_nexthop *api_nh;
 	struct nexthop *nexthop;
 	uint8_t count = 0;
-	afi_t afi;
 	size_t stream_size =
 		MAX(ZEBRA_MAX_PACKET_SIZ, sizeof(struct zapi_route));
 
@@ -565,24 +583,6 @@ int zsend_redistribute_route(int cmd, struct zserv *client,
 	api.instance = re->instance;
 	api.flags = re->flags;
 
-	afi = family2afi(p->family);
-	switch (afi) {
-	case AFI_IP:
-		if (cmd == ZEBRA_REDISTRIBUTE_ROUTE_ADD)
-			client->redist_v4_add_cnt++;
-		else
-			client->redist_v4_del_cnt++;
-		break;
-	case AFI_IP6:
-		if (cmd == ZEBRA_REDISTRIBUTE_ROUTE_ADD)
-			client->redist_v6_add_cnt++;
-		else
-			client->redist_v6_del_cnt++;
-		break;
-	default:
-		break;
-	}
-
 	/* Prefix. */
 	api.prefix = *p;
 	if (src_p) {
@@ -643,19 +643,75 @@ int zsend_redistribute_route(int cmd, struct zserv *client,
 
 	struct stream *s = stream_new(stream_size);
 
-	/* Encode route and send. */
+	/* Encode route. */
 	if (zapi_route_encode(cmd, s, &api) < 0) {
 		stream_free(s);
-		return -1;
+		return NULL;
+	}
+
+	return s;
+}
+
+/*
+ * The message does not depend on the client, so it is encoded on first
+ * use and packed with the other small messages of every client it goes to.
+ */
+int zsend_redistribute_route_msg(struct zserv *client,
+				 struct zserv_redist_msg *msg)
+{
+	afi_t afi;
+
+	if (!msg->s) {
+		msg->s = zapi_redistribute_route_encode(msg->cmd, msg->p,
+							msg->src_p, msg->re);
+		if (!msg->s)
+			return -1;
+	}
+
+	afi = family2afi(msg->p->family);
+	switch (afi) {
+	case AFI_IP:
+		if (msg->cmd == ZEBRA_REDISTRIBUTE_ROUTE_ADD)
+			client->redist_v4_add_cnt++;
+		else
+			client->redist_v4_del_cnt++;
+		break;
+	case AFI_IP6:
+		if (msg->cmd == ZEBRA_REDISTRIBUTE_ROUTE_ADD)
+			client->redist_v6_add_cnt++;
+		else
+			client->redist_v6_del_cnt++;
+		break;
+	default:
+		break;
 	}
 
 	if (IS_ZEBRA_DEBUG_SEND)
 		zlog_debug("%s: %s to client %s: type %s, vrf_id %d, p %pFX",
-			   __func__, zserv_command_string(cmd),
+			   __func__, zserv_command_string(msg->cmd),
 			   zebra_route_string(client->proto),
-			   zebra_route_string(api.type), api.vrf_id,
-			   &api.prefix);
-	return zserv_send_message(client, s);
+			   zebra_route_string(msg->re->type), msg->re->vrf_id,
+			   msg->p);
+	return zserv_send_message_packed(client, msg->s);
+}
+
+void zserv_redist_msg_done(struct zserv_redist_msg *msg)
+{
+	stream_free(msg->s);
+	msg->s = NULL;
+}
+
+int zsend_redistribute_route(int cmd, struct zserv *client,
+			     const struct prefix *p,
+			     const struct prefix *src_p,
+			     const struct route_entry *re)
+{
+	struct zserv_redist_msg msg = ZSERV_REDIST_MSG_INIT(cmd, p, src_p, re);
+	int ret;
+
+	ret = zsend_redistribute_route_msg(client, &msg);
+	zserv_redist_msg_done(&msg);
+	return ret;
 }
 
 /*
@@ -746,6 +802,92 @@ int zsend_nhg_notify(uint16_t type, uint16_t instance, uint32_t session_id,
  * Common utility send route notification, called from a path using a
  * route_entry and from a path using a dataplane context.
  */
+static void route_notify_encode(struct stream *s, const struct prefix *p,
+				uint32_t table_id,
+				enum zapi_route_notify_owner note, afi_t afi,
+				safi_t safi)
+{
+	stream_put(s, &note, sizeof(note));
+
+	stream_putc(s, p->family);
+	stream_putc(s, p->prefixlen);
+	stream_put(s, &p->u.prefix, prefix_blen(p));
+
+	stream_putl(s, table_id);
+
+	/* Encode AFI, SAFI in the message */
+	stream_putc(s, afi);
+	stream_putc(s, safi);
+}
+
+/* Largest entry of a ZEBRA_ROUTE_NOTIFY_OWNER_BULK */
+#define ROUTE_NOTIFY_BULK_ENTRY_MAX                                            \
+	(4 + 2 + sizeof(enum zapi_route_notify_owner) + 2                      \
+	 + sizeof(struct in6_addr) + 4 + 2)
+
+static void route_notify_bulk_send(struct zserv *client)
+{
+	struct stream *s = client->notify_bulk;
+
+	THREAD_OFF(client->t_notify_bulk);
+	if (!s)
+		return;
+
+	stream_putw_at(s, ZEBRA_HEADER_SIZE, client->notify_bulk_count);
+	stream_putw_at(s, 0, stream_get_endp(s));
+
+	client->notify_bulk = NULL;
+	client->notify_bulk_count = 0;
+
+	zserv_send_message(client, s);
+}
+
+static int route_notify_bulk_flush(struct thread *thread)
+{
+	route_notify_bulk_send(THREAD_ARG(thread));
+
+	return 0;
+}
+
+/*
+ * Notifications for clients sending routes in bulk are batched up until
+ * the current rib/dataplane results pass is over.
+ */
+static int route_notify_bulk(struct zserv *client, const struct prefix *p,
+			     vrf_id_t vrf_id, uint32_t table_id,
+			     enum zapi_route_notify_owner note, afi_t afi,
+			     safi_t safi)
+{
+	struct stream *s = client->notify_bulk;
+	size_t lenp;
+
+	if (s && (STREAM_WRITEABLE(s) < ROUTE_NOTIFY_BULK_ENTRY_MAX
+		  || client->notify_bulk_count == UINT16_MAX)) {
+		route_notify_bulk_send(client);
+		s = NULL;
+	}
+
+	if (!s) {
+		s = stream_new(ZEBRA_MAX_PACKET_SIZ);
+		zclient_create_header(s, ZEBRA_ROUTE_NOTIFY_OWNER_BULK,
+				      VRF_DEFAULT);
+		stream_putw(s, 0);
+		client->notify_bulk = s;
+	}
+
+	stream_putl(s, vrf_id);
+	lenp = stream_get_endp(s);
+	stream_putw(s, 0);
+	route_notify_encode(s, p, table_id, note, afi, safi);
+	stream_putw_at(s, lenp, stream_get_endp(s) - lenp - 2);
+	client->notify_bulk_count++;
+
+	thread_add_event(zrouter.master, route_notify_bulk_flush, client, 0,
+			 &client->t_notify_bulk);
+
+	return 0;
+}
+
 static int route_notify_internal(const struct prefix *p, int type,
 				 uint16_t instance, vrf_id_t vrf_id,
 				 uint32_t table_id,
@@ -754,7 +896,6 @@ static int route_notify_internal(const struct prefix *p, int type,
 {
 	struct zserv *client;
 	struct stream *s;
-	uint8_t blen;
 
 	client = zserv_find_client(type, instance);
 	if (!client || !client->notify_owner) {
@@ -771,6 +912,10 @@ static int route_notify_internal(const struct prefix *p, int type,
 			"Notifying Owner: %s about prefix %pFX(%u) %d vrf: %u",
 			zebra_route_string(type), p, table_id, note, vrf_id);
 
+	if (client->notify_owner_bulk)
+		return route_notify_bulk(client, p, vrf_id, table_id, note,
+					 afi, safi);
+
 	/* We're just allocating a small-ish buffer here, since we only
 	 * encode a small amount of data.
 	 */
@@ -779,21 +924,7 @@ static int route_notify_internal(const struct prefix *p, int type,
 	stream_reset(s);
 
 	zclient_create_header(s, ZEBRA_ROUTE_NOTIFY_OWNER, vrf_id);
-
-	stream_put(s, &note, sizeof(note));
-
-	stream_putc(s, p->family);
-
-	blen = prefix_blen(p);
-	stream_putc(s, p->prefixlen);
-	stream_put(s, &p->u.prefix, blen);
-
-	stream_putl(s, table_id);
-
-	/* Encode AFI, SAFI in the message */
-	stream_putc(s, afi);
-	stream_putc(s, safi);
-
+	route_notify_encode(s, p, table_id, note, afi, safi);
 	stream_putw_at(s, 0, stream_get_endp(s));
 
 	return zserv_send_message(client, s);
@@ -1331,6 +1462,8 @@ static void zread_fec_register(ZAPI_HANDLER_ARGS)
 		return;
 	}
 
+	zebra_mpls_fec_batch_begin(client);
+
 	while (l < hdr->length) {
 		STREAM_GETW(s, flags);
 		memset(&p, 0, sizeof(p));
@@ -1340,7 +1473,7 @@ static void zread_fec_register(ZAPI_HANDLER_ARGS)
 				EC_ZEBRA_UNKNOWN_FAMILY,
 				"fec_register: Received unknown family type %d",
 				p.family);
-			return;
+			goto stream_failure;
 		}
 		STREAM_GETC(s, p.prefixlen);
 		if ((p.family == AF_INET && p.prefixlen > IPV4_MAX_BITLEN)
@@ -1349,7 +1482,7 @@ static void zread_fec_register(ZAPI_HANDLER_ARGS)
 			zlog_debug(
 				"%s: Specified prefix hdr->length: %d is to long for %d",
 				__func__, p.prefixlen, p.family);
-			return;
+			goto stream_failure;
 		}
 		l += 5;
 		STREAM_GET(&p.u.prefix, s, PSIZE(p.prefixlen));
@@ -1366,7 +1499,7 @@ static void zread_fec_register(ZAPI_HANDLER_ARGS)
 	}
 
 stream_failure:
-	return;
+	zebra_mpls_fec_batch_end();
 }
 
 /* FEC unregister */
@@ -1971,127 +2104,276 @@ static void zread_nhg_add(ZAPI_HANDLER_ARGS)
 
 }
 
-static void zread_route_add(ZAPI_HANDLER_ARGS)
-{
-	struct stream *s;
-	struct zapi_route api;
-	afi_t afi;
-	struct prefix_ipv6 *src_p = NULL;
-	struct route_entry *re;
-	struct nexthop_group *ng = NULL;
-	struct nhg_backup_info *bnhg = NULL;
-	int ret;
-	vrf_id_t vrf_id;
-	struct nhg_hash_entry nhe;
+DEFINE_MTYPE_STATIC(ZEBRA, ZSERV_ROUTE, "ZAPI decoded route");
 
-	s = msg;
-	if (zapi_route_decode(s, &api) < 0) {
+static bool zserv_route_decode(struct stream *s, struct zapi_route *api)
+{
+	if (zapi_route_decode(s, api) < 0) {
 		if (IS_ZEBRA_DEBUG_RECV)
 			zlog_debug("%s: Unable to decode zapi_route sent",
 				   __func__);
-		return;
+		return false;
 	}
 
-	vrf_id = zvrf_id(zvrf);
-
-	if (IS_ZEBRA_DEBUG_RECV)
-		zlog_debug("%s: p=(%u:%u)%pFX, msg flags=0x%x, flags=0x%x",
-			   __func__, vrf_id, api.tableid, &api.prefix,
-			   (int)api.message, api.flags);
-
-	/* Allocate new route. */
-	re = XCALLOC(MTYPE_RE, sizeof(struct route_entry));
-	re->type = api.type;
-	re->instance = api.instance;
-	re->flags = api.flags;
-	re->uptime = monotime(NULL);
-	re->vrf_id = vrf_id;
+	return true;
+}
 
-	if (api.tableid)
-		re->table = api.tableid;
-	else
-		re->table = zvrf->table_id;
+/*
+ * Build the route entry for a decoded route add, without anything that
+ * depends on the vrf.
+ */
+static bool zserv_route_build(struct zserv *client, struct zapi_route *api,
+			      struct zserv_route *zr)
+{
+	struct route_entry *re;
 
-	if (!CHECK_FLAG(api.message, ZAPI_MESSAGE_NHG)
-	    && (!CHECK_FLAG(api.message, ZAPI_MESSAGE_NEXTHOP)
-		|| api.nexthop_num == 0)) {
+	if (!CHECK_FLAG(api->message, ZAPI_MESSAGE_NHG)
+	    && (!CHECK_FLAG(api->message, ZAPI_MESSAGE_NEXTHOP)
+		|| api->nexthop_num == 0)) {
 		flog_warn(
 			EC_ZEBRA_RX_ROUTE_NO_NEXTHOPS,
 			"%s: received a route without nexthops for prefix %pFX from client %s",
-			__func__, &api.prefix,
+			__func__, &api->prefix,
 			zebra_route_string(client->proto));
-
-		XFREE(MTYPE_RE, re);
-		return;
+		return false;
 	}
 
 	/* Report misuse of the backup flag */
-	if (CHECK_FLAG(api.message, ZAPI_MESSAGE_BACKUP_NEXTHOPS)
-	    && api.backup_nexthop_num == 0) {
+	if (CHECK_FLAG(api->message, ZAPI_MESSAGE_BACKUP_NEXTHOPS)
+	    && api->backup_nexthop_num == 0) {
 		if (IS_ZEBRA_DEBUG_RECV || IS_ZEBRA_DEBUG_EVENT)
 			zlog_debug(
 				"%s: client %s: BACKUP flag set but no backup nexthops, prefix %pFX",
 				__func__, zebra_route_string(client->proto),
-				&api.prefix);
+				&api->prefix);
+	}
+
+	/* Allocate new route. */
+	re = XCALLOC(MTYPE_RE, sizeof(struct route_entry));
+	re->type = api->type;
+	re->instance = api->instance;
+	re->flags = api->flags;
+	re->uptime = monotime(NULL);
+
+	if (CHECK_FLAG(api->message, ZAPI_MESSAGE_NHG))
+		re->nhe_id = api->nhgid;
+
+	if (CHECK_FLAG(api->message, ZAPI_MESSAGE_DISTANCE))
+		re->distance = api->distance;
+	if (CHECK_FLAG(api->message, ZAPI_MESSAGE_METRIC))
+		re->metric = api->metric;
+	if (CHECK_FLAG(api->message, ZAPI_MESSAGE_TAG))
+		re->tag = api->tag;
+	if (CHECK_FLAG(api->message, ZAPI_MESSAGE_MTU))
+		re->mtu = api->mtu;
+
+	if (CHECK_FLAG(api->message, ZAPI_MESSAGE_OPAQUE)) {
+		re->opaque = XMALLOC(MTYPE_OPAQUE,
+				     sizeof(struct opaque) + api->opaque.length);
+		re->opaque->length = api->opaque.length;
+		memcpy(re->opaque->data, api->opaque.data, re->opaque->length);
+	}
+
+	zr->re = re;
+	prefix_copy(&zr->prefix, &api->prefix);
+	zr->src_prefix = api->src_prefix;
+	zr->safi = api->safi;
+	zr->message = api->message;
+	zr->tableid = api->tableid;
+
+	return true;
+}
+
+static bool zserv_route_read_nexthops(struct zserv *client,
+				      struct zapi_route *api,
+				      struct zserv_route *zr)
+{
+	if (zr->re->nhe_id)
+		return true;
+
+	if (!zapi_read_nexthops(client, &api->prefix, api->nexthops,
+				api->flags, api->message, api->nexthop_num,
+				api->backup_nexthop_num, &zr->ng, NULL)
+	    || !zapi_read_nexthops(client, &api->prefix, api->backup_nexthops,
+				   api->flags, api->message,
+				   api->backup_nexthop_num,
+				   api->backup_nexthop_num, NULL, &zr->bnhg)) {
+		nexthop_group_delete(&zr->ng);
+		zebra_nhg_backup_free(&zr->bnhg);
+		return false;
 	}
 
-	if (CHECK_FLAG(api.message, ZAPI_MESSAGE_NHG))
-		re->nhe_id = api.nhgid;
+	return true;
+}
+
+/*
+ * Can the nexthops be built away from the main pthread?  EVPN routes
+ * install the router MAC, unnumbered interfaces need the interface list
+ * and label types depend on the client's protocol, which is set by the
+ * main pthread when it processes the client's hello.
+ */
+static bool zserv_route_nexthops_threadsafe(const struct zapi_route *api)
+{
+	const struct zapi_nexthop *api_nh;
+	uint16_t i;
+
+	if (CHECK_FLAG(api->flags, ZEBRA_FLAG_EVPN_ROUTE))
+		return false;
+
+	for (i = 0; i < api->nexthop_num + api->backup_nexthop_num; i++) {
+		if (i < api->nexthop_num)
+			api_nh = &api->nexthops[i];
+		else
+			api_nh = &api->backup_nexthops[i - api->nexthop_num];
+
+		if (CHECK_FLAG(api_nh->flags, ZAPI_NEXTHOP_FLAG_LABEL))
+			return false;
+		if (api_nh->type == NEXTHOP_TYPE_IPV4_IFINDEX
+		    && !CHECK_FLAG(api_nh->flags, ZAPI_NEXTHOP_FLAG_ONLINK))
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Number of routes in a ZEBRA_ROUTE_ADD or ZEBRA_ROUTE_ADD_BULK message.
+ * The client pthread queues a zserv_route for each of them, the main
+ * pthread uses the same count to pick them up again.
+ */
+uint16_t zserv_route_msg_count(struct stream *msg, uint16_t command)
+{
+	size_t len = stream_get_endp(msg);
+	uint16_t count;
+
+	if (len > ZEBRA_MAX_PACKET_SIZ)
+		return 0;
+
+	switch (command) {
+	case ZEBRA_ROUTE_ADD:
+		return 1;
+	case ZEBRA_ROUTE_ADD_BULK:
+		if (len < ZEBRA_HEADER_SIZE + 2)
+			return 0;
+		count = stream_getw_from(msg, ZEBRA_HEADER_SIZE);
+		return MIN(count, len - ZEBRA_HEADER_SIZE - 2);
+	}
+
+	return 0;
+}
+
+void zserv_route_predecode(struct zserv *client, struct stream *msg,
+			   uint16_t command, struct zserv_route_list_head *routes)
+{
+	struct zserv_route *zr;
+	struct zapi_route api;
+	uint16_t i, count;
+	bool decoded = true;
+
+	count = zserv_route_msg_count(msg, command);
+
+	stream_set_getp(msg, ZEBRA_HEADER_SIZE);
+	if (command == ZEBRA_ROUTE_ADD_BULK)
+		stream_forward_getp(msg, 2);
+
+	for (i = 0; i < count; i++) {
+		zr = XCALLOC(MTYPE_ZSERV_ROUTE, sizeof(*zr));
+		zserv_route_list_add_tail(routes, zr);
+
+		/* Can't find the next route after a malformed one */
+		if (!decoded || !(decoded = zserv_route_decode(msg, &api)))
+			continue;
+
+		conv_start(zrouter.conv, api.vrf_id, &api.prefix, 0);
+
+		if (!zserv_route_build(client, &api, zr))
+			continue;
+
+		if (!zserv_route_nexthops_threadsafe(&api)) {
+			zr->api = XMALLOC(MTYPE_ZSERV_ROUTE, sizeof(api));
+			memcpy(zr->api, &api, sizeof(api));
+		} else if (!zserv_route_read_nexthops(client, &api, zr)) {
+			zapi_opaque_free(zr->re->opaque);
+			XFREE(MTYPE_RE, zr->re);
+		}
+	}
+	stream_set_getp(msg, 0);
+}
 
-	if (!re->nhe_id
-	    && (!zapi_read_nexthops(client, &api.prefix, api.nexthops,
-				    api.flags, api.message, api.nexthop_num,
-				    api.backup_nexthop_num, &ng, NULL)
-		|| !zapi_read_nexthops(client, &api.prefix, api.backup_nexthops,
-				       api.flags, api.message,
-				       api.backup_nexthop_num,
-				       api.backup_nexthop_num, NULL, &bnhg))) {
+void zserv_route_free(struct zserv_route **pzr)
+{
+	struct zserv_route *zr = *pzr;
 
-		nexthop_group_delete(&ng);
-		zebra_nhg_backup_free(&bnhg);
-		XFREE(MTYPE_RE, re);
+	if (!zr)
 		return;
+
+	if (zr->re) {
+		zapi_opaque_free(zr->re->opaque);
+		XFREE(MTYPE_RE, zr->re);
 	}
+	nexthop_group_delete(&zr->ng);
+	zebra_nhg_backup_free(&zr->bnhg);
+	XFREE(MTYPE_ZSERV_ROUTE, zr->api);
+	XFREE(MTYPE_ZSERV_ROUTE, *pzr);
+}
+
+/* Hand a decoded ZEBRA_ROUTE_ADD to the rib */
+static void zserv_route_add(struct zserv *client, struct zebra_vrf *zvrf,
+			    struct zserv_route *zr)
+{
+	afi_t afi;
+	struct prefix_ipv6 *src_p = NULL;
+	struct route_entry *re;
+	int ret;
+	vrf_id_t vrf_id;
+	struct nhg_hash_entry nhe;
 
-	if (CHECK_FLAG(api.message, ZAPI_MESSAGE_DISTANCE))
-		re->distance = api.distance;
-	if (CHECK_FLAG(api.message, ZAPI_MESSAGE_METRIC))
-		re->metric = api.metric;
-	if (CHECK_FLAG(api.message, ZAPI_MESSAGE_TAG))
-		re->tag = api.tag;
-	if (CHECK_FLAG(api.message, ZAPI_MESSAGE_MTU))
-		re->mtu = api.mtu;
+	if (!zr->re)
+		return;
 
-	if (CHECK_FLAG(api.message, ZAPI_MESSAGE_OPAQUE)) {
-		re->opaque = XMALLOC(MTYPE_OPAQUE,
-				     sizeof(struct opaque) + api.opaque.length);
-		re->opaque->length = api.opaque.length;
-		memcpy(re->opaque->data, api.opaque.data, re->opaque->length);
+	if (zr->api) {
+		if (!zserv_route_read_nexthops(client, zr->api, zr))
+			return;
+		XFREE(MTYPE_ZSERV_ROUTE, zr->api);
 	}
 
-	afi = family2afi(api.prefix.family);
-	if (afi != AFI_IP6 && CHECK_FLAG(api.message, ZAPI_MESSAGE_SRCPFX)) {
+	vrf_id = zvrf_id(zvrf);
+
+	if (IS_ZEBRA_DEBUG_RECV)
+		zlog_debug("%s: p=(%u:%u)%pFX, msg flags=0x%x, flags=0x%x",
+			   __func__, vrf_id, zr->tableid, &zr->prefix,
+			   (int)zr->message, zr->re->flags);
+
+	afi = family2afi(zr->prefix.family);
+	if (afi != AFI_IP6 && CHECK_FLAG(zr->message, ZAPI_MESSAGE_SRCPFX)) {
 		flog_warn(EC_ZEBRA_RX_SRCDEST_WRONG_AFI,
 			  "%s: Received SRC Prefix but afi is not v6",
 			  __func__);
-		nexthop_group_delete(&ng);
-		zebra_nhg_backup_free(&bnhg);
-		XFREE(MTYPE_RE, re);
 		return;
 	}
-	if (CHECK_FLAG(api.message, ZAPI_MESSAGE_SRCPFX))
-		src_p = &api.src_prefix;
+	if (CHECK_FLAG(zr->message, ZAPI_MESSAGE_SRCPFX))
+		src_p = &zr->src_prefix;
 
-	if (api.safi != SAFI_UNICAST && api.safi != SAFI_MULTICAST) {
+	if (zr->safi != SAFI_UNICAST && zr->safi != SAFI_MULTICAST) {
 		flog_warn(EC_LIB_ZAPI_MISSMATCH,
 			  "%s: Received safi: %d but we can only accept UNICAST or MULTICAST",
-			  __func__, api.safi);
-		nexthop_group_delete(&ng);
-		zebra_nhg_backup_free(&bnhg);
-		XFREE(MTYPE_RE, re);
+			  __func__, zr->safi);
 		return;
 	}
 
+	/* The rib takes over the route entry from here */
+	re = zr->re;
+	zr->re = NULL;
+
+	re->vrf_id = vrf_id;
+	if (zr->tableid)
+		re->table = zr->tableid;
+	else
+		re->table = zvrf->table_id;
+
+	frrtrace(4, frr_zebra, zapi_route_add, client, vrf_id, re->table,
+		 &zr->prefix);
+
 	/*
 	 * If we have an ID, this proto owns the NHG it sent along with the
 	 * route, so we just send the ID into rib code with it.
@@ -2103,23 +2385,15 @@ static void zread_route_add(ZAPI_HANDLER_ARGS)
 	 * and stored.
 	 */
 	if (!re->nhe_id) {
-		zebra_nhe_init(&nhe, afi, ng->nexthop);
-		nhe.nhg.nexthop = ng->nexthop;
-		nhe.backup_info = bnhg;
+		zebra_nhe_init(&nhe, afi, zr->ng->nexthop);
+		nhe.nhg.nexthop = zr->ng->nexthop;
+		nhe.backup_info = zr->bnhg;
 	}
-	ret = rib_add_multipath_nhe(afi, api.safi, &api.prefix, src_p,
+	ret = rib_add_multipath_nhe(afi, zr->safi, &zr->prefix, src_p,
 				    re, &nhe);
 
-	/* At this point, these allocations are not needed: 're' has been
-	 * retained or freed, and if 're' still exists, it is using
-	 * a reference to a shared group object.
-	 */
-	nexthop_group_delete(&ng);
-	if (bnhg)
-		zebra_nhg_backup_free(&bnhg);
-
 	/* Stats */
-	switch (api.prefix.family) {
+	switch (zr->prefix.family) {
 	case AF_INET:
 		if (ret > 0)
 			client->v4_route_add_cnt++;
@@ -2135,6 +2409,54 @@ static void zread_route_add(ZAPI_HANDLER_ARGS)
 	}
 }
 
+/*
+ * Only used for messages that did not go through the client pthread;
+ * those read from the socket are decoded there already.
+ */
+static bool zread_route_add_one(struct zserv *client, struct stream *msg,
+				struct zebra_vrf *zvrf)
+{
+	struct zserv_route zr = {};
+	struct zapi_route api;
+
+	if (!zserv_route_decode(msg, &api))
+		return false;
+
+	conv_start(zrouter.conv, api.vrf_id, &api.prefix, 0);
+
+	if (zserv_route_build(client, &api, &zr)
+	    && zserv_route_read_nexthops(client, &api, &zr))
+		zserv_route_add(client, zvrf, &zr);
+
+	if (zr.re) {
+		zapi_opaque_free(zr.re->opaque);
+		XFREE(MTYPE_RE, zr.re);
+	}
+	nexthop_group_delete(&zr.ng);
+	zebra_nhg_backup_free(&zr.bnhg);
+
+	return true;
+}
+
+static void zread_route_add(ZAPI_HANDLER_ARGS)
+{
+	zread_route_add_one(client, msg, zvrf);
+}
+
+static void zread_route_add_bulk(ZAPI_HANDLER_ARGS)
+{
+	uint16_t count;
+
+	client->notify_owner_bulk = true;
+
+	STREAM_GETW(msg, count);
+	while (count-- && zread_route_add_one(client, msg, zvrf))
+		;
+
+stream_failure:
+	return;
+}
+
 void zapi_opaque_free(struct opaque *opaque)
 {
 	XFREE(MTYPE_OPAQUE, opaque);
@@ -2152,6 +2474,8 @@ static void zread_route_del(ZAPI_HANDLER_ARGS)
 	if (zapi_route_decode(s, &api) < 0)
 		return;
 
+	conv_start(zrouter.conv, zvrf_id(zvrf), &api.prefix, 0);
+
 	afi = family2afi(api.prefix.family);
 	if (afi != AFI_IP6 && CHECK_FLAG(api.message, ZAPI_MESSAGE_SRCPFX)) {
 		flog_warn(EC_ZEBRA_RX_SRCDEST_WRONG_AFI,
@@ -2172,6 +2496,9 @@ static void zread_route_del(ZAPI_HANDLER_ARGS)
 			   __func__, zvrf_id(zvrf), table_id, &api.prefix,
 			   (int)api.message, api.flags);
 
+	frrtrace(4, frr_zebra, zapi_route_delete, client, zvrf_id(zvrf),
+		 table_id, &api.prefix);
+
 	rib_delete(afi, api.safi, zvrf_id(zvrf), api.type, api.instance,
 		   api.flags, &api.prefix, src_p, NULL, 0, table_id, api.metric,
 		   api.distance, false);
@@ -2397,29 +2724,18 @@ done:
  * When the optional ZAPI_LABELS_FTN flag is set, the specified FEC (route) is
  * updated to use the received label(s).
  */
-static void zread_mpls_labels_add(ZAPI_HANDLER_ARGS)
+static void zapi_labels_add(struct zebra_vrf *zvrf, struct zapi_labels *zl)
 {
-	struct stream *s;
-	struct zapi_labels zl;
 	int ret;
 
-	/* Get input stream.  */
-	s = msg;
-	if (zapi_labels_decode(s, &zl) < 0) {
-		if (IS_ZEBRA_DEBUG_RECV)
-			zlog_debug("%s: Unable to decode zapi_labels sent",
-				   __func__);
-		return;
-	}
-
 	if (!mpls_enabled)
 		return;
 
 	/* Validate; will debug on failure */
-	if (zapi_labels_validate(&zl) < 0)
+	if (zapi_labels_validate(zl) < 0)
 		return;
 
-	ret = mpls_zapi_labels_process(true, zvrf, &zl);
+	ret = mpls_zapi_labels_process(true, zvrf, zl);
 	if (ret < 0) {
 		if (IS_ZEBRA_DEBUG_RECV)
 			zlog_debug("%s: Error processing zapi request",
@@ -2437,37 +2753,26 @@ static void zread_mpls_labels_add(ZAPI_HANDLER_ARGS)
  * When the optional ZAPI_LABELS_FTN flag is set, the labels of the specified
  * FEC (route) nexthops are deleted.
  */
-static void zread_mpls_labels_delete(ZAPI_HANDLER_ARGS)
+static void zapi_labels_delete(struct zebra_vrf *zvrf, struct zapi_labels *zl)
 {
-	struct stream *s;
-	struct zapi_labels zl;
 	int ret;
 
-	/* Get input stream.  */
-	s = msg;
-	if (zapi_labels_decode(s, &zl) < 0) {
-		if (IS_ZEBRA_DEBUG_RECV)
-			zlog_debug("%s: Unable to decode zapi_labels sent",
-				   __func__);
-		return;
-	}
-
 	if (!mpls_enabled)
 		return;
 
-	if (zl.nexthop_num > 0) {
-		ret = mpls_zapi_labels_process(false /*delete*/, zvrf, &zl);
+	if (zl->nexthop_num > 0) {
+		ret = mpls_zapi_labels_process(false /*delete*/, zvrf, zl);
 		if (ret < 0) {
 			if (IS_ZEBRA_DEBUG_RECV)
 				zlog_debug("%s: Error processing zapi request",
 					   __func__);
 		}
 	} else {
-		mpls_lsp_uninstall_all_vrf(zvrf, zl.type, zl.local_label);
+		mpls_lsp_uninstall_all_vrf(zvrf, zl->type, zl->local_label);
 
-		if (CHECK_FLAG(zl.message, ZAPI_LABELS_FTN))
-			mpls_ftn_uninstall(zvrf, zl.type, &zl.route.prefix,
-					   zl.route.type, zl.route.instance);
+		if (CHECK_FLAG(zl->message, ZAPI_LABELS_FTN))
+			mpls_ftn_uninstall(zvrf, zl->type, &zl->route.prefix,
+					   zl->route.type, zl->route.instance);
 	}
 }
 
@@ -2483,37 +2788,91 @@ static void zread_mpls_labels_delete(ZAPI_HANDLER_ARGS)
  * the LSP in the forwarding plane if that's supported by the underlying
  * platform.
  */
-static void zread_mpls_labels_replace(ZAPI_HANDLER_ARGS)
+static void zapi_labels_replace(struct zebra_vrf *zvrf, struct zapi_labels *zl)
 {
-	struct stream *s;
-	struct zapi_labels zl;
-
-	/* Get input stream.  */
-	s = msg;
-	if (zapi_labels_decode(s, &zl) < 0) {
-		if (IS_ZEBRA_DEBUG_RECV)
-			zlog_debug("%s: Unable to decode zapi_labels sent",
-				   __func__);
-		return;
-	}
-
 	if (!mpls_enabled)
 		return;
 
 	/* Validate; will debug on failure */
-	if (zapi_labels_validate(&zl) < 0)
+	if (zapi_labels_validate(zl) < 0)
 		return;
 
 	/* This removes everything, then re-adds from the client's
 	 * zapi message. Since the LSP will be processed later, on this
 	 * this same pthread, all of the changes will 'appear' at once.
 	 */
-	mpls_lsp_uninstall_all_vrf(zvrf, zl.type, zl.local_label);
-	if (CHECK_FLAG(zl.message, ZAPI_LABELS_FTN))
-		mpls_ftn_uninstall(zvrf, zl.type, &zl.route.prefix,
-				   zl.route.type, zl.route.instance);
+	mpls_lsp_uninstall_all_vrf(zvrf, zl->type, zl->local_label);
+	if (CHECK_FLAG(zl->message, ZAPI_LABELS_FTN))
+		mpls_ftn_uninstall(zvrf, zl->type, &zl->route.prefix,
+				   zl->route.type, zl->route.instance);
+
+	mpls_zapi_labels_process(true, zvrf, zl);
+}
+
+static void zread_mpls_labels(ZAPI_HANDLER_ARGS)
+{
+	struct zapi_labels zl;
+
+	if (zapi_labels_decode(msg, &zl) < 0) {
+		if (IS_ZEBRA_DEBUG_RECV)
+			zlog_debug("%s: Unable to decode zapi_labels sent",
+				   __func__);
+		return;
+	}
+
+	switch (hdr->command) {
+	case ZEBRA_MPLS_LABELS_ADD:
+		zapi_labels_add(zvrf, &zl);
+		break;
+	case ZEBRA_MPLS_LABELS_DELETE:
+		zapi_labels_delete(zvrf, &zl);
+		break;
+	case ZEBRA_MPLS_LABELS_REPLACE:
+		zapi_labels_replace(zvrf, &zl);
+		break;
+	}
+}
+
+/*
+ * A ZEBRA_MPLS_LABELS_BULK message carries a count and that many
+ * ZEBRA_MPLS_LABELS_ADD/DELETE/REPLACE commands, each followed by its body.
+ */
+static void zread_mpls_labels_bulk(ZAPI_HANDLER_ARGS)
+{
+	struct zapi_labels zl;
+	uint16_t count, cmd;
+
+	STREAM_GETW(msg, count);
+
+	while (count--) {
+		STREAM_GETW(msg, cmd);
+
+		/* Can't find the next entry after a malformed one */
+		if (zapi_labels_decode(msg, &zl) < 0)
+			goto stream_failure;
 
-	mpls_zapi_labels_process(true, zvrf, &zl);
+		switch (cmd) {
+		case ZEBRA_MPLS_LABELS_ADD:
+			zapi_labels_add(zvrf, &zl);
+			break;
+		case ZEBRA_MPLS_LABELS_DELETE:
+			zapi_labels_delete(zvrf, &zl);
+			break;
+		case ZEBRA_MPLS_LABELS_REPLACE:
+			zapi_labels_replace(zvrf, &zl);
+			break;
+		default:
+			if (IS_ZEBRA_DEBUG_RECV)
+				zlog_debug("%s: Unknown command %u in bulk message",
+					   __func__, cmd);
+			return;
+		}
+	}
+	return;
+
+stream_failure:
+	if (IS_ZEBRA_DEBUG_RECV)
+		zlog_debug("%s: Unable to decode zapi_labels sent", __func__);
 }
 
 static void zread_sr_policy_set(ZAPI_HANDLER_ARGS)
@@ -3613,6 +3972,7 @@ void (*const zserv_handlers[])(ZAPI_HANDLER_ARGS) = {
 	[ZEBRA_INTERFACE_DELETE] = zread_interface_delete,
 	[ZEBRA_INTERFACE_SET_PROTODOWN] = zread_interface_set_protodown,
 	[ZEBRA_ROUTE_ADD] = zread_route_add,
+	[ZEBRA_ROUTE_ADD_BULK] = zread_route_add_bulk,
 	[ZEBRA_ROUTE_DELETE] = zread_route_del,
 	[ZEBRA_REDISTRIBUTE_ADD] = zebra_redistribute_add,
 	[ZEBRA_REDISTRIBUTE_DELETE] = zebra_redistribute_delete,
@@ -3637,9 +3997,10 @@ void (*const zserv_handlers[])(ZAPI_HANDLER_ARGS) = {
 	[ZEBRA_INTERFACE_DISABLE_RADV] = zebra_interface_radv_disable,
 	[ZEBRA_SR_POLICY_SET] = zread_sr_policy_set,
 	[ZEBRA_SR_POLICY_DELETE] = zread_sr_policy_delete,
-	[ZEBRA_MPLS_LABELS_ADD] = zread_mpls_labels_add,
-	[ZEBRA_MPLS_LABELS_DELETE] = zread_mpls_labels_delete,
-	[ZEBRA_MPLS_LABELS_REPLACE] = zread_mpls_labels_replace,
+	[ZEBRA_MPLS_LABELS_ADD] = zread_mpls_labels,
+	[ZEBRA_MPLS_LABELS_DELETE] = zread_mpls_labels,
+	[ZEBRA_MPLS_LABELS_REPLACE] = zread_mpls_labels,
+	[ZEBRA_MPLS_LABELS_BULK] = zread_mpls_labels_bulk,
 	[ZEBRA_IPMR_ROUTE_STATS] = zebra_ipmr_route_stats,
 	[ZEBRA_LABEL_MANAGER_CONNECT] = zread_label_manager_request,
 	[ZEBRA_LABEL_MANAGER_CONNECT_ASYNC] = zread_label_manager_request,
@@ -3706,8 +4067,12 @@ void zserv_handle_commands(struct zserv *client, struct stream_fifo *fifo)
 	struct zebra_vrf *zvrf;
 	struct stream *msg;
 	struct stream_fifo temp_fifo;
+	struct zserv_route_list_head routes;
+	struct zserv_route *zr;
+	uint16_t nroutes;
 
 	stream_fifo_init(&temp_fifo);
+	zserv_route_list_init(&routes);
 
 	while (stream_fifo_head(fifo)) {
 		msg = stream_fifo_pop(fifo);
@@ -3723,6 +4088,17 @@ void zserv_handle_commands(struct zserv *client, struct stream_fifo *fifo)
 
 		zapi_parse_header(msg, &hdr);
 
+		/* Route adds were decoded by the client pthread */
+		nroutes = zserv_route_msg_count(msg, hdr.command);
+		if (nroutes) {
+			frr_with_mutex(&client->ibuf_mtx) {
+				while (nroutes--
+				       && (zr = zserv_route_list_pop(
+						   &client->ibuf_routes)))
+					zserv_route_list_add_tail(&routes, zr);
+			}
+		}
+
 		if (IS_ZEBRA_DEBUG_PACKET && IS_ZEBRA_DEBUG_RECV
 		    && IS_ZEBRA_DEBUG_DETAIL)
 			zserv_log_message(NULL, msg, &hdr);
@@ -3757,9 +4133,20 @@ void zserv_handle_commands(struct zserv *client, struct stream_fifo *fifo)
 			goto continue_loop;
 		}
 
-		zserv_handlers[hdr.command](client, &hdr, msg, zvrf);
+		if (zserv_route_list_count(&routes)) {
+			if (hdr.command == ZEBRA_ROUTE_ADD_BULK)
+				client->notify_owner_bulk = true;
+
+			while ((zr = zserv_route_list_pop(&routes))) {
+				zserv_route_add(client, zvrf, zr);
+				zserv_route_free(&zr);
+			}
+		} else
+			zserv_handlers[hdr.command](client, &hdr, msg, zvrf);
 
 continue_loop:
+		while ((zr = zserv_route_list_pop(&routes)))
+			zserv_route_free(&zr);
 		stream_free(msg);
 	}
 
@@ -3768,4 +4155,5 @@ continue_loop:
 		zebra_opaque_enqueue_batch(&temp_fifo);
 
 	stream_fifo_deinit(&temp_fifo);
+	zserv_route_list_fini(&routes);
 }
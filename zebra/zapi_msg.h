@@ -20,6 +20,9 @@
  * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
  */
 
+#ifndef _ZEBRA_ZAPI_MSG_H
+#define _ZEBRA_ZAPI_MSG_H
+
 #include "lib/if.h"
 #include "lib/vrf.h"
 #include "lib/zclient.h"
@@ -49,6 +52,42 @@ extern "C" {
 extern void zserv_handle_commands(struct zserv *client,
 				  struct stream_fifo *fifo);
 
+/*
+ * A route from a ZEBRA_ROUTE_ADD(_BULK) message, decoded by the client
+ * pthread when the message is read.
+ * The nexthops are built there too, unless that needs state owned by the
+ * main pthread; then the decoded zapi_route is kept for the main pthread.
+ */
+struct zserv_route {
+	struct zserv_route_list_item item;
+
+	struct prefix prefix;
+	struct prefix_ipv6 src_prefix;
+	safi_t safi;
+	uint32_t message;
+	uint32_t tableid;
+
+	/* NULL if the message was malformed */
+	struct route_entry *re;
+	struct nexthop_group *ng;
+	struct nhg_backup_info *bnhg;
+
+	struct zapi_route *api;
+};
+
+DECLARE_DLIST(zserv_route_list, struct zserv_route, item);
+
+extern uint16_t zserv_route_msg_count(struct stream *msg, uint16_t command);
+
+/*
+ * Decode a ZEBRA_ROUTE_ADD or ZEBRA_ROUTE_ADD_BULK message onto the list;
+ * called from the client pthread.
+ */
+extern void zserv_route_predecode(struct zserv *client, struct stream *msg,
+				  uint16_t command,
+				  struct zserv_route_list_head *routes);
+extern void zserv_route_free(struct zserv_route **pzr);
+
 extern int zsend_vrf_add(struct zserv *zclient, struct zebra_vrf *zvrf);
 extern int zsend_vrf_delete(struct zserv *zclient, struct zebra_vrf *zvrf);
 extern int zsend_interface_add(struct zserv *zclient, struct interface *ifp);
@@ -69,6 +108,25 @@ extern int zsend_redistribute_route(int cmd, struct zserv *zclient,
 				    const struct prefix *src_p,
 				    const struct route_entry *re);
 
+/* A redistribution message, encoded once for all the clients it goes to */
+struct zserv_redist_msg {
+	int cmd;
+	const struct prefix *p;
+	const struct prefix *src_p;
+	const struct route_entry *re;
+
+	struct stream *s;
+};
+
+#define ZSERV_REDIST_MSG_INIT(c, pfx, src_pfx, r)                              \
+	{                                                                      \
+		.cmd = (c), .p = (pfx), .src_p = (src_pfx), .re = (r),         \
+	}
+
+extern int zsend_redistribute_route_msg(struct zserv *zclient,
+					struct zserv_redist_msg *msg);
+extern void zserv_redist_msg_done(struct zserv_redist_msg *msg);
+
 extern int zsend_router_id_update(struct zserv *zclient, afi_t afi,
 				  struct prefix *p, vrf_id_t vrf_id);
 extern int zsend_interface_vrf_update(struct zserv *zclient,
@@ -127,3 +185,5 @@ extern int zsend_srv6_manager_get_locator_chunk_response(struct zserv *client,
 #ifdef __cplusplus
 }
 #endif
+
+#endif /* _ZEBRA_ZAPI_MSG_H */
@@ -25,8 +25,10 @@
 #include "lib/debug.h"
 #include "lib/frratomic.h"
 #include "lib/frr_pthread.h"
+#include "lib/jhash.h"
 #include "lib/memory.h"
 #include "lib/queue.h"
+#include "lib/typesafe.h"
 #include "lib/zebra.h"
 #include "zebra/zebra_router.h"
 #include "zebra/zebra_dplane.h"
@@ -35,6 +37,7 @@
 #include "zebra/rt.h"
 #include "zebra/debug.h"
 #include "zebra/zebra_pbr.h"
+#include "zebra/zebra_trace.h"
 #include "printfrr.h"
 
 /* Memory type for context blocks */
@@ -281,6 +284,8 @@ struct dplane_gre_ctx {
 	unsigned int mtu;
 	struct zebra_l2info_gre info;
 };
+PREDECL_HASH(dplane_route_pending);
+
 /*
  * The context block used to exchange info about route updates across
  * the boundary between the zebra main context (and pthread) and the
@@ -345,6 +350,12 @@ struct zebra_dplane_ctx {
 
 	/* Embedded list linkage */
 	TAILQ_ENTRY(zebra_dplane_ctx) zd_q_entries;
+
+	/* Newest route update for this prefix still on the incoming queue,
+	 * see dplane_route_coalesce()
+	 */
+	struct dplane_route_pending_item zd_pending_item;
+	bool zd_pending;
 };
 
 /* Flag that can be set by a pre-kernel provider as a signal that an update
@@ -420,6 +431,9 @@ static struct zebra_dplane_globals {
 	/* Update context queue inbound to the dataplane */
 	TAILQ_HEAD(zdg_ctx_q, zebra_dplane_ctx) dg_update_ctx_q;
 
+	/* Route updates on dg_update_ctx_q, by prefix */
+	struct dplane_route_pending_head dg_route_pending;
+
 	/* Ordered list of providers */
 	TAILQ_HEAD(zdg_prov_q, zebra_dplane_provider) dg_providers_q;
 
@@ -440,6 +454,12 @@ static struct zebra_dplane_globals {
 	_Atomic uint32_t dg_routes_in;
 	_Atomic uint32_t dg_routes_queued;
 	_Atomic uint32_t dg_routes_queued_max;
+	/* Kernel operations saved by coalescing queued route updates */
+	_Atomic uint32_t dg_routes_coalesced;
+	/* Updates waiting in the providers' input queues: a provider that
+	 * stops taking work pushes back on zebra through this.
+	 */
+	_Atomic uint32_t dg_prov_queued;
 	_Atomic uint32_t dg_route_errors;
 	_Atomic uint32_t dg_other_errors;
 
@@ -2149,7 +2169,9 @@ void dplane_set_in_queue_limit(uint32_t limit, bool set)
 uint32_t dplane_get_in_queue_len(void)
 {
 	return atomic_load_explicit(&zdplane_info.dg_routes_queued,
-				    memory_order_seq_cst);
+				    memory_order_seq_cst)
+	       + atomic_load_explicit(&zdplane_info.dg_prov_queued,
+				      memory_order_relaxed);
 }
 
 /*
@@ -2159,16 +2181,37 @@ static int dplane_ctx_ns_init(struct zebra_dplane_ctx *ctx,
 			      struct zebra_ns *zns,
 			      bool is_update)
 {
+#if defined(HAVE_NETLINK)
+	struct nlsock *nls;
+#endif
+
 	dplane_info_from_zns(&(ctx->zd_ns_info), zns);
 
 #if defined(HAVE_NETLINK)
+	/*
+	 * Routes are spread over the kernel shards by table, so all updates
+	 * for a prefix go out in order on the same socket.  Everything else
+	 * stays on shard 0.
+	 */
+	if (zrouter.dplane_shards > 1
+	    && (ctx->zd_op == DPLANE_OP_ROUTE_INSTALL
+		|| ctx->zd_op == DPLANE_OP_ROUTE_UPDATE
+		|| ctx->zd_op == DPLANE_OP_ROUTE_DELETE)) {
+		ctx->zd_ns_info.shard =
+			ctx->zd_table_id % zrouter.dplane_shards;
+		ctx->zd_ns_info.nls =
+			*zebra_ns_dplane_sock(zns, ctx->zd_ns_info.shard);
+	}
+
+	nls = zebra_ns_dplane_sock(zns, ctx->zd_ns_info.shard);
+
 	/* Increment message counter after copying to context struct - may need
 	 * two messages in some 'update' cases.
 	 */
 	if (is_update)
-		zns->netlink_dplane.seq += 2;
+		nls->seq += 2;
 	else
-		zns->netlink_dplane.seq++;
+		nls->seq++;
 #endif	/* HAVE_NETLINK */
 
 	return AOK;
@@ -2296,6 +2339,9 @@ int dplane_ctx_route_init(struct zebra_dplane_ctx *ctx, enum dplane_op_e op,
 	{
 		struct nhg_hash_entry *nhe = zebra_nhg_resolve(re->nhe);
 
+		/* the kernel object may be another NHE's */
+		nhe = zebra_nhg_kernel_nhe(nhe);
+
 		ctx->u.rinfo.nhe.id = nhe->id;
 		ctx->u.rinfo.nhe.old_id = 0;
 		/*
@@ -2805,6 +2851,105 @@ dplane_ctx_ipset_entry_init(struct zebra_dplane_ctx *ctx, enum dplane_op_e op,
 }
 
 
+static int dplane_route_pending_cmp(const struct zebra_dplane_ctx *a,
+				    const struct zebra_dplane_ctx *b)
+{
+	int ret;
+
+	if (a->zd_ns_info.ns_id != b->zd_ns_info.ns_id)
+		return numcmp(a->zd_ns_info.ns_id, b->zd_ns_info.ns_id);
+	if (a->zd_vrf_id != b->zd_vrf_id)
+		return numcmp(a->zd_vrf_id, b->zd_vrf_id);
+	if (a->zd_table_id != b->zd_table_id)
+		return numcmp(a->zd_table_id, b->zd_table_id);
+
+	ret = prefix_cmp(&a->u.rinfo.zd_dest, &b->u.rinfo.zd_dest);
+	if (ret)
+		return ret;
+	return prefix_cmp(&a->u.rinfo.zd_src, &b->u.rinfo.zd_src);
+}
+
+static uint32_t dplane_route_pending_hash(const struct zebra_dplane_ctx *ctx)
+{
+	return jhash_3words(ctx->zd_vrf_id, ctx->zd_table_id,
+			    prefix_hash_key(&ctx->u.rinfo.zd_dest),
+			    ctx->zd_ns_info.ns_id);
+}
+
+DECLARE_HASH(dplane_route_pending, struct zebra_dplane_ctx, zd_pending_item,
+	     dplane_route_pending_cmp, dplane_route_pending_hash);
+
+static bool dplane_ctx_is_route_op(const struct zebra_dplane_ctx *ctx)
+{
+	return ctx->zd_op == DPLANE_OP_ROUTE_INSTALL
+	       || ctx->zd_op == DPLANE_OP_ROUTE_UPDATE
+	       || ctx->zd_op == DPLANE_OP_ROUTE_DELETE;
+}
+
+static bool dplane_ctx_is_system_route(const struct zebra_dplane_ctx *ctx)
+{
+	return RSYSTEM_ROUTE(ctx->u.rinfo.zd_type)
+	       || (ctx->zd_is_update && RSYSTEM_ROUTE(ctx->u.rinfo.zd_old_type));
+}
+
+/*
+ * Whether the kernel operation of a queued route update can be left out
+ * because a newer one for the same prefix follows it.  That holds as long as
+ * the newer one does not depend on what the older one did: updates replace
+ * whatever is there and deletes remove it, but an install only works if
+ * nothing was installed.  System routes are left alone, their updates are
+ * special-cased on the old route type.
+ */
+static bool dplane_route_supersedes(const struct zebra_dplane_ctx *old,
+				    const struct zebra_dplane_ctx *new)
+{
+	if (dplane_ctx_is_system_route(old) || dplane_ctx_is_system_route(new))
+		return false;
+
+	if (new->zd_op == DPLANE_OP_ROUTE_INSTALL
+	    && old->zd_op != DPLANE_OP_ROUTE_INSTALL)
+		return false;
+
+	return true;
+}
+
+/*
+ * Coalesce a new route update with one for the same prefix that is still
+ * waiting on the incoming queue.  The older one stays queued so its result
+ * still reaches zebra in order, it just skips the kernel.  Must hold the
+ * dplane lock.
+ */
+static void dplane_route_coalesce(struct zebra_dplane_ctx *ctx)
+{
+	struct zebra_dplane_ctx *prev;
+
+	prev = dplane_route_pending_add(&zdplane_info.dg_route_pending, ctx);
+	if (prev) {
+		if (dplane_route_supersedes(prev, ctx)
+		    && !dplane_ctx_is_skip_kernel(prev)) {
+			dplane_ctx_set_skip_kernel(prev);
+			atomic_fetch_add_explicit(
+				&zdplane_info.dg_routes_coalesced, 1,
+				memory_order_relaxed);
+		}
+
+		dplane_route_pending_del(&zdplane_info.dg_route_pending, prev);
+		prev->zd_pending = false;
+		dplane_route_pending_add(&zdplane_info.dg_route_pending, ctx);
+	}
+	ctx->zd_pending = true;
+}
+
+/* Must hold the dplane lock */
+static void dplane_route_pending_clear(struct zebra_dplane_ctx *ctx)
+{
+	if (!ctx->zd_pending)
+		return;
+
+	dplane_route_pending_del(&zdplane_info.dg_route_pending, ctx);
+	ctx->zd_pending = false;
+}
+
 /*
  * Enqueue a new update,
  * and ensure an event is active for the dataplane pthread.
@@ -2814,9 +2959,16 @@ static int dplane_update_enqueue(struct zebra_dplane_ctx *ctx)
 	int ret = EINVAL;
 	uint32_t high, curr;
 
+	if (dplane_ctx_is_route_op(ctx))
+		conv_stage(zrouter.conv, dplane_ctx_get_vrf(ctx),
+			   dplane_ctx_get_dest(ctx), ZEBRA_CONV_DPLANE_ENQUEUE);
+
 	/* Enqueue for processing by the dataplane pthread */
 	DPLANE_LOCK();
 	{
+		if (dplane_ctx_is_route_op(ctx))
+			dplane_route_coalesce(ctx);
+
 		TAILQ_INSERT_TAIL(&zdplane_info.dg_update_ctx_q, ctx,
 				  zd_q_entries);
 	}
@@ -2828,6 +2980,8 @@ static int dplane_update_enqueue(struct zebra_dplane_ctx *ctx)
 
 	curr++;	/* We got the pre-incremented value */
 
+	frrtrace(2, frr_zebra, dplane_enqueue, ctx, curr);
+
 	/* Maybe update high-water counter also */
 	high = atomic_load_explicit(&zdplane_info.dg_routes_queued_max,
 				    memory_order_seq_cst);
@@ -2881,7 +3035,8 @@ dplane_route_update_internal(struct route_node *rn,
 			ctx->u.rinfo.zd_old_instance = old_re->instance;
 			ctx->u.rinfo.zd_old_distance = old_re->distance;
 			ctx->u.rinfo.zd_old_metric = old_re->metric;
-			ctx->u.rinfo.nhe.old_id = old_re->nhe->id;
+			ctx->u.rinfo.nhe.old_id =
+				zebra_nhg_kernel_nhe(old_re->nhe)->id;
 
 #ifndef HAVE_NETLINK
 			/* For bsd, capture previous re's nexthops too, sigh.
@@ -4317,7 +4472,7 @@ dplane_gre_set(struct interface *ifp, struct interface *ifp_link,
 int dplane_show_helper(struct vty *vty, bool detailed)
 {
 	uint64_t queued, queue_max, limit, errs, incoming, yields,
-		other_errs;
+		other_errs, coalesced;
 
 	/* Using atomics because counters are being changed in different
 	 * pthread contexts.
@@ -4336,6 +4491,8 @@ int dplane_show_helper(struct vty *vty, bool detailed)
 				      memory_order_relaxed);
 	other_errs = atomic_load_explicit(&zdplane_info.dg_other_errors,
 					  memory_order_relaxed);
+	coalesced = atomic_load_explicit(&zdplane_info.dg_routes_coalesced,
+					 memory_order_relaxed);
 
 	vty_out(vty, "Zebra dataplane:\nRoute updates:            %"PRIu64"\n",
 		incoming);
@@ -4344,6 +4501,7 @@ int dplane_show_helper(struct vty *vty, bool detailed)
 	vty_out(vty, "Route update queue limit: %"PRIu64"\n", limit);
 	vty_out(vty, "Route update queue depth: %"PRIu64"\n", queued);
 	vty_out(vty, "Route update queue max:   %"PRIu64"\n", queue_max);
+	vty_out(vty, "Route updates coalesced:  %" PRIu64 "\n", coalesced);
 	vty_out(vty, "Dplane update yields:     %"PRIu64"\n", yields);
 
 	incoming = atomic_load_explicit(&zdplane_info.dg_lsps_in,
@@ -4615,10 +4773,15 @@ struct zebra_dplane_ctx *dplane_provider_dequeue_in_ctx(
 
 		atomic_fetch_sub_explicit(&prov->dp_in_queued, 1,
 					  memory_order_relaxed);
+		atomic_fetch_sub_explicit(&zdplane_info.dg_prov_queued, 1,
+					  memory_order_relaxed);
 	}
 
 	dplane_provider_unlock(prov);
 
+	if (ctx)
+		frrtrace(2, frr_zebra, dplane_provider_dequeue, prov, ctx);
+
 	return ctx;
 }
 
@@ -4641,14 +4804,19 @@ int dplane_provider_dequeue_in_list(struct zebra_dplane_provider *prov,
 			TAILQ_REMOVE(&(prov->dp_ctx_in_q), ctx, zd_q_entries);
 
 			TAILQ_INSERT_TAIL(listp, ctx, zd_q_entries);
+			frrtrace(2, frr_zebra, dplane_provider_dequeue, prov,
+				 ctx);
 		} else {
 			break;
 		}
 	}
 
-	if (ret > 0)
+	if (ret > 0) {
 		atomic_fetch_sub_explicit(&prov->dp_in_queued, ret,
 					  memory_order_relaxed);
+		atomic_fetch_sub_explicit(&zdplane_info.dg_prov_queued, ret,
+					  memory_order_relaxed);
+	}
 
 	dplane_provider_unlock(prov);
 
@@ -4669,6 +4837,8 @@ void dplane_provider_enqueue_out_ctx(struct zebra_dplane_provider *prov,
 {
 	uint64_t curr, high;
 
+	frrtrace(2, frr_zebra, dplane_provider_enqueue, prov, ctx);
+
 	dplane_provider_lock(prov);
 
 	TAILQ_INSERT_TAIL(&(prov->dp_ctx_out_q), ctx,
@@ -4710,6 +4880,7 @@ static void dplane_info_from_zns(struct zebra_dplane_info *ns_info,
 
 #if defined(HAVE_NETLINK)
 	ns_info->is_cmd = true;
+	ns_info->shard = 0;
 	ns_info->nls = zns->netlink_dplane;
 #endif /* NETLINK */
 }
@@ -5089,11 +5260,16 @@ static int kernel_dplane_process_func(struct zebra_dplane_provider *prov)
 			TAILQ_INSERT_TAIL(&work_list, ctx, zd_q_entries);
 	}
 
-	kernel_update_multi(&work_list);
+	kernel_update_multi(&work_list, counter >= limit);
 
 	TAILQ_FOREACH_SAFE (ctx, &work_list, zd_q_entries, tctx) {
 		kernel_dplane_handle_result(ctx);
 
+		if (dplane_ctx_is_route_op(ctx))
+			conv_stage(zrouter.conv, dplane_ctx_get_vrf(ctx),
+				   dplane_ctx_get_dest(ctx),
+				   ZEBRA_CONV_KERNEL_ACK);
+
 		TAILQ_REMOVE(&work_list, ctx, zd_q_entries);
 		dplane_provider_enqueue_out_ctx(prov, ctx);
 	}
@@ -5237,6 +5413,7 @@ int dplane_clean_ctx_queue(bool (*context_cb)(struct zebra_dplane_ctx *ctx,
 		if (context_cb(ctx, val)) {
 			TAILQ_REMOVE(&zdplane_info.dg_update_ctx_q, ctx,
 				     zd_q_entries);
+			dplane_route_pending_clear(ctx);
 			TAILQ_INSERT_TAIL(&work_list, ctx, zd_q_entries);
 		}
 	}
@@ -5445,6 +5622,7 @@ static int dplane_thread_loop(struct thread *event)
 		if (ctx) {
 			TAILQ_REMOVE(&zdplane_info.dg_update_ctx_q, ctx,
 				     zd_q_entries);
+			dplane_route_pending_clear(ctx);
 
 			ctx->zd_provider = prov->dp_id;
 
@@ -5510,6 +5688,8 @@ static int dplane_thread_loop(struct thread *event)
 					  memory_order_relaxed);
 		atomic_fetch_add_explicit(&prov->dp_in_queued, counter,
 					  memory_order_relaxed);
+		atomic_fetch_add_explicit(&zdplane_info.dg_prov_queued, counter,
+					  memory_order_relaxed);
 		curr = atomic_load_explicit(&prov->dp_in_queued,
 					    memory_order_relaxed);
 		high = atomic_load_explicit(&prov->dp_in_max,
@@ -5652,6 +5832,7 @@ static void zebra_dplane_init_internal(void)
 	pthread_mutex_init(&zdplane_info.dg_mutex, NULL);
 
 	TAILQ_INIT(&zdplane_info.dg_update_ctx_q);
+	dplane_route_pending_init(&zdplane_info.dg_route_pending);
 	TAILQ_INIT(&zdplane_info.dg_providers_q);
 
 	zdplane_info.dg_updates_per_cycle = DPLANE_DEFAULT_NEW_WORK;
@@ -637,6 +637,25 @@ void zebra_evpn_svi_macip_del_for_evpn_hash(struct hash_bucket *bucket,
 	return;
 }
 
+/*
+ * On a VLAN-aware bridge the VxLAN device of an access VLAN is known
+ * without walking all the interfaces, see zebra_evpn_vl_vxl_ref().
+ * Returns false if that mapping doesn't apply to br_if.
+ */
+static bool zebra_evpn_map_access_vlan(struct interface *br_if, vlanid_t vid,
+				       zebra_evpn_t **p_zevpn)
+{
+	struct zebra_if *zif;
+
+	zif = zebra_evpn_vl_vxlan_zif(vid);
+	if (!zif || zif->brslave_info.br_if != br_if
+	    || !if_is_operative(zif->ifp))
+		return false;
+
+	*p_zevpn = zebra_evpn_lookup(zif->l2info.vxl.vni);
+	return true;
+}
+
 static int zebra_evpn_map_vlan_ns(struct ns *ns,
 				  void *_in_param,
 				  void **_p_zevpn)
@@ -714,6 +733,10 @@ zebra_evpn_t *zebra_evpn_map_vlan(struct interface *ifp,
 	in_param.zif = zif;
 	p_zevpn = &zevpn;
 
+	if (in_param.bridge_vlan_aware
+	    && zebra_evpn_map_access_vlan(br_if, vid, p_zevpn))
+		return zevpn;
+
 	ns_walk_func(zebra_evpn_map_vlan_ns,
 		     (void *)&in_param,
 		     (void **)p_zevpn);
@@ -815,6 +838,11 @@ zebra_evpn_t *zebra_evpn_from_svi(struct interface *ifp,
 	in_param.br_if = br_if;
 	in_param.zif = zif;
 	p_zevpn = &zevpn;
+
+	if (in_param.bridge_vlan_aware
+	    && zebra_evpn_map_access_vlan(br_if, in_param.vid, p_zevpn))
+		return zevpn;
+
 	/* See if this interface (or interface plus VLAN Id) maps to a VxLAN */
 	ns_walk_func(zebra_evpn_from_svi_ns, (void *)&in_param,
 		     (void **)p_zevpn);
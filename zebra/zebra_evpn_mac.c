@@ -983,8 +983,14 @@ void zebra_evpn_print_mac_hash_detail(struct hash_bucket *bucket, void *ctxt)
 	zebra_evpn_print_mac(mac, vty, json_mac_hdr);
 }
 
+/* Largest ZEBRA_MACIP_ADD / ZEBRA_MACIP_DEL */
+#define MACIP_MSG_MAX                                                          \
+	(ZEBRA_HEADER_SIZE + 4 + ETH_ALEN + 4 + IPV6_MAX_BYTELEN + 1 + 4       \
+	 + sizeof(esi_t))
+
 /*
- * Inform BGP about local MACIP.
+ * Inform BGP about local MACIP.  A move storm makes for a lot of these, so
+ * they are packed together on the way out.
  */
 int zebra_evpn_macip_send_msg_to_client(vni_t vni,
 					const struct ethaddr *macaddr,
@@ -1002,7 +1008,7 @@ int zebra_evpn_macip_send_msg_to_client(vni_t vni,
 	if (!client)
 		return 0;
 
-	s = stream_new(ZEBRA_MAX_PACKET_SIZ);
+	s = stream_new(MACIP_MSG_MAX);
 
 	zclient_create_header(s, cmd, zebra_vrf_get_evpn_id());
 	stream_putl(s, vni);
@@ -1050,7 +1056,9 @@ int zebra_evpn_macip_send_msg_to_client(vni_t vni,
 	else
 		client->macipdel_cnt++;
 
-	return zserv_send_message(client, s);
+	zserv_send_message_packed(client, s);
+	stream_free(s);
+	return 0;
 }
 
 static unsigned int mac_hash_keymake(const void *p)
@@ -531,6 +531,19 @@ static struct zebra_evpn_access_bd *zebra_evpn_acc_vl_find(vlanid_t vid)
 	return acc_bd;
 }
 
+/* Lookup the VxLAN device an access VLAN is mapped to */
+struct zebra_if *zebra_evpn_vl_vxlan_zif(vlanid_t vid)
+{
+	struct zebra_evpn_access_bd *acc_bd;
+
+	if (!zmh_info)
+		return NULL;
+
+	acc_bd = zebra_evpn_acc_vl_find(vid);
+
+	return acc_bd ? acc_bd->vxlan_zif : NULL;
+}
+
 /* A new broadcast domain can be created when a VLAN member or VLAN<=>VxLAN_IF
  * mapping is added.
  */
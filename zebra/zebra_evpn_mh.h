@@ -321,6 +321,7 @@ extern void zebra_evpn_es_set_base_evpn(zebra_evpn_t *zevpn);
 extern void zebra_evpn_es_clear_base_evpn(zebra_evpn_t *zevpn);
 extern void zebra_evpn_vl_vxl_ref(uint16_t vid, struct zebra_if *vxlan_zif);
 extern void zebra_evpn_vl_vxl_deref(uint16_t vid, struct zebra_if *vxlan_zif);
+extern struct zebra_if *zebra_evpn_vl_vxlan_zif(vlanid_t vid);
 extern void zebra_evpn_vl_mbr_ref(uint16_t vid, struct zebra_if *zif);
 extern void zebra_evpn_vl_mbr_deref(uint16_t vid, struct zebra_if *zif);
 extern void zebra_evpn_es_send_all_to_client(bool add);
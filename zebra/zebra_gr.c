@@ -484,14 +484,14 @@ static int32_t zebra_gr_route_stale_delete_timer_expiry(struct thread *thread)
 
 /*
  * Function to process to check if route entry is stale
- * or has been updated.
+ * or has been updated.  Returns true if the entry was stale.
  */
-static void zebra_gr_process_route_entry(struct zserv *client,
+static bool zebra_gr_process_route_entry(struct zserv *client,
 					 struct route_node *rn,
 					 struct route_entry *re)
 {
 	if ((client == NULL) || (rn == NULL) || (re == NULL))
-		return;
+		return false;
 
 	/* If the route is not refreshed after restart, delete the entry */
 	if (re->uptime < client->restart_time) {
@@ -500,21 +500,24 @@ static void zebra_gr_process_route_entry(struct zserv *client,
 				   __func__, zebra_route_string(client->proto),
 				   &rn->p);
 		rib_delnode(rn, re);
+		return true;
 	}
+	return false;
 }
 
 /*
- * This function walks through the route table for all vrf and deletes
- * the stale routes for the restarted client specified by the protocol
- * type
+ * This function walks through the routes of the restarted client's type
+ * in the vrf tables and deletes the stale ones.  Routes linked since the
+ * restart are at the end of the per type lists, and the ones deleted are
+ * unlinked by the time the timer fires again, so each run starts over
+ * from the head of the lists.
  */
 static int32_t zebra_gr_delete_stale_route(struct client_gr_info *info,
 					   struct zebra_vrf *zvrf)
 {
-	struct route_node *rn, *curr;
 	struct route_entry *re;
-	struct route_entry *next;
 	struct route_table *table;
+	struct rib_table_info *table_info;
 	int32_t n = 0;
 	afi_t afi, curr_afi;
 	uint8_t proto;
@@ -540,61 +543,32 @@ static int32_t zebra_gr_delete_stale_route(struct client_gr_info *info,
 	/* Process routes for all AFI */
 	for (afi = curr_afi; afi < AFI_MAX; afi++) {
 		table = zvrf->table[afi][SAFI_UNICAST];
+		if (!table)
+			continue;
+
+		table_info = route_table_get_info(table);
+		frr_each_safe (re_type_list, &table_info->type_routes[proto],
+			       re) {
+			if (CHECK_FLAG(re->status, ROUTE_ENTRY_REMOVED))
+				continue;
+			if (re->instance != instance)
+				continue;
+
+			/* If the route refresh is received after restart
+			 * then do not delete the route
+			 */
+			if (zebra_gr_process_route_entry(s_client, re->rn, re))
+				n++;
 
-		if (table) {
-			/*
-			 * If the current prefix is NULL then get the first
-			 * route entry in the table
+			/* If the max route count is reached then timer
+			 * thread will be restarted; store the current afi
 			 */
-			if (info->current_prefix == NULL) {
-				rn = route_top(table);
-				if (rn == NULL)
-					continue;
-				curr = rn;
-			} else
-				/* Get the next route entry */
-				curr = route_table_get_next(
-					table, info->current_prefix);
-
-			for (rn = curr; rn; rn = srcdest_route_next(rn)) {
-				RNODE_FOREACH_RE_SAFE (rn, re, next) {
-					if (CHECK_FLAG(re->status,
-						       ROUTE_ENTRY_REMOVED))
-						continue;
-					/* If the route refresh is received
-					 * after restart then do not delete
-					 * the route
-					 */
-					if (re->type == proto
-					    && re->instance == instance) {
-						zebra_gr_process_route_entry(
-							s_client, rn, re);
-						n++;
-					}
-
-					/* If the max route count is reached
-					 * then timer thread will be restarted
-					 * Store the current prefix and afi
-					 */
-					if ((n >= ZEBRA_MAX_STALE_ROUTE_COUNT)
-					    && (info->do_delete == false)) {
-						info->current_afi = afi;
-						info->current_prefix = XCALLOC(
-							MTYPE_TMP,
-							sizeof(struct prefix));
-						prefix_copy(
-							info->current_prefix,
-							&rn->p);
-						return n;
-					}
-				}
+			if ((n >= ZEBRA_MAX_STALE_ROUTE_COUNT)
+			    && (info->do_delete == false)) {
+				info->current_afi = afi;
+				return n;
 			}
 		}
-		/*
-		 * Reset the current prefix to indicate processing completion
-		 * of the current AFI
-		 */
-		XFREE(MTYPE_TMP, info->current_prefix);
 	}
 	return 0;
 }
@@ -180,8 +180,20 @@ static int zebra_mlag_client_msg_handler(struct thread *event)
 		 * write to MCLAGD
 		 */
 		if (len > 0) {
-			hook_call(zebra_mlag_private_write_data,
-				  mlag_wr_buffer, len);
+			int rc = hook_call(zebra_mlag_private_write_data,
+					   mlag_wr_buffer, len);
+
+			if (rc == len) {
+				atomic_fetch_add_explicit(
+					&zrouter.mlag_info.wr_msgs, 1,
+					memory_order_relaxed);
+				atomic_fetch_add_explicit(
+					&zrouter.mlag_info.wr_bytes, len,
+					memory_order_relaxed);
+			} else
+				atomic_fetch_add_explicit(
+					&zrouter.mlag_info.wr_errors, 1,
+					memory_order_relaxed);
 
 			/*
 			 * If message type is De-register, send a signal to main
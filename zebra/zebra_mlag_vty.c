@@ -44,6 +44,17 @@ DEFUN_HIDDEN (show_mlag,
 
 	vty_out(vty, "MLag is configured to: %s\n",
 		mlag_role2str(zrouter.mlag_info.role, buf, sizeof(buf)));
+	if (zrouter.mlag_info.mlag_fifo)
+		vty_out(vty, "MLag write queue: %zu messages\n",
+			stream_fifo_count_safe(zrouter.mlag_info.mlag_fifo));
+	vty_out(vty, "MLag written: %u messages, %" PRIu64
+		" bytes, %u errors\n",
+		atomic_load_explicit(&zrouter.mlag_info.wr_msgs,
+				     memory_order_relaxed),
+		atomic_load_explicit(&zrouter.mlag_info.wr_bytes,
+				     memory_order_relaxed),
+		atomic_load_explicit(&zrouter.mlag_info.wr_errors,
+				     memory_order_relaxed));
 
 	return CMD_SUCCESS;
 }
@@ -442,6 +442,37 @@ static int fec_change_update_lsp(struct zebra_vrf *zvrf, zebra_fec_t *fec,
 /*
  * Inform about FEC to a registered client.
  */
+/*
+ * While a client's FEC register message is handled, the label bindings sent
+ * back to it are packed into as few ZEBRA_FEC_UPDATE messages as possible.
+ */
+static struct {
+	struct zserv *client;
+	struct stream *s;
+} fec_batch;
+
+/* the largest FEC update entry: family, prefix length, prefix and label */
+#define FEC_UPDATE_ENTRY_MAX (2 + 1 + IPV6_MAX_BYTELEN + 4)
+
+void zebra_mpls_fec_batch_begin(struct zserv *client)
+{
+	fec_batch.client = client;
+}
+
+void zebra_mpls_fec_batch_end(void)
+{
+	struct zserv *client = fec_batch.client;
+	struct stream *s = fec_batch.s;
+
+	fec_batch.client = NULL;
+	fec_batch.s = NULL;
+	if (!s)
+		return;
+
+	stream_putw_at(s, 0, stream_get_endp(s));
+	zserv_send_message(client, s);
+}
+
 static int fec_send(zebra_fec_t *fec, struct zserv *client)
 {
 	struct stream *s;
@@ -449,6 +480,24 @@ static int fec_send(zebra_fec_t *fec, struct zserv *client)
 
 	rn = fec->rn;
 
+	if (client == fec_batch.client) {
+		s = fec_batch.s;
+		if (s && STREAM_WRITEABLE(s) < FEC_UPDATE_ENTRY_MAX) {
+			zebra_mpls_fec_batch_end();
+			fec_batch.client = client;
+			s = NULL;
+		}
+		if (!s) {
+			s = fec_batch.s = stream_new(ZEBRA_MAX_PACKET_SIZ);
+			zclient_create_header(s, ZEBRA_FEC_UPDATE,
+					      VRF_DEFAULT);
+		}
+		stream_putw(s, rn->p.family);
+		stream_put_prefix(s, &rn->p);
+		stream_putl(s, fec->label);
+		return 0;
+	}
+
 	/* Get output stream. */
 	s = stream_new(ZEBRA_MAX_PACKET_SIZ);
 
@@ -892,6 +941,63 @@ static void lsp_schedule(struct hash_bucket *bucket, void *ctxt)
 	(void)lsp_processq_add(lsp);
 }
 
+/* A connected route change, as seen by lsp_schedule_prefix() */
+struct lsp_schedule_ctx {
+	vrf_id_t vrf_id;
+	const struct prefix *p;
+};
+
+/*
+ * Could the resolution of this nexthop change with the connected routes
+ * under ctx->p?  Anything that doesn't resolve through a gateway address is
+ * assumed to be affected.
+ */
+static bool nhlfe_affected_by(const zebra_nhlfe_t *nhlfe,
+			      const struct lsp_schedule_ctx *ctx)
+{
+	const struct nexthop *nexthop = nhlfe->nexthop;
+	struct prefix gw = {};
+
+	if (!nexthop)
+		return false;
+
+	switch (nexthop->type) {
+	case NEXTHOP_TYPE_IPV4:
+	case NEXTHOP_TYPE_IPV4_IFINDEX:
+		gw.family = AF_INET;
+		gw.prefixlen = IPV4_MAX_BITLEN;
+		gw.u.prefix4 = nexthop->gate.ipv4;
+		break;
+	case NEXTHOP_TYPE_IPV6:
+	case NEXTHOP_TYPE_IPV6_IFINDEX:
+		gw.family = AF_INET6;
+		gw.prefixlen = IPV6_MAX_BITLEN;
+		gw.u.prefix6 = nexthop->gate.ipv6;
+		break;
+	default:
+		return true;
+	}
+
+	return nexthop->vrf_id == ctx->vrf_id && prefix_match(ctx->p, &gw);
+}
+
+/*
+ * Schedule an LSP for processing only if one of its NHLFEs could be
+ * affected by the connected route change described by ctxt.
+ */
+static void lsp_schedule_prefix(struct hash_bucket *bucket, void *ctxt)
+{
+	zebra_lsp_t *lsp = bucket->data;
+	zebra_nhlfe_t *nhlfe;
+
+	frr_each (nhlfe_list, &lsp->nhlfe_list, nhlfe) {
+		if (nhlfe_affected_by(nhlfe, ctxt)) {
+			lsp_schedule(bucket, NULL);
+			return;
+		}
+	}
+}
+
 /*
  * Process a LSP entry that is in the queue. Recalculate best NHLFE and
  * any multipaths and update or delete from the kernel, as needed.
@@ -3654,6 +3760,20 @@ void zebra_mpls_lsp_schedule(struct zebra_vrf *zvrf)
 	hash_iterate(zvrf->lsp_table, lsp_schedule, NULL);
 }
 
+/*
+ * Schedule the MPLS label forwarding entries whose nexthops resolve, or
+ * may resolve, through the connected route p in vrf_id.
+ */
+void zebra_mpls_lsp_schedule_prefix(struct zebra_vrf *zvrf, vrf_id_t vrf_id,
+				    const struct prefix *p)
+{
+	struct lsp_schedule_ctx ctx = {.vrf_id = vrf_id, .p = p};
+
+	if (!zvrf)
+		return;
+	hash_iterate(zvrf->lsp_table, lsp_schedule_prefix, &ctx);
+}
+
 /*
  * Display MPLS label forwarding table for a specific LSP
  * (VTY command handler).
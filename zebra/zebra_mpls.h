@@ -214,6 +214,13 @@ int zebra_mpls_fec_register(struct zebra_vrf *zvrf, struct prefix *p,
 			    uint32_t label, uint32_t label_index,
 			    struct zserv *client);
 
+/*
+ * Label bindings sent to the client between these go out packed in
+ * ZEBRA_FEC_UPDATE messages, for registrations of many FECs at once.
+ */
+void zebra_mpls_fec_batch_begin(struct zserv *client);
+void zebra_mpls_fec_batch_end(void);
+
 /*
  * Deregistration from a client for the label binding for a FEC. The FEC
  * itself is deleted if no other registered clients exist and there is no
@@ -368,6 +375,13 @@ void zebra_mpls_process_dplane_notify(struct zebra_dplane_ctx *ctx);
  */
 void zebra_mpls_lsp_schedule(struct zebra_vrf *zvrf);
 
+/*
+ * Schedule only the MPLS label forwarding entries whose nexthops may
+ * resolve through the connected route p in vrf_id.
+ */
+void zebra_mpls_lsp_schedule_prefix(struct zebra_vrf *zvrf, vrf_id_t vrf_id,
+				    const struct prefix *p);
+
 /*
  * Display MPLS label forwarding table for a specific LSP
  * (VTY command handler).
@@ -43,10 +43,13 @@
 #include "zebra_dplane.h"
 #include "zebra/interface.h"
 #include "zebra/zapi_msg.h"
+#include "zebra/zebra_trace.h"
 
 DEFINE_MTYPE_STATIC(ZEBRA, NHG, "Nexthop Group Entry");
 DEFINE_MTYPE_STATIC(ZEBRA, NHG_CONNECTED, "Nexthop Group Connected");
 DEFINE_MTYPE_STATIC(ZEBRA, NHG_CTX, "Nexthop Group Context");
+DEFINE_MTYPE_STATIC(ZEBRA, NHG_ID_INDEX, "Nexthop Group ID index");
+DEFINE_MTYPE_STATIC(ZEBRA, NHG_KERNEL_KEY, "Nexthop Group kernel object");
 
 /* Map backup nexthop indices between two nhes */
 struct backup_nh_map_s {
@@ -80,6 +83,8 @@ static void depends_decrement_free(struct nhg_connected_tree_head *head);
 static struct nhg_backup_info *
 nhg_backup_copy(const struct nhg_backup_info *orig);
 
+static void zebra_nhg_kernel_release(struct nhg_hash_entry *nhe);
+
 /* Helper function for getting the next allocatable ID */
 static uint32_t nhg_get_next_id(void)
 {
@@ -318,6 +323,159 @@ struct nhg_hash_entry *zebra_nhg_lookup_id(uint32_t id)
 	return hash_lookup(zrouter.nhgs_id, &lookup);
 }
 
+/*
+ * Copy of zrouter.nhgs_id for lookups from other pthreads.  It's an open
+ * addressing table with linear probing; only the main pthread changes it,
+ * slots are published with release stores and a table that has run out of
+ * free slots is replaced as a whole, the old one going away through RCU.
+ * Removed entries leave a tombstone so that probe sequences stay intact.
+ */
+#define NHG_ID_INDEX_MIN 64
+#define NHG_ID_TOMBSTONE ((uintptr_t)1)
+
+struct nhg_id_index {
+	struct rcu_head rcu_head;
+
+	uint32_t mask;
+	/* live entries, and live entries plus tombstones */
+	uint32_t count;
+	uint32_t used;
+
+	atomic_uintptr_t slots[];
+};
+
+static _Atomic uintptr_t nhg_id_index;
+
+static struct nhg_id_index *nhg_id_index_alloc(uint32_t size)
+{
+	struct nhg_id_index *idx;
+
+	idx = XCALLOC(MTYPE_NHG_ID_INDEX,
+		      sizeof(*idx) + size * sizeof(idx->slots[0]));
+	idx->mask = size - 1;
+	return idx;
+}
+
+static void nhg_id_index_put(struct nhg_id_index *idx,
+			     struct nhg_hash_entry *nhe)
+{
+	uint32_t i = jhash_1word(nhe->id, 0) & idx->mask;
+	uintptr_t cur;
+
+	/* ids are unique in zrouter.nhgs_id, so the first reusable slot
+	 * will do
+	 */
+	for (;; i = (i + 1) & idx->mask) {
+		cur = atomic_load_explicit(&idx->slots[i],
+					   memory_order_relaxed);
+		if (!cur || cur == NHG_ID_TOMBSTONE)
+			break;
+	}
+
+	if (!cur)
+		idx->used++;
+	idx->count++;
+	atomic_store_explicit(&idx->slots[i], (uintptr_t)nhe,
+			      memory_order_release);
+}
+
+static void zebra_nhg_id_index_add(struct nhg_hash_entry *nhe)
+{
+	struct nhg_id_index *idx, *old;
+	uint32_t size, i;
+	uintptr_t cur;
+
+	idx = (struct nhg_id_index *)atomic_load_explicit(
+		&nhg_id_index, memory_order_relaxed);
+
+	/* keep at least a quarter of the slots free so lookups terminate */
+	if (!idx || (idx->used + 1) * 4 > (idx->mask + 1) * 3) {
+		old = idx;
+		size = NHG_ID_INDEX_MIN;
+		while (old && size < (old->count + 1) * 2)
+			size <<= 1;
+
+		idx = nhg_id_index_alloc(size);
+		for (i = 0; old && i <= old->mask; i++) {
+			cur = atomic_load_explicit(&old->slots[i],
+						   memory_order_relaxed);
+			if (cur && cur != NHG_ID_TOMBSTONE)
+				nhg_id_index_put(
+					idx, (struct nhg_hash_entry *)cur);
+		}
+
+		atomic_store_explicit(&nhg_id_index, (uintptr_t)idx,
+				      memory_order_release);
+		rcu_free(MTYPE_NHG_ID_INDEX, old, rcu_head);
+	}
+
+	SET_FLAG(nhe->flags, NEXTHOP_GROUP_RCU_INDEXED);
+	nhg_id_index_put(idx, nhe);
+}
+
+static void zebra_nhg_id_index_del(struct nhg_hash_entry *nhe)
+{
+	struct nhg_id_index *idx;
+	uint32_t i;
+	uintptr_t cur;
+
+	idx = (struct nhg_id_index *)atomic_load_explicit(
+		&nhg_id_index, memory_order_relaxed);
+	if (!idx || !CHECK_FLAG(nhe->flags, NEXTHOP_GROUP_RCU_INDEXED))
+		return;
+
+	for (i = jhash_1word(nhe->id, 0) & idx->mask;;
+	     i = (i + 1) & idx->mask) {
+		cur = atomic_load_explicit(&idx->slots[i],
+					   memory_order_relaxed);
+		if (!cur)
+			return;
+		if (cur == (uintptr_t)nhe)
+			break;
+	}
+
+	idx->count--;
+	atomic_store_explicit(&idx->slots[i], NHG_ID_TOMBSTONE,
+			      memory_order_release);
+}
+
+struct nhg_hash_entry *zebra_nhg_lookup_id_rcu(uint32_t id)
+{
+	struct nhg_id_index *idx;
+	struct nhg_hash_entry *nhe;
+	uint32_t i;
+	uintptr_t cur;
+
+	rcu_assert_read_locked();
+
+	idx = (struct nhg_id_index *)atomic_load_explicit(
+		&nhg_id_index, memory_order_acquire);
+	if (!idx)
+		return NULL;
+
+	for (i = jhash_1word(id, 0) & idx->mask;; i = (i + 1) & idx->mask) {
+		cur = atomic_load_explicit(&idx->slots[i],
+					   memory_order_acquire);
+		if (!cur)
+			return NULL;
+		if (cur == NHG_ID_TOMBSTONE)
+			continue;
+
+		nhe = (struct nhg_hash_entry *)cur;
+		if (nhe->id == id)
+			return nhe;
+	}
+}
+
+void zebra_nhg_id_index_fini(void)
+{
+	struct nhg_id_index *idx;
+
+	idx = (struct nhg_id_index *)atomic_exchange_explicit(
+		&nhg_id_index, (uintptr_t)0, memory_order_acq_rel);
+	rcu_free(MTYPE_NHG_ID_INDEX, idx, rcu_head);
+}
+
 static int zebra_nhg_insert_id(struct nhg_hash_entry *nhe)
 {
 	if (hash_lookup(zrouter.nhgs_id, nhe)) {
@@ -329,6 +487,7 @@ static int zebra_nhg_insert_id(struct nhg_hash_entry *nhe)
 	}
 
 	hash_get(zrouter.nhgs_id, nhe, hash_alloc_intern);
+	zebra_nhg_id_index_add(nhe);
 
 	return 0;
 }
@@ -736,6 +895,7 @@ static bool zebra_nhe_find(struct nhg_hash_entry **nhe, /* return value */
 		 */
 		newnhe =
 			hash_get(zrouter.nhgs_id, lookup, zebra_nhg_hash_alloc);
+		zebra_nhg_id_index_add(newnhe);
 	}
 
 	created = true;
@@ -1098,6 +1258,7 @@ static void zebra_nhg_release(struct nhg_hash_entry *nhe)
 		zlog_debug("%s: nhe %p (%u)", __func__, nhe, nhe->id);
 
 	zebra_nhg_release_all_deps(nhe);
+	zebra_nhg_kernel_release(nhe);
 
 	/*
 	 * If its not zebra owned, we didn't store it here and have to be
@@ -1107,6 +1268,7 @@ static void zebra_nhg_release(struct nhg_hash_entry *nhe)
 		hash_release(zrouter.nhgs, nhe);
 
 	hash_release(zrouter.nhgs_id, nhe);
+	zebra_nhg_id_index_del(nhe);
 }
 
 static void zebra_nhg_handle_uninstall(struct nhg_hash_entry *nhe)
@@ -1616,7 +1778,15 @@ void zebra_nhg_free(struct nhg_hash_entry *nhe)
 
 	zebra_nhg_free_members(nhe);
 
-	XFREE(MTYPE_NHG, nhe);
+	/* at shutdown; the NHE we may share with can be gone already */
+	nhe->kernel_nhe = NULL;
+	zebra_nhg_kernel_release(nhe);
+
+	/* other pthreads may still be looking at it */
+	if (CHECK_FLAG(nhe->flags, NEXTHOP_GROUP_RCU_INDEXED))
+		rcu_free(MTYPE_NHG, nhe, rcu_head);
+	else
+		XFREE(MTYPE_NHG, nhe);
 }
 
 void zebra_nhg_hash_free(void *p)
@@ -2718,6 +2888,7 @@ static uint8_t zebra_nhg_nhe2grp_internal(struct nh_grp *grp,
 {
 	struct nhg_connected *rb_node_dep = NULL;
 	struct nhg_hash_entry *depend = NULL;
+	struct nhg_hash_entry *kernel_nhe;
 	uint8_t i = curr_index;
 
 	frr_each(nhg_connected_tree, &nhe->nhg_depends, rb_node_dep) {
@@ -2758,8 +2929,10 @@ static uint8_t zebra_nhg_nhe2grp_internal(struct nh_grp *grp,
 			/* If the nexthop not installed/queued for install don't
 			 * put in the ID array.
 			 */
-			if (!(CHECK_FLAG(depend->flags, NEXTHOP_GROUP_INSTALLED)
-			      || CHECK_FLAG(depend->flags,
+			kernel_nhe = zebra_nhg_kernel_nhe(depend);
+			if (!(CHECK_FLAG(kernel_nhe->flags,
+					 NEXTHOP_GROUP_INSTALLED)
+			      || CHECK_FLAG(kernel_nhe->flags,
 					    NEXTHOP_GROUP_QUEUED))) {
 				if (IS_ZEBRA_DEBUG_RIB_DETAILED
 				    || IS_ZEBRA_DEBUG_NHG)
@@ -2771,7 +2944,7 @@ static uint8_t zebra_nhg_nhe2grp_internal(struct nh_grp *grp,
 
 			/* Check for duplicate IDs, ignore if found. */
 			for (int j = 0; j < i; j++) {
-				if (depend->id == grp[j].id) {
+				if (kernel_nhe->id == grp[j].id) {
 					duplicate = true;
 					break;
 				}
@@ -2786,7 +2959,7 @@ static uint8_t zebra_nhg_nhe2grp_internal(struct nh_grp *grp,
 				continue;
 			}
 
-			grp[i].id = depend->id;
+			grp[i].id = kernel_nhe->id;
 			grp[i].weight = depend->nhg.nexthop->weight;
 			i++;
 		}
@@ -2814,9 +2987,185 @@ uint8_t zebra_nhg_nhe2grp(struct nh_grp *grp, struct nhg_hash_entry *nhe,
 	return zebra_nhg_nhe2grp_internal(grp, 0, nhe, max_num);
 }
 
+/*
+ * Kernel nexthop object sharing
+ *
+ * What the kernel gets for a nexthop object is only the nexthop itself, or
+ * the ids and weights of a group's members.  NHEs for the same nexthops in
+ * different VRFs or from different owners would otherwise each install an
+ * identical object, so an NHE about to be installed first looks for an
+ * installed NHE with the same kernel-level nexthops and, if there's one,
+ * takes a reference on it and uses its id instead.  Groups are compared by
+ * their members' kernel ids, so groups of shared singletons are shared as
+ * well.  NHEs owned by other daemons keep their own ids.
+ */
+struct nhg_kernel_key {
+	struct nhg_hash_entry *nhe;
+
+	/* everything from here on is zeroed, then hashed and compared */
+	afi_t afi;
+	vrf_id_t vrf_id;
+	enum nexthop_types_t type;
+	enum blackhole_type bh_type;
+	ifindex_t ifindex;
+	union g_addr gate;
+	bool onlink;
+	uint8_t num_labels;
+	mpls_label_t labels[MPLS_MAX_LABELS];
+
+	uint8_t grp_count;
+	struct nh_grp grp[MULTIPATH_NUM];
+};
+
+#define NHG_KERNEL_KEY_OFFSET offsetof(struct nhg_kernel_key, afi)
+#define NHG_KERNEL_KEY_SIZE                                                    \
+	(sizeof(struct nhg_kernel_key) - NHG_KERNEL_KEY_OFFSET)
+
+static unsigned long nhg_kernel_aliases;
+
+uint32_t zebra_nhg_kernel_key_hash(const void *arg)
+{
+	const struct nhg_kernel_key *key = arg;
+
+	return jhash((const uint8_t *)key + NHG_KERNEL_KEY_OFFSET,
+		     NHG_KERNEL_KEY_SIZE, 0x5a11ed1d);
+}
+
+bool zebra_nhg_kernel_key_equal(const void *arg1, const void *arg2)
+{
+	return !memcmp((const uint8_t *)arg1 + NHG_KERNEL_KEY_OFFSET,
+		       (const uint8_t *)arg2 + NHG_KERNEL_KEY_OFFSET,
+		       NHG_KERNEL_KEY_SIZE);
+}
+
+static int nhg_kernel_grp_cmp(const void *a, const void *b)
+{
+	const struct nh_grp *ga = a, *gb = b;
+
+	if (ga->id != gb->id)
+		return ga->id < gb->id ? -1 : 1;
+	return ga->weight - gb->weight;
+}
+
+/* Returns false if the NHE's kernel object is one that is not shared */
+static bool zebra_nhg_kernel_key_make(struct nhg_hash_entry *nhe,
+				      struct nhg_kernel_key *key)
+{
+	const struct nexthop *nh = nhe->nhg.nexthop;
+
+	memset(key, 0, sizeof(*key));
+
+	if (PROTO_OWNED(nhe)
+	    || CHECK_FLAG(nhe->flags, NEXTHOP_GROUP_RECURSIVE))
+		return false;
+
+	if (!zebra_nhg_depends_is_empty(nhe)) {
+		key->grp_count = zebra_nhg_nhe2grp(key->grp, nhe, MULTIPATH_NUM);
+		/* member ids are in the order of the alias ids */
+		qsort(key->grp, key->grp_count, sizeof(key->grp[0]),
+		      nhg_kernel_grp_cmp);
+		return key->grp_count != 0;
+	}
+
+	if (!nh || nh->next || nh->nh_srv6)
+		return false;
+
+	key->afi = nhe->afi;
+	key->type = nh->type;
+	if (nh->type == NEXTHOP_TYPE_BLACKHOLE) {
+		key->bh_type = nh->bh_type;
+		return true;
+	}
+
+	/* not what can be installed, leave it to the dataplane */
+	if (!nh->ifindex)
+		return false;
+
+	key->ifindex = nh->ifindex;
+	if (nh->type != NEXTHOP_TYPE_IFINDEX)
+		key->gate = nh->gate;
+	key->onlink = CHECK_FLAG(nh->flags, NEXTHOP_FLAG_ONLINK);
+	if (nh->nh_label) {
+		key->num_labels = MIN(nh->nh_label->num_labels,
+				      MPLS_MAX_LABELS);
+		memcpy(key->labels, nh->nh_label->label,
+		       key->num_labels * sizeof(key->labels[0]));
+	}
+	return true;
+}
+
+/* Use the kernel object of an installed NHE with the same nexthops */
+static bool zebra_nhg_kernel_share(struct nhg_hash_entry *nhe,
+				   struct nhg_kernel_key *key)
+{
+	struct nhg_kernel_key *found;
+	struct nhg_hash_entry *owner;
+
+	found = hash_lookup(zrouter.nhgs_kernel, key);
+	if (!found || found->nhe == nhe)
+		return false;
+
+	owner = found->nhe;
+	if (!CHECK_FLAG(owner->flags, NEXTHOP_GROUP_INSTALLED)
+	    && !CHECK_FLAG(owner->flags, NEXTHOP_GROUP_QUEUED))
+		return false;
+
+	if (IS_ZEBRA_DEBUG_NHG)
+		zlog_debug("%s: nhe %p (%u) uses kernel object of nhe (%u)",
+			   __func__, nhe, nhe->id, owner->id);
+
+	zebra_nhg_increment_ref(owner);
+	owner->kernel_aliases++;
+	nhg_kernel_aliases++;
+	nhe->kernel_nhe = owner;
+	return true;
+}
+
+static void zebra_nhg_kernel_key_add(struct nhg_hash_entry *nhe,
+				     const struct nhg_kernel_key *key)
+{
+	struct nhg_kernel_key *new;
+
+	new = XMALLOC(MTYPE_NHG_KERNEL_KEY, sizeof(*new));
+	memcpy(new, key, sizeof(*new));
+	new->nhe = nhe;
+
+	if (hash_get(zrouter.nhgs_kernel, new, hash_alloc_intern) != new) {
+		XFREE(MTYPE_NHG_KERNEL_KEY, new);
+		return;
+	}
+	nhe->kernel_key = new;
+}
+
+static void zebra_nhg_kernel_release(struct nhg_hash_entry *nhe)
+{
+	struct nhg_hash_entry *owner = nhe->kernel_nhe;
+
+	if (nhe->kernel_key) {
+		hash_release(zrouter.nhgs_kernel, nhe->kernel_key);
+		XFREE(MTYPE_NHG_KERNEL_KEY, nhe->kernel_key);
+	}
+
+	if (owner) {
+		nhe->kernel_nhe = NULL;
+		owner->kernel_aliases--;
+		nhg_kernel_aliases--;
+		zebra_nhg_decrement_ref(owner);
+	}
+}
+
+void zebra_nhg_kernel_share_stats(unsigned long *objects,
+				  unsigned long *aliases)
+{
+	*objects = hashcount(zrouter.nhgs_kernel);
+	*aliases = nhg_kernel_aliases;
+}
+
 void zebra_nhg_install_kernel(struct nhg_hash_entry *nhe)
 {
 	struct nhg_connected *rb_node_dep = NULL;
+	struct nhg_kernel_key key;
+	bool shareable = false;
 
 	/* Resolve it first */
 	nhe = zebra_nhg_resolve(nhe);
@@ -2826,15 +3175,28 @@ void zebra_nhg_install_kernel(struct nhg_hash_entry *nhe)
 		zebra_nhg_install_kernel(rb_node_dep->nhe);
 	}
 
+	if (nhe->kernel_nhe) {
+		zebra_nhg_install_kernel(nhe->kernel_nhe);
+		return;
+	}
+
 	if (CHECK_FLAG(nhe->flags, NEXTHOP_GROUP_VALID)
 	    && !CHECK_FLAG(nhe->flags, NEXTHOP_GROUP_INSTALLED)
 	    && !CHECK_FLAG(nhe->flags, NEXTHOP_GROUP_QUEUED)) {
+		if (!nhe->kernel_key && zebra_nhg_kernel_nexthops_enabled()) {
+			shareable = zebra_nhg_kernel_key_make(nhe, &key);
+			if (shareable && zebra_nhg_kernel_share(nhe, &key))
+				return;
+		}
+
 		/* Change its type to us since we are installing it */
 		if (!ZEBRA_NHG_CREATED(nhe))
 			nhe->type = ZEBRA_ROUTE_NHG;
 
 		int ret = dplane_nexthop_add(nhe);
 
+		frrtrace(2, frr_zebra, nhg_install, nhe, ret);
+
 		switch (ret) {
 		case ZEBRA_DPLANE_REQUEST_QUEUED:
 			SET_FLAG(nhe->flags, NEXTHOP_GROUP_QUEUED);
@@ -2844,15 +3206,97 @@ void zebra_nhg_install_kernel(struct nhg_hash_entry *nhe)
 				EC_ZEBRA_DP_INSTALL_FAIL,
 				"Failed to install Nexthop ID (%u) into the kernel",
 				nhe->id);
+			shareable = false;
 			break;
 		case ZEBRA_DPLANE_REQUEST_SUCCESS:
 			SET_FLAG(nhe->flags, NEXTHOP_GROUP_INSTALLED);
 			zebra_nhg_handle_install(nhe);
 			break;
 		}
+
+		if (shareable)
+			zebra_nhg_kernel_key_add(nhe, &key);
 	}
 }
 
+static void zebra_nhg_reroute_dependents(struct nhg_hash_entry *nhe,
+					 struct hash *seen)
+{
+	struct nhg_connected *rb_node_dep;
+	struct nhg_hash_entry *group;
+
+	frr_each(nhg_connected_tree, &nhe->nhg_dependents, rb_node_dep) {
+		group = rb_node_dep->nhe;
+
+		if (hash_lookup(seen, group))
+			continue;
+		hash_get(seen, group, hash_alloc_intern);
+
+		/* Groups in groups are flattened into the outer group's id
+		 * array, and recursive entries are only the glue between a
+		 * singleton and the groups using it; either way the groups
+		 * further up have to be looked at too.
+		 */
+		zebra_nhg_reroute_dependents(group, seen);
+
+		if (zebra_nhg_depends_is_empty(group)
+		    || CHECK_FLAG(group->flags, NEXTHOP_GROUP_RECURSIVE))
+			continue;
+
+		/* Nothing left to move to, the routes have to deal with it */
+		if (!CHECK_FLAG(group->flags, NEXTHOP_GROUP_VALID)
+		    || !CHECK_FLAG(group->flags, NEXTHOP_GROUP_INSTALLED)
+		    || CHECK_FLAG(group->flags, NEXTHOP_GROUP_QUEUED))
+			continue;
+
+		if (IS_ZEBRA_DEBUG_NHG)
+			zlog_debug("%s: rewriting nhe %p (%u) without nhe (%u)",
+				   __func__, group, group->id, nhe->id);
+
+		switch (dplane_nexthop_update(group)) {
+		case ZEBRA_DPLANE_REQUEST_QUEUED:
+			SET_FLAG(group->flags, NEXTHOP_GROUP_QUEUED);
+			break;
+		case ZEBRA_DPLANE_REQUEST_FAILURE:
+			flog_err(EC_ZEBRA_DP_INSTALL_FAIL,
+				 "Failed to update Nexthop ID (%u) in the kernel",
+				 group->id);
+			break;
+		case ZEBRA_DPLANE_REQUEST_SUCCESS:
+			break;
+		}
+	}
+}
+
+void zebra_nhg_fast_reroute(struct nhg_connected_tree_head *dependents)
+{
+	struct nhg_connected *rb_node_dep;
+	struct hash *seen;
+
+	if (!zebra_nhg_kernel_nexthops_enabled()
+	    || nhg_connected_tree_is_empty(dependents))
+		return;
+
+	/*
+	 * The groups are shared by all the routes using them, so moving
+	 * traffic off a dead link doesn't have to wait for those routes to
+	 * be reprocessed one by one; zebra_nhg_nhe2grp() already leaves out
+	 * the invalid members.  The routes still get reprocessed afterwards
+	 * to bring the RIB in line, but forwarding has converged by then.
+	 */
+	seen = hash_create_size(32, zebra_nhg_id_key, zebra_nhg_hash_id_equal,
+				"NHG fast reroute");
+
+	frr_each(nhg_connected_tree, dependents, rb_node_dep) {
+		if (CHECK_FLAG(rb_node_dep->nhe->flags, NEXTHOP_GROUP_VALID))
+			continue;
+		zebra_nhg_reroute_dependents(rb_node_dep->nhe, seen);
+	}
+
+	hash_clean(seen, NULL);
+	hash_free(seen);
+}
+
 void zebra_nhg_uninstall_kernel(struct nhg_hash_entry *nhe)
 {
 	if (CHECK_FLAG(nhe->flags, NEXTHOP_GROUP_INSTALLED)) {
@@ -2889,6 +3333,8 @@ void zebra_nhg_dplane_result(struct zebra_dplane_ctx *ctx)
 
 	id = dplane_ctx_get_nhe_id(ctx);
 
+	frrtrace(1, frr_zebra, nhg_dplane_result, ctx);
+
 	if (IS_ZEBRA_DEBUG_DPLANE_DETAIL || IS_ZEBRA_DEBUG_NHG_DETAIL)
 		zlog_debug(
 			"Nexthop dplane ctx %p, op %s, nexthop ID (%u), result %s",
@@ -3170,6 +3616,7 @@ struct nhg_hash_entry *zebra_nhg_proto_add(uint32_t id, int type,
 		 */
 		replace = true;
 		hash_release(zrouter.nhgs_id, old);
+		zebra_nhg_id_index_del(old);
 
 		/* Free all the things */
 		zebra_nhg_release_all_deps(old);
@@ -25,6 +25,7 @@
 
 #include "lib/nexthop.h"
 #include "lib/nexthop_group.h"
+#include "lib/frrcu.h"
 
 #ifdef __cplusplus
 extern "C" {
@@ -41,6 +42,8 @@ struct nh_grp {
 	uint8_t weight;
 };
 
+struct nhg_kernel_key;
+
 PREDECL_RBTREE_UNIQ(nhg_connected_tree);
 
 /*
@@ -89,6 +92,20 @@ struct nhg_hash_entry {
 	 */
 	struct nhg_connected_tree_head nhg_depends, nhg_dependents;
 
+	/* for entries that made it into the RCU id index */
+	struct rcu_head rcu_head;
+
+	/*
+	 * Kernel nexthop object sharing: NHEs that only differ in what the
+	 * kernel doesn't see (VRF, owner, ...) use a single kernel object.
+	 * kernel_nhe is the NHE whose object we use instead of installing
+	 * our own, and holds a reference on it.  kernel_key is set if we
+	 * have an object others can share, kernel_aliases counts them.
+	 */
+	struct nhg_hash_entry *kernel_nhe;
+	struct nhg_kernel_key *kernel_key;
+	uint32_t kernel_aliases;
+
 /*
  * Is this nexthop group valid, ie all nexthops are fully resolved.
  * What is fully resolved?  It's a nexthop that is either self contained
@@ -133,6 +150,11 @@ struct nhg_hash_entry {
  * Track FPM installation status..
  */
 #define NEXTHOP_GROUP_FPM (1 << 6)
+
+/*
+ * Entry is (or was) in the RCU id index and must be freed through RCU.
+ */
+#define NEXTHOP_GROUP_RCU_INDEXED (1 << 7)
 };
 
 /* Upper 4 bits of the NHG are reserved for indicating the NHG type */
@@ -261,6 +283,17 @@ extern bool zebra_nhg_dependents_is_empty(const struct nhg_hash_entry *nhe);
 /* Lookup ID, doesn't create */
 extern struct nhg_hash_entry *zebra_nhg_lookup_id(uint32_t id);
 
+/*
+ * Same as zebra_nhg_lookup_id(), for pthreads other than the main one.  Must
+ * be called under rcu_read_lock(); the entry stays allocated until
+ * rcu_read_unlock(), but only its id, afi, vrf_id and type may be relied on,
+ * everything else belongs to the main pthread.
+ */
+extern struct nhg_hash_entry *zebra_nhg_lookup_id_rcu(uint32_t id);
+
+/* Drop the RCU id index, at shutdown */
+extern void zebra_nhg_id_index_fini(void);
+
 /* Hash functions */
 extern uint32_t zebra_nhg_hash_key(const void *arg);
 extern uint32_t zebra_nhg_id_key(const void *arg);
@@ -341,10 +374,30 @@ extern void zebra_nhg_check_valid(struct nhg_hash_entry *nhe);
 extern uint8_t zebra_nhg_nhe2grp(struct nh_grp *grp, struct nhg_hash_entry *nhe,
 				 int size);
 
+/* The NHE whose kernel nexthop object is used for this one */
+static inline struct nhg_hash_entry *
+zebra_nhg_kernel_nhe(struct nhg_hash_entry *nhe)
+{
+	return nhe->kernel_nhe ? nhe->kernel_nhe : nhe;
+}
+
+extern uint32_t zebra_nhg_kernel_key_hash(const void *arg);
+extern bool zebra_nhg_kernel_key_equal(const void *arg1, const void *arg2);
+
+/* Number of kernel objects that can be shared, and NHEs sharing them */
+extern void zebra_nhg_kernel_share_stats(unsigned long *objects,
+					 unsigned long *aliases);
+
 /* Dataplane install/uninstall */
 extern void zebra_nhg_install_kernel(struct nhg_hash_entry *nhe);
 extern void zebra_nhg_uninstall_kernel(struct nhg_hash_entry *nhe);
 
+/*
+ * Singleton nexthops in `dependents` just became invalid; rewrite the
+ * installed groups using them that still have valid members, once each.
+ */
+extern void zebra_nhg_fast_reroute(struct nhg_connected_tree_head *dependents);
+
 /* Forward ref of dplane update context type */
 struct zebra_dplane_ctx;
 extern void zebra_nhg_dplane_result(struct zebra_dplane_ctx *ctx);
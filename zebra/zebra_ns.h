@@ -40,6 +40,11 @@ struct nlsock {
 	struct sockaddr_nl snl;
 	char name[64];
 };
+
+struct nl_reader;
+
+/* upper bound for --dplane-shards */
+#define ZEBRA_DPLANE_SHARDS_MAX 8
 #endif
 
 struct zebra_ns {
@@ -53,7 +58,11 @@ struct zebra_ns {
 	struct nlsock netlink;        /* kernel messages */
 	struct nlsock netlink_cmd;    /* command channel */
 	struct nlsock netlink_dplane; /* dataplane channel */
+	/* dataplane channels for kernel shards 1 and up */
+	struct nlsock netlink_dplane_shard[ZEBRA_DPLANE_SHARDS_MAX - 1];
 	struct thread *t_netlink;
+	/* with --nl-reader, replaces t_netlink */
+	struct nl_reader *netlink_reader;
 #endif
 
 	struct route_table *if_table;
@@ -62,6 +71,18 @@ struct zebra_ns {
 	struct ns *ns;
 };
 
+#ifdef HAVE_NETLINK
+/* dataplane socket used by the given kernel shard */
+static inline struct nlsock *zebra_ns_dplane_sock(struct zebra_ns *zns,
+						  unsigned int shard)
+{
+	if (shard == 0)
+		return &zns->netlink_dplane;
+
+	return &zns->netlink_dplane_shard[shard - 1];
+}
+#endif
+
 struct zebra_ns *zebra_ns_lookup(ns_id_t ns_id);
 
 int zebra_ns_init(const char *optional_default_name);
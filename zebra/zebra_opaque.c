@@ -31,6 +31,36 @@ DEFINE_MTYPE_STATIC(ZEBRA, OPQ, "ZAPI Opaque Information");
 
 /* Hash to hold message registration info from zapi clients */
 PREDECL_HASH(opq_regh);
+PREDECL_DLIST(opq_outs);
+
+/* Relay state of a ZAPI client, shared by all its registrations */
+struct opq_client_out {
+	struct opq_outs_item item;
+
+	int proto;
+	int instance;
+	uint32_t session_id;
+
+	/* Number of opq_client_reg's using this */
+	uint32_t regs;
+
+	/* Messages for the client collected in one dispatch run, sent
+	 * with a single zserv_send_batch().  Module pthread only.
+	 */
+	struct stream_fifo fifo;
+	size_t fifo_bytes;
+
+	/* Stats, protected by zo_info.out_mutex */
+	uint64_t msgs;
+	uint64_t bytes;
+	uint64_t batches;
+	/* batches queued while the client still had output pending */
+	uint64_t backlogged;
+	/* longest client output queue seen, in messages */
+	size_t max_queued;
+};
+
+DECLARE_DLIST(opq_outs, struct opq_client_out, item);
 
 /* Registered client info */
 struct opq_client_reg {
@@ -38,6 +68,8 @@ struct opq_client_reg {
 	int instance;
 	uint32_t session_id;
 
+	struct opq_client_out *out;
+
 	struct opq_client_reg *next;
 	struct opq_client_reg *prev;
 };
@@ -98,6 +130,12 @@ static struct zebra_opaque_globals {
 	pthread_mutex_t mutex;
 	struct stream_fifo in_fifo;
 
+	/* Per-client relay state; the list is only changed by the module
+	 * pthread, the lock is for reading the stats from elsewhere.
+	 */
+	pthread_mutex_t out_mutex;
+	struct opq_outs_head outs;
+
 } zo_info;
 
 /* Name string for debugs/logs */
@@ -122,6 +160,8 @@ static struct opq_client_reg *opq_client_alloc(
 static void opq_client_free(struct opq_client_reg **client);
 static const char *opq_client2str(char *buf, size_t buflen,
 				  const struct opq_client_reg *client);
+static const char *opq_out2str(char *buf, size_t buflen,
+			       const struct opq_client_out *out);
 
 /*
  * Initialize the module at startup
@@ -132,6 +172,8 @@ void zebra_opaque_init(void)
 
 	pthread_mutex_init(&zo_info.mutex, NULL);
 	stream_fifo_init(&zo_info.in_fifo);
+	pthread_mutex_init(&zo_info.out_mutex, NULL);
+	opq_outs_init(&zo_info.outs);
 
 	zo_info.msgs_per_cycle = ZEBRA_OPAQUE_MSG_LIMIT;
 }
@@ -210,6 +252,9 @@ void zebra_opaque_finish(void)
 
 	opq_regh_fini(&opq_reg_hash);
 
+	opq_outs_fini(&zo_info.outs);
+	pthread_mutex_destroy(&zo_info.out_mutex);
+
 	pthread_mutex_destroy(&zo_info.mutex);
 	stream_fifo_deinit(&zo_info.in_fifo);
 }
@@ -339,18 +384,73 @@ done:
 	return 0;
 }
 
+/*
+ * Send what a dispatch run collected for each client, one batch per client.
+ */
+static void opq_send_batches(void)
+{
+	struct opq_client_out *out;
+	struct zserv *zclient;
+	size_t count, queued;
+	char buf[50];
+
+	frr_each (opq_outs, &zo_info.outs, out) {
+		count = stream_fifo_count_safe(&out->fifo);
+		if (count == 0)
+			continue;
+
+		zclient = zserv_acquire_client(out->proto, out->instance,
+					       out->session_id);
+		if (zclient == NULL) {
+			if (IS_ZEBRA_DEBUG_RECV && IS_ZEBRA_DEBUG_DETAIL)
+				zlog_debug("%s: no zclient for %s", __func__,
+					   opq_out2str(buf, sizeof(buf), out));
+			/* Registered but gone? */
+			stream_fifo_clean(&out->fifo);
+			out->fifo_bytes = 0;
+			continue;
+		}
+
+		if (IS_ZEBRA_DEBUG_SEND && IS_ZEBRA_DEBUG_DETAIL)
+			zlog_debug("%s: sending %zu messages to client %s",
+				   __func__, count,
+				   opq_out2str(buf, sizeof(buf), out));
+
+		queued = atomic_load_explicit(&zclient->obuf_fifo->count,
+					      memory_order_relaxed);
+
+		/*
+		 * Sending messages actually means enqueuing them for a zapi
+		 * io pthread to send - so we don't touch them after this
+		 * call.
+		 */
+		zserv_send_batch(zclient, &out->fifo);
+		zserv_release_client(zclient);
+
+		frr_with_mutex(&zo_info.out_mutex) {
+			out->msgs += count;
+			out->bytes += out->fifo_bytes;
+			out->batches++;
+			if (queued)
+				out->backlogged++;
+			if (queued + count > out->max_queued)
+				out->max_queued = queued + count;
+		}
+		out->fifo_bytes = 0;
+	}
+}
+
 /*
  * Process (dispatch) or drop opaque messages.
  */
 static int dispatch_opq_messages(struct stream_fifo *msg_fifo)
 {
-	struct stream *msg, *dup;
+	struct stream *msg;
 	struct zmsghdr hdr;
 	struct zapi_opaque_msg info;
 	struct opq_msg_reg *reg;
 	int ret;
 	struct opq_client_reg *client;
-	struct zserv *zclient;
 	char buf[50];
 
 	while ((msg = stream_fifo_pop(msg_fifo)) != NULL) {
@@ -362,6 +462,8 @@ static int dispatch_opq_messages(struct stream_fifo *msg_fifo)
 			handle_opq_registration(&hdr, msg);
 			continue;
 		} else if (hdr.command == ZEBRA_OPAQUE_UNREGISTER) {
+			/* don't hold back what the client still gets */
+			opq_send_batches();
 			handle_opq_unregistration(&hdr, msg);
 			continue;
 		}
@@ -389,10 +491,10 @@ static int dispatch_opq_messages(struct stream_fifo *msg_fifo)
 		/* Reset read pointer, since we'll be re-sending message */
 		stream_set_getp(msg, 0);
 
-		/* Send a copy of the message to all registered clients */
+		/* Queue the message for all registered clients; they all get
+		 * the same (shared, read-only) data.
+		 */
 		for (client = reg->clients; client; client = client->next) {
-			dup = NULL;
-
 			if (CHECK_FLAG(info.flags, ZAPI_OPAQUE_FLAG_UNICAST)) {
 
 				if (client->proto != info.proto ||
@@ -407,55 +509,10 @@ static int dispatch_opq_messages(struct stream_fifo *msg_fifo)
 						   opq_client2str(buf,
 								  sizeof(buf),
 								  client));
-
-			} else {
-				/* Copy message if more clients */
-				if (client->next)
-					dup = stream_dup(msg);
 			}
 
-			/*
-			 * TODO -- this isn't ideal: we're going through an
-			 * acquire/release cycle for each client for each
-			 * message. Replace this with a batching version.
-			 */
-			zclient = zserv_acquire_client(client->proto,
-						       client->instance,
-						       client->session_id);
-			if (zclient) {
-				if (IS_ZEBRA_DEBUG_SEND &&
-				    IS_ZEBRA_DEBUG_DETAIL)
-					zlog_debug("%s: sending %s to client %s",
-						   __func__,
-						   (dup ? "dup" : "msg"),
-						   opq_client2str(buf,
-								  sizeof(buf),
-								  client));
-
-				/*
-				 * Sending a message actually means enqueuing
-				 * it for a zapi io pthread to send - so we
-				 * don't touch the message after this call.
-				 */
-				zserv_send_message(zclient, dup ? dup : msg);
-				if (dup)
-					dup = NULL;
-				else
-					msg = NULL;
-
-				zserv_release_client(zclient);
-			} else {
-				if (IS_ZEBRA_DEBUG_RECV &&
-				    IS_ZEBRA_DEBUG_DETAIL)
-					zlog_debug("%s: type %u: no zclient for %s",
-						   __func__, info.type,
-						   opq_client2str(buf,
-								  sizeof(buf),
-								  client));
-				/* Registered but gone? */
-				if (dup)
-					stream_free(dup);
-			}
+			stream_fifo_push(&client->out->fifo, stream_share(msg));
+			client->out->fifo_bytes += stream_get_endp(msg);
 
 			/* If unicast, we're done */
 			if (CHECK_FLAG(info.flags, ZAPI_OPAQUE_FLAG_UNICAST))
@@ -464,10 +521,11 @@ static int dispatch_opq_messages(struct stream_fifo *msg_fifo)
 
 drop_it:
 
-		if (msg)
-			stream_free(msg);
+		stream_free(msg);
 	}
 
+	opq_send_batches();
+
 	return 0;
 }
 
@@ -669,6 +727,51 @@ static void opq_reg_free(struct opq_msg_reg **reg)
 	XFREE(MTYPE_OPQ, (*reg));
 }
 
+static struct opq_client_out *opq_out_find(int proto, int instance,
+					    uint32_t session_id)
+{
+	struct opq_client_out *out;
+
+	frr_each (opq_outs, &zo_info.outs, out)
+		if (out->proto == proto && out->instance == instance
+		    && out->session_id == session_id)
+			return out;
+	return NULL;
+}
+
+static struct opq_client_out *opq_out_get(
+	const struct zapi_opaque_reg_info *info)
+{
+	struct opq_client_out *out;
+
+	out = opq_out_find(info->proto, info->instance, info->session_id);
+	if (!out) {
+		out = XCALLOC(MTYPE_OPQ, sizeof(struct opq_client_out));
+		out->proto = info->proto;
+		out->instance = info->instance;
+		out->session_id = info->session_id;
+		stream_fifo_init(&out->fifo);
+
+		frr_with_mutex(&zo_info.out_mutex) {
+			opq_outs_add_tail(&zo_info.outs, out);
+		}
+	}
+	out->regs++;
+	return out;
+}
+
+static void opq_out_put(struct opq_client_out *out)
+{
+	if (--out->regs)
+		return;
+
+	frr_with_mutex(&zo_info.out_mutex) {
+		opq_outs_del(&zo_info.outs, out);
+	}
+	stream_fifo_deinit(&out->fifo);
+	XFREE(MTYPE_OPQ, out);
+}
+
 static struct opq_client_reg *opq_client_alloc(
 	const struct zapi_opaque_reg_info *info)
 {
@@ -679,30 +782,69 @@ static struct opq_client_reg *opq_client_alloc(
 	client->proto = info->proto;
 	client->instance = info->instance;
 	client->session_id = info->session_id;
+	client->out = opq_out_get(info);
 
 	return client;
 }
 
 static void opq_client_free(struct opq_client_reg **client)
 {
+	opq_out_put((*client)->out);
 	XFREE(MTYPE_OPQ, (*client));
 }
 
-static const char *opq_client2str(char *buf, size_t buflen,
-				  const struct opq_client_reg *client)
+static const char *opq_proto2str(char *buf, size_t buflen, int proto,
+				 int instance, uint32_t session_id)
 {
 	char sbuf[20];
 
-	snprintf(buf, buflen, "%s/%u", zebra_route_string(client->proto),
-		 client->instance);
-	if (client->session_id > 0) {
-		snprintf(sbuf, sizeof(sbuf), "/%u", client->session_id);
+	snprintf(buf, buflen, "%s/%u", zebra_route_string(proto), instance);
+	if (session_id > 0) {
+		snprintf(sbuf, sizeof(sbuf), "/%u", session_id);
 		strlcat(buf, sbuf, buflen);
 	}
 
 	return buf;
 }
 
+static const char *opq_client2str(char *buf, size_t buflen,
+				  const struct opq_client_reg *client)
+{
+	return opq_proto2str(buf, buflen, client->proto, client->instance,
+			     client->session_id);
+}
+
+static const char *opq_out2str(char *buf, size_t buflen,
+			       const struct opq_client_out *out)
+{
+	return opq_proto2str(buf, buflen, out->proto, out->instance,
+			     out->session_id);
+}
+
+/*
+ * Opaque relay stats for "show zebra client"; called from the main pthread.
+ */
+void zebra_opaque_show_client(struct vty *vty, const struct zserv *client)
+{
+	struct opq_client_out *out;
+
+	frr_with_mutex(&zo_info.out_mutex) {
+		out = opq_out_find(client->proto, client->instance,
+				   client->session_id);
+		if (!out)
+			break;
+
+		vty_out(vty,
+			"Opaque relay: %" PRIu64 " msgs, %" PRIu64
+			" bytes in %" PRIu64 " batches\n",
+			out->msgs, out->bytes, out->batches);
+		vty_out(vty,
+			"  Backlogged batches: %" PRIu64
+			" Max output queue: %zu\n",
+			out->backlogged, out->max_queued);
+	}
+}
+
 /* Hash function for clients registered for messages */
 static uint32_t registration_hash(const struct opq_msg_reg *reg)
 {
@@ -59,5 +59,12 @@ void zebra_opaque_finish(void);
  */
 uint32_t zebra_opaque_enqueue_batch(struct stream_fifo *batch);
 
+/*
+ * Opaque relay statistics for a client, for "show zebra client".
+ */
+struct vty;
+struct zserv;
+void zebra_opaque_show_client(struct vty *vty, const struct zserv *client);
+
 
 #endif	/* _ZEBRA_OPAQUE_H */
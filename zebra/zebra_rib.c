@@ -57,11 +57,12 @@
 #include "zebra/zapi_msg.h"
 #include "zebra/zebra_dplane.h"
 #include "zebra/zebra_evpn_mh.h"
+#include "zebra/zebra_trace.h"
 
 DEFINE_MGROUP(ZEBRA, "zebra");
 
 DEFINE_MTYPE(ZEBRA, RE,       "Route Entry");
-DEFINE_MTYPE_STATIC(ZEBRA, RIB_DEST,       "RIB destination");
+DEFINE_MTYPE(ZEBRA, RIB_DEST,       "RIB destination");
 DEFINE_MTYPE_STATIC(ZEBRA, RIB_UPDATE_CTX, "Rib update context object");
 DEFINE_MTYPE_STATIC(ZEBRA, WQ_WRAPPER, "WQ wrapper");
 
@@ -122,6 +123,17 @@ static const struct {
 /* EVPN/VXLAN subqueue is number 1 */
 #define META_QUEUE_EVPN 1
 
+/* Entries per turn for each sub-queue, 0 is served before all others */
+static const uint16_t meta_queue_weight[MQ_SIZE] = {
+	0, 16, 32, 16, 16, 16, 8, 4,
+};
+
+static const char *const meta_queue_name[MQ_SIZE] = {
+	"NHG Objects",		"EVPN/VxLan Objects", "Connected Routes",
+	"Kernel Routes",	"Static Routes",      "IGP Routes",
+	"BGP Routes",		"Other Route Types",
+};
+
 /* Wrapper struct for nhg workqueue items; a 'ctx' is an incoming update
  * from the OS, and an 'nhe' is a nhe update.
  */
@@ -741,8 +753,12 @@ static int rib_can_delete_dest(rib_dest_t *dest)
 void zebra_rib_evaluate_rn_nexthops(struct route_node *rn, uint32_t seq)
 {
 	rib_dest_t *dest = rib_dest_from_rnode(rn);
+	struct route_node *changed_rn = rn;
+	const struct prefix *changed, *changed_src;
 	struct rnh *rnh;
 
+	srcdest_rnode_prefixes(rn, &changed, &changed_src);
+
 	/*
 	 * We are storing the rnh's associated withb
 	 * the tracked nexthop as a list of the rn's.
@@ -810,6 +826,17 @@ void zebra_rib_evaluate_rn_nexthops(struct route_node *rn, uint32_t seq)
 				continue;
 			}
 
+			/*
+			 * Up the tree, the rnh's resolve over a less specific
+			 * route.  The change can only matter to the ones
+			 * within the changed prefix, which may now resolve
+			 * over it instead.  This keeps a covering route from
+			 * re-resolving everything below it whenever one of
+			 * its more specifics changes.
+			 */
+			if (rn != changed_rn && !prefix_match(changed, p))
+				continue;
+
 			rnh->seqno = seq;
 			zebra_evaluate_rnh(zvrf, family2afi(p->family), 0,
 					   rnh->type, p);
@@ -1156,6 +1183,9 @@ static void rib_process(struct route_node *rn)
 
 	vrf = vrf_lookup_by_id(vrf_id);
 
+	frrtrace(2, frr_zebra, rib_process, p, vrf_id);
+	conv_stage(zrouter.conv, vrf_id, p, ZEBRA_CONV_RIB_PROCESS);
+
 	if (IS_ZEBRA_DEBUG_RIB)
 		srcdest_rnode2str(rn, buf, sizeof(buf));
 
@@ -1387,9 +1417,10 @@ static void zebra_rib_evaluate_mpls(struct route_node *rn)
 	if (CHECK_FLAG(dest->flags, RIB_DEST_UPDATE_LSPS)) {
 		if (IS_ZEBRA_DEBUG_MPLS)
 			zlog_debug(
-				"%s(%u): Scheduling all LSPs upon RIB completion",
-				zvrf_name(zvrf), zvrf_id(zvrf));
-		zebra_mpls_lsp_schedule(zvrf);
+				"%s(%u): Scheduling LSPs via %pRN upon RIB completion",
+				zvrf_name(zvrf), zvrf_id(zvrf), rn);
+		zebra_mpls_lsp_schedule_prefix(
+			zvrf, zvrf_id(rib_dest_vrf(dest)), &rn->p);
 		mpls_unmark_lsps_for_processing(rn);
 	}
 }
@@ -1888,6 +1919,10 @@ static void rib_process_result(struct zebra_dplane_ctx *ctx)
 	op = dplane_ctx_get_op(ctx);
 	status = dplane_ctx_get_status(ctx);
 
+	frrtrace(1, frr_zebra, rib_process_result, ctx);
+	conv_stage(zrouter.conv, dplane_ctx_get_vrf(ctx), dest_pfx,
+		   ZEBRA_CONV_DPLANE_RESULT);
+
 	if (IS_ZEBRA_DEBUG_DPLANE_DETAIL)
 		zlog_debug(
 			"%s(%u:%u):%pFX Processing dplane result ctx %p, op %s result %s",
@@ -2493,17 +2528,36 @@ static void process_subq_route(struct listnode *lnode, uint8_t qindex)
 	route_unlock_node(rnode);
 }
 
+static void meta_queue_sample(struct meta_queue *mq, uint8_t qindex)
+{
+	int64_t msec = monotime_since(&mq->mark_time[qindex], NULL) / 1000;
+	unsigned int b;
+
+	for (b = 0; b < MQ_LAT_BUCKETS - 1 && msec >= (1LL << (2 * b)); b++)
+		;
+	mq->lat_hist[qindex][b]++;
+	mq->mark[qindex] = NULL;
+}
+
 /*
  * Examine the specified subqueue; process one entry and return 1 if
  * there is a node, return 0 otherwise.
  */
-static unsigned int process_subq(struct list *subq, uint8_t qindex)
+static unsigned int process_subq(struct meta_queue *mq, uint8_t qindex)
 {
+	struct list *subq = mq->subq[qindex];
 	struct listnode *lnode = listhead(subq);
 
 	if (!lnode)
 		return 0;
 
+	mq->dequeued[qindex]++;
+	if (lnode == mq->mark[qindex])
+		meta_queue_sample(mq, qindex);
+
+	frrtrace(3, frr_zebra, meta_queue_process, qindex, listcount(subq),
+		 mq->size);
+
 	if (qindex == META_QUEUE_EVPN)
 		process_subq_evpn(lnode);
 	else if (qindex == route_info[ZEBRA_ROUTE_NHG].meta_q_map)
@@ -2516,9 +2570,12 @@ static unsigned int process_subq(struct list *subq, uint8_t qindex)
 	return 1;
 }
 
-/* Dispatch the meta queue by picking and processing the next node from
- * a non-empty sub-queue with lowest priority. wq is equal to zebra->ribq and
- * data is pointed to the meta queue structure.
+/* Dispatch the meta queue by picking and processing the next node.  Nexthop
+ * groups go first since routes may refer to them; the other sub-queues are
+ * served round robin, up to meta_queue_weight[] entries at a time, so that a
+ * burst of BGP routes does not hold up connected routes or the IGPs for long
+ * and neither can starve it.  wq is equal to zebra->ribq and data is pointed
+ * to the meta queue structure.
  */
 static wq_item_status meta_queue_process(struct work_queue *dummy, void *data)
 {
@@ -2541,15 +2598,40 @@ static wq_item_status meta_queue_process(struct work_queue *dummy, void *data)
 		return WQ_QUEUE_BLOCKED;
 	}
 
-	for (i = 0; i < MQ_SIZE; i++)
-		if (process_subq(mq->subq[i], i)) {
+	if (process_subq(mq, 0)) {
+		mq->size--;
+		return mq->size ? WQ_REQUEUE : WQ_SUCCESS;
+	}
+
+	for (i = 0; i < MQ_SIZE; i++) {
+		if (mq->credit && process_subq(mq, mq->cur)) {
+			mq->credit--;
 			mq->size--;
 			break;
 		}
+
+		/* turn is over or nothing left, on to the next one */
+		mq->cur = mq->cur % (MQ_SIZE - 1) + 1;
+		mq->credit = meta_queue_weight[mq->cur];
+	}
 	return mq->size ? WQ_REQUEUE : WQ_SUCCESS;
 }
 
 
+static void meta_queue_enqueue(struct meta_queue *mq, uint8_t qindex,
+			       void *data)
+{
+	struct listnode *lnode;
+
+	lnode = listnode_add(mq->subq[qindex], data);
+	mq->size++;
+
+	if (!mq->mark[qindex]) {
+		mq->mark[qindex] = lnode;
+		monotime(&mq->mark_time[qindex]);
+	}
+}
+
 /*
  * Look into the RN and queue it into the highest priority queue
  * at this point in time for processing.
@@ -2600,9 +2682,10 @@ static int rib_meta_queue_add(struct meta_queue *mq, void *data)
 	}
 
 	SET_FLAG(rib_dest_from_rnode(rn)->flags, RIB_ROUTE_QUEUED(qindex));
-	listnode_add(mq->subq[qindex], rn);
+	meta_queue_enqueue(mq, qindex, rn);
 	route_lock_node(rn);
-	mq->size++;
+
+	frrtrace(2, frr_zebra, rib_queue_add, rn, qindex);
 
 	if (IS_ZEBRA_DEBUG_RIB_DETAILED)
 		rnode_debug(rn, re->vrf_id, "queued rn %p into sub-queue %u",
@@ -2627,8 +2710,7 @@ static int rib_meta_queue_nhg_ctx_add(struct meta_queue *mq, void *data)
 	w->type = WQ_NHG_WRAPPER_TYPE_CTX;
 	w->u.ctx = ctx;
 
-	listnode_add(mq->subq[qindex], w);
-	mq->size++;
+	meta_queue_enqueue(mq, qindex, w);
 
 	if (IS_ZEBRA_DEBUG_RIB_DETAILED)
 		zlog_debug("NHG Context id=%u queued into sub-queue %u",
@@ -2653,8 +2735,7 @@ static int rib_meta_queue_nhg_add(struct meta_queue *mq, void *data)
 	w->type = WQ_NHG_WRAPPER_TYPE_NHG;
 	w->u.nhe = nhe;
 
-	listnode_add(mq->subq[qindex], w);
-	mq->size++;
+	meta_queue_enqueue(mq, qindex, w);
 
 	if (IS_ZEBRA_DEBUG_RIB_DETAILED)
 		zlog_debug("NHG id=%u queued into sub-queue %u",
@@ -2665,8 +2746,7 @@ static int rib_meta_queue_nhg_add(struct meta_queue *mq, void *data)
 
 static int rib_meta_queue_evpn_add(struct meta_queue *mq, void *data)
 {
-	listnode_add(mq->subq[META_QUEUE_EVPN], data);
-	mq->size++;
+	meta_queue_enqueue(mq, META_QUEUE_EVPN, data);
 
 	return 0;
 }
@@ -2991,6 +3071,49 @@ static struct meta_queue *meta_queue_new(void)
 	return new;
 }
 
+/* Drops the route nodes of a vrf that is going away. */
+void meta_queue_vrf_free(struct meta_queue *mq, struct zebra_vrf *zvrf)
+{
+	unsigned int i;
+
+	for (i = 0; i < MQ_SIZE; i++) {
+		struct listnode *lnode, *nnode;
+		struct route_node *rnode;
+		rib_dest_t *dest;
+
+		if (i == route_info[ZEBRA_ROUTE_NHG].meta_q_map
+		    || i == META_QUEUE_EVPN)
+			continue;
+
+		for (ALL_LIST_ELEMENTS(mq->subq[i], lnode, nnode, rnode)) {
+			dest = rib_dest_from_rnode(rnode);
+			if (dest && rib_dest_vrf(dest) == zvrf) {
+				if (lnode == mq->mark[i])
+					mq->mark[i] = NULL;
+				route_unlock_node(rnode);
+				list_delete_node(mq->subq[i], lnode);
+				mq->size--;
+			}
+		}
+	}
+}
+
+void meta_queue_show(struct vty *vty, struct meta_queue *mq)
+{
+	unsigned int i, b;
+
+	vty_out(vty,
+		"\nRoute processing queue     Queued   Dequeued   <1ms   <4ms  <16ms  <64ms <256ms    <1s    <4s   >=4s\n");
+
+	for (i = 0; i < MQ_SIZE; i++) {
+		vty_out(vty, "%-20s %12u %10" PRIu64, meta_queue_name[i],
+			listcount(mq->subq[i]), mq->dequeued[i]);
+		for (b = 0; b < MQ_LAT_BUCKETS; b++)
+			vty_out(vty, " %6" PRIu64, mq->lat_hist[i][b]);
+		vty_out(vty, "\n");
+	}
+}
+
 void meta_queue_free(struct meta_queue *mq)
 {
 	unsigned i;
@@ -3090,6 +3213,7 @@ rib_dest_t *zebra_rib_create_dest(struct route_node *rn)
 static void rib_link(struct route_node *rn, struct route_entry *re, int process)
 {
 	rib_dest_t *dest;
+	struct rib_table_info *info;
 	afi_t afi;
 	const char *rmap_name;
 
@@ -3105,6 +3229,10 @@ static void rib_link(struct route_node *rn, struct route_entry *re, int process)
 
 	re_list_add_head(&dest->routes, re);
 
+	info = srcdest_rnode_table_info(rn);
+	re->rn = rn;
+	re_type_list_add_tail(&info->type_routes[re->type], re);
+
 	afi = (rn->p.family == AF_INET)
 		      ? AFI_IP
 		      : (rn->p.family == AF_INET6) ? AFI_IP6 : AFI_MAX;
@@ -3146,6 +3274,7 @@ static void rib_addnode(struct route_node *rn,
 void rib_unlink(struct route_node *rn, struct route_entry *re)
 {
 	rib_dest_t *dest;
+	struct rib_table_info *info;
 
 	assert(rn && re);
 
@@ -3157,6 +3286,10 @@ void rib_unlink(struct route_node *rn, struct route_entry *re)
 
 	re_list_del(&dest->routes, re);
 
+	info = srcdest_rnode_table_info(rn);
+	re_type_list_del(&info->type_routes[re->type], re);
+	re->rn = NULL;
+
 	if (dest->selected_fib == re)
 		dest->selected_fib = NULL;
 
@@ -3949,6 +4082,14 @@ void rib_update_table(struct route_table *table, enum rib_update_event event,
 			   rib_update_event2str(event), zebra_route_string(rtype));
 	}
 
+	/* A table without kernel routes has nothing to update for the
+	 * kernel, which matters with many VRFs on every interface event.
+	 */
+	if (event == RIB_UPDATE_KERNEL && table->info
+	    && !re_type_list_count(
+		    &rib_table_info(table)->type_routes[ZEBRA_ROUTE_KERNEL]))
+		return;
+
 	/* Walk all routes and queue for processing, if appropriate for
 	 * the trigger event.
 	 */
@@ -4154,6 +4295,9 @@ int rib_sweep_route(struct thread *t)
 	zebra_router_sweep_route();
 	zebra_router_sweep_nhgs();
 
+	/* From here on, what the kernel had at startup is history */
+	kernel_fib_shadow_flush();
+
 	return 0;
 }
 
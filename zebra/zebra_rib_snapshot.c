@@ -0,0 +1,650 @@
+/*
+ * Zebra RIB snapshot for warm restarts.
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+#include <sys/mman.h>
+
+#include "lib/jhash.h"
+#include "lib/libfrr.h"
+#include "lib/lib_errors.h"
+#include "lib/memory.h"
+#include "lib/nexthop.h"
+#include "lib/nexthop_group.h"
+#include "lib/srcdest_table.h"
+#include "lib/thread.h"
+#include "lib/typesafe.h"
+#include "lib/vrf.h"
+
+#include "zebra/debug.h"
+#include "zebra/rib.h"
+#include "zebra/rt.h"
+#include "zebra/zebra_nhg.h"
+#include "zebra/zebra_rib_snapshot.h"
+#include "zebra/zebra_router.h"
+#include "zebra/zebra_vrf.h"
+
+DEFINE_MTYPE_STATIC(ZEBRA, RIB_SNAPSHOT, "Zebra RIB snapshot");
+
+/*
+ * The file is a header followed by arrays of fixed size records: VRF names,
+ * nexthops, nexthop groups (ranges of the nexthop array) and routes, which
+ * refer to VRFs and nexthop groups by index.  It is only ever read back by
+ * zebra on the same machine, so everything is in host byte order.
+ */
+#define RIB_SNAP_MAGIC 0x5a524942 /* "ZRIB" */
+#define RIB_SNAP_VERSION 1
+
+struct rib_snap_hdr {
+	uint32_t magic;
+	uint16_t version;
+	uint16_t hdr_size;
+	uint16_t vrf_size;
+	uint16_t nh_size;
+	uint16_t nhg_size;
+	uint16_t route_size;
+	uint32_t vrf_count;
+	uint32_t nh_count;
+	uint32_t nhg_count;
+	uint32_t route_count;
+};
+
+struct rib_snap_vrf {
+	char name[VRF_NAMSIZ + 1];
+};
+
+struct rib_snap_nh {
+	union g_addr gate;
+	union g_addr src;
+	int32_t ifindex;
+	uint32_t vrf;
+	uint8_t type;
+	uint8_t bh_type;
+	uint8_t weight;
+	uint8_t flags;
+	uint8_t label_type;
+	uint8_t num_labels;
+	uint16_t pad;
+	mpls_label_t labels[MPLS_MAX_LABELS];
+};
+
+struct rib_snap_nhg {
+	uint32_t first;
+	uint32_t count;
+};
+
+struct rib_snap_route {
+	union g_addr dst;
+	union g_addr src;
+	uint8_t family;
+	uint8_t dst_len;
+	uint8_t src_len;
+	uint8_t type;
+	uint16_t instance;
+	uint8_t distance;
+	uint8_t pad;
+	uint32_t flags;
+	uint32_t metric;
+	uint32_t mtu;
+	uint32_t tag;
+	uint32_t table;
+	uint32_t vrf;
+	uint32_t nhg;
+};
+
+/* Route flags that describe the FIB state rather than the route */
+#define RIB_SNAP_FLAGS_VOLATILE                                                \
+	(ZEBRA_FLAG_SELFROUTE | ZEBRA_FLAG_SELECTED | ZEBRA_FLAG_TRAPPED       \
+	 | ZEBRA_FLAG_OFFLOADED | ZEBRA_FLAG_OFFLOAD_FAILED)
+
+static unsigned int rib_snapshot_interval;
+static struct thread *t_rib_snapshot;
+
+static void rib_snapshot_path(char *buf, size_t len, const char *suffix)
+{
+	snprintf(buf, len, "%s/zebra-rib.snapshot%s", frr_vtydir, suffix);
+}
+
+/* growing array of records while the snapshot is being built */
+struct rib_snap_array {
+	uint8_t *data;
+	size_t size;
+	uint32_t count;
+	uint32_t alloc;
+};
+
+static void *rib_snap_array_push(struct rib_snap_array *a)
+{
+	void *item;
+
+	if (a->count == a->alloc) {
+		a->alloc = a->alloc ? a->alloc * 2 : 256;
+		a->data = XREALLOC(MTYPE_RIB_SNAPSHOT, a->data,
+				   a->alloc * a->size);
+	}
+	item = a->data + a->count++ * a->size;
+	memset(item, 0, a->size);
+	return item;
+}
+
+PREDECL_HASH(rib_snap_nhe);
+
+struct rib_snap_nhe_ref {
+	struct rib_snap_nhe_item item;
+	const struct nhg_hash_entry *nhe;
+	uint32_t idx;
+};
+
+static int rib_snap_nhe_cmp(const struct rib_snap_nhe_ref *a,
+			    const struct rib_snap_nhe_ref *b)
+{
+	return numcmp((uintptr_t)a->nhe, (uintptr_t)b->nhe);
+}
+
+static uint32_t rib_snap_nhe_hash(const struct rib_snap_nhe_ref *ref)
+{
+	return jhash(&ref->nhe, sizeof(ref->nhe), 0x2f3c8a51);
+}
+
+DECLARE_HASH(rib_snap_nhe, struct rib_snap_nhe_ref, item, rib_snap_nhe_cmp,
+	     rib_snap_nhe_hash);
+
+struct rib_snap_build {
+	struct rib_snap_array vrfs;
+	struct rib_snap_array nhs;
+	struct rib_snap_array nhgs;
+	struct rib_snap_array routes;
+	struct rib_snap_nhe_head nhe_refs;
+};
+
+static bool rib_snap_vrf_idx(struct rib_snap_build *b, vrf_id_t vrf_id,
+			     uint32_t *idx)
+{
+	struct rib_snap_vrf *sv;
+	struct vrf *vrf = vrf_lookup_by_id(vrf_id);
+	uint32_t i;
+
+	if (!vrf)
+		return false;
+
+	/* there are few VRFs, a linear search will do */
+	for (i = 0; i < b->vrfs.count; i++) {
+		sv = (struct rib_snap_vrf *)(b->vrfs.data + i * b->vrfs.size);
+		if (!strcmp(sv->name, vrf->name)) {
+			*idx = i;
+			return true;
+		}
+	}
+
+	sv = rib_snap_array_push(&b->vrfs);
+	strlcpy(sv->name, vrf->name, sizeof(sv->name));
+	*idx = b->vrfs.count - 1;
+	return true;
+}
+
+static bool rib_snap_nhe_idx(struct rib_snap_build *b,
+			     const struct nhg_hash_entry *nhe, uint32_t *idx)
+{
+	struct rib_snap_nhe_ref lookup = { .nhe = nhe }, *ref;
+	struct rib_snap_nhg *sg;
+	struct rib_snap_nh *sn;
+	struct nexthop *nh;
+	uint32_t first = b->nhs.count;
+
+	ref = rib_snap_nhe_find(&b->nhe_refs, &lookup);
+	if (ref) {
+		*idx = ref->idx;
+		return true;
+	}
+
+	/* only the nexthops a client gave us, resolution is redone */
+	for (nh = nhe->nhg.nexthop; nh; nh = nh->next) {
+		if (nh->nh_srv6 || nh->nh_encap_type) {
+			b->nhs.count = first;
+			return false;
+		}
+
+		sn = rib_snap_array_push(&b->nhs);
+		if (!rib_snap_vrf_idx(b, nh->vrf_id, &sn->vrf)) {
+			b->nhs.count = first;
+			return false;
+		}
+		sn->type = nh->type;
+		sn->ifindex = nh->ifindex;
+		if (nh->type == NEXTHOP_TYPE_BLACKHOLE)
+			sn->bh_type = nh->bh_type;
+		else
+			sn->gate = nh->gate;
+		sn->src = nh->src;
+		sn->weight = nh->weight;
+		sn->flags = nh->flags & NEXTHOP_FLAG_ONLINK;
+		if (nh->nh_label && nh->nh_label->num_labels) {
+			sn->label_type = nh->nh_label_type;
+			sn->num_labels = MIN(nh->nh_label->num_labels,
+					     MPLS_MAX_LABELS);
+			memcpy(sn->labels, nh->nh_label->label,
+			       sn->num_labels * sizeof(mpls_label_t));
+		}
+	}
+
+	if (b->nhs.count == first)
+		return false;
+
+	sg = rib_snap_array_push(&b->nhgs);
+	sg->first = first;
+	sg->count = b->nhs.count - first;
+
+	ref = XCALLOC(MTYPE_RIB_SNAPSHOT, sizeof(*ref));
+	ref->nhe = nhe;
+	ref->idx = *idx = b->nhgs.count - 1;
+	rib_snap_nhe_add(&b->nhe_refs, ref);
+	return true;
+}
+
+static void rib_snap_table(struct rib_snap_build *b, struct route_table *table,
+			   vrf_id_t vrf_id)
+{
+	const struct prefix *p, *src_p;
+	struct rib_snap_route *sr;
+	struct route_node *rn;
+	struct route_entry *re;
+	rib_dest_t *dest;
+	uint32_t vrf_idx, nhg_idx;
+
+	if (!table || !rib_snap_vrf_idx(b, vrf_id, &vrf_idx))
+		return;
+
+	for (rn = route_top(table); rn; rn = srcdest_route_next(rn)) {
+		dest = rib_dest_from_rnode(rn);
+		re = dest ? dest->selected_fib : NULL;
+		if (!re || !re->nhe)
+			continue;
+
+		/* whatever the kernel or the config will give us again */
+		if (RIB_SYSTEM_ROUTE(re) || re->type == ZEBRA_ROUTE_TABLE
+		    || CHECK_FLAG(re->status, ROUTE_ENTRY_REMOVED)
+		    || !CHECK_FLAG(re->status, ROUTE_ENTRY_INSTALLED)
+		    || CHECK_FLAG(re->flags, ZEBRA_FLAG_EVPN_ROUTE))
+			continue;
+
+		/* a client's own nexthop group goes away with the client */
+		if (PROTO_OWNED(re->nhe))
+			continue;
+
+		if (!rib_snap_nhe_idx(b, re->nhe, &nhg_idx))
+			continue;
+
+		srcdest_rnode_prefixes(rn, &p, &src_p);
+
+		sr = rib_snap_array_push(&b->routes);
+		sr->family = p->family;
+		sr->dst_len = p->prefixlen;
+		memcpy(&sr->dst, &p->u.prefix, prefix_blen(p));
+		if (src_p && src_p->prefixlen) {
+			sr->src_len = src_p->prefixlen;
+			memcpy(&sr->src, &src_p->u.prefix, prefix_blen(src_p));
+		}
+		sr->type = re->type;
+		sr->instance = re->instance;
+		sr->distance = re->distance;
+		sr->flags = re->flags & ~RIB_SNAP_FLAGS_VOLATILE;
+		sr->metric = re->metric;
+		sr->mtu = re->mtu;
+		sr->tag = re->tag;
+		sr->table = re->table;
+		sr->vrf = vrf_idx;
+		sr->nhg = nhg_idx;
+	}
+}
+
+static bool rib_snap_write_all(int fd, const void *data, size_t len)
+{
+	const uint8_t *p = data;
+	ssize_t nbytes;
+
+	while (len) {
+		nbytes = write(fd, p, len);
+		if (nbytes < 0) {
+			if (errno == EINTR)
+				continue;
+			return false;
+		}
+		p += nbytes;
+		len -= nbytes;
+	}
+	return true;
+}
+
+void zebra_rib_snapshot_write(void)
+{
+	struct rib_snap_build b = {
+		.vrfs.size = sizeof(struct rib_snap_vrf),
+		.nhs.size = sizeof(struct rib_snap_nh),
+		.nhgs.size = sizeof(struct rib_snap_nhg),
+		.routes.size = sizeof(struct rib_snap_route),
+	};
+	struct rib_snap_hdr hdr = {};
+	struct rib_snap_nhe_ref *ref;
+	struct zebra_vrf *zvrf;
+	struct vrf *vrf;
+	char path[512], tmppath[512];
+	bool ok;
+	int fd;
+
+	if (!rib_snapshot_interval)
+		return;
+
+	rib_snap_nhe_init(&b.nhe_refs);
+
+	RB_FOREACH (vrf, vrf_id_head, &vrfs_by_id) {
+		zvrf = vrf->info;
+		if (!zvrf)
+			continue;
+
+		rib_snap_table(&b, zvrf->table[AFI_IP][SAFI_UNICAST],
+			       vrf->vrf_id);
+		rib_snap_table(&b, zvrf->table[AFI_IP6][SAFI_UNICAST],
+			       vrf->vrf_id);
+	}
+
+	hdr.magic = RIB_SNAP_MAGIC;
+	hdr.version = RIB_SNAP_VERSION;
+	hdr.hdr_size = sizeof(hdr);
+	hdr.vrf_size = b.vrfs.size;
+	hdr.nh_size = b.nhs.size;
+	hdr.nhg_size = b.nhgs.size;
+	hdr.route_size = b.routes.size;
+	hdr.vrf_count = b.vrfs.count;
+	hdr.nh_count = b.nhs.count;
+	hdr.nhg_count = b.nhgs.count;
+	hdr.route_count = b.routes.count;
+
+	rib_snapshot_path(path, sizeof(path), "");
+	rib_snapshot_path(tmppath, sizeof(tmppath), ".tmp");
+
+	fd = open(tmppath, O_WRONLY | O_CREAT | O_TRUNC, 0600);
+	if (fd < 0) {
+		flog_err_sys(EC_LIB_SYSTEM_CALL, "%s: cannot create %s: %s",
+			     __func__, tmppath, safe_strerror(errno));
+		goto out;
+	}
+
+	ok = rib_snap_write_all(fd, &hdr, sizeof(hdr))
+	     && rib_snap_write_all(fd, b.vrfs.data, b.vrfs.count * b.vrfs.size)
+	     && rib_snap_write_all(fd, b.nhs.data, b.nhs.count * b.nhs.size)
+	     && rib_snap_write_all(fd, b.nhgs.data, b.nhgs.count * b.nhgs.size)
+	     && rib_snap_write_all(fd, b.routes.data,
+				   b.routes.count * b.routes.size)
+	     && fsync(fd) == 0;
+	close(fd);
+
+	if (!ok || rename(tmppath, path) < 0) {
+		flog_err_sys(EC_LIB_SYSTEM_CALL, "%s: cannot write %s: %s",
+			     __func__, path, safe_strerror(errno));
+		unlink(tmppath);
+		goto out;
+	}
+
+	if (IS_ZEBRA_DEBUG_RIB)
+		zlog_debug("%s: %u routes, %u nexthop groups written to %s",
+			   __func__, hdr.route_count, hdr.nhg_count, path);
+
+out:
+	while ((ref = rib_snap_nhe_pop(&b.nhe_refs)))
+		XFREE(MTYPE_RIB_SNAPSHOT, ref);
+	rib_snap_nhe_fini(&b.nhe_refs);
+	XFREE(MTYPE_RIB_SNAPSHOT, b.vrfs.data);
+	XFREE(MTYPE_RIB_SNAPSHOT, b.nhs.data);
+	XFREE(MTYPE_RIB_SNAPSHOT, b.nhgs.data);
+	XFREE(MTYPE_RIB_SNAPSHOT, b.routes.data);
+}
+
+static int zebra_rib_snapshot_timer(struct thread *thread)
+{
+	zebra_rib_snapshot_write();
+
+	thread_add_timer(zrouter.master, zebra_rib_snapshot_timer, NULL,
+			 rib_snapshot_interval, &t_rib_snapshot);
+	return 0;
+}
+
+void zebra_rib_snapshot_init(unsigned int interval)
+{
+	rib_snapshot_interval = interval;
+	if (!interval)
+		return;
+
+	thread_add_timer(zrouter.master, zebra_rib_snapshot_timer, NULL,
+			 interval, &t_rib_snapshot);
+}
+
+void zebra_rib_snapshot_finish(void)
+{
+	THREAD_OFF(t_rib_snapshot);
+}
+
+/* Restore side; the file is untrusted input as far as indices go. */
+struct rib_snap_view {
+	const struct rib_snap_hdr *hdr;
+	const struct rib_snap_vrf *vrfs;
+	const struct rib_snap_nh *nhs;
+	const struct rib_snap_nhg *nhgs;
+	const struct rib_snap_route *routes;
+	vrf_id_t *vrf_ids;
+};
+
+static bool rib_snap_view_init(struct rib_snap_view *v, const uint8_t *data,
+			       size_t len)
+{
+	const struct rib_snap_hdr *hdr = (const struct rib_snap_hdr *)data;
+	uint64_t need;
+
+	if (len < sizeof(*hdr) || hdr->magic != RIB_SNAP_MAGIC
+	    || hdr->version != RIB_SNAP_VERSION
+	    || hdr->hdr_size != sizeof(*hdr)
+	    || hdr->vrf_size != sizeof(struct rib_snap_vrf)
+	    || hdr->nh_size != sizeof(struct rib_snap_nh)
+	    || hdr->nhg_size != sizeof(struct rib_snap_nhg)
+	    || hdr->route_size != sizeof(struct rib_snap_route))
+		return false;
+
+	need = sizeof(*hdr) + (uint64_t)hdr->vrf_count * hdr->vrf_size
+	       + (uint64_t)hdr->nh_count * hdr->nh_size
+	       + (uint64_t)hdr->nhg_count * hdr->nhg_size
+	       + (uint64_t)hdr->route_count * hdr->route_size;
+	if (need != len)
+		return false;
+
+	v->hdr = hdr;
+	data += sizeof(*hdr);
+	v->vrfs = (const struct rib_snap_vrf *)data;
+	data += hdr->vrf_count * hdr->vrf_size;
+	v->nhs = (const struct rib_snap_nh *)data;
+	data += hdr->nh_count * hdr->nh_size;
+	v->nhgs = (const struct rib_snap_nhg *)data;
+	data += hdr->nhg_count * hdr->nhg_size;
+	v->routes = (const struct rib_snap_route *)data;
+	return true;
+}
+
+static struct nexthop_group *rib_snap_nhg_get(const struct rib_snap_view *v,
+					      uint32_t idx)
+{
+	const struct rib_snap_nhg *sg;
+	const struct rib_snap_nh *sn;
+	struct nexthop_group *ng;
+	struct nexthop *nh;
+	uint32_t i;
+
+	if (idx >= v->hdr->nhg_count)
+		return NULL;
+	sg = &v->nhgs[idx];
+	if (!sg->count || sg->first >= v->hdr->nh_count
+	    || sg->count > v->hdr->nh_count - sg->first)
+		return NULL;
+
+	ng = nexthop_group_new();
+	for (i = 0; i < sg->count; i++) {
+		sn = &v->nhs[sg->first + i];
+		if (sn->vrf >= v->hdr->vrf_count
+		    || v->vrf_ids[sn->vrf] == VRF_UNKNOWN
+		    || sn->type < NEXTHOP_TYPE_IFINDEX
+		    || sn->type > NEXTHOP_TYPE_BLACKHOLE
+		    || sn->num_labels > MPLS_MAX_LABELS) {
+			nexthop_group_delete(&ng);
+			return NULL;
+		}
+
+		nh = nexthop_new();
+		nh->type = sn->type;
+		nh->vrf_id = v->vrf_ids[sn->vrf];
+		nh->ifindex = sn->ifindex;
+		if (nh->type == NEXTHOP_TYPE_BLACKHOLE)
+			nh->bh_type = sn->bh_type;
+		else
+			nh->gate = sn->gate;
+		nh->src = sn->src;
+		nh->weight = sn->weight;
+		nh->flags = sn->flags & NEXTHOP_FLAG_ONLINK;
+		if (sn->num_labels)
+			nexthop_add_labels(nh, sn->label_type, sn->num_labels,
+					   sn->labels);
+		nexthop_group_add_sorted(ng, nh);
+	}
+	return ng;
+}
+
+static bool rib_snap_route_add(const struct rib_snap_view *v,
+			       const struct rib_snap_route *sr)
+{
+	struct prefix p = {};
+	struct prefix_ipv6 src_p = {};
+	struct nexthop_group *ng;
+	struct route_entry *re;
+	afi_t afi;
+
+	if (sr->family != AF_INET && sr->family != AF_INET6)
+		return false;
+	afi = family2afi(sr->family);
+	if (sr->dst_len > (afi == AFI_IP ? IPV4_MAX_BITLEN : IPV6_MAX_BITLEN)
+	    || sr->src_len > (afi == AFI_IP ? 0 : IPV6_MAX_BITLEN)
+	    || sr->type >= ZEBRA_ROUTE_MAX || RSYSTEM_ROUTE(sr->type)
+	    || sr->vrf >= v->hdr->vrf_count
+	    || v->vrf_ids[sr->vrf] == VRF_UNKNOWN)
+		return false;
+
+	p.family = sr->family;
+	p.prefixlen = sr->dst_len;
+	memcpy(&p.u.prefix, &sr->dst, prefix_blen(&p));
+	apply_mask(&p);
+	if (sr->src_len) {
+		src_p.family = AF_INET6;
+		src_p.prefixlen = sr->src_len;
+		src_p.prefix = sr->src.ipv6;
+		apply_mask_ipv6(&src_p);
+	}
+
+	ng = rib_snap_nhg_get(v, sr->nhg);
+	if (!ng)
+		return false;
+
+	/*
+	 * Marked like the routes read from the kernel: a client announcing
+	 * the route replaces it, otherwise the startup sweep removes it.
+	 */
+	re = XCALLOC(MTYPE_RE, sizeof(struct route_entry));
+	re->type = sr->type;
+	re->instance = sr->instance;
+	re->distance = sr->distance;
+	re->flags = (sr->flags & ~RIB_SNAP_FLAGS_VOLATILE)
+		    | ZEBRA_FLAG_SELFROUTE;
+	re->metric = sr->metric;
+	re->mtu = sr->mtu;
+	re->tag = sr->tag;
+	re->table = sr->table;
+	re->vrf_id = v->vrf_ids[sr->vrf];
+	re->uptime = monotime(NULL);
+
+	return rib_add_multipath(afi, SAFI_UNICAST, &p,
+				 sr->src_len ? &src_p : NULL, re, ng)
+	       >= 0;
+}
+
+void zebra_rib_snapshot_restore(void)
+{
+	struct rib_snap_view v = {};
+	struct vrf *vrf;
+	char path[512];
+	struct stat st;
+	uint8_t *data;
+	uint32_t i, added = 0;
+	int fd;
+
+	if (!rib_snapshot_interval)
+		return;
+
+	rib_snapshot_path(path, sizeof(path), "");
+	fd = open(path, O_RDONLY);
+	if (fd < 0) {
+		if (errno != ENOENT)
+			flog_err_sys(EC_LIB_SYSTEM_CALL,
+				     "%s: cannot open %s: %s", __func__, path,
+				     safe_strerror(errno));
+		return;
+	}
+
+	if (fstat(fd, &st) < 0 || st.st_size == 0) {
+		close(fd);
+		return;
+	}
+
+	data = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+	if (data == MAP_FAILED) {
+		flog_err_sys(EC_LIB_SYSTEM_CALL, "%s: cannot map %s: %s",
+			     __func__, path, safe_strerror(errno));
+		return;
+	}
+
+	if (!rib_snap_view_init(&v, data, st.st_size)) {
+		zlog_warn("%s: %s is not a usable RIB snapshot, ignoring",
+			  __func__, path);
+		munmap(data, st.st_size);
+		return;
+	}
+
+	v.vrf_ids = XCALLOC(MTYPE_RIB_SNAPSHOT,
+			    (v.hdr->vrf_count + 1) * sizeof(vrf_id_t));
+	for (i = 0; i < v.hdr->vrf_count; i++) {
+		char name[VRF_NAMSIZ + 1];
+
+		strlcpy(name, v.vrfs[i].name, sizeof(name));
+		vrf = vrf_lookup_by_name(name);
+		v.vrf_ids[i] = (vrf && vrf->info) ? vrf->vrf_id : VRF_UNKNOWN;
+	}
+
+	for (i = 0; i < v.hdr->route_count; i++)
+		if (rib_snap_route_add(&v, &v.routes[i]))
+			added++;
+
+	zlog_info("Restored %u of %u routes from RIB snapshot %s", added,
+		  v.hdr->route_count, path);
+
+	XFREE(MTYPE_RIB_SNAPSHOT, v.vrf_ids);
+	munmap(data, st.st_size);
+}
@@ -0,0 +1,58 @@
+/*
+ * Zebra RIB snapshot for warm restarts.
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#ifndef _ZEBRA_RIB_SNAPSHOT_H
+#define _ZEBRA_RIB_SNAPSHOT_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/*
+ * With --rib-snapshot, zebra periodically writes the routes it has installed
+ * to a file in the runtime directory.  When started with -K, the routes are
+ * put back into the RIB from that file before any client connects, so that
+ * they can be redistributed and resolved against right away; the kernel is
+ * only written to for routes that differ from what it already has.  Routes
+ * no client re-announces are removed by the usual startup sweep.
+ */
+
+/*
+ * Write a snapshot every 'interval' seconds; 0 disables snapshots.
+ */
+extern void zebra_rib_snapshot_init(unsigned int interval);
+
+/*
+ * Restore the RIB from the last snapshot, after the kernel state has been
+ * read.
+ */
+extern void zebra_rib_snapshot_restore(void);
+
+/*
+ * Write a snapshot now, e.g. when shutting down with routes retained.
+ */
+extern void zebra_rib_snapshot_write(void);
+
+extern void zebra_rib_snapshot_finish(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* _ZEBRA_RIB_SNAPSHOT_H */
@@ -57,6 +57,16 @@ DEFINE_MTYPE_STATIC(ZEBRA, RNH, "Nexthop tracking object");
  */
 static bool rnh_hide_backups;
 
+/*
+ * Tracked nexthops whose clients still need a NEXTHOP_UPDATE.  A route
+ * change can re-evaluate the same rnh several times in one pass of the
+ * rib processing, and a burst of changes re-evaluates it over and over;
+ * each client gets one update with the final state when the pass is done.
+ */
+DECLARE_DLIST(rnh_notify, struct rnh, rnh_notify_item);
+static struct rnh_notify_head rnh_notify_pending;
+static struct thread *t_rnh_notify;
+
 static void free_state(vrf_id_t vrf_id, struct route_entry *re,
 		       struct route_node *rn);
 static void copy_state(struct rnh *rnh, const struct route_entry *re,
@@ -67,6 +77,7 @@ static int zebra_client_cleanup_rnh(struct zserv *client);
 
 void zebra_rnh_init(void)
 {
+	rnh_notify_init(&rnh_notify_pending);
 	hook_register(zserv_client_close, zebra_client_cleanup_rnh);
 }
 
@@ -224,6 +235,10 @@ void zebra_free_rnh(struct rnh *rnh)
 
 	zebra_rnh_remove_from_routing_table(rnh);
 	rnh->flags |= ZEBRA_NHT_DELETED;
+	if (CHECK_FLAG(rnh->flags, ZEBRA_NHT_NOTIFY_PENDING)) {
+		rnh_notify_del(&rnh_notify_pending, rnh);
+		UNSET_FLAG(rnh->flags, ZEBRA_NHT_NOTIFY_PENDING);
+	}
 	list_delete(&rnh->client_list);
 	list_delete(&rnh->zebra_pseudowire_list);
 
@@ -395,18 +410,18 @@ static void zebra_rnh_clear_nexthop_rnh_filters(struct route_entry *re)
  * resolving a NH.
  */
 static int zebra_rnh_apply_nht_rmap(afi_t afi, struct zebra_vrf *zvrf,
-				    struct route_node *prn,
+				    const struct prefix *p,
 				    struct route_entry *re, int proto)
 {
 	int at_least_one = 0;
 	struct nexthop *nexthop;
 	route_map_result_t ret;
 
-	if (prn && re) {
+	if (p && re) {
 		for (nexthop = re->nhe->nhg.nexthop; nexthop;
 		     nexthop = nexthop->next) {
 			ret = zebra_nht_route_map_check(
-				afi, proto, &prn->p, zvrf, re, nexthop);
+				afi, proto, p, zvrf, re, nexthop);
 			if (ret != RMAP_DENYMATCH)
 				at_least_one++; /* at least one valid NH */
 			else {
@@ -524,23 +539,22 @@ static void zebra_rnh_eval_import_check_entry(struct zebra_vrf *zvrf, afi_t afi,
 }
 
 /*
- * Notify clients registered for this nexthop about a change.
+ * Notify clients registered for this nexthop about its current state.
  */
-static void zebra_rnh_notify_protocol_clients(struct zebra_vrf *zvrf, afi_t afi,
-					      struct route_node *nrn,
-					      struct rnh *rnh,
-					      struct route_node *prn,
-					      struct route_entry *re)
+static void zebra_rnh_notify_protocol_clients(struct zebra_vrf *zvrf,
+					      struct rnh *rnh)
 {
+	struct route_node *nrn = rnh->node;
+	struct route_entry *re = rnh->state;
 	struct listnode *node;
 	struct zserv *client;
 	int num_resolving_nh;
 
 	if (IS_ZEBRA_DEBUG_NHT) {
-		if (prn && re) {
-			zlog_debug("%s(%u):%pRN: NH resolved over route %pRN",
+		if (re) {
+			zlog_debug("%s(%u):%pRN: NH resolved over route %pFX",
 				   VRF_LOGNAME(zvrf->vrf), zvrf->vrf->vrf_id,
-				   nrn, prn);
+				   nrn, &rnh->resolved_route);
 		} else
 			zlog_debug("%s(%u):%pRN: NH has become unresolved",
 				   VRF_LOGNAME(zvrf->vrf), zvrf->vrf->vrf_id,
@@ -548,14 +562,15 @@ static void zebra_rnh_notify_protocol_clients(struct zebra_vrf *zvrf, afi_t afi,
 	}
 
 	for (ALL_LIST_ELEMENTS_RO(rnh->client_list, node, client)) {
-		if (prn && re) {
+		if (re) {
 			/* Apply route-map for this client to route resolving
 			 * this
 			 * nexthop to see if it is filtered or not.
 			 */
 			zebra_rnh_clear_nexthop_rnh_filters(re);
 			num_resolving_nh = zebra_rnh_apply_nht_rmap(
-				afi, zvrf, prn, re, client->proto);
+				rnh->afi, zvrf, &rnh->resolved_route, re,
+				client->proto);
 			if (num_resolving_nh)
 				rnh->filtered[client->proto] = 0;
 			else
@@ -588,6 +603,39 @@ static void zebra_rnh_notify_protocol_clients(struct zebra_vrf *zvrf, afi_t afi,
 		zebra_rnh_clear_nexthop_rnh_filters(re);
 }
 
+static int zebra_rnh_notify_pending(struct thread *thread)
+{
+	struct zebra_vrf *zvrf;
+	struct rnh *rnh;
+
+	while ((rnh = rnh_notify_pop(&rnh_notify_pending))) {
+		UNSET_FLAG(rnh->flags, ZEBRA_NHT_NOTIFY_PENDING);
+
+		zvrf = zebra_vrf_lookup_by_id(rnh->vrf_id);
+		if (!zvrf)
+			continue;
+
+		zebra_rnh_notify_protocol_clients(zvrf, rnh);
+	}
+
+	return 0;
+}
+
+/*
+ * Queue the clients of this nexthop for notification, once the current
+ * batch of route changes has been evaluated.
+ */
+static void zebra_rnh_notify_schedule(struct rnh *rnh)
+{
+	if (!CHECK_FLAG(rnh->flags, ZEBRA_NHT_NOTIFY_PENDING)) {
+		SET_FLAG(rnh->flags, ZEBRA_NHT_NOTIFY_PENDING);
+		rnh_notify_add_tail(&rnh_notify_pending, rnh);
+	}
+
+	thread_add_event(zrouter.master, zebra_rnh_notify_pending, NULL, 0,
+			 &t_rnh_notify);
+}
+
 /*
  * Utility to determine whether a candidate nexthop is useable. We make this
  * check in a couple of places, so this is a single home for the logic we
@@ -813,8 +861,7 @@ static void zebra_rnh_eval_nexthop_entry(struct zebra_vrf *zvrf, afi_t afi,
 		 * rnh->state.
 		 */
 		/* Notify registered protocol clients. */
-		zebra_rnh_notify_protocol_clients(zvrf, afi, nrn, rnh, prn,
-						  rnh->state);
+		zebra_rnh_notify_schedule(rnh);
 
 		/* Process pseudowires attached to this nexthop */
 		zebra_rnh_process_pseudowires(zvrf->vrf->vrf_id, rnh);
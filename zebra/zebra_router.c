@@ -34,6 +34,16 @@
 DEFINE_MTYPE_STATIC(ZEBRA, RIB_TABLE_INFO, "RIB table info");
 DEFINE_MTYPE_STATIC(ZEBRA, ZEBRA_RT_TABLE, "Zebra VRF table");
 
+/* enum zebra_conv_stage */
+static const char *const zebra_conv_stages[] = {
+	"zapi-receive",
+	"rib-process",
+	"dplane-enqueue",
+	"kernel-ack",
+	"fpm-send",
+	"dplane-result",
+};
+
 struct zebra_router zrouter = {
 	.multipath_num = MULTIPATH_NUM,
 	.ipv4_multicast_mode = MCAST_NO_CONFIG,
@@ -110,6 +120,7 @@ struct route_table *zebra_router_get_table(struct zebra_vrf *zvrf,
 	struct zebra_router_table finder;
 	struct zebra_router_table *zrt;
 	struct rib_table_info *info;
+	int type;
 
 	memset(&finder, 0, sizeof(finder));
 	finder.afi = afi;
@@ -128,12 +139,16 @@ struct route_table *zebra_router_get_table(struct zebra_vrf *zvrf,
 	zrt->ns_id = zvrf->zns->ns_id;
 	zrt->table =
 		(afi == AFI_IP6) ? srcdest_table_init() : route_table_init();
+	/* nexthop resolution does a lot of longest-prefix matching here */
+	route_table_enable_lpm_index(zrt->table);
 
 	info = XCALLOC(MTYPE_RIB_TABLE_INFO, sizeof(*info));
 	info->zvrf = zvrf;
 	info->afi = afi;
 	info->safi = safi;
 	info->table_id = tableid;
+	for (type = 0; type < ZEBRA_ROUTE_MAX; type++)
+		re_type_list_init(&info->type_routes[type]);
 	route_table_set_info(zrt->table, info);
 	zrt->table->cleanup = zebra_rtable_node_cleanup;
 
@@ -241,10 +256,12 @@ void zebra_router_terminate(void)
 	zebra_mlag_terminate();
 
 	/* Free NHE in ID table only since it has unhashable entries as well */
+	zebra_nhg_id_index_fini();
 	hash_clean(zrouter.nhgs_id, zebra_nhg_hash_free);
 	hash_free(zrouter.nhgs_id);
 	hash_clean(zrouter.nhgs, NULL);
 	hash_free(zrouter.nhgs);
+	hash_free(zrouter.nhgs_kernel);
 
 	hash_clean(zrouter.rules_hash, zebra_pbr_rules_free);
 	hash_free(zrouter.rules_hash);
@@ -255,6 +272,8 @@ void zebra_router_terminate(void)
 	hash_free(zrouter.ipset_entry_hash);
 	hash_clean(zrouter.iptable_hash, zebra_pbr_iptable_free);
 	hash_free(zrouter.iptable_hash);
+
+	conv_sampler_free(&zrouter.conv);
 }
 
 bool zebra_router_notify_on_ack(void)
@@ -288,12 +307,18 @@ void zebra_router_init(bool asic_offload, bool notify_on_ack)
 						"IPtable Hash Entry");
 
 	zrouter.nhgs =
-		hash_create_size(8, zebra_nhg_hash_key, zebra_nhg_hash_equal,
+		hash_create_open(8, zebra_nhg_hash_key, zebra_nhg_hash_equal,
 				 "Zebra Router Nexthop Groups");
 	zrouter.nhgs_id =
 		hash_create_size(8, zebra_nhg_id_key, zebra_nhg_hash_id_equal,
 				 "Zebra Router Nexthop Groups ID index");
+	zrouter.nhgs_kernel = hash_create_size(
+		8, zebra_nhg_kernel_key_hash, zebra_nhg_kernel_key_equal,
+		"Zebra Router Nexthop Groups kernel objects");
 
 	zrouter.asic_offloaded = asic_offload;
 	zrouter.notify_on_ack = notify_on_ack;
+
+	zrouter.conv = conv_sampler_new("zebra", zebra_conv_stages,
+					array_size(zebra_conv_stages));
 }
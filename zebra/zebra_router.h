@@ -23,6 +23,7 @@
 #define __ZEBRA_ROUTER_H__
 
 #include "lib/mlag.h"
+#include "lib/convergence.h"
 
 #include "zebra/zebra_ns.h"
 
@@ -129,6 +130,11 @@ struct zebra_mlag_info {
 	struct thread *t_read;
 	/* Event for MLAG write */
 	struct thread *t_write;
+
+	/* Written to MLAGD by the MLAG pthread, for "show zebra mlag" */
+	_Atomic uint32_t wr_msgs;
+	_Atomic uint32_t wr_errors;
+	_Atomic uint64_t wr_bytes;
 };
 
 struct zebra_router {
@@ -202,12 +208,36 @@ struct zebra_router {
 	 */
 	struct hash *nhgs;
 	struct hash *nhgs_id;
+	/* kernel nexthop objects that NHEs can share */
+	struct hash *nhgs_kernel;
 
 	/*
 	 * Does the underlying system provide an asic offload
 	 */
 	bool asic_offloaded;
 	bool notify_on_ack;
+
+	/*
+	 * Number of parallel kernel dataplane shards (--dplane-shards),
+	 * 1 if the kernel is programmed from the dataplane pthread only
+	 */
+	uint8_t dplane_shards;
+
+	/* Kernel messages are received on a pthread of their own */
+	bool netlink_reader;
+
+	/* "zebra convergence-sampling", stages are enum zebra_conv_stage */
+	struct conv_sampler *conv;
+};
+
+/* Convergence sampling stages, see lib/convergence.h */
+enum zebra_conv_stage {
+	ZEBRA_CONV_ZAPI_RECEIVE = 0,
+	ZEBRA_CONV_RIB_PROCESS,
+	ZEBRA_CONV_DPLANE_ENQUEUE,
+	ZEBRA_CONV_KERNEL_ACK,
+	ZEBRA_CONV_FPM_SEND,
+	ZEBRA_CONV_DPLANE_RESULT,
 };
 
 #define GRACEFUL_RESTART_TIME 60
@@ -0,0 +1,251 @@
+/* Tracing for zebra
+ *
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#if !defined(_ZEBRA_TRACE_H) || defined(TRACEPOINT_HEADER_MULTI_READ)
+#define _ZEBRA_TRACE_H
+
+#include "lib/trace.h"
+
+#ifdef HAVE_LTTNG
+
+#undef TRACEPOINT_PROVIDER
+#define TRACEPOINT_PROVIDER frr_zebra
+
+#undef TRACEPOINT_INCLUDE
+#define TRACEPOINT_INCLUDE "zebra/zebra_trace.h"
+
+#include <lttng/tracepoint.h>
+
+#include "lib/log.h"
+#include "lib/stream.h"
+#include "lib/table.h"
+#include "lib/zclient.h"
+#include "zebra/zebra_dplane.h"
+#include "zebra/zebra_nhg.h"
+#include "zebra/zserv.h"
+
+/*
+ * The events below follow a route from the zapi message carrying it to the
+ * dataplane result for it; the dplane events carry the context pointer,
+ * which is what ties them together.  Prefixes are recorded as family,
+ * length and address bytes so that nothing needs formatting at the trace
+ * site.
+ */
+
+/* clang-format off */
+
+/* A zapi message has been read by the zserv pthread */
+TRACEPOINT_EVENT(
+	frr_zebra,
+	zserv_read,
+	TP_ARGS(struct zserv *, client, uint16_t, command, uint16_t, length),
+	TP_FIELDS(
+		ctf_string(client, zebra_route_string(client->proto))
+		ctf_integer(unsigned short, instance, client->instance)
+		ctf_string(command, zserv_command_string(command))
+		ctf_integer(uint16_t, length, length)
+	)
+)
+
+TRACEPOINT_LOGLEVEL(frr_zebra, zserv_read, TRACE_DEBUG)
+
+/* A zapi message is handed to the socket */
+TRACEPOINT_EVENT(
+	frr_zebra,
+	zserv_write,
+	TP_ARGS(struct zserv *, client, struct stream *, msg),
+	TP_FIELDS(
+		ctf_string(client, zebra_route_string(client->proto))
+		ctf_integer(unsigned short, instance, client->instance)
+		ctf_string(command, zserv_command_string(stream_getw_from(
+				   msg, ZAPI_HEADER_CMD_LOCATION)))
+		ctf_integer(size_t, length, stream_get_endp(msg))
+	)
+)
+
+TRACEPOINT_LOGLEVEL(frr_zebra, zserv_write, TRACE_DEBUG)
+
+TRACEPOINT_EVENT_CLASS(
+	frr_zebra,
+	zapi_route,
+	TP_ARGS(struct zserv *, client, vrf_id_t, vrf_id, uint32_t, table_id,
+		const struct prefix *, p),
+	TP_FIELDS(
+		ctf_string(client, zebra_route_string(client->proto))
+		ctf_integer(unsigned short, instance, client->instance)
+		ctf_integer(vrf_id_t, vrf_id, vrf_id)
+		ctf_integer(uint32_t, table_id, table_id)
+		ctf_integer(uint8_t, family, p->family)
+		ctf_integer(uint16_t, prefixlen, p->prefixlen)
+		ctf_array(unsigned char, prefix, &p->u.prefix, 16)
+	)
+)
+
+#define ZAPI_ROUTE_TRACEPOINT_INSTANCE(name)                                   \
+	TRACEPOINT_EVENT_INSTANCE(                                             \
+		frr_zebra, zapi_route, name,                                   \
+		TP_ARGS(struct zserv *, client, vrf_id_t, vrf_id,              \
+			uint32_t, table_id, const struct prefix *, p))         \
+	TRACEPOINT_LOGLEVEL(frr_zebra, name, TRACE_INFO)
+
+/* A route add / delete from a client is handed to the rib */
+ZAPI_ROUTE_TRACEPOINT_INSTANCE(zapi_route_add)
+ZAPI_ROUTE_TRACEPOINT_INSTANCE(zapi_route_delete)
+
+/* A route node is put on a meta queue sub-queue */
+TRACEPOINT_EVENT(
+	frr_zebra,
+	rib_queue_add,
+	TP_ARGS(struct route_node *, rn, uint8_t, qindex),
+	TP_FIELDS(
+		ctf_integer(uint8_t, family, rn->p.family)
+		ctf_integer(uint16_t, prefixlen, rn->p.prefixlen)
+		ctf_array(unsigned char, prefix, &rn->p.u.prefix, 16)
+		ctf_integer(uint8_t, sub_queue, qindex)
+	)
+)
+
+TRACEPOINT_LOGLEVEL(frr_zebra, rib_queue_add, TRACE_INFO)
+
+/* An item is taken off a meta queue sub-queue */
+TRACEPOINT_EVENT(
+	frr_zebra,
+	meta_queue_process,
+	TP_ARGS(uint8_t, qindex, uint32_t, subq_len, uint32_t, mq_size),
+	TP_FIELDS(
+		ctf_integer(uint8_t, sub_queue, qindex)
+		ctf_integer(uint32_t, sub_queue_len, subq_len)
+		ctf_integer(uint32_t, meta_queue_size, mq_size)
+	)
+)
+
+TRACEPOINT_LOGLEVEL(frr_zebra, meta_queue_process, TRACE_DEBUG)
+
+/* Best path selection runs for a route node */
+TRACEPOINT_EVENT(
+	frr_zebra,
+	rib_process,
+	TP_ARGS(const struct prefix *, p, vrf_id_t, vrf_id),
+	TP_FIELDS(
+		ctf_integer(vrf_id_t, vrf_id, vrf_id)
+		ctf_integer(uint8_t, family, p->family)
+		ctf_integer(uint16_t, prefixlen, p->prefixlen)
+		ctf_array(unsigned char, prefix, &p->u.prefix, 16)
+	)
+)
+
+TRACEPOINT_LOGLEVEL(frr_zebra, rib_process, TRACE_INFO)
+
+/* A context is queued for the dataplane pthread */
+TRACEPOINT_EVENT(
+	frr_zebra,
+	dplane_enqueue,
+	TP_ARGS(struct zebra_dplane_ctx *, ctx, uint32_t, queued),
+	TP_FIELDS(
+		ctf_integer_hex(intptr_t, ctx, ctx)
+		ctf_string(op, dplane_op2str(dplane_ctx_get_op(ctx)))
+		ctf_integer(vrf_id_t, vrf_id, dplane_ctx_get_vrf(ctx))
+		ctf_integer(uint32_t, queued, queued)
+	)
+)
+
+TRACEPOINT_LOGLEVEL(frr_zebra, dplane_enqueue, TRACE_INFO)
+
+TRACEPOINT_EVENT_CLASS(
+	frr_zebra,
+	dplane_provider,
+	TP_ARGS(struct zebra_dplane_provider *, prov,
+		struct zebra_dplane_ctx *, ctx),
+	TP_FIELDS(
+		ctf_string(provider, dplane_provider_get_name(prov))
+		ctf_integer_hex(intptr_t, ctx, ctx)
+		ctf_string(op, dplane_op2str(dplane_ctx_get_op(ctx)))
+		ctf_string(status, dplane_res2str(dplane_ctx_get_status(ctx)))
+	)
+)
+
+#define DPLANE_PROVIDER_TRACEPOINT_INSTANCE(name)                              \
+	TRACEPOINT_EVENT_INSTANCE(                                             \
+		frr_zebra, dplane_provider, name,                              \
+		TP_ARGS(struct zebra_dplane_provider *, prov,                  \
+			struct zebra_dplane_ctx *, ctx))                       \
+	TRACEPOINT_LOGLEVEL(frr_zebra, name, TRACE_DEBUG)
+
+/* A provider takes a context in, and passes it on when done with it */
+DPLANE_PROVIDER_TRACEPOINT_INSTANCE(dplane_provider_dequeue)
+DPLANE_PROVIDER_TRACEPOINT_INSTANCE(dplane_provider_enqueue)
+
+/* The dataplane result for a route is back on the main pthread */
+TRACEPOINT_EVENT(
+	frr_zebra,
+	rib_process_result,
+	TP_ARGS(struct zebra_dplane_ctx *, ctx),
+	TP_FIELDS(
+		ctf_integer_hex(intptr_t, ctx, ctx)
+		ctf_string(op, dplane_op2str(dplane_ctx_get_op(ctx)))
+		ctf_string(status, dplane_res2str(dplane_ctx_get_status(ctx)))
+		ctf_integer(vrf_id_t, vrf_id, dplane_ctx_get_vrf(ctx))
+		ctf_integer(uint32_t, table_id, dplane_ctx_get_table(ctx))
+		ctf_integer(uint8_t, family, dplane_ctx_get_dest(ctx)->family)
+		ctf_integer(uint16_t, prefixlen,
+			    dplane_ctx_get_dest(ctx)->prefixlen)
+		ctf_array(unsigned char, prefix,
+			  &dplane_ctx_get_dest(ctx)->u.prefix, 16)
+	)
+)
+
+TRACEPOINT_LOGLEVEL(frr_zebra, rib_process_result, TRACE_INFO)
+
+/* A nexthop group is queued for installation */
+TRACEPOINT_EVENT(
+	frr_zebra,
+	nhg_install,
+	TP_ARGS(struct nhg_hash_entry *, nhe, int, ret),
+	TP_FIELDS(
+		ctf_integer(uint32_t, id, nhe->id)
+		ctf_string(type, zebra_route_string(nhe->type))
+		ctf_integer_hex(uint32_t, flags, nhe->flags)
+		ctf_integer(int, result, ret)
+	)
+)
+
+TRACEPOINT_LOGLEVEL(frr_zebra, nhg_install, TRACE_INFO)
+
+/* The dataplane result for a nexthop group is back on the main pthread */
+TRACEPOINT_EVENT(
+	frr_zebra,
+	nhg_dplane_result,
+	TP_ARGS(struct zebra_dplane_ctx *, ctx),
+	TP_FIELDS(
+		ctf_integer_hex(intptr_t, ctx, ctx)
+		ctf_integer(uint32_t, id, dplane_ctx_get_nhe_id(ctx))
+		ctf_string(op, dplane_op2str(dplane_ctx_get_op(ctx)))
+		ctf_string(status, dplane_res2str(dplane_ctx_get_status(ctx)))
+	)
+)
+
+TRACEPOINT_LOGLEVEL(frr_zebra, nhg_dplane_result, TRACE_INFO)
+
+/* clang-format on */
+
+#include <lttng/tracepoint-event.h>
+
+#endif /* HAVE_LTTNG */
+
+#endif /* _ZEBRA_TRACE_H */
@@ -62,6 +62,8 @@
 
 extern int allow_delete;
 
+DEFINE_MTYPE_STATIC(ZEBRA, ROUTE_SHOW_WALK, "Route show walk");
+
 /* context to manage dumps in multiple tables or vrfs */
 struct route_show_ctx {
 	bool multi;       /* dump multiple tables or vrf */
@@ -1129,6 +1131,100 @@ static void vty_show_ip_route_detail_json(struct vty *vty,
 	json_object_free(json);
 }
 
+/* what "show ip route" is looking for */
+struct route_show_filter {
+	afi_t afi;
+	bool use_fib;
+	route_tag_t tag;
+	const struct prefix *longer_prefix_p;
+	bool supernets_only;
+	int type;
+	unsigned short ospf_instance_id;
+	bool use_json;
+	uint32_t tableid;
+};
+
+/*
+ * Shows the matching routes of one node.  For json, returns the array of
+ * routes if there were any; first is cleared once the text header is out.
+ */
+static json_object *do_show_route_node(struct vty *vty,
+				       struct zebra_vrf *zvrf,
+				       struct route_node *rn,
+				       const struct route_show_filter *flt,
+				       int *first, struct route_show_ctx *ctx)
+{
+	struct route_entry *re;
+	rib_dest_t *dest;
+	json_object *json_prefix = NULL;
+	uint32_t addr;
+
+	dest = rib_dest_from_rnode(rn);
+
+	RNODE_FOREACH_RE (rn, re) {
+		if (flt->use_fib && re != dest->selected_fib)
+			continue;
+
+		if (flt->tag && re->tag != flt->tag)
+			continue;
+
+		if (flt->longer_prefix_p
+		    && !prefix_match(flt->longer_prefix_p, &rn->p))
+			continue;
+
+		/* This can only be true when the afi is IPv4 */
+		if (flt->supernets_only) {
+			addr = ntohl(rn->p.u.prefix4.s_addr);
+
+			if (IN_CLASSC(addr) && rn->p.prefixlen >= 24)
+				continue;
+
+			if (IN_CLASSB(addr) && rn->p.prefixlen >= 16)
+				continue;
+
+			if (IN_CLASSA(addr) && rn->p.prefixlen >= 8)
+				continue;
+		}
+
+		if (flt->type && re->type != flt->type)
+			continue;
+
+		if (flt->ospf_instance_id
+		    && (re->type != ZEBRA_ROUTE_OSPF
+			|| re->instance != flt->ospf_instance_id))
+			continue;
+
+		if (flt->use_json) {
+			if (!json_prefix)
+				json_prefix = json_object_new_array();
+		} else if (*first) {
+			if (!ctx->header_done) {
+				if (flt->afi == AFI_IP)
+					vty_out(vty, SHOW_ROUTE_V4_HEADER);
+				else
+					vty_out(vty, SHOW_ROUTE_V6_HEADER);
+			}
+			if (ctx->multi && ctx->header_done)
+				vty_out(vty, "\n");
+			if (ctx->multi || zvrf_id(zvrf) != VRF_DEFAULT
+			    || flt->tableid) {
+				if (!flt->tableid)
+					vty_out(vty, "VRF %s:\n",
+						zvrf_name(zvrf));
+				else
+					vty_out(vty, "VRF %s table %u:\n",
+						zvrf_name(zvrf), flt->tableid);
+			}
+			ctx->header_done = true;
+			*first = 0;
+		}
+
+		vty_show_ip_route(vty, rn, re, json_prefix, flt->use_fib);
+	}
+
+	return json_prefix;
+}
+
 static void do_show_route_helper(struct vty *vty, struct zebra_vrf *zvrf,
 				 struct route_table *table, afi_t afi,
 				 bool use_fib, route_tag_t tag,
@@ -1138,13 +1234,21 @@ static void do_show_route_helper(struct vty *vty, struct zebra_vrf *zvrf,
 				 uint32_t tableid, struct route_show_ctx *ctx)
 {
 	struct route_node *rn;
-	struct route_entry *re;
 	int first = 1;
-	rib_dest_t *dest;
 	json_object *json = NULL;
 	json_object *json_prefix = NULL;
-	uint32_t addr;
 	char buf[BUFSIZ];
+	struct route_show_filter flt = {
+		.afi = afi,
+		.use_fib = use_fib,
+		.tag = tag,
+		.longer_prefix_p = longer_prefix_p,
+		.supernets_only = supernets_only,
+		.type = type,
+		.ospf_instance_id = ospf_instance_id,
+		.use_json = use_json,
+		.tableid = tableid,
+	};
 
 	/*
 	 * ctx->multi indicates if we are dumping multiple tables or vrfs.
@@ -1162,77 +1266,11 @@ static void do_show_route_helper(struct vty *vty, struct zebra_vrf *zvrf,
 
 	/* Show all routes. */
 	for (rn = route_top(table); rn; rn = srcdest_route_next(rn)) {
-		dest = rib_dest_from_rnode(rn);
-
-		RNODE_FOREACH_RE (rn, re) {
-			if (use_fib && re != dest->selected_fib)
-				continue;
-
-			if (tag && re->tag != tag)
-				continue;
-
-			if (longer_prefix_p
-			    && !prefix_match(longer_prefix_p, &rn->p))
-				continue;
-
-			/* This can only be true when the afi is IPv4 */
-			if (supernets_only) {
-				addr = ntohl(rn->p.u.prefix4.s_addr);
-
-				if (IN_CLASSC(addr) && rn->p.prefixlen >= 24)
-					continue;
-
-				if (IN_CLASSB(addr) && rn->p.prefixlen >= 16)
-					continue;
-
-				if (IN_CLASSA(addr) && rn->p.prefixlen >= 8)
-					continue;
-			}
-
-			if (type && re->type != type)
-				continue;
-
-			if (ospf_instance_id
-			    && (re->type != ZEBRA_ROUTE_OSPF
-				|| re->instance != ospf_instance_id))
-				continue;
-
-			if (use_json) {
-				if (!json_prefix)
-					json_prefix = json_object_new_array();
-			} else if (first) {
-				if (!ctx->header_done) {
-					if (afi == AFI_IP)
-						vty_out(vty,
-							SHOW_ROUTE_V4_HEADER);
-					else
-						vty_out(vty,
-							SHOW_ROUTE_V6_HEADER);
-				}
-				if (ctx->multi && ctx->header_done)
-					vty_out(vty, "\n");
-				if (ctx->multi || zvrf_id(zvrf) != VRF_DEFAULT
-				    || tableid) {
-					if (!tableid)
-						vty_out(vty, "VRF %s:\n",
-							zvrf_name(zvrf));
-					else
-						vty_out(vty,
-							"VRF %s table %u:\n",
-							zvrf_name(zvrf),
-							tableid);
-				}
-				ctx->header_done = true;
-				first = 0;
-			}
-
-			vty_show_ip_route(vty, rn, re, json_prefix, use_fib);
-		}
-
+		json_prefix = do_show_route_node(vty, zvrf, rn, &flt, &first,
+						 ctx);
 		if (json_prefix) {
 			prefix2str(&rn->p, buf, sizeof(buf));
 			json_object_object_add(json, buf, json_prefix);
-			json_prefix = NULL;
 		}
 	}
 
@@ -1274,13 +1312,12 @@ static void do_show_ip_route_all(struct vty *vty, struct zebra_vrf *zvrf,
 	}
 }
 
-static int do_show_ip_route(struct vty *vty, const char *vrf_name, afi_t afi,
-			    safi_t safi, bool use_fib, bool use_json,
-			    route_tag_t tag,
-			    const struct prefix *longer_prefix_p,
-			    bool supernets_only, int type,
-			    unsigned short ospf_instance_id, uint32_t tableid,
-			    struct route_show_ctx *ctx)
+/* Looks up the table to show, printing why if there is none. */
+static struct route_table *show_route_table(struct vty *vty,
+					    const char *vrf_name, afi_t afi,
+					    safi_t safi, bool use_json,
+					    uint32_t tableid,
+					    struct zebra_vrf **zvrfp)
 {
 	struct route_table *table;
 	struct zebra_vrf *zvrf = NULL;
@@ -1290,7 +1327,7 @@ static int do_show_ip_route(struct vty *vty, const char *vrf_name, afi_t afi,
 			vty_out(vty, "{}\n");
 		else
 			vty_out(vty, "vrf %s not defined\n", vrf_name);
-		return CMD_SUCCESS;
+		return NULL;
 	}
 
 	if (zvrf_id(zvrf) == VRF_UNKNOWN) {
@@ -1298,7 +1335,7 @@ static int do_show_ip_route(struct vty *vty, const char *vrf_name, afi_t afi,
 			vty_out(vty, "{}\n");
 		else
 			vty_out(vty, "vrf %s inactive\n", vrf_name);
-		return CMD_SUCCESS;
+		return NULL;
 	}
 
 	if (tableid)
@@ -1308,9 +1345,29 @@ static int do_show_ip_route(struct vty *vty, const char *vrf_name, afi_t afi,
 	if (!table) {
 		if (use_json)
 			vty_out(vty, "{}\n");
-		return CMD_SUCCESS;
+		return NULL;
 	}
 
+	*zvrfp = zvrf;
+	return table;
+}
+
+static int do_show_ip_route(struct vty *vty, const char *vrf_name, afi_t afi,
+			    safi_t safi, bool use_fib, bool use_json,
+			    route_tag_t tag,
+			    const struct prefix *longer_prefix_p,
+			    bool supernets_only, int type,
+			    unsigned short ospf_instance_id, uint32_t tableid,
+			    struct route_show_ctx *ctx)
+{
+	struct route_table *table;
+	struct zebra_vrf *zvrf = NULL;
+
+	table = show_route_table(vty, vrf_name, afi, safi, use_json, tableid,
+				 &zvrf);
+	if (!table)
+		return CMD_SUCCESS;
+
 	do_show_route_helper(vty, zvrf, table, afi, use_fib, tag,
 			     longer_prefix_p, supernets_only, type,
 			     ospf_instance_id, use_json, tableid, ctx);
@@ -1318,6 +1375,152 @@ static int do_show_ip_route(struct vty *vty, const char *vrf_name, afi_t afi,
 	return CMD_SUCCESS;
 }
 
+/* Single table "show ip route", see do_show_ip_route_walk() */
+struct route_show_walk {
+	vrf_id_t vrf_id;
+	safi_t safi;
+	struct route_show_filter flt;
+	struct prefix longer_prefix;
+
+	/* NULL while paused, the vrf and its tables can go away meanwhile */
+	struct zebra_vrf *zvrf;
+	route_table_iter_t iter;
+
+	struct route_show_ctx ctx;
+	int first;
+	struct json_stream js;
+};
+
+static void route_show_walk_node(struct vty *vty, struct route_show_walk *walk,
+				 struct route_node *rn)
+{
+	json_object *json_prefix;
+	char buf[BUFSIZ];
+
+	json_prefix = do_show_route_node(vty, walk->zvrf, rn, &walk->flt,
+					 &walk->first, &walk->ctx);
+	if (json_prefix) {
+		prefix2str(&rn->p, buf, sizeof(buf));
+		json_stream_add(&walk->js, buf, json_prefix);
+	}
+}
+
+static bool route_show_walk_step(struct vty *vty, void *arg)
+{
+	struct route_show_walk *walk = arg;
+	struct route_table *table, *src_table;
+	struct route_node *rn, *srn;
+
+	if (!walk->zvrf) {
+		walk->zvrf = zebra_vrf_lookup_by_id(walk->vrf_id);
+		if (!walk->zvrf)
+			return false;
+
+		if (walk->flt.tableid)
+			table = zebra_router_find_table(walk->zvrf,
+							walk->flt.tableid,
+							walk->flt.afi,
+							SAFI_UNICAST);
+		else
+			table = zebra_vrf_table(walk->flt.afi, walk->safi,
+						walk->vrf_id);
+		if (!table) {
+			walk->zvrf = NULL;
+			return false;
+		}
+		walk->iter.table = table;
+	}
+
+	rn = route_table_iter_next(&walk->iter);
+	if (!rn)
+		return false;
+
+	/* source specific routes go with their destination */
+	route_show_walk_node(vty, walk, rn);
+	src_table = srcdest_srcnode_table(rn);
+	if (src_table)
+		for (srn = route_top(src_table); srn; srn = route_next(srn))
+			route_show_walk_node(vty, walk, srn);
+	return true;
+}
+
+static void route_show_walk_pause(void *arg)
+{
+	struct route_show_walk *walk = arg;
+
+	route_table_iter_pause(&walk->iter);
+	walk->zvrf = NULL;
+}
+
+static int route_show_walk_finish(struct vty *vty, void *arg)
+{
+	struct route_show_walk *walk = arg;
+
+	if (vty && walk->flt.use_json)
+		json_stream_close(&walk->js);
+
+	route_table_iter_cleanup(&walk->iter);
+	XFREE(MTYPE_ROUTE_SHOW_WALK, walk);
+	return CMD_SUCCESS;
+}
+
+static const struct vty_walk_ops route_show_walk_ops = {
+	.step = route_show_walk_step,
+	.pause = route_show_walk_pause,
+	.finish = route_show_walk_finish,
+};
+
+/*
+ * Same output as do_show_ip_route(), but through vty_walk(): full tables are
+ * shown from events without blocking zebra.  Nothing is kept locked in
+ * between, the walk picks up after the last prefix shown.
+ */
+static int do_show_ip_route_walk(struct vty *vty, const char *vrf_name,
+				 afi_t afi, safi_t safi, bool use_fib,
+				 bool use_json, route_tag_t tag,
+				 const struct prefix *longer_prefix_p,
+				 bool supernets_only, int type,
+				 unsigned short ospf_instance_id,
+				 uint32_t tableid)
+{
+	struct route_show_walk *walk;
+	struct route_table *table;
+	struct zebra_vrf *zvrf = NULL;
+
+	table = show_route_table(vty, vrf_name, afi, safi, use_json, tableid,
+				 &zvrf);
+	if (!table)
+		return CMD_SUCCESS;
+
+	walk = XCALLOC(MTYPE_ROUTE_SHOW_WALK, sizeof(*walk));
+	walk->vrf_id = zvrf_id(zvrf);
+	walk->safi = safi;
+	walk->flt.afi = afi;
+	walk->flt.use_fib = use_fib;
+	walk->flt.tag = tag;
+	if (longer_prefix_p) {
+		prefix_copy(&walk->longer_prefix, longer_prefix_p);
+		walk->flt.longer_prefix_p = &walk->longer_prefix;
+	}
+	walk->flt.supernets_only = supernets_only;
+	walk->flt.type = type;
+	walk->flt.ospf_instance_id = ospf_instance_id;
+	walk->flt.use_json = use_json;
+	walk->flt.tableid = tableid;
+	walk->zvrf = zvrf;
+	route_table_iter_init(&walk->iter, table);
+	walk->first = 1;
+
+	if (use_json) {
+		json_stream_init(&walk->js, vty,
+				 JSON_C_TO_STRING_PRETTY
+					 | JSON_C_TO_STRING_NOSLASHESCAPE);
+		json_stream_object_open(&walk->js, NULL);
+	}
+
+	return vty_walk(vty, &route_show_walk_ops, walk);
+}
+
 DEFPY (show_ip_nht,
        show_ip_nht_cmd,
        "show <ip$ipv4|ipv6$ipv6> <nht|import-check>$type [<A.B.C.D|X:X::X:X>$addr|vrf NAME$vrf_name [<A.B.C.D|X:X::X:X>$addr]|vrf all$vrf_all]",
@@ -1410,6 +1613,11 @@ static void show_nexthop_group_out(struct vty *vty, struct nhg_hash_entry *nhe)
 			vty_out(vty, ", Installed");
 		vty_out(vty, "\n");
 	}
+	if (nhe->kernel_nhe)
+		vty_out(vty, "     Kernel object: ID %u\n", nhe->kernel_nhe->id);
+	if (nhe->kernel_aliases)
+		vty_out(vty, "     Kernel object shared by: %u\n",
+			nhe->kernel_aliases);
 	if (nhe->ifp)
 		vty_out(vty, "     Interface Index: %d\n", nhe->ifp->ifindex);
 
@@ -1543,6 +1751,20 @@ static void show_nexthop_group_cmd_helper(struct vty *vty,
 	hash_walk(zrouter.nhgs_id, nhe_show_walker, &ctx);
 }
 
+static void show_nexthop_group_kernel_share(struct vty *vty)
+{
+	unsigned long objects, aliases;
+
+	zebra_nhg_kernel_share_stats(&objects, &aliases);
+	if (!objects)
+		return;
+
+	vty_out(vty,
+		"Kernel nexthop objects: %lu used by %lu nexthop groups (%.2f:1)\n",
+		objects, objects + aliases,
+		(double)(objects + aliases) / objects);
+}
+
 static void if_nexthop_group_dump_vty(struct vty *vty, struct interface *ifp)
 {
 	struct zebra_if *zebra_if = NULL;
@@ -1651,6 +1873,7 @@ DEFPY (show_nexthop_group,
 			vty_out(vty, "VRF: %s\n", vrf->name);
 			show_nexthop_group_cmd_helper(vty, zvrf, afi, type);
 		}
+		show_nexthop_group_kernel_share(vty);
 
 		return CMD_SUCCESS;
 	}
@@ -1667,6 +1890,7 @@ DEFPY (show_nexthop_group,
 	}
 
 	show_nexthop_group_cmd_helper(vty, zvrf, afi, type);
+	show_nexthop_group_kernel_share(vty);
 
 	return CMD_SUCCESS;
 }
@@ -1894,17 +2118,17 @@ DEFPY (show_route,
 		if (!zvrf)
 			return CMD_SUCCESS;
 
-		if (table_all)
-			do_show_ip_route_all(vty, zvrf, afi, !!fib, !!json, tag,
-					     prefix_str ? prefix : NULL,
-					     !!supernets_only, type,
-					     ospf_instance_id, &ctx);
-		else
-			do_show_ip_route(vty, vrf->name, afi, SAFI_UNICAST,
-					 !!fib, !!json, tag,
-					 prefix_str ? prefix : NULL,
-					 !!supernets_only, type,
-					 ospf_instance_id, table, &ctx);
+		if (!table_all)
+			return do_show_ip_route_walk(
+				vty, vrf->name, afi, SAFI_UNICAST, !!fib,
+				!!json, tag, prefix_str ? prefix : NULL,
+				!!supernets_only, type, ospf_instance_id,
+				table);
+
+		do_show_ip_route_all(vty, zvrf, afi, !!fib, !!json, tag,
+				     prefix_str ? prefix : NULL,
+				     !!supernets_only, type, ospf_instance_id,
+				     &ctx);
 	}
 
 	return CMD_SUCCESS;
@@ -3896,6 +4120,10 @@ static int config_write_protocol(struct vty *vty)
 		vty_out(vty, "zebra zapi-packets %u\n",
 			zrouter.packets_to_process);
 
+	if (conv_get_rate(zrouter.conv))
+		vty_out(vty, "zebra convergence-sampling %u\n",
+			conv_get_rate(zrouter.conv));
+
 	enum multicast_mode ipv4_multicast_mode = multicast_mode_ipv4_get();
 
 	if (ipv4_multicast_mode != MCAST_NO_CONFIG)
@@ -3963,6 +4191,8 @@ DEFUN (show_zebra,
 			zvrf->lsp_removals);
 	}
 
+	meta_queue_show(vty, zrouter.mq);
+
 	return CMD_SUCCESS;
 }
 
@@ -4111,7 +4341,12 @@ DEFUN (show_dataplane,
 	if (argv_find(argv, argc, "detailed", &idx))
 		detailed = true;
 
-	return dplane_show_helper(vty, detailed);
+	dplane_show_helper(vty, detailed);
+#ifdef HAVE_NETLINK
+	netlink_batch_show_helper(vty);
+#endif /* HAVE_NETLINK */
+
+	return CMD_SUCCESS;
 }
 
 /* Display dataplane providers info */
@@ -4166,6 +4401,44 @@ DEFUN (no_zebra_dplane_queue_limit,
 	return CMD_SUCCESS;
 }
 
+DEFPY (zebra_convergence_sampling,
+       zebra_convergence_sampling_cmd,
+       "zebra convergence-sampling (1-65535)$rate",
+       ZEBRA_STR
+       "Time a sample of the route updates from zapi to the dataplane\n"
+       "Sample 1 in this many prefixes\n")
+{
+	conv_set_rate(zrouter.conv, rate);
+
+	return CMD_SUCCESS;
+}
+
+DEFPY (no_zebra_convergence_sampling,
+       no_zebra_convergence_sampling_cmd,
+       "no zebra convergence-sampling [(1-65535)]",
+       NO_STR
+       ZEBRA_STR
+       "Time a sample of the route updates from zapi to the dataplane\n"
+       "Sample 1 in this many prefixes\n")
+{
+	conv_set_rate(zrouter.conv, 0);
+
+	return CMD_SUCCESS;
+}
+
+DEFUN (show_zebra_convergence,
+       show_zebra_convergence_cmd,
+       "show zebra convergence [json]",
+       SHOW_STR
+       ZEBRA_STR
+       "Per-stage timing of the sampled route updates\n"
+       JSON_STR)
+{
+	conv_show(vty, zrouter.conv, use_json(argc, argv));
+
+	return CMD_SUCCESS;
+}
+
 DEFUN (zebra_show_routing_tables_summary,
        zebra_show_routing_tables_summary_cmd,
        "show zebra router table summary",
@@ -4296,6 +4569,34 @@ DEFUN_HIDDEN(no_zebra_kernel_netlink_batch_tx_buf,
 	return CMD_SUCCESS;
 }
 
+DEFPY_HIDDEN(zebra_kernel_netlink_batch_window,
+	     zebra_kernel_netlink_batch_window_cmd,
+	     "zebra kernel netlink batch-window (1-65535)$window",
+	     ZEBRA_STR
+	     "Zebra kernel interface\n"
+	     "Set Netlink parameters\n"
+	     "Set number of messages sent before reading responses\n"
+	     "Number of messages\n")
+{
+	netlink_set_batch_window(window, true);
+
+	return CMD_SUCCESS;
+}
+
+DEFPY_HIDDEN(no_zebra_kernel_netlink_batch_window,
+	     no_zebra_kernel_netlink_batch_window_cmd,
+	     "no zebra kernel netlink batch-window [(1-65535)]",
+	     NO_STR ZEBRA_STR
+	     "Zebra kernel interface\n"
+	     "Set Netlink parameters\n"
+	     "Set number of messages sent before reading responses\n"
+	     "Number of messages\n")
+{
+	netlink_set_batch_window(0, false);
+
+	return CMD_SUCCESS;
+}
+
 #endif /* HAVE_NETLINK */
 
 /* IP node for static routes. */
@@ -4449,7 +4750,13 @@ void zebra_vty_init(void)
 #ifdef HAVE_NETLINK
 	install_element(CONFIG_NODE, &zebra_kernel_netlink_batch_tx_buf_cmd);
 	install_element(CONFIG_NODE, &no_zebra_kernel_netlink_batch_tx_buf_cmd);
+	install_element(CONFIG_NODE, &zebra_kernel_netlink_batch_window_cmd);
+	install_element(CONFIG_NODE, &no_zebra_kernel_netlink_batch_window_cmd);
 #endif /* HAVE_NETLINK */
 
 	install_element(VIEW_NODE, &zebra_show_routing_tables_summary_cmd);
+
+	install_element(CONFIG_NODE, &zebra_convergence_sampling_cmd);
+	install_element(CONFIG_NODE, &no_zebra_convergence_sampling_cmd);
+	install_element(VIEW_NODE, &show_zebra_convergence_cmd);
 }
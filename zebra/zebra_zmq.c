@@ -0,0 +1,154 @@
+/*
+ * Zebra RIB change export over ZeroMQ
+ * Copyright (C) 2026  The FRRouting Project
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU General Public License as published by the Free
+ * Software Foundation; either version 2 of the License, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but WITHOUT
+ * ANY WARRANTY; without even the implied warranty of MERCHANTABILITY or
+ * FITNESS FOR A PARTICULAR PURPOSE.  See the GNU General Public License for
+ * more details.
+ *
+ * You should have received a copy of the GNU General Public License along
+ * with this program; see the file COPYING; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin St, Fifth Floor, Boston, MA 02110-1301 USA
+ */
+
+#include <zebra.h>
+
+#include "command.h"
+#include "frr_zmq_pub.h"
+#include "libfrr.h"
+#include "lib/version.h"
+#include "srcdest_table.h"
+
+#include "zebra/rib.h"
+#include "zebra/zebra_vrf.h"
+
+#define ZEBRA_ZMQ_DEFAULT_ENDPOINT "tcp://127.0.0.1:5560"
+
+static struct frrzmq_pub *zebra_zmq_pub;
+
+/*
+ * Called whenever a destination's selected route or its installed state
+ * changes; the event carries what's in the FIB for the prefix now.
+ */
+static int zebra_zmq_rib_update(struct route_node *rn, const char *reason)
+{
+	struct frrzmq_route_event ev = {};
+	const struct prefix *p, *src_p;
+	struct rib_table_info *info;
+	struct route_entry *re;
+	struct nexthop *nexthop;
+	rib_dest_t *dest;
+
+	if (!zebra_zmq_pub)
+		return 0;
+
+	srcdest_rnode_prefixes(rn, &p, &src_p);
+	/* the event has no room for a source prefix */
+	if (src_p && src_p->prefixlen)
+		return 0;
+	if (p->family != AF_INET && p->family != AF_INET6)
+		return 0;
+
+	info = srcdest_rnode_table_info(rn);
+	dest = rib_dest_from_rnode(rn);
+	re = dest ? dest->selected_fib : NULL;
+
+	frrzmq_route_event_prefix(&ev, p);
+	ev.safi = info->safi;
+	ev.vrf_id = htonl(zvrf_id(info->zvrf));
+	ev.table = htonl(info->table_id);
+
+	if (!re) {
+		ev.op = FRRZMQ_ROUTE_DEL;
+		frrzmq_pub_add(zebra_zmq_pub, &ev, sizeof(ev));
+		return 0;
+	}
+
+	ev.op = FRRZMQ_ROUTE_ADD;
+	ev.type = re->type;
+	ev.distance = re->distance;
+	ev.metric = htonl(re->metric);
+
+	/* only the first installed nexthop */
+	for (ALL_NEXTHOPS_PTR(rib_get_fib_nhg(re), nexthop)) {
+		if (!CHECK_FLAG(nexthop->flags, NEXTHOP_FLAG_FIB))
+			continue;
+
+		ev.ifindex = htonl(nexthop->ifindex);
+		switch (nexthop->type) {
+		case NEXTHOP_TYPE_IPV4:
+		case NEXTHOP_TYPE_IPV4_IFINDEX:
+			ev.nh_afi = AFI_IP;
+			memcpy(ev.nexthop, &nexthop->gate.ipv4,
+			       sizeof(nexthop->gate.ipv4));
+			break;
+		case NEXTHOP_TYPE_IPV6:
+		case NEXTHOP_TYPE_IPV6_IFINDEX:
+			ev.nh_afi = AFI_IP6;
+			memcpy(ev.nexthop, &nexthop->gate.ipv6,
+			       sizeof(nexthop->gate.ipv6));
+			break;
+		case NEXTHOP_TYPE_IFINDEX:
+		case NEXTHOP_TYPE_BLACKHOLE:
+			break;
+		}
+		break;
+	}
+
+	frrzmq_pub_add(zebra_zmq_pub, &ev, sizeof(ev));
+	return 0;
+}
+
+DEFUN (show_zebra_zmq_publisher,
+       show_zebra_zmq_publisher_cmd,
+       "show zebra zmq-publisher",
+       SHOW_STR
+       ZEBRA_STR
+       "ZeroMQ RIB change export\n")
+{
+	if (!zebra_zmq_pub) {
+		vty_out(vty, "ZeroMQ publisher is not running\n");
+		return CMD_SUCCESS;
+	}
+
+	frrzmq_pub_show(vty, zebra_zmq_pub);
+	return CMD_SUCCESS;
+}
+
+static int zebra_zmq_init(struct thread_master *master)
+{
+	const char *endpoint = THIS_MODULE->load_args;
+
+	if (!endpoint || !*endpoint)
+		endpoint = ZEBRA_ZMQ_DEFAULT_ENDPOINT;
+
+	zebra_zmq_pub =
+		frrzmq_pub_new(master, endpoint, FRRZMQ_SRC_ZEBRA_RIB);
+	install_element(VIEW_NODE, &show_zebra_zmq_publisher_cmd);
+	return 0;
+}
+
+static int zebra_zmq_fini(void)
+{
+	frrzmq_pub_free(&zebra_zmq_pub);
+	return 0;
+}
+
+static int zebra_zmq_module_init(void)
+{
+	hook_register(rib_update, zebra_zmq_rib_update);
+	hook_register(frr_late_init, zebra_zmq_init);
+	hook_register(frr_early_fini, zebra_zmq_fini);
+	return 0;
+}
+
+FRR_MODULE_SETUP(.name = "zebra_zmq", .version = FRR_VERSION,
+		 .description = "zebra RIB change export over ZeroMQ",
+		 .init = zebra_zmq_module_init,
+);
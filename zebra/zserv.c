@@ -55,6 +55,7 @@
 #include "lib/frratomic.h"        /* for atomic_load_explicit, atomic_stor... */
 #include "lib/lib_errors.h"       /* for generic ferr ids */
 #include "lib/printfrr.h"         /* for string functions */
+#include "lib/shm_ring.h"         /* for shm_ring_attach, shm_ring_get... */
 
 #include "zebra/debug.h"          /* for various debugging macros */
 #include "zebra/rib.h"            /* for rib_score_proto */
@@ -63,6 +64,8 @@
 #include "zebra/zserv.h"          /* for zserv */
 #include "zebra/zebra_router.h"
 #include "zebra/zebra_errors.h"   /* for error messages */
+#include "zebra/zebra_trace.h"    /* for frrtrace */
+#include "zebra/zebra_opaque.h"   /* for zebra_opaque_show_client */
 /* clang-format on */
 
 /* privileges */
@@ -193,6 +196,7 @@ static void zserv_client_fail(struct zserv *client)
 
 	THREAD_OFF(client->t_read);
 	THREAD_OFF(client->t_write);
+	THREAD_OFF(client->t_ring);
 	zserv_event(client, ZSERV_HANDLE_CLIENT_FAIL);
 }
 
@@ -253,6 +257,7 @@ static int zserv_write(struct thread *thread)
 
 	while (stream_fifo_head(cache)) {
 		msg = stream_fifo_pop(cache);
+		frrtrace(2, frr_zebra, zserv_write, client, msg);
 		buffer_put(client->wb, STREAM_DATA(msg), stream_get_endp(msg));
 		stream_free(msg);
 	}
@@ -289,6 +294,202 @@ zwrite_fail:
 	return 0;
 }
 
+static int zserv_read(struct thread *thread);
+
+static bool zserv_read_header_valid(struct zserv *client, int sock,
+				    struct zmsghdr *hdr)
+{
+	char errmsg[256];
+
+	/* Reset to read from the beginning of the incoming packet. */
+	stream_set_getp(client->ibuf_work, 0);
+
+	/* Fetch header values */
+	if (!zapi_parse_header(client->ibuf_work, hdr)) {
+		snprintf(errmsg, sizeof(errmsg),
+			 "%s: Message has corrupt header", __func__);
+		zserv_log_message(errmsg, client->ibuf_work, NULL);
+		return false;
+	}
+
+	/* Validate header */
+	if (hdr->marker != ZEBRA_HEADER_MARKER
+	    || hdr->version != ZSERV_VERSION) {
+		snprintf(
+			errmsg, sizeof(errmsg),
+			"Message has corrupt header\n%s: socket %d version mismatch, marker %d, version %d",
+			__func__, sock, hdr->marker, hdr->version);
+		zserv_log_message(errmsg, client->ibuf_work, hdr);
+		return false;
+	}
+	if (hdr->length < ZEBRA_HEADER_SIZE) {
+		snprintf(
+			errmsg, sizeof(errmsg),
+			"Message has corrupt header\n%s: socket %d message length %u is less than header size %d",
+			__func__, sock, hdr->length, ZEBRA_HEADER_SIZE);
+		zserv_log_message(errmsg, client->ibuf_work, hdr);
+		return false;
+	}
+	if (hdr->length > STREAM_SIZE(client->ibuf_work)) {
+		snprintf(
+			errmsg, sizeof(errmsg),
+			"Message has corrupt header\n%s: socket %d message length %u exceeds buffer size %lu",
+			__func__, sock, hdr->length,
+			(unsigned long)STREAM_SIZE(client->ibuf_work));
+		zserv_log_message(errmsg, client->ibuf_work, hdr);
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * Like stream_read_try(), but also picks up a file descriptor passed along
+ * with the data; that is how a client hands over its shared memory ring.
+ */
+static ssize_t zserv_read_try(struct zserv *client, int sock, size_t size)
+{
+	union {
+		char buf[CMSG_SPACE(sizeof(int))];
+		struct cmsghdr align;
+	} cmsgbuf;
+	struct iovec iov;
+	struct msghdr msgh = {};
+	struct cmsghdr *cmsg;
+	ssize_t nb;
+	int fd;
+
+	msgh.msg_iov = &iov;
+	msgh.msg_iovlen = 1;
+	msgh.msg_control = cmsgbuf.buf;
+	msgh.msg_controllen = sizeof(cmsgbuf.buf);
+
+	nb = stream_recvmsg(client->ibuf_work, sock, &msgh, 0, size);
+	if (nb < 0) {
+		if (ERRNO_IO_RETRY(errno))
+			return -2;
+		flog_err(EC_LIB_SOCKET, "%s: read failed on fd %d: %s",
+			 __func__, sock, safe_strerror(errno));
+		return -1;
+	}
+
+	for (cmsg = CMSG_FIRSTHDR(&msgh); cmsg;
+	     cmsg = CMSG_NXTHDR(&msgh, cmsg)) {
+		if (cmsg->cmsg_level != SOL_SOCKET
+		    || cmsg->cmsg_type != SCM_RIGHTS)
+			continue;
+		memcpy(&fd, CMSG_DATA(cmsg), sizeof(fd));
+		if (client->ring_fd >= 0)
+			close(client->ring_fd);
+		client->ring_fd = fd;
+	}
+
+	return nb;
+}
+
+/*
+ * Copy the message read into ibuf_work, which goes to the main pthread to be
+ * processed and freed there.
+ */
+static struct stream *zserv_msg_dup(struct stream *ibuf_work)
+{
+	struct stream *msg;
+
+	msg = stream_new_pooled(stream_get_endp(ibuf_work));
+	stream_set_getp(ibuf_work, 0);
+	return stream_copy(msg, ibuf_work);
+}
+
+/*
+ * Map the ring offered with ZEBRA_SHM_RING_SETUP and tell the client whether
+ * it can use it.
+ */
+static void zserv_ring_setup(struct zserv *client)
+{
+	struct stream *s;
+
+	if (!client->ring && client->ring_fd >= 0)
+		client->ring = shm_ring_attach(client->ring_fd);
+	else if (IS_ZEBRA_DEBUG_EVENT)
+		zlog_debug("%s: client %s sent a stray ring setup", __func__,
+			   zebra_route_string(client->proto));
+
+	if (client->ring_fd >= 0) {
+		close(client->ring_fd);
+		client->ring_fd = -1;
+	}
+
+	if (IS_ZEBRA_DEBUG_EVENT)
+		zlog_debug("%s: shared memory ring for client %s %s", __func__,
+			   zebra_route_string(client->proto),
+			   client->ring ? "attached" : "refused");
+
+	s = stream_new(ZEBRA_HEADER_SIZE + 1);
+	zclient_create_header(s, ZEBRA_SHM_RING_SETUP, VRF_DEFAULT);
+	stream_putc(s, !!client->ring);
+	stream_putw_at(s, 0, stream_get_endp(s));
+	zserv_send_message(client, s);
+}
+
+/*
+ * Read messages from the client's ring, up to p2p of them, into the same
+ * queues the socket messages go to.
+ *
+ * Returns the remaining budget, or -1 if the client wrote garbage.
+ */
+static int zserv_read_ring(struct zserv *client, struct stream_fifo *cache,
+			   struct zserv_route_list_head *routes, uint32_t p2p,
+			   struct zmsghdr *hdr)
+{
+	struct stream *msg;
+
+	while (p2p) {
+		if (!shm_ring_peek(client->ring, STREAM_DATA(client->ibuf_work),
+				   ZEBRA_HEADER_SIZE)) {
+			if (shm_ring_sleep(client->ring))
+				break;
+			continue;
+		}
+		stream_set_endp(client->ibuf_work, ZEBRA_HEADER_SIZE);
+
+		if (!zserv_read_header_valid(client, client->sock, hdr))
+			return -1;
+
+		/* the client puts whole messages only */
+		if (!shm_ring_get(client->ring, STREAM_DATA(client->ibuf_work),
+				  hdr->length)) {
+			zserv_log_message("Truncated message in ring",
+					  client->ibuf_work, hdr);
+			return -1;
+		}
+		stream_set_endp(client->ibuf_work, hdr->length);
+
+		if (IS_ZEBRA_DEBUG_PACKET)
+			zlog_debug("zebra message[%s:%u:%u] comes from ring",
+				   zserv_command_string(hdr->command),
+				   hdr->vrf_id, hdr->length);
+
+		frrtrace(3, frr_zebra, zserv_read, client, hdr->command,
+			 hdr->length);
+
+		if (hdr->command != ZEBRA_SHM_RING_SETUP
+		    && hdr->command != ZEBRA_SHM_RING_KICK) {
+			msg = zserv_msg_dup(client->ibuf_work);
+			zserv_route_predecode(client, msg, hdr->command, routes);
+			stream_fifo_push(cache, msg);
+		}
+		stream_reset(client->ibuf_work);
+		p2p--;
+	}
+
+	/* out of budget with messages left, come back for them */
+	if (!p2p)
+		thread_add_event(client->pthread->master, zserv_read, client, 0,
+				 &client->t_ring);
+
+	return p2p;
+}
+
 /*
  * Read and process data from a client socket.
  *
@@ -309,6 +510,9 @@ zwrite_fail:
  * process the client's input queue. Finally, if all of this was successful,
  * this task reschedules itself.
  *
+ * Clients that use a shared memory ring are read the same way, except that
+ * the messages come out of the ring and the socket only carries the wakeups.
+ *
  * Any failure in any of these actions is handled by terminating the client.
  */
 static int zserv_read(struct thread *thread)
@@ -321,24 +525,26 @@ static int zserv_read(struct thread *thread)
 
 	uint32_t p2p;
 	struct zmsghdr hdr;
+	struct zserv_route_list_head routes;
+	struct zserv_route *zr;
 
 	p2p_orig = atomic_load_explicit(&zrouter.packets_to_process,
 					memory_order_relaxed);
 	cache = stream_fifo_new();
+	zserv_route_list_init(&routes);
 	p2p = p2p_orig;
-	sock = THREAD_FD(thread);
+	/* not THREAD_FD(), this also runs as t_ring event */
+	sock = client->sock;
 
 	while (p2p) {
 		ssize_t nb;
-		bool hdrvalid;
-		char errmsg[256];
 
 		already = stream_get_endp(client->ibuf_work);
 
 		/* Read length and command (if we don't have it already). */
 		if (already < ZEBRA_HEADER_SIZE) {
-			nb = stream_read_try(client->ibuf_work, sock,
-					     ZEBRA_HEADER_SIZE - already);
+			nb = zserv_read_try(client, sock,
+					    ZEBRA_HEADER_SIZE - already);
 			if ((nb == 0 || nb == -1)) {
 				if (IS_ZEBRA_DEBUG_EVENT)
 					zlog_debug("connection closed socket [%d]",
@@ -352,51 +558,13 @@ static int zserv_read(struct thread *thread)
 			already = ZEBRA_HEADER_SIZE;
 		}
 
-		/* Reset to read from the beginning of the incoming packet. */
-		stream_set_getp(client->ibuf_work, 0);
-
-		/* Fetch header values */
-		hdrvalid = zapi_parse_header(client->ibuf_work, &hdr);
-
-		if (!hdrvalid) {
-			snprintf(errmsg, sizeof(errmsg),
-				 "%s: Message has corrupt header", __func__);
-			zserv_log_message(errmsg, client->ibuf_work, NULL);
+		if (!zserv_read_header_valid(client, sock, &hdr))
 			goto zread_fail;
-		}
-
-		/* Validate header */
-		if (hdr.marker != ZEBRA_HEADER_MARKER
-		    || hdr.version != ZSERV_VERSION) {
-			snprintf(
-				errmsg, sizeof(errmsg),
-				"Message has corrupt header\n%s: socket %d version mismatch, marker %d, version %d",
-				__func__, sock, hdr.marker, hdr.version);
-			zserv_log_message(errmsg, client->ibuf_work, &hdr);
-			goto zread_fail;
-		}
-		if (hdr.length < ZEBRA_HEADER_SIZE) {
-			snprintf(
-				errmsg, sizeof(errmsg),
-				"Message has corrupt header\n%s: socket %d message length %u is less than header size %d",
-				__func__, sock, hdr.length, ZEBRA_HEADER_SIZE);
-			zserv_log_message(errmsg, client->ibuf_work, &hdr);
-			goto zread_fail;
-		}
-		if (hdr.length > STREAM_SIZE(client->ibuf_work)) {
-			snprintf(
-				errmsg, sizeof(errmsg),
-				"Message has corrupt header\n%s: socket %d message length %u exceeds buffer size %lu",
-				__func__, sock, hdr.length,
-				(unsigned long)STREAM_SIZE(client->ibuf_work));
-			zserv_log_message(errmsg, client->ibuf_work, &hdr);
-			goto zread_fail;
-		}
 
 		/* Read rest of data. */
 		if (already < hdr.length) {
-			nb = stream_read_try(client->ibuf_work, sock,
-					     hdr.length - already);
+			nb = zserv_read_try(client, sock,
+					    hdr.length - already);
 			if ((nb == 0 || nb == -1)) {
 				if (IS_ZEBRA_DEBUG_EVENT)
 					zlog_debug(
@@ -417,14 +585,52 @@ static int zserv_read(struct thread *thread)
 				   hdr.vrf_id, hdr.length,
 				   sock);
 
-		stream_set_getp(client->ibuf_work, 0);
-		struct stream *msg = stream_dup(client->ibuf_work);
+		frrtrace(3, frr_zebra, zserv_read, client, hdr.command,
+			 hdr.length);
+
+		/* ring control stays in this pthread */
+		if (hdr.command == ZEBRA_SHM_RING_SETUP) {
+			zserv_ring_setup(client);
+			stream_reset(client->ibuf_work);
+			continue;
+		}
+		if (hdr.command == ZEBRA_SHM_RING_KICK) {
+			client->ring_kicked = !!client->ring;
+			stream_reset(client->ibuf_work);
+			continue;
+		}
+
+		struct stream *msg = zserv_msg_dup(client->ibuf_work);
+
+		/*
+		 * Decoding route adds here takes that work off the main
+		 * pthread, which would otherwise do it for every client.
+		 */
+		zserv_route_predecode(client, msg, hdr.command, &routes);
 
 		stream_fifo_push(cache, msg);
 		stream_reset(client->ibuf_work);
 		p2p--;
 	}
 
+	/*
+	 * The ring is only looked at when no socket message is half read;
+	 * there are none behind the first kick anyway.
+	 */
+	if (client->ring_kicked && stream_get_endp(client->ibuf_work) == 0) {
+		if (!p2p)
+			thread_add_event(client->pthread->master, zserv_read,
+					 client, 0, &client->t_ring);
+		else {
+			int left = zserv_read_ring(client, cache, &routes, p2p,
+						   &hdr);
+
+			if (left < 0)
+				goto zread_fail;
+			p2p = left;
+		}
+	}
+
 	if (p2p < p2p_orig) {
 		/* update session statistics */
 		atomic_store_explicit(&client->last_read_time, monotime(NULL),
@@ -437,6 +643,9 @@ static int zserv_read(struct thread *thread)
 			while (cache->head)
 				stream_fifo_push(client->ibuf_fifo,
 						 stream_fifo_pop(cache));
+			while ((zr = zserv_route_list_pop(&routes)))
+				zserv_route_list_add_tail(&client->ibuf_routes,
+							  zr);
 		}
 
 		/* Schedule job to process those packets */
@@ -452,10 +661,14 @@ static int zserv_read(struct thread *thread)
 	zserv_client_event(client, ZSERV_CLIENT_READ);
 
 	stream_fifo_free(cache);
+	zserv_route_list_fini(&routes);
 
 	return 0;
 
 zread_fail:
+	while ((zr = zserv_route_list_pop(&routes)))
+		zserv_route_free(&zr);
+	zserv_route_list_fini(&routes);
 	stream_fifo_free(cache);
 	zserv_client_fail(client);
 	return -1;
@@ -536,6 +749,10 @@ static int zserv_process_messages(struct thread *thread)
 int zserv_send_message(struct zserv *client, struct stream *msg)
 {
 	frr_with_mutex(&client->obuf_mtx) {
+		if (client->obuf_packed) {
+			stream_fifo_push(client->obuf_fifo, client->obuf_packed);
+			client->obuf_packed = NULL;
+		}
 		stream_fifo_push(client->obuf_fifo, msg);
 	}
 
@@ -552,6 +769,10 @@ int zserv_send_batch(struct zserv *client, struct stream_fifo *fifo)
 	struct stream *msg;
 
 	frr_with_mutex(&client->obuf_mtx) {
+		if (client->obuf_packed) {
+			stream_fifo_push(client->obuf_fifo, client->obuf_packed);
+			client->obuf_packed = NULL;
+		}
 		msg = stream_fifo_pop(fifo);
 		while (msg) {
 			stream_fifo_push(client->obuf_fifo, msg);
@@ -564,6 +785,57 @@ int zserv_send_batch(struct zserv *client, struct stream_fifo *fifo)
 	return 0;
 }
 
+static int zserv_packed_flush(struct thread *thread)
+{
+	struct zserv *client = THREAD_ARG(thread);
+	bool queued = false;
+
+	frr_with_mutex(&client->obuf_mtx) {
+		if (client->obuf_packed) {
+			stream_fifo_push(client->obuf_fifo, client->obuf_packed);
+			client->obuf_packed = NULL;
+			queued = true;
+		}
+	}
+
+	if (queued)
+		zserv_client_event(client, ZSERV_CLIENT_WRITE);
+
+	return 0;
+}
+
+/*
+ * Send a small message to a connected Zebra API client, packed with others.
+ * The client reads a byte stream, so it can't tell the difference.
+ */
+int zserv_send_message_packed(struct zserv *client, const struct stream *msg)
+{
+	size_t len = stream_get_endp(msg);
+	bool full = false;
+
+	frr_with_mutex(&client->obuf_mtx) {
+		if (client->obuf_packed
+		    && STREAM_WRITEABLE(client->obuf_packed) < len) {
+			stream_fifo_push(client->obuf_fifo, client->obuf_packed);
+			client->obuf_packed = NULL;
+			full = true;
+		}
+
+		if (!client->obuf_packed)
+			client->obuf_packed =
+				stream_new(MAX(len, ZEBRA_MAX_PACKET_SIZ));
+		stream_put(client->obuf_packed, STREAM_DATA(msg), len);
+	}
+
+	if (full)
+		zserv_client_event(client, ZSERV_CLIENT_WRITE);
+
+	thread_add_event(zrouter.master, zserv_packed_flush, client, 0,
+			 &client->t_packed_flush);
+
+	return 0;
+}
+
 /* Hooks for client connect / disconnect */
 DEFINE_HOOK(zserv_client_connect, (struct zserv *client), (client));
 DEFINE_KOOH(zserv_client_close, (struct zserv *client), (client));
@@ -582,6 +854,8 @@ DEFINE_KOOH(zserv_client_close, (struct zserv *client), (client));
  */
 static void zserv_client_free(struct zserv *client)
 {
+	struct zserv_route *zr;
+
 	if (client == NULL)
 		return;
 
@@ -619,10 +893,22 @@ static void zserv_client_free(struct zserv *client)
 		stream_free(client->obuf_work);
 	if (client->ibuf_fifo)
 		stream_fifo_free(client->ibuf_fifo);
+	while ((zr = zserv_route_list_pop(&client->ibuf_routes)))
+		zserv_route_free(&zr);
+	zserv_route_list_fini(&client->ibuf_routes);
+	THREAD_OFF(client->t_notify_bulk);
+	if (client->notify_bulk)
+		stream_free(client->notify_bulk);
+	THREAD_OFF(client->t_packed_flush);
+	if (client->obuf_packed)
+		stream_free(client->obuf_packed);
 	if (client->obuf_fifo)
 		stream_fifo_free(client->obuf_fifo);
 	if (client->wb)
 		buffer_free(client->wb);
+	shm_ring_del(&client->ring);
+	if (client->ring_fd >= 0)
+		close(client->ring_fd);
 
 	/* Free buffer mutexes */
 	pthread_mutex_destroy(&client->obuf_mtx);
@@ -742,7 +1028,9 @@ static struct zserv *zserv_client_create(int sock)
 
 	/* Make client input/output buffer. */
 	client->sock = sock;
+	client->ring_fd = -1;
 	client->ibuf_fifo = stream_fifo_new();
+	zserv_route_list_init(&client->ibuf_routes);
 	client->obuf_fifo = stream_fifo_new();
 	client->ibuf_work = stream_new(stream_size);
 	client->obuf_work = stream_new(stream_size);
@@ -1119,6 +1407,7 @@ static void zebra_show_client_detail(struct vty *vty, struct zserv *client)
 		client->ibuf_fifo->count, client->ibuf_fifo->max_count,
 		client->obuf_fifo->count, client->obuf_fifo->max_count);
 #endif
+	zebra_opaque_show_client(vty, client);
 	vty_out(vty, "\n");
 }
 
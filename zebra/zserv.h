@@ -52,6 +52,8 @@ extern "C" {
 
 #define ZEBRA_RMAP_DEFAULT_UPDATE_TIMER 5 /* disabled by default */
 
+PREDECL_DLIST(zserv_route_list);
+
 
 /* Stale route marker timer */
 #define ZEBRA_DEFAULT_STALE_UPDATE_DELAY 1
@@ -107,8 +109,13 @@ struct zserv {
 	/* Input/output buffer to the client. */
 	pthread_mutex_t ibuf_mtx;
 	struct stream_fifo *ibuf_fifo;
+	/* ZEBRA_ROUTE_ADDs on ibuf_fifo, already decoded, in the same order */
+	struct zserv_route_list_head ibuf_routes;
 	pthread_mutex_t obuf_mtx;
 	struct stream_fifo *obuf_fifo;
+	/* Small messages packed back to back, not on obuf_fifo yet */
+	struct stream *obuf_packed;
+	struct thread *t_packed_flush;
 
 	/* Private I/O buffers */
 	struct stream *ibuf_work;
@@ -121,6 +128,18 @@ struct zserv {
 	struct thread *t_read;
 	struct thread *t_write;
 
+	/* Shared memory ring offered by the client, with the file descriptor
+	 * that came along before ZEBRA_SHM_RING_SETUP was read.  The ring is
+	 * only read after the first ZEBRA_SHM_RING_KICK, which the client
+	 * sends behind everything it wrote to the socket.  All of this is
+	 * private to the client pthread.
+	 */
+	struct shm_ring *ring;
+	int ring_fd;
+	bool ring_kicked;
+	/* Continue reading the ring once the read budget was used up */
+	struct thread *t_ring;
+
 	/* Event for message processing, for the main pthread */
 	struct thread *t_process;
 
@@ -142,6 +161,14 @@ struct zserv {
 
 	bool notify_owner;
 
+	/* The client sends its routes in bulk; so route owner notifications
+	 * are batched in notify_bulk until the event runs.
+	 */
+	bool notify_owner_bulk;
+	struct stream *notify_bulk;
+	uint16_t notify_bulk_count;
+	struct thread *t_notify_bulk;
+
 	/* Indicates if client is synchronous. */
 	bool synchronous;
 
@@ -299,6 +326,22 @@ extern int zserv_send_message(struct zserv *client, struct stream *msg);
  */
 extern int zserv_send_batch(struct zserv *client, struct stream_fifo *fifo);
 
+/*
+ * Send a small message to a connected Zebra API client.  The message is
+ * copied into a buffer shared with the following ones, which goes out when
+ * it fills up, when any other message is sent to the client, or when the
+ * event loop comes around; the order of messages is kept either way.
+ * Main pthread only.
+ *
+ * client
+ *    the client to send to
+ *
+ * msg
+ *    the message to send, still owned by the caller
+ */
+extern int zserv_send_message_packed(struct zserv *client,
+				     const struct stream *msg);
+
 /*
  * Retrieve a client by its protocol and instance number.
  *